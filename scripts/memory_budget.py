@@ -0,0 +1,44 @@
+"""
+memory_budget.py - PlatformIO post-link script for the RAM report
+
+Has the linker write a map (firmware.map next to firmware.elf), then prints
+the static RAM by subsystem (tools/memory_report.py) after each link - on
+Teensy 4.x with where each section landed (ITCM, DTCM, OCRAM, FLASH,
+EXTMEM). When the env sets custom_ram_budget, a group over its limit fails
+the build:
+
+    custom_ram_budget = total:7680, inputs:6144
+"""
+
+# pylint: disable=undefined-variable
+# pyright: reportUndefinedVariable=false
+# Import and env are injected by PlatformIO/SCons at runtime
+
+Import("env")  # type: ignore
+import os
+import subprocess
+import sys
+
+# Host builds (env:native) run no RAM budget - and not every host linker takes -Map
+if env.get("PIOPLATFORM") == "native":
+    Return()
+
+map_path = os.path.join(env.subst("$BUILD_DIR"), "firmware.map")
+env.Append(LINKFLAGS=["-Wl,-Map," + map_path])
+
+
+def report_ram(source, target, env):
+    """Print the RAM report; fail the build when over the env's budget."""
+    script = os.path.join(env.subst("$PROJECT_DIR"), "tools", "memory_report.py")
+    budget = env.GetProjectOption("custom_ram_budget", "")
+    cmd = [sys.executable, script, map_path, "--top", "5"]
+    if env.BoardConfig().get("build.mcu", "") == "imxrt1062":
+        cmd.append("--placement")
+    if budget:
+        cmd += ["--budget", budget]
+    if subprocess.call(cmd) != 0 and budget:
+        print("Error: RAM budget for this env exceeded (custom_ram_budget in platformio.ini)")
+        env.Exit(1)
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", report_ram)
@@ -0,0 +1,16 @@
+"""
+native_sim.py - PlatformIO script for the host simulator (env:native)
+
+Builds the simulator's Arduino stand-ins (sim/src) into the native program
+next to the firmware sources; their headers come from -I sim/include in the
+env's build_flags, so libraries see the same Arduino.h.
+"""
+
+# pylint: disable=undefined-variable
+# pyright: reportUndefinedVariable=false
+# Import and env are injected by PlatformIO/SCons at runtime
+
+Import("env")  # type: ignore
+
+env.Append(CXXFLAGS=["-std=gnu++17"])
+env.BuildSources("$BUILD_DIR/sim", "$PROJECT_DIR/sim/src")
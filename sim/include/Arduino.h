@@ -0,0 +1,306 @@
+/*
+ * Arduino.h - Arduino core API for the host simulator (env:native)
+ * Part of the preOBD firmware simulator
+ *
+ * Just the part of the Arduino API the firmware uses, implemented on the host:
+ *
+ *   - Time (millis, micros, delay) runs on the simulated clock (sim.h)
+ *   - analogRead() / digitalRead() play back a recorded trace; pins without
+ *     a trace column read the level last written (digital) or 0 (analog)
+ *   - Serial is stdin/stdout, non-blocking
+ *   - Flash helpers (F(), PROGMEM, pgm_read_*, *_P) are plain RAM accesses
+ *
+ * Interrupts are single-threaded: attachInterrupt() handlers run from the
+ * simulator loop when a trace edge is played back, between loop() passes.
+ */
+
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <ctype.h>
+#include <stdarg.h>
+#include <algorithm>
+
+// ===== Types and constants =====
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW  0
+
+#define INPUT          0
+#define OUTPUT         1
+#define INPUT_PULLUP   2
+#define INPUT_PULLDOWN 3
+
+#define CHANGE  1
+#define FALLING 2
+#define RISING  3
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define DEFAULT 1
+#define EXTERNAL 0
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+// Pins: 64 digital, A0-A15 on 14-29 (Teensy-style numbering)
+#define NUM_DIGITAL_PINS 64
+#define NUM_ANALOG_INPUTS 16
+#define LED_BUILTIN 13
+
+#define A0  14
+#define A1  15
+#define A2  16
+#define A3  17
+#define A4  18
+#define A5  19
+#define A6  20
+#define A7  21
+#define A8  22
+#define A9  23
+#define A10 24
+#define A11 25
+#define A12 26
+#define A13 27
+#define A14 28
+#define A15 29
+
+#define NOT_AN_INTERRUPT -1
+#define digitalPinToInterrupt(p) ((p) < NUM_DIGITAL_PINS ? (int)(p) : NOT_AN_INTERRUPT)
+#define analogInputToDigitalPin(p) ((p) < NUM_ANALOG_INPUTS ? (p) + A0 : -1)
+
+// ===== Math helpers =====
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define radians(deg) ((deg) * DEG_TO_RAD)
+#define degrees(rad) ((rad) * RAD_TO_DEG)
+#define sq(x) ((x) * (x))
+
+#define lowByte(w) ((uint8_t)((w) & 0xff))
+#define highByte(w) ((uint8_t)((w) >> 8))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define bitWrite(value, bit, bitvalue) ((bitvalue) ? bitSet(value, bit) : bitClear(value, bit))
+#define bit(b) (1UL << (b))
+
+using std::min;
+using std::max;
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// ===== Flash strings (plain RAM on the host) =====
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+#define FPSTR(p) (reinterpret_cast<const __FlashStringHelper*>(p))
+
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(s) (s)
+#define DMAMEM
+#define FLASHMEM
+#define FASTRUN
+#define EXTMEM
+
+#define pgm_read_byte(addr)  (*(const uint8_t*)(addr))
+#define pgm_read_word(addr)  (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+#define pgm_read_float(addr) (*(const float*)(addr))
+#define pgm_read_ptr(addr)   (*(void* const*)(addr))
+
+#define memcpy_P memcpy
+#define memcmp_P memcmp
+#define strcpy_P strcpy
+#define strncpy_P strncpy
+#define strcat_P strcat
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strcasecmp_P strcasecmp
+#define strncasecmp_P strncasecmp
+#define strlen_P strlen
+#define strstr_P strstr
+#define sprintf_P sprintf
+#define snprintf_P snprintf
+#define vsnprintf_P vsnprintf
+
+// ===== AVR libc conversions =====
+
+char* itoa(int value, char* out, int base);
+char* utoa(unsigned int value, char* out, int base);
+char* ltoa(long value, char* out, int base);
+char* ultoa(unsigned long value, char* out, int base);
+char* dtostrf(double value, signed char width, unsigned char prec, char* out);
+
+// ===== Interrupts (single-threaded: nothing to mask) =====
+
+#define noInterrupts() do {} while (0)
+#define interrupts() do {} while (0)
+#define cli() do {} while (0)
+#define sei() do {} while (0)
+
+// ===== Core functions =====
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+void analogReadResolution(unsigned int bits);
+void analogReadAveraging(unsigned int samples);
+void analogWriteResolution(unsigned int bits);
+void analogReference(uint8_t mode);
+
+void attachInterrupt(int irq, void (*isr)(), int mode);
+void detachInterrupt(int irq);
+
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration = 0);
+void noTone(uint8_t pin);
+unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout = 1000000UL);
+
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t value);
+uint8_t shiftIn(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder);
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+// ===== String (the subset the firmware touches) =====
+
+class String {
+public:
+    String(const char* s = "") { assign(s); }
+    String(const String& other) { assign(other.buf); }
+    String& operator=(const String& other) { if (this != &other) assign(other.buf); return *this; }
+    ~String() { free(buf); }
+
+    const char* c_str() const { return buf; }
+    unsigned int length() const { return (unsigned int)strlen(buf); }
+    bool operator==(const char* s) const { return strcmp(buf, s) == 0; }
+
+private:
+    char* buf = nullptr;
+    void assign(const char* s) {
+        char* copy = strdup(s ? s : "");
+        free(buf);
+        buf = copy;
+    }
+};
+
+// ===== Print / Stream =====
+
+class Print {
+public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* str) { return str ? write((const uint8_t*)str, strlen(str)) : 0; }
+    size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+
+    size_t print(const __FlashStringHelper* str);
+    size_t print(const String& str);
+    size_t print(const char* str);
+    size_t print(char c);
+    size_t print(unsigned char value, int base = DEC);
+    size_t print(int value, int base = DEC);
+    size_t print(unsigned int value, int base = DEC);
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(long long value, int base = DEC);
+    size_t print(unsigned long long value, int base = DEC);
+    size_t print(double value, int digits = 2);
+
+    size_t println(const __FlashStringHelper* str);
+    size_t println(const String& str);
+    size_t println(const char* str);
+    size_t println(char c);
+    size_t println(unsigned char value, int base = DEC);
+    size_t println(int value, int base = DEC);
+    size_t println(unsigned int value, int base = DEC);
+    size_t println(long value, int base = DEC);
+    size_t println(unsigned long value, int base = DEC);
+    size_t println(long long value, int base = DEC);
+    size_t println(unsigned long long value, int base = DEC);
+    size_t println(double value, int digits = 2);
+    size_t println();
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+private:
+    size_t printNumber(unsigned long long value, uint8_t base);
+    size_t printFloat(double value, uint8_t digits);
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long timeoutMs) { timeout = timeoutMs; }
+    size_t readBytes(char* buffer, size_t length);
+    size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+    size_t readBytesUntil(char terminator, char* buffer, size_t length);
+
+protected:
+    unsigned long timeout = 1000;
+    int timedRead();
+};
+
+// USB serial: stdin/stdout. Extra UARTs (Serial1-Serial8) aren't simulated.
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    void end() {}
+    operator bool() const { return true; }
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int availableForWrite() override { return 4096; }
+    void flush() override;
+
+    int available() override;
+    int read() override;
+    int peek() override;
+};
+
+extern HardwareSerial Serial;
+
+// ===== Sketch entry points (src/main.cpp) =====
+
+void setup();
+void loop();
+
+#endif // SIM_ARDUINO_H
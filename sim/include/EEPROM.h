@@ -0,0 +1,46 @@
+/*
+ * EEPROM.h - EEPROM for the host simulator (env:native)
+ * Part of the preOBD firmware simulator
+ *
+ * A file-backed byte array (--eeprom FILE, default sim_eeprom.bin). Cells
+ * start erased (0xFF) like a new chip; every write goes straight to the file,
+ * so a saved config survives restarting the simulator.
+ */
+
+#ifndef SIM_EEPROM_H
+#define SIM_EEPROM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef SIM_EEPROM_BYTES
+#define SIM_EEPROM_BYTES 4096   // Teensy 4.x emulated EEPROM size
+#endif
+
+class EEPROMClass {
+public:
+    uint8_t read(int address);
+    void write(int address, uint8_t value);
+    void update(int address, uint8_t value) { if (read(address) != value) write(address, value); }
+    uint16_t length() { return SIM_EEPROM_BYTES; }
+
+    // ESP32-style API - writes are already on disk
+    bool begin(size_t size) { (void)size; return true; }
+    bool commit() { return true; }
+
+    template<typename T> T& get(int address, T& value) {
+        uint8_t* bytes = (uint8_t*)&value;
+        for (size_t i = 0; i < sizeof(T); i++) bytes[i] = read(address + (int)i);
+        return value;
+    }
+
+    template<typename T> const T& put(int address, const T& value) {
+        const uint8_t* bytes = (const uint8_t*)&value;
+        for (size_t i = 0; i < sizeof(T); i++) update(address + (int)i, bytes[i]);
+        return value;
+    }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif // SIM_EEPROM_H
@@ -0,0 +1,73 @@
+/*
+ * SD.h - SD card for the host simulator (env:native)
+ * Part of the preOBD firmware simulator
+ *
+ * The card is a host directory (--sd DIR, default sim_sd/): SD.open("/logs/x")
+ * opens DIR/logs/x. Same semantics as the Arduino SD library - FILE_WRITE
+ * creates and appends, File copies share one open handle.
+ */
+
+#ifndef SIM_SD_H
+#define SIM_SD_H
+
+#include <Arduino.h>
+#include <memory>
+
+#define FILE_READ   0
+#define FILE_WRITE  1
+#define FILE_APPEND FILE_WRITE
+
+#ifndef BUILTIN_SDCARD
+#define BUILTIN_SDCARD 254
+#endif
+
+class File : public Stream {
+public:
+    File() {}
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int availableForWrite() override { return isOpen() ? 512 : 0; }
+    void flush() override;
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    int read(void* buffer, size_t size);
+
+    bool seek(uint32_t position);
+    uint32_t position();
+    uint32_t size();
+    void close();
+    bool truncate(uint32_t length = 0);
+
+    const char* name() const;
+    bool isDirectory() const;
+    File openNextFile(uint8_t mode = FILE_READ);
+    void rewindDirectory();
+
+    operator bool() const { return isOpen(); }
+
+private:
+    struct Handle;
+    std::shared_ptr<Handle> handle;
+
+    bool isOpen() const;
+    friend class SDClass;
+};
+
+class SDClass {
+public:
+    bool begin(uint8_t csPin = BUILTIN_SDCARD);
+    File open(const char* path, uint8_t mode = FILE_READ);
+    bool exists(const char* path);
+    bool remove(const char* path);
+    bool mkdir(const char* path);
+    bool rmdir(const char* path);
+    bool rename(const char* from, const char* to);
+};
+
+extern SDClass SD;
+
+#endif // SIM_SD_H
@@ -0,0 +1,48 @@
+/*
+ * SPI.h - SPI bus for the host simulator (env:native)
+ * Part of the preOBD firmware simulator
+ *
+ * No SPI devices are simulated: transfers return 0xFF, as an idle MISO line
+ * would. SPI sensors (thermocouples) read as disconnected.
+ */
+
+#ifndef SIM_SPI_H
+#define SIM_SPI_H
+
+#include <Arduino.h>
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0C
+
+class SPISettings {
+public:
+    SPISettings() {}
+    SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) {
+        (void)clock; (void)bitOrder; (void)dataMode;
+    }
+};
+
+class SPIClass {
+public:
+    void begin() {}
+    void end() {}
+    void beginTransaction(SPISettings settings) { (void)settings; }
+    void endTransaction() {}
+    void usingInterrupt(uint8_t irq) { (void)irq; }
+
+    uint8_t transfer(uint8_t data) { (void)data; return 0xFF; }
+    uint16_t transfer16(uint16_t data) { (void)data; return 0xFFFF; }
+    void transfer(void* buffer, size_t count) { memset(buffer, 0xFF, count); }
+
+    void setMOSI(uint8_t pin) { (void)pin; }
+    void setMISO(uint8_t pin) { (void)pin; }
+    void setSCK(uint8_t pin) { (void)pin; }
+};
+
+extern SPIClass SPI;
+extern SPIClass SPI1;
+extern SPIClass SPI2;
+
+#endif // SIM_SPI_H
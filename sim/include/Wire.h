@@ -0,0 +1,41 @@
+/*
+ * Wire.h - I2C bus for the host simulator (env:native)
+ * Part of the preOBD firmware simulator
+ *
+ * No I2C devices are simulated: every address NAKs, so I2C sensors and
+ * displays report themselves missing.
+ */
+
+#ifndef SIM_WIRE_H
+#define SIM_WIRE_H
+
+#include <Arduino.h>
+
+class TwoWire : public Stream {
+public:
+    void begin() {}
+    void begin(int sda, int scl) { (void)sda; (void)scl; }
+    void end() {}
+    void setClock(uint32_t hz) { (void)hz; }
+    void setSDA(uint8_t pin) { (void)pin; }
+    void setSCL(uint8_t pin) { (void)pin; }
+
+    void beginTransmission(uint8_t address) { (void)address; }
+    uint8_t endTransmission(bool stop = true) { (void)stop; return 2; }   // Address NAK
+    uint8_t requestFrom(uint8_t address, uint8_t count, bool stop = true) {
+        (void)address; (void)count; (void)stop;
+        return 0;
+    }
+
+    size_t write(uint8_t c) override { (void)c; return 1; }
+    using Print::write;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+};
+
+extern TwoWire Wire;
+extern TwoWire Wire1;
+extern TwoWire Wire2;
+
+#endif // SIM_WIRE_H
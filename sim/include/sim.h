@@ -0,0 +1,89 @@
+/*
+ * sim.h - Host simulator control (env:native)
+ * Part of the preOBD firmware simulator
+ *
+ * The simulator runs the real setup() and loop() from src/main.cpp against
+ * host stand-ins for the hardware:
+ *
+ *   Clock   - simulated. In the default (virtual) mode time only moves when
+ *             the firmware spends it: --loop-us per loop() pass, delay(),
+ *             and hal::idleUntilInterrupt(), which skips to the next 1ms tick
+ *             as SysTick would wake the CPU. Runs are deterministic and go as
+ *             fast as the host allows. With --realtime the clock follows the
+ *             host clock, scaled by --speed.
+ *   ADC     - a recorded trace (--adc FILE, CSV): analogRead() and
+ *             digitalRead() return the row in effect at the current time
+ *   CAN     - SocketCAN (--can IFACE[,IFACE...], Linux): bus n is the nth
+ *             interface, e.g. vcan0 next to candump/cansend
+ *   EEPROM  - a file (--eeprom FILE)
+ *   SD card - a directory (--sd DIR)
+ *   Serial  - stdin/stdout
+ *
+ * Usage:
+ *   .pio/build/native/program --adc drive.csv --can vcan0 --duration 600
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef SIM_MAX_CAN_BUSES
+#define SIM_MAX_CAN_BUSES 3     // NUM_CAN_BUSES on PREOBD_NATIVE
+#endif
+
+#ifndef SIM_CLOCK_READ_NS
+#define SIM_CLOCK_READ_NS 100   // Virtual time one millis()/micros() call costs
+#endif
+
+namespace sim {
+
+// ===== Options (set by main() from the command line) =====
+
+struct Options {
+    const char* adcTrace;                      // CSV trace, nullptr = none
+    const char* eepromFile;
+    const char* sdDir;
+    const char* canInterfaces[SIM_MAX_CAN_BUSES];  // nullptr = bus not connected
+    bool realtime;          // Follow the host clock instead of the virtual one
+    double speed;           // Realtime only: simulated seconds per host second
+    uint32_t loopCostUs;    // Virtual only: time one loop() pass costs
+    uint64_t durationUs;    // Stop after this much simulated time, 0 = run on
+    bool stopAtTraceEnd;    // Stop when the ADC trace runs out
+};
+
+Options& options();
+
+// ===== Clock =====
+
+uint64_t nowNs();              // Simulated time since start
+void advanceNs(uint64_t ns);   // Spend time (virtual mode), wait (realtime)
+void idleToNextTick();         // Sleep until the next 1ms tick
+
+// ===== Pins and trace playback =====
+
+bool loadTrace(const char* path);
+bool traceEnded();
+void updateTrace();            // Apply trace rows up to now, fire pin interrupts
+int analogValue(uint8_t pin);
+int digitalValue(uint8_t pin);
+void setDigitalOutput(uint8_t pin, uint8_t value);
+
+// ===== Storage =====
+
+void openEEPROM(const char* path);
+void closeEEPROM();
+
+// ===== Serial =====
+
+void serialBegin();            // stdin non-blocking
+void serialFlush();
+
+// ===== CAN =====
+
+const char* canInterface(uint8_t bus);
+
+} // namespace sim
+
+#endif // SIM_H
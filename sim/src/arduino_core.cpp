@@ -0,0 +1,285 @@
+/*
+ * arduino_core.cpp - Print, Stream, Serial and libc helpers for the host
+ * Part of the preOBD firmware simulator
+ *
+ * Print formats numbers the way the Arduino core does (print(1.5) is "1.50",
+ * print(255, HEX) is "FF"), so serial output matches a board byte for byte.
+ */
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <Wire.h>
+#include "sim.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+HardwareSerial Serial;
+SPIClass SPI;
+SPIClass SPI1;
+SPIClass SPI2;
+TwoWire Wire;
+TwoWire Wire1;
+TwoWire Wire2;
+
+// ===== Print =====
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) {
+        if (write(*buffer++)) n++;
+        else break;
+    }
+    return n;
+}
+
+size_t Print::print(const __FlashStringHelper* str) { return write(reinterpret_cast<const char*>(str)); }
+size_t Print::print(const String& str) { return write(str.c_str()); }
+size_t Print::print(const char* str) { return write(str); }
+size_t Print::print(char c) { return write((uint8_t)c); }
+size_t Print::print(unsigned char value, int base) { return print((unsigned long)value, base); }
+size_t Print::print(int value, int base) { return print((long)value, base); }
+size_t Print::print(unsigned int value, int base) { return print((unsigned long)value, base); }
+size_t Print::print(long value, int base) {
+    // Other bases print the 32-bit two's complement, as on a board
+    if (base != 10 && base != 0) return printNumber((uint32_t)value, (uint8_t)base);
+    return print((long long)value, base);
+}
+size_t Print::print(unsigned long value, int base) { return print((unsigned long long)value, base); }
+
+size_t Print::print(long long value, int base) {
+    if (base == 0) return write((uint8_t)value);
+    if (base == 10 && value < 0) {
+        size_t n = print('-');
+        return n + printNumber((unsigned long long)(-(value + 1)) + 1, 10);
+    }
+    return printNumber((unsigned long long)value, (uint8_t)base);
+}
+
+size_t Print::print(unsigned long long value, int base) {
+    if (base == 0) return write((uint8_t)value);
+    return printNumber(value, (uint8_t)base);
+}
+
+size_t Print::print(double value, int digits) { return printFloat(value, (uint8_t)digits); }
+
+size_t Print::println() { return write("\r\n"); }
+size_t Print::println(const __FlashStringHelper* str) { return print(str) + println(); }
+size_t Print::println(const String& str) { return print(str) + println(); }
+size_t Print::println(const char* str) { return print(str) + println(); }
+size_t Print::println(char c) { return print(c) + println(); }
+size_t Print::println(unsigned char value, int base) { return print(value, base) + println(); }
+size_t Print::println(int value, int base) { return print(value, base) + println(); }
+size_t Print::println(unsigned int value, int base) { return print(value, base) + println(); }
+size_t Print::println(long value, int base) { return print(value, base) + println(); }
+size_t Print::println(unsigned long value, int base) { return print(value, base) + println(); }
+size_t Print::println(long long value, int base) { return print(value, base) + println(); }
+size_t Print::println(unsigned long long value, int base) { return print(value, base) + println(); }
+size_t Print::println(double value, int digits) { return print(value, digits) + println(); }
+
+size_t Print::printf(const char* format, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if (len < 0) return 0;
+    if ((size_t)len >= sizeof(buf)) len = sizeof(buf) - 1;
+    return write((const uint8_t*)buf, (size_t)len);
+}
+
+size_t Print::printNumber(unsigned long long value, uint8_t base) {
+    char buf[8 * sizeof(value) + 1];
+    char* p = &buf[sizeof(buf) - 1];
+    *p = '\0';
+    if (base < 2) base = 10;
+    do {
+        char digit = (char)(value % base);
+        value /= base;
+        *--p = digit < 10 ? digit + '0' : digit + 'A' - 10;
+    } while (value);
+    return write(p);
+}
+
+size_t Print::printFloat(double value, uint8_t digits) {
+    if (isnan(value)) return print("nan");
+    if (isinf(value)) return print("inf");
+    if (value > 4294967040.0 || value < -4294967040.0) return print("ovf");
+
+    size_t n = 0;
+    if (value < 0.0) {
+        n += print('-');
+        value = -value;
+    }
+
+    double rounding = 0.5;
+    for (uint8_t i = 0; i < digits; i++) rounding /= 10.0;
+    value += rounding;
+
+    unsigned long whole = (unsigned long)value;
+    double remainder = value - (double)whole;
+    n += print(whole);
+    if (digits > 0) n += print('.');
+    while (digits-- > 0) {
+        remainder *= 10.0;
+        unsigned int digit = (unsigned int)remainder;
+        n += print(digit);
+        remainder -= digit;
+    }
+    return n;
+}
+
+// ===== Stream =====
+
+int Stream::timedRead() {
+    uint32_t start = millis();
+    do {
+        int c = read();
+        if (c >= 0) return c;
+        delay(1);
+    } while (millis() - start < timeout);
+    return -1;
+}
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+        int c = timedRead();
+        if (c < 0) break;
+        buffer[count++] = (char)c;
+    }
+    return count;
+}
+
+size_t Stream::readBytesUntil(char terminator, char* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+        int c = timedRead();
+        if (c < 0 || c == terminator) break;
+        buffer[count++] = (char)c;
+    }
+    return count;
+}
+
+// ===== Serial: stdin / stdout =====
+
+static uint8_t rxBuf[512];
+static size_t rxHead = 0;
+static size_t rxTail = 0;
+static bool stdinOpen = true;
+static bool txPending = false;
+
+static void fillRx() {
+    if (rxHead < rxTail || !stdinOpen) return;
+    ssize_t n = ::read(STDIN_FILENO, rxBuf, sizeof(rxBuf));
+    if (n > 0) {
+        rxHead = 0;
+        rxTail = (size_t)n;
+    } else if (n == 0) {
+        stdinOpen = false;   // EOF - a piped command script has run out; keep running
+    }
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    txPending = true;
+    return fwrite(buffer, 1, size, stdout);
+}
+
+void HardwareSerial::flush() {
+    sim::serialFlush();
+}
+
+int HardwareSerial::available() {
+    fillRx();
+    return (int)(rxTail - rxHead);
+}
+
+int HardwareSerial::read() {
+    fillRx();
+    if (rxHead >= rxTail) return -1;
+    return rxBuf[rxHead++];
+}
+
+int HardwareSerial::peek() {
+    fillRx();
+    if (rxHead >= rxTail) return -1;
+    return rxBuf[rxHead];
+}
+
+namespace sim {
+
+void serialBegin() {
+    int flags = fcntl(STDIN_FILENO, F_GETFL, 0);
+    if (flags >= 0) fcntl(STDIN_FILENO, F_SETFL, flags | O_NONBLOCK);
+}
+
+void serialFlush() {
+    if (!txPending) return;
+    fflush(stdout);
+    txPending = false;
+}
+
+} // namespace sim
+
+// ===== AVR libc conversions =====
+
+static char* unsignedToString(unsigned long value, char* out, int base) {
+    char buf[8 * sizeof(value) + 1];
+    char* p = &buf[sizeof(buf) - 1];
+    *p = '\0';
+    if (base < 2 || base > 36) base = 10;
+    do {
+        int digit = (int)(value % base);
+        value /= base;
+        *--p = (char)(digit < 10 ? digit + '0' : digit + 'a' - 10);
+    } while (value);
+    strcpy(out, p);
+    return out;
+}
+
+char* ultoa(unsigned long value, char* out, int base) {
+    return unsignedToString(value, out, base);
+}
+
+char* utoa(unsigned int value, char* out, int base) {
+    return unsignedToString(value, out, base);
+}
+
+char* ltoa(long value, char* out, int base) {
+    if (base == 10 && value < 0) {
+        out[0] = '-';
+        unsignedToString((unsigned long)(-(value + 1)) + 1, out + 1, base);
+        return out;
+    }
+    return unsignedToString((unsigned long)value, out, base);
+}
+
+char* itoa(int value, char* out, int base) {
+    if (base == 10) return ltoa(value, out, base);
+    return unsignedToString((unsigned int)value, out, base);
+}
+
+char* dtostrf(double value, signed char width, unsigned char prec, char* out) {
+    sprintf(out, "%*.*f", width, prec, value);
+    return out;
+}
+
+// ===== Random =====
+
+long random(long max) {
+    if (max <= 0) return 0;
+    return ::random() % max;
+}
+
+long random(long min, long max) {
+    if (min >= max) return min;
+    return random(max - min) + min;
+}
+
+void randomSeed(unsigned long seed) {
+    if (seed != 0) srandom((unsigned int)seed);
+}
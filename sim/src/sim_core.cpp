@@ -0,0 +1,376 @@
+/*
+ * sim_core.cpp - Simulated clock, pins and trace playback
+ * Part of the preOBD firmware simulator
+ *
+ * Trace format (--adc FILE): CSV with a header row. The first column is the
+ * time of the row, "time_ms" or "time_s"; every other column is a pin:
+ *
+ *   A<n>    - analog pin An, raw counts at the current analogReadResolution()
+ *   A<n>_V  - analog pin An, volts at the pin (AREF = SIM_AREF_VOLTAGE)
+ *   D<n>    - digital pin n, 0 or 1 - edges fire attachInterrupt() handlers
+ *
+ *   time_ms,A0,A1_V,D2
+ *   0,2048,1.20,0
+ *   100,2051,1.22,1
+ *
+ * A row holds until the next one; after the last row every pin keeps its
+ * last value.
+ */
+
+#include <Arduino.h>
+#include "sim.h"
+
+#include <time.h>
+#include <vector>
+#include <string>
+
+#ifndef SIM_AREF_VOLTAGE
+#define SIM_AREF_VOLTAGE 3.3
+#endif
+
+namespace sim {
+
+static Options opts = {
+    nullptr,                // adcTrace
+    "sim_eeprom.bin",       // eepromFile
+    "sim_sd",               // sdDir
+    {nullptr},              // canInterfaces
+    false,                  // realtime
+    1.0,                    // speed
+    20,                     // loopCostUs
+    0,                      // durationUs
+    false,                  // stopAtTraceEnd
+};
+
+Options& options() { return opts; }
+
+const char* canInterface(uint8_t bus) {
+    return bus < SIM_MAX_CAN_BUSES ? opts.canInterfaces[bus] : nullptr;
+}
+
+// ===== Pins =====
+
+enum ColumnKind : uint8_t { COL_COUNTS, COL_VOLTS, COL_DIGITAL };
+
+struct Column {
+    uint8_t pin;
+    ColumnKind kind;
+};
+
+struct PinState {
+    uint8_t mode;
+    uint8_t level;          // Written (output) or traced (input) level
+    bool traced;            // A digital trace column drives this pin
+    void (*isr)();
+    int isrMode;
+};
+
+static PinState pins[NUM_DIGITAL_PINS];
+static float analogInput[NUM_DIGITAL_PINS];     // Counts or volts, per analogKind
+static ColumnKind analogKind[NUM_DIGITAL_PINS];
+static bool analogTraced[NUM_DIGITAL_PINS];
+static unsigned int analogBits = 10;            // Arduino default until analogReadResolution()
+
+// ===== Trace =====
+
+static std::vector<Column> columns;
+static std::vector<uint64_t> rowTimes;          // ns
+static std::vector<float> rowValues;            // rowTimes.size() x columns.size()
+static size_t nextRow = 0;
+
+// ===== Clock =====
+
+static uint64_t virtualNs = 0;
+static uint64_t hostStartNs = 0;
+
+static uint64_t hostNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t nowNs() {
+    if (!opts.realtime) return virtualNs;
+    if (hostStartNs == 0) hostStartNs = hostNs();
+    return (uint64_t)((double)(hostNs() - hostStartNs) * opts.speed);
+}
+
+static void applyRow(size_t row) {
+    const float* values = &rowValues[row * columns.size()];
+    for (size_t c = 0; c < columns.size(); c++) {
+        const Column& col = columns[c];
+        if (col.kind != COL_DIGITAL) {
+            analogInput[col.pin] = values[c];
+            continue;
+        }
+        PinState& p = pins[col.pin];
+        uint8_t level = values[c] != 0.0f ? HIGH : LOW;
+        uint8_t before = p.level;
+        p.level = level;
+        if (p.isr && level != before &&
+            (p.isrMode == CHANGE || (p.isrMode == RISING && level == HIGH) ||
+             (p.isrMode == FALLING && level == LOW))) {
+            p.isr();
+        }
+    }
+}
+
+// Move the clock to target, stopping at each trace row on the way so the
+// interrupts it fires see their own time
+static void runUntil(uint64_t target) {
+    while (nextRow < rowTimes.size() && rowTimes[nextRow] <= target) {
+        if (!opts.realtime && rowTimes[nextRow] > virtualNs) virtualNs = rowTimes[nextRow];
+        applyRow(nextRow++);
+    }
+    if (!opts.realtime && target > virtualNs) virtualNs = target;
+}
+
+static void sleepHostNs(uint64_t ns) {
+    struct timespec ts;
+    ts.tv_sec = (time_t)(ns / 1000000000ULL);
+    ts.tv_nsec = (long)(ns % 1000000000ULL);
+    nanosleep(&ts, nullptr);
+}
+
+void advanceNs(uint64_t ns) {
+    if (opts.realtime) {
+        uint64_t target = nowNs() + ns;
+        while (nowNs() < target) {
+            sleepHostNs((uint64_t)((double)(target - nowNs()) / opts.speed));
+        }
+        runUntil(target);
+        return;
+    }
+    runUntil(virtualNs + ns);
+}
+
+void idleToNextTick() {
+    uint64_t now = nowNs();
+    uint64_t tick = (now / 1000000ULL + 1) * 1000000ULL;
+    advanceNs(tick - now);
+}
+
+void updateTrace() {
+    runUntil(nowNs());
+}
+
+bool traceEnded() {
+    return !rowTimes.empty() && nextRow >= rowTimes.size();
+}
+
+static bool parseColumn(const std::string& name, Column& col) {
+    if (name.size() < 2) return false;
+    char kind = (char)toupper((unsigned char)name[0]);
+    char* end = nullptr;
+    long n = strtol(name.c_str() + 1, &end, 10);
+    if (end == name.c_str() + 1 || n < 0) return false;
+
+    if (kind == 'A' && n < NUM_ANALOG_INPUTS) {
+        col.pin = (uint8_t)(A0 + n);
+        if (*end == '\0') col.kind = COL_COUNTS;
+        else if (strcasecmp(end, "_V") == 0) col.kind = COL_VOLTS;
+        else return false;
+        return true;
+    }
+    if (kind == 'D' && n < NUM_DIGITAL_PINS && *end == '\0') {
+        col.pin = (uint8_t)n;
+        col.kind = COL_DIGITAL;
+        return true;
+    }
+    return false;
+}
+
+static void splitCsv(const char* line, std::vector<std::string>& fields) {
+    fields.clear();
+    std::string field;
+    for (const char* p = line; ; p++) {
+        if (*p == ',' || *p == '\0' || *p == '\n' || *p == '\r') {
+            fields.push_back(field);
+            field.clear();
+            if (*p != ',') break;
+        } else if (*p != ' ' && *p != '\t') {
+            field += *p;
+        }
+    }
+}
+
+bool loadTrace(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "sim: cannot open trace %s\n", path);
+        return false;
+    }
+
+    char line[4096];
+    std::vector<std::string> fields;
+    if (!fgets(line, sizeof(line), f)) {
+        fprintf(stderr, "sim: trace %s is empty\n", path);
+        fclose(f);
+        return false;
+    }
+    splitCsv(line, fields);
+
+    double timeScale;
+    if (strcasecmp(fields[0].c_str(), "time_ms") == 0) timeScale = 1e6;
+    else if (strcasecmp(fields[0].c_str(), "time_s") == 0) timeScale = 1e9;
+    else {
+        fprintf(stderr, "sim: trace %s: first column must be time_ms or time_s\n", path);
+        fclose(f);
+        return false;
+    }
+
+    columns.clear();
+    for (size_t i = 1; i < fields.size(); i++) {
+        Column col;
+        if (!parseColumn(fields[i], col)) {
+            fprintf(stderr, "sim: trace %s: unknown column '%s' (A<n>, A<n>_V or D<n>)\n",
+                    path, fields[i].c_str());
+            fclose(f);
+            return false;
+        }
+        columns.push_back(col);
+        if (col.kind == COL_DIGITAL) {
+            pins[col.pin].traced = true;
+        } else {
+            analogTraced[col.pin] = true;
+            analogKind[col.pin] = col.kind;
+        }
+    }
+
+    unsigned lineNumber = 1;
+    while (fgets(line, sizeof(line), f)) {
+        lineNumber++;
+        splitCsv(line, fields);
+        if (fields.size() == 1 && fields[0].empty()) continue;   // Blank line
+        if (fields.size() != columns.size() + 1) {
+            fprintf(stderr, "sim: trace %s:%u: expected %zu fields\n", path, lineNumber, columns.size() + 1);
+            fclose(f);
+            return false;
+        }
+        uint64_t t = (uint64_t)(strtod(fields[0].c_str(), nullptr) * timeScale);
+        if (!rowTimes.empty() && t < rowTimes.back()) {
+            fprintf(stderr, "sim: trace %s:%u: time goes backwards\n", path, lineNumber);
+            fclose(f);
+            return false;
+        }
+        rowTimes.push_back(t);
+        for (size_t c = 0; c < columns.size(); c++) {
+            rowValues.push_back(strtof(fields[c + 1].c_str(), nullptr));
+        }
+    }
+    fclose(f);
+
+    fprintf(stderr, "sim: trace %s: %zu rows, %zu pins, %.3f s\n", path, rowTimes.size(),
+            columns.size(), rowTimes.empty() ? 0.0 : rowTimes.back() / 1e9);
+    updateTrace();   // Row 0 before setup() reads anything
+    return true;
+}
+
+int analogValue(uint8_t pin) {
+    if (pin < A0 && pin < NUM_ANALOG_INPUTS) pin += A0;   // analogRead(0) = A0
+    if (pin >= NUM_DIGITAL_PINS || !analogTraced[pin]) return 0;
+    uint32_t fullScale = (1UL << analogBits) - 1;
+    float counts = analogInput[pin];
+    if (analogKind[pin] == COL_VOLTS) counts = counts / (float)SIM_AREF_VOLTAGE * fullScale;
+    if (counts < 0) return 0;
+    if (counts > fullScale) return (int)fullScale;
+    return (int)(counts + 0.5f);
+}
+
+int digitalValue(uint8_t pin) {
+    if (pin >= NUM_DIGITAL_PINS) return LOW;
+    return pins[pin].level;
+}
+
+void setDigitalOutput(uint8_t pin, uint8_t value) {
+    if (pin >= NUM_DIGITAL_PINS || pins[pin].traced) return;
+    pins[pin].level = value ? HIGH : LOW;
+}
+
+} // namespace sim
+
+// ===== Arduino time and pin API =====
+
+uint32_t millis() {
+    if (!sim::opts.realtime) sim::virtualNs += SIM_CLOCK_READ_NS;
+    return (uint32_t)(sim::nowNs() / 1000000ULL);
+}
+
+uint32_t micros() {
+    if (!sim::opts.realtime) sim::virtualNs += SIM_CLOCK_READ_NS;
+    return (uint32_t)(sim::nowNs() / 1000ULL);
+}
+
+void delay(uint32_t ms) {
+    sim::advanceNs((uint64_t)ms * 1000000ULL);
+}
+
+void delayMicroseconds(uint32_t us) {
+    sim::advanceNs((uint64_t)us * 1000ULL);
+}
+
+void yield() {
+    sim::serialFlush();
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin >= NUM_DIGITAL_PINS) return;
+    sim::PinState& p = sim::pins[pin];
+    p.mode = mode;
+    if (!p.traced && mode == INPUT_PULLUP) p.level = HIGH;
+    if (!p.traced && mode == INPUT_PULLDOWN) p.level = LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    sim::setDigitalOutput(pin, value);
+}
+
+int digitalRead(uint8_t pin) {
+    return sim::digitalValue(pin);
+}
+
+int analogRead(uint8_t pin) {
+    return sim::analogValue(pin);
+}
+
+void analogWrite(uint8_t pin, int value) { (void)pin; (void)value; }
+
+void analogReadResolution(unsigned int bits) {
+    if (bits >= 1 && bits <= 16) sim::analogBits = bits;
+}
+
+void analogReadAveraging(unsigned int samples) { (void)samples; }
+void analogWriteResolution(unsigned int bits) { (void)bits; }
+void analogReference(uint8_t mode) { (void)mode; }
+
+void attachInterrupt(int irq, void (*isr)(), int mode) {
+    if (irq < 0 || irq >= NUM_DIGITAL_PINS) return;
+    sim::pins[irq].isr = isr;
+    sim::pins[irq].isrMode = mode;
+}
+
+void detachInterrupt(int irq) {
+    if (irq < 0 || irq >= NUM_DIGITAL_PINS) return;
+    sim::pins[irq].isr = nullptr;
+}
+
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration) {
+    (void)pin; (void)frequency; (void)duration;
+}
+
+void noTone(uint8_t pin) { (void)pin; }
+
+unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout) {
+    (void)pin; (void)state;
+    delayMicroseconds(timeout);   // No pulses are simulated - always times out
+    return 0;
+}
+
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t value) {
+    (void)dataPin; (void)clockPin; (void)bitOrder; (void)value;
+}
+
+uint8_t shiftIn(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder) {
+    (void)dataPin; (void)clockPin; (void)bitOrder;
+    return 0;
+}
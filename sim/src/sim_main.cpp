@@ -0,0 +1,135 @@
+/*
+ * sim_main.cpp - Host simulator entry point
+ * Part of the preOBD firmware simulator
+ *
+ * Parses the command line, then runs setup() once and loop() until the
+ * simulated duration is up, the ADC trace has played out, or Ctrl-C.
+ */
+
+#include <Arduino.h>
+#include "sim.h"
+
+#include <signal.h>
+#include <time.h>
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int) {
+    stopRequested = 1;
+}
+
+static void usage(const char* program) {
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  --adc FILE        Play an ADC/pin trace (CSV, see sim/src/sim_core.cpp)\n"
+        "  --can IF[,IF...]  SocketCAN interface per bus (e.g. vcan0)\n"
+        "  --eeprom FILE     EEPROM image (default sim_eeprom.bin)\n"
+        "  --sd DIR          SD card directory (default sim_sd)\n"
+        "  --duration SEC    Stop after SEC simulated seconds\n"
+        "  --loop-us N       Virtual time one loop() pass costs (default 20)\n"
+        "  --realtime        Follow the host clock instead of the virtual one\n"
+        "  --speed X         With --realtime: simulated seconds per host second\n"
+        "\n"
+        "Without --duration a run with --adc stops when the trace ends.\n"
+        "Serial is stdin/stdout: pipe in a command script or type commands.\n",
+        program);
+}
+
+static bool splitInterfaces(char* list) {
+    uint8_t bus = 0;
+    for (char* name = strtok(list, ","); name; name = strtok(nullptr, ",")) {
+        if (bus >= SIM_MAX_CAN_BUSES) {
+            fprintf(stderr, "sim: at most %d CAN interfaces\n", SIM_MAX_CAN_BUSES);
+            return false;
+        }
+        sim::options().canInterfaces[bus++] = name;
+    }
+    return true;
+}
+
+static bool parseArgs(int argc, char** argv) {
+    sim::Options& opts = sim::options();
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        bool takesValue = true;
+
+        if (strcmp(arg, "--realtime") == 0) {
+            opts.realtime = true;
+            takesValue = false;
+        } else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            return false;
+        } else if (!value) {
+            fprintf(stderr, "sim: %s needs a value\n", arg);
+            return false;
+        } else if (strcmp(arg, "--adc") == 0) {
+            opts.adcTrace = value;
+        } else if (strcmp(arg, "--can") == 0) {
+            if (!splitInterfaces(argv[i + 1])) return false;
+        } else if (strcmp(arg, "--eeprom") == 0) {
+            opts.eepromFile = value;
+        } else if (strcmp(arg, "--sd") == 0) {
+            opts.sdDir = value;
+        } else if (strcmp(arg, "--duration") == 0) {
+            opts.durationUs = (uint64_t)(atof(value) * 1e6);
+        } else if (strcmp(arg, "--loop-us") == 0) {
+            opts.loopCostUs = (uint32_t)atol(value);
+        } else if (strcmp(arg, "--speed") == 0) {
+            opts.speed = atof(value);
+            if (opts.speed <= 0) {
+                fprintf(stderr, "sim: --speed must be positive\n");
+                return false;
+            }
+        } else {
+            fprintf(stderr, "sim: unknown option %s\n", arg);
+            return false;
+        }
+        if (takesValue) i++;
+    }
+    opts.stopAtTraceEnd = opts.adcTrace && opts.durationUs == 0;
+    return true;
+}
+
+static double hostSeconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char** argv) {
+    if (!parseArgs(argc, argv)) {
+        usage(argv[0]);
+        return 2;
+    }
+    sim::Options& opts = sim::options();
+
+    if (opts.adcTrace && !sim::loadTrace(opts.adcTrace)) return 1;
+    sim::openEEPROM(opts.eepromFile);
+    sim::serialBegin();
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    double hostStart = hostSeconds();
+    uint64_t passes = 0;
+
+    setup();
+    while (!stopRequested) {
+        loop();
+        passes++;
+        sim::serialFlush();
+        if (!opts.realtime) sim::advanceNs((uint64_t)opts.loopCostUs * 1000ULL);
+        else sim::updateTrace();
+
+        if (opts.durationUs && sim::nowNs() >= opts.durationUs * 1000ULL) break;
+        if (opts.stopAtTraceEnd && sim::traceEnded()) break;
+    }
+    sim::serialFlush();
+    sim::closeEEPROM();
+
+    double simulated = sim::nowNs() / 1e9;
+    double host = hostSeconds() - hostStart;
+    fprintf(stderr, "sim: %.3f s simulated in %.3f s (%.1fx), %llu loop passes\n",
+            simulated, host, host > 0 ? simulated / host : 0.0, (unsigned long long)passes);
+    return 0;
+}
@@ -0,0 +1,244 @@
+/*
+ * sim_storage.cpp - File-backed EEPROM and SD card
+ * Part of the preOBD firmware simulator
+ */
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <SD.h>
+#include "sim.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+
+EEPROMClass EEPROM;
+SDClass SD;
+
+// ===== EEPROM =====
+
+static uint8_t eepromImage[SIM_EEPROM_BYTES];
+static FILE* eepromFile = nullptr;
+
+namespace sim {
+
+void openEEPROM(const char* path) {
+    memset(eepromImage, 0xFF, sizeof(eepromImage));
+    eepromFile = fopen(path, "r+b");
+    if (eepromFile) {
+        size_t n = fread(eepromImage, 1, sizeof(eepromImage), eepromFile);
+        (void)n;   // A shorter file leaves the rest erased
+    } else {
+        eepromFile = fopen(path, "w+b");
+        if (!eepromFile) {
+            fprintf(stderr, "sim: cannot create %s - EEPROM writes won't persist\n", path);
+            return;
+        }
+    }
+    fseek(eepromFile, 0, SEEK_SET);
+    fwrite(eepromImage, 1, sizeof(eepromImage), eepromFile);
+    fflush(eepromFile);
+}
+
+void closeEEPROM() {
+    if (eepromFile) fclose(eepromFile);
+    eepromFile = nullptr;
+}
+
+} // namespace sim
+
+uint8_t EEPROMClass::read(int address) {
+    if (address < 0 || address >= SIM_EEPROM_BYTES) return 0xFF;
+    return eepromImage[address];
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+    if (address < 0 || address >= SIM_EEPROM_BYTES) return;
+    eepromImage[address] = value;
+    if (!eepromFile) return;
+    fseek(eepromFile, address, SEEK_SET);
+    fputc(value, eepromFile);
+    fflush(eepromFile);
+}
+
+// ===== SD card =====
+
+struct File::Handle {
+    FILE* fp = nullptr;
+    DIR* dir = nullptr;
+    std::string path;       // Host path
+    std::string name;       // Last path component
+};
+
+static bool sdReady = false;
+
+static std::string hostPath(const char* path) {
+    std::string p = sim::options().sdDir;
+    if (!path || path[0] != '/') p += '/';
+    if (path) p += path;
+    return p;
+}
+
+static const char* baseName(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    return path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+}
+
+bool SDClass::begin(uint8_t csPin) {
+    (void)csPin;
+    const char* root = sim::options().sdDir;
+    if (!root) return false;
+    ::mkdir(root, 0755);
+    struct stat st;
+    sdReady = stat(root, &st) == 0 && S_ISDIR(st.st_mode);
+    return sdReady;
+}
+
+File SDClass::open(const char* path, uint8_t mode) {
+    File file;
+    if (!sdReady) return file;
+
+    std::string host = hostPath(path);
+    auto handle = std::make_shared<File::Handle>();
+    handle->path = host;
+    handle->name = baseName(host);
+
+    struct stat st;
+    if (stat(host.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+        handle->dir = opendir(host.c_str());
+        if (!handle->dir) return file;
+    } else {
+        handle->fp = fopen(host.c_str(), mode == FILE_WRITE ? "a+b" : "rb");
+        if (!handle->fp) return file;
+        if (mode == FILE_WRITE) fseek(handle->fp, 0, SEEK_END);   // Writes append
+    }
+    file.handle = handle;
+    return file;
+}
+
+bool SDClass::exists(const char* path) {
+    struct stat st;
+    return sdReady && stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool SDClass::remove(const char* path) {
+    return sdReady && ::unlink(hostPath(path).c_str()) == 0;
+}
+
+bool SDClass::mkdir(const char* path) {
+    if (!sdReady) return false;
+    // Creates parents too, as the SD library does
+    std::string host = hostPath(path);
+    for (size_t i = sim::options().sdDir ? strlen(sim::options().sdDir) + 1 : 0; i <= host.size(); i++) {
+        if (i == host.size() || host[i] == '/') {
+            std::string part = host.substr(0, i);
+            ::mkdir(part.c_str(), 0755);
+        }
+    }
+    struct stat st;
+    return stat(host.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+bool SDClass::rmdir(const char* path) {
+    return sdReady && ::rmdir(hostPath(path).c_str()) == 0;
+}
+
+bool SDClass::rename(const char* from, const char* to) {
+    return sdReady && ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
+
+bool File::isOpen() const {
+    return handle && (handle->fp || handle->dir);
+}
+
+size_t File::write(const uint8_t* buffer, size_t size) {
+    if (!handle || !handle->fp) return 0;
+    return fwrite(buffer, 1, size, handle->fp);
+}
+
+void File::flush() {
+    if (handle && handle->fp) fflush(handle->fp);
+}
+
+int File::available() {
+    if (!handle || !handle->fp) return 0;
+    long here = ftell(handle->fp);
+    uint32_t total = size();
+    return here < 0 || (uint32_t)here >= total ? 0 : (int)(total - (uint32_t)here);
+}
+
+int File::read() {
+    if (!handle || !handle->fp) return -1;
+    int c = fgetc(handle->fp);
+    return c == EOF ? -1 : c;
+}
+
+int File::peek() {
+    if (!handle || !handle->fp) return -1;
+    int c = fgetc(handle->fp);
+    if (c == EOF) return -1;
+    ungetc(c, handle->fp);
+    return c;
+}
+
+int File::read(void* buffer, size_t size) {
+    if (!handle || !handle->fp) return -1;
+    return (int)fread(buffer, 1, size, handle->fp);
+}
+
+bool File::seek(uint32_t pos) {
+    return handle && handle->fp && fseek(handle->fp, (long)pos, SEEK_SET) == 0;
+}
+
+uint32_t File::position() {
+    if (!handle || !handle->fp) return 0;
+    long here = ftell(handle->fp);
+    return here < 0 ? 0 : (uint32_t)here;
+}
+
+uint32_t File::size() {
+    if (!handle || !handle->fp) return 0;
+    fflush(handle->fp);
+    struct stat st;
+    return fstat(fileno(handle->fp), &st) == 0 ? (uint32_t)st.st_size : 0;
+}
+
+void File::close() {
+    if (!handle) return;
+    if (handle->fp) fclose(handle->fp);
+    if (handle->dir) closedir(handle->dir);
+    handle->fp = nullptr;
+    handle->dir = nullptr;
+}
+
+bool File::truncate(uint32_t length) {
+    if (!handle || !handle->fp) return false;
+    fflush(handle->fp);
+    return ftruncate(fileno(handle->fp), (off_t)length) == 0;
+}
+
+const char* File::name() const {
+    return handle ? handle->name.c_str() : "";
+}
+
+bool File::isDirectory() const {
+    return handle && handle->dir;
+}
+
+File File::openNextFile(uint8_t mode) {
+    File next;
+    if (!handle || !handle->dir) return next;
+    struct dirent* entry;
+    while ((entry = readdir(handle->dir)) != nullptr) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        std::string child = handle->path + "/" + entry->d_name;
+        std::string root = sim::options().sdDir;
+        return SD.open(child.c_str() + root.size(), mode);   // Back to a card path
+    }
+    return next;
+}
+
+void File::rewindDirectory() {
+    if (handle && handle->dir) rewinddir(handle->dir);
+}
@@ -111,7 +111,11 @@
 #define REALDASH_INTERVAL_MS 100         // RealDash updates (10Hz)
 #define LCD_UPDATE_INTERVAL_MS 500       // LCD display (2Hz) - human readable
 #define SERIAL_CSV_INTERVAL_MS 1000      // Serial CSV (1Hz) - prevents buffer flooding
-#define SD_LOG_INTERVAL_MS 5000          // SD logging (0.2Hz) - reduces wear
+#define SD_LOG_INTERVAL_MS 5000          // SD logging (0.2Hz) - alarms trigger full-rate bursts
+
+#ifndef USB_SERIAL_WAIT_MS
+#define USB_SERIAL_WAIT_MS 3000          // Max time boot waits for a USB host (0 = don't wait)
+#endif                                   // Overlaps bus/sensor init; vehicle installs can use 0
 
 // ============================================================================
 // TEST MODE CONFIGURATION
@@ -134,9 +138,10 @@
     // Request/response mode is always enabled when CAN is enabled
     // No additional configuration needed - auto-responds to 0x7DF and 0x7E0 requests
 
-    // Optional: Minimum interval between OBD-II requests (ms) to prevent bus flooding
-    // Most scanners query sequentially at ~1-10 Hz, so this is rarely needed
-    // #define OBD2_MIN_REQUEST_INTERVAL_MS 10  // Uncomment to enable rate limiting
+    // Minimum interval between answered OBD-II requests per addressing mode (ms)
+    // Protects the main loop from a flooding tester; most scanners query
+    // sequentially at ~1-10 Hz and never hit it. 0 disables the limit.
+    // #define OBD2_MIN_REQUEST_INTERVAL_MS 5   // Default (outputs/output_can.cpp)
 #endif
 
 // ============================================================================
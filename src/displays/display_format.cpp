@@ -0,0 +1,82 @@
+/*
+ * display_format.cpp - Input readings as the displays show them
+ */
+
+#include "display_format.h"
+#include "../lib/sensor_types.h"
+#include "../lib/units_registry.h"
+#include "../inputs/input_manager.h"  // toInputUnits()
+#ifdef USE_STATIC_CONFIG
+#include "../lib/generated/sensor_library_static.h"
+#else
+#include "../lib/sensor_library.h"
+#endif
+
+static void setText(DisplayReading* out, const char* text) {
+    strcpy(out->text, text);
+    out->length = strlen(text);
+}
+
+void formatDisplayReading(const Input* input, DisplayReading* out) {
+    out->numeric = false;
+    out->degrees = false;
+    out->symbol = nullptr;
+
+    // If sensor is not enabled, show "CFG"
+    if (!input->flags.isEnabled) {
+        setText(out, "CFG");
+        return;
+    }
+    // Check for invalid values (NaN)
+    if (isnan(input->value)) {
+        setText(out, "ERR");
+        return;
+    }
+    // If value is exactly 0.0, show "---" (likely in CONFIG mode, not yet read)
+    if (input->value == 0.0f) {
+        setText(out, "---");
+        return;
+    }
+
+    // Convert to display units
+    float displayValue = toInputUnits(input, input->value);
+
+    // Get unit info from registry
+    const UnitsInfo* unitInfo = getUnitsByIndex(input->unitsIndex);
+    MeasurementType measType = MEASURE_TEMPERATURE;
+    if (unitInfo) {
+        measType = (MeasurementType)pgm_read_byte(&unitInfo->measurementType);
+    }
+
+    // Determine decimal precision based on measurement type
+    uint8_t decimals = 1;  // Default: 1 decimal place
+    switch (measType) {
+        case MEASURE_TEMPERATURE:
+        case MEASURE_HUMIDITY:
+        case MEASURE_ELEVATION:
+        case MEASURE_RPM:
+        case MEASURE_SPEED:
+        case MEASURE_DIGITAL:
+            decimals = 0;  // No decimals for these
+            break;
+        case MEASURE_PRESSURE:
+            // inHg uses 2 decimals, others use 1
+            decimals = (input->unitsIndex == getUnitsIndexByName("INHG")) ? 2 : 1;
+            break;
+        case MEASURE_VOLTAGE:
+            decimals = 1;  // 1 decimal for voltage
+            break;
+        default:
+            break;
+    }
+
+    out->length = formatFixed(out->text, displayValue, decimals);
+    out->numeric = true;
+
+    // Temperature gets a degree symbol before the unit; others the registry symbol
+    if (measType == MEASURE_TEMPERATURE) {
+        out->degrees = true;
+    } else if (unitInfo) {
+        out->symbol = input->unitsSymbol;
+    }
+}
@@ -0,0 +1,28 @@
+/*
+ * display_format.h - Input readings as the displays show them
+ *
+ * The LCD and OLED show a reading the same way: "CFG" for a disabled
+ * input, "ERR" for NAN, "---" before the first reading, otherwise the value
+ * in its display units at the measurement's precision (none for
+ * temperatures, RPM, speed...; two for inHg), then a degree sign or the
+ * unit's symbol. Each backend draws the degree sign its own way.
+ */
+
+#ifndef DISPLAY_FORMAT_H
+#define DISPLAY_FORMAT_H
+
+#include <Arduino.h>
+#include "../inputs/input.h"
+#include "../lib/float_format.h"
+
+struct DisplayReading {
+    char text[FLOAT_FORMAT_SIZE];   // Value or status text, NUL terminated
+    uint8_t length;
+    bool numeric;                   // text is a value - a unit follows
+    bool degrees;                   // Temperature: degree sign instead of a symbol
+    const char* symbol;             // Unit symbol (PROGMEM), nullptr if none
+};
+
+void formatDisplayReading(const Input* input, DisplayReading* out);
+
+#endif // DISPLAY_FORMAT_H
@@ -1,5 +1,21 @@
 /*
  * display_lcd.cpp - LCD display module
+ *
+ * Each refresh renders into a RAM copy of the screen and sends only the
+ * characters that changed since the previous one, so a steady reading
+ * costs no I2C traffic on the bus the LCD shares with I2C sensors. Which
+ * inputs a refresh draws is up to the page layout (lcd_layout.h).
+ *
+ * The changes go out as an I2C engine job (lib/i2c_engine.h) rather than
+ * inside the refresh: each loop pass sends runs of them until the pass's
+ * I2C budget is used, so a full redraw (tens of ms of bus time) is spread
+ * over several passes with sensor reads in between, and nothing is sent
+ * while the bus is stuck. A refresh before the last one is out just moves
+ * the target - the job always sends what frame holds now.
+ *
+ * Build Flags:
+ *   -D LCD_FLUSH_MAX_GAP=n  - Unchanged characters rewritten to join two
+ *                             changed runs instead of a setCursor (default 1)
  */
 
 #include "../config.h"
@@ -8,6 +24,8 @@
 #include "../lib/units_registry.h"
 #include "../lib/message_api.h"
 #include "../lib/log_tags.h"
+#include "display_format.h"
+#include "../lib/i2c_engine.h"
 #ifdef USE_STATIC_CONFIG
 #include "../lib/generated/application_presets_static.h"
 #include "../lib/generated/sensor_library_static.h"
@@ -19,15 +37,21 @@
 #ifdef ENABLE_LCD
 
 #include <LiquidCrystal_I2C.h>
+#include "lcd_layout.h"  // LCD_COLS, LCD_ROWS
 
-// LCD display configuration
-#define LCD_COLS 20
-#define LCD_ROWS 4
-#define LCD_COLUMNS_PER_SENSOR (LCD_COLS / 2)  // Split display into 2 columns
+// Unchanged characters rewritten rather than starting a new run (flushLCD)
+#ifndef LCD_FLUSH_MAX_GAP
+#define LCD_FLUSH_MAX_GAP 1
+#endif
 
 LiquidCrystal_I2C lcd(0x27, LCD_COLS, LCD_ROWS);
 byte currentLine = 0;
 
+// Shadow of the glass: updateLCD() renders into frame, the flush job sends
+// only the characters that differ from shown (what the LCD holds)
+static byte frame[LCD_ROWS][LCD_COLS];
+static byte shown[LCD_ROWS][LCD_COLS];
+
 // Custom character icon definitions
 enum ICONS{
     ICON_DEGREE,
@@ -53,6 +77,7 @@ byte coolant_icon[8] = {0x04,0x07,0x04,0x07,0x04,0x0E,0x0E,0x04};
 // Forward declarations
 void showConfigModeMessage();
 byte getIconForApplication(uint8_t appIndex);
+static void clearShadow();
 
 void initLCD() {
     lcd.init();
@@ -65,7 +90,7 @@ void initLCD() {
     lcd.createChar(ICON_TACHOMETER, tachometer_icon);
     lcd.createChar(ICON_COOLANT, coolant_icon);
     lcd.createChar(ICON_OIL, oil_icon);
-    lcd.clear();
+    clearShadow();
     msg.debug.info(TAG_DISPLAY, "LCD initialized");
 }
 
@@ -131,163 +156,98 @@ byte getIconForApplication(uint8_t appIndex) {
     }
 }
 
+// Put text in a sensor cell from column n, as much as fits
+static void putText(byte* cell, int& n, const char* text, int len) {
+    for (int i = 0; i < len && n < LCD_COLUMNS_PER_SENSOR; i++) {
+        cell[n++] = text[i];
+    }
+}
+
 void displaySensor(Input *ptr, byte line) {
     // Calculate column position based on LCD_COLUMNS_PER_SENSOR
     byte col = (line >= LCD_ROWS) ? LCD_COLUMNS_PER_SENSOR : 0;
     byte row = (line >= LCD_ROWS) ? line - LCD_ROWS : line;
+    if (row >= LCD_ROWS) return;            // Past both columns
 
-    lcd.setCursor(col, row);
-
+    byte* cell = &frame[row][col];
     int charsPrinted = 0;
 
     if (ptr->flags.display) {
-        // Print icon
-        if (charsPrinted < LCD_COLUMNS_PER_SENSOR) {
-            lcd.write(getIconForApplication(ptr->applicationIndex));
-            charsPrinted++;
-        }
-
-        // Print sensor abbreviation
-        if (charsPrinted < LCD_COLUMNS_PER_SENSOR) {
-            int abbrLen = strlen(ptr->abbrName);
-            int charsAvailable = LCD_COLUMNS_PER_SENSOR - charsPrinted;
-            if (abbrLen > charsAvailable) abbrLen = charsAvailable;
-            for (int i = 0; i < abbrLen; i++) {
-                lcd.print(ptr->abbrName[i]);
+        // Icon, abbreviation and colon
+        cell[charsPrinted++] = getIconForApplication(ptr->applicationIndex);
+        putText(cell, charsPrinted, ptr->abbrName, strlen(ptr->abbrName));
+        putText(cell, charsPrinted, ":", 1);
+
+        // Reading, truncated if it won't fit, then its unit (if space available)
+        DisplayReading reading;
+        formatDisplayReading(ptr, &reading);
+        putText(cell, charsPrinted, reading.text, reading.length);
+        if (reading.degrees && charsPrinted < LCD_COLUMNS_PER_SENSOR) {
+            cell[charsPrinted++] = ICON_DEGREE;
+        } else if (reading.symbol) {
+            int symLen = strlen_P(reading.symbol);
+            for (int i = 0; i < symLen && charsPrinted < LCD_COLUMNS_PER_SENSOR; i++) {
+                cell[charsPrinted++] = pgm_read_byte(reading.symbol + i);
             }
-            charsPrinted += abbrLen;
-        }
-
-        // Print colon
-        if (charsPrinted < LCD_COLUMNS_PER_SENSOR) {
-            lcd.print(":");
-            charsPrinted++;
         }
+    }
 
-        // If sensor is not enabled, show "CFG"
-        if (!ptr->flags.isEnabled) {
-            if (charsPrinted < LCD_COLUMNS_PER_SENSOR) {
-                int remaining = LCD_COLUMNS_PER_SENSOR - charsPrinted;
-                if (remaining >= 3) {
-                    charsPrinted += lcd.print("CFG");
-                } else {
-                    // Print as much as we can fit
-                    const char* msg = "CFG";
-                    for (int i = 0; i < remaining; i++) {
-                        lcd.print(msg[i]);
-                        charsPrinted++;
-                    }
-                }
-            }
-        }
-        // Check for invalid values (NaN)
-        else if (isnan(ptr->value)) {
-            if (charsPrinted < LCD_COLUMNS_PER_SENSOR) {
-                int remaining = LCD_COLUMNS_PER_SENSOR - charsPrinted;
-                if (remaining >= 3) {
-                    charsPrinted += lcd.print("ERR");
-                } else {
-                    const char* msg = "ERR";
-                    for (int i = 0; i < remaining; i++) {
-                        lcd.print(msg[i]);
-                        charsPrinted++;
-                    }
-                }
-            }
-        }
-        // If value is exactly 0.0, show "---" (likely in CONFIG mode, not yet read)
-        else if (ptr->value == 0.0f) {
-            if (charsPrinted < LCD_COLUMNS_PER_SENSOR) {
-                int remaining = LCD_COLUMNS_PER_SENSOR - charsPrinted;
-                if (remaining >= 3) {
-                    charsPrinted += lcd.print("---");
-                } else {
-                    const char* msg = "---";
-                    for (int i = 0; i < remaining; i++) {
-                        lcd.print(msg[i]);
-                        charsPrinted++;
-                    }
-                }
-            }
-        } else {
-            // Convert to display units
-            float displayValue = convertFromBaseUnits(ptr->value, ptr->unitsIndex);
-
-            // Get unit info from registry
-            const UnitsInfo* unitInfo = getUnitsByIndex(ptr->unitsIndex);
-            MeasurementType measType = MEASURE_TEMPERATURE;
-            if (unitInfo) {
-                measType = (MeasurementType)pgm_read_byte(&unitInfo->measurementType);
-            }
+    // Pad remaining space in the column to clear old data
+    while (charsPrinted < LCD_COLUMNS_PER_SENSOR) {
+        cell[charsPrinted++] = ' ';
+    }
+}
 
-            // Determine decimal precision based on measurement type
-            int decimals = 1;  // Default: 1 decimal place
-            switch (measType) {
-                case MEASURE_TEMPERATURE:
-                case MEASURE_HUMIDITY:
-                case MEASURE_ELEVATION:
-                case MEASURE_RPM:
-                case MEASURE_SPEED:
-                case MEASURE_DIGITAL:
-                    decimals = 0;  // No decimals for these
-                    break;
-                case MEASURE_PRESSURE:
-                    // inHg uses 2 decimals, others use 1
-                    decimals = (ptr->unitsIndex == getUnitsIndexByName("INHG")) ? 2 : 1;
-                    break;
-                case MEASURE_VOLTAGE:
-                    decimals = 1;  // 1 decimal for voltage
-                    break;
+/**
+ * Send the characters of frame that differ from shown (I2C engine job)
+ *
+ * One setCursor per run of changes in a row; a gap of up to
+ * LCD_FLUSH_MAX_GAP unchanged characters is rewritten rather than
+ * skipped, since a setCursor costs as much on the bus as a character.
+ * Stops after the run that uses up the pass's I2C budget.
+ *
+ * @return true when the glass matches frame
+ */
+static bool flushLCDJob() {
+    if (!i2cBusReady()) return false;
+
+    for (byte row = 0; row < LCD_ROWS; row++) {
+        int col = 0;
+        while (col < LCD_COLS) {
+            if (frame[row][col] == shown[row][col]) {
+                col++;
+                continue;
             }
 
-            // Print value with appropriate precision (if space available)
-            if (charsPrinted < LCD_COLUMNS_PER_SENSOR) {
-                // Format the value to a string first to check length
-                char valBuffer[12];
-                dtostrf(displayValue, 1, decimals, valBuffer);
-                int valLen = strlen(valBuffer);
-                int charsAvailable = LCD_COLUMNS_PER_SENSOR - charsPrinted;
-
-                // If value + unit symbols won't fit, truncate
-                if (valLen > charsAvailable) {
-                    valLen = charsAvailable;
-                }
-
-                for (int i = 0; i < valLen; i++) {
-                    lcd.print(valBuffer[i]);
-                    charsPrinted++;
-                }
+            // Extend the run while the next change is within the gap
+            int end = col + 1;
+            int last = col;
+            while (end < LCD_COLS && end - last <= LCD_FLUSH_MAX_GAP + 1) {
+                if (frame[row][end] != shown[row][end]) last = end;
+                end++;
             }
 
-            // Print unit symbol from registry (if space available)
-            if (charsPrinted < LCD_COLUMNS_PER_SENSOR) {
-                if (measType == MEASURE_TEMPERATURE) {
-                    // Temperature gets a degree symbol before the unit
-                    lcd.write((byte)ICON_DEGREE);
-                    charsPrinted++;
-                } else if (unitInfo) {
-                    // Use symbol from registry
-                    const char* symPtr = (const char*)pgm_read_ptr(&unitInfo->symbol);
-                    if (symPtr) {
-                        int symLen = strlen_P(symPtr);
-                        int charsAvailable = LCD_COLUMNS_PER_SENSOR - charsPrinted;
-                        if (symLen > charsAvailable) symLen = charsAvailable;
-
-                        for (int i = 0; i < symLen; i++) {
-                            char c = pgm_read_byte(symPtr + i);
-                            lcd.print(c);
-                            charsPrinted++;
-                        }
-                    }
-                }
+            lcd.setCursor(col, row);
+            for (int i = col; i <= last; i++) {
+                lcd.write(frame[row][i]);
+                shown[row][i] = frame[row][i];
             }
+            col = last + 1;
+            if (i2cSliceDone()) return false;
         }
     }
+    return true;
+}
 
-    // Pad remaining space in the column to clear old data
-    for (int i = charsPrinted; i < LCD_COLUMNS_PER_SENSOR; i++) {
-        lcd.print(" ");
-    }
+static void flushLCD() {
+    i2cQueueJob(flushLCDJob, I2C_JOB_DISPLAY);
+}
+
+// Blank the glass, and both buffers with it
+static void clearShadow() {
+    lcd.clear();
+    memset(frame, ' ', sizeof(frame));
+    memset(shown, ' ', sizeof(shown));
 }
 
 void updateLCD(Input** inputs, int numInputs) {
@@ -306,27 +266,29 @@ void updateLCD(Input** inputs, int numInputs) {
     // Clear the CONFIG MODE message when first sensor is configured
     static bool firstSensorShown = false;
     if (!firstSensorShown) {
-        lcd.clear();
+        clearShadow();
         firstSensorShown = true;
     }
 
-    // Display all sensors (enabled will show values, disabled will show "CFG")
+    // Render all sensors (enabled will show values, disabled will show "CFG");
+    // lines no sensor draws on any more come out blank
+    memset(frame, ' ', sizeof(frame));
     for (int i = 0; i < numInputs; i++) {
         displaySensor(inputs[i], currentLine);
         currentLine++;
     }
+    flushLCD();
 }
 
 void clearLCD() {
-    lcd.clear();
+    clearShadow();
 }
 
 void showConfigModeMessage() {
-    lcd.clear();
-    lcd.setCursor(0, 0);
-    lcd.print("CONFIG MODE");
-    lcd.setCursor(0, 1);
-    lcd.print("Use serial console");
+    clearShadow();
+    memcpy(frame[0], "CONFIG MODE", 11);
+    memcpy(frame[1], "Use serial console", 18);
+    flushLCD();
 }
 
 void enableLCD() {
@@ -335,10 +297,10 @@ void enableLCD() {
 
 void disableLCD() {
     lcd.noBacklight();
-    lcd.clear();
+    clearShadow();
 }
 
-#else
+#elif !defined(ENABLE_OLED)  // display_oled.cpp provides the hooks
 
 void initLCD() {}
 void displaySensor(Input *ptr, byte line) {}
@@ -0,0 +1,297 @@
+/*
+ * display_oled.cpp - SSD1306 graphic OLED over SPI
+ *
+ * frame[][] is drawn each update; shown[][] is what the panel holds. The
+ * bounding box of their differences is copied to txBuffer (so the next
+ * frame can be drawn while it is sent) and written with the SSD1306 column
+ * and page address window set to the box.
+ */
+
+#include "display_oled.h"
+#include "../config.h"
+
+#ifdef ENABLE_OLED
+
+#ifdef ENABLE_LCD
+#error "ENABLE_OLED and ENABLE_LCD are alternatives - define one"
+#endif
+
+#include <SPI.h>
+#include "font5x7.h"
+#include "display_format.h"
+#include "../inputs/input.h"
+#include "../lib/bus_manager.h"
+#include "../lib/pin_registry.h"
+#include "../lib/message_api.h"
+#include "../lib/log_tags.h"
+
+#if defined(__IMXRT1062__)
+#include <EventResponder.h>
+#define OLED_DMA 1
+#else
+#define OLED_DMA 0
+#endif
+
+// SSD1306 commands
+#define SSD1306_COLUMN_ADDR 0x21
+#define SSD1306_PAGE_ADDR   0x22
+#define SSD1306_DISPLAY_OFF 0xAE
+#define SSD1306_DISPLAY_ON  0xAF
+
+static const uint8_t SSD1306_INIT[] PROGMEM = {
+    0xAE,           // Display off
+    0xD5, 0x80,     // Clock divide
+    0xA8, 0x3F,     // Multiplex: 64 rows
+    0xD3, 0x00,     // No display offset
+    0x40,           // Start line 0
+    0x8D, 0x14,     // Charge pump on
+    0x20, 0x00,     // Horizontal addressing - a window fills row by row
+    0xA1,           // Segment remap (column 127 = SEG0)
+    0xC8,           // COM scan descending
+    0xDA, 0x12,     // COM pins: alternative
+    0x81, 0xCF,     // Contrast
+    0xD9, 0xF1,     // Pre-charge
+    0xDB, 0x40,     // VCOMH deselect
+    0xA4,           // Show RAM
+    0xA6            // Not inverted
+};
+
+static uint8_t frame[OLED_PAGES][OLED_WIDTH];
+static uint8_t shown[OLED_PAGES][OLED_WIDTH];
+static uint8_t txBuffer[OLED_PAGES * OLED_WIDTH];
+
+static SPIClass* spi = nullptr;
+static const SPISettings OLED_SPI_SETTINGS(OLED_SPI_CLOCK, MSBFIRST, SPI_MODE0);
+
+static volatile bool transferring = false;
+
+#if OLED_DMA
+static bool useDma = false;                 // Own bus - nothing else drives it mid-transfer
+static EventResponder transferEvent;
+
+// Runs from yield(), between loop() passes - not in the DMA interrupt
+static void transferDone(EventResponderRef event) {
+    (void)event;
+    digitalWrite(OLED_CS_PIN, HIGH);
+    spi->endTransaction();
+    transferring = false;
+}
+#endif
+
+static void waitTransfer() {
+    while (transferring) yield();
+}
+
+static SPIClass* oledBus() {
+#if defined(__IMXRT1062__)
+    switch (OLED_SPI_BUS) {
+        case 1: return &SPI1;
+        case 2: return &SPI2;
+        default: return &SPI;
+    }
+#else
+    return getActiveSPI();
+#endif
+}
+
+static void sendCommands(const uint8_t* commands, uint8_t count, bool progmem) {
+    waitTransfer();
+    spi->beginTransaction(OLED_SPI_SETTINGS);
+    digitalWrite(OLED_DC_PIN, LOW);
+    digitalWrite(OLED_CS_PIN, LOW);
+    for (uint8_t i = 0; i < count; i++) {
+        spi->transfer(progmem ? pgm_read_byte(commands + i) : commands[i]);
+    }
+    digitalWrite(OLED_CS_PIN, HIGH);
+    spi->endTransaction();
+}
+
+/**
+ * Send the bounding box of frame's differences from shown
+ *
+ * While a DMA transfer is still in flight nothing is sent: shown only
+ * takes what was sent, so the next call picks these changes up.
+ */
+static void flushOLED() {
+    if (transferring) return;
+
+    int p0 = OLED_PAGES, p1 = -1, c0 = OLED_WIDTH, c1 = -1;
+    for (int p = 0; p < OLED_PAGES; p++) {
+        for (int c = 0; c < OLED_WIDTH; c++) {
+            if (frame[p][c] == shown[p][c]) continue;
+            if (p < p0) p0 = p;
+            p1 = p;
+            if (c < c0) c0 = c;
+            if (c > c1) c1 = c;
+        }
+    }
+    if (p1 < 0) return;
+
+    uint16_t n = 0;
+    for (int p = p0; p <= p1; p++) {
+        memcpy(&txBuffer[n], &frame[p][c0], c1 - c0 + 1);
+        memcpy(&shown[p][c0], &frame[p][c0], c1 - c0 + 1);
+        n += c1 - c0 + 1;
+    }
+
+    const uint8_t window[] = {SSD1306_COLUMN_ADDR, (uint8_t)c0, (uint8_t)c1,
+                              SSD1306_PAGE_ADDR, (uint8_t)p0, (uint8_t)p1};
+    spi->beginTransaction(OLED_SPI_SETTINGS);
+    digitalWrite(OLED_DC_PIN, LOW);
+    digitalWrite(OLED_CS_PIN, LOW);
+    for (uint8_t i = 0; i < sizeof(window); i++) spi->transfer(window[i]);
+    digitalWrite(OLED_DC_PIN, HIGH);
+
+#if OLED_DMA
+    if (useDma) {
+        transferring = true;        // transferDone() ends the transaction
+        spi->transfer(txBuffer, nullptr, n, transferEvent);
+        return;
+    }
+#endif
+    spi->transfer(txBuffer, n);
+    digitalWrite(OLED_CS_PIN, HIGH);
+    spi->endTransaction();
+}
+
+// Text at pixel column x of a page, clipped at the right edge
+static uint8_t drawText(uint8_t page, uint8_t x, const char* text, uint8_t len) {
+    for (uint8_t i = 0; i < len && x + 5 <= OLED_WIDTH; i++) {
+        uint8_t c = (uint8_t)text[i];
+        if (c < FONT5X7_FIRST || c > FONT5X7_DEGREE) c = '?';
+        const uint8_t* glyph = FONT5X7[c - FONT5X7_FIRST];
+        for (uint8_t col = 0; col < 5; col++) frame[page][x + col] = pgm_read_byte(glyph + col);
+        x += FONT5X7_WIDTH;
+    }
+    return x;
+}
+
+// Bar between the input's alarm limits (none if it has no usable range)
+static void drawBar(uint8_t page, const Input* input) {
+    float low = input->minValue;
+    float high = input->maxValue;
+    if (!input->flags.isEnabled || isnan(input->value) || isnan(low) || isnan(high) || isinf(low) ||
+        isinf(high) || high <= low) {
+        return;
+    }
+
+    float fraction = (input->value - low) / (high - low);
+    if (fraction < 0) fraction = 0;
+    if (fraction > 1) fraction = 1;
+    uint8_t fill = 1 + (uint8_t)(fraction * (OLED_WIDTH - 3) + 0.5f);
+
+    uint8_t* row = frame[page];
+    row[0] = row[OLED_WIDTH - 1] = 0x7E;    // Ends
+    for (uint8_t c = 1; c < OLED_WIDTH - 1; c++) {
+        row[c] = (c <= fill) ? 0x7E : 0x42; // Filled, or top and bottom edges
+    }
+}
+
+static void drawInput(const Input* input, uint8_t line) {
+    uint8_t textPage = line * 2;
+
+    // Name at the left, reading and unit at the right
+    char marker = (input->currentSeverity == SEVERITY_WARNING) ? '!' : ' ';
+    uint8_t x = drawText(textPage, 0, &marker, 1);
+    drawText(textPage, x, input->abbrName, strlen(input->abbrName));
+
+    DisplayReading reading;
+    formatDisplayReading(input, &reading);
+    char text[FLOAT_FORMAT_SIZE + 8];
+    uint8_t len = reading.length;
+    memcpy(text, reading.text, len);
+    if (reading.degrees) {
+        text[len++] = FONT5X7_DEGREE;
+    } else if (reading.symbol) {
+        uint8_t symLen = strlen_P(reading.symbol);
+        if (symLen > 7) symLen = 7;
+        memcpy_P(&text[len], reading.symbol, symLen);
+        len += symLen;
+    }
+    int right = OLED_WIDTH - (int)len * FONT5X7_WIDTH;
+    drawText(textPage, (right > 0) ? right : 0, text, len);
+
+    if (input->currentSeverity == SEVERITY_ALARM) {
+        for (uint8_t c = 0; c < OLED_WIDTH; c++) frame[textPage][c] ^= 0xFF;
+    }
+
+    drawBar(textPage + 1, input);
+}
+
+void initLCD() {
+    spi = oledBus();
+#if defined(__IMXRT1062__)
+    if (OLED_SPI_BUS != getActiveSPIId()) {
+        spi->begin();
+        registerPin(getDefaultSPIMOSI(OLED_SPI_BUS), PIN_RESERVED, "OLED SPI");
+        registerPin(getDefaultSPISCK(OLED_SPI_BUS), PIN_RESERVED, "OLED SPI");
+        useDma = true;
+        transferEvent.attach(transferDone);
+    }
+#endif
+
+    registerPin(OLED_CS_PIN, PIN_CS, "OLED CS");
+    registerPin(OLED_DC_PIN, PIN_OUTPUT, "OLED DC");
+    pinMode(OLED_CS_PIN, OUTPUT);
+    digitalWrite(OLED_CS_PIN, HIGH);
+    pinMode(OLED_DC_PIN, OUTPUT);
+    if (OLED_RST_PIN != 0xFF) {
+        registerPin(OLED_RST_PIN, PIN_OUTPUT, "OLED RST");
+        pinMode(OLED_RST_PIN, OUTPUT);
+        digitalWrite(OLED_RST_PIN, LOW);
+        delay(1);
+        digitalWrite(OLED_RST_PIN, HIGH);
+        delay(1);
+    }
+
+    sendCommands(SSD1306_INIT, sizeof(SSD1306_INIT), true);
+
+    // Panel RAM is random after reset - send a blank screen whole
+    memset(frame, 0, sizeof(frame));
+    memset(shown, 0xFF, sizeof(shown));
+    flushOLED();
+    msg.debug.info(TAG_DISPLAY, "OLED initialized");
+}
+
+void showConfigModeMessage() {
+    memset(frame, 0, sizeof(frame));
+    drawText(0, 0, "CONFIG MODE", 11);
+    drawText(2, 0, "Use serial console", 18);
+    flushOLED();
+}
+
+void updateLCD(Input** inputs, int numInputs) {
+    // If no sensors configured, show CONFIG MODE message
+    if (numInputs == 0) {
+        static bool configMsgShown = false;
+        if (!configMsgShown) {
+            showConfigModeMessage();
+            configMsgShown = true;
+        }
+        return;
+    }
+
+    memset(frame, 0, sizeof(frame));
+    for (int i = 0; i < numInputs && i < OLED_LINES; i++) {
+        drawInput(inputs[i], i);
+    }
+    flushOLED();
+}
+
+void clearLCD() {
+    memset(frame, 0, sizeof(frame));
+    flushOLED();
+}
+
+void enableLCD() {
+    const uint8_t on = SSD1306_DISPLAY_ON;
+    sendCommands(&on, 1, false);
+}
+
+void disableLCD() {
+    const uint8_t off = SSD1306_DISPLAY_OFF;
+    sendCommands(&off, 1, false);
+    clearLCD();
+}
+
+#endif // ENABLE_OLED
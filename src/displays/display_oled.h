@@ -0,0 +1,76 @@
+/*
+ * display_oled.h - SSD1306 graphic OLED over SPI
+ *
+ * A 128x64 SSD1306 OLED in place of the character LCD: build with
+ * ENABLE_OLED instead of ENABLE_LCD. It shows the same pages (lcd_layout.h),
+ * OLED_LINES inputs each - name and reading on one text line, and below it
+ * a bar graph of the reading between its alarm limits. An input in alarm is
+ * drawn inverted; one at warning is marked with '!'.
+ *
+ * Each frame is drawn into a RAM framebuffer and compared with what the
+ * panel holds, and only the bounding box of the changed bytes is sent. On
+ * Teensy 4.x with the OLED on its own SPI bus (SPI1 by default) the transfer
+ * runs by DMA: the loop starts it and carries on, and the changes of a frame
+ * drawn while one is in flight go with the next. Elsewhere, or on the
+ * sensors' SPI bus, the transfer blocks - about 1 ms for the whole screen
+ * at 8 MHz.
+ *
+ * The display hooks main.cpp, display_manager.cpp and system_mode.cpp call
+ * keep their LCD names (initLCD(), updateLCD(), enableLCD()...); with
+ * ENABLE_OLED, display_oled.cpp provides them instead of display_lcd.cpp.
+ *
+ * Build Flags:
+ *   -D ENABLE_OLED               - Use the OLED (instead of ENABLE_LCD)
+ *   -D OLED_SPI_BUS=n            - 0-2 = SPI/SPI1/SPI2, Teensy 4.x (default 1;
+ *                                  other platforms use the active SPI bus)
+ *   -D OLED_CS_PIN=n             - Chip select (default 38 on Teensy 4.x, else 10)
+ *   -D OLED_DC_PIN=n             - Data/command (default 37 on Teensy 4.x, else 9)
+ *   -D OLED_RST_PIN=n            - Reset (default 36 on Teensy 4.x, else 8; 255 = none)
+ *   -D OLED_SPI_CLOCK=n          - SPI clock in Hz (default 8000000)
+ *   -D OLED_FRAME_INTERVAL_MS=n  - Refresh interval (default 40, 25 fps)
+ */
+
+#ifndef DISPLAY_OLED_H
+#define DISPLAY_OLED_H
+
+#include <Arduino.h>
+
+#define OLED_WIDTH 128
+#define OLED_PAGES 8                        // 8-pixel rows of the SSD1306
+#define OLED_LINES (OLED_PAGES / 2)         // Inputs per page: text and bar graph
+
+#ifndef OLED_SPI_BUS
+#define OLED_SPI_BUS 1
+#endif
+
+#if defined(__IMXRT1062__)
+#define OLED_DEFAULT_CS 38
+#define OLED_DEFAULT_DC 37
+#define OLED_DEFAULT_RST 36
+#else
+#define OLED_DEFAULT_CS 10
+#define OLED_DEFAULT_DC 9
+#define OLED_DEFAULT_RST 8
+#endif
+
+#ifndef OLED_CS_PIN
+#define OLED_CS_PIN OLED_DEFAULT_CS
+#endif
+
+#ifndef OLED_DC_PIN
+#define OLED_DC_PIN OLED_DEFAULT_DC
+#endif
+
+#ifndef OLED_RST_PIN
+#define OLED_RST_PIN OLED_DEFAULT_RST
+#endif
+
+#ifndef OLED_SPI_CLOCK
+#define OLED_SPI_CLOCK 8000000
+#endif
+
+#ifndef OLED_FRAME_INTERVAL_MS
+#define OLED_FRAME_INTERVAL_MS 40
+#endif
+
+#endif // DISPLAY_OLED_H
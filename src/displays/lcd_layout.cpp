@@ -0,0 +1,138 @@
+/*
+ * lcd_layout.cpp - Pages of inputs on the LCD
+ *
+ * visible[] holds the inputs that may be shown, in slot order, rebuilt on a
+ * new input layout version or mode. A page is DISPLAY_LINES lines: the pinned
+ * inputs, then the next perPage unpinned visible inputs.
+ */
+
+#include "lcd_layout.h"
+#include "../config.h"
+#include "../inputs/input_manager.h"
+#include "../inputs/alarm_logic.h"
+#include "../lib/system_mode.h"
+#ifndef USE_STATIC_CONFIG
+#include "../lib/system_config.h"
+#endif
+
+#if defined(ENABLE_LCD) || defined(ENABLE_OLED)
+
+extern void updateLCD(Input** inputs, int numInputs);
+
+static Input* visible[MAX_INPUTS];
+static uint8_t numVisible;
+static uint8_t builtVersion;
+static bool builtForRun;
+static bool built = false;
+
+static uint8_t page;
+static uint8_t numPages = 1;
+static uint32_t pageShownAt;
+
+static uint8_t pageSeconds() {
+#ifdef USE_STATIC_CONFIG
+    return LCD_PAGE_SECONDS;
+#else
+    return systemConfig.lcdPageSeconds;
+#endif
+}
+
+static bool pinAlarms() {
+#ifdef USE_STATIC_CONFIG
+    return LCD_PIN_ALARMS;
+#else
+    return systemConfig.lcdPinAlarms;
+#endif
+}
+
+// Alarmed inputs that are also visible (one just disabled may still be listed)
+static bool pinnable(const Input* input) {
+    return input->flags.isEnabled && input->flags.display;
+}
+
+static void collectVisible(bool run) {
+    numVisible = 0;
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        Input* input = &inputs[i];
+        bool candidate = run ? input->flags.isEnabled : (input->pin != 0xFF);
+        if (candidate && input->flags.display) visible[numVisible++] = input;
+    }
+    builtVersion = getInputLayoutVersion();
+    builtForRun = run;
+    built = true;
+}
+
+void updateLCDLayout(uint32_t now) {
+    bool run = isInRunMode();
+    if (!built || builtForRun != run || builtVersion != getInputLayoutVersion()) {
+        collectVisible(run);
+    }
+
+    static Input* lines[DISPLAY_LINES];
+    uint8_t n = 0;
+
+    // Pinned: visible inputs away from NORMAL, alarms first (RUN mode only -
+    // alarms aren't evaluated in CONFIG)
+    bool pinning = run && pinAlarms();
+    uint8_t numPinnable = 0;
+    if (pinning) {
+        uint8_t numAlarmed = getAlarmedCount();
+        for (uint8_t k = 0; k < numAlarmed; k++) {
+            Input* input = getAlarmedInput(k);
+            if (!pinnable(input)) continue;
+            numPinnable++;
+            if (input->currentSeverity == SEVERITY_ALARM && n < DISPLAY_LINES) lines[n++] = input;
+        }
+        for (uint8_t k = 0; k < numAlarmed && n < DISPLAY_LINES; k++) {
+            Input* input = getAlarmedInput(k);
+            if (pinnable(input) && input->currentSeverity == SEVERITY_WARNING) lines[n++] = input;
+        }
+    }
+
+    // Pages of the rest
+    uint8_t perPage = DISPLAY_LINES - n;
+    uint8_t unpinned = numVisible - numPinnable;
+    numPages = (perPage == 0 || unpinned == 0) ? 1 : (unpinned + perPage - 1) / perPage;
+
+    uint8_t seconds = pageSeconds();
+    if (seconds > 0 && numPages > 1 && now - pageShownAt >= seconds * 1000UL) {
+        page++;
+        pageShownAt = now;
+    }
+    if (page >= numPages) page = 0;
+
+    uint8_t skip = page * perPage;
+    for (uint8_t i = 0; i < numVisible && n < DISPLAY_LINES; i++) {
+        Input* input = visible[i];
+        if (pinning && input->currentSeverity != SEVERITY_NORMAL) continue;  // Already pinned
+        if (skip > 0) {
+            skip--;
+            continue;
+        }
+        lines[n++] = input;
+    }
+
+    updateLCD(lines, n);
+}
+
+void showLCDPage(uint8_t n) {
+    page = n;                   // Wrapped at the next update if past the last
+    pageShownAt = millis();
+}
+
+uint8_t getLCDPage() {
+    return page;
+}
+
+uint8_t getLCDPageCount() {
+    return numPages;
+}
+
+#else
+
+void updateLCDLayout(uint32_t now) {}
+void showLCDPage(uint8_t n) {}
+uint8_t getLCDPage() { return 0; }
+uint8_t getLCDPageCount() { return 1; }
+
+#endif
@@ -0,0 +1,65 @@
+/*
+ * lcd_layout.h - Pages of inputs on the LCD
+ *
+ * The LCD shows LCD_LINES inputs (two columns of LCD_ROWS). More visible
+ * inputs than that are split into pages, shown in turn every
+ * DISPLAY ROTATE seconds or picked with DISPLAY PAGE. In RUN mode, inputs
+ * at WARNING or ALARM are pinned to the top of every page - alarms first -
+ * so one never rotates out of sight; the other lines page through the rest.
+ *
+ * Visible inputs are the enabled ones with display on (in CONFIG mode, every
+ * configured one). The list is collected again only when the input
+ * configuration changes (getInputLayoutVersion()), and the pinned inputs
+ * come from the alarm logic's list of inputs away from NORMAL - an update
+ * walks neither all MAX_INPUTS slots nor every input for its severity.
+ *
+ * The OLED (display_oled.h) shows the same pages, OLED_LINES inputs each.
+ *
+ * Usage:
+ *   updateLCDLayout(now);           // Each display refresh - renders the page
+ *   showLCDPage(getLCDPage() + 1);  // DISPLAY PAGE NEXT
+ *
+ * Build Flags:
+ *   -D LCD_PAGE_SECONDS=n  - Default page rotation (default 5; 0 = manual)
+ *   -D LCD_PIN_ALARMS=0    - Default: don't pin inputs in alarm
+ */
+
+#ifndef LCD_LAYOUT_H
+#define LCD_LAYOUT_H
+
+#include <Arduino.h>
+
+// LCD geometry
+#define LCD_COLS 20
+#define LCD_ROWS 4
+#define LCD_COLUMNS_PER_SENSOR (LCD_COLS / 2)  // Split display into 2 columns
+#define LCD_LINES (LCD_ROWS * 2)              // Inputs per page
+
+#ifdef ENABLE_OLED
+#include "display_oled.h"
+#define DISPLAY_LINES OLED_LINES
+#define DISPLAY_REFRESH_MS OLED_FRAME_INTERVAL_MS
+#else
+#define DISPLAY_LINES LCD_LINES
+#define DISPLAY_REFRESH_MS LCD_UPDATE_INTERVAL_MS   // config.h
+#endif
+
+#ifndef LCD_PAGE_SECONDS
+#define LCD_PAGE_SECONDS 5
+#endif
+
+#ifndef LCD_PIN_ALARMS
+#define LCD_PIN_ALARMS 1
+#endif
+
+// Lay out the current page (rotating it when due) and render it
+void updateLCDLayout(uint32_t now);
+
+// Show page n (0-based; past the last page wraps to the first)
+void showLCDPage(uint8_t n);
+
+// Page shown / pages, as of the last update
+uint8_t getLCDPage();
+uint8_t getLCDPageCount();
+
+#endif // LCD_LAYOUT_H
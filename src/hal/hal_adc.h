@@ -0,0 +1,111 @@
+/*
+ * hal_adc.h - Hardware Abstraction Layer for background ADC conversions
+ * Part of the preOBD Hardware Abstraction Layer
+ *
+ * Lets the ADC scanner (lib/adc_scan.h) start a conversion and collect the
+ * result on a later loop pass instead of spinning inside analogRead():
+ *
+ *   AVR        - ADC registers directly (same reference as setupADC: DEFAULT)
+ *   Teensy 3.x - ADC library (bundled with Teensyduino), second ADC module
+ *   Teensy 4.x - ADC library, ADC2 (ADC1 stays with the core's analogRead)
+ *   Others     - not supported: adcStart() returns false and the scanner
+ *                falls back to analogRead()
+ *
+ * Only one conversion is in flight at a time. On AVR the scanner and
+ * analogRead() share the single ADC, so callers must let a pending conversion
+ * finish (adcDone()) before calling analogRead().
+ *
+ * Usage:
+ *   #include "hal/hal_adc.h"
+ *   hal::adcInit();
+ *   if (hal::adcStart(pin)) {
+ *       ...
+ *       if (hal::adcDone()) reading = hal::adcResult();
+ *   }
+ */
+
+#ifndef HAL_ADC_H
+#define HAL_ADC_H
+
+#include <Arduino.h>
+#include "../lib/platform.h"  // ADC_RESOLUTION
+
+#if defined(__MK20DX256__) || defined(__MK64FX512__) || \
+    defined(__MK66FX1M0__) || defined(__IMXRT1062__)
+    #include <ADC.h>
+    #define HAL_ADC_TEENSY 1
+#elif defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__) || \
+      defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+    #define HAL_ADC_AVR 1
+#endif
+
+namespace hal {
+
+#if defined(HAL_ADC_TEENSY)
+// Constructed on first use so it is set up after setupADC()
+inline ADC* adcInstance() {
+    static ADC adc;
+    return &adc;
+}
+#endif
+
+// Prepare the background ADC (call once, after setupADC())
+inline void adcInit() {
+#if defined(HAL_ADC_TEENSY)
+    ADC* adc = adcInstance();
+    // Library constructor resets both modules - restore the analogRead() settings
+    adc->adc0->setResolution(ADC_RESOLUTION);
+    adc->adc0->setAveraging(4);
+    // Background module: single samples, oversampling is done in software
+    adc->adc1->setResolution(ADC_RESOLUTION);
+    adc->adc1->setAveraging(1);
+#endif
+}
+
+// Start a conversion on pin; false if pin can't be converted in the background
+inline bool adcStart(uint8_t pin) {
+#if defined(HAL_ADC_TEENSY)
+    return adcInstance()->adc1->startSingleRead(pin);
+#elif defined(HAL_ADC_AVR)
+  #if defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+    if (pin >= 54) pin -= 54;  // A0 = 54
+    ADCSRB = (ADCSRB & ~(1 << MUX5)) | (((pin >> 3) & 0x01) << MUX5);
+  #else
+    if (pin >= 14) pin -= 14;  // A0 = 14
+  #endif
+    ADMUX = (DEFAULT << 6) | (pin & 0x07);
+    ADCSRA |= (1 << ADSC);
+    return true;
+#else
+    (void)pin;
+    return false;
+#endif
+}
+
+// True once the conversion started by adcStart() has finished
+inline bool adcDone() {
+#if defined(HAL_ADC_TEENSY)
+    return adcInstance()->adc1->isComplete();
+#elif defined(HAL_ADC_AVR)
+    return (ADCSRA & (1 << ADSC)) == 0;
+#else
+    return true;
+#endif
+}
+
+// Result of the finished conversion (0-ADC_MAX_VALUE)
+inline int adcResult() {
+#if defined(HAL_ADC_TEENSY)
+    return adcInstance()->adc1->readSingle();
+#elif defined(HAL_ADC_AVR)
+    uint8_t low = ADCL;   // ADCL must be read first - it latches ADCH
+    uint8_t high = ADCH;
+    return (high << 8) | low;
+#else
+    return 0;
+#endif
+}
+
+} // namespace hal
+
+#endif // HAL_ADC_H
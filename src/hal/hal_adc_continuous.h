@@ -0,0 +1,46 @@
+/*
+ * hal_adc_continuous.h - Hardware Abstraction Layer for continuous ADC scanning
+ * Part of the preOBD Hardware Abstraction Layer
+ *
+ * Opt-in backend (-D ENABLE_ADC_CONTINUOUS) that converts a fixed list of
+ * analog pins autonomously in hardware, so the ADC scanner (lib/adc_scan.h)
+ * only has to copy out finished, already-averaged results:
+ *
+ *   Teensy 4.x - ADC_ETC trigger chains on ADC2 with hardware averaging
+ *                (ADC1 stays with the core's analogRead)
+ *   ESP32      - Arduino-ESP32 3.x continuous ADC driver (DMA ring buffer)
+ *   Others     - not available: adcContinuousBegin() returns false and the
+ *                scanner keeps driving single conversions
+ *
+ * Usage:
+ *   #include "hal/hal_adc_continuous.h"
+ *   if (hal::adcContinuousBegin(pins, count, 4)) {   // 4 samples averaged per result
+ *       ...
+ *       if (hal::adcContinuousRead(counts)) { ... counts[i] for pins[i] ... }
+ *   }
+ *   hal::adcContinuousEnd();  // Before changing the pin list
+ *
+ * HAL_ADC_CONTINUOUS_EXCLUSIVE is 1 where analogRead() can't be used while
+ * the scan is running (End it first).
+ */
+
+#ifndef HAL_ADC_CONTINUOUS_H
+#define HAL_ADC_CONTINUOUS_H
+
+#include <stdint.h>
+
+#if defined(ENABLE_ADC_CONTINUOUS) && defined(__IMXRT1062__)
+    // Teensy 4.x (IMXRT1062)
+    #include "platforms/adc_continuous_teensy4.h"
+
+#elif defined(ENABLE_ADC_CONTINUOUS) && defined(ESP32)
+    // ESP32 variants (requires Arduino-ESP32 3.x, stub otherwise)
+    #include "platforms/adc_continuous_esp32.h"
+
+#else
+    // Not enabled or no backend for this platform
+    #include "platforms/adc_continuous_stub.h"
+
+#endif
+
+#endif // HAL_ADC_CONTINUOUS_H
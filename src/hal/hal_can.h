@@ -6,6 +6,7 @@
  * - Teensy 3.x/4.x: Native FlexCAN (supports multiple buses: CAN1, CAN2, CAN3)
  * - ESP32: Native TWAI (CAN) - single bus only
  * - AVR (Uno, Mega): MCP2515 via SPI - single bus only
+ * - Host simulator (env:native): SocketCAN interfaces, e.g. vcan0
  *
  * Usage:
  *   #include "hal/hal_can.h"
@@ -13,6 +14,11 @@
  *   hal::can::begin(500000, 1);        // Initialize bus 1 (Teensy only)
  *   hal::can::write(0x7E8, data, 8, false);       // Write to default bus
  *   hal::can::read(id, data, len, ext, 1);        // Read from bus 1
+ *   hal::can::readFrame(frame, 1);                // Read with receive time (hal_can_frame.h)
+ *   hal::can::setFilterRules(rules, n, 1);        // Acceptance filters (hal_can_filter.h)
+ *   hal::can::getRxOverflows(1);                  // Frames lost to receive overruns
+ *   pin = hal::can::sleep(1);                     // Wake-on-activity mode - pin to wake on (LOW)
+ *   if (hal::can::activity(1)) hal::can::wake(1); // Bus woke up - back to normal operation
  *
  * Note: CAN is only available when ENABLE_CAN is defined
  */
@@ -21,10 +27,17 @@
 #define HAL_CAN_H
 
 #include <stdint.h>
+#include <string.h>
 #include "../config.h"
+#include "hal_can_filter.h"
+#include "hal_can_frame.h"
 
 #ifdef ENABLE_CAN
 
+#if defined(ENABLE_CAN_FD) && !defined(USE_FLEXCAN_NATIVE)
+    #error "ENABLE_CAN_FD needs native FlexCAN (USE_FLEXCAN_NATIVE on Teensy 4.x)"
+#endif
+
 // Platform detection and include appropriate implementation
 #if defined(ENABLE_CAN_HYBRID)
     // Hybrid mode: Multiple controller types on different buses
@@ -39,6 +52,10 @@
     // ESP32 with native TWAI
     #include "platforms/can_twai.h"
 
+#elif defined(PREOBD_NATIVE)
+    // Host simulator: SocketCAN
+    #include "platforms/can_socketcan.h"
+
 #else
     // All other platforms: MCP2515 via SPI
     #include "platforms/can_mcp2515.h"
@@ -60,17 +77,61 @@ inline bool write(uint32_t id, const uint8_t* data, uint8_t len, bool extended,
     return false;
 }
 
-inline bool read(uint32_t& id, uint8_t* data, uint8_t& len, bool& extended, uint8_t bus = 0) {
-    (void)id; (void)data; (void)len; (void)extended; (void)bus;
+inline bool readFrame(CanRxFrame& frame, uint8_t bus = 0) {
+    (void)frame; (void)bus;
     return false;
 }
 
-inline void setFilters(uint32_t filter1, uint32_t filter2, uint8_t bus = 0) {
-    (void)filter1; (void)filter2; (void)bus;
+inline uint32_t getRxOverflows(uint8_t bus = 0) {
+    (void)bus;
+    return 0;
+}
+
+inline bool setFilterRules(const CanFilterRule* rules, uint8_t count, uint8_t bus = 0) {
+    (void)rules; (void)count; (void)bus;
+    return false;
+}
+
+inline uint8_t sleep(uint8_t bus = 0) {
+    (void)bus;
+    return HAL_CAN_NO_WAKE_PIN;
+}
+
+inline bool activity(uint8_t bus = 0) {
+    (void)bus;
+    return false;
+}
+
+inline void wake(uint8_t bus = 0) {
+    (void)bus;
 }
 
 }} // namespace hal::can
 
 #endif // ENABLE_CAN
 
+namespace hal { namespace can {
+
+// Read without the receive time (shorthand for readFrame)
+inline bool read(uint32_t& id, uint8_t* data, uint8_t& len, bool& extended, uint8_t bus = 0) {
+    CanRxFrame frame;
+    if (!readFrame(frame, bus)) return false;
+    id = frame.id;
+    len = frame.len;
+    extended = frame.extended;
+    memcpy(data, frame.data, frame.len);
+    return true;
+}
+
+// Accept only two exact standard IDs (shorthand for setFilterRules)
+inline void setFilters(uint32_t filter1, uint32_t filter2, uint8_t bus = 0) {
+    const CanFilterRule rules[2] = {
+        { filter1, HAL_CAN_STD_MASK, false },
+        { filter2, HAL_CAN_STD_MASK, false },
+    };
+    setFilterRules(rules, 2, bus);
+}
+
+}} // namespace hal::can
+
 #endif // HAL_CAN_H
@@ -0,0 +1,128 @@
+/*
+ * hal_can_filter.h - CAN acceptance filter rules
+ * Part of the preOBD Hardware Abstraction Layer
+ *
+ * Callers describe the frames they want as a list of (id, mask, extended)
+ * rules - a frame matches a rule when (frame_id & mask) == (id & mask) and
+ * its format (standard/extended) is the rule's. Each CAN backend compiles
+ * the list onto its controller's acceptance filters:
+ *
+ *   MCP2515  - 2 masks, 6 filters (RXB0: mask 0 + 2 filters, RXB1: mask 1 + 4)
+ *   TWAI     - single filter mode (1 rule) or dual filter mode (2 rules)
+ *   FlexCAN  - one RX FIFO filter element per rule (8; RX mailboxes when polled)
+ *
+ * When there are more rules than the controller has filters, rules are merged
+ * pairwise (keeping only the ID bits both agree on) until they fit. The
+ * hardware then accepts a superset of the rules, and setFilterRules() returns
+ * false so the caller knows to keep its software filter - it never drops a
+ * frame a rule asked for.
+ *
+ * An empty rule list accepts every frame.
+ *
+ * Usage:
+ *   hal::can::CanFilterRule rules[] = {
+ *       { 0x7E8, HAL_CAN_STD_MASK, false },   // ECU response
+ *       { 0x18DAF100, 0x1FFFFF00, true },     // J1939-style range
+ *   };
+ *   bool exact = hal::can::setFilterRules(rules, 2, bus);
+ */
+
+#ifndef HAL_CAN_FILTER_H
+#define HAL_CAN_FILTER_H
+
+#include <stdint.h>
+
+#define HAL_CAN_STD_MASK 0x7FFUL        // Exact match, 11-bit ID
+#define HAL_CAN_EXT_MASK 0x1FFFFFFFUL   // Exact match, 29-bit ID
+
+// Rules a backend accepts in one call; longer lists fall back to accept-all
+#ifndef HAL_CAN_MAX_FILTER_RULES
+#define HAL_CAN_MAX_FILTER_RULES 32
+#endif
+
+namespace hal { namespace can {
+
+struct CanFilterRule {
+    uint32_t id;        // ID bits to match
+    uint32_t mask;      // 1 = bit must match, 0 = don't care
+    bool extended;      // Match 29-bit (true) or 11-bit (false) frames
+};
+
+namespace filter {
+
+    inline uint32_t fullMask(bool extended) {
+        return extended ? HAL_CAN_EXT_MASK : HAL_CAN_STD_MASK;
+    }
+
+    inline uint8_t maskBits(uint32_t mask) {
+        uint8_t bits = 0;
+        for (; mask; mask &= mask - 1) bits++;
+        return bits;
+    }
+
+    // Copy rules into work, clamping masks to the ID width and masking IDs
+    // Returns false if there are more than HAL_CAN_MAX_FILTER_RULES
+    inline bool normalize(const CanFilterRule* rules, uint8_t count, CanFilterRule* work) {
+        if (count > HAL_CAN_MAX_FILTER_RULES) return false;
+        for (uint8_t i = 0; i < count; i++) {
+            work[i].extended = rules[i].extended;
+            work[i].mask = rules[i].mask & fullMask(rules[i].extended);
+            work[i].id = rules[i].id & work[i].mask;
+        }
+        return true;
+    }
+
+    /**
+     * Merge rules of the same frame format until at most maxRules remain
+     * Each step merges the pair that loses the fewest mask bits, so exact
+     * IDs that differ in one bit become a single rule with that bit opened.
+     *
+     * @param rules     Normalized rules, merged in place
+     * @param count     Number of rules
+     * @param maxRules  Filters available
+     * @param exact     Cleared if a merge widened what is accepted
+     * @return          New rule count, or 0 if standard and extended rules
+     *                  can't share the available filters (accept all)
+     */
+    inline uint8_t merge(CanFilterRule* rules, uint8_t count, uint8_t maxRules, bool* exact) {
+        while (count > maxRules) {
+            uint8_t bestA = 0, bestB = 0;
+            int8_t bestBits = -1;
+            uint32_t bestMask = 0;
+
+            for (uint8_t a = 0; a < count; a++) {
+                for (uint8_t b = a + 1; b < count; b++) {
+                    if (rules[a].extended != rules[b].extended) continue;
+                    uint32_t mask = rules[a].mask & rules[b].mask & ~(rules[a].id ^ rules[b].id);
+                    int8_t bits = maskBits(mask);
+                    if (bits > bestBits) {
+                        bestBits = bits;
+                        bestA = a;
+                        bestB = b;
+                        bestMask = mask;
+                    }
+                }
+            }
+            if (bestBits < 0) {
+                *exact = false;
+                return 0;  // One rule of each format left over - nothing to merge
+            }
+
+            // Exact only if one rule already covered the other
+            CanFilterRule& a = rules[bestA];
+            const CanFilterRule& b = rules[bestB];
+            if (bestMask != a.mask && bestMask != b.mask) *exact = false;
+            a.mask = bestMask;
+            a.id &= bestMask;
+
+            rules[bestB] = rules[count - 1];
+            count--;
+        }
+        return count;
+    }
+
+} // namespace filter
+
+}} // namespace hal::can
+
+#endif // HAL_CAN_FILTER_H
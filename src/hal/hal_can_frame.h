@@ -0,0 +1,108 @@
+/*
+ * hal_can_frame.h - Received CAN frames and the per-bus receive ring
+ * Part of the preOBD Hardware Abstraction Layer
+ *
+ * Backends that receive from an interrupt (MCP2515 INT pin, FlexCAN RX FIFO)
+ * copy each frame into a CanRxRing from the ISR and stamp it with millis()
+ * and hal::micros64() there, so a frame's age is measured from when it came
+ * off the wire rather than from whenever the main loop got round to reading
+ * it. Polled backends stamp at read time.
+ *
+ * The ring is single-producer (ISR) / single-consumer (main loop): the ISR
+ * only writes head, the reader only writes tail, and each index is published
+ * after the slot it covers is complete, so neither side needs to mask
+ * interrupts.
+ *
+ * With -D ENABLE_CAN_FD (Teensy 4.x CAN3) frames carry up to 64 data bytes;
+ * otherwise the payload is classic CAN's 8 bytes, so single-bus AVR builds
+ * don't pay for FD-sized rings.
+ *
+ * Usage (inside a backend):
+ *   CanRxFrame* slot = ring.claim();         // ISR - nullptr when full
+ *   if (slot) { fill(slot); ring.publish(); } else ring.overflows++;
+ *
+ *   CanRxFrame frame;
+ *   while (ring.pop(frame)) handle(frame);   // Main loop
+ */
+
+#ifndef HAL_CAN_FRAME_H
+#define HAL_CAN_FRAME_H
+
+#include <stdint.h>
+#include "hal_timebase.h"
+
+#ifdef ENABLE_CAN_FD
+  #define HAL_CAN_MAX_DLEN 64
+#else
+  #define HAL_CAN_MAX_DLEN 8
+#endif
+
+// hal::can::sleep() result for a bus with no pin to wake on (its RX interrupt
+// wakes the CPU, or it isn't running)
+#define HAL_CAN_NO_WAKE_PIN 0xFF
+
+namespace hal { namespace can {
+
+struct CanRxFrame {
+    uint64_t rxUs;      // hal::micros64() when the frame was received
+    uint32_t id;
+    uint32_t rxMs;      // millis() at the same moment (timeouts)
+    uint8_t len;        // 0-8, or up to 64 for CAN FD frames
+    bool extended;
+    bool fd;            // Received as a CAN FD frame
+    uint8_t data[HAL_CAN_MAX_DLEN];
+};
+
+// Smallest CAN FD payload size (8, 12, 16, 20, 24, 32, 48, 64) holding len bytes
+inline uint8_t fdPayloadLength(uint8_t len) {
+    if (len <= 8) return len;
+    if (len <= 24) return (len + 3) & ~3;
+    if (len <= 32) return 32;
+    if (len <= 48) return 48;
+    return 64;
+}
+
+// SIZE must be a power of 2, at most 128 (one slot is always kept free)
+template<uint8_t SIZE>
+struct CanRxRing {
+    CanRxFrame frames[SIZE];
+    volatile uint8_t head;
+    volatile uint8_t tail;
+    volatile uint16_t overflows;   // Frames dropped, ring full
+    bool active;                   // ISR attached - reads come from here
+
+    void reset() {
+        head = 0;
+        tail = 0;
+    }
+
+    // Producer: next free slot, or nullptr if the ring is full
+    CanRxFrame* claim() {
+        uint8_t h = head;
+        if (((h + 1) & (SIZE - 1)) == tail) return nullptr;
+        return &frames[h];
+    }
+
+    // Producer: make the claimed slot visible to the reader
+    void publish() {
+        head = (head + 1) & (SIZE - 1);
+    }
+
+    // Consumer: nothing waiting
+    bool empty() const {
+        return head == tail;
+    }
+
+    // Consumer: copy out the oldest frame
+    bool pop(CanRxFrame& frame) {
+        uint8_t t = tail;
+        if (t == head) return false;
+        frame = frames[t];
+        tail = (t + 1) & (SIZE - 1);  // Release the slot after copying
+        return true;
+    }
+};
+
+}} // namespace hal::can
+
+#endif // HAL_CAN_FRAME_H
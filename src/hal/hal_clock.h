@@ -0,0 +1,110 @@
+/*
+ * hal_clock.h - Hardware Abstraction Layer for wall-clock time
+ * Part of the preOBD Hardware Abstraction Layer
+ *
+ * Unix time for naming and stamping logs, when the board knows it:
+ *
+ *   Teensy 3.x/4.x - battery-backed RTC (Teensy3Clock, set by the
+ *                    Teensyduino loader at upload time)
+ *   ESP32          - time() once something (SNTP, setWallClock) has set it
+ *   Others         - only after setWallClock()
+ *
+ * setWallClock() takes time from an external source (a GPS fix, a host over
+ * serial) and also sets the RTC where there is one. Anything before
+ * HAL_CLOCK_VALID_AFTER counts as "not set" - an RTC that lost its battery
+ * restarts near 1970.
+ *
+ * Usage:
+ *   #include "hal/hal_clock.h"
+ *   uint32_t now = hal::wallClock();   // 0 = unknown
+ */
+
+#ifndef HAL_CLOCK_H
+#define HAL_CLOCK_H
+
+#include <Arduino.h>
+
+#if defined(__IMXRT1062__) || defined(__MK20DX256__) || \
+    defined(__MK64FX512__) || defined(__MK66FX1M0__)
+    #define HAL_CLOCK_TEENSY_RTC 1
+#elif defined(ESP32)
+    #include <time.h>
+    #include <sys/time.h>
+#endif
+
+#define HAL_CLOCK_VALID_AFTER 1704067200UL   // 2024-01-01 00:00:00 UTC
+
+namespace hal {
+
+// setWallClock() reference: unix time at millis() == wallClockSetMs() (0 = never set)
+inline uint32_t& wallClockSetSeconds() { static uint32_t seconds = 0; return seconds; }
+inline uint32_t& wallClockSetMs() { static uint32_t ms = 0; return ms; }
+
+// Seconds since 1970-01-01 UTC, or 0 if the time is not known
+inline uint32_t wallClock() {
+#if defined(HAL_CLOCK_TEENSY_RTC)
+    uint32_t rtc = Teensy3Clock.get();
+    if (rtc >= HAL_CLOCK_VALID_AFTER) return rtc;
+#elif defined(ESP32)
+    time_t t = time(nullptr);
+    if ((uint32_t)t >= HAL_CLOCK_VALID_AFTER) return (uint32_t)t;
+#endif
+    if (wallClockSetSeconds() == 0) return 0;
+    return wallClockSetSeconds() + (millis() - wallClockSetMs()) / 1000;
+}
+
+// Time from an external source (GPS, host); sets the RTC where there is one
+inline void setWallClock(uint32_t seconds) {
+    if (seconds < HAL_CLOCK_VALID_AFTER) return;
+    wallClockSetSeconds() = seconds;
+    wallClockSetMs() = millis();
+#if defined(HAL_CLOCK_TEENSY_RTC)
+    Teensy3Clock.set(seconds);
+#elif defined(ESP32)
+    struct timeval tv = { (time_t)seconds, 0 };
+    settimeofday(&tv, nullptr);
+#endif
+}
+
+/**
+ * Unix time of a UTC calendar date and time (year 1970-2105)
+ */
+inline uint32_t makeWallClock(uint16_t year, uint8_t month, uint8_t day,
+                              uint8_t hour, uint8_t minute, uint8_t second) {
+    // Days since 1970 from the civil date (inverse of formatWallClock())
+    uint32_t y = year - (month <= 2 ? 1 : 0);
+    uint32_t era = y / 400;
+    uint32_t yoe = y - era * 400;
+    uint32_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    uint32_t days = era * 146097 + doe - 719468;
+    return days * 86400 + hour * 3600UL + minute * 60UL + second;
+}
+
+/**
+ * Format unix time as YYYYMMDD_HHMMSS (UTC) - sorts as text
+ * @param out  At least 16 bytes
+ */
+inline void formatWallClock(uint32_t seconds, char* out) {
+    uint32_t days = seconds / 86400;
+    uint32_t secs = seconds % 86400;
+
+    // Civil date from days since 1970 (Howard Hinnant's algorithm)
+    uint32_t z = days + 719468;
+    uint32_t era = z / 146097;
+    uint32_t doe = z - era * 146097;
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp = (5 * doy + 2) / 153;
+    uint32_t day = doy - (153 * mp + 2) / 5 + 1;
+    uint32_t month = mp < 10 ? mp + 3 : mp - 9;
+    uint32_t year = yoe + era * 400 + (month <= 2 ? 1 : 0);
+
+    // Arguments narrowed to their digit counts so the 16 bytes provably fit
+    snprintf(out, 16, "%04u%02u%02u_%02u%02u%02u", (unsigned)(year % 10000), (unsigned)(month % 100),
+             (unsigned)(day % 100), (unsigned)(secs / 3600 % 100), (unsigned)(secs / 60 % 60), (unsigned)(secs % 60));
+}
+
+} // namespace hal
+
+#endif // HAL_CLOCK_H
@@ -0,0 +1,108 @@
+/*
+ * hal_cycles.h - Hardware Abstraction Layer for the cycle counter
+ * Part of the preOBD Hardware Abstraction Layer
+ *
+ * A free-running counter for timing short stretches of code, finer than
+ * micros():
+ *
+ *   Teensy 3.x/4.x, Due - DWT CYCCNT, core clock cycles
+ *   ESP32                - CCOUNT (ESP.getCycleCount()), core clock cycles
+ *   AVR                  - micros() (4us steps at 16 MHz) - no cycle counter
+ *   Host simulator       - host monotonic clock in ns (the simulated clock
+ *                          moves only when the firmware spends time)
+ *
+ * The count wraps at 32 bits (7 s at 600 MHz); differences of two reads
+ * are right across one wrap. HAL_CYCLES_ARE_CORE_CYCLES tells whether a
+ * tick is one CPU cycle or only cycleHz() apart.
+ *
+ * Usage:
+ *   #include "hal/hal_cycles.h"
+ *   hal::cycleCounterBegin();
+ *   uint32_t t0 = hal::cycleCount();
+ *   ...
+ *   uint32_t ticks = hal::cycleCount() - t0;   // ticks / hal::cycleHz() seconds
+ */
+
+#ifndef HAL_CYCLES_H
+#define HAL_CYCLES_H
+
+#include <Arduino.h>
+
+#if defined(__IMXRT1062__) || defined(__MK20DX256__) || defined(__MK20DX128__) || \
+    defined(__MK64FX512__) || defined(__MK66FX1M0__)
+    #define HAL_CYCLES_TEENSY_DWT 1
+    #define HAL_CYCLES_ARE_CORE_CYCLES 1
+#elif defined(ARDUINO_SAM_DUE)
+    #define HAL_CYCLES_ARE_CORE_CYCLES 1
+#elif defined(ESP32)
+    #include <Esp.h>
+    #include <esp32-hal-cpu.h>
+    #define HAL_CYCLES_ARE_CORE_CYCLES 1
+#elif defined(PREOBD_NATIVE)
+    #include <time.h>
+    #define HAL_CYCLES_ARE_CORE_CYCLES 0
+#else
+    #define HAL_CYCLES_ARE_CORE_CYCLES 0
+#endif
+
+namespace hal {
+
+// Start the counter where it isn't running from reset (idempotent)
+inline void cycleCounterBegin() {
+#if defined(HAL_CYCLES_TEENSY_DWT)
+    // Teensy 4 startup code enables it already; Teensy 3.x doesn't
+    ARM_DEMCR |= ARM_DEMCR_TRCENA;
+    ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+#elif defined(ARDUINO_SAM_DUE)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+inline uint32_t cycleCount() {
+#if defined(HAL_CYCLES_TEENSY_DWT)
+    return ARM_DWT_CYCCNT;
+#elif defined(ARDUINO_SAM_DUE)
+    return DWT->CYCCNT;
+#elif defined(ESP32)
+    return ESP.getCycleCount();
+#elif defined(PREOBD_NATIVE)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+#else
+    return micros();
+#endif
+}
+
+// Counter ticks per second
+inline uint32_t cycleHz() {
+#if defined(__IMXRT1062__)
+    return F_CPU_ACTUAL;        // Follows set_arm_clock()
+#elif defined(HAL_CYCLES_TEENSY_DWT)
+    return F_CPU;
+#elif defined(ARDUINO_SAM_DUE)
+    return SystemCoreClock;
+#elif defined(ESP32)
+    return getCpuFrequencyMhz() * 1000000UL;
+#elif defined(PREOBD_NATIVE)
+    return 1000000000UL;
+#else
+    return 1000000UL;
+#endif
+}
+
+// Core clock in Hz, for converting ticks to cycles where they aren't cycles
+inline uint32_t cpuHz() {
+#if HAL_CYCLES_ARE_CORE_CYCLES
+    return cycleHz();
+#elif defined(F_CPU)
+    return F_CPU;
+#else
+    return 0;                   // Unknown (host)
+#endif
+}
+
+} // namespace hal
+
+#endif // HAL_CYCLES_H
@@ -0,0 +1,38 @@
+/*
+ * hal_freq_counter.h - Hardware Abstraction Layer for hardware pulse counters
+ * Part of the preOBD Hardware Abstraction Layer
+ *
+ * Opt-in backend (-D ENABLE_FREQ_COUNTER_HW) that counts pulse edges in a
+ * hardware counter instead of taking one interrupt per edge, so the pulse
+ * capture (lib/freq_capture.h) only samples a count when an input is read:
+ *
+ *   ESP32   - PCNT units (rising edges, glitch filter up to ~12us)
+ *   Others  - not available: freqCounterBegin() returns false and the
+ *             channel uses its edge interrupt
+ *
+ * Usage:
+ *   #include "hal/hal_freq_counter.h"
+ *   if (hal::freqCounterBegin(unit, pin, 10)) {       // 10us glitch filter
+ *       uint16_t count = hal::freqCounterRead(unit);  // Wraps at HAL_FREQ_COUNTER_WRAP
+ *   }
+ *   hal::freqCounterEnd(unit);
+ *
+ * HAL_FREQ_COUNTER_UNITS is the number of counters (unit 0 .. UNITS-1).
+ */
+
+#ifndef HAL_FREQ_COUNTER_H
+#define HAL_FREQ_COUNTER_H
+
+#include <stdint.h>
+
+#if defined(ENABLE_FREQ_COUNTER_HW) && defined(ESP32)
+    // ESP32 variants with a PCNT peripheral (stub otherwise)
+    #include "platforms/freq_counter_esp32.h"
+
+#else
+    // Not enabled or no backend for this platform
+    #include "platforms/freq_counter_stub.h"
+
+#endif
+
+#endif // HAL_FREQ_COUNTER_H
@@ -0,0 +1,62 @@
+/*
+ * hal_idle.h - Hardware Abstraction Layer for CPU idle
+ * Part of the preOBD Hardware Abstraction Layer
+ *
+ * Puts the CPU into its lightest sleep state until the next interrupt.
+ * Every supported platform has a periodic tick interrupt (SysTick on ARM,
+ * Timer0 on AVR, FreeRTOS tick on ESP32), so the core wakes at least once per
+ * millisecond and the caller simply re-checks its deadline.
+ *
+ * Peripherals (USB, UART, CAN, SPI) keep running in these states, so serial
+ * commands and CAN frames still wake the CPU as soon as they arrive.
+ *
+ * In the host simulator (env:native) idling moves the simulated clock on to
+ * the next 1ms tick - a virtual-clock run skips the idle time entirely.
+ *
+ * Usage:
+ *   #include "hal/hal_idle.h"
+ *   hal::idleUntilInterrupt();
+ */
+
+#ifndef HAL_IDLE_H
+#define HAL_IDLE_H
+
+#include <stdint.h>
+
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__) || \
+    defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+    #include <avr/sleep.h>
+#elif defined(ESP32)
+    #include <freertos/FreeRTOS.h>
+    #include <freertos/task.h>
+#elif defined(PREOBD_NATIVE)
+    #include <sim.h>
+#endif
+
+namespace hal {
+
+inline void idleUntilInterrupt() {
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__) || \
+    defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+    // IDLE mode stops the CPU clock only - timers, UART and SPI keep running
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_mode();
+#elif defined(__MK20DX256__) || defined(__MK20DX128__) || \
+      defined(__MK64FX512__) || defined(__MK66FX1M0__) || \
+      defined(__IMXRT1062__) || defined(ARDUINO_SAM_DUE)
+    // Cortex-M: wait for interrupt (SysTick fires every 1ms)
+    __asm__ volatile("wfi");
+#elif defined(ESP32)
+    // Yield one tick to the idle task; with CONFIG_PM_ENABLE and tickless idle
+    // the IDF drops into automatic light-sleep here
+    vTaskDelay(1);
+#elif defined(PREOBD_NATIVE)
+    sim::idleToNextTick();
+#else
+    // Unknown platform - busy-wait (no-op)
+#endif
+}
+
+} // namespace hal
+
+#endif // HAL_IDLE_H
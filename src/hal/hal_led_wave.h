@@ -0,0 +1,54 @@
+/*
+ * hal_led_wave.h - Hardware Abstraction Layer for hardware-timed LED effects
+ * Part of the preOBD Hardware Abstraction Layer
+ *
+ * Runs a blink or a breathing ramp on the three RGB LED PWM channels without
+ * loop() - so a busy loop can't stretch a blink or stutter a fade, and the
+ * loop only touches the LED when the effect changes:
+ *
+ *   Teensy 3.x/4.x - IntervalTimer (PIT) stepping the PWM duty: each half
+ *                    period for a blink, HAL_LED_WAVE_STEPS steps per ramp
+ *   ESP32          - LEDC channels 0-2 (pins[i] on channel i, set up by the
+ *                    caller). A blink flips the duty from an esp_timer; a
+ *                    ramp is a hardware fade started each half period
+ *                    (LEDC fade engine), so the steps are the peripheral's
+ *   Others         - not available: ledWaveStart() returns false and the
+ *                    caller animates the effect from the loop
+ *
+ * The wave starts at its peak (blink on) or trough (ramp dark), like the
+ * loop-driven effect did.
+ *
+ * Usage:
+ *   #include "hal/hal_led_wave.h"
+ *   if (!hal::ledWaveStart(hal::LED_WAVE_BLINK, pins, peak, 500, false)) { ... }
+ *   hal::ledWaveStop();   // Before writing the channels directly again
+ */
+
+#ifndef HAL_LED_WAVE_H
+#define HAL_LED_WAVE_H
+
+#include <stdint.h>
+
+namespace hal {
+
+enum LedWave : uint8_t {
+    LED_WAVE_BLINK = 0,     // Square: peak for half the period, off for the other half
+    LED_WAVE_RAMP           // Triangle: off to peak and back over the period
+};
+
+} // namespace hal
+
+#if defined(TEENSYDUINO)
+    // Teensy 3.x / 4.x
+    #include "platforms/led_wave_teensy.h"
+
+#elif defined(ESP32)
+    #include "platforms/led_wave_esp32.h"
+
+#else
+    // No backend for this platform
+    #include "platforms/led_wave_stub.h"
+
+#endif
+
+#endif // HAL_LED_WAVE_H
@@ -0,0 +1,163 @@
+/*
+ * hal_memory.h - Hardware Abstraction Layer for RAM usage queries
+ * Part of the preOBD Hardware Abstraction Layer
+ *
+ * Where the static data, the heap and the stack are, from the linker symbols
+ * and allocator state of each platform:
+ *
+ *   AVR        - .data/.bss from __data_start to __bss_end; heap from
+ *                __heap_start up to __brkval; stack down from RAMEND
+ *   Teensy 3.x - .data/.bss from _sdata to _ebss; heap up from _ebss to
+ *                __brkval; stack down from _estack
+ *   Teensy 4.x - DTCM .data/.bss from _sdata to _ebss, stack down from
+ *                _estack to _ebss; DMAMEM below _heap_start in OCRAM; heap
+ *                from _heap_start up to __brkval
+ *   ESP32      - .data/.bss from the IDF linker symbols; heap and stack from
+ *                the heap allocator and FreeRTOS (HAL_HAS_STACK_RANGE = 0)
+ *   Others     - nothing known (HAL_HAS_MEMORY_INFO = 0)
+ *
+ * Where the stack range is known, the region between the heap and the stack
+ * can be painted and scanned for a high-water mark (lib/memory_report.h).
+ *
+ * Usage:
+ *   #include "hal/hal_memory.h"
+ *   size_t heap = hal::memHeapBytes();
+ */
+
+#ifndef HAL_MEMORY_H
+#define HAL_MEMORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__) || \
+    defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+    #include <avr/io.h>  // RAMEND
+    extern char __data_start;
+    extern char __bss_end;
+    extern char __heap_start;
+    extern char* __brkval;
+    #define HAL_HAS_MEMORY_INFO 1
+    #define HAL_HAS_STACK_RANGE 1
+#elif defined(__MK20DX256__) || defined(__MK20DX128__) || \
+      defined(__MK64FX512__) || defined(__MK66FX1M0__)
+    extern unsigned long _sdata;
+    extern unsigned long _ebss;
+    extern unsigned long _estack;
+    extern char* __brkval;
+    #define HAL_HAS_MEMORY_INFO 1
+    #define HAL_HAS_STACK_RANGE 1
+#elif defined(__IMXRT1062__)
+    extern unsigned long _sdata;
+    extern unsigned long _ebss;
+    extern unsigned long _estack;
+    extern unsigned long _heap_start;
+    extern char* __brkval;
+    #define HAL_MEMORY_OCRAM_BASE 0x20200000UL
+    #define HAL_HAS_MEMORY_INFO 1
+    #define HAL_HAS_STACK_RANGE 1
+#elif defined(ESP32)
+    #include <Arduino.h>  // ESP.getFreeHeap()
+    #include <freertos/FreeRTOS.h>
+    #include <freertos/task.h>
+    extern int _data_start, _data_end, _bss_start, _bss_end;
+    #define HAL_HAS_MEMORY_INFO 1
+    #define HAL_HAS_STACK_RANGE 0
+#else
+    #define HAL_HAS_MEMORY_INFO 0
+    #define HAL_HAS_STACK_RANGE 0
+#endif
+
+namespace hal {
+
+// Bytes of .data + .bss in the main RAM
+inline size_t memStaticBytes() {
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__) || \
+    defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+    return &__bss_end - &__data_start;
+#elif defined(__MK20DX256__) || defined(__MK20DX128__) || \
+      defined(__MK64FX512__) || defined(__MK66FX1M0__) || defined(__IMXRT1062__)
+    return (const char*)&_ebss - (const char*)&_sdata;
+#elif defined(ESP32)
+    return ((const char*)&_data_end - (const char*)&_data_start) +
+           ((const char*)&_bss_end - (const char*)&_bss_start);
+#else
+    return 0;
+#endif
+}
+
+// Bytes of static data in a second RAM (Teensy 4.x DMAMEM), 0 elsewhere
+inline size_t memSecondaryStaticBytes() {
+#if defined(__IMXRT1062__)
+    return (uintptr_t)&_heap_start - HAL_MEMORY_OCRAM_BASE;
+#else
+    return 0;
+#endif
+}
+
+// Heap bytes in use (handed out by sbrk, or allocated on ESP32)
+inline size_t memHeapBytes() {
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__) || \
+    defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+    return __brkval ? __brkval - &__heap_start : 0;
+#elif defined(__MK20DX256__) || defined(__MK20DX128__) || \
+      defined(__MK64FX512__) || defined(__MK66FX1M0__)
+    return __brkval ? __brkval - (char*)&_ebss : 0;
+#elif defined(__IMXRT1062__)
+    return __brkval ? __brkval - (char*)&_heap_start : 0;
+#elif defined(ESP32)
+    return ESP.getHeapSize() - ESP.getFreeHeap();
+#else
+    return 0;
+#endif
+}
+
+// Most heap bytes ever in use, where the allocator tracks it (0 = unknown)
+inline size_t memHeapPeakBytes() {
+#if defined(ESP32)
+    return ESP.getHeapSize() - ESP.getMinFreeHeap();
+#else
+    return 0;
+#endif
+}
+
+// Lowest address the stack can grow down to now (heap top, or end of .bss)
+inline uintptr_t memStackLimit() {
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__) || \
+    defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+    return (uintptr_t)(__brkval ? __brkval : &__heap_start);
+#elif defined(__MK20DX256__) || defined(__MK20DX128__) || \
+      defined(__MK64FX512__) || defined(__MK66FX1M0__)
+    return (uintptr_t)(__brkval ? __brkval : (char*)&_ebss);
+#elif defined(__IMXRT1062__)
+    return (uintptr_t)&_ebss;   // Heap is in OCRAM
+#else
+    return 0;
+#endif
+}
+
+// One past the highest stack address
+inline uintptr_t memStackTop() {
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__) || \
+    defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+    return (uintptr_t)RAMEND + 1;
+#elif defined(__MK20DX256__) || defined(__MK20DX128__) || \
+      defined(__MK64FX512__) || defined(__MK66FX1M0__) || defined(__IMXRT1062__)
+    return (uintptr_t)&_estack;
+#else
+    return 0;
+#endif
+}
+
+// Stack bytes of the calling task never used (ESP32), 0 = unknown
+inline size_t memTaskStackUnused() {
+#if defined(ESP32)
+    return uxTaskGetStackHighWaterMark(nullptr);   // Bytes on ESP32
+#else
+    return 0;
+#endif
+}
+
+} // namespace hal
+
+#endif // HAL_MEMORY_H
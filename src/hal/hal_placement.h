@@ -0,0 +1,138 @@
+/*
+ * hal_placement.h - Hardware Abstraction Layer for code and data placement
+ * Part of the preOBD Hardware Abstraction Layer
+ *
+ * Marks code and buffers for the memory they belong in, on the parts that
+ * have more than one kind:
+ *
+ *   HAL_HOT_CODE    - the sensor, CAN and alarm paths run every loop
+ *   HAL_COLD_CODE   - commands, help and reports, run when someone types
+ *   HAL_DMA_BUFFER  - large buffers the loop or a peripheral streams through
+ *                     (SD staging, sample rings), 32-byte (cache line) aligned
+ *   HAL_EXT_RAM     - big rings that can live in slow external RAM
+ *   HAL_ISR         - interrupt handlers and every function they call
+ *
+ * Teensy 4.x (i.MX RT1062) memory plan:
+ *
+ *   ITCM   0x00000000  Code, zero wait state. The Teensyduino linker script
+ *                      puts all code here unless it is FLASHMEM, so
+ *                      HAL_HOT_CODE (FASTRUN) only pins it there - and frees
+ *                      nothing. ITCM and DTCM share 512 KB in 32 KB banks:
+ *                      each bank less of code in ITCM is one more for DTCM.
+ *   DTCM   0x20000000  .data, .bss and the stack, zero wait state. inputs[]
+ *                      and the other runtime tables stay here (no marking).
+ *   OCRAM  0x20200000  DMAMEM, cached, not zeroed at startup - so a
+ *                      HAL_DMA_BUFFER holds garbage until written. The heap
+ *                      is also here.
+ *   FLASH  0x60000000  HAL_COLD_CODE (FLASHMEM), run through the 32 KB cache
+ *   EXTMEM 0x70000000  HAL_EXT_RAM on a Teensy 4.1 with PSRAM soldered on;
+ *                      check hal::extRamBytes() before use - with none fitted
+ *                      the linker still places it, but reads return garbage
+ *
+ * HAL_EXT_RAM is ordinary static storage on a Teensy 4.0. Elsewhere the
+ * macros are empty (HAL_HAS_PLACEMENT = 0) apart from HAL_DMA_BUFFER's
+ * alignment and HAL_ISR: Teensy 3.x FASTRUN would copy code into its only
+ * RAM.
+ *
+ * ESP32: the flash cache is off while flash is written (EEPROM commits, SD
+ * and BLE bonding on the same SPI flash), and any code in flash an interrupt
+ * runs then crashes the chip. HAL_ISR is IRAM_ATTR there: attachInterrupt()
+ * handlers and their callees must have it - and can't be templates, whose
+ * instances GCC puts in their own sections whatever they say. micros(), millis(), digitalRead()
+ * and esp_timer_get_time() are in IRAM already. Mutable statics are in DRAM;
+ * a const table read inside an ISR would need DRAM_ATTR (none is).
+ *
+ * What landed where: SYSTEM MEMORY lists the paths noted with
+ * notePlacement() (lib/memory_report.h), and tools/memory_report.py
+ * --placement lists each region from the linker map after every build.
+ *
+ * Usage:
+ *   #include "hal/hal_placement.h"
+ *   HAL_HOT_CODE void updateCANCache(...);
+ *   HAL_COLD_CODE static int cmd_help(int argc, const char* const* argv);
+ *   HAL_DMA_BUFFER static uint8_t stage[2][4096];
+ *   HAL_EXT_RAM static uint8_t ring[1048576];
+ *   if (hal::extRamBytes() == 0) ... // No PSRAM - don't use ring
+ *   HAL_ISR static void ppsISR() { ... }
+ *
+ * Build Flags:
+ *   -D PLACEMENT_COLD_FLASH=0  - Keep HAL_COLD_CODE in ITCM (default 1: flash)
+ */
+
+#ifndef HAL_PLACEMENT_H
+#define HAL_PLACEMENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef PLACEMENT_COLD_FLASH
+#define PLACEMENT_COLD_FLASH 1
+#endif
+
+#if defined(__IMXRT1062__)
+    #include <Arduino.h>  // FASTRUN, FLASHMEM, DMAMEM, EXTMEM
+    #define HAL_HOT_CODE FASTRUN
+    #if PLACEMENT_COLD_FLASH
+        #define HAL_COLD_CODE FLASHMEM
+    #else
+        #define HAL_COLD_CODE
+    #endif
+    #define HAL_DMA_BUFFER DMAMEM __attribute__((aligned(32)))
+    #if defined(ARDUINO_TEENSY41)
+        extern "C" uint8_t external_psram_size;  // MB of PSRAM fitted (Teensy 4.1 core)
+        #define HAL_EXT_RAM EXTMEM
+        #define HAL_HAS_EXT_RAM 1
+    #else
+        #define HAL_EXT_RAM
+        #define HAL_HAS_EXT_RAM 0
+    #endif
+    #define HAL_ISR FASTRUN
+    #define HAL_HAS_PLACEMENT 1
+#elif defined(ESP32)
+    #include <esp_attr.h>  // IRAM_ATTR
+    #define HAL_HOT_CODE
+    #define HAL_COLD_CODE
+    #define HAL_DMA_BUFFER __attribute__((aligned(32)))
+    #define HAL_EXT_RAM
+    #define HAL_HAS_EXT_RAM 0
+    #define HAL_ISR IRAM_ATTR
+    #define HAL_HAS_PLACEMENT 0
+#else
+    #define HAL_HOT_CODE
+    #define HAL_COLD_CODE
+    #define HAL_DMA_BUFFER __attribute__((aligned(32)))
+    #define HAL_EXT_RAM
+    #define HAL_HAS_EXT_RAM 0
+    #define HAL_ISR
+    #define HAL_HAS_PLACEMENT 0
+#endif
+
+namespace hal {
+
+// Bytes of external RAM fitted for HAL_EXT_RAM (0 = none, or not this platform)
+inline size_t extRamBytes() {
+#if HAL_HAS_EXT_RAM
+    return (size_t)external_psram_size * 1048576UL;
+#else
+    return 0;
+#endif
+}
+
+// Memory an address is in: "ITCM", "DTCM", "OCRAM", "FLASH", "EXTMEM" ("?" elsewhere)
+inline const char* placementRegion(const void* addr) {
+#if HAL_HAS_PLACEMENT
+    uintptr_t a = (uintptr_t)addr;
+    if (a < 0x00080000UL) return "ITCM";
+    if (a >= 0x20000000UL && a < 0x20080000UL) return "DTCM";
+    if (a >= 0x20200000UL && a < 0x20280000UL) return "OCRAM";
+    if (a >= 0x60000000UL && a < 0x70000000UL) return "FLASH";
+    if (a >= 0x70000000UL && a < 0x80000000UL) return "EXTMEM";
+#else
+    (void)addr;
+#endif
+    return "?";
+}
+
+} // namespace hal
+
+#endif // HAL_PLACEMENT_H
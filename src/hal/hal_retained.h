@@ -0,0 +1,66 @@
+/*
+ * hal_retained.h - Hardware Abstraction Layer for reset-retained RAM
+ * Part of the preOBD Hardware Abstraction Layer
+ *
+ * Places a variable in a RAM section that the startup code neither zeroes nor
+ * initialises, so its contents survive a watchdog or software reset (but not
+ * a power cycle). Callers must validate the contents themselves (magic value
+ * + checksum) since the RAM holds garbage after power-on.
+ *
+ *   AVR        - .noinit section
+ *   Teensy 3.x - .noinit section (provided by the Teensyduino linker scripts)
+ *   Teensy 4.x - DMAMEM (OCRAM, not cleared at startup); cached, so writes are
+ *                flushed with retainedFlush()
+ *   ESP32      - RTC_NOINIT_ATTR (RTC slow memory)
+ *   Others     - ordinary static storage (HAL_HAS_RETAINED_RAM = 0)
+ *
+ * Usage:
+ *   #include "hal/hal_retained.h"
+ *   static MyState state HAL_RETAINED;
+ *   ...
+ *   state.field = x;
+ *   hal::retainedFlush(&state, sizeof(state));
+ */
+
+#ifndef HAL_RETAINED_H
+#define HAL_RETAINED_H
+
+#include <stddef.h>
+
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__) || \
+    defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+    #define HAL_RETAINED __attribute__((section(".noinit")))
+    #define HAL_HAS_RETAINED_RAM 1
+#elif defined(__MK20DX256__) || defined(__MK20DX128__) || \
+      defined(__MK64FX512__) || defined(__MK66FX1M0__)
+    #define HAL_RETAINED __attribute__((section(".noinit")))
+    #define HAL_HAS_RETAINED_RAM 1
+#elif defined(__IMXRT1062__)
+    #include <Arduino.h>  // DMAMEM, arm_dcache_flush
+    #define HAL_RETAINED DMAMEM
+    #define HAL_HAS_RETAINED_RAM 1
+#elif defined(ESP32)
+    #include <esp_attr.h>
+    #define HAL_RETAINED RTC_NOINIT_ATTR
+    #define HAL_HAS_RETAINED_RAM 1
+#else
+    #define HAL_RETAINED
+    #define HAL_HAS_RETAINED_RAM 0
+#endif
+
+namespace hal {
+
+// Make sure retained data has reached RAM before a reset can occur
+inline void retainedFlush(void* addr, size_t size) {
+#if defined(__IMXRT1062__)
+    // OCRAM is write-back cached - a watchdog reset would drop dirty lines
+    arm_dcache_flush(addr, size);
+#else
+    (void)addr;
+    (void)size;
+#endif
+}
+
+} // namespace hal
+
+#endif // HAL_RETAINED_H
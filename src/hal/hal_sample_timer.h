@@ -0,0 +1,35 @@
+/*
+ * hal_sample_timer.h - Hardware Abstraction Layer for a periodic sampling interrupt
+ * Part of the preOBD Hardware Abstraction Layer
+ *
+ * One hardware timer calling a function at a fixed period, independent of
+ * loop(), so the bench streamer (outputs/bench_stream.h) samples the ADC at
+ * an exact rate:
+ *
+ *   Teensy 3.x/4.x - IntervalTimer (PIT); analogRead() is safe in its ISR
+ *   Others         - not available: sampleTimerBegin() returns false
+ *                    (ESP32 analogRead() takes a lock, AVR conversions
+ *                    are ~100us each)
+ *
+ * Usage:
+ *   #include "hal/hal_sample_timer.h"
+ *   if (hal::sampleTimerBegin(sampleIsr, 1000)) { ... }   // Every 1000us
+ *   hal::sampleTimerEnd();
+ */
+
+#ifndef HAL_SAMPLE_TIMER_H
+#define HAL_SAMPLE_TIMER_H
+
+#include <stdint.h>
+
+#if defined(TEENSYDUINO)
+    // Teensy 3.x / 4.x
+    #include "platforms/sample_timer_teensy.h"
+
+#else
+    // No backend for this platform
+    #include "platforms/sample_timer_stub.h"
+
+#endif
+
+#endif // HAL_SAMPLE_TIMER_H
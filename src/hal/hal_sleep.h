@@ -0,0 +1,118 @@
+/*
+ * hal_sleep.h - Hardware Abstraction Layer for low-power sleep
+ * Part of the preOBD Hardware Abstraction Layer
+ *
+ * Deeper than hal_idle.h: sleeps until one of a set of wake pins is at its
+ * active level, or a timeout passes - whichever comes first. The caller
+ * feeds the watchdog between calls, so keep the timeout under its period.
+ *
+ * What each platform does while asleep:
+ *   AVR        IDLE with the ADC off. Power-down would stop Timer0, and
+ *              millis() with it; the board regulator draws more than the
+ *              chip does anyway.
+ *   Teensy 4.x ARM clock down to 24 MHz, WFI until SysTick (100 kHz
+ *              reference - millis() keeps time) or a peripheral interrupt,
+ *              then back to the clock it ran at. USB stays enumerated.
+ *   Teensy 3.x WFI on SysTick or a peripheral interrupt.
+ *   ESP32      esp_light_sleep_start() with GPIO (level) and timer wakeup
+ *              sources. RAM and peripheral registers are kept, so there is
+ *              no boot on wake; radios and native USB drop out while asleep.
+ *   native     Simulated clock moved on tick by tick.
+ *
+ * A pin already at its level returns at once, so no wake is lost between
+ * the check and the sleep: the levels are checked before sleeping and after
+ * each wakeup. Wake sources without a pin (a FlexCAN or USB interrupt) are
+ * seen through the wakeCheck callback, polled after each wakeup.
+ *
+ * Usage:
+ *   #include "hal/hal_sleep.h"
+ *   hal::WakePin pins[] = { { CAN_INT_0, LOW }, { IGNITION_PIN, HIGH } };
+ *   if (hal::sleepUntilWake(pins, 2, 1000, canHasFrames)) ...  // Woken, not timed out
+ */
+
+#ifndef HAL_SLEEP_H
+#define HAL_SLEEP_H
+
+#include <Arduino.h>
+#include "hal_idle.h"
+
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__) || \
+    defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+    #include <avr/sleep.h>
+#elif defined(__IMXRT1062__)
+    extern "C" uint32_t set_arm_clock(uint32_t frequency);  // Teensy 4 core (clockspeed.c)
+#elif defined(ESP32)
+    #include <esp_sleep.h>
+    #include <driver/gpio.h>
+#endif
+
+namespace hal {
+
+struct WakePin {
+    uint8_t pin;
+    uint8_t level;      // LOW or HIGH - the level that wakes
+};
+
+namespace detail {
+    inline bool wakePinActive(const WakePin* pins, uint8_t count, bool (*wakeCheck)()) {
+        for (uint8_t i = 0; i < count; i++) {
+            if (digitalRead(pins[i].pin) == pins[i].level) return true;
+        }
+        return wakeCheck != nullptr && wakeCheck();
+    }
+}
+
+/**
+ * Sleep until a wake pin is at its level, wakeCheck() returns true (polled
+ * after every wakeup - activity an interrupt brought in) or timeoutMs passed
+ * @return true if woken, false on the timeout
+ */
+inline bool sleepUntilWake(const WakePin* pins, uint8_t count, uint32_t timeoutMs,
+                           bool (*wakeCheck)() = nullptr) {
+    if (detail::wakePinActive(pins, count, wakeCheck)) return true;
+#if !defined(ESP32)
+    uint32_t start = millis();
+#endif
+
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__) || \
+    defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+    uint8_t adcsra = ADCSRA;
+    ADCSRA &= ~_BV(ADEN);   // ADC off - its analog supply is most of what IDLE leaves running
+    while (millis() - start < timeoutMs && !detail::wakePinActive(pins, count, wakeCheck)) {
+        set_sleep_mode(SLEEP_MODE_IDLE);
+        sleep_mode();
+    }
+    ADCSRA = adcsra;
+#elif defined(__IMXRT1062__)
+    uint32_t cpuHz = F_CPU_ACTUAL;
+    set_arm_clock(24000000);
+    while (millis() - start < timeoutMs && !detail::wakePinActive(pins, count, wakeCheck)) {
+        __asm__ volatile("wfi");
+    }
+    set_arm_clock(cpuHz);
+#elif defined(ESP32)
+    for (uint8_t i = 0; i < count; i++) {
+        gpio_wakeup_enable((gpio_num_t)pins[i].pin,
+                           pins[i].level == HIGH ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL);
+    }
+    if (count > 0) esp_sleep_enable_gpio_wakeup();
+    esp_sleep_enable_timer_wakeup((uint64_t)timeoutMs * 1000ULL);
+    esp_light_sleep_start();
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER);
+    if (count > 0) esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_GPIO);
+    for (uint8_t i = 0; i < count; i++) {
+        gpio_wakeup_disable((gpio_num_t)pins[i].pin);
+    }
+#else
+    // Cortex-M (WFI on SysTick), native (simulated ticks)
+    while (millis() - start < timeoutMs && !detail::wakePinActive(pins, count, wakeCheck)) {
+        idleUntilInterrupt();
+    }
+#endif
+
+    return detail::wakePinActive(pins, count, wakeCheck);
+}
+
+} // namespace hal
+
+#endif // HAL_SLEEP_H
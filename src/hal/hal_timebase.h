@@ -0,0 +1,114 @@
+/*
+ * hal_timebase.h - Hardware Abstraction Layer for the 64-bit microsecond clock
+ * Part of the preOBD Hardware Abstraction Layer
+ *
+ * A monotonic microsecond count since boot that never wraps in practice
+ * (584,000 years), for stamping samples and frames where millis() is too
+ * coarse or wraps (49 days):
+ *
+ *   Teensy 3.x/4.x - DWT CYCCNT extended to 64 bits, in core cycles / MHz
+ *   ESP32          - esp_timer_get_time() (64-bit already)
+ *   Others         - micros() extended to 64 bits
+ *
+ * The extension notices a wrap of the 32-bit counter on the next read, so
+ * micros64() has to be called at least once per wrap - 7 s of DWT at
+ * 600 MHz, 71 minutes of micros(). The main loop does (updateTimebase()).
+ * Safe to call from interrupt handlers - the extension runs with interrupts
+ * masked, and restores the mask it found.
+ *
+ * This is local time since boot; lib/timebase.h maps it to UTC.
+ *
+ * Usage:
+ *   #include "hal/hal_timebase.h"
+ *   uint64_t t = hal::micros64();
+ */
+
+#ifndef HAL_TIMEBASE_H
+#define HAL_TIMEBASE_H
+
+#include <Arduino.h>
+
+#if defined(__IMXRT1062__) || defined(__MK20DX256__) || defined(__MK20DX128__) || \
+    defined(__MK64FX512__) || defined(__MK66FX1M0__)
+    #include "hal_cycles.h"
+    #define HAL_TIMEBASE_TEENSY_DWT 1
+#elif defined(ESP32)
+    #include <esp_timer.h>
+#endif
+
+namespace hal {
+
+namespace detail {
+
+// Extension state: counter at the last read, whole microseconds counted,
+// and leftover counter ticks short of a microsecond (DWT only)
+struct Timebase64 {
+    uint32_t last;
+    uint32_t remainder;
+    uint64_t us;
+};
+
+inline Timebase64& timebase64() { static Timebase64 state = { 0, 0, 0 }; return state; }
+
+// Mask interrupts, returning whether they were enabled
+inline bool timebaseLock() {
+#if defined(__arm__)
+    uint32_t primask;
+    __asm__ volatile("mrs %0, primask" : "=r"(primask));
+    __asm__ volatile("cpsid i" ::: "memory");
+    return primask == 0;
+#elif defined(__AVR__)
+    bool enabled = SREG & 0x80;
+    cli();
+    return enabled;
+#elif defined(PREOBD_NATIVE)
+    return false;
+#else
+    noInterrupts();
+    return true;
+#endif
+}
+
+inline void timebaseUnlock(bool enabled) {
+#if defined(__arm__)
+    if (enabled) __asm__ volatile("cpsie i" ::: "memory");
+#elif defined(__AVR__)
+    if (enabled) sei();
+#elif defined(PREOBD_NATIVE)
+    (void)enabled;
+#else
+    if (enabled) interrupts();
+#endif
+}
+
+} // namespace detail
+
+// Microseconds since boot, monotonic, 64-bit
+inline uint64_t micros64() {
+#if defined(ESP32)
+    return (uint64_t)esp_timer_get_time();
+#else
+    detail::Timebase64& s = detail::timebase64();
+    bool enabled = detail::timebaseLock();
+#if defined(HAL_TIMEBASE_TEENSY_DWT)
+    // Cycles to microseconds at the current core clock, carrying the remainder
+    uint32_t now = cycleCount();
+    uint32_t perUs = cycleHz() / 1000000UL;
+    uint64_t ticks = (uint64_t)(now - s.last) + s.remainder;
+    s.last = now;
+    s.us += ticks / perUs;
+    s.remainder = (uint32_t)(ticks % perUs);
+#else
+    uint32_t now = micros();
+    s.us += (uint32_t)(now - s.last);
+    s.last = now;
+#endif
+    uint64_t us = s.us;
+    detail::timebaseUnlock(enabled);
+    return us;
+#endif
+}
+
+} // namespace hal
+
+#endif // HAL_TIMEBASE_H
@@ -45,6 +45,13 @@
     #define PLATFORM_NEEDS_SPI_CAN 0
     // ESP32 has 1 native TWAI bus (NUM_CAN_BUSES defined in bus_defaults.h)
 
+// Host simulator: SocketCAN interfaces (sim/, Linux)
+#elif defined(PREOBD_NATIVE)
+
+    #define PLATFORM_CAN_CONTROLLER "SocketCAN"
+    #define PLATFORM_HAS_NATIVE_CAN 1
+    #define PLATFORM_NEEDS_SPI_CAN 0
+
 // Detect STM32 bxCAN (future support)
 #elif defined(STM32F4xx) || defined(STM32F1xx)
 
@@ -106,7 +113,8 @@
 
 // Used for analog sensor calibration and pin compatibility
 #if defined(__IMXRT1062__) || defined(__MK20DX256__) || defined(__MK64FX512__) || \
-    defined(__MK66FX1M0__) || defined(ESP32) || defined(STM32F4xx) || defined(STM32F1xx)
+    defined(__MK66FX1M0__) || defined(ESP32) || defined(STM32F4xx) || defined(STM32F1xx) || \
+    defined(PREOBD_NATIVE)
     #define PLATFORM_VOLTAGE_3V3 1
     #define PLATFORM_VOLTAGE_5V 0
 #else
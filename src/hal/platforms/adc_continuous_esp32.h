@@ -0,0 +1,73 @@
+/*
+ * adc_continuous_esp32.h - ESP32 continuous ADC implementation
+ * Part of the preOBD Hardware Abstraction Layer
+ *
+ * Wraps the Arduino-ESP32 3.x continuous ADC API (ADC1 + DMA ring buffer,
+ * averaged per pin by the driver). Older cores don't have it - the stub
+ * behaviour is used there and the scanner keeps single conversions.
+ */
+
+#ifndef HAL_ADC_CONTINUOUS_ESP32_H
+#define HAL_ADC_CONTINUOUS_ESP32_H
+
+#include <Arduino.h>
+#include <esp_arduino_version.h>
+
+// Per-pin conversion rate of the DMA scan
+#ifndef ADC_CONTINUOUS_SAMPLE_HZ
+#define ADC_CONTINUOUS_SAMPLE_HZ 20000
+#endif
+
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+
+#define HAL_HAS_ADC_CONTINUOUS 1
+#define HAL_ADC_CONTINUOUS_EXCLUSIVE 1  // ADC1 can't do analogRead() while scanning
+
+namespace hal {
+
+namespace detail {
+    static uint8_t continuousPins = 0;
+}
+
+inline bool adcContinuousBegin(const uint8_t* pins, uint8_t count, uint8_t oversample) {
+    if (count == 0) return false;
+    analogContinuousSetWidth(ADC_RESOLUTION);
+    analogContinuousSetAtten(ADC_11db);  // Same range as setupADC()
+    if (!analogContinuous(pins, count, oversample, ADC_CONTINUOUS_SAMPLE_HZ, nullptr)) {
+        return false;  // e.g. a pin on ADC2 - not supported in continuous mode
+    }
+    if (!analogContinuousStart()) {
+        analogContinuousDeinit();
+        return false;
+    }
+    detail::continuousPins = count;
+    return true;
+}
+
+inline bool adcContinuousRead(uint16_t* counts) {
+    adc_continuous_data_t* results = nullptr;
+    if (detail::continuousPins == 0 || !analogContinuousRead(&results, 0)) {
+        return false;  // No completed frame since the last read
+    }
+    for (uint8_t i = 0; i < detail::continuousPins; i++) {
+        counts[i] = (uint16_t)results[i].avg_read_raw;
+    }
+    return true;
+}
+
+inline void adcContinuousEnd() {
+    if (detail::continuousPins == 0) return;
+    analogContinuousStop();
+    analogContinuousDeinit();
+    detail::continuousPins = 0;
+}
+
+} // namespace hal
+
+#else
+
+#include "adc_continuous_stub.h"
+
+#endif // ESP_ARDUINO_VERSION_MAJOR >= 3
+
+#endif // HAL_ADC_CONTINUOUS_ESP32_H
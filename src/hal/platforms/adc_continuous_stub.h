@@ -0,0 +1,33 @@
+/*
+ * adc_continuous_stub.h - Stub continuous ADC implementation
+ * Part of the preOBD Hardware Abstraction Layer
+ * Used when ENABLE_ADC_CONTINUOUS is off or the platform has no backend
+ */
+
+#ifndef HAL_ADC_CONTINUOUS_STUB_H
+#define HAL_ADC_CONTINUOUS_STUB_H
+
+#include <stdint.h>
+
+#define HAL_HAS_ADC_CONTINUOUS 0
+#define HAL_ADC_CONTINUOUS_EXCLUSIVE 0
+
+namespace hal {
+
+inline bool adcContinuousBegin(const uint8_t* pins, uint8_t count, uint8_t oversample) {
+    (void)pins;
+    (void)count;
+    (void)oversample;
+    return false;
+}
+
+inline bool adcContinuousRead(uint16_t* counts) {
+    (void)counts;
+    return false;
+}
+
+inline void adcContinuousEnd() {}
+
+} // namespace hal
+
+#endif // HAL_ADC_CONTINUOUS_STUB_H
@@ -0,0 +1,152 @@
+/*
+ * adc_continuous_teensy4.h - Teensy 4.x (IMXRT1062) continuous ADC implementation
+ * Part of the preOBD Hardware Abstraction Layer
+ *
+ * Uses the ADC External Trigger Control (ADC_ETC) block to sequence ADC2
+ * through up to 8 channels per trigger chain, 4 chains (TRIG4-7), without CPU
+ * involvement. ADC2's hardware averaging does the decimation. Each
+ * adcContinuousRead() copies the finished pass out of the result registers
+ * and kicks off the next one, so a read never waits for a conversion.
+ *
+ * Pins only on ADC1 (A10, A11) can't be scanned this way - Begin fails and
+ * the caller keeps single conversions.
+ */
+
+#ifndef HAL_ADC_CONTINUOUS_TEENSY4_H
+#define HAL_ADC_CONTINUOUS_TEENSY4_H
+
+#include <Arduino.h>
+#include "../hal_adc.h"  // hal::adcInstance() for ADC2 resolution/averaging
+
+#define HAL_HAS_ADC_CONTINUOUS 1
+#define HAL_ADC_CONTINUOUS_EXCLUSIVE 0  // analogRead() uses ADC1 - no conflict
+
+namespace hal {
+
+namespace detail {
+    // ADC_ETC register block (i.MX RT1060 RM, chapter 67)
+    struct AdcEtcTrigger {
+        volatile uint32_t CTRL;
+        volatile uint32_t COUNTER;
+        volatile uint32_t CHAIN[4];    // CHAIN_1_0 .. CHAIN_7_6
+        volatile uint32_t RESULT[4];   // RESULT_1_0 .. RESULT_7_6
+    };
+    struct AdcEtcRegs {
+        volatile uint32_t CTRL;
+        volatile uint32_t DONE0_1_IRQ;
+        volatile uint32_t DONE2_ERR_IRQ;
+        volatile uint32_t DMA_CTRL;
+        AdcEtcTrigger TRIG[8];
+    };
+    #define HAL_ADC_ETC (*(detail::AdcEtcRegs*)0x403B0000)
+
+    const uint32_t ETC_CTRL_TSC_BYPASS = 1UL << 30;
+    const uint32_t ETC_TRIG_SW_TRIG    = 1UL << 0;
+    const uint32_t ETC_TRIG_MODE_SW    = 1UL << 4;
+    const uint32_t ADC_CFG_ADTRG_BIT   = 1UL << 13;
+    const uint32_t ADC_HC_ADCH_ETC     = 16;   // Channel supplied by ADC_ETC
+
+    const uint8_t FIRST_ADC2_TRIGGER = 4;      // TRIG4-7 drive ADC2
+    const uint8_t CHAIN_LENGTH = 8;
+    const uint8_t MAX_PINS = 4 * CHAIN_LENGTH;
+
+    // ADC2 input channel for a Teensy 4.0/4.1 pin, 0xFF if not on ADC2
+    inline uint8_t adc2Channel(uint8_t pin) {
+        static const uint8_t channels[] = {
+            7, 8, 12, 11, 6, 5, 15, 0, 13, 14,   // 14-23: A0-A9
+            0xFF, 0xFF,                          // 24-25: A10-A11 (ADC1 only)
+            3, 4                                 // 26-27: A12-A13
+        };
+        if (pin >= 14 && pin <= 27) return channels[pin - 14];
+        if (pin == 38) return 1;                 // A14 (Teensy 4.1)
+        if (pin == 39) return 2;                 // A15
+        if (pin == 40) return 9;                 // A16
+        if (pin == 41) return 10;                // A17
+        return 0xFF;
+    }
+
+    static uint8_t numPins = 0;
+    static uint8_t numTriggers = 0;
+
+    inline void triggerPass() {
+        for (uint8_t t = 0; t < numTriggers; t++) {
+            HAL_ADC_ETC.TRIG[FIRST_ADC2_TRIGGER + t].CTRL |= ETC_TRIG_SW_TRIG;
+        }
+    }
+
+    inline uint32_t doneMask() {
+        return ((1UL << numTriggers) - 1) << FIRST_ADC2_TRIGGER;
+    }
+}
+
+inline bool adcContinuousBegin(const uint8_t* pins, uint8_t count, uint8_t oversample) {
+    if (count == 0 || count > detail::MAX_PINS) return false;
+    for (uint8_t i = 0; i < count; i++) {
+        if (detail::adc2Channel(pins[i]) == 0xFF) return false;
+    }
+
+    // Averaging through the ADC library, then hand ADC2 to the trigger controller
+    ADC* adc = adcInstance();
+    adc->adc1->setResolution(ADC_RESOLUTION);
+    adc->adc1->setAveraging(oversample);
+    ADC2_CFG |= detail::ADC_CFG_ADTRG_BIT;
+    ADC2_HC0 = detail::ADC_HC_ADCH_ETC;
+
+    detail::numPins = count;
+    detail::numTriggers = (count + detail::CHAIN_LENGTH - 1) / detail::CHAIN_LENGTH;
+
+    for (uint8_t t = 0; t < detail::numTriggers; t++) {
+        detail::AdcEtcTrigger* trig = &HAL_ADC_ETC.TRIG[detail::FIRST_ADC2_TRIGGER + t];
+        uint8_t first = t * detail::CHAIN_LENGTH;
+        uint8_t length = count - first;
+        if (length > detail::CHAIN_LENGTH) length = detail::CHAIN_LENGTH;
+
+        trig->CTRL = detail::ETC_TRIG_MODE_SW | ((uint32_t)(length - 1) << 12);
+        for (uint8_t r = 0; r < 4; r++) trig->CHAIN[r] = 0;
+
+        for (uint8_t s = 0; s < length; s++) {
+            // Segment: channel, HC0, back-to-back, DONE0 interrupt flag on the last one
+            uint32_t segment = detail::adc2Channel(pins[first + s]) |
+                               (1UL << 4) | (1UL << 12) |
+                               ((s == length - 1) ? (1UL << 13) : 0);
+            trig->CHAIN[s / 2] |= segment << ((s & 1) ? 16 : 0);
+        }
+    }
+
+    HAL_ADC_ETC.CTRL = detail::ETC_CTRL_TSC_BYPASS | detail::doneMask();
+    HAL_ADC_ETC.DONE0_1_IRQ = detail::doneMask();  // Clear stale flags
+    detail::triggerPass();
+    return true;
+}
+
+inline bool adcContinuousRead(uint16_t* counts) {
+    uint32_t mask = detail::doneMask();
+    if (detail::numPins == 0 || (HAL_ADC_ETC.DONE0_1_IRQ & mask) != mask) {
+        return false;  // Pass still running
+    }
+
+    for (uint8_t i = 0; i < detail::numPins; i++) {
+        detail::AdcEtcTrigger* trig =
+            &HAL_ADC_ETC.TRIG[detail::FIRST_ADC2_TRIGGER + i / detail::CHAIN_LENGTH];
+        uint8_t s = i % detail::CHAIN_LENGTH;
+        uint32_t result = trig->RESULT[s / 2];
+        counts[i] = (s & 1) ? ((result >> 16) & 0x0FFF) : (result & 0x0FFF);
+    }
+
+    HAL_ADC_ETC.DONE0_1_IRQ = mask;
+    detail::triggerPass();
+    return true;
+}
+
+inline void adcContinuousEnd() {
+    if (detail::numPins == 0) return;
+    HAL_ADC_ETC.CTRL = detail::ETC_CTRL_TSC_BYPASS;  // All triggers disabled
+    ADC2_CFG &= ~detail::ADC_CFG_ADTRG_BIT;           // Back to software-triggered
+    adcInstance()->adc1->setAveraging(1);
+    detail::numPins = 0;
+    detail::numTriggers = 0;
+}
+
+} // namespace hal
+
+#endif // HAL_ADC_CONTINUOUS_TEENSY4_H
@@ -6,12 +6,76 @@
  * - Bus 0: CAN1 (available on all Teensy 3.x/4.x)
  * - Bus 1: CAN2 (Teensy 3.6, 4.0, 4.1)
  * - Bus 2: CAN3 (Teensy 4.1 only)
+ *
+ * Interrupt-driven receive (default):
+ * Each bus runs its RX FIFO with the FIFO interrupt enabled. FlexCAN_T4
+ * hands every frame to an onReceive() callback in interrupt context, which
+ * copies it into this bus's ring (hal_can_frame.h) stamped with millis() as
+ * it arrives; readFrame() pops from the ring. Nothing is polled, and a frame's
+ * age in the CAN frame cache is its real age on the wire rather than the time
+ * since the main loop last looked. The FIFO's 8 ID filter elements carry the
+ * acceptance filter rules; mailboxes after the FIFO are left for transmit.
+ *
+ * The controller's 16-bit receive timestamp counts bit times (it wraps every
+ * 131ms at 500kbps), so it's only good for ordering within the FIFO; the ISR
+ * runs within microseconds of reception, which makes millis() at ISR entry
+ * the usable receive time.
+ *
+ * With -D FLEXCAN_RX_FIFO=0 the previous polled mode is used: 8 RX mailboxes,
+ * each holding one filter rule, read from the main loop.
+ *
+ * CAN FD (-D ENABLE_CAN_FD, Teensy 4.x):
+ * Bus 2 (CAN3, the only FD-capable controller) runs FlexCAN_T4FD with 64-byte
+ * mailboxes at the configured nominal rate and CAN_FD_DATA_BAUDRATE in the
+ * data phase. The FD controller has no RX FIFO, so 8 RX mailboxes (one filter
+ * rule each) raise the interrupt and the callback fills the ring the same
+ * way. Frames of up to 8 bytes are sent as classic CAN, so OBD-II and other
+ * classic nodes on the bus still understand them; longer ones go out as FD
+ * with bit rate switching.
+ *
+ * Build Flags:
+ *   -D FLEXCAN_RX_FIFO=0|1  - FIFO + interrupt receive (default 1)
+ *   -D FLEXCAN_RX_RING=n    - Frames buffered per bus, power of 2
+ *                             (default 64 on Teensy 4.x, 32 on 3.x; 20 bytes each,
+ *                             76 with ENABLE_CAN_FD)
+ *   -D CAN_FD_DATA_BAUDRATE=n - CAN FD data phase rate (default 2000000, max 8000000)
  */
 
 #ifndef HAL_CAN_FLEXCAN_H
 #define HAL_CAN_FLEXCAN_H
 
+#include <Arduino.h>
 #include <FlexCAN_T4.h>
+#include "../hal_can_filter.h"
+#include "../hal_can_frame.h"
+#include "../hal_placement.h"
+#include "../../lib/isr_profile.h"
+
+#ifndef FLEXCAN_RX_FIFO
+#define FLEXCAN_RX_FIFO 1
+#endif
+
+#ifndef FLEXCAN_RX_RING
+  #if defined(__IMXRT1062__)
+    #define FLEXCAN_RX_RING 64
+  #else
+    #define FLEXCAN_RX_RING 32
+  #endif
+#endif
+
+#if (FLEXCAN_RX_RING & (FLEXCAN_RX_RING - 1)) != 0 || FLEXCAN_RX_RING > 128
+#error "FLEXCAN_RX_RING must be a power of 2, at most 128"
+#endif
+
+#if defined(ENABLE_CAN_FD)
+  #if !defined(__IMXRT1062__)
+    #error "ENABLE_CAN_FD needs a Teensy 4.x (CAN3 is the only FD controller)"
+  #endif
+  #define FLEXCAN_FD_BUS 2
+  #ifndef CAN_FD_DATA_BAUDRATE
+  #define CAN_FD_DATA_BAUDRATE 2000000
+  #endif
+#endif
 
 namespace hal { namespace can {
 
@@ -21,41 +85,286 @@ namespace flexcan {
 #endif
 
 namespace detail {
-    // Static instances in detail namespace to avoid ODR issues
-    static FlexCAN_T4<CAN1, RX_SIZE_256, TX_SIZE_16> canBus0;
+    static constexpr int RX_MAILBOXES = 8;   // Polled mode
+    static constexpr int FIFO_FILTERS = 8;   // RX FIFO ID filter elements (default table size)
+    static constexpr int MAX_MAILBOXES = 16;
+
+    typedef CanRxRing<FLEXCAN_RX_RING> RxRing;
+
+    // Per-bus ring, shared across translation units like the instances below
+    inline RxRing& busRing(uint8_t bus) {
+        static RxRing rings[3];
+        return rings[bus];
+    }
+
+    // One instance per bus shared by every translation unit (function-local
+    // statics of inline functions) - FlexCAN_T4 routes a bus's interrupt to
+    // the last instance constructed, so per-file copies would fight over it
+    template<CAN_DEV_TABLE BUS>
+    inline FlexCAN_T4<BUS, RX_SIZE_256, TX_SIZE_16>& busInstance() {
+        static FlexCAN_T4<BUS, RX_SIZE_256, TX_SIZE_16> instance;
+        return instance;
+    }
+
+    static FlexCAN_T4<CAN1, RX_SIZE_256, TX_SIZE_16>& canBus0 = busInstance<CAN1>();
     #if defined(CAN2)
-        static FlexCAN_T4<CAN2, RX_SIZE_256, TX_SIZE_16> canBus1;
+        static FlexCAN_T4<CAN2, RX_SIZE_256, TX_SIZE_16>& canBus1 = busInstance<CAN2>();
     #endif
-    #if defined(CAN3)
-        static FlexCAN_T4<CAN3, RX_SIZE_256, TX_SIZE_16> canBus2;
+    #if defined(FLEXCAN_FD_BUS)
+        typedef FlexCAN_T4FD<CAN3, RX_SIZE_256, TX_SIZE_16> FDBus;
+        inline FDBus& fdInstance() {
+            static FDBus instance;
+            return instance;
+        }
+        static FDBus& canBus2 = fdInstance();
+    #elif defined(CAN3)
+        static FlexCAN_T4<CAN3, RX_SIZE_256, TX_SIZE_16>& canBus2 = busInstance<CAN3>();
     #endif
 
+    #if FLEXCAN_RX_FIFO
+    /**
+     * FIFO callback - interrupt context, so copy into the ring and return
+     * A full ring drops the frame (counted); the reader catches up next pass.
+     */
+    template<uint8_t BUS_INDEX>
+    void rxISR(const CAN_message_t& msg) {  // ITCM like all code (a template can't be HAL_ISR)
+        ISR_PROFILE_BEGIN();
+        RxRing& ring = busRing(BUS_INDEX);
+        CanRxFrame* slot = ring.claim();
+        if (slot == nullptr) {
+            ring.overflows++;
+            ISR_PROFILE_END(ISR_PROF_CAN_RX);
+            return;
+        }
+        slot->id = msg.id;
+        slot->extended = msg.flags.extended;
+        slot->len = msg.len > 8 ? 8 : msg.len;
+        slot->fd = false;
+        slot->rxMs = millis();
+        slot->rxUs = hal::micros64();
+        memcpy(slot->data, msg.buf, slot->len);
+        ring.publish();
+        ISR_PROFILE_END(ISR_PROF_CAN_RX);
+    }
+
     // Helper to initialize a specific bus instance
+    template<uint8_t BUS_INDEX, typename T>
+    inline void initBus(T& bus, uint32_t baudrate, bool listenOnly = false) {
+        RxRing& ring = busRing(BUS_INDEX);
+        if (ring.active) bus.enableFIFOInterrupt(false);  // Re-init - stop the producer first
+        ring.active = false;
+        ring.reset();
+        bus.begin();
+        bus.setBaudRate(baudrate, listenOnly ? LISTEN_ONLY : TX);
+        bus.setMaxMB(MAX_MAILBOXES);
+        bus.enableFIFO();
+        bus.setFIFOFilter(ACCEPT_ALL);
+        // Mailboxes past the FIFO and its filter table transmit
+        for (int i = FIFO_FILTERS; i < MAX_MAILBOXES; i++) {
+            bus.setMB((FLEXCAN_MAILBOX)i, TX);
+        }
+        bus.onReceive(FIFO, rxISR<BUS_INDEX>);
+        bus.enableFIFOInterrupt();
+        ring.active = true;
+    }
+
+    /**
+     * One rule per FIFO filter element - each has its own ID, mask and frame
+     * format. Unused elements reject everything.
+     */
+    template<typename T>
+    inline bool applyFilterRules(T& bus, const CanFilterRule* rules, uint8_t count) {
+        CanFilterRule work[HAL_CAN_MAX_FILTER_RULES];
+        bool exact = filter::normalize(rules, count, work);
+        if (!exact) count = 0;
+        count = filter::merge(work, count, FIFO_FILTERS, &exact);
+
+        if (count == 0) {
+            bus.setFIFOFilter(ACCEPT_ALL);
+            return exact;
+        }
+        bus.setFIFOFilter(REJECT_ALL);
+        for (uint8_t i = 0; i < count; i++) {
+            bus.setFIFOUserFilter(i, work[i].id, work[i].mask, work[i].extended ? EXT : STD);
+        }
+        return exact;
+    }
+
     template<typename T>
+    inline bool readBus(T& bus, uint8_t busIndex, CanRxFrame& frame) {
+        (void)bus;
+        RxRing& ring = busRing(busIndex);
+        return ring.active && ring.pop(frame);
+    }
+    #else
+    // Helper to initialize a specific bus instance
+    template<uint8_t BUS_INDEX, typename T>
     inline void initBus(T& bus, uint32_t baudrate, bool listenOnly = false) {
         bus.begin();
         bus.setBaudRate(baudrate, listenOnly ? LISTEN_ONLY : TX);
-        bus.setMaxMB(16);
+        bus.setMaxMB(MAX_MAILBOXES);
         // Configure first 8 mailboxes for RX
-        for (int i = 0; i < 8; i++) {
+        for (int i = 0; i < RX_MAILBOXES; i++) {
             bus.setMB((FLEXCAN_MAILBOX)i, RX, STD);
         }
     }
+
+    /**
+     * One rule per RX mailbox - each mailbox has its own ID, mask and frame
+     * format. Unused mailboxes reject everything.
+     */
+    template<typename T>
+    inline bool applyFilterRules(T& bus, const CanFilterRule* rules, uint8_t count) {
+        CanFilterRule work[HAL_CAN_MAX_FILTER_RULES];
+        bool exact = filter::normalize(rules, count, work);
+        if (!exact) count = 0;
+        count = filter::merge(work, count, RX_MAILBOXES, &exact);
+
+        for (int i = 0; i < RX_MAILBOXES; i++) {
+            FLEXCAN_MAILBOX mb = (FLEXCAN_MAILBOX)i;
+            if (count == 0) {
+                bus.setMB(mb, RX, STD);
+                bus.setMBFilter(mb, ACCEPT_ALL);
+            } else if (i < count) {
+                bus.setMB(mb, RX, work[i].extended ? EXT : STD);
+                bus.setMBUserFilter(mb, work[i].id, work[i].mask);
+            } else {
+                bus.setMBFilter(mb, REJECT_ALL);
+            }
+        }
+        return exact;
+    }
+
+    template<typename T>
+    inline bool readBus(T& bus, uint8_t busIndex, CanRxFrame& frame) {
+        (void)busIndex;
+        CAN_message_t msg;
+        if (!bus.read(msg)) return false;
+        frame.id = msg.id;
+        frame.extended = msg.flags.extended;
+        frame.len = msg.len > 8 ? 8 : msg.len;
+        frame.fd = false;
+        frame.rxMs = millis();
+        frame.rxUs = hal::micros64();
+        memcpy(frame.data, msg.buf, frame.len);
+        return true;
+    }
+    #endif
+
+    #if defined(FLEXCAN_FD_BUS)
+    static constexpr int FD_RX_MAILBOXES = 8;
+    static constexpr int FD_MAILBOXES = 14;   // 64-byte payloads: 7 per RAM region
+
+    // Mailbox callback - interrupt context, same ring as the classic buses
+    HAL_ISR inline void rxISRFD(const CANFD_message_t& msg) {
+        ISR_PROFILE_BEGIN();
+        RxRing& ring = busRing(FLEXCAN_FD_BUS);
+        CanRxFrame* slot = ring.claim();
+        if (slot == nullptr) {
+            ring.overflows++;
+            ISR_PROFILE_END(ISR_PROF_CAN_RX);
+            return;
+        }
+        slot->id = msg.id;
+        slot->extended = msg.flags.extended;
+        slot->fd = msg.edl;
+        slot->len = msg.len > HAL_CAN_MAX_DLEN ? HAL_CAN_MAX_DLEN : msg.len;
+        slot->rxMs = millis();
+        slot->rxUs = hal::micros64();
+        memcpy(slot->data, msg.buf, slot->len);
+        ring.publish();
+        ISR_PROFILE_END(ISR_PROF_CAN_RX);
+    }
+
+    inline void initFDBus(FDBus& bus, uint32_t baudrate, bool listenOnly) {
+        RxRing& ring = busRing(FLEXCAN_FD_BUS);
+        if (ring.active) bus.enableMBInterrupts(false);  // Re-init - stop the producer first
+        ring.active = false;
+        ring.reset();
+
+        bus.begin();
+        CANFD_timings_t config;
+        config.clock = CLK_24MHz;
+        config.baudrate = baudrate;
+        config.baudrateFD = CAN_FD_DATA_BAUDRATE;
+        config.propdelay = 190;
+        config.bus_length = 1;
+        config.sample = 75;
+        bus.setRegions(64);
+        bus.setBaudRate(config, 1, 1, listenOnly ? LISTEN_ONLY : TX);
+        for (int i = 0; i < FD_MAILBOXES; i++) {
+            bus.setMB((FLEXCAN_MAILBOX)i, i < FD_RX_MAILBOXES ? RX : TX, STD);
+        }
+        for (int i = 0; i < FD_RX_MAILBOXES; i++) {
+            bus.setMBFilter((FLEXCAN_MAILBOX)i, ACCEPT_ALL);
+        }
+        bus.onReceive(rxISRFD);
+        bus.enableMBInterrupts();
+        ring.active = true;
+    }
+
+    // One rule per RX mailbox, as in polled classic mode
+    inline bool applyFilterRules(FDBus& bus, const CanFilterRule* rules, uint8_t count) {
+        CanFilterRule work[HAL_CAN_MAX_FILTER_RULES];
+        bool exact = filter::normalize(rules, count, work);
+        if (!exact) count = 0;
+        count = filter::merge(work, count, FD_RX_MAILBOXES, &exact);
+
+        for (int i = 0; i < FD_RX_MAILBOXES; i++) {
+            FLEXCAN_MAILBOX mb = (FLEXCAN_MAILBOX)i;
+            if (count == 0) {
+                bus.setMB(mb, RX, STD);
+                bus.setMBFilter(mb, ACCEPT_ALL);
+            } else if (i < count) {
+                bus.setMB(mb, RX, work[i].extended ? EXT : STD);
+                bus.setMBUserFilter(mb, work[i].id, work[i].mask);
+            } else {
+                bus.setMBFilter(mb, REJECT_ALL);
+            }
+        }
+        return exact;
+    }
+
+    inline bool readBus(FDBus& bus, uint8_t busIndex, CanRxFrame& frame) {
+        (void)bus;
+        RxRing& ring = busRing(busIndex);
+        return ring.active && ring.pop(frame);
+    }
+
+    // Up to 8 bytes goes out as classic CAN, longer as FD with bit rate switching
+    inline bool writeFD(FDBus& bus, uint32_t id, const uint8_t* data, uint8_t len, bool extended) {
+        if (len > HAL_CAN_MAX_DLEN) return false;
+        CANFD_message_t msg;
+        msg.id = id;
+        msg.flags.extended = extended;
+        msg.flags.remote = 0;
+        msg.edl = len > 8;
+        msg.brs = len > 8;
+        msg.len = fdPayloadLength(len);
+        memset(msg.buf, 0, sizeof(msg.buf));  // Pad up to the FD payload size
+        memcpy(msg.buf, data, len);
+        return bus.write(msg) > 0;
+    }
+    #endif
 }
 
 inline bool begin(uint32_t baudrate, uint8_t bus = 0, bool listenOnly = false) {
     switch (bus) {
         case 0:
-            detail::initBus(detail::canBus0, baudrate, listenOnly);
+            detail::initBus<0>(detail::canBus0, baudrate, listenOnly);
             return true;
         #if defined(CAN2)
         case 1:
-            detail::initBus(detail::canBus1, baudrate, listenOnly);
+            detail::initBus<1>(detail::canBus1, baudrate, listenOnly);
             return true;
         #endif
-        #if defined(CAN3)
+        #if defined(FLEXCAN_FD_BUS)
+        case FLEXCAN_FD_BUS:
+            detail::initFDBus(detail::canBus2, baudrate, listenOnly);
+            return true;
+        #elif defined(CAN3)
         case 2:
-            detail::initBus(detail::canBus2, baudrate, listenOnly);
+            detail::initBus<2>(detail::canBus2, baudrate, listenOnly);
             return true;
         #endif
         default:
@@ -64,6 +373,11 @@ inline bool begin(uint32_t baudrate, uint8_t bus = 0, bool listenOnly = false) {
 }
 
 inline bool write(uint32_t id, const uint8_t* data, uint8_t len, bool extended, uint8_t bus = 0) {
+    #if defined(FLEXCAN_FD_BUS)
+        if (bus == FLEXCAN_FD_BUS) return detail::writeFD(detail::canBus2, id, data, len, extended);
+    #endif
+    if (len > 8) return false;  // Classic CAN bus
+
     CAN_message_t msg;
     msg.id = id;
     msg.len = len;
@@ -78,7 +392,7 @@ inline bool write(uint32_t id, const uint8_t* data, uint8_t len, bool extended,
         case 1:
             return detail::canBus1.write(msg) > 0;
         #endif
-        #if defined(CAN3)
+        #if defined(CAN3) && !defined(FLEXCAN_FD_BUS)
         case 2:
             return detail::canBus2.write(msg) > 0;
         #endif
@@ -87,65 +401,71 @@ inline bool write(uint32_t id, const uint8_t* data, uint8_t len, bool extended,
     }
 }
 
-inline bool read(uint32_t& id, uint8_t* data, uint8_t& len, bool& extended, uint8_t bus = 0) {
-    CAN_message_t msg;
-    bool result = false;
-
+inline bool readFrame(CanRxFrame& frame, uint8_t bus = 0) {
     switch (bus) {
         case 0:
-            result = detail::canBus0.read(msg);
-            break;
+            return detail::readBus(detail::canBus0, 0, frame);
         #if defined(CAN2)
         case 1:
-            result = detail::canBus1.read(msg);
-            break;
+            return detail::readBus(detail::canBus1, 1, frame);
         #endif
         #if defined(CAN3)
         case 2:
-            result = detail::canBus2.read(msg);
-            break;
+            return detail::readBus(detail::canBus2, 2, frame);
         #endif
         default:
             return false;
     }
-
-    if (result) {
-        id = msg.id;
-        len = msg.len;
-        extended = msg.flags.extended;
-        memcpy(data, msg.buf, msg.len);
-        return true;
-    }
-    return false;
 }
 
-inline void setFilters(uint32_t filter1, uint32_t filter2, uint8_t bus = 0) {
+inline uint32_t getRxOverflows(uint8_t bus = 0) {
+    #if defined(FLEXCAN_FD_BUS)
+        if (bus == FLEXCAN_FD_BUS) return detail::busRing(bus).overflows;
+    #endif
+    #if FLEXCAN_RX_FIFO
+        if (bus > 2) return 0;
+        return detail::busRing(bus).overflows;
+    #else
+        // Polled mailboxes - FlexCAN_T4 doesn't count overwritten frames
+        (void)bus;
+        return 0;
+    #endif
+}
+inline bool setFilterRules(const CanFilterRule* rules, uint8_t count, uint8_t bus = 0) {
     switch (bus) {
         case 0:
-            detail::canBus0.setMBFilter(MB0, filter1);
-            detail::canBus0.setMBFilter(MB1, filter2);
-            detail::canBus0.enableMBInterrupt(MB0);
-            detail::canBus0.enableMBInterrupt(MB1);
-            break;
+            return detail::applyFilterRules(detail::canBus0, rules, count);
         #if defined(CAN2)
         case 1:
-            detail::canBus1.setMBFilter(MB0, filter1);
-            detail::canBus1.setMBFilter(MB1, filter2);
-            detail::canBus1.enableMBInterrupt(MB0);
-            detail::canBus1.enableMBInterrupt(MB1);
-            break;
+            return detail::applyFilterRules(detail::canBus1, rules, count);
         #endif
         #if defined(CAN3)
         case 2:
-            detail::canBus2.setMBFilter(MB0, filter1);
-            detail::canBus2.setMBFilter(MB1, filter2);
-            detail::canBus2.enableMBInterrupt(MB0);
-            detail::canBus2.enableMBInterrupt(MB1);
-            break;
+            return detail::applyFilterRules(detail::canBus2, rules, count);
         #endif
+        default:
+            return false;
     }
 }
 
+// Low power (lib/power_manager): the controller keeps receiving, and its RX
+// interrupt ends the CPU's WFI - no wake pin. Polled buses (FLEXCAN_RX_FIFO=0,
+// no interrupt) don't wake the unit.
+inline uint8_t sleep(uint8_t bus = 0) {
+    (void)bus;
+    return HAL_CAN_NO_WAKE_PIN;
+}
+
+inline bool activity(uint8_t bus = 0) {
+    if (bus > 2) return false;
+    detail::RxRing& ring = detail::busRing(bus);
+    return ring.active && !ring.empty();
+}
+
+inline void wake(uint8_t bus = 0) {
+    (void)bus;  // Never stopped
+}
+
 #ifdef ENABLE_CAN_HYBRID
 } // namespace flexcan
 #endif
@@ -6,7 +6,8 @@
  * Example: ESP32 TWAI on bus 0 + MCP2515 on bus 1 for dual-bus operation.
  *
  * This file is only included when ENABLE_CAN_HYBRID is defined.
- * Routes CAN operations to the appropriate driver based on bus controller type.
+ * Routes CAN operations to the appropriate driver through a bus table
+ * resolved at compile time from the CAN_BUS_x_TYPE flags (see Bus Table).
  *
  * Configuration via platformio.ini:
  *   -D ENABLE_CAN_HYBRID
@@ -56,8 +57,10 @@
     #define HYBRID_HAS_TWAI 0
 #endif
 
-// Check if any bus uses MCP2515 (always included for now since we can't check enum at preprocessor time)
-// In hybrid mode, at least one bus might be MCP2515 if it's not the native controller
+// MCP2515 is on any platform, and the preprocessor can't compare the enum in
+// CAN_BUS_x_TYPE, so its header is always available; the bus table below only
+// calls it for MCP2515 buses, and the driver constructs a controller on first
+// use, so a build without one links none of it
 #define HYBRID_HAS_MCP2515 1
 
 // ============================================================================
@@ -80,120 +83,177 @@
 
 namespace hal { namespace can {
 
+// ============================================================================
+// Bus Table
+// ============================================================================
+// Backend<type> forwards to one controller family's driver. Each bus is
+// Backend<CAN_CONTROLLER_BUS_n>, fixed by the build flags, so a call on a bus
+// goes straight to its driver instead of switching on the controller type per
+// frame. A driver no bus uses is never called, and nothing of it is linked. The
+// primary template is a bus without a controller (NONE, or a type this
+// platform has no driver for).
+
+template<CanControllerType TYPE>
+struct Backend {
+    static constexpr bool present = false;
+    static bool begin(uint8_t, uint32_t, bool) { return false; }
+    static bool write(uint8_t, uint32_t, const uint8_t*, uint8_t, bool) { return false; }
+    static bool readFrame(uint8_t, CanRxFrame&) { return false; }
+    static uint32_t getRxOverflows(uint8_t) { return 0; }
+    static bool setFilterRules(uint8_t, const CanFilterRule*, uint8_t) { return false; }
+    static uint8_t sleep(uint8_t) { return HAL_CAN_NO_WAKE_PIN; }
+    static bool activity(uint8_t) { return false; }
+    static void wake(uint8_t) {}
+};
+
+#if HYBRID_HAS_FLEXCAN
+template<>
+struct Backend<CanControllerType::FLEXCAN> {
+    static constexpr bool present = true;
+    static bool begin(uint8_t bus, uint32_t baudrate, bool listenOnly) { return flexcan::begin(baudrate, bus, listenOnly); }
+    static bool write(uint8_t bus, uint32_t id, const uint8_t* data, uint8_t len, bool extended) { return flexcan::write(id, data, len, extended, bus); }
+    static bool readFrame(uint8_t bus, CanRxFrame& frame) { return flexcan::readFrame(frame, bus); }
+    static uint32_t getRxOverflows(uint8_t bus) { return flexcan::getRxOverflows(bus); }
+    static bool setFilterRules(uint8_t bus, const CanFilterRule* rules, uint8_t count) { return flexcan::setFilterRules(rules, count, bus); }
+    static uint8_t sleep(uint8_t bus) { return flexcan::sleep(bus); }
+    static bool activity(uint8_t bus) { return flexcan::activity(bus); }
+    static void wake(uint8_t bus) { flexcan::wake(bus); }
+};
+#endif
+
+#if HYBRID_HAS_TWAI
+// The one TWAI controller - checked to be bus 0 below
+template<>
+struct Backend<CanControllerType::TWAI> {
+    static constexpr bool present = true;
+    static bool begin(uint8_t, uint32_t baudrate, bool listenOnly) { return twai::begin(baudrate, 0, listenOnly); }
+    static bool write(uint8_t, uint32_t id, const uint8_t* data, uint8_t len, bool extended) { return twai::write(id, data, len, extended, 0); }
+    static bool readFrame(uint8_t, CanRxFrame& frame) { return twai::readFrame(frame, 0); }
+    static uint32_t getRxOverflows(uint8_t) { return twai::getRxOverflows(0); }
+    static bool setFilterRules(uint8_t, const CanFilterRule* rules, uint8_t count) { return twai::setFilterRules(rules, count, 0); }
+    static uint8_t sleep(uint8_t) { return twai::sleep(0); }
+    static bool activity(uint8_t) { return twai::activity(0); }
+    static void wake(uint8_t) { twai::wake(0); }
+};
+#endif
+
+#if HYBRID_HAS_MCP2515
+template<>
+struct Backend<CanControllerType::MCP2515> {
+    static constexpr bool present = true;
+    static bool begin(uint8_t bus, uint32_t baudrate, bool listenOnly) { return mcp2515::begin(baudrate, bus, listenOnly); }
+    static bool write(uint8_t bus, uint32_t id, const uint8_t* data, uint8_t len, bool extended) { return mcp2515::write(id, data, len, extended, bus); }
+    static bool readFrame(uint8_t bus, CanRxFrame& frame) { return mcp2515::readFrame(frame, bus); }
+    static uint32_t getRxOverflows(uint8_t bus) { return mcp2515::getRxOverflows(bus); }
+    static bool setFilterRules(uint8_t bus, const CanFilterRule* rules, uint8_t count) { return mcp2515::setFilterRules(rules, count, bus); }
+    static uint8_t sleep(uint8_t bus) { return mcp2515::sleep(bus); }
+    static bool activity(uint8_t bus) { return mcp2515::activity(bus); }
+    static void wake(uint8_t bus) { mcp2515::wake(bus); }
+};
+#endif
+
+// Controller of a bus, NONE past the buses this build configures
+inline constexpr CanControllerType hybridBusType(uint8_t bus) {
+    return bus < PLATFORM_EFFECTIVE_CAN_BUSES ? getBusControllerType(bus) : CanControllerType::NONE;
+}
+
+typedef Backend<hybridBusType(0)> Bus0;
+typedef Backend<hybridBusType(1)> Bus1;
+typedef Backend<hybridBusType(2)> Bus2;
+typedef Backend<hybridBusType(3)> Bus3;
+
+// A configured bus must have a driver in this build, and TWAI exists once
+static_assert(Bus0::present, "CAN_BUS_0_TYPE has no driver on this platform");
+static_assert(hybridBusType(1) == CanControllerType::NONE || Bus1::present, "CAN_BUS_1_TYPE has no driver on this platform");
+static_assert(hybridBusType(2) == CanControllerType::NONE || Bus2::present, "CAN_BUS_2_TYPE has no driver on this platform");
+static_assert(hybridBusType(3) == CanControllerType::NONE || Bus3::present, "CAN_BUS_3_TYPE has no driver on this platform");
+static_assert(hybridBusType(1) != CanControllerType::TWAI && hybridBusType(2) != CanControllerType::TWAI &&
+              hybridBusType(3) != CanControllerType::TWAI, "TWAI can only be bus 0");
+
 // ============================================================================
 // Hybrid Dispatcher Functions
 // ============================================================================
+// A switch on the bus number, each case a direct (inlined) driver call - a
+// caller passing a constant bus compiles to the driver call alone. Buses past
+// the configured ones are Backend<NONE>.
 
 inline bool begin(uint32_t baudrate, uint8_t bus = 0, bool listenOnly = false) {
-    // Validate bus number is within platform limits
-    if (bus >= PLATFORM_EFFECTIVE_CAN_BUSES) return false;
-
-    CanControllerType ctrl = getBusControllerType(bus);
-
-    switch (ctrl) {
-        #if HYBRID_HAS_FLEXCAN
-        case CanControllerType::FLEXCAN:
-            return flexcan::begin(baudrate, bus, listenOnly);
-        #endif
-
-        #if HYBRID_HAS_TWAI
-        case CanControllerType::TWAI:
-            // TWAI only supports bus 0
-            return (bus == 0) ? twai::begin(baudrate, 0, listenOnly) : false;
-        #endif
-
-        #if HYBRID_HAS_MCP2515
-        case CanControllerType::MCP2515:
-            return mcp2515::begin(baudrate, bus, listenOnly);
-        #endif
-
-        case CanControllerType::NONE:
-        default:
-            return false;
+    switch (bus) {
+        case 0: return Bus0::begin(0, baudrate, listenOnly);
+        case 1: return Bus1::begin(1, baudrate, listenOnly);
+        case 2: return Bus2::begin(2, baudrate, listenOnly);
+        case 3: return Bus3::begin(3, baudrate, listenOnly);
+        default: return false;
     }
 }
 
 inline bool write(uint32_t id, const uint8_t* data, uint8_t len, bool extended, uint8_t bus = 0) {
-    // Validate bus number is within platform limits
-    if (bus >= PLATFORM_EFFECTIVE_CAN_BUSES) return false;
-
-    CanControllerType ctrl = getBusControllerType(bus);
-
-    switch (ctrl) {
-        #if HYBRID_HAS_FLEXCAN
-        case CanControllerType::FLEXCAN:
-            return flexcan::write(id, data, len, extended, bus);
-        #endif
-
-        #if HYBRID_HAS_TWAI
-        case CanControllerType::TWAI:
-            return (bus == 0) ? twai::write(id, data, len, extended, 0) : false;
-        #endif
-
-        #if HYBRID_HAS_MCP2515
-        case CanControllerType::MCP2515:
-            return mcp2515::write(id, data, len, extended, bus);
-        #endif
-
-        case CanControllerType::NONE:
-        default:
-            return false;
+    switch (bus) {
+        case 0: return Bus0::write(0, id, data, len, extended);
+        case 1: return Bus1::write(1, id, data, len, extended);
+        case 2: return Bus2::write(2, id, data, len, extended);
+        case 3: return Bus3::write(3, id, data, len, extended);
+        default: return false;
     }
 }
 
-inline bool read(uint32_t& id, uint8_t* data, uint8_t& len, bool& extended, uint8_t bus = 0) {
-    // Validate bus number is within platform limits
-    if (bus >= PLATFORM_EFFECTIVE_CAN_BUSES) return false;
-
-    CanControllerType ctrl = getBusControllerType(bus);
+inline bool readFrame(CanRxFrame& frame, uint8_t bus = 0) {
+    switch (bus) {
+        case 0: return Bus0::readFrame(0, frame);
+        case 1: return Bus1::readFrame(1, frame);
+        case 2: return Bus2::readFrame(2, frame);
+        case 3: return Bus3::readFrame(3, frame);
+        default: return false;
+    }
+}
 
-    switch (ctrl) {
-        #if HYBRID_HAS_FLEXCAN
-        case CanControllerType::FLEXCAN:
-            return flexcan::read(id, data, len, extended, bus);
-        #endif
+inline uint32_t getRxOverflows(uint8_t bus = 0) {
+    switch (bus) {
+        case 0: return Bus0::getRxOverflows(0);
+        case 1: return Bus1::getRxOverflows(1);
+        case 2: return Bus2::getRxOverflows(2);
+        case 3: return Bus3::getRxOverflows(3);
+        default: return 0;
+    }
+}
 
-        #if HYBRID_HAS_TWAI
-        case CanControllerType::TWAI:
-            return (bus == 0) ? twai::read(id, data, len, extended, 0) : false;
-        #endif
+inline bool setFilterRules(const CanFilterRule* rules, uint8_t count, uint8_t bus = 0) {
+    switch (bus) {
+        case 0: return Bus0::setFilterRules(0, rules, count);
+        case 1: return Bus1::setFilterRules(1, rules, count);
+        case 2: return Bus2::setFilterRules(2, rules, count);
+        case 3: return Bus3::setFilterRules(3, rules, count);
+        default: return false;
+    }
+}
 
-        #if HYBRID_HAS_MCP2515
-        case CanControllerType::MCP2515:
-            return mcp2515::read(id, data, len, extended, bus);
-        #endif
+inline uint8_t sleep(uint8_t bus = 0) {
+    switch (bus) {
+        case 0: return Bus0::sleep(0);
+        case 1: return Bus1::sleep(1);
+        case 2: return Bus2::sleep(2);
+        case 3: return Bus3::sleep(3);
+        default: return HAL_CAN_NO_WAKE_PIN;
+    }
+}
 
-        case CanControllerType::NONE:
-        default:
-            return false;
+inline bool activity(uint8_t bus = 0) {
+    switch (bus) {
+        case 0: return Bus0::activity(0);
+        case 1: return Bus1::activity(1);
+        case 2: return Bus2::activity(2);
+        case 3: return Bus3::activity(3);
+        default: return false;
     }
 }
 
-inline void setFilters(uint32_t filter1, uint32_t filter2, uint8_t bus = 0) {
-    CanControllerType ctrl = getBusControllerType(bus);
-
-    switch (ctrl) {
-        #if HYBRID_HAS_FLEXCAN
-        case CanControllerType::FLEXCAN:
-            flexcan::setFilters(filter1, filter2, bus);
-            break;
-        #endif
-
-        #if HYBRID_HAS_TWAI
-        case CanControllerType::TWAI:
-            if (bus == 0) twai::setFilters(filter1, filter2, 0);
-            break;
-        #endif
-
-        #if HYBRID_HAS_MCP2515
-        case CanControllerType::MCP2515:
-            mcp2515::setFilters(filter1, filter2, bus);
-            break;
-        #endif
-
-        case CanControllerType::NONE:
-        default:
-            break;
+inline void wake(uint8_t bus = 0) {
+    switch (bus) {
+        case 0: Bus0::wake(0); break;
+        case 1: Bus1::wake(1); break;
+        case 2: Bus2::wake(2); break;
+        case 3: Bus3::wake(3); break;
+        default: break;
     }
 }
 
@@ -6,6 +6,24 @@
  * Supports up to 2 MCP2515 controllers for dual CAN bus operation:
  * - Bus 0: CAN_CS_0, CAN_INT_0 (primary)
  * - Bus 1: CAN_CS_1, CAN_INT_1 (secondary)
+ *
+ * Interrupt-driven receive:
+ * The MCP2515 only holds two received frames, so polling from the main loop
+ * drops frames whenever the loop stalls for more than two frame times
+ * (~500us at 500kbps). Where the SPI library can mask the CAN interrupt
+ * during other transactions (SPI.usingInterrupt - AVR, Teensy), a falling
+ * edge on CAN_INT_x runs an ISR that drains the controller into a
+ * single-producer/single-consumer ring (hal_can_frame.h), stamping each
+ * frame with its receive time; readFrame() pops from the ring. Frames lost to
+ * a full ring or a controller overrun are counted (getRxOverflows). Buses
+ * without a usable interrupt pin are polled as before.
+ *
+ * Build Flags:
+ *   -D MCP2515_RX_INTERRUPT=0|1 - Interrupt-driven receive (default 1 on AVR/Teensy)
+ *   -D MCP2515_RX_RING=n        - Frames buffered per bus, power of 2
+ *                                 (default 8 on Uno, 32 elsewhere; 18 bytes each)
+ *   -D MCP2515_SPI_BUS=1|2      - Controllers on SPI1/SPI2 instead of SPI (Teensy;
+ *                                 started by lib/bus_manager, see its SPI arbiter)
  */
 
 #ifndef HAL_CAN_MCP2515_H
@@ -19,6 +37,42 @@
 #endif
 #include <mcp2515.h>
 #include "../../config.h"  // For CAN_CS_x, CAN_INT_x pin definitions
+#include "../hal_can_filter.h"
+#include "../hal_can_frame.h"
+#include "../hal_placement.h"
+#include "../../lib/isr_profile.h"
+
+#ifndef MCP2515_RX_INTERRUPT
+  #if defined(__AVR__) || defined(TEENSYDUINO)
+    #define MCP2515_RX_INTERRUPT 1
+  #else
+    #define MCP2515_RX_INTERRUPT 0   // No SPI.usingInterrupt() - SPI from an ISR would race the main loop,
+                                     // and the mcp2515 library is not in IRAM (hal_placement.h)
+  #endif
+#endif
+
+#ifndef MCP2515_RX_RING
+  #if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
+    #define MCP2515_RX_RING 8
+  #else
+    #define MCP2515_RX_RING 32
+  #endif
+#endif
+
+#if (MCP2515_RX_RING & (MCP2515_RX_RING - 1)) != 0 || MCP2515_RX_RING > 128
+#error "MCP2515_RX_RING must be a power of 2, at most 128"
+#endif
+
+// ISR drain passes before returning (bounds time spent in the ISR)
+#define MCP2515_ISR_MAX_FRAMES 8
+
+// SPI port of the controllers - the library's default is SPI, at 10 MHz
+#if defined(MCP2515_SPI_BUS) && MCP2515_SPI_BUS == 1
+    #define MCP2515_SPI_PORT (&SPI1)
+#elif defined(MCP2515_SPI_BUS) && MCP2515_SPI_BUS == 2
+    #define MCP2515_SPI_PORT (&SPI2)
+#endif
+#define MCP2515_SPI_HZ 10000000
 
 namespace hal { namespace can {
 
@@ -28,21 +82,217 @@ namespace mcp2515 {
 #endif
 
 namespace detail {
-    // Static MCP2515 instances
-    static MCP2515 canBus0(CAN_CS_0);
+    // Receive ring - the ISR writes head, readFrame() writes tail
+    struct RxRing : CanRxRing<MCP2515_RX_RING> {
+        volatile uint16_t controllerOverflows;  // RXB0/RXB1 overruns flagged by the MCP2515
+    };
+
+    inline void toCanFrame(const struct can_frame& raw, uint32_t rxMs, uint64_t rxUs, CanRxFrame& frame) {
+        frame.id = raw.can_id & CAN_EFF_MASK;  // Strip flags to get raw ID
+        frame.extended = (raw.can_id & CAN_EFF_FLAG) != 0;
+        frame.len = raw.can_dlc > 8 ? 8 : raw.can_dlc;
+        frame.fd = false;
+        frame.rxMs = rxMs;
+        frame.rxUs = rxUs;
+        memcpy(frame.data, raw.data, frame.len);
+    }
+
+    // Per-bus state lives in function-local statics of inline functions, so
+    // every translation unit including this header shares one controller
+    // object, one set of flags and one ring per bus (input, output and the RX
+    // pump all talk to the same bus). A controller is constructed on first
+    // use - a hybrid build without an MCP2515 bus links none of the library.
+    struct BusFlags {
+        bool initialized;
+        bool listenOnly;   // Mode to return to after filter changes
+    };
+
+    inline MCP2515& bus0Instance() {
+        #ifdef MCP2515_SPI_PORT
+            static MCP2515 instance(CAN_CS_0, MCP2515_SPI_HZ, MCP2515_SPI_PORT);
+        #else
+            static MCP2515 instance(CAN_CS_0);
+        #endif
+        return instance;
+    }
+    inline BusFlags& busFlags(uint8_t bus) {
+        static BusFlags flags[2];
+        return flags[bus];
+    }
+    inline RxRing& busRing(uint8_t bus) {
+        static RxRing rings[2];
+        return rings[bus];
+    }
+
+    static bool& bus0Initialized = busFlags(0).initialized;
+    static bool& bus0ListenOnly = busFlags(0).listenOnly;
 
     #if defined(CAN_CS_1) && (CAN_CS_1 != 0xFF)
-        static MCP2515 canBus1(CAN_CS_1);
+        inline MCP2515& bus1Instance() {
+            #ifdef MCP2515_SPI_PORT
+                static MCP2515 instance(CAN_CS_1, MCP2515_SPI_HZ, MCP2515_SPI_PORT);
+            #else
+                static MCP2515 instance(CAN_CS_1);
+            #endif
+            return instance;
+        }
         static constexpr bool hasBus1 = true;
     #else
         static constexpr bool hasBus1 = false;
     #endif
+    static bool& bus1Initialized = busFlags(1).initialized;
+    static bool& bus1ListenOnly = busFlags(1).listenOnly;
+
+    #if MCP2515_RX_INTERRUPT
+    static RxRing& rxRing0 = busRing(0);
+    #if defined(CAN_CS_1) && (CAN_CS_1 != 0xFF)
+        static RxRing& rxRing1 = busRing(1);
+    #endif
+
+    /**
+     * Move every pending frame from the controller into the ring
+     * INT stays low while any flag is set, so keep going until it releases
+     * (a missed edge would otherwise stall reception for good).
+     */
+    inline void drainToRing(MCP2515& ctrl, RxRing& ring, uint8_t intPin) {
+        for (uint8_t n = 0; n < MCP2515_ISR_MAX_FRAMES && digitalRead(intPin) == LOW; n++) {
+            struct can_frame raw;
+            if (ctrl.readMessage(&raw) == MCP2515::ERROR_OK) {
+                CanRxFrame* slot = ring.claim();
+                if (slot == nullptr) {
+                    ring.overflows++;  // Ring full - read anyway to clear the interrupt
+                    continue;
+                }
+                toCanFrame(raw, millis(), hal::micros64(), *slot);
+                ring.publish();
+                continue;
+            }
+
+            // No frame pending - error/wake flags are holding INT low
+            uint8_t eflg = ctrl.getErrorFlags();
+            if (eflg & (MCP2515::EFLG_RX0OVR | MCP2515::EFLG_RX1OVR)) {
+                ring.controllerOverflows++;
+                ctrl.clearRXnOVR();
+            }
+            ctrl.clearERRIF();
+            ctrl.clearMERR();
+        }
+    }
+
+    HAL_ISR static void rxISR0() {
+        ISR_PROFILE_BEGIN();
+        drainToRing(bus0Instance(), rxRing0, CAN_INT_0);
+        ISR_PROFILE_END(ISR_PROF_CAN_RX);
+    }
+    #if defined(CAN_CS_1) && (CAN_CS_1 != 0xFF)
+        HAL_ISR static void rxISR1() {
+            ISR_PROFILE_BEGIN();
+            drainToRing(bus1Instance(), rxRing1, CAN_INT_1);
+            ISR_PROFILE_END(ISR_PROF_CAN_RX);
+        }
+    #endif
 
-    // Track initialization state
-    static bool bus0Initialized = false;
-    static bool bus1Initialized = false;
+    /**
+     * Attach the RX interrupt for a bus (after the controller is running)
+     * Returns false if the pin has no interrupt - the bus is then polled.
+     */
+    inline bool attachRxInterrupt(MCP2515& ctrl, RxRing& ring, uint8_t intPin, void (*isr)()) {
+        if (intPin == 0xFF) return false;
+        int irq = digitalPinToInterrupt(intPin);
+        if (irq == NOT_AN_INTERRUPT) return false;
+
+        detachInterrupt(irq);
+        ring.reset();
+        pinMode(intPin, INPUT_PULLUP);
+        #ifdef MCP2515_SPI_PORT
+            MCP2515_SPI_PORT->usingInterrupt(irq);  // Mask INT during every other transaction on its bus
+        #else
+            SPI.usingInterrupt(irq);  // Mask INT during every other SPI transaction
+        #endif
+        attachInterrupt(irq, isr, FALLING);
+        ring.active = true;
+
+        // Frames received before the ISR existed hold INT low - no edge will come
+        noInterrupts();
+        drainToRing(ctrl, ring, intPin);
+        interrupts();
+        return true;
+    }
+
+    inline void detachRxInterrupt(RxRing& ring, uint8_t intPin) {
+        if (!ring.active) return;
+        detachInterrupt(digitalPinToInterrupt(intPin));
+        ring.active = false;
+    }
+    #endif
+
+    inline uint32_t overflowCount(RxRing& ring) {
+        noInterrupts();
+        uint32_t count = (uint32_t)ring.overflows + ring.controllerOverflows;
+        interrupts();
+        return count;
+    }
 
     // Convert baudrate to MCP2515 speed enum
+    // The library has no setter for WAKIE - BIT MODIFY the register directly
+    static constexpr uint8_t REG_CANINTE = 0x2B;
+    static constexpr uint8_t REG_CANINTF = 0x2C;
+    static constexpr uint8_t INT_WAK = 0x40;   // WAKIE / WAKIF
+
+    inline void bitModify(uint8_t cs, uint8_t reg, uint8_t mask, uint8_t data) {
+        #ifdef MCP2515_SPI_PORT
+            SPIClass& port = *MCP2515_SPI_PORT;
+        #else
+            SPIClass& port = SPI;
+        #endif
+        port.beginTransaction(SPISettings(MCP2515_SPI_HZ, MSBFIRST, SPI_MODE0));
+        digitalWrite(cs, LOW);
+        port.transfer(0x05);  // BIT MODIFY
+        port.transfer(reg);
+        port.transfer(mask);
+        port.transfer(data);
+        digitalWrite(cs, HIGH);
+        port.endTransaction();
+    }
+
+    /**
+     * Sleep mode, waking on bus activity: the first edge on RXCAN sets WAKIF
+     * and pulls INT low. The frame that wakes it is lost while the oscillator
+     * starts; the controller comes back in listen-only mode until wake().
+     */
+    inline uint8_t sleepController(MCP2515& ctrl, const BusFlags& flags, uint8_t cs, uint8_t intPin) {
+        if (!flags.initialized) return HAL_CAN_NO_WAKE_PIN;
+        bitModify(cs, REG_CANINTF, INT_WAK, 0);
+        bitModify(cs, REG_CANINTE, INT_WAK, INT_WAK);
+        ctrl.setSleepMode();
+        return intPin;
+    }
+
+    inline bool controllerActivity(MCP2515& ctrl, const BusFlags& flags, uint8_t intPin) {
+        if (!flags.initialized) return false;
+        if (intPin != 0xFF) return digitalRead(intPin) == LOW;
+        return (ctrl.getInterrupts() & MCP2515::CANINTF_WAKIF) != 0;  // No INT pin - ask over SPI
+    }
+
+    inline void wakeController(MCP2515& ctrl, const BusFlags& flags, RxRing& ring,
+                               uint8_t cs, uint8_t intPin) {
+        if (!flags.initialized) return;
+        if (flags.listenOnly) ctrl.setListenOnlyMode();
+        else ctrl.setNormalMode();
+        bitModify(cs, REG_CANINTE, INT_WAK, 0);
+        bitModify(cs, REG_CANINTF, INT_WAK, 0);  // Releases INT
+        #if MCP2515_RX_INTERRUPT
+            // Frames taken while WAKIF held INT low came with no edge
+            if (ring.active) {
+                noInterrupts();
+                drainToRing(ctrl, ring, intPin);
+                interrupts();
+            }
+        #else
+            (void)ring; (void)intPin;
+        #endif
+    }
+
     inline CAN_SPEED baudrateToSpeed(uint32_t baudrate) {
         switch (baudrate) {
             case 1000000: return CAN_1000KBPS;
@@ -72,6 +322,97 @@ namespace detail {
             return MCP_8MHZ;
         #endif
     }
+
+    inline bool setFilterPair(MCP2515& ctrl, MCP2515::RXF num, const CanFilterRule& rule) {
+        return ctrl.setFilter(num, rule.extended, rule.id) == MCP2515::ERROR_OK;
+    }
+
+    /**
+     * Program masks and filters from a rule list
+     * RXB0 gets mask 0 and filters 0-1, RXB1 mask 1 and filters 2-5. A mask
+     * only serves one frame format (for standard frames the extended mask bits
+     * would compare data bytes), so when both formats are present the smaller
+     * group goes to RXB0 and the larger to RXB1.
+     */
+    inline bool applyFilterRules(MCP2515& ctrl, bool listenOnly,
+                                 const CanFilterRule* rules, uint8_t count) {
+        CanFilterRule work[HAL_CAN_MAX_FILTER_RULES];
+        bool exact = filter::normalize(rules, count, work);
+        if (!exact) count = 0;
+
+        // Partition standard rules ahead of extended ones
+        uint8_t numStd = 0;
+        for (uint8_t i = 0; i < count; i++) {
+            if (!work[i].extended) {
+                CanFilterRule tmp = work[numStd];
+                work[numStd++] = work[i];
+                work[i] = tmp;
+            }
+        }
+        uint8_t numExt = count - numStd;
+
+        // Group 0 -> RXB0 (2 filters), group 1 -> RXB1 (4 filters)
+        CanFilterRule* group[2];
+        uint8_t groupSize[2];
+        if (numStd > 0 && numExt > 0) {
+            bool stdLarger = numStd >= numExt;
+            group[0] = stdLarger ? &work[numStd] : &work[0];
+            groupSize[0] = filter::merge(group[0], stdLarger ? numExt : numStd, 2, &exact);
+            group[1] = stdLarger ? &work[0] : &work[numStd];
+            groupSize[1] = filter::merge(group[1], stdLarger ? numStd : numExt, 4, &exact);
+        } else {
+            count = filter::merge(work, count, 6, &exact);
+            group[0] = &work[0];
+            groupSize[0] = count < 2 ? count : 2;
+            group[1] = &work[groupSize[0]];
+            groupSize[1] = count - groupSize[0];
+        }
+
+        if (ctrl.setConfigMode() != MCP2515::ERROR_OK) return false;
+
+        bool ok = true;
+        if (count == 0) {
+            // Accept all - masks open, one filter of each format per buffer
+            static const CanFilterRule anyStd = { 0, 0, false };
+            static const CanFilterRule anyExt = { 0, 0, true };
+            ok &= ctrl.setFilterMask(MCP2515::MASK0, false, 0) == MCP2515::ERROR_OK;
+            ok &= ctrl.setFilterMask(MCP2515::MASK1, false, 0) == MCP2515::ERROR_OK;
+            ok &= setFilterPair(ctrl, MCP2515::RXF0, anyStd);
+            ok &= setFilterPair(ctrl, MCP2515::RXF1, anyExt);
+            ok &= setFilterPair(ctrl, MCP2515::RXF2, anyStd);
+            ok &= setFilterPair(ctrl, MCP2515::RXF3, anyExt);
+            ok &= setFilterPair(ctrl, MCP2515::RXF4, anyStd);
+            ok &= setFilterPair(ctrl, MCP2515::RXF5, anyExt);
+        } else {
+            // An empty group repeats the other group, so it accepts nothing extra
+            if (groupSize[0] == 0) { group[0] = group[1]; groupSize[0] = groupSize[1]; }
+            if (groupSize[1] == 0) { group[1] = group[0]; groupSize[1] = groupSize[0]; }
+
+            static const MCP2515::RXF filters0[2] = { MCP2515::RXF0, MCP2515::RXF1 };
+            static const MCP2515::RXF filters1[4] = { MCP2515::RXF2, MCP2515::RXF3, MCP2515::RXF4, MCP2515::RXF5 };
+            const MCP2515::RXF* filters[2] = { filters0, filters1 };
+            const MCP2515::MASK masks[2] = { MCP2515::MASK0, MCP2515::MASK1 };
+            const uint8_t slots[2] = { 2, 4 };
+
+            for (uint8_t g = 0; g < 2; g++) {
+                // One mask per buffer - the bits every rule in the group compares
+                uint32_t mask = group[g][0].mask;
+                for (uint8_t i = 1; i < groupSize[g]; i++) {
+                    if (group[g][i].mask != mask) exact = false;
+                    mask &= group[g][i].mask;
+                }
+                ok &= ctrl.setFilterMask(masks[g], group[g][0].extended, mask) == MCP2515::ERROR_OK;
+                for (uint8_t f = 0; f < slots[g]; f++) {
+                    // Spare filters repeat the first rule
+                    const CanFilterRule& rule = group[g][f < groupSize[g] ? f : 0];
+                    ok &= setFilterPair(ctrl, filters[g][f], rule);
+                }
+            }
+        }
+
+        MCP2515::ERROR mode = listenOnly ? ctrl.setListenOnlyMode() : ctrl.setNormalMode();
+        return ok && mode == MCP2515::ERROR_OK && exact;
+    }
 }
 
 inline bool begin(uint32_t baudrate, uint8_t bus = 0, bool listenOnly = false) {
@@ -80,30 +421,44 @@ inline bool begin(uint32_t baudrate, uint8_t bus = 0, bool listenOnly = false) {
 
     switch (bus) {
         case 0:
-            detail::canBus0.reset();
-            if (detail::canBus0.setBitrate(speed, clock) != MCP2515::ERROR_OK) {
+            #if MCP2515_RX_INTERRUPT
+                detail::detachRxInterrupt(detail::rxRing0, CAN_INT_0);
+            #endif
+            detail::bus0Instance().reset();
+            if (detail::bus0Instance().setBitrate(speed, clock) != MCP2515::ERROR_OK) {
                 return false;
             }
             if (listenOnly) {
-                if (detail::canBus0.setListenOnlyMode() != MCP2515::ERROR_OK) return false;
+                if (detail::bus0Instance().setListenOnlyMode() != MCP2515::ERROR_OK) return false;
             } else {
-                if (detail::canBus0.setNormalMode() != MCP2515::ERROR_OK) return false;
+                if (detail::bus0Instance().setNormalMode() != MCP2515::ERROR_OK) return false;
             }
             detail::bus0Initialized = true;
+            detail::bus0ListenOnly = listenOnly;
+            #if MCP2515_RX_INTERRUPT
+                detail::attachRxInterrupt(detail::bus0Instance(), detail::rxRing0, CAN_INT_0, detail::rxISR0);
+            #endif
             return true;
 
         case 1:
             #if defined(CAN_CS_1) && (CAN_CS_1 != 0xFF)
-                detail::canBus1.reset();
-                if (detail::canBus1.setBitrate(speed, clock) != MCP2515::ERROR_OK) {
+                #if MCP2515_RX_INTERRUPT
+                    detail::detachRxInterrupt(detail::rxRing1, CAN_INT_1);
+                #endif
+                detail::bus1Instance().reset();
+                if (detail::bus1Instance().setBitrate(speed, clock) != MCP2515::ERROR_OK) {
                     return false;
                 }
                 if (listenOnly) {
-                    if (detail::canBus1.setListenOnlyMode() != MCP2515::ERROR_OK) return false;
+                    if (detail::bus1Instance().setListenOnlyMode() != MCP2515::ERROR_OK) return false;
                 } else {
-                    if (detail::canBus1.setNormalMode() != MCP2515::ERROR_OK) return false;
+                    if (detail::bus1Instance().setNormalMode() != MCP2515::ERROR_OK) return false;
                 }
                 detail::bus1Initialized = true;
+                detail::bus1ListenOnly = listenOnly;
+                #if MCP2515_RX_INTERRUPT
+                    detail::attachRxInterrupt(detail::bus1Instance(), detail::rxRing1, CAN_INT_1, detail::rxISR1);
+                #endif
                 return true;
             #else
                 return false;  // Bus 1 not configured
@@ -115,6 +470,8 @@ inline bool begin(uint32_t baudrate, uint8_t bus = 0, bool listenOnly = false) {
 }
 
 inline bool write(uint32_t id, const uint8_t* data, uint8_t len, bool extended, uint8_t bus = 0) {
+    if (len > 8) return false;  // Classic CAN only
+
     struct can_frame frame;
     frame.can_id = id;
     if (extended) {
@@ -126,12 +483,12 @@ inline bool write(uint32_t id, const uint8_t* data, uint8_t len, bool extended,
     switch (bus) {
         case 0:
             if (!detail::bus0Initialized) return false;
-            return detail::canBus0.sendMessage(&frame) == MCP2515::ERROR_OK;
+            return detail::bus0Instance().sendMessage(&frame) == MCP2515::ERROR_OK;
 
         case 1:
             #if defined(CAN_CS_1) && (CAN_CS_1 != 0xFF)
                 if (!detail::bus1Initialized) return false;
-                return detail::canBus1.sendMessage(&frame) == MCP2515::ERROR_OK;
+                return detail::bus1Instance().sendMessage(&frame) == MCP2515::ERROR_OK;
             #else
                 return false;
             #endif
@@ -141,20 +498,25 @@ inline bool write(uint32_t id, const uint8_t* data, uint8_t len, bool extended,
     }
 }
 
-inline bool read(uint32_t& id, uint8_t* data, uint8_t& len, bool& extended, uint8_t bus = 0) {
-    struct can_frame frame;
-    MCP2515::ERROR result;
+inline bool readFrame(CanRxFrame& frame, uint8_t bus = 0) {
+    struct can_frame raw;
 
     switch (bus) {
         case 0:
             if (!detail::bus0Initialized) return false;
-            result = detail::canBus0.readMessage(&frame);
+            #if MCP2515_RX_INTERRUPT
+                if (detail::rxRing0.active) return detail::rxRing0.pop(frame);
+            #endif
+            if (detail::bus0Instance().readMessage(&raw) != MCP2515::ERROR_OK) return false;
             break;
 
         case 1:
             #if defined(CAN_CS_1) && (CAN_CS_1 != 0xFF)
                 if (!detail::bus1Initialized) return false;
-                result = detail::canBus1.readMessage(&frame);
+                #if MCP2515_RX_INTERRUPT
+                    if (detail::rxRing1.active) return detail::rxRing1.pop(frame);
+                #endif
+                if (detail::bus1Instance().readMessage(&raw) != MCP2515::ERROR_OK) return false;
                 break;
             #else
                 return false;
@@ -164,23 +526,89 @@ inline bool read(uint32_t& id, uint8_t* data, uint8_t& len, bool& extended, uint
             return false;
     }
 
-    if (result == MCP2515::ERROR_OK) {
-        id = frame.can_id & CAN_EFF_MASK;  // Strip flags to get raw ID
-        extended = (frame.can_id & CAN_EFF_FLAG) != 0;
-        len = frame.can_dlc;
-        memcpy(data, frame.data, frame.can_dlc);
-        return true;
+    detail::toCanFrame(raw, millis(), hal::micros64(), frame);
+    return true;
+}
+
+inline uint32_t getRxOverflows(uint8_t bus = 0) {
+    #if MCP2515_RX_INTERRUPT
+        switch (bus) {
+            case 0:
+                return detail::overflowCount(detail::rxRing0);
+            #if defined(CAN_CS_1) && (CAN_CS_1 != 0xFF)
+            case 1:
+                return detail::overflowCount(detail::rxRing1);
+            #endif
+            default:
+                return 0;
+        }
+    #else
+        (void)bus;
+        return 0;  // Polled - overruns aren't tracked
+    #endif
+}
+
+inline bool setFilterRules(const CanFilterRule* rules, uint8_t count, uint8_t bus = 0) {
+    switch (bus) {
+        case 0:
+            if (!detail::bus0Initialized) return false;
+            return detail::applyFilterRules(detail::bus0Instance(), detail::bus0ListenOnly, rules, count);
+
+        case 1:
+            #if defined(CAN_CS_1) && (CAN_CS_1 != 0xFF)
+                if (!detail::bus1Initialized) return false;
+                return detail::applyFilterRules(detail::bus1Instance(), detail::bus1ListenOnly, rules, count);
+            #else
+                return false;
+            #endif
+
+        default:
+            return false;
+    }
+}
+
+// Low power (lib/power_manager): Sleep mode with wake-on-activity
+// Returns the INT pin to wake on (LOW), HAL_CAN_NO_WAKE_PIN if the bus has none
+// or isn't running - activity() then polls WAKIF.
+inline uint8_t sleep(uint8_t bus = 0) {
+    switch (bus) {
+        case 0:
+            return detail::sleepController(detail::bus0Instance(), detail::busFlags(0), CAN_CS_0, CAN_INT_0);
+        #if defined(CAN_CS_1) && (CAN_CS_1 != 0xFF)
+        case 1:
+            return detail::sleepController(detail::bus1Instance(), detail::busFlags(1), CAN_CS_1, CAN_INT_1);
+        #endif
+        default:
+            return HAL_CAN_NO_WAKE_PIN;
+    }
+}
+
+inline bool activity(uint8_t bus = 0) {
+    switch (bus) {
+        case 0:
+            return detail::controllerActivity(detail::bus0Instance(), detail::busFlags(0), CAN_INT_0);
+        #if defined(CAN_CS_1) && (CAN_CS_1 != 0xFF)
+        case 1:
+            return detail::controllerActivity(detail::bus1Instance(), detail::busFlags(1), CAN_INT_1);
+        #endif
+        default:
+            return false;
     }
-    return false;
 }
 
-inline void setFilters(uint32_t filter1, uint32_t filter2, uint8_t bus = 0) {
-    // MCP2515 has complex filter configuration
-    // For simplicity, we'll accept all frames and do software filtering
-    // Full hardware filter support could be added later if needed
-    (void)filter1;
-    (void)filter2;
-    (void)bus;
+inline void wake(uint8_t bus = 0) {
+    switch (bus) {
+        case 0:
+            detail::wakeController(detail::bus0Instance(), detail::busFlags(0), detail::busRing(0), CAN_CS_0, CAN_INT_0);
+            break;
+        #if defined(CAN_CS_1) && (CAN_CS_1 != 0xFF)
+        case 1:
+            detail::wakeController(detail::bus1Instance(), detail::busFlags(1), detail::busRing(1), CAN_CS_1, CAN_INT_1);
+            break;
+        #endif
+        default:
+            break;
+    }
 }
 
 #ifdef ENABLE_CAN_HYBRID
@@ -0,0 +1,232 @@
+/*
+ * can_socketcan.h - Linux SocketCAN driver for the host simulator
+ * Part of the preOBD Hardware Abstraction Layer
+ *
+ * Bus n is the nth interface given to the simulator (--can vcan0,vcan1), so
+ * the firmware shares a bus with candump, cansend or a second simulator:
+ *
+ *   sudo ip link add dev vcan0 type vcan && sudo ip link set up vcan0
+ *
+ * The bitrate is the interface's (ip link ... bitrate on real adapters);
+ * begin() ignores it. Listen-only just refuses writes - a vcan has no ACKs
+ * to suppress. Acceptance filters go to the kernel (CAN_RAW_FILTER), which
+ * takes every rule as given, so filtering is always exact. Receive overruns
+ * are the socket's drop count (SO_RXQ_OVFL).
+ *
+ * Not Linux: every bus fails to start, as if no interface was given.
+ */
+
+#ifndef HAL_CAN_SOCKETCAN_H
+#define HAL_CAN_SOCKETCAN_H
+
+#include <Arduino.h>
+#include <sim.h>
+#include "../hal_can_filter.h"
+#include "../hal_can_frame.h"
+
+#if defined(__linux__)
+    #include <fcntl.h>
+    #include <net/if.h>
+    #include <sys/ioctl.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+    #include <linux/can.h>
+    #include <linux/can/raw.h>
+    #define SOCKETCAN_AVAILABLE 1
+#else
+    #define SOCKETCAN_AVAILABLE 0
+#endif
+
+namespace hal { namespace can {
+
+namespace detail {
+    // Per-bus state lives in a function-local static of an inline function,
+    // shared by every translation unit
+    struct SocketBus {
+        int fd;
+        bool listenOnly;
+        uint32_t overflows;     // Kernel drop count at the last receive
+    };
+
+    inline SocketBus& socketBus(uint8_t bus) {
+        static SocketBus buses[SIM_MAX_CAN_BUSES] = {};
+        static bool initialized = false;
+        if (!initialized) {
+            for (uint8_t i = 0; i < SIM_MAX_CAN_BUSES; i++) buses[i].fd = -1;
+            initialized = true;
+        }
+        return buses[bus];
+    }
+
+#if SOCKETCAN_AVAILABLE
+    inline int openSocket(const char* interfaceName) {
+        int fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+        if (fd < 0) return -1;
+
+        struct ifreq ifr;
+        memset(&ifr, 0, sizeof(ifr));
+        strncpy(ifr.ifr_name, interfaceName, IFNAMSIZ - 1);
+        struct sockaddr_can addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.can_family = AF_CAN;
+        if (ioctl(fd, SIOCGIFINDEX, &ifr) < 0) {
+            close(fd);
+            return -1;
+        }
+        addr.can_ifindex = ifr.ifr_ifindex;
+        if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+            close(fd);
+            return -1;
+        }
+
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on));
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        return fd;
+    }
+#endif
+} // namespace detail
+
+inline bool begin(uint32_t baudrate, uint8_t bus = 0, bool listenOnly = false) {
+    (void)baudrate;
+    if (bus >= SIM_MAX_CAN_BUSES) return false;
+    const char* interfaceName = sim::canInterface(bus);
+    if (!interfaceName) return false;   // Bus not connected (no --can for it)
+
+#if SOCKETCAN_AVAILABLE
+    detail::SocketBus& b = detail::socketBus(bus);
+    if (b.fd >= 0) close(b.fd);
+    b.fd = detail::openSocket(interfaceName);
+    b.listenOnly = listenOnly;
+    b.overflows = 0;
+    if (b.fd < 0) {
+        fprintf(stderr, "sim: CAN bus %d: cannot open %s\n", bus, interfaceName);
+        return false;
+    }
+    return true;
+#else
+    (void)listenOnly;
+    return false;
+#endif
+}
+
+inline bool write(uint32_t id, const uint8_t* data, uint8_t len, bool extended, uint8_t bus = 0) {
+#if SOCKETCAN_AVAILABLE
+    if (bus >= SIM_MAX_CAN_BUSES || len > 8) return false;
+    detail::SocketBus& b = detail::socketBus(bus);
+    if (b.fd < 0 || b.listenOnly) return false;
+
+    struct can_frame raw;
+    memset(&raw, 0, sizeof(raw));
+    raw.can_id = extended ? ((id & CAN_EFF_MASK) | CAN_EFF_FLAG) : (id & CAN_SFF_MASK);
+    raw.can_dlc = len;
+    memcpy(raw.data, data, len);
+    return ::write(b.fd, &raw, sizeof(raw)) == (ssize_t)sizeof(raw);   // EAGAIN: TX queue full
+#else
+    (void)id; (void)data; (void)len; (void)extended; (void)bus;
+    return false;
+#endif
+}
+
+inline bool readFrame(CanRxFrame& frame, uint8_t bus = 0) {
+#if SOCKETCAN_AVAILABLE
+    if (bus >= SIM_MAX_CAN_BUSES) return false;
+    detail::SocketBus& b = detail::socketBus(bus);
+    if (b.fd < 0) return false;
+
+    struct can_frame raw;
+    char control[CMSG_SPACE(sizeof(uint32_t))];
+    struct iovec iov = { &raw, sizeof(raw) };
+    struct msghdr msgHeader;
+
+    while (true) {
+        memset(&msgHeader, 0, sizeof(msgHeader));
+        msgHeader.msg_iov = &iov;
+        msgHeader.msg_iovlen = 1;
+        msgHeader.msg_control = control;
+        msgHeader.msg_controllen = sizeof(control);
+
+        ssize_t n = recvmsg(b.fd, &msgHeader, MSG_DONTWAIT);
+        if (n < (ssize_t)sizeof(raw)) return false;   // Nothing waiting
+
+        for (struct cmsghdr* c = CMSG_FIRSTHDR(&msgHeader); c; c = CMSG_NXTHDR(&msgHeader, c)) {
+            if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SO_RXQ_OVFL) {
+                memcpy(&b.overflows, CMSG_DATA(c), sizeof(uint32_t));
+            }
+        }
+        if (raw.can_id & (CAN_RTR_FLAG | CAN_ERR_FLAG)) continue;   // Data frames only
+        break;
+    }
+
+    frame.extended = (raw.can_id & CAN_EFF_FLAG) != 0;
+    frame.id = raw.can_id & (frame.extended ? CAN_EFF_MASK : CAN_SFF_MASK);
+    frame.len = raw.can_dlc > 8 ? 8 : raw.can_dlc;
+    frame.fd = false;
+    frame.rxMs = millis();
+    frame.rxUs = hal::micros64();
+    memcpy(frame.data, raw.data, frame.len);
+    return true;
+#else
+    (void)frame; (void)bus;
+    return false;
+#endif
+}
+
+inline uint32_t getRxOverflows(uint8_t bus = 0) {
+    if (bus >= SIM_MAX_CAN_BUSES) return 0;
+    return detail::socketBus(bus).overflows;
+}
+
+inline bool setFilterRules(const CanFilterRule* rules, uint8_t count, uint8_t bus = 0) {
+#if SOCKETCAN_AVAILABLE
+    if (bus >= SIM_MAX_CAN_BUSES) return false;
+    detail::SocketBus& b = detail::socketBus(bus);
+    if (b.fd < 0) return false;
+
+    CanFilterRule work[HAL_CAN_MAX_FILTER_RULES];
+    struct can_filter filters[HAL_CAN_MAX_FILTER_RULES];
+    if (count == 0 || !filter::normalize(rules, count, work)) {
+        struct can_filter all = { 0, 0 };
+        setsockopt(b.fd, SOL_CAN_RAW, CAN_RAW_FILTER, &all, sizeof(all));
+        return count == 0;   // Too many rules: accept all, caller keeps its filter
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        // EFF flag in the mask: the rule matches its own frame format only
+        filters[i].can_id = work[i].id | (work[i].extended ? CAN_EFF_FLAG : 0);
+        filters[i].can_mask = work[i].mask | CAN_EFF_FLAG | CAN_RTR_FLAG;
+    }
+    return setsockopt(b.fd, SOL_CAN_RAW, CAN_RAW_FILTER, filters,
+                      count * sizeof(struct can_filter)) == 0;
+#else
+    (void)rules; (void)count; (void)bus;
+    return false;
+#endif
+}
+
+// Low power (lib/power_manager): the socket keeps queuing - no wake pin, and
+// activity() peeks at whether a frame is waiting
+inline uint8_t sleep(uint8_t bus = 0) {
+    (void)bus;
+    return HAL_CAN_NO_WAKE_PIN;
+}
+
+inline bool activity(uint8_t bus = 0) {
+#if SOCKETCAN_AVAILABLE
+    if (bus >= SIM_MAX_CAN_BUSES) return false;
+    detail::SocketBus& b = detail::socketBus(bus);
+    if (b.fd < 0) return false;
+    struct can_frame raw;
+    return recv(b.fd, &raw, sizeof(raw), MSG_PEEK | MSG_DONTWAIT) > 0;
+#else
+    (void)bus;
+    return false;
+#endif
+}
+
+inline void wake(uint8_t bus = 0) {
+    (void)bus;  // Never stopped
+}
+
+}} // namespace hal::can
+
+#endif // HAL_CAN_SOCKETCAN_H
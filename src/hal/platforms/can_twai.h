@@ -9,7 +9,10 @@
 #ifndef HAL_CAN_TWAI_H
 #define HAL_CAN_TWAI_H
 
+#include <Arduino.h>
 #include <ESP32-TWAI-CAN.hpp>
+#include "../hal_can_filter.h"
+#include "../hal_can_frame.h"
 
 namespace hal { namespace can {
 
@@ -18,49 +21,122 @@ namespace hal { namespace can {
 namespace twai {
 #endif
 
-inline bool begin(uint32_t baudrate, uint8_t bus = 0, bool listenOnly = false) {
-    // ESP32 only supports a single CAN bus
-    if (bus != 0) return false;
+namespace detail {
+    // Acceptance filters are fixed at driver install - kept so
+    // setFilterRules() can reinstall with the same settings. Shared by every
+    // translation unit (function-local static of an inline function).
+    struct DriverState {
+        uint32_t baudrate;
+        bool listenOnly;
+        bool initialized;
+    };
+
+    inline DriverState& driverState() {
+        static DriverState state;
+        return state;
+    }
 
-    // Select pins based on ESP32 variant
-    int8_t txPin, rxPin;
+    static uint32_t& baudrate = driverState().baudrate;
+    static bool& listenOnly = driverState().listenOnly;
+    static bool& initialized = driverState().initialized;
+
+    /**
+     * Encode up to two rules as a TWAI acceptance filter
+     * Code/mask bit layout follows the SJA1000 (mask bit 1 = don't care):
+     *   Single mode, std: ID[10:0] in bits 31:21
+     *   Single mode, ext: ID[28:0] in bits 31:3
+     *   Dual mode,   std: ID[10:0] in bits 15:5 of each 16-bit half
+     *   Dual mode,   ext: ID[28:13] in each 16-bit half (low ID bits not compared)
+     * Dual mode applies both halves to every frame whatever its format, so
+     * mixed-format pairs and extended pairs are approximate.
+     */
+    inline void encodeFilter(const CanFilterRule* rules, uint8_t count,
+                             twai_filter_config_t* f_config, bool* exact) {
+        if (count == 1) {
+            const CanFilterRule& r = rules[0];
+            uint8_t shift = r.extended ? 3 : 21;
+            f_config->acceptance_code = r.id << shift;
+            f_config->acceptance_mask = ~(r.mask << shift);
+            f_config->single_filter = true;
+            return;
+        }
+
+        // Extended rule in the first half when mixed - a standard rule there
+        // would also compare bits 3:0 (its data byte) against the second half
+        uint8_t first = (rules[1].extended && !rules[0].extended) ? 1 : 0;
+
+        uint32_t code = 0, mask = 0;
+        for (uint8_t i = 0; i < 2; i++) {
+            const CanFilterRule& r = rules[i == 0 ? first : 1 - first];
+            uint16_t halfCode, halfMask;
+            if (r.extended) {
+                halfCode = (uint16_t)(r.id >> 13);
+                halfMask = (uint16_t)~(r.mask >> 13);
+                if ((r.mask & 0x1FFF) != 0) *exact = false;
+            } else {
+                halfCode = (uint16_t)(r.id << 5);
+                halfMask = (uint16_t)~(r.mask << 5);
+            }
+            code |= (uint32_t)halfCode << (i == 0 ? 16 : 0);
+            mask |= (uint32_t)halfMask << (i == 0 ? 16 : 0);
+        }
+        if (rules[0].extended != rules[1].extended) *exact = false;
+        f_config->acceptance_code = code;
+        f_config->acceptance_mask = mask;
+        f_config->single_filter = false;
+    }
+
+    // Pins for this ESP32 variant
     #if defined(CONFIG_IDF_TARGET_ESP32S3) || defined(CONFIG_IDF_TARGET_ESP32C3)
-        txPin = GPIO_NUM_20; rxPin = GPIO_NUM_21;
+        static constexpr int8_t txPin = GPIO_NUM_20, rxPin = GPIO_NUM_21;
     #else
-        txPin = GPIO_NUM_21; rxPin = GPIO_NUM_22;
+        static constexpr int8_t txPin = GPIO_NUM_21, rxPin = GPIO_NUM_22;
     #endif
-    ESP32Can.setPins(txPin, rxPin);
-
-    // Convert baudrate to TWAI speed setting (library expects kbps)
-    TwaiSpeed speed = ESP32Can.convertSpeed(baudrate / 1000);
-    ESP32Can.setSpeed(speed);
-
-    if (listenOnly) {
-        // Pass custom general config with listen-only mode to begin()
-        // No ACK bits, no error frames, no TX of any kind
-        twai_general_config_t g_config = {
-            .mode           = TWAI_MODE_LISTEN_ONLY,
-            .tx_io          = (gpio_num_t)txPin,
-            .rx_io          = (gpio_num_t)rxPin,
-            .clkout_io      = TWAI_IO_UNUSED,
-            .bus_off_io     = TWAI_IO_UNUSED,
-            .tx_queue_len   = 0,        // No TX in listen-only
-            .rx_queue_len   = 5,
-            .alerts_enabled = TWAI_ALERT_NONE,
-            .clkout_divider = 0,
-            .intr_flags     = ESP_INTR_FLAG_LEVEL1
-        };
-        return ESP32Can.begin(speed, -1, -1, 0xFFFF, 0xFFFF,
-                              nullptr, &g_config, nullptr);
-    }
 
-    return ESP32Can.begin();
+    inline bool install(twai_filter_config_t* f_config) {
+        ESP32Can.setPins(txPin, rxPin);
+
+        // Convert baudrate to TWAI speed setting (library expects kbps)
+        TwaiSpeed speed = ESP32Can.convertSpeed(baudrate / 1000);
+        ESP32Can.setSpeed(speed);
+
+        if (listenOnly) {
+            // Pass custom general config with listen-only mode to begin()
+            // No ACK bits, no error frames, no TX of any kind
+            twai_general_config_t g_config = {
+                .mode           = TWAI_MODE_LISTEN_ONLY,
+                .tx_io          = (gpio_num_t)txPin,
+                .rx_io          = (gpio_num_t)rxPin,
+                .clkout_io      = TWAI_IO_UNUSED,
+                .bus_off_io     = TWAI_IO_UNUSED,
+                .tx_queue_len   = 0,        // No TX in listen-only
+                .rx_queue_len   = 5,
+                .alerts_enabled = TWAI_ALERT_NONE,
+                .clkout_divider = 0,
+                .intr_flags     = ESP_INTR_FLAG_LEVEL1
+            };
+            return ESP32Can.begin(speed, -1, -1, 0xFFFF, 0xFFFF,
+                                  f_config, &g_config, nullptr);
+        }
+
+        return ESP32Can.begin(speed, -1, -1, 0xFFFF, 0xFFFF, f_config);
+    }
 }
 
-inline bool write(uint32_t id, const uint8_t* data, uint8_t len, bool extended, uint8_t bus = 0) {
+inline bool begin(uint32_t baudrate, uint8_t bus = 0, bool listenOnly = false) {
     // ESP32 only supports a single CAN bus
     if (bus != 0) return false;
 
+    detail::baudrate = baudrate;
+    detail::listenOnly = listenOnly;
+    detail::initialized = detail::install(nullptr);  // Accept all until filters are set
+    return detail::initialized;
+}
+
+inline bool write(uint32_t id, const uint8_t* data, uint8_t len, bool extended, uint8_t bus = 0) {
+    // ESP32 only supports a single CAN bus; TWAI is classic CAN only
+    if (bus != 0 || len > 8) return false;
+
     CanFrame frame;
     frame.identifier = id;
     frame.extd = extended ? 1 : 0;
@@ -69,29 +145,69 @@ inline bool write(uint32_t id, const uint8_t* data, uint8_t len, bool extended,
     return ESP32Can.writeFrame(frame);
 }
 
-inline bool read(uint32_t& id, uint8_t* data, uint8_t& len, bool& extended, uint8_t bus = 0) {
+inline bool readFrame(CanRxFrame& frame, uint8_t bus = 0) {
     // ESP32 only supports a single CAN bus
     if (bus != 0) return false;
 
-    CanFrame frame;
-    if (ESP32Can.readFrame(frame, 0)) {  // Non-blocking read
-        id = frame.identifier;
-        len = frame.data_length_code;
-        extended = frame.extd;
-        memcpy(data, frame.data, frame.data_length_code);
+    // Driver queue carries no receive time - stamp on the way out
+    ::CanFrame raw;
+    if (ESP32Can.readFrame(raw, 0)) {  // Non-blocking read
+        frame.id = raw.identifier;
+        frame.len = raw.data_length_code > 8 ? 8 : raw.data_length_code;
+        frame.extended = raw.extd;
+        frame.fd = false;
+        frame.rxMs = millis();
+        frame.rxUs = hal::micros64();
+        memcpy(frame.data, raw.data, frame.len);
         return true;
     }
     return false;
 }
 
-inline void setFilters(uint32_t filter1, uint32_t filter2, uint8_t bus = 0) {
+inline uint32_t getRxOverflows(uint8_t bus = 0) {
+    if (bus != 0 || !detail::initialized) return 0;
+
+    // Frames lost to a full driver RX queue
+    twai_status_info_t info;
+    if (twai_get_status_info(&info) != ESP_OK) return 0;
+    return info.rx_missed_count;
+}
+
+inline bool setFilterRules(const CanFilterRule* rules, uint8_t count, uint8_t bus = 0) {
     // ESP32 only supports a single CAN bus
-    if (bus != 0) return;
+    if (bus != 0 || !detail::initialized) return false;
+
+    CanFilterRule work[HAL_CAN_MAX_FILTER_RULES];
+    bool exact = filter::normalize(rules, count, work);
+    if (!exact) count = 0;
+    count = filter::merge(work, count, 2, &exact);
+
+    // Filters can only change with the driver stopped - reinstall it
+    twai_filter_config_t f_config = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+    if (count > 0) detail::encodeFilter(work, count, &f_config, &exact);
+
+    ESP32Can.end();
+    detail::initialized = detail::install(&f_config);
+    return detail::initialized && exact;
+}
+
+// Low power (lib/power_manager): the controller can't run through light
+// sleep, so it is stopped (driver, filters and mode kept) and the RX pin wakes
+// the chip - a dominant bit (LOW) on the bus. The frame that wakes it is lost.
+inline uint8_t sleep(uint8_t bus = 0) {
+    if (bus != 0 || !detail::initialized) return HAL_CAN_NO_WAKE_PIN;
+    twai_stop();
+    return (uint8_t)detail::rxPin;
+}
+
+inline bool activity(uint8_t bus = 0) {
+    if (bus != 0 || !detail::initialized) return false;
+    return digitalRead(detail::rxPin) == LOW;
+}
 
-    // ESP32 TWAI filtering is more complex - software filtering recommended
-    // Hardware acceptance filter can be configured via ESP32Can if needed
-    (void)filter1;
-    (void)filter2;
+inline void wake(uint8_t bus = 0) {
+    if (bus != 0 || !detail::initialized) return;
+    twai_start();
 }
 
 #ifdef ENABLE_CAN_HYBRID
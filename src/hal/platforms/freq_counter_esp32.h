@@ -0,0 +1,152 @@
+/*
+ * freq_counter_esp32.h - ESP32 PCNT pulse counter implementation
+ * Part of the preOBD Hardware Abstraction Layer
+ *
+ * One PCNT unit per pulse input, counting rising edges up to
+ * HAL_FREQ_COUNTER_WRAP and restarting from 0. Uses the pulse_cnt driver on
+ * Arduino-ESP32 3.x and the legacy pcnt driver on 2.x. Variants without a
+ * PCNT peripheral (ESP32-C3) get the stub behaviour.
+ */
+
+#ifndef HAL_FREQ_COUNTER_ESP32_H
+#define HAL_FREQ_COUNTER_ESP32_H
+
+#include <Arduino.h>
+#include <esp_arduino_version.h>
+#include <soc/soc_caps.h>
+
+#if SOC_PCNT_SUPPORTED
+
+#define HAL_HAS_FREQ_COUNTER 1
+#define HAL_FREQ_COUNTER_WRAP 32767
+
+// Longest glitch the PCNT filter can reject (1023 APB cycles at 80MHz)
+#define HAL_FREQ_COUNTER_MAX_FILTER_US 12
+
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+
+#include <driver/pulse_cnt.h>
+
+#define HAL_FREQ_COUNTER_UNITS SOC_PCNT_UNITS_PER_GROUP
+
+namespace hal {
+
+namespace detail {
+    static pcnt_unit_handle_t pcntUnits[HAL_FREQ_COUNTER_UNITS];
+    static pcnt_channel_handle_t pcntChannels[HAL_FREQ_COUNTER_UNITS];
+}
+
+inline void freqCounterEnd(uint8_t unit) {
+    if (unit >= HAL_FREQ_COUNTER_UNITS || detail::pcntUnits[unit] == nullptr) return;
+    pcnt_unit_stop(detail::pcntUnits[unit]);
+    pcnt_unit_disable(detail::pcntUnits[unit]);
+    if (detail::pcntChannels[unit]) pcnt_del_channel(detail::pcntChannels[unit]);
+    pcnt_del_unit(detail::pcntUnits[unit]);
+    detail::pcntUnits[unit] = nullptr;
+    detail::pcntChannels[unit] = nullptr;
+}
+
+inline bool freqCounterBegin(uint8_t unit, uint8_t pin, uint16_t filter_us) {
+    if (unit >= HAL_FREQ_COUNTER_UNITS) return false;
+    freqCounterEnd(unit);
+
+    pcnt_unit_config_t unitConfig = {};
+    unitConfig.low_limit = -1;
+    unitConfig.high_limit = HAL_FREQ_COUNTER_WRAP;  // Count restarts from 0 here
+    if (pcnt_new_unit(&unitConfig, &detail::pcntUnits[unit]) != ESP_OK) {
+        detail::pcntUnits[unit] = nullptr;
+        return false;
+    }
+
+    if (filter_us > HAL_FREQ_COUNTER_MAX_FILTER_US) filter_us = HAL_FREQ_COUNTER_MAX_FILTER_US;
+    pcnt_glitch_filter_config_t filterConfig = {};
+    filterConfig.max_glitch_ns = filter_us * 1000;
+    pcnt_unit_set_glitch_filter(detail::pcntUnits[unit], &filterConfig);
+
+    pcnt_chan_config_t chanConfig = {};
+    chanConfig.edge_gpio_num = pin;
+    chanConfig.level_gpio_num = -1;
+    if (pcnt_new_channel(detail::pcntUnits[unit], &chanConfig, &detail::pcntChannels[unit]) != ESP_OK) {
+        detail::pcntChannels[unit] = nullptr;
+        pcnt_del_unit(detail::pcntUnits[unit]);
+        detail::pcntUnits[unit] = nullptr;
+        return false;
+    }
+    pcnt_channel_set_edge_action(detail::pcntChannels[unit],
+                                 PCNT_CHANNEL_EDGE_ACTION_INCREASE,   // Rising
+                                 PCNT_CHANNEL_EDGE_ACTION_HOLD);      // Falling
+
+    pcnt_unit_enable(detail::pcntUnits[unit]);
+    pcnt_unit_clear_count(detail::pcntUnits[unit]);
+    pcnt_unit_start(detail::pcntUnits[unit]);
+    return true;
+}
+
+inline uint16_t freqCounterRead(uint8_t unit) {
+    if (unit >= HAL_FREQ_COUNTER_UNITS || detail::pcntUnits[unit] == nullptr) return 0;
+    int count = 0;
+    pcnt_unit_get_count(detail::pcntUnits[unit], &count);
+    return (uint16_t)count;
+}
+
+} // namespace hal
+
+#else  // Arduino-ESP32 2.x - legacy driver
+
+#include <driver/pcnt.h>
+
+#define HAL_FREQ_COUNTER_UNITS PCNT_UNIT_MAX
+
+namespace hal {
+
+inline bool freqCounterBegin(uint8_t unit, uint8_t pin, uint16_t filter_us) {
+    if (unit >= HAL_FREQ_COUNTER_UNITS) return false;
+
+    pcnt_config_t config = {};
+    config.pulse_gpio_num = pin;
+    config.ctrl_gpio_num = PCNT_PIN_NOT_USED;
+    config.lctrl_mode = PCNT_MODE_KEEP;
+    config.hctrl_mode = PCNT_MODE_KEEP;
+    config.pos_mode = PCNT_COUNT_INC;   // Rising
+    config.neg_mode = PCNT_COUNT_DIS;   // Falling
+    config.counter_h_lim = HAL_FREQ_COUNTER_WRAP;  // Count restarts from 0 here
+    config.counter_l_lim = 0;
+    config.unit = (pcnt_unit_t)unit;
+    config.channel = PCNT_CHANNEL_0;
+    if (pcnt_unit_config(&config) != ESP_OK) return false;
+
+    if (filter_us > HAL_FREQ_COUNTER_MAX_FILTER_US) filter_us = HAL_FREQ_COUNTER_MAX_FILTER_US;
+    uint16_t ticks = filter_us * 80;  // APB cycles
+    if (ticks > 1023) ticks = 1023;
+    pcnt_set_filter_value((pcnt_unit_t)unit, ticks);
+    pcnt_filter_enable((pcnt_unit_t)unit);
+
+    pcnt_counter_pause((pcnt_unit_t)unit);
+    pcnt_counter_clear((pcnt_unit_t)unit);
+    pcnt_counter_resume((pcnt_unit_t)unit);
+    return true;
+}
+
+inline uint16_t freqCounterRead(uint8_t unit) {
+    if (unit >= HAL_FREQ_COUNTER_UNITS) return 0;
+    int16_t count = 0;
+    pcnt_get_counter_value((pcnt_unit_t)unit, &count);
+    return (uint16_t)count;
+}
+
+inline void freqCounterEnd(uint8_t unit) {
+    if (unit >= HAL_FREQ_COUNTER_UNITS) return;
+    pcnt_counter_pause((pcnt_unit_t)unit);
+}
+
+} // namespace hal
+
+#endif // ESP_ARDUINO_VERSION_MAJOR
+
+#else  // No PCNT on this variant
+
+#include "freq_counter_stub.h"
+
+#endif // SOC_PCNT_SUPPORTED
+
+#endif // HAL_FREQ_COUNTER_ESP32_H
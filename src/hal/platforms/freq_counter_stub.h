@@ -0,0 +1,36 @@
+/*
+ * freq_counter_stub.h - Stub hardware pulse counter implementation
+ * Part of the preOBD Hardware Abstraction Layer
+ * Used when ENABLE_FREQ_COUNTER_HW is off or the platform has no backend
+ */
+
+#ifndef HAL_FREQ_COUNTER_STUB_H
+#define HAL_FREQ_COUNTER_STUB_H
+
+#include <stdint.h>
+
+#define HAL_HAS_FREQ_COUNTER 0
+#define HAL_FREQ_COUNTER_UNITS 0
+#define HAL_FREQ_COUNTER_WRAP 32767
+
+namespace hal {
+
+inline bool freqCounterBegin(uint8_t unit, uint8_t pin, uint16_t filter_us) {
+    (void)unit;
+    (void)pin;
+    (void)filter_us;
+    return false;
+}
+
+inline uint16_t freqCounterRead(uint8_t unit) {
+    (void)unit;
+    return 0;
+}
+
+inline void freqCounterEnd(uint8_t unit) {
+    (void)unit;
+}
+
+} // namespace hal
+
+#endif // HAL_FREQ_COUNTER_STUB_H
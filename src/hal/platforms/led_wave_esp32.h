@@ -0,0 +1,132 @@
+/*
+ * led_wave_esp32.h - ESP32 hardware-timed LED effect implementation
+ * Part of the preOBD Hardware Abstraction Layer
+ *
+ * Drives LEDC channels 0-2 as set up with the Arduino-ESP32 2.x ledcSetup()
+ * (channels 0-7 are the high-speed group where the chip has one). A
+ * periodic esp_timer (timer task, not loop()) fires every half period:
+ * a blink sets the new duty, a ramp starts an LEDC hardware fade to the
+ * peak or back to dark over that half period. Arduino-ESP32 3.x manages
+ * LEDC by pin instead - there ledWaveStart() returns false.
+ */
+
+#ifndef HAL_LED_WAVE_ESP32_H
+#define HAL_LED_WAVE_ESP32_H
+
+#include <Arduino.h>
+#include <esp_arduino_version.h>
+
+#if ESP_ARDUINO_VERSION_MAJOR < 3
+
+#include <driver/ledc.h>
+#include <esp_timer.h>
+#include <soc/soc_caps.h>
+
+#define HAL_HAS_LED_WAVE 1
+
+namespace hal {
+
+namespace detail {
+#if SOC_LEDC_SUPPORT_HS_MODE
+    static const ledc_mode_t ledWaveMode = LEDC_HIGH_SPEED_MODE;
+#else
+    static const ledc_mode_t ledWaveMode = LEDC_LOW_SPEED_MODE;
+#endif
+    static esp_timer_handle_t ledWaveTimer = nullptr;
+    static bool ledWaveFades = false;       // ledc_fade_func_install() done
+    static bool ledWaveRunning = false;
+    static uint8_t ledWavePeak[3];
+    static bool ledWaveInvert;
+    static LedWave ledWaveKind;
+    static uint32_t ledWaveHalfMs;
+    static bool ledWaveHigh;                // Heading for (or at) the peak
+
+    static uint32_t ledWaveDuty(uint8_t i, bool high) {
+        uint8_t duty = high ? ledWavePeak[i] : 0;
+        return ledWaveInvert ? 255 - duty : duty;
+    }
+
+    static void ledWaveSet(bool high) {
+        for (uint8_t i = 0; i < 3; i++) {
+            ledc_channel_t ch = (ledc_channel_t)i;
+            if (ledWaveKind == LED_WAVE_BLINK) {
+                ledc_set_duty(ledWaveMode, ch, ledWaveDuty(i, high));
+                ledc_update_duty(ledWaveMode, ch);
+            } else {
+                ledc_set_fade_time_and_start(ledWaveMode, ch, ledWaveDuty(i, high),
+                                             ledWaveHalfMs, LEDC_FADE_NO_WAIT);
+            }
+        }
+    }
+
+    static void ledWaveTick(void*) {
+        ledWaveHigh = !ledWaveHigh;
+        ledWaveSet(ledWaveHigh);
+    }
+}
+
+inline void ledWaveStop() {
+    if (!detail::ledWaveRunning) return;
+    esp_timer_stop(detail::ledWaveTimer);
+    detail::ledWaveRunning = false;
+    if (detail::ledWaveKind == LED_WAVE_RAMP) {
+        // Let a fade in progress finish on a one-step fade, so ledcWrite() sticks
+        for (uint8_t i = 0; i < 3; i++) {
+            ledc_channel_t ch = (ledc_channel_t)i;
+            ledc_set_fade_with_step(detail::ledWaveMode, ch, detail::ledWaveDuty(i, false), 255, 1);
+            ledc_fade_start(detail::ledWaveMode, ch, LEDC_FADE_WAIT_DONE);
+        }
+    }
+}
+
+inline bool ledWaveStart(LedWave wave, const uint8_t pins[3], const uint8_t peak[3],
+                         uint16_t period_ms, bool invert) {
+    (void)pins;  // Channels 0-2
+    ledWaveStop();
+    if (period_ms < 2) return false;
+
+    if (!detail::ledWaveFades) {
+        if (ledc_fade_func_install(0) != ESP_OK) return false;
+        detail::ledWaveFades = true;
+    }
+    if (detail::ledWaveTimer == nullptr) {
+        esp_timer_create_args_t args = {};
+        args.callback = detail::ledWaveTick;
+        args.dispatch_method = ESP_TIMER_TASK;
+        args.name = "led_wave";
+        if (esp_timer_create(&args, &detail::ledWaveTimer) != ESP_OK) {
+            detail::ledWaveTimer = nullptr;
+            return false;
+        }
+    }
+
+    for (uint8_t i = 0; i < 3; i++) {
+        detail::ledWavePeak[i] = peak[i];
+    }
+    detail::ledWaveInvert = invert;
+    detail::ledWaveKind = wave;
+    detail::ledWaveHalfMs = period_ms / 2;
+
+    // Blink: on first; ramp: from dark, fading up first
+    if (wave == LED_WAVE_RAMP) {
+        for (uint8_t i = 0; i < 3; i++) {
+            ledc_set_duty(detail::ledWaveMode, (ledc_channel_t)i, detail::ledWaveDuty(i, false));
+            ledc_update_duty(detail::ledWaveMode, (ledc_channel_t)i);
+        }
+    }
+    detail::ledWaveHigh = true;
+    detail::ledWaveSet(true);
+    if (esp_timer_start_periodic(detail::ledWaveTimer, (uint64_t)detail::ledWaveHalfMs * 1000ULL) != ESP_OK) {
+        return false;
+    }
+    detail::ledWaveRunning = true;
+    return true;
+}
+
+} // namespace hal
+
+#else
+#include "led_wave_stub.h"
+#endif // ESP_ARDUINO_VERSION_MAJOR < 3
+
+#endif // HAL_LED_WAVE_ESP32_H
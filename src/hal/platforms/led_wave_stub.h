@@ -0,0 +1,30 @@
+/*
+ * led_wave_stub.h - Stub hardware-timed LED effect implementation
+ * Part of the preOBD Hardware Abstraction Layer
+ * Used on platforms without a timer backend - effects run from the loop
+ */
+
+#ifndef HAL_LED_WAVE_STUB_H
+#define HAL_LED_WAVE_STUB_H
+
+#include <stdint.h>
+
+#define HAL_HAS_LED_WAVE 0
+
+namespace hal {
+
+inline bool ledWaveStart(LedWave wave, const uint8_t pins[3], const uint8_t peak[3],
+                         uint16_t period_ms, bool invert) {
+    (void)wave;
+    (void)pins;
+    (void)peak;
+    (void)period_ms;
+    (void)invert;
+    return false;
+}
+
+inline void ledWaveStop() {}
+
+} // namespace hal
+
+#endif // HAL_LED_WAVE_STUB_H
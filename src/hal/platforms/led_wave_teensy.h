@@ -0,0 +1,84 @@
+/*
+ * led_wave_teensy.h - Teensy 3.x/4.x hardware-timed LED effect implementation
+ * Part of the preOBD Hardware Abstraction Layer
+ *
+ * An IntervalTimer (PIT) steps the three analogWrite() duties - writes to
+ * the FlexPWM/QuadTimer (or FTM) compare registers, safe in its ISR. A
+ * blink takes one interrupt per half period; a ramp HAL_LED_WAVE_STEPS per
+ * half period (64: a 2 s breath steps every 16 ms). Takes a PIT channel of
+ * its own; with none free, ledWaveStart() returns false.
+ */
+
+#ifndef HAL_LED_WAVE_TEENSY_H
+#define HAL_LED_WAVE_TEENSY_H
+
+#include <Arduino.h>
+#include <IntervalTimer.h>
+#include "../hal_placement.h"
+
+#define HAL_HAS_LED_WAVE 1
+
+#ifndef HAL_LED_WAVE_STEPS
+#define HAL_LED_WAVE_STEPS 64
+#endif
+
+namespace hal {
+
+namespace detail {
+    static IntervalTimer ledWaveTimer;
+    static uint8_t ledWavePins[3];
+    static uint8_t ledWavePeak[3];
+    static bool ledWaveInvert;
+    static LedWave ledWaveKind;
+    static volatile uint16_t ledWaveStep;   // Blink: 0 on, 1 off; ramp: 0 .. 2*STEPS-1
+
+    HAL_ISR static void ledWaveWrite(uint16_t level, uint16_t full) {
+        for (uint8_t i = 0; i < 3; i++) {
+            uint8_t duty = (uint8_t)((uint16_t)ledWavePeak[i] * level / full);
+            analogWrite(ledWavePins[i], ledWaveInvert ? 255 - duty : duty);
+        }
+    }
+
+    HAL_ISR static void ledWaveIsr() {
+        uint16_t step = ledWaveStep + 1;
+        if (ledWaveKind == LED_WAVE_BLINK) {
+            if (step >= 2) step = 0;
+            ledWaveWrite(step == 0 ? 1 : 0, 1);
+        } else {
+            if (step >= 2 * HAL_LED_WAVE_STEPS) step = 0;
+            ledWaveWrite(step <= HAL_LED_WAVE_STEPS ? step : 2 * HAL_LED_WAVE_STEPS - step, HAL_LED_WAVE_STEPS);
+        }
+        ledWaveStep = step;
+    }
+}
+
+inline void ledWaveStop() {
+    detail::ledWaveTimer.end();
+}
+
+inline bool ledWaveStart(LedWave wave, const uint8_t pins[3], const uint8_t peak[3],
+                         uint16_t period_ms, bool invert) {
+    ledWaveStop();
+    if (period_ms < 2) return false;
+    for (uint8_t i = 0; i < 3; i++) {
+        detail::ledWavePins[i] = pins[i];
+        detail::ledWavePeak[i] = peak[i];
+    }
+    detail::ledWaveInvert = invert;
+    detail::ledWaveKind = wave;
+
+    uint32_t interval_us = (uint32_t)period_ms * 1000UL / 2;
+    if (wave == LED_WAVE_BLINK) {
+        detail::ledWaveStep = 0;
+        detail::ledWaveWrite(1, 1);           // On first
+    } else {
+        interval_us /= HAL_LED_WAVE_STEPS;
+        detail::ledWaveStep = 0;
+        detail::ledWaveWrite(0, 1);           // Dark first
+    }
+    return detail::ledWaveTimer.begin(detail::ledWaveIsr, interval_us);
+}
+
+} // namespace hal
+
+#endif // HAL_LED_WAVE_TEENSY_H
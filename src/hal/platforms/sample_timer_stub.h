@@ -0,0 +1,26 @@
+/*
+ * sample_timer_stub.h - Stub sampling interrupt implementation
+ * Part of the preOBD Hardware Abstraction Layer
+ * Used on platforms without a sampling timer backend
+ */
+
+#ifndef HAL_SAMPLE_TIMER_STUB_H
+#define HAL_SAMPLE_TIMER_STUB_H
+
+#include <stdint.h>
+
+#define HAL_HAS_SAMPLE_TIMER 0
+
+namespace hal {
+
+inline bool sampleTimerBegin(void (*isr)(), uint32_t period_us) {
+    (void)isr;
+    (void)period_us;
+    return false;
+}
+
+inline void sampleTimerEnd() {}
+
+} // namespace hal
+
+#endif // HAL_SAMPLE_TIMER_STUB_H
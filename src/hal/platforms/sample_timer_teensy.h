@@ -0,0 +1,33 @@
+/*
+ * sample_timer_teensy.h - Teensy 3.x/4.x sampling interrupt implementation
+ * Part of the preOBD Hardware Abstraction Layer
+ *
+ * A Teensy IntervalTimer (periodic interrupt timer, PIT) at its default
+ * priority. The ISR must stay short - everything else waits while it runs.
+ */
+
+#ifndef HAL_SAMPLE_TIMER_TEENSY_H
+#define HAL_SAMPLE_TIMER_TEENSY_H
+
+#include <Arduino.h>
+#include <IntervalTimer.h>
+
+#define HAL_HAS_SAMPLE_TIMER 1
+
+namespace hal {
+
+namespace detail {
+    static IntervalTimer sampleTimer;
+}
+
+inline bool sampleTimerBegin(void (*isr)(), uint32_t period_us) {
+    return detail::sampleTimer.begin(isr, period_us);
+}
+
+inline void sampleTimerEnd() {
+    detail::sampleTimer.end();
+}
+
+} // namespace hal
+
+#endif // HAL_SAMPLE_TIMER_TEENSY_H
@@ -0,0 +1,263 @@
+/*
+ * alarm_journal.cpp - Alarm event journal in EEPROM
+ *
+ * Ring of AlarmJournalRecord slots from JOURNAL_ADDRESS to the end of the
+ * EEPROM (at most ALARM_JOURNAL_RECORDS). Events wait in queue[] with their
+ * sequence numbers assigned; the writer copies the oldest into nextSlot a
+ * byte at a time and drops it from the queue once its checksum is written.
+ */
+
+#include "alarm_journal.h"
+#include "input_manager.h"
+#include "../lib/system_config.h"
+#include "../lib/message_api.h"
+#include "../hal/hal_clock.h"
+#include <EEPROM.h>
+#include <math.h>
+
+#if defined(__AVR__)
+#include <avr/eeprom.h>
+#define JOURNAL_BYTES_PER_UPDATE 1          // Each byte takes 3.3 ms
+#else
+#define JOURNAL_BYTES_PER_UPDATE 16
+#endif
+
+#define RECORD_SIZE sizeof(AlarmJournalRecord)
+
+static_assert(sizeof(AlarmJournalRecord) == 16, "Journal records are 16 bytes in EEPROM");
+
+#define JOURNAL_ADDRESS ALARM_JOURNAL_ADDRESS
+
+static uint16_t capacity;                   // Slots that fit (0 = no journal)
+static uint16_t nextSlot;                   // Slot the oldest queued event goes to
+static uint16_t nextSeq;                    // Sequence number of the next event
+static uint8_t bootNumber;
+
+static AlarmJournalRecord queue[ALARM_JOURNAL_QUEUE];
+static uint8_t queueHead;                   // Oldest event
+static uint8_t queueCount;
+static uint16_t dropped;                    // Events lost with the queue full
+static uint32_t firstQueuedMs;              // When the page being gathered started
+
+static uint8_t pageLeft;                    // Records left in the batch being written (0 = idle)
+static uint8_t byteOffset;                  // Next byte of queue[queueHead]
+
+static uint8_t checksumOf(const AlarmJournalRecord* record) {
+    const uint8_t* bytes = (const uint8_t*)record;
+    uint8_t sum = 0xA5;                     // Erased (0xFF) and zeroed slots never match
+    for (uint8_t i = 0; i < RECORD_SIZE - 1; i++) sum ^= bytes[i];
+    return sum;
+}
+
+static uint16_t slotAddress(uint16_t slot) {
+    return JOURNAL_ADDRESS + slot * RECORD_SIZE;
+}
+
+static bool readRecord(uint16_t slot, AlarmJournalRecord* record) {
+    EEPROM.get(slotAddress(slot), *record);
+    return record->checksum == checksumOf(record);
+}
+
+void initAlarmJournal() {
+    uint32_t length = EEPROM.length();
+    capacity = 0;
+    if (length > JOURNAL_ADDRESS) {
+        uint32_t fit = (length - JOURNAL_ADDRESS) / RECORD_SIZE;
+        capacity = (fit < ALARM_JOURNAL_RECORDS) ? fit : ALARM_JOURNAL_RECORDS;
+    }
+    if (capacity == 0) return;
+
+    // Head: the newest valid record (serial order, so the sequence may wrap)
+    bool found = false;
+    AlarmJournalRecord newest;
+    uint16_t newestSlot = 0;
+    for (uint16_t slot = 0; slot < capacity; slot++) {
+        AlarmJournalRecord record;
+        if (!readRecord(slot, &record)) continue;
+        if (!found || (int16_t)(record.seq - newest.seq) > 0) {
+            newest = record;
+            newestSlot = slot;
+            found = true;
+        }
+    }
+
+    nextSlot = found ? (newestSlot + 1) % capacity : 0;
+    nextSeq = found ? newest.seq + 1 : 0;
+    bootNumber = found ? newest.boot + 1 : 0;
+}
+
+void logAlarmEvent(const Input* input, AlarmSeverity previous, AlarmSeverity severity) {
+    if (capacity == 0) return;
+    if (queueCount >= ALARM_JOURNAL_QUEUE) {
+        dropped++;
+        return;
+    }
+    if (queueCount == 0) firstQueuedMs = millis();
+
+    AlarmJournalRecord* record = &queue[(queueHead + queueCount) % ALARM_JOURNAL_QUEUE];
+    uint32_t wall = hal::wallClock();
+    record->seq = nextSeq++;
+    record->boot = bootNumber;
+    record->pin = (uint8_t)input->pin;
+    record->time = wall ? wall : millis();
+    record->value = input->value;
+    record->severity = severity;
+    record->previous = previous;
+    record->flags = (wall ? 0 : ALARM_JOURNAL_UPTIME) | (input->pin > 0xFF ? ALARM_JOURNAL_PIN_HIGH : 0);
+    record->checksum = checksumOf(record);
+    queueCount++;
+}
+
+// Next page: up to ALARM_JOURNAL_PAGE_RECORDS of the queued events
+static void startPage() {
+    pageLeft = (queueCount < ALARM_JOURNAL_PAGE_RECORDS) ? queueCount : ALARM_JOURNAL_PAGE_RECORDS;
+    byteOffset = 0;
+}
+
+// Write the page in progress, up to budget changed bytes
+static void writePage(uint16_t budget, uint32_t now) {
+    while (budget > 0 && pageLeft > 0) {
+#if defined(__AVR__)
+        if (!eeprom_is_ready()) return;     // Previous byte still being written
+#endif
+        const uint8_t* bytes = (const uint8_t*)&queue[queueHead];
+        uint16_t addr = slotAddress(nextSlot) + byteOffset;
+        if (EEPROM.read(addr) != bytes[byteOffset]) {
+            EEPROM.write(addr, bytes[byteOffset]);
+            budget--;                       // Unchanged bytes cost nothing
+        }
+        if (++byteOffset < RECORD_SIZE) continue;
+
+        // Checksum written - the record is in the ring
+        byteOffset = 0;
+        nextSlot = (nextSlot + 1) % capacity;
+        queueHead = (queueHead + 1) % ALARM_JOURNAL_QUEUE;
+        queueCount--;
+        if (--pageLeft == 0) {
+            firstQueuedMs = now;
+#if defined(ESP32)
+            EEPROM.commit();                // Emulated EEPROM: one sector write per page
+#endif
+        }
+    }
+}
+
+void updateAlarmJournal(uint32_t now) {
+    if (capacity == 0) return;
+
+    if (pageLeft == 0) {
+        if (queueCount == 0) return;
+        if (queueCount < ALARM_JOURNAL_PAGE_RECORDS && now - firstQueuedMs < ALARM_JOURNAL_FLUSH_MS) return;
+        startPage();
+    }
+    writePage(JOURNAL_BYTES_PER_UPDATE, now);
+}
+
+void flushAlarmJournal() {
+    if (capacity == 0) return;
+    uint32_t now = millis();
+    while (queueCount > 0) {
+        if (pageLeft == 0) startPage();
+        writePage(0xFFFF, now);             // AVR: returns while a byte is programming - spin
+    }
+}
+
+static void printSeverityName(uint8_t severity) {
+    switch (severity) {
+        case SEVERITY_NORMAL:  msg.control.print(F("NORMAL")); break;
+        case SEVERITY_WARNING: msg.control.print(F("WARNING")); break;
+        case SEVERITY_ALARM:   msg.control.print(F("ALARM")); break;
+        default:               msg.control.print(F("?")); break;
+    }
+}
+
+static void printRecord(const AlarmJournalRecord* record, bool written) {
+    msg.control.print(F("  #"));
+    msg.control.print(record->seq);
+    msg.control.print(F("  boot "));
+    msg.control.print(record->boot);
+    msg.control.print(F("  "));
+
+    char text[16];
+    if (record->flags & ALARM_JOURNAL_UPTIME) {
+        uint32_t s = record->time / 1000;
+        snprintf(text, sizeof(text), "+%02lu:%02lu:%02lu.%03lu", (unsigned long)(s / 3600),
+                 (unsigned long)(s / 60 % 60), (unsigned long)(s % 60), (unsigned long)(record->time % 1000));
+    } else {
+        hal::formatWallClock(record->time, text);
+    }
+    msg.control.print(text);
+    msg.control.print(F("  "));
+
+    InputPin pin = record->pin;
+#if INPUT_PIN_WIDE
+    if (record->flags & ALARM_JOURNAL_PIN_HIGH) pin |= 0x100;
+#endif
+    printPin(pin);
+    Input* input = getInputByPin(pin);
+    if (input) {
+        msg.control.print(F(" ("));
+        msg.control.print(input->abbrName);
+        msg.control.print(F(")"));
+    }
+    msg.control.print(F("  "));
+    printSeverityName(record->previous);
+    msg.control.print(F(" -> "));
+    printSeverityName(record->severity);
+    msg.control.print(F("  "));
+    if (isnan(record->value)) msg.control.print(F("---"));
+    else msg.control.print(record->value, 2);
+    if (!written) msg.control.print(F("  (not yet written)"));
+    msg.control.println();
+}
+
+void printAlarmHistory(uint8_t count) {
+    msg.control.println();
+    if (capacity == 0) {
+        msg.control.println(F("Alarm journal: no EEPROM space after the system config"));
+        msg.control.println();
+        return;
+    }
+
+    msg.control.print(F("===== Alarm History ("));
+    msg.control.print(capacity);
+    msg.control.print(F(" slots, boot "));
+    msg.control.print(bootNumber);
+    if (dropped) {
+        msg.control.print(F(", "));
+        msg.control.print(dropped);
+        msg.control.print(F(" dropped"));
+    }
+    msg.control.println(F(") ====="));
+
+    // Newest first: the queue, then the ring backwards while the sequence runs on
+    uint8_t shown = 0;
+    for (uint8_t k = queueCount; k > 0 && shown < count; k--, shown++) {
+        printRecord(&queue[(queueHead + k - 1) % ALARM_JOURNAL_QUEUE], false);
+    }
+
+    uint16_t expect = (queueCount ? queue[queueHead].seq : nextSeq) - 1;
+    for (uint16_t k = 0; k < capacity && shown < count; k++, shown++, expect--) {
+        AlarmJournalRecord record;
+        uint16_t slot = (nextSlot + capacity - 1 - k) % capacity;
+        if (!readRecord(slot, &record) || record.seq != expect) break;
+        printRecord(&record, true);
+    }
+
+    if (shown == 0) msg.control.println(F("  (none)"));
+    msg.control.println();
+}
+
+void clearAlarmHistory() {
+    queueHead = 0;
+    queueCount = 0;
+    pageLeft = 0;
+    dropped = 0;
+
+    // Spoil each valid record's checksum - one byte per record, not the whole ring
+    for (uint16_t slot = 0; slot < capacity; slot++) {
+        AlarmJournalRecord record;
+        if (!readRecord(slot, &record)) continue;
+        EEPROM.write(slotAddress(slot) + RECORD_SIZE - 1, record.checksum ^ 0xFF);
+    }
+}
@@ -0,0 +1,104 @@
+/*
+ * alarm_journal.h - Alarm event journal in EEPROM
+ *
+ * Every change of an input's severity (the transitions alarm_logic.cpp
+ * counts) is recorded - time, pin, old and new severity, value - in a ring
+ * of 16-byte records after the system config, so a power cycle doesn't lose
+ * that oil pressure dropped out at 14:32. ALARM HISTORY lists it.
+ *
+ * Wear levelling: the ring has no header or head pointer to rewrite. Each
+ * record carries a sequence number; at boot the newest valid record is the
+ * head, so every slot is written once per lap of the ring.
+ *
+ * Batching: events queue in RAM and are written as a page of
+ * ALARM_JOURNAL_PAGE_RECORDS records - once a page is full, or
+ * ALARM_JOURNAL_FLUSH_MS after the first event. updateAlarmJournal() writes a
+ * few bytes per loop (on AVR one byte, and only once the previous one has
+ * finished - each takes 3.3 ms), so a write never stalls the loop. The
+ * checksum byte goes last: a record cut off by a power loss reads back as
+ * invalid, not as a wrong event.
+ *
+ * Times are unix seconds when the wall clock is known (hal_clock.h),
+ * otherwise milliseconds since that power cycle's boot (numbered from the
+ * journal itself).
+ *
+ * Usage:
+ *   initAlarmJournal();            // setup(), after the config is loaded
+ *   logAlarmEvent(input, from, to); // alarm_logic.cpp does this
+ *   updateAlarmJournal(now);        // every loop
+ *   flushAlarmJournal();            // supply failing - everything queued, now
+ *
+ * Build Flags:
+ *   -D ALARM_JOURNAL_RECORDS=n      - Ring slots (default 64; 0 disables the journal)
+ *   -D ALARM_JOURNAL_QUEUE=n        - Events waiting in RAM (default 8; 4 on AVR)
+ *   -D ALARM_JOURNAL_PAGE_RECORDS=n - Records per batch (default 4)
+ *   -D ALARM_JOURNAL_FLUSH_MS=n     - Longest wait for a page to fill (default 5000)
+ */
+
+#ifndef ALARM_JOURNAL_H
+#define ALARM_JOURNAL_H
+
+#include <Arduino.h>
+#include "input.h"
+#include "../lib/system_config.h"
+
+#ifndef ALARM_JOURNAL_RECORDS
+#define ALARM_JOURNAL_RECORDS 64
+#endif
+
+#ifndef ALARM_JOURNAL_QUEUE
+#if defined(__AVR__)
+#define ALARM_JOURNAL_QUEUE 4
+#else
+#define ALARM_JOURNAL_QUEUE 8
+#endif
+#endif
+
+#ifndef ALARM_JOURNAL_PAGE_RECORDS
+#define ALARM_JOURNAL_PAGE_RECORDS 4
+#endif
+
+#ifndef ALARM_JOURNAL_FLUSH_MS
+#define ALARM_JOURNAL_FLUSH_MS 5000
+#endif
+
+// Ring area: after the system config, on a record boundary; the accumulator
+// store (input_stats.h) starts where a full ring would end
+#define ALARM_JOURNAL_ADDRESS ((SYSTEM_CONFIG_ADDRESS + SYSTEM_CONFIG_SIZE + 15) / 16 * 16)
+#define ALARM_JOURNAL_END (ALARM_JOURNAL_ADDRESS + ALARM_JOURNAL_RECORDS * 16)
+
+#define ALARM_JOURNAL_UPTIME 0x01           // AlarmJournalRecord.flags: time is ms since boot
+#define ALARM_JOURNAL_PIN_HIGH 0x02         // AlarmJournalRecord.flags: pin is pin + 0x100 (wide CAN pin)
+
+// One event as stored (16 bytes)
+struct AlarmJournalRecord {
+    uint16_t seq;                           // Write order; the newest is the head
+    uint8_t boot;                           // Power cycle it happened in
+    uint8_t pin;
+    uint32_t time;                          // Unix seconds, or ms since boot (ALARM_JOURNAL_UPTIME)
+    float value;                            // Reading at the transition
+    uint8_t severity;                       // AlarmSeverity entered
+    uint8_t previous;                       // AlarmSeverity left
+    uint8_t flags;
+    uint8_t checksum;                       // Written last
+};
+
+// Find the ring's head and this boot's number
+void initAlarmJournal();
+
+// Queue a severity change (dropped, and counted, if the queue is full)
+void logAlarmEvent(const Input* input, AlarmSeverity previous, AlarmSeverity severity);
+
+// Write queued events, a few bytes per call
+void updateAlarmJournal(uint32_t now);
+
+// Write every queued event now (blocking - the power-fail path, lib/power_fail.h)
+void flushAlarmJournal();
+
+// Print the newest count events, unwritten ones included
+void printAlarmHistory(uint8_t count);
+
+// Invalidate every record (blocking - a CONFIG mode command)
+void clearAlarmHistory();
+
+#endif // ALARM_JOURNAL_H
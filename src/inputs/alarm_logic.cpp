@@ -21,17 +21,91 @@
  *      ↓                                            │
  *   READY ←──────────────────────┐                 │
  *      │                          │                 │
- *      │ (violation + persist)    │ (value normal) │
+ *      │ (violation + persist)    │ (clear + hyst) │
  *      ↓                          │                 │
  *   ACTIVE ────────────────────── ┘                │
  *      │                                            │
  *      │ (alarm disabled)                          │
  *      └────────────────────────────────────────────┘
+ *
+ * In READY / ACTIVE, warning and alarm are two levels, each with its own
+ * thresholds (warnMin/warnMax, minValue/maxValue), hysteresis band and
+ * persist / clear times - so a value hovering at a threshold changes
+ * severity once, not every reading (each change drives the buzzer, LED,
+ * relays and CAN).
  */
 
 #include "alarm_logic.h"
 #include "../config.h"
 #include "input_manager.h"
+#include "alarm_trend.h"
+#include "alarm_rules.h"
+#include "alarm_journal.h"
+#include "../lib/latency_trace.h"
+#include "../hal/hal_placement.h"
+
+// Severity each slot adds to the counts (NORMAL while the input is disabled)
+static AlarmSeverity countedSeverity[MAX_INPUTS];
+static uint8_t severityCount[SEVERITY_ALARM + 1] = {MAX_INPUTS, 0, 0};
+
+// Slots counted at WARNING or ALARM, in the order they left NORMAL
+static uint8_t alarmedSlots[MAX_INPUTS];
+static uint8_t numAlarmed = 0;
+
+// Level state beside each AlarmContext (whose faultStartTime is the alarm level's timer)
+struct AlarmLevelState {
+    uint32_t warnSince;     // Warning condition changed at (0 = no change pending)
+    bool alarmBeyond;       // Past the alarm thresholds, with hysteresis
+    bool warnBeyond;        // Past the warning thresholds, with hysteresis
+    bool warnOn;            // Warning asserted, after its timers
+};
+static AlarmLevelState levelState[MAX_INPUTS];
+
+static void resetLevels(Input* input) {
+    input->alarmContext.faultStartTime = 0;
+    uint8_t slot = input - inputs;
+    if (slot < MAX_INPUTS) memset(&levelState[slot], 0, sizeof(AlarmLevelState));
+}
+
+// Set an input's severity, moving its count (and journalling it) on a change
+static void setSeverity(Input* input, AlarmSeverity severity) {
+    input->currentSeverity = severity;
+
+    uint8_t slot = input - inputs;
+    if (slot >= MAX_INPUTS) return;
+    AlarmSeverity counted = input->flags.isEnabled ? severity : SEVERITY_NORMAL;
+    if (counted == countedSeverity[slot]) return;
+    logAlarmEvent(input, countedSeverity[slot], counted);
+    if (countedSeverity[slot] == SEVERITY_NORMAL) {
+        alarmedSlots[numAlarmed++] = slot;
+    } else if (counted == SEVERITY_NORMAL) {
+        uint8_t k = 0;
+        while (alarmedSlots[k] != slot) k++;
+        memmove(&alarmedSlots[k], &alarmedSlots[k + 1], numAlarmed - k - 1);
+        numAlarmed--;
+    }
+    severityCount[countedSeverity[slot]]--;
+    severityCount[counted]++;
+    countedSeverity[slot] = counted;
+}
+
+AlarmSeverity getWorstSeverity() {
+    if (severityCount[SEVERITY_ALARM]) return SEVERITY_ALARM;
+    if (severityCount[SEVERITY_WARNING]) return SEVERITY_WARNING;
+    return SEVERITY_NORMAL;
+}
+
+uint8_t getSeverityCount(AlarmSeverity severity) {
+    return (severity <= SEVERITY_ALARM) ? severityCount[severity] : 0;
+}
+
+uint8_t getAlarmedCount() {
+    return numAlarmed;
+}
+
+Input* getAlarmedInput(uint8_t n) {
+    return (n < numAlarmed) ? &inputs[alarmedSlots[n]] : nullptr;
+}
 
 // Initialize alarm context for an input
 void initInputAlarmContext(Input* input, uint32_t now, uint16_t warmupTime_ms, uint16_t persistTime_ms) {
@@ -42,71 +116,65 @@ void initInputAlarmContext(Input* input, uint32_t now, uint16_t warmupTime_ms, u
     input->alarmContext.warmupTime_ms = warmupTime_ms;
     input->alarmContext.persistTime_ms = persistTime_ms;
     input->flags.isInAlarm = false;
-    input->currentSeverity = SEVERITY_NORMAL;
+    setSeverity(input, SEVERITY_NORMAL);
+    resetLevels(input);
+    resetInputTrend(input);
 }
 
-// Evaluate alarm severity for an input
-AlarmSeverity evaluateSeverity(Input* input, uint32_t now) {
-    // Safety: NaN values are treated as normal
-    if (isnan(input->value)) {
-        return SEVERITY_NORMAL;
-    }
-
-    AlarmContext* ctx = &input->alarmContext;
-
-    // During warmup/init/disabled, always return normal
-    if (ctx->state == ALARM_WARMUP || ctx->state == ALARM_INIT || ctx->state == ALARM_DISABLED) {
-        return SEVERITY_NORMAL;
-    }
-
-    bool alarmViolation = false;
-    bool warningViolation = false;
+// Warning thresholds: configured, or WARNING_THRESHOLD_PERCENT of the alarm ones
+static float warnHigh(const Input* input) {
+    if (!isnan(input->warnMax)) return input->warnMax;
+    if (input->maxValue >= 999) return NAN;  // 999 is the disabled marker
+    return input->maxValue * (WARNING_THRESHOLD_PERCENT / 100.0);
+}
 
-    // Check high-side threshold (maxValue)
-    if (input->maxValue < 999) {  // Threshold enabled (999 is disabled marker)
-        float warningMax = input->maxValue * (WARNING_THRESHOLD_PERCENT / 100.0);
-        if (input->value >= input->maxValue) {
-            alarmViolation = true;
-        } else if (input->value >= warningMax) {
-            warningViolation = true;
-        }
-    }
+static float warnLow(const Input* input) {
+    if (!isnan(input->warnMin)) return input->warnMin;
+    if (input->minValue <= -999) return NAN;  // -999 is the disabled marker
+    return input->minValue + (input->minValue * (100 - WARNING_THRESHOLD_PERCENT) / 100.0);
+}
 
-    // Check low-side threshold (minValue)
-    if (input->minValue > -999) {  // Threshold enabled (-999 is disabled marker)
-        float warningMin = input->minValue + (input->minValue * (100 - WARNING_THRESHOLD_PERCENT) / 100.0);
-        if (input->value <= input->minValue) {
-            alarmViolation = true;
-        } else if (input->value <= warningMin) {
-            warningViolation = true;
-        }
-    }
+// Past a threshold pair: entered at the threshold, left once back inside by the band
+static bool beyond(float value, float low, float high, float band, bool wasBeyond) {
+    float inset = wasBeyond ? band : 0;
+    return (!isnan(high) && value >= high - inset) || (!isnan(low) && value <= low + inset);
+}
 
-    // Return worst-case severity
-    if (alarmViolation && ctx->faultStartTime > 0 && (now - ctx->faultStartTime >= ctx->persistTime_ms)) {
-        return SEVERITY_ALARM;
-    } else if (warningViolation || (alarmViolation && ctx->faultStartTime > 0)) {
-        return SEVERITY_WARNING;  // Warning triggers immediately OR during alarm persist wait
+// Level after its timers: a changed condition must last enterMs to assert, clearMs to clear
+static bool debounce(uint32_t* since, bool asserted, bool condition,
+                     uint16_t enterMs, uint16_t clearMs, uint32_t now) {
+    if (condition == asserted) {
+        *since = 0;
+        return asserted;
     }
-
-    return SEVERITY_NORMAL;
+    if (*since == 0) *since = now ? now : 1;  // 0 means no change pending
+    if (now - *since < (condition ? enterMs : clearMs)) return asserted;
+    *since = 0;
+    return condition;
 }
 
 // Update alarm state for a single input
-void updateInputAlarmState(Input* input, uint32_t now) {
+HAL_HOT_CODE void updateInputAlarmState(Input* input, uint32_t now) {
     // Quick exit if alarm disabled or input not enabled
     if (!input->flags.alarm || !input->flags.isEnabled) {
         input->flags.isInAlarm = false;
         input->alarmContext.state = ALARM_DISABLED;
+        setSeverity(input, SEVERITY_NORMAL);
         return;
     }
 
     AlarmContext* ctx = &input->alarmContext;
 
+    // Keep the trend fit current through INIT and WARMUP, so it is ready at READY
+    updateInputTrend(input, now);
+
     // ===== STATE MACHINE =====
     switch (ctx->state) {
         case ALARM_DISABLED:
-            // Should not reach here if flags.alarm is true, but handle gracefully
+            // Alarm (re-)enabled - start over from INIT
+            ctx->state = ALARM_INIT;
+            ctx->stateEntryTime = now;
+            resetLevels(input);
             input->flags.isInAlarm = false;
             return;
 
@@ -139,47 +207,58 @@ void updateInputAlarmState(Input* input, uint32_t now) {
     }
 
     // ===== ALARM QUALIFICATION LOGIC =====
-    // Only active when state is READY or ACTIVE
+    // Only active when state is READY or ACTIVE. Each level (warning, alarm)
+    // is entered at its thresholds and left once back inside by its
+    // hysteresis band; then a change must last its persist / clear time.
+    uint8_t slot = input - inputs;
+    if (slot >= MAX_INPUTS) return;
+    AlarmLevelState* lv = &levelState[slot];
 
-    // Check if currently violating threshold (with NaN safety)
-    bool violating = false;
-    if (!isnan(input->value)) {
-        violating = (input->value >= input->maxValue || input->value <= input->minValue);
+    bool alarmCondition = false;
+    bool warnCondition = false;
+    if (!isnan(input->value)) {  // NaN safety: no reading is no violation
+        float high = (input->maxValue < 999) ? input->maxValue : NAN;
+        float low = (input->minValue > -999) ? input->minValue : NAN;
+        lv->alarmBeyond = beyond(input->value, low, high, input->alarmHysteresis, lv->alarmBeyond);
+        lv->warnBeyond = beyond(input->value, warnLow(input), warnHigh(input), input->warnHysteresis, lv->warnBeyond);
+        alarmCondition = lv->alarmBeyond;
+        warnCondition = lv->warnBeyond;
+    } else {
+        lv->alarmBeyond = false;
+        lv->warnBeyond = false;
     }
 
-    if (violating) {
-        // Start fault timer if not already started
-        if (ctx->faultStartTime == 0) {
-            ctx->faultStartTime = now;
-        }
+    // Rate of change (trend alarm) and cross-input rules count like a threshold
+    AlarmSeverity trend = getTrendSeverity(input);
+    AlarmSeverity rule = getRuleSeverity(input);
+    if (trend == SEVERITY_ALARM || rule == SEVERITY_ALARM) alarmCondition = true;
+    if (trend != SEVERITY_NORMAL || rule != SEVERITY_NORMAL) warnCondition = true;
+    warnCondition |= alarmCondition;  // An alarm condition warns while its persist time runs
 
-        // Check if fault has persisted long enough
-        // This prevents false alarms from transient sensor noise/spikes
-        if (now - ctx->faultStartTime >= ctx->persistTime_ms) {
-            input->flags.isInAlarm = true;
-            ctx->state = ALARM_ACTIVE;
-        }
-        // else: violation detected but not persistent yet, wait
-    } else {
-        // Value returned to normal - reset fault timer
-        ctx->faultStartTime = 0;
-        input->flags.isInAlarm = false;
+    // Persist time prevents false alarms from transient sensor noise/spikes,
+    // clear time from a value hovering at the threshold
+    bool alarmOn = debounce(&ctx->faultStartTime, ctx->state == ALARM_ACTIVE, alarmCondition,
+                            ctx->persistTime_ms, input->alarmClearMs, now);
+    lv->warnOn = debounce(&lv->warnSince, lv->warnOn, warnCondition,
+                          input->warnPersistMs, input->warnClearMs, now);
 
-        // Transition back to READY state if we were in ACTIVE
-        if (ctx->state == ALARM_ACTIVE) {
-            ctx->state = ALARM_READY;
-        }
-    }
+    input->flags.isInAlarm = alarmOn;
+    ctx->state = alarmOn ? ALARM_ACTIVE : ALARM_READY;
 
-    // Update severity level (new feature)
-    input->currentSeverity = evaluateSeverity(input, now);
+    // Update severity level (and the counts, if it changed)
+    setSeverity(input, alarmOn ? SEVERITY_ALARM : (lv->warnOn ? SEVERITY_WARNING : SEVERITY_NORMAL));
 }
 
 // Update alarm state for all enabled inputs
-void updateAllInputAlarms(uint32_t now) {
+HAL_HOT_CODE void updateAllInputAlarms(uint32_t now) {
+    updateAlarmRules();  // Only rules reading inputs with new values
+
     for (uint8_t i = 0; i < MAX_INPUTS; i++) {
         if (inputs[i].flags.isEnabled) {
             updateInputAlarmState(&inputs[i], now);
+            TRACE_ALARM(i);
+        } else if (countedSeverity[i] != SEVERITY_NORMAL) {
+            setSeverity(&inputs[i], SEVERITY_NORMAL);  // Disabled or cleared - no longer counts
         }
     }
 }
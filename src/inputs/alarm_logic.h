@@ -9,6 +9,12 @@
  * - Warmup period prevents false alarms during cold start
  * - Persistence time prevents false alarms from transient sensor noise
  * - Alarm state stored in Input.flags.isInAlarm for consumption by output modules
+ * - Trend alarms (alarm_trend.h) and cross-input rules (alarm_rules.h) are
+ *   violations of an input like its thresholds
+ * - Counts of enabled inputs per severity are kept as severities change, so
+ *   the system's worst severity is a lookup, not a scan of every input -
+ *   and so is the list of inputs away from NORMAL (the LCD pins them)
+ * - Each of those changes is also recorded in the alarm journal (alarm_journal.h)
  */
 
 #ifndef ALARM_LOGIC_H
@@ -44,4 +50,22 @@ void updateInputAlarmState(Input* input, uint32_t now);
  */
 void updateAllInputAlarms(uint32_t now);
 
+/**
+ * Worst severity across enabled inputs, from the per-severity counts
+ * (updated on transitions by the functions above - O(1))
+ */
+AlarmSeverity getWorstSeverity();
+
+/**
+ * Number of enabled inputs currently at a severity
+ */
+uint8_t getSeverityCount(AlarmSeverity severity);
+
+/**
+ * Enabled inputs at WARNING or ALARM, in the order they left NORMAL
+ * (n < getAlarmedCount(); nullptr past the end)
+ */
+uint8_t getAlarmedCount();
+Input* getAlarmedInput(uint8_t n);
+
 #endif // ALARM_LOGIC_H
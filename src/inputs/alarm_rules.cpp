@@ -0,0 +1,200 @@
+/*
+ * alarm_rules.cpp - Conditional / cross-input alarm rules
+ *
+ * Compiled form: each term's pin (and reference pin) resolved to an input
+ * slot, and per input slot a mask of the rules reading it. A rule is
+ * evaluated when one of those inputs has a new reading, or once after a
+ * compile; a change in whether it holds refreshes its target's severity.
+ */
+
+#include "alarm_rules.h"
+#include "input_manager.h"
+#include "../config.h"
+#include "../lib/message_api.h"
+#include <math.h>
+
+#define NO_SLOT 0xFF
+
+static AlarmRuleConfig rules[ALARM_RULE_MAX];
+
+// Compiled form
+static uint8_t termSlot[ALARM_RULE_MAX][ALARM_RULE_TERMS];
+static uint8_t refSlot[ALARM_RULE_MAX][ALARM_RULE_TERMS];
+static uint16_t readBy[MAX_INPUTS];             // Rules with a term on each input
+static uint8_t lastSeq[MAX_INPUTS];             // Input.sequence last evaluated
+
+static uint16_t pending;                        // Rules to evaluate on the next update
+static uint16_t holding;                        // Rules whose terms all hold
+static AlarmSeverity ruleSeverity[MAX_INPUTS];  // Worst holding rule per target
+
+static uint8_t slotOf(uint8_t pin) {
+    Input* input = getInputByPin(pin);
+    return input ? (uint8_t)(input - inputs) : NO_SLOT;
+}
+
+// Reading of a slot, NAN if it has none (missing, disabled, moved)
+static float valueOf(uint8_t slot, uint8_t pin) {
+    if (slot == NO_SLOT) return NAN;
+    const Input* input = &inputs[slot];
+    if (input->pin != pin || !input->flags.isEnabled) return NAN;
+    return input->value;
+}
+
+static bool ruleHolds(uint8_t r) {
+    const AlarmRuleConfig* rule = &rules[r];
+    for (uint8_t t = 0; t < rule->numTerms; t++) {
+        const AlarmRuleTerm* term = &rule->terms[t];
+        float value = valueOf(termSlot[r][t], term->pin);
+        float operand = term->value;
+        if (term->refPin != ALARM_RULE_CONSTANT) {
+            operand += valueOf(refSlot[r][t], term->refPin);
+        }
+        if (isnan(value) || isnan(operand)) return false;
+
+        bool holds = (term->op == RULE_OP_LESS) ? (value < operand) : (value > operand);
+        if (!holds) return false;
+    }
+    return true;
+}
+
+static void refreshTarget(uint8_t slot) {
+    if (slot == NO_SLOT) return;
+    AlarmSeverity worst = SEVERITY_NORMAL;
+    for (uint8_t r = 0; r < ALARM_RULE_MAX; r++) {
+        if ((holding & (1u << r)) && termSlot[r][0] == slot && rules[r].severity > worst) {
+            worst = (AlarmSeverity)rules[r].severity;
+        }
+    }
+    ruleSeverity[slot] = worst;
+}
+
+void updateAlarmRules() {
+    uint16_t dirty = pending;
+    pending = 0;
+    for (uint8_t k = 0; k < numActiveSlots; k++) {
+        uint8_t i = activeSlots[k];
+        if (readBy[i] == 0 || inputs[i].sequence == lastSeq[i]) continue;
+        lastSeq[i] = inputs[i].sequence;
+        dirty |= readBy[i];
+    }
+
+    for (uint8_t r = 0; dirty != 0; r++, dirty >>= 1) {
+        if (!(dirty & 1)) continue;
+        uint16_t bit = 1u << r;
+        bool holds = ruleHolds(r);
+        if (holds == ((holding & bit) != 0)) continue;
+        holding ^= bit;
+        refreshTarget(termSlot[r][0]);
+    }
+}
+
+AlarmSeverity getRuleSeverity(const Input* input) {
+    uint8_t idx = input - inputs;
+    if (idx >= MAX_INPUTS) return SEVERITY_NORMAL;
+    return ruleSeverity[idx];
+}
+
+void compileAlarmRules() {
+    memset(readBy, 0, sizeof(readBy));
+    memset(ruleSeverity, 0, sizeof(ruleSeverity));
+    holding = 0;
+    pending = 0;
+
+    for (uint8_t r = 0; r < ALARM_RULE_MAX; r++) {
+        const AlarmRuleConfig* rule = &rules[r];
+        memset(termSlot[r], NO_SLOT, sizeof(termSlot[r]));
+        memset(refSlot[r], NO_SLOT, sizeof(refSlot[r]));
+        if (rule->severity == SEVERITY_NORMAL) continue;
+
+        for (uint8_t t = 0; t < rule->numTerms; t++) {
+            const AlarmRuleTerm* term = &rule->terms[t];
+            termSlot[r][t] = slotOf(term->pin);
+            if (termSlot[r][t] != NO_SLOT) readBy[termSlot[r][t]] |= 1u << r;
+            if (term->refPin == ALARM_RULE_CONSTANT) continue;
+            refSlot[r][t] = slotOf(term->refPin);
+            if (refSlot[r][t] != NO_SLOT) readBy[refSlot[r][t]] |= 1u << r;
+        }
+        pending |= 1u << r;
+    }
+}
+
+const AlarmRuleConfig* getAlarmRule(uint8_t n) {
+    return (n < ALARM_RULE_MAX) ? &rules[n] : nullptr;
+}
+
+bool setAlarmRule(uint8_t n, const AlarmRuleConfig& rule) {
+    if (n >= ALARM_RULE_MAX || rule.severity > SEVERITY_ALARM) return false;
+
+    if (rule.severity == SEVERITY_NORMAL) {
+        memset(&rules[n], 0, sizeof(AlarmRuleConfig));
+    } else {
+        if (rule.numTerms == 0 || rule.numTerms > ALARM_RULE_TERMS) return false;
+        for (uint8_t t = 0; t < rule.numTerms; t++) {
+            const AlarmRuleTerm* term = &rule.terms[t];
+            if (term->op > RULE_OP_GREATER || isnan(term->value) || isinf(term->value)) return false;
+        }
+        rules[n] = rule;
+        memset(rules[n].reserved, 0, sizeof(rules[n].reserved));
+        for (uint8_t t = rule.numTerms; t < ALARM_RULE_TERMS; t++) {
+            memset(&rules[n].terms[t], 0, sizeof(AlarmRuleTerm));
+        }
+    }
+    compileAlarmRules();
+    return true;
+}
+
+void clearAlarmRules() {
+    memset(rules, 0, sizeof(rules));
+    compileAlarmRules();
+}
+
+static void printTerm(const AlarmRuleTerm* term) {
+    printPin(term->pin);
+    msg.control.print(' ');
+    msg.control.print(term->op == RULE_OP_LESS ? '<' : '>');
+    msg.control.print(' ');
+    if (term->refPin == ALARM_RULE_CONSTANT) {
+        msg.control.print(term->value, 2);
+        return;
+    }
+    printPin(term->refPin);
+    if (term->value != 0) {
+        if (term->value > 0) msg.control.print('+');
+        msg.control.print(term->value, 2);
+    }
+}
+
+void printAlarmRule(uint8_t n) {
+    const AlarmRuleConfig* rule = getAlarmRule(n);
+    if (rule == nullptr || rule->severity == SEVERITY_NORMAL) {
+        msg.control.print(F("OFF"));
+        return;
+    }
+    for (uint8_t t = 0; t < rule->numTerms; t++) {
+        if (t == 1) msg.control.print(F(" WHEN "));
+        else if (t > 1) msg.control.print(F(" AND "));
+        printTerm(&rule->terms[t]);
+    }
+    msg.control.print(rule->severity == SEVERITY_WARNING ? F(" -> WARNING") : F(" -> ALARM"));
+    if (holding & (1u << n)) msg.control.print(F(" (holding)"));
+}
+
+void listAlarmRules() {
+    msg.control.println();
+    msg.control.print(F("===== Alarm Rules ("));
+    msg.control.print(ALARM_RULE_MAX);
+    msg.control.println(F(" slots) ====="));
+
+    uint8_t shown = 0;
+    for (uint8_t n = 0; n < ALARM_RULE_MAX; n++) {
+        if (rules[n].severity == SEVERITY_NORMAL) continue;
+        msg.control.print(F("  "));
+        msg.control.print(n);
+        msg.control.print(F(": "));
+        printAlarmRule(n);
+        msg.control.println();
+        shown++;
+    }
+    if (shown == 0) msg.control.println(F("  (none)"));
+    msg.control.println();
+}
@@ -0,0 +1,98 @@
+/*
+ * alarm_rules.h - Conditional / cross-input alarm rules
+ *
+ * A rule raises its target input's alarm when all of its terms hold. Each
+ * term compares one input with a constant or with another input plus an
+ * offset, so an alarm can depend on other readings:
+ *
+ *   SET A3 ALARM RULE 0 < 1.5 WHEN CAN:0 > 1500    oil pressure low while RPM > 1500
+ *   SET A2 ALARM RULE 1 > A5+70 WARNING             coolant 70 above ambient
+ *   SET A2 ALARM RULE 1 OFF
+ *
+ * The first term is the target's own; WHEN adds up to ALARM_RULE_TERMS - 1
+ * more, on any inputs. Values are standard units. A rule that holds is a
+ * violation of the target like a threshold one (alarm_logic.cpp: warning at
+ * once, alarm after the persist time) - or only a warning, with WARNING.
+ *
+ * Rules are kept by pin (AlarmRuleConfig, saved with the inputs) and
+ * compiled to input slots, with a mask per input of the rules that read it.
+ * updateAlarmRules() evaluates only the rules of inputs whose reading
+ * changed (Input.sequence), so its cost follows the inputs that updated,
+ * not rules x loops. A term on a missing input or a NAN reading is false.
+ *
+ * Usage:
+ *   updateAlarmRules();                    // updateAllInputAlarms() does this
+ *   AlarmSeverity s = getRuleSeverity(input);
+ *
+ * Build Flags:
+ *   -D ALARM_RULE_MAX=n     - Rules (default 8; 4 on AVR; max 16)
+ *   -D ALARM_RULE_TERMS=n   - Terms per rule (default 3)
+ */
+
+#ifndef ALARM_RULES_H
+#define ALARM_RULES_H
+
+#include <Arduino.h>
+#include "input.h"
+
+#ifndef ALARM_RULE_MAX
+#if defined(__AVR__)
+#define ALARM_RULE_MAX 4
+#else
+#define ALARM_RULE_MAX 8
+#endif
+#endif
+
+#ifndef ALARM_RULE_TERMS
+#define ALARM_RULE_TERMS 3
+#endif
+
+static_assert(ALARM_RULE_MAX <= 16, "Rule masks are 16 bits");
+
+#define ALARM_RULE_CONSTANT 0xFF            // AlarmRuleTerm.refPin: compare with value alone
+
+enum AlarmRuleOp : uint8_t {
+    RULE_OP_LESS = 0,                       // pin < operand
+    RULE_OP_GREATER = 1                     // pin > operand
+};
+
+// One comparison: pin <op> value, or pin <op> refPin + value (8 bytes)
+struct AlarmRuleTerm {
+    uint8_t pin;
+    uint8_t op;                             // AlarmRuleOp
+    uint8_t refPin;                         // ALARM_RULE_CONSTANT or a pin
+    uint8_t reserved;
+    float value;                            // Constant or offset, standard units
+};
+
+// A rule as configured and saved (28 bytes with 3 terms)
+struct AlarmRuleConfig {
+    uint8_t severity;                       // SEVERITY_NORMAL = unused slot
+    uint8_t numTerms;                       // terms[0].pin is the target
+    uint8_t reserved[2];
+    AlarmRuleTerm terms[ALARM_RULE_TERMS];
+};
+
+// Evaluate the rules whose inputs have new readings
+void updateAlarmRules();
+
+// Worst severity of the rules on this input that hold
+AlarmSeverity getRuleSeverity(const Input* input);
+
+// Rule n, or nullptr past ALARM_RULE_MAX (severity NORMAL if unused)
+const AlarmRuleConfig* getAlarmRule(uint8_t n);
+
+// Replace rule n (severity NORMAL clears it); false if invalid
+bool setAlarmRule(uint8_t n, const AlarmRuleConfig& rule);
+
+// Clear every rule
+void clearAlarmRules();
+
+// Resolve pins to input slots again (inputs added, cleared or loaded)
+void compileAlarmRules();
+
+// Print one rule ("A3 < 1.50 WHEN CAN:0 > 1500.00") / the table
+void printAlarmRule(uint8_t n);
+void listAlarmRules();
+
+#endif // ALARM_RULES_H
@@ -0,0 +1,128 @@
+/*
+ * alarm_trend.cpp - Rate-of-change (trend) alarms
+ *
+ * Times are seconds relative to the latest reading, so the moments stay
+ * small however long the input runs: each reading shifts the old ones back
+ * by dt, then joins with weight alpha = dt / (window + dt) at t = 0.
+ */
+
+#include "alarm_trend.h"
+#include "input_manager.h"
+#include "../config.h"
+#include "../lib/message_api.h"
+#include <math.h>
+
+struct InputTrendState {
+    float t;               // Weighted mean of reading times (s, <= 0)
+    float v;               // Weighted mean of values
+    float tt;              // Weighted mean of t^2
+    float tv;              // Weighted mean of t * v
+    float slope;           // Fitted slope, units/s (NAN until ready)
+    uint32_t lastMs;       // millis() of the latest reading
+    uint32_t firstMs;      // millis() of the first reading of this fit
+    uint8_t lastSeq;       // Input.sequence of the latest reading
+    uint8_t readings;      // Readings in this fit (saturates)
+};
+
+static InputTrendState trendState[MAX_INPUTS];
+
+static uint16_t trendWindow(const Input* input) {
+    return input->trendWindow ? input->trendWindow : ALARM_TREND_WINDOW_MS;
+}
+
+static void restart(InputTrendState* s) {
+    s->readings = 0;
+    s->slope = NAN;
+}
+
+void updateInputTrend(Input* input, uint32_t now) {
+    if (input->trendRate == 0) return;
+
+    uint8_t idx = input - inputs;
+    if (idx >= MAX_INPUTS) return;
+    InputTrendState* s = &trendState[idx];
+    if (s->readings > 0 && input->sequence == s->lastSeq) return;  // Nothing new
+    s->lastSeq = input->sequence;
+
+    float value = input->value;
+    if (isnan(value)) {
+        restart(s);
+        return;
+    }
+
+    if (s->readings == 0) {
+        s->t = 0;
+        s->v = value;
+        s->tt = 0;
+        s->tv = 0;
+        s->firstMs = now;
+    } else {
+        float dt = (now - s->lastMs) * 0.001f;
+        if (dt <= 0) return;
+        float alpha = dt / (trendWindow(input) * 0.001f + dt);
+        float keep = 1.0f - alpha;
+
+        // Shift the old readings back by dt: E[t - dt], E[(t - dt)^2], E[(t - dt) v]
+        s->tt = s->tt - 2.0f * dt * s->t + dt * dt;
+        s->tv = s->tv - dt * s->v;
+        s->t -= dt;
+
+        // The new reading at t = 0
+        s->t *= keep;
+        s->tt *= keep;
+        s->tv *= keep;
+        s->v = keep * s->v + alpha * value;
+    }
+    s->lastMs = now;
+    if (s->readings < 255) s->readings++;
+
+    float variance = s->tt - s->t * s->t;
+    bool ready = s->readings >= ALARM_TREND_MIN_READINGS &&
+                 now - s->firstMs >= trendWindow(input) / 2 && variance > 1e-9f;
+    s->slope = ready ? (s->tv - s->t * s->v) / variance : NAN;
+}
+
+AlarmSeverity getTrendSeverity(const Input* input) {
+    float rate = input->trendRate;
+    if (rate == 0) return SEVERITY_NORMAL;
+
+    float slope = getInputTrend(input);
+    if (isnan(slope)) return SEVERITY_NORMAL;
+
+    // Same direction as the rate, and as fast (alarm) or nearly (warning)
+    float ratio = slope / rate;
+    if (ratio >= 1.0f) return SEVERITY_ALARM;
+    if (ratio >= WARNING_THRESHOLD_PERCENT / 100.0f) return SEVERITY_WARNING;
+    return SEVERITY_NORMAL;
+}
+
+float getInputTrend(const Input* input) {
+    uint8_t idx = input - inputs;
+    if (idx >= MAX_INPUTS || input->trendRate == 0) return NAN;
+    return trendState[idx].slope;
+}
+
+void resetInputTrend(Input* input) {
+    uint8_t idx = input - inputs;
+    if (idx >= MAX_INPUTS) return;
+    restart(&trendState[idx]);
+}
+
+void printInputTrend(const Input* input) {
+    if (input->trendRate == 0) {
+        msg.control.print(F("OFF"));
+        return;
+    }
+    msg.control.print(input->trendRate, 2);
+    msg.control.print(F("/s over "));
+    msg.control.print(trendWindow(input));
+    msg.control.print(F("ms (now "));
+    float slope = getInputTrend(input);
+    if (isnan(slope)) {
+        msg.control.print(F("--"));
+    } else {
+        msg.control.print(slope, 2);
+        msg.control.print(F("/s"));
+    }
+    msg.control.print(')');
+}
@@ -0,0 +1,57 @@
+/*
+ * alarm_trend.h - Rate-of-change (trend) alarms
+ *
+ * An input with a trend rate alarms on how fast its value moves, not only
+ * on where it is - a falling oil pressure or a climbing EGT is caught while
+ * the value is still inside its thresholds:
+ *
+ *   SET A0 ALARM TREND -1.0       oil pressure falling faster than 1 bar/s
+ *   SET A3 ALARM TREND 50 500     EGT rising faster than 50 C/s, 500 ms window
+ *   SET A3 ALARM TREND OFF
+ *
+ * The rate is in standard units per second; its sign is the direction. The
+ * slope is a least-squares line through the recent readings, kept as
+ * exponentially weighted moments of time and value (four floats per input),
+ * so each new reading costs the same however many the window spans. The
+ * window is the weighting's time constant. A slope past the rate is a
+ * violation like a threshold one (alarm_logic.cpp: warning at once, alarm
+ * after the persist time); past WARNING_THRESHOLD_PERCENT of it, a warning.
+ *
+ * No trend is reported until the fit has ALARM_TREND_MIN_READINGS readings
+ * spanning half a window - or after a NAN, which restarts it.
+ *
+ * Build Flags:
+ *   -D ALARM_TREND_WINDOW_MS=n      - Default window (default 1000)
+ *   -D ALARM_TREND_MIN_READINGS=n   - Readings before a slope counts (default 4)
+ */
+
+#ifndef ALARM_TREND_H
+#define ALARM_TREND_H
+
+#include <Arduino.h>
+#include "input.h"
+
+#ifndef ALARM_TREND_WINDOW_MS
+#define ALARM_TREND_WINDOW_MS 1000
+#endif
+
+#ifndef ALARM_TREND_MIN_READINGS
+#define ALARM_TREND_MIN_READINGS 4
+#endif
+
+// Fold the input's reading into its fit if it is new (Input.sequence moved)
+void updateInputTrend(Input* input, uint32_t now);
+
+// Severity of the current slope against the input's trend rate
+AlarmSeverity getTrendSeverity(const Input* input);
+
+// Current slope, standard units per second (NAN until the fit is ready)
+float getInputTrend(const Input* input);
+
+// Forget the fit (configuration changed, alarm context restarted)
+void resetInputTrend(Input* input);
+
+// Print "OFF" / "-1.00/s over 1000ms (now -0.12/s)" to the control port
+void printInputTrend(const Input* input);
+
+#endif // ALARM_TREND_H
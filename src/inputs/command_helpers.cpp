@@ -18,10 +18,18 @@
 #include "../lib/application_presets.h"
 #include "../lib/sensor_library.h"
 #include "../lib/units_registry.h"
+#include "../lib/ext_adc.h"  // ADC:n pins
+#include "../lib/gps.h"  // GPS:n pins
+#include "../lib/timebase.h"  // TIME_SYNC
+#include "../lib/adc_scan.h"  // Sensor supply compensation
 #include "input.h"  // For Input struct definition
 #include "input_manager.h"  // For inputs[] array access
+#include "input_math.h"  // MATH:n pins
+#include "../outputs/host_subscription.h"  // HOST_SUBSCRIPTIONS
+#include "command_script.h"  // COMMAND_SCRIPTS
 #include <string.h>
 #include <ctype.h>
+#include <math.h>
 
 // Helper: trim whitespace in-place
 void trim(char* str) {
@@ -79,6 +87,20 @@ MessagePlane parsePlane(const char* str, bool* isValid) {
     return PLANE_CONTROL;  // Safe default (but isValid=false indicates error)
 }
 
+// Helper: Parse TX overflow policy name
+TxOverflowPolicy parseTxPolicy(const char* str, bool* isValid) {
+    static const TxOverflowPolicy policies[] = {TX_POLICY_DEFAULT, TX_DROP_OLDEST, TX_DROP_NEWEST, TX_BLOCK};
+    for (TxOverflowPolicy policy : policies) {
+        if (streq(str, MessageRouter::getTxPolicyName(policy))) {
+            if (isValid) *isValid = true;
+            return policy;
+        }
+    }
+
+    if (isValid) *isValid = false;
+    return TX_POLICY_DEFAULT;
+}
+
 // Helper: Parse transport ID
 TransportID parseTransport(const char* str, bool* isValid) {
     if (streq(str, "USB_SERIAL") || streq(str, "USB") || streq(str, "SERIAL")) {
@@ -121,6 +143,18 @@ TransportID parseTransport(const char* str, bool* isValid) {
         if (isValid) *isValid = true;
         return TRANSPORT_ESP32_BT;
     }
+    if (streq(str, "BLE_DATA") || streq(str, "ESP32_BLE_DATA")) {
+        if (isValid) *isValid = true;
+        return TRANSPORT_ESP32_BLE_DATA;
+    }
+    if (streq(str, "WIFI") || streq(str, "ESP32_WIFI")) {
+        if (isValid) *isValid = true;
+        return TRANSPORT_ESP32_WIFI;
+    }
+    if (streq(str, "WIFI_UDP") || streq(str, "ESP32_WIFI_UDP")) {
+        if (isValid) *isValid = true;
+        return TRANSPORT_ESP32_WIFI_UDP;
+    }
     if (streq(str, "NONE")) {
         if (isValid) *isValid = true;
         return TRANSPORT_NONE;
@@ -298,6 +332,23 @@ void printSystemConfig() {
     msg.control.print(F("ADC Reference: "));
     msg.control.print(AREF_VOLTAGE);
     msg.control.println(F("V"));
+#ifdef ADC_SUPPLY_PIN
+    msg.control.print(F("Sensor Supply: "));
+    float supply = getAdcSupplyVoltage();
+    if (isnan(supply)) {
+        msg.control.println(F("not measured yet"));
+    } else {
+        msg.control.print(supply, 3);
+        msg.control.print(F("V (nominal "));
+        msg.control.print(ADC_SUPPLY_NOMINAL);
+        msg.control.print(F("V), correction x"));
+        msg.control.print(getAdcSupplyFactor(), 4);
+        if (fabs(supply / ADC_SUPPLY_NOMINAL - 1.0) > ADC_SUPPLY_MAX_DEVIATION) {
+            msg.control.print(F(" - out of range, not applied"));
+        }
+        msg.control.println();
+    }
+#endif
     msg.control.print(F("ADC Resolution: "));
     msg.control.print(ADC_RESOLUTION);
     msg.control.println(F(" bits"));
@@ -379,6 +430,7 @@ void printHelpList() {
     msg.control.println(F("  LIST SENSORS        - Show available Sensor Types"));
     msg.control.println(F("  LIST OUTPUTS        - Show available output modules"));
     msg.control.println(F("  LIST TRANSPORTS     - Show available transports"));
+    msg.control.println(F("  LIST RULES          - Show alarm rules"));
     msg.control.println();
 }
 
@@ -403,6 +455,28 @@ void printHelpSet() {
     msg.control.println(F("  SET <pin> ALARM DISABLE  - Disable alarm for input"));
     msg.control.println(F("  SET <pin> ALARM WARMUP <ms>  - Alarm warmup time (0-300000ms)"));
     msg.control.println(F("  SET <pin> ALARM PERSIST <ms>  - Alarm persistence time (0-60000ms)"));
+    msg.control.println(F("  SET <pin> ALARM CLEAR <ms>  - Time back to normal before the alarm clears (0-60000ms)"));
+    msg.control.println(F("  SET <pin> ALARM WARN <min> <max>|AUTO  - Warning thresholds (AUTO = % of alarm)"));
+    msg.control.println(F("  SET <pin> ALARM WARN PERSIST|CLEAR <ms>  - Warning persist / clear times"));
+    msg.control.println(F("  SET <pin> ALARM HYSTERESIS <alarm> [<warn>]  - Exit bands (standard units)"));
+    msg.control.println(F("  SET <pin> ALARM TREND <units/s>|OFF [<ms>]  - Rate-of-change alarm (window 50-60000ms)"));
+    msg.control.println(F("  SET <pin> ALARM RULE <n> <|> <value|pin[+k]> [WHEN <pin> <|> <value|pin[+k]> [AND ...]] [WARNING]"));
+    msg.control.println(F("                       - Conditional / cross-input alarm (RULE <n> OFF removes)"));
+    msg.control.println();
+    msg.control.println(F("Filtering:"));
+    msg.control.println(F("  SET <pin> FILTER EMA <tau_ms>  - Moving average, time constant in ms"));
+    msg.control.println(F("  SET <pin> FILTER MEDIAN <3|5>  - Median of last 3 or 5 readings"));
+    msg.control.println(F("  SET <pin> FILTER SLEW <units_per_s>  - Rate limit (standard units)"));
+    msg.control.println(F("  SET <pin> FILTER NONE  - Raw readings"));
+    msg.control.println();
+    msg.control.println(F("Read rate:"));
+    msg.control.println(F("  SET <pin> RATE ADAPTIVE <max_ms> <units_per_s>  - Slow down while stable"));
+    msg.control.println(F("  SET <pin> RATE FIXED  - Read at the sensor interval (default)"));
+    msg.control.println();
+    msg.control.println(F("Math channels (MATH:0-15):"));
+    msg.control.println(F("  SET MATH:<n> <application> MATH  - Create; units, alarms and OBD from the application"));
+    msg.control.println(F("  SET MATH:<n> MATH [INTEGRATE] <pin> [+|-|*|/ <pin|value>] [* <k>] [+|- <c>]"));
+    msg.control.println(F("                       - Derived value, left to right (INTEGRATE: total over seconds)"));
     msg.control.println();
     msg.control.println(F("See also: HELP CALIBRATION for advanced sensor calibration"));
     msg.control.println();
@@ -436,6 +510,20 @@ void printHelpControl() {
     msg.control.println(F("  INFO <pin>  - Show detailed pin info"));
     msg.control.println(F("  INFO <pin> ALARM  - Show alarm status and configuration"));
     msg.control.println(F("  INFO <pin> CALIBRATION  - Show calibration details"));
+    msg.control.println(F("  INFO <pin> HEALTH  - Show read failures, latency and fault reason"));
+    msg.control.println(F("  INFO <pin> SUMMARY  - Show min/max/mean/stddev since boot and this session"));
+    msg.control.println(F("  INFO <pin>|ALL SUMMARY RESET  - Start a new session"));
+#ifdef ENABLE_ALARMS
+    msg.control.println(F("  ALARM HISTORY [count]  - Show recent alarm/warning changes (saved in EEPROM)"));
+    msg.control.println(F("  ALARM HISTORY CLEAR  - Clear the alarm history (CONFIG mode)"));
+#endif
+#ifdef ENABLE_STATS
+    msg.control.println(F("  STATS  - Distance, engine hours and time at temperature (saved in EEPROM)"));
+    msg.control.println(F("  STATS RESET [<pin>]  - Zero all totals, or one input's (CONFIG mode)"));
+#endif
+#if TIME_SYNC
+    msg.control.println(F("  TIME  - Show UTC time, its source (PPS/RTC) and the clock's drift"));
+#endif
     msg.control.println();
 }
 
@@ -445,9 +533,21 @@ void printHelpOutput() {
     msg.control.println(F("Configure CAN, RealDash, Serial, and SD logging"));
     msg.control.println();
     msg.control.println(F("  OUTPUT STATUS  - Show current output states"));
-    msg.control.println(F("  OUTPUT <name> ENABLE  - Enable output (CAN, RealDash, Serial, SD_Log)"));
+    msg.control.println(F("  OUTPUT <name> ENABLE  - Enable output (CAN, RealDash, Serial, SD_Log, MQTT)"));
     msg.control.println(F("  OUTPUT <name> DISABLE  - Disable output"));
     msg.control.println(F("  OUTPUT <name> INTERVAL <ms>  - Set output interval"));
+    msg.control.println(F("  OUTPUT <name> MODE <PERIODIC|CHANGE|HEARTBEAT> [deadband]"));
+    msg.control.println(F("    PERIODIC  - Send every input each interval (default)"));
+    msg.control.println(F("    CHANGE    - Send an input only when it moves more than deadband"));
+    msg.control.println(F("    HEARTBEAT - CHANGE, plus every input each interval"));
+    msg.control.println(F("  OUTPUT <name> AGGREGATE <LAST|MEAN|MIN|MAX>"));
+    msg.control.println(F("    LAST      - Send the latest reading each interval (default)"));
+    msg.control.println(F("    MEAN/MIN/MAX - Send that statistic of every reading since the last send"));
+#ifdef ENABLE_MQTT
+    msg.control.println(F("  OUTPUT MQTT FORMAT <JSON|BINARY>  - Payload of each batched publish"));
+    msg.control.println(F("  OUTPUT MQTT QOS <0|1>  - 1 = resend until the broker acknowledges"));
+    msg.control.println(F("  OUTPUT MQTT STATUS  - Broker session, published/dropped counters, queue"));
+#endif
     msg.control.println();
 }
 
@@ -458,13 +558,24 @@ void printHelpBus() {
     msg.control.println();
     msg.control.println(F("Display Bus Configuration:"));
     msg.control.println(F("  BUS I2C                   - Show all I2C bus status"));
-    msg.control.println(F("  BUS SPI                   - Show all SPI bus status"));
+    msg.control.println(F("  BUS SPI                   - Show SPI bus status, device classes, utilization"));
     msg.control.println(F("  BUS CAN                   - Show all CAN bus status"));
     msg.control.println(F("  BUS SERIAL                - Show all serial port status"));
+#ifdef ENABLE_EXT_ADC
+    msg.control.println(F("  BUS ADC                   - External ADCs, channels in use (ADC:n)"));
+#endif
+#ifdef ENABLE_GPS
+    msg.control.println(F("  BUS GPS                   - GPS receiver, fix, position and UTC"));
+#endif
+#ifdef ENABLE_MODBUS
+    msg.control.println(F("  BUS MODBUS                - Modbus slave counters and register map"));
+#endif
     msg.control.println();
     msg.control.println(F("I2C Bus Commands:"));
     msg.control.println(F("  BUS I2C [0|1|2]           - Select I2C bus (Wire/Wire1/Wire2)"));
     msg.control.println(F("  BUS I2C CLOCK <kHz>       - Set I2C clock (100, 400, 1000)"));
+    msg.control.println(F("  BUS I2C RECOVER           - Clock out a stuck slave, restart the bus"));
+    msg.control.println(F("  BUS I2C SCAN              - List devices that answer, update the inventory"));
     msg.control.println();
     msg.control.println(F("SPI Bus Commands:"));
     msg.control.println(F("  BUS SPI [0|1|2]           - Select SPI bus (SPI/SPI1/SPI2)"));
@@ -474,6 +585,12 @@ void printHelpBus() {
     msg.control.println(F("  BUS CAN [0|1|2]           - Select CAN bus (CAN1/CAN2/CAN3)"));
     msg.control.println(F("  BUS CAN BAUDRATE <bps>    - Set CAN baudrate"));
     msg.control.println(F("    Valid baudrates: 125000, 250000, 500000, 1000000"));
+#ifdef ENABLE_CAN_NODES
+    msg.control.println(F("  BUS CAN NODE              - Node number, channels, nodes seen, imports"));
+    msg.control.println(F("  BUS CAN NODE ID <0-15|OFF> - Join the node network on the output bus"));
+    msg.control.println(F("  BUS CAN NODE SUBSCRIBE <n> - Import node n's channels as NODE:n inputs"));
+    msg.control.println(F("  BUS CAN NODE UNSUBSCRIBE <n> - Stop importing (existing inputs stay)"));
+#endif
     msg.control.println();
     msg.control.println(F("Serial Port Commands:"));
     msg.control.println(F("  BUS SERIAL <1-8>          - Show specific port status"));
@@ -481,6 +598,9 @@ void printHelpBus() {
     msg.control.println(F("  BUS SERIAL <1-8> DISABLE  - Disable port"));
     msg.control.println(F("  BUS SERIAL <1-8> BAUDRATE <rate> - Set baud rate"));
     msg.control.println(F("    Valid rates: 9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600"));
+    msg.control.println(F("    Teensy 4.x / ESP32 also: 1000000, 2000000, 3000000, 4000000"));
+    msg.control.println(F("  BUS SERIAL <1-8> FLOW <rts> <cts> - RTS/CTS flow control, one port (Teensy 4.x)"));
+    msg.control.println(F("  BUS SERIAL <1-8> FLOW OFF - No flow control"));
     msg.control.println();
     msg.control.println(F("Examples:"));
     msg.control.println(F("  BUS I2C 1                 # Select Wire1"));
@@ -496,11 +616,14 @@ void printHelpRelay() {
     msg.control.println(F("Threshold-based relay outputs for cooling fans, alarms, etc."));
     msg.control.println();
     msg.control.println(F("  RELAY LIST  - Show all relay status"));
-    msg.control.println(F("  RELAY <0-1> STATUS  - Show specific relay"));
-    msg.control.println(F("  RELAY <0-1> PIN <pin>  - Set relay output pin"));
-    msg.control.println(F("  RELAY <0-1> INPUT <pin>  - Link relay to sensor input"));
-    msg.control.println(F("  RELAY <0-1> THRESHOLD <on> <off>  - Set activation thresholds"));
-    msg.control.println(F("  RELAY <0-1> MODE <DISABLED|AUTO_HIGH|AUTO_LOW|MANUAL_ON|MANUAL_OFF>"));
+    msg.control.println(F("  RELAY <n> STATUS  - Show specific relay"));
+    msg.control.println(F("  RELAY <n> PIN <pin>  - Set relay output pin"));
+    msg.control.println(F("  RELAY <n> INPUT <pin>  - Link relay to sensor input"));
+    msg.control.println(F("  RELAY <n> THRESHOLD <on> <off>  - Set activation thresholds"));
+    msg.control.println(F("  RELAY <n> MINTIME <on_ms> <off_ms>  - Minimum on/off times (0-60000)"));
+    msg.control.println(F("  RELAY <n> CURVE <LINEAR|QUADRATIC|FAN|PUMP>  - PWM duty curve (OFF value = 0%, ON value = 100%)"));
+    msg.control.println(F("  RELAY <n> FREQUENCY <hz>  - PWM frequency (0 = platform default)"));
+    msg.control.println(F("  RELAY <n> MODE <DISABLED|AUTO_HIGH|AUTO_LOW|MANUAL_ON|MANUAL_OFF|PWM>"));
     msg.control.println();
 }
 #endif
@@ -513,6 +636,8 @@ void printHelpTest() {
     msg.control.println();
     msg.control.println(F("  TEST LIST  - Show available test scenarios"));
     msg.control.println(F("  TEST <0-4>  - Start a specific test scenario"));
+    msg.control.println(F("  TEST FILE <file> [LOOP]  - Play a recorded CSV trace from SD"));
+    msg.control.println(F("  TEST CERTIFY [<seconds>] [CAN <percent>]  - Worst-case load run and loop-time report"));
     msg.control.println(F("  TEST STOP  - Stop current test scenario"));
     msg.control.println(F("  TEST STATUS  - Show current test status"));
     msg.control.println();
@@ -533,6 +658,9 @@ void printHelpDisplay() {
     msg.control.println(F("  DISPLAY TYPE <LCD|OLED|NONE>"));
     msg.control.println(F("  DISPLAY ADDRESS <hex>    - I2C address (LCD only)"));
     msg.control.println(F("  DISPLAY INTERVAL <ms>    - Display refresh rate"));
+    msg.control.println(F("  DISPLAY PAGE <n>|NEXT    - Show an LCD page (also in RUN mode)"));
+    msg.control.println(F("  DISPLAY ROTATE <seconds> - Page rotation (0 = manual)"));
+    msg.control.println(F("  DISPLAY PIN ON|OFF       - Pin inputs in alarm to every page"));
     msg.control.println();
     msg.control.println(F("Note: Unit preferences moved to SYSTEM UNITS"));
     msg.control.println();
@@ -543,10 +671,31 @@ void printHelpTransport() {
     msg.control.println(F("=== TRANSPORT Commands ==="));
     msg.control.println(F("Route control, data, and debug messages"));
     msg.control.println();
-    msg.control.println(F("  TRANSPORT STATUS  - Show current transport routing"));
+    msg.control.println(F("  TRANSPORT STATUS  - Show routing, traffic and TX buffer counters"));
+    msg.control.println(F("  TRANSPORT RESET  - Restart the traffic counters (rates from now)"));
+    msg.control.println(F("  TRANSPORT FRAMING [ON|OFF]  - Frame every write on this transport by plane"));
+    msg.control.println(F("      ('c' control, 'd' data, 'g' debug; RAM only, serial transports)"));
     msg.control.println(F("  TRANSPORT CONTROL <transport>  - Route control messages"));
     msg.control.println(F("  TRANSPORT DATA <transport>  - Route sensor data output"));
     msg.control.println(F("  TRANSPORT DEBUG <transport>  - Route debug messages"));
+    msg.control.println(F("  TRANSPORT <plane> ADD <transport>  - Also send the plane to a transport"));
+    msg.control.println(F("  TRANSPORT <plane> REMOVE <transport>  - Stop sending it there"));
+    msg.control.println(F("  TRANSPORT PROFILE <transport>  - Show a transport's data plane profile"));
+    msg.control.println(F("  TRANSPORT PROFILE <transport> RATE <bytes/s>  - Cap its data rate (0 = none)"));
+    msg.control.println(F("  TRANSPORT PROFILE <transport> STREAMS <streams>  - Data it takes:"));
+    msg.control.println(F("      TEXT, REALDASH, SERIAL, ALL, NONE"));
+    msg.control.println(F("  TRANSPORT PROFILE <transport> CLEAR  - All streams, unshaped"));
+    msg.control.println(F("  TRANSPORT <plane> POLICY <policy>  - When a TX buffer is full:"));
+    msg.control.println(F("      DROP_NEWEST (data/debug default), DROP_OLDEST,"));
+    msg.control.println(F("      BLOCK (CONTROL only, its default), DEFAULT"));
+#if HOST_SUBSCRIPTIONS
+    msg.control.println();
+    msg.control.println(F("Host subscriptions (this transport, RAM only):"));
+    msg.control.println(F("  SUBSCRIBE <pin|name>[@hz] ... [FORMAT CSV|BINARY]  - Stream only these"));
+    msg.control.println(F("      channels here, each at its rate (default 10 Hz)"));
+    msg.control.println(F("  SUBSCRIBE STATUS  - Subscribed transports and channels"));
+    msg.control.println(F("  SUBSCRIBE STOP  - Back to the regular data plane"));
+#endif
     msg.control.println();
     msg.control.println(F("  (Use LIST TRANSPORTS to see available transports)"));
     msg.control.println();
@@ -562,6 +711,26 @@ void printHelpSystem() {
     msg.control.println(F("  SYSTEM STATUS           - Show all global configuration"));
     msg.control.println(F("  SYSTEM DUMP             - Show complete system dump"));
     msg.control.println(F("  SYSTEM DUMP JSON        - Export configuration as JSON"));
+    msg.control.println(F("  SYSTEM DUMP BIN         - Export as binary IMPORT lines (paste back)"));
+    msg.control.println(F("  SYSTEM LOOP             - Loop budget overruns (this + previous boot)"));
+    msg.control.println(F("  SYSTEM EEPROM           - Queued EEPROM writes, wear per region"));
+    msg.control.println(F("  SYSTEM MEMORY           - Static tables, heap, stack high-water mark"));
+#ifdef ENABLE_POWER_MANAGER
+    msg.control.println(F("  SYSTEM POWER            - Engine-off sources, sleeps, time to first data"));
+    msg.control.println(F("  SYSTEM POWER SLEEP      - Sleep now until ignition/CAN/serial wakes it"));
+#endif
+#ifdef ENABLE_POWER_FAIL
+#ifndef ENABLE_POWER_MANAGER
+    msg.control.println(F("  SYSTEM POWER            - Supply sense, power failures, flush time"));
+#endif
+    msg.control.println(F("  SYSTEM POWER FAIL       - Run the power-fail flush now (hold-up test)"));
+#endif
+#ifdef ENABLE_TASK_WATCHDOG
+    msg.control.println(F("  SYSTEM WATCHDOG         - Task heartbeats, last task-miss reset"));
+#endif
+#ifdef ENABLE_BENCHMARK
+    msg.control.println(F("  SYSTEM BENCHMARK [CSV] [<kernel>] - Time the hot-path kernels"));
+#endif
     msg.control.println();
 
     msg.control.println(F("Pin Status:"));
@@ -580,6 +749,8 @@ void printHelpSystem() {
     msg.control.println(F("  SYSTEM SEA_LEVEL <hPa>  - For altitude calculations"));
     msg.control.println(F("  SYSTEM INTERVAL <type> <ms> - Global timing intervals"));
     msg.control.println(F("    Types: SENSOR, ALARM"));
+    msg.control.println(F("  SYSTEM LOOP BUDGET <ms> - Soft loop deadline (not saved)"));
+    msg.control.println(F("  SYSTEM LOOP RESET       - Clear overrun history"));
     msg.control.println();
 
     msg.control.println(F("System Control:"));
@@ -605,13 +776,33 @@ void printHelpConfig() {
     msg.control.println(F("      SAVE config.json                # Default to SD"));
     msg.control.println(F("      SAVE SD:mycar.json              # Explicit SD"));
     msg.control.println(F("      SAVE USB:backup.json            # USB (if available)"));
+    msg.control.println(F("      SAVE SD:mycar.bin               # Binary blob (.bin)"));
     msg.control.println();
     msg.control.println(F("  LOAD [dest:]file        - Load config from file"));
     msg.control.println(F("    Examples:"));
     msg.control.println(F("      LOAD racing.json                # Load from SD"));
     msg.control.println(F("      LOAD SD:backup.json             # Explicit SD"));
     msg.control.println(F("      LOAD USB:restore.json           # USB (if available)"));
+    msg.control.println(F("      LOAD SD:mycar.bin               # Binary blob (by content)"));
+    msg.control.println();
+    msg.control.println(F("Binary Import (CONFIG mode):"));
+    msg.control.println(F("  IMPORT BEGIN|<base64>|END - Paste the lines SYSTEM DUMP BIN prints"));
+    msg.control.println(F("  CONFIG HASH             - CRC-32 of the config (any mode); a patch"));
+    msg.control.println(F("                            made for it may be imported after BEGIN"));
+    msg.control.println();
+    msg.control.println(F("Transactions (bulk configuration):"));
+    msg.control.println(F("  BEGIN                   - Stage changes: no per-command validation"));
+    msg.control.println(F("                            or rebuilds, inputs not read"));
+    msg.control.println(F("  COMMIT                  - Validate all inputs, apply once"));
+    msg.control.println(F("                            (invalid: everything rolled back)"));
+    msg.control.println(F("  ROLLBACK                - Restore inputs as they were at BEGIN"));
+    msg.control.println();
+#if COMMAND_SCRIPTS
+    msg.control.println(F("Scripts (SD card, CONFIG mode):"));
+    msg.control.println(F("  RUN [SD:]<script>       - Run /scripts/<script> in one transaction,"));
+    msg.control.println(F("                            one summary instead of per-command output"));
     msg.control.println();
+#endif
     msg.control.println(F("Modes:"));
     msg.control.println(F("  CONFIG                  - Enter configuration mode"));
     msg.control.println(F("  RUN                     - Enter run mode"));
@@ -638,9 +829,23 @@ void printHelpExamples() {
     msg.control.println(F("  SET I2C:0 ALARM 10 50  (modify existing I2C sensor)"));
     msg.control.println(F("  INFO I2C:1  (query I2C sensor)"));
     msg.control.println();
+#ifdef ENABLE_EXT_ADC
+    msg.control.println(F("External ADC channels (MCP3208 ADC:0-7, ADS1115 ADC:8-15):"));
+    msg.control.println(F("  SET ADC:0 OIL_TEMP VDO_150C_STEINHART"));
+    msg.control.println(F("  BUS ADC  (chips and latest counts)"));
+    msg.control.println();
+#endif
+#ifdef ENABLE_GPS
+    msg.control.println(F("GPS inputs (GPS:0-7):"));
+    msg.control.println(F("  SET GPS:0 VEHICLE_SPEED GPS_SPEED"));
+    msg.control.println(F("  SET GPS:1 ELEVATION GPS_ALTITUDE"));
+    msg.control.println(F("  BUS GPS  (fix, position and UTC)"));
+    msg.control.println();
+#endif
     msg.control.println(F("CAN sensor import (OBD-II, J1939):"));
     msg.control.println(F("  SET CAN 0x0C  (import Engine RPM from CAN bus)"));
     msg.control.println(F("  SET CAN 0x0D  (import Vehicle Speed)"));
+    msg.control.println(F("  SET CAN FRAME 0x3E9  (import a broadcast frame)"));
     msg.control.println(F("  SET CAN:0 ALARM 500 6000  (modify CAN sensor)"));
     msg.control.println();
     msg.control.println(F("Advanced sensor setup:"));
@@ -654,8 +859,13 @@ void printHelpExamples() {
     msg.control.println(F("Alarm configuration:"));
     msg.control.println(F("  SET A2 ALARM 50 120  (set alarm thresholds)"));
     msg.control.println(F("  SET A2 ALARM ENABLE  (enable alarm)"));
+    msg.control.println(F("  SET A3 ALARM RULE 0 < 1.5 WHEN CAN:0 > 1500  (low oil pressure above 1500 RPM)"));
     msg.control.println(F("  INFO A2 ALARM  (show alarm status)"));
     msg.control.println();
+    msg.control.println(F("Math channels:"));
+    msg.control.println(F("  SET MATH:0 OIL_TEMP MATH"));
+    msg.control.println(F("  SET MATH:0 MATH A6 - A7  (oil minus coolant)"));
+    msg.control.println();
     msg.control.println(F("Output and control:"));
     msg.control.println(F("  ENABLE A2"));
     msg.control.println(F("  OUTPUT CAN ENABLE"));
@@ -721,13 +931,22 @@ void printHelpQuick() {
     msg.control.println(F("Notation: <required> <option1|option2> [optional]"));
     msg.control.println();
     msg.control.println(F("Discovery:"));
-    msg.control.println(F("  LIST INPUTS|APPLICATIONS|SENSORS|OUTPUTS|TRANSPORTS"));
+    msg.control.println(F("  LIST INPUTS|APPLICATIONS|SENSORS|OUTPUTS|TRANSPORTS|RULES"));
     msg.control.println();
     msg.control.println(F("Input Control:"));
     msg.control.println(F("  ENABLE <pin>"));
     msg.control.println(F("  DISABLE <pin>"));
     msg.control.println(F("  CLEAR <pin>"));
     msg.control.println(F("  INFO [<pin>] [ALARM|CALIBRATION]"));
+#ifdef ENABLE_ALARMS
+    msg.control.println(F("  ALARM HISTORY [count]|CLEAR"));
+#endif
+#ifdef ENABLE_STATS
+    msg.control.println(F("  STATS [RESET [<pin>]]"));
+#endif
+#if TIME_SYNC
+    msg.control.println(F("  TIME"));
+#endif
     msg.control.println();
     msg.control.println(F("Input Configuration:"));
     msg.control.println(F("  SET <pin> <app> <sensor>"));
@@ -738,7 +957,18 @@ void printHelpQuick() {
     msg.control.println(F("  SET <pin> UNITS <units>"));
     msg.control.println(F("  SET <pin> ALARM <min> <max>"));
     msg.control.println(F("  SET <pin> ALARM ENABLE|DISABLE"));
-    msg.control.println(F("  SET <pin> ALARM WARMUP|PERSIST <ms>"));
+    msg.control.println(F("  SET <pin> ALARM WARMUP|PERSIST|CLEAR <ms>"));
+    msg.control.println(F("  SET <pin> ALARM WARN <min> <max>|AUTO|PERSIST <ms>|CLEAR <ms>"));
+    msg.control.println(F("  SET <pin> ALARM HYSTERESIS <alarm> [<warn>]"));
+    msg.control.println(F("  SET <pin> ALARM TREND <units/s>|OFF [<ms>]"));
+    msg.control.println(F("  SET <pin> ALARM RULE <n> <|> <operand> [WHEN ...] [WARNING] | OFF"));
+    msg.control.println(F("  SET <pin> FILTER NONE|EMA|MEDIAN|SLEW [param]"));
+    msg.control.println(F("  SET <pin> RATE FIXED|ADAPTIVE <max_ms> <units_per_s>"));
+    msg.control.println(F("  SET MATH:<n> MATH [INTEGRATE] <pin> [<op> <pin|value>] [* <k>] [+|- <c>]"));
+#ifdef ENABLE_CAN
+    msg.control.println(F("  SET <pin> CAN_TIMEOUT <ms>|AUTO|DEFAULT"));
+    msg.control.println(F("  SET <pin> CAN_SIGNAL <start_bit> <bits> LE|BE [scale] [offset]"));
+#endif
     msg.control.println(F("  SET <pin> CALIBRATION PRESET"));
     msg.control.println(F("  SET <pin> RPM|SPEED|PRESSURE_LINEAR|STEINHART|BETA|BIAS|PRESSURE_POLY ..."));
     msg.control.println();
@@ -746,6 +976,8 @@ void printHelpQuick() {
     msg.control.println(F("  OUTPUT STATUS"));
     msg.control.println(F("  OUTPUT <module> ENABLE|DISABLE"));
     msg.control.println(F("  OUTPUT <module> INTERVAL <ms>"));
+    msg.control.println(F("  OUTPUT <module> MODE <PERIODIC|CHANGE|HEARTBEAT> [deadband]"));
+    msg.control.println(F("  OUTPUT <module> AGGREGATE <LAST|MEAN|MIN|MAX>"));
     msg.control.println();
     msg.control.println(F("Bus Configuration:"));
     msg.control.println(F("  BUS I2C|SPI|CAN"));
@@ -753,20 +985,60 @@ void printHelpQuick() {
     msg.control.println(F("  BUS I2C <0-2> CLOCK <100|400|1000>"));
     msg.control.println(F("  BUS SPI <0-2> CLOCK <Hz>"));
     msg.control.println(F("  BUS CAN <0-2> BAUDRATE <125000|250000|500000|1000000>"));
+#ifdef ENABLE_CAN_NODES
+    msg.control.println(F("  BUS CAN NODE [ID <0-15|OFF>|SUBSCRIBE <n>|UNSUBSCRIBE <n>]"));
+#endif
 #ifdef ENABLE_RELAY_OUTPUT
     msg.control.println();
     msg.control.println(F("Relays:"));
     msg.control.println(F("  RELAY LIST"));
-    msg.control.println(F("  RELAY <0-1> STATUS"));
-    msg.control.println(F("  RELAY <0-1> PIN|INPUT <pin>"));
-    msg.control.println(F("  RELAY <0-1> THRESHOLD <on> <off>"));
-    msg.control.println(F("  RELAY <0-1> MODE <DISABLED|AUTO_HIGH|AUTO_LOW|MANUAL_ON|MANUAL_OFF>"));
+    msg.control.println(F("  RELAY <n> STATUS"));
+    msg.control.println(F("  RELAY <n> PIN|INPUT <pin>"));
+    msg.control.println(F("  RELAY <n> THRESHOLD <on> <off>"));
+    msg.control.println(F("  RELAY <n> MINTIME <on_ms> <off_ms>"));
+    msg.control.println(F("  RELAY <n> CURVE <LINEAR|QUADRATIC|FAN|PUMP> | FREQUENCY <hz>"));
+    msg.control.println(F("  RELAY <n> MODE <DISABLED|AUTO_HIGH|AUTO_LOW|MANUAL_ON|MANUAL_OFF|PWM>"));
 #endif
 #ifdef ENABLE_TEST_MODE
     msg.control.println();
     msg.control.println(F("Test Mode:"));
     msg.control.println(F("  TEST LIST|STATUS|STOP"));
     msg.control.println(F("  TEST <0-4>"));
+#endif
+#ifdef ENABLE_PROFILER
+    msg.control.println();
+    msg.control.println(F("Profiler:"));
+    msg.control.println(F("  PROFILE [RESET]"));
+#endif
+#ifdef ENABLE_TRACE
+    msg.control.println();
+    msg.control.println(F("Latency Trace:"));
+    msg.control.println(F("  TRACE [START [<pin>] | STOP | DUMP]"));
+#endif
+#ifdef ENABLE_RAW_TRACE
+    msg.control.println();
+    msg.control.println(F("Raw Trace:"));
+    msg.control.println(F("  RAW RECORD [<file>] | REPLAY <file> [LOOP]"));
+    msg.control.println(F("  RAW [STATUS] | STOP"));
+#endif
+#if defined(ENABLE_CAN_REPLAY) && defined(ENABLE_CAN)
+    msg.control.println();
+    msg.control.println(F("CAN Replay:"));
+    msg.control.println(F("  SCAN REPLAY <file>|STREAM [SPEED <x>|MAX] [TX <CAN1|CAN2|CAN3>] [LOOP]"));
+    msg.control.println(F("  SCAN REPLAY STATUS|STOP"));
+#endif
+#ifdef ENABLE_BENCH_STREAM
+    msg.control.println();
+    msg.control.println(F("Bench Streaming:"));
+    msg.control.println(F("  BENCH [STATUS]"));
+    msg.control.println(F("  BENCH START [rate_hz]"));
+    msg.control.println(F("  BENCH STOP"));
+#endif
+#if HOST_SUBSCRIPTIONS
+    msg.control.println();
+    msg.control.println(F("Host Subscriptions:"));
+    msg.control.println(F("  SUBSCRIBE <pin|name>[@hz] ... [FORMAT CSV|BINARY]"));
+    msg.control.println(F("  SUBSCRIBE STATUS|STOP"));
 #endif
     msg.control.println();
     msg.control.println(F("Display:"));
@@ -775,6 +1047,9 @@ void printHelpQuick() {
     msg.control.println(F("  DISPLAY TYPE <LCD|OLED|NONE>"));
     msg.control.println(F("  DISPLAY ADDRESS <hex>"));
     msg.control.println(F("  DISPLAY INTERVAL <ms>"));
+    msg.control.println(F("  DISPLAY PAGE <n>|NEXT"));
+    msg.control.println(F("  DISPLAY ROTATE <seconds>"));
+    msg.control.println(F("  DISPLAY PIN ON|OFF"));
     msg.control.println();
     msg.control.println(F("Transport:"));
     msg.control.println(F("  TRANSPORT STATUS|LIST"));
@@ -782,10 +1057,19 @@ void printHelpQuick() {
     msg.control.println();
     msg.control.println(F("System:"));
     msg.control.println(F("  SYSTEM STATUS"));
-    msg.control.println(F("  SYSTEM DUMP [JSON]"));
+    msg.control.println(F("  SYSTEM DUMP [JSON|BIN]"));
     msg.control.println(F("  SYSTEM UNITS <TEMP|PRESSURE|ELEVATION|SPEED> <unit>"));
     msg.control.println(F("  SYSTEM SEA_LEVEL <hPa>"));
     msg.control.println(F("  SYSTEM INTERVAL <SENSOR|ALARM> <ms>"));
+    msg.control.println(F("  SYSTEM LOOP [RESET | BUDGET <ms>]"));
+    msg.control.println(F("  SYSTEM EEPROM"));
+    msg.control.println(F("  SYSTEM MEMORY"));
+#ifdef ENABLE_TASK_WATCHDOG
+    msg.control.println(F("  SYSTEM WATCHDOG"));
+#endif
+#ifdef ENABLE_BENCHMARK
+    msg.control.println(F("  SYSTEM BENCHMARK [CSV] [<kernel>]"));
+#endif
     msg.control.println(F("  SYSTEM REBOOT"));
     msg.control.println(F("  SYSTEM RESET CONFIRM"));
     msg.control.println();
@@ -793,6 +1077,8 @@ void printHelpQuick() {
     msg.control.println(F("  CONFIG|RUN|RELOAD"));
     msg.control.println(F("  SAVE [EEPROM|[dest:]file]"));
     msg.control.println(F("  LOAD [EEPROM|[dest:]file]"));
+    msg.control.println(F("  IMPORT BEGIN|<base64>|END"));
+    msg.control.println(F("  BEGIN|COMMIT|ROLLBACK"));
     msg.control.println(F("  RESET"));
     msg.control.println(F("  VERSION"));
     msg.control.println();
@@ -803,9 +1089,11 @@ void printHelpQuick() {
 /**
  * Parse a pin string into a pin number.
  * Accepts "A0"-"A15" for analog pins, numeric strings for digital pins,
- * or "I2C" for I2C sensors (BME280, etc).
+ * "I2C" for I2C sensors (BME280, etc), "ADC:n" for external ADC channels,
+ * "GPS:n" for GPS inputs, "NODE:n" for channels of other units, or "MATH:n"
+ * for math channels.
  */
-uint8_t parsePin(const char* pinStr, bool* isValid) {
+InputPin parsePin(const char* pinStr, bool* isValid) {
     if (!pinStr) {
         if (isValid) *isValid = false;
         return 0;
@@ -850,34 +1138,34 @@ uint8_t parsePin(const char* pinStr, bool* isValid) {
 
     // Handle "CAN" keyword for CAN-imported sensors (OBD-II, J1939, custom)
     // Use a virtual pin counter to allow multiple CAN sensors
-    // Virtual pins start at 0xC0 (192) - matches CAN virtual pin allocation
+    // Virtual pins are CAN:0 (0xC0) up - see CAN_PIN() in input.h
     if (streq(pinStr, "CAN")) {
-        static uint8_t canVirtualPinCounter = 0xC0;
+        static uint16_t canChannelCounter = 0;
 
-        // Find highest allocated CAN virtual pin and continue from there
+        // Find highest allocated CAN channel and continue from there
         // This handles EEPROM loads where pins were already allocated
-        uint8_t highestAllocated = 0xBF;  // Start before CAN range
+        int highestAllocated = -1;
         for (uint8_t i = 0; i < MAX_INPUTS; i++) {
-            if (inputs[i].pin >= 0xC0 && inputs[i].pin < 0xE0) {
-                if (inputs[i].pin > highestAllocated) {
-                    highestAllocated = inputs[i].pin;
-                }
+            if (CAN_IS_PIN(inputs[i].pin) && (int)CAN_PIN_CHANNEL(inputs[i].pin) > highestAllocated) {
+                highestAllocated = CAN_PIN_CHANNEL(inputs[i].pin);
             }
         }
 
-        // Set counter to next available slot
-        if (highestAllocated >= 0xC0) {
-            canVirtualPinCounter = highestAllocated + 1;
+        // Set counter to next available channel
+        if (highestAllocated >= 0) {
+            canChannelCounter = highestAllocated + 1;
         }
 
-        // Check if we've exceeded the virtual pin range (0xC0-0xDF = 32 sensors)
-        if (canVirtualPinCounter >= 0xE0) {
-            msg.control.println(F("ERROR: Too many CAN sensors configured (max 32)"));
+        // Check if we've exceeded the virtual pin range
+        if (canChannelCounter >= CAN_PINS) {
+            msg.control.print(F("ERROR: Too many CAN sensors configured (max "));
+            msg.control.print(CAN_PINS);
+            msg.control.println(F(")"));
             if (isValid) *isValid = false;
             return 0;
         }
 
-        return canVirtualPinCounter++;
+        return CAN_PIN(canChannelCounter++);
     }
 
     // Handle "CAN:n" format for referencing existing CAN sensors (e.g., "CAN:0", "CAN:1")
@@ -885,18 +1173,84 @@ uint8_t parsePin(const char* pinStr, bool* isValid) {
         const char* numStr = pinStr + 4;
         int canIndex = atoi(numStr);
 
-        // Validate CAN index range (0-31 for 32 total CAN sensors)
-        if (canIndex < 0 || canIndex > 31) {
+        // Validate CAN index range
+        if (canIndex < 0 || canIndex >= CAN_PINS) {
             msg.control.print(F("ERROR: CAN index "));
             msg.control.print(canIndex);
-            msg.control.println(F(" out of range (valid: 0-31)"));
+            msg.control.print(F(" out of range (valid: 0-"));
+            msg.control.print(CAN_PINS - 1);
+            msg.control.println(F(")"));
             if (isValid) *isValid = false;
             return 0;
         }
 
         // Convert CAN index to virtual pin number
-        uint8_t virtualPin = 0xC0 + canIndex;
-        return virtualPin;
+        return CAN_PIN(canIndex);
+    }
+
+    // Handle "MATH:n" for math channels (input_math.h)
+    if (strncmp(pinStr, "MATH:", 5) == 0 || strncmp(pinStr, "math:", 5) == 0) {
+        int channel = atoi(pinStr + 5);
+        if (channel < 0 || channel >= MATH_CHANNELS) {
+            msg.control.print(F("ERROR: MATH channel "));
+            msg.control.print(channel);
+            msg.control.println(F(" out of range (valid: 0-15)"));
+            if (isValid) *isValid = false;
+            return 0;
+        }
+        return MATH_PIN(channel);
+    }
+
+    // Handle "NODE:n" for channels of other units (lib/can_node.h)
+    if (strncmp(pinStr, "NODE:", 5) == 0 || strncmp(pinStr, "node:", 5) == 0) {
+        int index = atoi(pinStr + 5);
+        if (index < 0 || index >= NODE_PINS) {
+            msg.control.print(F("ERROR: NODE channel "));
+            msg.control.print(index);
+            msg.control.println(F(" out of range (valid: 0-31)"));
+            if (isValid) *isValid = false;
+            return 0;
+        }
+        return NODE_PIN(index);
+    }
+
+    // Handle "GPS:n" for GPS inputs (lib/gps.h)
+    if (strncmp(pinStr, "GPS:", 4) == 0 || strncmp(pinStr, "gps:", 4) == 0) {
+#ifdef ENABLE_GPS
+        int index = atoi(pinStr + 4);
+        if (index < 0 || index >= GPS_PINS) {
+            msg.control.print(F("ERROR: GPS input "));
+            msg.control.print(index);
+            msg.control.println(F(" out of range (valid: 0-7)"));
+            if (isValid) *isValid = false;
+            return 0;
+        }
+        return GPS_PIN(index);
+#else
+        msg.control.println(F("ERROR: GPS not compiled in (-D ENABLE_GPS)"));
+        if (isValid) *isValid = false;
+        return 0;
+#endif
+    }
+
+    // Handle "ADC:n" for external ADC channels (lib/ext_adc.h) - before the
+    // analog pins, which also start with 'A'
+    if (strncmp(pinStr, "ADC:", 4) == 0 || strncmp(pinStr, "adc:", 4) == 0) {
+#ifdef ENABLE_EXT_ADC
+        int channel = atoi(pinStr + 4);
+        if (channel < 0 || channel >= EXT_ADC_CHANNELS) {
+            msg.control.print(F("ERROR: ADC channel "));
+            msg.control.print(channel);
+            msg.control.println(F(" out of range (valid: 0-15)"));
+            if (isValid) *isValid = false;
+            return 0;
+        }
+        return EXT_ADC_PIN(channel);
+#else
+        msg.control.println(F("ERROR: External ADCs not compiled in (-D ENABLE_EXT_ADC)"));
+        if (isValid) *isValid = false;
+        return 0;
+#endif
     }
 
     // Analog pins
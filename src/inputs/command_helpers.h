@@ -7,6 +7,9 @@
 
 #include <stdint.h>
 #include "../lib/message_router.h"
+#include "../lib/hash.h"
+#include "../hal/hal_placement.h"
+#include "input.h"  // InputPin
 
 // Forward declarations for enums
 enum MessagePlane;
@@ -17,13 +20,18 @@ void trim(char* str);
 void toUpper(char* str);
 bool streq(const char* a, const char* b);
 
+// streq() against a literal for a token hashed once (djb2_hash(token)):
+// a miss is one 16-bit compare, a hit is confirmed by name
+#define TOKEN_IS(token, tokenHash, name) ((tokenHash) == DJB2(name) && streq((token), (name)))
+
 // Pin parsing
-uint8_t parsePin(const char* pinStr, bool* isValid);
+InputPin parsePin(const char* pinStr, bool* isValid);
 void resetVirtualPinCounters();  // Reset CAN/I2C virtual pin allocation counters
 
 // Transport parsing (returns valid enum + sets isValid flag)
 MessagePlane parsePlane(const char* str, bool* isValid);
 TransportID parseTransport(const char* str, bool* isValid);
+TxOverflowPolicy parseTxPolicy(const char* str, bool* isValid);
 
 // File path parsing for SAVE/LOAD commands
 struct FilePathComponents {
@@ -39,32 +47,32 @@ struct FilePathComponents {
 FilePathComponents parseFilePath(const char* pathStr);
 
 // System status printers
-void printDisplayConfig();
+HAL_COLD_CODE void printDisplayConfig();
 
-// Help system
-void printHelpOverview();
-void printHelpQuick();
-void printHelpCategory(const char* category);
+// Help system (cold - flash on Teensy 4, see hal_placement.h)
+HAL_COLD_CODE void printHelpOverview();
+HAL_COLD_CODE void printHelpQuick();
+HAL_COLD_CODE void printHelpCategory(const char* category);
 
 // Individual help printer functions
-void printHelpList();
-void printHelpSet();
-void printHelpCalibration();
-void printHelpControl();
-void printHelpOutput();
-void printHelpBus();
-void printHelpDisplay();
-void printHelpTransport();
-void printHelpSystem();
-void printHelpConfig();
-void printHelpExamples();
+HAL_COLD_CODE void printHelpList();
+HAL_COLD_CODE void printHelpSet();
+HAL_COLD_CODE void printHelpCalibration();
+HAL_COLD_CODE void printHelpControl();
+HAL_COLD_CODE void printHelpOutput();
+HAL_COLD_CODE void printHelpBus();
+HAL_COLD_CODE void printHelpDisplay();
+HAL_COLD_CODE void printHelpTransport();
+HAL_COLD_CODE void printHelpSystem();
+HAL_COLD_CODE void printHelpConfig();
+HAL_COLD_CODE void printHelpExamples();
 
 #ifdef ENABLE_RELAY_OUTPUT
-void printHelpRelay();
+HAL_COLD_CODE void printHelpRelay();
 #endif
 
 #ifdef ENABLE_TEST_MODE
-void printHelpTest();
+HAL_COLD_CODE void printHelpTest();
 #endif
 
 #endif // _COMMAND_HELPERS_H_
@@ -0,0 +1,211 @@
+/*
+ * command_script.cpp - Command scripts from SD, applied in one batch
+ */
+
+#include "command_script.h"
+
+#if COMMAND_SCRIPTS
+
+#include "command_table.h"
+#include "command_helpers.h"
+#include "input_manager.h"
+#include "../lib/message_api.h"
+#include "../lib/log_tags.h"
+#include "../lib/sd_manager.h"
+#include "../lib/system_mode.h"
+#include "../lib/response_stream.h"
+#include <SD.h>
+
+#define SCRIPT_DIR "/scripts"
+#define SCRIPT_MAX_ARGS 16          // As many as the prompt takes (serial_config.cpp)
+#define SCRIPT_CAPTURE_BYTES 256    // A failing command's answer, shown with the summary
+
+static bool running = false;
+static char captured[SCRIPT_CAPTURE_BYTES];
+
+// Read one line (CR/LF stripped, overlong lines cut); false at end of file
+static bool readLine(File& file, char* line, uint16_t size, bool* cut) {
+    uint16_t len = 0;
+    *cut = false;
+    int c = file.read();
+    if (c < 0) return false;
+    while (c >= 0 && c != '\n') {
+        if (c != '\r') {
+            if (len + 1 < size) line[len++] = (char)c;
+            else *cut = true;
+        }
+        c = file.read();
+    }
+    line[len] = '\0';
+    return true;
+}
+
+// Split a line in place into argv (space/tab separated, "double quotes" keep spaces)
+static int tokenize(char* line, const char** argv) {
+    int argc = 0;
+    char* p = line;
+    while (*p && argc < SCRIPT_MAX_ARGS) {
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '\0') break;
+        if (*p == '"') {
+            argv[argc++] = ++p;
+            while (*p && *p != '"') p++;
+        } else {
+            argv[argc++] = p;
+            while (*p && *p != ' ' && *p != '\t') p++;
+        }
+        if (*p) *p++ = '\0';
+    }
+    return argc;
+}
+
+// Captured output, indented under the summary
+static void printCaptured() {
+    const char* p = captured;
+    while (*p) {
+        msg.control.print(F("  "));
+        const char* end = p;
+        while (*end && *end != '\n') end++;
+        while (p < end) {
+            if (*p != '\r') msg.control.print(*p);
+            p++;
+        }
+        msg.control.println();
+        if (*p) p++;
+    }
+}
+
+// The script's lines through the dispatcher; false at the first that fails
+static bool runLines(File& file, const char* filename, uint16_t* commands, bool* saveAfter) {
+    char line[SCRIPT_LINE_MAX];
+    char copy[SCRIPT_LINE_MAX];
+    const char* argv[SCRIPT_MAX_ARGS];
+    uint16_t lineNumber = 0;
+    bool cut;
+
+    while (readLine(file, line, sizeof(line), &cut)) {
+        lineNumber++;
+        strcpy(copy, line);                 // tokenize() splits line - copy for the error
+        int argc = tokenize(line, argv);
+        if (argc == 0 || argv[0][0] == '#') continue;
+
+        if (streq(argv[0], "BEGIN") || streq(argv[0], "COMMIT") || streq(argv[0], "ROLLBACK")) {
+            continue;                       // The script is the transaction
+        }
+        if (streq(argv[0], "SAVE") && argc == 1) {
+            *saveAfter = true;              // Once the transaction has committed
+            continue;
+        }
+
+        int result = 1;
+        router.setControlCapture(captured, sizeof(captured));
+        if (cut) {
+            msg.control.println(F("ERROR: Line too long (SCRIPT_LINE_MAX)"));
+        } else if (streq(argv[0], "RUN")) {
+            msg.control.println(F("ERROR: RUN inside a script"));
+        } else {
+            result = dispatchCommand(argc, argv);
+            if (responseActive()) finishResponse();  // LIST and DUMP answer later - into the capture now
+        }
+        router.setControlCapture(nullptr, 0);
+
+        if (result != 0) {
+            msg.control.print(F("Script "));
+            msg.control.print(filename);
+            msg.control.print(F(": line "));
+            msg.control.print(lineNumber);
+            msg.control.print(F(" failed: "));
+            msg.control.println(copy);
+            printCaptured();
+            return false;
+        }
+        (*commands)++;
+    }
+    return true;
+}
+
+int runCommandScript(const char* filename) {
+    if (running) {
+        msg.control.println(F("ERROR: RUN inside a script"));
+        return 1;
+    }
+    if (!isInConfigMode()) {
+        msg.control.println(F("ERROR: RUN <script> needs CONFIG mode"));
+        return 1;
+    }
+    if (isInputTransactionActive()) {
+        msg.control.println(F("ERROR: Config transaction open - COMMIT or ROLLBACK first"));
+        return 1;
+    }
+    if (!isSDInitialized()) {
+        msg.control.println(F("ERROR: SD card not available"));
+        return 1;
+    }
+
+    char path[48];
+    snprintf(path, sizeof(path), (filename[0] == '/') ? SCRIPT_DIR "%s" : SCRIPT_DIR "/%s", filename);
+    File file = SD.open(path, FILE_READ);
+    if (!file) {
+        msg.control.print(F("ERROR: Failed to open script: "));
+        msg.control.println(path);
+        return 1;
+    }
+
+    uint32_t start = millis();
+    uint16_t commands = 0;
+    bool saveAfter = false;
+    bool staged = CONFIG_TRANSACTIONS && beginInputTransaction();
+
+    running = true;
+    bool ok = runLines(file, filename, &commands, &saveAfter);
+    running = false;
+    file.close();
+
+    if (!ok) {
+        if (staged) rollbackInputTransaction();
+        msg.control.print(F("  "));
+        msg.control.print(commands);
+        msg.control.println(staged ? F(" commands before it ran; input changes rolled back")
+                                   : F(" commands before it ran and were applied"));
+        return 1;
+    }
+
+    if (staged && !commitInputTransaction()) {
+        msg.control.print(F("Script "));
+        msg.control.print(filename);
+        msg.control.println(F(": configuration invalid - input changes rolled back"));
+        return 1;
+    }
+
+    if (saveAfter) {
+        const char* save[] = { "SAVE" };
+        router.setControlCapture(captured, sizeof(captured));
+        int result = dispatchCommand(1, save);
+        router.setControlCapture(nullptr, 0);
+        if (result != 0) {
+            msg.control.print(F("Script "));
+            msg.control.print(filename);
+            msg.control.println(F(": applied, SAVE failed"));
+            printCaptured();
+            return 1;
+        }
+    }
+
+    msg.control.print(F("Script "));
+    msg.control.print(filename);
+    msg.control.print(F(": "));
+    msg.control.print(commands);
+    msg.control.print(F(" commands in "));
+    msg.control.print(millis() - start);
+    msg.control.print(F(" ms, "));
+    msg.control.print(numActiveInputs);
+    msg.control.print(F(" inputs active"));
+    msg.control.println(saveAfter ? F(", saved") : F(""));
+    return 0;
+}
+
+bool isCommandScriptRunning() {
+    return running;
+}
+
+#endif // COMMAND_SCRIPTS
@@ -0,0 +1,62 @@
+/*
+ * command_script.h - Command scripts from SD, applied in one batch
+ *
+ * Provisioning over serial means pasting dozens of SET / BUS / OUTPUT lines,
+ * each echoed and answered on its own - minutes over BLE for a full unit.
+ * RUN <script> reads /scripts/<script> from the SD card and runs every line
+ * through dispatchCommand() in the same call:
+ *
+ *   - One command per line, as typed at the prompt; blank lines and lines
+ *     starting with # are skipped
+ *   - Each command's output is captured (MessageRouter::setControlCapture())
+ *     instead of sent; the script answers with one summary
+ *   - Input changes are staged in a config transaction (input_manager.h),
+ *     validated and applied once at the end, so the schedule is rebuilt once
+ *   - A failing line stops the script: its own output is shown and the
+ *     transaction rolled back. System changes (BUS, OUTPUT, TRANSPORT) made
+ *     by earlier lines stay, as they do at the prompt
+ *   - SAVE lines run after the commit; BEGIN / COMMIT / ROLLBACK lines are
+ *     skipped (the script is the transaction); RUN lines are refused
+ *
+ * CONFIG mode only. Without CONFIG_TRANSACTIONS the lines still run in one
+ * batch, each applied as it runs.
+ *
+ * Usage:
+ *   RUN provision.txt         // /scripts/provision.txt
+ *   RUN SD:provision.txt
+ *
+ * Build Flags:
+ *   -D SCRIPT_LINE_MAX=n     - Longest script line (default 128)
+ */
+
+#ifndef COMMAND_SCRIPT_H
+#define COMMAND_SCRIPT_H
+
+#include <Arduino.h>
+#include "../config.h"
+
+#if defined(ENABLE_SD_LOGGING) || defined(ENABLE_JSON_CONFIG)
+#define COMMAND_SCRIPTS 1
+#else
+#define COMMAND_SCRIPTS 0
+#endif
+
+#ifndef SCRIPT_LINE_MAX
+#define SCRIPT_LINE_MAX 128
+#endif
+
+#if COMMAND_SCRIPTS
+
+/**
+ * Run a script file (RUN <script>)
+ * @param filename  Name under /scripts (SD: prefix already stripped)
+ * @return 0 if every line ran and the transaction committed, else 1
+ */
+int runCommandScript(const char* filename);
+
+// A script is running - RUN inside one is refused
+bool isCommandScriptRunning();
+
+#endif // COMMAND_SCRIPTS
+
+#endif // COMMAND_SCRIPT_H
@@ -11,11 +11,18 @@
 #include "command_table.h"
 #include "command_helpers.h"
 #include "input_manager.h"
+#include "sensors/adc_lut.h"
+#include "input_filter.h"
+#include "input_rate.h"
+#include "alarm_trend.h"
+#include "alarm_rules.h"
+#include "input_math.h"
 #include "../config.h"
 #include "../version.h"
 #include "../lib/system_mode.h"
 #include "../lib/system_config.h"
 #include "../lib/json_config.h"
+#include "../lib/config_blob.h"
 #include "../lib/message_router.h"
 #include "../lib/message_api.h"
 #include "../lib/log_filter.h"
@@ -25,20 +32,69 @@
 #include "../lib/sensor_library.h"
 #include "../lib/platform.h"
 #include "../lib/bus_manager.h"
+#include "../lib/i2c_engine.h"
+#include "../lib/device_inventory.h"
 #include "../lib/bus_defaults.h"
 #include "../lib/serial_manager.h"
 #include "../lib/pin_registry.h"
 #include "../outputs/output_base.h"
+#include "../outputs/output_can.h"
+#include "../outputs/output_realdash.h"
+#include "../outputs/output_serial.h"
+#include "../outputs/output_mqtt.h"
 #include "../lib/display_manager.h"
+#include "../displays/lcd_layout.h"
+#include "../lib/loop_monitor.h"
+#include "../lib/eeprom_store.h"
+#include "../lib/memory_report.h"
+#include "../lib/response_stream.h"
+#include "../hal/hal_placement.h"
+#include "../lib/static_pool.h"
+#include "../lib/timebase.h"
+#include "../lib/can_node.h"
+#include "alarm_journal.h"
+#include "input_stats.h"
+#include "input_summary.h"
 #ifdef ENABLE_RELAY_OUTPUT
 #include "../outputs/output_relay.h"
 #endif
 #ifdef ENABLE_TEST_MODE
 #include "../test/test_mode.h"
 #endif
+#ifdef ENABLE_PROFILER
+#include "../lib/profiler.h"
+#endif
+#ifdef ENABLE_BENCHMARK
+#include "../lib/benchmark.h"
+#endif
+#ifdef ENABLE_TRACE
+#include "../lib/latency_trace.h"
+#endif
+#ifdef ENABLE_RAW_TRACE
+#include "../lib/raw_trace.h"
+#endif
+#ifdef ENABLE_BENCH_STREAM
+#include "../outputs/bench_stream.h"
+#endif
+#include "../outputs/host_subscription.h"
+#ifdef ENABLE_EXT_ADC
+#include "../lib/ext_adc.h"
+#endif
+#include "../lib/gps.h"  // GPS:n pins
+#include "../lib/modbus.h"
+#include "../lib/power_manager.h"
+#include "../lib/power_fail.h"
+#include "command_script.h"
+#include "../lib/watchdog.h"
 #ifdef ENABLE_CAN
 #include "sensors/can/can_scan.h"
+#include "sensors/can/can_frame_cache.h"
+#include "sensors/can/can_signal.h"
+#include "input_can.h"
 #include "../lib/can_sensor_library/standard_pids.h"
+#ifdef ENABLE_CAN_REPLAY
+#include "../lib/can_replay.h"
+#endif
 #endif
 #include <string.h>
 #include <ctype.h>
@@ -49,38 +105,68 @@
     #include <avr/wdt.h>
 #endif
 
-// Forward declarations of command handlers
-static int cmd_help(int argc, const char* const* argv);
-static int cmd_list(int argc, const char* const* argv);
-static int cmd_set(int argc, const char* const* argv);
-static int cmd_enable(int argc, const char* const* argv);
-static int cmd_disable(int argc, const char* const* argv);
-static int cmd_clear(int argc, const char* const* argv);
-static int cmd_info(int argc, const char* const* argv);
-static int cmd_output(int argc, const char* const* argv);
-static int cmd_display(int argc, const char* const* argv);
-static int cmd_transport(int argc, const char* const* argv);
-static int cmd_system(int argc, const char* const* argv);
-static int cmd_save(int argc, const char* const* argv);
-static int cmd_load(int argc, const char* const* argv);
-static int cmd_config(int argc, const char* const* argv);
-static int cmd_run(int argc, const char* const* argv);
-static int cmd_version(int argc, const char* const* argv);
-static int cmd_reboot(int argc, const char* const* argv);
-static int cmd_bus(int argc, const char* const* argv);
-static int cmd_log(int argc, const char* const* argv);
+// Forward declarations of command handlers (run when typed - flash on Teensy 4)
+HAL_COLD_CODE static int cmd_help(int argc, const char* const* argv);
+HAL_COLD_CODE static int cmd_list(int argc, const char* const* argv);
+HAL_COLD_CODE static int cmd_set(int argc, const char* const* argv);
+HAL_COLD_CODE static int cmd_enable(int argc, const char* const* argv);
+HAL_COLD_CODE static int cmd_disable(int argc, const char* const* argv);
+HAL_COLD_CODE static int cmd_clear(int argc, const char* const* argv);
+HAL_COLD_CODE static int cmd_info(int argc, const char* const* argv);
+HAL_COLD_CODE static int cmd_output(int argc, const char* const* argv);
+HAL_COLD_CODE static int cmd_display(int argc, const char* const* argv);
+HAL_COLD_CODE static int cmd_transport(int argc, const char* const* argv);
+HAL_COLD_CODE static int cmd_system(int argc, const char* const* argv);
+HAL_COLD_CODE static int cmd_save(int argc, const char* const* argv);
+HAL_COLD_CODE static int cmd_load(int argc, const char* const* argv);
+HAL_COLD_CODE static int cmd_import(int argc, const char* const* argv);
+HAL_COLD_CODE static int cmd_config(int argc, const char* const* argv);
+HAL_COLD_CODE static int cmd_run(int argc, const char* const* argv);
+HAL_COLD_CODE static int cmd_version(int argc, const char* const* argv);
+HAL_COLD_CODE static int cmd_reboot(int argc, const char* const* argv);
+HAL_COLD_CODE static int cmd_bus(int argc, const char* const* argv);
+HAL_COLD_CODE static int cmd_log(int argc, const char* const* argv);
+HAL_COLD_CODE static int cmd_begin(int argc, const char* const* argv);
+HAL_COLD_CODE static int cmd_commit(int argc, const char* const* argv);
+HAL_COLD_CODE static int cmd_rollback(int argc, const char* const* argv);
+#ifdef ENABLE_ALARMS
+HAL_COLD_CODE static int cmd_alarm(int argc, const char* const* argv);
+#endif
+#ifdef ENABLE_STATS
+HAL_COLD_CODE static int cmd_stats(int argc, const char* const* argv);
+#endif
+#if TIME_SYNC
+HAL_COLD_CODE static int cmd_time(int argc, const char* const* argv);
+#endif
 #ifdef ENABLE_RELAY_OUTPUT
-static int cmd_relay(int argc, const char* const* argv);
+HAL_COLD_CODE static int cmd_relay(int argc, const char* const* argv);
 #endif
 #ifdef ENABLE_TEST_MODE
-static int cmd_test(int argc, const char* const* argv);
+HAL_COLD_CODE static int cmd_test(int argc, const char* const* argv);
 #endif
 #ifdef ENABLE_CAN
-static int cmd_scan(int argc, const char* const* argv);
+HAL_COLD_CODE static int cmd_scan(int argc, const char* const* argv);
+#endif
+#ifdef ENABLE_PROFILER
+HAL_COLD_CODE static int cmd_profile(int argc, const char* const* argv);
+#endif
+#ifdef ENABLE_TRACE
+HAL_COLD_CODE static int cmd_trace(int argc, const char* const* argv);
+#endif
+#ifdef ENABLE_RAW_TRACE
+HAL_COLD_CODE static int cmd_raw(int argc, const char* const* argv);
+#endif
+#ifdef ENABLE_BENCH_STREAM
+HAL_COLD_CODE static int cmd_bench(int argc, const char* const* argv);
+#endif
+#if HOST_SUBSCRIPTIONS
+HAL_COLD_CODE static int cmd_subscribe(int argc, const char* const* argv);
 #endif
 
 // Platform-specific reboot helper (shared by REBOOT and SYSTEM REBOOT/RESET)
 static void platformReboot() {
+    loopMonitorPrepareReset();  // Intentional - don't report it as a stalled segment
+    flushEEPROMStore();         // A SAVE just before still being written
     delay(100);
     #if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__) || \
         defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
@@ -97,75 +183,158 @@ static void platformReboot() {
 }
 
 // Command table
-const Command COMMANDS[] = {
+constexpr Command COMMANDS[] = {
     // Mode commands (always available)
-    {"CONFIG", cmd_config, "Enter configuration mode", false},
-    {"RUN", cmd_run, "Enter run mode", false},
+    COMMAND("CONFIG", cmd_config, "Enter configuration mode / CONFIG HASH", false),
+    COMMAND("RUN", cmd_run, "Enter run mode / RUN <script> from SD", false),
 
     // Query commands (read-only, available in both modes)
-    {"HELP", cmd_help, "Show help", false},
-    {"?", cmd_help, "Show help (alias)", false},
-    {"LIST", cmd_list, "List inputs/applications/sensors", false},
-    {"INFO", cmd_info, "Show input details", false},
-    {"VERSION", cmd_version, "Show firmware version", false},
+    COMMAND("HELP", cmd_help, "Show help", false),
+    COMMAND("?", cmd_help, "Show help (alias)", false),
+    COMMAND("LIST", cmd_list, "List inputs/applications/sensors", false),
+    COMMAND("INFO", cmd_info, "Show input details", false),
+    COMMAND("VERSION", cmd_version, "Show firmware version", false),
 
     // Configuration commands (CONFIG mode only)
-    {"SET", cmd_set, "Configure input", true},
-    {"ENABLE", cmd_enable, "Enable input", true},
-    {"DISABLE", cmd_disable, "Disable input", true},
-    {"CLEAR", cmd_clear, "Clear input", true},
-    {"OUTPUT", cmd_output, "Configure outputs", true},
-    {"DISPLAY", cmd_display, "Configure display", true},
-    {"TRANSPORT", cmd_transport, "Configure message routing", true},
-    {"SYSTEM", cmd_system, "System configuration", true},
-    {"SAVE", cmd_save, "Save configuration", true},
-    {"LOAD", cmd_load, "Load configuration", true},
-    {"REBOOT", cmd_reboot, "", true},  // Undocumented alias for SYSTEM REBOOT
-    {"BUS", cmd_bus, "Configure I2C/SPI/CAN buses", true},
-    {"LOG", cmd_log, "Configure log levels and tags", false},
+    COMMAND("SET", cmd_set, "Configure input", true),
+    COMMAND("ENABLE", cmd_enable, "Enable input", true),
+    COMMAND("DISABLE", cmd_disable, "Disable input", true),
+    COMMAND("CLEAR", cmd_clear, "Clear input", true),
+    COMMAND("OUTPUT", cmd_output, "Configure outputs", true),
+    COMMAND("DISPLAY", cmd_display, "Configure display", true),
+    COMMAND("TRANSPORT", cmd_transport, "Configure message routing", true),
+    COMMAND("SYSTEM", cmd_system, "System configuration", true),
+    COMMAND("SAVE", cmd_save, "Save configuration", true),
+    COMMAND("LOAD", cmd_load, "Load configuration", true),
+    COMMAND("IMPORT", cmd_import, "Import a binary config (SYSTEM DUMP BIN lines)", true),
+    COMMAND("BEGIN", cmd_begin, "Start a config transaction", true),
+    COMMAND("COMMIT", cmd_commit, "Validate and apply a config transaction", true),
+    COMMAND("ROLLBACK", cmd_rollback, "Discard a config transaction", true),
+    COMMAND("REBOOT", cmd_reboot, "", true),  // Undocumented alias for SYSTEM REBOOT
+    COMMAND("BUS", cmd_bus, "Configure I2C/SPI/CAN buses", true),
+    COMMAND("LOG", cmd_log, "Configure log levels and tags", false),
+#ifdef ENABLE_ALARMS
+    COMMAND("ALARM", cmd_alarm, "Alarm event history", false),
+#endif
+#ifdef ENABLE_STATS
+    COMMAND("STATS", cmd_stats, "Distance, engine hours, time at temperature", false),
+#endif
+#if TIME_SYNC
+    COMMAND("TIME", cmd_time, "UTC time, its sync source and drift", false),
+#endif
 
 #ifdef ENABLE_RELAY_OUTPUT
-    {"RELAY", cmd_relay, "Configure relay outputs", true},
+    COMMAND("RELAY", cmd_relay, "Configure relay outputs", true),
 #endif
 #ifdef ENABLE_TEST_MODE
-    {"TEST", cmd_test, "Test mode control", false},
+    COMMAND("TEST", cmd_test, "Test mode control", false),
 #endif
 #ifdef ENABLE_CAN
-    {"SCAN", cmd_scan, "Scan CAN bus for PIDs", true},
+    COMMAND("SCAN", cmd_scan, "Scan CAN bus for PIDs", false),
+#endif
+#ifdef ENABLE_PROFILER
+    COMMAND("PROFILE", cmd_profile, "Show loop/task timing", false),
+#endif
+#ifdef ENABLE_TRACE
+    COMMAND("TRACE", cmd_trace, "Sample-to-wire latency", false),
+#endif
+#ifdef ENABLE_RAW_TRACE
+    COMMAND("RAW", cmd_raw, "Record or replay raw acquisitions", false),
+#endif
+#ifdef ENABLE_BENCH_STREAM
+    COMMAND("BENCH", cmd_bench, "High-rate ADC streaming", false),
+#endif
+#if HOST_SUBSCRIPTIONS
+    COMMAND("SUBSCRIBE", cmd_subscribe, "Stream chosen channels to this host", false),
 #endif
 };
 
 const uint8_t NUM_COMMANDS = sizeof(COMMANDS) / sizeof(Command);
 
+// Compile-time check that no two command names share a hash
+constexpr bool commandHashFree(uint8_t i, uint8_t j) {
+    return j >= sizeof(COMMANDS) / sizeof(Command) ||
+           (COMMANDS[i].nameHash != COMMANDS[j].nameHash && commandHashFree(i, j + 1));
+}
+
+constexpr bool commandHashesUnique(uint8_t i) {
+    return i >= sizeof(COMMANDS) / sizeof(Command) ||
+           (commandHashFree(i, i + 1) && commandHashesUnique(i + 1));
+}
+
+static_assert(commandHashesUnique(0), "Two command names hash alike - rename one");
+
 // Check if command is read-only (allowed in RUN mode)
 bool isReadOnlyCommand(const char* cmdName) {
-    return streq(cmdName, "HELP") ||
-           streq(cmdName, "?") ||
-           streq(cmdName, "VERSION") ||
-           streq(cmdName, "INFO") ||
-           streq(cmdName, "LIST") ||
-           streq(cmdName, "CONFIG") ||
-           streq(cmdName, "RUN") ||
-           streq(cmdName, "SYSTEM") ||  // Allow SYSTEM STATUS and SYSTEM DUMP in RUN mode
-           streq(cmdName, "LOG") ||     // Allow LOG STATUS, LOG TAGS in RUN mode (LEVEL/TAG require CONFIG)
+    switch (djb2_hash(cmdName)) {
+        case DJB2("HELP"):
+        case DJB2("?"):
+        case DJB2("VERSION"):
+        case DJB2("INFO"):
+        case DJB2("LIST"):
+        case DJB2("CONFIG"):
+        case DJB2("RUN"):
+        case DJB2("SYSTEM"):    // Allow SYSTEM STATUS and SYSTEM DUMP in RUN mode
+        case DJB2("LOG"):       // Allow LOG STATUS, LOG TAGS in RUN mode (LEVEL/TAG require CONFIG)
+        case DJB2("TRANSPORT"): // STATUS and RESET only - routing changes need CONFIG (cmd_transport)
+        case DJB2("DISPLAY"):   // STATUS and PAGE only - settings need CONFIG (cmd_display)
+#ifdef ENABLE_ALARMS
+        case DJB2("ALARM"):     // HISTORY only - HISTORY CLEAR needs CONFIG (cmd_alarm)
+#endif
+#ifdef ENABLE_STATS
+        case DJB2("STATS"):     // Totals only - RESET needs CONFIG (cmd_stats)
+#endif
+#if TIME_SYNC
+        case DJB2("TIME"):
+#endif
 #ifdef ENABLE_TEST_MODE
-           streq(cmdName, "TEST") ||
+        case DJB2("TEST"):
+#endif
+#ifdef ENABLE_PROFILER
+        case DJB2("PROFILE"):
 #endif
-           false;
+#ifdef ENABLE_TRACE
+        case DJB2("TRACE"):
+#endif
+#ifdef ENABLE_RAW_TRACE
+        case DJB2("RAW"):       // SD file and RAM only - configuration untouched
+#endif
+#ifdef ENABLE_CAN
+        case DJB2("SCAN"):      // Listens only - configuration untouched
+#endif
+#if HOST_SUBSCRIPTIONS
+        case DJB2("SUBSCRIBE"): // RAM only - configuration untouched
+#endif
+            return true;
+        default:
+            return false;
+    }
 }
 
 // Main command dispatcher
 int dispatchCommand(int argc, const char* const* argv) {
     if (argc == 0) return 0;
 
-    // Convert command name to uppercase for comparison
-    char cmdUpper[32];
-    strncpy(cmdUpper, argv[0], sizeof(cmdUpper) - 1);
-    cmdUpper[sizeof(cmdUpper) - 1] = '\0';
-    for (char* p = cmdUpper; *p; p++) *p = toupper(*p);
+    // Look up the command by hash (case-insensitive), confirmed by name
+    uint16_t hash = djb2_hash(argv[0]);
+    const Command* command = nullptr;
+    for (uint8_t i = 0; i < NUM_COMMANDS; i++) {
+        if (COMMANDS[i].nameHash == hash && streq(argv[0], COMMANDS[i].name)) {
+            command = &COMMANDS[i];
+            break;
+        }
+    }
+
+    if (command == nullptr) {
+        msg.control.print(F("ERROR: Unknown command '"));
+        msg.control.print(argv[0]);
+        msg.control.println(F("'"));
+        msg.control.println(F("  Type HELP for available commands"));
+        return 1;
+    }
 
     // Mode gating check (except for mode-switching commands)
-    if (isInRunMode() && !isReadOnlyCommand(cmdUpper)) {
+    if (isInRunMode() && !isReadOnlyCommand(command->name)) {
         msg.control.println();
         msg.control.println(F("========================================"));
         msg.control.println(F("  ERROR: Configuration locked in RUN mode"));
@@ -175,19 +344,9 @@ int dispatchCommand(int argc, const char* const* argv) {
         return 1;
     }
 
-    // Look up command in table and dispatch
-    for (uint8_t i = 0; i < NUM_COMMANDS; i++) {
-        if (streq(cmdUpper, COMMANDS[i].name)) {
-            return COMMANDS[i].handler(argc, argv);
-        }
-    }
-
-    // Command not found
-    msg.control.print(F("ERROR: Unknown command '"));
-    msg.control.print(argv[0]);
-    msg.control.println(F("'"));
-    msg.control.println(F("  Type HELP for available commands"));
-    return 1;
+    int result = command->handler(argc, argv);
+    scratchReset();             // No document outlives its command
+    return result;
 }
 
 //=============================================================================
@@ -215,7 +374,7 @@ static int cmd_help(int argc, const char* const* argv) {
 static int cmd_list(int argc, const char* const* argv) {
     if (argc == 1) {
         msg.control.println(F("ERROR: LIST requires a subcommand"));
-        msg.control.println(F("  Usage: LIST INPUTS | APPLICATIONS | SENSORS | OUTPUTS | TRANSPORTS"));
+        msg.control.println(F("  Usage: LIST INPUTS | APPLICATIONS | SENSORS | OUTPUTS | TRANSPORTS | RULES"));
         return 1;
     }
 
@@ -231,11 +390,13 @@ static int cmd_list(int argc, const char* const* argv) {
         listOutputModules();
     } else if (streq(argv[1], "TRANSPORTS")) {
         router.listAvailableTransports();
+    } else if (streq(argv[1], "RULES")) {
+        listAlarmRules();
     } else {
         msg.control.print(F("ERROR: Unknown LIST subcommand '"));
         msg.control.print(argv[1]);
         msg.control.println(F("'"));
-        msg.control.println(F("  Valid: INPUTS, APPLICATIONS, SENSORS, OUTPUTS, TRANSPORTS"));
+        msg.control.println(F("  Valid: INPUTS, APPLICATIONS, SENSORS, OUTPUTS, TRANSPORTS, RULES"));
         return 1;
     }
     return 0;
@@ -263,24 +424,110 @@ static int cmd_version(int argc, const char* const* argv) {
 }
 
 static int cmd_config(int argc, const char* const* argv) {
-    // CONFIG command now only enters configuration mode
+    // CONFIG HASH - CRC-32 of the config as exported, for delta sync (config_blob.h)
+    if (argc == 2 && streq(argv[1], "HASH")) {
+        printConfigHash();
+        return 0;
+    }
+    // Otherwise CONFIG only enters configuration mode
     // CONFIG SAVE/LOAD have been removed - use SAVE FILE / LOAD FILE instead
+    if (argc > 1) {
+        msg.control.println(F("  Usage: CONFIG | CONFIG HASH"));
+        return 1;
+    }
     setMode(MODE_CONFIG);
     return 0;
 }
 
+// SAVE, LOAD and RUN need a validated configuration
+static bool refuseInTransaction() {
+    if (!isInputTransactionActive()) return false;
+    msg.control.println(F("ERROR: Config transaction open - COMMIT or ROLLBACK first"));
+    return true;
+}
+
 static int cmd_run(int argc, const char* const* argv) {
+    // RUN <script> - a command file from SD in one batch (command_script.h)
+    if (argc >= 2) {
+#if COMMAND_SCRIPTS
+        FilePathComponents path = parseFilePath(argv[1]);
+        if (!path.isValid || !streq(path.destination, "SD")) {
+            msg.control.println(F("ERROR: Scripts are read from SD - RUN [SD:]<script>"));
+            return 1;
+        }
+        return runCommandScript(path.filename);
+#else
+        msg.control.println(F("ERROR: Scripts need SD support (ENABLE_SD_LOGGING or ENABLE_JSON_CONFIG)"));
+        return 1;
+#endif
+    }
+    if (refuseInTransaction()) return 1;
     setMode(MODE_RUN);
     return 0;
 }
 
+// BEGIN - stage input changes until COMMIT (validated and rebuilt once)
+static int cmd_begin(int argc, const char* const* argv) {
+    if (!CONFIG_TRANSACTIONS) {
+        msg.control.println(F("ERROR: Config transactions not available on this platform"));
+        return 1;
+    }
+    if (!beginInputTransaction()) {
+        msg.control.println(F("ERROR: Config transaction already open"));
+        return 1;
+    }
+    msg.control.println(F("Config transaction started - COMMIT to apply, ROLLBACK to discard"));
+    return 0;
+}
+
+static int cmd_commit(int argc, const char* const* argv) {
+    if (!isInputTransactionActive()) {
+        msg.control.println(F("ERROR: No config transaction open (BEGIN)"));
+        return 1;
+    }
+    if (!commitInputTransaction()) {
+        msg.control.println(F("ERROR: Configuration invalid - all changes since BEGIN rolled back"));
+        return 1;
+    }
+    msg.control.print(F("Config transaction committed ("));
+    msg.control.print(numActiveInputs);
+    msg.control.println(F(" inputs active)"));
+    return 0;
+}
+
+static int cmd_rollback(int argc, const char* const* argv) {
+    if (!rollbackInputTransaction()) {
+        msg.control.println(F("ERROR: No config transaction open (BEGIN)"));
+        return 1;
+    }
+    msg.control.println(F("Config transaction rolled back"));
+    return 0;
+}
+
+static void printSaveResult() {
+    msg.control.print(F("Configuration saved"));
+    uint16_t queued = getEEPROMStorePending();
+    if (queued) {
+        msg.control.print(F(" ("));
+        msg.control.print(queued);
+        msg.control.print(F(" changed bytes being written)"));
+    }
+    msg.control.println();
+}
+
 static int cmd_save(int argc, const char* const* argv) {
+    if (refuseInTransaction()) return 1;
+    if (isPowerFailing()) {
+        msg.control.println(F("ERROR: Supply failing - not saving (lib/power_fail.h)"));
+        return 1;
+    }
+
     // Case 1: SAVE (bare) → EEPROM (backward compatible)
     if (argc == 1) {
         msg.control.println(F("Saving configuration to EEPROM..."));
         saveInputConfig();
         saveSystemConfig();
-        msg.control.println(F("Configuration saved"));
+        printSaveResult();
         return 0;
     }
 
@@ -289,7 +536,7 @@ static int cmd_save(int argc, const char* const* argv) {
         msg.control.println(F("Saving configuration to EEPROM..."));
         saveInputConfig();
         saveSystemConfig();
-        msg.control.println(F("Configuration saved"));
+        printSaveResult();
         return 0;
     }
 
@@ -327,15 +574,21 @@ static int cmd_save(int argc, const char* const* argv) {
     msg.control.println(F("    SAVE EEPROM             # Save to EEPROM (explicit)"));
     msg.control.println(F("    SAVE config.json        # Save to SD card"));
     msg.control.println(F("    SAVE SD:mycar.json      # Save to SD card (explicit)"));
+    msg.control.println(F("    SAVE SD:mycar.bin       # Binary blob"));
     return 1;
 }
 
 static int cmd_load(int argc, const char* const* argv) {
+    if (refuseInTransaction()) return 1;
+
     // Case 1: LOAD (bare) → EEPROM (backward compatible)
     if (argc == 1) {
         msg.control.println(F("Loading configuration from EEPROM..."));
         loadInputConfig();
         loadSystemConfig();
+#ifdef ENABLE_RELAY_OUTPUT
+        bindRelays();
+#endif
         msg.control.println(F("Configuration loaded"));
         return 0;
     }
@@ -345,6 +598,9 @@ static int cmd_load(int argc, const char* const* argv) {
         msg.control.println(F("Loading configuration from EEPROM..."));
         loadInputConfig();
         loadSystemConfig();
+#ifdef ENABLE_RELAY_OUTPUT
+        bindRelays();
+#endif
         msg.control.println(F("Configuration loaded"));
         return 0;
     }
@@ -387,6 +643,19 @@ static int cmd_load(int argc, const char* const* argv) {
     return 1;
 }
 
+// IMPORT BEGIN | <base64> | END - the lines SYSTEM DUMP BIN prints (config_blob.h).
+// A whole config is refused inside a transaction, a patch is staged in it
+static int cmd_import(int argc, const char* const* argv) {
+    if (argc != 2) {
+        msg.control.println(F("  Usage: IMPORT BEGIN | <base64> | END"));
+        return 1;
+    }
+    bool end = streq(argv[1], "END");
+    if (!importConfigBlobLine(argv[1])) return 1;
+    if (end) msg.control.println(F("Type SAVE to persist to EEPROM"));
+    return 0;
+}
+
 static int cmd_reboot(int argc, const char* const* argv) {
     msg.control.println(F("Rebooting system..."));
     platformReboot();
@@ -396,6 +665,229 @@ static int cmd_reboot(int argc, const char* const* argv) {
 // Stub implementations for remaining commands
 // These will be filled in next
 
+// "<" or ">"
+static bool parseRuleOp(const char* s, uint8_t* op) {
+    if (streq(s, "<")) {
+        *op = RULE_OP_LESS;
+    } else if (streq(s, ">")) {
+        *op = RULE_OP_GREATER;
+    } else {
+        msg.control.print(F("ERROR: Rule comparison must be < or >, not '"));
+        msg.control.print(s);
+        msg.control.println(F("'"));
+        return false;
+    }
+    return true;
+}
+
+// A configured input (bare I2C / CAN would allocate a new virtual pin) on
+// a pin rules and math channels can keep in one byte
+static bool parseRulePin(const char* s, uint8_t* pin) {
+    bool valid = !streq(s, "I2C") && !streq(s, "CAN");
+    InputPin parsed = valid ? parsePin(s, &valid) : 0;
+    if (!valid || getInputByPin(parsed) == nullptr) {
+        msg.control.print(F("ERROR: No input on '"));
+        msg.control.print(s);
+        msg.control.println(F("'"));
+        return false;
+    }
+    if (!PIN_IS_NARROW(parsed)) {
+        msg.control.print(F("ERROR: Rules and math channels take pins below CAN:32, not "));
+        msg.control.println(s);
+        return false;
+    }
+    *pin = parsed;
+    return true;
+}
+
+// A constant ("1.5", "-40") or a configured input plus an offset ("A5", "A5+70", "CAN:1-0.5")
+static bool parseRuleOperand(const char* s, AlarmRuleTerm* term) {
+    char* end;
+    double constant = strtod(s, &end);
+    if (end != s && *end == '\0') {
+        term->refPin = ALARM_RULE_CONSTANT;
+        term->value = constant;
+        return true;
+    }
+
+    const char* sign = strpbrk(s + 1, "+-");
+    char pinName[12];
+    size_t len = sign ? (size_t)(sign - s) : strlen(s);
+    if (len >= sizeof(pinName)) len = sizeof(pinName) - 1;
+    memcpy(pinName, s, len);
+    pinName[len] = '\0';
+
+    if (!parseRulePin(pinName, &term->refPin)) return false;
+    term->value = sign ? strtod(sign, nullptr) : 0.0f;
+    return true;
+}
+
+// SET <pin> ALARM RULE <n> OFF | <op> <operand> [WHEN <pin> <op> <operand> [AND ...]] [WARNING]
+static int setAlarmRuleCommand(InputPin pin, int argc, const char* const* argv) {
+    if (argc < 6) {
+        msg.control.println(F("ERROR: ALARM RULE requires a rule number and a comparison, or OFF"));
+        msg.control.println(F("  Usage: SET <pin> ALARM RULE <n> <|> <value|pin[+k]> [WHEN <pin> <|> <value|pin[+k]> [AND ...]] [WARNING]"));
+        msg.control.println(F("         SET <pin> ALARM RULE <n> OFF"));
+        return 1;
+    }
+    int n = atoi(argv[4]);
+    if (n < 0 || n >= ALARM_RULE_MAX) {
+        msg.control.print(F("ERROR: Rule number must be 0-"));
+        msg.control.println(ALARM_RULE_MAX - 1);
+        return 1;
+    }
+
+    AlarmRuleConfig rule;
+    memset(&rule, 0, sizeof(rule));
+    if (!streq(argv[5], "OFF")) {
+        if (getInputByPin(pin) == nullptr) {
+            msg.control.print(F("ERROR: No input on "));
+            msg.control.println(argv[1]);
+            return 1;
+        }
+        if (!PIN_IS_NARROW(pin)) {
+            msg.control.print(F("ERROR: Rules and math channels take pins below CAN:32, not "));
+            msg.control.println(argv[1]);
+            return 1;
+        }
+        rule.severity = SEVERITY_ALARM;
+
+        // Target term, then WHEN / AND terms on any input
+        int i = 5;
+        uint8_t termPin = pin;
+        while (true) {
+            if (rule.numTerms >= ALARM_RULE_TERMS) {
+                msg.control.print(F("ERROR: A rule has at most "));
+                msg.control.print(ALARM_RULE_TERMS);
+                msg.control.println(F(" comparisons"));
+                return 1;
+            }
+            if (i + 1 >= argc) {
+                msg.control.println(F("ERROR: Comparison needs < or > and a value"));
+                return 1;
+            }
+            AlarmRuleTerm* term = &rule.terms[rule.numTerms++];
+            term->pin = termPin;
+            if (!parseRuleOp(argv[i], &term->op) || !parseRuleOperand(argv[i + 1], term)) return 1;
+            i += 2;
+
+            if (i < argc && streq(argv[i], "WARNING")) {
+                rule.severity = SEVERITY_WARNING;
+                i++;
+            }
+            if (i >= argc) break;
+
+            if (!streq(argv[i], rule.numTerms == 1 ? "WHEN" : "AND") || i + 1 >= argc) {
+                msg.control.print(F("ERROR: Unexpected '"));
+                msg.control.print(argv[i]);
+                msg.control.println(rule.numTerms == 1 ? F("' - expected WHEN or WARNING") : F("' - expected AND or WARNING"));
+                return 1;
+            }
+            if (!parseRulePin(argv[i + 1], &termPin)) return 1;
+            i += 2;
+        }
+    }
+
+    if (!setAlarmRule(n, rule)) {
+        msg.control.println(F("ERROR: Invalid rule"));
+        return 1;
+    }
+    msg.control.print(F("Alarm rule "));
+    msg.control.print(n);
+    msg.control.print(F(": "));
+    printAlarmRule(n);
+    msg.control.println();
+    msg.control.println(F("  (use SAVE to persist)"));
+    return 0;
+}
+
+// "+", "-", "*" or "/" (MATH_OP_NONE if neither)
+static uint8_t parseMathOp(const char* s) {
+    if (streq(s, "+")) return MATH_OP_ADD;
+    if (streq(s, "-")) return MATH_OP_SUB;
+    if (streq(s, "*")) return MATH_OP_MUL;
+    if (streq(s, "/")) return MATH_OP_DIV;
+    return MATH_OP_NONE;
+}
+
+// SET <pin> MATH [INTEGRATE] <input> [<op> <input|value>] [* <k>] [+|- <c>]
+static int setMathCommand(InputPin pin, int argc, const char* const* argv) {
+    Input* input = getInputByPin(pin);
+    if (!MATH_IS_PIN(pin) || input == nullptr) {
+        msg.control.println(F("ERROR: MATH needs a math channel - SET MATH:n <application> first"));
+        return 1;
+    }
+
+    MathChannelCalibration expr = { MATH_OP_NONE, 0xFF, MATH_SOURCE_CONSTANT, 0, 0.0f, 1.0f, 0.0f };
+    int i = 3;
+    if (i < argc && streq(argv[i], "INTEGRATE")) {
+        expr.integrate = 1;
+        i++;
+    }
+    if (i >= argc) {
+        msg.control.println(F("ERROR: MATH requires an expression"));
+        msg.control.println(F("  Usage: SET <pin> MATH [INTEGRATE] <input> [+|-|*|/ <input|value>] [* <k>] [+|- <c>]"));
+        return 1;
+    }
+    if (!parseRulePin(argv[i++], &expr.source_a)) return 1;
+
+    // Left to right: the operation (on an input or a constant), then * k, then + c
+    uint8_t stage = 0;
+    while (i < argc) {
+        uint8_t op = parseMathOp(argv[i]);
+        if (op == MATH_OP_NONE || i + 1 >= argc) {
+            msg.control.print(F("ERROR: Expected + - * or / and an operand at '"));
+            msg.control.print(argv[i]);
+            msg.control.println(F("'"));
+            return 1;
+        }
+        const char* operand = argv[i + 1];
+        i += 2;
+        char* end;
+        float value = strtod(operand, &end);
+        bool constant = end != operand && *end == '\0';
+
+        if (stage == 0) {
+            expr.op = op;
+            if (constant) expr.constant = value;
+            else if (!parseRulePin(operand, &expr.source_b)) return 1;
+            stage = 1;
+        } else if (!constant) {
+            msg.control.println(F("ERROR: Only the first operation may read an input"));
+            return 1;
+        } else if (stage == 1 && (op == MATH_OP_MUL || op == MATH_OP_DIV)) {
+            if (op == MATH_OP_DIV && value == 0) {
+                msg.control.println(F("ERROR: Division by zero"));
+                return 1;
+            }
+            expr.scale = (op == MATH_OP_MUL) ? value : 1.0f / value;
+            stage = 2;
+        } else if (stage < 3 && (op == MATH_OP_ADD || op == MATH_OP_SUB)) {
+            expr.offset = (op == MATH_OP_ADD) ? value : -value;
+            stage = 3;
+        } else {
+            msg.control.println(F("ERROR: Expression is <input> [<op> <operand>] [* <k>] [+ <c>]"));
+            return 1;
+        }
+    }
+
+    if (expr.source_a == pin || (expr.op != MATH_OP_NONE && expr.source_b == pin)) {
+        msg.control.println(F("ERROR: A math channel cannot read itself"));
+        return 1;
+    }
+    if (!setMathChannel(pin, expr)) {
+        msg.control.println(F("ERROR: Invalid expression"));
+        return 1;
+    }
+    msg.control.print(F("Input "));
+    msg.control.print(argv[1]);
+    msg.control.print(F(" = "));
+    printMathExpression(input);
+    msg.control.println();
+    msg.control.println(F("  (use SAVE to persist)"));
+    return 0;
+}
+
 static int cmd_set(int argc, const char* const* argv) {
     // SET <pin> <field> <value>
     // Also supports combined syntax: SET <pin> <application> <sensor>
@@ -410,10 +902,11 @@ static int cmd_set(int argc, const char* const* argv) {
 
     // Parse pin
     bool pinValid = false;
-    uint8_t pin = parsePin(argv[1], &pinValid);
+    InputPin pin = parsePin(argv[1], &pinValid);
     if (!pinValid) return 1;
 
     const char* field = argv[2];
+    uint16_t fieldHash = djb2_hash(field);
 
     // Try combined syntax: SET <pin> <application> <sensor>
     // Example: SET 6 CHT MAX6675
@@ -430,8 +923,28 @@ static int cmd_set(int argc, const char* const* argv) {
             if (sensorInfo && appPreset) {
                 MeasurementType sensorMeasType = (MeasurementType)pgm_read_byte(&sensorInfo->measurementType);
                 MeasurementType appMeasType = (MeasurementType)pgm_read_byte(&appPreset->expectedMeasurementType);
+                bool mathSensor = pgm_read_byte(&sensorInfo->calibrationType) == CAL_MATH_CHANNEL;
+                if (mathSensor != MATH_IS_PIN(pin)) {
+                    msg.control.println(mathSensor ? F("ERROR: MATH sensor is for MATH:n inputs only")
+                                                   : F("ERROR: MATH:n inputs use the MATH sensor"));
+                    return 1;
+                }
+                void (*readFn)(Input*) = (void (*)(Input*))pgm_read_ptr(&sensorInfo->readFunction);
+                bool gpsSensor = readFn == readGpsSpeed || readFn == readGpsAltitude;
+                if (gpsSensor != GPS_IS_PIN(pin)) {
+                    msg.control.println(gpsSensor ? F("ERROR: GPS sensors are for GPS:n inputs only")
+                                                  : F("ERROR: GPS:n inputs use GPS_SPEED or GPS_ALTITUDE"));
+                    return 1;
+                }
+                bool nodeSensor = pgm_read_byte(&sensorInfo->calibrationType) == CAL_NODE_CHANNEL;
+                if (nodeSensor != NODE_IS_PIN(pin)) {
+                    msg.control.println(nodeSensor ? F("ERROR: NODE sensor is for NODE:n inputs only")
+                                                   : F("ERROR: NODE:n inputs use the NODE sensor"));
+                    return 1;
+                }
 
-                if (sensorMeasType != appMeasType) {
+                // A math or node channel measures whatever its application does
+                if (sensorMeasType != appMeasType && !mathSensor && !nodeSensor) {
                     msg.control.print(F("ERROR: Sensor/application type mismatch - "));
                     msg.control.print(argv[3]);
                     msg.control.print(F(" measures "));
@@ -486,12 +999,48 @@ static int cmd_set(int argc, const char* const* argv) {
     }
 
     // SET CAN <pid>  -  Import CAN sensor by PID
+    // SET CAN FRAME <can_id>  -  Import a broadcast frame (no PID byte)
+    // SET CAN FRAME <pgn> [source]  -  J1939 input protocol: PGN from any / one source address
     // Example: SET CAN 0x0C  (imports Engine RPM from OBD-II)
     // This automatically assigns the next available CAN virtual pin (CAN:0, CAN:1, etc.)
     if (streq(argv[1], "CAN") && argc >= 3) {
+        // Whole-frame imports are placed with SET <pin> CAN_SIGNAL afterwards
+        bool wholeFrame = streq(argv[2], "FRAME");
+        bool j1939 = systemConfig.buses.can_input_protocol == CAN_PROTOCOL_J1939;
+        uint16_t frameId = 0;
+        int16_t j1939Source = -1;  // Any source address
+        if (wholeFrame) {
+            if (argc < 4) {
+                msg.control.println(F("ERROR: CAN FRAME requires a CAN ID"));
+                msg.control.println(F("  Usage: SET CAN FRAME <can_id>"));
+                return 1;
+            }
+            uint32_t id = strtoul(argv[3], nullptr, 0);
+            if (j1939) {
+                if (id == 0 || id > 0xFFFF) {
+                    msg.control.println(F("ERROR: J1939 PGN must be 1-65535 (data page 0)"));
+                    return 1;
+                }
+                if (argc >= 5) {
+                    uint32_t source = strtoul(argv[4], nullptr, 0);
+                    if (source > 253) {
+                        msg.control.println(F("ERROR: J1939 source address must be 0-253"));
+                        return 1;
+                    }
+                    j1939Source = source;
+                }
+            } else if (id == 0 || id > 0x7FF) {
+                msg.control.println(F("ERROR: CAN ID must be a standard ID (0x001-0x7FF)"));
+                return 1;
+            }
+            frameId = (uint16_t)id;
+        }
+
         // Parse PID (supports hex like 0x0C or decimal like 12)
-        uint8_t pid;
-        if (argv[2][0] == '0' && (argv[2][1] == 'x' || argv[2][1] == 'X')) {
+        uint8_t pid = 0;
+        if (wholeFrame) {
+            // No PID byte in the frame
+        } else if (argv[2][0] == '0' && (argv[2][1] == 'x' || argv[2][1] == 'X')) {
             pid = (uint8_t)strtoul(argv[2] + 2, nullptr, 16);
         } else {
             pid = (uint8_t)atoi(argv[2]);
@@ -499,13 +1048,13 @@ static int cmd_set(int argc, const char* const* argv) {
 
         // Allocate next CAN virtual pin
         bool pinValid = false;
-        uint8_t virtualPin = parsePin("CAN", &pinValid);
+        InputPin virtualPin = parsePin("CAN", &pinValid);
         if (!pinValid) {
             return 1;  // Error already printed by parsePin
         }
 
         // Lookup standard PID info
-        const StandardPIDInfo* pidInfo = lookupStandardPID(pid);
+        const StandardPIDInfo* pidInfo = wholeFrame ? nullptr : lookupStandardPID(pid);
 
         // Configure as CAN_IMPORT sensor
         uint8_t canSensorIndex = getSensorIndexByName("CAN_IMPORT");
@@ -527,34 +1076,75 @@ static int cmd_set(int argc, const char* const* argv) {
             return 1;
         }
 
+        // Stale timeout from the broadcast period the last SCAN measured
+        uint16_t importTimeout = 0;
+        #ifdef ENABLE_CAN
+        if (!wholeFrame) importTimeout = getCANScanTimeout(0x7E8, pid);
+        #endif
+
         // Configure CAN calibration
-        if (pidInfo) {
+        input->customCalibration.can.whole_frame = wholeFrame && j1939Source < 0;
+        if (wholeFrame) {
+            // Passthrough of data byte 0 until CAN_SIGNAL places the signal
+            input->customCalibration.can.source_can_id = frameId;
+            input->customCalibration.can.source_pid = j1939Source < 0 ? 0 : j1939Source;
+            input->customCalibration.can.data_offset = 0;
+            input->customCalibration.can.data_length = 1;
+            input->customCalibration.can.is_big_endian = true;
+            input->customCalibration.can.bit_offset = 0;
+            input->customCalibration.can.bit_length = 0;
+            input->customCalibration.can.scale_factor = 1.0;
+            input->customCalibration.can.offset = 0.0;
+            #ifdef ENABLE_CAN
+            importTimeout = getCANScanTimeout(frameId, CAN_PID_WHOLE_FRAME);  // J1939: SCAN lists PGNs
+            #endif
+            input->customCalibration.can.timeout_ms = importTimeout;
+            input->flags.useCustomCalibration = true;
+
+            char name[INPUT_DISPLAY_NAME_LEN];
+            sprintf(name, "CAN 0x%03X", frameId);
+            storeInputDisplayName(input, name);
+            sprintf(input->abbrName, "C%03X", frameId);
+
+            msg.control.print(F("✓ Imported CAN frame CAN:"));
+            msg.control.print(CAN_PIN_CHANNEL(virtualPin));
+            msg.control.print(F(" - ID 0x"));
+            msg.control.println(frameId, HEX);
+            msg.control.print(F("  Hint: Use 'SET CAN:"));
+            msg.control.print(CAN_PIN_CHANNEL(virtualPin));
+            msg.control.println(F(" CAN_SIGNAL ...' to place the signal"));
+        } else if (pidInfo) {
             // Use standard PID info for automatic configuration
             input->customCalibration.can.source_can_id = 0x7E8;  // OBD-II default
             input->customCalibration.can.source_pid = pid;
             input->customCalibration.can.data_offset = 0;
             input->customCalibration.can.data_length = pidInfo->data_length;
             input->customCalibration.can.is_big_endian = true;
+            input->customCalibration.can.bit_offset = 0;
+            input->customCalibration.can.bit_length = 0;
             input->customCalibration.can.scale_factor = pidInfo->scale_factor;
             input->customCalibration.can.offset = pidInfo->offset;
+            input->customCalibration.can.timeout_ms = importTimeout;
             input->flags.useCustomCalibration = true;
 
             // Set measurement type from standard PID table
             input->measurementType = pidInfo->measurementType;
 
             // Set display name from standard table
-            strncpy_P(input->displayName, pidInfo->name, sizeof(input->displayName) - 1);
-            input->displayName[sizeof(input->displayName) - 1] = '\0';
+            char name[INPUT_DISPLAY_NAME_LEN];
+            strncpy_P(name, pidInfo->name, sizeof(name) - 1);
+            name[sizeof(name) - 1] = '\0';
+            storeInputDisplayName(input, name);
             strncpy_P(input->abbrName, pidInfo->abbr, sizeof(input->abbrName) - 1);
             input->abbrName[sizeof(input->abbrName) - 1] = '\0';
 
             msg.control.print(F("✓ Imported CAN sensor CAN:"));
-            msg.control.print(virtualPin - 0xC0);
+            msg.control.print(CAN_PIN_CHANNEL(virtualPin));
             msg.control.print(F(" - PID 0x"));
             if (pid < 0x10) msg.control.print('0');
             msg.control.print(pid, HEX);
             msg.control.print(F(" ("));
-            msg.control.print(input->displayName);
+            msg.control.print(getInputDisplayName(input, name));
             msg.control.println(F(")"));
         } else {
             // Unknown PID - use default calibration
@@ -563,15 +1153,20 @@ static int cmd_set(int argc, const char* const* argv) {
             input->customCalibration.can.data_offset = 0;
             input->customCalibration.can.data_length = 1;
             input->customCalibration.can.is_big_endian = true;
+            input->customCalibration.can.bit_offset = 0;
+            input->customCalibration.can.bit_length = 0;
             input->customCalibration.can.scale_factor = 1.0;
             input->customCalibration.can.offset = 0.0;
+            input->customCalibration.can.timeout_ms = importTimeout;
             input->flags.useCustomCalibration = true;
 
-            sprintf(input->displayName, "CAN PID 0x%02X", pid);
+            char name[INPUT_DISPLAY_NAME_LEN];
+            sprintf(name, "CAN PID 0x%02X", pid);
+            storeInputDisplayName(input, name);
             sprintf(input->abbrName, "C%02X", pid);
 
             msg.control.print(F("✓ Imported CAN sensor CAN:"));
-            msg.control.print(virtualPin - 0xC0);
+            msg.control.print(CAN_PIN_CHANNEL(virtualPin));
             msg.control.print(F(" - PID 0x"));
             if (pid < 0x10) msg.control.print('0');
             msg.control.print(pid, HEX);
@@ -579,12 +1174,19 @@ static int cmd_set(int argc, const char* const* argv) {
             msg.control.println(F("  Hint: Use 'SET CAN:0 ...' commands to customize"));
         }
 
+        if (importTimeout > 0) {
+            msg.control.print(F("  Stale timeout: "));
+            msg.control.print(importTimeout);
+            msg.control.println(F(" ms (from SCAN)"));
+        }
+
         input->flags.isEnabled = true;
+        rebuildInputSchedule();  // Subscribe to the (CAN ID, PID) just configured
         return 0;
     }
 
     // SET <pin> APPLICATION <application>
-    if (streq(field, "APPLICATION")) {
+    if (TOKEN_IS(field, fieldHash, "APPLICATION")) {
         if (argc < 4) {
             msg.control.println(F("ERROR: APPLICATION requires an application name"));
             msg.control.println(F("  Hint: Use 'LIST APPLICATIONS' to see valid options"));
@@ -610,7 +1212,7 @@ static int cmd_set(int argc, const char* const* argv) {
 
     // SET <pin> SENSOR <category> <preset>  (two-layer syntax)
     // SET <pin> SENSOR <sensor>             (legacy flat syntax)
-    if (streq(field, "SENSOR")) {
+    if (TOKEN_IS(field, fieldHash, "SENSOR")) {
         if (argc < 4) {
             msg.control.println(F("ERROR: SENSOR requires arguments"));
             msg.control.println(F("  Usage: SET <pin> SENSOR <category> <preset>"));
@@ -683,7 +1285,7 @@ static int cmd_set(int argc, const char* const* argv) {
     }
 
     // SET <pin> NAME <name>
-    if (streq(field, "NAME")) {
+    if (TOKEN_IS(field, fieldHash, "NAME")) {
         if (argc < 4) {
             msg.control.println(F("ERROR: NAME requires a name string"));
             return 1;
@@ -699,7 +1301,7 @@ static int cmd_set(int argc, const char* const* argv) {
     }
 
     // SET <pin> DISPLAY_NAME <name>
-    if (streq(field, "DISPLAY_NAME")) {
+    if (TOKEN_IS(field, fieldHash, "DISPLAY_NAME")) {
         if (argc < 4) {
             msg.control.println(F("ERROR: DISPLAY_NAME requires a name string"));
             return 1;
@@ -715,7 +1317,7 @@ static int cmd_set(int argc, const char* const* argv) {
     }
 
     // SET <pin> UNITS <units>
-    if (streq(field, "UNITS")) {
+    if (TOKEN_IS(field, fieldHash, "UNITS")) {
         if (argc < 4) {
             msg.control.println(F("ERROR: UNITS requires a unit name"));
             return 1;
@@ -732,9 +1334,9 @@ static int cmd_set(int argc, const char* const* argv) {
     }
 
     // SET <pin> ALARM subcommands
-    if (streq(field, "ALARM")) {
+    if (TOKEN_IS(field, fieldHash, "ALARM")) {
         if (argc < 4) {
-            msg.control.println(F("ERROR: ALARM requires ENABLE, DISABLE, WARMUP, PERSIST, or <min> <max>"));
+            msg.control.println(F("ERROR: ALARM requires ENABLE, DISABLE, WARMUP, PERSIST, CLEAR, WARN, HYSTERESIS, TREND, RULE, or <min> <max>"));
             return 1;
         }
 
@@ -804,45 +1406,427 @@ static int cmd_set(int argc, const char* const* argv) {
             return 1;
         }
 
-        // SET <pin> ALARM <min> <max>
-        if (argc < 5) {
-            msg.control.println(F("ERROR: ALARM requires min and max values"));
+        // SET <pin> ALARM CLEAR <ms>
+        if (streq(argv[3], "CLEAR")) {
+            if (argc < 5) {
+                msg.control.println(F("ERROR: ALARM CLEAR requires a time value in milliseconds"));
+                return 1;
+            }
+            long value = atol(argv[4]);
+            if (value < 0 || value > 60000) {
+                msg.control.println(F("ERROR: Alarm clear time must be 0-60000ms"));
+                return 1;
+            }
+            if (setInputAlarmClear(pin, value)) {
+                msg.control.print(F("Input "));
+                msg.control.print(argv[1]);
+                msg.control.print(F(" alarm clear time set to "));
+                msg.control.print(value);
+                msg.control.println(F("ms"));
+                return 0;
+            }
             return 1;
         }
-        float minVal = atof(argv[3]);
-        float maxVal = atof(argv[4]);
-        if (setInputAlarmRange(pin, minVal, maxVal)) {
-            msg.control.print(F("Input "));
-            msg.control.print(argv[1]);
-            msg.control.print(F(" alarm range set to "));
-            msg.control.print(minVal);
-            msg.control.print(F(" - "));
-            msg.control.println(maxVal);
-            return 0;
-        }
-        return 1;
-    }
 
-    // ===== OUTPUT ROUTING COMMANDS =====
-    // SET <pin> OUTPUT <target> ENABLE|DISABLE
-    // SET <pin> OUTPUT ALL ENABLE|DISABLE
-    // SET <pin> OUTPUT STATUS
-    if (streq(field, "OUTPUT")) {
-        if (argc < 4) {
-            msg.control.println(F("ERROR: OUTPUT requires a target"));
-            msg.control.println(F("  Usage: SET <pin> OUTPUT <CAN|RealDash|Serial|SD_Log|ALL> <ENABLE|DISABLE>"));
-            msg.control.println(F("         SET <pin> OUTPUT STATUS"));
-            return 1;
-        }
+        // SET <pin> ALARM WARN <min> <max> | AUTO | PERSIST <ms> | CLEAR <ms>
+        if (streq(argv[3], "WARN")) {
+            if (argc < 5) {
+                msg.control.println(F("ERROR: ALARM WARN requires <min> <max>, AUTO, PERSIST <ms>, or CLEAR <ms>"));
+                return 1;
+            }
+            Input* input = getInputByPin(pin);
+            if (input == nullptr) return 1;
 
-        // SET <pin> OUTPUT STATUS
-        if (streq(argv[3], "STATUS")) {
-            printInputOutputInfo(pin);
-            return 0;
-        }
+            if (streq(argv[4], "PERSIST") || streq(argv[4], "CLEAR")) {
+                bool persist = streq(argv[4], "PERSIST");
+                long value = (argc >= 6) ? atol(argv[5]) : -1;
+                if (value < 0 || value > 60000) {
+                    msg.control.println(F("ERROR: Warning persist/clear time must be 0-60000ms"));
+                    return 1;
+                }
+                uint16_t persistMs = persist ? value : input->warnPersistMs;
+                uint16_t clearMs = persist ? input->warnClearMs : value;
+                if (!setInputWarnTimers(pin, persistMs, clearMs)) return 1;
+                msg.control.print(F("Input "));
+                msg.control.print(argv[1]);
+                msg.control.print(persist ? F(" warning persistence set to ") : F(" warning clear time set to "));
+                msg.control.print(value);
+                msg.control.println(F("ms"));
+                return 0;
+            }
 
-        // All other subcommands need ENABLE/DISABLE
-        if (argc < 5) {
+            bool autoRange = streq(argv[4], "AUTO");
+            if (!autoRange && argc < 6) {
+                msg.control.println(F("ERROR: ALARM WARN requires min and max values"));
+                return 1;
+            }
+            float minVal = autoRange ? NAN : atof(argv[4]);
+            float maxVal = autoRange ? NAN : atof(argv[5]);
+            if (setInputWarnRange(pin, minVal, maxVal)) {
+                msg.control.print(F("Input "));
+                msg.control.print(argv[1]);
+                if (autoRange) {
+                    msg.control.print(F(" warning range set to "));
+                    msg.control.print(WARNING_THRESHOLD_PERCENT);
+                    msg.control.println(F("% of the alarm range"));
+                } else {
+                    msg.control.print(F(" warning range set to "));
+                    msg.control.print(minVal);
+                    msg.control.print(F(" - "));
+                    msg.control.println(maxVal);
+                }
+                return 0;
+            }
+            return 1;
+        }
+
+        // SET <pin> ALARM HYSTERESIS <alarm_band> [<warn_band>]
+        if (streq(argv[3], "HYSTERESIS")) {
+            if (argc < 5) {
+                msg.control.println(F("ERROR: ALARM HYSTERESIS requires a band (standard units)"));
+                msg.control.println(F("  Usage: SET <pin> ALARM HYSTERESIS <alarm_band> [<warn_band>]"));
+                return 1;
+            }
+            float alarmBand = atof(argv[4]);
+            float warnBand = (argc >= 6) ? atof(argv[5]) : alarmBand;
+            if (!isValidAlarmHysteresis(alarmBand) || !isValidAlarmHysteresis(warnBand)) {
+                msg.control.println(F("ERROR: Hysteresis must be 0 or more"));
+                return 1;
+            }
+            if (setInputAlarmHysteresis(pin, alarmBand, warnBand)) {
+                msg.control.print(F("Input "));
+                msg.control.print(argv[1]);
+                msg.control.print(F(" hysteresis set to "));
+                msg.control.print(alarmBand);
+                msg.control.print(F(" (alarm), "));
+                msg.control.print(warnBand);
+                msg.control.println(F(" (warning)"));
+                return 0;
+            }
+            return 1;
+        }
+
+        // SET <pin> ALARM TREND <units_per_s>|OFF [<window_ms>]
+        if (streq(argv[3], "TREND")) {
+            if (argc < 5) {
+                msg.control.println(F("ERROR: ALARM TREND requires a rate (units/s) or OFF"));
+                msg.control.println(F("  Usage: SET <pin> ALARM TREND <units_per_s>|OFF [<window_ms>]"));
+                return 1;
+            }
+            float rate = streq(argv[4], "OFF") ? 0.0f : atof(argv[4]);
+            if (rate == 0.0f && !streq(argv[4], "OFF")) {
+                msg.control.println(F("ERROR: Trend rate must be non-zero (OFF to disable)"));
+                return 1;
+            }
+            long window = (argc >= 6) ? atol(argv[5]) : ALARM_TREND_WINDOW_MS;
+            if (window < 50 || window > 60000) {
+                msg.control.println(F("ERROR: Trend window must be 50-60000ms"));
+                return 1;
+            }
+            Input* input = getInputByPin(pin);
+            if (input && setInputAlarmTrend(pin, rate, (uint16_t)window)) {
+                msg.control.print(F("Input "));
+                msg.control.print(argv[1]);
+                msg.control.print(F(" trend alarm: "));
+                printInputTrend(input);
+                msg.control.println();
+                msg.control.println(F("  (use SAVE to persist)"));
+                return 0;
+            }
+            return 1;
+        }
+
+        // SET <pin> ALARM RULE <n> OFF | <op> <operand> [WHEN <pin> <op> <operand> [AND ...]] [WARNING]
+        if (streq(argv[3], "RULE")) {
+            return setAlarmRuleCommand(pin, argc, argv);
+        }
+
+        // SET <pin> ALARM <min> <max>
+        if (argc < 5) {
+            msg.control.println(F("ERROR: ALARM requires min and max values"));
+            return 1;
+        }
+        float minVal = atof(argv[3]);
+        float maxVal = atof(argv[4]);
+        if (setInputAlarmRange(pin, minVal, maxVal)) {
+            msg.control.print(F("Input "));
+            msg.control.print(argv[1]);
+            msg.control.print(F(" alarm range set to "));
+            msg.control.print(minVal);
+            msg.control.print(F(" - "));
+            msg.control.println(maxVal);
+            return 0;
+        }
+        return 1;
+    }
+
+    // SET <pin> FILTER NONE | EMA <tau_ms> | MEDIAN <3|5> | SLEW <units_per_s>
+    if (TOKEN_IS(field, fieldHash, "FILTER")) {
+        if (argc < 4) {
+            msg.control.println(F("ERROR: FILTER requires a filter type"));
+            msg.control.println(F("  Usage: SET <pin> FILTER NONE | EMA <tau_ms> | MEDIAN <3|5> | SLEW <units_per_s>"));
+            return 1;
+        }
+
+        uint8_t filterType;
+        if (streq(argv[3], "NONE")) {
+            filterType = FILTER_NONE;
+        } else if (streq(argv[3], "EMA")) {
+            filterType = FILTER_EMA;
+        } else if (streq(argv[3], "MEDIAN")) {
+            filterType = FILTER_MEDIAN;
+        } else if (streq(argv[3], "SLEW")) {
+            filterType = FILTER_SLEW;
+        } else {
+            msg.control.print(F("ERROR: Unknown filter '"));
+            msg.control.print(argv[3]);
+            msg.control.println(F("'"));
+            msg.control.println(F("  Valid filters: NONE, EMA, MEDIAN, SLEW"));
+            return 1;
+        }
+
+        uint16_t filterParam = 0;
+        if (filterType != FILTER_NONE) {
+            if (argc < 5) {
+                msg.control.print(F("ERROR: FILTER "));
+                msg.control.print(getInputFilterName(filterType));
+                msg.control.println(F(" requires a parameter"));
+                return 1;
+            }
+            if (filterType == FILTER_SLEW) {
+                // Rate in standard units per second, stored in hundredths
+                float rate = atof(argv[4]);
+                if (rate <= 0 || rate > 655.0) {
+                    msg.control.println(F("ERROR: Slew rate must be 0.01-655 units/s"));
+                    return 1;
+                }
+                filterParam = (uint16_t)(rate * 100.0 + 0.5);
+            } else {
+                long value = atol(argv[4]);
+                filterParam = (value > 0 && value <= 65535) ? (uint16_t)value : 0;
+            }
+        }
+
+        if (!isValidInputFilter(filterType, filterParam)) {
+            if (filterType == FILTER_MEDIAN) {
+                msg.control.println(F("ERROR: MEDIAN supports 3 or 5 taps"));
+            } else {
+                msg.control.println(F("ERROR: EMA time constant must be 1-65535ms"));
+            }
+            return 1;
+        }
+
+        if (setInputFilter(pin, filterType, filterParam)) {
+            Input* input = getInputByPin(pin);
+            msg.control.print(F("Input "));
+            msg.control.print(argv[1]);
+            msg.control.print(F(" filter set to "));
+            printInputFilter(input);
+            msg.control.println();
+            msg.control.println(F("  (use SAVE to persist)"));
+            return 0;
+        }
+        msg.control.println(F("ERROR: Input not configured"));
+        return 1;
+    }
+
+    // SET <pin> RATE FIXED | ADAPTIVE <max_ms> <units_per_s>
+    if (TOKEN_IS(field, fieldHash, "RATE")) {
+        if (argc < 4) {
+            msg.control.println(F("ERROR: RATE requires a mode"));
+            msg.control.println(F("  Usage: SET <pin> RATE FIXED | ADAPTIVE <max_ms> <units_per_s>"));
+            return 1;
+        }
+
+        uint16_t maxInterval = 0;
+        uint16_t band = 0;
+        if (streq(argv[3], "ADAPTIVE")) {
+            if (argc < 6) {
+                msg.control.println(F("ERROR: RATE ADAPTIVE requires <max_ms> <units_per_s>"));
+                return 1;
+            }
+            long maxMs = atol(argv[4]);
+            if (maxMs < 1 || maxMs > 60000) {
+                msg.control.println(F("ERROR: Maximum interval must be 1-60000ms"));
+                return 1;
+            }
+            // Rate in standard units per second, stored in hundredths
+            float rate = atof(argv[5]);
+            if (rate <= 0 || rate > 655.0) {
+                msg.control.println(F("ERROR: Band must be 0.01-655 units/s"));
+                return 1;
+            }
+            maxInterval = (uint16_t)maxMs;
+            band = (uint16_t)(rate * 100.0 + 0.5);
+        } else if (!streq(argv[3], "FIXED")) {
+            msg.control.print(F("ERROR: Unknown rate mode '"));
+            msg.control.print(argv[3]);
+            msg.control.println(F("'"));
+            msg.control.println(F("  Valid modes: FIXED, ADAPTIVE"));
+            return 1;
+        }
+
+        if (setInputRate(pin, maxInterval, band)) {
+            Input* input = getInputByPin(pin);
+            msg.control.print(F("Input "));
+            msg.control.print(argv[1]);
+            msg.control.print(F(" read rate set to "));
+            printInputRate(input);
+            msg.control.println();
+            msg.control.println(F("  (use SAVE to persist)"));
+            return 0;
+        }
+        msg.control.println(F("ERROR: Input not configured"));
+        return 1;
+    }
+
+#ifdef ENABLE_CAN
+    // SET <pin> CAN_TIMEOUT <ms> | AUTO | DEFAULT
+    if (TOKEN_IS(field, fieldHash, "CAN_TIMEOUT")) {
+        if (argc < 4) {
+            msg.control.println(F("ERROR: CAN_TIMEOUT requires a time"));
+            msg.control.println(F("  Usage: SET <pin> CAN_TIMEOUT <ms> | AUTO | DEFAULT"));
+            return 1;
+        }
+
+        Input* input = getInputByPin(pin);
+        if (!input) {
+            msg.control.println(F("ERROR: Input not configured"));
+            return 1;
+        }
+        if (input->calibrationType != CAL_CAN_IMPORT || !input->flags.useCustomCalibration) {
+            msg.control.println(F("ERROR: Not a CAN-imported input (use SET CAN <pid>)"));
+            return 1;
+        }
+
+        uint16_t timeout;
+        if (streq(argv[3], "DEFAULT")) {
+            timeout = 0;
+        } else if (streq(argv[3], "AUTO")) {
+            timeout = getCANScanTimeout(input->customCalibration.can.source_can_id,
+                                        input->customCalibration.can.whole_frame ?
+                                            CAN_PID_WHOLE_FRAME : input->customCalibration.can.source_pid);
+            if (timeout == 0) {
+                msg.control.println(F("ERROR: No broadcast period measured - run SCAN CAN first"));
+                return 1;
+            }
+        } else {
+            long ms = atol(argv[3]);
+            if (ms < CAN_SCAN_TIMEOUT_MIN_MS || ms > 60000) {
+                msg.control.println(F("ERROR: CAN timeout must be 100-60000ms"));
+                return 1;
+            }
+            timeout = (uint16_t)ms;
+        }
+
+        input->customCalibration.can.timeout_ms = timeout;
+        resetCANReadState();  // Recompile with the new timeout
+        msg.control.print(F("Input "));
+        msg.control.print(argv[1]);
+        msg.control.print(F(" CAN stale timeout set to "));
+        msg.control.print(timeout ? timeout : CAN_DEFAULT_TIMEOUT_MS);
+        msg.control.println(timeout ? F(" ms") : F(" ms (default)"));
+        msg.control.println(F("  (use SAVE to persist)"));
+        return 0;
+    }
+
+    // SET <pin> MATH [INTEGRATE] <input> [<op> <input|value>] [* <k>] [+|- <c>]
+    if (TOKEN_IS(field, fieldHash, "MATH")) {
+        return setMathCommand(pin, argc, argv);
+    }
+
+    // SET <pin> CAN_SIGNAL <start_bit> <bits> LE|BE [scale] [offset]
+    // DBC-style bit-packed signal: start bit numbered LSB = 0 in byte 0
+    if (TOKEN_IS(field, fieldHash, "CAN_SIGNAL")) {
+        if (argc < 6) {
+            msg.control.println(F("ERROR: CAN_SIGNAL requires start bit, length and byte order"));
+            msg.control.println(F("  Usage: SET <pin> CAN_SIGNAL <start_bit> <bits> LE|BE [scale] [offset]"));
+            return 1;
+        }
+
+        Input* input = getInputByPin(pin);
+        if (!input) {
+            msg.control.println(F("ERROR: Input not configured"));
+            return 1;
+        }
+        if (input->calibrationType != CAL_CAN_IMPORT || !input->flags.useCustomCalibration) {
+            msg.control.println(F("ERROR: Not a CAN-imported input (use SET CAN <pid>)"));
+            return 1;
+        }
+
+        bool bigEndian;
+        if (streq(argv[5], "BE")) {
+            bigEndian = true;
+        } else if (streq(argv[5], "LE")) {
+            bigEndian = false;
+        } else {
+            msg.control.println(F("ERROR: Byte order must be LE (Intel) or BE (Motorola)"));
+            return 1;
+        }
+
+        long startBit = atol(argv[3]);
+        long bits = atol(argv[4]);
+        if (startBit < 0 || startBit >= CAN_CACHE_MAX_DATA * 8 || bits < 1 || bits > 32) {
+            msg.control.println(F("ERROR: Start bit must fit the payload and length be 1-32 bits"));
+            return 1;
+        }
+
+        CANSensorCalibration cal;
+        memcpy(&cal, &input->customCalibration.can, sizeof(cal));
+        cal.data_offset = startBit / 8;
+        cal.bit_offset = startBit % 8;
+        cal.bit_length = bits;
+        cal.is_big_endian = bigEndian;
+        if (argc >= 7) cal.scale_factor = atof(argv[6]);
+        if (argc >= 8) cal.offset = atof(argv[7]);
+
+        CANSignal sig;
+        if (!compileCANSignal(&cal, &sig)) {
+            msg.control.println(F("ERROR: Signal runs past the end of the frame"));
+            return 1;
+        }
+
+        memcpy(&input->customCalibration.can, &cal, sizeof(cal));
+        resetCANReadState();
+        msg.control.print(F("Input "));
+        msg.control.print(argv[1]);
+        msg.control.print(F(" CAN signal: bytes "));
+        msg.control.print(sig.firstByte);
+        msg.control.print('-');
+        msg.control.print(sig.minLength - 1);
+        msg.control.print(F(", "));
+        msg.control.print(bits);
+        msg.control.print(F(" bits "));
+        msg.control.print(bigEndian ? F("BE") : F("LE"));
+        msg.control.print(F(", x"));
+        msg.control.print(cal.scale_factor, 4);
+        msg.control.print(F(" + "));
+        msg.control.println(cal.offset, 4);
+        msg.control.println(F("  (use SAVE to persist)"));
+        return 0;
+    }
+#endif
+
+    // ===== OUTPUT ROUTING COMMANDS =====
+    // SET <pin> OUTPUT <target> ENABLE|DISABLE
+    // SET <pin> OUTPUT ALL ENABLE|DISABLE
+    // SET <pin> OUTPUT STATUS
+    if (TOKEN_IS(field, fieldHash, "OUTPUT")) {
+        if (argc < 4) {
+            msg.control.println(F("ERROR: OUTPUT requires a target"));
+            msg.control.println(F("  Usage: SET <pin> OUTPUT <CAN|CAN_Mirror|RealDash|Serial|SD_Log|MQTT|ALL> <ENABLE|DISABLE>"));
+            msg.control.println(F("         SET <pin> OUTPUT STATUS"));
+            return 1;
+        }
+
+        // SET <pin> OUTPUT STATUS
+        if (streq(argv[3], "STATUS")) {
+            printInputOutputInfo(pin);
+            return 0;
+        }
+
+        // All other subcommands need ENABLE/DISABLE
+        if (argc < 5) {
             msg.control.println(F("ERROR: OUTPUT requires ENABLE or DISABLE"));
             return 1;
         }
@@ -864,7 +1848,10 @@ static int cmd_set(int argc, const char* const* argv) {
                 msg.control.println(F("ERROR: Input not configured"));
                 return 1;
             }
-            input->outputMask = enable ? OUTPUT_MASK_ALL_DATA : 0x00;
+            // The CAN mirror carries a reduced set of its own - left as it is
+            input->outputMask = (input->outputMask & (1 << OUTPUT_CAN_MIRROR)) |
+                                (enable ? OUTPUT_MASK_ALL_DATA : 0x00);
+            rebuildCANBroadcastLayout();
             msg.control.print(F("Input "));
             msg.control.print(argv[1]);
             msg.control.print(F(" all data outputs "));
@@ -879,17 +1866,21 @@ static int cmd_set(int argc, const char* const* argv) {
         uint8_t outputId;
         if (streq(argv[3], "CAN")) {
             outputId = OUTPUT_CAN;
+        } else if (streq(argv[3], "CAN_MIRROR")) {
+            outputId = OUTPUT_CAN_MIRROR;
         } else if (streq(argv[3], "REALDASH")) {
             outputId = OUTPUT_REALDASH;
         } else if (streq(argv[3], "SERIAL")) {
             outputId = OUTPUT_SERIAL;
         } else if (streq(argv[3], "SD_LOG") || streq(argv[3], "SD")) {
             outputId = OUTPUT_SD;
+        } else if (streq(argv[3], "MQTT")) {
+            outputId = OUTPUT_MQTT;
         } else {
             msg.control.print(F("ERROR: Unknown output '"));
             msg.control.print(argv[3]);
             msg.control.println(F("'"));
-            msg.control.println(F("  Valid outputs: CAN, RealDash, Serial, SD_Log, ALL"));
+            msg.control.println(F("  Valid outputs: CAN, CAN_Mirror, RealDash, Serial, SD_Log, MQTT, ALL"));
             return 1;
         }
 
@@ -911,7 +1902,7 @@ static int cmd_set(int argc, const char* const* argv) {
 
     // SET <pin> CALIBRATION PRESET
     // Clears custom calibration and reverts to sensor library preset
-    if (streq(field, "CALIBRATION")) {
+    if (TOKEN_IS(field, fieldHash, "CALIBRATION")) {
         if (argc < 4) {
             msg.control.println(F("ERROR: CALIBRATION requires PRESET"));
             return 1;
@@ -931,6 +1922,7 @@ static int cmd_set(int argc, const char* const* argv) {
         // Clear custom calibration
         input->flags.useCustomCalibration = false;
         memset(&input->customCalibration, 0, sizeof(CalibrationOverride));
+        buildAdcLut(input);  // Counts table was built from the old calibration
 
         msg.control.print(F("Cleared custom calibration for pin "));
         msg.control.println(argv[1]);
@@ -940,7 +1932,7 @@ static int cmd_set(int argc, const char* const* argv) {
 
     // SET <pin> RPM <poles> <ratio> [<mult>] <timeout> <min> <max>
     // Supports 5 parameters (mult defaults to 1.0) or 6 parameters (custom mult)
-    if (streq(field, "RPM")) {
+    if (TOKEN_IS(field, fieldHash, "RPM")) {
         if (argc < 8 && argc < 9) {
             msg.control.println(F("ERROR: RPM requires 5 or 6 parameters"));
             msg.control.println(F("  Usage: SET <pin> RPM <poles> <ratio> <timeout> <min> <max>"));
@@ -1038,7 +2030,7 @@ static int cmd_set(int argc, const char* const* argv) {
 
     // SET <pin> SPEED <pulses_per_rev> <tire_circ_mm> <drive_ratio> [<mult>] <timeout> <max_speed>
     // Supports 5 parameters (mult defaults to 1.0) or 6 parameters (custom mult)
-    if (streq(field, "SPEED")) {
+    if (TOKEN_IS(field, fieldHash, "SPEED")) {
         if (argc < 8 && argc < 9) {
             msg.control.println(F("ERROR: SPEED requires 5 or 6 parameters"));
             msg.control.println(F("  Usage: SET <pin> SPEED <ppr> <tire_circ> <ratio> <timeout> <max_speed>"));
@@ -1135,7 +2127,7 @@ static int cmd_set(int argc, const char* const* argv) {
     }
 
     // SET <pin> PRESSURE_LINEAR <vmin> <vmax> <pmin> <pmax>
-    if (streq(field, "PRESSURE_LINEAR")) {
+    if (TOKEN_IS(field, fieldHash, "PRESSURE_LINEAR")) {
         if (argc < 7) {
             msg.control.println(F("ERROR: PRESSURE_LINEAR requires 4 parameters"));
             msg.control.println(F("  Usage: SET <pin> PRESSURE_LINEAR <vmin> <vmax> <pmin> <pmax>"));
@@ -1181,6 +2173,7 @@ static int cmd_set(int argc, const char* const* argv) {
         input->customCalibration.pressureLinear.voltage_max = vmax;
         input->customCalibration.pressureLinear.output_min = pmin;
         input->customCalibration.pressureLinear.output_max = pmax;
+        buildAdcLut(input);  // Precomputed line was built from the old calibration
 
         msg.control.print(F("Pressure Linear calibration set for pin "));
         msg.control.println(argv[1]);
@@ -1199,7 +2192,7 @@ static int cmd_set(int argc, const char* const* argv) {
 
     // SET <pin> BIAS <resistor>
     // Generic bias resistor command - works with Steinhart-Hart, Lookup, and Pressure Polynomial
-    if (streq(field, "BIAS")) {
+    if (TOKEN_IS(field, fieldHash, "BIAS")) {
         if (argc < 4) {
             msg.control.println(F("ERROR: BIAS requires a resistor value"));
             return 1;
@@ -1247,6 +2240,7 @@ static int cmd_set(int argc, const char* const* argv) {
         } else if (input->calibrationType == CAL_PRESSURE_POLYNOMIAL) {
             input->customCalibration.pressurePolynomial.bias_resistor = bias;
         }
+        buildAdcLut(input);  // Counts table was built from the old calibration
 
         msg.control.print(F("Bias resistor set for pin "));
         msg.control.print(argv[1]);
@@ -1257,7 +2251,7 @@ static int cmd_set(int argc, const char* const* argv) {
     }
 
     // SET <pin> STEINHART <bias_r> <a> <b> <c>
-    if (streq(field, "STEINHART")) {
+    if (TOKEN_IS(field, fieldHash, "STEINHART")) {
         if (argc < 7) {
             msg.control.println(F("ERROR: STEINHART requires 4 parameters"));
             msg.control.println(F("  Usage: SET <pin> STEINHART <bias_r> <a> <b> <c>"));
@@ -1292,6 +2286,7 @@ static int cmd_set(int argc, const char* const* argv) {
         input->customCalibration.steinhart.steinhart_a = a;
         input->customCalibration.steinhart.steinhart_b = b;
         input->customCalibration.steinhart.steinhart_c = c;
+        buildAdcLut(input);  // Counts table was built from the old calibration
 
         msg.control.print(F("Steinhart-Hart calibration set for pin "));
         msg.control.println(argv[1]);
@@ -1308,7 +2303,7 @@ static int cmd_set(int argc, const char* const* argv) {
     }
 
     // SET <pin> BETA <bias_r> <beta> <r0> <t0>
-    if (streq(field, "BETA")) {
+    if (TOKEN_IS(field, fieldHash, "BETA")) {
         if (argc < 7) {
             msg.control.println(F("ERROR: BETA requires 4 parameters"));
             msg.control.println(F("  Usage: SET <pin> BETA <bias_r> <beta> <r0> <t0>"));
@@ -1352,6 +2347,7 @@ static int cmd_set(int argc, const char* const* argv) {
         input->customCalibration.beta.beta = beta;
         input->customCalibration.beta.r0 = r0;
         input->customCalibration.beta.t0 = t0;
+        buildAdcLut(input);  // Counts table was built from the old calibration
 
         msg.control.print(F("Beta calibration set for pin "));
         msg.control.println(argv[1]);
@@ -1371,7 +2367,7 @@ static int cmd_set(int argc, const char* const* argv) {
     }
 
     // SET <pin> PRESSURE_POLY <bias_r> <a> <b> <c>
-    if (streq(field, "PRESSURE_POLY")) {
+    if (TOKEN_IS(field, fieldHash, "PRESSURE_POLY")) {
         if (argc < 7) {
             msg.control.println(F("ERROR: PRESSURE_POLY requires 4 parameters"));
             msg.control.println(F("  Usage: SET <pin> PRESSURE_POLY <bias_r> <a> <b> <c>"));
@@ -1403,6 +2399,7 @@ static int cmd_set(int argc, const char* const* argv) {
         input->customCalibration.pressurePolynomial.poly_a = a;
         input->customCalibration.pressurePolynomial.poly_b = b;
         input->customCalibration.pressurePolynomial.poly_c = c;
+        buildAdcLut(input);  // Counts table was built from the old calibration
 
         msg.control.print(F("Pressure Polynomial calibration set for pin "));
         msg.control.println(argv[1]);
@@ -1434,7 +2431,7 @@ static int cmd_enable(int argc, const char* const* argv) {
     }
 
     bool valid;
-    uint8_t pin = parsePin(argv[1], &valid);
+    InputPin pin = parsePin(argv[1], &valid);
     if (!valid) return 1;
 
     enableInput(pin, true);
@@ -1452,7 +2449,7 @@ static int cmd_disable(int argc, const char* const* argv) {
     }
 
     bool valid;
-    uint8_t pin = parsePin(argv[1], &valid);
+    InputPin pin = parsePin(argv[1], &valid);
     if (!valid) return 1;
 
     enableInput(pin, false);
@@ -1470,7 +2467,7 @@ static int cmd_clear(int argc, const char* const* argv) {
     }
 
     bool valid;
-    uint8_t pin = parsePin(argv[1], &valid);
+    InputPin pin = parsePin(argv[1], &valid);
     if (!valid) return 1;
 
     clearInput(pin);
@@ -1483,15 +2480,40 @@ static int cmd_clear(int argc, const char* const* argv) {
 static int cmd_info(int argc, const char* const* argv) {
         if (argc < 2) {
         msg.control.println(F("ERROR: INFO requires a pin"));
-        msg.control.println(F("  Usage: INFO <pin> [ALARM|OUTPUT|CALIBRATION]"));
+        msg.control.println(F("  Usage: INFO <pin> [ALARM|OUTPUT|CALIBRATION|HEALTH|SUMMARY [RESET]]"));
         return 1;
     }
 
+    // Session statistics restart (a new drive) - allowed in RUN mode like the rest of INFO
+    bool summaryReset = argc == 4 && streq(argv[2], "SUMMARY") && streq(argv[3], "RESET");
+    if (summaryReset && streq(argv[1], "ALL")) {
+        uint32_t now = millis();
+        for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+            if (inputs[i].pin != 0xFF) resetInputSession(&inputs[i], now);
+        }
+        msg.control.println(F("Session statistics reset for all inputs"));
+        return 0;
+    }
+
     bool valid;
-    uint8_t pin = parsePin(argv[1], &valid);
+    InputPin pin = parsePin(argv[1], &valid);
     if (!valid) return 1;
 
-    // Check for subcommands (ALARM, CALIBRATION, OUTPUT)
+    if (summaryReset) {
+        Input* input = getInputByPin(pin);
+        if (input == nullptr) {
+            msg.control.print(F("ERROR: Input for pin "));
+            msg.control.print(argv[1]);
+            msg.control.println(F(" not found"));
+            return 1;
+        }
+        resetInputSession(input, millis());
+        msg.control.print(F("Session statistics reset for "));
+        msg.control.println(argv[1]);
+        return 0;
+    }
+
+    // Check for subcommands (ALARM, CALIBRATION, OUTPUT, HEALTH, SUMMARY)
     if (argc == 3) {
         if (streq(argv[2], "ALARM")) {
             printInputAlarmInfo(pin);
@@ -1499,6 +2521,10 @@ static int cmd_info(int argc, const char* const* argv) {
             printInputOutputInfo(pin);
         } else if (streq(argv[2], "CALIBRATION")) {
             printInputCalibration(pin);
+        } else if (streq(argv[2], "HEALTH")) {
+            printInputHealthInfo(pin);
+        } else if (streq(argv[2], "SUMMARY")) {
+            printInputSummaryInfo(pin);
         } else {
             msg.control.print(F("ERROR: Unknown INFO subcommand '"));
             msg.control.print(argv[2]);
@@ -1515,7 +2541,7 @@ static int cmd_info(int argc, const char* const* argv) {
 static int cmd_output(int argc, const char* const* argv) {
     if (argc < 2) {
         msg.control.println(F("ERROR: OUTPUT requires a subcommand"));
-        msg.control.println(F("  Usage: OUTPUT STATUS | <name> ENABLE | DISABLE | INTERVAL <ms>"));
+        msg.control.println(F("  Usage: OUTPUT STATUS | <name> ENABLE | DISABLE | INTERVAL <ms> | MODE <mode> [deadband] | AGGREGATE <stat> | FORMAT <format> | QOS <0|1>"));
         return 1;
     }
 
@@ -1527,7 +2553,7 @@ static int cmd_output(int argc, const char* const* argv) {
     // All other subcommands require a name
     if (argc < 3) {
         msg.control.println(F("ERROR: Subcommand requires an output name"));
-        msg.control.println(F("  Usage: OUTPUT <name> ENABLE | DISABLE | INTERVAL <ms>"));
+        msg.control.println(F("  Usage: OUTPUT <name> ENABLE | DISABLE | INTERVAL <ms> | MODE <mode> [deadband] | AGGREGATE <stat> | FORMAT <format> | QOS <0|1>"));
         return 1;
     }
 
@@ -1571,52 +2597,333 @@ static int cmd_output(int argc, const char* const* argv) {
             msg.control.println(F("'"));
             return 1;
         }
-    } else {
-        msg.control.print(F("ERROR: Unknown subcommand '"));
-        msg.control.print(subcommand);
-        msg.control.println(F("'"));
-        msg.control.println(F("Valid commands: STATUS, or <module> ENABLE|DISABLE|INTERVAL"));
-        return 1;
-    }
-
-    return 0;
-}
-
-static int cmd_display(int argc, const char* const* argv) {
-    if (argc < 2) {
-        msg.control.println(F("ERROR: DISPLAY requires a subcommand"));
-        msg.control.println(F("  Usage: DISPLAY STATUS | ENABLE | DISABLE | TYPE <type> | ADDRESS <hex> | INTERVAL <ms>"));
-        return 1;
-    }
-
-    const char* subcommand = argv[1];
+    } else if (streq(subcommand, "MODE")) {
+        // OUTPUT <name> MODE <PERIODIC|CHANGE|HEARTBEAT> [deadband]
+        if (argc < 4) {
+            msg.control.println(F("ERROR: MODE requires PERIODIC, CHANGE or HEARTBEAT"));
+            msg.control.println(F("  Usage: OUTPUT <name> MODE <PERIODIC|CHANGE|HEARTBEAT> [deadband]"));
+            return 1;
+        }
+        OutputSendMode mode;
+        if (streq(argv[3], "PERIODIC")) {
+            mode = OUTPUT_MODE_PERIODIC;
+        } else if (streq(argv[3], "CHANGE")) {
+            mode = OUTPUT_MODE_ON_CHANGE;
+        } else if (streq(argv[3], "HEARTBEAT")) {
+            mode = OUTPUT_MODE_HEARTBEAT;
+        } else {
+            msg.control.print(F("ERROR: Unknown mode '"));
+            msg.control.print(argv[3]);
+            msg.control.println(F("'"));
+            msg.control.println(F("  Valid: PERIODIC, CHANGE, HEARTBEAT"));
+            return 1;
+        }
 
-    // DISPLAY STATUS
-    if (streq(subcommand, "STATUS")) {
-        msg.control.println(F("=== Display Configuration ==="));
-        msg.control.print(F("Status: "));
-        msg.control.println(systemConfig.displayEnabled ? F("Enabled") : F("Disabled"));
-        msg.control.print(F("Type: "));
-        switch (systemConfig.displayType) {
-            case DISPLAY_NONE: msg.control.println(F("None")); break;
-            case DISPLAY_LCD: msg.control.println(F("LCD")); break;
-            case DISPLAY_OLED: msg.control.println(F("OLED")); break;
-            default: msg.control.println(F("Unknown")); break;
+        // Deadband in standard units (e.g. 0.5 = half a degree C), stored as hundredths
+        float deadband = (argc >= 5) ? atof(argv[4]) : 0.0f;
+        if (deadband < 0.0f || deadband > 655.35f) {
+            msg.control.println(F("ERROR: Deadband must be 0-655.35 (standard units)"));
+            return 1;
         }
-        msg.control.print(F("LCD I2C Address: 0x"));
-        msg.control.println(systemConfig.lcdI2CAddress, HEX);
-        msg.control.print(F("Update Interval: "));
-        msg.control.print(systemConfig.lcdUpdateInterval);
-        msg.control.println(F("ms"));
-        return 0;
-    }
 
-    // DISPLAY ENABLE
-    if (streq(subcommand, "ENABLE")) {
-        systemConfig.displayEnabled = 1;
-        setDisplayRuntime(true);
-        msg.control.println(F("Display enabled (use SAVE to persist)"));
-        return 0;
+        if (!getOutputByName(outputName)) {
+            msg.control.print(F("ERROR: Unknown output '"));
+            msg.control.print(outputName);
+            msg.control.println(F("'"));
+            return 1;
+        }
+        if (setOutputMode(outputName, mode, (uint16_t)(deadband * 100.0f + 0.5f))) {
+            msg.control.print(outputName);
+            msg.control.print(F(" mode set to "));
+            msg.control.print(argv[3]);
+            if (mode != OUTPUT_MODE_PERIODIC) {
+                msg.control.print(F(", deadband "));
+                msg.control.print(deadband, 2);
+            }
+            msg.control.println();
+        } else {
+            msg.control.print(F("ERROR: '"));
+            msg.control.print(outputName);
+            msg.control.println(F("' is not a data output (CAN, RealDash, Serial, SD_Log, MQTT)"));
+            return 1;
+        }
+    } else if (streq(subcommand, "AGGREGATE")) {
+        // OUTPUT <name> AGGREGATE <LAST|MEAN|MIN|MAX>
+        if (argc < 4) {
+            msg.control.println(F("ERROR: AGGREGATE requires LAST, MEAN, MIN or MAX"));
+            msg.control.println(F("  Usage: OUTPUT <name> AGGREGATE <LAST|MEAN|MIN|MAX>"));
+            return 1;
+        }
+        OutputAggregate aggregate;
+        if (streq(argv[3], "LAST")) {
+            aggregate = OUTPUT_AGG_LAST;
+        } else if (streq(argv[3], "MEAN")) {
+            aggregate = OUTPUT_AGG_MEAN;
+        } else if (streq(argv[3], "MIN")) {
+            aggregate = OUTPUT_AGG_MIN;
+        } else if (streq(argv[3], "MAX")) {
+            aggregate = OUTPUT_AGG_MAX;
+        } else {
+            msg.control.print(F("ERROR: Unknown aggregate '"));
+            msg.control.print(argv[3]);
+            msg.control.println(F("'"));
+            msg.control.println(F("  Valid: LAST, MEAN, MIN, MAX"));
+            return 1;
+        }
+
+        if (!getOutputByName(outputName)) {
+            msg.control.print(F("ERROR: Unknown output '"));
+            msg.control.print(outputName);
+            msg.control.println(F("'"));
+            return 1;
+        }
+        if (setOutputAggregate(outputName, aggregate)) {
+            msg.control.print(outputName);
+            msg.control.print(F(" aggregate set to "));
+            msg.control.println(getOutputAggregateName(aggregate));
+        } else {
+            msg.control.print(F("ERROR: '"));
+            msg.control.print(outputName);
+            msg.control.println(F("' is not a data output (CAN, RealDash, Serial, SD_Log, MQTT)"));
+            return 1;
+        }
+    } else if (streq(subcommand, "FORMAT") && getOutputByName(outputName) == getOutputByIndex(OUTPUT_MQTT)) {
+        // OUTPUT MQTT FORMAT <JSON|BINARY>
+        if (argc < 4) {
+            msg.control.print(F("MQTT format: "));
+            msg.control.println(getMqttFormatName(getMqttFormat()));
+            msg.control.println(F("  Usage: OUTPUT MQTT FORMAT <JSON|BINARY>"));
+            return 0;
+        }
+        MqttFormat format;
+        if (streq(argv[3], "JSON")) {
+            format = MQTT_FORMAT_JSON;
+        } else if (streq(argv[3], "BINARY")) {
+            format = MQTT_FORMAT_BINARY;
+        } else {
+            msg.control.print(F("ERROR: Unknown format '"));
+            msg.control.print(argv[3]);
+            msg.control.println(F("'"));
+            msg.control.println(F("  Valid: JSON, BINARY"));
+            return 1;
+        }
+        if (!setMqttFormat(format)) {
+            msg.control.println(F("ERROR: MQTT is not available on this build"));
+            return 1;
+        }
+        msg.control.print(F("MQTT format set to "));
+        msg.control.println(getMqttFormatName(format));
+        msg.control.println(F("  (use SAVE to persist)"));
+    } else if (streq(subcommand, "FORMAT")) {
+        // OUTPUT Serial FORMAT <CSV|WIDE|BINARY|COMPRESSED>
+        if (getOutputByName(outputName) != getOutputByIndex(OUTPUT_SERIAL)) {
+            msg.control.println(F("ERROR: FORMAT is only available for Serial and MQTT"));
+            return 1;
+        }
+        if (argc < 4) {
+            msg.control.print(F("Serial format: "));
+            msg.control.println(getSerialFormatName(getSerialFormat()));
+            msg.control.println(F("  Usage: OUTPUT Serial FORMAT <CSV|WIDE|BINARY|COMPRESSED>"));
+            return 0;
+        }
+        SerialFormat format;
+        if (streq(argv[3], "CSV")) {
+            format = SERIAL_FORMAT_CSV;
+        } else if (streq(argv[3], "WIDE")) {
+            format = SERIAL_FORMAT_WIDE;
+        } else if (streq(argv[3], "BINARY")) {
+            format = SERIAL_FORMAT_BINARY;
+        } else if (streq(argv[3], "COMPRESSED")) {
+            format = SERIAL_FORMAT_COMPRESSED;
+        } else {
+            msg.control.print(F("ERROR: Unknown format '"));
+            msg.control.print(argv[3]);
+            msg.control.println(F("'"));
+            msg.control.println(F("  Valid: CSV, WIDE, BINARY, COMPRESSED"));
+            return 1;
+        }
+        if (!setSerialFormat(format)) {
+            msg.control.print(F("ERROR: "));
+            msg.control.print(getSerialFormatName(format));
+            msg.control.println(F(" is not available on this build"));
+            return 1;
+        }
+        msg.control.print(F("Serial format set to "));
+        msg.control.println(getSerialFormatName(format));
+        msg.control.println(F("  (use SAVE to persist)"));
+    } else if (streq(subcommand, "XML")) {
+        // OUTPUT RealDash XML - channel description for the current inputs
+        if (getOutputByName(outputName) != getOutputByIndex(OUTPUT_REALDASH)) {
+            msg.control.println(F("ERROR: XML is only available for RealDash"));
+            return 1;
+        }
+        printRealdashXML();
+    } else if (streq(subcommand, "QOS") || streq(subcommand, "STATUS")) {
+        // OUTPUT MQTT QOS <0|1>, OUTPUT MQTT STATUS
+        if (getOutputByName(outputName) != getOutputByIndex(OUTPUT_MQTT)) {
+            msg.control.print(F("ERROR: "));
+            msg.control.print(subcommand);
+            msg.control.println(F(" is only available for MQTT"));
+            return 1;
+        }
+#ifdef ENABLE_MQTT
+        if (streq(subcommand, "STATUS")) {
+            printMqttStatus();
+            return 0;
+        }
+        if (argc < 4) {
+            msg.control.print(F("MQTT QoS: "));
+            msg.control.println(getMqttQos());
+            msg.control.println(F("  Usage: OUTPUT MQTT QOS <0|1>"));
+            return 0;
+        }
+        if (!isdigit(argv[3][0]) || !setMqttQos(atoi(argv[3]))) {
+            msg.control.println(F("ERROR: QoS must be 0 or 1"));
+            return 1;
+        }
+        msg.control.print(F("MQTT QoS set to "));
+        msg.control.println(getMqttQos());
+        msg.control.println(F("  (use SAVE to persist)"));
+#else
+        msg.control.println(F("ERROR: MQTT is not available on this build (ENABLE_MQTT)"));
+        return 1;
+#endif
+    } else {
+        msg.control.print(F("ERROR: Unknown subcommand '"));
+        msg.control.print(subcommand);
+        msg.control.println(F("'"));
+        msg.control.println(F("Valid commands: STATUS, or <module> ENABLE|DISABLE|INTERVAL|MODE|AGGREGATE, Serial FORMAT, MQTT FORMAT|QOS|STATUS, RealDash XML"));
+        return 1;
+    }
+
+    return 0;
+}
+
+static int cmd_display(int argc, const char* const* argv) {
+    if (argc < 2) {
+        msg.control.println(F("ERROR: DISPLAY requires a subcommand"));
+        msg.control.println(F("  Usage: DISPLAY STATUS | ENABLE | DISABLE | TYPE <type> | ADDRESS <hex> | INTERVAL <ms>"));
+        msg.control.println(F("         DISPLAY PAGE <n>|NEXT | ROTATE <seconds> | PIN ON|OFF"));
+        return 1;
+    }
+
+    const char* subcommand = argv[1];
+
+    if (isInRunMode() && !streq(subcommand, "STATUS") && !streq(subcommand, "PAGE")) {
+        msg.control.println(F("ERROR: Only DISPLAY STATUS and DISPLAY PAGE are available in RUN mode"));
+        return 1;
+    }
+
+    // DISPLAY STATUS
+    if (streq(subcommand, "STATUS")) {
+        msg.control.println(F("=== Display Configuration ==="));
+        msg.control.print(F("Status: "));
+        msg.control.println(systemConfig.displayEnabled ? F("Enabled") : F("Disabled"));
+        msg.control.print(F("Type: "));
+        switch (systemConfig.displayType) {
+            case DISPLAY_NONE: msg.control.println(F("None")); break;
+            case DISPLAY_LCD: msg.control.println(F("LCD")); break;
+            case DISPLAY_OLED: msg.control.println(F("OLED")); break;
+            default: msg.control.println(F("Unknown")); break;
+        }
+        msg.control.print(F("LCD I2C Address: 0x"));
+        msg.control.println(systemConfig.lcdI2CAddress, HEX);
+        msg.control.print(F("Update Interval: "));
+        msg.control.print(systemConfig.lcdUpdateInterval);
+        msg.control.println(F("ms"));
+        msg.control.print(F("Page Rotation: "));
+        if (systemConfig.lcdPageSeconds) {
+            msg.control.print(systemConfig.lcdPageSeconds);
+            msg.control.println(F("s"));
+        } else {
+            msg.control.println(F("Manual"));
+        }
+        msg.control.print(F("Alarm Pinning: "));
+        msg.control.println(systemConfig.lcdPinAlarms ? F("On") : F("Off"));
+#if defined(ENABLE_LCD) || defined(ENABLE_OLED)
+        msg.control.print(F("Page: "));
+        msg.control.print(getLCDPage() + 1);
+        msg.control.print(F(" of "));
+        msg.control.println(getLCDPageCount());
+#endif
+        return 0;
+    }
+
+    // DISPLAY PAGE <n>|NEXT
+    if (streq(subcommand, "PAGE")) {
+#if defined(ENABLE_LCD) || defined(ENABLE_OLED)
+        if (argc < 3) {
+            msg.control.println(F("ERROR: PAGE requires a page number or NEXT"));
+            msg.control.println(F("  Usage: DISPLAY PAGE <n>|NEXT"));
+            return 1;
+        }
+        uint8_t pageCount = getLCDPageCount();
+        uint8_t next;
+        if (streq(argv[2], "NEXT")) {
+            next = (getLCDPage() + 1) % pageCount;
+        } else {
+            int n = atoi(argv[2]);
+            if (n < 1 || n > pageCount) {
+                msg.control.print(F("ERROR: Page must be 1-"));
+                msg.control.println(pageCount);
+                return 1;
+            }
+            next = n - 1;
+        }
+        showLCDPage(next);
+        msg.control.print(F("Showing page "));
+        msg.control.print(next + 1);
+        msg.control.print(F(" of "));
+        msg.control.println(pageCount);
+        return 0;
+#else
+        msg.control.println(F("ERROR: No display support compiled in"));
+        return 1;
+#endif
+    }
+
+    // DISPLAY ROTATE <seconds>
+    if (streq(subcommand, "ROTATE")) {
+        if (argc < 3) {
+            msg.control.println(F("ERROR: ROTATE requires a time in seconds"));
+            msg.control.println(F("  Usage: DISPLAY ROTATE <seconds>  (0 = manual, DISPLAY PAGE)"));
+            return 1;
+        }
+        int seconds = atoi(argv[2]);
+        if (seconds < 0 || seconds > 255) {
+            msg.control.println(F("ERROR: Rotation must be 0-255 seconds"));
+            return 1;
+        }
+        systemConfig.lcdPageSeconds = (uint8_t)seconds;
+        if (seconds) {
+            msg.control.print(F("Pages rotate every "));
+            msg.control.print(seconds);
+            msg.control.println(F(" s (use SAVE to persist)"));
+        } else {
+            msg.control.println(F("Page rotation off - use DISPLAY PAGE (use SAVE to persist)"));
+        }
+        return 0;
+    }
+
+    // DISPLAY PIN ON|OFF
+    if (streq(subcommand, "PIN")) {
+        if (argc < 3 || (!streq(argv[2], "ON") && !streq(argv[2], "OFF"))) {
+            msg.control.println(F("ERROR: Usage: DISPLAY PIN ON|OFF"));
+            return 1;
+        }
+        systemConfig.lcdPinAlarms = streq(argv[2], "ON") ? 1 : 0;
+        msg.control.println(systemConfig.lcdPinAlarms
+            ? F("Inputs in warning/alarm pinned to every page (use SAVE to persist)")
+            : F("Alarm pinning off (use SAVE to persist)"));
+        return 0;
+    }
+
+    // DISPLAY ENABLE
+    if (streq(subcommand, "ENABLE")) {
+        systemConfig.displayEnabled = 1;
+        setDisplayRuntime(true);
+        msg.control.println(F("Display enabled (use SAVE to persist)"));
+        return 0;
     }
 
     // DISPLAY DISABLE
@@ -1695,15 +3002,102 @@ static int cmd_display(int argc, const char* const* argv) {
     msg.control.print(F("ERROR: Unknown subcommand '"));
     msg.control.print(subcommand);
     msg.control.println(F("'"));
-    msg.control.println(F("  Valid commands: STATUS, ENABLE, DISABLE, TYPE, ADDRESS, INTERVAL"));
+    msg.control.println(F("  Valid commands: STATUS, ENABLE, DISABLE, TYPE, ADDRESS, INTERVAL, PAGE, ROTATE, PIN"));
     msg.control.println(F("  Note: Unit configuration moved to SYSTEM UNITS"));
     return 1;
 }
 
+// TRANSPORT PROFILE <transport> [RATE <bytes/s>] [STREAMS ALL|NONE|<stream>...] | CLEAR
+static int cmd_transport_profile(int argc, const char* const* argv) {
+    if (argc < 3) {
+        msg.control.println(F("ERROR: Usage: TRANSPORT PROFILE <transport> [RATE <bytes/s>] [STREAMS <streams>] | CLEAR"));
+        msg.control.println(F("  Streams: TEXT, REALDASH, SERIAL, ALL, NONE"));
+        return 1;
+    }
+
+    bool transportValid = false;
+    TransportID transport = parseTransport(argv[2], &transportValid);
+    if (!transportValid || transport == TRANSPORT_NONE) {
+        msg.control.print(F("ERROR: Unknown transport '"));
+        msg.control.print(argv[2]);
+        msg.control.println(F("'"));
+        return 1;
+    }
+
+    const DataProfile* current = router.getDataProfile(transport);  // nullptr with profiles off
+    if (!current) {
+        msg.control.println(F("ERROR: Data plane profiles not available (ROUTER_DATA_PROFILES=0)"));
+        return 1;
+    }
+    if (argc == 3) {
+        router.printDataProfile(transport);
+        msg.control.println();
+        return 0;
+    }
+
+    if (isInRunMode()) {
+        msg.control.println(F("ERROR: Routing changes need CONFIG mode (TRANSPORT STATUS, RESET and FRAMING work in RUN)"));
+        return 1;
+    }
+
+    uint32_t rate = current->rate;
+    uint8_t streams = current->streams;
+    if (streq(argv[3], "CLEAR")) {
+        rate = 0;
+        streams = DATA_STREAMS_ALL;
+    } else {
+        int i = 3;
+        while (i < argc) {
+            if (streq(argv[i], "RATE") && i + 1 < argc) {
+                rate = strtoul(argv[i + 1], nullptr, 10);
+                if (rate > 65535) {
+                    msg.control.println(F("ERROR: RATE is 0 (unshaped) to 65535 bytes/s"));
+                    return 1;
+                }
+                i += 2;
+            } else if (streq(argv[i], "STREAMS") && i + 1 < argc) {
+                streams = 0;
+                for (i++; i < argc && !streq(argv[i], "RATE"); i++) {
+                    if (streq(argv[i], "ALL")) {
+                        streams = DATA_STREAMS_ALL;
+                    } else if (streq(argv[i], "NONE")) {
+                        streams = 0;
+                    } else if (streq(argv[i], "TEXT")) {
+                        streams |= 1u << DATA_STREAM_TEXT;
+                    } else if (streq(argv[i], "REALDASH")) {
+                        streams |= 1u << DATA_STREAM_REALDASH;
+                    } else if (streq(argv[i], "SERIAL")) {
+                        streams |= 1u << DATA_STREAM_SERIAL;
+                    } else {
+                        msg.control.print(F("ERROR: Unknown stream '"));
+                        msg.control.print(argv[i]);
+                        msg.control.println(F("'"));
+                        msg.control.println(F("  Valid: TEXT, REALDASH, SERIAL, ALL, NONE"));
+                        return 1;
+                    }
+                }
+            } else {
+                msg.control.print(F("ERROR: Expected RATE <bytes/s> or STREAMS <streams>, got '"));
+                msg.control.print(argv[i]);
+                msg.control.println(F("'"));
+                return 1;
+            }
+        }
+    }
+
+    router.setDataProfile(transport, (uint16_t)rate, streams);
+    msg.control.print(F("Set profile "));
+    router.printDataProfile(transport);
+    msg.control.println();
+    router.syncConfig();
+    msg.control.println(F("Use SAVE to persist"));
+    return 0;
+}
+
 static int cmd_transport(int argc, const char* const* argv) {
     if (argc < 2) {
         msg.control.println(F("ERROR: TRANSPORT requires a subcommand"));
-        msg.control.println(F("  Usage: TRANSPORT STATUS | <plane> <transport>"));
+        msg.control.println(F("  Usage: TRANSPORT STATUS | RESET | FRAMING [ON|OFF] | PROFILE <transport> ... | <plane> <transport> | <plane> ADD|REMOVE <transport> | <plane> POLICY <policy>"));
         msg.control.println(F("  (Use LIST TRANSPORTS to see available transports)"));
         return 1;
     }
@@ -1713,6 +3107,48 @@ static int cmd_transport(int argc, const char* const* argv) {
         return 0;
     }
 
+    if (streq(argv[1], "RESET")) {
+        router.resetTransportCounters();
+        msg.control.println(F("Transport traffic counters reset"));
+        return 0;
+    }
+
+    // TRANSPORT FRAMING [ON|OFF] - plane frames on the transport the command came from
+    if (streq(argv[1], "FRAMING")) {
+        TransportInterface* t = router.getActiveControlTransport();
+        if (!t) t = router.getTransport(PLANE_CONTROL);
+        if (!t) return 1;
+        if (argc < 3) {
+            msg.control.print(t->getName());
+            msg.control.println(t->isFramed() ? F(": plane framing ON") : F(": plane framing OFF"));
+            return 0;
+        }
+        bool on = streq(argv[2], "ON");
+        if (!on && !streq(argv[2], "OFF")) {
+            msg.control.println(F("ERROR: Usage: TRANSPORT FRAMING [ON|OFF]"));
+            return 1;
+        }
+        if (!t->setFraming(on)) {
+            msg.control.print(F("ERROR: "));
+            msg.control.print(t->getName());
+            msg.control.println(F(" has no plane framing"));
+            return 1;
+        }
+        msg.control.print(t->getName());
+        msg.control.println(on ? F(": plane framing ON ('c'/'d'/'g' frames)") : F(": plane framing OFF"));
+        return 0;
+    }
+
+    // TRANSPORT PROFILE <transport> [RATE <bytes/s>] [STREAMS ALL|NONE|<stream>...] | CLEAR
+    if (streq(argv[1], "PROFILE")) {
+        return cmd_transport_profile(argc, argv);
+    }
+
+    if (isInRunMode()) {
+        msg.control.println(F("ERROR: Routing changes need CONFIG mode (TRANSPORT STATUS, RESET and FRAMING work in RUN)"));
+        return 1;
+    }
+
     // All other subcommands require a plane and transport
     if (argc < 3) {
         msg.control.println(F("ERROR: Subcommand requires a plane and transport"));
@@ -1729,20 +3165,80 @@ static int cmd_transport(int argc, const char* const* argv) {
         return 1;
     }
 
+    // TRANSPORT <plane> POLICY <DROP_OLDEST|DROP_NEWEST|BLOCK|DEFAULT>
+    if (streq(argv[2], "POLICY")) {
+        if (argc < 4) {
+            msg.control.print(F("Overflow policy: "));
+            msg.control.println(MessageRouter::getTxPolicyName(router.getTxPolicy(plane)));
+            return 0;
+        }
+        bool policyValid = false;
+        TxOverflowPolicy policy = parseTxPolicy(argv[3], &policyValid);
+        if (!policyValid) {
+            msg.control.print(F("ERROR: Unknown policy '"));
+            msg.control.print(argv[3]);
+            msg.control.println(F("'"));
+            msg.control.println(F("  Valid: DROP_OLDEST, DROP_NEWEST, BLOCK, DEFAULT"));
+            return 1;
+        }
+        if (!router.setTxPolicy(plane, policy)) {
+            msg.control.println(F("ERROR: Only the CONTROL plane may BLOCK"));
+            return 1;
+        }
+        msg.control.print(F("Set "));
+        msg.control.print(argv[1]);
+        msg.control.print(F(" overflow → "));
+        msg.control.println(MessageRouter::getTxPolicyName(router.getTxPolicy(plane)));
+        router.syncConfig();
+        msg.control.println(F("Use SAVE to persist"));
+        return 0;
+    }
+
+    // TRANSPORT <plane> ADD|REMOVE <transport> - subscribers besides the primary
+    bool add = streq(argv[2], "ADD");
+    bool remove = streq(argv[2], "REMOVE");
+    const char* name = argv[2];
+    if (add || remove) {
+        if (argc < 4) {
+            msg.control.print(F("ERROR: Usage: TRANSPORT <plane> "));
+            msg.control.print(argv[2]);
+            msg.control.println(F(" <transport>"));
+            return 1;
+        }
+        name = argv[3];
+    }
+
     bool transportValid = false;
-    TransportID transport = parseTransport(argv[2], &transportValid);
-    if (!transportValid) {
+    TransportID transport = parseTransport(name, &transportValid);
+    if (!transportValid || ((add || remove) && transport == TRANSPORT_NONE)) {
         msg.control.print(F("ERROR: Unknown transport '"));
-        msg.control.print(argv[2]);
+        msg.control.print(name);
         msg.control.println(F("'"));
         return 1;
     }
 
-    if (router.setTransport(plane, transport)) {
-        msg.control.print(F("Set "));
+    if (remove) {
+        if (!router.removeSubscriber(plane, transport)) {
+            msg.control.print(F("ERROR: "));
+            msg.control.print(name);
+            msg.control.print(F(" is not a subscriber of "));
+            msg.control.println(argv[1]);
+            return 1;
+        }
+        msg.control.print(F("Removed "));
+        msg.control.print(name);
+        msg.control.print(F(" from "));
+        msg.control.println(argv[1]);
+        router.syncConfig();
+        msg.control.println(F("Use SAVE to persist"));
+        return 0;
+    }
+
+    if (add ? router.addSubscriber(plane, transport) : router.setTransport(plane, transport)) {
+        msg.control.print(add ? F("Added ") : F("Set "));
         msg.control.print(argv[1]);
-        msg.control.print(F(" → "));
-        msg.control.println(argv[2]);
+        msg.control.print(add ? F(" + ") : F(" → "));
+        msg.control.println(name);
 
         // Sync router state to systemConfig (will be persisted on SAVE)
         router.syncConfig();
@@ -1759,7 +3255,7 @@ static int cmd_transport(int argc, const char* const* argv) {
             msg.control.println(F(" ENABLE"));
         } else {
             msg.control.print(F("ERROR: Transport '"));
-            msg.control.print(argv[2]);
+            msg.control.print(name);
             msg.control.println(F("' not available"));
         }
         return 1;
@@ -1771,7 +3267,7 @@ static int cmd_transport(int argc, const char* const* argv) {
 static int cmd_system(int argc, const char* const* argv) {
     if (argc < 2) {
         msg.control.println(F("ERROR: SYSTEM requires a subcommand"));
-        msg.control.println(F("  Usage: SYSTEM STATUS | DUMP | PINS | UNITS | SEA_LEVEL | INTERVAL | REBOOT | RESET"));
+        msg.control.println(F("  Usage: SYSTEM STATUS | DUMP [JSON|BIN] | PINS | UNITS | SEA_LEVEL | INTERVAL | LOOP | EEPROM | MEMORY | POWER | WATCHDOG | BENCHMARK | REBOOT | RESET"));
         return 1;
     }
 
@@ -1788,7 +3284,7 @@ static int cmd_system(int argc, const char* const* argv) {
         }
         // Specific pin query
         bool valid = false;
-        uint8_t pin = parsePin(argv[2], &valid);
+        InputPin pin = parsePin(argv[2], &valid);
         if (valid) {
             printPinStatus(pin);
             return 0;
@@ -1797,13 +3293,17 @@ static int cmd_system(int argc, const char* const* argv) {
         return 1;
     }
 
-    // SYSTEM DUMP [JSON]
+    // SYSTEM DUMP [JSON|BIN]
     if (streq(argv[1], "DUMP")) {
         // Check for "SYSTEM DUMP JSON" variant
         if (argc == 3 && streq(argv[2], "JSON")) {
-            msg.control.println();
-            dumpConfigToJSON(Serial);
-            msg.control.println();
+            startConfigDumpJSON();
+            return 0;
+        }
+
+        // Binary blob as IMPORT lines - paste them back (CONFIG mode) to restore
+        if (argc == 3 && streq(argv[2], "BIN")) {
+            dumpConfigBlobLines();
             return 0;
         }
 
@@ -1814,8 +3314,9 @@ static int cmd_system(int argc, const char* const* argv) {
         msg.control.println(F("========================================"));
         msg.control.println();
 
-        // Show inputs
+        // Show inputs (in order with the rest of the dump - not a response)
         listAllInputs();
+        finishResponse();
         msg.control.println();
 
         // Show outputs
@@ -1941,6 +3442,7 @@ static int cmd_system(int argc, const char* const* argv) {
         uint16_t interval = atoi(argv[3]);
         if (streq(argv[2], "SENSOR")) {
             systemConfig.sensorReadInterval = interval;
+            rebuildInputSchedule();  // Inputs without a sensor minimum use this interval
             msg.control.print(F("Sensor read interval set to "));
             msg.control.print(interval);
             msg.control.println(F(" ms"));
@@ -1959,6 +3461,129 @@ static int cmd_system(int argc, const char* const* argv) {
         return 0;
     }
 
+    // SYSTEM EEPROM - Queued config writes and wear counters
+    if (streq(argv[1], "EEPROM")) {
+        printEEPROMStoreStatus();
+        return 0;
+    }
+
+    // SYSTEM MEMORY - Static tables, heap and stack high-water mark
+    if (streq(argv[1], "MEMORY")) {
+        printMemoryReport();
+        return 0;
+    }
+
+    // SYSTEM POWER [SLEEP|FAIL] - Engine-off low-power mode (lib/power_manager.h),
+    // supply loss detection (lib/power_fail.h)
+    if (streq(argv[1], "POWER")) {
+#if defined(ENABLE_POWER_MANAGER) || defined(ENABLE_POWER_FAIL)
+        if (argc == 2) {
+#ifdef ENABLE_POWER_MANAGER
+            printPowerStatus();
+#endif
+#ifdef ENABLE_POWER_FAIL
+            printPowerFailStatus();
+#endif
+            return 0;
+        }
+#ifdef ENABLE_POWER_MANAGER
+        if (streq(argv[2], "SLEEP")) {
+            if (!isInRunMode()) {
+                msg.control.println(F("ERROR: SYSTEM POWER SLEEP needs RUN mode"));
+                return 1;
+            }
+            if (!requestPowerSleep()) {
+                msg.control.println(F("ERROR: No wake source (ignition pin or CAN traffic) - not sleeping"));
+                return 1;
+            }
+            msg.control.println(F("Sleeping until ignition, CAN or serial activity"));
+            return 0;
+        }
+#endif
+#ifdef ENABLE_POWER_FAIL
+        if (streq(argv[2], "FAIL")) {
+            requestPowerFailTest();
+            msg.control.print(F("Running the power-fail path - resumes "));
+            msg.control.print(POWER_FAIL_RECOVER_MS);
+            msg.control.println(F(" ms after, SYSTEM POWER shows the flush time"));
+            return 0;
+        }
+#endif
+        msg.control.println(F("ERROR: Unknown POWER subcommand"));
+        msg.control.println(F("  Usage: SYSTEM POWER [SLEEP|FAIL]"));
+        return 1;
+#else
+        msg.control.println(F("ERROR: Power management not available (build with -D ENABLE_POWER_MANAGER or ENABLE_POWER_FAIL)"));
+        return 1;
+#endif
+    }
+
+    // SYSTEM WATCHDOG - Task heartbeats and the last task-miss reset (lib/watchdog.h)
+    if (streq(argv[1], "WATCHDOG")) {
+#ifdef ENABLE_TASK_WATCHDOG
+        printTaskWatchdogStatus();
+        return 0;
+#else
+        msg.control.println(F("ERROR: Task watchdog not available (build with -D ENABLE_TASK_WATCHDOG)"));
+        return 1;
+#endif
+    }
+
+    // SYSTEM BENCHMARK [CSV] [<kernel>] - Hot-path kernel timings
+    if (streq(argv[1], "BENCHMARK")) {
+#ifdef ENABLE_BENCHMARK
+        bool csv = argc > 2 && streq(argv[2], "CSV");
+        uint8_t filterArg = csv ? 3 : 2;
+        const char* filter = argc > filterArg ? argv[filterArg] : nullptr;
+        if (runBenchmarks(csv, filter) == 0) {
+            msg.control.print(F("ERROR: Unknown kernel '"));
+            msg.control.print(filter);
+            msg.control.println(F("'"));
+            msg.control.println(F("  Usage: SYSTEM BENCHMARK [CSV] [<kernel>]"));
+            return 1;
+        }
+        return 0;
+#else
+        msg.control.println(F("ERROR: Benchmarks not available (build with -D ENABLE_BENCHMARK)"));
+        return 1;
+#endif
+    }
+
+    // SYSTEM LOOP [RESET | BUDGET <ms>] - Loop budget monitor
+    if (streq(argv[1], "LOOP")) {
+        if (argc == 2) {
+            printLoopStatus();
+            return 0;
+        }
+        if (streq(argv[2], "RESET")) {
+            resetLoopHistory();
+            msg.control.println(F("Loop overrun history cleared"));
+            return 0;
+        }
+        if (streq(argv[2], "BUDGET")) {
+            if (argc < 4) {
+                msg.control.println(F("ERROR: BUDGET requires a time in ms"));
+                msg.control.println(F("  Usage: SYSTEM LOOP BUDGET <ms>"));
+                return 1;
+            }
+            int budget = atoi(argv[3]);
+            if (budget < 1 || budget > 1000) {
+                msg.control.println(F("ERROR: Budget must be 1-1000 ms"));
+                return 1;
+            }
+            setLoopBudget((uint16_t)budget);
+            msg.control.print(F("Loop budget set to "));
+            msg.control.print(budget);
+            msg.control.println(F(" ms"));
+            return 0;
+        }
+        msg.control.print(F("ERROR: Unknown LOOP subcommand '"));
+        msg.control.print(argv[2]);
+        msg.control.println(F("'"));
+        msg.control.println(F("  Usage: SYSTEM LOOP [RESET | BUDGET <ms>]"));
+        return 1;
+    }
+
     // SYSTEM REBOOT - Restart the device
     if (streq(argv[1], "REBOOT")) {
         msg.control.println(F("Rebooting system..."));
@@ -2046,7 +3671,7 @@ static int cmd_relay(int argc, const char* const* argv) {
             return 1;
         }
         bool valid = false;
-        uint8_t pin = parsePin(argv[3], &valid);
+        InputPin pin = parsePin(argv[3], &valid);
         if (valid) {
             setRelayInput(relayIndex, pin);
             msg.control.print(F("Relay "));
@@ -2071,6 +3696,63 @@ static int cmd_relay(int argc, const char* const* argv) {
         msg.control.print(argv[3]);
         msg.control.print(F(", OFF="));
         msg.control.println(argv[4]);
+    } else if (streq(subcommand, "MINTIME")) {
+        if (argc < 5) {
+            msg.control.println(F("ERROR: MINTIME requires on and off times (ms)"));
+            return 1;
+        }
+        long minOn = atol(argv[3]);
+        long minOff = atol(argv[4]);
+        if (minOn < 0 || minOff < 0 || minOn > RELAY_MAX_MIN_TIME_MS || minOff > RELAY_MAX_MIN_TIME_MS) {
+            msg.control.println(F("ERROR: Minimum times are 0-60000 ms"));
+            return 1;
+        }
+        setRelayMinTimes(relayIndex, (uint16_t)minOn, (uint16_t)minOff);
+        msg.control.print(F("Relay "));
+        msg.control.print(relayIndex);
+        msg.control.print(F(" minimum times: ON="));
+        msg.control.print(minOn);
+        msg.control.print(F("ms, OFF="));
+        msg.control.print(minOff);
+        msg.control.println(F("ms"));
+    } else if (streq(subcommand, "CURVE")) {
+        if (argc < 4) {
+            msg.control.println(F("ERROR: CURVE requires a curve name"));
+            return 1;
+        }
+        uint8_t curve = getRelayCurveByName(argv[3]);
+        if (curve == 0xFF) {
+            msg.control.print(F("ERROR: Unknown curve '"));
+            msg.control.print(argv[3]);
+            msg.control.println(F("'"));
+            msg.control.println(F("  Valid curves: LINEAR, QUADRATIC, FAN, PUMP"));
+            return 1;
+        }
+        setRelayCurve(relayIndex, (RelayCurve)curve);
+        msg.control.print(F("Relay "));
+        msg.control.print(relayIndex);
+        msg.control.print(F(" PWM curve set to "));
+        msg.control.println(getRelayCurveName(curve));
+    } else if (streq(subcommand, "FREQUENCY")) {
+        if (argc < 4) {
+            msg.control.println(F("ERROR: FREQUENCY requires a value in Hz (0 = default)"));
+            return 1;
+        }
+        long hz = atol(argv[3]);
+        if (hz < 0 || hz > RELAY_MAX_PWM_HZ) {
+            msg.control.println(F("ERROR: Frequency is 0-40000 Hz"));
+            return 1;
+        }
+        setRelayFrequency(relayIndex, (uint16_t)hz);
+        msg.control.print(F("Relay "));
+        msg.control.print(relayIndex);
+        msg.control.print(F(" PWM frequency set to "));
+        if (hz == 0) {
+            msg.control.println(F("platform default"));
+        } else {
+            msg.control.print(hz);
+            msg.control.println(F(" Hz"));
+        }
     } else if (streq(subcommand, "MODE")) {
         if (argc < 4) {
             msg.control.println(F("ERROR: MODE requires a mode name"));
@@ -2083,9 +3765,10 @@ static int cmd_relay(int argc, const char* const* argv) {
         else if (streq(argv[3], "AUTO_LOW")) { mode = RELAY_AUTO_LOW; modeValid = true; }
         else if (streq(argv[3], "MANUAL_ON")) { mode = RELAY_MANUAL_ON; modeValid = true; }
         else if (streq(argv[3], "MANUAL_OFF")) { mode = RELAY_MANUAL_OFF; modeValid = true; }
+        else if (streq(argv[3], "PWM")) { mode = RELAY_PWM; modeValid = true; }
 
         if (modeValid) {
-            setRelayMode(relayIndex, mode);
+            if (!setRelayMode(relayIndex, mode)) return 1;
             msg.control.print(F("Relay "));
             msg.control.print(relayIndex);
             msg.control.print(F(" mode set to "));
@@ -2094,14 +3777,14 @@ static int cmd_relay(int argc, const char* const* argv) {
             msg.control.print(F("ERROR: Unknown mode '"));
             msg.control.print(argv[3]);
             msg.control.println(F("'"));
-            msg.control.println(F("  Valid modes: DISABLED, AUTO_HIGH, AUTO_LOW, MANUAL_ON, MANUAL_OFF"));
+            msg.control.println(F("  Valid modes: DISABLED, AUTO_HIGH, AUTO_LOW, MANUAL_ON, MANUAL_OFF, PWM"));
             return 1;
         }
     } else {
         msg.control.print(F("ERROR: Unknown subcommand '"));
         msg.control.print(subcommand);
         msg.control.println(F("'"));
-        msg.control.println(F("Valid commands: LIST, STATUS, PIN, INPUT, THRESHOLD, MODE"));
+        msg.control.println(F("Valid commands: LIST, STATUS, PIN, INPUT, THRESHOLD, MINTIME, CURVE, FREQUENCY, MODE"));
         return 1;
     }
     return 0;
@@ -2114,6 +3797,8 @@ static int cmd_test(int argc, const char* const* argv) {
         msg.control.println(F("ERROR: TEST requires a subcommand"));
         msg.control.println(F("  Usage: TEST LIST"));
         msg.control.println(F("  Usage: TEST <0-N>"));
+        msg.control.println(F("  Usage: TEST FILE <file> [LOOP]"));
+        msg.control.println(F("  Usage: TEST CERTIFY [<seconds>] [CAN <percent>]"));
         msg.control.println(F("  Usage: TEST STOP"));
         msg.control.println(F("  Usage: TEST STATUS"));
         return 1;
@@ -2129,7 +3814,9 @@ static int cmd_test(int argc, const char* const* argv) {
 
     // TEST STOP
     if (streq(subcommand, "STOP")) {
-        if (!isTestModeActive()) {
+        if (isTestCertifyActive()) {
+            stopTestCertify();
+        } else if (!isTestModeActive()) {
             msg.control.println(F("No test scenario is currently running"));
         } else {
             stopTestMode();
@@ -2140,15 +3827,55 @@ static int cmd_test(int argc, const char* const* argv) {
 
     // TEST STATUS
     if (streq(subcommand, "STATUS")) {
-        if (!isTestModeActive()) {
-            msg.control.println(F("Test mode: INACTIVE"));
-        } else {
-            msg.control.println(F("Test mode: ACTIVE"));
-            msg.control.println(F("  Use TEST LIST to see all scenarios"));
+        printTestStatus();
+        return 0;
+    }
+
+    // TEST FILE <file> [LOOP] - recorded trace from SD
+    if (streq(subcommand, "FILE")) {
+        if (argc < 3) {
+            msg.control.println(F("ERROR: TEST FILE requires a file name"));
+            msg.control.println(F("  Usage: TEST FILE <file> [LOOP]"));
+            return 1;
+        }
+        bool loop = argc >= 4 && streq(argv[3], "LOOP");
+        if (!startTestTrace(argv[2], loop)) {
+            return 1;
         }
+        msg.control.println(F("Test trace started"));
+        msg.control.println(F("  Use TEST STATUS to check progress"));
+        msg.control.println(F("  Use TEST STOP to end early"));
         return 0;
     }
 
+    // TEST CERTIFY [<seconds>] [CAN <percent>] - worst-case load run
+    if (streq(subcommand, "CERTIFY")) {
+        if (isInConfigMode()) {
+            msg.control.println(F("ERROR: TEST CERTIFY runs in RUN mode"));
+            return 1;
+        }
+        uint32_t seconds = TEST_CERTIFY_SECONDS;
+        uint8_t canLoad = TEST_CERTIFY_CAN_LOAD;
+        for (int i = 2; i < argc; i++) {
+            if (streq(argv[i], "CAN") && i + 1 < argc) {
+                long pct = atol(argv[++i]);
+                if (pct < 0 || pct > 100) {
+                    msg.control.println(F("ERROR: CAN load must be 0-100 percent"));
+                    return 1;
+                }
+                canLoad = (uint8_t)pct;
+            } else {
+                long secs = atol(argv[i]);
+                if (secs < 1 || secs > 3600) {
+                    msg.control.println(F("ERROR: Usage: TEST CERTIFY [<1-3600 seconds>] [CAN <percent>]"));
+                    return 1;
+                }
+                seconds = (uint32_t)secs;
+            }
+        }
+        return startTestCertify(seconds, canLoad) ? 0 : 1;
+    }
+
     // TEST <scenario_number> - Try to parse as a number
     char* endPtr;
     long scenarioNum = strtol(subcommand, &endPtr, 10);
@@ -2182,37 +3909,79 @@ static int cmd_test(int argc, const char* const* argv) {
     msg.control.println(F("'"));
     msg.control.println(F("  Usage: TEST LIST"));
     msg.control.println(F("  Usage: TEST <0-N>"));
+    msg.control.println(F("  Usage: TEST FILE <file> [LOOP]"));
+    msg.control.println(F("  Usage: TEST CERTIFY [<seconds>] [CAN <percent>]"));
     msg.control.println(F("  Usage: TEST STOP"));
     msg.control.println(F("  Usage: TEST STATUS"));
     return 1;
 }
 #endif
 
+#if NUM_SERIAL_PORTS > 0
+// Baud rate argument to a BAUD_* index - unsupported rates fall back to 115200,
+// rates above what this platform's UARTs run (SERIAL_MAX_BAUD) to the fastest that do
+static uint8_t parseSerialBaud(const char* arg) {
+    uint32_t baudrate = atol(arg);
+    uint8_t baud_idx = getBaudRateIndex(baudrate);
+    if (baud_idx > getMaxBaudIndex()) {
+        baud_idx = getMaxBaudIndex();
+        msg.control.print(F("WARNING: Baud rate "));
+        msg.control.print(baudrate);
+        msg.control.print(F(" above this platform's maximum, using "));
+        msg.control.println(getBaudRateFromIndex(baud_idx));
+    } else if (getBaudRateFromIndex(baud_idx) != baudrate) {
+        msg.control.print(F("WARNING: Baud rate "));
+        msg.control.print(baudrate);
+        msg.control.print(F(" not supported, using "));
+        msg.control.println(getBaudRateFromIndex(baud_idx));
+    }
+    return baud_idx;
+}
+#endif
+
 static int cmd_bus(int argc, const char* const* argv) {
     if (argc < 2) {
         msg.control.println();
         msg.control.println(F("Commands:"));
         msg.control.println(F("  BUS I2C [0|1|2]           - Show or select I2C bus"));
         msg.control.println(F("  BUS I2C CLOCK <kHz>       - Set I2C clock (100/400/1000)"));
+        msg.control.println(F("  BUS I2C RECOVER           - Free a stuck bus, restart Wire"));
+        msg.control.println(F("  BUS I2C SCAN              - List devices, update the inventory"));
         msg.control.println(F("  BUS SPI [0|1|2]           - Show or select SPI bus"));
         msg.control.println(F("  BUS SPI CLOCK <Hz>        - Set SPI clock"));
-        msg.control.println(F("  BUS CAN                   - Show CAN status"));
+#ifdef ENABLE_EXT_ADC
+        msg.control.println(F("  BUS ADC                   - External ADCs and their channels"));
+#endif
+#ifdef ENABLE_GPS
+        msg.control.println(F("  BUS GPS                   - GPS receiver, fix and time"));
+#endif
+#ifdef ENABLE_MODBUS
+        msg.control.println(F("  BUS MODBUS                - Modbus slave counters and register map"));
+#endif
+        msg.control.println(F("  BUS CAN [STATUS]          - Show CAN status, RX load and drops"));
         msg.control.println(F("  BUS CAN BAUDRATE <bps>    - Set CAN baudrate (both buses)"));
-        msg.control.println(F("  BUS CAN INPUT <bus> <ENABLE|LISTEN|DISABLE> [bps]"));
+        msg.control.println(F("  BUS CAN INPUT <bus> <ENABLE|LISTEN|POLL|DISABLE> [bps]"));
         msg.control.println(F("  BUS CAN INPUT BAUDRATE <bps> - Set CAN input baudrate"));
+        msg.control.println(F("  BUS CAN INPUT PROTOCOL <AUTO|J1939> - 11-bit or J1939 input"));
         msg.control.println(F("  BUS CAN OUTPUT <bus> <ENABLE|DISABLE> [bps]"));
         msg.control.println(F("  BUS CAN OUTPUT BAUDRATE <bps> - Set CAN output baudrate"));
+        msg.control.println(F("  BUS CAN OUTPUT LAYOUT [OBD|PACKED [base_id]|J1939|N2K|DBC|REALDASH]"));
+        msg.control.println(F("  BUS CAN MIRROR <bus|NONE> [bps] - Second CAN output (CAN_Mirror inputs)"));
+        msg.control.println(F("  BUS CAN MIRROR INTERVAL <ms>"));
+        msg.control.println(F("  BUS CAN MIRROR LAYOUT [OBD|PACKED [base_id]|J1939|N2K|DBC|REALDASH]"));
+        msg.control.println(F("  BUS CAN J1939 ADDRESS <0-253> - J1939 source address"));
         msg.control.println(F("  BUS SERIAL                - Show all serial ports"));
         msg.control.println(F("  BUS SERIAL <1-8> ENABLE [baud] - Enable serial port"));
         msg.control.println(F("  BUS SERIAL <1-8> DISABLE  - Disable serial port"));
-        msg.control.println(F("  BUS SERIAL <1-8> BAUDRATE <rate> - Set baud rate"));
+        msg.control.println(F("  BUS SERIAL <1-8> BAUDRATE <rate> - Set baud rate (up to 4000000)"));
+        msg.control.println(F("  BUS SERIAL <1-8> FLOW <rts> <cts> - RTS/CTS flow control (FLOW OFF)"));
         return 0;
     }
 
     const char* busType = argv[1];
 
     // -------------------------------------------------------------------------
-    // BUS I2C [0|1|2] or BUS I2C CLOCK <kHz>
+    // BUS I2C [0|1|2], BUS I2C CLOCK <kHz>, BUS I2C RECOVER or BUS I2C SCAN
     // -------------------------------------------------------------------------
     if (streq(busType, "I2C")) {
         // BUS I2C (no arguments) - display I2C status
@@ -2221,6 +3990,19 @@ static int cmd_bus(int argc, const char* const* argv) {
             return 0;
         }
 
+        // BUS I2C RECOVER - clock out a stuck slave and restart Wire
+        if (streq(argv[2], "RECOVER")) {
+            bool released = i2cRecoverBus();
+            msg.control.println(released ? F("I2C bus released") : F("ERROR: I2C bus still held low - check wiring and devices"));
+            return released ? 0 : 1;
+        }
+
+        // BUS I2C SCAN - every address on the active bus, device inventory updated
+        if (streq(argv[2], "SCAN")) {
+            scanI2CBus();
+            return 0;
+        }
+
         // BUS I2C CLOCK <kHz>
         if (streq(argv[2], "CLOCK")) {
             if (argc < 4) {
@@ -2268,6 +4050,36 @@ static int cmd_bus(int argc, const char* const* argv) {
         return 0;
     }
 
+#ifdef ENABLE_EXT_ADC
+    // -------------------------------------------------------------------------
+    // BUS ADC - external ADC chips (lib/ext_adc.h)
+    // -------------------------------------------------------------------------
+    if (streq(busType, "ADC")) {
+        printExtAdcStatus();
+        return 0;
+    }
+#endif
+
+#ifdef ENABLE_GPS
+    // -------------------------------------------------------------------------
+    // BUS GPS - GPS receiver (lib/gps.h)
+    // -------------------------------------------------------------------------
+    if (streq(busType, "GPS")) {
+        printGpsStatus();
+        return 0;
+    }
+#endif
+
+#ifdef ENABLE_MODBUS
+    // -------------------------------------------------------------------------
+    // BUS MODBUS - Modbus RTU/TCP slave (lib/modbus.h)
+    // -------------------------------------------------------------------------
+    if (streq(busType, "MODBUS")) {
+        printModbusStatus();
+        return 0;
+    }
+#endif
+
     // -------------------------------------------------------------------------
     // BUS SPI [0|1|2] or BUS SPI CLOCK <Hz>
     // -------------------------------------------------------------------------
@@ -2336,8 +4148,8 @@ static int cmd_bus(int argc, const char* const* argv) {
         msg.control.println(F("ERROR: No CAN buses available on this platform"));
         return 1;
 #else
-        // BUS CAN (no arguments) - display CAN status
-        if (argc == 2) {
+        // BUS CAN or BUS CAN STATUS - display CAN status, RX load and counters
+        if (argc == 2 || streq(argv[2], "STATUS")) {
             displayCANStatus();
             return 0;
         }
@@ -2368,6 +4180,24 @@ static int cmd_bus(int argc, const char* const* argv) {
 
         // BUS CAN INPUT BAUDRATE <bps> or BUS CAN INPUT <CAN1|CAN2|CAN3> <ENABLE|DISABLE> [bps]
         if (streq(argv[2], "INPUT")) {
+            // BUS CAN INPUT PROTOCOL <AUTO|J1939>
+            if (argc >= 4 && streq(argv[3], "PROTOCOL")) {
+                if (argc >= 5 && streq(argv[4], "AUTO")) {
+                    systemConfig.buses.can_input_protocol = CAN_PROTOCOL_AUTO;
+                    msg.control.println(F("CAN input protocol set to AUTO (11-bit IDs, OBD-II or custom)"));
+                } else if (argc >= 5 && streq(argv[4], "J1939")) {
+                    systemConfig.buses.can_input_protocol = CAN_PROTOCOL_J1939;
+                    msg.control.println(F("CAN input protocol set to J1939 (29-bit IDs)"));
+                    msg.control.println(F("  CAN inputs read PGN <can_id> from source address <pid>"));
+                } else {
+                    msg.control.println(F("ERROR: Usage: BUS CAN INPUT PROTOCOL <AUTO|J1939>"));
+                    return 1;
+                }
+                msg.control.println(F("Note: Takes effect on next reboot"));
+                msg.control.println(F("Use SAVE to persist"));
+                return 0;
+            }
+
             // BUS CAN INPUT BAUDRATE <bps>
             if (argc >= 4 && streq(argv[3], "BAUDRATE")) {
                 if (argc < 5) {
@@ -2399,9 +4229,9 @@ static int cmd_bus(int argc, const char* const* argv) {
                 return 0;
             }
 
-            // BUS CAN INPUT <CAN1|CAN2|CAN3> <ENABLE|LISTEN|DISABLE> [baudrate]
+            // BUS CAN INPUT <CAN1|CAN2|CAN3> <ENABLE|LISTEN|POLL|DISABLE> [baudrate]
             if (argc < 5) {
-                msg.control.println(F("ERROR: Usage: BUS CAN INPUT <CAN1|CAN2|CAN3> <ENABLE|LISTEN|DISABLE> [baudrate]"));
+                msg.control.println(F("ERROR: Usage: BUS CAN INPUT <CAN1|CAN2|CAN3> <ENABLE|LISTEN|POLL|DISABLE> [baudrate]"));
                 return 1;
             }
 
@@ -2424,18 +4254,21 @@ static int cmd_bus(int argc, const char* const* argv) {
                 return 1;
             }
 
-            // Parse mode: ENABLE (normal with ACK), LISTEN (listen-only), DISABLE
+            // Parse mode: ENABLE (normal with ACK), LISTEN (listen-only), POLL (requests PIDs), DISABLE
             uint8_t mode = CAN_INPUT_OFF;
             if (streq(argv[4], "ENABLE") || streq(argv[4], "NORMAL")) {
                 mode = CAN_INPUT_NORMAL;
             } else if (streq(argv[4], "LISTEN")) {
                 mode = CAN_INPUT_LISTEN;
+            } else if (streq(argv[4], "POLL")) {
+                mode = CAN_INPUT_POLL;
             } else if (streq(argv[4], "DISABLE")) {
                 mode = CAN_INPUT_OFF;
             } else {
-                msg.control.println(F("ERROR: Must be ENABLE/NORMAL, LISTEN, or DISABLE"));
+                msg.control.println(F("ERROR: Must be ENABLE/NORMAL, LISTEN, POLL, or DISABLE"));
                 msg.control.println(F("  ENABLE/NORMAL - Active input with ACK (for CAN sensor devices)"));
                 msg.control.println(F("  LISTEN        - Listen-only, no ACK/TX (for sniffing ECU bus)"));
+                msg.control.println(F("  POLL          - Active input that requests OBD-II PIDs from the ECU"));
                 msg.control.println(F("  DISABLE       - Turn off CAN input"));
                 return 1;
             }
@@ -2473,11 +4306,19 @@ static int cmd_bus(int argc, const char* const* argv) {
                 systemConfig.buses.can_input_baudrate = baudrate;
 
                 msg.control.print(F("CAN input "));
-                msg.control.print(mode == CAN_INPUT_LISTEN ? F("listen-only") : F("normal"));
+                if (mode == CAN_INPUT_LISTEN) {
+                    msg.control.print(F("listen-only"));
+                } else if (mode == CAN_INPUT_POLL) {
+                    msg.control.print(F("polling"));
+                } else {
+                    msg.control.print(F("normal"));
+                }
                 msg.control.print(F(" on "));
                 msg.control.println(argv[3]);
                 if (mode == CAN_INPUT_LISTEN) {
                     msg.control.println(F("  No ACK/TX - safe for passive bus monitoring"));
+                } else if (mode == CAN_INPUT_POLL) {
+                    msg.control.println(F("  Requests the PIDs of CAN inputs on 0x7E8-0x7EF (Mode 01, up to 6 per request)"));
                 }
 
                 // Shared-bus baudrate synchronization
@@ -2502,6 +4343,54 @@ static int cmd_bus(int argc, const char* const* argv) {
 
         // BUS CAN OUTPUT BAUDRATE <bps> or BUS CAN OUTPUT <CAN1|CAN2|CAN3> <ENABLE|DISABLE> [bps]
         if (streq(argv[2], "OUTPUT")) {
+            // BUS CAN OUTPUT LAYOUT [OBD|PACKED [base_id]|J1939|N2K|DBC|REALDASH]
+            if (argc >= 4 && streq(argv[3], "LAYOUT")) {
+                if (argc == 4) {
+                    printCANBroadcastLayout(CAN_LAYOUT_TABLE);
+                    return 0;
+                }
+                if (streq(argv[4], "DBC")) {
+                    printCANBroadcastLayout(CAN_LAYOUT_DBC);
+                    return 0;
+                }
+                if (streq(argv[4], "REALDASH")) {
+                    printCANBroadcastLayout(CAN_LAYOUT_REALDASH);
+                    return 0;
+                }
+
+                if (streq(argv[4], "OBD")) {
+                    systemConfig.buses.can_output_layout = CAN_OUTPUT_OBD;
+                    rebuildCANBroadcastLayout();
+                    msg.control.println(F("CAN output layout set to OBD (one frame per input on 0x7E8)"));
+                } else if (streq(argv[4], "PACKED")) {
+                    if (argc >= 6) {
+                        uint32_t baseId = strtoul(argv[5], nullptr, 0);
+                        if (baseId > 0x7FF) {
+                            msg.control.println(F("ERROR: Base ID must be an 11-bit ID (0x000-0x7FF)"));
+                            return 1;
+                        }
+                        systemConfig.buses.can_output_base_id = baseId;
+                    }
+                    systemConfig.buses.can_output_layout = CAN_OUTPUT_PACKED;
+                    rebuildCANBroadcastLayout();
+                    printCANBroadcastLayout(CAN_LAYOUT_TABLE);
+                } else if (streq(argv[4], "J1939")) {
+                    systemConfig.buses.can_output_layout = CAN_OUTPUT_J1939;
+                    rebuildCANBroadcastLayout();
+                    printCANBroadcastLayout(CAN_LAYOUT_TABLE);
+                } else if (streq(argv[4], "N2K") || streq(argv[4], "NMEA2000")) {
+                    systemConfig.buses.can_output_layout = CAN_OUTPUT_NMEA2000;
+                    rebuildCANBroadcastLayout();
+                    printCANBroadcastLayout(CAN_LAYOUT_TABLE);
+                } else {
+                    msg.control.println(F("ERROR: Usage: BUS CAN OUTPUT LAYOUT [OBD|PACKED [base_id]|J1939|N2K|DBC|REALDASH]"));
+                    return 1;
+                }
+                applyCANOutputFilters();  // NMEA 2000 network management in or out
+                msg.control.println(F("Use SAVE to persist"));
+                return 0;
+            }
+
             // BUS CAN OUTPUT BAUDRATE <bps>
             if (argc >= 4 && streq(argv[3], "BAUDRATE")) {
                 if (argc < 5) {
@@ -2586,21 +4475,222 @@ static int cmd_bus(int argc, const char* const* argv) {
                 msg.control.print(F("CAN output enabled on "));
                 msg.control.println(argv[3]);
 
-                // Shared-bus baudrate synchronization
-                if (systemConfig.buses.input_can_bus == systemConfig.buses.output_can_bus &&
-                    systemConfig.buses.output_can_bus != 0xFF) {
-                    systemConfig.buses.can_input_baudrate = baudrate;
-                    msg.control.println(F("WARNING: Input and output share same bus - input baudrate also set to match"));
+                // Shared-bus baudrate synchronization
+                if (systemConfig.buses.input_can_bus == systemConfig.buses.output_can_bus &&
+                    systemConfig.buses.output_can_bus != 0xFF) {
+                    systemConfig.buses.can_input_baudrate = baudrate;
+                    msg.control.println(F("WARNING: Input and output share same bus - input baudrate also set to match"));
+                }
+
+                msg.control.print(F("CAN output baudrate set to "));
+                msg.control.print(baudrate / 1000);
+                msg.control.println(F("kbps"));
+            } else {
+                systemConfig.buses.can_output_enabled = 0;
+                msg.control.println(F("CAN output disabled"));
+            }
+
+            msg.control.println(F("Note: Takes effect on next reboot"));
+            msg.control.println(F("Use SAVE to persist"));
+            return 0;
+        }
+
+#ifdef ENABLE_CAN_NODES
+        // BUS CAN NODE [ID <0-15|OFF>|SUBSCRIBE <n>|UNSUBSCRIBE <n>]
+        if (streq(argv[2], "NODE")) {
+            if (argc == 3) {
+                printCANNodeStatus();
+                return 0;
+            }
+            if (argc < 5) {
+                msg.control.println(F("ERROR: Usage: BUS CAN NODE [ID <0-15|OFF>|SUBSCRIBE <n>|UNSUBSCRIBE <n>]"));
+                return 1;
+            }
+            bool off = streq(argv[4], "OFF");
+            uint32_t node = strtoul(argv[4], nullptr, 10);
+            if ((!off && node >= CAN_NODE_COUNT) || (off && !streq(argv[3], "ID"))) {
+                msg.control.println(F("ERROR: Node number must be 0-15"));
+                return 1;
+            }
+
+            if (streq(argv[3], "ID")) {
+                systemConfig.buses.can_node_id = off ? CAN_NODE_OFF : node;
+                initCANNodes();             // Join (or leave) now
+                applyCANOutputFilters();
+                if (off) {
+                    msg.control.println(F("CAN node disabled"));
+                } else {
+                    msg.control.print(F("CAN node number set to "));
+                    msg.control.println(node);
+                }
+            } else if (streq(argv[3], "SUBSCRIBE")) {
+                systemConfig.buses.can_node_subscribe |= (1U << node);
+                msg.control.print(F("Subscribed to node "));
+                msg.control.print(node);
+                msg.control.println(F(" - its channels import as NODE:n inputs when announced"));
+            } else if (streq(argv[3], "UNSUBSCRIBE")) {
+                systemConfig.buses.can_node_subscribe &= ~(1U << node);
+                msg.control.print(F("Unsubscribed from node "));
+                msg.control.print(node);
+                msg.control.println(F(" - NODE:n inputs already imported stay (CLEAR to remove)"));
+            } else {
+                msg.control.println(F("ERROR: Usage: BUS CAN NODE [ID <0-15|OFF>|SUBSCRIBE <n>|UNSUBSCRIBE <n>]"));
+                return 1;
+            }
+            msg.control.println(F("Use SAVE to persist"));
+            return 0;
+        }
+#endif
+
+        // BUS CAN J1939 ADDRESS <0-253>
+        if (streq(argv[2], "J1939")) {
+            if (argc < 5 || !streq(argv[3], "ADDRESS")) {
+                msg.control.println(F("ERROR: Usage: BUS CAN J1939 ADDRESS <0-253>"));
+                return 1;
+            }
+            uint32_t address = strtoul(argv[4], nullptr, 0);
+            if (address > 253) {
+                msg.control.println(F("ERROR: J1939 source address must be 0-253"));
+                return 1;
+            }
+            systemConfig.buses.j1939_address = address;
+            rebuildCANBroadcastLayout();  // New IDs, claimed again on a J1939 or NMEA 2000 output
+            msg.control.print(F("J1939 / NMEA 2000 source address set to 0x"));
+            msg.control.println(address, HEX);
+            msg.control.println(F("Use SAVE to persist"));
+            return 0;
+        }
+
+        // BUS CAN MIRROR <CAN1|CAN2|CAN3|NONE> [bps], INTERVAL <ms>, LAYOUT [...]
+        if (streq(argv[2], "MIRROR")) {
+            if (argc < 4) {
+                msg.control.println(F("ERROR: Usage: BUS CAN MIRROR <CAN1|CAN2|CAN3|NONE> [bps]"));
+                msg.control.println(F("       BUS CAN MIRROR INTERVAL <ms>"));
+                msg.control.println(F("       BUS CAN MIRROR LAYOUT [OBD|PACKED [base_id]|J1939|N2K|DBC|REALDASH]"));
+                return 1;
+            }
+
+            // BUS CAN MIRROR LAYOUT [OBD|PACKED [base_id]|J1939|N2K|DBC|REALDASH]
+            if (streq(argv[3], "LAYOUT")) {
+                if (argc == 4) {
+                    printCANBroadcastLayout(CAN_LAYOUT_TABLE, 1);
+                    return 0;
+                }
+                if (streq(argv[4], "DBC")) {
+                    printCANBroadcastLayout(CAN_LAYOUT_DBC, 1);
+                    return 0;
+                }
+                if (streq(argv[4], "REALDASH")) {
+                    printCANBroadcastLayout(CAN_LAYOUT_REALDASH, 1);
+                    return 0;
+                }
+
+                if (streq(argv[4], "OBD")) {
+                    systemConfig.buses.can_mirror_layout = CAN_OUTPUT_OBD;
+                    rebuildCANBroadcastLayout();
+                    msg.control.println(F("CAN mirror layout set to OBD (one frame per input on 0x7E8)"));
+                } else if (streq(argv[4], "PACKED")) {
+                    if (argc >= 6) {
+                        uint32_t baseId = strtoul(argv[5], nullptr, 0);
+                        if (baseId > 0x7FF) {
+                            msg.control.println(F("ERROR: Base ID must be an 11-bit ID (0x000-0x7FF)"));
+                            return 1;
+                        }
+                        systemConfig.buses.can_mirror_base_id = baseId;
+                    }
+                    systemConfig.buses.can_mirror_layout = CAN_OUTPUT_PACKED;
+                    rebuildCANBroadcastLayout();
+                    printCANBroadcastLayout(CAN_LAYOUT_TABLE, 1);
+                } else if (streq(argv[4], "J1939")) {
+                    systemConfig.buses.can_mirror_layout = CAN_OUTPUT_J1939;
+                    rebuildCANBroadcastLayout();
+                    printCANBroadcastLayout(CAN_LAYOUT_TABLE, 1);
+                } else if (streq(argv[4], "N2K") || streq(argv[4], "NMEA2000")) {
+                    systemConfig.buses.can_mirror_layout = CAN_OUTPUT_NMEA2000;
+                    rebuildCANBroadcastLayout();
+                    printCANBroadcastLayout(CAN_LAYOUT_TABLE, 1);
+                } else {
+                    msg.control.println(F("ERROR: Usage: BUS CAN MIRROR LAYOUT [OBD|PACKED [base_id]|J1939|N2K|DBC|REALDASH]"));
+                    return 1;
+                }
+                applyCANOutputFilters();  // NMEA 2000 network management in or out
+                msg.control.println(F("Use SAVE to persist"));
+                return 0;
+            }
+
+            // BUS CAN MIRROR INTERVAL <ms>
+            if (streq(argv[3], "INTERVAL")) {
+                uint32_t interval = (argc >= 5) ? strtoul(argv[4], nullptr, 10) : 0;
+                if (interval < 10 || interval > 60000) {
+                    msg.control.println(F("ERROR: Usage: BUS CAN MIRROR INTERVAL <10-60000 ms>"));
+                    return 1;
+                }
+                systemConfig.buses.can_mirror_interval = interval;
+                msg.control.print(F("CAN mirror interval set to "));
+                msg.control.print(interval);
+                msg.control.println(F("ms"));
+                msg.control.println(F("Use SAVE to persist"));
+                return 0;
+            }
+
+            // BUS CAN MIRROR <CAN1|CAN2|CAN3|NONE> [baudrate]
+            uint8_t bus_id;
+            if (streq(argv[3], "CAN1")) bus_id = 0;
+            else if (streq(argv[3], "CAN2")) bus_id = 1;
+            else if (streq(argv[3], "CAN3")) bus_id = 2;
+            else if (streq(argv[3], "NONE") || streq(argv[3], "DISABLE")) bus_id = 0xFF;
+            else {
+                msg.control.println(F("ERROR: Bus must be CAN1, CAN2, CAN3, or NONE"));
+                return 1;
+            }
+
+            if (bus_id == 0xFF) {
+                systemConfig.buses.can_mirror_bus = 0xFF;
+                msg.control.println(F("CAN mirror disabled"));
+                msg.control.println(F("Note: Takes effect on next reboot"));
+                msg.control.println(F("Use SAVE to persist"));
+                return 0;
+            }
+
+            if (bus_id >= NUM_CAN_BUSES) {
+                msg.control.print(F("ERROR: "));
+                msg.control.print(argv[3]);
+                msg.control.println(F(" not available on this platform"));
+                return 1;
+            }
+            if (bus_id == systemConfig.buses.output_can_bus && systemConfig.buses.can_output_enabled) {
+                msg.control.println(F("ERROR: Mirror must use a different bus than CAN output"));
+                return 1;
+            }
+            bool sharedWithInput = systemConfig.buses.can_input_mode != CAN_INPUT_OFF &&
+                                   bus_id == systemConfig.buses.input_can_bus;
+            if (sharedWithInput && systemConfig.buses.can_input_mode == CAN_INPUT_LISTEN) {
+                msg.control.println(F("ERROR: CAN input is listen-only on that bus - no transmit allowed"));
+                return 1;
+            }
+
+            uint32_t baudrate = systemConfig.buses.can_mirror_baudrate;
+            if (argc >= 5) {
+                baudrate = atol(argv[4]);
+                if (baudrate != 125000 && baudrate != 250000 && baudrate != 500000 && baudrate != 1000000) {
+                    msg.control.println(F("ERROR: CAN baudrate must be 125000, 250000, 500000, or 1000000"));
+                    return 1;
                 }
+            }
 
-                msg.control.print(F("CAN output baudrate set to "));
-                msg.control.print(baudrate / 1000);
-                msg.control.println(F("kbps"));
-            } else {
-                systemConfig.buses.can_output_enabled = 0;
-                msg.control.println(F("CAN output disabled"));
+            systemConfig.buses.can_mirror_bus = bus_id;
+            systemConfig.buses.can_mirror_baudrate = baudrate;
+            if (sharedWithInput) {
+                systemConfig.buses.can_input_baudrate = baudrate;
+                msg.control.println(F("WARNING: Mirror and input share same bus - input baudrate also set to match"));
             }
 
+            msg.control.print(F("CAN mirror enabled on "));
+            msg.control.print(argv[3]);
+            msg.control.print(F(" @ "));
+            msg.control.print(baudrate / 1000);
+            msg.control.println(F("kbps"));
+            msg.control.println(F("  Route inputs with SET <pin> OUTPUT CAN_MIRROR ENABLE"));
             msg.control.println(F("Note: Takes effect on next reboot"));
             msg.control.println(F("Use SAVE to persist"));
             return 0;
@@ -2608,18 +4698,25 @@ static int cmd_bus(int argc, const char* const* argv) {
 
         // Unknown CAN subcommand
         msg.control.println(F("ERROR: Unknown CAN subcommand"));
-        msg.control.println(F("Valid: BAUDRATE, INPUT, OUTPUT"));
+        msg.control.println(F("Valid: STATUS, BAUDRATE, INPUT, OUTPUT, MIRROR, J1939"));
+        msg.control.println(F("  BUS CAN STATUS"));
         msg.control.println(F("  BUS CAN BAUDRATE <bps>"));
-        msg.control.println(F("  BUS CAN INPUT <CAN1|CAN2|CAN3> <ENABLE|LISTEN|DISABLE> [bps]"));
+        msg.control.println(F("  BUS CAN INPUT <CAN1|CAN2|CAN3> <ENABLE|LISTEN|POLL|DISABLE> [bps]"));
         msg.control.println(F("  BUS CAN INPUT BAUDRATE <bps>"));
+        msg.control.println(F("  BUS CAN INPUT PROTOCOL <AUTO|J1939>"));
         msg.control.println(F("  BUS CAN OUTPUT <CAN1|CAN2|CAN3> <ENABLE|DISABLE> [bps]"));
         msg.control.println(F("  BUS CAN OUTPUT BAUDRATE <bps>"));
+        msg.control.println(F("  BUS CAN OUTPUT LAYOUT [OBD|PACKED [base_id]|J1939|N2K|DBC|REALDASH]"));
+        msg.control.println(F("  BUS CAN MIRROR <CAN1|CAN2|CAN3|NONE> [bps]"));
+        msg.control.println(F("  BUS CAN MIRROR INTERVAL <ms>"));
+        msg.control.println(F("  BUS CAN MIRROR LAYOUT [OBD|PACKED [base_id]|J1939|N2K|DBC|REALDASH]"));
+        msg.control.println(F("  BUS CAN J1939 ADDRESS <0-253>"));
         return 1;
 #endif
     }
 
     // -------------------------------------------------------------------------
-    // BUS SERIAL [1-8] [ENABLE|DISABLE|BAUDRATE <rate>]
+    // BUS SERIAL [1-8] [ENABLE|DISABLE|BAUDRATE <rate>|FLOW <rts> <cts>|FLOW OFF]
     // -------------------------------------------------------------------------
     if (streq(busType, "SERIAL")) {
 #if NUM_SERIAL_PORTS == 0
@@ -2653,20 +4750,22 @@ static int cmd_bus(int argc, const char* const* argv) {
                 return 0;
             }
 
+            // A driver-owned port (GPS) is not reconfigured from here
+            if (getSerialPortClaim(port_id)) {
+                msg.control.print(F("ERROR: Serial"));
+                msg.control.print(port_id);
+                msg.control.print(F(" is used by "));
+                msg.control.println(getSerialPortClaim(port_id));
+                return 1;
+            }
+
             // BUS SERIAL <port> ENABLE [baudrate]
             if (streq(argv[3], "ENABLE")) {
                 // Use saved baud rate from config, or 115200 if not set
                 uint8_t baud_idx = systemConfig.serial.baudrate_index[port_id - 1];
 
                 if (argc >= 5) {
-                    uint32_t baudrate = atol(argv[4]);
-                    baud_idx = getBaudRateIndex(baudrate);
-                    if (getBaudRateFromIndex(baud_idx) != baudrate) {
-                        msg.control.print(F("WARNING: Baud rate "));
-                        msg.control.print(baudrate);
-                        msg.control.print(F(" not supported, using "));
-                        msg.control.println(getBaudRateFromIndex(baud_idx));
-                    }
+                    baud_idx = parseSerialBaud(argv[4]);
                 }
 
                 if (enableSerialPort(port_id, baud_idx)) {
@@ -2703,19 +4802,12 @@ static int cmd_bus(int argc, const char* const* argv) {
                 if (argc < 5) {
                     msg.control.println(F("ERROR: BAUDRATE requires a speed"));
                     msg.control.println(F("  Usage: BUS SERIAL <port> BAUDRATE <rate>"));
-                    msg.control.println(F("  Valid: 9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600"));
+                    msg.control.println(F("  Valid: 9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600,"));
+                    msg.control.println(F("         1000000, 2000000, 3000000, 4000000 (Teensy 4.x, ESP32)"));
                     return 1;
                 }
 
-                uint32_t baudrate = atol(argv[4]);
-                uint8_t baud_idx = getBaudRateIndex(baudrate);
-
-                if (getBaudRateFromIndex(baud_idx) != baudrate) {
-                    msg.control.print(F("WARNING: Baud rate "));
-                    msg.control.print(baudrate);
-                    msg.control.print(F(" not supported, using "));
-                    msg.control.println(getBaudRateFromIndex(baud_idx));
-                }
+                uint8_t baud_idx = parseSerialBaud(argv[4]);
 
                 systemConfig.serial.baudrate_index[port_id - 1] = baud_idx;
                 msg.control.print(F("Serial"));
@@ -2727,11 +4819,64 @@ static int cmd_bus(int argc, const char* const* argv) {
                 return 0;
             }
 
+            // BUS SERIAL <port> FLOW <rts> <cts> | FLOW OFF
+            if (streq(argv[3], "FLOW")) {
+#if SERIAL_FLOW_CONTROL
+                bool off = argc == 5 && streq(argv[4], "OFF");
+                if (!off && argc < 6) {
+                    msg.control.println(F("ERROR: FLOW requires RTS and CTS pins, or OFF"));
+                    msg.control.println(F("  Usage: BUS SERIAL <port> FLOW <rts> <cts> | FLOW OFF"));
+                    return 1;
+                }
+                if (off) {
+                    if (systemConfig.serial.flow_port != port_id) {
+                        msg.control.print(F("Serial"));
+                        msg.control.print(port_id);
+                        msg.control.println(F(" has no flow control"));
+                        return 0;
+                    }
+                    setSerialFlowControl(0, 0xFF, 0xFF);
+                    msg.control.print(F("Serial"));
+                    msg.control.print(port_id);
+                    msg.control.println(F(" flow control off"));
+                } else {
+                    uint8_t rts = atoi(argv[4]);
+                    uint8_t cts = atoi(argv[5]);
+                    uint8_t previous = systemConfig.serial.flow_port;
+                    if (!setSerialFlowControl(port_id, rts, cts)) {
+                        msg.control.print(F("ERROR: RTS="));
+                        msg.control.print(rts);
+                        msg.control.print(F(", CTS="));
+                        msg.control.print(cts);
+                        msg.control.println(F(" not usable (same pin, the port's RX/TX, or in use)"));
+                        return 1;
+                    }
+                    if (previous != 0 && previous != port_id) {
+                        msg.control.print(F("Note: Serial"));
+                        msg.control.print(previous);
+                        msg.control.println(F(" flow control off (one port only)"));
+                    }
+                    msg.control.print(F("Serial"));
+                    msg.control.print(port_id);
+                    msg.control.print(F(" flow control RTS="));
+                    msg.control.print(rts);
+                    msg.control.print(F(", CTS="));
+                    msg.control.println(cts);
+                }
+                msg.control.println(F("Note: Takes effect when the port is next enabled or on reboot"));
+                msg.control.println(F("Use SAVE to persist"));
+                return 0;
+#else
+                msg.control.println(F("ERROR: Hardware flow control not supported on this platform"));
+                return 1;
+#endif
+            }
+
             // Unknown subcommand for port
             msg.control.print(F("ERROR: Unknown command '"));
             msg.control.print(argv[3]);
             msg.control.println(F("'"));
-            msg.control.println(F("  Valid: ENABLE, DISABLE, BAUDRATE"));
+            msg.control.println(F("  Valid: ENABLE, DISABLE, BAUDRATE, FLOW"));
             return 1;
         }
 
@@ -2739,7 +4884,7 @@ static int cmd_bus(int argc, const char* const* argv) {
         msg.control.print(F("ERROR: Unknown serial command '"));
         msg.control.print(argv[2]);
         msg.control.println(F("'"));
-        msg.control.println(F("  Usage: BUS SERIAL [1-8] [ENABLE|DISABLE|BAUDRATE <rate>]"));
+        msg.control.println(F("  Usage: BUS SERIAL [1-8] [ENABLE|DISABLE|BAUDRATE <rate>|FLOW <rts> <cts>|FLOW OFF]"));
         return 1;
 #endif
     }
@@ -2987,19 +5132,33 @@ static int cmd_log(int argc, const char* const* argv) {
 #ifdef ENABLE_CAN
 static int cmd_scan(int argc, const char* const* argv) {
     // Usage: SCAN CAN [duration_ms]
+    //        SCAN RESULTS
     //        SCAN CANCEL
+    //        SCAN REPLAY <file>|STREAM [SPEED <x>|MAX] [TX <bus>] [LOOP]
 
     if (argc < 2) {
         msg.control.println(F("SCAN - Scan CAN bus for active PIDs"));
         msg.control.println(F(""));
         msg.control.println(F("Usage:"));
         msg.control.println(F("  SCAN CAN [duration]  - Scan CAN bus (default 10000ms)"));
+        msg.control.println(F("  SCAN RESULTS         - List results (partial while scanning)"));
+        msg.control.println(F("  SCAN EXPORT [file]   - Results as CSV (serial, or file on SD)"));
         msg.control.println(F("  SCAN CANCEL          - Cancel/clear scan results"));
+#ifdef ENABLE_CAN_REPLAY
+        msg.control.println(F("  SCAN REPLAY <file>|STREAM [SPEED <x>|MAX] [TX <CAN1|CAN2|CAN3>] [LOOP]"));
+        msg.control.println(F("                       - Replay a candump/ASC log into the CAN input"));
+        msg.control.println(F("  SCAN REPLAY STATUS   - Replay progress, receive and frame cache counters"));
+        msg.control.println(F("  SCAN REPLAY STOP     - Stop the replay"));
+#endif
         msg.control.println(F(""));
         msg.control.println(F("Examples:"));
         msg.control.println(F("  SCAN CAN             - Scan for 10 seconds"));
         msg.control.println(F("  SCAN CAN 15000       - Scan for 15 seconds"));
+        msg.control.println(F("  SCAN EXPORT scan.csv - Save results to SD"));
         msg.control.println(F("  SCAN CANCEL          - Clear results"));
+#ifdef ENABLE_CAN_REPLAY
+        msg.control.println(F("  SCAN REPLAY drive.log SPEED 4 - Replay a log from SD four times as fast"));
+#endif
         return 0;
     }
 
@@ -3032,18 +5191,496 @@ static int cmd_scan(int argc, const char* const* argv) {
         return 0;
     }
 
+    if (streq(subcmd, "RESULTS")) {
+        if (getCANScanState() == SCAN_IDLE) {
+            msg.control.println(F("ERROR: No scan results - run SCAN CAN first"));
+            return 1;
+        }
+        printCANScanResults();
+        return 0;
+    }
+
+    if (streq(subcmd, "EXPORT")) {
+        return exportCANScan(argc >= 3 ? argv[2] : nullptr) ? 0 : 1;
+    }
+
     if (streq(subcmd, "CANCEL")) {
         cancelCANScan();
         return 0;
     }
 
+#ifdef ENABLE_CAN_REPLAY
+    if (streq(subcmd, "REPLAY")) {
+        if (argc < 3 || streq(argv[2], "STATUS")) {
+            printCANReplayStatus();
+            return 0;
+        }
+        if (streq(argv[2], "STOP")) {
+            if (!isCANReplayActive()) {
+                msg.control.println(F("No replay running"));
+                return 0;
+            }
+            stopCANReplay();
+            return 0;
+        }
+        if (isInConfigMode()) {
+            msg.control.println(F("ERROR: SCAN REPLAY needs RUN mode (CAN input running)"));
+            return 1;
+        }
+
+        uint16_t speedPct = 100;
+        uint8_t txBus = CAN_REPLAY_INJECT;
+        bool loop = false;
+        for (int i = 3; i < argc; i++) {
+            if (streq(argv[i], "SPEED") && i + 1 < argc) {
+                i++;
+                if (streq(argv[i], "MAX")) {
+                    speedPct = 0;
+                    continue;
+                }
+                float speed = atof(argv[i]);
+                if (speed < 0.01f || speed > 100.0f) {
+                    msg.control.println(F("ERROR: Speed must be 0.01-100 (times the recorded rate) or MAX"));
+                    return 1;
+                }
+                speedPct = (uint16_t)(speed * 100.0f + 0.5f);
+            } else if (streq(argv[i], "TX") && i + 1 < argc) {
+                i++;
+                if (streq(argv[i], "CAN1")) txBus = 0;
+                else if (streq(argv[i], "CAN2")) txBus = 1;
+                else if (streq(argv[i], "CAN3")) txBus = 2;
+                else {
+                    msg.control.println(F("ERROR: Bus must be CAN1, CAN2, or CAN3"));
+                    return 1;
+                }
+            } else if (streq(argv[i], "LOOP")) {
+                loop = true;
+            } else {
+                msg.control.print(F("ERROR: Unknown option '"));
+                msg.control.print(argv[i]);
+                msg.control.println(F("' (SPEED <x>|MAX, TX <bus>, LOOP)"));
+                return 1;
+            }
+        }
+
+        bool stream = streq(argv[2], "STREAM");
+        if (!startCANReplay(stream ? nullptr : argv[2], speedPct, txBus, loop)) return 1;
+        if (stream) {
+            msg.control.println(F("Streaming - send candump or ASC lines, END to finish"));
+        } else {
+            msg.control.print(F("Replaying "));
+            msg.control.println(argv[2]);
+        }
+        return 0;
+    }
+#endif
+
     // Unknown subcommand
     msg.control.print(F("ERROR: Unknown SCAN subcommand '"));
     msg.control.print(subcmd);
     msg.control.println(F("'"));
-    msg.control.println(F("  Valid: CAN, CANCEL"));
+#ifdef ENABLE_CAN_REPLAY
+    msg.control.println(F("  Valid: CAN, EXPORT, CANCEL, REPLAY"));
+#else
+    msg.control.println(F("  Valid: CAN, EXPORT, CANCEL"));
+#endif
     return 1;
 }
 #endif // ENABLE_CAN
 
+// ============================================================================
+// PROFILE COMMAND - Loop/task execution timing
+// ============================================================================
+
+#ifdef ENABLE_PROFILER
+static int cmd_profile(int argc, const char* const* argv) {
+    // Usage: PROFILE
+    //        PROFILE RESET
+
+    if (argc < 2) {
+        printProfile();
+        return 0;
+    }
+
+    if (streq(argv[1], "RESET")) {
+        profilerReset();
+        msg.control.println(F("Profile statistics cleared"));
+        return 0;
+    }
+
+    msg.control.print(F("ERROR: Unknown PROFILE subcommand '"));
+    msg.control.print(argv[1]);
+    msg.control.println(F("'"));
+    msg.control.println(F("  Usage: PROFILE [RESET]"));
+    return 1;
+}
+#endif // ENABLE_PROFILER
+
+// ============================================================================
+// TRACE COMMAND - Sample-to-wire latency
+// ============================================================================
+
+#ifdef ENABLE_TRACE
+static int cmd_trace(int argc, const char* const* argv) {
+    // Usage: TRACE
+    //        TRACE START [<pin>]
+    //        TRACE STOP
+    //        TRACE DUMP
+
+    if (argc < 2) {
+        printTraceReport();
+        return 0;
+    }
+
+    if (streq(argv[1], "START")) {
+        uint8_t slot = 0xFF;
+        if (argc >= 3) {
+            bool valid;
+            InputPin pin = parsePin(argv[2], &valid);
+            if (!valid) return 1;
+            Input* input = getInputByPin(pin);
+            if (input == nullptr) {
+                msg.control.print(F("ERROR: No input on pin "));
+                msg.control.println(argv[2]);
+                return 1;
+            }
+            slot = input - inputs;
+        }
+        traceStart(slot);
+        msg.control.print(F("Tracing "));
+        msg.control.println(slot == 0xFF ? "all inputs" : inputs[slot].abbrName);
+        return 0;
+    }
+
+    if (streq(argv[1], "STOP")) {
+        traceStop();
+        msg.control.println(F("Trace stopped - TRACE shows it"));
+        return 0;
+    }
+
+    if (streq(argv[1], "DUMP")) {
+        printTraceDump();
+        return 0;
+    }
+
+    msg.control.print(F("ERROR: Unknown TRACE subcommand '"));
+    msg.control.print(argv[1]);
+    msg.control.println(F("'"));
+    msg.control.println(F("  Usage: TRACE [START [<pin>] | STOP | DUMP]"));
+    return 1;
+}
+#endif // ENABLE_TRACE
+
+#ifdef ENABLE_RAW_TRACE
+static int cmd_raw(int argc, const char* const* argv) {
+    // Usage: RAW [STATUS]
+    //        RAW RECORD [<file>]
+    //        RAW REPLAY <file> [LOOP]
+    //        RAW STOP
+
+    if (argc < 2 || streq(argv[1], "STATUS")) {
+        printRawTraceStatus();
+        return 0;
+    }
+
+    if (streq(argv[1], "RECORD")) {
+        return startRawRecord(argc >= 3 ? argv[2] : nullptr) ? 0 : 1;
+    }
+
+    if (streq(argv[1], "REPLAY")) {
+        if (argc < 3) {
+            msg.control.println(F("ERROR: RAW REPLAY needs a file"));
+            return 1;
+        }
+        bool loop = argc >= 4 && streq(argv[3], "LOOP");
+        return startRawReplay(argv[2], loop) ? 0 : 1;
+    }
+
+    if (streq(argv[1], "STOP")) {
+        if (rawTraceMode == RAW_TRACE_OFF) {
+            printRawTraceStatus();
+        } else {
+            stopRawTrace();             // Prints the summary
+        }
+        return 0;
+    }
+
+    msg.control.print(F("ERROR: Unknown RAW subcommand '"));
+    msg.control.print(argv[1]);
+    msg.control.println(F("'"));
+    msg.control.println(F("  Usage: RAW [STATUS | RECORD [<file>] | REPLAY <file> [LOOP] | STOP]"));
+    return 1;
+}
+#endif // ENABLE_RAW_TRACE
+
+// ============================================================================
+// BENCH COMMAND - High-rate ADC streaming
+// ============================================================================
+
+#ifdef ENABLE_BENCH_STREAM
+static int cmd_bench(int argc, const char* const* argv) {
+    // Usage: BENCH [STATUS]
+    //        BENCH START [rate_hz]
+    //        BENCH STOP
+
+    if (argc < 2 || streq(argv[1], "STATUS")) {
+        printBenchStreamStatus();
+        return 0;
+    }
+
+    if (streq(argv[1], "START")) {
+        if (isInConfigMode()) {
+            msg.control.println(F("ERROR: BENCH START needs RUN mode (sensors running)"));
+            return 1;
+        }
+        long rate = (argc >= 3) ? atol(argv[2]) : BENCH_STREAM_DEFAULT_RATE_HZ;
+        if (rate <= 0 || rate > BENCH_STREAM_MAX_RATE_HZ) {
+            msg.control.print(F("ERROR: Rate must be 1-"));
+            msg.control.print(BENCH_STREAM_MAX_RATE_HZ);
+            msg.control.println(F(" Hz"));
+            return 1;
+        }
+
+        switch (startBenchStream((uint16_t)rate)) {
+            case BENCH_STARTED:
+                msg.control.print(F("Bench stream started at "));
+                msg.control.print(rate);
+                msg.control.println(F(" Hz (cosmetic tasks paused, BENCH STOP to end)"));
+                return 0;
+            case BENCH_NO_TIMER:
+                msg.control.println(F("ERROR: No sampling timer on this platform"));
+                return 1;
+            case BENCH_NO_CHANNELS:
+                msg.control.println(F("ERROR: No analog inputs are being read yet"));
+                return 1;
+            case BENCH_TOO_WIDE:
+                msg.control.println(F("ERROR: Too many channels for one block (raise BENCH_STREAM_BLOCK_BYTES)"));
+                return 1;
+            default:
+                msg.control.println(F("ERROR: Bad rate"));
+                return 1;
+        }
+    }
+
+    if (streq(argv[1], "STOP")) {
+        stopBenchStream();
+        msg.control.println(F("Bench stream stopped"));
+        return 0;
+    }
+
+    msg.control.print(F("ERROR: Unknown BENCH subcommand '"));
+    msg.control.print(argv[1]);
+    msg.control.println(F("'"));
+    msg.control.println(F("  Usage: BENCH [STATUS] | START [rate_hz] | STOP"));
+    return 1;
+}
+#endif // ENABLE_BENCH_STREAM
+
+// ============================================================================
+// SUBSCRIBE COMMAND - Host-negotiated data plane subscription
+// ============================================================================
+
+#if HOST_SUBSCRIPTIONS
+// "<pin|name>[@hz]" - false (with the error printed) if not an enabled input or a bad rate
+static bool parseSubscribeChannel(const char* spec, HostChannelRequest* request) {
+    char name[32];
+    strncpy(name, spec, sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+    long rate = HOST_SUBSCRIBE_DEFAULT_HZ;
+    char* at = strchr(name, '@');
+    if (at) {
+        *at = '\0';
+        rate = atol(at + 1);
+    }
+    if (rate <= 0 || rate > HOST_SUBSCRIBE_MAX_HZ) {
+        msg.control.print(F("ERROR: Rate must be 1-"));
+        msg.control.print(HOST_SUBSCRIBE_MAX_HZ);
+        msg.control.print(F(" Hz: "));
+        msg.control.println(spec);
+        return false;
+    }
+
+    // An input's abbreviation, or a pin (parsePin() reads any word as pin 0)
+    uint8_t slot = 0xFF;
+    for (uint8_t i = 0; slot == 0xFF && i < MAX_INPUTS; i++) {
+        if (inputs[i].pin != 0xFF && streq(inputs[i].abbrName, name)) slot = i;
+    }
+    if (slot == 0xFF) {
+        bool isValid = false;
+        InputPin pin = parsePin(name, &isValid);
+        if (isValid) slot = getInputIndex(pin);
+    }
+    if (slot == 0xFF || !inputs[slot].flags.isEnabled) {
+        msg.control.print(F("ERROR: No enabled input "));
+        msg.control.println(name);
+        return false;
+    }
+    request->slot = slot;
+    request->rateHz = (uint16_t)rate;
+    return true;
+}
+
+static int cmd_subscribe(int argc, const char* const* argv) {
+    // Usage: SUBSCRIBE [STATUS]
+    //        SUBSCRIBE <pin|name>[@hz] ... [FORMAT CSV|BINARY]
+    //        SUBSCRIBE STOP
+
+    if (argc < 2 || streq(argv[1], "STATUS")) {
+        printHostSubscriptions();
+        return 0;
+    }
+
+    TransportID transportId = router.findTransportId(router.getActiveControlTransport());
+    if (streq(argv[1], "STOP")) {
+        if (unsubscribeHost(transportId)) {
+            msg.control.println(F("Subscription ended"));
+        } else {
+            msg.control.println(F("No subscription on this transport"));
+        }
+        return 0;
+    }
+
+    // Channels separated by spaces or commas
+    HostChannelRequest requests[HOST_SUBSCRIBE_MAX_CHANNELS];
+    uint8_t count = 0;
+    HostFormat format = HOST_FORMAT_CSV;
+    for (int a = 1; a < argc; a++) {
+        if (streq(argv[a], "FORMAT")) {
+            if (a + 1 < argc && streq(argv[a + 1], "CSV")) {
+                format = HOST_FORMAT_CSV;
+            } else if (a + 1 < argc && streq(argv[a + 1], "BINARY")) {
+                format = HOST_FORMAT_BINARY;
+            } else {
+                msg.control.println(F("ERROR: FORMAT must be CSV or BINARY"));
+                return 1;
+            }
+            a++;
+            continue;
+        }
+
+        char list[32];
+        strncpy(list, argv[a], sizeof(list) - 1);
+        list[sizeof(list) - 1] = '\0';
+        for (char* spec = strtok(list, ","); spec; spec = strtok(nullptr, ",")) {
+            if (count == HOST_SUBSCRIBE_MAX_CHANNELS) {
+                msg.control.print(F("ERROR: At most "));
+                msg.control.print(HOST_SUBSCRIBE_MAX_CHANNELS);
+                msg.control.println(F(" channels"));
+                return 1;
+            }
+            if (!parseSubscribeChannel(spec, &requests[count])) return 1;
+            for (uint8_t c = 0; c < count; c++) {
+                if (requests[c].slot == requests[count].slot) {
+                    msg.control.print(F("ERROR: Channel listed twice: "));
+                    msg.control.println(spec);
+                    return 1;
+                }
+            }
+            count++;
+        }
+    }
+    if (count == 0) {
+        msg.control.println(F("ERROR: No channels given"));
+        msg.control.println(F("  Usage: SUBSCRIBE <pin|name>[@hz] ... [FORMAT CSV|BINARY] | STATUS | STOP"));
+        return 1;
+    }
+
+    switch (subscribeHost(transportId, requests, count, format)) {
+        case HOST_SUBSCRIBED:
+            msg.control.print(F("Subscribed: "));
+            msg.control.print(count);
+            msg.control.print(format == HOST_FORMAT_CSV ? F(" channels, CSV") : F(" channels, BINARY"));
+            msg.control.println(F(" (SUBSCRIBE STOP to end)"));
+            return 0;
+        case HOST_SUB_NOT_BINARY:
+            msg.control.println(F("ERROR: This transport can't carry binary frames - use FORMAT CSV"));
+            return 1;
+        case HOST_SUB_FULL:
+            msg.control.print(F("ERROR: "));
+            msg.control.print(HOST_SUBSCRIBE_MAX_HOSTS);
+            msg.control.println(F(" other transports are subscribed already"));
+            return 1;
+        default:
+            msg.control.println(F("ERROR: Subscriptions need a registered transport"));
+            return 1;
+    }
+}
+#endif // HOST_SUBSCRIPTIONS
+
+#ifdef ENABLE_ALARMS
+static int cmd_alarm(int argc, const char* const* argv) {
+    if (argc < 2 || !streq(argv[1], "HISTORY")) {
+        msg.control.println(F("ERROR: Unknown ALARM subcommand"));
+        msg.control.println(F("  Usage: ALARM HISTORY [count] | HISTORY CLEAR"));
+        return 1;
+    }
+
+    if (argc >= 3 && streq(argv[2], "CLEAR")) {
+        if (isInRunMode()) {
+            msg.control.println(F("ERROR: ALARM HISTORY CLEAR needs CONFIG mode"));
+            return 1;
+        }
+        clearAlarmHistory();
+        msg.control.println(F("Alarm history cleared"));
+        return 0;
+    }
+
+    long count = (argc >= 3) ? atol(argv[2]) : 20;
+    if (count < 1 || count > 255) {
+        msg.control.println(F("ERROR: Count is 1-255"));
+        return 1;
+    }
+    printAlarmHistory((uint8_t)count);
+    return 0;
+}
+#endif // ENABLE_ALARMS
+
+#ifdef ENABLE_STATS
+static int cmd_stats(int argc, const char* const* argv) {
+    if (argc < 2) {
+        printInputStats();
+        return 0;
+    }
+
+    if (!streq(argv[1], "RESET")) {
+        msg.control.println(F("ERROR: Unknown STATS subcommand"));
+        msg.control.println(F("  Usage: STATS | STATS RESET [<pin>]"));
+        return 1;
+    }
+    if (isInRunMode()) {
+        msg.control.println(F("ERROR: STATS RESET needs CONFIG mode"));
+        return 1;
+    }
+
+    InputPin pin = 0xFF;
+    if (argc >= 3) {
+        bool valid;
+        pin = parsePin(argv[2], &valid);
+        if (!valid) return 1;
+    }
+    if (!resetInputStats(pin)) {
+        if (pin == 0xFF) {
+            msg.control.println(F("ERROR: No speed, RPM or temperature inputs"));
+        } else {
+            msg.control.print(F("ERROR: No accumulator on "));
+            msg.control.println(argv[2]);
+        }
+        return 1;
+    }
+    msg.control.println(F("Stats reset (use STATS to check)"));
+    return 0;
+}
+#endif // ENABLE_STATS
+
+#if TIME_SYNC
+static int cmd_time(int argc, const char* const* argv) {
+    if (argc > 1) {
+        msg.control.println(F("ERROR: TIME takes no arguments"));
+        return 1;
+    }
+    printTimebaseStatus();
+    return 0;
+}
+#endif // TIME_SYNC
+
 #endif // USE_STATIC_CONFIG
@@ -1,12 +1,18 @@
 /*
  * command_table.h - Table-driven command dispatch system
  * Replaces monolithic if/else command parsing with structured table
+ *
+ * Each entry carries its name's djb2 hash (lib/hash.h), computed at compile
+ * time. Dispatch hashes the typed command once and compares 16-bit hashes,
+ * confirming the one match by name; duplicate hashes in the table fail to
+ * compile.
  */
 
 #ifndef _COMMAND_TABLE_H_
 #define _COMMAND_TABLE_H_
 
 #include <stdint.h>
+#include "../lib/hash.h"
 
 // Command handler function signature
 // Returns 0 on success, non-zero on error
@@ -20,8 +26,13 @@ struct Command {
     CommandHandler handler;    // Function pointer to handler
     const char* help;          // Short help text (PROGMEM on AVR)
     bool configModeOnly;       // true = only available in CONFIG mode
+    uint16_t nameHash;         // djb2_hash(name)
 };
 
+// Table entry with its name hash filled in at compile time
+#define COMMAND(name, handler, help, configModeOnly) \
+    {name, handler, help, configModeOnly, djb2_const(name)}
+
 // Command table (defined in command_table.cpp)
 extern const Command COMMANDS[];
 extern const uint8_t NUM_COMMANDS;
@@ -10,11 +10,22 @@
  * ============================================================================
  *
  * Physical pins:     0x00-0x7F (0-127)   - Hardware GPIO pins, analog inputs
- * CAN virtual pins:  0xC0-0xDF (192-223) - CAN:0 to CAN:31 (32 sensors max)
- * I2C virtual pins:  0xF0-0xFF (240-255) - I2C:0 to I2C:15 (reserved for future)
+ * Node virtual pins: 0x80-0x9F (128-159) - NODE:0 to NODE:31, channels of other units on CAN (lib/can_node.h)
+ * GPS virtual pins:  0xA0-0xA7 (160-167) - GPS:0 to GPS:7, speed/altitude from a GPS receiver (lib/gps.h)
+ * Math virtual pins: 0xB0-0xBF (176-191) - MATH:0 to MATH:15, derived from other inputs (input_math.h)
+ * CAN virtual pins:  0xC0-0xDF (192-223) - CAN:0 to CAN:31
+ * ADC virtual pins:  0xE0-0xEF (224-239) - ADC:0 to ADC:15, external ADC channels (lib/ext_adc.h)
+ * I2C virtual pins:  0xF0-0xFF (240-255) - I2C:0 to I2C:15 (I2C sensors, e.g. BME280)
+ * Wide CAN pins:     0x100-0x1FF         - CAN:32 to CAN:287 (INPUT_PIN_WIDE builds)
  *
  * Virtual pins don't correspond to physical GPIO - they represent data sources
- * from bus protocols (CAN frames, I2C sensors with addresses, etc.)
+ * from bus protocols (CAN frames, I2C sensors with addresses, etc.) or, for
+ * MATH:n, from an expression over other inputs
+ *
+ * Pins are InputPin: 16 bits except on AVR, where the input table is too
+ * small to outgrow 32 CAN pins. Records that keep a pin in one byte - alarm
+ * rule terms, math channel sources, relay inputs, node channels - take the
+ * pins below 0x100 only.
  *
  * ============================================================================
  * ARCHITECTURE OVERVIEW
@@ -54,6 +65,8 @@
  * - Stored in RAM (inputs[] array)
  * - Calibration data pointed to PROGMEM (not copied)
  * - Custom calibration stored in RAM only if overridden
+ * - Display name read from the application preset in PROGMEM; a custom
+ *   name takes a slot of a small RAM pool (INPUT_NAME_POOL_SLOTS)
  *
  * For Arduino Uno (2KB RAM), practical limit is ~10 inputs.
  * For Teensy/Mega, can support 20+ inputs easily.
@@ -65,11 +78,45 @@
 #define INPUT_H
 
 #include <Arduino.h>
+#include <stddef.h>  // offsetof
 #include "../lib/sensor_types.h"
 
 // Forward declarations
 struct Input;
 
+#define INPUT_DISPLAY_NAME_LEN 32   // Display name buffer, terminator included
+
+// ===== PIN NUMBERS =====
+#ifndef INPUT_PIN_WIDE
+  #if defined(__AVR__)
+    #define INPUT_PIN_WIDE 0
+  #else
+    #define INPUT_PIN_WIDE 1
+  #endif
+#endif
+
+#if INPUT_PIN_WIDE
+typedef uint16_t InputPin;
+#else
+typedef uint8_t InputPin;
+#endif
+
+// CAN:n - the first 32 in the 8-bit space, the rest from 0x100
+#define CAN_PIN_BASE        0xC0
+#define CAN_PIN_WIDE_BASE   0x100
+#if INPUT_PIN_WIDE
+#define CAN_PINS            (32 + 256)
+#else
+#define CAN_PINS            32
+#endif
+#define CAN_PIN(n)          ((n) < 32 ? CAN_PIN_BASE + (n) : CAN_PIN_WIDE_BASE + (n) - 32)
+#define CAN_IS_PIN(pin)     (((pin) >= CAN_PIN_BASE && (pin) < CAN_PIN_BASE + 32) || \
+                             (INPUT_PIN_WIDE && (pin) >= CAN_PIN_WIDE_BASE && (pin) < CAN_PIN_WIDE_BASE + 256))
+#define CAN_PIN_CHANNEL(pin) ((pin) < CAN_PIN_WIDE_BASE ? (pin) - CAN_PIN_BASE : (pin) - CAN_PIN_WIDE_BASE + 32)
+
+// Pins up to here fit the one-byte pin of rules, math sources and relays
+#define PIN_IS_NARROW(pin)  ((pin) < 0x100)
+
 // ===== CALIBRATION OVERRIDE UNION =====
 // Custom calibration storage (16 bytes)
 // Used when useCustomCalibration == true
@@ -150,11 +197,33 @@ union CalibrationOverride {
         uint8_t data_offset;        // Byte offset in frame
         uint8_t data_length;        // 1-4 bytes
         bool is_big_endian;         // Byte order
+        uint8_t bit_offset;         // Start bit in data_offset byte (bit-packed)
+        uint8_t bit_length;         // Signal bits, 0 = whole bytes
         float scale_factor;         // Multiplier
         float offset;               // Additive offset
-        byte padding[3];
+        uint16_t timeout_ms;        // Stale timeout (0 = default 2000ms)
+        bool whole_frame;           // Broadcast frame, no PID byte
     } can;
 
+    // Math channel (16 bytes, see inputs/input_math.h)
+    struct {
+        uint8_t op;                 // MathOp
+        uint8_t source_a;           // Pin of input A
+        uint8_t source_b;           // Pin of input B, or MATH_SOURCE_CONSTANT
+        uint8_t integrate;          // Running total over time
+        float constant;             // B when source_b is MATH_SOURCE_CONSTANT
+        float scale;                // Result multiplier
+        float offset;               // Result offset
+    } math;
+
+    // Node channel (4 bytes + padding, see lib/can_node.h)
+    struct {
+        uint8_t node;               // Node number of the unit it comes from
+        uint8_t remote_pin;         // Pin of the input there
+        uint16_t app_hash;          // Application name hash it was announced with
+        byte padding[12];
+    } node;
+
     // Raw bytes for memset/EEPROM operations
     byte raw[16];
 };
@@ -188,37 +257,27 @@ struct AlarmContext {
 // ===== INPUT STRUCTURE =====
 // Runtime configuration for a physical input pin
 // Size: ~100 bytes per input
-struct Input {
-    // === Hardware (1 byte) ===
-    uint8_t pin;                    // Physical pin (A0-A15, or digital, or 0xF0-0xFD for I2C virtual)
-    // Note: Bus selection is global via SystemConfig.buses (not per-input)
+//
+// Field order is deliberate: everything the per-loop walkers touch (output
+// send, alarm evaluation, LCD) sits in a 32-byte hot block at the front, so
+// scanning inputs[] pulls one cache line per input instead of dragging the
+// names and calibration data through the cache. Cold configuration follows.
+// The read function is cold here because the read schedule caches it
+// (see InputSchedule in input_manager.h).
 
-    // === User Configuration ===
-    char abbrName[8];               // "CHT", "OIL" (for LCD display)
-    char displayName[32];           // "Cylinder Head Temperature" (full name)
-    uint8_t applicationIndex;       // Index into APPLICATION_PRESETS[] array
-    uint8_t sensorIndex;            // Index into SENSOR_LIBRARY[] array
-    uint8_t unitsIndex;             // Index into UNITS_REGISTRY[] array
-    
-    // === Alarm Thresholds (stored in STANDARD UNITS) ===
-    // Temperature: Celsius
-    // Pressure: bar
-    // Voltage: volts
-    float minValue;                 // Alarm minimum (standard units)
-    float maxValue;                 // Alarm maximum (standard units)
-    
-    // === OBDII ===
-    uint8_t obd2pid;               // OBD-II PID
-    uint8_t obd2length;            // OBD-II response length
+// Teensy 4.x: start every Input on a D-cache line so the hot block never straddles two
+#if defined(__IMXRT1062__)
+#define INPUT_CACHE_ALIGN alignas(32)
+#else
+#define INPUT_CACHE_ALIGN
+#endif
 
-    // === Output Routing ===
-    uint8_t outputMask;            // Per-input output routing (bits 0-3: CAN, RealDash, Serial, SD)
+struct INPUT_CACHE_ALIGN Input {
+    // ===== HOT: read/written every loop (32 bytes) =====
 
     // === Runtime Data ===
     float value;                    // Current sensor reading
-
-    // === Alarm State Management ===
-    AlarmContext alarmContext;      // Alarm state machine context (12 bytes)
+    uint8_t sequence;               // Incremented whenever value changes (change-driven outputs)
     AlarmSeverity currentSeverity;  // Current severity level (1 byte)
 
     // === Flags (packed into 1 byte) ===
@@ -231,6 +290,63 @@ struct Input {
         uint8_t reserved : 3;       // Reserved for future use
     } flags;
 
+    // === Output Routing ===
+    uint8_t outputMask;            // Per-input output routing (bits 0-4: CAN, RealDash, Serial, SD, MQTT; bit 7: CAN mirror)
+
+    // === Alarm State Management ===
+    AlarmContext alarmContext;      // Alarm state machine context
+
+    // === Alarm Thresholds (stored in STANDARD UNITS) ===
+    // Temperature: Celsius
+    // Pressure: bar
+    // Voltage: volts
+    float minValue;                 // Alarm minimum (standard units)
+    float maxValue;                 // Alarm maximum (standard units)
+
+    // ===== COLD: configuration =====
+
+    // === Hardware ===
+    InputPin pin;                   // Physical pin (A0-A15, or digital), or virtual (GPS 0xA0+, MATH 0xB0+, CAN 0xC0+ and 0x100+, ADC 0xE0+, I2C 0xF0-0xFD)
+    // Note: Bus selection is global via SystemConfig.buses (not per-input)
+
+    // === User Configuration ===
+    char abbrName[8];               // "CHT", "OIL" (for LCD display)
+    uint8_t displayNameSlot;        // 0 = preset label ("Cylinder Head Temperature"), else custom name pool slot + 1
+    uint8_t applicationIndex;       // Index into APPLICATION_PRESETS[] array
+    uint8_t sensorIndex;            // Index into SENSOR_LIBRARY[] array
+    uint8_t unitsIndex;             // Index into UNITS_REGISTRY[] array
+
+    // === Display Conversion (unitsIndex resolved by refreshInputUnits()) ===
+    float unitsFactor;              // Display value = value * unitsFactor + unitsOffset
+    float unitsOffset;
+    const char* unitsSymbol;        // Unit symbol (PROGMEM)
+
+    // === OBDII ===
+    uint8_t obd2pid;               // OBD-II PID
+    uint8_t obd2length;            // OBD-II response length
+    uint8_t obd2data[5];           // Current value as obd2length PID bytes (refreshOBD2Data)
+
+    // === Filtering (post-read stage, see input_filter.h) ===
+    uint8_t filterType;            // InputFilterType
+    uint16_t filterParam;          // EMA: time constant ms, MEDIAN: taps, SLEW: hundredths of units/s
+
+    // === Read Rate (see input_rate.h) ===
+    uint16_t rateMaxInterval;      // Adaptive mode: longest interval in ms (0 = fixed rate)
+    uint16_t rateBand;             // Adaptive mode: stable below this, hundredths of units/s
+
+    // === Trend Alarm (see alarm_trend.h) ===
+    float trendRate;               // Alarm slope, standard units/s (sign = direction, 0 = off)
+    uint16_t trendWindow;          // Fit window in ms (0 = ALARM_TREND_WINDOW_MS)
+
+    // === Alarm Levels (see alarm_logic.cpp; standard units) ===
+    uint16_t alarmClearMs;         // Alarm condition gone this long to clear (persist: alarmContext)
+    uint16_t warnPersistMs;        // Warning condition this long to warn
+    uint16_t warnClearMs;          // Warning condition gone this long to clear
+    float warnMin;                 // Warning thresholds (NAN = WARNING_THRESHOLD_PERCENT
+    float warnMax;                 //   of minValue / maxValue)
+    float alarmHysteresis;         // Back inside minValue/maxValue by this to leave the alarm
+    float warnHysteresis;          // Back inside warnMin/warnMax by this to leave the warning
+
     // === Function Pointers ===
     void (*readFunction)(Input*);
     MeasurementType measurementType;
@@ -241,4 +357,7 @@ struct Input {
     CalibrationOverride customCalibration; // Custom calibration (16 bytes)
 };
 
+static_assert(offsetof(Input, maxValue) + sizeof(float) <= 32,
+              "Input hot block must fit in one 32-byte cache line");
+
 #endif // INPUT_H
\ No newline at end of file
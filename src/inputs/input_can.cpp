@@ -3,7 +3,9 @@
  *
  * Separate CAN input subsystem - independent from CAN output.
  * Receives frames from configured input CAN bus and populates frame cache.
- * Supports OBD-II, J1939, and custom CAN protocols.
+ * Supports OBD-II and custom CAN protocols on 11-bit IDs, and with the J1939
+ * input protocol (BUS CAN INPUT PROTOCOL J1939) 29-bit J1939 frames keyed by
+ * PGN and source address, TP.BAM messages reassembled (lib/j1939.h).
  *
  * Uses HAL for platform abstraction (FlexCAN, TWAI, MCP2515).
  * Supports dual-bus on Teensy (input on different bus than output).
@@ -15,16 +17,67 @@
 #include "../lib/bus_config.h"
 #include "../lib/message_api.h"
 #include "../lib/log_tags.h"
+#include "../lib/memory_report.h"
 #include "sensors/can/can_frame_cache.h"
+#include "sensors/can/can_scan.h"
+#include "input_manager.h"
+#include "obd2_poller.h"
 #include "../hal/hal_can.h"
+#include "../lib/can_rx.h"
+#include "../lib/j1939.h"
+#include "../outputs/output_can.h"
 
 // ============================================================================
 // INTERNAL STATE
 // ============================================================================
 
 static bool canInputInitialized = false;
+static bool handleCANInputFrame(const hal::can::CanRxFrame& frame);
 static uint8_t canInputBus = 0;  // Which bus we're reading from
 
+// (CAN ID, PID) pairs referenced by configured CAN-imported inputs
+// Frames outside this set are dropped before the cache (except during SCAN)
+// Whole-frame subscriptions use pid CAN_PID_WHOLE_FRAME
+struct CANSubscription {
+    uint16_t can_id;
+    uint8_t pid;
+    bool wholeFrame;        // Broadcast frame - cache the payload under its ID alone
+};
+
+static CANSubscription canSubscriptions[MAX_INPUTS];
+static uint8_t numCANSubscriptions = 0;
+
+// Hardware acceptance filters follow the subscription set once the bus is
+// running (on a shared bus the output subsystem starts it)
+static bool canInputBusStarted = false;
+static bool canFiltersOpen = false;  // Filters accepting everything for SCAN
+static bool canAcceptAll = false;    // SCAN listening - cache every frame
+
+// J1939 input protocol - cache keys are (PGN, source address)
+static bool j1939Input = false;
+static J1939TpReceiver j1939Tp;
+
+static bool isCANIdSubscribed(uint32_t can_id) {
+    for (uint8_t i = 0; i < numCANSubscriptions; i++) {
+        if (canSubscriptions[i].can_id == can_id) return true;
+    }
+    return false;
+}
+
+static bool isCANWholeFrameSubscribed(uint32_t can_id) {
+    for (uint8_t i = 0; i < numCANSubscriptions; i++) {
+        if (canSubscriptions[i].can_id == can_id && canSubscriptions[i].wholeFrame) return true;
+    }
+    return false;
+}
+
+static bool isCANFrameSubscribed(uint32_t can_id, uint8_t pid) {
+    for (uint8_t i = 0; i < numCANSubscriptions; i++) {
+        if (canSubscriptions[i].can_id == can_id && canSubscriptions[i].pid == pid) return true;
+    }
+    return false;
+}
+
 // ============================================================================
 // INITIALIZATION
 // ============================================================================
@@ -37,6 +90,8 @@ static uint8_t canInputBus = 0;  // Which bus we're reading from
  * @return true if initialized successfully, false otherwise
  */
 bool initCANInput() {
+    unregisterCANRxHandler(handleCANInputFrame);  // Bus may have changed
+
     // Check if input is enabled (NORMAL or LISTEN mode)
     uint8_t mode = systemConfig.buses.can_input_mode;
     if (mode == CAN_INPUT_OFF) {
@@ -49,6 +104,9 @@ bool initCANInput() {
         canInputInitialized = false;
         return false;  // No input bus configured
     }
+    canInputBusStarted = false;
+    j1939Input = (systemConfig.buses.can_input_protocol == CAN_PROTOCOL_J1939);
+    j1939TpReset(&j1939Tp);
 
     uint32_t baudrate = systemConfig.buses.can_input_baudrate;
     bool listenOnly = (mode == CAN_INPUT_LISTEN);
@@ -75,17 +133,168 @@ bool initCANInput() {
             return false;
         }
         canInputBus = bus;
+        canInputBusStarted = true;
         const char* modeStr = listenOnly ? "listen-only" : "normal";
         msg.debug.info(TAG_CAN, "CAN input initialized on bus %d (%lu bps, %s)", bus, baudrate, modeStr);
     }
+    if (j1939Input) {
+        msg.debug.info(TAG_CAN, "CAN input protocol J1939 (PGN / source address)");
+    }
 
     // Initialize CAN frame cache
     initCANFrameCache();
+    noteStaticMemory(F("CAN frame cache"), sizeof(canFrameCache));
+    noteStaticMemory(F("CAN scan results"), CAN_SCAN_MAX_RESULTS * sizeof(CANScanResult));
+
+    // Every frame on the bus - subscriptions are checked in processCANFrame()
+    if (!registerCANRxHandler("INPUT", bus, 0, 0, handleCANInputFrame)) {
+        msg.debug.error(TAG_CAN, "CAN input: no free RX handler slot");
+        canInputInitialized = false;
+        return false;
+    }
 
     canInputInitialized = true;
+    refreshCANInputSubscriptions();
     return true;
 }
 
+/**
+ * Program the input bus acceptance filters
+ * One exact rule per subscribed CAN ID (PIDs share an ID, so they can only
+ * be told apart in software), plus the OBD-II request IDs when the output
+ * subsystem answers requests on the same bus, the node IDs when this unit
+ * is a node there (lib/can_node.h) and NMEA 2000 network management when an
+ * output runs that layout there (getCANOutputFilterRules()). Open while
+ * SCAN is listening.
+ * J1939: one rule per subscribed PGN from any source, plus TP.CM / TP.DT.
+ */
+static void pushCANInputFilters(bool acceptAll) {
+    if (!canInputInitialized || !canInputBusStarted) return;
+
+    hal::can::CanFilterRule rules[MAX_INPUTS + CAN_OUTPUT_FILTER_RULES];
+    uint8_t count = 0;
+
+    if (!acceptAll && j1939Input) {
+        hal::can::CanFilterRule j1939Rules[MAX_INPUTS + 2 + CAN_OUTPUT_FILTER_RULES];
+        for (uint8_t i = 0; i < numCANSubscriptions; i++) {
+            uint32_t pgn = canSubscriptions[i].can_id;
+            uint32_t id = pgn << 8;
+            bool seen = false;
+            for (uint8_t k = 0; k < count; k++) {
+                if (j1939Rules[k].id == id) seen = true;
+            }
+            if (seen) continue;
+            j1939Rules[count++] = { id, j1939PGNMask(pgn), true };
+        }
+        if (count > 0) {
+            // Multi-packet messages carrying a subscribed PGN
+            j1939Rules[count++] = { (uint32_t)J1939_PGN_TP_CM << 8, J1939_PDU1_PGN_MASK, true };
+            j1939Rules[count++] = { (uint32_t)J1939_PGN_TP_DT << 8, J1939_PDU1_PGN_MASK, true };
+        }
+        count += getCANOutputFilterRules(canInputBus, &j1939Rules[count]);
+        if (!hal::can::setFilterRules(j1939Rules, count, canInputBus) && count > 0) {
+            msg.debug.info(TAG_CAN, "CAN bus %d: %d filter rules exceed hardware filters - rest filtered in software",
+                           canInputBus, count);
+        }
+        canFiltersOpen = false;
+        return;
+    }
+
+    if (!acceptAll) {
+        for (uint8_t i = 0; i < numCANSubscriptions; i++) {
+            uint16_t can_id = canSubscriptions[i].can_id;
+            bool seen = false;
+            for (uint8_t k = 0; k < count; k++) {
+                if (rules[k].id == can_id) seen = true;
+            }
+            if (seen) continue;
+            rules[count].id = can_id;
+            rules[count].mask = HAL_CAN_STD_MASK;
+            rules[count].extended = false;
+            count++;
+        }
+
+        // Shared bus - what the outputs answer there (see output_can.cpp)
+        uint8_t outputRules = getCANOutputFilterRules(canInputBus, &rules[count]);
+        count += outputRules;
+
+        // Nothing subscribed - software drops everything, no point narrowing
+        if (numCANSubscriptions == 0 && outputRules == 0) count = 0;
+    }
+
+    if (!hal::can::setFilterRules(rules, count, canInputBus) && count > 0) {
+        msg.debug.info(TAG_CAN, "CAN bus %d: %d filter rules exceed hardware filters - rest filtered in software",
+                       canInputBus, count);
+    }
+    canFiltersOpen = acceptAll;
+}
+
+void applyCANInputFilters() {
+    canInputBusStarted = true;
+    pushCANInputFilters(false);
+}
+
+/**
+ * Rebuild the subscription set from the CAN-imported inputs and pin their
+ * cache slots. Inputs not yet loaded at init are picked up on the next
+ * schedule rebuild.
+ */
+void refreshCANInputSubscriptions() {
+    unpinAllCANCacheEntries();
+    numCANSubscriptions = 0;
+    resetOBD2Poller(canInputBus, canInputInitialized && !j1939Input &&
+                    systemConfig.buses.can_input_mode == CAN_INPUT_POLL);
+
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        const Input* input = &inputs[i];
+        if (input->pin == 0xFF || input->calibrationType != CAL_CAN_IMPORT) continue;
+
+        uint16_t can_id;
+        uint8_t pid;
+        bool wholeFrame;
+        uint16_t timeout_ms;
+        if (input->flags.useCustomCalibration) {
+            can_id = input->customCalibration.can.source_can_id;
+            pid = input->customCalibration.can.source_pid;
+            wholeFrame = input->customCalibration.can.whole_frame;
+            timeout_ms = input->customCalibration.can.timeout_ms;
+        } else if (input->presetCalibration != nullptr) {
+            // Preset calibration (PROGMEM)
+            const CANSensorCalibration* cal = (const CANSensorCalibration*)input->presetCalibration;
+            can_id = pgm_read_word(&cal->source_can_id);
+            pid = pgm_read_byte(&cal->source_pid);
+            wholeFrame = pgm_read_byte(&cal->whole_frame);
+            timeout_ms = pgm_read_word(&cal->timeout_ms);
+        } else {
+            continue;
+        }
+        if (wholeFrame) {
+            pid = CAN_PID_WHOLE_FRAME;  // J1939: the PGN from any source
+        } else if (!j1939Input) {
+            addOBD2PollPID(can_id, pid, input, timeout_ms ? timeout_ms : CAN_DEFAULT_TIMEOUT_MS);
+        }
+
+        if (isCANFrameSubscribed(can_id, pid)) continue;  // Several inputs on one PID or frame
+        canSubscriptions[numCANSubscriptions].can_id = can_id;
+        canSubscriptions[numCANSubscriptions].pid = pid;
+        canSubscriptions[numCANSubscriptions].wholeFrame = wholeFrame;
+        numCANSubscriptions++;
+
+        if (!pinCANCacheEntry(can_id, pid)) {
+            msg.debug.warn(TAG_CAN, "Frame cache full around 0x%X/0x%02X - input %d may be evicted",
+                           can_id, pid, i);
+        }
+    }
+
+    msg.debug.info(TAG_CAN, "CAN input subscribed to %d ID/PID pairs", numCANSubscriptions);
+    pushCANInputFilters(false);
+}
+
+uint32_t getCANInputRxOverflows() {
+    if (!canInputInitialized) return 0;
+    return hal::can::getRxOverflows(canInputBus);
+}
+
 /**
  * Shutdown CAN input subsystem
  *
@@ -99,6 +308,7 @@ bool initCANInput() {
  * For true power-down, disable ENABLE_CAN at compile time or power-cycle the board.
  */
 void shutdownCANInput() {
+    unregisterCANRxHandler(handleCANInputFrame);
     canInputInitialized = false;
 }
 
@@ -111,19 +321,42 @@ void shutdownCANInput() {
  * @param can_id    CAN identifier
  * @param data      Frame data buffer
  * @param len       Frame data length
+ * @param rxMs      millis() when the frame was received
+ * @param rxUs      hal::micros64() at the same moment (cache timestamp)
+ * @param acceptAll SCAN in progress - hand every frame to recordCANScanFrame() too
+ * @return          true if the frame was cached
  */
-static void processCANFrame(uint32_t can_id, const uint8_t* data, uint8_t len) {
+static bool processCANFrame(uint32_t can_id, const uint8_t* data, uint8_t len, uint32_t rxMs, uint64_t rxUs,
+                            bool acceptAll) {
+    // Cheapest rejection first - most bus traffic is IDs no input reads
+    if (!acceptAll && !isCANIdSubscribed(can_id)) {
+        return false;
+    }
+
     // Validate frame has minimum data
     if (len == 0) {
         #ifdef DEBUG
         msg.debug.warn(TAG_CAN, "Empty CAN frame (ID 0x%03X)", can_id);
         #endif
-        return;
+        return false;
+    }
+
+    // Answer to the poller's request (single or multi-PID, ISO-TP framed)
+    if (handleOBD2PollFrame(can_id, data, len, rxMs, rxUs, acceptAll)) {
+        return true;
+    }
+
+    // Broadcast frame an input reads whole - no PID byte to parse
+    if (isCANWholeFrameSubscribed(can_id)) {
+        if (acceptAll) recordCANScanFrame(can_id, CAN_PID_WHOLE_FRAME, data, len, rxMs);
+        updateCANCache(can_id, CAN_PID_WHOLE_FRAME, data, len, rxUs);
+        return true;
     }
 
     // Detect protocol format and extract identifier
     uint8_t identifier;
     uint8_t data_offset;
+    bool obd2 = true;
 
     if (len >= 3 && data[0] == 0x04 && data[1] == 0x41) {
         // OBD-II Mode 01 response format:
@@ -148,10 +381,21 @@ static void processCANFrame(uint32_t can_id, const uint8_t* data, uint8_t len) {
         #endif
         identifier = data[0];
         data_offset = 0;
+        obd2 = false;
     } else {
-        // Custom protocol or J1939 - use first byte as identifier
+        // Custom protocol - use first byte as identifier (J1939 has its own path)
         identifier = data[0];
         data_offset = 0;
+        obd2 = false;
+    }
+
+    // SCAN records OBD-II responses per PID and everything else per CAN ID
+    if (acceptAll) {
+        if (obd2) {
+            recordCANScanFrame(can_id, identifier, &data[data_offset], len - data_offset, rxMs);
+        } else {
+            recordCANScanFrame(can_id, CAN_PID_WHOLE_FRAME, data, len, rxMs);
+        }
     }
 
     // Update cache with extracted data
@@ -160,35 +404,151 @@ static void processCANFrame(uint32_t can_id, const uint8_t* data, uint8_t len) {
         #ifdef DEBUG
         msg.debug.warn(TAG_CAN, "No data after protocol parsing (ID 0x%03X)", can_id);
         #endif
-        return;
+        return false;
+    }
+
+    if (!isCANFrameSubscribed(can_id, identifier)) {
+        return false;  // Not read by any input (or a subscribed ID, but a PID no input reads)
     }
 
-    updateCANCache(can_id, identifier, &data[data_offset], data_length);
+    updateCANCache(can_id, identifier, &data[data_offset], data_length, rxUs);
+    return true;
 }
 
 /**
- * Update CAN input - poll for incoming frames and populate cache
- * Called from main loop - non-blocking
- * Uses HAL for platform abstraction.
+ * Cache a J1939 message (single frame or reassembled) under its PGN
+ * Inputs read it under (PGN, source address), or (PGN, CAN_PID_WHOLE_FRAME)
+ * from any source. The payload is cached whole, so signal offsets count from
+ * byte 0; a BAM message longer than CAN_CACHE_MAX_DATA keeps its leading bytes.
+ */
+static bool cacheJ1939Message(uint32_t pgn, uint8_t source, const uint8_t* data, uint16_t len,
+                              uint32_t rxMs, uint64_t rxUs, bool acceptAll) {
+    if (pgn > 0xFFFF || len == 0) return false;  // DP=1 PGNs don't fit the 16-bit cache key
+    uint16_t key = (uint16_t)pgn;
+    uint8_t cacheLen = len > CAN_CACHE_MAX_DATA ? CAN_CACHE_MAX_DATA : len;
+
+    // SCAN lists PGNs - SET CAN FRAME <pgn> reads one from any source
+    if (acceptAll) recordCANScanFrame(key, CAN_PID_WHOLE_FRAME, data, cacheLen, rxMs);
+
+    bool cached = false;
+    if (isCANFrameSubscribed(key, CAN_PID_WHOLE_FRAME)) {
+        updateCANCache(key, CAN_PID_WHOLE_FRAME, data, cacheLen, rxUs);
+        cached = true;
+    }
+    if (isCANFrameSubscribed(key, source)) {
+        updateCANCache(key, source, data, cacheLen, rxUs);
+        cached = true;
+    }
+    return cached;
+}
+
+/**
+ * Process a 29-bit J1939 frame - TP.CM / TP.DT feed the BAM reassembler,
+ * everything else is a single-frame message
+ */
+static bool processJ1939Frame(uint32_t can_id, const uint8_t* data, uint8_t len, uint32_t rxMs, uint64_t rxUs,
+                              bool acceptAll) {
+    J1939Id id = j1939ParseId(can_id);
+
+    if (id.pgn == J1939_PGN_TP_CM || id.pgn == J1939_PGN_TP_DT) {
+        const J1939TpSession* message = nullptr;
+        switch (j1939TpReceive(&j1939Tp, id, data, len, rxMs, &message)) {
+            case J1939_TP_COMPLETE:
+                return cacheJ1939Message(message->pgn, message->source, message->data, message->length,
+                                         rxMs, rxUs, acceptAll);
+            case J1939_TP_IN_PROGRESS:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // Cheapest rejection first, as for 11-bit frames
+    if (!acceptAll && (id.pgn > 0xFFFF || !isCANIdSubscribed(id.pgn))) return false;
+    return cacheJ1939Message(id.pgn, id.source, data, len, rxMs, rxUs, acceptAll);
+}
+
+/**
+ * CAN RX pump handler (lib/can_rx.h) - every frame on the input bus
+ * J1939 networks carry only 29-bit frames; 11-bit frames are dropped there.
+ */
+static bool handleCANInputFrame(const hal::can::CanRxFrame& frame) {
+    if (!canInputInitialized) return false;
+    if (j1939Input) {
+        if (!frame.extended) return false;
+        return processJ1939Frame(frame.id, frame.data, frame.len, frame.rxMs, frame.rxUs, canAcceptAll);
+    }
+    return processCANFrame(frame.id, frame.data, frame.len, frame.rxMs, frame.rxUs, canAcceptAll);
+}
+
+void printJ1939InputStatus() {
+    if (!canInputInitialized || !j1939Input) return;
+    msg.control.print(F("J1939 input: "));
+    msg.control.print(j1939Tp.completed);
+    msg.control.print(F(" BAM messages, "));
+    msg.control.print(j1939Tp.dropped);
+    msg.control.println(F(" dropped"));
+}
+
+void printCANCacheStats(const CANCacheStats* since) {
+    if (!canInputInitialized) return;
+    CANCacheStats s = canCacheStats;
+    if (since) {
+        s.updates -= since->updates;
+        s.inserts -= since->inserts;
+        s.evictions -= since->evictions;
+        s.refused -= since->refused;
+        s.hits -= since->hits;
+        s.misses -= since->misses;
+    }
+    uint16_t valid, pinned;
+    countCANCacheSlots(&valid, &pinned);
+
+    msg.control.print(F("Frame cache: "));
+    msg.control.print(valid);
+    msg.control.print(F("/"));
+    msg.control.print(CAN_CACHE_SIZE);
+    msg.control.print(F(" slots with data, "));
+    msg.control.print(pinned);
+    msg.control.println(F(" pinned"));
+    msg.control.print(F("  Stored: "));
+    msg.control.print(s.updates);
+    msg.control.print(F(" updates, "));
+    msg.control.print(s.inserts);
+    msg.control.print(F(" new ("));
+    msg.control.print(s.evictions);
+    msg.control.print(F(" evicting), "));
+    msg.control.print(s.refused);
+    msg.control.println(F(" refused"));
+    msg.control.print(F("  Lookups: "));
+    msg.control.print(s.hits);
+    msg.control.print(F(" hit, "));
+    msg.control.print(s.misses);
+    msg.control.println(F(" miss"));
+}
+
+/**
+ * Update CAN input - track SCAN so filters open while it listens, and send
+ * the next OBD-II request in POLL mode
+ * Called from main loop before pumpCANRx(), which delivers the frames.
  *
  * Supports:
  * - OBD-II responses (Mode 0x41) - extracts PID from byte[2]
- * - J1939 and custom protocols - uses byte[0] as identifier
+ * - Custom protocols - uses byte[0] as identifier
+ * - J1939 (input protocol J1939) - PGN and source address
  * - Any CAN ID (not limited to 0x7E8)
  */
 void updateCANInput() {
     // Check if input is enabled and initialized
     if (!canInputInitialized || systemConfig.buses.can_input_mode == CAN_INPUT_OFF) {
+        canAcceptAll = false;
         return;
     }
 
-    // Poll for frames via HAL (handles all platforms)
-    uint32_t id;
-    uint8_t data[8];
-    uint8_t len;
-    bool extended;
-
-    while (hal::can::read(id, data, len, extended, canInputBus)) {
-        processCANFrame(id, data, len);
+    canAcceptAll = (getCANScanState() == SCAN_LISTENING);  // SCAN needs to see everything
+    if (canAcceptAll != canFiltersOpen) {
+        pushCANInputFilters(canAcceptAll);  // Open for the scan, narrow again after
     }
+
+    updateOBD2Poller(millis());
 }
@@ -8,7 +8,17 @@
  * - Uses input_can_bus from systemConfig.buses
  * - Polls for incoming frames without blocking
  * - Updates canFrameCache for readCANSensor() to consume
- * - Supports any CAN ID (OBD-II, J1939, custom protocols)
+ * - Only caches (CAN ID, PID) pairs a configured CAN input subscribes to;
+ *   everything else is dropped on receive (SCAN sees every frame, without
+ *   caching it)
+ * - Broadcast frames without a PID byte (SET CAN FRAME) are cached whole
+ *   under their CAN ID, one slot for every signal read from the frame
+ * - Subscribed IDs are also programmed into the controller's acceptance
+ *   filters (hal::can::setFilterRules) so most traffic never reaches us
+ * - Supports any CAN ID (OBD-II, custom protocols); with the J1939 input
+ *   protocol, 29-bit frames are keyed by (PGN, source address) instead and
+ *   TP.BAM multi-packet messages are reassembled (lib/j1939.h)
+ * - In POLL mode, requests the subscribed ECU PIDs itself (obd2_poller.h)
  */
 
 #ifndef INPUT_CAN_H
@@ -35,10 +45,55 @@ bool initCANInput();
  * Supports:
  * - OBD-II Mode 01 responses (0x41) - extracts PID from byte[2]
  * - Custom protocols - uses byte[0] as identifier
+ * - J1939 - PGN and source address from the 29-bit ID
  * - Any CAN ID (not limited to 0x7E8)
  */
 void updateCANInput();
 
+/**
+ * Rebuild the subscription set from the configured CAN-imported inputs and
+ * pin their (CAN ID, PID) pairs in the frame cache, so bursts of other bus
+ * traffic can't evict them
+ *
+ * Called whenever the input schedule is rebuilt.
+ */
+void refreshCANInputSubscriptions();
+
+/**
+ * Forget the compiled signals, frame groups and last decoded frame of every
+ * CAN-imported input; the next read recompiles them (calibrations may have
+ * changed)
+ *
+ * Called whenever the input schedule is rebuilt (sensors/can/can_read.cpp).
+ */
+void resetCANReadState();
+
+/**
+ * Program the input bus hardware acceptance filters from the subscription set
+ *
+ * On a bus shared with CAN output, the output subsystem starts the bus and
+ * calls this afterwards; the OBD-II request IDs it answers are included.
+ */
+void applyCANInputFilters();
+
+/**
+ * Frames lost on the input bus to receive overruns since it was started
+ * (controller buffers or the driver's RX ring; 0 where not tracked)
+ */
+uint32_t getCANInputRxOverflows();
+
+/**
+ * Print J1939 transport counters to the control port (J1939 input protocol only)
+ */
+void printJ1939InputStatus();
+
+/**
+ * Print frame cache occupancy and counters to the control port (CAN input only)
+ * @param since  Counters to subtract (a snapshot taken earlier), nullptr = since boot
+ */
+struct CANCacheStats;
+void printCANCacheStats(const CANCacheStats* since = nullptr);
+
 /**
  * Shutdown CAN input subsystem
  * Disables CAN input bus
@@ -0,0 +1,153 @@
+/*
+ * input_filter.cpp - Per-input post-read filtering
+ */
+
+#include "input_filter.h"
+#include "input_manager.h"
+#include "../lib/message_router.h"  // For msg.control
+#include "../lib/message_api.h"
+#include <math.h>
+
+struct InputFilterState {
+    float window[FILTER_MEDIAN_MAX_TAPS];  // MEDIAN history; EMA/SLEW keep their output in [0]
+    uint32_t lastMs;                       // millis() of the previous filtered sample
+    uint8_t count;                         // Samples held (0 = restart on next reading)
+    uint8_t head;                          // Next MEDIAN slot to overwrite
+};
+
+static InputFilterState filterState[MAX_INPUTS];
+
+// Median of the first n entries (n <= FILTER_MEDIAN_MAX_TAPS)
+static float medianOf(const float* values, uint8_t n) {
+    float sorted[FILTER_MEDIAN_MAX_TAPS];
+    for (uint8_t i = 0; i < n; i++) {
+        // Insertion sort - at most 5 entries
+        float v = values[i];
+        uint8_t j = i;
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+    return sorted[n / 2];
+}
+
+void applyInputFilter(Input* input, uint32_t now) {
+    if (input->filterType == FILTER_NONE) return;
+
+    uint8_t idx = input - inputs;
+    if (idx >= MAX_INPUTS) return;
+    InputFilterState* state = &filterState[idx];
+
+    float raw = input->value;
+    if (isnan(raw)) {
+        state->count = 0;  // Fault passes through; restart from the next good reading
+        return;
+    }
+
+    uint32_t dt = now - state->lastMs;
+    state->lastMs = now;
+
+    switch (input->filterType) {
+        case FILTER_EMA: {
+            if (state->count == 0) {
+                state->window[0] = raw;
+            } else {
+                // Discrete equivalent of a first-order lag with time constant tau
+                float alpha = (float)dt / ((float)input->filterParam + dt);
+                state->window[0] += alpha * (raw - state->window[0]);
+            }
+            state->count = 1;
+            input->value = state->window[0];
+            break;
+        }
+
+        case FILTER_MEDIAN: {
+            uint8_t taps = input->filterParam;
+            if (taps > FILTER_MEDIAN_MAX_TAPS) taps = FILTER_MEDIAN_MAX_TAPS;
+            if (taps == 0) taps = 1;
+            if (state->count == 0) state->head = 0;
+
+            state->window[state->head] = raw;
+            state->head = (state->head + 1) % taps;
+            if (state->count < taps) state->count++;
+            input->value = medianOf(state->window, state->count);
+            break;
+        }
+
+        case FILTER_SLEW: {
+            if (state->count == 0) {
+                state->window[0] = raw;
+            } else {
+                float maxStep = input->filterParam * 0.01f * dt * 0.001f;
+                float step = raw - state->window[0];
+                if (step > maxStep) step = maxStep;
+                if (step < -maxStep) step = -maxStep;
+                state->window[0] += step;
+            }
+            state->count = 1;
+            input->value = state->window[0];
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+void resetInputFilter(Input* input) {
+    uint8_t idx = input - inputs;
+    if (idx >= MAX_INPUTS) return;
+    filterState[idx].count = 0;
+    filterState[idx].head = 0;
+}
+
+void resetInputFilters() {
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        filterState[i].count = 0;
+        filterState[i].head = 0;
+    }
+}
+
+bool isValidInputFilter(uint8_t type, uint16_t param) {
+    switch (type) {
+        case FILTER_NONE:   return true;
+        case FILTER_EMA:    return param > 0;
+        case FILTER_MEDIAN: return param == 3 || param == 5;
+        case FILTER_SLEW:   return param > 0;
+        default:            return false;
+    }
+}
+
+const __FlashStringHelper* getInputFilterName(uint8_t type) {
+    switch (type) {
+        case FILTER_EMA:    return F("EMA");
+        case FILTER_MEDIAN: return F("MEDIAN");
+        case FILTER_SLEW:   return F("SLEW");
+        default:            return F("NONE");
+    }
+}
+
+void printInputFilter(const Input* input) {
+    msg.control.print(getInputFilterName(input->filterType));
+    switch (input->filterType) {
+        case FILTER_EMA:
+            msg.control.print(' ');
+            msg.control.print(input->filterParam);
+            msg.control.print(F("ms"));
+            break;
+        case FILTER_MEDIAN:
+            msg.control.print(' ');
+            msg.control.print(input->filterParam);
+            msg.control.print(F(" taps"));
+            break;
+        case FILTER_SLEW:
+            msg.control.print(' ');
+            msg.control.print(input->filterParam / 100.0, 2);
+            msg.control.print(F("/s"));
+            break;
+        default:
+            break;
+    }
+}
@@ -0,0 +1,53 @@
+/*
+ * input_filter.h - Per-input post-read filtering
+ *
+ * Read functions store the raw conversion in Input::value; the read pipeline
+ * then runs the input's filter stage over it before anything else (alarms,
+ * relays, outputs) sees the value:
+ *
+ *   FILTER_EMA     - Exponential moving average, time constant filterParam ms
+ *                    (weighted by the actual time between reads, so it means
+ *                    the same thing at any read interval)
+ *   FILTER_MEDIAN  - Median of the last filterParam (3 or 5) readings
+ *                    (rejects single-sample spikes without lag on steps)
+ *   FILTER_SLEW    - Rate limit, filterParam hundredths of standard units per
+ *                    second (/100: 50 = 0.5 bar/s)
+ *
+ * State is a fixed per-input array (no allocation). A NAN reading passes
+ * straight through and restarts the filter, so sensor faults are never
+ * smoothed over. Configured with SET <pin> FILTER, persisted in EEPROM.
+ */
+
+#ifndef INPUT_FILTER_H
+#define INPUT_FILTER_H
+
+#include <Arduino.h>
+#include "input.h"
+
+enum InputFilterType : uint8_t {
+    FILTER_NONE = 0,
+    FILTER_EMA,
+    FILTER_MEDIAN,
+    FILTER_SLEW,
+    NUM_FILTER_TYPES
+};
+
+#define FILTER_MEDIAN_MAX_TAPS 5
+
+// Filter the raw value the read function just stored (call after every read)
+void applyInputFilter(Input* input, uint32_t now);
+
+// Forget filter history (configuration changed)
+void resetInputFilter(Input* input);
+void resetInputFilters();
+
+// True if param is valid for type (EMA > 0 ms, MEDIAN 3 or 5, SLEW > 0)
+bool isValidInputFilter(uint8_t type, uint16_t param);
+
+// "NONE", "EMA", "MEDIAN", "SLEW"
+const __FlashStringHelper* getInputFilterName(uint8_t type);
+
+// Print "EMA 500ms" style description to the control port
+void printInputFilter(const Input* input);
+
+#endif // INPUT_FILTER_H
@@ -0,0 +1,139 @@
+/*
+ * input_health.cpp - Per-input read health and fault telemetry
+ */
+
+#include "input_health.h"
+#include "input_manager.h"
+#include "../lib/message_router.h"  // For msg.control
+#include "../lib/message_api.h"
+#include <math.h>
+
+static InputHealth health[MAX_INPUTS];
+
+static inline InputHealth* healthOf(const Input* input) {
+    uint8_t idx = input - inputs;
+    return (idx < MAX_INPUTS) ? &health[idx] : nullptr;
+}
+
+void setInputFault(Input* input, uint8_t reason) {
+    input->value = NAN;
+    InputHealth* h = healthOf(input);
+    if (h) h->pendingReason = reason;
+}
+
+void recordInputRead(Input* input, uint32_t now, uint32_t latency_us) {
+    InputHealth* h = healthOf(input);
+    if (h == nullptr) return;
+
+    h->latencyUs = (latency_us > 0xFFFF) ? 0xFFFF : latency_us;
+    if (h->latencyUs > h->maxLatencyUs) h->maxLatencyUs = h->latencyUs;
+
+    if (isnan(input->value)) {
+        h->lastReason = (h->pendingReason != FAULT_NONE) ? h->pendingReason : FAULT_UNKNOWN;
+        if (h->consecutiveFails < 0xFFFF) h->consecutiveFails++;
+        if (h->totalFails < 0xFFFF) h->totalFails++;
+    } else {
+        h->consecutiveFails = 0;
+        h->lastGoodMs = now;
+    }
+    h->pendingReason = FAULT_NONE;
+}
+
+uint16_t getInputHealthInterval(const Input* input, uint16_t interval) {
+#if INPUT_HEALTH_BACKOFF_FAILS > 0
+    const InputHealth* h = healthOf(input);
+    if (h && h->consecutiveFails >= INPUT_HEALTH_BACKOFF_FAILS && interval < INPUT_HEALTH_BACKOFF_MS) {
+        return INPUT_HEALTH_BACKOFF_MS;
+    }
+#endif
+    return interval;
+}
+
+const InputHealth* getInputHealth(const Input* input) {
+    return healthOf(input);
+}
+
+void resetInputHealth(Input* input) {
+    InputHealth* h = healthOf(input);
+    if (h) memset(h, 0, sizeof(InputHealth));
+}
+
+const __FlashStringHelper* getInputFaultName(uint8_t reason) {
+    switch (reason) {
+        case FAULT_NONE:           return F("NONE");
+        case FAULT_ADC_RAIL:       return F("ADC_RAIL");
+        case FAULT_OPEN_CIRCUIT:   return F("OPEN");
+        case FAULT_SHORT_CIRCUIT:  return F("SHORT");
+        case FAULT_NO_DEVICE:      return F("NO_DEVICE");
+        case FAULT_STALE:          return F("STALE");
+        case FAULT_OUT_OF_RANGE:   return F("OUT_OF_RANGE");
+        case FAULT_NO_CALIBRATION: return F("NO_CALIBRATION");
+        default:                   return F("UNKNOWN");
+    }
+}
+
+void packInputHealthFrame(const Input* input, uint32_t now, uint8_t* frame) {
+    memset(frame, 0, INPUT_HEALTH_FRAME_SIZE);
+    const InputHealth* h = healthOf(input);
+    if (h == nullptr) return;
+
+    uint32_t ageS = h->lastGoodMs ? (now - h->lastGoodMs) / 1000 : 0xFFFF;
+    if (ageS > 0xFFFF) ageS = 0xFFFF;
+    uint16_t latency = (h->latencyUs + 50) / 100;
+
+    frame[0] = input->pin;
+    frame[1] = h->lastReason;
+    frame[2] = (h->consecutiveFails > 0xFF) ? 0xFF : h->consecutiveFails;
+    frame[3] = h->totalFails & 0xFF;
+    frame[4] = h->totalFails >> 8;
+    frame[5] = ageS & 0xFF;
+    frame[6] = ageS >> 8;
+    frame[7] = (latency > 0xFF) ? 0xFF : latency;
+}
+
+void printInputHealth(const Input* input) {
+    const InputHealth* h = healthOf(input);
+    if (h == nullptr) return;
+    uint32_t now = millis();
+
+    msg.control.print(F("  Consecutive Failures: "));
+    msg.control.println(h->consecutiveFails);
+
+    msg.control.print(F("  Total Failures: "));
+    msg.control.println(h->totalFails);
+
+    msg.control.print(F("  Last Failure: "));
+    msg.control.println(getInputFaultName(h->lastReason));
+
+    msg.control.print(F("  Last Good: "));
+    if (h->lastGoodMs == 0) {
+        msg.control.println(F("never"));
+    } else {
+        msg.control.print(now - h->lastGoodMs);
+        msg.control.println(F("ms ago"));
+    }
+
+    msg.control.print(F("  Read Latency: "));
+    msg.control.print(h->latencyUs);
+    msg.control.print(F("us (max "));
+    msg.control.print(h->maxLatencyUs);
+    msg.control.println(F("us)"));
+
+#if INPUT_HEALTH_BACKOFF_FAILS > 0
+    if (h->consecutiveFails >= INPUT_HEALTH_BACKOFF_FAILS) {
+        msg.control.print(F("  Backed off: reading every "));
+        msg.control.print(INPUT_HEALTH_BACKOFF_MS);
+        msg.control.println(F("ms until it recovers"));
+    }
+#endif
+
+    uint8_t frame[INPUT_HEALTH_FRAME_SIZE];
+    packInputHealthFrame(input, now, frame);
+    msg.control.print(F("  Frame:"));
+    for (uint8_t i = 0; i < INPUT_HEALTH_FRAME_SIZE; i++) {
+        msg.control.print(' ');
+        if (frame[i] < 0x10) msg.control.print('0');
+        msg.control.print(frame[i], HEX);
+    }
+    msg.control.println();
+}
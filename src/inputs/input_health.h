@@ -0,0 +1,93 @@
+/*
+ * input_health.h - Per-input read health and fault telemetry
+ *
+ * A failed read only leaves NAN in Input::value. The read pipeline records
+ * every read here instead, so degrading senders show up before they fail:
+ *
+ *   - Consecutive and total failures (total saturates at 65535)
+ *   - millis() of the last good reading
+ *   - Read latency (last and worst, microseconds)
+ *   - Reason code of the last failure
+ *
+ * Read functions that know why they failed report it with
+ * setInputFault(ptr, FAULT_x) instead of storing NAN themselves; a NAN with
+ * no reason is recorded as FAULT_UNKNOWN.
+ *
+ * An input with INPUT_HEALTH_BACKOFF_FAILS consecutive failures is read at
+ * most every INPUT_HEALTH_BACKOFF_MS until it returns a good reading, so a
+ * dead sensor doesn't burn a read every interval.
+ *
+ * Exported through INFO <pin> HEALTH, the JSON dump ("health") and an
+ * 8-byte binary frame (packInputHealthFrame, one CAN frame per input).
+ *
+ * Build Flags:
+ *   -D INPUT_HEALTH_BACKOFF_FAILS=n - Failures before backoff (default 10, 0 = never)
+ *   -D INPUT_HEALTH_BACKOFF_MS=n    - Read interval while backed off (default 1000)
+ */
+
+#ifndef INPUT_HEALTH_H
+#define INPUT_HEALTH_H
+
+#include <Arduino.h>
+#include "input.h"
+
+#ifndef INPUT_HEALTH_BACKOFF_FAILS
+#define INPUT_HEALTH_BACKOFF_FAILS 10
+#endif
+
+#ifndef INPUT_HEALTH_BACKOFF_MS
+#define INPUT_HEALTH_BACKOFF_MS 1000
+#endif
+
+#define INPUT_HEALTH_FRAME_SIZE 8
+
+enum InputFaultReason : uint8_t {
+    FAULT_NONE = 0,
+    FAULT_UNKNOWN,          // NAN without a reported reason
+    FAULT_ADC_RAIL,         // Analog reading stuck at a rail (open/short sender)
+    FAULT_OPEN_CIRCUIT,     // Thermocouple open
+    FAULT_SHORT_CIRCUIT,    // Thermocouple shorted to GND/VCC
+    FAULT_NO_DEVICE,        // Bus device or capture channel not available
+    FAULT_STALE,            // Source data timed out (CAN)
+    FAULT_OUT_OF_RANGE,     // Conversion outside the sensor's valid range
+    FAULT_NO_CALIBRATION,   // Calibration data missing
+    NUM_FAULT_REASONS
+};
+
+struct InputHealth {
+    uint32_t lastGoodMs;        // millis() of the last good reading (0 = never)
+    uint16_t consecutiveFails;
+    uint16_t totalFails;
+    uint16_t latencyUs;         // Last read duration
+    uint16_t maxLatencyUs;      // Worst read duration
+    uint8_t lastReason;         // InputFaultReason of the last failure
+    uint8_t pendingReason;      // Set by setInputFault() during the current read
+};
+
+// Store NAN with a reason (call from read functions)
+void setInputFault(Input* input, uint8_t reason);
+
+// Account for the read that just ran (call after every read, before filtering)
+void recordInputRead(Input* input, uint32_t now, uint32_t latency_us);
+
+// Read interval to use next (interval, or the backoff interval for a dead input)
+uint16_t getInputHealthInterval(const Input* input, uint16_t interval);
+
+// Health of input (nullptr if input is not in inputs[])
+const InputHealth* getInputHealth(const Input* input);
+
+// Clear counters (input reconfigured)
+void resetInputHealth(Input* input);
+
+// "NONE", "ADC_RAIL", "OPEN", ...
+const __FlashStringHelper* getInputFaultName(uint8_t reason);
+
+// Pack into frame[INPUT_HEALTH_FRAME_SIZE]:
+//   [0] pin  [1] reason  [2] consecutive (sat. 255)  [3..4] total (LE)
+//   [5..6] seconds since last good (LE, sat. 65535)  [7] latency /100us (sat. 255)
+void packInputHealthFrame(const Input* input, uint32_t now, uint8_t* frame);
+
+// Print health details to the control port
+void printInputHealth(const Input* input);
+
+#endif // INPUT_HEALTH_H
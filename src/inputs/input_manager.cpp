@@ -2,17 +2,23 @@
  * input_manager.cpp - Input Configuration & Management Implementation
  */
 
-#include <EEPROM.h>
 #include <string.h>
  #include "../config.h"
 #include "../version.h"
 #include "input_manager.h"
 #include "alarm_logic.h"
 #include "../lib/system_config.h"
+#include "../lib/eeprom_store.h"
+#include "../lib/config_log.h"
+#include "../lib/crc32.h"
+#include "../lib/config_migrate.h"
 #include "../lib/units_registry.h"
+#include "../lib/hash.h"
 #include "../lib/message_router.h"  // For msg.control
 #include "../lib/message_api.h"
 #include "../lib/log_tags.h"
+#include "../lib/memory_report.h"
+#include "../lib/response_stream.h"
 #ifdef USE_STATIC_CONFIG
 #include "../lib/generated/application_presets_static.h"
 #include "../lib/generated/sensor_library_static.h"
@@ -21,14 +27,66 @@
 #include "../lib/sensor_library.h"
 #endif
 #include "../lib/pin_registry.h"
+#include "../lib/adc_scan.h"
+#include "../lib/ext_adc.h"
+#include "../lib/gps.h"
+#include "../lib/can_node.h"
+#include "../lib/modbus.h"
+#include "../lib/freq_capture.h"
+#include "../lib/state_capture.h"
+#include "sensors/adc_lut.h"
+#include "input_filter.h"
+#include "input_health.h"
+#include "input_rate.h"
+#include "alarm_trend.h"
+#include "alarm_rules.h"
+#include "input_math.h"
+#include "input_snapshot.h"
+#include "input_stats.h"
+#include "input_summary.h"
+#include "sensors/thermocouples/thermocouple_batch.h"
+#ifdef ENABLE_CAN
+#include "input_can.h"
+#include "../outputs/output_can.h"
+#endif
 
 // ===== GLOBAL STATE =====
 Input inputs[MAX_INPUTS];
 uint8_t numActiveInputs = 0;
+uint8_t activeSlots[MAX_INPUTS];
+uint8_t numActiveSlots = 0;
+
+InputSchedule inputSchedule[MAX_INPUTS];
+uint8_t numScheduledInputs = 0;
+static uint8_t inputLayoutVersion = 0;
+
+// millis() at which each input's sensor has finished warming up (0 = ready)
+static uint32_t inputReadyAt[MAX_INPUTS];
+
+#if INPUT_PIN_WIDE
+// Slot each pin was last found in. Only a hint: an entry is checked against
+// the slot's pin before it is used, so pins can move without updating it
+#define PIN_SLOT_MAP_SIZE 0x200
+static uint8_t pinSlot[PIN_SLOT_MAP_SIZE];
+#endif
+
+#if !defined(USE_STATIC_CONFIG) && CONFIG_TRANSACTIONS
+// Open config transaction: inputs[] as it was at BEGIN, for rollback
+static bool transactionActive = false;
+static bool transactionLive = false;    // Inputs read and changes applied at once (TEST CERTIFY)
+static Input transactionSaved[MAX_INPUTS];
+static uint8_t transactionSavedActive = 0;
+#else
+static const bool transactionActive = false;
+static const bool transactionLive = false;
+#endif
+
+// Custom display names (Input::displayNameSlot - 1); a slot no input refers to is free
+static char displayNamePool[INPUT_NAME_POOL_SLOTS][INPUT_DISPLAY_NAME_LEN];
 
 // ===== EEPROM LAYOUT =====
 // EEPROM stores configuration persistently for runtime mode.
-// Layout: [Header (8 bytes)] [InputEEPROM 0] [InputEEPROM 1] ... [InputEEPROM N]
+// Layout: [Header (12 bytes)] [InputEEPROM 0] [InputEEPROM 1] ... [InputEEPROM N]
 //
 // IMPORTANT: We store hashes (not indices) in EEPROM for stability.
 // Registry indices can change when entries are reordered, but hashes remain stable.
@@ -43,6 +101,7 @@ struct EEPROMHeader {
     uint16_t version;
     uint8_t numInputs;
     uint8_t reserved;
+    uint32_t crc;                   // CRC-32 of the InputEEPROM records
 };
 
 // InputEEPROM - Compact struct for EEPROM storage
@@ -50,11 +109,11 @@ struct EEPROMHeader {
 // Uses hashes instead of indices for stability across registry reordering
 struct InputEEPROM {
     // === Hardware ===
-    uint8_t pin;                    // Physical pin
+    uint8_t pin;                    // Pin, bits 0-7 (bit 8 in flagsByte)
 
     // === User Configuration (stored as hashes) ===
     char abbrName[8];               // "CHT", "OIL"
-    char displayName[32];           // "Cylinder Head Temp"
+    char displayName[32];           // Custom name ("" = the preset's label)
     uint16_t applicationHash;       // djb2_hash of application name
     uint16_t sensorHash;            // djb2_hash of sensor name
     uint16_t unitsHash;             // djb2_hash of units name
@@ -68,16 +127,74 @@ struct InputEEPROM {
     uint8_t obd2length;
 
     // === Flags ===
-    uint8_t flagsByte;              // Packed flags
+    uint8_t flagsByte;              // Packed flags (0x10: pin bit 8, a wide CAN pin)
 
     // === Output Routing ===
-    uint8_t outputMask;             // Per-input output routing (bits 0-3: CAN, RealDash, Serial, SD)
+    uint8_t outputMask;             // Per-input output routing (bits 0-3: CAN, RealDash, Serial, SD; bit 7: CAN mirror)
+
+    // === Filtering ===
+    uint8_t filterType;             // InputFilterType
+    uint16_t filterParam;
+
+    // === Read Rate ===
+    uint16_t rateMaxInterval;       // 0 = fixed
+    uint16_t rateBand;
+
+    // === Trend Alarm ===
+    float trendRate;                // Standard units/s, 0 = off
+    uint16_t trendWindow;           // ms, 0 = default
+
+    // === Alarm Levels (in STANDARD UNITS) ===
+    uint16_t alarmPersistMs;
+    uint16_t alarmClearMs;
+    uint16_t warnPersistMs;
+    uint16_t warnClearMs;
+    float warnMin;                  // NAN = derived from minValue
+    float warnMax;                  // NAN = derived from maxValue
+    float alarmHysteresis;
+    float warnHysteresis;
 
     // === Calibration ===
     uint8_t calibrationType;
     CalibrationOverride customCalibration;  // 16 bytes
 };
 
+// Boot index cache - stored right after the InputEEPROM records
+// Layout: [InputIndexCacheHeader] [InputIndexCacheEntry 0] ... [Entry N]
+//
+// Holds the registry indices this firmware build resolved the hashes to, so
+// later boots of the same build skip the registry scans. Every cached index is
+// still checked against the stored hash (one PROGMEM read), so a stale or
+// corrupt cache only costs a fallback to hash resolution. Not covered by the
+// config CRC and not versioned - it is rewritten whenever it doesn't match.
+#define INDEX_CACHE_BUILD_ID djb2_hash(FW_GIT_HASH)
+
+struct InputIndexCacheHeader {
+    uint16_t buildId;               // djb2_hash(FW_GIT_HASH) of the build that wrote it
+    uint8_t numInputs;              // Must match EEPROMHeader.numInputs
+    uint8_t reserved;
+};
+
+struct InputIndexCacheEntry {
+    uint8_t applicationIndex;
+    uint8_t sensorIndex;
+    uint8_t unitsIndex;
+};
+
+// Alarm rules (alarm_rules.h) - stored right after the index cache
+// Layout: [AlarmRulesHeader] [AlarmRuleConfig 0] ... [AlarmRuleConfig count-1]
+//
+// Rules are kept by pin, like the inputs they read. Only saved when the
+// block ends before SystemConfig; a bad magic or CRC loads no rules.
+#define ALARM_RULES_MAGIC 0x5252            // "RR"
+
+struct AlarmRulesHeader {
+    uint16_t magic;
+    uint8_t count;                  // Rule slots stored (ALARM_RULE_MAX of the build that wrote it)
+    uint8_t reserved;
+    uint32_t crc;                   // CRC-32 of the rule bytes
+};
+
 // ===== STATIC CONFIG (Compile-Time) =====
 #ifdef USE_STATIC_CONFIG
 
@@ -103,7 +220,7 @@ struct InputEEPROM {
 // Simple macro to configure an input using the registry-based functions
 #define CONFIGURE_INPUT(N, idx) \
     do { \
-        uint8_t pin = INPUT_##N##_PIN; \
+        InputPin pin = INPUT_##N##_PIN; \
         setInputApplication(pin, INPUT_##N##_APPLICATION); \
         setInputSensor(pin, INPUT_##N##_SENSOR); \
     } while(0)
@@ -396,7 +513,15 @@ bool initInputManager() {
         inputs[i].pin = 0xFF;  // Invalid pin
         inputs[i].applicationIndex = 0;  // 0 = NONE
         inputs[i].sensorIndex = 0;       // 0 = NONE
+        inputs[i].value = NAN;           // No reading until the first read completes
     }
+    memset(inputReadyAt, 0, sizeof(inputReadyAt));
+
+    noteStaticMemory(F("inputs[] + read schedule"), sizeof(inputs) + sizeof(inputSchedule) + sizeof(inputReadyAt));
+    noteStaticMemory(F("Custom display names"), sizeof(displayNamePool));
+#if !defined(USE_STATIC_CONFIG) && CONFIG_TRANSACTIONS
+    noteStaticMemory(F("Transaction rollback copy"), sizeof(transactionSaved));
+#endif
 
 #ifdef USE_STATIC_CONFIG
     // ===== COMPILE-TIME CONFIGURATION MODE =====
@@ -488,6 +613,8 @@ bool initInputManager() {
         }
     }
 
+    rebuildInputSchedule();
+
     msg.control.print(F("✓ Loaded "));
     msg.control.print(numActiveInputs);
     msg.control.println(F(" inputs from static config"));
@@ -500,6 +627,7 @@ bool initInputManager() {
     if (!eepromLoaded) {
         msg.debug.info(TAG_CONFIG, "No valid config in EEPROM - starting with blank configuration");
     }
+    rebuildInputSchedule();
     return eepromLoaded;
 #endif
 }
@@ -508,200 +636,790 @@ bool initInputManager() {
 
 #ifndef USE_STATIC_CONFIG
 
+#ifndef ENABLE_CONFIG_LOG
+
+static uint16_t indexCacheAddress(uint8_t numInputs) {
+    return EEPROM_HEADER_SIZE + (uint16_t)numInputs * EEPROM_INPUT_SIZE;
+}
+
+static uint16_t alarmRulesAddress(uint8_t numInputs) {
+    return indexCacheAddress(numInputs) + sizeof(InputIndexCacheHeader) +
+           (uint16_t)numInputs * sizeof(InputIndexCacheEntry);
+}
+
+static bool alarmRulesFit(uint8_t numInputs) {
+    return alarmRulesAddress(numInputs) + sizeof(AlarmRulesHeader) +
+           (uint16_t)ALARM_RULE_MAX * sizeof(AlarmRuleConfig) <= SYSTEM_CONFIG_ADDRESS;
+}
+
+// Cache must end before SystemConfig - with many inputs it is simply not used
+static bool indexCacheFits(uint8_t numInputs) {
+    uint16_t end = indexCacheAddress(numInputs) + sizeof(InputIndexCacheHeader) +
+                   (uint16_t)numInputs * sizeof(InputIndexCacheEntry);
+    return end <= SYSTEM_CONFIG_ADDRESS;
+}
+
+// Cache entry for EEPROM record number `record` of numInputs
+static void writeIndexCacheEntry(uint8_t numInputs, uint8_t record, const Input* input) {
+    if (!indexCacheFits(numInputs)) return;
+    InputIndexCacheEntry entry;
+    entry.applicationIndex = input->applicationIndex;
+    entry.sensorIndex = input->sensorIndex;
+    entry.unitsIndex = input->unitsIndex;
+    eepromPut(indexCacheAddress(numInputs) + sizeof(InputIndexCacheHeader) +
+              (uint16_t)record * sizeof(InputIndexCacheEntry), entry);
+}
+
+static void writeIndexCacheHeader(uint8_t numInputs) {
+    if (!indexCacheFits(numInputs)) return;
+    InputIndexCacheHeader cacheHeader;
+    cacheHeader.buildId = INDEX_CACHE_BUILD_ID;
+    cacheHeader.numInputs = numInputs;
+    cacheHeader.reserved = 0;
+    eepromPut(indexCacheAddress(numInputs), cacheHeader);
+}
+
 /**
- * Calculate XOR checksum of all active inputs
- * Used to detect EEPROM corruption
+ * Write the boot index cache from inputs[0..numInputs) - right after
+ * loadInputConfig(), which fills them in record order. saveInputConfig()
+ * skips slots, so it writes each entry with its record instead.
  */
-static uint8_t calculateConfigChecksum() {
+static void writeIndexCache(uint8_t numInputs) {
+    writeIndexCacheHeader(numInputs);
+    for (uint8_t i = 0; i < numInputs; i++) {
+        writeIndexCacheEntry(numInputs, i, &inputs[i]);
+    }
+}
+
+static bool writeAlarmRules(uint8_t numInputs) {
+    if (!alarmRulesFit(numInputs)) return false;
+    uint16_t addr = alarmRulesAddress(numInputs);
+
+    AlarmRulesHeader rulesHeader = {ALARM_RULES_MAGIC, ALARM_RULE_MAX, 0, 0};
+    uint16_t ruleAddr = addr + sizeof(AlarmRulesHeader);
+    for (uint8_t n = 0; n < ALARM_RULE_MAX; n++) {
+        const AlarmRuleConfig* rule = getAlarmRule(n);
+        rulesHeader.crc = crc32Update(rulesHeader.crc, rule, sizeof(AlarmRuleConfig));
+        eepromPut(ruleAddr, *rule);
+        ruleAddr += sizeof(AlarmRuleConfig);
+    }
+    eepromPut(addr, rulesHeader);
+    return true;
+}
+
+// Set the rules from count stored slots at addr (already checked)
+static void applyStoredRules(uint16_t addr, uint8_t stored) {
+    uint8_t count = stored < ALARM_RULE_MAX ? stored : ALARM_RULE_MAX;
+    for (uint8_t n = 0; n < count; n++) {
+        AlarmRuleConfig rule;
+        eepromGet(addr, rule);
+        addr += sizeof(AlarmRuleConfig);
+        if (!setAlarmRule(n, rule)) {
+            msg.debug.warn(TAG_CONFIG, "Alarm rule %d invalid - dropped", n);
+        }
+    }
+}
+
+static void readAlarmRules(uint8_t numInputs) {
+    clearAlarmRules();
+    if (!alarmRulesFit(numInputs)) return;
+    uint16_t addr = alarmRulesAddress(numInputs);
+
+    AlarmRulesHeader rulesHeader;
+    eepromGet(addr, rulesHeader);
+    if (rulesHeader.magic != ALARM_RULES_MAGIC || rulesHeader.count > 16) return;
+    addr += sizeof(AlarmRulesHeader);
+
+    // CRC over every stored slot first - then rules are applied as a whole or not at all
+    uint32_t crc = 0;
+    for (uint8_t n = 0; n < rulesHeader.count; n++) {
+        AlarmRuleConfig rule;
+        eepromGet(addr + n * sizeof(AlarmRuleConfig), rule);
+        crc = crc32Update(crc, &rule, sizeof(AlarmRuleConfig));
+    }
+    if (crc != rulesHeader.crc) {
+        msg.debug.warn(TAG_CONFIG, "Alarm rules CRC mismatch - rules not loaded");
+        return;
+    }
+    applyStoredRules(addr, rulesHeader.count);
+}
+
+// ===== MIGRATION (config_migrate.h) =====
+// Before v9 the header was 8 bytes (EEPROMHeader without crc; XOR of the
+// records in reserved) and the alarm rules header 4 (XOR of the rule
+// bytes). v8 records are the current InputEEPROM; v7 records had no alarm
+// levels, which migrate to the SET <pin> ALARM defaults. v3 (the baseline
+// release) had no filter, read rate or trend settings either, and no index
+// cache or alarm rules after the records.
+#define LEGACY_HEADER_SIZE 8
+
+struct LegacyAlarmRulesHeader {
+    uint16_t magic;
+    uint8_t count;
+    uint8_t checksum;
+};
+
+struct InputEEPROMv7 {
+    uint8_t pin;
+    char abbrName[8];
+    char displayName[32];
+    uint16_t applicationHash;
+    uint16_t sensorHash;
+    uint16_t unitsHash;
+    float minValue;
+    float maxValue;
+    uint8_t obd2pid;
+    uint8_t obd2length;
+    uint8_t flagsByte;
+    uint8_t outputMask;
+    uint8_t filterType;
+    uint16_t filterParam;
+    uint16_t rateMaxInterval;
+    uint16_t rateBand;
+    float trendRate;
+    uint16_t trendWindow;
+    uint8_t calibrationType;
+    CalibrationOverride customCalibration;
+};
+
+struct InputEEPROMv3 {
+    uint8_t pin;
+    char abbrName[8];
+    char displayName[32];
+    uint16_t applicationHash;
+    uint16_t sensorHash;
+    uint16_t unitsHash;
+    float minValue;
+    float maxValue;
+    uint8_t obd2pid;
+    uint8_t obd2length;
+    uint8_t flagsByte;
+    uint8_t outputMask;
+    uint8_t calibrationType;
+    CalibrationOverride customCalibration;
+};
+
+static const ConfigFieldMap INPUT_V8_FIELDS[] PROGMEM = {
+    {0, 0, sizeof(InputEEPROM)},
+};
+
+static const ConfigFieldMap INPUT_V7_FIELDS[] PROGMEM = {
+    {0, 0, offsetof(InputEEPROMv7, trendWindow) + sizeof(uint16_t)},  // pin through trendWindow
+    {offsetof(InputEEPROMv7, calibrationType), offsetof(InputEEPROM, calibrationType), sizeof(uint8_t)},
+    {offsetof(InputEEPROMv7, customCalibration), offsetof(InputEEPROM, customCalibration), sizeof(CalibrationOverride)},
+};
+
+static const ConfigFieldMap INPUT_V3_FIELDS[] PROGMEM = {
+    {0, 0, offsetof(InputEEPROMv3, outputMask) + sizeof(uint8_t)},  // pin through outputMask
+    {offsetof(InputEEPROMv3, calibrationType), offsetof(InputEEPROM, calibrationType), sizeof(uint8_t)},
+    {offsetof(InputEEPROMv3, customCalibration), offsetof(InputEEPROM, customCalibration), sizeof(CalibrationOverride)},
+};
+
+static const ConfigMigration INPUT_MIGRATIONS[] = {
+    {8, sizeof(InputEEPROM), INPUT_V8_FIELDS, sizeof(INPUT_V8_FIELDS) / sizeof(ConfigFieldMap)},
+    {7, sizeof(InputEEPROMv7), INPUT_V7_FIELDS, sizeof(INPUT_V7_FIELDS) / sizeof(ConfigFieldMap)},
+    {3, sizeof(InputEEPROMv3), INPUT_V3_FIELDS, sizeof(INPUT_V3_FIELDS) / sizeof(ConfigFieldMap)},
+};
+
+static_assert(sizeof(InputEEPROMv7) <= sizeof(InputEEPROM), "Old records are read into an InputEEPROM-sized buffer");
+
+// Read an old record at addr into e, XORing its bytes into checksum
+static void readLegacyInput(const ConfigMigration* migration, uint16_t addr, InputEEPROM* e, uint8_t* checksum) {
+    uint8_t image[sizeof(InputEEPROM)];
+    eepromStoreRead(addr, image, migration->size);
+    for (uint16_t k = 0; k < migration->size; k++) {
+        *checksum ^= image[k];
+    }
+
+    memset(e, 0, sizeof(InputEEPROM));  // Fields the old version didn't have: no band, no timers
+    e->warnMin = NAN;
+    e->warnMax = NAN;
+    migrateConfigImage(migration, image, e);
+}
+
+// Old rules block: after the old records and index cache, XOR-checked
+static void readLegacyAlarmRules(uint8_t numInputs, uint16_t recordSize) {
+    clearAlarmRules();
+    uint16_t addr = LEGACY_HEADER_SIZE + (uint16_t)numInputs * recordSize +
+                    sizeof(InputIndexCacheHeader) + (uint16_t)numInputs * sizeof(InputIndexCacheEntry);
+    if (addr + sizeof(LegacyAlarmRulesHeader) + (uint16_t)ALARM_RULE_MAX * sizeof(AlarmRuleConfig) > SYSTEM_CONFIG_ADDRESS) return;
+
+    LegacyAlarmRulesHeader rulesHeader;
+    eepromGet(addr, rulesHeader);
+    if (rulesHeader.magic != ALARM_RULES_MAGIC || rulesHeader.count > 16) return;
+    addr += sizeof(LegacyAlarmRulesHeader);
+
     uint8_t checksum = 0;
+    for (uint16_t k = 0; k < (uint16_t)rulesHeader.count * sizeof(AlarmRuleConfig); k++) {
+        checksum ^= eepromStoreReadByte(addr + k);
+    }
+    if (checksum != rulesHeader.checksum) {
+        msg.debug.warn(TAG_CONFIG, "Alarm rules checksum mismatch - rules not loaded");
+        return;
+    }
+    applyStoredRules(addr, rulesHeader.count);
+}
 
-    // Read InputEEPROM structs from EEPROM and checksum them
-    // This ensures we're checksumming what was actually saved, not runtime data
-    uint16_t addr = EEPROM_HEADER_SIZE;
-    for (uint8_t i = 0; i < numActiveInputs; i++) {
+// Cached index is only trusted if the registry entry still has the stored hash
+static bool cachedApplicationValid(uint8_t index, uint16_t hash) {
+    const ApplicationPreset* preset = getApplicationByIndex(index);
+    return preset && pgm_read_word(&preset->nameHash) == hash;
+}
+
+static bool cachedSensorValid(uint8_t index, uint16_t hash) {
+    const SensorInfo* info = getSensorByIndex(index);
+    return info && pgm_read_word(&info->nameHash) == hash;
+}
+
+static bool cachedUnitsValid(uint8_t index, uint16_t hash) {
+    const UnitsInfo* info = getUnitsByIndex(index);
+    return info && pgm_read_word(&info->nameHash) == hash;
+}
+
+#endif // ENABLE_CONFIG_LOG
+
+// Input → InputEEPROM (indices → hashes)
+static void packInput(const Input* input, InputEEPROM* e) {
+    memset(e, 0, sizeof(InputEEPROM));
+
+    // Copy simple fields
+    e->pin = (uint8_t)input->pin;
+    strncpy(e->abbrName, input->abbrName, sizeof(e->abbrName) - 1);
+    e->abbrName[sizeof(e->abbrName) - 1] = '\0';  // Ensure null termination
+    if (input->displayNameSlot) {               // Empty: the preset's name
+        strncpy(e->displayName, displayNamePool[input->displayNameSlot - 1], sizeof(e->displayName) - 1);
+    }
+    e->minValue = input->minValue;
+    e->maxValue = input->maxValue;
+    e->obd2pid = input->obd2pid;
+    e->obd2length = input->obd2length;
+    e->calibrationType = input->calibrationType;
+    memcpy(&e->customCalibration, &input->customCalibration, sizeof(CalibrationOverride));
+
+    // Pack flags into single byte
+    e->flagsByte =
+        (input->flags.isEnabled ? 0x01 : 0) |
+        (input->flags.alarm ? 0x02 : 0) |
+        (input->flags.display ? 0x04 : 0) |
+        (input->flags.useCustomCalibration ? 0x08 : 0) |
+        (input->pin > 0xFF ? 0x10 : 0);
+
+    // Output routing mask
+    e->outputMask = input->outputMask;
+
+    // Filter stage
+    e->filterType = input->filterType;
+    e->filterParam = input->filterParam;
+
+    // Read rate
+    e->rateMaxInterval = input->rateMaxInterval;
+    e->rateBand = input->rateBand;
+
+    // Trend alarm
+    e->trendRate = input->trendRate;
+    e->trendWindow = input->trendWindow;
+
+    // Alarm levels
+    e->alarmPersistMs = input->alarmContext.persistTime_ms;
+    e->alarmClearMs = input->alarmClearMs;
+    e->warnPersistMs = input->warnPersistMs;
+    e->warnClearMs = input->warnClearMs;
+    e->warnMin = input->warnMin;
+    e->warnMax = input->warnMax;
+    e->alarmHysteresis = input->alarmHysteresis;
+    e->warnHysteresis = input->warnHysteresis;
+
+    // Convert indices to hashes by looking up names in registries
+    const ApplicationPreset* appPreset = getApplicationByIndex(input->applicationIndex);
+    if (appPreset) {
+        e->applicationHash = pgm_read_word(&appPreset->nameHash);
+    }
+
+    const SensorInfo* sensorInfo = getSensorByIndex(input->sensorIndex);
+    if (sensorInfo) {
+        e->sensorHash = pgm_read_word(&sensorInfo->nameHash);
+    }
+
+    const UnitsInfo* unitsInfo = getUnitsByIndex(input->unitsIndex);
+    if (unitsInfo) {
+        e->unitsHash = pgm_read_word(&unitsInfo->nameHash);
+    }
+}
+
+// InputEEPROM → Input, all but the registry indices
+static void unpackInput(Input* input, const InputEEPROM& e) {
+    // Copy simple fields
+    input->pin = e.pin;
+#if INPUT_PIN_WIDE
+    if (e.flagsByte & 0x10) input->pin |= 0x100;
+#endif
+    strncpy(input->abbrName, e.abbrName, sizeof(input->abbrName));
+    input->abbrName[sizeof(input->abbrName) - 1] = '\0';  // Ensure null termination
+    input->minValue = e.minValue;
+    input->maxValue = e.maxValue;
+    input->obd2pid = e.obd2pid;
+    input->obd2length = e.obd2length;
+    input->calibrationType = (CalibrationType)e.calibrationType;
+    memcpy(&input->customCalibration, &e.customCalibration, sizeof(CalibrationOverride));
+
+    // Unpack flags from single byte
+    input->flags.isEnabled = (e.flagsByte & 0x01) != 0;
+    input->flags.alarm = (e.flagsByte & 0x02) != 0;
+    input->flags.display = (e.flagsByte & 0x04) != 0;
+    input->flags.useCustomCalibration = (e.flagsByte & 0x08) != 0;
+
+    // Output routing mask
+    input->outputMask = e.outputMask;
+
+    // Filter stage (invalid settings fall back to unfiltered)
+    if (isValidInputFilter(e.filterType, e.filterParam)) {
+        input->filterType = e.filterType;
+        input->filterParam = e.filterParam;
+    }
+
+    // Read rate (invalid settings fall back to fixed)
+    if (isValidInputRate(e.rateMaxInterval, e.rateBand)) {
+        input->rateMaxInterval = e.rateMaxInterval;
+        input->rateBand = e.rateBand;
+    }
+
+    // Trend alarm (a corrupt rate turns it off)
+    if (!isnan(e.trendRate) && !isinf(e.trendRate)) {
+        input->trendRate = e.trendRate;
+        input->trendWindow = e.trendWindow;
+    }
+
+    // Alarm levels (corrupt thresholds fall back to derived, bands to none)
+    input->alarmClearMs = e.alarmClearMs;
+    input->warnPersistMs = e.warnPersistMs;
+    input->warnClearMs = e.warnClearMs;
+    input->warnMin = isinf(e.warnMin) ? NAN : e.warnMin;
+    input->warnMax = isinf(e.warnMax) ? NAN : e.warnMax;
+    input->alarmHysteresis = isValidAlarmHysteresis(e.alarmHysteresis) ? e.alarmHysteresis : 0;
+    input->warnHysteresis = isValidAlarmHysteresis(e.warnHysteresis) ? e.warnHysteresis : 0;
+}
+
+// Function pointers, sensor init and alarm state of an input just loaded
+static void initLoadedInput(Input* input, uint16_t alarmPersistMs) {
+    // Re-initialize function pointers and sensor-specific data
+    // (Function pointers can't be reliably stored in EEPROM)
+    const SensorInfo* flashInfo = getSensorByIndex(input->sensorIndex);
+    if (flashInfo) {
+        SensorInfo info;
+        loadSensorInfo(flashInfo, &info);
+        input->readFunction = info.readFunction;
+        input->measurementType = info.measurementType;
+        input->calibrationType = info.calibrationType;
+
+        // Restore preset calibration pointer if not using custom calibration
+        if (!input->flags.useCustomCalibration) {
+            input->presetCalibration = info.defaultCalibration;
+        }
+
+        // Call sensor-specific initialization function if it exists
+        if (info.initFunction) {
+            info.initFunction(input);
+        }
+    }
+
+    // Alarm state machine from INIT: preset warmup, saved persistence
+    uint16_t warmupTime_ms = 0;
+    const ApplicationPreset* flashPreset = getApplicationByIndex(input->applicationIndex);
+    if (flashPreset) {
+        ApplicationPreset preset;
+        loadApplicationPreset(flashPreset, &preset);
+        warmupTime_ms = preset.warmupTime_ms;
+    }
+    initInputAlarmContext(input, millis(), warmupTime_ms, alarmPersistMs);
+}
+
+#ifdef ENABLE_CONFIG_LOG
+
+// ===== CONFIG LOG (config_log.h) =====
+// Each InputEEPROM member is one field, keyed by the input's position in save
+// order (as slots are in the fixed layout); each alarm rule is one record.
+// Field numbers are positions in this table - new members go at the end.
+struct InputLogField {
+    uint8_t offset;
+    uint8_t size;
+};
+
+#define INPUT_LOG_FIELD(member) {offsetof(InputEEPROM, member), sizeof(((InputEEPROM*)0)->member)}
+
+static const InputLogField INPUT_LOG_FIELDS[] PROGMEM = {
+    INPUT_LOG_FIELD(pin),
+    INPUT_LOG_FIELD(abbrName),
+    INPUT_LOG_FIELD(displayName),
+    INPUT_LOG_FIELD(applicationHash),
+    INPUT_LOG_FIELD(sensorHash),
+    INPUT_LOG_FIELD(unitsHash),
+    INPUT_LOG_FIELD(minValue),
+    INPUT_LOG_FIELD(maxValue),
+    INPUT_LOG_FIELD(obd2pid),
+    INPUT_LOG_FIELD(obd2length),
+    INPUT_LOG_FIELD(flagsByte),
+    INPUT_LOG_FIELD(outputMask),
+    INPUT_LOG_FIELD(filterType),
+    INPUT_LOG_FIELD(filterParam),
+    INPUT_LOG_FIELD(rateMaxInterval),
+    INPUT_LOG_FIELD(rateBand),
+    INPUT_LOG_FIELD(trendRate),
+    INPUT_LOG_FIELD(trendWindow),
+    INPUT_LOG_FIELD(alarmPersistMs),
+    INPUT_LOG_FIELD(alarmClearMs),
+    INPUT_LOG_FIELD(warnPersistMs),
+    INPUT_LOG_FIELD(warnClearMs),
+    INPUT_LOG_FIELD(warnMin),
+    INPUT_LOG_FIELD(warnMax),
+    INPUT_LOG_FIELD(alarmHysteresis),
+    INPUT_LOG_FIELD(warnHysteresis),
+    INPUT_LOG_FIELD(calibrationType),
+    INPUT_LOG_FIELD(customCalibration),
+};
+
+#define NUM_INPUT_LOG_FIELDS (sizeof(INPUT_LOG_FIELDS) / sizeof(INPUT_LOG_FIELDS[0]))
+
+static_assert(sizeof(InputEEPROM) <= 255, "Config log field offsets are 8 bits");
+static_assert(MAX_INPUTS < CONFIG_LOG_RULES, "Input keys must stay below the special keys");
+
+// Config as last committed to the log - what a save is diffed against
+static InputEEPROM logged[MAX_INPUTS];
+static AlarmRuleConfig loggedRules[ALARM_RULE_MAX];
+static uint8_t loggedCount;
+
+static void applyLogRecord(uint8_t key, uint8_t field, const uint8_t* data, uint8_t length) {
+    if (key == CONFIG_LOG_COMMIT) {
+        loggedCount = length ? data[0] : 0;
+        return;
+    }
+
+    uint8_t* target;
+    uint8_t size;
+    if (key == CONFIG_LOG_RULES) {
+        if (field >= ALARM_RULE_MAX) return;
+        target = (uint8_t*)&loggedRules[field];
+        size = sizeof(AlarmRuleConfig);
+    } else {
+        if (key >= MAX_INPUTS || field >= NUM_INPUT_LOG_FIELDS) return;  // Another build's slots or fields
+        target = (uint8_t*)&logged[key] + pgm_read_byte(&INPUT_LOG_FIELDS[field].offset);
+        size = pgm_read_byte(&INPUT_LOG_FIELDS[field].size);
+    }
+    memset(target, 0, size);
+    memcpy(target, data, length < size ? length : size);
+}
+
+static bool isZero(const uint8_t* data, uint8_t size) {
+    while (size--) {
+        if (*data++) return false;
+    }
+    return true;
+}
+
+// One field of the config being saved: its record bytes if it has to be
+// logged (changed, or non-zero in a fresh log); written, and taken into
+// logged[], when write is set
+static uint16_t logField(uint8_t key, uint8_t field, const uint8_t* now, uint8_t* was,
+                         uint8_t size, bool fresh, bool write) {
+    if (fresh ? isZero(now, size) : memcmp(now, was, size) == 0) return 0;
+    if (write) {
+        configLogAppend(key, field, now, size);
+        memcpy(was, now, size);
+    }
+    return configLogRecordBytes(now, size);
+}
+
+// Records the current config needs on top of logged[] (fresh: in an empty log)
+static uint16_t logChanges(uint8_t* count, bool fresh, bool write) {
+    uint16_t bytes = 0;
+    uint8_t saved = 0;
+
+    for (uint8_t i = 0; i < MAX_INPUTS && saved < numActiveInputs; i++) {
+        if (inputs[i].pin == 0xFF || !inputs[i].flags.isEnabled) continue;
         InputEEPROM eepromInput;
-        EEPROM.get(addr, eepromInput);
+        packInput(&inputs[i], &eepromInput);
+        for (uint8_t f = 0; f < NUM_INPUT_LOG_FIELDS; f++) {
+            uint8_t offset = pgm_read_byte(&INPUT_LOG_FIELDS[f].offset);
+            uint8_t size = pgm_read_byte(&INPUT_LOG_FIELDS[f].size);
+            bytes += logField(saved, f, (const uint8_t*)&eepromInput + offset,
+                              (uint8_t*)&logged[saved] + offset, size, fresh, write);
+        }
+        saved++;
+    }
+
+    for (uint8_t n = 0; n < ALARM_RULE_MAX; n++) {
+        bytes += logField(CONFIG_LOG_RULES, n, (const uint8_t*)getAlarmRule(n),
+                          (uint8_t*)&loggedRules[n], sizeof(AlarmRuleConfig), fresh, write);
+    }
+
+    *count = saved;
+    return bytes;
+}
+
+bool saveInputConfig() {
+    uint8_t count;
+    uint16_t bytes = logChanges(&count, false, false);
+    bool compacted = false;
+
+    // Full log: start a new generation holding only the current config
+    if (bytes > configLogRoom()) {
+        uint16_t snapshot = logChanges(&count, true, false);
+        if (snapshot > configLogCapacity()) {
+            msg.control.print(F("ERROR: Config needs "));
+            msg.control.print(snapshot);
+            msg.control.print(F(" bytes, the config log holds "));
+            msg.control.println(configLogCapacity());
+            msg.control.println(F("  Inputs not saved - remove some, or drop unused settings"));
+            return false;
+        }
+        configLogFormat();
+        memset(logged, 0, sizeof(logged));
+        memset(loggedRules, 0, sizeof(loggedRules));
+        bytes = snapshot;
+        compacted = true;
+    }
+
+    logChanges(&count, false, true);
+    configLogCommit(count);
+    loggedCount = count;
+
+    msg.control.print(F("✓ Saved "));
+    msg.control.print(count);
+    msg.control.print(F(" inputs to EEPROM (config log, "));
+    msg.control.print(bytes);
+    msg.control.print(F(" bytes of changes, "));
+    msg.control.print(configLogUsed());
+    msg.control.print(F("/"));
+    msg.control.print(CONFIG_LOG_BYTES);
+    msg.control.println(F(" used)"));
+    if (compacted) {
+        msg.debug.info(TAG_CONFIG, "Config log compacted (generation %d)", configLogGeneration());
+    }
+    return true;
+}
+
+bool loadInputConfig() {
+    memset(logged, 0, sizeof(logged));
+    memset(loggedRules, 0, sizeof(loggedRules));
+    loggedCount = 0;
+    if (!configLogOpen()) {
+        return false;
+    }
+    configLogReplay(applyLogRecord);
+
+    // Clear existing inputs
+    memset(inputs, 0, sizeof(inputs));
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        inputs[i].pin = 0xFF;
+        inputs[i].value = NAN;  // No reading until the first read completes
+    }
+
+    numActiveInputs = (loggedCount < MAX_INPUTS) ? loggedCount : MAX_INPUTS;
+    for (uint8_t i = 0; i < numActiveInputs; i++) {
+        unpackInput(&inputs[i], logged[i]);
+        inputs[i].applicationIndex = getApplicationIndexByHash(logged[i].applicationHash);
+        inputs[i].sensorIndex = getSensorIndexByHash(logged[i].sensorHash);
+        inputs[i].unitsIndex = getUnitsIndexByHash(logged[i].unitsHash);
+        storeInputDisplayName(&inputs[i], logged[i].displayName);
+        initLoadedInput(&inputs[i], logged[i].alarmPersistMs);
+    }
 
-        // XOR all bytes of the EEPROM structure
-        const uint8_t* data = (const uint8_t*)&eepromInput;
-        for (size_t k = 0; k < sizeof(InputEEPROM); k++) {
-            checksum ^= data[k];
+    clearAlarmRules();
+    for (uint8_t n = 0; n < ALARM_RULE_MAX; n++) {
+        if (loggedRules[n].severity == SEVERITY_NORMAL) continue;
+        if (!setAlarmRule(n, loggedRules[n])) {
+            msg.debug.warn(TAG_CONFIG, "Alarm rule %d invalid - dropped", n);
         }
+    }
+
+    rebuildInputSchedule();
+
+    msg.debug.info(TAG_CONFIG, "Loaded %d inputs from the config log (%d bytes)", numActiveInputs, configLogUsed());
+    return true;
+}
+
+void resetInputConfig() {
+    // Forget the log
+    configLogErase();
+    memset(logged, 0, sizeof(logged));
+    memset(loggedRules, 0, sizeof(loggedRules));
+    loggedCount = 0;
 
-        addr += EEPROM_INPUT_SIZE;
+    // Clear inputs
+    memset(inputs, 0, sizeof(inputs));
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        inputs[i].pin = 0xFF;
     }
+    numActiveInputs = 0;
+    clearAlarmRules();
+    rebuildInputSchedule();
 
-    return checksum;
+    msg.control.println(F("Configuration reset"));
 }
 
+#else // Fixed layout
+
 bool saveInputConfig() {
     // Convert Input structs to InputEEPROM structs (indices → hashes)
     uint16_t addr = EEPROM_HEADER_SIZE;
     uint8_t savedCount = 0;
+    uint32_t crc = 0;               // Over the records as written - no read-back pass
+
+    // Record count first - the index cache sits after the last record
+    uint8_t recordCount = 0;
+    for (uint8_t i = 0; i < MAX_INPUTS && recordCount < numActiveInputs; i++) {
+        if (inputs[i].pin != 0xFF && inputs[i].flags.isEnabled) recordCount++;
+    }
 
-    for (uint8_t i = 0; i < MAX_INPUTS && savedCount < numActiveInputs; i++) {
+    for (uint8_t i = 0; i < MAX_INPUTS && savedCount < recordCount; i++) {
         if (inputs[i].pin != 0xFF && inputs[i].flags.isEnabled) {
             InputEEPROM eepromInput;
-            memset(&eepromInput, 0, sizeof(InputEEPROM));
-
-            // Copy simple fields
-            eepromInput.pin = inputs[i].pin;
-            strncpy(eepromInput.abbrName, inputs[i].abbrName, sizeof(eepromInput.abbrName) - 1);
-            eepromInput.abbrName[sizeof(eepromInput.abbrName) - 1] = '\0';  // Ensure null termination
-            strncpy(eepromInput.displayName, inputs[i].displayName, sizeof(eepromInput.displayName) - 1);
-            eepromInput.displayName[sizeof(eepromInput.displayName) - 1] = '\0';  // Ensure null termination
-            eepromInput.minValue = inputs[i].minValue;
-            eepromInput.maxValue = inputs[i].maxValue;
-            eepromInput.obd2pid = inputs[i].obd2pid;
-            eepromInput.obd2length = inputs[i].obd2length;
-            eepromInput.calibrationType = inputs[i].calibrationType;
-            memcpy(&eepromInput.customCalibration, &inputs[i].customCalibration, sizeof(CalibrationOverride));
-
-            // Pack flags into single byte
-            eepromInput.flagsByte =
-                (inputs[i].flags.isEnabled ? 0x01 : 0) |
-                (inputs[i].flags.alarm ? 0x02 : 0) |
-                (inputs[i].flags.display ? 0x04 : 0) |
-                (inputs[i].flags.useCustomCalibration ? 0x08 : 0);
-
-            // Output routing mask
-            eepromInput.outputMask = inputs[i].outputMask;
-
-            // Convert indices to hashes by looking up names in registries
-            const ApplicationPreset* appPreset = getApplicationByIndex(inputs[i].applicationIndex);
-            if (appPreset) {
-                eepromInput.applicationHash = pgm_read_word(&appPreset->nameHash);
-            }
-
-            const SensorInfo* sensorInfo = getSensorByIndex(inputs[i].sensorIndex);
-            if (sensorInfo) {
-                eepromInput.sensorHash = pgm_read_word(&sensorInfo->nameHash);
-            }
-
-            const UnitsInfo* unitsInfo = getUnitsByIndex(inputs[i].unitsIndex);
-            if (unitsInfo) {
-                eepromInput.unitsHash = pgm_read_word(&unitsInfo->nameHash);
-            }
+            packInput(&inputs[i], &eepromInput);
 
             // Write to EEPROM
-            EEPROM.put(addr, eepromInput);
+            crc = crc32Update(crc, &eepromInput, sizeof(InputEEPROM));
+            eepromPut(addr, eepromInput);
             addr += EEPROM_INPUT_SIZE;
+
+            // Indices are already resolved - record them for the next boot
+            writeIndexCacheEntry(recordCount, savedCount, &inputs[i]);
             savedCount++;
         }
     }
+    writeIndexCacheHeader(savedCount);
 
     msg.control.print(F("✓ Saved "));
     msg.control.print(savedCount);
     msg.control.println(F(" inputs to EEPROM (hash-based)"));
 
-    // Calculate checksum
-    uint8_t checksum = calculateConfigChecksum();
+    bool anyRules = false;
+    for (uint8_t n = 0; n < ALARM_RULE_MAX; n++) {
+        if (getAlarmRule(n)->severity != SEVERITY_NORMAL) anyRules = true;
+    }
+    if (!writeAlarmRules(savedCount) && anyRules) {
+        msg.control.println(F("WARNING: Alarm rules not saved - no EEPROM room with this many inputs"));
+    }
 
-    // Write header with checksum
+    // Write header with the CRC (the count is what the CRC covers)
     EEPROMHeader header;
     header.magic = EEPROM_MAGIC;
     header.version = EEPROM_VERSION;
-    header.numInputs = numActiveInputs;
-    header.reserved = checksum;  // Store checksum in reserved field
+    header.numInputs = savedCount;
+    header.reserved = 0;
+    header.crc = crc;
 
-    EEPROM.put(0, header);
+    eepromPut(0, header);
 
-    msg.debug.debug(TAG_CONFIG, "Checksum: 0x%02X", checksum);
+    msg.debug.debug(TAG_CONFIG, "CRC: 0x%08lX", (unsigned long)crc);
 
     return true;
 }
 
 bool loadInputConfig() {
     EEPROMHeader header;
-    EEPROM.get(0, header);
+    eepromGet(0, header);
 
     // Validate magic number
     if (header.magic != EEPROM_MAGIC) {
         return false;
     }
 
-    // Check version
+    // Older version: read it through its migration, then save it in this layout
+    const ConfigMigration* migration = nullptr;
     if (header.version != EEPROM_VERSION) {
-        msg.debug.warn(TAG_CONFIG, "EEPROM version mismatch (found %d, expected %d) - ignoring", header.version, EEPROM_VERSION);
-        return false;
+        migration = findConfigMigration(INPUT_MIGRATIONS, sizeof(INPUT_MIGRATIONS) / sizeof(ConfigMigration),
+                                        header.version);
+        if (!migration) {
+            msg.debug.warn(TAG_CONFIG, "EEPROM version mismatch (found %d, expected %d) - ignoring", header.version, EEPROM_VERSION);
+            return false;
+        }
     }
 
     // Clear existing inputs
     memset(inputs, 0, sizeof(inputs));
     for (uint8_t i = 0; i < MAX_INPUTS; i++) {
         inputs[i].pin = 0xFF;
+        inputs[i].value = NAN;  // No reading until the first read completes
     }
 
     // Read inputs from EEPROM and convert hashes → indices
-    uint16_t addr = EEPROM_HEADER_SIZE;
+    uint16_t addr = migration ? LEGACY_HEADER_SIZE : EEPROM_HEADER_SIZE;
+    uint16_t recordSize = migration ? migration->size : EEPROM_INPUT_SIZE;
     numActiveInputs = header.numInputs;
 
     if (numActiveInputs > MAX_INPUTS) {
         numActiveInputs = MAX_INPUTS;
     }
 
+    // Boot cache written by this same build? Then indices need no registry scan
+    bool cacheSupported = !migration && (numActiveInputs == header.numInputs) && indexCacheFits(numActiveInputs);
+    uint16_t cacheAddr = indexCacheAddress(numActiveInputs);
+    bool cacheUsable = false;
+    if (cacheSupported) {
+        InputIndexCacheHeader cacheHeader;
+        eepromGet(cacheAddr, cacheHeader);
+        cacheAddr += sizeof(InputIndexCacheHeader);
+        cacheUsable = (cacheHeader.buildId == INDEX_CACHE_BUILD_ID &&
+                       cacheHeader.numInputs == numActiveInputs);
+    }
+    bool cacheDirty = cacheSupported && !cacheUsable;
+
+    // CRC is accumulated in this pass (same bytes saveInputConfig() covered)
+    uint32_t calculatedCrc = 0;
+    uint8_t legacyChecksum = 0;
+
     for (uint8_t i = 0; i < numActiveInputs; i++) {
         InputEEPROM eepromInput;
-        EEPROM.get(addr, eepromInput);
-        addr += EEPROM_INPUT_SIZE;
-
-        // Copy simple fields
-        inputs[i].pin = eepromInput.pin;
-        strncpy(inputs[i].abbrName, eepromInput.abbrName, sizeof(inputs[i].abbrName));
-        inputs[i].abbrName[sizeof(inputs[i].abbrName) - 1] = '\0';  // Ensure null termination
-        strncpy(inputs[i].displayName, eepromInput.displayName, sizeof(inputs[i].displayName));
-        inputs[i].displayName[sizeof(inputs[i].displayName) - 1] = '\0';  // Ensure null termination
-        inputs[i].minValue = eepromInput.minValue;
-        inputs[i].maxValue = eepromInput.maxValue;
-        inputs[i].obd2pid = eepromInput.obd2pid;
-        inputs[i].obd2length = eepromInput.obd2length;
-        inputs[i].calibrationType = (CalibrationType)eepromInput.calibrationType;
-        memcpy(&inputs[i].customCalibration, &eepromInput.customCalibration, sizeof(CalibrationOverride));
-
-        // Unpack flags from single byte
-        inputs[i].flags.isEnabled = (eepromInput.flagsByte & 0x01) != 0;
-        inputs[i].flags.alarm = (eepromInput.flagsByte & 0x02) != 0;
-        inputs[i].flags.display = (eepromInput.flagsByte & 0x04) != 0;
-        inputs[i].flags.useCustomCalibration = (eepromInput.flagsByte & 0x08) != 0;
-
-        // Output routing mask
-        inputs[i].outputMask = eepromInput.outputMask;
-
-        // Resolve hashes to current indices
-        inputs[i].applicationIndex = getApplicationIndexByHash(eepromInput.applicationHash);
-        inputs[i].sensorIndex = getSensorIndexByHash(eepromInput.sensorHash);
-        inputs[i].unitsIndex = getUnitsIndexByHash(eepromInput.unitsHash);
-
-        // Re-initialize function pointers and sensor-specific data
-        // (Function pointers can't be reliably stored in EEPROM)
-        const SensorInfo* flashInfo = getSensorByIndex(inputs[i].sensorIndex);
-        if (flashInfo) {
-            SensorInfo info;
-            loadSensorInfo(flashInfo, &info);
-            inputs[i].readFunction = info.readFunction;
-            inputs[i].measurementType = info.measurementType;
-            inputs[i].calibrationType = info.calibrationType;
+        if (migration) {
+            readLegacyInput(migration, addr, &eepromInput, &legacyChecksum);
+        } else {
+            eepromGet(addr, eepromInput);
+            calculatedCrc = crc32Update(calculatedCrc, &eepromInput, sizeof(InputEEPROM));
+        }
+        addr += recordSize;
 
-            // Restore preset calibration pointer if not using custom calibration
-            if (!inputs[i].flags.useCustomCalibration) {
-                inputs[i].presetCalibration = info.defaultCalibration;
-            }
+        unpackInput(&inputs[i], eepromInput);
 
-            // Call sensor-specific initialization function if it exists
-            if (info.initFunction) {
-                info.initFunction(&inputs[i]);
-            }
+        // Resolve hashes to current indices (cached indices first, scan on miss)
+        InputIndexCacheEntry cached = {0, 0, 0};
+        if (cacheUsable) {
+            eepromGet(cacheAddr, cached);
+            cacheAddr += sizeof(InputIndexCacheEntry);
+        }
+        if (cacheUsable && cachedApplicationValid(cached.applicationIndex, eepromInput.applicationHash)) {
+            inputs[i].applicationIndex = cached.applicationIndex;
+        } else {
+            inputs[i].applicationIndex = getApplicationIndexByHash(eepromInput.applicationHash);
+            if (inputs[i].applicationIndex != cached.applicationIndex) cacheDirty = cacheSupported;
+        }
+        if (cacheUsable && cachedSensorValid(cached.sensorIndex, eepromInput.sensorHash)) {
+            inputs[i].sensorIndex = cached.sensorIndex;
+        } else {
+            inputs[i].sensorIndex = getSensorIndexByHash(eepromInput.sensorHash);
+            if (inputs[i].sensorIndex != cached.sensorIndex) cacheDirty = cacheSupported;
+        }
+        if (cacheUsable && cachedUnitsValid(cached.unitsIndex, eepromInput.unitsHash)) {
+            inputs[i].unitsIndex = cached.unitsIndex;
+        } else {
+            inputs[i].unitsIndex = getUnitsIndexByHash(eepromInput.unitsHash);
+            if (inputs[i].unitsIndex != cached.unitsIndex) cacheDirty = cacheSupported;
         }
-    }
 
-    // Verify checksum
-    uint8_t storedChecksum = header.reserved;
-    uint8_t calculatedChecksum = calculateConfigChecksum();
+        storeInputDisplayName(&inputs[i], eepromInput.displayName);   // Needs applicationIndex
+        initLoadedInput(&inputs[i], eepromInput.alarmPersistMs);
+    }
 
-    if (storedChecksum != calculatedChecksum) {
-        msg.control.println(F("ERROR: EEPROM checksum mismatch! Configuration corrupted."));
+    // Verify CRC (old versions: their XOR checksum)
+    bool intact = migration ? (legacyChecksum == header.reserved) : (header.crc == calculatedCrc);
+    if (!intact) {
+        msg.control.println(F("ERROR: EEPROM CRC mismatch! Configuration corrupted."));
         msg.control.println(F("Please reconfigure inputs and run SAVE."));
-        msg.debug.error(TAG_CONFIG, "Checksum mismatch: Stored 0x%02X, Calculated 0x%02X", storedChecksum, calculatedChecksum);
+        if (migration) {
+            msg.debug.error(TAG_CONFIG, "v%d checksum mismatch: Stored 0x%02X, Calculated 0x%02X",
+                            header.version, header.reserved, legacyChecksum);
+        } else {
+            msg.debug.error(TAG_CONFIG, "CRC mismatch: Stored 0x%08lX, Calculated 0x%08lX",
+                            (unsigned long)header.crc, (unsigned long)calculatedCrc);
+        }
 
         // Clear corrupted data
         memset(inputs, 0, sizeof(inputs));
@@ -709,11 +1427,31 @@ bool loadInputConfig() {
             inputs[i].pin = 0xFF;
         }
         numActiveInputs = 0;
+        rebuildInputSchedule();
 
         return false;
     }
 
-    msg.debug.debug(TAG_CONFIG, "Checksum verified: 0x%02X", storedChecksum);
+    // First boot of a new build (or stale entries) - refresh the cache
+    if (cacheDirty) {
+        writeIndexCache(numActiveInputs);
+        msg.debug.debug(TAG_CONFIG, "Input index cache rebuilt for build %s", FW_GIT_HASH);
+    }
+
+    // Compiled against the loaded inputs by rebuildInputSchedule()
+    if (migration && header.version > 3) readLegacyAlarmRules(numActiveInputs, recordSize);
+    else if (migration) clearAlarmRules();
+    else readAlarmRules(numActiveInputs);
+
+    rebuildInputSchedule();
+
+    if (migration) {
+        msg.debug.info(TAG_CONFIG, "Input config migrated from v%d to v%d", header.version, EEPROM_VERSION);
+        saveInputConfig();
+        return true;
+    }
+
+    msg.debug.debug(TAG_CONFIG, "CRC verified: 0x%08lX", (unsigned long)header.crc);
     msg.debug.info(TAG_CONFIG, "Loaded %d inputs from EEPROM", numActiveInputs);
     return true;
 }
@@ -721,7 +1459,7 @@ bool loadInputConfig() {
 void resetInputConfig() {
     // Clear EEPROM header
     EEPROMHeader header = {0};
-    EEPROM.put(0, header);
+    eepromPut(0, header);
 
     // Clear inputs
     memset(inputs, 0, sizeof(inputs));
@@ -729,10 +1467,14 @@ void resetInputConfig() {
         inputs[i].pin = 0xFF;
     }
     numActiveInputs = 0;
+    clearAlarmRules();
+    rebuildInputSchedule();
 
     msg.control.println(F("Configuration reset"));
 }
 
+#endif // ENABLE_CONFIG_LOG
+
 #endif // USE_STATIC_CONFIG
 
 // ===== HELPER FUNCTIONS =====
@@ -742,13 +1484,9 @@ void resetInputConfig() {
  * @param pin  Pin number (use A0, A1, etc. for analog pins)
  * @return Pointer to Input struct, or nullptr if pin not configured
  */
-Input* getInputByPin(uint8_t pin) {
-    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
-        if (inputs[i].pin == pin) {
-            return &inputs[i];
-        }
-    }
-    return nullptr;
+Input* getInputByPin(InputPin pin) {
+    uint8_t slot = getInputIndex(pin);
+    return slot != 0xFF ? &inputs[slot] : nullptr;
 }
 
 /**
@@ -768,31 +1506,231 @@ Input* getInputByIndex(uint8_t index) {
  * Get the array index for a given pin number.
  * @param pin  Pin number to search for
  * @return Array index (0 to MAX_INPUTS-1), or 0xFF if not found
+ * @note  A configured pin is found through pinSlot[] in one step; only a
+ *        miss (or a pin that moved) walks the slots
  */
-uint8_t getInputIndex(uint8_t pin) {
+uint8_t getInputIndex(InputPin pin) {
+#if INPUT_PIN_WIDE
+    if (pin < PIN_SLOT_MAP_SIZE) {
+        uint8_t slot = pinSlot[pin];
+        if (slot < MAX_INPUTS && inputs[slot].pin == pin) return slot;
+    }
+#endif
     for (uint8_t i = 0; i < MAX_INPUTS; i++) {
         if (inputs[i].pin == pin) {
+#if INPUT_PIN_WIDE
+            if (pin < PIN_SLOT_MAP_SIZE) pinSlot[pin] = i;
+#endif
             return i;
         }
     }
     return 0xFF;  // Not found
 }
 
-/**
- * Find the first unused slot in the inputs array.
- * @return Array index of free slot, or 0xFF if array is full
- */
-static uint8_t findFreeSlot() {
-    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
-        if (inputs[i].pin == 0xFF) {
-            return i;
+// Encode the input's value into obd2data as its PID's scaled, big-endian
+// integer. Returns early when obd2length is 0 or longer than obd2data.
+void refreshOBD2Data(Input* input) {
+    uint8_t dataBytes = input->obd2length;
+    if (dataBytes == 0 || dataBytes > sizeof(input->obd2data)) return;  // Not encodable as a PID
+
+    if (isnan(input->value)) {
+        memset(input->obd2data, 0, sizeof(input->obd2data));  // Never sent - outputs skip NaN
+        return;
+    }
+
+    // Scale to the PID's integer form (sensor_types.h), rounded
+    ObdScale obd = getObdScale(input->measurementType);
+    float raw = input->value * obd.scale + obd.offset + 0.5f;
+
+    // Clamp to what the PID's bytes hold - past the range reads as the
+    // limit instead of wrapping around (e.g. 260 C as 4 C)
+    if (!(raw >= 0.0f)) raw = 0.0f;
+
+    // Encode data based on size (big-endian / MSB first)
+    if (dataBytes == 1) {
+        input->obd2data[0] = raw >= 255.0f ? 0xFF : (byte)raw;
+    } else if (dataBytes == 2) {
+        uint16_t value = raw >= 65535.0f ? 0xFFFF : (uint16_t)raw;
+        input->obd2data[0] = (value >> 8) & 0xFF;
+        input->obd2data[1] = value & 0xFF;
+    } else {
+        uint32_t limit = dataBytes == 3 ? 0xFFFFFFUL : 0xFFFFFFFFUL;
+        uint32_t value = raw >= (float)limit ? limit : (uint32_t)raw;
+        for (uint8_t i = 0; i < dataBytes; i++) {
+            uint8_t shift = (dataBytes - 1 - i) * 8;
+            input->obd2data[i] = shift < 32 ? (value >> shift) & 0xFF : 0;
         }
     }
-    return 0xFF;  // No free slots
 }
 
-/**
- * Validate input configuration
+void refreshInputUnits(Input* input) {
+    const UnitsInfo* info = getUnitsByIndex(input->unitsIndex);
+    if (info == nullptr) {
+        input->unitsFactor = 1.0;      // Unknown unit: base units, no symbol
+        input->unitsOffset = 0.0;
+    } else {
+        input->unitsFactor = pgm_read_float(&info->conversionFactor);
+        input->unitsOffset = pgm_read_float(&info->conversionOffset);
+    }
+    input->unitsSymbol = getUnitStringByIndex(input->unitsIndex);
+}
+
+uint8_t getInputLayoutVersion() {
+    return inputLayoutVersion;
+}
+
+// The sensor's minimum read interval, or the global default if it has none
+static uint16_t getScheduledReadInterval(const Input* input, uint16_t defaultInterval) {
+    const SensorInfo* sensorInfo = getSensorByIndex(input->sensorIndex);
+    uint16_t interval = sensorInfo ? pgm_read_word(&sensorInfo->minReadInterval) : 0;
+    return interval ? interval : defaultInterval;
+}
+
+/**
+ * Rebuild the read schedule from the current inputs[] state.
+ * Resolves each enabled input's read function and interval once so the
+ * main loop never touches PROGMEM or skips over empty slots.
+ * A sensor interval of 0 means "use the global sensor read interval".
+ * @note  Call after anything that changes which inputs are enabled, their
+ *        sensor, or their read function (e.g. test mode substitution)
+ */
+void rebuildInputSchedule() {
+    inputLayoutVersion++;           // Even mid-transaction - the inputs have changed
+    if (transactionActive && !transactionLive) return;  // Rebuilt once at COMMIT
+
+#ifdef USE_STATIC_CONFIG
+    uint16_t defaultInterval = SENSOR_READ_INTERVAL_MS;
+#else
+    uint16_t defaultInterval = systemConfig.sensorReadInterval;
+#endif
+    uint32_t now = millis();
+
+    numActiveSlots = 0;
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        if (inputs[i].pin != 0xFF && inputs[i].flags.isEnabled) activeSlots[numActiveSlots++] = i;
+    }
+
+    // Pins may have changed role - analog inputs re-register on their next read
+    resetAdcScan();
+    resetThermocoupleBatch();  // CS pins re-register on their next read
+#ifdef ENABLE_EXT_ADC
+    resetExtAdc();             // So do external ADC channels
+#endif
+    clearAdcLuts();
+    resetInputFilters();
+    resetInputRates();
+    resetInputSnapshot();
+    compileAlarmRules();  // Rules name pins - their inputs may be in other slots now
+#ifndef USE_STATIC_CONFIG
+    compileMathChannels();  // So do math channel expressions
+#endif
+    rebuildCANNodeTable();  // Channels announced to other nodes, NODE:n measurement types
+    bindInputStats();       // Accumulators follow their inputs' pins
+    resetModbusRegisters(); // Slots may hold other inputs now
+
+    // Math channels (MATH:n) after every other input, so a source's new
+    // reading reaches them in the same pass
+    numScheduledInputs = 0;
+    for (uint16_t n = 0; n < 2 * MAX_INPUTS; n++) {
+        bool mathPass = n >= MAX_INPUTS;
+        Input* input = &inputs[mathPass ? n - MAX_INPUTS : n];
+        if (!mathPass && input->pin != 0xFF) refreshInputUnits(input);  // Loaded or restored unitsIndex
+        if (input->pin == 0xFF || !input->flags.isEnabled || input->readFunction == nullptr ||
+            MATH_IS_PIN(input->pin) != mathPass) {
+            continue;
+        }
+        refreshOBD2Data(input);  // Sensor type or PID length may have changed
+
+        const SensorInfo* sensorInfo = getSensorByIndex(input->sensorIndex);
+        uint16_t interval = getScheduledReadInterval(input, defaultInterval);
+
+        InputSchedule* entry = &inputSchedule[numScheduledInputs++];
+        entry->input = input;
+        entry->readFunction = input->readFunction;
+        entry->startFunction = nullptr;
+        entry->completeFunction = nullptr;
+        if (sensorInfo) {
+            SensorInfo info;
+            loadSensorInfo(sensorInfo, &info);
+            // Not when the read is overridden (test mode) - that one runs as is
+            if (info.startFunction && info.completeFunction && info.readFunction == input->readFunction) {
+                entry->startFunction = info.startFunction;
+                entry->completeFunction = info.completeFunction;
+            }
+        }
+        entry->interval = interval;
+        entry->nextDue = getInputFirstReadTime(input, now);  // Next pass, or once warmed up
+        entry->readyAt = 0;
+
+        buildAdcLut(input);  // Counts-to-value table for resistive sensors
+    }
+
+#ifdef ENABLE_CAN
+    refreshCANInputSubscriptions();  // Keep configured CAN pairs resident in the frame cache
+    resetCANReadState();
+    rebuildOBD2PIDIndex();           // Requests see enabled/cleared inputs at once
+    rebuildCANBroadcastLayout();
+#endif
+}
+
+uint16_t setInputScheduleInterval(const Input* input, uint16_t interval) {
+#ifdef USE_STATIC_CONFIG
+    uint16_t defaultInterval = SENSOR_READ_INTERVAL_MS;
+#else
+    uint16_t defaultInterval = systemConfig.sensorReadInterval;
+#endif
+    for (uint8_t i = 0; i < numScheduledInputs; i++) {
+        InputSchedule* entry = &inputSchedule[i];
+        if (entry->input != input) continue;
+
+        // Only inputs read at the global default - a sensor minimum stands
+        const SensorInfo* sensorInfo = getSensorByIndex(input->sensorIndex);
+        bool sensorMinimum = sensorInfo && pgm_read_word(&sensorInfo->minReadInterval) != 0;
+        uint16_t base = getScheduledReadInterval(input, defaultInterval);
+        entry->interval = (interval == 0 || interval >= base || sensorMinimum) ? base : interval;
+
+        uint32_t soonest = millis() + entry->interval;
+        if ((int32_t)(entry->nextDue - soonest) > 0) entry->nextDue = soonest;
+        return entry->interval;
+    }
+    return 0;
+}
+
+void setInputWarmup(Input* input, uint16_t warmup_ms) {
+    uint8_t idx = input - inputs;
+    if (idx >= MAX_INPUTS) return;
+    inputReadyAt[idx] = millis() + warmup_ms;
+    if (inputReadyAt[idx] == 0) inputReadyAt[idx] = 1;  // 0 is reserved for "ready"
+}
+
+uint32_t getInputFirstReadTime(const Input* input, uint32_t now) {
+    uint8_t idx = input - inputs;
+    if (idx >= MAX_INPUTS || inputReadyAt[idx] == 0) return now;
+
+    // Pending warm-ups are at most 65535ms ahead - anything else has expired
+    uint32_t remaining = inputReadyAt[idx] - now;
+    if (remaining == 0 || remaining > 0xFFFFUL) {
+        inputReadyAt[idx] = 0;
+        return now;
+    }
+    return inputReadyAt[idx];
+}
+
+/**
+ * Find the first unused slot in the inputs array.
+ * @return Array index of free slot, or 0xFF if array is full
+ */
+static uint8_t findFreeSlot() {
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        if (inputs[i].pin == 0xFF) {
+            return i;
+        }
+    }
+    return 0xFF;  // No free slots
+}
+
+/**
+ * Validate input configuration
  * Checks for:
  * - Pin conflicts (duplicate pin assignments)
  * - Alarm threshold sanity (min < max)
@@ -802,8 +1740,8 @@ static bool validateInputConfig(Input* input) {
     if (!input) return false;
 
     // Check if pin is reserved by a bus (I2C, SPI, CAN)
-    // Skip this check for virtual pins (CAN 0xC0+, I2C 0xF0+)
-    if (input->pin < 0xC0 && !isPinAvailable(input->pin)) {
+    // Skip this check for virtual pins (NODE 0x80+, GPS 0xA0+, MATH 0xB0+, CAN 0xC0+, ADC 0xE0+, I2C 0xF0+)
+    if (input->pin < 0x80 && !isPinAvailable(input->pin)) {
         msg.control.print(F("ERROR: Pin "));
         if (input->pin >= A0) {
             msg.control.print(F("A"));
@@ -827,10 +1765,13 @@ static bool validateInputConfig(Input* input) {
         // Check if another enabled input uses the same pin
         if (other->flags.isEnabled && other->pin == input->pin) {
             msg.control.print(F("ERROR: Pin "));
-            if (input->pin >= 0xF0) {
-                msg.control.print(F("I2C"));
-            } else if (input->pin >= 0xC0 && input->pin < 0xE0) {
+            if (CAN_IS_PIN(input->pin)) {
                 msg.control.print(F("CAN"));
+            } else if (input->pin >= 0xF0) {
+                msg.control.print(F("I2C"));
+            } else if (EXT_ADC_IS_PIN(input->pin) || MATH_IS_PIN(input->pin) || GPS_IS_PIN(input->pin) ||
+                       NODE_IS_PIN(input->pin)) {
+                printPin(input->pin);
             } else if (input->pin >= A0) {
                 msg.control.print(F("A"));
                 msg.control.print(input->pin - A0);
@@ -858,7 +1799,7 @@ static bool validateInputConfig(Input* input) {
 }
 
 // ===== CONFIGURATION FUNCTIONS =====
-bool setInputApplication(uint8_t pin, uint8_t appIndex) {
+bool setInputApplication(InputPin pin, uint8_t appIndex) {
     // Find or create input
     Input* input = getInputByPin(pin);
     bool isNewInput = (input == nullptr);
@@ -887,6 +1828,14 @@ bool setInputApplication(uint8_t pin, uint8_t appIndex) {
     ApplicationPreset preset;
     loadApplicationPreset(flashPreset, &preset);
 
+    // A GPS input is a speed or an altitude
+    if (GPS_IS_PIN(pin) && preset.expectedMeasurementType != MEASURE_SPEED &&
+        preset.expectedMeasurementType != MEASURE_ELEVATION) {
+        msg.control.println(F("ERROR: GPS:n inputs measure SPEED or ELEVATION"));
+        if (isNewInput) input->pin = 0xFF;
+        return false;
+    }
+
     // Apply preset to input
     input->applicationIndex = appIndex;
 
@@ -895,17 +1844,24 @@ bool setInputApplication(uint8_t pin, uint8_t appIndex) {
     strncpy_P(input->abbrName, preset.abbreviation, sizeof(input->abbrName) - 1);
     input->abbrName[sizeof(input->abbrName) - 1] = '\0';
 
-    if (preset.label) {
-        strncpy_P(input->displayName, preset.label, sizeof(input->displayName) - 1);
-    } else {
-        strncpy_P(input->displayName, preset.name, sizeof(input->displayName) - 1);
-    }
-    input->displayName[sizeof(input->displayName) - 1] = '\0';
+    input->displayNameSlot = 0;     // Display name: the preset's label (or name)
 
     // Don't set sensorIndex yet - let setInputSensor() do it
     // (This allows sensorChanged check to work correctly)
     uint8_t defaultSensor = preset.defaultSensor;
+#ifndef USE_STATIC_CONFIG
+    // A math channel keeps its MATH sensor - the application gives units, alarms and OBD
+    if (MATH_IS_PIN(pin)) defaultSensor = getSensorIndexByName("MATH");
+    // A GPS input takes the GPS field its application measures
+    if (GPS_IS_PIN(pin)) {
+        defaultSensor = getSensorIndexByName(preset.expectedMeasurementType == MEASURE_ELEVATION
+                                             ? "GPS_ALTITUDE" : "GPS_SPEED");
+    }
+    // Likewise a node channel keeps its NODE sensor
+    if (NODE_IS_PIN(pin)) defaultSensor = getSensorIndexByName("NODE");
+#endif
     input->unitsIndex = preset.defaultUnits;
+    refreshInputUnits(input);
 
     // CRITICAL: Store min/max in STANDARD UNITS (no conversion!)
     // Preset already has values in Celsius, bar, volts, etc.
@@ -919,6 +1875,19 @@ bool setInputApplication(uint8_t pin, uint8_t appIndex) {
     input->flags.isEnabled = true;
     input->flags.useCustomCalibration = false;  // Use preset calibration
     input->outputMask = OUTPUT_MASK_ALL_DATA;   // All data outputs enabled by default
+    input->filterType = FILTER_NONE;            // Raw readings until SET <pin> FILTER
+    input->filterParam = 0;
+    input->rateMaxInterval = 0;                 // Fixed rate until SET <pin> RATE
+    input->rateBand = 0;
+    input->trendRate = 0;                       // No trend alarm until SET <pin> ALARM TREND
+    input->trendWindow = 0;
+    input->warnMin = NAN;                       // Warnings at WARNING_THRESHOLD_PERCENT until SET <pin> ALARM WARN
+    input->warnMax = NAN;
+    input->alarmHysteresis = 0;                 // No exit band, no timers past the preset persistence
+    input->warnHysteresis = 0;
+    input->alarmClearMs = 0;
+    input->warnPersistMs = 0;
+    input->warnClearMs = 0;
 
     // Initialize alarm context from preset
     initInputAlarmContext(input, millis(), preset.warmupTime_ms, preset.persistTime_ms);
@@ -928,8 +1897,8 @@ bool setInputApplication(uint8_t pin, uint8_t appIndex) {
         numActiveInputs++;
     }
 
-    // Validate configuration before finalizing
-    if (!validateInputConfig(input)) {
+    // Validate configuration before finalizing (a transaction validates at COMMIT)
+    if ((!transactionActive || transactionLive) && !validateInputConfig(input)) {
         // Validation failed - revert changes
         if (isNewInput) {
             input->pin = 0xFF;  // Mark as free
@@ -943,7 +1912,7 @@ bool setInputApplication(uint8_t pin, uint8_t appIndex) {
     return setInputSensor(pin, defaultSensor);
 }
 
-bool setInputSensor(uint8_t pin, uint8_t sensorIndex) {
+bool setInputSensor(InputPin pin, uint8_t sensorIndex) {
     Input* input = getInputByPin(pin);
     if (input == nullptr) {
         msg.control.println(F("ERROR: Input not configured"));
@@ -961,6 +1930,28 @@ bool setInputSensor(uint8_t pin, uint8_t sensorIndex) {
     SensorInfo info;
     loadSensorInfo(flashInfo, &info);
 
+    // MATH:n pins take the MATH sensor and nothing else does
+    if (MATH_IS_PIN(pin) != (info.calibrationType == CAL_MATH_CHANNEL)) {
+        msg.control.println(MATH_IS_PIN(pin) ? F("ERROR: MATH:n inputs use the MATH sensor")
+                                             : F("ERROR: MATH sensor is for MATH:n inputs only"));
+        return false;
+    }
+
+    // Likewise GPS:n pins and the GPS sensors
+    bool gpsSensor = info.readFunction == readGpsSpeed || info.readFunction == readGpsAltitude;
+    if (GPS_IS_PIN(pin) != gpsSensor) {
+        msg.control.println(GPS_IS_PIN(pin) ? F("ERROR: GPS:n inputs use GPS_SPEED or GPS_ALTITUDE")
+                                            : F("ERROR: GPS sensors are for GPS:n inputs only"));
+        return false;
+    }
+
+    // And NODE:n pins and the NODE sensor
+    if (NODE_IS_PIN(pin) != (info.calibrationType == CAL_NODE_CHANNEL)) {
+        msg.control.println(NODE_IS_PIN(pin) ? F("ERROR: NODE:n inputs use the NODE sensor")
+                                             : F("ERROR: NODE sensor is for NODE:n inputs only"));
+        return false;
+    }
+
     // Check if sensor is actually changing (to avoid redundant init)
     bool sensorChanged = (input->sensorIndex != sensorIndex);
 
@@ -976,14 +1967,23 @@ bool setInputSensor(uint8_t pin, uint8_t sensorIndex) {
 
     // Call sensor-specific initialization function only if sensor changed
     // (Prevents duplicate init when setting same sensor twice)
-    if (sensorChanged && info.initFunction) {
-        info.initFunction(input);
+    if (sensorChanged) {
+        if (PIN_IS_NARROW(pin)) {
+            releaseFreqCapture(pin);  // Pulse and switch sensors re-claim their channel in init
+            releaseStateCapture(pin);
+        }
+        resetInputHealth(input);
+        resetInputSummary(input);
+        if (info.initFunction) {
+            info.initFunction(input);
+        }
     }
 
+    rebuildInputSchedule();
     return true;
 }
 
-bool setInputName(uint8_t pin, const char* name) {
+bool setInputName(InputPin pin, const char* name) {
     Input* input = getInputByPin(pin);
     if (input == nullptr) return false;
 
@@ -992,24 +1992,85 @@ bool setInputName(uint8_t pin, const char* name) {
     return true;
 }
 
-bool setInputDisplayName(uint8_t pin, const char* displayName) {
+bool setInputDisplayName(InputPin pin, const char* displayName) {
     Input* input = getInputByPin(pin);
     if (input == nullptr) return false;
 
-    strncpy(input->displayName, displayName, sizeof(input->displayName) - 1);
-    input->displayName[sizeof(input->displayName) - 1] = '\0';
+    return storeInputDisplayName(input, displayName);
+}
+
+// ===== DISPLAY NAMES =====
+
+// The application preset's display string in PROGMEM (label, else name)
+static const char* presetDisplayName(const Input* input) {
+    const ApplicationPreset* preset = getApplicationByIndex(input->applicationIndex);
+    if (preset == nullptr) return nullptr;
+    const char* label = (const char*)pgm_read_ptr(&preset->label);
+    return label ? label : (const char*)pgm_read_ptr(&preset->name);
+}
+
+// Pool slot (1-based) referred to by an input other than except - or kept for ROLLBACK
+static bool displayNameSlotInUse(uint8_t slot, const Input* except) {
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        if (&inputs[i] != except && inputs[i].displayNameSlot == slot) return true;
+    }
+#if !defined(USE_STATIC_CONFIG) && CONFIG_TRANSACTIONS
+    if (transactionActive) {
+        for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+            if (transactionSaved[i].displayNameSlot == slot) return true;
+        }
+    }
+#endif
+    return false;
+}
+
+bool storeInputDisplayName(Input* input, const char* displayName) {
+    const char* preset = presetDisplayName(input);
+    if (displayName[0] == '\0' || (preset && strncmp_P(displayName, preset, INPUT_DISPLAY_NAME_LEN - 1) == 0)) {
+        input->displayNameSlot = 0;                 // The preset's own - nothing to keep
+        return true;
+    }
+
+    uint8_t slot = input->displayNameSlot;
+    if (slot == 0 || displayNameSlotInUse(slot, input)) {
+        for (slot = 1; slot <= INPUT_NAME_POOL_SLOTS && displayNameSlotInUse(slot, input); slot++) {
+        }
+        if (slot > INPUT_NAME_POOL_SLOTS) {
+            msg.control.println(F("ERROR: No room for another custom display name (INPUT_NAME_POOL_SLOTS)"));
+            return false;
+        }
+    }
+
+    char* name = displayNamePool[slot - 1];
+    strncpy(name, displayName, INPUT_DISPLAY_NAME_LEN - 1);
+    name[INPUT_DISPLAY_NAME_LEN - 1] = '\0';
+    input->displayNameSlot = slot;
     return true;
 }
 
-bool setInputUnits(uint8_t pin, uint8_t unitsIndex) {
+const char* getInputDisplayName(const Input* input, char* buf) {
+    if (input->displayNameSlot) return displayNamePool[input->displayNameSlot - 1];
+
+    const char* preset = presetDisplayName(input);
+    if (preset) {
+        strncpy_P(buf, preset, INPUT_DISPLAY_NAME_LEN - 1);
+        buf[INPUT_DISPLAY_NAME_LEN - 1] = '\0';
+    } else {
+        buf[0] = '\0';
+    }
+    return buf;
+}
+
+bool setInputUnits(InputPin pin, uint8_t unitsIndex) {
     Input* input = getInputByPin(pin);
     if (input == nullptr) return false;
 
     input->unitsIndex = unitsIndex;
+    refreshInputUnits(input);
     return true;
 }
 
-bool setInputAlarmRange(uint8_t pin, float minValue, float maxValue) {
+bool setInputAlarmRange(InputPin pin, float minValue, float maxValue) {
     Input* input = getInputByPin(pin);
     if (input == nullptr) return false;
 
@@ -1054,24 +2115,29 @@ bool setInputAlarmRange(uint8_t pin, float minValue, float maxValue) {
     return true;
 }
 
-bool setInputOBD(uint8_t pin, uint8_t pid, uint8_t length) {
+bool setInputOBD(InputPin pin, uint8_t pid, uint8_t length) {
     Input* input = getInputByPin(pin);
     if (input == nullptr) return false;
 
     input->obd2pid = pid;
     input->obd2length = length;
+    refreshOBD2Data(input);
+#ifdef ENABLE_CAN
+    rebuildOBD2PIDIndex();
+#endif
     return true;
 }
 
-bool enableInput(uint8_t pin, bool enable) {
+bool enableInput(InputPin pin, bool enable) {
     Input* input = getInputByPin(pin);
     if (input == nullptr) return false;
 
     input->flags.isEnabled = enable;
+    rebuildInputSchedule();
     return true;
 }
 
-bool enableInputAlarm(uint8_t pin, bool enable) {
+bool enableInputAlarm(InputPin pin, bool enable) {
     Input* input = getInputByPin(pin);
     if (input == nullptr) return false;
 
@@ -1079,15 +2145,16 @@ bool enableInputAlarm(uint8_t pin, bool enable) {
     return true;
 }
 
-bool enableInputDisplay(uint8_t pin, bool enable) {
+bool enableInputDisplay(InputPin pin, bool enable) {
     Input* input = getInputByPin(pin);
     if (input == nullptr) return false;
 
     input->flags.display = enable;
+    inputLayoutVersion++;
     return true;
 }
 
-bool setInputAlarmWarmup(uint8_t pin, uint16_t warmupTime_ms) {
+bool setInputAlarmWarmup(InputPin pin, uint16_t warmupTime_ms) {
     Input* input = getInputByPin(pin);
     if (input == nullptr) return false;
 
@@ -1095,7 +2162,7 @@ bool setInputAlarmWarmup(uint8_t pin, uint16_t warmupTime_ms) {
     return true;
 }
 
-bool setInputAlarmPersist(uint8_t pin, uint16_t persistTime_ms) {
+bool setInputAlarmPersist(InputPin pin, uint16_t persistTime_ms) {
     Input* input = getInputByPin(pin);
     if (input == nullptr) return false;
 
@@ -1103,24 +2170,35 @@ bool setInputAlarmPersist(uint8_t pin, uint16_t persistTime_ms) {
     return true;
 }
 
-bool setInputOutputMask(uint8_t pin, uint8_t outputId, bool enable) {
+bool setInputOutputMask(InputPin pin, uint8_t outputId, bool enable) {
     Input* input = getInputByPin(pin);
     if (input == nullptr) return false;
 
-    if (outputId > OUTPUT_SD) return false;  // Only data outputs (0-3)
+    if (outputId >= NUM_DATA_OUTPUTS && outputId != OUTPUT_CAN_MIRROR) return false;  // Only data outputs (0-4) and the CAN mirror
 
     if (enable) {
         input->outputMask |= (1 << outputId);
     } else {
         input->outputMask &= ~(1 << outputId);
     }
+#ifdef ENABLE_CAN
+    if (outputId == OUTPUT_CAN || outputId == OUTPUT_CAN_MIRROR) {
+        rebuildCANBroadcastLayout();  // CAN routing decides the packed signals
+    }
+#endif
     return true;
 }
 
-bool clearInput(uint8_t pin) {
+bool clearInput(InputPin pin) {
     Input* input = getInputByPin(pin);
     if (input == nullptr) return false;
 
+    if (PIN_IS_NARROW(pin)) {
+        releaseFreqCapture(pin);
+        releaseStateCapture(pin);
+    }
+    resetInputHealth(input);
+    resetInputSummary(input);
     memset(input, 0, sizeof(Input));
     input->pin = 0xFF;
 
@@ -1132,11 +2210,168 @@ bool clearInput(uint8_t pin) {
         }
     }
 
+    rebuildInputSchedule();
+    return true;
+}
+
+// ===== CONFIG TRANSACTIONS =====
+#if !defined(USE_STATIC_CONFIG) && CONFIG_TRANSACTIONS
+
+bool isInputTransactionActive() {
+    return transactionActive;
+}
+
+bool beginInputTransaction(bool live) {
+    if (transactionActive) return false;
+    memcpy(transactionSaved, inputs, sizeof(inputs));
+    transactionSavedActive = numActiveInputs;
+    transactionActive = true;
+    transactionLive = live;
+    if (!live) {
+        numScheduledInputs = 0;     // No reads of half-configured inputs
+        numActiveSlots = 0;         // Nor sends
+    }
+    return true;
+}
+
+// Put inputs[] back as they were at BEGIN; sensors that changed are re-initialized
+static void restoreTransactionInputs() {
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        Input* input = &inputs[i];
+        const Input* saved = &transactionSaved[i];
+        bool changed = input->pin != saved->pin || input->sensorIndex != saved->sensorIndex;
+        if (changed && input->pin != 0xFF && PIN_IS_NARROW(input->pin)) {
+            releaseFreqCapture(input->pin);
+            releaseStateCapture(input->pin);
+        }
+
+        memcpy(input, saved, sizeof(Input));
+        if (!changed || input->pin == 0xFF) continue;
+
+        resetInputHealth(input);
+        resetInputSummary(input);
+        const SensorInfo* flashInfo = getSensorByIndex(input->sensorIndex);
+        if (flashInfo) {
+            SensorInfo info;
+            loadSensorInfo(flashInfo, &info);
+            if (info.initFunction) info.initFunction(input);
+        }
+    }
+    numActiveInputs = transactionSavedActive;
+}
+
+bool commitInputTransaction() {
+    if (!transactionActive) return false;
+
+    // Every enabled input against every other and the buses, once
+    bool valid = true;
+    for (uint8_t i = 0; i < MAX_INPUTS && valid; i++) {
+        if (inputs[i].pin != 0xFF && inputs[i].flags.isEnabled) {
+            valid = validateInputConfig(&inputs[i]);
+        }
+    }
+    if (!valid) restoreTransactionInputs();
+
+    transactionActive = false;
+    transactionLive = false;
+    rebuildInputSchedule();
+    return valid;
+}
+
+bool rollbackInputTransaction() {
+    if (!transactionActive) return false;
+    restoreTransactionInputs();
+    transactionActive = false;
+    transactionLive = false;
+    rebuildInputSchedule();
+    return true;
+}
+
+#elif !defined(USE_STATIC_CONFIG)
+
+bool isInputTransactionActive() { return false; }
+bool beginInputTransaction(bool live) { (void)live; return false; }
+bool commitInputTransaction() { return false; }
+bool rollbackInputTransaction() { return false; }
+
+#endif
+
+bool setInputFilter(InputPin pin, uint8_t filterType, uint16_t filterParam) {
+    Input* input = getInputByPin(pin);
+    if (input == nullptr) return false;
+    if (!isValidInputFilter(filterType, filterParam)) return false;
+
+    input->filterType = filterType;
+    input->filterParam = (filterType == FILTER_NONE) ? 0 : filterParam;
+    resetInputFilter(input);
+    return true;
+}
+
+bool setInputRate(InputPin pin, uint16_t maxInterval, uint16_t band) {
+    Input* input = getInputByPin(pin);
+    if (input == nullptr) return false;
+    if (!isValidInputRate(maxInterval, band)) return false;
+
+    input->rateMaxInterval = maxInterval;
+    input->rateBand = (maxInterval == 0) ? 0 : band;
+    resetInputRate(input);
+    return true;
+}
+
+bool isValidAlarmHysteresis(float band) {
+    return !isnan(band) && !isinf(band) && band >= 0;
+}
+
+bool setInputWarnRange(InputPin pin, float minValue, float maxValue) {
+    Input* input = getInputByPin(pin);
+    if (input == nullptr) return false;
+    if (isinf(minValue) || isinf(maxValue)) return false;
+
+    input->warnMin = minValue;
+    input->warnMax = maxValue;
+    return true;
+}
+
+bool setInputAlarmHysteresis(InputPin pin, float alarmBand, float warnBand) {
+    Input* input = getInputByPin(pin);
+    if (input == nullptr) return false;
+    if (!isValidAlarmHysteresis(alarmBand) || !isValidAlarmHysteresis(warnBand)) return false;
+
+    input->alarmHysteresis = alarmBand;
+    input->warnHysteresis = warnBand;
+    return true;
+}
+
+bool setInputAlarmClear(InputPin pin, uint16_t clearMs) {
+    Input* input = getInputByPin(pin);
+    if (input == nullptr) return false;
+
+    input->alarmClearMs = clearMs;
+    return true;
+}
+
+bool setInputWarnTimers(InputPin pin, uint16_t persistMs, uint16_t clearMs) {
+    Input* input = getInputByPin(pin);
+    if (input == nullptr) return false;
+
+    input->warnPersistMs = persistMs;
+    input->warnClearMs = clearMs;
+    return true;
+}
+
+bool setInputAlarmTrend(InputPin pin, float rate, uint16_t windowMs) {
+    Input* input = getInputByPin(pin);
+    if (input == nullptr) return false;
+    if (isnan(rate) || isinf(rate)) return false;
+
+    input->trendRate = rate;
+    input->trendWindow = (rate == 0) ? 0 : windowMs;
+    resetInputTrend(input);
     return true;
 }
 
 // ===== CALIBRATION OVERRIDE FUNCTIONS =====
-bool setInputCalibrationSteinhart(uint8_t pin, float bias, float a, float b, float c) {
+bool setInputCalibrationSteinhart(InputPin pin, float bias, float a, float b, float c) {
     Input* input = getInputByPin(pin);
     if (input == nullptr) return false;
 
@@ -1146,20 +2381,22 @@ bool setInputCalibrationSteinhart(uint8_t pin, float bias, float a, float b, flo
     input->customCalibration.steinhart.steinhart_b = b;
     input->customCalibration.steinhart.steinhart_c = c;
 
+    buildAdcLut(input);  // Table was built from the old calibration
     return true;
 }
 
-bool setInputCalibrationLookup(uint8_t pin, float bias) {
+bool setInputCalibrationLookup(InputPin pin, float bias) {
     Input* input = getInputByPin(pin);
     if (input == nullptr) return false;
 
     input->flags.useCustomCalibration = true;
     input->customCalibration.lookup.bias_resistor = bias;
 
+    buildAdcLut(input);  // Table was built from the old calibration
     return true;
 }
 
-bool setInputCalibrationPressureLinear(uint8_t pin, float vMin, float vMax, float pMin, float pMax) {
+bool setInputCalibrationPressureLinear(InputPin pin, float vMin, float vMax, float pMin, float pMax) {
     Input* input = getInputByPin(pin);
     if (input == nullptr) return false;
 
@@ -1169,10 +2406,11 @@ bool setInputCalibrationPressureLinear(uint8_t pin, float vMin, float vMax, floa
     input->customCalibration.pressureLinear.output_min = pMin;
     input->customCalibration.pressureLinear.output_max = pMax;
 
+    buildAdcLut(input);  // Table was built from the old calibration
     return true;
 }
 
-bool setInputCalibrationPressurePolynomial(uint8_t pin, float bias, float a, float b, float c) {
+bool setInputCalibrationPressurePolynomial(InputPin pin, float bias, float a, float b, float c) {
     Input* input = getInputByPin(pin);
     if (input == nullptr) return false;
 
@@ -1182,16 +2420,18 @@ bool setInputCalibrationPressurePolynomial(uint8_t pin, float bias, float a, flo
     input->customCalibration.pressurePolynomial.poly_b = b;
     input->customCalibration.pressurePolynomial.poly_c = c;
 
+    buildAdcLut(input);  // Table was built from the old calibration
     return true;
 }
 
-bool clearInputCalibration(uint8_t pin) {
+bool clearInputCalibration(InputPin pin) {
     Input* input = getInputByPin(pin);
     if (input == nullptr) return false;
 
     input->flags.useCustomCalibration = false;
     memset(&input->customCalibration, 0, sizeof(CalibrationOverride));
 
+    buildAdcLut(input);  // Table was built from the old calibration
     return true;
 }
 
@@ -1221,14 +2461,26 @@ static void printAlarmState(AlarmState state) {
     }
 }
 
-// Helper to print pin name (A0, 1, I2C:0, CAN:0, etc)
-static void printPin(uint8_t pin) {
-    if (pin >= 0xF0) {
+// Helper to print pin name (A0, 1, I2C:0, CAN:0, ADC:0, MATH:0, GPS:0, NODE:0, etc)
+void printPin(InputPin pin) {
+    if (CAN_IS_PIN(pin)) {
+        msg.control.print(F("CAN:"));
+        msg.control.print(CAN_PIN_CHANNEL(pin));
+    } else if (pin >= 0xF0) {
         msg.control.print(F("I2C:"));
         msg.control.print(pin - 0xF0);
-    } else if (pin >= 0xC0 && pin < 0xE0) {
-        msg.control.print(F("CAN:"));
-        msg.control.print(pin - 0xC0);
+    } else if (EXT_ADC_IS_PIN(pin)) {
+        msg.control.print(F("ADC:"));
+        msg.control.print(pin - EXT_ADC_PIN(0));
+    } else if (MATH_IS_PIN(pin)) {
+        msg.control.print(F("MATH:"));
+        msg.control.print(pin - MATH_PIN(0));
+    } else if (GPS_IS_PIN(pin)) {
+        msg.control.print(F("GPS:"));
+        msg.control.print(pin - GPS_PIN(0));
+    } else if (NODE_IS_PIN(pin)) {
+        msg.control.print(F("NODE:"));
+        msg.control.print(pin - NODE_PIN(0));
     } else if (pin >= A0) {
         msg.control.print(F("A"));
         msg.control.print(pin - A0);
@@ -1237,7 +2489,7 @@ static void printPin(uint8_t pin) {
     }
 }
 
-void printInputInfo(uint8_t pin) {
+void printInputInfo(InputPin pin) {
     Input* input = getInputByPin(pin);
     if (!input) {
         msg.control.print(F("ERROR: Input for pin "));
@@ -1261,8 +2513,22 @@ void printInputInfo(uint8_t pin) {
     msg.control.print(F("  Sensor: "));
     msg.control.println(getSensorNameByIndex(input->sensorIndex));
 
+    if (input->calibrationType == CAL_MATH_CHANNEL) {
+        msg.control.print(F("  Expression: "));
+        printMathExpression(input);
+        msg.control.println();
+    }
+    if (input->calibrationType == CAL_NODE_CHANNEL && input->flags.useCustomCalibration) {
+        msg.control.print(F("  Source: node "));
+        msg.control.print(input->customCalibration.node.node);
+        msg.control.print(F(", pin "));
+        printPin(input->customCalibration.node.remote_pin);
+        msg.control.println();
+    }
+
+    char name[INPUT_DISPLAY_NAME_LEN];
     msg.control.print(F("  Display Name: '"));
-    msg.control.print(input->displayName);
+    msg.control.print(getInputDisplayName(input, name));
     msg.control.println(F("'"));
 
     msg.control.print(F("  Short Name: '"));
@@ -1280,19 +2546,73 @@ void printInputInfo(uint8_t pin) {
     if (input->outputMask < 0x10) msg.control.print('0');
     msg.control.println(input->outputMask, HEX);
 
+    msg.control.print(F("  Filter: "));
+    printInputFilter(input);
+    msg.control.println();
+
+    msg.control.print(F("  Read Rate: "));
+    printInputRate(input);
+    msg.control.println();
+
+    msg.control.print(F("  Trend Alarm: "));
+    printInputTrend(input);
+    msg.control.println();
+
     msg.control.print(F("  Current Value: "));
     msg.control.print(input->value, 2);
     msg.control.print(F(" "));
     msg.control.println(getUnitStringByIndex(input->unitsIndex));
 
+    StateCaptureSample state;
+    if (PIN_IS_NARROW(pin) && getStateCapture(pin, &state)) {
+        msg.control.print(F("  Pin State: "));
+        msg.control.print(state.level ? F("HIGH") : F("LOW"));
+        msg.control.print(F(" for "));
+        msg.control.print(state.inStateMs / 1000.0, 1);
+        msg.control.print(F(" s, HIGH "));
+        msg.control.print(state.dutyHigh * 100.0, 0);
+        msg.control.print(F("% of the last "));
+        msg.control.print(state.windowMs / 1000.0, 1);
+        msg.control.print(F(" s, "));
+        msg.control.print(state.edges);
+        msg.control.println(F(" edges"));
+    }
+
+    const InputHealth* health = getInputHealth(input);
+    if (health) {
+        msg.control.print(F("  Health: "));
+        msg.control.print(health->consecutiveFails);
+        msg.control.print(F(" consecutive / "));
+        msg.control.print(health->totalFails);
+        msg.control.print(F(" total failures, last "));
+        msg.control.println(getInputFaultName(health->lastReason));
+    }
+
+    const InputSummary* summary = getInputSummary(input);
+    if (summary && summary->session.count > 0) {
+        msg.control.print(F("  Session: "));
+        msg.control.print(summary->session.min * input->unitsFactor + input->unitsOffset, 2);
+        msg.control.print(F(" / "));
+        msg.control.print(summary->session.mean * input->unitsFactor + input->unitsOffset, 2);
+        msg.control.print(F(" / "));
+        msg.control.print(summary->session.max * input->unitsFactor + input->unitsOffset, 2);
+        msg.control.print(' ');
+        msg.control.print((const __FlashStringHelper*)input->unitsSymbol);
+        msg.control.println(F(" (min / mean / max)"));
+    }
+
     msg.control.println();
     msg.control.println(F("To see alarm config:  INFO <pin> ALARM"));
     msg.control.println(F("To see calibration:   INFO <pin> CALIBRATION"));
     msg.control.println(F("To see output routing: INFO <pin> OUTPUT"));
+    msg.control.println(F("To see read health:   INFO <pin> HEALTH"));
+#if INPUT_SUMMARY
+    msg.control.println(F("To see statistics:    INFO <pin> SUMMARY"));
+#endif
     msg.control.println();
 }
 
-void printInputAlarmInfo(uint8_t pin) {
+void printInputAlarmInfo(InputPin pin) {
     Input* input = getInputByPin(pin);
     if (!input) {
         msg.control.print(F("ERROR: Input for pin "));
@@ -1318,6 +2638,20 @@ void printInputAlarmInfo(uint8_t pin) {
     msg.control.println(input->minValue, 2);
     msg.control.print(F("  Max Threshold: "));
     msg.control.println(input->maxValue, 2);
+    msg.control.print(F("  Warning Range: "));
+    if (isnan(input->warnMin) && isnan(input->warnMax)) {
+        msg.control.print(WARNING_THRESHOLD_PERCENT);
+        msg.control.println(F("% of the alarm range"));
+    } else {
+        msg.control.print(input->warnMin, 2);
+        msg.control.print(F(" - "));
+        msg.control.println(input->warnMax, 2);
+    }
+    msg.control.print(F("  Hysteresis: "));
+    msg.control.print(input->alarmHysteresis, 2);
+    msg.control.print(F(" (alarm), "));
+    msg.control.print(input->warnHysteresis, 2);
+    msg.control.println(F(" (warning)"));
 
     msg.control.print(F("  Warmup Time: "));
     msg.control.print(input->alarmContext.warmupTime_ms);
@@ -1325,17 +2659,27 @@ void printInputAlarmInfo(uint8_t pin) {
 
     msg.control.print(F("  Persistence Time: "));
     msg.control.print(input->alarmContext.persistTime_ms);
+    msg.control.print(F(" ms, clear "));
+    msg.control.print(input->alarmClearMs);
+    msg.control.println(F(" ms"));
+    msg.control.print(F("  Warning Persist: "));
+    msg.control.print(input->warnPersistMs);
+    msg.control.print(F(" ms, clear "));
+    msg.control.print(input->warnClearMs);
     msg.control.println(F(" ms"));
 
+    msg.control.print(F("  Trend: "));
+    printInputTrend(input);
+    msg.control.println();
+
     msg.control.print(F("  Time in State: "));
-    extern unsigned long millis(void);
     msg.control.print(millis() - input->alarmContext.stateEntryTime);
     msg.control.println(F(" ms"));
 
     msg.control.println();
 }
 
-void printInputOutputInfo(uint8_t pin) {
+void printInputOutputInfo(InputPin pin) {
     Input* input = getInputByPin(pin);
     if (!input) {
         msg.control.print(F("ERROR: Input for pin "));
@@ -1352,17 +2696,65 @@ void printInputOutputInfo(uint8_t pin) {
 
     msg.control.print(F("  CAN:      "));
     msg.control.println((input->outputMask & (1 << OUTPUT_CAN)) ? F("ENABLED") : F("DISABLED"));
+    msg.control.print(F("  CAN_Mirror: "));
+    msg.control.println((input->outputMask & (1 << OUTPUT_CAN_MIRROR)) ? F("ENABLED") : F("DISABLED"));
     msg.control.print(F("  RealDash: "));
     msg.control.println((input->outputMask & (1 << OUTPUT_REALDASH)) ? F("ENABLED") : F("DISABLED"));
     msg.control.print(F("  Serial:   "));
     msg.control.println((input->outputMask & (1 << OUTPUT_SERIAL)) ? F("ENABLED") : F("DISABLED"));
     msg.control.print(F("  SD_Log:   "));
     msg.control.println((input->outputMask & (1 << OUTPUT_SD)) ? F("ENABLED") : F("DISABLED"));
+    msg.control.print(F("  MQTT:     "));
+    msg.control.println((input->outputMask & (1 << OUTPUT_MQTT)) ? F("ENABLED") : F("DISABLED"));
 
     msg.control.println();
 }
 
-void printInputCalibration(uint8_t pin) {
+void printInputHealthInfo(InputPin pin) {
+    Input* input = getInputByPin(pin);
+    if (!input) {
+        msg.control.print(F("ERROR: Input for pin "));
+        printPin(pin);
+        msg.control.println(F(" not found"));
+        return;
+    }
+
+    msg.control.println();
+    msg.control.print(F("===== Read Health ["));
+    printPin(pin);
+    msg.control.print(F("] ====="));
+    msg.control.println();
+
+    printInputHealth(input);
+
+    msg.control.println();
+}
+
+void printInputSummaryInfo(InputPin pin) {
+    Input* input = getInputByPin(pin);
+    if (!input) {
+        msg.control.print(F("ERROR: Input for pin "));
+        printPin(pin);
+        msg.control.println(F(" not found"));
+        return;
+    }
+
+    msg.control.println();
+    msg.control.print(F("===== Statistics ["));
+    printPin(pin);
+    msg.control.print(F("] ====="));
+    msg.control.println();
+
+#if INPUT_SUMMARY
+    printInputSummary(input);
+#else
+    msg.control.println(F("  Not kept in this build (INPUT_SUMMARY=0)"));
+#endif
+
+    msg.control.println();
+}
+
+void printInputCalibration(InputPin pin) {
     Input* input = getInputByPin(pin);
     if (!input) {
         msg.control.print(F("ERROR: Input for pin "));
@@ -1458,232 +2850,280 @@ void printInputCalibration(uint8_t pin) {
         msg.control.print(F("  Max Speed: "));
         msg.control.print(input->customCalibration.speed.max_speed_kph);
         msg.control.println(F(" km/h"));
+    } else if (input->calibrationType == CAL_MATH_CHANNEL) {
+        msg.control.println(F("Math Channel"));
+        msg.control.print(F("  Expression: "));
+        printMathExpression(input);
+        msg.control.println();
+    } else if (input->calibrationType == CAL_NODE_CHANNEL) {
+        msg.control.println(F("Node Channel"));
+        msg.control.print(F("  Source: node "));
+        msg.control.print(input->customCalibration.node.node);
+        msg.control.print(F(", pin "));
+        printPin(input->customCalibration.node.remote_pin);
+        msg.control.print(F(", application 0x"));
+        msg.control.println(input->customCalibration.node.app_hash, HEX);
     }
     msg.control.println();
 }
 
-void listAllInputs() {
-    msg.control.println(F("Active Inputs:"));
-    bool found = false;
+// LIST INPUTS - one input per step; arg notes that one was printed
+static bool listAllInputsStep(ResponseCursor& cursor) {
+    if (cursor.section == 0) {
+        msg.control.println(F("Active Inputs:"));
+        cursor.section = 1;
+        return true;
+    }
 
-    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
-        if (inputs[i].pin != 0xFF && inputs[i].flags.isEnabled) {
-            found = true;
-            msg.control.print(F("  "));
-            if (inputs[i].pin >= 0xF0) {
-                msg.control.print(F("I2C:"));
-                msg.control.print(inputs[i].pin - 0xF0);
-            } else if (inputs[i].pin >= 0xC0 && inputs[i].pin < 0xE0) {
-                msg.control.print(F("CAN:"));
-                msg.control.print(inputs[i].pin - 0xC0);
-            } else if (inputs[i].pin >= A0) {
-                msg.control.print(F("A"));
-                msg.control.print(inputs[i].pin - A0);
-            } else {
-                msg.control.print(inputs[i].pin);
-            }
-            msg.control.print(F(": "));
-            msg.control.print(inputs[i].abbrName);
-            msg.control.print(F(" ("));
-            msg.control.print(inputs[i].displayName);
-            msg.control.print(F(") = "));
-            msg.control.print(inputs[i].value);
-            msg.control.print(F(" "));
-            msg.control.println((__FlashStringHelper*)getUnitStringByIndex(inputs[i].unitsIndex));
+    while (cursor.index < MAX_INPUTS) {
+        const Input* input = &inputs[cursor.index++];
+        if (input->pin == 0xFF || !input->flags.isEnabled) continue;
+        cursor.arg = 1;
+        msg.control.print(F("  "));
+        if (CAN_IS_PIN(input->pin)) {
+            printPin(input->pin);
+        } else if (input->pin >= 0xF0) {
+            msg.control.print(F("I2C:"));
+            msg.control.print(input->pin - 0xF0);
+        } else if (EXT_ADC_IS_PIN(input->pin) || MATH_IS_PIN(input->pin) || GPS_IS_PIN(input->pin) ||
+                   NODE_IS_PIN(input->pin)) {
+            printPin(input->pin);
+        } else if (input->pin >= A0) {
+            msg.control.print(F("A"));
+            msg.control.print(input->pin - A0);
+        } else {
+            msg.control.print(input->pin);
         }
+        msg.control.print(F(": "));
+        msg.control.print(input->abbrName);
+        char name[INPUT_DISPLAY_NAME_LEN];
+        msg.control.print(F(" ("));
+        msg.control.print(getInputDisplayName(input, name));
+        msg.control.print(F(") = "));
+        msg.control.print(input->value);
+        msg.control.print(F(" "));
+        msg.control.println((__FlashStringHelper*)getUnitStringByIndex(input->unitsIndex));
+        return true;
     }
 
-    if (!found) {
+    if (!cursor.arg) {
         msg.control.println(F("  (none)"));
     }
+    return false;
 }
 
-void listApplicationPresets() {
-    msg.control.println(F("Available Application Presets:"));
+void listAllInputs() {
+    startResponse(listAllInputsStep);
+}
 
-    // Group by measurement type
-    msg.control.println(F("Temperature:"));
-    for (uint8_t i = 1; i < NUM_APPLICATION_PRESETS; i++) {
-        const ApplicationPreset* preset = &APPLICATION_PRESETS[i];
-        MeasurementType type = (MeasurementType)pgm_read_byte(&preset->expectedMeasurementType);
-        if (type == MEASURE_TEMPERATURE) {
-            const char* name = READ_APP_NAME(preset);
-            const char* label = READ_APP_LABEL(preset);
-            msg.control.print(F("  "));
-            msg.control.print((__FlashStringHelper*)name);
-            // Pad to 20 chars for alignment
-            uint8_t nameLen = strlen_P(name);
-            for (uint8_t j = nameLen; j < 20; j++) msg.control.write(' ');
-            msg.control.print(F("- "));
-            msg.control.println((__FlashStringHelper*)label);
-        }
-    }
+// "  NAME<padding>- Label" from flash strings (label may be null)
+static void printListItem(const char* name, const char* label, uint8_t width) {
+    msg.control.print(F("  "));
+    msg.control.print((__FlashStringHelper*)name);
+    uint8_t nameLen = strlen_P(name);
+    for (uint8_t j = nameLen; j < width; j++) msg.control.write(' ');
+    msg.control.print(F("- "));
+    if (label) msg.control.println((__FlashStringHelper*)label);
+    else msg.control.println();
+}
 
-    msg.control.println(F("Pressure:"));
-    for (uint8_t i = 1; i < NUM_APPLICATION_PRESETS; i++) {
-        const ApplicationPreset* preset = &APPLICATION_PRESETS[i];
-        MeasurementType type = (MeasurementType)pgm_read_byte(&preset->expectedMeasurementType);
-        if (type == MEASURE_PRESSURE) {
-            const char* name = READ_APP_NAME(preset);
-            const char* label = READ_APP_LABEL(preset);
-            msg.control.print(F("  "));
-            msg.control.print((__FlashStringHelper*)name);
-            uint8_t nameLen = strlen_P(name);
-            for (uint8_t j = nameLen; j < 20; j++) msg.control.write(' ');
-            msg.control.print(F("- "));
-            msg.control.println((__FlashStringHelper*)label);
-        }
+// Preset groups of LIST APPLICATIONS, in order; the last takes the rest
+static uint8_t presetGroup(MeasurementType type) {
+    switch (type) {
+        case MEASURE_TEMPERATURE: return 0;
+        case MEASURE_PRESSURE:    return 1;
+        case MEASURE_VOLTAGE:     return 2;
+        default:                  return 3;
     }
+}
 
-    msg.control.println(F("Electrical:"));
-    for (uint8_t i = 1; i < NUM_APPLICATION_PRESETS; i++) {
-        const ApplicationPreset* preset = &APPLICATION_PRESETS[i];
-        MeasurementType type = (MeasurementType)pgm_read_byte(&preset->expectedMeasurementType);
-        if (type == MEASURE_VOLTAGE) {
-            const char* name = READ_APP_NAME(preset);
-            const char* label = READ_APP_LABEL(preset);
-            msg.control.print(F("  "));
-            msg.control.print((__FlashStringHelper*)name);
-            uint8_t nameLen = strlen_P(name);
-            for (uint8_t j = nameLen; j < 20; j++) msg.control.write(' ');
-            msg.control.print(F("- "));
-            msg.control.println((__FlashStringHelper*)label);
+// LIST APPLICATIONS - a group heading, then one preset per step (section = group)
+static bool listApplicationPresetsStep(ResponseCursor& cursor) {
+    if (cursor.index == 0) {
+        switch (cursor.section) {
+            case 0:
+                msg.control.println(F("Available Application Presets:"));
+                msg.control.println(F("Temperature:"));
+                break;
+            case 1: msg.control.println(F("Pressure:")); break;
+            case 2: msg.control.println(F("Electrical:")); break;
+            default: msg.control.println(F("Other:")); break;
         }
+        cursor.index = 1;   // Preset 0 is NONE
+        return true;
     }
 
-    msg.control.println(F("Other:"));
-    for (uint8_t i = 1; i < NUM_APPLICATION_PRESETS; i++) {
-        const ApplicationPreset* preset = &APPLICATION_PRESETS[i];
+    while (cursor.index < NUM_APPLICATION_PRESETS) {
+        const ApplicationPreset* preset = &APPLICATION_PRESETS[cursor.index++];
         MeasurementType type = (MeasurementType)pgm_read_byte(&preset->expectedMeasurementType);
-        if (type != MEASURE_TEMPERATURE && type != MEASURE_PRESSURE && type != MEASURE_VOLTAGE) {
-            const char* name = READ_APP_NAME(preset);
-            const char* label = READ_APP_LABEL(preset);
-            msg.control.print(F("  "));
-            msg.control.print((__FlashStringHelper*)name);
-            uint8_t nameLen = strlen_P(name);
-            for (uint8_t j = nameLen; j < 20; j++) msg.control.write(' ');
-            msg.control.print(F("- "));
-            msg.control.println((__FlashStringHelper*)label);
+        if (presetGroup(type) == cursor.section) {
+            printListItem(READ_APP_NAME(preset), READ_APP_LABEL(preset), 20);
+            return true;
         }
     }
+
+    cursor.index = 0;
+    return ++cursor.section < 4;
 }
 
-/**
- * List sensors - supports three modes:
- *   1. No filter: Show category summary with sensor counts
- *   2. Category filter: Show sensors in that category (e.g., "NTC_THERMISTOR", "NTC")
- *   3. Measurement filter: Show all sensors of that type (e.g., "TEMPERATURE", "PRESSURE")
- */
-void listSensors(const char* filter) {
-    // Helper lambda to print a single sensor
-    auto printSensor = [](const SensorInfo* sensor) {
-        const char* name = READ_SENSOR_NAME(sensor);
-        const char* label = (const char*)pgm_read_ptr(&sensor->label);
-        msg.control.print(F("  "));
-        msg.control.print((__FlashStringHelper*)name);
-        uint8_t nameLen = strlen_P(name);
-        for (uint8_t j = nameLen; j < 24; j++) msg.control.write(' ');
-        msg.control.print(F("- "));
-        if (label) msg.control.println((__FlashStringHelper*)label);
-        else msg.control.println();
-    };
-
-    // No filter: Show category summary
-    if (filter == nullptr) {
-        msg.control.println(F("Sensor Categories:"));
-        msg.control.println();
+void listApplicationPresets() {
+    startResponse(listApplicationPresetsStep);
+}
 
-        for (uint8_t cat = 0; cat < CAT_COUNT; cat++) {
-            uint8_t count = countSensorsInCategory((SensorCategory)cat);
-            if (count > 0) {
-                const SensorCategoryInfo* catInfo = getCategoryInfo((SensorCategory)cat);
+// LIST SENSORS - category summary: heading, one category per step, then the footer
+static bool listSensorCategoriesStep(ResponseCursor& cursor) {
+    switch (cursor.section) {
+        case 0:
+            msg.control.println(F("Sensor Categories:"));
+            msg.control.println();
+            cursor.section = 1;
+            return true;
+
+        case 1:
+            while (cursor.index < CAT_COUNT) {
+                SensorCategory cat = (SensorCategory)cursor.index++;
+                uint8_t count = countSensorsInCategory(cat);
+                if (count == 0) continue;
+                const SensorCategoryInfo* catInfo = getCategoryInfo(cat);
                 const char* catName = READ_CATEGORY_NAME(catInfo);
-                const char* catLabel = READ_CATEGORY_LABEL(catInfo);
 
                 msg.control.print(F("  "));
                 msg.control.print((__FlashStringHelper*)catName);
                 uint8_t nameLen = strlen_P(catName);
                 for (uint8_t j = nameLen; j < 20; j++) msg.control.write(' ');
                 msg.control.print(F("- "));
-                msg.control.print((__FlashStringHelper*)catLabel);
+                msg.control.print((__FlashStringHelper*)READ_CATEGORY_LABEL(catInfo));
                 msg.control.print(F(" ("));
                 msg.control.print(count);
                 msg.control.println(F(")"));
+                return true;
             }
-        }
-
-        msg.control.println();
-        msg.control.println(F("Measurement Type Filters:"));
-        msg.control.print(F("  TEMPERATURE           - All temperature sensors ("));
-        msg.control.print(countSensorsByMeasurementType(MEASURE_TEMPERATURE));
-        msg.control.println(F(")"));
-        msg.control.print(F("  PRESSURE              - All pressure sensors ("));
-        msg.control.print(countSensorsByMeasurementType(MEASURE_PRESSURE));
-        msg.control.println(F(")"));
+            cursor.section = 2;
+            return true;
+
+        case 2:
+            msg.control.println();
+            msg.control.println(F("Measurement Type Filters:"));
+            msg.control.print(F("  TEMPERATURE           - All temperature sensors ("));
+            msg.control.print(countSensorsByMeasurementType(MEASURE_TEMPERATURE));
+            msg.control.println(F(")"));
+            msg.control.print(F("  PRESSURE              - All pressure sensors ("));
+            msg.control.print(countSensorsByMeasurementType(MEASURE_PRESSURE));
+            msg.control.println(F(")"));
+            cursor.section = 3;
+            return true;
+
+        case 3:
+            msg.control.println();
+            msg.control.println(F("Usage: LIST SENSORS <category>    - Show sensors in category"));
+            msg.control.println(F("       LIST SENSORS TEMPERATURE   - Show all temperature sensors"));
+            msg.control.println(F("       SET <pin> SENSOR <category> <preset>"));
+            cursor.section = 4;
+            return true;
+
+        default:
+            msg.control.println();
+            msg.control.println(F("Aliases: NTC -> THERMISTOR"));
+            msg.control.println(F("         TC -> THERMOCOUPLE"));
+            msg.control.println(F("         RPM, SPEED -> FREQUENCY"));
+            return false;
+    }
+}
 
-        msg.control.println();
-        msg.control.println(F("Usage: LIST SENSORS <category>    - Show sensors in category"));
-        msg.control.println(F("       LIST SENSORS TEMPERATURE   - Show all temperature sensors"));
-        msg.control.println(F("       SET <pin> SENSOR <category> <preset>"));
-        msg.control.println();
-        msg.control.println(F("Aliases: NTC -> THERMISTOR"));
-        msg.control.println(F("         TC -> THERMOCOUPLE"));
-        msg.control.println(F("         RPM, SPEED -> FREQUENCY"));
-        return;
+// Next library sensor from cursor.index that passes match(), or null at the end
+static const SensorInfo* nextListedSensor(ResponseCursor& cursor, bool (*match)(uint8_t index, uint8_t arg)) {
+    while (cursor.index < NUM_SENSORS) {
+        uint8_t i = cursor.index++;
+        const SensorInfo* sensor = &SENSOR_LIBRARY[i];
+        if (pgm_read_ptr(&sensor->label) == nullptr) continue;
+        if (match(i, cursor.arg)) return sensor;
     }
+    return nullptr;
+}
 
-    // Check if filter is a measurement type (TEMPERATURE, PRESSURE)
-    int8_t measFilter = getMeasurementTypeFilter(filter);
-    if (measFilter >= 0) {
-        MeasurementType measType = (MeasurementType)measFilter;
-        const char* typeName = (measType == MEASURE_TEMPERATURE) ? "Temperature" : "Pressure";
+static bool sensorHasMeasurement(uint8_t index, uint8_t measType) {
+    return pgm_read_byte(&SENSOR_LIBRARY[index].measurementType) == measType;
+}
+
+static bool sensorInCategory(uint8_t index, uint8_t cat) {
+    return getSensorCategory(index) == cat;
+}
 
+// LIST SENSORS TEMPERATURE|PRESSURE - arg is the MeasurementType
+static bool listSensorsByTypeStep(ResponseCursor& cursor) {
+    if (cursor.section == 0) {
         msg.control.print(F("All "));
-        msg.control.print(typeName);
+        msg.control.print(cursor.arg == MEASURE_TEMPERATURE ? F("Temperature") : F("Pressure"));
         msg.control.println(F(" Sensors:"));
         msg.control.println();
+        cursor.section = 1;
+        cursor.index = 1;   // Sensor 0 is NONE
+        return true;
+    }
 
-        for (uint8_t i = 1; i < NUM_SENSORS; i++) {
-            const SensorInfo* sensor = &SENSOR_LIBRARY[i];
-            if (pgm_read_ptr(&sensor->label) == nullptr) continue;
+    const SensorInfo* sensor = nextListedSensor(cursor, sensorHasMeasurement);
+    if (sensor) {
+        printListItem(READ_SENSOR_NAME(sensor), (const char*)pgm_read_ptr(&sensor->label), 24);
+        return true;
+    }
 
-            MeasurementType sensorMeasType = (MeasurementType)pgm_read_byte(&sensor->measurementType);
-            if (sensorMeasType == measType) {
-                printSensor(sensor);
-            }
-        }
+    msg.control.println();
+    msg.control.println(F("IMPORTANT: 5V sensors (0.5-4.5V) require voltage dividers for 3.3V systems!"));
+    return false;
+}
 
+// LIST SENSORS <category> - arg is the SensorCategory
+static bool listSensorsInCategoryStep(ResponseCursor& cursor) {
+    SensorCategory cat = (SensorCategory)cursor.arg;
+    if (cursor.section == 0) {
+        msg.control.print((__FlashStringHelper*)READ_CATEGORY_LABEL(getCategoryInfo(cat)));
+        msg.control.println(F(":"));
         msg.control.println();
+        cursor.section = 1;
+        cursor.index = 1;
+        return true;
+    }
+
+    const SensorInfo* sensor = nextListedSensor(cursor, sensorInCategory);
+    if (sensor) {
+        printListItem(READ_SENSOR_NAME(sensor), (const char*)pgm_read_ptr(&sensor->label), 24);
+        return true;
+    }
+
+    msg.control.println();
+    msg.control.println(F("Usage: SET <pin> SENSOR <category> <preset>"));
+    if (cat == CAT_ENVIRONMENTAL) {
+        msg.control.println(F("Note: Use 'I2C' for pin, e.g., SET I2C AMBIENT_TEMP BME280_TEMP"));
+    } else if (cat == CAT_PRESSURE || cat == CAT_THERMISTOR) {
         msg.control.println(F("IMPORTANT: 5V sensors (0.5-4.5V) require voltage dividers for 3.3V systems!"));
+    }
+    return false;
+}
+
+/**
+ * List sensors - supports three modes:
+ *   1. No filter: Show category summary with sensor counts
+ *   2. Category filter: Show sensors in that category (e.g., "NTC_THERMISTOR", "NTC")
+ *   3. Measurement filter: Show all sensors of that type (e.g., "TEMPERATURE", "PRESSURE")
+ * The list goes out a line per step (lib/response_stream.h).
+ */
+void listSensors(const char* filter) {
+    if (filter == nullptr) {
+        startResponse(listSensorCategoriesStep);
+        return;
+    }
+
+    // Check if filter is a measurement type (TEMPERATURE, PRESSURE)
+    int8_t measFilter = getMeasurementTypeFilter(filter);
+    if (measFilter >= 0) {
+        startResponse(listSensorsByTypeStep, (uint8_t)measFilter);
         return;
     }
 
     // Check if filter is a category name or alias
     SensorCategory cat = getCategoryByName(filter);
     if (cat < CAT_COUNT) {
-        const SensorCategoryInfo* catInfo = getCategoryInfo(cat);
-        const char* catLabel = READ_CATEGORY_LABEL(catInfo);
-
-        msg.control.print((__FlashStringHelper*)catLabel);
-        msg.control.println(F(":"));
-        msg.control.println();
-
-        for (uint8_t i = 1; i < NUM_SENSORS; i++) {
-            const SensorInfo* sensor = &SENSOR_LIBRARY[i];
-            if (pgm_read_ptr(&sensor->label) == nullptr) continue;
-
-            if (getSensorCategory(i) == cat) {
-                printSensor(sensor);
-            }
-        }
-
-        msg.control.println();
-        msg.control.println(F("Usage: SET <pin> SENSOR <category> <preset>"));
-        if (cat == CAT_ENVIRONMENTAL) {
-            msg.control.println(F("Note: Use 'I2C' for pin, e.g., SET I2C AMBIENT_TEMP BME280_TEMP"));
-        } else if (cat == CAT_PRESSURE || cat == CAT_THERMISTOR) {
-            msg.control.println(F("IMPORTANT: 5V sensors (0.5-4.5V) require voltage dividers for 3.3V systems!"));
-        }
+        startResponse(listSensorsInCategoryStep, (uint8_t)cat);
         return;
     }
 
@@ -7,6 +7,13 @@
  * - EEPROM persistence (in EEPROM/serial config mode)
  * - Runtime queries and modifications
  * - Custom calibration overrides
+ * - Config transactions (BEGIN / COMMIT / ROLLBACK) for bulk configuration
+ *
+ * Build Flags:
+ *   -D CONFIG_TRANSACTIONS=0  - No config transactions (default off on Uno:
+ *                               rollback keeps a copy of inputs[] in RAM)
+ *   -D INPUT_NAME_POOL_SLOTS=n - Custom display names held at once (default
+ *                               MAX_INPUTS; MAX_INPUTS / 2 on AVR)
  */
 
 #ifndef INPUT_MANAGER_H
@@ -17,40 +24,126 @@
 #include <Arduino.h>
 #include "input.h"
 
+#ifndef CONFIG_TRANSACTIONS
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
+#define CONFIG_TRANSACTIONS 0
+#else
+#define CONFIG_TRANSACTIONS 1
+#endif
+#endif
+
+// Display names that differ from the application preset's, 32 bytes each
+#ifndef INPUT_NAME_POOL_SLOTS
+#if defined(__AVR__)
+#define INPUT_NAME_POOL_SLOTS (MAX_INPUTS / 2)
+#else
+#define INPUT_NAME_POOL_SLOTS MAX_INPUTS
+#endif
+#endif
+
 // Global inputs array
 extern Input inputs[MAX_INPUTS];
 extern uint8_t numActiveInputs;
 
+// Slots of the enabled inputs in slot order, kept by rebuildInputSchedule() -
+// per-pass code walks these instead of all MAX_INPUTS slots. Empty while a
+// transaction is open, like the read schedule.
+extern uint8_t activeSlots[MAX_INPUTS];
+extern uint8_t numActiveSlots;
+
+// ===== READ SCHEDULE =====
+// Compact table of enabled inputs with everything the hot loop needs resolved
+// up front (read function, interval, next-due time). Rebuilt whenever the set
+// of enabled inputs or their sensors changes, so updateSensors() only compares
+// timestamps instead of walking MAX_INPUTS slots and reading PROGMEM.
+// Two-phase sensors (SensorInfo::startFunction) are started when due and
+// collected at readyAt; readyAt is 0 while no conversion is in flight.
+struct InputSchedule {
+    Input* input;                   // Input to read
+    void (*readFunction)(Input*);   // Cached read function
+    uint16_t (*startFunction)(Input*);   // Two-phase start, nullptr = readFunction only
+    void (*completeFunction)(Input*);    // Two-phase collect
+    uint16_t interval;              // Read interval in ms (sensor minimum or global default)
+    uint32_t nextDue;               // millis() timestamp of next read
+    uint32_t readyAt;               // millis() the started conversion is ready, 0 = none
+};
+
+extern InputSchedule inputSchedule[MAX_INPUTS];
+extern uint8_t numScheduledInputs;
+
+void rebuildInputSchedule();          // Rebuild schedule from current inputs[] state
+
+// Read a scheduled input at interval ms until the next rebuild (host
+// subscriptions) - only shorter than its own interval, and never for a
+// sensor with a minimum read interval; 0 restores its own
+// Returns the interval now in effect, 0 if the input isn't scheduled
+uint16_t setInputScheduleInterval(const Input* input, uint16_t interval);
+
+// Changes whenever inputs are configured, cleared, enabled or shown/hidden, so
+// consumers that keep their own list of inputs (the LCD pages) rebuild it then
+uint8_t getInputLayoutVersion();
+
+// Resolve unitsIndex into the cached display conversion and symbol - whenever
+// unitsIndex changes, so outputs convert with one multiply-add per value
+void refreshInputUnits(Input* input);
+
+// Value in the input's display units (cached conversion, see refreshInputUnits())
+static inline float toInputUnits(const Input* input, float baseValue) {
+    return baseValue * input->unitsFactor + input->unitsOffset;
+}
+
+// Encode the input's value into obd2data - once per changed reading, so OBD-II
+// responders and broadcasters copy bytes instead of converting per request
+void refreshOBD2Data(Input* input);
+
+// Sensor warm-up: init functions call setInputWarmup() when the first valid
+// reading takes time (e.g. MAX6675 conversion). The schedule holds the input's
+// first read until then instead of setup() delaying every input.
+void setInputWarmup(Input* input, uint16_t warmup_ms);
+uint32_t getInputFirstReadTime(const Input* input, uint32_t now);  // now, or end of warm-up
+
 // ===== INITIALIZATION =====
 bool initInputManager();              // Initialize and load from EEPROM (returns true if EEPROM config loaded)
 
 // ===== CONFIGURATION =====
-bool setInputApplication(uint8_t pin, uint8_t appIndex);
-bool setInputSensor(uint8_t pin, uint8_t sensorIndex);
-bool setInputName(uint8_t pin, const char* name);
-bool setInputDisplayName(uint8_t pin, const char* displayName);
-bool setInputUnits(uint8_t pin, uint8_t unitsIndex);
-bool setInputAlarmRange(uint8_t pin, float minValue, float maxValue);
-bool setInputOBD(uint8_t pin, uint8_t pid, uint8_t length);
-bool enableInput(uint8_t pin, bool enable);
-bool enableInputAlarm(uint8_t pin, bool enable);
-bool enableInputDisplay(uint8_t pin, bool enable);
-bool setInputAlarmWarmup(uint8_t pin, uint16_t warmupTime_ms);
-bool setInputAlarmPersist(uint8_t pin, uint16_t persistTime_ms);
-bool setInputOutputMask(uint8_t pin, uint8_t outputId, bool enable);
-bool clearInput(uint8_t pin);
+bool setInputApplication(InputPin pin, uint8_t appIndex);
+bool setInputSensor(InputPin pin, uint8_t sensorIndex);
+bool setInputName(InputPin pin, const char* name);
+bool setInputDisplayName(InputPin pin, const char* displayName);
+bool storeInputDisplayName(Input* input, const char* displayName);       // false: name pool full
+
+// The input's display name: its custom name, or the preset's copied into buf
+const char* getInputDisplayName(const Input* input, char* buf);           // buf: INPUT_DISPLAY_NAME_LEN
+bool setInputUnits(InputPin pin, uint8_t unitsIndex);
+bool setInputAlarmRange(InputPin pin, float minValue, float maxValue);
+bool setInputOBD(InputPin pin, uint8_t pid, uint8_t length);
+bool enableInput(InputPin pin, bool enable);
+bool enableInputAlarm(InputPin pin, bool enable);
+bool enableInputDisplay(InputPin pin, bool enable);
+bool setInputAlarmWarmup(InputPin pin, uint16_t warmupTime_ms);
+bool setInputAlarmPersist(InputPin pin, uint16_t persistTime_ms);
+bool setInputAlarmClear(InputPin pin, uint16_t clearMs);
+bool setInputWarnRange(InputPin pin, float minValue, float maxValue);  // NAN = WARNING_THRESHOLD_PERCENT
+bool setInputWarnTimers(InputPin pin, uint16_t persistMs, uint16_t clearMs);
+bool setInputAlarmHysteresis(InputPin pin, float alarmBand, float warnBand);
+bool isValidAlarmHysteresis(float band);
+bool setInputOutputMask(InputPin pin, uint8_t outputId, bool enable);
+bool setInputFilter(InputPin pin, uint8_t filterType, uint16_t filterParam);  // See input_filter.h
+bool setInputRate(InputPin pin, uint16_t maxInterval, uint16_t band);         // See input_rate.h (0 = fixed)
+bool setInputAlarmTrend(InputPin pin, float rate, uint16_t windowMs);         // See alarm_trend.h (rate 0 = off)
+bool clearInput(InputPin pin);
 
 // ===== CALIBRATION OVERRIDES =====
-bool setInputCalibrationSteinhart(uint8_t pin, float bias, float a, float b, float c);
-bool setInputCalibrationLookup(uint8_t pin, float bias);
-bool setInputCalibrationPressureLinear(uint8_t pin, float vMin, float vMax, float pMin, float pMax);
-bool setInputCalibrationPressurePolynomial(uint8_t pin, float bias, float a, float b, float c);
-bool clearInputCalibration(uint8_t pin);
+bool setInputCalibrationSteinhart(InputPin pin, float bias, float a, float b, float c);
+bool setInputCalibrationLookup(InputPin pin, float bias);
+bool setInputCalibrationPressureLinear(InputPin pin, float vMin, float vMax, float pMin, float pMax);
+bool setInputCalibrationPressurePolynomial(InputPin pin, float bias, float a, float b, float c);
+bool clearInputCalibration(InputPin pin);
 
 // ===== HELPER FUNCTIONS =====
-Input* getInputByPin(uint8_t pin);   // Find input by pin number
+Input* getInputByPin(InputPin pin);  // Find input by pin number
 Input* getInputByIndex(uint8_t index); // Get input by array index
-uint8_t getInputIndex(uint8_t pin);  // Get array index for pin
+uint8_t getInputIndex(InputPin pin); // Get array index for pin
 
 #ifndef USE_STATIC_CONFIG
 
@@ -59,14 +152,29 @@ bool saveInputConfig();               // Save all inputs to EEPROM
 bool loadInputConfig();               // Load all inputs from EEPROM
 void resetInputConfig();              // Clear all inputs and EEPROM
 
+// ===== CONFIG TRANSACTIONS =====
+// Between begin and commit, input changes are applied but not validated, and
+// the derived tables (schedule, ADC LUTs, CAN subscriptions, PID index) are
+// not rebuilt; inputs are not read. Commit validates every input once, then
+// rebuilds once - or restores inputs[] as it was at begin if any is invalid.
+// A live transaction (TEST CERTIFY) keeps reading: each change is validated
+// and takes effect at once, and rollback puts the configuration back.
+bool beginInputTransaction(bool live = false);  // false if one is open (or CONFIG_TRANSACTIONS=0)
+bool commitInputTransaction();        // false if validation failed (rolled back)
+bool rollbackInputTransaction();      // false if none was open
+bool isInputTransactionActive();
+
 // ===== RUNTIME =====
 void readAllInputs();                 // Read all enabled inputs
 
 // ===== INFO =====
-void printInputInfo(uint8_t pin);    // Print detailed input information
-void printInputAlarmInfo(uint8_t pin);
-void printInputOutputInfo(uint8_t pin);
-void printInputCalibration(uint8_t pin);
+void printInputInfo(InputPin pin);    // Print detailed input information
+void printInputAlarmInfo(InputPin pin);
+void printInputOutputInfo(InputPin pin);
+void printInputHealthInfo(InputPin pin);
+void printInputSummaryInfo(InputPin pin);
+void printInputCalibration(InputPin pin);
+void printPin(InputPin pin);          // Print a pin as typed (A0, 7, I2C:0, CAN:0)
 void listAllInputs();                // List all active inputs
 void listApplicationPresets();       // List available Applications
 void listSensors(const char* filter = nullptr);  // List sensors (categories, by category, or by measurement type)
@@ -0,0 +1,199 @@
+/*
+ * input_math.cpp - Math channels: virtual inputs derived from other inputs
+ *
+ * Compiled form: per input slot of a math channel, its sources resolved to
+ * input slots and the sequences they were last evaluated at. A read compares
+ * the sequences and returns at once if neither moved.
+ *
+ * NOTE: Only compiled in EEPROM/runtime configuration mode (not in static mode)
+ */
+
+#include "../config.h"
+
+#ifndef USE_STATIC_CONFIG
+
+#include "input_math.h"
+#include "input_manager.h"
+#include "input_health.h"
+#include "../lib/application_presets.h"
+#include "../lib/message_api.h"
+#include <math.h>
+
+#define NO_SLOT 0xFF
+#define MAX_STEP_MS 1000            // A longer gap between reads (scan paused) is not integrated
+
+struct MathChannelState {
+    uint8_t pin;                // Channel this state belongs to (0xFF = none)
+    uint8_t slot[2];            // Input slots of A and B
+    uint8_t seq[2];             // Their Input.sequence at the last evaluation
+    bool stale;                 // Evaluate on the next read
+    float rate;                 // Integrators: latest result, held between evaluations
+    float total;                // Integrators: running total
+    uint32_t lastMs;            // Integrators: millis() of the last step (0 = none yet)
+};
+
+static MathChannelState channels[MAX_INPUTS];
+
+static uint8_t slotOf(uint8_t pin) {
+    Input* input = getInputByPin(pin);
+    return input ? (uint8_t)(input - inputs) : NO_SLOT;
+}
+
+static void restartChannel(MathChannelState* s, uint8_t pin) {
+    s->pin = pin;
+    s->rate = NAN;
+    s->total = 0;
+    s->lastMs = 0;
+}
+
+void compileMathChannels() {
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        Input* input = &inputs[i];
+        MathChannelState* s = &channels[i];
+        if (input->pin == 0xFF || input->calibrationType != CAL_MATH_CHANNEL) {
+            s->pin = 0xFF;
+            continue;
+        }
+        if (s->pin != input->pin) restartChannel(s, input->pin);  // Slot has a new channel
+
+        const ApplicationPreset* app = getApplicationByIndex(input->applicationIndex);
+        if (app) input->measurementType = (MeasurementType)pgm_read_byte(&app->expectedMeasurementType);
+
+        s->slot[0] = NO_SLOT;
+        s->slot[1] = NO_SLOT;
+        if (input->flags.useCustomCalibration) {
+            s->slot[0] = slotOf(input->customCalibration.math.source_a);
+            if (input->customCalibration.math.source_b != MATH_SOURCE_CONSTANT) {
+                s->slot[1] = slotOf(input->customCalibration.math.source_b);
+            }
+        }
+        s->stale = true;
+    }
+}
+
+// A source's reading moved since the last evaluation
+static bool sourceMoved(MathChannelState* s, uint8_t n) {
+    if (s->slot[n] == NO_SLOT) return false;
+    uint8_t seq = inputs[s->slot[n]].sequence;
+    if (seq == s->seq[n]) return false;
+    s->seq[n] = seq;
+    return true;
+}
+
+// Reading of a source; NAN with the reason if it has none
+static float sourceValue(uint8_t slot, uint8_t pin, uint8_t* fault) {
+    if (slot == NO_SLOT || inputs[slot].pin != pin || !inputs[slot].flags.isEnabled) {
+        *fault = FAULT_NO_DEVICE;
+        return NAN;
+    }
+    if (isnan(inputs[slot].value)) *fault = FAULT_STALE;
+    return inputs[slot].value;
+}
+
+static float evaluate(const Input* ptr, const MathChannelState* s, uint8_t* fault) {
+    const auto& expr = ptr->customCalibration.math;
+    float a = sourceValue(s->slot[0], expr.source_a, fault);
+    float result = a;
+    if (expr.op != MATH_OP_NONE) {
+        float b = (expr.source_b == MATH_SOURCE_CONSTANT) ? expr.constant
+                                                          : sourceValue(s->slot[1], expr.source_b, fault);
+        switch (expr.op) {
+            case MATH_OP_ADD: result = a + b; break;
+            case MATH_OP_SUB: result = a - b; break;
+            case MATH_OP_MUL: result = a * b; break;
+            case MATH_OP_DIV: result = (b != 0) ? a / b : NAN; break;
+        }
+    }
+    return result * expr.scale + expr.offset;
+}
+
+void readMathChannel(Input* ptr) {
+    uint8_t idx = ptr - inputs;
+    if (idx >= MAX_INPUTS || !ptr->flags.useCustomCalibration || channels[idx].pin != ptr->pin) {
+        setInputFault(ptr, FAULT_NO_CALIBRATION);  // No expression set yet
+        return;
+    }
+    MathChannelState* s = &channels[idx];
+    bool moved = sourceMoved(s, 0);
+    moved |= sourceMoved(s, 1);
+
+    if (!ptr->customCalibration.math.integrate) {
+        // Nothing new upstream - keep the value (a NAN is re-evaluated for its reason)
+        if (!moved && !s->stale && !isnan(ptr->value)) return;
+        s->stale = false;
+        uint8_t fault = FAULT_NONE;
+        float result = evaluate(ptr, s, &fault);
+        if (fault != FAULT_NONE || isnan(result)) {
+            setInputFault(ptr, fault != FAULT_NONE ? fault : FAULT_OUT_OF_RANGE);
+            return;
+        }
+        ptr->value = result;
+        return;
+    }
+
+    // Integrator: the previous result holds until now, then the new one starts
+    uint32_t now = millis();
+    if (s->lastMs != 0 && !isnan(s->rate) && now - s->lastMs <= MAX_STEP_MS) {
+        s->total += s->rate * (float)(now - s->lastMs) * 0.001f;
+    }
+    s->lastMs = now ? now : 1;
+    if (moved || s->stale) {
+        s->stale = false;
+        uint8_t fault = FAULT_NONE;
+        s->rate = evaluate(ptr, s, &fault);  // NAN pauses the total
+    }
+    ptr->value = s->total;
+}
+
+bool setMathChannel(uint8_t pin, const MathChannelCalibration& expr) {
+    Input* input = getInputByPin(pin);
+    if (input == nullptr || input->calibrationType != CAL_MATH_CHANNEL) return false;
+    if (expr.op > MATH_OP_DIV || expr.source_a == 0xFF || getInputByPin(expr.source_a) == nullptr) return false;
+    if (expr.op != MATH_OP_NONE && expr.source_b != MATH_SOURCE_CONSTANT &&
+        getInputByPin(expr.source_b) == nullptr) return false;
+    if (!isfinite(expr.constant) || !isfinite(expr.scale) || !isfinite(expr.offset)) return false;
+
+    memset(&input->customCalibration, 0, sizeof(CalibrationOverride));
+    input->customCalibration.math.op = expr.op;
+    input->customCalibration.math.source_a = expr.source_a;
+    input->customCalibration.math.source_b = (expr.op == MATH_OP_NONE) ? MATH_SOURCE_CONSTANT : expr.source_b;
+    input->customCalibration.math.integrate = expr.integrate ? 1 : 0;
+    input->customCalibration.math.constant = expr.constant;
+    input->customCalibration.math.scale = expr.scale;
+    input->customCalibration.math.offset = expr.offset;
+    input->flags.useCustomCalibration = true;
+    input->value = NAN;
+
+    uint8_t idx = input - inputs;
+    restartChannel(&channels[idx], pin);
+    rebuildInputSchedule();  // Resolves the new sources
+    return true;
+}
+
+void printMathExpression(const Input* input) {
+    if (input->calibrationType != CAL_MATH_CHANNEL || !input->flags.useCustomCalibration) {
+        msg.control.print(F("(none)"));
+        return;
+    }
+    const auto& expr = input->customCalibration.math;
+    static const char OPS[] = " +-*/";
+    if (expr.integrate) msg.control.print(F("INTEGRATE "));
+    printPin(expr.source_a);
+    if (expr.op != MATH_OP_NONE) {
+        msg.control.print(' ');
+        msg.control.print(OPS[expr.op]);
+        msg.control.print(' ');
+        if (expr.source_b == MATH_SOURCE_CONSTANT) msg.control.print(expr.constant, 4);
+        else printPin(expr.source_b);
+    }
+    if (expr.scale != 1.0f) {
+        msg.control.print(F(" * "));
+        msg.control.print(expr.scale, 4);
+    }
+    if (expr.offset != 0.0f) {
+        msg.control.print(expr.offset > 0 ? F(" + ") : F(" - "));
+        msg.control.print(fabsf(expr.offset), 4);
+    }
+}
+
+#endif // USE_STATIC_CONFIG
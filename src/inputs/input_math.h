@@ -0,0 +1,82 @@
+/*
+ * input_math.h - Math channels: virtual inputs derived from other inputs
+ *
+ * A math channel is an input on a virtual pin MATH:0-MATH:15 (0xB0-0xBF)
+ * whose value is an expression over other inputs' readings - an oil/coolant
+ * delta-T, boost from a MAP sensor, AFR from a wideband's voltage, fuel used
+ * from a flow reading:
+ *
+ *   SET MATH:0 OIL_TEMP MATH                   application: units, alarms, OBD
+ *   SET MATH:0 MATH A6 - A7                    oil minus coolant
+ *   SET MATH:1 BOOST_PRESSURE MATH
+ *   SET MATH:1 MATH A2 - 1.013                 MAP minus atmosphere
+ *   SET MATH:2 MATH A4 * 2 + 10                0-5 V wideband -> AFR 10-20
+ *   SET MATH:3 MATH INTEGRATE CAN:2 / 3600     L/h -> litres used
+ *
+ * The expression is compiled to one fixed form when it is set -
+ * (A <op> B) * scale + offset, op one of + - * /, A an input, B an input or
+ * a constant - evaluated left to right. INTEGRATE makes the value the
+ * running total of the result over time (result x seconds), from power-on or
+ * from when the expression was set. Values are standard units.
+ *
+ * Everything else is an ordinary input: the channel gets its application
+ * (units, alarm range, OBD-II PID, outputs, logging, filters) with
+ * SET MATH:n <application> MATH, and its measurement type follows the
+ * application. Math channels may read other math channels.
+ *
+ * Change propagation: a channel is scheduled like any input, after all the
+ * others so a source's new reading reaches it in the same pass, but its read
+ * only re-evaluates when a source's Input.sequence moved since the last
+ * evaluation; otherwise it keeps its value, and no sequence bump goes on to
+ * the outputs. A missing or disabled source reads NAN (NO_DEVICE), a source
+ * without a reading NAN (STALE). Integrators are advanced on every read.
+ *
+ * The expression is kept in the input's custom calibration, so it is saved
+ * with the input. Pins are resolved to input slots by compileMathChannels()
+ * on every schedule rebuild.
+ *
+ * Runtime configuration only - static builds have no math channels.
+ *
+ * Build Flags:
+ *   -D MATH_CHANNEL_INTERVAL_MS=n - How often a channel checks its sources (default 10)
+ */
+
+#ifndef INPUT_MATH_H
+#define INPUT_MATH_H
+
+#include <Arduino.h>
+#include "input.h"
+
+#ifndef MATH_CHANNEL_INTERVAL_MS
+#define MATH_CHANNEL_INTERVAL_MS 10
+#endif
+
+// Virtual pin of channel n (MATH:n)
+#define MATH_PIN(n)         (0xB0 + (n))
+#define MATH_CHANNELS       16
+
+#define MATH_IS_PIN(pin)    ((pin) >= 0xB0 && (pin) < 0xC0)
+
+enum MathOp : uint8_t {
+    MATH_OP_NONE = 0,                       // A alone
+    MATH_OP_ADD,                            // A + B
+    MATH_OP_SUB,                            // A - B
+    MATH_OP_MUL,                            // A * B
+    MATH_OP_DIV                             // A / B (NAN when B is 0)
+};
+
+// Sensor read function of MATH:n inputs
+void readMathChannel(Input* ptr);
+
+// Resolve the channels' source pins to input slots and take their
+// measurement types from their applications (rebuildInputSchedule())
+void compileMathChannels();
+
+// Replace a math channel's expression and restart its total
+// False if pin is not a configured MATH:n input or the expression is invalid
+bool setMathChannel(uint8_t pin, const MathChannelCalibration& expr);
+
+// Print the expression ("A6 - A7", "INTEGRATE CAN:2 / 3600.00")
+void printMathExpression(const Input* input);
+
+#endif // INPUT_MATH_H
@@ -0,0 +1,92 @@
+/*
+ * input_rate.cpp - Adaptive per-input read rate
+ */
+
+#include "input_rate.h"
+#include "input_manager.h"
+#include "../lib/message_router.h"  // For msg.control
+#include "../lib/message_api.h"
+#include <math.h>
+
+struct InputRateState {
+    float lastValue;       // Value at the previous read
+    uint32_t lastMs;       // millis() of the previous read
+    uint16_t interval;     // Current interval (0 = restart on next read)
+};
+
+static InputRateState rateState[MAX_INPUTS];
+
+// Value near an enabled alarm threshold, now or one interval ahead
+static bool nearAlarm(const Input* input, float value, float slope, uint16_t interval) {
+    if (!input->flags.alarm) return false;
+
+    float margin = (input->maxValue - input->minValue) * INPUT_RATE_ALARM_MARGIN;
+    float projected = value + slope * interval * 0.001f;
+    return value < input->minValue + margin || value > input->maxValue - margin ||
+           projected < input->minValue + margin || projected > input->maxValue - margin;
+}
+
+uint16_t getInputRateInterval(Input* input, uint16_t baseInterval, uint32_t now) {
+    if (input->rateMaxInterval == 0) return baseInterval;
+
+    uint8_t idx = input - inputs;
+    if (idx >= MAX_INPUTS) return baseInterval;
+    InputRateState* state = &rateState[idx];
+
+    float value = input->value;
+    uint32_t dt = now - state->lastMs;
+
+    uint16_t interval = baseInterval;
+    if (state->interval != 0 && !isnan(value) && !isnan(state->lastValue) && dt > 0) {
+        float slope = (value - state->lastValue) * 1000.0f / dt;  // Units per second
+        float band = input->rateBand * 0.01f;
+
+        if (fabsf(slope) <= band && !nearAlarm(input, value, slope, state->interval)) {
+            // Stable - back off by half the current interval per read
+            uint32_t longer = state->interval + state->interval / 2 + 1;
+            interval = (longer > input->rateMaxInterval) ? input->rateMaxInterval : longer;
+        }
+    }
+    if (interval < baseInterval) interval = baseInterval;
+
+    state->lastValue = value;
+    state->lastMs = now;
+    state->interval = interval;
+    return interval;
+}
+
+void resetInputRate(Input* input) {
+    uint8_t idx = input - inputs;
+    if (idx >= MAX_INPUTS) return;
+    rateState[idx].interval = 0;
+}
+
+void resetInputRates() {
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        rateState[i].interval = 0;
+    }
+}
+
+bool isValidInputRate(uint16_t maxInterval, uint16_t band) {
+    if (maxInterval == 0) return true;  // Fixed rate
+    return band > 0;
+}
+
+void printInputRate(const Input* input) {
+    if (input->rateMaxInterval == 0) {
+        msg.control.print(F("FIXED"));
+        return;
+    }
+    msg.control.print(F("ADAPTIVE up to "));
+    msg.control.print(input->rateMaxInterval);
+    msg.control.print(F("ms, band "));
+    msg.control.print(input->rateBand / 100.0, 2);
+    msg.control.print(F("/s"));
+
+    uint8_t idx = input - inputs;
+    if (idx < MAX_INPUTS && rateState[idx].interval != 0) {
+        msg.control.print(F(" (now "));
+        msg.control.print(rateState[idx].interval);
+        msg.control.print(F("ms)"));
+    }
+}
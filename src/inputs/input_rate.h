@@ -0,0 +1,47 @@
+/*
+ * input_rate.h - Adaptive per-input read rate
+ *
+ * By default an input is read at its fixed schedule interval (the sensor's
+ * minReadInterval or the global read interval). In adaptive mode the
+ * interval follows the signal instead:
+ *
+ *   - While the value changes slower than rateBand (hundredths of standard
+ *     units per second) the interval grows by half per read, up to
+ *     rateMaxInterval
+ *   - A faster change, a NAN, or a value within INPUT_RATE_ALARM_MARGIN of
+ *     an enabled alarm threshold (now, or projected one interval ahead at
+ *     the current rate) snaps it straight back to the schedule interval
+ *
+ * A stable coolant temperature is then read a few times a second instead of
+ * 20, and loop time and bus bandwidth go to the channels that are moving.
+ * Configured with SET <pin> RATE, persisted in EEPROM.
+ *
+ * Build Flags:
+ *   -D INPUT_RATE_ALARM_MARGIN=f - Fraction of the alarm span treated as near (default 0.1)
+ */
+
+#ifndef INPUT_RATE_H
+#define INPUT_RATE_H
+
+#include <Arduino.h>
+#include "input.h"
+
+#ifndef INPUT_RATE_ALARM_MARGIN
+#define INPUT_RATE_ALARM_MARGIN 0.1f
+#endif
+
+// Interval until the next read of input (call after the read and filter stage)
+// baseInterval is the schedule interval - the fastest rate and the fixed-mode rate
+uint16_t getInputRateInterval(Input* input, uint16_t baseInterval, uint32_t now);
+
+// Forget rate history (configuration changed)
+void resetInputRate(Input* input);
+void resetInputRates();
+
+// True for fixed mode (maxInterval 0) or a usable adaptive setting
+bool isValidInputRate(uint16_t maxInterval, uint16_t band);
+
+// Print "FIXED" / "ADAPTIVE up to 1000ms, band 0.50/s" to the control port
+void printInputRate(const Input* input);
+
+#endif // INPUT_RATE_H
@@ -0,0 +1,67 @@
+/*
+ * input_snapshot.cpp - Published input values for the output modules
+ */
+
+#include "input_snapshot.h"
+#include "input_manager.h"
+#include "../lib/dual_core.h"
+
+static InputSample sampleBuffer[2][MAX_INPUTS];
+static uint8_t front = 0;
+static uint32_t version = 0;
+static uint8_t staged[(MAX_INPUTS + 7) / 8];   // Slots written to the back buffer this pass
+static bool anyStaged = false;
+
+#ifdef ENABLE_DUAL_CORE
+static InputSample readerCopy[2][MAX_INPUTS];   // loop(), acquisition task
+#endif
+
+void resetInputSnapshot() {
+    for (uint8_t b = 0; b < 2; b++) {
+        for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+            sampleBuffer[b][i].value = NAN;
+            sampleBuffer[b][i].readMs = 0;
+        }
+    }
+    memset(staged, 0, sizeof(staged));
+    anyStaged = false;
+    version++;
+}
+
+void stageInputSample(uint8_t slot, float value, uint32_t now) {
+    InputSample& sample = sampleBuffer[front ^ 1][slot];
+    sample.value = value;
+    sample.readMs = now;
+    staged[slot >> 3] |= 1 << (slot & 7);
+    anyStaged = true;
+}
+
+void publishInputSnapshot() {
+    if (!anyStaged) return;
+    dualCoreLock();
+    front ^= 1;
+    version++;
+    dualCoreUnlock();
+
+    // The new back buffer is a pass behind for the slots just published
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        if (staged[i >> 3] & (1 << (i & 7))) {
+            sampleBuffer[front ^ 1][i] = sampleBuffer[front][i];
+        }
+    }
+    memset(staged, 0, sizeof(staged));
+    anyStaged = false;
+}
+
+InputSnapshot getInputSnapshot() {
+#ifdef ENABLE_DUAL_CORE
+    InputSample* copy = readerCopy[onAcquisitionCore() ? 1 : 0];
+    dualCoreLock();
+    memcpy(copy, sampleBuffer[front], sizeof(readerCopy[0]));
+    InputSnapshot snapshot = { copy, version };
+    dualCoreUnlock();
+#else
+    InputSnapshot snapshot = { sampleBuffer[front], version };
+#endif
+    return snapshot;
+}
@@ -0,0 +1,56 @@
+/*
+ * input_snapshot.h - Published input values for the output modules
+ *
+ * Read functions update Input::value in place, one input at a time, at
+ * each input's own interval - and a read can take several steps (raw
+ * value, then the filter stage). Output modules read a published snapshot
+ * instead: every read stages { value, read time } in a back buffer, and the
+ * end of each sensor pass publishes it in one step by swapping buffers and
+ * bumping the version. An output pass takes the snapshot once, so every
+ * module and every value it sends come from the same published state, and
+ * each value carries the time it was read.
+ *
+ *   stageInputSample(slot, input->value, now);   // After each read+filter
+ *   publishInputSnapshot();                      // End of the sensor pass
+ *
+ *   InputSnapshot snap = getInputSnapshot();     // Output pass
+ *   float v = snap.samples[slot].value;
+ *
+ * No copy of the array: after a swap only the slots staged in that pass
+ * are carried into the new back buffer, so inputs read every pass cost one
+ * 8-byte copy and idle ones nothing.
+ *
+ * With ENABLE_DUAL_CORE (dual_core.h) the reads run on the other core, which
+ * may swap while an output pass still reads - so there getInputSnapshot()
+ * copies the front buffer, under the spinlock, into a buffer of the calling
+ * side's own and returns that.
+ */
+
+#ifndef INPUT_SNAPSHOT_H
+#define INPUT_SNAPSHOT_H
+
+#include <Arduino.h>
+#include "input.h"
+
+struct InputSample {
+    float value;        // Input::value after the read and filter stage (standard units)
+    uint32_t readMs;    // millis() of that read (0 = never read)
+};
+
+struct InputSnapshot {
+    const InputSample* samples;   // By input slot
+    uint32_t version;             // Bumped by every publish that carried a new sample
+};
+
+// All samples to NAN / never read (setup, input reconfiguration)
+void resetInputSnapshot();
+
+// Stage the result of a read - invisible to outputs until published
+void stageInputSample(uint8_t slot, float value, uint32_t now);
+
+// Make every staged sample visible at once (a no-op if nothing was staged)
+void publishInputSnapshot();
+
+InputSnapshot getInputSnapshot();
+
+#endif // INPUT_SNAPSHOT_H
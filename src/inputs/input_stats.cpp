@@ -0,0 +1,428 @@
+/*
+ * input_stats.cpp - Odometer, engine hours and time-at-temperature accumulators
+ *
+ * channels[] holds the totals in RAM, channelOf[] maps an input slot to its
+ * accumulator so a reading finds it without a search. The ring runs from
+ * STATS_ADDRESS (after a full alarm journal) to the end of the EEPROM, at
+ * most STATS_RECORDS slots. A snapshot copies one accumulator at a time into
+ * pending and writes it a byte at a time, checksum last.
+ */
+
+#ifdef ENABLE_STATS
+
+#include "input_stats.h"
+#include "input_manager.h"
+#include "alarm_journal.h"
+#include "../lib/application_presets.h"
+#include "../lib/message_api.h"
+#include "../lib/log_tags.h"
+#include <EEPROM.h>
+#include <math.h>
+
+#if defined(__AVR__)
+#include <avr/eeprom.h>
+#define STATS_BYTES_PER_UPDATE 1            // Each byte takes 3.3 ms
+#else
+#define STATS_BYTES_PER_UPDATE 16
+#endif
+
+#define RECORD_SIZE sizeof(StatsRecord)
+#define NO_CHANNEL 0xFF
+#define IDLE 0xFF
+
+static_assert(sizeof(StatsRecord) == 32, "Stats records are 32 bytes in EEPROM");
+
+#ifdef ENABLE_ALARMS
+#define STATS_ADDRESS ALARM_JOURNAL_END
+#else
+#define STATS_ADDRESS ALARM_JOURNAL_ADDRESS
+#endif
+
+struct StatsChannel {
+    InputPin pin;
+    uint8_t kind;                           // StatsKind
+    bool running;                           // Engine hours: the last reading was running
+    uint16_t partMs;                        // Time kinds: counted, not yet a whole second
+    float partMetres;                       // Distance: counted, not yet a whole metre
+    uint32_t lastMs;                        // Previous reading (0 = none yet)
+    uint32_t total[STATS_BANDS];
+};
+
+static StatsChannel channels[STATS_CHANNELS];
+static uint8_t numChannels;
+static uint8_t channelOf[MAX_INPUTS];
+static uint8_t supplySlot = NO_CHANNEL;     // PRIMARY_BATTERY input
+static bool supplyArmed;                    // Was above the brownout level since the last trigger
+static bool opened;                         // initInputStats() has found the head
+
+static uint16_t capacity;                   // Slots that fit (0 = totals not kept)
+static uint16_t nextSlot;
+static uint16_t nextSeq;
+
+static bool dirty;                          // Counted since the last snapshot started
+static bool saveRequested;
+static bool urgent;                         // Brownout: write the snapshot in one pass
+static uint32_t lastSnapshotMs;
+static uint32_t savedMs;                    // Last snapshot finished (0 = not this boot)
+
+static StatsRecord pending;
+static uint8_t writeIndex = IDLE;           // Accumulator being written
+static uint8_t byteOffset;
+
+static uint8_t checksumOf(const StatsRecord* record) {
+    const uint8_t* bytes = (const uint8_t*)record;
+    uint8_t sum = 0x5A;                     // Erased (0xFF) and zeroed slots never match
+    for (uint8_t i = 0; i < RECORD_SIZE - 1; i++) sum ^= bytes[i];
+    return sum;
+}
+
+static uint16_t slotAddress(uint16_t slot) {
+    return STATS_ADDRESS + slot * RECORD_SIZE;
+}
+
+static bool readRecord(uint16_t slot, StatsRecord* record) {
+    EEPROM.get(slotAddress(slot), *record);
+    return record->checksum == checksumOf(record);
+}
+
+static uint8_t kindOf(const Input* input) {
+    switch (input->measurementType) {
+        case MEASURE_SPEED:       return STATS_DISTANCE;
+        case MEASURE_RPM:         return STATS_ENGINE_HOURS;
+        case MEASURE_TEMPERATURE: return STATS_TIME_IN_BAND;
+        default:                  return 0;
+    }
+}
+
+static InputPin recordPin(const StatsRecord& record) {
+    return (InputPin)(record.pin | (record.pinHigh << 8));
+}
+
+// Newest record of the accumulator's pin and kind into its totals
+static void restoreChannel(StatsChannel* ch) {
+    bool found = false;
+    uint16_t newest = 0;
+    for (uint16_t slot = 0; slot < capacity; slot++) {
+        StatsRecord record;
+        if (!readRecord(slot, &record) || recordPin(record) != ch->pin || record.kind != ch->kind) continue;
+        if (!found || (int16_t)(record.seq - newest) > 0) {
+            memcpy(ch->total, record.total, sizeof(ch->total));
+            newest = record.seq;
+            found = true;
+        }
+    }
+}
+
+void initInputStats() {
+    uint32_t length = EEPROM.length();
+    capacity = 0;
+    if (length > STATS_ADDRESS) {
+        uint32_t fit = (length - STATS_ADDRESS) / RECORD_SIZE;
+        capacity = (fit < STATS_RECORDS) ? fit : STATS_RECORDS;
+    }
+    if (capacity < 2 * STATS_CHANNELS) {
+        capacity = 0;
+        msg.debug.warn(TAG_SYSTEM, "Stats: no EEPROM room after the alarm journal - totals not kept");
+    }
+
+    // Head: the newest valid record (serial order, so the sequence may wrap)
+    bool found = false;
+    uint16_t newestSlot = 0;
+    for (uint16_t slot = 0; slot < capacity; slot++) {
+        StatsRecord record;
+        if (!readRecord(slot, &record)) continue;
+        if (!found || (int16_t)(record.seq - nextSeq) > 0) {
+            nextSeq = record.seq;
+            newestSlot = slot;
+            found = true;
+        }
+    }
+    nextSlot = found ? (newestSlot + 1) % capacity : 0;
+    nextSeq = found ? nextSeq + 1 : 0;
+
+    opened = true;
+    bindInputStats();
+}
+
+void bindInputStats() {
+    if (!opened) return;                    // Boot: initInputStats() binds once the ring is open
+
+    StatsChannel previous[STATS_CHANNELS];
+    uint8_t numPrevious = numChannels;
+    memcpy(previous, channels, sizeof(channels));
+
+    uint8_t battery = getApplicationIndexByName("PRIMARY_BATTERY");
+    numChannels = 0;
+    supplySlot = NO_CHANNEL;
+    memset(channelOf, NO_CHANNEL, sizeof(channelOf));
+
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        const Input* input = &inputs[i];
+        if (input->pin == 0xFF) continue;
+        if (input->applicationIndex == battery && supplySlot == NO_CHANNEL) supplySlot = i;
+
+        uint8_t kind = kindOf(input);
+        if (kind == 0 || numChannels >= STATS_CHANNELS) continue;
+
+        StatsChannel* ch = &channels[numChannels];
+        uint8_t k = 0;
+        while (k < numPrevious && (previous[k].pin != input->pin || previous[k].kind != kind)) k++;
+        if (k < numPrevious) {
+            *ch = previous[k];              // Same input - keep its running totals
+        } else {
+            memset(ch, 0, sizeof(*ch));
+            ch->pin = input->pin;
+            ch->kind = kind;
+            restoreChannel(ch);
+        }
+        channelOf[i] = numChannels++;
+    }
+
+    // The snapshot being written may describe the old layout - start over
+    if (writeIndex != IDLE) {
+        writeIndex = IDLE;
+        saveRequested = true;
+    }
+}
+
+static void addTime(StatsChannel* ch, uint8_t band, uint32_t ms) {
+    ms += ch->partMs;
+    ch->total[band] += ms / 1000;
+    ch->partMs = ms % 1000;
+    dirty = true;
+}
+
+// Band of a temperature between the input's alarm thresholds
+static uint8_t bandOf(const Input* input, float value) {
+    if (value < input->minValue) return 0;
+    if (value >= input->maxValue) return STATS_BANDS - 1;
+    float span = input->maxValue - input->minValue;
+    uint8_t band = 1 + (uint8_t)((value - input->minValue) / span * (STATS_BANDS - 2));
+    return (band > STATS_BANDS - 2) ? STATS_BANDS - 2 : band;
+}
+
+// A supply that collapses can read NAN (out of range) as well as low
+static void checkSupply(float volts) {
+    if (volts >= STATS_BROWNOUT_V + 1.0f) {
+        supplyArmed = true;
+    } else if (supplyArmed && (isnan(volts) || volts < STATS_BROWNOUT_V)) {
+        supplyArmed = false;
+        saveRequested = true;
+        urgent = true;
+    }
+}
+
+void accumulateInputStats(const Input* input, uint32_t now) {
+    if (!opened) return;
+    uint8_t slot = input - inputs;
+    if (slot == supplySlot) checkSupply(input->value);
+    if (channelOf[slot] == NO_CHANNEL) return;
+
+    StatsChannel* ch = &channels[channelOf[slot]];
+    uint32_t dt = now - ch->lastMs;
+    bool counted = ch->lastMs != 0 && dt <= STATS_MAX_STEP_MS;
+    ch->lastMs = now ? now : 1;
+
+    float value = input->value;
+    switch (ch->kind) {
+        case STATS_DISTANCE:
+            if (counted && value > 0) {
+                ch->partMetres += value * (float)dt / 3600.0f;  // km/h x ms = metres x 3600
+                if (ch->partMetres >= 1.0f) {
+                    uint32_t whole = (uint32_t)ch->partMetres;
+                    ch->total[0] += whole;
+                    ch->partMetres -= whole;
+                    dirty = true;
+                }
+            }
+            break;
+
+        case STATS_ENGINE_HOURS: {
+            bool running = value >= STATS_RUNNING_RPM;      // NAN: not known to run
+            if (counted && running) addTime(ch, 0, dt);
+            if (ch->running && !running) saveRequested = true;  // Engine stopped
+            ch->running = running;
+            break;
+        }
+
+        case STATS_TIME_IN_BAND:
+            if (counted && !isnan(value)) addTime(ch, bandOf(input, value), dt);
+            break;
+    }
+}
+
+static void buildRecord(uint8_t c) {
+    memset(&pending, 0, sizeof(pending));
+    pending.seq = nextSeq++;
+    pending.pin = (uint8_t)channels[c].pin;
+    pending.pinHigh = channels[c].pin >> 8;
+    pending.kind = channels[c].kind;
+    memcpy(pending.total, channels[c].total, sizeof(pending.total));
+    pending.checksum = checksumOf(&pending);
+}
+
+void updateInputStats(uint32_t now) {
+    if (capacity == 0 || numChannels == 0) return;
+
+    if (writeIndex == IDLE) {
+        if (!saveRequested && !(dirty && now - lastSnapshotMs >= STATS_SAVE_MS)) return;
+        saveRequested = false;
+        dirty = false;
+        lastSnapshotMs = now;
+        writeIndex = 0;
+        byteOffset = 0;
+        buildRecord(0);
+    }
+
+    uint16_t budget = urgent ? 0xFFFF : STATS_BYTES_PER_UPDATE;
+    while (budget > 0 && writeIndex != IDLE) {
+#if defined(__AVR__)
+        if (!eeprom_is_ready()) return;     // Previous byte still being written
+#endif
+        const uint8_t* bytes = (const uint8_t*)&pending;
+        uint16_t addr = slotAddress(nextSlot) + byteOffset;
+        if (EEPROM.read(addr) != bytes[byteOffset]) {
+            EEPROM.write(addr, bytes[byteOffset]);
+            budget--;                       // Unchanged bytes cost nothing
+        }
+        if (++byteOffset < RECORD_SIZE) continue;
+
+        // Checksum written - the record is in the ring
+        byteOffset = 0;
+        nextSlot = (nextSlot + 1) % capacity;
+        if (++writeIndex < numChannels) {
+            buildRecord(writeIndex);
+            continue;
+        }
+        writeIndex = IDLE;
+        savedMs = now ? now : 1;
+        if (!saveRequested) urgent = false;
+#if defined(ESP32)
+        EEPROM.commit();                    // Emulated EEPROM: one sector write per snapshot
+#endif
+    }
+}
+
+void flushInputStats() {
+    if (capacity == 0 || numChannels == 0) return;
+    if (writeIndex == IDLE && !dirty && !saveRequested) return;  // Nothing since the last snapshot
+
+    // A snapshot already under way finishes first, then one of the current totals
+    saveRequested = true;
+    urgent = true;
+    uint32_t now = millis();
+    while (writeIndex != IDLE || saveRequested) {
+        updateInputStats(now);              // AVR: returns while a byte is programming - spin
+    }
+}
+
+bool resetInputStats(InputPin pin) {
+    bool found = false;
+    for (uint8_t c = 0; c < numChannels; c++) {
+        StatsChannel* ch = &channels[c];
+        if (pin != 0xFF && ch->pin != pin) continue;
+        memset(ch->total, 0, sizeof(ch->total));
+        ch->partMs = 0;
+        ch->partMetres = 0;
+        found = true;
+    }
+    if (found) saveRequested = true;
+    return found;
+}
+
+bool getEngineSeconds(uint8_t slot, uint32_t* seconds) {
+    if (slot >= MAX_INPUTS || channelOf[slot] >= numChannels) return false;
+    const StatsChannel* ch = &channels[channelOf[slot]];
+    if (ch->kind != STATS_ENGINE_HOURS) return false;
+    *seconds = ch->total[0];
+    return true;
+}
+
+// ===== STATUS =====
+
+static void printHours(uint32_t seconds) {
+    char text[16];
+    snprintf(text, sizeof(text), "%lu:%02lu", (unsigned long)(seconds / 3600),
+             (unsigned long)(seconds / 60 % 60));
+    msg.control.print(text);
+}
+
+static void printBands(const StatsChannel* ch, const Input* input) {
+    float edge[STATS_BANDS - 1];
+    for (uint8_t b = 0; b < STATS_BANDS - 1; b++) {
+        float value = input->minValue + (input->maxValue - input->minValue) * b / (STATS_BANDS - 2);
+        edge[b] = value * input->unitsFactor + input->unitsOffset;
+    }
+    for (uint8_t b = 0; b < STATS_BANDS; b++) {
+        msg.control.print(F("    "));
+        if (b == 0) {
+            msg.control.print(F("< "));
+            msg.control.print(edge[0], 0);
+        } else if (b == STATS_BANDS - 1) {
+            msg.control.print(F(">= "));
+            msg.control.print(edge[STATS_BANDS - 2], 0);
+        } else {
+            msg.control.print(edge[b - 1], 0);
+            msg.control.print('-');
+            msg.control.print(edge[b], 0);
+        }
+        msg.control.print(F(": "));
+        printHours(ch->total[b]);
+        msg.control.println();
+    }
+}
+
+void printInputStats() {
+    msg.control.println();
+    msg.control.print(F("===== Stats ("));
+    if (capacity == 0) {
+        msg.control.print(F("not saved - no EEPROM room"));
+    } else {
+        msg.control.print(capacity);
+        msg.control.print(F(" slots, "));
+        if (savedMs == 0) {
+            msg.control.print(F("not written this boot"));
+        } else {
+            msg.control.print(F("written "));
+            msg.control.print((millis() - savedMs) / 1000);
+            msg.control.print(F(" s ago"));
+        }
+    }
+    msg.control.println(F(") ====="));
+
+    for (uint8_t c = 0; c < numChannels; c++) {
+        const StatsChannel* ch = &channels[c];
+        const Input* input = getInputByPin(ch->pin);
+        if (input == nullptr) continue;
+
+        msg.control.print(F("  "));
+        printPin(ch->pin);
+        msg.control.print(F(" ("));
+        msg.control.print(input->abbrName);
+        msg.control.print(F(")  "));
+        switch (ch->kind) {
+            case STATS_DISTANCE:
+                msg.control.print(F("Distance: "));
+                msg.control.print(ch->total[0] / 1000.0f, 1);
+                msg.control.print(F(" km ("));
+                msg.control.print(ch->total[0] / 1609.344f, 1);
+                msg.control.println(F(" mi)"));
+                break;
+            case STATS_ENGINE_HOURS:
+                msg.control.print(F("Engine hours: "));
+                msg.control.print(ch->total[0] / 3600.0f, 1);
+                msg.control.println(F(" h"));
+                break;
+            case STATS_TIME_IN_BAND:
+                msg.control.print(F("Time in band (h:mm, "));
+                msg.control.print((const __FlashStringHelper*)input->unitsSymbol);
+                msg.control.println(F("):"));
+                printBands(ch, input);
+                break;
+        }
+    }
+    if (numChannels == 0) msg.control.println(F("  (no speed, RPM or temperature inputs)"));
+    msg.control.println();
+}
+
+#endif // ENABLE_STATS
@@ -0,0 +1,150 @@
+/*
+ * input_stats.h - Odometer, engine hours and time-at-temperature accumulators
+ *
+ * Running totals for maintenance, kept across power cycles, so the oil
+ * change interval or the hours a CHT spent near its limit are a STATS
+ * command away instead of a day of laptop logging. Each input gets an
+ * accumulator by its measurement type:
+ *
+ *   MEASURE_SPEED        distance driven (metres; the value is km/h)
+ *   MEASURE_RPM          engine hours (seconds at or above STATS_RUNNING_RPM)
+ *   MEASURE_TEMPERATURE  time in band (seconds in each of STATS_BANDS bands:
+ *                        below the alarm minimum, four equal bands up to
+ *                        the alarm maximum, at or above it)
+ *
+ * up to STATS_CHANNELS inputs, in slot order. The bands follow SET <pin>
+ * ALARM, so moving the thresholds moves the band edges of the totals
+ * already gathered.
+ *
+ * Accumulation: accumulateInputStats() is called with every reading
+ * (main.cpp, after the filter) and adds that reading over the time since the
+ * input's previous one - one multiply and an add, no scan. A gap longer than
+ * STATS_MAX_STEP_MS (CONFIG mode, a dead sensor) is not counted; readings
+ * that are NAN count nothing (and an engine reading NAN is not running).
+ *
+ * Persistence: a snapshot writes one 32-byte record per accumulator into a
+ * ring after the alarm journal. Like the journal there is no header to
+ * rewrite - each record carries a sequence number and the newest valid
+ * record of a pin wins at boot - and the bytes go out a few per loop
+ * (updateInputStats()). The ring holds at least two snapshots, so one cut
+ * off by a power loss leaves the previous one whole. A snapshot is taken:
+ *   - STATS_SAVE_MS after the previous one, if anything was counted
+ *   - when the engine stops (an engine hours input drops below running)
+ *   - at once on brownout - the PRIMARY_BATTERY input, after reading above
+ *     STATS_BROWNOUT_V + 1 V, reads below it or NAN: the whole snapshot in
+ *     one pass (AVR: still a byte per loop), so a supply with enough
+ *     hold-up capacitance rides through the write
+ * What was counted after the last snapshot is lost to a power cut without
+ * warning.
+ *
+ * Usage:
+ *   initInputStats();                   // setup(), after the config is loaded
+ *   bindInputStats();                   // rebuildInputSchedule() does this
+ *   accumulateInputStats(input, now);   // with every reading
+ *   updateInputStats(now);              // every loop, CONFIG mode too
+ *   flushInputStats();                  // supply failing - a snapshot, now
+ *
+ * Build Flags:
+ *   -D ENABLE_STATS            - Accumulators and the STATS command
+ *   -D STATS_CHANNELS=n        - Inputs with an accumulator (default 8; 4 on AVR)
+ *   -D STATS_RECORDS=n         - Ring slots of 32 bytes (default 4 x STATS_CHANNELS)
+ *   -D STATS_SAVE_MS=n         - Longest time between snapshots (default 600000)
+ *   -D STATS_RUNNING_RPM=n     - RPM that counts as running (default 400)
+ *   -D STATS_BROWNOUT_V=n      - Battery voltage that triggers a snapshot (default 8.0)
+ *   -D STATS_MAX_STEP_MS=n     - Longest gap between readings that is counted (default 5000)
+ */
+
+#ifndef INPUT_STATS_H
+#define INPUT_STATS_H
+
+#include <Arduino.h>
+#include "input.h"
+
+#ifdef ENABLE_STATS
+
+#ifndef STATS_CHANNELS
+#if defined(__AVR__)
+#define STATS_CHANNELS 4
+#else
+#define STATS_CHANNELS 8
+#endif
+#endif
+
+#ifndef STATS_RECORDS
+#define STATS_RECORDS (4 * STATS_CHANNELS)
+#endif
+
+#ifndef STATS_SAVE_MS
+#define STATS_SAVE_MS 600000UL
+#endif
+
+#ifndef STATS_RUNNING_RPM
+#define STATS_RUNNING_RPM 400
+#endif
+
+#ifndef STATS_BROWNOUT_V
+#define STATS_BROWNOUT_V 8.0f
+#endif
+
+#ifndef STATS_MAX_STEP_MS
+#define STATS_MAX_STEP_MS 5000
+#endif
+
+static_assert(STATS_RECORDS >= 2 * STATS_CHANNELS, "The stats ring must hold two snapshots");
+
+#define STATS_BANDS 6                       // Below min, 4 equal bands, at or above max
+
+enum StatsKind : uint8_t {
+    STATS_DISTANCE = 1,                     // total[0]: metres
+    STATS_ENGINE_HOURS,                     // total[0]: seconds running
+    STATS_TIME_IN_BAND                      // total[0..STATS_BANDS-1]: seconds
+};
+
+// One accumulator as stored (32 bytes)
+struct StatsRecord {
+    uint16_t seq;                           // Write order; a pin's newest record wins
+    uint8_t pin;                            // Bits 0-7
+    uint8_t kind;                           // StatsKind
+    uint32_t total[STATS_BANDS];
+    uint8_t pinHigh;                        // Bits 8-15 (wide CAN pins)
+    uint8_t reserved[2];
+    uint8_t checksum;                       // Written last
+};
+
+// Find the ring's head, then bind the configured inputs
+void initInputStats();
+
+// Give the inputs their accumulators (totals of inputs that keep theirs carry over)
+void bindInputStats();
+
+// Count a reading
+void accumulateInputStats(const Input* input, uint32_t now);
+
+// Start snapshots when due, write a few bytes of one
+void updateInputStats(uint32_t now);
+
+// Write a snapshot of the current totals now (blocking - the power-fail path,
+// lib/power_fail.h); nothing if nothing was counted since the last one
+void flushInputStats();
+
+// Totals, and when they were last written (STATS)
+void printInputStats();
+
+// Zero one input's totals, or all (pin 0xFF); false if the pin has none
+bool resetInputStats(InputPin pin);
+
+// Engine hours (seconds) of the input in slot; false if it has no engine hours accumulator
+bool getEngineSeconds(uint8_t slot, uint32_t* seconds);
+
+#else
+
+inline void initInputStats() {}
+inline void bindInputStats() {}
+inline void accumulateInputStats(const Input*, uint32_t) {}
+inline void updateInputStats(uint32_t) {}
+inline void flushInputStats() {}
+inline bool getEngineSeconds(uint8_t, uint32_t*) { return false; }
+
+#endif // ENABLE_STATS
+
+#endif // INPUT_STATS_H
@@ -0,0 +1,106 @@
+/*
+ * input_summary.cpp - Per-input running statistics since boot and per session
+ */
+
+#include "input_summary.h"
+
+#if INPUT_SUMMARY
+
+#include "input_manager.h"
+#include "../lib/message_api.h"
+#include <math.h>
+
+static InputSummary summary[MAX_INPUTS];
+
+static inline InputSummary* summaryOf(const Input* input) {
+    uint8_t idx = input - inputs;
+    return (idx < MAX_INPUTS) ? &summary[idx] : nullptr;
+}
+
+static void addReading(InputSummaryWindow* w, float value, uint32_t now) {
+    if (w->count == 0 || value < w->min) {
+        w->min = value;
+        w->minMs = now;
+    }
+    if (w->count == 0 || value > w->max) {
+        w->max = value;
+        w->maxMs = now;
+    }
+    if (w->count < 0xFFFFFFFF) w->count++;
+    float delta = value - w->mean;
+    w->mean += delta / (float)w->count;
+    w->m2 += delta * (value - w->mean);
+}
+
+void recordInputSummary(const Input* input, uint32_t now) {
+    InputSummary* s = summaryOf(input);
+    if (s == nullptr || isnan(input->value)) return;
+    addReading(&s->boot, input->value, now);
+    addReading(&s->session, input->value, now);
+}
+
+const InputSummary* getInputSummary(const Input* input) {
+    return summaryOf(input);
+}
+
+float getSummaryStdDev(const InputSummaryWindow* window) {
+    if (window->count < 2 || window->m2 <= 0) return 0;
+    return sqrtf(window->m2 / (float)(window->count - 1));
+}
+
+void resetInputSummary(const Input* input) {
+    InputSummary* s = summaryOf(input);
+    if (s == nullptr) return;
+    memset(s, 0, sizeof(InputSummary));
+    s->sessionStartMs = millis();
+}
+
+void resetInputSession(const Input* input, uint32_t now) {
+    InputSummary* s = summaryOf(input);
+    if (s == nullptr) return;
+    memset(&s->session, 0, sizeof(InputSummaryWindow));
+    s->sessionStartMs = now;
+}
+
+static void printAgo(uint32_t now, uint32_t ms) {
+    msg.control.print(F(" ("));
+    msg.control.print((now - ms) / 1000);
+    msg.control.print(F("s ago)"));
+}
+
+static void printWindow(const Input* input, const InputSummaryWindow* w, uint32_t now) {
+    if (w->count == 0) {
+        msg.control.println(F("no readings"));
+        return;
+    }
+    const __FlashStringHelper* units = (const __FlashStringHelper*)input->unitsSymbol;
+    msg.control.print(w->count);
+    msg.control.print(F(" readings, min "));
+    msg.control.print(w->min * input->unitsFactor + input->unitsOffset, 2);
+    printAgo(now, w->minMs);
+    msg.control.print(F(", mean "));
+    msg.control.print(w->mean * input->unitsFactor + input->unitsOffset, 2);
+    msg.control.print(F(", max "));
+    msg.control.print(w->max * input->unitsFactor + input->unitsOffset, 2);
+    printAgo(now, w->maxMs);
+    msg.control.print(F(", sd "));
+    msg.control.print(getSummaryStdDev(w) * fabsf(input->unitsFactor), 2);
+    msg.control.print(' ');
+    msg.control.println(units);
+}
+
+void printInputSummary(const Input* input) {
+    const InputSummary* s = summaryOf(input);
+    if (s == nullptr) return;
+    uint32_t now = millis();
+
+    msg.control.print(F("  Since Boot: "));
+    printWindow(input, &s->boot, now);
+
+    msg.control.print(F("  Session ("));
+    msg.control.print((now - s->sessionStartMs) / 1000);
+    msg.control.print(F("s): "));
+    printWindow(input, &s->session, now);
+}
+
+#endif // INPUT_SUMMARY
@@ -0,0 +1,84 @@
+/*
+ * input_summary.h - Per-input running statistics since boot and per session
+ *
+ * Every reading (after the filter, the value outputs see) is folded into two
+ * windows per input - since boot and since the session was last reset -
+ * with Welford's update: count, mean and the sum of squared differences
+ * (for the standard deviation), plus min and max and the millis() at which
+ * each was seen. Fixed state, O(1) per reading, no samples kept, so an
+ * engine-health summary of a whole drive needs no full-rate log.
+ *
+ * NAN readings are not counted (input_health.h has those). The boot
+ * window restarts with the input's read health (sensor changed, input
+ * cleared or reloaded); the session also restarts on INFO <pin> SUMMARY
+ * RESET, or INFO ALL SUMMARY RESET for every input.
+ *
+ * Exported through INFO <pin> (session line), INFO <pin> SUMMARY and the
+ * JSON dump ("summary").
+ *
+ * Build Flags:
+ *   -D INPUT_SUMMARY=0|1 - Keep the statistics (default 1; 0 on Uno - 60 bytes per input)
+ */
+
+#ifndef INPUT_SUMMARY_H
+#define INPUT_SUMMARY_H
+
+#include <Arduino.h>
+#include "input.h"
+
+#ifndef INPUT_SUMMARY
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
+#define INPUT_SUMMARY 0
+#else
+#define INPUT_SUMMARY 1
+#endif
+#endif
+
+struct InputSummaryWindow {
+    uint32_t count;             // Readings counted (0 = none yet)
+    float mean;
+    float m2;                   // Sum of squared differences from the mean
+    float min;
+    float max;
+    uint32_t minMs;             // millis() of the min / max reading
+    uint32_t maxMs;
+};
+
+struct InputSummary {
+    InputSummaryWindow boot;    // Since boot or the input was last reconfigured
+    InputSummaryWindow session; // Since the last session reset
+    uint32_t sessionStartMs;
+};
+
+#if INPUT_SUMMARY
+
+// Count the reading in input->value (call after every read, after filtering)
+void recordInputSummary(const Input* input, uint32_t now);
+
+// Statistics of input (nullptr if input is not in inputs[])
+const InputSummary* getInputSummary(const Input* input);
+
+// Standard deviation of a window (0 with fewer than two readings)
+float getSummaryStdDev(const InputSummaryWindow* window);
+
+// Restart both windows (input reconfigured)
+void resetInputSummary(const Input* input);
+
+// Restart the session window of one input
+void resetInputSession(const Input* input, uint32_t now);
+
+// Print both windows to the control port
+void printInputSummary(const Input* input);
+
+#else
+
+inline void recordInputSummary(const Input*, uint32_t) {}
+inline const InputSummary* getInputSummary(const Input*) { return nullptr; }
+inline float getSummaryStdDev(const InputSummaryWindow*) { return 0; }
+inline void resetInputSummary(const Input*) {}
+inline void resetInputSession(const Input*, uint32_t) {}
+inline void printInputSummary(const Input*) {}
+
+#endif // INPUT_SUMMARY
+
+#endif // INPUT_SUMMARY_H
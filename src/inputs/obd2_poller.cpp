@@ -0,0 +1,395 @@
+/*
+ * obd2_poller.cpp - Active OBD-II Mode 01 poller
+ */
+
+#include "obd2_poller.h"
+#include "input_manager.h"
+#include "sensors/can/can_frame_cache.h"
+#include "sensors/can/can_scan.h"
+#include "../lib/can_tx.h"
+#include "../lib/isotp.h"
+#include "../lib/message_api.h"
+#include "../lib/log_tags.h"
+
+// SAE J1979 Mode 01 response data lengths, PIDs 0x00-0x64 (0 = unknown)
+// Multi-PID answers carry no lengths of their own; PIDs outside the table
+// are requested one at a time and read to the end of the answer.
+static const uint8_t OBD2_PID_LENGTHS[] PROGMEM = {
+    4, 4, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 2, 1, 1, 1,   // 0x00
+    2, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1, 2,   // 0x10
+    4, 2, 2, 2, 4, 4, 4, 4, 4, 4, 4, 4, 1, 1, 1, 1,   // 0x20
+    1, 2, 2, 1, 4, 4, 4, 4, 4, 4, 4, 4, 2, 2, 2, 2,   // 0x30
+    4, 4, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 4,   // 0x40
+    4, 1, 1, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1, 2, 2, 1,   // 0x50
+    4, 1, 1, 2, 5                                     // 0x60
+};
+
+static uint8_t getOBD2PIDLength(uint8_t pid) {
+    if (pid >= sizeof(OBD2_PID_LENGTHS)) return 0;
+    return pgm_read_byte(&OBD2_PID_LENGTHS[pid]);
+}
+
+// Change slowly - polled every OBD2_POLL_SLOW_FACTOR read intervals
+static bool isSlowOBD2PID(uint8_t pid, MeasurementType type) {
+    if (type == MEASURE_TEMPERATURE) return true;
+    switch (pid) {
+        case 0x1F:  // Run time since start
+        case 0x21:  // Distance with MIL on
+        case 0x2F:  // Fuel tank level
+        case 0x31:  // Distance since codes cleared
+        case 0x33:  // Barometric pressure
+        case 0x4D:  // Time with MIL on
+        case 0x4E:  // Time since codes cleared
+            return true;
+        default:
+            return false;
+    }
+}
+
+// ============================================================================
+// INTERNAL STATE
+// ============================================================================
+
+struct OBD2PollPID {
+    uint8_t ecu;            // Response ID - OBD2_RESPONSE_ID_BASE
+    uint8_t pid;
+    uint8_t length;         // J1979 data length, 0 = unknown (requested alone)
+    uint8_t misses;         // Consecutive requests it went unanswered
+    uint16_t interval;      // Poll interval in ms
+    uint32_t due;           // millis() when it should next be requested
+};
+
+struct OBD2PollECU {
+    bool multiPid;          // Answers several PIDs per request
+    uint8_t multiStrikes;   // Multi-PID answers in a row with only the first PID
+    uint16_t responseMs;    // Smoothed response time, 0 until measured
+};
+
+static OBD2PollPID pollPIDs[MAX_INPUTS];
+static uint8_t numPollPIDs = 0;
+static OBD2PollECU pollECUs[OBD2_MAX_ECUS];
+
+static bool pollEnabled = false;
+static uint8_t pollBus = 0;
+
+// Request in flight
+static bool requestBusy = false;
+static uint8_t requestECU = 0;
+static uint8_t requestSlots[OBD2_POLL_MAX_PIDS_PER_REQUEST];  // Indexes into pollPIDs
+static uint8_t requestCount = 0;
+static uint32_t requestSentMs = 0;
+static uint32_t lastExchangeMs = 0;
+static IsoTpReceiver pollRx;
+
+// Statistics since the last reset
+static uint32_t statRequests = 0;
+static uint32_t statAnswers = 0;    // PIDs answered
+static uint32_t statTimeouts = 0;
+
+// ============================================================================
+// CONFIGURATION
+// ============================================================================
+
+void resetOBD2Poller(uint8_t bus, bool enabled) {
+    pollBus = bus;
+    pollEnabled = enabled;
+    numPollPIDs = 0;
+    requestBusy = false;
+    isotpReset(&pollRx);
+    for (uint8_t i = 0; i < OBD2_MAX_ECUS; i++) {
+        pollECUs[i].multiPid = true;
+        pollECUs[i].multiStrikes = 0;
+        pollECUs[i].responseMs = 0;
+    }
+    statRequests = 0;
+    statAnswers = 0;
+    statTimeouts = 0;
+}
+
+void addOBD2PollPID(uint16_t can_id, uint8_t pid, const Input* input, uint16_t timeout_ms) {
+    if (!pollEnabled) return;
+    if (can_id < OBD2_RESPONSE_ID_BASE || can_id >= OBD2_RESPONSE_ID_BASE + OBD2_MAX_ECUS) return;
+
+    // Poll as often as the input is read - unscheduled (disabled) inputs need nothing
+    uint16_t interval = 0;
+    for (uint8_t i = 0; i < numScheduledInputs; i++) {
+        if (inputSchedule[i].input == input) {
+            interval = inputSchedule[i].interval;
+            break;
+        }
+    }
+    if (interval == 0) return;
+
+    if (isSlowOBD2PID(pid, input->measurementType)) {
+        uint32_t slow = (uint32_t)interval * OBD2_POLL_SLOW_FACTOR;
+        uint16_t limit = timeout_ms / 2;  // Two chances before the input goes stale
+        if (slow > limit) slow = limit;
+        if (slow > interval) interval = (uint16_t)slow;
+    }
+
+    uint8_t ecu = can_id - OBD2_RESPONSE_ID_BASE;
+    for (uint8_t i = 0; i < numPollPIDs; i++) {
+        if (pollPIDs[i].ecu == ecu && pollPIDs[i].pid == pid) {
+            if (interval < pollPIDs[i].interval) pollPIDs[i].interval = interval;
+            return;
+        }
+    }
+    if (numPollPIDs >= MAX_INPUTS) return;
+
+    OBD2PollPID* p = &pollPIDs[numPollPIDs++];
+    p->ecu = ecu;
+    p->pid = pid;
+    p->length = getOBD2PIDLength(pid);
+    p->misses = 0;
+    p->interval = interval;
+    p->due = millis();
+}
+
+// ============================================================================
+// REQUESTS
+// ============================================================================
+
+// Timeout for the request in flight - a few response times, once measured
+static uint16_t getRequestTimeout() {
+    uint16_t measured = pollECUs[requestECU].responseMs;
+    if (measured == 0) return OBD2_POLL_TIMEOUT_MS;
+    uint32_t timeout = (uint32_t)measured * 4;
+    if (timeout < OBD2_POLL_MIN_TIMEOUT_MS) timeout = OBD2_POLL_MIN_TIMEOUT_MS;
+    if (timeout > OBD2_POLL_TIMEOUT_MS) timeout = OBD2_POLL_TIMEOUT_MS;
+    return (uint16_t)timeout;
+}
+
+static bool isRequested(uint8_t slot) {
+    for (uint8_t k = 0; k < requestCount; k++) {
+        if (requestSlots[k] == slot) return true;
+    }
+    return false;
+}
+
+/**
+ * Pick the PIDs for the next request and send it
+ * The most overdue PID chooses the ECU; the request fills up with that
+ * ECU's other PIDs in order of due time, including those due within half
+ * an interval. PIDs of unknown length go alone.
+ */
+static void sendNextOBD2Request(uint32_t now) {
+    requestCount = 0;
+
+    // Most overdue PID
+    uint8_t first = 0xFF;
+    for (uint8_t i = 0; i < numPollPIDs; i++) {
+        if ((int32_t)(now - pollPIDs[i].due) < 0) continue;
+        if (first == 0xFF || (int32_t)(pollPIDs[first].due - pollPIDs[i].due) > 0) first = i;
+    }
+    if (first == 0xFF) return;
+
+    requestECU = pollPIDs[first].ecu;
+    requestSlots[requestCount++] = first;
+
+    uint8_t limit = pollECUs[requestECU].multiPid ? OBD2_POLL_MAX_PIDS_PER_REQUEST : 1;
+    if (pollPIDs[first].length == 0) limit = 1;
+
+    while (requestCount < limit) {
+        uint8_t next = 0xFF;
+        for (uint8_t i = 0; i < numPollPIDs; i++) {
+            const OBD2PollPID* p = &pollPIDs[i];
+            if (p->ecu != requestECU || p->length == 0 || isRequested(i)) continue;
+            if ((int32_t)(now + p->interval / 2 - p->due) < 0) continue;  // Not nearly due
+            if (next == 0xFF || (int32_t)(pollPIDs[next].due - p->due) > 0) next = i;
+        }
+        if (next == 0xFF) break;
+        requestSlots[requestCount++] = next;
+    }
+
+    uint8_t payload[1 + OBD2_POLL_MAX_PIDS_PER_REQUEST];
+    payload[0] = 0x01;  // Mode 01 - current data
+    for (uint8_t k = 0; k < requestCount; k++) {
+        OBD2PollPID* p = &pollPIDs[requestSlots[k]];
+        payload[1 + k] = p->pid;
+        // Next due from now whatever the answer, so the schedule doesn't drift with the ECU
+        p->due = now + (p->misses >= OBD2_POLL_MAX_MISSES ? OBD2_POLL_RETRY_MS : p->interval);
+    }
+
+    uint8_t frame[ISOTP_FRAME_LEN];
+    isotpBuildSingleFrame(frame, payload, 1 + requestCount);
+
+#ifdef OBD2_POLL_FUNCTIONAL
+    uint32_t requestId = OBD2_FUNCTIONAL_ID;
+#else
+    uint32_t requestId = OBD2_REQUEST_ID_BASE + requestECU;
+#endif
+    if (!queueCANTx(pollBus, requestId, frame, ISOTP_FRAME_LEN, false, CAN_TX_URGENT)) {
+        return;  // TX queue full - the PIDs come round again next interval
+    }
+
+    isotpReset(&pollRx);
+    requestBusy = true;
+    requestSentMs = now;
+    statRequests++;
+}
+
+/**
+ * Close the request in flight
+ * @param answered  Bit k set: requestSlots[k] was in the answer
+ * @param rxMs      When the answer completed (0 on timeout)
+ */
+static void finishOBD2Request(uint8_t answered, uint32_t rxMs) {
+    OBD2PollECU* ecu = &pollECUs[requestECU];
+
+    if (answered) {
+        uint16_t elapsed = (uint16_t)(rxMs - requestSentMs);
+        ecu->responseMs = ecu->responseMs ? (uint16_t)((ecu->responseMs * 7u + elapsed) / 8) : elapsed;
+        if (ecu->responseMs == 0) ecu->responseMs = 1;
+
+        // Only the first PID answered: an unsupported PID once, an ECU that
+        // takes one PID per request if it keeps happening
+        if (requestCount > 1 && ecu->multiPid) {
+            if (answered != 0x01) {
+                ecu->multiStrikes = 0;
+            } else if (++ecu->multiStrikes >= OBD2_POLL_MAX_MISSES) {
+                ecu->multiPid = false;
+                msg.debug.info(TAG_CAN, "OBD-II poll: ECU 0x%03X answers one PID per request",
+                               OBD2_RESPONSE_ID_BASE + requestECU);
+            }
+        }
+    }
+
+    for (uint8_t k = 0; k < requestCount; k++) {
+        OBD2PollPID* p = &pollPIDs[requestSlots[k]];
+        if (answered & (1 << k)) {
+            p->misses = 0;
+        } else if (p->misses < 0xFF) {
+            p->misses++;
+        }
+    }
+
+    requestBusy = false;
+    lastExchangeMs = rxMs ? rxMs : millis();
+}
+
+/**
+ * Split a complete Mode 01 answer into its PIDs and cache each one
+ * [0x41 pidA dataA... pidB dataB...] or [0x7F 0x01 nrc]
+ * @return  Bit k set for each requestSlots[k] answered
+ */
+static uint8_t parseOBD2Answer(const uint8_t* data, uint16_t length, uint32_t rxMs, uint64_t rxUs, bool scanning) {
+    uint16_t responseId = OBD2_RESPONSE_ID_BASE + requestECU;
+
+    if (length >= 3 && data[0] == 0x7F && data[1] == 0x01) {
+        // Negative response - a multi-PID request the ECU won't take
+        if (requestCount > 1 && pollECUs[requestECU].multiPid) {
+            pollECUs[requestECU].multiPid = false;
+            msg.debug.info(TAG_CAN, "OBD-II poll: ECU 0x%03X rejects multi-PID requests (NRC 0x%02X)",
+                           responseId, data[2]);
+        }
+        return 0;
+    }
+    if (length < 2 || data[0] != 0x41) return 0;
+
+    uint8_t answered = 0;
+    uint16_t pos = 1;
+    while (pos < length) {
+        uint8_t pid = data[pos];
+        uint8_t k = 0;
+        while (k < requestCount && pollPIDs[requestSlots[k]].pid != pid) k++;
+        if (k == requestCount) break;  // Not asked for - can't know its length
+
+        uint16_t dataLength = pollPIDs[requestSlots[k]].length;
+        if (dataLength == 0) dataLength = length - pos - 1;  // Requested alone - rest of the answer
+        if (dataLength == 0 || pos + 1 + dataLength > length) break;
+
+        const uint8_t* pidData = &data[pos + 1];
+        if (scanning) recordCANScanFrame(responseId, pid, pidData, dataLength, rxMs);
+        updateCANCache(responseId, pid, pidData, dataLength, rxUs);
+        answered |= (1 << k);
+        statAnswers++;
+        pos += 1 + dataLength;
+    }
+    return answered;
+}
+
+void updateOBD2Poller(uint32_t now) {
+    if (!pollEnabled || numPollPIDs == 0) return;
+
+    if (requestBusy) {
+        // Multi-frame answer under way - the transport times out between frames
+        uint32_t since = pollRx.active ? pollRx.lastFrameMs : requestSentMs;
+        uint16_t timeout = pollRx.active ? ISOTP_TIMEOUT_MS : getRequestTimeout();
+        if ((uint32_t)(now - since) <= timeout) return;
+        statTimeouts++;
+        finishOBD2Request(0, 0);
+    }
+
+    if ((uint32_t)(now - lastExchangeMs) < OBD2_POLL_MIN_GAP_MS) return;
+    sendNextOBD2Request(now);
+}
+
+bool handleOBD2PollFrame(uint32_t can_id, const uint8_t* data, uint8_t len, uint32_t rxMs, uint64_t rxUs,
+                         bool scanning) {
+    if (!pollEnabled || !requestBusy) return false;
+    if (can_id != (uint32_t)OBD2_RESPONSE_ID_BASE + requestECU) return false;
+
+    IsoTpRxStatus status = isotpReceive(&pollRx, data, len, rxMs);
+    uint8_t flow[ISOTP_FRAME_LEN];
+
+    switch (status) {
+        case ISOTP_RX_FIRST_FRAME:
+            // Send the rest at once - no block limit, no separation time
+            isotpBuildFlowControl(flow, ISOTP_FC_CONTINUE, 0, 0);
+            queueCANTx(pollBus, OBD2_REQUEST_ID_BASE + requestECU, flow, ISOTP_FRAME_LEN, false, CAN_TX_URGENT);
+            return true;
+
+        case ISOTP_RX_IN_PROGRESS:
+            return true;
+
+        case ISOTP_RX_OVERFLOW:
+            isotpBuildFlowControl(flow, ISOTP_FC_OVERFLOW, 0, 0);
+            queueCANTx(pollBus, OBD2_REQUEST_ID_BASE + requestECU, flow, ISOTP_FRAME_LEN, false, CAN_TX_URGENT);
+            msg.debug.warn(TAG_CAN, "OBD-II poll: answer from 0x%03X exceeds %d bytes", can_id, ISOTP_MAX_PAYLOAD);
+            finishOBD2Request(0, rxMs);
+            return true;
+
+        case ISOTP_RX_COMPLETE: {
+            uint8_t answered = parseOBD2Answer(pollRx.data, pollRx.length, rxMs, rxUs, scanning);
+            finishOBD2Request(answered, rxMs);
+            // Back to back - the ECU's answer paces the next request
+            if (OBD2_POLL_MIN_GAP_MS == 0) sendNextOBD2Request(millis());
+            return true;
+        }
+
+        case ISOTP_RX_ERROR:
+            finishOBD2Request(0, rxMs);
+            return true;
+
+        default:
+            return false;  // Not transport framing we expect - let the passive path look
+    }
+}
+
+void printOBD2PollerStatus() {
+    if (!pollEnabled) return;
+
+    msg.control.print(F("Poll:   "));
+    msg.control.print(numPollPIDs);
+    msg.control.print(F(" PIDs, "));
+    msg.control.print(statRequests);
+    msg.control.print(F(" requests, "));
+    msg.control.print(statAnswers);
+    msg.control.print(F(" answers, "));
+    msg.control.print(statTimeouts);
+    msg.control.println(F(" timeouts"));
+
+    for (uint8_t e = 0; e < OBD2_MAX_ECUS; e++) {
+        uint8_t count = 0;
+        for (uint8_t i = 0; i < numPollPIDs; i++) {
+            if (pollPIDs[i].ecu == e) count++;
+        }
+        if (count == 0) continue;
+        char line[64];
+        snprintf(line, sizeof(line), "  ECU 0x%03X: %d PIDs, %s, response %u ms",
+                 OBD2_RESPONSE_ID_BASE + e, count,
+                 pollECUs[e].multiPid ? "multi-PID" : "single PID",
+                 pollECUs[e].responseMs);
+        msg.control.println(line);
+    }
+}
@@ -0,0 +1,106 @@
+/*
+ * obd2_poller.h - Active OBD-II Mode 01 poller
+ *
+ * Many vehicles only answer OBD-II when asked. With the input bus in POLL
+ * mode (BUS CAN INPUT <bus> POLL) the poller requests the PIDs that
+ * configured CAN inputs read on an ECU response ID (0x7E8-0x7EF) itself:
+ *
+ * - Up to OBD2_POLL_MAX_PIDS_PER_REQUEST PIDs per Mode 01 request; the
+ *   ECU's multi-PID answer arrives in one ISO-TP exchange (lib/isotp.h),
+ *   with the Flow Control sent from here
+ * - Physical addressing, 0x7E0+n for the ECU answering on 0x7E8+n
+ *   (-D OBD2_POLL_FUNCTIONAL requests on 0x7DF instead)
+ * - One request in flight; the next goes out as soon as the answer is
+ *   complete, and the response timeout follows the ECU's measured response
+ *   time, so the poll rate paces itself to the ECU
+ * - Each PID is due at the read interval of the fastest input that reads
+ *   it; temperatures and other slow PIDs every OBD2_POLL_SLOW_FACTOR
+ *   intervals (within their stale timeout), so RPM and speed get the
+ *   bandwidth. Requests take the most overdue PIDs first and fill up with
+ *   PIDs due within half an interval
+ * - ECUs that ignore or reject multi-PID requests drop to one PID per
+ *   request; PIDs that stay unanswered back off to OBD2_POLL_RETRY_MS
+ *
+ * Answers land in the frame cache under the response ID and PID, exactly
+ * like the passively received single-PID responses.
+ *
+ * Build Flags:
+ *   -D OBD2_POLL_TIMEOUT_MS=n    - Longest wait for an answer (default 100)
+ *   -D OBD2_POLL_MIN_GAP_MS=n    - Quiet time between requests (default 0)
+ *   -D OBD2_POLL_SLOW_FACTOR=n   - Slow PIDs poll this many intervals apart (default 10)
+ *   -D OBD2_POLL_RETRY_MS=n      - Retry period for PIDs the ECU doesn't answer (default 5000)
+ *   -D OBD2_POLL_FUNCTIONAL      - Send requests to the functional address 0x7DF
+ */
+
+#ifndef OBD2_POLLER_H
+#define OBD2_POLLER_H
+
+#include <Arduino.h>
+#include "input.h"
+
+#define OBD2_POLL_MAX_PIDS_PER_REQUEST 6    // SAE J1979 limit
+
+#define OBD2_REQUEST_ID_BASE   0x7E0        // Physical request to ECU n: 0x7E0 + n
+#define OBD2_RESPONSE_ID_BASE  0x7E8        // Response from ECU n: 0x7E8 + n
+#define OBD2_FUNCTIONAL_ID     0x7DF
+#define OBD2_MAX_ECUS          8
+
+#ifndef OBD2_POLL_TIMEOUT_MS
+#define OBD2_POLL_TIMEOUT_MS 100
+#endif
+
+#ifndef OBD2_POLL_MIN_GAP_MS
+#define OBD2_POLL_MIN_GAP_MS 0
+#endif
+
+#ifndef OBD2_POLL_SLOW_FACTOR
+#define OBD2_POLL_SLOW_FACTOR 10
+#endif
+
+#ifndef OBD2_POLL_RETRY_MS
+#define OBD2_POLL_RETRY_MS 5000
+#endif
+
+#define OBD2_POLL_MIN_TIMEOUT_MS 20         // Floor for the adaptive response timeout
+#define OBD2_POLL_MAX_MISSES     3          // Unanswered requests before a PID backs off
+
+/**
+ * Forget the polled PIDs and ECU state
+ * Called when the CAN input subscriptions are rebuilt.
+ *
+ * @param bus      Input bus requests go out on
+ * @param enabled  Input bus in POLL mode and running
+ */
+void resetOBD2Poller(uint8_t bus, bool enabled);
+
+/**
+ * Poll (can_id, pid) for input - ignored unless can_id is an ECU response ID
+ * 0x7E8-0x7EF and the input is scheduled. Several inputs may read one PID;
+ * the fastest sets its poll interval.
+ *
+ * @param timeout_ms  The input's stale timeout (slow PIDs are polled within it)
+ */
+void addOBD2PollPID(uint16_t can_id, uint8_t pid, const Input* input, uint16_t timeout_ms);
+
+/**
+ * Send the next request when the previous one is answered or timed out
+ * Called from updateCANInput() every loop.
+ */
+void updateOBD2Poller(uint32_t now);
+
+/**
+ * Offer a received frame to the poller (CAN input receive path)
+ * Consumes the frames of the response to its request in flight, caches
+ * every PID in it and hands them to SCAN while one is listening.
+ *
+ * @return  true if the frame belonged to the poller's exchange
+ */
+bool handleOBD2PollFrame(uint32_t can_id, const uint8_t* data, uint8_t len, uint32_t rxMs, uint64_t rxUs,
+                         bool scanning);
+
+/**
+ * Print poll rate, response time and timeouts to the control port (BUS CAN)
+ */
+void printOBD2PollerStatus();
+
+#endif // OBD2_POLLER_H
@@ -7,6 +7,7 @@
  *
  * Directory structure:
  * - sensors/sensor_utils.cpp          - Shared utility functions
+ * - sensors/adc_lut.cpp               - Precomputed counts-to-value tables
  * - sensors/linear/                   - Shared linear sensor implementation
  * - sensors/thermocouples/            - SPI thermocouple sensors
  * - sensors/thermistors/              - NTC thermistor sensors
@@ -14,7 +15,12 @@
  * - sensors/voltage/                  - Voltage measurement
  * - sensors/rpm/                      - RPM sensing
  * - sensors/environmental/            - Environmental sensors (BME280)
+ * - sensors/gps/                      - GPS speed and altitude
  * - sensors/digital/                  - Digital inputs (float switch)
+ *
+ * Static builds with thin libraries (tools/configure.py --generate-thin-libs)
+ * get a manifest, lib/generated/static_manifest.h: an implementation no
+ * configured sensor uses is left out (STATIC_SKIP_<DIR>_<FILE>).
  */
 
 #include "../config.h"
@@ -23,6 +29,9 @@
 #include "../lib/sensor_types.h"
 #ifdef USE_STATIC_CONFIG
 #include "../lib/generated/sensor_library_static.h"
+#if __has_include("../lib/generated/static_manifest.h")
+#include "../lib/generated/static_manifest.h"  // Implementations this config uses
+#endif
 #else
 #include "../lib/sensor_library.h"
 #endif
@@ -37,40 +46,77 @@
 #include "sensors/sensor_utils.cpp"
 
 // Shared linear sensor (used by both pressure and temperature)
+#ifndef STATIC_SKIP_LINEAR_LINEAR_SENSOR
 #include "sensors/linear/linear_sensor.cpp"
+#endif
 
 // Thermocouples (SPI-based)
 #include "sensors/thermocouples/thermocouple_common.cpp"
+#ifndef STATIC_SKIP_THERMOCOUPLES_MAX6675
 #include "sensors/thermocouples/max6675.cpp"
+#endif
+#ifndef STATIC_SKIP_THERMOCOUPLES_MAX31855
 #include "sensors/thermocouples/max31855.cpp"
+#endif
 
 // Thermistors (NTC resistance-based)
+#ifndef STATIC_SKIP_THERMISTORS_STEINHART
 #include "sensors/thermistors/steinhart.cpp"
+#endif
+#ifndef STATIC_SKIP_THERMISTORS_BETA
 #include "sensors/thermistors/beta.cpp"
+#endif
+#ifndef STATIC_SKIP_THERMISTORS_TABLE
 #include "sensors/thermistors/table.cpp"
+#endif
 
 // Pressure sensors
+#ifndef STATIC_SKIP_PRESSURE_POLYNOMIAL
 #include "sensors/pressure/polynomial.cpp"
+#endif
+#ifndef STATIC_SKIP_PRESSURE_TABLE
 #include "sensors/pressure/table.cpp"
+#endif
+
+// Counts-to-value tables (built from the thermistor/pressure conversions above)
+#include "sensors/adc_lut.cpp"
 
 // Voltage sensors
+#ifndef STATIC_SKIP_VOLTAGE_DIVIDER
 #include "sensors/voltage/divider.cpp"
+#endif
+#ifndef STATIC_SKIP_VOLTAGE_DIRECT
 #include "sensors/voltage/direct.cpp"
+#endif
 
 // RPM sensors
+#ifndef STATIC_SKIP_RPM_W_PHASE
 #include "sensors/rpm/w_phase.cpp"
+#endif
 
 // Speed sensors
+#ifndef STATIC_SKIP_SPEED_HALL_SPEED
 #include "sensors/speed/hall_speed.cpp"
+#endif
+
+// GPS speed and altitude (fields of the GPS driver's fix)
+#ifndef STATIC_SKIP_GPS_GPS_FIX
+#include "sensors/gps/gps_fix.cpp"
+#endif
 
 // Environmental sensors (e.g. BME280)
+#ifndef STATIC_SKIP_ENVIRONMENTAL_BME280
 #include "sensors/environmental/bme280.cpp"
+#endif
 
 // Digital sensors
+#ifndef STATIC_SKIP_DIGITAL_FLOAT_SWITCH
 #include "sensors/digital/float_switch.cpp"
+#endif
 
 // CAN sensors (CAN bus imported sensors)
 #include "sensors/can/can_frame_cache.cpp"
+#include "sensors/can/can_signal.cpp"
 #include "sensors/can/can_read.cpp"
 #include "sensors/can/can_scan.cpp"
 
@@ -121,60 +167,3 @@ float convertToBaseUnits(float displayValue, uint8_t unitsIndex) {
 
     return (displayValue - offset) / factor;
 }
-
-// ===== OBDII CONVERSION FUNCTIONS =====
-
-float obdConvertTemperature(float celsius) {
-    return celsius + 40.0;  // OBDII format: A-40
-}
-
-float obdConvertPressure(float bar) {
-    return bar * 10.0;  // OBDII format: A/10
-}
-
-float obdConvertVoltage(float volts) {
-    return volts * 10.0;  // OBDII format: A/10
-}
-
-float obdConvertDirect(float value) {
-    return value;
-}
-
-float obdConvertRPM(float rpm) {
-    return rpm / 4.0;  // OBDII format: RPM = ((A×256)+B)/4
-}
-
-float obdConvertHumidity(float humidity) {
-    return humidity * 2.55;  // Convert 0-100% to 0-255
-}
-
-float obdConvertElevation(float meters) {
-    return meters;
-}
-
-float obdConvertFloatSwitch(float value) {
-    return value * 255.0;  // OBDII format: 0 or 255
-}
-
-float obdConvertSpeed(float kph) {
-    // OBD-II PID 0x0D format: Vehicle Speed in km/h (range 0-255)
-    // Direct value, no conversion needed
-    if (kph > 255.0) return 255.0;  // Clamp to max
-    return kph;
-}
-
-// ===== MEASUREMENT TYPE CONVERSION HELPERS =====
-
-ObdConvertFunc getObdConvertFunc(MeasurementType type) {
-    switch (type) {
-        case MEASURE_TEMPERATURE: return obdConvertTemperature;
-        case MEASURE_PRESSURE: return obdConvertPressure;
-        case MEASURE_VOLTAGE: return obdConvertVoltage;
-        case MEASURE_RPM: return obdConvertRPM;
-        case MEASURE_HUMIDITY: return obdConvertHumidity;
-        case MEASURE_ELEVATION: return obdConvertElevation;
-        case MEASURE_DIGITAL: return obdConvertFloatSwitch;
-        case MEASURE_SPEED: return obdConvertSpeed;
-        default: return obdConvertVoltage;
-    }
-}
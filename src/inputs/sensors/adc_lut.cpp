@@ -0,0 +1,312 @@
+/*
+ * adc_lut.cpp - Precomputed ADC-count-to-value tables
+ *
+ * Included by sensor_read.cpp after the sensor implementations it builds
+ * tables from.
+ */
+
+#include "adc_lut.h"
+#include "sensor_utils.h"
+#include "../input_manager.h"
+#include <math.h>
+#ifdef PREOBD_FIXED_POINT
+#include "../../lib/fixed_point.h"
+#endif
+
+#if ADC_LINEAR_LINES
+
+static AdcLinear linearLines[MAX_INPUTS];
+static bool linearValid[MAX_INPUTS];
+
+static void clearAdcLinear() {
+    memset(linearValid, 0, sizeof(linearValid));
+}
+
+static void buildAdcLinear(Input* input) {
+    uint8_t idx = input - inputs;
+    if (idx >= MAX_INPUTS) return;
+
+    linearValid[idx] = false;
+    if (input->pin == 0xFF) return;
+    switch (input->calibrationType) {
+#ifndef STATIC_SKIP_LINEAR_LINEAR_SENSOR
+        case CAL_LINEAR:          linearSensorLine(input, &linearLines[idx]); break;
+#endif
+#ifndef STATIC_SKIP_VOLTAGE_DIVIDER
+        case CAL_VOLTAGE_DIVIDER: voltageDividerLine(input, &linearLines[idx]); break;
+#endif
+        default:                  return;
+    }
+    linearValid[idx] = true;
+}
+
+const AdcLinear* getAdcLinear(const Input* input) {
+    uint8_t idx = input - inputs;
+    if (idx >= MAX_INPUTS || !linearValid[idx]) return nullptr;
+    return &linearLines[idx];
+}
+
+#else  // ADC_LINEAR_LINES == 0
+
+static void clearAdcLinear() {}
+static void buildAdcLinear(Input* input) { (void)input; }
+const AdcLinear* getAdcLinear(const Input* input) {
+    (void)input;
+    return nullptr;
+}
+
+#endif
+
+#if ADC_LUT_SLOTS > 0
+
+// Table covers the counts readAnalogPin() accepts as valid
+#define ADC_LUT_FIRST (ADC_RAIL_MARGIN + 1)
+#define ADC_LUT_LAST  (ADC_MAX_VALUE - ADC_RAIL_MARGIN - 1)
+
+#define ADC_LUT_NONE 0xFF
+
+typedef float (*CountsConvertFunc)(const Input*, float);
+
+#if ADC_LUT_DENSE
+// One entry per count, quantized to 16 bits over the table's own range
+#define ADC_LUT_ENTRIES (ADC_LUT_LAST - ADC_LUT_FIRST + 1)
+#define ADC_LUT_DIRECT  0xFFFF      // Undefined or outside the range - convert directly
+#define ADC_LUT_CODES   65534.0f    // Codes 0..65534 span the range
+#define ADC_LUT_RANGE_POINTS 65     // Samples that set the range before the table is built
+
+static uint16_t lutTable[ADC_LUT_SLOTS][ADC_LUT_ENTRIES];
+#ifdef PREOBD_FIXED_POINT
+static fixed_t lutBase[ADC_LUT_SLOTS];    // value = base + (code << shift), Q16.16
+static uint8_t lutShift[ADC_LUT_SLOTS];
+#else
+static float lutBase[ADC_LUT_SLOTS];      // value = base + code * step
+static float lutStep[ADC_LUT_SLOTS];
+#endif
+
+#else
+#define ADC_LUT_STEP  ((float)(ADC_LUT_LAST - ADC_LUT_FIRST) / (ADC_LUT_POINTS - 1))
+
+#ifdef PREOBD_FIXED_POINT
+// Table position of a count in Q16.16 steps (integer multiply, no float)
+#define ADC_LUT_SCALE_Q16 ((((uint32_t)(ADC_LUT_POINTS - 1) << 16) + (ADC_LUT_LAST - ADC_LUT_FIRST) / 2) / \
+                           (ADC_LUT_LAST - ADC_LUT_FIRST))
+#define ADC_LUT_MAX_STEP  ((fixed_t)128 << FIXED_SHIFT)  // fixedLerp() limit
+
+typedef fixed_t LutEntry;
+#define LUT_STORE(v) fixedFromFloat(v)
+#define LUT_LOAD(v)  fixedToFloat(v)
+#else
+typedef float LutEntry;
+#define LUT_STORE(v) (v)
+#define LUT_LOAD(v)  (v)
+#endif
+
+static LutEntry lutTable[ADC_LUT_SLOTS][ADC_LUT_POINTS];
+// Intervals where the straight line is off by more than ADC_LUT_MAX_ERROR - converted directly
+static uint8_t lutCoarse[ADC_LUT_SLOTS][(ADC_LUT_POINTS + 6) / 8];
+#endif // ADC_LUT_DENSE
+
+static uint8_t lutOwner[ADC_LUT_SLOTS];   // Input index using each slot
+static uint8_t lutSlot[MAX_INPUTS];       // Slot per input (ADC_LUT_NONE = convert directly)
+static bool lutInitialized = false;
+
+static CountsConvertFunc getCountsConvertFunc(CalibrationType type) {
+    switch (type) {
+        // Conversions a static build left out (static_manifest.h) convert directly
+#ifndef STATIC_SKIP_THERMISTORS_STEINHART
+        case CAL_THERMISTOR_STEINHART: return thermistorSteinhartFromCounts;
+#endif
+#ifndef STATIC_SKIP_THERMISTORS_BETA
+        case CAL_THERMISTOR_BETA:      return thermistorBetaFromCounts;
+#endif
+#ifndef STATIC_SKIP_THERMISTORS_TABLE
+        case CAL_THERMISTOR_TABLE:     return thermistorLookupFromCounts;
+#endif
+#ifndef STATIC_SKIP_PRESSURE_POLYNOMIAL
+        case CAL_PRESSURE_POLYNOMIAL:  return pressurePolynomialFromCounts;
+#endif
+#ifndef STATIC_SKIP_PRESSURE_TABLE
+        case CAL_PRESSURE_TABLE:       return pressureTableFromCounts;
+#endif
+        default:                       return nullptr;
+    }
+}
+
+#if ADC_LUT_DENSE
+
+static void fillLutTable(uint8_t slot, const Input* input, CountsConvertFunc convert) {
+    // Range from a coarse pass, widened an eighth each way; a count whose
+    // value still falls outside is converted directly
+    float lo = INFINITY, hi = -INFINITY;
+    for (uint8_t i = 0; i < ADC_LUT_RANGE_POINTS; i++) {
+        float v = convert(input, ADC_LUT_FIRST + i * ((float)(ADC_LUT_LAST - ADC_LUT_FIRST) / (ADC_LUT_RANGE_POINTS - 1)));
+        if (isnan(v)) continue;
+        if (v < lo) lo = v;
+        if (v > hi) hi = v;
+    }
+    uint16_t* table = lutTable[slot];
+    if (!(hi >= lo)) {
+        for (uint16_t i = 0; i < ADC_LUT_ENTRIES; i++) table[i] = ADC_LUT_DIRECT;
+        return;
+    }
+    float margin = (hi - lo) / 8 + 0.001f;
+    lo -= margin;
+    hi += margin;
+
+#ifdef PREOBD_FIXED_POINT
+    if (lo <= -FIXED_LIMIT) lo = -FIXED_LIMIT + 1;
+    if (hi >= FIXED_LIMIT) hi = FIXED_LIMIT - 1;
+    fixed_t base = fixedFromFloat(lo);
+    uint32_t span = (uint32_t)(fixedFromFloat(hi) - base);
+    uint8_t shift = 0;
+    while ((span >> shift) > (uint32_t)ADC_LUT_CODES) shift++;
+    lutBase[slot] = base;
+    lutShift[slot] = shift;
+#else
+    float step = (hi - lo) / ADC_LUT_CODES;
+    lutBase[slot] = lo;
+    lutStep[slot] = step;
+#endif
+
+    for (uint16_t i = 0; i < ADC_LUT_ENTRIES; i++) {
+        float v = convert(input, ADC_LUT_FIRST + i);
+        uint16_t code = ADC_LUT_DIRECT;
+#ifdef PREOBD_FIXED_POINT
+        fixed_t q = fixedFromFloat(v);
+        if (q != FIXED_NAN && q >= base) {
+            uint32_t c = ((uint32_t)(q - base) + ((1UL << shift) >> 1)) >> shift;
+            if (c <= (uint32_t)ADC_LUT_CODES) code = (uint16_t)c;
+        }
+#else
+        if (v >= lo && v <= hi) code = (uint16_t)lroundf((v - lo) / step);
+#endif
+        table[i] = code;
+    }
+}
+
+#else
+
+static void fillLutTable(uint8_t slot, const Input* input, CountsConvertFunc convert) {
+    LutEntry* table = lutTable[slot];
+    for (uint16_t i = 0; i < ADC_LUT_POINTS; i++) {
+        table[i] = LUT_STORE(convert(input, ADC_LUT_FIRST + i * ADC_LUT_STEP));
+    }
+
+    // Check each interval against the curve at its quarter points
+    uint8_t* coarse = lutCoarse[slot];
+    memset(coarse, 0, sizeof(lutCoarse[0]));
+    for (uint16_t i = 0; i < ADC_LUT_POINTS - 1; i++) {
+        float y0 = LUT_LOAD(table[i]);
+        float y1 = LUT_LOAD(table[i + 1]);
+        bool off = isnan(y0) || isnan(y1);
+        for (uint8_t q = 1; q < 4 && !off; q++) {
+            float exact = convert(input, ADC_LUT_FIRST + (i + q * 0.25f) * ADC_LUT_STEP);
+            float line = y0 + q * 0.25f * (y1 - y0);
+            off = isnan(exact) || fabsf(exact - line) > ADC_LUT_MAX_ERROR;
+        }
+        if (off) coarse[i >> 3] |= (uint8_t)(1 << (i & 7));
+    }
+}
+
+#endif // ADC_LUT_DENSE
+
+void clearAdcLuts() {
+    clearAdcLinear();
+    memset(lutOwner, ADC_LUT_NONE, sizeof(lutOwner));
+    memset(lutSlot, ADC_LUT_NONE, sizeof(lutSlot));
+    lutInitialized = true;
+}
+
+void buildAdcLut(Input* input) {
+    if (!lutInitialized) clearAdcLuts();
+    buildAdcLinear(input);
+
+    uint8_t idx = input - inputs;
+    if (idx >= MAX_INPUTS) return;
+
+    // Release the old table first - the calibration it was built from is gone
+    uint8_t slot = lutSlot[idx];
+    if (slot != ADC_LUT_NONE) {
+        lutOwner[slot] = ADC_LUT_NONE;
+        lutSlot[idx] = ADC_LUT_NONE;
+    }
+
+    CountsConvertFunc convert = getCountsConvertFunc(input->calibrationType);
+    if (convert == nullptr || input->pin == 0xFF) return;
+
+    for (slot = 0; slot < ADC_LUT_SLOTS; slot++) {
+        if (lutOwner[slot] == ADC_LUT_NONE) break;
+    }
+    if (slot >= ADC_LUT_SLOTS) return;  // All slots taken - convert on every read
+
+    fillLutTable(slot, input, convert);
+    lutOwner[slot] = idx;
+    lutSlot[idx] = slot;
+}
+
+bool lookupAdcLut(const Input* input, float counts, float* value) {
+    uint8_t idx = input - inputs;
+    if (!lutInitialized || idx >= MAX_INPUTS || lutSlot[idx] == ADC_LUT_NONE) return false;
+    if (counts < ADC_LUT_FIRST || counts > ADC_LUT_LAST) return false;
+    uint8_t slot = lutSlot[idx];
+
+#if ADC_LUT_DENSE && defined(PREOBD_FIXED_POINT)
+    // Whole counts, integer only - the entry is the value
+    uint16_t code = lutTable[slot][(int)counts - ADC_LUT_FIRST];
+    if (code == ADC_LUT_DIRECT) return false;
+    *value = fixedToFloat(lutBase[slot] + ((fixed_t)code << lutShift[slot]));
+#elif ADC_LUT_DENSE
+    // Between the two neighbouring counts (oversampled readings are fractional)
+    float pos = counts - ADC_LUT_FIRST;
+    uint16_t i = (uint16_t)pos;
+    float frac = pos - i;
+    if (i >= ADC_LUT_ENTRIES - 1) {
+        i = ADC_LUT_ENTRIES - 1;
+        frac = 0.0f;
+    }
+    const uint16_t* table = lutTable[slot];
+    uint16_t c0 = table[i];
+    uint16_t c1 = frac > 0.0f ? table[i + 1] : c0;
+    if (c0 == ADC_LUT_DIRECT || c1 == ADC_LUT_DIRECT) return false;
+    *value = lutBase[slot] + (c0 + frac * ((float)c1 - c0)) * lutStep[slot];
+#elif defined(PREOBD_FIXED_POINT)
+    // Integer-only interpolation at whole counts - one conversion each way
+    uint32_t pos = (uint32_t)((int)counts - ADC_LUT_FIRST) * ADC_LUT_SCALE_Q16;
+    uint16_t i = pos >> 16;
+    uint8_t frac = (pos >> 8) & 0xFF;
+    if (i >= ADC_LUT_POINTS - 1) {
+        i = ADC_LUT_POINTS - 2;
+        frac = 0xFF;
+    }
+    if (lutCoarse[slot][i >> 3] & (1 << (i & 7))) return false;
+
+    const fixed_t* table = lutTable[slot];
+    fixed_t y0 = table[i];
+    fixed_t y1 = table[i + 1];
+    if (y1 - y0 >= ADC_LUT_MAX_STEP || y0 - y1 >= ADC_LUT_MAX_STEP) return false;
+
+    *value = fixedToFloat(fixedLerp(y0, y1, frac));
+#else
+    // Position in table steps - multiply by the constant reciprocal, no division
+    float pos = (counts - ADC_LUT_FIRST) * (1.0f / ADC_LUT_STEP);
+    uint16_t i = (uint16_t)pos;
+    if (i >= ADC_LUT_POINTS - 1) i = ADC_LUT_POINTS - 2;
+    float frac = pos - i;
+    if (lutCoarse[slot][i >> 3] & (1 << (i & 7))) return false;  // Too curved here - convert exactly
+
+    const float* table = lutTable[slot];
+    *value = table[i] + frac * (table[i + 1] - table[i]);
+#endif
+    return true;
+}
+
+#else  // ADC_LUT_SLOTS == 0
+
+void buildAdcLut(Input* input) { buildAdcLinear(input); }
+void clearAdcLuts() { clearAdcLinear(); }
+bool lookupAdcLut(const Input* input, float counts, float* value) {
+    (void)input; (void)counts; (void)value;
+    return false;
+}
+
+#endif
@@ -0,0 +1,128 @@
+/*
+ * adc_lut.h - Precomputed ADC-count-to-value tables
+ *
+ * Resistive sensors (thermistors, VDO pressure senders) turn an integer ADC
+ * count into a value through calculateResistance() plus log()/cubic, sqrt()
+ * or a PROGMEM table walk - on AVR the float log() dominates the whole read.
+ * Since the only input is the count, each such input gets a table of values
+ * over the valid (non-railed) count range, built once when its calibration
+ * is assigned, by the sensor's own conversion function - so it follows
+ * custom and preset calibration exactly.
+ *
+ * 10-bit ADCs (ADC_LUT_DENSE) store every count: one 16-bit entry each,
+ * quantized over the range the input's curve covers (~2KB per table). A
+ * read is one entry, interpolated between neighbours for fractional
+ * (oversampled) counts.
+ *
+ * 12-bit ADCs store ADC_LUT_POINTS evenly spaced counts and interpolate
+ * linearly between them. The error between points is the curvature of the
+ * sensor curve over one step (64 counts with the default 65 points) - at the
+ * steep end of a thermistor curve that is degrees. When the table is built
+ * each step is checked against the exact conversion at its quarter points;
+ * a step off by more than ADC_LUT_MAX_ERROR there is converted directly.
+ *
+ * Inputs without a table (unsupported calibration type, no free slot, or a
+ * NAN on either side of the reading) are converted directly as before.
+ *
+ * With -D PREOBD_FIXED_POINT (FPU-less AVR) the lookup is integer-only, at
+ * whole counts: a dense entry is the value, sparse entries are Q16.16 (lib/
+ * fixed_point.h); the result is converted to float once for Input::value.
+ *
+ * Linear-class inputs (CAL_LINEAR sensors, voltage dividers) need no table:
+ * their calibration is a straight line in counts. buildAdcLut() folds the
+ * span ratios, divider ratio, correction and AREF/ADC_MAX_VALUE scaling
+ * into a gain/offset pair (AdcLinear) with the clamp limits in counts, so a
+ * read is a clamp and one multiply-add - no division, no custom/preset
+ * branch, no PROGMEM access. Without a line (no calibration of that type,
+ * ADC_LINEAR_LINES 0) the read builds one on the spot from the same code.
+ *
+ * Build Flags:
+ *   -D ADC_LUT_SLOTS=n      - Inputs with a table (default: 0 on Uno, 1 on Mega,
+ *                             MAX_INPUTS elsewhere). 0 compiles the tables out.
+ *   -D ADC_LUT_DENSE=0|1    - One entry per count (default 1 on 10-bit ADCs)
+ *   -D ADC_LUT_POINTS=n     - Sparse entries per table (default 65, n * 4 bytes each)
+ *   -D ADC_LUT_MAX_ERROR=x  - Sparse interpolation limit, standard units (default 0.05)
+ *   -D ADC_LINEAR_LINES=0|1 - Precomputed lines for linear-class inputs
+ *                             (default 1; 0 on Uno, 16 bytes per input)
+ */
+
+#ifndef ADC_LUT_H
+#define ADC_LUT_H
+
+#include <Arduino.h>
+#include "../../lib/platform.h"
+#include "../input.h"
+
+#ifndef ADC_LUT_SLOTS
+  #if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
+    #define ADC_LUT_SLOTS 0          // 2KB RAM - convert on every read
+  #elif defined(__AVR__)
+    #define ADC_LUT_SLOTS 1          // Dense table, ~2KB of the Mega's 8KB
+  #else
+    #define ADC_LUT_SLOTS MAX_INPUTS
+  #endif
+#endif
+
+#ifndef ADC_LUT_DENSE
+  #if ADC_MAX_VALUE <= 1023
+    #define ADC_LUT_DENSE 1
+  #else
+    #define ADC_LUT_DENSE 0
+  #endif
+#endif
+
+#ifndef ADC_LUT_POINTS
+#define ADC_LUT_POINTS 65
+#endif
+
+#ifndef ADC_LUT_MAX_ERROR
+#define ADC_LUT_MAX_ERROR 0.05f
+#endif
+
+#ifndef ADC_LINEAR_LINES
+  #if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
+    #define ADC_LINEAR_LINES 0
+  #else
+    #define ADC_LINEAR_LINES 1
+  #endif
+#endif
+
+// Counts-to-value line: value = counts * gain + offset, counts clamped first
+struct AdcLinear {
+    float gain;
+    float offset;
+    float countsMin;
+    float countsMax;
+};
+
+static inline float applyAdcLinear(const AdcLinear* line, float counts) {
+    if (counts < line->countsMin) counts = line->countsMin;
+    if (counts > line->countsMax) counts = line->countsMax;
+    return counts * line->gain + line->offset;
+}
+
+// Counts-to-value conversions the tables are built from (sensor implementations)
+float thermistorSteinhartFromCounts(const Input *ptr, float reading);
+float thermistorBetaFromCounts(const Input *ptr, float reading);
+float thermistorLookupFromCounts(const Input *ptr, float reading);
+float pressurePolynomialFromCounts(const Input *ptr, float reading);
+float pressureTableFromCounts(const Input *ptr, float reading);
+
+// Lines of the linear-class conversions (custom, preset or default calibration)
+void linearSensorLine(const Input *ptr, AdcLinear* line);
+void voltageDividerLine(const Input *ptr, AdcLinear* line);
+
+// (Re)build the table for input after its sensor or calibration changed
+// Releases the input's table if its calibration type has no conversion above
+void buildAdcLut(Input* input);
+
+// Drop all tables (inputs are being rebuilt)
+void clearAdcLuts();
+
+// Table value for counts; false if input has no table - convert directly
+bool lookupAdcLut(const Input* input, float counts, float* value);
+
+// Precomputed line of a linear-class input; nullptr - build it on the spot
+const AdcLinear* getAdcLinear(const Input* input);
+
+#endif // ADC_LUT_H
@@ -7,142 +7,240 @@
  */
 
 #include "can_frame_cache.h"
+#include "../../../hal/hal_timebase.h"
+#include "../../../hal/hal_placement.h"
+#include "../../../lib/memory_report.h"
 #include <string.h>
 
 // ===== GLOBAL CACHE =====
 CANFrameEntry canFrameCache[CAN_CACHE_SIZE];
+CANCacheStats canCacheStats;
+
+#ifdef ENABLE_CAN_FD
+// Payload blocks for CAN FD frames longer than 8 bytes
+static uint8_t fdBlocks[CAN_CACHE_FD_BLOCKS][CAN_CACHE_MAX_DATA];
+static bool fdBlockUsed[CAN_CACHE_FD_BLOCKS];
+#endif
+
+#if CAN_CACHE_MAX_PROBE < CAN_CACHE_SIZE
+#define CAN_CACHE_PROBES CAN_CACHE_MAX_PROBE
+#else
+#define CAN_CACHE_PROBES CAN_CACHE_SIZE
+#endif
 
 // ===== HELPER FUNCTIONS =====
 
 /**
  * Hash function for (CAN_ID, PID) pair
- * Simple XOR hash with modulo for cache indexing
+ * Multiplicative (Fibonacci) hash - spreads the sequential IDs and PIDs
+ * typical of a vehicle bus across the whole table
  *
  * @param can_id    CAN identifier
  * @param pid       PID byte
- * @return          Cache index (0 to CAN_CACHE_SIZE-1)
+ * @return          Home slot (0 to CAN_CACHE_SIZE-1)
  */
-static inline uint8_t hashCANFrame(uint16_t can_id, uint8_t pid) {
-    return (can_id ^ pid) & (CAN_CACHE_SIZE - 1);  // Efficient modulo for power-of-2
+static inline uint16_t hashCANFrame(uint16_t can_id, uint8_t pid) {
+    uint32_t key = ((uint32_t)can_id << 8) | pid;
+    return (uint16_t)((key * 2654435761UL) >> 16) & (CAN_CACHE_SIZE - 1);
+}
+
+static inline uint16_t probeSlot(uint16_t home, uint8_t probe) {
+    return (home + probe) & (CAN_CACHE_SIZE - 1);
+}
+
+static inline bool slotInUse(const CANFrameEntry* entry) {
+    return entry->valid || entry->pinned;
+}
+
+static inline bool slotMatches(const CANFrameEntry* entry, uint16_t can_id, uint8_t pid) {
+    return slotInUse(entry) && entry->can_id == can_id && entry->pid == pid;
 }
 
 /**
- * Find least recently used entry for replacement
- * Used when hash collision occurs
+ * Return an entry's FD payload block (if any) to the pool
+ */
+static void releaseBlock(CANFrameEntry* entry) {
+    #ifdef ENABLE_CAN_FD
+    if (entry->block != CAN_CACHE_NO_BLOCK) {
+        fdBlockUsed[entry->block] = false;
+    }
+    #endif
+    entry->block = CAN_CACHE_NO_BLOCK;
+}
+
+#ifdef ENABLE_CAN_FD
+static uint8_t allocBlock() {
+    for (uint8_t i = 0; i < CAN_CACHE_FD_BLOCKS; i++) {
+        if (!fdBlockUsed[i]) {
+            fdBlockUsed[i] = true;
+            return i;
+        }
+    }
+    return CAN_CACHE_NO_BLOCK;
+}
+#endif
+
+/**
+ * Find the slot holding (can_id, pid) within its probe window
+ * Probes the whole window (not just up to the first empty slot), so
+ * clearing an entry never hides the ones behind it
  *
- * @return  Index of oldest entry
+ * @return  Pointer to the entry or nullptr
  */
-static uint8_t findLRUEntry() {
-    uint32_t oldest_time = 0xFFFFFFFF;
-    uint8_t oldest_index = 0;
+static CANFrameEntry* findSlot(uint16_t can_id, uint8_t pid) {
+    uint16_t home = hashCANFrame(can_id, pid);
+    for (uint8_t probe = 0; probe < CAN_CACHE_PROBES; probe++) {
+        CANFrameEntry* entry = &canFrameCache[probeSlot(home, probe)];
+        if (slotMatches(entry, can_id, pid)) return entry;
+    }
+    return nullptr;
+}
 
-    for (uint8_t i = 0; i < CAN_CACHE_SIZE; i++) {
-        if (!canFrameCache[i].valid) {
-            return i;  // Empty slot found
+/**
+ * Pick a slot for a new (can_id, pid) in its probe window
+ * First free slot, else the oldest unpinned entry (its FD block is released)
+ *
+ * @return  Pointer to the slot or nullptr if every slot is pinned
+ */
+static CANFrameEntry* claimSlot(uint16_t can_id, uint8_t pid) {
+    uint16_t home = hashCANFrame(can_id, pid);
+    CANFrameEntry* oldest = nullptr;
+
+    for (uint8_t probe = 0; probe < CAN_CACHE_PROBES; probe++) {
+        CANFrameEntry* entry = &canFrameCache[probeSlot(home, probe)];
+        if (!slotInUse(entry)) {
+            oldest = entry;
+            break;
         }
-        if (canFrameCache[i].timestamp_ms < oldest_time) {
-            oldest_time = canFrameCache[i].timestamp_ms;
-            oldest_index = i;
+        if (entry->pinned) continue;
+        if (oldest == nullptr || entry->timestamp_us < oldest->timestamp_us) {
+            oldest = entry;
         }
     }
-
-    return oldest_index;
+    if (oldest) releaseBlock(oldest);
+    return oldest;
 }
 
 // ===== API IMPLEMENTATION =====
 
 void initCANFrameCache() {
     memset(canFrameCache, 0, sizeof(canFrameCache));
-    for (uint8_t i = 0; i < CAN_CACHE_SIZE; i++) {
-        canFrameCache[i].valid = false;
+    for (uint16_t i = 0; i < CAN_CACHE_SIZE; i++) {
+        canFrameCache[i].block = CAN_CACHE_NO_BLOCK;
     }
+    notePlacement(F("updateCANCache()"), (const void*)updateCANCache);
+    #ifdef ENABLE_CAN_FD
+    memset(fdBlockUsed, 0, sizeof(fdBlockUsed));
+    #endif
 }
 
-void updateCANCache(uint16_t can_id, uint8_t pid, const uint8_t* data, uint8_t len) {
+HAL_HOT_CODE void updateCANCache(uint16_t can_id, uint8_t pid, const uint8_t* data, uint8_t len, uint64_t rx_us) {
     // Validate input parameters
     // NOTE: Caller MUST ensure 'data' buffer has at least 'len' bytes available
-    // Current callers (updateCANInput, CAN scan) always provide 8-byte buffers
-    if (!data || len == 0 || len > 8) return;
-
-    uint8_t index = hashCANFrame(can_id, pid);
-    uint8_t copy_len = min(len, (uint8_t)8);
-
-    // Check if entry already exists at hash index
-    if (canFrameCache[index].valid &&
-        canFrameCache[index].can_id == can_id &&
-        canFrameCache[index].pid == pid) {
-        // Update existing entry
-        memcpy(canFrameCache[index].data, data, copy_len);
-        canFrameCache[index].timestamp_ms = millis();
-        return;
-    }
-
-    // Hash collision - check if this (can_id, pid) exists elsewhere
-    for (uint8_t i = 0; i < CAN_CACHE_SIZE; i++) {
-        if (canFrameCache[i].valid &&
-            canFrameCache[i].can_id == can_id &&
-            canFrameCache[i].pid == pid) {
-            // Found existing entry, update it
-            memcpy(canFrameCache[i].data, data, copy_len);
-            canFrameCache[i].timestamp_ms = millis();
-            return;
+    if (!data || len == 0 || len > CAN_CACHE_MAX_DATA) return;
+
+    CANFrameEntry* entry = findSlot(can_id, pid);
+    if (entry == nullptr) {
+        entry = claimSlot(can_id, pid);
+        if (entry == nullptr) {
+            canCacheStats.refused++;
+            return;  // Window full of pinned pairs - not one we need
         }
+        canCacheStats.inserts++;
+        if (entry->valid) canCacheStats.evictions++;
+        entry->can_id = can_id;
+        entry->pid = pid;
+        entry->pinned = false;
+    } else {
+        canCacheStats.updates++;
     }
 
-    // New entry - use LRU replacement if hash slot occupied
-    if (canFrameCache[index].valid) {
-        index = findLRUEntry();
+    #ifdef ENABLE_CAN_FD
+    if (len > sizeof(entry->data)) {
+        if (entry->block == CAN_CACHE_NO_BLOCK) {
+            entry->block = allocBlock();
+            if (entry->block == CAN_CACHE_NO_BLOCK) {
+                canCacheStats.refused++;
+                return;  // Pool empty - keep the previous payload
+            }
+        }
+        memcpy(fdBlocks[entry->block], data, len);
+    } else {
+        releaseBlock(entry);
+        memcpy(entry->data, data, len);
     }
-
-    // Store new entry
-    canFrameCache[index].can_id = can_id;
-    canFrameCache[index].pid = pid;
-    memcpy(canFrameCache[index].data, data, copy_len);
-    canFrameCache[index].timestamp_ms = millis();
-    canFrameCache[index].valid = true;
+    #else
+    memcpy(entry->data, data, len);
+    #endif
+    entry->len = len;
+    entry->timestamp_us = rx_us;
+    entry->valid = true;
 }
 
 CANFrameEntry* getCANCacheEntry(uint16_t can_id, uint8_t pid) {
-    // Fast path: check hash index first
-    uint8_t index = hashCANFrame(can_id, pid);
-    if (canFrameCache[index].valid &&
-        canFrameCache[index].can_id == can_id &&
-        canFrameCache[index].pid == pid) {
-        return &canFrameCache[index];
-    }
-
-    // Slow path: linear search for hash collision resolution
-    for (uint8_t i = 0; i < CAN_CACHE_SIZE; i++) {
-        if (canFrameCache[i].valid &&
-            canFrameCache[i].can_id == can_id &&
-            canFrameCache[i].pid == pid) {
-            return &canFrameCache[i];
-        }
+    CANFrameEntry* entry = findSlot(can_id, pid);
+    if (entry && entry->valid) {
+        canCacheStats.hits++;
+    } else {
+        canCacheStats.misses++;
     }
+    return entry;
+}
 
-    return nullptr;  // Not found
+const uint8_t* getCANCacheData(const CANFrameEntry* entry) {
+    #ifdef ENABLE_CAN_FD
+    if (entry->block != CAN_CACHE_NO_BLOCK) return fdBlocks[entry->block];
+    #endif
+    return entry->data;
 }
 
 bool isCANDataStale(CANFrameEntry* entry, uint32_t timeout_ms) {
     if (!entry || !entry->valid) return true;
 
-    uint32_t elapsed = millis() - entry->timestamp_ms;
-
-    // Handle millis() rollover (occurs every ~49 days)
-    if (elapsed > timeout_ms && elapsed < 0x80000000UL) {
-        return true;  // Stale
-    }
-
-    return false;  // Fresh
+    // 64-bit microseconds - no rollover to allow for
+    return hal::micros64() - entry->timestamp_us > (uint64_t)timeout_ms * 1000ULL;
 }
 
 void clearCANCacheEntry(uint16_t can_id, uint8_t pid) {
-    CANFrameEntry* entry = getCANCacheEntry(can_id, pid);
+    CANFrameEntry* entry = findSlot(can_id, pid);
     if (entry) {
-        entry->valid = false;
+        entry->valid = false;  // Stays reserved if pinned
+        releaseBlock(entry);
     }
 }
 
 void clearCANCache() {
     initCANFrameCache();
 }
+
+bool pinCANCacheEntry(uint16_t can_id, uint8_t pid) {
+    CANFrameEntry* entry = findSlot(can_id, pid);
+    if (entry == nullptr) {
+        entry = claimSlot(can_id, pid);
+        if (entry == nullptr) return false;
+        entry->can_id = can_id;
+        entry->pid = pid;
+        entry->valid = false;  // Evicted or empty slot - no data for this pair yet
+    }
+    entry->pinned = true;
+    return true;
+}
+
+void unpinAllCANCacheEntries() {
+    for (uint16_t i = 0; i < CAN_CACHE_SIZE; i++) {
+        canFrameCache[i].pinned = false;
+    }
+}
+
+void resetCANCacheStats() {
+    memset(&canCacheStats, 0, sizeof(canCacheStats));
+}
+
+void countCANCacheSlots(uint16_t* valid, uint16_t* pinned) {
+    *valid = 0;
+    *pinned = 0;
+    for (uint16_t i = 0; i < CAN_CACHE_SIZE; i++) {
+        if (canFrameCache[i].valid) (*valid)++;
+        if (canFrameCache[i].pinned) (*pinned)++;
+    }
+}
@@ -1,13 +1,23 @@
 /*
  * can_frame_cache.h - CAN Frame Cache for Imported Sensors
  *
- * Circular buffer to cache incoming CAN frames by (CAN_ID, PID) pair.
+ * Hash table caching incoming CAN frames by (CAN_ID, PID) pair.
  * Used by CAN-imported sensors to retrieve cached data without blocking.
  *
  * Architecture:
- * - Fixed-size cache (16 entries) with hash-based indexing
- * - LRU (Least Recently Used) replacement on collision
- * - Timeout detection for stale data (2000ms default)
+ * - CAN_CACHE_SIZE entries sized per platform (16 on Uno, 256 on Teensy 4.x)
+ * - Multiplicative hash, open addressing with at most CAN_CACHE_MAX_PROBE
+ *   linear probes - lookups and updates never scan the whole table
+ * - Oldest unpinned entry in the probe window is replaced when it is full
+ * - Pinned entries (the pairs configured CAN inputs read) are never evicted
+ *   by unrelated bus traffic
+ * - Counters (canCacheStats) of updates, new entries, evictions, refused
+ *   frames and lookup hits/misses, for sizing the cache against real
+ *   traffic (BUS CAN, SCAN REPLAY)
+ * - Timeout detection for stale data (per input, 2000ms default)
+ * - Classic payloads (up to 8 bytes) live in the entry; with ENABLE_CAN_FD,
+ *   longer CAN FD payloads take a 64-byte block from a shared pool instead,
+ *   so only the pairs that actually carry FD frames pay for the space
  *
  * THREAD SAFETY:
  * - NOT interrupt-safe - updates are non-atomic
@@ -15,6 +25,11 @@
  * - readCANSensor() can be called from main loop only
  * - Safe for single-threaded Arduino environment (no concurrent access)
  * - If ISR usage required, add noInterrupts()/interrupts() guards
+ *
+ * Build Flags:
+ *   -D CAN_CACHE_SIZE=n        - Entries, power of 2 (default 16 Uno, 32 Mega, 256 Teensy 4.x, 64 other)
+ *   -D CAN_CACHE_MAX_PROBE=n   - Slots probed per lookup (default 8)
+ *   -D CAN_CACHE_FD_BLOCKS=n   - CAN FD payload blocks, 64 bytes each (default 32)
  */
 
 #ifndef CAN_FRAME_CACHE_H
@@ -23,31 +38,82 @@
 #include <Arduino.h>
 
 // ===== CONFIGURATION =====
-#define CAN_CACHE_SIZE 16           // Must be power of 2 for efficient modulo
-#define CAN_DEFAULT_TIMEOUT_MS 2000 // Default stale timeout
+#ifndef CAN_CACHE_SIZE
+  #if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
+    #define CAN_CACHE_SIZE 16
+  #elif defined(__AVR__)
+    #define CAN_CACHE_SIZE 32
+  #elif defined(__IMXRT1062__)
+    #define CAN_CACHE_SIZE 256
+  #else
+    #define CAN_CACHE_SIZE 64
+  #endif
+#endif
+
+#if (CAN_CACHE_SIZE & (CAN_CACHE_SIZE - 1)) != 0
+#error "CAN_CACHE_SIZE must be a power of 2"
+#endif
+
+#ifndef CAN_CACHE_MAX_PROBE
+#define CAN_CACHE_MAX_PROBE 8
+#endif
+
+#ifdef ENABLE_CAN_FD
+  #ifndef CAN_CACHE_FD_BLOCKS
+  #define CAN_CACHE_FD_BLOCKS 32
+  #endif
+  #if CAN_CACHE_FD_BLOCKS > 254
+  #error "CAN_CACHE_FD_BLOCKS must be at most 254"
+  #endif
+  #define CAN_CACHE_MAX_DATA 64
+#else
+  #define CAN_CACHE_MAX_DATA 8
+#endif
 
-// TODO: Make timeout configurable per sensor for different update rates
-// - High-frequency PIDs (RPM, speed): 100-500ms timeout
-// - Low-frequency PIDs (coolant temp): 2000-5000ms timeout
-// Current implementation uses fixed 2000ms for all sensors
+#define CAN_CACHE_NO_BLOCK 0xFF     // Payload is inline in the entry
+
+// PID key of whole-frame (broadcast) entries - the full payload, cached by
+// CAN ID alone, shared by every signal configured on that frame
+#define CAN_PID_WHOLE_FRAME 0xFF
+
+// Stale timeout for inputs whose CAN calibration leaves timeout_ms at 0
+// (SET CAN derives a per-PID timeout from the broadcast period after SCAN)
+#define CAN_DEFAULT_TIMEOUT_MS 2000
 
 // ===== DATA STRUCTURES =====
 
 /**
  * CAN Frame Cache Entry
  * Stores a single cached CAN frame indexed by (CAN_ID, PID)
- * Size: ~13 bytes per entry
+ * Size: 24 bytes per entry (26 on AVR)
+ * Read the payload through getCANCacheData() - FD payloads aren't in data[]
  */
 struct CANFrameEntry {
+    uint64_t timestamp_us;  // hal::micros64() when the frame was received
     uint16_t can_id;        // CAN identifier (0x7E8 for OBD-II, 0x400+ for J1939, etc.)
     uint8_t pid;            // PID or identifier byte (OBD-II PID or custom protocol ID)
-    uint8_t data[8];        // Full 8-byte CAN frame data payload
-    uint32_t timestamp_ms;  // millis() when frame was last updated
+    uint8_t len;            // Payload bytes held (1 to CAN_CACHE_MAX_DATA)
+    uint8_t data[8];        // Classic CAN payload
+    uint8_t block;          // FD payload block, CAN_CACHE_NO_BLOCK when inline
     bool valid;             // Entry is populated and valid
+    bool pinned;            // Reserved for a configured input (slot in use even before data)
+};
+
+/**
+ * Cache counters since boot (or resetCANCacheStats())
+ */
+struct CANCacheStats {
+    uint32_t updates;       // Frames stored over an existing entry of their pair
+    uint32_t inserts;       // Frames that took a new slot
+    uint32_t evictions;     // ... of them, replacing another pair's data
+    uint32_t refused;       // Frames dropped: probe window pinned, or FD pool empty
+    uint32_t hits;          // Lookups that found their pair
+    uint32_t misses;        // Lookups that didn't
 };
 
 // ===== GLOBAL CACHE =====
 extern CANFrameEntry canFrameCache[CAN_CACHE_SIZE];
+extern CANCacheStats canCacheStats;
 
 // ===== API FUNCTIONS =====
 
@@ -60,14 +126,18 @@ void initCANFrameCache();
 
 /**
  * Update cache with incoming CAN frame
- * Uses hash-based indexing with LRU replacement on collision
+ * Replaces the oldest unpinned entry in the probe window if it is full;
+ * the frame is dropped if every slot there is pinned
  *
  * @param can_id    CAN identifier
  * @param pid       PID or identifier byte
- * @param data      Pointer to data payload (up to 8 bytes)
- * @param len       Data length (1-8 bytes)
+ * @param data      Pointer to data payload
+ * @param len       Data length (1 to CAN_CACHE_MAX_DATA bytes); a frame
+ *                  longer than 8 bytes is dropped if the FD pool is empty
+ * @param rx_us     hal::micros64() when the frame was received (ISR time on
+ *                  interrupt-driven CAN backends) - staleness counts from here
  */
-void updateCANCache(uint16_t can_id, uint8_t pid, const uint8_t* data, uint8_t len);
+void updateCANCache(uint16_t can_id, uint8_t pid, const uint8_t* data, uint8_t len, uint64_t rx_us);
 
 /**
  * Get cached CAN frame entry
@@ -79,12 +149,17 @@ void updateCANCache(uint16_t can_id, uint8_t pid, const uint8_t* data, uint8_t l
  */
 CANFrameEntry* getCANCacheEntry(uint16_t can_id, uint8_t pid);
 
+/**
+ * Payload of a cache entry (entry->len bytes)
+ */
+const uint8_t* getCANCacheData(const CANFrameEntry* entry);
+
 /**
  * Check if cached data is stale (timed out)
  *
  * @param entry         Pointer to cache entry
  * @param timeout_ms    Timeout in milliseconds (default: CAN_DEFAULT_TIMEOUT_MS)
- * @return              true if stale (millis() - timestamp > timeout)
+ * @return              true if stale (hal::micros64() - timestamp > timeout)
  */
 bool isCANDataStale(CANFrameEntry* entry, uint32_t timeout_ms = CAN_DEFAULT_TIMEOUT_MS);
 
@@ -98,8 +173,30 @@ void clearCANCacheEntry(uint16_t can_id, uint8_t pid);
 
 /**
  * Clear all cache entries
- * Equivalent to initCANFrameCache()
+ * Equivalent to initCANFrameCache() (pins are cleared too)
  */
 void clearCANCache();
 
+/**
+ * Reserve the slot for (can_id, pid) so other traffic can't evict it
+ *
+ * @return  false if the probe window is full of other pinned pairs
+ */
+bool pinCANCacheEntry(uint16_t can_id, uint8_t pid);
+
+/**
+ * Release all pins (configured CAN inputs changed - pin the new set after)
+ */
+void unpinAllCANCacheEntries();
+
+/**
+ * Zero canCacheStats
+ */
+void resetCANCacheStats();
+
+/**
+ * Slots holding data, and slots pinned (with or without data)
+ */
+void countCANCacheSlots(uint16_t* valid, uint16_t* pinned);
+
 #endif // CAN_FRAME_CACHE_H
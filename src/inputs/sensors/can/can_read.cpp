@@ -2,71 +2,201 @@
  * can_read.cpp - CAN Sensor Read Function
  *
  * Read function for CAN-imported sensors.
- * Retrieves cached CAN frame data and extracts multi-byte values.
+ * Retrieves cached CAN frame data and decodes the input's signal from it.
+ *
+ * Each input's calibration is compiled into a CANSignal descriptor
+ * (can_signal.h) on its first read after the schedule is rebuilt, so reads
+ * decode straight from the cached payload without revisiting the
+ * calibration.
+ *
+ * Inputs reading the same cached frame (same CAN ID and PID - e.g. RPM, TPS
+ * and MAP from one broadcast) form a frame group. The first read that sees a
+ * newer frame decodes every signal of the group from it in one pass; the
+ * other members' reads then just return their value, so a frame costs one
+ * cache lookup and one decode pass however many inputs it feeds, and
+ * related signals always come from the same frame. The group keeps its
+ * (pinned, so stable) cache slot and only looks it up again if the slot no
+ * longer holds the frame.
+ *
+ * Each input goes stale after its calibration's timeout_ms without a frame
+ * (CAN_DEFAULT_TIMEOUT_MS when 0), counted from when the frame was received.
  */
 
 #include <Arduino.h>
 #include "../../input.h"
+#include "../../input_health.h"
+#include "../../input_manager.h"
 #include "../../../lib/sensor_types.h"
 #include "can_frame_cache.h"
+#include "can_signal.h"
+
+enum CANSignalStatus : uint8_t {
+    CAN_SIGNAL_UNCOMPILED = 0,
+    CAN_SIGNAL_READY,
+    CAN_SIGNAL_INVALID      // Calibration doesn't describe a usable signal
+};
+
+#define CAN_READ_NONE 0xFF  // End of a group's member list
+
+// Inputs decoded from one cached frame
+struct CANFrameGroup {
+    CANFrameEntry* entry;   // Cache slot holding the frame (nullptr until seen)
+    uint64_t rx_us;         // Receive time of the frame last decoded
+    uint16_t can_id;
+    uint8_t pid;
+    uint8_t firstInput;     // Head of the member list (input index)
+    bool decoded;           // rx_us is meaningful
+};
+
+// Compiled signal and last decoded value per input
+struct CANReadState {
+    CANSignal signal;
+    float value;            // Decoded from the group's last frame
+    CANSignalStatus status;
+    uint8_t group;          // canFrameGroups index
+    uint8_t nextInGroup;    // Next member's input index, CAN_READ_NONE at the end
+    uint8_t fault;          // FAULT_NONE, or why value couldn't be decoded
+};
+
+static CANReadState canReadState[MAX_INPUTS];
+static CANFrameGroup canFrameGroups[MAX_INPUTS];
+static uint8_t numCANFrameGroups = 0;
+static bool canFrameGroupsBuilt = false;
+
+void resetCANReadState() {
+    memset(canReadState, 0, sizeof(canReadState));
+    numCANFrameGroups = 0;
+    canFrameGroupsBuilt = false;
+}
 
 /**
- * Read CAN-imported sensor
- * Retrieves cached CAN frame and extracts value with proper byte order
- *
- * @param ptr   Pointer to Input struct
+ * Compile the input's calibration (custom or preset - presets live in PROGMEM)
  */
-void readCANSensor(Input* ptr) {
-    if (!ptr) return;
-
-    // Get calibration (custom or preset)
+static CANSignalStatus compileInputSignal(const Input* ptr, CANSignal* sig) {
+    CANSensorCalibration presetCal;
     const CANSensorCalibration* cal;
     if (ptr->flags.useCustomCalibration) {
         cal = (const CANSensorCalibration*)&ptr->customCalibration.can;
+    } else if (ptr->presetCalibration) {
+        memcpy_P(&presetCal, ptr->presetCalibration, sizeof(presetCal));
+        cal = &presetCal;
     } else {
-        cal = (const CANSensorCalibration*)ptr->presetCalibration;
+        return CAN_SIGNAL_INVALID;
     }
+    return compileCANSignal(cal, sig) ? CAN_SIGNAL_READY : CAN_SIGNAL_INVALID;
+}
 
-    if (!cal) {
-        ptr->value = NAN;
-        return;
+/**
+ * Compile every CAN-imported input and group them by source frame
+ */
+static void buildCANFrameGroups() {
+    resetCANReadState();
+
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        const Input* input = &inputs[i];
+        if (input->pin == 0xFF || input->calibrationType != CAL_CAN_IMPORT) continue;
+
+        CANReadState* state = &canReadState[i];
+        state->status = compileInputSignal(input, &state->signal);
+        if (state->status != CAN_SIGNAL_READY) continue;
+
+        uint8_t g = 0;
+        while (g < numCANFrameGroups &&
+               !(canFrameGroups[g].can_id == state->signal.can_id &&
+                 canFrameGroups[g].pid == state->signal.pid)) {
+            g++;
+        }
+        if (g == numCANFrameGroups) {
+            CANFrameGroup* group = &canFrameGroups[numCANFrameGroups++];
+            group->can_id = state->signal.can_id;
+            group->pid = state->signal.pid;
+            group->firstInput = CAN_READ_NONE;
+        }
+
+        state->group = g;
+        state->nextInGroup = canFrameGroups[g].firstInput;
+        canFrameGroups[g].firstInput = i;
+    }
+
+    canFrameGroupsBuilt = true;
+}
+
+/**
+ * Decode every member of a group from the frame in entry
+ */
+static void decodeCANFrameGroup(CANFrameGroup* group, const CANFrameEntry* entry) {
+    const uint8_t* data = getCANCacheData(entry);
+
+    for (uint8_t i = group->firstInput; i != CAN_READ_NONE; i = canReadState[i].nextInGroup) {
+        CANReadState* state = &canReadState[i];
+        if (entry->len < state->signal.minLength) {
+            state->fault = FAULT_OUT_OF_RANGE;  // Frame shorter than the calibration expects
+            continue;
+        }
+        // output = (raw * scale) + offset, e.g.
+        //   RPM:         raw * 0.25 + 0.0     (OBD-II PID 0x0C)
+        //   Temperature: raw * 1.0 + (-40.0)  (OBD-II PID 0x05, 0x0F)
+        //   Speed:       raw * 1.0 + 0.0      (OBD-II PID 0x0D)
+        state->value = decodeCANSignal(state->signal, data);
+        state->fault = FAULT_NONE;
     }
 
-    // Lookup cached CAN frame
-    CANFrameEntry* entry = getCANCacheEntry(cal->source_can_id, cal->source_pid);
+    group->rx_us = entry->timestamp_us;
+    group->decoded = true;
+}
+
+/**
+ * Read CAN-imported sensor
+ * Returns the input's signal from the newest cached frame of its group
+ *
+ * @param ptr   Pointer to Input struct
+ */
+HAL_HOT_CODE void readCANSensor(Input* ptr) {
+    if (!ptr) return;
 
-    // Check validity and timeout (2000ms default)
-    if (!entry || !entry->valid || isCANDataStale(entry, 2000)) {
-        ptr->value = NAN;
+    uint8_t idx = ptr - inputs;
+    if (idx >= MAX_INPUTS) {
+        setInputFault(ptr, FAULT_NO_CALIBRATION);
         return;
     }
 
-    // Validate data offset and length
-    if (cal->data_offset + cal->data_length > 8) {
-        ptr->value = NAN;
+    // Groups are built on the first read after a rebuild, and again when an
+    // input configured since then reads
+    if (!canFrameGroupsBuilt || canReadState[idx].status == CAN_SIGNAL_UNCOMPILED) {
+        buildCANFrameGroups();
+    }
+    CANReadState* state = &canReadState[idx];
+    if (state->status == CAN_SIGNAL_UNCOMPILED) {
+        state->status = CAN_SIGNAL_INVALID;  // Not a CAN-imported input after all
+    }
+    if (state->status != CAN_SIGNAL_READY) {
+        setInputFault(ptr, FAULT_NO_CALIBRATION);
         return;
     }
+    CANFrameGroup* group = &canFrameGroups[state->group];
 
-    // Extract multi-byte value from CAN frame
-    uint32_t raw_value = 0;
+    // Slot still holding our frame? Otherwise look it up again
+    CANFrameEntry* entry = group->entry;
+    if (!entry || !entry->valid || entry->can_id != group->can_id || entry->pid != group->pid) {
+        entry = getCANCacheEntry(group->can_id, group->pid);
+        group->entry = entry;
+        group->decoded = false;
+    }
 
-    if (cal->is_big_endian) {
-        // Big-endian (MSB first) - OBD-II standard
-        for (uint8_t i = 0; i < cal->data_length; i++) {
-            raw_value = (raw_value << 8) | entry->data[cal->data_offset + i];
-        }
-    } else {
-        // Little-endian (LSB first) - some J1939 and custom protocols
-        for (uint8_t i = 0; i < cal->data_length; i++) {
-            raw_value |= ((uint32_t)entry->data[cal->data_offset + i] << (i * 8));
-        }
+    // Check validity and timeout
+    if (!entry || !entry->valid || isCANDataStale(entry, state->signal.timeout_ms)) {
+        setInputFault(ptr, FAULT_STALE);
+        return;
+    }
+
+    // Newer frame than the group last decoded - decode all its members
+    if (!group->decoded || group->rx_us != entry->timestamp_us) {
+        decodeCANFrameGroup(group, entry);
     }
 
-    // Apply scaling and offset
-    // Formula: output = (raw * scale) + offset
-    // Examples:
-    //   RPM:         raw * 0.25 + 0.0     (OBD-II PID 0x0C)
-    //   Temperature: raw * 1.0 + (-40.0)  (OBD-II PID 0x05, 0x0F)
-    //   Speed:       raw * 1.0 + 0.0      (OBD-II PID 0x0D)
-    ptr->value = (raw_value * cal->scale_factor) + cal->offset;
+    if (state->fault != FAULT_NONE) {
+        setInputFault(ptr, state->fault);
+        return;
+    }
+    ptr->value = state->value;
 }
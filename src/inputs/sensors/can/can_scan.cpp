@@ -1,8 +1,9 @@
 /*
  * can_scan.cpp - CAN Bus Scanning State Machine
  *
- * Scans the CAN bus for active PIDs and displays results.
- * Integrates with CAN frame cache to collect traffic.
+ * Scans the CAN bus for active PIDs and broadcast frames and displays results.
+ * Fed frame by frame from the CAN input receive path (input_can.cpp).
+ * Results are listed as a response, a record per step (SCAN RESULTS).
  */
 
 #include "can_scan.h"
@@ -10,15 +11,24 @@
 #include "../../../lib/can_sensor_library/standard_pids.h"
 #include "../../../lib/message_api.h"
 #include "../../../lib/log_tags.h"
+#include "../../../lib/response_stream.h"
+#include "../../../lib/system_mode.h"
 #include <string.h>
 
+#if defined(ENABLE_SD_LOGGING) || defined(ENABLE_JSON_CONFIG)
+#include "../../../lib/sd_manager.h"
+#include <SD.h>
+#define CAN_SCAN_SD_EXPORT
+#endif
+
 // ============================================================================
 // MODULE STATE
 // ============================================================================
 
 static CANScanState scanState = SCAN_IDLE;
-static CANScanResult scanResults[MAX_SCAN_RESULTS];
-static uint8_t scanResultCount = 0;
+static CANScanResult scanResults[CAN_SCAN_MAX_RESULTS];
+static uint16_t scanResultCount = 0;
+static uint16_t scanDropped = 0;      // Frames of IDs that found no free record
 static uint32_t scanStartTime = 0;
 static uint16_t scanDuration = 0;
 
@@ -26,63 +36,164 @@ static uint16_t scanDuration = 0;
 // HELPER FUNCTIONS
 // ============================================================================
 
+// Same multiplicative hash as the frame cache, over the scan table
+static inline uint16_t hashScanKey(uint16_t can_id, uint8_t pid) {
+    uint32_t key = ((uint32_t)can_id << 8) | pid;
+    return (uint16_t)((key * 2654435761UL) >> 16) & (CAN_SCAN_MAX_RESULTS - 1);
+}
+
 /**
- * Display scan results to user
+ * Record for (can_id, pid), claiming a free one if create is set
+ * @return nullptr if absent (or the probe window is full)
  */
-static void displayScanResults() {
-    msg.control.println(F("\n=== CAN Scan Complete ==="));
+static CANScanResult* lookupScanResult(uint16_t can_id, uint8_t pid, bool create) {
+    uint16_t home = hashScanKey(can_id, pid);
+    for (uint8_t probe = 0; probe < CAN_SCAN_MAX_PROBE; probe++) {
+        CANScanResult* r = &scanResults[(home + probe) & (CAN_SCAN_MAX_RESULTS - 1)];
+        if (!r->used) {
+            if (!create) return nullptr;
+            r->used = true;
+            r->can_id = can_id;
+            r->pid = pid;
+            scanResultCount++;
+            return r;
+        }
+        if (r->can_id == can_id && r->pid == pid) return r;
+    }
+    return nullptr;
+}
 
-    if (scanResultCount == 0) {
-        msg.control.println(F("No PIDs detected during scan period."));
-        msg.control.println(F("Ensure CAN input is enabled and bus is active."));
-        return;
+static inline uint32_t scanKey(const CANScanResult* r) {
+    return ((uint32_t)r->can_id << 8) | r->pid;
+}
+
+/**
+ * Next used record in (CAN ID, PID) order after key, nullptr when done
+ * O(n) per call - only used to list results
+ */
+static const CANScanResult* nextScanResult(int32_t afterKey) {
+    const CANScanResult* best = nullptr;
+    for (uint16_t i = 0; i < CAN_SCAN_MAX_RESULTS; i++) {
+        const CANScanResult* r = &scanResults[i];
+        if (!r->used || (int32_t)scanKey(r) <= afterKey) continue;
+        if (!best || scanKey(r) < scanKey(best)) best = r;
     }
+    return best;
+}
 
-    msg.control.print(F("Found "));
-    msg.control.print(scanResultCount);
-    msg.control.println(F(" PIDs:\n"));
-    msg.control.println(F("  PID   Name                    CAN ID  Len  Samples"));
-    msg.control.println(F("  ----- ----------------------- ------- ---- --------"));
+static void printHex3(uint16_t value) {
+    if (value < 0x100) msg.control.print('0');
+    if (value < 0x10) msg.control.print('0');
+    msg.control.print(value, HEX);
+}
+
+static void printPadded(uint32_t value, uint8_t width) {
+    char buf[11];
+    snprintf(buf, sizeof(buf), "%lu", (unsigned long)value);
+    msg.control.print(buf);
+    for (uint8_t j = strlen(buf); j < width; j++) msg.control.print(' ');
+}
+
+// Live bytes as one character per payload byte: X changed, . constant
+static void formatChangeMask(const CANScanResult* r, char* out) {
+    uint8_t n = r->data_length < 8 ? r->data_length : 8;
+    for (uint8_t b = 0; b < n; b++) {
+        out[b] = (r->change_mask & (1 << b)) ? 'X' : '.';
+    }
+    out[n] = '\0';
+}
+
+// Results listing (a response, lib/response_stream.h): heading, one record
+// per step in (CAN ID, PID) order after listAfterKey, then the footer
+static int32_t listAfterKey = -1;
+
+static bool scanResultsStep(ResponseCursor& cursor) {
+    if (cursor.section == 0) {
+        if (scanState == SCAN_LISTENING) {
+            uint32_t elapsed = millis() - scanStartTime;
+            msg.control.print(F("\n=== CAN Scan (listening, "));
+            msg.control.print(elapsed < scanDuration ? (scanDuration - elapsed + 999) / 1000 : 0);
+            msg.control.println(F(" s left) ==="));
+        } else {
+            msg.control.println(F("\n=== CAN Scan Complete ==="));
+        }
+
+        if (scanResultCount == 0) {
+            msg.control.println(F("No PIDs detected during scan period."));
+            msg.control.println(F("Ensure CAN input is enabled and bus is active."));
+            return false;
+        }
+
+        msg.control.print(F("Found "));
+        msg.control.print(scanResultCount);
+        msg.control.println(F(" PIDs/frames:\n"));
+        msg.control.println(F("  CAN ID PID   Name                    Len Samples Period Jitter Live"));
+        msg.control.println(F("  ------ ----- ----------------------- --- ------- ------ ------ --------"));
+        listAfterKey = -1;
+        cursor.section = 1;
+        return true;
+    }
 
-    for (uint8_t i = 0; i < scanResultCount; i++) {
-        // Lookup standard name
-        const StandardPIDInfo* info = lookupStandardPID(scanResults[i].pid);
+    const CANScanResult* r = nextScanResult(listAfterKey);
+    if (r) {
+        listAfterKey = scanKey(r);
 
         char name[32];
+        bool wholeFrame = (r->pid == CAN_PID_WHOLE_FRAME);
+        const StandardPIDInfo* info = wholeFrame ? nullptr : lookupStandardPID(r->pid);
         if (info) {
             // Copy name from PROGMEM
             strncpy_P(name, info->name, 31);
             name[31] = '\0';
         } else {
-            sprintf(name, "Unknown PID");
+            strcpy(name, wholeFrame ? "Broadcast frame" : "Unknown PID");
         }
 
         // Format output manually (no printf)
         msg.control.print(F("  0x"));
-        if (scanResults[i].pid < 0x10) msg.control.print('0');
-        msg.control.print(scanResults[i].pid, HEX);
-        msg.control.print(F("  "));
-        msg.control.print(name);
+        printHex3(r->can_id);
+        if (wholeFrame) {
+            msg.control.print(F("  -     "));
+        } else {
+            msg.control.print(F("  0x"));
+            if (r->pid < 0x10) msg.control.print('0');
+            msg.control.print(r->pid, HEX);
+            msg.control.print(F("  "));
+        }
 
         // Pad to align columns (23 chars for name)
-        uint8_t nameLen = strlen(name);
-        for (uint8_t j = nameLen; j < 23; j++) {
+        msg.control.print(name);
+        for (uint8_t j = strlen(name); j < 24; j++) {
             msg.control.print(' ');
         }
 
-        msg.control.print(F(" 0x"));
-        if (scanResults[i].can_id < 0x100) msg.control.print('0');
-        if (scanResults[i].can_id < 0x10) msg.control.print('0');
-        msg.control.print(scanResults[i].can_id, HEX);
-        msg.control.print(F("   "));
-        msg.control.print(scanResults[i].data_length);
-        msg.control.print(F("    "));
-        msg.control.println(scanResults[i].sample_count);
+        printPadded(r->data_length, 4);
+        printPadded(r->sample_count, 8);
+        uint16_t period = getCANScanPeriod(r->can_id, r->pid);
+        if (period > 0) {
+            printPadded(period, 7);
+            printPadded(r->max_gap_ms - r->min_gap_ms, 7);
+        } else {
+            msg.control.print(F("-      -      "));
+        }
+        char live[9];
+        formatChangeMask(r, live);
+        msg.control.println(live);
+        return true;
+    }
+
+    if (scanDropped > 0) {
+        msg.control.print(F("\n"));
+        msg.control.print(scanDropped);
+        msg.control.println(F(" frames not recorded (scan table full - raise CAN_SCAN_MAX_RESULTS)"));
     }
 
-    msg.control.println(F("\nTo import a PID: SET CAN <pid_hex>"));
+    msg.control.println(F("\nPeriod/Jitter in ms; Live marks payload bytes that changed (X)."));
+    msg.control.println(F("To import a PID: SET CAN <pid_hex>"));
     msg.control.println(F("Example: SET CAN 0x0C (imports Engine RPM)"));
-    msg.control.println(F("\nType 'SCAN CANCEL' to clear results."));
+    msg.control.println(F("To import a broadcast signal: SET CAN FRAME <can_id>, then CAN_SIGNAL"));
+    msg.control.println(F("\nType 'SCAN EXPORT [file]' for CSV, 'SCAN CANCEL' to clear results."));
+    return false;
 }
 
 // ============================================================================
@@ -93,6 +204,7 @@ void startCANScan(uint16_t duration_ms) {
     // Reset state
     scanState = SCAN_LISTENING;
     scanResultCount = 0;
+    scanDropped = 0;
     scanStartTime = millis();
     scanDuration = duration_ms;
     memset(scanResults, 0, sizeof(scanResults));
@@ -100,7 +212,11 @@ void startCANScan(uint16_t duration_ms) {
     msg.control.print(F("Scanning CAN bus for "));
     msg.control.print(duration_ms);
     msg.control.println(F(" ms..."));
-    msg.control.println(F("Listening for all CAN frames..."));
+    if (isInRunMode()) {
+        msg.control.println(F("Listening in the background - monitoring continues (SCAN RESULTS)"));
+    } else {
+        msg.control.println(F("Listening for all CAN frames..."));
+    }
 }
 
 void updateCANScan() {
@@ -111,62 +227,155 @@ void updateCANScan() {
     // Check if scan period has elapsed
     if (millis() - scanStartTime > scanDuration) {
         scanState = SCAN_DISPLAYING;
-        displayScanResults();
+        if (isInRunMode()) {
+            // Don't cut into monitoring output with the whole table
+            msg.control.print(F("CAN scan complete: "));
+            msg.control.print(scanResultCount);
+            msg.control.println(F(" PIDs/frames - SCAN RESULTS to list them"));
+        } else {
+            printCANScanResults();
+        }
+    }
+}
+
+void printCANScanResults() {
+    startResponse(scanResultsStep);
+}
+
+void recordCANScanFrame(uint32_t can_id, uint8_t pid, const uint8_t* data, uint8_t len, uint32_t rx_ms) {
+    if (scanState != SCAN_LISTENING || can_id > 0x7FF) return;
+
+    CANScanResult* r = lookupScanResult((uint16_t)can_id, pid, true);
+    if (!r) {
+        if (scanDropped < 0xFFFF) scanDropped++;
         return;
     }
 
-    // Collect PIDs from cache
-    // Iterate through cache and add new PIDs to results
-    for (uint8_t i = 0; i < CAN_CACHE_SIZE; i++) {
-        // Access cache entry
-        CANFrameEntry entry;
-
-        // Get pointer to cache entry (external linkage)
-        extern CANFrameEntry canFrameCache[CAN_CACHE_SIZE];
-        memcpy(&entry, &canFrameCache[i], sizeof(CANFrameEntry));
-
-        if (!entry.valid) continue;
-
-        // Check if PID already in results
-        bool found = false;
-        for (uint8_t j = 0; j < scanResultCount; j++) {
-            if (scanResults[j].can_id == entry.can_id &&
-                scanResults[j].pid == entry.pid) {
-                // Update sample count and last data
-                scanResults[j].sample_count++;
-                memcpy(scanResults[j].last_data, entry.data, 8);
-                found = true;
-                break;
-            }
-        }
+    uint8_t n = len < 8 ? len : 8;
+    if (r->sample_count == 0) {
+        r->first_rx_ms = rx_ms;
+        r->min_gap_ms = 0xFFFF;
+    } else {
+        uint32_t gap = rx_ms - r->last_rx_ms;
+        if (gap > 0xFFFF) gap = 0xFFFF;
+        if (gap < r->min_gap_ms) r->min_gap_ms = gap;
+        if (gap > r->max_gap_ms) r->max_gap_ms = gap;
 
-        // Add new PID if space available
-        if (!found && scanResultCount < MAX_SCAN_RESULTS) {
-            scanResults[scanResultCount].can_id = entry.can_id;
-            scanResults[scanResultCount].pid = entry.pid;
-            // NOTE: Cache doesn't store data_length, so we default to 8
-            // Standard PIDs define actual data_length in standard_pids.h
-            scanResults[scanResultCount].data_length = 8;
-            scanResults[scanResultCount].sample_count = 1;
-            memcpy(scanResults[scanResultCount].last_data, entry.data, 8);
-            scanResultCount++;
+        uint8_t common = r->data_length < n ? r->data_length : n;
+        for (uint8_t b = 0; b < common; b++) {
+            if (data[b] != r->last_data[b]) r->change_mask |= (1 << b);
         }
     }
+
+    if (r->sample_count < 0xFFFF) r->sample_count++;
+    r->last_rx_ms = rx_ms;
+    r->data_length = len;
+    memcpy(r->last_data, data, n);
 }
 
 CANScanState getCANScanState() {
     return scanState;
 }
 
-const CANScanResult* getCANScanResults(uint8_t* count) {
-    if (count) {
-        *count = scanResultCount;
+const CANScanResult* findCANScanResult(uint16_t can_id, uint8_t pid) {
+    return lookupScanResult(can_id, pid, false);
+}
+
+uint16_t getCANScanPeriod(uint16_t can_id, uint8_t pid) {
+    const CANScanResult* r = findCANScanResult(can_id, pid);
+    if (!r || r->sample_count < 2) return 0;
+    uint32_t period = (r->last_rx_ms - r->first_rx_ms) / (r->sample_count - 1);
+    return period > 0xFFFF ? 0xFFFF : (uint16_t)period;
+}
+
+uint16_t getCANScanTimeout(uint16_t can_id, uint8_t pid) {
+    uint32_t period = getCANScanPeriod(can_id, pid);
+    if (period == 0) return 0;
+    uint32_t timeout = period * CAN_SCAN_TIMEOUT_PERIODS;
+    if (timeout < CAN_SCAN_TIMEOUT_MIN_MS) timeout = CAN_SCAN_TIMEOUT_MIN_MS;
+    if (timeout > CAN_SCAN_TIMEOUT_MAX_MS) timeout = CAN_SCAN_TIMEOUT_MAX_MS;
+    return (uint16_t)timeout;
+}
+
+/**
+ * One CSV row: can_id,pid,len,samples,period_ms,jitter_ms,change_mask,last_data
+ */
+static void formatScanCSV(const CANScanResult* r, char* line, size_t size) {
+    uint16_t period = getCANScanPeriod(r->can_id, r->pid);
+    int pos = snprintf(line, size, "0x%03X,", r->can_id);
+    if (r->pid == CAN_PID_WHOLE_FRAME) {
+        pos += snprintf(line + pos, size - pos, "FRAME,");
+    } else {
+        pos += snprintf(line + pos, size - pos, "0x%02X,", r->pid);
+    }
+    pos += snprintf(line + pos, size - pos, "%u,%u,%u,%u,0x%02X,",
+                    r->data_length, r->sample_count, period,
+                    period ? (unsigned)(r->max_gap_ms - r->min_gap_ms) : 0u, r->change_mask);
+    uint8_t n = r->data_length < 8 ? r->data_length : 8;
+    for (uint8_t b = 0; b < n && pos < (int)size - 2; b++) {
+        pos += snprintf(line + pos, size - pos, "%02X", r->last_data[b]);
+    }
+}
+
+static const char SCAN_CSV_HEADER[] PROGMEM = "can_id,pid,len,samples,period_ms,jitter_ms,change_mask,last_data";
+
+bool exportCANScan(const char* filename) {
+    if (scanResultCount == 0) {
+        msg.control.println(F("ERROR: No scan results - run SCAN CAN first"));
+        return false;
+    }
+
+    char line[64];
+
+    if (!filename) {
+        strncpy_P(line, SCAN_CSV_HEADER, sizeof(line) - 1);
+        line[sizeof(line) - 1] = '\0';
+        msg.control.println(line);
+        for (const CANScanResult* r = nextScanResult(-1); r; r = nextScanResult(scanKey(r))) {
+            formatScanCSV(r, line, sizeof(line));
+            msg.control.println(line);
+        }
+        return true;
     }
-    return scanResults;
+
+#ifdef CAN_SCAN_SD_EXPORT
+    if (!isSDInitialized()) {
+        msg.control.println(F("ERROR: SD card not available"));
+        return false;
+    }
+    if (SD.exists(filename)) {
+        SD.remove(filename);  // FILE_WRITE appends - replace instead
+    }
+    File file = SD.open(filename, FILE_WRITE);
+    if (!file) {
+        msg.control.print(F("ERROR: Cannot create "));
+        msg.control.println(filename);
+        return false;
+    }
+
+    strncpy_P(line, SCAN_CSV_HEADER, sizeof(line) - 1);
+    line[sizeof(line) - 1] = '\0';
+    file.println(line);
+    for (const CANScanResult* r = nextScanResult(-1); r; r = nextScanResult(scanKey(r))) {
+        formatScanCSV(r, line, sizeof(line));
+        file.println(line);
+    }
+    file.close();
+
+    msg.control.print(F("✓ Exported "));
+    msg.control.print(scanResultCount);
+    msg.control.print(F(" scan results to "));
+    msg.control.println(filename);
+    return true;
+#else
+    msg.control.println(F("ERROR: SD support not compiled in (SCAN EXPORT without a file prints CSV)"));
+    return false;
+#endif
 }
 
 void cancelCANScan() {
     scanState = SCAN_IDLE;
     scanResultCount = 0;
+    memset(scanResults, 0, sizeof(scanResults));
     msg.control.println(F("CAN scan cancelled."));
 }
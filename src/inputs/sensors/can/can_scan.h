@@ -1,8 +1,27 @@
 /*
  * can_scan.h - CAN Bus Scanning State Machine
  *
- * Interactive CAN bus scanning to detect available PIDs.
- * Collects frames during scan period and displays results.
+ * Interactive CAN bus scanning to detect available PIDs and broadcast frames.
+ * The CAN input receive path hands every frame to recordCANScanFrame() while
+ * a scan listens, so nothing is missed between polls and scanning doesn't
+ * churn the frame cache. Works in CONFIG and RUN mode: in RUN mode sensor
+ * reads and outputs carry on while it listens, the end of the scan is a
+ * one-line notice, and SCAN RESULTS lists the table - at any time, partial
+ * while still listening - a line per loop pass (lib/response_stream.h).
+ *
+ * Results live in a pooled hash table sized for a full bus, one record per
+ * OBD-II response PID or per broadcast CAN ID (whole frame, standard IDs),
+ * with:
+ * - Frame count, mean period and jitter (longest - shortest gap)
+ * - A change mask of the payload bytes that varied during the scan - the
+ *   live signals of a broadcast frame (first 8 bytes)
+ *
+ * The measured periods seed imported inputs' stale timeouts
+ * (getCANScanTimeout); results export as CSV to serial or SD (SCAN EXPORT).
+ *
+ * Build Flags:
+ *   -D CAN_SCAN_MAX_RESULTS=n  - Records, power of 2 (default 16 Uno, 32 Mega,
+ *                                512 Teensy 4.x, 256 ESP32, 64 other)
  */
 
 #ifndef CAN_SCAN_H
@@ -24,16 +43,45 @@ enum CANScanState {
 // SCAN RESULT STRUCTURE
 // ============================================================================
 
-#define MAX_SCAN_RESULTS 32
+#ifndef CAN_SCAN_MAX_RESULTS
+  #if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
+    #define CAN_SCAN_MAX_RESULTS 16
+  #elif defined(__AVR__)
+    #define CAN_SCAN_MAX_RESULTS 32
+  #elif defined(__IMXRT1062__)
+    #define CAN_SCAN_MAX_RESULTS 512
+  #elif defined(ESP32)
+    #define CAN_SCAN_MAX_RESULTS 256
+  #else
+    #define CAN_SCAN_MAX_RESULTS 64
+  #endif
+#endif
+
+#if (CAN_SCAN_MAX_RESULTS & (CAN_SCAN_MAX_RESULTS - 1)) != 0
+#error "CAN_SCAN_MAX_RESULTS must be a power of 2"
+#endif
+
+#define CAN_SCAN_MAX_PROBE 8
 
 struct CANScanResult {
     uint16_t can_id;        // CAN identifier
-    uint8_t pid;            // PID or identifier byte
-    uint8_t data_length;    // Number of data bytes
-    uint32_t sample_count;  // Number of times this PID was seen
-    uint8_t last_data[8];   // Most recent data payload
+    uint8_t pid;            // OBD-II PID, or CAN_PID_WHOLE_FRAME for broadcast frames
+    uint8_t data_length;    // Payload bytes of the latest frame (after the PID)
+    uint16_t sample_count;  // Frames received during the scan (saturates)
+    uint16_t min_gap_ms;    // Shortest and longest gap between frames
+    uint16_t max_gap_ms;
+    uint8_t change_mask;    // Bit n set: payload byte n changed between frames
+    bool used;
+    uint32_t first_rx_ms;   // Receive time of the first and latest frame
+    uint32_t last_rx_ms;
+    uint8_t last_data[8];   // Most recent data payload (first 8 bytes)
 };
 
+// Imported inputs go stale after this many missed broadcast periods
+#define CAN_SCAN_TIMEOUT_PERIODS 4
+#define CAN_SCAN_TIMEOUT_MIN_MS  100
+#define CAN_SCAN_TIMEOUT_MAX_MS  10000
+
 // ============================================================================
 // EXPORTED FUNCTIONS
 // ============================================================================
@@ -46,10 +94,27 @@ void startCANScan(uint16_t duration_ms);
 
 /**
  * Update CAN scan state machine
- * Called from main loop during CONFIG mode
+ * Called from main loop in CONFIG and RUN mode
  */
 void updateCANScan();
 
+/**
+ * List the results (SCAN RESULTS) - partial while the scan listens
+ * Goes out as a response, from the next loop pass on
+ */
+void printCANScanResults();
+
+/**
+ * Record a received frame while the scan listens (CAN input receive path)
+ *
+ * @param can_id    Standard CAN ID (extended IDs are not recorded)
+ * @param pid       OBD-II PID, or CAN_PID_WHOLE_FRAME
+ * @param data      Payload after the PID (whole payload for broadcast frames)
+ * @param len       Payload length
+ * @param rx_ms     millis() when the frame was received
+ */
+void recordCANScanFrame(uint32_t can_id, uint8_t pid, const uint8_t* data, uint8_t len, uint32_t rx_ms);
+
 /**
  * Get current scan state
  * @return Current state (IDLE, LISTENING, DISPLAYING)
@@ -57,11 +122,31 @@ void updateCANScan();
 CANScanState getCANScanState();
 
 /**
- * Get scan results array
- * @param count   Output: number of results
- * @return Pointer to results array
+ * Result recorded for (can_id, pid) by the last scan, nullptr if none
+ */
+const CANScanResult* findCANScanResult(uint16_t can_id, uint8_t pid);
+
+/**
+ * Average broadcast period of (can_id, pid) seen by the last scan
+ * Results are kept until SCAN CANCEL or the next scan.
+ * @return Period in ms, 0 if fewer than two frames were seen
+ */
+uint16_t getCANScanPeriod(uint16_t can_id, uint8_t pid);
+
+/**
+ * Stale timeout for (can_id, pid) derived from the last scan
+ * CAN_SCAN_TIMEOUT_PERIODS broadcast periods, clamped to
+ * CAN_SCAN_TIMEOUT_MIN_MS..CAN_SCAN_TIMEOUT_MAX_MS
+ * @return Timeout in ms, 0 if the scan didn't measure a period
+ */
+uint16_t getCANScanTimeout(uint16_t can_id, uint8_t pid);
+
+/**
+ * Write the scan results as CSV
+ * @param filename  SD card file (replaced), or nullptr for the control stream
+ * @return          false if there are no results or the file can't be written
  */
-const CANScanResult* getCANScanResults(uint8_t* count);
+bool exportCANScan(const char* filename);
 
 /**
  * Cancel/reset scan
@@ -0,0 +1,46 @@
+/*
+ * can_signal.cpp - CAN signal descriptor compilation
+ */
+
+#include "can_signal.h"
+#include "can_frame_cache.h"
+
+bool compileCANSignal(const CANSensorCalibration* cal, CANSignal* sig) {
+    uint8_t bits;
+    uint8_t startBit;   // Within the first byte
+
+    if (cal->bit_length == 0) {
+        // Whole bytes - the LSB (little-endian) or MSB (big-endian) of the first byte
+        if (cal->data_length == 0 || cal->data_length > 4) return false;
+        bits = cal->data_length * 8;
+        startBit = cal->is_big_endian ? 7 : 0;
+    } else {
+        if (cal->bit_length > 32 || cal->bit_offset > 7) return false;
+        bits = cal->bit_length;
+        startBit = cal->bit_offset;
+    }
+
+    if (cal->is_big_endian) {
+        // MSB at startBit, the rest runs down through the following bytes
+        uint8_t below = bits - 1;   // Bits after the MSB
+        sig->byteCount = (below > startBit) ? 1 + (below - startBit + 7) / 8 : 1;
+        sig->shift = (sig->byteCount - 1) * 8 + startBit - below;
+    } else {
+        // LSB at startBit, the rest runs up into the following bytes
+        sig->byteCount = (startBit + bits + 7) / 8;
+        sig->shift = startBit;
+    }
+
+    if ((uint16_t)cal->data_offset + sig->byteCount > CAN_CACHE_MAX_DATA) return false;
+
+    sig->can_id = cal->source_can_id;
+    sig->pid = cal->whole_frame ? CAN_PID_WHOLE_FRAME : cal->source_pid;
+    sig->firstByte = cal->data_offset;
+    sig->minLength = cal->data_offset + sig->byteCount;
+    sig->bigEndian = cal->is_big_endian;
+    sig->mask = (bits >= 32) ? 0xFFFFFFFFUL : ((1UL << bits) - 1);
+    sig->scale = cal->scale_factor;
+    sig->offset = cal->offset;
+    sig->timeout_ms = cal->timeout_ms ? cal->timeout_ms : CAN_DEFAULT_TIMEOUT_MS;
+    return true;
+}
@@ -0,0 +1,83 @@
+/*
+ * can_signal.h - Precompiled CAN signal extraction
+ *
+ * A CAN calibration describes where a signal sits in a frame (byte offset,
+ * start bit, length, byte order) and how to scale it. compileCANSignal()
+ * validates that once and reduces it to a load/shift/mask descriptor, so a
+ * read only loads the bytes the signal spans straight out of the cached
+ * payload - no per-read bounds checks, byte-order branches over the
+ * calibration, or copies.
+ *
+ * Signals follow DBC conventions: whole-byte signals (bit_length 0) take
+ * data_length bytes from data_offset; bit-packed signals take bit_length
+ * bits (1-32) whose start bit is bit_offset within byte data_offset.
+ *   Little-endian (Intel, DBC @1)    - start bit is the signal's LSB,
+ *                                      continuing into higher bytes
+ *   Big-endian    (Motorola, DBC @0) - start bit is the signal's MSB,
+ *                                      continuing into the next byte's bit 7
+ * Bits are numbered LSB = 0 within each byte, so DBC start bit N is
+ * data_offset N / 8, bit_offset N % 8.
+ *
+ * Usage:
+ *   CANSignal sig;
+ *   if (!compileCANSignal(&cal, &sig)) fault();      // Configuration time
+ *   if (len >= sig.minLength) value = decodeCANSignal(sig, data);
+ */
+
+#ifndef CAN_SIGNAL_H
+#define CAN_SIGNAL_H
+
+#include <Arduino.h>
+#include "../../../lib/sensor_types.h"
+
+struct CANSignal {
+    uint16_t can_id;        // Source frame (from the calibration)
+    uint8_t pid;
+    uint8_t firstByte;      // First payload byte the signal touches
+    uint8_t byteCount;      // Bytes loaded (1-5)
+    uint8_t minLength;      // Payload must hold at least this many bytes
+    uint8_t shift;          // Right shift bringing the signal's LSB to bit 0 (0-7)
+    bool bigEndian;         // firstByte is the most significant byte loaded
+    uint32_t mask;          // Signal-width mask applied after the shift
+    float scale;            // output = raw * scale + offset
+    float offset;
+    uint16_t timeout_ms;    // Stale timeout (already defaulted)
+};
+
+/**
+ * Validate a calibration and compile its signal descriptor
+ *
+ * @return  false if the signal doesn't fit a payload (bad length, offset or
+ *          start bit) - sig is left unusable
+ */
+bool compileCANSignal(const CANSensorCalibration* cal, CANSignal* sig);
+
+/**
+ * Raw (unscaled) signal bits from a payload of at least sig.minLength bytes
+ */
+inline uint32_t extractCANSignal(const CANSignal& sig, const uint8_t* data) {
+    const uint8_t* p = data + sig.firstByte;
+    uint8_t n = sig.byteCount > 4 ? 4 : sig.byteCount;
+    uint32_t raw = 0;
+
+    if (sig.bigEndian) {
+        for (uint8_t i = 0; i < n; i++) raw = (raw << 8) | p[i];
+        // A 5th byte only occurs for a 32-bit signal off a byte boundary
+        if (sig.byteCount > 4) raw = (raw << (8 - sig.shift)) | (p[4] >> sig.shift);
+        else raw >>= sig.shift;
+    } else {
+        for (uint8_t i = 0; i < n; i++) raw |= (uint32_t)p[i] << (i * 8);
+        raw >>= sig.shift;
+        if (sig.byteCount > 4) raw |= (uint32_t)p[4] << (32 - sig.shift);
+    }
+    return raw & sig.mask;
+}
+
+/**
+ * Scaled signal value from a payload of at least sig.minLength bytes
+ */
+inline float decodeCANSignal(const CANSignal& sig, const uint8_t* data) {
+    return extractCANSignal(sig, data) * sig.scale + sig.offset;
+}
+
+#endif // CAN_SIGNAL_H
@@ -3,6 +3,15 @@
  *
  * Implements digital input reading for float switches.
  * Commonly used for coolant level monitoring.
+ *
+ * The pin takes an edge interrupt (lib/state_capture.h), so the reading is
+ * the debounced level rather than whatever the float was bouncing on at the
+ * instant of the read. Slosh shorter than FLOAT_SWITCH_DEBOUNCE_MS doesn't
+ * change it; INFO <pin> shows the share of time the float was up. A pin
+ * without an interrupt (or with no capture channel left) is read directly.
+ *
+ * Build Flags:
+ *   -D FLOAT_SWITCH_DEBOUNCE_MS=n  - Time a level must hold to count (default 250)
  */
 
 #include "../../../config.h"
@@ -10,19 +19,26 @@
 #include "../../input.h"
 #include "../../../lib/message_api.h"
 #include "../../../lib/log_tags.h"
+#include "../../../lib/state_capture.h"
+
+#ifndef FLOAT_SWITCH_DEBOUNCE_MS
+#define FLOAT_SWITCH_DEBOUNCE_MS 250
+#endif
 
 // ===== INITIALIZATION =====
 
 /**
  * Initialize digital float switch
  *
- * Sets up a digital pin with internal pullup resistor.
- * Most float switches are normally-closed and need pullup.
+ * Sets up a digital pin with internal pullup resistor and claims a state
+ * capture channel for it. Most float switches are normally-closed and need
+ * pullup.
  *
  * @param ptr  Pointer to Input structure containing pin configuration
  */
 void initFloatSwitch(Input* ptr) {
     pinMode(ptr->pin, INPUT_PULLUP);  // Most float switches need pullup
+    attachStateCapture(ptr->pin, FLOAT_SWITCH_DEBOUNCE_MS);
     msg.debug.info(TAG_SENSOR, "Digital input on pin %d for %s", ptr->pin, ptr->abbrName);
 }
 
@@ -31,7 +47,8 @@ void initFloatSwitch(Input* ptr) {
 /**
  * Read digital float switch
  *
- * Reads digital state from pin and handles normal orientation.
+ * Takes the debounced state from the pin's capture channel (or the pin
+ * itself if it has none) and handles normal orientation.
  * Supports both normally-closed (NC) and normally-open (NO) switches
  * via COOLANT_LEVEL_INVERTED compile-time flag.
  *
@@ -45,8 +62,10 @@ void initFloatSwitch(Input* ptr) {
  * @note Inverted (NO): Float UP = OPEN = LOW, Float DOWN = CLOSED = HIGH
  */
 void readDigitalFloatSwitch(Input *ptr) {
-    // Read digital state from the pin
-    float rawValue = (float)digitalRead(ptr->pin);
+    // Debounced state from the edge record, else the pin as it is now
+    StateCaptureSample state;
+    float rawValue = getStateCapture(ptr->pin, &state) ? (float)state.level
+                                                        : (float)digitalRead(ptr->pin);
 
     // Support both normally closed (NC) and normally open (NO) switches
     #ifdef COOLANT_LEVEL_INVERTED
@@ -5,25 +5,141 @@
  * and temperature sensor. Provides temperature, pressure, humidity, and
  * calculated elevation readings.
  *
+ * The four virtual inputs share one sample: the sensor free-runs in normal
+ * mode (hardware oversampling + IIR filter, so a read never waits on a
+ * conversion) and the first read after BME280_SAMPLE_INTERVAL_MS fetches all
+ * compensated channels once; the other inputs return the cached fields.
+ *
+ * With BME280_FORCED_MODE the sensor sleeps between samples (no self-heating
+ * from continuous conversions) and converts once per sample. The two-phase
+ * read does it without waiting: startBME280() triggers the conversion for all
+ * four channels, and the scheduler collects them with the read functions
+ * BME280_CONVERSION_MS later. A read with no conversion started (static read
+ * pipeline) triggers one and waits it out.
+ *
+ * The library's Wire traffic waits for i2cBusReady() (lib/i2c_engine.h): on
+ * a stuck bus the channels report FAULT_NO_DEVICE for the pass instead of
+ * hanging in Wire while the engine recovers the bus.
+ *
+ * The address found is kept in the device inventory (lib/device_inventory.h):
+ * the next boot tries only that address, and a sensor that was not found is
+ * not probed again until BUS I2C SCAN sees it.
+ *
  * Note: This file includes conditional compilation guards to allow building
  * without BME280 library when not needed.
+ *
+ * Build Flags:
+ *   -D BME280_SAMPLE_INTERVAL_MS=n - Lifetime of the shared sample (default SENSOR_READ_INTERVAL_MS)
+ *   -D BME280_FORCED_MODE          - One conversion per sample instead of free-running
+ *   -D BME280_CONVERSION_MS=n      - Forced conversion time (default 20: 18.5ms max at T x2, P x4, H x1)
  */
 
 #include "../../../config.h"
 #include "../../../lib/platform.h"
 #include "../../../lib/bus_manager.h"
+#include "../../../lib/i2c_engine.h"
+#include "../../../lib/device_inventory.h"
 #include "../../input.h"
+#include "../../input_health.h"
 #include "../../../lib/message_api.h"
 #include "../../../lib/log_tags.h"
 #include <Wire.h>
 
 #ifdef ENABLE_BME280
 #include <Adafruit_BME280.h>
+#include <new>
+#include "../../../lib/static_pool.h"
 
 // Shared BME280 object and state (lazy initialization)
 static Adafruit_BME280* bme280_ptr = nullptr;
 static bool bme280_initialized = false;
 static uint8_t bme280_i2c_address = 0x00;  // 0 = not yet detected
+static bool bme280_skip_noted = false;     // Absent-at-last-boot warning shown
+
+// Cache lifetime - one I2C sample serves every BME280 input read inside it
+#ifndef BME280_SAMPLE_INTERVAL_MS
+#define BME280_SAMPLE_INTERVAL_MS SENSOR_READ_INTERVAL_MS
+#endif
+
+#ifndef BME280_CONVERSION_MS
+#define BME280_CONVERSION_MS 20
+#endif
+
+#define BME280_REG_CTRL_MEAS    0xF4
+#define BME280_CTRL_MEAS_FORCED 0x4D    // osrs_t x2, osrs_p x4, forced mode (same oversampling as normal mode)
+
+// Shared sample (all channels from the same conversion)
+static struct {
+    float temperature;  // Celsius
+    float pressure;     // bar
+    float humidity;     // percent
+    float elevation;    // meters
+    uint32_t sampledMs;
+    bool valid;
+} bme280_sample;
+
+#ifdef BME280_FORCED_MODE
+static bool bme280_converting = false;
+static uint32_t bme280_startedMs = 0;
+
+// A sample serves the channels collected in the same pass as the one that
+// fetched it; the next period's reads start a new conversion
+static bool isSampleFresh(uint32_t now) {
+    return bme280_sample.valid && (now - bme280_sample.sampledMs) < BME280_SAMPLE_INTERVAL_MS / 2;
+}
+
+static void triggerConversion(uint32_t now) {
+    const uint8_t ctrl[2] = { BME280_REG_CTRL_MEAS, BME280_CTRL_MEAS_FORCED };
+    if (i2cWrite(bme280_i2c_address, ctrl, 2) != I2C_OK) return;  // Next read tries again
+    bme280_converting = true;
+    bme280_startedMs = now;
+}
+#else
+static bool isSampleFresh(uint32_t now) {
+    return bme280_sample.valid && (now - bme280_sample.sampledMs) < BME280_SAMPLE_INTERVAL_MS;
+}
+#endif
+
+// Refresh the shared sample if it is older than BME280_SAMPLE_INTERVAL_MS
+// Returns false if the sensor is not available
+static bool sampleBME280() {
+    if (!bme280_ptr || !bme280_initialized) {
+        return false;
+    }
+
+    uint32_t now = millis();
+    if (isSampleFresh(now)) {
+        return true;
+    }
+    if (!i2cBusReady()) {
+        return false;  // Stuck bus - the library would hang in Wire
+    }
+
+#ifdef BME280_FORCED_MODE
+    if (!bme280_converting) {
+        triggerConversion(now);  // Synchronous read - nothing started it
+        if (!bme280_converting) return false;
+    }
+    uint32_t elapsed = now - bme280_startedMs;
+    if (elapsed < BME280_CONVERSION_MS) {
+        delay(BME280_CONVERSION_MS - elapsed);
+        now = millis();
+    }
+    bme280_converting = false;
+#endif
+
+    bme280_sample.temperature = bme280_ptr->readTemperature();
+    float pressurePa = bme280_ptr->readPressure();
+    bme280_sample.pressure = pressurePa / 100000.0;
+    bme280_sample.humidity = bme280_ptr->readHumidity();
+
+    // Same barometric formula as Adafruit_BME280::readAltitude(), without the extra read
+    bme280_sample.elevation = 44330.0 * (1.0 - pow((pressurePa / 100.0) / SEA_LEVEL_PRESSURE_HPA, 0.1903));
+
+    bme280_sample.sampledMs = now;
+    bme280_sample.valid = true;
+    return true;
+}
 
 // ===== INITIALIZATION =====
 
@@ -31,7 +147,7 @@ static uint8_t bme280_i2c_address = 0x00;  // 0 = not yet detected
  * Initialize BME280 sensor
  *
  * Performs lazy initialization of BME280 via I2C.
- * Auto-detects I2C address (tries 0x76 first, then 0x77).
+ * Tries the inventory's address first, else auto-detects (0x76, then 0x77).
  *
  * @param ptr  Pointer to Input structure (not used, but required for init signature)
  *
@@ -44,23 +160,60 @@ void initBME280(Input* ptr) {
         return;
     }
 
-    // Create BME280 object on first use
+    // Create BME280 object on first use (static pool; kept for retries)
     if (!bme280_ptr) {
-        bme280_ptr = new Adafruit_BME280();
+        void* mem = poolAlloc(sizeof(Adafruit_BME280), "BME280");
+        if (!mem) {
+            msg.debug.warn(TAG_SENSOR, "BME280 sensors will read NAN");
+            return;
+        }
+        bme280_ptr = new (mem) Adafruit_BME280();
     }
 
-    // Auto-detect I2C address (try 0x76 first, then 0x77)
+    // Not found at the last boot - don't spend the probes again
+    uint8_t recorded = inventoryRecall(DEVICE_BME280, 0);
+    if (recorded == INVENTORY_ABSENT) {
+        if (!bme280_skip_noted) {
+            msg.debug.warn(TAG_SENSOR, "BME280 not found at the last boot - BUS I2C SCAN to look again");
+            msg.debug.warn(TAG_SENSOR, "BME280 sensors will read NAN");
+        }
+        bme280_skip_noted = true;
+        return;
+    }
+
+    // The recorded address, else auto-detect (try 0x76 first, then 0x77)
     // Use the active I2C bus from bus_manager
     TwoWire* i2c = getActiveI2C();
-    if (bme280_ptr->begin(0x76, i2c)) {
+    if (recorded != INVENTORY_UNKNOWN && bme280_ptr->begin(recorded, i2c)) {
+        bme280_initialized = true;
+        bme280_i2c_address = recorded;
+    } else if (recorded != 0x76 && bme280_ptr->begin(0x76, i2c)) {
         bme280_initialized = true;
         bme280_i2c_address = 0x76;
-    } else if (bme280_ptr->begin(0x77, i2c)) {
+    } else if (recorded != 0x77 && bme280_ptr->begin(0x77, i2c)) {
         bme280_initialized = true;
         bme280_i2c_address = 0x77;
     }
+    inventoryRecord(DEVICE_BME280, 0, bme280_initialized ? bme280_i2c_address : INVENTORY_ABSENT);
 
     if (bme280_initialized) {
+        // Free-running conversions: T x2, P x4, H x1, IIR x4, ~40ms cycle (inside one sample interval)
+#ifdef BME280_FORCED_MODE
+        bme280_ptr->setSampling(Adafruit_BME280::MODE_FORCED,  // Sleeps after each conversion
+#else
+        bme280_ptr->setSampling(Adafruit_BME280::MODE_NORMAL,
+#endif
+                                Adafruit_BME280::SAMPLING_X2,
+                                Adafruit_BME280::SAMPLING_X4,
+                                Adafruit_BME280::SAMPLING_X1,
+                                Adafruit_BME280::FILTER_X4,
+                                Adafruit_BME280::STANDBY_MS_20);
+        bme280_sample.valid = false;
+#ifdef BME280_FORCED_MODE
+        bme280_converting = true;  // setSampling() started one
+        bme280_startedMs = millis();
+#endif
+
         // Show virtual pin number (I2C:0, I2C:1, etc.)
         if (ptr->pin >= 0xF0) {
             msg.debug.info(TAG_SENSOR, "BME280 (0x%02X) initialized on I2C:%d for %s",
@@ -72,11 +225,35 @@ void initBME280(Input* ptr) {
     } else {
         msg.debug.warn(TAG_SENSOR, "BME280 not found at 0x76 or 0x77");
         msg.debug.warn(TAG_SENSOR, "BME280 sensors will read NAN");
-        delete bme280_ptr;
-        bme280_ptr = nullptr;
     }
 }
 
+// ===== TWO-PHASE START =====
+
+/**
+ * Start the shared conversion (SensorInfo::startFunction of all four channels)
+ *
+ * @param ptr  Pointer to Input structure (not used - one conversion serves all channels)
+ * @return     ms until the read functions can collect it, 0 = now
+ */
+uint16_t startBME280(Input* ptr) {
+    (void)ptr;
+#ifdef BME280_FORCED_MODE
+    if (!bme280_ptr || !bme280_initialized) {
+        return 0;  // The read reports the fault
+    }
+    uint32_t now = millis();
+    if (!bme280_converting) {
+        if (isSampleFresh(now)) return 0;  // Another channel's conversion serves this pass
+        triggerConversion(now);
+    }
+    uint32_t elapsed = now - bme280_startedMs;
+    return elapsed < BME280_CONVERSION_MS ? BME280_CONVERSION_MS - elapsed : 0;
+#else
+    return 0;  // Free-running - the registers always hold a finished conversion
+#endif
+}
+
 // ===== READING FUNCTIONS =====
 
 /**
@@ -86,10 +263,10 @@ void initBME280(Input* ptr) {
  * @return     Temperature in Celsius, or NAN if sensor not initialized
  */
 void readBME280Temp(Input *ptr) {
-    if (bme280_ptr && bme280_initialized) {
-        ptr->value = bme280_ptr->readTemperature();  // Store in Celsius
+    if (sampleBME280()) {
+        ptr->value = bme280_sample.temperature;  // Store in Celsius
     } else {
-        ptr->value = NAN;
+        setInputFault(ptr, FAULT_NO_DEVICE);
     }
 }
 
@@ -100,10 +277,10 @@ void readBME280Temp(Input *ptr) {
  * @return     Pressure in bar, or NAN if sensor not initialized
  */
 void readBME280Pressure(Input *ptr) {
-    if (bme280_ptr && bme280_initialized) {
-        ptr->value = bme280_ptr->readPressure() / 100000.0;  // Store in bar
+    if (sampleBME280()) {
+        ptr->value = bme280_sample.pressure;  // Store in bar
     } else {
-        ptr->value = NAN;
+        setInputFault(ptr, FAULT_NO_DEVICE);
     }
 }
 
@@ -114,26 +291,27 @@ void readBME280Pressure(Input *ptr) {
  * @return     Relative humidity in percent (0-100), or NAN if sensor not initialized
  */
 void readBME280Humidity(Input *ptr) {
-    if (bme280_ptr && bme280_initialized) {
-        ptr->value = bme280_ptr->readHumidity();  // Store as percentage (0-100)
+    if (sampleBME280()) {
+        ptr->value = bme280_sample.humidity;  // Store as percentage (0-100)
     } else {
-        ptr->value = NAN;
+        setInputFault(ptr, FAULT_NO_DEVICE);
     }
 }
 
 /**
  * Read BME280 calculated elevation
  *
- * Calculates elevation based on atmospheric pressure.
+ * Calculates elevation based on atmospheric pressure (computed once per
+ * shared sample).
  *
  * @param ptr  Pointer to Input structure to store elevation reading
  * @return     Elevation in meters, or NAN if sensor not initialized
  */
 void readBME280Elevation(Input *ptr) {
-    if (bme280_ptr && bme280_initialized) {
-        ptr->value = bme280_ptr->readAltitude(SEA_LEVEL_PRESSURE_HPA);  // Store in meters
+    if (sampleBME280()) {
+        ptr->value = bme280_sample.elevation;  // Store in meters
     } else {
-        ptr->value = NAN;
+        setInputFault(ptr, FAULT_NO_DEVICE);
     }
 }
 
@@ -145,9 +323,11 @@ void initBME280(Input* ptr) {
     msg.debug.warn(TAG_SENSOR, "BME280 support not compiled in");
 }
 
-void readBME280Temp(Input *ptr) { ptr->value = NAN; }
-void readBME280Pressure(Input *ptr) { ptr->value = NAN; }
-void readBME280Humidity(Input *ptr) { ptr->value = NAN; }
-void readBME280Elevation(Input *ptr) { ptr->value = NAN; }
+uint16_t startBME280(Input* ptr) { (void)ptr; return 0; }
+
+void readBME280Temp(Input *ptr) { setInputFault(ptr, FAULT_NO_DEVICE); }
+void readBME280Pressure(Input *ptr) { setInputFault(ptr, FAULT_NO_DEVICE); }
+void readBME280Humidity(Input *ptr) { setInputFault(ptr, FAULT_NO_DEVICE); }
+void readBME280Elevation(Input *ptr) { setInputFault(ptr, FAULT_NO_DEVICE); }
 
 #endif // ENABLE_BME280
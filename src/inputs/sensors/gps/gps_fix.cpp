@@ -0,0 +1,69 @@
+/*
+ * gps_fix.cpp - GPS Speed and Altitude
+ *
+ * Read functions of the GPS:n inputs: fields of the latest fix parsed by the
+ * GPS driver (lib/gps.h) from its serial port. A read takes the value the
+ * fix holds - no I/O - and reports a missing or stale fix as a fault.
+ */
+
+#include "../../../config.h"
+#include "../../input.h"
+#include "../../input_health.h"
+#include "../../../lib/gps.h"
+
+#ifdef ENABLE_GPS
+
+/**
+ * Latest fix if it can be used, else the input's fault is set
+ *
+ * @param ptr  Input being read
+ * @return     The fix, or nullptr (FAULT_NO_DEVICE: nothing received yet,
+ *             FAULT_STALE: no fix within GPS_TIMEOUT_MS)
+ */
+static const GpsFix* currentGpsFix(Input* ptr) {
+    if (getGpsStats().bytes == 0) {
+        setInputFault(ptr, FAULT_NO_DEVICE);
+        return nullptr;
+    }
+    if (!hasGpsFix(millis())) {
+        setInputFault(ptr, FAULT_STALE);
+        return nullptr;
+    }
+    return &getGpsFix();
+}
+
+/**
+ * Read GPS speed over ground
+ *
+ * @param ptr  Pointer to Input structure to store speed reading (km/h)
+ */
+void readGpsSpeed(Input* ptr) {
+    const GpsFix* fix = currentGpsFix(ptr);
+    if (fix) ptr->value = fix->speed;
+}
+
+/**
+ * Read GPS altitude above mean sea level
+ *
+ * A 2D fix has no altitude (FAULT_STALE).
+ *
+ * @param ptr  Pointer to Input structure to store altitude reading (metres)
+ */
+void readGpsAltitude(Input* ptr) {
+    const GpsFix* fix = currentGpsFix(ptr);
+    if (!fix) return;
+    if (isnan(fix->altitude)) {
+        setInputFault(ptr, FAULT_STALE);
+        return;
+    }
+    ptr->value = fix->altitude;
+}
+
+#else
+
+// ===== STUB IMPLEMENTATIONS (GPS DISABLED) =====
+
+void readGpsSpeed(Input* ptr) { setInputFault(ptr, FAULT_NO_DEVICE); }
+void readGpsAltitude(Input* ptr) { setInputFault(ptr, FAULT_NO_DEVICE); }
+
+#endif // ENABLE_GPS
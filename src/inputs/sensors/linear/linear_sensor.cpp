@@ -17,27 +17,20 @@
 #include "../sensor_utils.h"
 
 /**
- * Read linear sensor (generic method)
+ * Counts-to-value line of a linear sensor
  *
- * Works for any linear sensor: temperature, pressure, voltage, etc.
- * Units are determined by the measurementType field in the Input structure.
+ * Folds AREF/ADC_MAX_VALUE, the voltage span and the output span into one
+ * gain/offset pair, with the voltage clamp as a clamp on counts.
  *
- * @param ptr  Pointer to Input structure containing sensor configuration
+ * @param ptr   Input providing the calibration
+ * @param line  Filled with the line
  *
  * Calibration sources (in priority order):
  * 1. Custom calibration (RAM) - from EEPROM/serial config mode
  * 2. Preset calibration (PROGMEM) - from sensor library
  * 3. Default fallback - 0.5V-4.5V → 0-5 bar (common automotive pressure sensor)
  */
-void readLinearSensor(Input *ptr) {
-    bool isValid;
-    int reading = readAnalogPin(ptr->pin, &isValid);
-
-    if (!isValid) {
-        ptr->value = NAN;
-        return;
-    }
-
+void linearSensorLine(const Input *ptr, AdcLinear* line) {
     // Get calibration values (from custom RAM or PROGMEM preset)
     float V_min, V_max, output_min, output_max;
     if (ptr->flags.useCustomCalibration && ptr->calibrationType == CAL_LINEAR) {
@@ -61,15 +54,40 @@ void readLinearSensor(Input *ptr) {
         output_max = 5.0;
     }
 
-    // Convert ADC reading to voltage
-    float voltage = reading * (AREF_VOLTAGE / (float)ADC_MAX_VALUE);
+    // Y = (V - V_min) / (V_max - V_min) * (Y_max - Y_min) + Y_min, with V = counts * AREF / ADC_MAX
+    float countsPerVolt = (float)ADC_MAX_VALUE / AREF_VOLTAGE;
+    line->countsMin = V_min * countsPerVolt;
+    line->countsMax = V_max * countsPerVolt;
+    line->gain = (output_max - output_min) / (line->countsMax - line->countsMin);
+    line->offset = output_min - line->countsMin * line->gain;
+}
+
+/**
+ * Read linear sensor (generic method)
+ *
+ * Works for any linear sensor: temperature, pressure, voltage, etc.
+ * Units are determined by the measurementType field in the Input structure.
+ *
+ * @param ptr  Pointer to Input structure containing sensor configuration
+ *
+ * The line from linearSensorLine() is precomputed when the calibration is
+ * assigned (sensors/adc_lut.h), so a read is one clamp and multiply-add.
+ */
+HAL_HOT_CODE void readLinearSensor(Input *ptr) {
+    bool isValid;
+    float reading = readAnalogPin(ptr->pin, &isValid);
 
-    // Clamp voltage to valid range
-    if (voltage < V_min) voltage = V_min;
-    if (voltage > V_max) voltage = V_max;
+    if (!isValid) {
+        setInputFault(ptr, FAULT_ADC_RAIL);
+        return;
+    }
 
-    // Linear interpolation: Y = (V - V_min) / (V_max - V_min) * (Y_max - Y_min) + Y_min
-    float outputValue = ((voltage - V_min) / (V_max - V_min)) * (output_max - output_min) + output_min;
+    const AdcLinear* line = getAdcLinear(ptr);
+    AdcLinear computed;
+    if (line == nullptr) {
+        linearSensorLine(ptr, &computed);
+        line = &computed;
+    }
 
-    ptr->value = outputValue;  // Store in base units (°C for temp, bar for pressure, etc.)
+    ptr->value = applyAdcLinear(line, reading);  // Store in base units (°C for temp, bar for pressure, etc.)
 }
@@ -16,29 +16,13 @@
 #include <math.h>
 
 /**
- * Read pressure sensor using polynomial calibration
- *
- * Converts sensor resistance to pressure using a quadratic polynomial equation.
- * Specific to VDO pressure sensors with non-linear resistance curves.
- *
- * @param ptr  Pointer to Input structure to store pressure reading
+ * Convert ADC counts to pressure using the polynomial calibration
  *
- * Calibration sources (in priority order):
- * 1. Custom calibration (RAM) - from EEPROM/serial config mode
- * 2. Preset calibration (PROGMEM) - from sensor library (VDO 2-bar, 5-bar)
- * 3. No fallback - returns NAN if coefficients not available
- *
- * @note Returns NAN if calibration data missing or ADC reading invalid
+ * @param ptr      Input providing the calibration
+ * @param reading  ADC counts (fractional when building a lookup table)
+ * @return         Pressure in bar, or NAN if there is no real solution
  */
-void readPressurePolynomial(Input *ptr) {
-    bool isValid;
-    int reading = readAnalogPin(ptr->pin, &isValid);
-
-    if (!isValid) {
-        ptr->value = NAN;
-        return;
-    }
-
+float pressurePolynomialFromCounts(const Input *ptr, float reading) {
     // Get calibration values (from custom RAM or PROGMEM preset)
     float bias_resistor, a, b, c;
     if (ptr->flags.useCustomCalibration && ptr->calibrationType == CAL_PRESSURE_POLYNOMIAL) {
@@ -55,8 +39,7 @@ void readPressurePolynomial(Input *ptr) {
         b = pgm_read_float(&cal->poly_b);
         c = pgm_read_float(&cal->poly_c);
     } else {
-        ptr->value = NAN;  // Can't calculate without coefficients
-        return;
+        return NAN;  // Can't calculate without coefficients
     }
 
     // VDO sensors use quadratic equation: V = A*P² + B*P + C
@@ -65,8 +48,7 @@ void readPressurePolynomial(Input *ptr) {
     float R_sensor = calculateResistance(reading, bias_resistor);
 
     if (isnan(R_sensor) || R_sensor <= 0) {
-        ptr->value = NAN;
-        return;
+        return NAN;
     }
 
     c = c - R_sensor;
@@ -74,12 +56,41 @@ void readPressurePolynomial(Input *ptr) {
     float discriminant = (b * b) - (4.0 * a * c);
 
     if (discriminant < 0) {
-        ptr->value = NAN;  // No real solution
-        return;
+        return NAN;  // No real solution
     }
 
     // Take the positive root (pressure is always positive)
     float pressure = (-b - sqrt(discriminant)) / (2.0 * a);
 
-    ptr->value = pressure;  // Store in bar
+    return pressure;  // bar
+}
+
+/**
+ * Read pressure sensor using polynomial calibration
+ *
+ * Converts sensor resistance to pressure using a quadratic polynomial equation.
+ * Specific to VDO pressure sensors with non-linear resistance curves.
+ *
+ * @param ptr  Pointer to Input structure to store pressure reading
+ *
+ * Calibration sources (in priority order):
+ * 1. Custom calibration (RAM) - from EEPROM/serial config mode
+ * 2. Preset calibration (PROGMEM) - from sensor library (VDO 2-bar, 5-bar)
+ * 3. No fallback - returns NAN if coefficients not available
+ *
+ * @note Returns NAN if calibration data missing or ADC reading invalid
+ */
+HAL_HOT_CODE void readPressurePolynomial(Input *ptr) {
+    bool isValid;
+    float reading = readAnalogPin(ptr->pin, &isValid);
+
+    if (!isValid) {
+        setInputFault(ptr, FAULT_ADC_RAIL);
+        return;
+    }
+
+    // Precomputed table when one was built for this input (sensors/adc_lut.h)
+    if (lookupAdcLut(ptr, reading, &ptr->value)) return;
+
+    ptr->value = pressurePolynomialFromCounts(ptr, reading);
 }
@@ -13,31 +13,16 @@
 #include "../sensor_utils.h"
 
 /**
- * Read pressure sensor using lookup table interpolation
- *
- * Converts sensor resistance to pressure by interpolating between
- * values in a PROGMEM lookup table. Provides highest accuracy when using
- * manufacturer calibration data.
+ * Convert ADC counts to pressure using the PROGMEM lookup table
  *
- * @param ptr  Pointer to Input structure to store pressure reading
- *
- * @note Requires preset calibration with lookup table in PROGMEM
- * @note Returns NAN if calibration data is missing or ADC reading is invalid
- * @note Uses interpolateAscending() since resistance increases with pressure
+ * @param ptr      Input providing the calibration
+ * @param reading  ADC counts (fractional when building a lookup table)
+ * @return         Pressure in bar, or NAN if calibration is missing
  */
-void readPressureTable(Input *ptr) {
-    bool isValid;
-    int reading = readAnalogPin(ptr->pin, &isValid);
-
-    if (!isValid) {
-        ptr->value = NAN;
-        return;
-    }
-
+float pressureTableFromCounts(const Input *ptr, float reading) {
     // Get calibration from PROGMEM (REQUIRED for table method)
     if (ptr->calibrationType != CAL_PRESSURE_TABLE || ptr->presetCalibration == nullptr) {
-        ptr->value = NAN;  // Can't do lookup without table
-        return;
+        return NAN;  // Can't do lookup without table
     }
 
     const PressureTableCalibration* cal = (const PressureTableCalibration*)ptr->presetCalibration;
@@ -47,8 +32,7 @@ void readPressureTable(Input *ptr) {
     float R_sensor = calculateResistance(reading, R_bias);
 
     if (isnan(R_sensor) || R_sensor <= 0) {
-        ptr->value = NAN;
-        return;
+        return NAN;
     }
 
     // Read lookup table info from PROGMEM
@@ -57,6 +41,34 @@ void readPressureTable(Input *ptr) {
     const float* pressure_table = (const float*)pgm_read_ptr(&cal->pressure_table);
 
     // Use ascending interpolation (resistance increases with pressure)
-    ptr->value = interpolateAscending(R_sensor, table_size,
-                                      resistance_table, pressure_table);
+    return interpolateAscending(R_sensor, table_size,
+                                resistance_table, pressure_table);
+}
+
+/**
+ * Read pressure sensor using lookup table interpolation
+ *
+ * Converts sensor resistance to pressure by interpolating between
+ * values in a PROGMEM lookup table. Provides highest accuracy when using
+ * manufacturer calibration data.
+ *
+ * @param ptr  Pointer to Input structure to store pressure reading
+ *
+ * @note Requires preset calibration with lookup table in PROGMEM
+ * @note Returns NAN if calibration data is missing or ADC reading is invalid
+ * @note Uses interpolateAscending() since resistance increases with pressure
+ */
+HAL_HOT_CODE void readPressureTable(Input *ptr) {
+    bool isValid;
+    float reading = readAnalogPin(ptr->pin, &isValid);
+
+    if (!isValid) {
+        setInputFault(ptr, FAULT_ADC_RAIL);
+        return;
+    }
+
+    // Precomputed table when one was built for this input (sensors/adc_lut.h)
+    if (lookupAdcLut(ptr, reading, &ptr->value)) return;
+
+    ptr->value = pressureTableFromCounts(ptr, reading);
 }
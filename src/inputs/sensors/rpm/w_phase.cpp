@@ -2,58 +2,35 @@
  * w_phase.cpp - W-Phase Alternator RPM Sensing
  *
  * Implements engine RPM measurement using the W-phase output from an alternator.
- * Uses interrupt-based pulse counting to calculate RPM based on alternator
- * characteristics (poles, pulley ratio).
+ * Uses interrupt-based pulse timing (lib/freq_capture.h, one channel per
+ * input) to calculate RPM based on alternator characteristics (poles,
+ * pulley ratio).
  */
 
 #include "../../../config.h"
 #include "../../../lib/platform.h"
 #include "../../input.h"
+#include "../../input_health.h"
 #include "../../../lib/sensor_types.h"
 #include "../../../lib/sensor_library.h"
 #include "../../../lib/message_api.h"
 #include "../../../lib/log_tags.h"
+#include "../../../lib/freq_capture.h"
 
-// ===== GLOBAL VARIABLES FOR RPM CALCULATION =====
-// These must be global to be accessed by the ISR
-
-volatile unsigned long rpm_pulse_count = 0;
-volatile unsigned long rpm_last_time = 0;
-volatile unsigned long rpm_pulse_interval = 0;
-unsigned long rpm_calc_time = 0;
-
-// ===== INTERRUPT SERVICE ROUTINE =====
-
-/**
- * RPM pulse interrupt service routine
- *
- * Called on each rising edge of the W-phase signal.
- * Measures time between pulses and applies debouncing.
- */
-void rpmPulseISR() {
-    unsigned long now = micros();
-    unsigned long interval = now - rpm_last_time;
-
-    // Debounce: ignore pulses faster than 100 µs (600,000 RPM equivalent)
-    if (interval > 100) {
-        rpm_pulse_interval = interval;
-        rpm_pulse_count++;
-        rpm_last_time = now;
-    }
-}
+// Debounce: ignore pulses faster than 100 µs (600,000 RPM equivalent)
+#define RPM_DEBOUNCE_US 100
 
 // ===== INITIALIZATION =====
 
 /**
  * Initialize W-Phase RPM sensing
  *
- * Sets up interrupt-based pulse counting on the specified pin.
+ * Claims a pulse capture channel for the specified pin.
  *
  * @param ptr  Pointer to Input structure containing pin configuration
  */
 void initWPhaseRPM(Input* ptr) {
-    pinMode(ptr->pin, INPUT);
-    attachInterrupt(digitalPinToInterrupt(ptr->pin), rpmPulseISR, RISING);
+    if (!attachFreqCapture(ptr->pin, RPM_DEBOUNCE_US)) return;
     msg.debug.info(TAG_SENSOR, "RPM sensing on pin %d for %s", ptr->pin, ptr->abbrName);
 }
 
@@ -72,7 +49,8 @@ void initWPhaseRPM(Input* ptr) {
  * 2. Preset calibration (PROGMEM) - from sensor library
  * 3. Default fallback - 12-pole alternator, 3:1 pulley ratio
  *
- * Formula: Engine_RPM = (60,000,000 / (interval × pulses_per_rev × pulley_ratio)) × calibration_mult
+ * Formula: Engine_RPM = (60 × freq_hz / (pulses_per_rev × pulley_ratio)) × calibration_mult
+ * (freq_hz from lib/freq_capture.h: period timing at low RPM, edge counting at high RPM)
  */
 void readWPhaseRPM(Input *ptr) {
     // Get calibration parameters
@@ -121,20 +99,22 @@ void readWPhaseRPM(Input *ptr) {
     // Accounts for both alternator pulses and pulley ratio
     float calibration_factor = pulses_per_rev * pulley_ratio;
 
-    // Calculate time since last pulse
-    unsigned long now = millis();
-    unsigned long time_since_pulse = now - (rpm_last_time / 1000);
+    FreqCaptureSample pulse;
+    if (!getFreqCapture(ptr->pin, &pulse)) {
+        setInputFault(ptr, FAULT_NO_DEVICE);  // No capture channel for this pin
+        return;
+    }
 
     // Check for timeout (engine stopped)
-    if (time_since_pulse > timeout_ms) {
+    if (pulse.idleUs > timeout_ms * 1000UL) {
         ptr->value = 0;
         return;
     }
 
-    // Calculate ENGINE RPM from pulse interval
-    // Formula: Engine_RPM = (60,000,000 / (interval × pulses_per_rev × pulley_ratio)) × calibration_mult
-    if (rpm_pulse_interval > 0) {
-        float engine_rpm = (60000000.0 / (rpm_pulse_interval * calibration_factor)) * calibration_mult;
+    // Calculate ENGINE RPM from pulse frequency
+    // Formula: Engine_RPM = (60 × freq_hz / (pulses_per_rev × pulley_ratio)) × calibration_mult
+    if (pulse.frequencyHz > 0) {
+        float engine_rpm = (60.0 * pulse.frequencyHz / calibration_factor) * calibration_mult;
 
         // Validate range
         if (engine_rpm >= min_rpm && engine_rpm <= max_rpm) {
@@ -145,7 +125,7 @@ void readWPhaseRPM(Input *ptr) {
                 ptr->value = engine_rpm;
             }
         } else {
-            ptr->value = NAN;  // Out of range
+            setInputFault(ptr, FAULT_OUT_OF_RANGE);
         }
     }
 }
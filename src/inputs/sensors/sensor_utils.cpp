@@ -5,10 +5,49 @@
  */
 
 #include "sensor_utils.h"
+#include "../../lib/ext_adc.h"
+#include "../../lib/raw_trace.h"
 
 // Helper macros to read calibration data from PROGMEM
 #define READ_FLOAT_PROGMEM(addr) pgm_read_float(&(addr))
 
+/**
+ * Find the table segment containing a value (binary search).
+ *
+ * @param value       The X value to look up (strictly inside the table's end points)
+ * @param tableSize   Number of entries in the lookup table (>= 2)
+ * @param xTable      X values in PROGMEM, strictly monotonic
+ * @param descending  True if X values decrease along the table
+ * @return Index i such that value lies between xTable[i] and xTable[i+1]
+ *
+ * @note O(log n) PROGMEM reads instead of a scan from one end.
+ */
+static byte findTableSegment(float value, byte tableSize, const float* xTable, bool descending) {
+    byte lo = 0;
+    byte hi = tableSize - 1;   // Invariant: value lies between xTable[lo] and xTable[hi]
+    while (hi - lo > 1) {
+        byte mid = lo + (hi - lo) / 2;
+        float xMid = READ_FLOAT_PROGMEM(xTable[mid]);
+        if ((xMid > value) == descending) {
+            lo = mid;   // value is further along the table than mid
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Interpolate within segment [i, i+1] - four PROGMEM reads
+static float interpolateSegment(float value, byte i, const float* xTable, const float* yTable) {
+    float xi = READ_FLOAT_PROGMEM(xTable[i]);
+    float xi_next = READ_FLOAT_PROGMEM(xTable[i+1]);
+    float yi = READ_FLOAT_PROGMEM(yTable[i]);
+    float yi_next = READ_FLOAT_PROGMEM(yTable[i+1]);
+
+    // Linear interpolation: y = y1 + ((x - x1) / (x2 - x1)) * (y2 - y1)
+    return yi + ((value - xi) / (xi_next - xi)) * (yi_next - yi);
+}
+
 /**
  * Linear interpolation in a PROGMEM lookup table.
  *
@@ -20,14 +59,13 @@
  *
  * @param value       The X value to look up
  * @param tableSize   Number of entries in the lookup tables
- * @param xTable      X values in PROGMEM (must be sorted, typically descending)
+ * @param xTable      X values in PROGMEM (must be sorted in DESCENDING order)
  * @param yTable      Corresponding Y values in PROGMEM
- * @return Interpolated Y value, or NAN if lookup fails
- *
- * @note X table is traversed backwards assuming descending order.
- *       For ascending tables, modify the iteration direction.
+ * @return Interpolated Y value (clamped to the table ends), or NAN if the table is empty
  */
 float interpolate(float value, byte tableSize, const float* xTable, const float* yTable) {
+    if (tableSize == 0) return NAN;
+
     // Handle edge cases - read from PROGMEM
     float x0 = READ_FLOAT_PROGMEM(xTable[0]);
     float xLast = READ_FLOAT_PROGMEM(xTable[tableSize-1]);
@@ -35,22 +73,8 @@ float interpolate(float value, byte tableSize, const float* xTable, const float*
     if (value >= x0) return READ_FLOAT_PROGMEM(yTable[0]);
     if (value <= xLast) return READ_FLOAT_PROGMEM(yTable[tableSize-1]);
 
-    // Find the right segment
-    // Iterate backwards since tables are typically in descending order
-    for (int i = tableSize-1; i >= 0; i--) {
-        float xi = READ_FLOAT_PROGMEM(xTable[i]);
-        float xi_prev = READ_FLOAT_PROGMEM(xTable[i-1]);
-
-        if (value >= xi && value <= xi_prev) {
-            // Linear interpolation: y = y1 + ((x – x1) / (x2 – x1)) * (y2 – y1)
-            float yi = READ_FLOAT_PROGMEM(yTable[i]);
-            float xi_next = READ_FLOAT_PROGMEM(xTable[i+1]);
-            float yi_next = READ_FLOAT_PROGMEM(yTable[i+1]);
-
-            return yi + ((value - xi) / (xi_next - xi)) * (yi_next - yi);
-        }
-    }
-    return NAN;
+    byte i = findTableSegment(value, tableSize, xTable, true);
+    return interpolateSegment(value, i, xTable, yTable);
 }
 
 /**
@@ -66,9 +90,11 @@ float interpolate(float value, byte tableSize, const float* xTable, const float*
  * @param tableSize   Number of entries in the lookup tables
  * @param xTable      X values in PROGMEM (must be sorted in ASCENDING order)
  * @param yTable      Corresponding Y values in PROGMEM
- * @return Interpolated Y value, or NAN if lookup fails
+ * @return Interpolated Y value (clamped to the table ends), or NAN if the table is empty
  */
 float interpolateAscending(float value, byte tableSize, const float* xTable, const float* yTable) {
+    if (tableSize == 0) return NAN;
+
     // Handle edge cases - read from PROGMEM
     float x0 = READ_FLOAT_PROGMEM(xTable[0]);
     float xLast = READ_FLOAT_PROGMEM(xTable[tableSize-1]);
@@ -77,62 +103,75 @@ float interpolateAscending(float value, byte tableSize, const float* xTable, con
     if (value <= x0) return READ_FLOAT_PROGMEM(yTable[0]);
     if (value >= xLast) return READ_FLOAT_PROGMEM(yTable[tableSize-1]);
 
-    // Find the right segment (iterate forward for ascending order)
-    for (int i = 0; i < tableSize - 1; i++) {
-        float xi = READ_FLOAT_PROGMEM(xTable[i]);
-        float xi_next = READ_FLOAT_PROGMEM(xTable[i+1]);
-
-        if (value >= xi && value <= xi_next) {
-            // Linear interpolation: y = y1 + ((x - x1) / (x2 - x1)) * (y2 - y1)
-            float yi = READ_FLOAT_PROGMEM(yTable[i]);
-            float yi_next = READ_FLOAT_PROGMEM(yTable[i+1]);
+    byte i = findTableSegment(value, tableSize, xTable, false);
+    return interpolateSegment(value, i, xTable, yTable);
+}
 
-            return yi + ((value - xi) / (xi_next - xi)) * (yi_next - yi);
-        }
+/**
+ * Raw ADC counts for an analog pin
+ *
+ * Returns the background scanner's latest oversampled result for the pin
+ * (see lib/adc_scan.h). The first call for a pin registers it with the
+ * scanner; until a scan result exists the pin is read synchronously.
+ * External ADC channels (ADC:n) come from their driver the same way, in
+ * native counts with the fraction kept (lib/ext_adc.h).
+ *
+ * @param pin  Analog pin number to read
+ * @return     ADC reading value (0-ADC_MAX_VALUE, NAN if an external ADC is missing)
+ *
+ * @note Multiplexer settling (the old throwaway analogRead) is handled by the
+ *       scanner's ADC_SETTLE_SAMPLES discard.
+ */
+float readAnalogRaw(int pin) {
+    float counts;
+#ifdef ENABLE_EXT_ADC
+    if (EXT_ADC_IS_PIN(pin)) {
+        if (!getExtAdcCounts(pin, &counts)) counts = readExtAdcNow(pin);
+        RAW_TRACE(RAW_KIND_ADC, pin, counts);
+        return counts;
     }
-    return NAN;
+#endif
+    int reading;
+    if (!getAdcCounts(pin, &reading)) {
+        reading = readAdcNow(pin);
+    }
+    counts = reading;
+    RAW_TRACE(RAW_KIND_ADC, pin, counts);  // Recorded, or replaced in a replay
+    return counts;
 }
 
-// Readings within this margin of 0 or ADC_MAX are considered "railed"
-// (sensor disconnected, shorted, or out of range)
-#define ADC_RAIL_MARGIN 3
-
 /**
  * Centralized ADC reading with validation
  *
- * Reads analog pin twice (discarding first reading) and validates range.
+ * Reads analog pin counts (readAnalogRaw) and validates range. For the
+ * ratiometric sensors that read through it (thermistors, resistive senders,
+ * linear sensors) the counts are scaled to the nominal sensor supply
+ * (getAdcSupplyFactor(), lib/adc_scan.h - 1 without -D ADC_SUPPLY_PIN).
  *
  * @param pin      Analog pin number to read
  * @param isValid  Pointer to bool that will be set to false if reading is out of range
- * @return         ADC reading value (0-ADC_MAX_VALUE)
- *
- * @note First reading after switching pins may be inaccurate due to ADC multiplexer
- *       settling and sample-and-hold capacitor charging. We read twice and keep the second.
+ * @return         ADC reading value (0-ADC_MAX_VALUE, supply-compensated)
+ * @note A NAN reading (external ADC missing) is invalid
+ * @note The rail check is on the uncompensated counts
  */
-int readAnalogPin(int pin, bool* isValid) {
-    // First reading after switching pins may be inaccurate due to ADC multiplexer
-    // settling and sample-and-hold capacitor charging. Read twice, keep second.
-    // Note: 10ms delay between reads improves stability but is currently disabled
-    // to minimize loop time. Uncomment if experiencing noisy readings.
-    analogRead(pin);              // Discard first reading (multiplexer settling)
-    //delay(10);                  // Optional: Allow ADC input to stabilize
-    int reading = analogRead(pin); // Actual measurement
+float readAnalogPin(int pin, bool* isValid) {
+    float reading = readAnalogRaw(pin);
 
     // Check if reading is within valid range (not stuck at rails)
     *isValid = (reading < (ADC_MAX_VALUE - ADC_RAIL_MARGIN) && reading > ADC_RAIL_MARGIN);
-    return reading;
+    return reading * getAdcSupplyFactor();
 }
 
 /**
  * Calculate resistance from ADC reading using voltage divider formula
  *
- * @param reading       ADC reading value (0-ADC_MAX_VALUE)
+ * @param reading       ADC reading value (0-ADC_MAX_VALUE, may be fractional)
  * @param biasResistor  Known bias resistor value in ohms
  * @return              Calculated sensor resistance in ohms, or NAN if invalid
  *
  * Formula: R_sensor = reading * R_bias / (ADC_MAX - reading)
  */
-float calculateResistance(int reading, float biasResistor) {
+float calculateResistance(float reading, float biasResistor) {
     if (reading >= ADC_MAX_VALUE) {
         return NAN;  // Avoid division by zero
     }
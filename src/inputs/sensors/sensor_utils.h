@@ -3,8 +3,10 @@
  *
  * This header provides common utility functions used across multiple sensors:
  * - interpolate(): Linear interpolation for lookup tables
+ * - readAnalogRaw(): Scanned ADC counts (lib/adc_scan.h, lib/ext_adc.h)
  * - readAnalogPin(): ADC reading with validation
  * - calculateResistance(): Voltage divider resistance calculation
+ * - lookupAdcLut(): Precomputed counts-to-value tables (adc_lut.h)
  */
 
 #ifndef SENSOR_UTILS_H
@@ -13,6 +15,14 @@
 #include <Arduino.h>
 #include "../../lib/platform.h"
 #include "../input.h"
+#include "../../lib/adc_scan.h"
+#include "adc_lut.h"
+#include "../input_health.h"  // setInputFault()
+#include "../../hal/hal_placement.h"
+
+// Readings within this margin of 0 or ADC_MAX are considered "railed"
+// (sensor disconnected, shorted, or out of range)
+#define ADC_RAIL_MARGIN 3
 
 // Linear interpolation in PROGMEM lookup tables (descending X order - thermistors)
 float interpolate(float value, byte tableSize, const float* xTable, const float* yTable);
@@ -20,10 +30,14 @@ float interpolate(float value, byte tableSize, const float* xTable, const float*
 // Linear interpolation in PROGMEM lookup tables (ascending X order - pressure sensors)
 float interpolateAscending(float value, byte tableSize, const float* xTable, const float* yTable);
 
+// ADC counts from the background scanner (synchronous read until scanned)
+// Fractional for external ADC channels (ADC:n), which resolve finer
+float readAnalogRaw(int pin);
+
 // Centralized ADC reading with validation
-int readAnalogPin(int pin, bool* isValid);
+float readAnalogPin(int pin, bool* isValid);
 
 // Calculate thermistor resistance from ADC reading
-float calculateResistance(int reading, float biasResistor);
+float calculateResistance(float reading, float biasResistor);
 
 #endif // SENSOR_UTILS_H
@@ -2,60 +2,38 @@
  * hall_speed.cpp - Hall Effect Vehicle Speed Sensing
  *
  * Implements vehicle speed measurement using hall effect sensors.
- * Uses interrupt-based pulse counting to calculate speed based on
- * tire circumference, pulses per revolution, and drive ratio.
+ * Uses interrupt-based pulse timing (lib/freq_capture.h, one channel per
+ * input) to calculate speed based on tire circumference, pulses per
+ * revolution, and drive ratio.
  */
 
 #include "../../../config.h"
 #include "../../../lib/platform.h"
 #include "../../input.h"
+#include "../../input_health.h"
 #include "../../../lib/sensor_types.h"
 #include "../../../lib/sensor_library.h"
 #include "../../../lib/message_api.h"
 #include "../../../lib/log_tags.h"
+#include "../../../lib/freq_capture.h"
 
-// ===== GLOBAL VARIABLES FOR SPEED CALCULATION =====
-// These must be global to be accessed by the ISR
-
-volatile unsigned long speed_pulse_count = 0;
-volatile unsigned long speed_last_time = 0;
-volatile unsigned long speed_pulse_interval = 0;
-
-// ===== INTERRUPT SERVICE ROUTINE =====
-
-/**
- * Speed pulse interrupt service routine
- *
- * Called on each rising edge of the hall effect sensor signal.
- * Measures time between pulses and applies debouncing.
- */
-void speedPulseISR() {
-    unsigned long now = micros();
-    unsigned long interval = now - speed_last_time;
-
-    // Debounce: ignore pulses faster than 500 µs (prevents noise at high speed)
-    // At 300 km/h with 100 pulses/rev on 2000mm circumference:
-    // freq = 300000/(3600*2.0) * 100 = 4166 Hz, period = 240 µs
-    // So 500 µs debounce allows up to ~300 km/h safely
-    if (interval > 500) {
-        speed_pulse_interval = interval;
-        speed_pulse_count++;
-        speed_last_time = now;
-    }
-}
+// Debounce: ignore pulses faster than 500 µs (prevents noise at high speed)
+// At 300 km/h with 100 pulses/rev on 2000mm circumference:
+// freq = 300000/(3600*2.0) * 100 = 4166 Hz, period = 240 µs
+// So 500 µs debounce allows up to ~300 km/h safely
+#define SPEED_DEBOUNCE_US 500
 
 // ===== INITIALIZATION =====
 
 /**
  * Initialize Hall Effect Speed sensing
  *
- * Sets up interrupt-based pulse counting on the specified pin.
+ * Claims a pulse capture channel for the specified pin.
  *
  * @param ptr  Pointer to Input structure containing pin configuration
  */
 void initHallSpeed(Input* ptr) {
-    pinMode(ptr->pin, INPUT);
-    attachInterrupt(digitalPinToInterrupt(ptr->pin), speedPulseISR, RISING);
+    if (!attachFreqCapture(ptr->pin, SPEED_DEBOUNCE_US)) return;
     msg.debug.info(TAG_SENSOR, "Speed sensing on pin %d for %s", ptr->pin, ptr->abbrName);
 }
 
@@ -75,7 +53,7 @@ void initHallSpeed(Input* ptr) {
  * 3. Default fallback - generic configuration
  *
  * Formula:
- * freq_hz = 1000000.0 / pulse_interval_us
+ * freq_hz = blended pulse frequency (lib/freq_capture.h)
  * revolutions_per_second = freq_hz / pulses_per_rev
  * wheel_speed_m_per_s = revolutions_per_second * (tire_circumference_mm / 1000.0) / final_drive_ratio
  * speed_kph = wheel_speed_m_per_s * 3.6
@@ -119,20 +97,22 @@ void readHallSpeed(Input *ptr) {
         }
     }
 
-    // Calculate time since last pulse
-    unsigned long now = millis();
-    unsigned long time_since_pulse = now - (speed_last_time / 1000);
+    FreqCaptureSample pulse;
+    if (!getFreqCapture(ptr->pin, &pulse)) {
+        setInputFault(ptr, FAULT_NO_DEVICE);  // No capture channel for this pin
+        return;
+    }
 
     // Check for timeout (vehicle stopped)
-    if (time_since_pulse > timeout_ms) {
+    if (pulse.idleUs > timeout_ms * 1000UL) {
         ptr->value = 0.0;
         return;
     }
 
-    // Calculate vehicle speed from pulse interval
-    if (speed_pulse_interval > 0) {
-        // Convert pulse interval (µs) to frequency (Hz)
-        float freq_hz = 1000000.0 / speed_pulse_interval;
+    // Calculate vehicle speed from pulse frequency
+    // (lib/freq_capture.h: period timing at low speed, edge counting at high speed)
+    if (pulse.frequencyHz > 0) {
+        float freq_hz = pulse.frequencyHz;
 
         // Calculate wheel revolutions per second
         float revolutions_per_second = freq_hz / pulses_per_rev;
@@ -155,7 +135,7 @@ void readHallSpeed(Input *ptr) {
                 ptr->value = speed_kph;
             }
         } else {
-            ptr->value = NAN;  // Out of range
+            setInputFault(ptr, FAULT_OUT_OF_RANGE);
         }
     }
 }
@@ -15,29 +15,13 @@
 #include <math.h>
 
 /**
- * Read thermistor using Beta equation
- *
- * Converts thermistor resistance to temperature using the simplified
- * Beta parameter equation. Good for moderate temperature ranges.
- *
- * @param ptr  Pointer to Input structure to store temperature reading
- *
- * Calibration sources (in priority order):
- * 1. Custom calibration (RAM) - from EEPROM/serial config mode
- * 2. Preset calibration (PROGMEM) - from sensor library
- * 3. Default fallback - Generic 10K NTC β=3950K at 25°C
+ * Convert ADC counts to temperature using the Beta equation
  *
- * @note Returns NAN if ADC reading is invalid or resistance calculation fails
+ * @param ptr      Input providing the calibration
+ * @param reading  ADC counts (fractional when building a lookup table)
+ * @return         Temperature in Celsius, or NAN if resistance is invalid
  */
-void readThermistorBeta(Input *ptr) {
-    bool isValid;
-    int reading = readAnalogPin(ptr->pin, &isValid);
-
-    if (!isValid) {
-        ptr->value = NAN;
-        return;
-    }
-
+float thermistorBetaFromCounts(const Input *ptr, float reading) {
     // Get calibration values (from custom RAM or PROGMEM preset)
     float R_bias, beta, R0, T0_celsius;
     if (ptr->flags.useCustomCalibration && ptr->calibrationType == CAL_THERMISTOR_BETA) {
@@ -65,8 +49,7 @@ void readThermistorBeta(Input *ptr) {
     float R_thermistor = calculateResistance(reading, R_bias);
 
     if (isnan(R_thermistor) || R_thermistor <= 0) {
-        ptr->value = NAN;
-        return;
+        return NAN;
     }
 
     // Beta equation: T(K) = 1 / (1/T0(K) + (1/β) * ln(R/R0))
@@ -77,5 +60,35 @@ void readThermistorBeta(Input *ptr) {
     float logR_ratio = log(R_thermistor / R0);
     float temp_kelvin = 1.0 / ((1.0 / T0_kelvin) + (logR_ratio / beta));
 
-    ptr->value = temp_kelvin - 273.15;  // Store in Celsius
+    return temp_kelvin - 273.15;  // Celsius
+}
+
+/**
+ * Read thermistor using Beta equation
+ *
+ * Converts thermistor resistance to temperature using the simplified
+ * Beta parameter equation. Good for moderate temperature ranges.
+ *
+ * @param ptr  Pointer to Input structure to store temperature reading
+ *
+ * Calibration sources (in priority order):
+ * 1. Custom calibration (RAM) - from EEPROM/serial config mode
+ * 2. Preset calibration (PROGMEM) - from sensor library
+ * 3. Default fallback - Generic 10K NTC β=3950K at 25°C
+ *
+ * @note Returns NAN if ADC reading is invalid or resistance calculation fails
+ */
+HAL_HOT_CODE void readThermistorBeta(Input *ptr) {
+    bool isValid;
+    float reading = readAnalogPin(ptr->pin, &isValid);
+
+    if (!isValid) {
+        setInputFault(ptr, FAULT_ADC_RAIL);
+        return;
+    }
+
+    // Precomputed table when one was built for this input (sensors/adc_lut.h)
+    if (lookupAdcLut(ptr, reading, &ptr->value)) return;
+
+    ptr->value = thermistorBetaFromCounts(ptr, reading);
 }
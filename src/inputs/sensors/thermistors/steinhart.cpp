@@ -15,29 +15,13 @@
 #include <math.h>
 
 /**
- * Read thermistor using Steinhart-Hart equation
- *
- * Converts thermistor resistance to temperature using the three-coefficient
- * Steinhart-Hart equation, which provides better accuracy than the Beta method.
- *
- * @param ptr  Pointer to Input structure to store temperature reading
- *
- * Calibration sources (in priority order):
- * 1. Custom calibration (RAM) - from EEPROM/serial config mode
- * 2. Preset calibration (PROGMEM) - from sensor library (e.g., VDO sensors)
- * 3. Default fallback - Generic 10K NTC thermistor coefficients
+ * Convert ADC counts to temperature using the Steinhart-Hart equation
  *
- * @note Returns NAN if ADC reading is invalid or resistance calculation fails
+ * @param ptr      Input providing the calibration
+ * @param reading  ADC counts (fractional when building a lookup table)
+ * @return         Temperature in Celsius, or NAN if resistance is invalid
  */
-void readThermistorSteinhart(Input *ptr) {
-    bool isValid;
-    int reading = readAnalogPin(ptr->pin, &isValid);
-
-    if (!isValid) {
-        ptr->value = NAN;
-        return;
-    }
-
+float thermistorSteinhartFromCounts(const Input *ptr, float reading) {
     // Get calibration values (from custom RAM or PROGMEM preset)
     float R_bias, A, B, C;
     if (ptr->flags.useCustomCalibration && ptr->calibrationType == CAL_THERMISTOR_STEINHART) {
@@ -65,8 +49,7 @@ void readThermistorSteinhart(Input *ptr) {
     float R_thermistor = calculateResistance(reading, R_bias);
 
     if (isnan(R_thermistor) || R_thermistor <= 0) {
-        ptr->value = NAN;
-        return;
+        return NAN;
     }
 
     // Steinhart-Hart equation: 1/T = A + B*ln(R) + C*(ln(R))^3
@@ -74,5 +57,35 @@ void readThermistorSteinhart(Input *ptr) {
     float logR3 = logR * logR * logR;
     float temp_kelvin = 1.0 / (A + (B * logR) + (C * logR3));
 
-    ptr->value = temp_kelvin - 273.15;  // Store in Celsius
+    return temp_kelvin - 273.15;  // Celsius
+}
+
+/**
+ * Read thermistor using Steinhart-Hart equation
+ *
+ * Converts thermistor resistance to temperature using the three-coefficient
+ * Steinhart-Hart equation, which provides better accuracy than the Beta method.
+ *
+ * @param ptr  Pointer to Input structure to store temperature reading
+ *
+ * Calibration sources (in priority order):
+ * 1. Custom calibration (RAM) - from EEPROM/serial config mode
+ * 2. Preset calibration (PROGMEM) - from sensor library (e.g., VDO sensors)
+ * 3. Default fallback - Generic 10K NTC thermistor coefficients
+ *
+ * @note Returns NAN if ADC reading is invalid or resistance calculation fails
+ */
+HAL_HOT_CODE void readThermistorSteinhart(Input *ptr) {
+    bool isValid;
+    float reading = readAnalogPin(ptr->pin, &isValid);
+
+    if (!isValid) {
+        setInputFault(ptr, FAULT_ADC_RAIL);
+        return;
+    }
+
+    // Precomputed table when one was built for this input (sensors/adc_lut.h)
+    if (lookupAdcLut(ptr, reading, &ptr->value)) return;
+
+    ptr->value = thermistorSteinhartFromCounts(ptr, reading);
 }
@@ -13,30 +13,16 @@
 #include "../sensor_utils.h"
 
 /**
- * Read thermistor using lookup table interpolation
- *
- * Converts thermistor resistance to temperature by interpolating between
- * values in a PROGMEM lookup table. Provides highest accuracy when using
- * manufacturer calibration data.
+ * Convert ADC counts to temperature using the PROGMEM lookup table
  *
- * @param ptr  Pointer to Input structure to store temperature reading
- *
- * @note Requires preset calibration with lookup table in PROGMEM
- * @note Returns NAN if calibration data is missing or ADC reading is invalid
+ * @param ptr      Input providing the calibration
+ * @param reading  ADC counts (fractional when building a lookup table)
+ * @return         Temperature in Celsius, or NAN if calibration is missing
  */
-void readThermistorLookup(Input *ptr) {
-    bool isValid;
-    int reading = readAnalogPin(ptr->pin, &isValid);
-
-    if (!isValid) {
-        ptr->value = NAN;
-        return;
-    }
-
+float thermistorLookupFromCounts(const Input *ptr, float reading) {
     // Get calibration from PROGMEM (REQUIRED for table method)
     if (ptr->calibrationType != CAL_THERMISTOR_TABLE || ptr->presetCalibration == nullptr) {
-        ptr->value = NAN;  // Can't do lookup without table
-        return;
+        return NAN;  // Can't do lookup without table
     }
 
     const ThermistorLookupCalibration* cal = (const ThermistorLookupCalibration*)ptr->presetCalibration;
@@ -46,8 +32,7 @@ void readThermistorLookup(Input *ptr) {
     float R_thermistor = calculateResistance(reading, R_bias);
 
     if (isnan(R_thermistor) || R_thermistor <= 0) {
-        ptr->value = NAN;
-        return;
+        return NAN;
     }
 
     // Read lookup table info from PROGMEM
@@ -55,6 +40,33 @@ void readThermistorLookup(Input *ptr) {
     const float* resistance_table = (const float*)pgm_read_ptr(&cal->resistance_table);
     const float* temperature_table = (const float*)pgm_read_ptr(&cal->temperature_table);
 
-    ptr->value = interpolate(R_thermistor, table_size,
-                            resistance_table, temperature_table);
+    return interpolate(R_thermistor, table_size,
+                       resistance_table, temperature_table);
+}
+
+/**
+ * Read thermistor using lookup table interpolation
+ *
+ * Converts thermistor resistance to temperature by interpolating between
+ * values in a PROGMEM lookup table. Provides highest accuracy when using
+ * manufacturer calibration data.
+ *
+ * @param ptr  Pointer to Input structure to store temperature reading
+ *
+ * @note Requires preset calibration with lookup table in PROGMEM
+ * @note Returns NAN if calibration data is missing or ADC reading is invalid
+ */
+HAL_HOT_CODE void readThermistorLookup(Input *ptr) {
+    bool isValid;
+    float reading = readAnalogPin(ptr->pin, &isValid);
+
+    if (!isValid) {
+        setInputFault(ptr, FAULT_ADC_RAIL);
+        return;
+    }
+
+    // Precomputed table when one was built for this input (sensors/adc_lut.h)
+    if (lookupAdcLut(ptr, reading, &ptr->value)) return;
+
+    ptr->value = thermistorLookupFromCounts(ptr, reading);
 }
@@ -10,12 +10,39 @@
 #include "../../../lib/platform.h"
 #include "../../../lib/bus_manager.h"
 #include "../../input.h"
+#include "../../input_manager.h"
+#include "thermocouple_batch.h"
+#include "thermocouple_linear.h"
+#include "../../input_health.h"
+#include "../../../lib/raw_trace.h"
 #include <SPI.h>
 
+#define MAX31855_CONVERSION_MS 100
+#define MAX31855_READ_INTERVAL_MS 100  // Batch interval (registry minReadInterval)
+
+void initThermocoupleCS(Input* ptr);
+
+/**
+ * Initialize MAX31855 thermocouple
+ *
+ * Sets up the chip select pin and holds the first read until the chip has
+ * completed its first conversion after power-up.
+ *
+ * @param ptr  Pointer to Input structure containing pin configuration
+ *
+ * @note Conversion time is up to 100ms - earlier reads return stale/invalid data
+ */
+void initMAX31855(Input *ptr) {
+    initThermocoupleCS(ptr);
+    setInputWarmup(ptr, MAX31855_CONVERSION_MS);
+}
+
 /**
  * Read MAX31855 thermocouple sensor
  *
- * Reads temperature from MAX31855 via SPI and stores result in Celsius.
+ * Decodes the MAX31855 frame from the thermocouple batch (read synchronously
+ * via SPI until the batch has one) and stores the result in Celsius,
+ * linearized against its cold junction (thermocouple_linear.h).
  *
  * @param ptr  Pointer to Input structure to store temperature reading
  *
@@ -23,37 +50,20 @@
  * - 32-bit data transfer (MSB first)
  * - Bits 2-0 indicate fault conditions
  * - Temperature data in bits 31-18 (14 bits, signed, 0.25°C resolution)
+ * - Cold junction in bits 15-4 (12 bits, signed, 0.0625°C resolution)
  *
  * @note Returns NAN if any fault is detected (thermocouple short/open, etc.)
  */
 void readMAX31855(Input *ptr) {
-    uint32_t d = 0;
-    uint8_t buf[4];
-
-    SPIClass* spi = getActiveSPI();
-    spi->beginTransaction(SPISettings(4000000, MSBFIRST, SPI_MODE0));
-    digitalWrite(ptr->pin, LOW);
-    delayMicroseconds(1);
-
-    for (int i = 0; i < 4; i++) {
-        buf[i] = spi->transfer(0x00);
+    uint32_t d;
+    if (!getThermocoupleRaw(ptr->pin, 4, MAX31855_READ_INTERVAL_MS, &d)) {
+        d = readThermocoupleNow(ptr->pin, 4);
     }
+    RAW_TRACE(RAW_KIND_SPI, ptr->pin, d);
 
-    digitalWrite(ptr->pin, HIGH);
-    spi->endTransaction();
-
-    // Combine bytes
-    d = buf[0];
-    d <<= 8;
-    d |= buf[1];
-    d <<= 8;
-    d |= buf[2];
-    d <<= 8;
-    d |= buf[3];
-
-    // Check fault bits
+    // Check fault bits (D0 open circuit, D1 short to GND, D2 short to VCC)
     if (d & 0x07) {
-        ptr->value = NAN;
+        setInputFault(ptr, (d & 0x01) ? FAULT_OPEN_CIRCUIT : FAULT_SHORT_CIRCUIT);
         return;
     }
 
@@ -67,5 +77,10 @@ void readMAX31855(Input *ptr) {
         temp_raw = (d >> 18) & 0x00003FFF;
     }
 
+#if TC_LINEARIZE
+    int16_t coldJunction16 = (int16_t)(d & 0xFFF0) >> 4;
+    ptr->value = linearizeThermocouple(ptr->pin, temp_raw * 4, coldJunction16);
+#else
     ptr->value = temp_raw * 0.25;  // Store in Celsius
+#endif
 }
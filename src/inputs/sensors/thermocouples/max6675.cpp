@@ -9,12 +9,39 @@
 #include "../../../lib/platform.h"
 #include "../../../lib/bus_manager.h"
 #include "../../input.h"
+#include "../../input_manager.h"
+#include "thermocouple_batch.h"
+#include "thermocouple_linear.h"
+#include "../../input_health.h"
+#include "../../../lib/raw_trace.h"
 #include <SPI.h>
 
+#define MAX6675_CONVERSION_MS 220
+#define MAX6675_READ_INTERVAL_MS 250  // Batch interval (registry minReadInterval)
+
+void initThermocoupleCS(Input* ptr);
+
+/**
+ * Initialize MAX6675 thermocouple
+ *
+ * Sets up the chip select pin and holds the first read until the chip has
+ * completed its first conversion after power-up.
+ *
+ * @param ptr  Pointer to Input structure containing pin configuration
+ *
+ * @note Conversion time is up to 220ms - earlier reads return stale/invalid data
+ */
+void initMAX6675(Input *ptr) {
+    initThermocoupleCS(ptr);
+    setInputWarmup(ptr, MAX6675_CONVERSION_MS);
+}
+
 /**
  * Read MAX6675 thermocouple sensor
  *
- * Reads temperature from MAX6675 via SPI and stores result in Celsius.
+ * Decodes the MAX6675 frame from the thermocouple batch (read synchronously
+ * via SPI until the batch has one) and stores the result in Celsius,
+ * linearized against an assumed cold junction (thermocouple_linear.h).
  *
  * @param ptr  Pointer to Input structure to store temperature reading
  *
@@ -27,22 +54,21 @@
  * @note Returns NAN if thermocouple is disconnected
  */
 void readMAX6675(Input *ptr) {
-    SPIClass* spi = getActiveSPI();
-    spi->beginTransaction(SPISettings(4000000, MSBFIRST, SPI_MODE0));
-    digitalWrite(ptr->pin, LOW);
-    delayMicroseconds(1);
-
-    uint16_t value = spi->transfer(0x00);
-    value <<= 8;
-    value |= spi->transfer(0x00);
-
-    digitalWrite(ptr->pin, HIGH);
-    spi->endTransaction();
+    uint32_t frame;
+    if (!getThermocoupleRaw(ptr->pin, 2, MAX6675_READ_INTERVAL_MS, &frame)) {
+        frame = readThermocoupleNow(ptr->pin, 2);
+    }
+    RAW_TRACE(RAW_KIND_SPI, ptr->pin, frame);
+    uint16_t value = frame;
 
     if (value & 0x4) {
-        ptr->value = NAN;  // No thermocouple attached
+        setInputFault(ptr, FAULT_OPEN_CIRCUIT);  // No thermocouple attached
     } else {
         value >>= 3;
+#if TC_LINEARIZE
+        ptr->value = linearizeThermocouple(ptr->pin, (int32_t)value * 4, TC_MAX6675_COLD_JUNCTION_C * 16);
+#else
         ptr->value = value * 0.25;  // Store in Celsius
+#endif
     }
 }
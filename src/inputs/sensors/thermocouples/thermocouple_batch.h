@@ -0,0 +1,60 @@
+/*
+ * thermocouple_batch.h - Batched SPI reads for thermocouple amplifiers
+ *
+ * Instead of each readMAX6675()/readMAX31855() opening its own SPI
+ * transaction from inside the sensor task, one scheduled batch services every
+ * thermocouple chip select that is due, back to back inside a single
+ * beginTransaction()/endTransaction() window, and keeps the raw frame per CS
+ * pin. The read functions only decode the cached frame.
+ *
+ * Each chip keeps its own interval (its conversion time - reading a MAX6675
+ * early restarts its conversion), so a batch pass reads only the chips whose
+ * conversion has completed; chips on the same interval line up into the same
+ * pass.
+ *
+ * Chips register on their first read and are forgotten whenever the input
+ * schedule is rebuilt (same lifecycle as lib/adc_scan.h). A chip without a
+ * fresh frame is read synchronously, so callers always get a reading.
+ *
+ * Usage:
+ *   // Scheduled task - reschedule at the returned deadline
+ *   setTaskDeadline(tcTaskId, updateThermocoupleBatch(now));
+ *
+ *   uint32_t raw;
+ *   if (!getThermocoupleRaw(pin, 2, 250, &raw)) raw = readThermocoupleNow(pin, 2);
+ *
+ * The bus is taken through the SPI arbiter (lib/bus_manager.h), which
+ * times it and keeps SD writes clear of the next batch deadline.
+ *
+ * Build Flags:
+ *   -D TC_BATCH_MAX_DEVICES=n  - Chip selects tracked by the batch (default 8)
+ *   -D THERMOCOUPLE_SPI_BUS=n  - SPI bus of the probes (default: active bus, lib/bus_manager.h)
+ */
+
+#ifndef THERMOCOUPLE_BATCH_H
+#define THERMOCOUPLE_BATCH_H
+
+#include <Arduino.h>
+
+#ifndef TC_BATCH_MAX_DEVICES
+#define TC_BATCH_MAX_DEVICES 8
+#endif
+
+// Idle deadline when no chip is registered
+#define TC_BATCH_IDLE_MS 250
+
+// Run one batch pass over the due chips; returns the next deadline
+uint32_t updateThermocoupleBatch(uint32_t now);
+
+// Latest raw frame (bytes long, MSB first) for the chip on csPin
+// Registers the chip with its read interval on first call
+// Returns false if there is no fresh frame - use readThermocoupleNow()
+bool getThermocoupleRaw(uint8_t csPin, uint8_t bytes, uint16_t interval_ms, uint32_t* raw);
+
+// Synchronous frame read (own SPI transaction)
+uint32_t readThermocoupleNow(uint8_t csPin, uint8_t bytes);
+
+// Forget all registered chips (inputs were reconfigured)
+void resetThermocoupleBatch();
+
+#endif // THERMOCOUPLE_BATCH_H
@@ -1,7 +1,9 @@
 /*
  * thermocouple_common.cpp - Shared Thermocouple Initialization
  *
- * Provides common initialization function for SPI-based thermocouples.
+ * Provides common initialization function for SPI-based thermocouples, the
+ * batched SPI reader (thermocouple_batch.h) and the NIST linearization
+ * (thermocouple_linear.h).
  * Used by both MAX6675 and MAX31855 sensors.
  */
 
@@ -10,8 +12,14 @@
 #include "../../input.h"
 #include "../../../lib/message_api.h"
 #include "../../../lib/log_tags.h"
+#include "../../../lib/bus_manager.h"
+#include "thermocouple_batch.h"
+#include "thermocouple_linear.h"
+#include "../../../lib/generated/thermocouple_tables.h"
 #include <SPI.h>
 
+#define THERMOCOUPLE_SPI_SETTINGS SPISettings(4000000, MSBFIRST, SPI_MODE0)
+
 /**
  * Initialize thermocouple chip select pin
  *
@@ -20,10 +28,173 @@
  *
  * @param ptr  Pointer to Input structure containing pin configuration
  *
- * @note This function is shared by both MAX6675 and MAX31855 sensors.
+ * @note Shared by initMAX6675() and initMAX31855(), which add their
+ *       conversion-time warm-up.
  */
 void initThermocoupleCS(Input* ptr) {
     pinMode(ptr->pin, OUTPUT);
     digitalWrite(ptr->pin, HIGH);  // CS idle state is HIGH
     msg.debug.info(TAG_SENSOR, "Thermocouple CS pin %d for %s", ptr->pin, ptr->abbrName);
 }
+
+// ===== BATCHED READS =====
+
+struct ThermocoupleChip {
+    uint8_t csPin;
+    uint8_t bytes;          // Frame length (MAX6675: 2, MAX31855: 4)
+    uint16_t interval;      // Conversion time - minimum time between reads
+    bool valid;             // frame holds a completed read
+    uint32_t frame;         // Raw frame, MSB first
+    uint32_t nextDue;       // millis() of the next batch read
+    uint32_t updatedMs;     // millis() when frame was stored
+    bool cjValid;           // The cold junction below is set
+    int16_t cj16;           // Cached cold junction (1/16 C) and its voltage (thermocouple_linear.h)
+    int16_t cjMicrovolts;
+    uint32_t cjRefreshMs;   // millis() when they were computed
+};
+
+static ThermocoupleChip chips[TC_BATCH_MAX_DEVICES];
+static uint8_t numChips = 0;
+
+// Clock one frame out of the chip on csPin (caller holds the transaction)
+static uint32_t transferFrame(SPIClass* spi, uint8_t csPin, uint8_t bytes) {
+    uint8_t buf[4] = {0, 0, 0, 0};
+
+    digitalWrite(csPin, LOW);
+    delayMicroseconds(1);
+    spi->transfer(buf, bytes);  // Block transfer - uses the FIFO where the core has one
+    digitalWrite(csPin, HIGH);
+
+    uint32_t frame = 0;
+    for (uint8_t i = 0; i < bytes; i++) {
+        frame = (frame << 8) | buf[i];
+    }
+    return frame;
+}
+
+static ThermocoupleChip* findChip(uint8_t csPin) {
+    for (uint8_t i = 0; i < numChips; i++) {
+        if (chips[i].csPin == csPin) return &chips[i];
+    }
+    return nullptr;
+}
+
+uint32_t updateThermocoupleBatch(uint32_t now) {
+    uint32_t next = now + TC_BATCH_IDLE_MS;
+    SPIClass* spi = nullptr;
+
+    for (uint8_t i = 0; i < numChips; i++) {
+        ThermocoupleChip* chip = &chips[i];
+        if ((int32_t)(now - chip->nextDue) >= 0) {
+            // One transaction window for every chip due in this pass
+            if (spi == nullptr) {
+                spi = spiBegin(SPI_CLIENT_THERMOCOUPLE, THERMOCOUPLE_SPI_SETTINGS);
+            }
+            chip->frame = transferFrame(spi, chip->csPin, chip->bytes);
+            chip->updatedMs = now;
+            chip->valid = true;
+
+            chip->nextDue += chip->interval;
+            if ((int32_t)(now - chip->nextDue) >= 0) {
+                chip->nextDue = now + chip->interval;
+            }
+        }
+        if ((int32_t)(chip->nextDue - next) < 0) {
+            next = chip->nextDue;
+        }
+    }
+
+    if (spi != nullptr) {
+        spiEnd(SPI_CLIENT_THERMOCOUPLE);
+    }
+    if (numChips > 0) {
+        spiSetNextDue(SPI_CLIENT_THERMOCOUPLE, next);  // SD writes keep clear of it
+    }
+    return next;
+}
+
+bool getThermocoupleRaw(uint8_t csPin, uint8_t bytes, uint16_t interval_ms, uint32_t* raw) {
+    ThermocoupleChip* chip = findChip(csPin);
+    if (chip == nullptr) {
+        if (numChips >= TC_BATCH_MAX_DEVICES) return false;
+        chip = &chips[numChips++];
+        chip->csPin = csPin;
+        chip->bytes = bytes;
+        chip->interval = interval_ms;
+        chip->valid = false;
+        chip->cjValid = false;
+        chip->nextDue = millis() + interval_ms;  // Caller reads synchronously now
+        return false;
+    }
+
+    // Two missed batch passes - the scheduler is overloaded, read directly
+    if (!chip->valid || (millis() - chip->updatedMs) > 2UL * chip->interval) {
+        return false;
+    }
+    *raw = chip->frame;
+    return true;
+}
+
+uint32_t readThermocoupleNow(uint8_t csPin, uint8_t bytes) {
+    SPIClass* spi = spiBegin(SPI_CLIENT_THERMOCOUPLE, THERMOCOUPLE_SPI_SETTINGS);
+    uint32_t frame = transferFrame(spi, csPin, bytes);
+    spiEnd(SPI_CLIENT_THERMOCOUPLE);
+
+    // The chip restarted its conversion - the batch waits a full interval
+    ThermocoupleChip* chip = findChip(csPin);
+    if (chip != nullptr) {
+        chip->frame = frame;
+        chip->updatedMs = millis();
+        chip->valid = true;
+        chip->nextDue = chip->updatedMs + chip->interval;
+    }
+    return frame;
+}
+
+void resetThermocoupleBatch() {
+    numChips = 0;
+}
+
+// ===== NIST LINEARIZATION =====
+
+// Linear interpolation in a PROGMEM table of 2^shift steps; offset is the
+// input less the table's start. Past either end the end segment is extended.
+static int32_t interpolateTable(const int16_t* table, uint8_t count, int32_t offset, uint8_t shift) {
+    int32_t i = offset >> shift;
+    if (i < 0) i = 0;
+    if (i > count - 2) i = count - 2;
+    int32_t a = (int16_t)pgm_read_word(&table[i]);
+    int32_t b = (int16_t)pgm_read_word(&table[i + 1]);
+    return a + (((b - a) * (offset - (i << shift))) >> shift);
+}
+
+static int16_t coldJunctionMicrovolts(int16_t coldJunction16) {
+    int32_t offset = coldJunction16 - TC_K_CJ_START_C * 16;
+    return interpolateTable(TC_K_COLD_JUNCTION, TC_K_CJ_COUNT, offset, TC_K_CJ_SHIFT + 4);
+}
+
+float linearizeThermocouple(uint8_t csPin, int32_t reported16, int16_t coldJunction16) {
+    ThermocoupleChip* chip = findChip(csPin);
+    int16_t cj16 = coldJunction16;
+    int16_t coldUv;
+    if (chip == nullptr) {
+        coldUv = coldJunctionMicrovolts(cj16);
+    } else {
+        uint32_t now = millis();
+        if (!chip->cjValid || now - chip->cjRefreshMs >= TC_COLD_JUNCTION_REFRESH_MS) {
+            chip->cj16 = cj16;
+            chip->cjMicrovolts = coldJunctionMicrovolts(cj16);
+            chip->cjRefreshMs = now;
+            chip->cjValid = true;
+        }
+        cj16 = chip->cj16;
+        coldUv = chip->cjMicrovolts;
+    }
+
+    // The chip reads (V / Seebeck) + cold junction. Undoing it against the
+    // cached junction instead of the current one costs only the line's drift
+    // from NIST over the change since the refresh - well under 0.1 C.
+    int32_t measuredUv = (reported16 - cj16) * (int32_t)TC_K_SEEBECK_NV / 16000;
+    int32_t offset = measuredUv + coldUv - TC_K_INVERSE_START_UV;
+    return interpolateTable(TC_K_INVERSE, TC_K_INVERSE_COUNT, offset, TC_K_INVERSE_SHIFT) / 16.0f;
+}
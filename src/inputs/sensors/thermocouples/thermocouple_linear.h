@@ -0,0 +1,55 @@
+/*
+ * thermocouple_linear.h - NIST linearization of thermocouple amplifier readings
+ *
+ * The MAX6675 and MAX31855 report a temperature that assumes a constant
+ * Seebeck coefficient (41.276 uV/C for K-type). A real K-type junction drifts
+ * from that line by several degrees, more at high EGT: 1200 C reads about
+ * 1183 C. linearizeThermocouple() takes the chip's reading back to the
+ * thermocouple voltage, adds the cold junction's voltage and looks the total
+ * up in the NIST ITS-90 tables of lib/generated/thermocouple_tables.h
+ * (tools/generate_thermocouple_tables.py) - two table interpolations in
+ * integer math, no polynomial per read.
+ *
+ * Accuracy against the NIST functions: within 0.05 C from 0 C up, within
+ * 2 C at -200 C. The chips' own error (about +-2 C) is not corrected.
+ *
+ * The cold junction and its voltage are cached per chip and refreshed every
+ * TC_COLD_JUNCTION_REFRESH_MS - the junction moves slowly, so most reads are
+ * the inverse lookup alone. The MAX6675 doesn't report its cold junction, so
+ * it is taken as TC_MAX6675_COLD_JUNCTION_C; near room temperature the line
+ * is close to NIST, so an error there moves the reading by a fraction of a
+ * degree.
+ *
+ * Build Flags:
+ *   -D TC_LINEARIZE=0                  - Keep the chips' linear readings
+ *   -D TC_COLD_JUNCTION_REFRESH_MS=n   - Cold junction refresh (default 1000)
+ *   -D TC_MAX6675_COLD_JUNCTION_C=n    - Assumed MAX6675 cold junction (default 25)
+ */
+
+#ifndef THERMOCOUPLE_LINEAR_H
+#define THERMOCOUPLE_LINEAR_H
+
+#include <Arduino.h>
+
+#ifndef TC_LINEARIZE
+#define TC_LINEARIZE 1
+#endif
+
+#ifndef TC_COLD_JUNCTION_REFRESH_MS
+#define TC_COLD_JUNCTION_REFRESH_MS 1000
+#endif
+
+#ifndef TC_MAX6675_COLD_JUNCTION_C
+#define TC_MAX6675_COLD_JUNCTION_C 25
+#endif
+
+/**
+ * True temperature of a K-type junction from an amplifier's linear reading
+ * @param csPin           Chip select - keys the cached cold junction
+ * @param reported16      The chip's hot-junction temperature in 1/16 C
+ * @param coldJunction16  Cold-junction temperature in 1/16 C
+ * @return Temperature in C
+ */
+float linearizeThermocouple(uint8_t csPin, int32_t reported16, int16_t coldJunction16);
+
+#endif // THERMOCOUPLE_LINEAR_H
@@ -8,6 +8,7 @@
 #include "../../../config.h"
 #include "../../../lib/platform.h"
 #include "../../input.h"
+#include "../sensor_utils.h"
 
 /**
  * Read voltage directly (no divider)
@@ -21,11 +22,11 @@
  *
  * @note Returns NAN if reading is below threshold (sensor disconnected)
  */
-void readVoltageDirect(Input *ptr) {
-    int reading = analogRead(ptr->pin);
+HAL_HOT_CODE void readVoltageDirect(Input *ptr) {
+    float reading = readAnalogRaw(ptr->pin);
 
-    if (reading < 10) {
-        ptr->value = NAN;
+    if (!(reading >= 10)) {  // Also NAN: external ADC missing
+        setInputFault(ptr, FAULT_ADC_RAIL);
         return;
     }
 
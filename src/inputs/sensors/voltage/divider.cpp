@@ -10,14 +10,17 @@
 #include "../../../lib/platform.h"
 #include "../../input.h"
 #include "../../../lib/sensor_types.h"
+#include "../sensor_utils.h"
+#include <math.h>
 
 /**
- * Read voltage through resistor divider
+ * Counts-to-voltage line of a resistor divider
  *
- * Measures voltage at the midpoint of a resistor divider and calculates
- * the original voltage before division.
+ * Folds AREF/ADC_MAX_VALUE, the divider ratio and the correction factor into
+ * the gain; the offset is the calibration offset. Counts are not clamped.
  *
- * @param ptr  Pointer to Input structure to store voltage reading
+ * @param ptr   Input providing the calibration
+ * @param line  Filled with the line
  *
  * Calibration sources (in priority order):
  * 1. Custom calibration (RAM) - r1, r2, correction factor, offset
@@ -26,14 +29,7 @@
  *
  * Formula: V = ADC * (AREF / ADC_MAX) * divider_ratio * correction + offset
  */
-void readVoltageDivider(Input *ptr) {
-    int reading = analogRead(ptr->pin);
-
-    if (reading < 10) {
-        ptr->value = NAN;
-        return;
-    }
-
+void voltageDividerLine(const Input *ptr, AdcLinear* line) {
     // Get calibration values (from custom RAM or PROGMEM preset)
     float r1, r2, correction, offset;
     if (ptr->flags.useCustomCalibration && ptr->calibrationType == CAL_VOLTAGE_DIVIDER) {
@@ -62,8 +58,37 @@ void readVoltageDivider(Input *ptr) {
     // Calculate divider ratio from resistor values
     float divider_ratio = (r1 + r2) / r2;
 
-    // Calculate voltage: V = ADC * (AREF / ADC_MAX) * divider_ratio * correction + offset
-    float voltage = (reading * AREF_VOLTAGE / (float)ADC_MAX_VALUE) * divider_ratio * correction + offset;
+    line->gain = (AREF_VOLTAGE / (float)ADC_MAX_VALUE) * divider_ratio * correction;
+    line->offset = offset;
+    line->countsMin = -INFINITY;
+    line->countsMax = INFINITY;
+}
+
+/**
+ * Read voltage through resistor divider
+ *
+ * Measures voltage at the midpoint of a resistor divider and calculates
+ * the original voltage before division.
+ *
+ * @param ptr  Pointer to Input structure to store voltage reading
+ *
+ * The line from voltageDividerLine() is precomputed when the calibration is
+ * assigned (sensors/adc_lut.h), so a read is one multiply-add.
+ */
+HAL_HOT_CODE void readVoltageDivider(Input *ptr) {
+    float reading = readAnalogRaw(ptr->pin);
+
+    if (!(reading >= 10)) {  // Also NAN: external ADC missing
+        setInputFault(ptr, FAULT_ADC_RAIL);
+        return;
+    }
+
+    const AdcLinear* line = getAdcLinear(ptr);
+    AdcLinear computed;
+    if (line == nullptr) {
+        voltageDividerLine(ptr, &computed);
+        line = &computed;
+    }
 
-    ptr->value = voltage;
+    ptr->value = applyAdcLinear(line, reading);
 }
@@ -14,6 +14,11 @@
 #include "command_helpers.h"
 #include "../lib/message_router.h"
 #include "../lib/message_api.h"
+#include "../lib/memory_report.h"
+#include "../lib/response_stream.h"
+#ifdef ENABLE_CAN_REPLAY
+#include "../lib/can_replay.h"
+#endif
 #include <string.h>
 #include <ctype.h>
 
@@ -37,6 +42,18 @@
 static CLI_UINT cli_buffer[BYTES_TO_CLI_UINTS(CLI_BUFFER_SIZE)];
 static EmbeddedCli* cli = nullptr;
 
+// CLI output (the prompt) after a command whose answer is still going out
+// (response_stream.h) - written once the answer is complete
+#define CLI_HELD_OUTPUT 16
+static char heldOutput[CLI_HELD_OUTPUT];
+static uint8_t heldCount = 0;
+
+static void releaseHeldOutput() {
+    if (heldCount == 0 || responseActive()) return;
+    msg.control.write((const uint8_t*)heldOutput, heldCount);
+    heldCount = 0;
+}
+
 //=============================================================================
 // Callbacks
 //=============================================================================
@@ -44,6 +61,14 @@ static EmbeddedCli* cli = nullptr;
 // Write character callback - embedded-cli calls this to output characters
 static void cli_write_char(EmbeddedCli* embeddedCli, char c) {
     (void)embeddedCli;
+    if (responseActive()) {
+        if (heldCount < sizeof(heldOutput)) {
+            heldOutput[heldCount++] = c;
+            return;
+        }
+        finishResponse();  // More than a prompt - the answer has to go first
+    }
+    releaseHeldOutput();
     msg.control.write(c);
 }
 
@@ -157,6 +182,7 @@ void initSerialConfig() {
     }
 
     // Set buffer after size check
+    noteStaticMemory(F("CLI buffer"), sizeof(cli_buffer));
     config->cliBuffer = cli_buffer;
     config->cliBufferSize = CLI_BUFFER_SIZE;
 
@@ -222,12 +248,37 @@ void handleCommandInput(char c) {
     }
 }
 
+/**
+ * Handle a block of input (called by MessageRouter with each bulk read)
+ * Each complete line is run as soon as it ends, so a pasted script never
+ * holds more than one line in the CLI's receive buffer
+ */
+bool handleCommandInput(const uint8_t* data, size_t len) {
+    if (cli == nullptr || len == 0) return false;
+#if defined(ENABLE_CAN_REPLAY) && defined(ENABLE_CAN)
+    if (isCANReplayStreaming()) {
+        return feedCANReplayStream(data, len);  // Log lines, not commands, until END
+    }
+#endif
+    for (size_t i = 0; i < len; i++) {
+        // A line after one that started a response (a pasted script): that answer first
+        if (responseActive()) finishResponse();
+        releaseHeldOutput();
+        embeddedCliReceiveChar(cli, (char)data[i]);
+        if (data[i] == '\r' || data[i] == '\n') {
+            embeddedCliProcess(cli);
+        }
+    }
+    return data[len - 1] != '\r' && data[len - 1] != '\n';
+}
+
 /**
  * Process CLI - should be called from main loop
  * This processes received characters and executes commands
  */
 void processSerialCommands() {
     if (cli != nullptr) {
+        releaseHeldOutput();
         embeddedCliProcess(cli);
     }
 }
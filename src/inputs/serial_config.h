@@ -27,11 +27,16 @@ void handleSerialCommand(char* cmd);
 // Handle incoming character input (called by MessageRouter)
 void handleCommandInput(char c);
 
+// Handle a block of received input, running each command as its line ends
+// (called by MessageRouter). Returns true if it ends mid-line.
+bool handleCommandInput(const uint8_t* data, size_t len);
+
 #else // USE_STATIC_CONFIG defined
 
 // Stub functions for static builds (no runtime configuration)
 inline void processSerialCommands() {}
 inline void handleCommandInput(char) {}
+inline bool handleCommandInput(const uint8_t*, size_t) { return false; }
 
 #endif // USE_STATIC_CONFIG
 
@@ -0,0 +1,298 @@
+/*
+ * adc_scan.cpp - Background ADC acquisition implementation
+ */
+
+#include "adc_scan.h"
+#include "../hal/hal_adc.h"
+#include "../hal/hal_adc_continuous.h"
+#ifdef ADC_SUPPLY_PIN
+#include "pin_registry.h"
+#include <math.h>
+#endif
+
+struct AdcChannel {
+    uint8_t pin;
+    bool background;       // hal::adcStart() accepted this pin
+    bool valid;            // counts holds a completed scan result
+    uint16_t counts;       // Averaged counts from the last scan
+    uint32_t updatedMs;    // millis() when counts was stored
+};
+
+static AdcChannel channels[ADC_SCAN_MAX_PINS];
+static uint8_t numChannels = 0;
+
+// Scan state
+static uint8_t current = 0;        // Channel being sampled
+static uint8_t sampleCount = 0;    // Conversions taken on it (settle + oversample)
+static uint32_t accumulator = 0;
+static bool converting = false;    // Background conversion in flight
+static uint32_t nextScanMs = 0;
+
+// Continuous hardware scan (hal/hal_adc_continuous.h)
+#if HAL_HAS_ADC_CONTINUOUS
+static bool continuous = false;       // Hardware is scanning all channels
+static bool continuousDirty = false;  // Channel list changed - (re)start it
+#endif
+
+static bool suspended = false;        // ADC owned elsewhere (suspendAdcScan)
+
+#ifdef ADC_SUPPLY_PIN
+// Nominal supply in counts at the pin - factor = this / measured counts
+#define SUPPLY_NOMINAL_COUNTS ((float)ADC_SUPPLY_NOMINAL / ADC_SUPPLY_DIVIDER / AREF_VOLTAGE * ADC_MAX_VALUE)
+
+static float supplyFactor = 1.0f;
+static float supplyVoltage = NAN;
+
+// New supply reading (channel 0) - once per pass
+static void updateSupplyFactor() {
+    const AdcChannel* ch = &channels[0];
+    if (numChannels == 0 || !ch->valid) return;
+
+    float ratio = ch->counts / SUPPLY_NOMINAL_COUNTS;
+    supplyVoltage = ratio * ADC_SUPPLY_NOMINAL;
+    if (ratio < 1.0f - ADC_SUPPLY_MAX_DEVIATION || ratio > 1.0f + ADC_SUPPLY_MAX_DEVIATION) {
+        supplyFactor = 1.0f;      // Not wired or regulator out - don't correct with it
+        return;
+    }
+    supplyFactor = 1.0f / ratio;
+}
+
+float getAdcSupplyFactor() {
+    return supplyFactor;
+}
+
+float getAdcSupplyVoltage() {
+    return supplyVoltage;
+}
+#endif
+
+// ===== SCAN STATE MACHINE =====
+
+// Store a result for a channel (scan pass, continuous frame or synchronous read)
+static void storeCounts(AdcChannel* ch, uint16_t counts) {
+    ch->counts = counts;
+    ch->updatedMs = millis();
+    ch->valid = true;
+}
+
+// Feed one conversion of the current channel
+static void addSample(int reading) {
+    if (sampleCount >= ADC_SETTLE_SAMPLES) {
+        accumulator += reading;
+    }
+    sampleCount++;
+
+    if (sampleCount >= ADC_SETTLE_SAMPLES + ADC_OVERSAMPLE) {
+        storeCounts(&channels[current], (accumulator + ADC_OVERSAMPLE / 2) / ADC_OVERSAMPLE);
+
+        current++;
+        sampleCount = 0;
+        accumulator = 0;
+    }
+}
+
+// Let an in-flight conversion finish so the ADC is free for analogRead()
+static void finishPendingConversion() {
+    if (!converting) return;
+    while (!hal::adcDone()) {}
+    converting = false;
+    addSample(hal::adcResult());
+}
+
+#if HAL_HAS_ADC_CONTINUOUS
+static void stopContinuous() {
+    if (!continuous) return;
+    hal::adcContinuousEnd();
+    continuous = false;
+}
+
+// Hand the current channel list to the hardware scanner (falls back to the
+// conversion-by-conversion scan if the backend rejects it)
+static void restartContinuous() {
+    finishPendingConversion();
+    stopContinuous();
+    continuousDirty = false;
+    if (numChannels == 0) return;
+
+    uint8_t pins[ADC_SCAN_MAX_PINS];
+    for (uint8_t i = 0; i < numChannels; i++) pins[i] = channels[i].pin;
+    continuous = hal::adcContinuousBegin(pins, numChannels, ADC_OVERSAMPLE);
+
+    current = 0;
+    sampleCount = 0;
+    accumulator = 0;
+}
+#endif
+
+void initAdcScan() {
+    hal::adcInit();
+#ifdef ADC_SUPPLY_PIN
+    registerPin(ADC_SUPPLY_PIN, PIN_RESERVED, "Sensor supply");
+#endif
+    resetAdcScan();
+}
+
+uint32_t updateAdcScan(uint32_t now) {
+    if (suspended) return now + ADC_SCAN_INTERVAL_MS;
+
+#if HAL_HAS_ADC_CONTINUOUS
+    if (continuousDirty) restartContinuous();
+    if (continuous) {
+        // Hardware scans on its own - just publish the latest finished frame
+        uint16_t counts[ADC_SCAN_MAX_PINS];
+        if (hal::adcContinuousRead(counts)) {
+            for (uint8_t i = 0; i < numChannels; i++) storeCounts(&channels[i], counts[i]);
+#ifdef ADC_SUPPLY_PIN
+            updateSupplyFactor();
+#endif
+        }
+        return now + ADC_SCAN_INTERVAL_MS;
+    }
+#endif
+
+    if (converting) {
+        if (!hal::adcDone()) return now;  // Still converting - stay due
+        converting = false;
+        addSample(hal::adcResult());
+    }
+
+    if (current >= numChannels) {
+        // Pass complete (or nothing registered) - wait for the next one
+#ifdef ADC_SUPPLY_PIN
+        updateSupplyFactor();
+#endif
+        current = 0;
+        nextScanMs = now + ADC_SCAN_INTERVAL_MS;
+        return nextScanMs;
+    }
+
+    if (current == 0 && sampleCount == 0 && (int32_t)(now - nextScanMs) < 0) {
+        return nextScanMs;  // Between passes
+    }
+
+    AdcChannel* ch = &channels[current];
+    if (ch->background && hal::adcStart(ch->pin)) {
+        converting = true;
+        return now;
+    }
+
+    // No background conversion for this pin - take its burst synchronously,
+    // one channel per call so the rest of the loop still interleaves
+    ch->background = false;
+    uint8_t channel = current;
+    while (current == channel) {
+        addSample(analogRead(ch->pin));
+    }
+    return now;
+}
+
+// ===== SENSOR ACCESS =====
+
+static AdcChannel* findChannel(uint8_t pin) {
+    for (uint8_t i = 0; i < numChannels; i++) {
+        if (channels[i].pin == pin) return &channels[i];
+    }
+    return nullptr;
+}
+
+bool getAdcCounts(uint8_t pin, int* counts) {
+    AdcChannel* ch = findChannel(pin);
+    if (ch == nullptr) {
+        if (numChannels >= ADC_SCAN_MAX_PINS) return false;
+        ch = &channels[numChannels++];
+        ch->pin = pin;
+        ch->background = true;
+        ch->valid = false;
+#if HAL_HAS_ADC_CONTINUOUS
+        continuousDirty = true;
+#endif
+        return false;
+    }
+
+    if (!ch->valid || (millis() - ch->updatedMs) > ADC_SCAN_MAX_AGE_MS) {
+        return false;
+    }
+    *counts = ch->counts;
+    return true;
+}
+
+int readAdcNow(uint8_t pin) {
+    finishPendingConversion();
+#if HAL_HAS_ADC_CONTINUOUS && HAL_ADC_CONTINUOUS_EXCLUSIVE
+    // ADC unit is busy scanning - stop it, the next scan task restarts it
+    if (continuous) {
+        stopContinuous();
+        continuousDirty = true;
+    }
+#endif
+
+    // Suspended: the owner converts from an interrupt - keep it off the ADC meanwhile
+    if (suspended) noInterrupts();
+    for (uint8_t i = 0; i < ADC_SETTLE_SAMPLES; i++) {
+        analogRead(pin);  // Discard (multiplexer settling)
+    }
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < ADC_OVERSAMPLE; i++) {
+        sum += analogRead(pin);
+    }
+    if (suspended) interrupts();
+    int counts = (sum + ADC_OVERSAMPLE / 2) / ADC_OVERSAMPLE;
+
+    // Good until the scan catches up with this pin
+    AdcChannel* ch = findChannel(pin);
+    if (ch != nullptr) storeCounts(ch, counts);
+    return counts;
+}
+
+void resetAdcScan() {
+    finishPendingConversion();
+#if HAL_HAS_ADC_CONTINUOUS
+    stopContinuous();
+    continuousDirty = false;
+#endif
+    numChannels = 0;
+#ifdef ADC_SUPPLY_PIN
+    // The supply stays registered - first channel of every pass
+    channels[0].pin = ADC_SUPPLY_PIN;
+    channels[0].background = true;
+    channels[0].valid = false;
+    numChannels = 1;
+#if HAL_HAS_ADC_CONTINUOUS
+    continuousDirty = true;
+#endif
+#endif
+    current = 0;
+    sampleCount = 0;
+    accumulator = 0;
+    nextScanMs = millis();
+}
+
+uint8_t getAdcScanPins(uint8_t* pins) {
+    for (uint8_t i = 0; i < numChannels; i++) pins[i] = channels[i].pin;
+    return numChannels;
+}
+
+void suspendAdcScan(bool suspend) {
+    if (suspend == suspended) return;
+    if (suspend) {
+        finishPendingConversion();
+#if HAL_HAS_ADC_CONTINUOUS
+        if (continuous) {
+            stopContinuous();
+            continuousDirty = true;  // Restarted by the first scan after resuming
+        }
+#endif
+    }
+    suspended = suspend;
+    current = 0;
+    sampleCount = 0;
+    accumulator = 0;
+    nextScanMs = millis();
+}
+
+void putAdcCounts(uint8_t index, uint16_t counts) {
+    if (index < numChannels) storeCounts(&channels[index], counts);
+#ifdef ADC_SUPPLY_PIN
+    if (index == 0) updateSupplyFactor();
+#endif
+}
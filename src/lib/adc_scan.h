@@ -0,0 +1,132 @@
+/*
+ * adc_scan.h - Background ADC acquisition for analog inputs
+ *
+ * Instead of every analog read function doing its own throwaway + real
+ * analogRead() inside the sensor task, one scanner walks all analog pins in
+ * use, one conversion at a time, and caches the result per pin:
+ *
+ *   - After switching the multiplexer, ADC_SETTLE_SAMPLES conversions are
+ *     discarded (sample-and-hold settling, same reason as the old dummy read)
+ *   - The next ADC_OVERSAMPLE conversions are averaged into the cached counts
+ *   - Conversions run in the background where the HAL supports it
+ *     (hal/hal_adc.h: AVR, Teensy second ADC); the scan task only collects a
+ *     finished result and starts the next one, so the loop keeps running
+ *     while the ADC works
+ *
+ * With -D ENABLE_ADC_CONTINUOUS the whole pin list is handed to a hardware
+ * scanner instead (hal/hal_adc_continuous.h: Teensy 4.x ADC_ETC chains,
+ * ESP32 continuous driver) and the scan task just copies out finished
+ * frames. If the backend can't take the pin list the conversion-by-
+ * conversion scan above is used.
+ *
+ * Pins register themselves on their first readAnalogPin() and are forgotten
+ * whenever the input schedule is rebuilt (a reconfigured pin may be digital
+ * now). A pin without a recent scan result is read synchronously, so
+ * callers always get a reading.
+ *
+ * The bench streamer (outputs/bench_stream.h) can take the ADC over: the
+ * scan is suspended and the streamer stores each registered pin's newest
+ * sample with putAdcCounts(), so sensors keep reading fresh counts.
+ *
+ * Supply compensation: thermistors, resistive senders and linear sensors
+ * are ratiometric - their output follows the 5 V sensor supply, which sags
+ * with the car's electrics, while their calibrations assume it sits at
+ * ADC_SUPPLY_NOMINAL. With -D ADC_SUPPLY_PIN the supply (through a divider
+ * of ADC_SUPPLY_DIVIDER) is a permanent first channel of every scan pass.
+ * At the end of each pass one division turns it into a correction factor,
+ * nominal / measured, and readAnalogPin() multiplies every ratiometric
+ * reading by it - one multiply per input, no extra conversions. Voltage
+ * inputs (readAnalogRaw()) measure absolute volts and are not corrected. A
+ * supply more than ADC_SUPPLY_MAX_DEVIATION off nominal (pin not wired,
+ * regulator failed) is not trusted: the factor falls back to 1.
+ *
+ * Usage:
+ *   // Scheduled task - reschedule at the returned deadline
+ *   setTaskDeadline(adcTaskId, updateAdcScan(now));
+ *
+ *   int counts;
+ *   if (!getAdcCounts(pin, &counts)) counts = readAdcNow(pin);
+ *
+ * Build Flags:
+ *   -D ADC_OVERSAMPLE=n        - Conversions averaged per pin per scan (default 4)
+ *   -D ADC_SETTLE_SAMPLES=n    - Conversions discarded after a mux switch (default 1)
+ *   -D ADC_SCAN_INTERVAL_MS=n  - Time between scan passes (default SENSOR_READ_INTERVAL_MS)
+ *   -D ENABLE_ADC_CONTINUOUS   - Hardware continuous scan where supported (Teensy 4.x, ESP32)
+ *   -D ADC_SUPPLY_PIN=pin      - Analog pin measuring the sensor supply (compensation off without)
+ *   -D ADC_SUPPLY_DIVIDER=r    - Divider ratio in front of that pin (default 1.0)
+ *   -D ADC_SUPPLY_NOMINAL=v    - Supply the calibrations assume (default AREF_VOLTAGE)
+ */
+
+#ifndef ADC_SCAN_H
+#define ADC_SCAN_H
+
+#include <Arduino.h>
+#include "../config.h"
+#include "platform.h"  // PLATFORM_MAX_INPUTS
+
+#ifndef ADC_OVERSAMPLE
+#define ADC_OVERSAMPLE 4
+#endif
+
+#ifndef ADC_SETTLE_SAMPLES
+#define ADC_SETTLE_SAMPLES 1
+#endif
+
+#ifndef ADC_SCAN_INTERVAL_MS
+#define ADC_SCAN_INTERVAL_MS SENSOR_READ_INTERVAL_MS
+#endif
+
+// Cached counts older than this are not used (scan stalled or pin just added)
+#define ADC_SCAN_MAX_AGE_MS (4UL * ADC_SCAN_INTERVAL_MS)
+
+#ifdef ADC_SUPPLY_PIN
+  #ifndef ADC_SUPPLY_DIVIDER
+  #define ADC_SUPPLY_DIVIDER 1.0
+  #endif
+  #ifndef ADC_SUPPLY_NOMINAL
+  #define ADC_SUPPLY_NOMINAL AREF_VOLTAGE
+  #endif
+  // Measured supply outside nominal +/- this fraction - factor stays 1
+  #define ADC_SUPPLY_MAX_DEVIATION 0.25
+  #define ADC_SCAN_MAX_PINS (PLATFORM_MAX_INPUTS + 1)  // Supply is channel 0
+#else
+  #define ADC_SCAN_MAX_PINS PLATFORM_MAX_INPUTS  // Analog pins, however many slots
+#endif
+
+// Call once after setupADC()
+void initAdcScan();
+
+// Advance the scan: collect a finished conversion, start the next one
+// Returns the next deadline (now while a pass is in progress)
+uint32_t updateAdcScan(uint32_t now);
+
+// Latest scanned counts for pin (registers pin for scanning on first call)
+// Returns false if there is no fresh result - use readAdcNow()
+bool getAdcCounts(uint8_t pin, int* counts);
+
+// Synchronous settle + oversampled read, safe while a scan is in progress
+int readAdcNow(uint8_t pin);
+
+// Forget all registered pins (inputs were reconfigured)
+void resetAdcScan();
+
+// Registered pins in scan order (at most ADC_SCAN_MAX_PINS), returns the count
+uint8_t getAdcScanPins(uint8_t* pins);
+
+// Stop (true) or resume (false) all scanning - someone else owns the ADC
+void suspendAdcScan(bool suspend);
+
+// Store counts for the index-th pin of getAdcScanPins() (while suspended)
+void putAdcCounts(uint8_t index, uint16_t counts);
+
+#ifdef ADC_SUPPLY_PIN
+// Ratiometric correction, nominal / measured supply (updated once per scan pass)
+float getAdcSupplyFactor();
+
+// Measured sensor supply in volts (NAN until the first pass)
+float getAdcSupplyVoltage();
+#else
+static inline float getAdcSupplyFactor() { return 1.0f; }
+#endif
+
+#endif // ADC_SCAN_H
@@ -44,6 +44,7 @@
 #include "../inputs/input.h"
 #include "hash.h"
 #include "generated/registry_enums.h"
+#include "generated/registry_hashes.h"
 
 // ===== APPLICATION PRESET STRUCTURE =====
 struct ApplicationPreset {
@@ -550,16 +551,29 @@ inline const ApplicationPreset* getApplicationByIndex(uint8_t index) {
     return &APPLICATION_PRESETS[index];
 }
 
+#ifndef USE_STATIC_CONFIG
+// Thin static libraries renumber the applications; they keep the scan
+static_assert(APPLICATION_HASH_COUNT == NUM_APPLICATION_PRESETS, "registry_hashes.h is stale - run tools/generate_registry_enums.py");
+#endif
+
 /**
- * Get ApplicationPreset index by hash value (O(n) linear search)
+ * Get ApplicationPreset index by hash value (O(1) perfect hash)
  *
- * Searches the registry for an application with matching name hash.
+ * Reads the one slot of APPLICATION_HASH_SLOTS (registry_hashes.h) the hash
+ * can be in and confirms it against the entry. A hash that isn't there
+ * (unknown name) falls back to scanning the registry.
  * Used for parsing user input strings.
  *
  * @param hash  16-bit hash value to search for
  * @return      Array index (0-16), or 0 (APP_NONE) if not found
  */
 inline uint8_t getApplicationIndexByHash(uint16_t hash) {
+#ifndef USE_STATIC_CONFIG
+    uint8_t slot = pgm_read_byte(&APPLICATION_HASH_SLOTS[REGISTRY_HASH_SLOT(hash, APPLICATION_HASH_SEED, APPLICATION_HASH_BITS)]);
+    if (slot < NUM_APPLICATION_PRESETS && pgm_read_word(&APPLICATION_PRESETS[slot].nameHash) == hash) {
+        return slot;
+    }
+#endif
     for (uint8_t i = 0; i < NUM_APPLICATION_PRESETS; i++) {
         uint16_t appHash = pgm_read_word(&APPLICATION_PRESETS[i].nameHash);
         if (appHash == hash) {
@@ -570,7 +584,7 @@ inline uint8_t getApplicationIndexByHash(uint16_t hash) {
 }
 
 /**
- * Get ApplicationPreset index by name string (O(n) hash-based search)
+ * Get ApplicationPreset index by name string (O(1) hash lookup)
  *
  * Hashes the input string and searches for matching application.
  * Case-insensitive.
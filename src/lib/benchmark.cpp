@@ -0,0 +1,497 @@
+/*
+ * benchmark.cpp - Microbenchmarks of the hot-path kernels
+ */
+
+#include "benchmark.h"
+
+#ifdef ENABLE_BENCHMARK
+
+#include "../config.h"
+#include "platform.h"
+#include "message_api.h"
+#include "static_pool.h"
+#include "watchdog.h"
+#include "units_registry.h"
+#include "float_format.h"
+#include "../version.h"
+#include "../hal/hal_cycles.h"
+#include "../inputs/input.h"
+#include "../inputs/input_manager.h"
+#include "../inputs/alarm_logic.h"
+#include "../inputs/sensors/sensor_utils.h"
+#include "../inputs/sensors/can/can_frame_cache.h"
+#include "../outputs/output_base.h"
+#include "../outputs/output_frame.h"
+#include "../outputs/output_serial.h"
+#include "../outputs/output_realdash.h"
+#ifdef USE_STATIC_CONFIG
+#if __has_include("generated/static_manifest.h")
+#include "generated/static_manifest.h"  // Conversions this config compiled in
+#endif
+#endif
+
+// ===== Fixtures =====
+
+// 10k NTC (beta 3950), -40..150C - descending resistance, as the thermistor tables
+static const float BENCH_NTC_OHMS[24] PROGMEM = {
+    401859.7, 225059.9, 130973.3, 78909.2, 49060.3, 31387.6, 20612.1, 13862.9,
+    9530.2, 6684.8, 4776.8, 3472.4, 2564.5, 1922.1, 1460.4, 1123.8,
+    875.1, 689.0, 548.1, 440.3, 356.9, 291.8, 240.5, 199.7
+};
+static const float BENCH_NTC_CELSIUS[24] PROGMEM = {
+    -40.0, -31.7, -23.5, -15.2, -7.0, 1.3, 9.6, 17.8, 26.1, 34.3, 42.6, 50.9,
+    59.1, 67.4, 75.7, 83.9, 92.2, 100.4, 108.7, 117.0, 125.2, 133.5, 141.7, 150.0
+};
+
+// 10-184 ohm sender, 0-10 bar - ascending, as the pressure tables
+static const float BENCH_SENDER_OHMS[12] PROGMEM = {
+    10.0, 25.8, 41.6, 57.5, 73.3, 89.1, 104.9, 120.7, 136.5, 152.4, 168.2, 184.0
+};
+static const float BENCH_SENDER_BAR[12] PROGMEM = {
+    0.00, 0.91, 1.82, 2.73, 3.64, 4.55, 5.45, 6.36, 7.27, 8.18, 9.09, 10.00
+};
+
+static Input benchInput;   // Custom calibration per kernel, never in inputs[]
+
+static volatile float sinkFloat;    // Results go here so no call is optimized out
+static volatile uint32_t sinkWord;
+
+// Arguments step through the range without a divide per call
+struct Sweep {
+    float value, low, high, step;
+
+    Sweep(float lo, float hi) : value(lo), low(lo), high(hi), step((hi - lo) / 61) {}
+    float next() {
+        value += step;
+        if (value > high) value = low;
+        return value;
+    }
+};
+
+static Sweep countsSweep() {
+    return Sweep(ADC_RAIL_MARGIN + 40, ADC_MAX_VALUE - ADC_RAIL_MARGIN - 40);
+}
+
+// ===== Kernels =====
+// Each runs n calls and returns the counter ticks they took
+
+static uint32_t benchLoop(uint16_t n, uint16_t) {
+    Sweep s = countsSweep();
+    uint32_t t0 = hal::cycleCount();
+    for (uint16_t i = 0; i < n; i++) sinkFloat = s.next();
+    return hal::cycleCount() - t0;
+}
+
+static uint32_t benchInterpolate(uint16_t n, uint16_t) {
+    Sweep s(180.0, 420000.0);
+    uint32_t t0 = hal::cycleCount();
+    for (uint16_t i = 0; i < n; i++) {
+        sinkFloat = interpolate(s.next(), 24, BENCH_NTC_OHMS, BENCH_NTC_CELSIUS);
+    }
+    return hal::cycleCount() - t0;
+}
+
+static uint32_t benchInterpolateAscending(uint16_t n, uint16_t) {
+    Sweep s(5.0, 190.0);
+    uint32_t t0 = hal::cycleCount();
+    for (uint16_t i = 0; i < n; i++) {
+        sinkFloat = interpolateAscending(s.next(), 12, BENCH_SENDER_OHMS, BENCH_SENDER_BAR);
+    }
+    return hal::cycleCount() - t0;
+}
+
+static uint32_t benchResistance(uint16_t n, uint16_t) {
+    Sweep s = countsSweep();
+    uint32_t t0 = hal::cycleCount();
+    for (uint16_t i = 0; i < n; i++) sinkFloat = calculateResistance(s.next(), 10000.0);
+    return hal::cycleCount() - t0;
+}
+
+#ifndef STATIC_SKIP_THERMISTORS_STEINHART
+static uint32_t benchSteinhart(uint16_t n, uint16_t) {
+    benchInput.flags.useCustomCalibration = 1;
+    benchInput.calibrationType = CAL_THERMISTOR_STEINHART;
+    benchInput.customCalibration.steinhart.bias_resistor = 10000.0;
+    benchInput.customCalibration.steinhart.steinhart_a = 1.129148e-3;
+    benchInput.customCalibration.steinhart.steinhart_b = 2.34125e-4;
+    benchInput.customCalibration.steinhart.steinhart_c = 8.76741e-8;
+
+    Sweep s = countsSweep();
+    uint32_t t0 = hal::cycleCount();
+    for (uint16_t i = 0; i < n; i++) sinkFloat = thermistorSteinhartFromCounts(&benchInput, s.next());
+    return hal::cycleCount() - t0;
+}
+#endif
+
+#ifndef STATIC_SKIP_THERMISTORS_BETA
+static uint32_t benchBeta(uint16_t n, uint16_t) {
+    benchInput.flags.useCustomCalibration = 1;
+    benchInput.calibrationType = CAL_THERMISTOR_BETA;
+    benchInput.customCalibration.beta.bias_resistor = 10000.0;
+    benchInput.customCalibration.beta.beta = 3950.0;
+    benchInput.customCalibration.beta.r0 = 10000.0;
+    benchInput.customCalibration.beta.t0 = 25.0;
+
+    Sweep s = countsSweep();
+    uint32_t t0 = hal::cycleCount();
+    for (uint16_t i = 0; i < n; i++) sinkFloat = thermistorBetaFromCounts(&benchInput, s.next());
+    return hal::cycleCount() - t0;
+}
+#endif
+
+// ----- CAN frame cache -----
+// The cache is refilled with bench frames (key k: ID 0x100 + k, PID k) to
+// the occupancy under test; the live entries wait in the scratch arena and
+// the cache counters are put back after
+
+enum CanCacheOp : uint8_t { CACHE_UPDATE, CACHE_GET, CACHE_MISS };
+
+static void clearCacheEntries() {
+    // Entry by entry - initCANFrameCache() would also free the FD payload
+    // blocks the saved entries still own
+    memset(canFrameCache, 0, sizeof(canFrameCache));
+    for (uint16_t i = 0; i < CAN_CACHE_SIZE; i++) canFrameCache[i].block = CAN_CACHE_NO_BLOCK;
+}
+
+static uint32_t benchCanCache(uint16_t n, uint16_t param) {
+    CANFrameEntry* saved = (CANFrameEntry*)scratchAlloc(sizeof(canFrameCache));
+    if (!saved) return 0;
+    memcpy(saved, canFrameCache, sizeof(canFrameCache));
+    CANCacheStats savedStats = canCacheStats;  // Bench traffic isn't the bus's
+    clearCacheEntries();
+
+    uint8_t op = param & 0x03;
+    uint16_t keys = (uint32_t)CAN_CACHE_SIZE * (param >> 2) / 100;
+    if (keys == 0) keys = 1;
+    uint8_t data[8] = {0x41, 0x05, 0x7B, 0, 0, 0, 0, 0};
+    for (uint16_t k = 0; k < keys; k++) {
+        updateCANCache(0x100 + k, (uint8_t)k, data, 8, k);
+    }
+
+    uint16_t k = 0;
+    uint32_t t0 = hal::cycleCount();
+    for (uint16_t i = 0; i < n; i++) {
+        if (op == CACHE_UPDATE) {
+            data[3] = (uint8_t)i;
+            updateCANCache(0x100 + k, (uint8_t)k, data, 8, i);
+        } else if (op == CACHE_GET) {
+            sinkWord = (uint32_t)(uintptr_t)getCANCacheEntry(0x100 + k, (uint8_t)k);
+        } else {
+            sinkWord = (uint32_t)(uintptr_t)getCANCacheEntry(0x600 + k, (uint8_t)k);
+        }
+        if (++k == keys) k = 0;
+    }
+    uint32_t ticks = hal::cycleCount() - t0;
+
+    memcpy(canFrameCache, saved, sizeof(canFrameCache));
+    canCacheStats = savedStats;
+    scratchFree(saved);
+    return ticks;
+}
+
+// ----- OBD-II and units -----
+
+#define UNITS_PARAM_F   0       // Target unit, looked up by name in benchUnits()
+#define UNITS_PARAM_PSI 1
+
+static void setupOBD2Input() {
+    benchInput.measurementType = MEASURE_TEMPERATURE;
+    benchInput.obd2pid = 0x05;      // Coolant temperature
+    benchInput.obd2length = 1;
+}
+
+static uint32_t benchOBD2Encode(uint16_t n, uint16_t) {
+    setupOBD2Input();
+    Sweep s(-40.0, 150.0);
+    uint32_t t0 = hal::cycleCount();
+    for (uint16_t i = 0; i < n; i++) {
+        benchInput.value = s.next();
+        refreshOBD2Data(&benchInput);
+    }
+    uint32_t ticks = hal::cycleCount() - t0;
+    sinkWord = benchInput.obd2data[0];
+    return ticks;
+}
+
+static uint32_t benchOBD2Frame(uint16_t n, uint16_t) {
+    setupOBD2Input();
+    benchInput.value = 90.0;
+    refreshOBD2Data(&benchInput);
+    byte frame[8];
+    uint32_t t0 = hal::cycleCount();
+    for (uint16_t i = 0; i < n; i++) {
+        buildOBD2Frame(frame, &benchInput);
+        sinkWord = frame[3];
+    }
+    return hal::cycleCount() - t0;
+}
+
+static uint32_t benchUnits(uint16_t n, uint16_t param) {
+    uint8_t unitsIndex = getUnitsIndexByName(param == UNITS_PARAM_F ? "FAHRENHEIT" : "PSI");
+    Sweep s(0.0, 150.0);
+    uint32_t t0 = hal::cycleCount();
+    for (uint16_t i = 0; i < n; i++) sinkFloat = convertFromBaseUnits(s.next(), unitsIndex);
+    return hal::cycleCount() - t0;
+}
+
+// The outputs' path: the input's cached conversion (refreshInputUnits())
+static uint32_t benchInputUnits(uint16_t n, uint16_t param) {
+    benchInput.unitsIndex = getUnitsIndexByName(param == UNITS_PARAM_F ? "FAHRENHEIT" : "PSI");
+    refreshInputUnits(&benchInput);
+    Sweep s(0.0, 150.0);
+    uint32_t t0 = hal::cycleCount();
+    for (uint16_t i = 0; i < n; i++) sinkFloat = toInputUnits(&benchInput, s.next());
+    return hal::cycleCount() - t0;
+}
+
+// ----- Pipeline (configured inputs) -----
+
+static uint32_t benchAlarms(uint16_t n, uint16_t) {
+    uint32_t now = millis();
+    uint32_t t0 = hal::cycleCount();
+    for (uint16_t i = 0; i < n; i++) updateAllInputAlarms(now);  // No new readings - no transitions
+    return hal::cycleCount() - t0;
+}
+
+// ----- Serializers (into the output frame, dropped after each call) -----
+
+#ifdef ENABLE_SERIAL_OUTPUT
+static uint32_t benchCsvLine(uint16_t n, uint16_t) {
+    strcpy(benchInput.abbrName, "CLT");
+    benchInput.unitsIndex = getUnitsIndexByName("FAHRENHEIT");
+    refreshInputUnits(&benchInput);
+    Sweep s(-40.0, 150.0);
+    uint32_t t0 = hal::cycleCount();
+    for (uint16_t i = 0; i < n; i++) {
+        appendSerialCSVLine(&benchInput, s.next());
+        outputFrame.discard();
+    }
+    return hal::cycleCount() - t0;
+}
+#endif
+
+#ifdef ENABLE_REALDASH
+static uint32_t benchRealdash(uint16_t n, uint16_t) {
+    uint8_t slots[MAX_INPUTS];
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        if (inputs[i].pin != 0xFF && inputs[i].flags.isEnabled &&
+            (inputs[i].outputMask & (1 << OUTPUT_REALDASH))) {
+            slots[count++] = i;
+        }
+    }
+    InputSnapshot snap = getInputSnapshot();
+    uint32_t now = millis();
+    uint32_t t0 = hal::cycleCount();
+    for (uint16_t i = 0; i < n; i++) {
+        sendRealdashBatch(slots, count, snap.samples, now);
+        outputFrame.discard();
+    }
+    return hal::cycleCount() - t0;
+}
+#endif
+
+// ===== Kernel table =====
+
+typedef uint32_t (*BenchFn)(uint16_t iterations, uint16_t param);
+
+struct BenchCase {
+    const char* kernel;     // PROGMEM
+    const char* label;      // PROGMEM
+    BenchFn run;
+    uint16_t param;
+};
+
+#define CACHE_CASE(op, percent) (uint16_t)((op) | ((percent) << 2))
+
+static const char K_LOOP[] PROGMEM = "loop";
+static const char K_INTERPOLATE[] PROGMEM = "interpolate";
+static const char K_INTERPOLATE_ASC[] PROGMEM = "interpolateAscending";
+static const char K_RESISTANCE[] PROGMEM = "calculateResistance";
+static const char K_STEINHART[] PROGMEM = "steinhart";
+static const char K_BETA[] PROGMEM = "beta";
+static const char K_CAN_CACHE[] PROGMEM = "can_cache";
+static const char K_OBD2_ENCODE[] PROGMEM = "obd2_encode";
+static const char K_OBD2_FRAME[] PROGMEM = "buildOBD2Frame";
+static const char K_UNITS[] PROGMEM = "convertFromBaseUnits";
+static const char K_INPUT_UNITS[] PROGMEM = "toInputUnits";
+static const char K_ALARMS[] PROGMEM = "alarms";
+static const char K_CSV_LINE[] PROGMEM = "csv_line";
+static const char K_REALDASH[] PROGMEM = "realdash";
+
+static const char L_HARNESS[] PROGMEM = "harness";
+static const char L_NTC_24[] PROGMEM = "24pt desc";
+static const char L_SENDER_12[] PROGMEM = "12pt asc";
+static const char L_BIAS_10K[] PROGMEM = "10k bias";
+static const char L_COUNTS[] PROGMEM = "counts";
+static const char L_UPDATE_25[] PROGMEM = "update 25%";
+static const char L_UPDATE_50[] PROGMEM = "update 50%";
+static const char L_UPDATE_90[] PROGMEM = "update 90%";
+static const char L_GET_25[] PROGMEM = "get 25%";
+static const char L_GET_50[] PROGMEM = "get 50%";
+static const char L_GET_90[] PROGMEM = "get 90%";
+static const char L_MISS_25[] PROGMEM = "miss 25%";
+static const char L_MISS_50[] PROGMEM = "miss 50%";
+static const char L_MISS_90[] PROGMEM = "miss 90%";
+static const char L_PID_1BYTE[] PROGMEM = "1 byte PID";
+static const char L_TO_F[] PROGMEM = "C to F";
+static const char L_TO_PSI[] PROGMEM = "bar to PSI";
+static const char L_CONFIGURED[] PROGMEM = "configured";
+static const char L_ONE_INPUT[] PROGMEM = "1 input";
+
+static const BenchCase BENCH_CASES[] PROGMEM = {
+    {K_LOOP, L_HARNESS, benchLoop, 0},
+    {K_INTERPOLATE, L_NTC_24, benchInterpolate, 0},
+    {K_INTERPOLATE_ASC, L_SENDER_12, benchInterpolateAscending, 0},
+    {K_RESISTANCE, L_BIAS_10K, benchResistance, 0},
+#ifndef STATIC_SKIP_THERMISTORS_STEINHART
+    {K_STEINHART, L_COUNTS, benchSteinhart, 0},
+#endif
+#ifndef STATIC_SKIP_THERMISTORS_BETA
+    {K_BETA, L_COUNTS, benchBeta, 0},
+#endif
+    {K_CAN_CACHE, L_UPDATE_25, benchCanCache, CACHE_CASE(CACHE_UPDATE, 25)},
+    {K_CAN_CACHE, L_UPDATE_50, benchCanCache, CACHE_CASE(CACHE_UPDATE, 50)},
+    {K_CAN_CACHE, L_UPDATE_90, benchCanCache, CACHE_CASE(CACHE_UPDATE, 90)},
+    {K_CAN_CACHE, L_GET_25, benchCanCache, CACHE_CASE(CACHE_GET, 25)},
+    {K_CAN_CACHE, L_GET_50, benchCanCache, CACHE_CASE(CACHE_GET, 50)},
+    {K_CAN_CACHE, L_GET_90, benchCanCache, CACHE_CASE(CACHE_GET, 90)},
+    {K_CAN_CACHE, L_MISS_25, benchCanCache, CACHE_CASE(CACHE_MISS, 25)},
+    {K_CAN_CACHE, L_MISS_50, benchCanCache, CACHE_CASE(CACHE_MISS, 50)},
+    {K_CAN_CACHE, L_MISS_90, benchCanCache, CACHE_CASE(CACHE_MISS, 90)},
+    {K_OBD2_ENCODE, L_PID_1BYTE, benchOBD2Encode, 0},
+    {K_OBD2_FRAME, L_PID_1BYTE, benchOBD2Frame, 0},
+    {K_UNITS, L_TO_F, benchUnits, UNITS_PARAM_F},
+    {K_UNITS, L_TO_PSI, benchUnits, UNITS_PARAM_PSI},
+    {K_INPUT_UNITS, L_TO_F, benchInputUnits, UNITS_PARAM_F},
+    {K_INPUT_UNITS, L_TO_PSI, benchInputUnits, UNITS_PARAM_PSI},
+    {K_ALARMS, L_CONFIGURED, benchAlarms, 0},
+#ifdef ENABLE_SERIAL_OUTPUT
+    {K_CSV_LINE, L_ONE_INPUT, benchCsvLine, 0},
+#endif
+#ifdef ENABLE_REALDASH
+    {K_REALDASH, L_CONFIGURED, benchRealdash, 0},
+#endif
+};
+
+#define NUM_BENCH_CASES (sizeof(BENCH_CASES) / sizeof(BENCH_CASES[0]))
+
+// ===== Runner =====
+
+// Best (lowest) of BENCHMARK_RUNS runs; 0 = the kernel could not run
+static uint32_t bestOfRuns(const BenchCase& c) {
+    c.run(BENCHMARK_ITERATIONS / 10 + 1, c.param);   // Warm caches and branch predictors
+
+    uint32_t best = 0;
+    for (uint8_t r = 0; r < BENCHMARK_RUNS; r++) {
+        uint32_t ticks = c.run(BENCHMARK_ITERATIONS, c.param);
+        if (ticks != 0 && (best == 0 || ticks < best)) best = ticks;
+        watchdogReset();
+    }
+    return best;
+}
+
+static uint8_t countEnabledInputs() {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        if (inputs[i].pin != 0xFF && inputs[i].flags.isEnabled) n++;
+    }
+    return n;
+}
+
+static void printPadded(const char* progmemText, uint8_t width) {
+    msg.control.print((const __FlashStringHelper*)progmemText);
+    for (uint8_t n = strlen_P(progmemText); n < width; n++) msg.control.print(' ');
+}
+
+// Right-aligned in width columns, one decimal; "-" for a value the counter can't give
+static void printColumn(float value, bool known, uint8_t width) {
+    char text[FLOAT_FORMAT_SIZE];
+    uint8_t n = 1;
+    if (known) {
+        n = formatFixed(text, value, 1);
+    } else {
+        strcpy(text, "-");
+    }
+    for (; n < width; n++) msg.control.print(' ');
+    msg.control.print(text);
+}
+
+static void printHeader(bool csv, uint8_t enabled) {
+    if (csv) {
+        msg.control.println(F("version,platform,kernel,case,iterations,inputs,cycles_per_call,ns_per_call"));
+        return;
+    }
+    msg.control.println();
+    msg.control.print(F("=== Benchmark: "));
+    msg.control.print(BENCHMARK_ITERATIONS);
+    msg.control.print(F(" calls, best of "));
+    msg.control.print(BENCHMARK_RUNS);
+    msg.control.println(F(" runs ==="));
+    msg.control.print(F("Counter: "));
+    msg.control.print(hal::cycleHz());
+    msg.control.print(F(" Hz"));
+    if (!HAL_CYCLES_ARE_CORE_CYCLES) {
+        msg.control.print(hal::cpuHz() ? F(" (cycles estimated from the CPU clock)") : F(" (host clock, no cycles)"));
+    }
+    msg.control.println();
+    msg.control.print(F("Inputs enabled: "));
+    msg.control.print(enabled);
+    msg.control.println(F(" (alarms, realdash)"));
+    msg.control.println(F("Kernel                Case            cycles/call      ns/call"));
+}
+
+static void printResult(bool csv, const BenchCase& c, uint32_t ticks, uint8_t enabled) {
+    double ticksPerCall = (double)ticks / BENCHMARK_ITERATIONS;
+    double ns = ticksPerCall * 1e9 / hal::cycleHz();
+    double cycles = HAL_CYCLES_ARE_CORE_CYCLES ? ticksPerCall : ns * hal::cpuHz() / 1e9;
+
+    if (csv) {
+        msg.control.print(firmwareVersionString());
+        msg.control.print(',');
+        msg.control.print(F(PLATFORM_NAME));
+        msg.control.print(',');
+        msg.control.print((const __FlashStringHelper*)c.kernel);
+        msg.control.print(',');
+        msg.control.print((const __FlashStringHelper*)c.label);
+        msg.control.print(',');
+        msg.control.print(BENCHMARK_ITERATIONS);
+        msg.control.print(',');
+        msg.control.print(enabled);
+        msg.control.print(',');
+        if (ticks != 0 && hal::cpuHz() != 0) msg.control.print(cycles, 1);
+        msg.control.print(',');
+        if (ticks != 0) msg.control.print(ns, 1);
+        msg.control.println();
+        return;
+    }
+
+    printPadded(c.kernel, 22);
+    printPadded(c.label, 16);
+    if (ticks == 0) {
+        msg.control.println(F("skipped (no scratch space to save the CAN cache)"));
+        return;
+    }
+    printColumn(cycles, hal::cpuHz() != 0, 11);
+    printColumn(ns, true, 13);
+    msg.control.println();
+}
+
+uint8_t runBenchmarks(bool csv, const char* filter) {
+    hal::cycleCounterBegin();
+    uint8_t enabled = countEnabledInputs();
+    uint8_t ran = 0;
+
+    for (uint8_t i = 0; i < NUM_BENCH_CASES; i++) {
+        BenchCase c;
+        memcpy_P(&c, &BENCH_CASES[i], sizeof(BenchCase));
+        if (filter && strcasecmp_P(filter, c.kernel) != 0) continue;
+
+        if (ran++ == 0) printHeader(csv, enabled);
+        printResult(csv, c, bestOfRuns(c), enabled);
+    }
+    if (ran > 0 && !csv) msg.control.println();
+    return ran;
+}
+
+#endif // ENABLE_BENCHMARK
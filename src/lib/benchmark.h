@@ -0,0 +1,75 @@
+/*
+ * benchmark.h - Microbenchmarks of the hot-path kernels
+ *
+ * Opt-in (-D ENABLE_BENCHMARK) timing of the functions every loop pass
+ * leans on, so a change to one of them can be measured on the target (and
+ * in the host simulator) instead of guessed at from the loop profile:
+ *
+ *   interpolate / interpolateAscending   table walk of the table sensors
+ *   steinhart / beta                     thermistor counts-to-temperature
+ *   calculateResistance                  voltage divider
+ *   can_cache update / get / miss        frame cache at 25, 50, 90% full
+ *   obd2_encode / buildOBD2Frame         PID bytes and the Mode 01 frame
+ *   convertFromBaseUnits / toInputUnits  display unit conversion, registry
+ *                                        and per-input cached
+ *   alarms                               updateAllInputAlarms() over the
+ *                                        configured inputs
+ *   csv_line / realdash                  data plane serializers, into the
+ *                                        output frame (never written out)
+ *
+ * Every kernel but alarms and realdash runs on fixed fixtures (its own
+ * tables, calibration and input), so results compare across builds and
+ * releases; those two walk the configured inputs, and the report states
+ * how many are enabled. Each kernel runs BENCHMARK_ITERATIONS calls, the
+ * best of BENCHMARK_RUNS runs is kept (interrupts stay on - the best run is
+ * the one they missed), and the report gives cycles and ns per call from
+ * the HAL cycle counter (hal/hal_cycles.h: DWT on Cortex-M, CCOUNT on
+ * ESP32; on AVR cycles are estimated from micros()). The "loop" row is the
+ * harness alone - the argument sweep and the result store - and is not
+ * taken off the other rows.
+ *
+ * The CAN cache kernels fill the cache with their own frames; the live
+ * cache is saved to the scratch arena (static_pool.h) and put back after,
+ * and they are skipped if it doesn't fit there.
+ *
+ * SYSTEM BENCHMARK prints a table, SYSTEM BENCHMARK CSV the same as CSV
+ * (one header row, then version,platform,kernel,case,...) to keep across
+ * releases - tools/bench_compare.py flags the kernels that got slower.
+ * The command holds the loop for the whole run (about a second on AVR).
+ *
+ * Build Flags:
+ *   -D ENABLE_BENCHMARK          - Compile the benchmarks and SYSTEM BENCHMARK
+ *   -D BENCHMARK_ITERATIONS=n    - Calls per run (default 1000; 100 on AVR)
+ *   -D BENCHMARK_RUNS=n          - Runs per kernel, best kept (default 5)
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <Arduino.h>
+
+#ifndef BENCHMARK_ITERATIONS
+  #if defined(__AVR__)
+    #define BENCHMARK_ITERATIONS 100
+  #else
+    #define BENCHMARK_ITERATIONS 1000
+  #endif
+#endif
+
+#ifndef BENCHMARK_RUNS
+#define BENCHMARK_RUNS 5
+#endif
+
+#ifdef ENABLE_BENCHMARK
+
+/**
+ * Run the kernels and print the results (SYSTEM BENCHMARK [CSV] [<kernel>])
+ * @param csv     CSV rows instead of the table
+ * @param filter  Only kernels with this name (case-insensitive), nullptr = all
+ * @return        Kernels run (0: no kernel of that name)
+ */
+uint8_t runBenchmarks(bool csv, const char* filter);
+
+#endif // ENABLE_BENCHMARK
+
+#endif // BENCHMARK_H
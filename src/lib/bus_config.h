@@ -7,7 +7,7 @@
  *
  * Also configures hardware serial ports (Serial1-Serial8) for TRANSPORT use.
  *
- * Total size: 26-28 bytes for BusConfig (platform dependent) + 16 bytes for SerialPortConfig
+ * Total size: 30-32 bytes for BusConfig (platform dependent) + 16 bytes for SerialPortConfig
  */
 
 #ifndef BUS_CONFIG_H
@@ -26,11 +26,49 @@
  *            no TX of any kind. Use when sniffing an existing CAN bus
  *            (e.g., reading from a car's OBD-II/ECU network) to avoid
  *            disrupting communication between other nodes.
+ * - POLL:    NORMAL, plus OBD-II Mode 01 requests for the PIDs configured
+ *            inputs read (inputs/obd2_poller.h). Use with vehicles that only
+ *            answer when asked.
  */
 enum CanInputMode : uint8_t {
     CAN_INPUT_OFF    = 0,   // Disabled
     CAN_INPUT_NORMAL = 1,   // Active input with ACK
-    CAN_INPUT_LISTEN = 2    // Listen-only (passive, no ACK/TX)
+    CAN_INPUT_LISTEN = 2,   // Listen-only (passive, no ACK/TX)
+    CAN_INPUT_POLL   = 3    // Active input, requests OBD-II PIDs
+};
+
+/**
+ * CAN Input Protocol
+ *
+ * How frames on the CAN input bus are keyed in the frame cache:
+ * - AUTO:   11-bit frames; OBD-II Mode 01 responses are keyed by PID,
+ *           anything else by its first byte (or whole, SET CAN FRAME)
+ * - J1939:  29-bit frames keyed by PGN and source address (lib/j1939.h);
+ *           TP.BAM multi-packet messages are reassembled. An input's CAN
+ *           ID is the PGN and its PID the source address (FRAME = any).
+ */
+enum CanInputProtocol : uint8_t {
+    CAN_PROTOCOL_AUTO  = 0,  // OBD-II / custom 11-bit
+    CAN_PROTOCOL_J1939 = 1   // SAE J1939
+};
+
+/**
+ * CAN Output Broadcast Layout
+ *
+ * Controls how the CAN output broadcasts input values every send interval
+ * (OBD-II requests are answered in either layout):
+ * - OBD:     One Mode 01 style frame per input on 0x7E8 (default)
+ * - PACKED:  Inputs packed as scaled 8/16-bit signals into frames from
+ *            can_output_base_id up (outputs/output_can.h). Describe the
+ *            layout to a dashboard with BUS CAN OUTPUT LAYOUT DBC|REALDASH.
+ * - J1939:   Inputs with a standard SPN as J1939 PGNs (engine temperature
+ *            65262, ...) on 29-bit IDs from j1939_address (lib/j1939.h)
+ */
+enum CanOutputLayout : uint8_t {
+    CAN_OUTPUT_OBD      = 0,  // One OBD-II frame per input
+    CAN_OUTPUT_PACKED   = 1,  // Several inputs per custom-ID frame
+    CAN_OUTPUT_J1939    = 2,  // Standard SPNs in J1939 PGNs
+    CAN_OUTPUT_NMEA2000 = 3   // Engine and temperature PGNs for marine networks (lib/nmea2000.h)
 };
 
 /**
@@ -56,9 +94,30 @@ struct BusConfig {
     uint32_t can_output_baudrate; // bps - output bus baud rate (125000, 250000, 500000, 1000000)
 
     // Runtime mode/enable flags
-    uint8_t can_input_mode;     // CanInputMode: OFF(0), NORMAL(1), LISTEN(2)
+    uint8_t can_input_mode;     // CanInputMode: OFF(0), NORMAL(1), LISTEN(2), POLL(3)
     uint8_t can_output_enabled; // Enable CAN output (0=disabled, 1=enabled)
-};  // 26 bytes nominal (28 with ARM padding)
+
+    // CAN output broadcast layout - NEW in system config v10
+    uint8_t can_output_layout;  // CanOutputLayout: OBD(0), PACKED(1)
+    uint16_t can_output_base_id; // First frame ID of the packed layout (11-bit)
+
+    // CAN mirror output - NEW in system config v11
+    // Second, broadcast-only CAN output for inputs routed to OUTPUT_CAN_MIRROR
+    uint8_t can_mirror_bus;      // 0=CAN1, 1=CAN2, 2=CAN3, 0xFF=NONE (disabled)
+    uint8_t can_mirror_layout;   // CanOutputLayout: OBD(0), PACKED(1)
+    uint16_t can_mirror_base_id; // First frame ID of the mirror's packed layout (11-bit)
+    uint16_t can_mirror_interval; // ms between mirror broadcasts
+    uint32_t can_mirror_baudrate; // bps - mirror bus baud rate
+
+    // J1939 - NEW in system config v12
+    uint8_t can_input_protocol; // CanInputProtocol: AUTO(0), J1939(1)
+    uint8_t j1939_address;      // Our source address for J1939 output (0-253), preferred address for NMEA 2000
+
+    // CAN node network - NEW in system config v20 (lib/can_node.h)
+    uint8_t can_node_id;        // Our node number (0-15), 0xFF = not a node
+    uint8_t can_node_reserved;
+    uint16_t can_node_subscribe; // Bit n = import the channels of node n
+};  // 46 bytes nominal (48 with ARM padding)
 
 /**
  * Serial Port Baud Rate Index
@@ -75,7 +134,11 @@ enum SerialBaudIndex {
     BAUD_230400 = 5,   // 230400 bps
     BAUD_460800 = 6,   // 460800 bps
     BAUD_921600 = 7,   // 921600 bps
-    NUM_BAUD_RATES = 8
+    BAUD_1000000 = 8,  // 1 Mbps and up: Teensy 4.x and ESP32 (SERIAL_MAX_BAUD)
+    BAUD_2000000 = 9,
+    BAUD_3000000 = 10,
+    BAUD_4000000 = 11,
+    NUM_BAUD_RATES = 12
 };
 
 /**
@@ -94,11 +157,16 @@ struct SerialPortConfig {
 
     // Baud rate index for each port (8 bytes)
     // Index 0 = Serial1, Index 1 = Serial2, etc.
-    // Values are SerialBaudIndex enum (0-7)
+    // Values are SerialBaudIndex enum (0-11)
     uint8_t baudrate_index[8];
 
-    // Reserved for future expansion (7 bytes)
-    uint8_t reserved[7];
+    // RTS/CTS hardware flow control, one port (3 bytes) - was reserved (0 = none)
+    uint8_t flow_port;        // 1-8 = Serial<n> uses RTS/CTS, 0 = no port
+    uint8_t rts_pin;          // Our RTS: asserted while the port can take data
+    uint8_t cts_pin;          // Our CTS: the far end's RTS
+
+    // Reserved for future expansion (4 bytes)
+    uint8_t reserved[4];
 };  // 16 bytes total
 
 #endif // BUS_CONFIG_H
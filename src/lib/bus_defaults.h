@@ -10,6 +10,7 @@
  * - Teensy 3.6 (MK66FX1M0): 3x I2C, 2x SPI, 2x CAN, 6x Serial (I2C remappable)
  * - ESP32: 2x I2C, 1x SPI, 1x CAN, 2x Serial (fully remappable)
  * - Arduino Mega (ATmega2560): 1x I2C, 1x SPI, 0x CAN, 3x Serial
+ * - Host simulator (PREOBD_NATIVE): 1x I2C, 1x SPI, 3x CAN (SocketCAN), no extra Serial
  */
 
 #ifndef BUS_DEFAULTS_H
@@ -27,6 +28,10 @@
 #define DEFAULT_SPI_CLOCK      4000000  // Hz (4MHz)
 #define DEFAULT_CAN_BUS        0        // CAN1
 #define DEFAULT_CAN_BAUDRATE   500000   // bps
+#define DEFAULT_CAN_OUTPUT_BASE_ID 0x500 // First packed broadcast frame
+#define DEFAULT_CAN_MIRROR_BASE_ID 0x600 // First packed mirror frame
+#define DEFAULT_CAN_MIRROR_INTERVAL 20   // ms (50 Hz)
+#define DEFAULT_J1939_ADDRESS  0x80     // First self-configurable J1939 address
 #define DEFAULT_SERIAL_BAUDRATE 115200  // bps
 
 // ============================================================================
@@ -349,6 +354,39 @@
 #define SUPPORTS_CAN_PIN_REMAP 0
 #define SUPPORTS_SERIAL_PIN_REMAP 0
 
+// ============================================================================
+// HOST SIMULATOR (env:native, sim/)
+// ============================================================================
+#elif defined(PREOBD_NATIVE)
+
+// ----- I2C / SPI Default Pins -----
+// Pin numbers only - no I2C or SPI devices are simulated
+#define DEFAULT_I2C0_SDA 18
+#define DEFAULT_I2C0_SCL 19
+
+#define DEFAULT_SPI0_MOSI 11
+#define DEFAULT_SPI0_MISO 12
+#define DEFAULT_SPI0_SCK  13
+
+// ----- CAN Default Pins -----
+// SocketCAN interfaces (--can), no pins to reserve
+#define DEFAULT_CAN1_TX 0xFF
+#define DEFAULT_CAN1_RX 0xFF
+#define DEFAULT_CAN2_TX 0xFF
+#define DEFAULT_CAN2_RX 0xFF
+#define DEFAULT_CAN3_TX 0xFF
+#define DEFAULT_CAN3_RX 0xFF
+
+// ----- Platform Capabilities -----
+#define NUM_I2C_BUSES 1
+#define NUM_SPI_BUSES 1
+#define NUM_CAN_BUSES 3
+#define NUM_SERIAL_PORTS 0
+#define SUPPORTS_WIRE_PIN_REMAP 0
+#define SUPPORTS_SPI_PIN_REMAP 0
+#define SUPPORTS_CAN_PIN_REMAP 0
+#define SUPPORTS_SERIAL_PIN_REMAP 0
+
 // ============================================================================
 // UNKNOWN PLATFORM
 // ============================================================================
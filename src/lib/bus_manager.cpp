@@ -5,14 +5,25 @@
  */
 
 #include "bus_manager.h"
+#include "../config.h"
 #include "bus_config.h"
 #include "bus_defaults.h"
 #include "pin_registry.h"
+#include "i2c_engine.h"
+#include "device_inventory.h"
 #include "system_config.h"
 #include "message_api.h"
 #include "log_tags.h"
 #include <Wire.h>
 #include <SPI.h>
+#ifdef ENABLE_CAN
+#include "../inputs/input_can.h"
+#include "../inputs/obd2_poller.h"
+#include "../outputs/output_can.h"
+#include "can_rx.h"
+#include "can_tx.h"
+#include "can_node.h"
+#endif
 
 // ============================================================================
 // GLOBAL STATE
@@ -30,6 +41,8 @@ static uint8_t active_can_id = 0;
 // CAN ready flag (actual FlexCAN objects are in output_can.cpp)
 static bool can_ready = false;
 
+static void initAssignedSPIBuses();
+
 // ============================================================================
 // MAIN INITIALIZATION
 // ============================================================================
@@ -54,6 +67,9 @@ void initConfiguredBuses() {
         }
     }
 
+    // Buses assigned to SPI device classes other than the active one
+    initAssignedSPIBuses();
+
     // Initialize CAN output bus if enabled
     if (systemConfig.buses.can_output_enabled && systemConfig.buses.output_can_bus != 0xFF) {
         if (!initCANBus(systemConfig.buses.output_can_bus, systemConfig.buses.can_output_baudrate)) {
@@ -65,6 +81,15 @@ void initConfiguredBuses() {
         }
     }
 
+    // Initialize CAN mirror bus (second output) - pins only, if no other role claims it
+    uint8_t mirrorBus = systemConfig.buses.can_mirror_bus;
+    if (mirrorBus != 0xFF && mirrorBus != systemConfig.buses.output_can_bus &&
+        !(systemConfig.buses.can_input_mode != CAN_INPUT_OFF && mirrorBus == systemConfig.buses.input_can_bus)) {
+        if (!initCANBus(mirrorBus, systemConfig.buses.can_mirror_baudrate)) {
+            msg.debug.warn(TAG_CAN, "CAN mirror: Failed to initialize bus %d", mirrorBus);
+        }
+    }
+
     // Initialize CAN input bus if enabled
     // Supports two modes:
     // 1. SHARED BUS: input_can_bus == output_can_bus (same physical bus)
@@ -185,6 +210,7 @@ bool initI2CBus(uint8_t bus_id, uint16_t clock_khz) {
 
     if (success) {
         active_i2c_id = bus_id;
+        configureI2CTimeout(active_i2c);  // A stuck slave must not hang Wire
 
         // Register pins as reserved in pin registry
         static const char* i2c_desc[] = {"Wire", "Wire1", "Wire2"};
@@ -212,63 +238,15 @@ bool initSPIBus(uint8_t bus_id, uint32_t clock_hz) {
     uint8_t miso = getDefaultSPIMISO(bus_id);
     uint8_t sck = getDefaultSPISCK(bus_id);
 
-    // Platform-specific initialization
+    // Platform-specific SPI instance (fixed pins)
+    SPIClass* bus = getSPIBus(bus_id);
     bool success = false;
-
-#if defined(__IMXRT1062__)
-    // Teensy 4.x: Multiple SPI instances with fixed pins
-    switch (bus_id) {
-        case 0:
-            SPI.begin();
-            active_spi = &SPI;
-            success = true;
-            break;
-        case 1:
-            SPI1.begin();
-            active_spi = &SPI1;
-            success = true;
-            break;
-        case 2:
-            SPI2.begin();
-            active_spi = &SPI2;
-            success = true;
-            break;
-    }
-
-#elif defined(__MK66FX1M0__) || defined(__MK64FX512__)
-    // Teensy 3.6/3.5: Multiple SPI instances
-    switch (bus_id) {
-        case 0:
-            SPI.begin();
-            active_spi = &SPI;
-            success = true;
-            break;
-#if NUM_SPI_BUSES >= 2
-        case 1:
-            SPI1.begin();
-            active_spi = &SPI1;
-            success = true;
-            break;
-#endif
-    }
-
-#elif defined(ESP32)
-    // ESP32: Single SPI bus with default pins
-    if (bus_id == 0) {
-        SPI.begin();
-        active_spi = &SPI;
+    if (bus != nullptr) {
+        bus->begin();
+        active_spi = bus;
         success = true;
     }
 
-#else
-    // Generic Arduino: Single SPI bus
-    if (bus_id == 0) {
-        SPI.begin();
-        active_spi = &SPI;
-        success = true;
-    }
-#endif
-
     if (success) {
         active_spi_id = bus_id;
 
@@ -332,6 +310,31 @@ SPIClass* getActiveSPI() {
     return active_spi ? active_spi : &SPI;
 }
 
+SPIClass* getSPIBus(uint8_t bus_id) {
+    if (bus_id >= NUM_SPI_BUSES) return nullptr;
+
+#if defined(__IMXRT1062__)
+    // Teensy 4.x: SPI, SPI1, SPI2
+    switch (bus_id) {
+        case 0: return &SPI;
+        case 1: return &SPI1;
+        case 2: return &SPI2;
+    }
+#elif defined(__MK66FX1M0__) || defined(__MK64FX512__)
+    // Teensy 3.6/3.5: SPI, SPI1
+    switch (bus_id) {
+        case 0: return &SPI;
+#if NUM_SPI_BUSES >= 2
+        case 1: return &SPI1;
+#endif
+    }
+#else
+    // ESP32 and generic Arduino: single SPI bus with default pins
+    if (bus_id == 0) return &SPI;
+#endif
+    return nullptr;
+}
+
 uint8_t getActiveI2CId() {
     return active_i2c_id;
 }
@@ -344,6 +347,222 @@ uint8_t getActiveCANId() {
     return active_can_id;
 }
 
+// ============================================================================
+// SPI ARBITER
+// ============================================================================
+
+struct SpiClientStats {
+    uint32_t transactions;      // Since boot
+    uint32_t windowUs;          // Bus time in the current window
+    uint32_t lastWindowUs;      // Bus time in the last full window
+    uint32_t maxHoldUs;         // Longest single hold since boot
+    uint32_t deferrals;         // spiShouldYield() answers of yes
+    uint32_t claimUs;           // micros() when the hold started
+    uint32_t nextDue;           // spiSetNextDue() deadline
+    uint32_t deferredSince;     // millis() of the first deferral in a row
+    bool hasDue;
+    bool deferring;
+};
+
+static SpiClientStats spiClients[NUM_SPI_CLIENTS];
+static uint32_t spiWindowStart = 0;
+static uint32_t spiLastWindowMs = 0;    // Length of the last full window
+
+static const char* const spiClientNames[NUM_SPI_CLIENTS] = {
+    "CAN", "THERMOCOUPLE", "EXT_ADC", "SD"
+};
+
+// Build-flag assignment of a class (SPI_BUS_ACTIVE = follow the active bus)
+static uint8_t assignedSPIBus(SpiClient client) {
+    switch (client) {
+        case SPI_CLIENT_CAN:          return MCP2515_SPI_BUS;
+        case SPI_CLIENT_THERMOCOUPLE: return THERMOCOUPLE_SPI_BUS;
+        case SPI_CLIENT_EXT_ADC:      return EXT_ADC_SPI_BUS;
+        default:                      return SPI_BUS_ACTIVE;
+    }
+}
+
+uint8_t getSPIBusIdFor(SpiClient client) {
+    if (client == SPI_CLIENT_SD) {
+        // SD.begin() has no bus argument: SPI, or SDIO for the built-in card
+        return systemConfig.sdCSPin == 254 ? SPI_BUS_NONE : 0;
+    }
+    if (client == SPI_CLIENT_CAN) {
+#if defined(ENABLE_CAN) && (PLATFORM_NEEDS_SPI_CAN || defined(ENABLE_CAN_HYBRID))
+        // The MCP2515 library's own default is SPI
+        return MCP2515_SPI_BUS == SPI_BUS_ACTIVE ? 0 : MCP2515_SPI_BUS;
+#else
+        return SPI_BUS_NONE;  // Native controller (FlexCAN, TWAI) or no CAN
+#endif
+    }
+    uint8_t bus_id = assignedSPIBus(client);
+    if (bus_id == SPI_BUS_ACTIVE || getSPIBus(bus_id) == nullptr) return active_spi_id;
+    return bus_id;
+}
+
+SPIClass* getSPIFor(SpiClient client) {
+    uint8_t bus_id = getSPIBusIdFor(client);
+    if (bus_id == SPI_BUS_NONE || bus_id == active_spi_id) return getActiveSPI();
+    SPIClass* bus = getSPIBus(bus_id);
+    return bus ? bus : getActiveSPI();
+}
+
+// Start the buses the build assigns to a class, if not the active one
+static void initAssignedSPIBuses() {
+    static const char* spi_desc[] = {"SPI", "SPI1", "SPI2"};
+    uint8_t started = 1 << active_spi_id;
+
+    for (uint8_t c = 0; c < NUM_SPI_CLIENTS; c++) {
+        uint8_t bus_id = assignedSPIBus((SpiClient)c);
+        if (bus_id == SPI_BUS_ACTIVE || getSPIBusIdFor((SpiClient)c) == SPI_BUS_NONE) continue;
+        SPIClass* bus = getSPIBus(bus_id);
+        if (bus == nullptr) {
+            msg.debug.warn(TAG_SPI, "%s: SPI bus %d not available, using the active bus",
+                           spiClientNames[c], bus_id);
+            continue;
+        }
+        if (started & (1 << bus_id)) continue;
+        started |= 1 << bus_id;
+
+        bus->begin();
+        registerPin(getDefaultSPIMOSI(bus_id), PIN_RESERVED, spi_desc[bus_id]);
+        registerPin(getDefaultSPIMISO(bus_id), PIN_RESERVED, spi_desc[bus_id]);
+        registerPin(getDefaultSPISCK(bus_id), PIN_RESERVED, spi_desc[bus_id]);
+        msg.debug.info(TAG_SPI, "SPI bus %d initialized for %s", bus_id, spiClientNames[c]);
+    }
+}
+
+// Close the window into lastWindowUs once it has run its length
+static void foldSPILoad(uint32_t now) {
+    uint32_t elapsed = now - spiWindowStart;
+    if (elapsed < SPI_LOAD_WINDOW_MS) return;
+
+    for (uint8_t c = 0; c < NUM_SPI_CLIENTS; c++) {
+        spiClients[c].lastWindowUs = spiClients[c].windowUs;
+        spiClients[c].windowUs = 0;
+    }
+    spiLastWindowMs = elapsed;
+    spiWindowStart = now;
+}
+
+void spiClaim(SpiClient client) {
+    spiClients[client].claimUs = micros();
+}
+
+void spiRelease(SpiClient client) {
+    SpiClientStats* st = &spiClients[client];
+    uint32_t held = micros() - st->claimUs;
+    st->transactions++;
+    st->windowUs += held;
+    if (held > st->maxHoldUs) st->maxHoldUs = held;
+    foldSPILoad(millis());
+}
+
+SPIClass* spiBegin(SpiClient client, const SPISettings& settings) {
+    SPIClass* spi = getSPIFor(client);
+    spi->beginTransaction(settings);
+    spiClaim(client);
+    return spi;
+}
+
+void spiEnd(SpiClient client) {
+    spiRelease(client);
+    getSPIFor(client)->endTransaction();
+}
+
+void spiSetNextDue(SpiClient client, uint32_t due_ms) {
+    spiClients[client].nextDue = due_ms;
+    spiClients[client].hasDue = true;
+}
+
+// A polled MCP2515 holds received frames (only two fit) until it is read
+static bool canFramesWaiting() {
+#if defined(ENABLE_CAN) && PLATFORM_NEEDS_SPI_CAN && !defined(PREOBD_NATIVE)
+    if (CAN_INT_0 != 0xFF && digitalRead(CAN_INT_0) == LOW) return true;
+    if (CAN_CS_1 != 0xFF && CAN_INT_1 != 0xFF && digitalRead(CAN_INT_1) == LOW) return true;
+#endif
+    return false;
+}
+
+bool spiShouldYield(SpiClient client) {
+    uint8_t bus_id = getSPIBusIdFor(client);
+    SpiClientStats* st = &spiClients[client];
+    if (bus_id == SPI_BUS_NONE) return false;
+
+    uint32_t now = millis();
+    bool wait = false;
+    for (uint8_t c = 0; c < client && !wait; c++) {
+        if (getSPIBusIdFor((SpiClient)c) != bus_id) continue;
+        if (c == SPI_CLIENT_CAN) {
+            wait = canFramesWaiting();
+        } else if (spiClients[c].hasDue) {
+            // Long overdue: the batch is not running (inputs were reconfigured)
+            int32_t ahead = (int32_t)(spiClients[c].nextDue - now);
+            wait = ahead <= SPI_YIELD_AHEAD_MS && ahead > -(int32_t)SPI_MAX_DEFER_MS;
+        }
+    }
+
+    if (!wait) {
+        st->deferring = false;
+        return false;
+    }
+    if (!st->deferring) {
+        st->deferring = true;
+        st->deferredSince = now;
+    } else if (now - st->deferredSince >= SPI_MAX_DEFER_MS) {
+        st->deferring = false;  // Waited long enough - go ahead this time
+        return false;
+    }
+    st->deferrals++;
+    return true;
+}
+
+// Per-class and per-bus share of the last window
+static void printSPIArbiterStats() {
+    foldSPILoad(millis());
+    uint32_t windowUs = spiLastWindowMs * 1000UL;
+
+    msg.control.println(F("Device classes (highest priority first):"));
+    for (uint8_t c = 0; c < NUM_SPI_CLIENTS; c++) {
+        SpiClientStats* st = &spiClients[c];
+        uint8_t bus_id = getSPIBusIdFor((SpiClient)c);
+        char line[96];
+        snprintf(line, sizeof(line), "  %-13s %-5s %lu transactions, max hold %lu us, %lu deferred",
+                 spiClientNames[c],
+                 bus_id != SPI_BUS_NONE ? getSPIBusName(bus_id) : (c == SPI_CLIENT_SD ? "SDIO" : "none"),
+                 (unsigned long)st->transactions, (unsigned long)st->maxHoldUs,
+                 (unsigned long)st->deferrals);
+        msg.control.print(line);
+        if (windowUs > 0 && st->transactions > 0) {
+            msg.control.print(F(", "));
+            msg.control.print(st->lastWindowUs * 100.0f / windowUs, 1);
+            msg.control.print(F("% of bus"));
+        }
+        msg.control.println();
+    }
+
+    if (windowUs == 0) return;
+    msg.control.print(F("Utilization over "));
+    msg.control.print(spiLastWindowMs);
+    msg.control.print(F(" ms:"));
+    for (uint8_t b = 0; b < NUM_SPI_BUSES; b++) {
+        uint32_t busyUs = 0;
+        bool used = false;
+        for (uint8_t c = 0; c < NUM_SPI_CLIENTS; c++) {
+            if (getSPIBusIdFor((SpiClient)c) != b) continue;
+            used = true;
+            busyUs += spiClients[c].lastWindowUs;
+        }
+        if (!used) continue;
+        msg.control.print(F(" "));
+        msg.control.print(getSPIBusName(b));
+        msg.control.print(F(" "));
+        msg.control.print(busyUs * 100.0f / windowUs, 1);
+        msg.control.print(F("%"));
+    }
+    msg.control.println();
+}
+
 // ============================================================================
 // BUS NAME HELPERS
 // ============================================================================
@@ -401,6 +620,10 @@ void displayI2CStatus() {
         msg.control.print(getI2CBusName(i));
     }
     msg.control.println();
+    printI2CEngineStatus();
+#ifndef USE_STATIC_CONFIG
+    printDeviceInventory();
+#endif
 }
 
 // Helper function to display SPI bus configuration
@@ -427,6 +650,7 @@ void displaySPIStatus() {
         msg.control.print(getSPIBusName(i));
     }
     msg.control.println();
+    printSPIArbiterStats();
 }
 
 // Helper function to display CAN bus configuration
@@ -440,11 +664,20 @@ void displayCANStatus() {
         msg.control.print(getCANBusName(systemConfig.buses.input_can_bus));
         if (systemConfig.buses.can_input_mode == CAN_INPUT_LISTEN) {
             msg.control.print(F(" (LISTEN) @ "));
+        } else if (systemConfig.buses.can_input_mode == CAN_INPUT_POLL) {
+            msg.control.print(F(" (POLL) @ "));
         } else {
             msg.control.print(F(" (NORMAL) @ "));
         }
         msg.control.print(systemConfig.buses.can_input_baudrate / 1000);
         msg.control.print(F("kbps"));
+        if (systemConfig.buses.can_input_protocol == CAN_PROTOCOL_J1939) {
+            msg.control.print(F(", J1939"));
+        }
+#ifdef ENABLE_CAN
+        msg.control.print(F(", RX overflows: "));
+        msg.control.print(getCANInputRxOverflows());
+#endif
     } else {
         msg.control.print(F("DISABLED"));
     }
@@ -457,10 +690,55 @@ void displayCANStatus() {
         msg.control.print(F(" (ENABLED) @ "));
         msg.control.print(systemConfig.buses.can_output_baudrate / 1000);
         msg.control.print(F("kbps"));
+        if (systemConfig.buses.can_output_layout == CAN_OUTPUT_PACKED) {
+            msg.control.print(F(", PACKED from 0x"));
+            msg.control.print(systemConfig.buses.can_output_base_id, HEX);
+        } else if (systemConfig.buses.can_output_layout == CAN_OUTPUT_J1939) {
+            msg.control.print(F(", J1939 SA 0x"));
+            msg.control.print(systemConfig.buses.j1939_address, HEX);
+        } else if (systemConfig.buses.can_output_layout == CAN_OUTPUT_NMEA2000) {
+            msg.control.print(F(", NMEA 2000 from SA 0x"));
+            msg.control.print(systemConfig.buses.j1939_address, HEX);
+        }
     } else {
         msg.control.print(F("DISABLED"));
     }
     msg.control.println();
+
+    // Display mirror bus
+    msg.control.print(F("Mirror: "));
+    if (systemConfig.buses.can_mirror_bus != 0xFF) {
+        msg.control.print(getCANBusName(systemConfig.buses.can_mirror_bus));
+        msg.control.print(F(" @ "));
+        msg.control.print(systemConfig.buses.can_mirror_baudrate / 1000);
+        msg.control.print(F("kbps, every "));
+        msg.control.print(systemConfig.buses.can_mirror_interval);
+        msg.control.print(F("ms"));
+        if (systemConfig.buses.can_mirror_layout == CAN_OUTPUT_PACKED) {
+            msg.control.print(F(", PACKED from 0x"));
+            msg.control.print(systemConfig.buses.can_mirror_base_id, HEX);
+        } else if (systemConfig.buses.can_mirror_layout == CAN_OUTPUT_J1939) {
+            msg.control.print(F(", J1939 SA 0x"));
+            msg.control.print(systemConfig.buses.j1939_address, HEX);
+        } else if (systemConfig.buses.can_mirror_layout == CAN_OUTPUT_NMEA2000) {
+            msg.control.print(F(", NMEA 2000 from SA 0x"));
+            msg.control.print(systemConfig.buses.j1939_address, HEX);
+        } else {
+            msg.control.print(F(", OBD"));
+        }
+    } else {
+        msg.control.print(F("DISABLED"));
+    }
+    msg.control.println();
+#ifdef ENABLE_CAN
+    printOBD2PollerStatus();
+    printJ1939InputStatus();
+    printCANCacheStats();
+    printOBD2RequestStats();
+    printCANRxStats();
+    printCANTxStats();
+    printCANNodeStatus();
+#endif
     msg.control.print(F("Available buses: "));
     for (uint8_t i = 0; i < NUM_CAN_BUSES; i++) {
         if (i > 0) msg.control.print(F(", "));
@@ -8,11 +8,43 @@
  * - Platform-specific initialization (Teensy 4.x, 3.6, ESP32, Mega)
  * - Pin conflict validation before bus initialization
  * - Simple accessor functions for the active bus instance
+ * - SPI arbiter: per-device-class bus assignment, priorities and utilization
  *
  * Usage:
  *   1. Call initConfiguredBuses() during setup()
  *   2. Sensors use getActiveI2C() to get the active Wire object
- *   3. SPI devices use getActiveSPI() to get the active SPI object
+ *   3. SPI devices use getActiveSPI() to get the active SPI object, or
+ *      spiBegin()/spiEnd() for a device class the arbiter tracks
+ *
+ * SPI arbiter:
+ * The SD card, the MCP2515 controllers and the thermocouple and MCP3208
+ * batches can share one bus. Each device class (SpiClient, highest priority
+ * first) is assigned a bus - the active one unless its build flag names
+ * another, which initConfiguredBuses() then starts too - so heavy classes
+ * can be split onto SPI1/SPI2. Transactions of a class go through
+ * spiBegin()/spiEnd() (spiClaim()/spiRelease() around library calls that
+ * open their own, like SD writes), which time how long each holds the bus.
+ *
+ * The loop is cooperative, so priority is enforced where a long job starts:
+ * before an SD sector write, spiShouldYield() says to put it off while a
+ * higher class on the same bus has work due within SPI_YIELD_AHEAD_MS (batch
+ * deadlines announced with spiSetNextDue()) or a polled MCP2515 holds frames
+ * (INT low). A class is put off for at most SPI_MAX_DEFER_MS in a row.
+ * The batches themselves already chain their chips back to back in one
+ * transaction.
+ *
+ * BUS SPI shows each class's bus, transactions, longest hold, deferrals and
+ * share of the bus over the last SPI_LOAD_WINDOW_MS, and each bus's total.
+ *
+ * Build Flags:
+ *   -D MCP2515_SPI_BUS=n       - SPI bus of the MCP2515 controllers (default: SPI, bus 0)
+ *   -D THERMOCOUPLE_SPI_BUS=n  - SPI bus of the MAX6675/MAX31855 probes (default: active bus)
+ *   -D EXT_ADC_SPI_BUS=n       - SPI bus of the MCP3208 (default: active bus)
+ *   -D SPI_YIELD_AHEAD_MS=n    - Higher-priority work due this soon defers SD writes (default 2)
+ *   -D SPI_MAX_DEFER_MS=n      - Longest a class is deferred in a row (default 20)
+ *   -D SPI_LOAD_WINDOW_MS=n    - Utilization window (default 1000)
+ *   The SD card stays on SPI (bus 0; none with BUILTIN_SDCARD): SD.begin()
+ *   has no bus argument.
  */
 
 #ifndef BUS_MANAGER_H
@@ -101,6 +133,88 @@ uint8_t getActiveSPIId();
  */
 uint8_t getActiveCANId();
 
+/**
+ * Get the SPI object of a bus
+ * @param bus_id Bus number (0-2)
+ * @return Pointer to the SPIClass object, or nullptr if not on this platform
+ */
+SPIClass* getSPIBus(uint8_t bus_id);
+
+// ============================================================================
+// SPI ARBITER
+// ============================================================================
+
+#define SPI_BUS_ACTIVE 0xFF     // Class flag default: the active SPI bus (SPI for the MCP2515)
+#define SPI_BUS_NONE   0xFF     // getSPIBusIdFor(): class not on any SPI bus
+
+#ifndef MCP2515_SPI_BUS
+#define MCP2515_SPI_BUS SPI_BUS_ACTIVE
+#endif
+
+#ifndef THERMOCOUPLE_SPI_BUS
+#define THERMOCOUPLE_SPI_BUS SPI_BUS_ACTIVE
+#endif
+
+#ifndef EXT_ADC_SPI_BUS
+#define EXT_ADC_SPI_BUS SPI_BUS_ACTIVE
+#endif
+
+#ifndef SPI_YIELD_AHEAD_MS
+#define SPI_YIELD_AHEAD_MS 2
+#endif
+
+#ifndef SPI_MAX_DEFER_MS
+#define SPI_MAX_DEFER_MS 20
+#endif
+
+#ifndef SPI_LOAD_WINDOW_MS
+#define SPI_LOAD_WINDOW_MS 1000
+#endif
+
+// SPI device classes, highest priority first
+enum SpiClient : uint8_t {
+    SPI_CLIENT_CAN = 0,         // MCP2515 controllers
+    SPI_CLIENT_THERMOCOUPLE,    // MAX6675 / MAX31855 batch
+    SPI_CLIENT_EXT_ADC,         // MCP3208 batch
+    SPI_CLIENT_SD,              // SD card writes
+    NUM_SPI_CLIENTS
+};
+
+/**
+ * Bus assigned to a device class
+ * @return Bus ID (0-2), or SPI_BUS_NONE (SD card on SDIO)
+ */
+uint8_t getSPIBusIdFor(SpiClient client);
+
+/**
+ * SPI object assigned to a device class
+ * @return Pointer to the SPIClass object (the active bus if unassigned)
+ */
+SPIClass* getSPIFor(SpiClient client);
+
+/**
+ * Open a transaction on the class's bus and start timing it
+ * @return The bus to transfer on - close with spiEnd()
+ */
+SPIClass* spiBegin(SpiClient client, const SPISettings& settings);
+
+// Close the transaction opened by spiBegin()
+void spiEnd(SpiClient client);
+
+// Time a library call that opens its own transactions on the class's bus
+void spiClaim(SpiClient client);
+void spiRelease(SpiClient client);
+
+// A class's next batch deadline (millis()), for spiShouldYield()
+void spiSetNextDue(SpiClient client, uint32_t due_ms);
+
+/**
+ * Should a long job of this class wait?
+ * @return true if a higher-priority class on the same bus has work due
+ *         (counted as a deferral; false after SPI_MAX_DEFER_MS of them)
+ */
+bool spiShouldYield(SpiClient client);
+
 // ============================================================================
 // BUS INFORMATION
 // ============================================================================
@@ -137,6 +251,7 @@ void displayI2CStatus();
 
 /**
  * Display SPI bus configuration status
+ * (with the arbiter's class assignments and utilization)
  */
 void displaySPIStatus();
 
@@ -4,6 +4,8 @@
 
 #include "button_handler.h"
 #include "../config.h"
+#include "../hal/hal_placement.h"
+#include "isr_profile.h"
 #include "message_api.h"
 #include "log_tags.h"
 
@@ -11,76 +13,145 @@
 #define DEBOUNCE_MS 50              // Debounce delay (50ms)
 #define LONG_PRESS_MS 2000          // Long press threshold (2 seconds)
 
-// Button state tracking
-static bool buttonState = false;           // Current debounced state (true = pressed)
-static bool lastRawState = false;          // Last raw reading
-static uint32_t lastDebounceTime = 0;      // Last time input changed
-static uint32_t pressStartTime = 0;        // When button was first pressed
-static bool pressHandled = false;          // Flag to prevent re-triggering
+static_assert((BUTTON_EDGE_QUEUE & (BUTTON_EDGE_QUEUE - 1)) == 0, "BUTTON_EDGE_QUEUE must be a power of 2");
 
-void initButtonHandler() {
-    pinMode(MODE_BUTTON, INPUT_PULLUP);
-    buttonState = digitalRead(MODE_BUTTON) == LOW;
-    lastRawState = buttonState;
-    lastDebounceTime = millis();
-    pressStartTime = 0;
+struct ButtonEdge {
+    uint32_t atMs;
+    bool pressed;                   // Level after the edge (LOW = pressed with INPUT_PULLUP)
+};
+
+// Edge queue - the ISR writes entries and head, the loop reads them and moves tail
+static volatile ButtonEdge edges[BUTTON_EDGE_QUEUE];
+static volatile uint8_t edgeHead = 0;
+static volatile uint8_t edgeTail = 0;
+static volatile bool edgeOverflow = false;  // Edges dropped - resync from the pin
+static bool polled = false;                 // No interrupt on the pin - poll it each pass
+static bool polledLevel = false;
+
+// Debounce and press state (loop only)
+static bool pendingPressed = false;         // Level of the newest edge, not yet held DEBOUNCE_MS
+static uint32_t pendingAt = 0;
+static bool havePending = false;
+static bool buttonState = false;            // Current debounced state (true = pressed)
+static uint32_t pressStartTime = 0;         // When the debounced press started
+static bool pressHandled = false;           // Long press already sent for this press
+
+static ButtonListener listeners[BUTTON_MAX_LISTENERS];
+static uint8_t numListeners = 0;
+
+// Queue an edge (ISR, or the loop when polling)
+HAL_ISR static void pushEdge(uint32_t atMs, bool pressed) {
+    uint8_t next = (edgeHead + 1) & (BUTTON_EDGE_QUEUE - 1);
+    if (next == edgeTail) {
+        edgeOverflow = true;
+        return;
+    }
+    edges[edgeHead].atMs = atMs;
+    edges[edgeHead].pressed = pressed;
+    edgeHead = next;
+}
+
+HAL_ISR static void buttonISR() {
+    ISR_PROFILE_BEGIN();
+    pushEdge(millis(), digitalRead(MODE_BUTTON) == LOW);
+    ISR_PROFILE_END(ISR_PROF_BUTTON);
+}
+
+static void notify(ButtonPress event) {
+    for (uint8_t i = 0; i < numListeners; i++) {
+        listeners[i](event);
+    }
+}
+
+// A level held DEBOUNCE_MS from atMs - press transitions and their events
+static void acceptLevel(bool pressed, uint32_t atMs) {
+    if (pressed == buttonState) return;  // Bounced back to where it was
+    buttonState = pressed;
+
+    if (pressed) {
+        pressStartTime = atMs;
+        pressHandled = false;
+        notify(BUTTON_DOWN);
+        return;
+    }
+
+    // Released - a long press not yet sent (the loop was held that long) still counts
+    if (!pressHandled) {
+        notify(atMs - pressStartTime >= LONG_PRESS_MS ? BUTTON_LONG_PRESS : BUTTON_SHORT_PRESS);
+    }
     pressHandled = false;
-    msg.debug.info(TAG_SYSTEM, "Button handler initialized");
 }
 
-ButtonPress updateButtonHandler() {
-    uint32_t now = millis();
+void initButtonHandler() {
+    pinMode(MODE_BUTTON, INPUT_PULLUP);
+    buttonState = digitalRead(MODE_BUTTON) == LOW;
+    pressStartTime = millis();
+    pressHandled = buttonState;           // Held through boot (CONFIG entry) - not a press
+    havePending = false;
+    edgeHead = edgeTail = 0;
+    edgeOverflow = false;
 
-    // Read raw button state (LOW = pressed with INPUT_PULLUP)
-    bool rawState = (digitalRead(MODE_BUTTON) == LOW);
+    int irq = digitalPinToInterrupt(MODE_BUTTON);
+    polled = irq == NOT_AN_INTERRUPT;
+    polledLevel = buttonState;
+    if (!polled) {
+        attachInterrupt(irq, buttonISR, CHANGE);
+    }
+    msg.debug.info(TAG_SYSTEM, polled ? "Button handler initialized (polled - pin has no interrupt)"
+                                      : "Button handler initialized");
+}
 
-    // Detect state change
-    if (rawState != lastRawState) {
-        lastDebounceTime = now;
+bool subscribeButton(ButtonListener listener) {
+    for (uint8_t i = 0; i < numListeners; i++) {
+        if (listeners[i] == listener) return true;
     }
-    lastRawState = rawState;
+    if (listener == nullptr || numListeners >= BUTTON_MAX_LISTENERS) return false;
+    listeners[numListeners++] = listener;
+    return true;
+}
 
-    // Debounce: only update state if stable for DEBOUNCE_MS
-    if ((now - lastDebounceTime) > DEBOUNCE_MS) {
-        bool newState = rawState;
+void updateButtonHandler() {
+    uint32_t now = millis();
 
-        // Detect button press (transition from not pressed to pressed)
-        if (newState && !buttonState) {
-            // Button just pressed
-            pressStartTime = now;
-            pressHandled = false;
+    if (polled) {
+        bool level = digitalRead(MODE_BUTTON) == LOW;
+        if (level != polledLevel) {
+            polledLevel = level;
+            pushEdge(now, level);
         }
+    }
 
-        // While button is held, check if we've reached long press threshold
-        if (newState && buttonState && !pressHandled && pressStartTime > 0) {
-            uint32_t pressDuration = now - pressStartTime;
-            if (pressDuration >= LONG_PRESS_MS) {
-                // Long press threshold reached - trigger action for preview
-                pressHandled = true;
-                return BUTTON_LONG_PRESS;
-            }
-        }
+    // Each edge settles the one before it if they are DEBOUNCE_MS apart
+    while (edgeTail != edgeHead) {
+        uint32_t atMs = edges[edgeTail].atMs;
+        bool pressed = edges[edgeTail].pressed;
+        edgeTail = (edgeTail + 1) & (BUTTON_EDGE_QUEUE - 1);
 
-        // Detect button release (transition from pressed to not pressed)
-        if (!newState && buttonState) {
-            // Button just released
-            if (pressStartTime > 0) {
-                pressStartTime = 0;
-
-                // If long press was already handled, this release is just confirmation
-                // If not handled yet, it's a short press
-                if (!pressHandled) {
-                    buttonState = newState;
-                    return BUTTON_SHORT_PRESS;
-                }
-                pressHandled = false;
-            }
+        if (havePending && atMs - pendingAt >= DEBOUNCE_MS) {
+            acceptLevel(pendingPressed, pendingAt);
         }
+        pendingPressed = pressed;
+        pendingAt = atMs;
+        havePending = true;
+    }
+    if (edgeOverflow) {
+        edgeOverflow = false;
+        pendingPressed = digitalRead(MODE_BUTTON) == LOW;
+        pendingAt = now;
+        havePending = true;
+    }
 
-        buttonState = newState;
+    // Newest edge held long enough
+    if (havePending && now - pendingAt >= DEBOUNCE_MS) {
+        havePending = false;
+        acceptLevel(pendingPressed, pendingAt);
     }
 
-    return BUTTON_NONE;
+    // Still held - the long press goes out once, before the release
+    if (buttonState && !pressHandled && now - pressStartTime >= LONG_PRESS_MS) {
+        pressHandled = true;
+        notify(BUTTON_LONG_PRESS);
+    }
 }
 
 bool isButtonPressed() {
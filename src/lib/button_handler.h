@@ -1,6 +1,32 @@
 /*
  * button_handler.h - Multi-function button handler
  * Handles MODE_BUTTON with debouncing and long-press detection
+ *
+ * One service owns the button pin. An edge interrupt (CHANGE) timestamps
+ * each edge with the level it left the pin at into a small queue; nothing
+ * reads the pin from the loop. updateButtonHandler() drains the queue,
+ * debounces on the timestamps (a level counts once it held DEBOUNCE_MS)
+ * and classifies presses, then hands each event to the subscribers:
+ *
+ *   BUTTON_DOWN         Debounced press, as it starts (alarm silence)
+ *   BUTTON_LONG_PRESS   Held LONG_PRESS_MS (display toggle) - sent while
+ *                       still held, so the user sees it take effect
+ *   BUTTON_SHORT_PRESS  Released before LONG_PRESS_MS
+ *
+ * Presses are timed from the edges, not from when the loop got to them, so
+ * a slow loop pass still tells a short press from a long one. If the pin
+ * has no interrupt (pin 5 on an Uno) the service polls it once per pass
+ * into the same queue. A full queue drops edges and reads the pin once to
+ * resync.
+ *
+ * Usage:
+ *   static void onButton(ButtonPress event) { if (event == BUTTON_DOWN) ... }
+ *   subscribeButton(onButton);     // At init, before or after initButtonHandler()
+ *   updateButtonHandler();         // loop()
+ *
+ * Build Flags:
+ *   -D BUTTON_EDGE_QUEUE=n       - Edges buffered between loop passes (default 8, power of 2)
+ *   -D BUTTON_MAX_LISTENERS=n    - Subscribers (default 4)
  */
 
 #ifndef BUTTON_HANDLER_H
@@ -8,19 +34,32 @@
 
 #include <Arduino.h>
 
+#ifndef BUTTON_EDGE_QUEUE
+#define BUTTON_EDGE_QUEUE 8
+#endif
+
+#ifndef BUTTON_MAX_LISTENERS
+#define BUTTON_MAX_LISTENERS 4
+#endif
+
 // Button press types
 enum ButtonPress {
     BUTTON_NONE = 0,      // No press detected
     BUTTON_SHORT_PRESS,   // Short press (< 2 seconds)
-    BUTTON_LONG_PRESS     // Long press (>= 2 seconds)
+    BUTTON_LONG_PRESS,    // Long press (>= 2 seconds)
+    BUTTON_DOWN           // Press started (debounced)
 };
 
-// Initialize button handler
+typedef void (*ButtonListener)(ButtonPress event);
+
+// Initialize button handler (pin and edge interrupt)
 void initButtonHandler();
 
-// Update button state (call frequently from main loop)
-// Returns button press type if a press was completed, otherwise BUTTON_NONE
-ButtonPress updateButtonHandler();
+// Deliver button events to listener; false if BUTTON_MAX_LISTENERS are taken
+bool subscribeButton(ButtonListener listener);
+
+// Drain queued edges, debounce, classify and notify subscribers (call from loop)
+void updateButtonHandler();
 
 // Get current button state (for debugging)
 bool isButtonPressed();
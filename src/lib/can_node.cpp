@@ -0,0 +1,549 @@
+/*
+ * can_node.cpp - preOBD node network: several units sharing inputs over CAN
+ *
+ * Own side: the channel table (rebuilt with the input schedule), paced out
+ * a few entries per pass when it changes or a subscriber asks, plus the
+ * heartbeat and the value frames from the loop. Remote side: a heartbeat
+ * and table per node heard, the channels of subscribed nodes with their
+ * latest values, and the NODE:n inputs made for them.
+ */
+
+#include "../config.h"
+#include "can_node.h"
+#include "../inputs/input.h"
+#include "../inputs/input_health.h"
+
+#if defined(ENABLE_CAN_NODES) && defined(ENABLE_CAN)
+
+#include "../hal/hal_can.h"
+#include "../inputs/input_manager.h"
+#include "../outputs/output_can.h"
+#include "../outputs/packed_signal.h"
+#include "application_presets.h"
+#include "can_rx.h"
+#include "can_tx.h"
+#include "crc32.h"
+#include "message_api.h"
+#include "log_tags.h"
+#include "memory_report.h"
+#include "system_config.h"
+
+static_assert((CAN_NODE_BASE_ID & 0x3F) == 0 && CAN_NODE_BASE_ID < 0x800,
+              "CAN_NODE_BASE_ID must be an 11-bit multiple of 0x40");
+
+#define NODE_ID_MASK   0x7C0        // The 64 IDs of the protocol
+#define SIGNAL_BYTES   7            // A value frame is its number plus 7 signal bytes
+#define MAX_FRAMES     ((MAX_INPUTS * 2 + SIGNAL_BYTES - 1) / SIGNAL_BYTES)
+#define NO_ENTRY       0xFF
+
+// ===== OWN CHANNEL TABLE =====
+
+struct NodeChannel {
+    uint8_t slot;               // inputs[] slot
+    uint8_t pin;
+    uint16_t appHash;           // Application name hash
+    uint8_t type;               // MeasurementType - the signal's width and scaling
+    uint8_t frame;              // Value frame
+    uint8_t start;              // First byte after the frame number
+};
+
+static NodeChannel channels[MAX_INPUTS];
+static uint8_t frameLen[MAX_FRAMES];   // Signal bytes used in each value frame
+static uint8_t channelCount = 0;
+static uint8_t frameCount = 0;
+static uint16_t tableCrc = 0;
+static uint8_t tableNext = NO_ENTRY;   // Next entry to announce (NO_ENTRY: none due)
+
+static uint8_t nodeBus = 0xFF;         // Bus the node runs on (0xFF: not a node)
+static uint8_t nodeId = CAN_NODE_OFF;
+static uint32_t nextHeartbeat = 0;
+static uint32_t nextValues = 0;
+
+// ===== NODES HEARD =====
+
+struct RemoteNode {
+    uint32_t lastSeen;          // millis() of its last heartbeat (0 = never)
+    uint32_t uptime;            // Seconds, from that heartbeat
+    uint32_t lastRequest;       // millis() of our last table request to it
+    uint32_t runningCrc;        // CRC-32 of the entries of the announcement in progress
+    uint16_t tableCrc;          // Table CRC its heartbeat carries
+    uint16_t heldCrc;           // CRC of the last complete announcement received
+    uint8_t channels;           // Channel count its heartbeat carries
+    uint8_t expected;           // Entries of the announcement in progress
+    uint8_t received;           // ... received in order so far
+    bool complete;
+};
+
+struct RemoteChannel {
+    uint8_t node;               // NO_ENTRY = free
+    uint8_t pin;                // The input's pin on its node
+    uint8_t type;               // MeasurementType
+    uint8_t frame;
+    uint8_t start;
+    uint16_t appHash;
+    float value;                // Standard units, NAN: none
+    uint32_t rxMs;              // millis() of its last value (0 = none)
+};
+
+static RemoteNode nodes[CAN_NODE_COUNT];
+static RemoteChannel remote[CAN_NODE_MAX_REMOTE];
+static uint16_t importDue = 0;          // Bit n: node n's table completed, import on the next update
+static uint32_t conflicts = 0;          // Heartbeats from another unit with our node number
+static uint32_t remoteDropped = 0;      // Announced channels without room here
+
+static bool isSubscribed(uint8_t node) {
+    return systemConfig.buses.can_node_subscribe & (1U << node);
+}
+
+static bool isNodeAlive(const RemoteNode& n, uint32_t now) {
+    return n.lastSeen != 0 && now - n.lastSeen < CAN_NODE_TIMEOUT_MS;
+}
+
+// One table entry's share of the table CRC
+static uint32_t addEntryCrc(uint32_t crc, uint8_t pin, uint16_t appHash, uint8_t type, uint8_t frame, uint8_t start) {
+    const uint8_t bytes[6] = { pin, (uint8_t)(appHash & 0xFF), (uint8_t)(appHash >> 8), type, frame, start };
+    return crc32Update(crc, bytes, sizeof(bytes));
+}
+
+// ===== TABLE =====
+
+void rebuildCANNodeTable() {
+    channelCount = 0;
+    frameCount = 0;
+    uint32_t crc = 0;
+    uint8_t frame = 0;
+    uint8_t start = 0;
+
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        Input* input = &inputs[i];
+        if (input->pin == 0xFF) continue;
+        const ApplicationPreset* app = getApplicationByIndex(input->applicationIndex);
+
+        // NODE:n inputs measure what their applications do, and aren't passed on
+        if (input->calibrationType == CAL_NODE_CHANNEL) {
+            if (app) input->measurementType = (MeasurementType)pgm_read_byte(&app->expectedMeasurementType);
+            continue;
+        }
+        if (!input->flags.isEnabled || NODE_IS_PIN(input->pin) || app == nullptr) continue;
+        if (!PIN_IS_NARROW(input->pin)) continue;   // The table carries 8-bit pins
+
+        uint8_t width = getPackedScale(input->measurementType).width;
+        if (start + width > SIGNAL_BYTES) {
+            frame++;
+            start = 0;
+        }
+        NodeChannel& c = channels[channelCount++];
+        c.slot = i;
+        c.pin = input->pin;
+        c.appHash = pgm_read_word(&app->nameHash);
+        c.type = input->measurementType;
+        c.frame = frame;
+        c.start = start;
+        crc = addEntryCrc(crc, c.pin, c.appHash, c.type, c.frame, c.start);
+        start += width;
+        frameLen[frame] = start;
+        frameCount = frame + 1;
+    }
+
+    uint16_t crc16 = (uint16_t)(crc & 0xFFFF);
+    if (crc16 != tableCrc && nodeBus != 0xFF) tableNext = 0;  // Tell the subscribers now
+    tableCrc = crc16;
+}
+
+// Send up to a broadcast burst of table entries
+static void announceTable() {
+    for (uint8_t k = 0; k < CAN_TX_BROADCAST_BURST && tableNext < channelCount; k++, tableNext++) {
+        const NodeChannel& c = channels[tableNext];
+        uint8_t data[8] = { tableNext, channelCount, c.pin, (uint8_t)(c.appHash & 0xFF), (uint8_t)(c.appHash >> 8),
+                            c.type, c.frame, c.start };
+        queueCANTx(nodeBus, CAN_NODE_ID(CAN_NODE_MSG_TABLE, nodeId), data, 8, false, CAN_TX_BROADCAST, tableNext);
+    }
+    if (tableNext >= channelCount) tableNext = NO_ENTRY;
+}
+
+static void sendHeartbeat(uint32_t now) {
+    uint32_t uptime = now / 1000;
+    uint8_t data[8] = { CAN_NODE_PROTOCOL_VERSION, channelCount,
+                        (uint8_t)(tableCrc & 0xFF), (uint8_t)(tableCrc >> 8),
+                        (uint8_t)uptime, (uint8_t)(uptime >> 8), (uint8_t)(uptime >> 16), (uint8_t)(uptime >> 24) };
+    queueCANTx(nodeBus, CAN_NODE_ID(CAN_NODE_MSG_HEARTBEAT, nodeId), data, 8, false, CAN_TX_BROADCAST);
+}
+
+static void sendValues() {
+    uint8_t c = 0;
+    for (uint8_t f = 0; f < frameCount; f++) {
+        uint8_t data[8];
+        data[0] = f;
+        memset(&data[1], 0xFF, SIGNAL_BYTES);
+        for (; c < channelCount && channels[c].frame == f; c++) {
+            const Input* input = &inputs[channels[c].slot];
+            float value = input->flags.isEnabled ? input->value : NAN;
+            writePackedSignal(&data[1 + channels[c].start], (MeasurementType)channels[c].type, value);
+        }
+        queueCANTx(nodeBus, CAN_NODE_ID(CAN_NODE_MSG_VALUES, nodeId), data, 1 + frameLen[f], false,
+                   CAN_TX_BROADCAST, f);
+    }
+}
+
+static void requestTable(uint8_t node, uint32_t now) {
+    RemoteNode& n = nodes[node];
+    if (n.lastRequest != 0 && now - n.lastRequest < CAN_NODE_HEARTBEAT_MS) return;
+    n.lastRequest = now ? now : 1;
+    uint8_t data[1] = { node };
+    queueCANTx(nodeBus, CAN_NODE_ID(CAN_NODE_MSG_REQUEST, nodeId), data, 1, false, CAN_TX_URGENT);
+}
+
+// ===== RECEIVE =====
+
+static void dropNodeChannels(uint8_t node) {
+    for (uint8_t i = 0; i < CAN_NODE_MAX_REMOTE; i++) {
+        if (remote[i].node == node) remote[i].node = NO_ENTRY;
+    }
+}
+
+static RemoteChannel* findRemoteChannel(uint8_t node, uint8_t pin) {
+    for (uint8_t i = 0; i < CAN_NODE_MAX_REMOTE; i++) {
+        if (remote[i].node == node && remote[i].pin == pin) return &remote[i];
+    }
+    return nullptr;
+}
+
+static void handleHeartbeat(uint8_t node, const uint8_t* d, uint8_t len, uint32_t rxMs) {
+    if (node == nodeId) {
+        conflicts++;
+        return;
+    }
+    RemoteNode& n = nodes[node];
+    n.lastSeen = rxMs ? rxMs : 1;
+    n.channels = d[1];
+    n.tableCrc = d[2] | (d[3] << 8);
+    n.uptime = (uint32_t)d[4] | ((uint32_t)d[5] << 8) | ((uint32_t)d[6] << 16) | ((uint32_t)d[7] << 24);
+    (void)len;
+
+    if (!isSubscribed(node)) return;
+    if (n.channels == 0) {
+        // Nothing to announce - an empty table is complete as it is
+        if (!n.complete || n.heldCrc != n.tableCrc) dropNodeChannels(node);
+        n.complete = true;
+        n.heldCrc = n.tableCrc;
+        return;
+    }
+    if (!n.complete || n.heldCrc != n.tableCrc) requestTable(node, rxMs);
+}
+
+static void handleTableEntry(uint8_t node, const uint8_t* d) {
+    if (!isSubscribed(node)) return;
+    RemoteNode& n = nodes[node];
+    uint8_t index = d[0];
+    uint8_t count = d[1];
+    uint16_t appHash = d[3] | (d[4] << 8);
+
+    // An announcement starts at entry 0; a gap makes it incomplete until the next
+    if (index == 0) {
+        dropNodeChannels(node);
+        n.expected = count;
+        n.received = 0;
+        n.runningCrc = 0;
+        n.complete = false;
+    }
+    if (index != n.received || count != n.expected || n.complete) return;
+
+    n.runningCrc = addEntryCrc(n.runningCrc, d[2], appHash, d[5], d[6], d[7]);
+    n.received++;
+
+    RemoteChannel* c = nullptr;
+    for (uint8_t i = 0; i < CAN_NODE_MAX_REMOTE && !c; i++) {
+        if (remote[i].node == NO_ENTRY) c = &remote[i];
+    }
+    if (c) {
+        c->node = node;
+        c->pin = d[2];
+        c->type = d[5];
+        c->frame = d[6];
+        c->start = d[7];
+        c->appHash = appHash;
+        c->value = NAN;
+        c->rxMs = 0;
+    } else {
+        remoteDropped++;
+    }
+
+    if (n.received == n.expected) {
+        n.complete = true;
+        n.heldCrc = (uint16_t)(n.runningCrc & 0xFFFF);
+        importDue |= (1U << node);
+    }
+}
+
+static void handleValues(uint8_t node, const uint8_t* d, uint8_t len, uint32_t rxMs) {
+    if (!isSubscribed(node) || len < 1) return;
+    for (uint8_t i = 0; i < CAN_NODE_MAX_REMOTE; i++) {
+        RemoteChannel& c = remote[i];
+        if (c.node != node || c.frame != d[0]) continue;
+        PackedScale scale = getPackedScale((MeasurementType)c.type);
+        if (1 + c.start + scale.width > len) continue;
+        uint16_t raw = d[1 + c.start];
+        uint16_t notAvailable = 0xFF;
+        if (scale.width == 2) {
+            raw |= d[2 + c.start] << 8;
+            notAvailable = 0xFFFF;
+        }
+        c.value = (raw == notAvailable) ? NAN : raw * scale.factor + scale.offset;
+        c.rxMs = rxMs ? rxMs : 1;
+    }
+}
+
+static bool handleNodeFrame(const hal::can::CanRxFrame& frame) {
+    if (frame.extended || frame.len < 1) return false;
+    uint8_t message = (frame.id >> 4) & 0x03;
+    uint8_t node = frame.id & 0x0F;
+
+    switch (message) {
+        case CAN_NODE_MSG_HEARTBEAT:
+            if (frame.len < 8 || frame.data[0] != CAN_NODE_PROTOCOL_VERSION) return false;
+            handleHeartbeat(node, frame.data, frame.len, frame.rxMs);
+            return true;
+        case CAN_NODE_MSG_REQUEST:
+            if (frame.data[0] != nodeId) return false;
+            tableNext = 0;
+            return true;
+        case CAN_NODE_MSG_TABLE:
+            if (frame.len < 8 || node == nodeId) return false;
+            handleTableEntry(node, frame.data);
+            return true;
+        default:
+            if (node == nodeId) return false;
+            handleValues(node, frame.data, frame.len, frame.rxMs);
+            return true;
+    }
+}
+
+// ===== IMPORT =====
+
+#ifndef USE_STATIC_CONFIG
+static Input* findNodeInput(uint8_t node, uint8_t pin) {
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        Input* input = &inputs[i];
+        if (input->pin == 0xFF || input->calibrationType != CAL_NODE_CHANNEL ||
+            !input->flags.useCustomCalibration) continue;
+        if (input->customCalibration.node.node == node && input->customCalibration.node.remote_pin == pin) {
+            return input;
+        }
+    }
+    return nullptr;
+}
+
+static uint8_t freeNodePin() {
+    for (uint8_t k = 0; k < NODE_PINS; k++) {
+        if (getInputByPin(NODE_PIN(k)) == nullptr) return NODE_PIN(k);
+    }
+    return 0xFF;
+}
+
+// Give every channel of a complete table an input, unless one already reads it
+static void importNodeChannels(uint8_t node) {
+    uint8_t added = 0;
+    for (uint8_t i = 0; i < CAN_NODE_MAX_REMOTE; i++) {
+        const RemoteChannel& c = remote[i];
+        if (c.node != node || findNodeInput(node, c.pin)) continue;
+
+        uint8_t appIndex = getApplicationIndexByHash(c.appHash);
+        if (appIndex == 0) {
+            msg.debug.warn(TAG_CAN, "Node %d pin %d: application 0x%04X not known here - not imported",
+                           node, c.pin, c.appHash);
+            continue;
+        }
+        uint8_t pin = freeNodePin();
+        if (pin == 0xFF) {
+            msg.debug.warn(TAG_CAN, "No free NODE:n pin - node %d not fully imported", node);
+            break;
+        }
+        if (!setInputApplication(pin, appIndex)) break;  // No free input slot (printed)
+
+        Input* input = getInputByPin(pin);
+        memset(&input->customCalibration, 0, sizeof(CalibrationOverride));
+        input->customCalibration.node.node = node;
+        input->customCalibration.node.remote_pin = c.pin;
+        input->customCalibration.node.app_hash = c.appHash;
+        input->flags.useCustomCalibration = true;
+        added++;
+        msg.debug.info(TAG_CAN, "NODE:%d <- node %d pin %d (%s)", pin - NODE_PIN(0), node, c.pin,
+                       input->abbrName);
+    }
+    if (added > 0) rebuildInputSchedule();
+}
+#endif // USE_STATIC_CONFIG
+
+// ===== LOOP =====
+
+bool getCANNodeFilterRule(hal::can::CanFilterRule* rule) {
+    uint8_t id = systemConfig.buses.can_node_id;
+    if (id >= CAN_NODE_COUNT) return false;
+    rule->id = CAN_NODE_BASE_ID;
+    rule->mask = NODE_ID_MASK;
+    rule->extended = false;
+    return true;
+}
+
+void initCANNodes() {
+    unregisterCANRxHandler(handleNodeFrame);
+    nodeBus = 0xFF;
+    nodeId = systemConfig.buses.can_node_id;
+    if (nodeId >= CAN_NODE_COUNT) {
+        nodeId = CAN_NODE_OFF;
+        return;
+    }
+
+    uint8_t bus = getCANOutputBus();
+    if (bus == 0xFF) {
+        msg.debug.warn(TAG_CAN, "CAN node %d needs the CAN output bus - node disabled", nodeId);
+        return;
+    }
+    if (!registerCANRxHandler("NODE", bus, CAN_NODE_BASE_ID, NODE_ID_MASK, handleNodeFrame)) {
+        msg.debug.error(TAG_CAN, "CAN node: no free RX handler slot");
+        return;
+    }
+    noteStaticMemory(F("CAN node tables"), sizeof(channels) + sizeof(nodes) + sizeof(remote));
+    for (uint8_t i = 0; i < CAN_NODE_MAX_REMOTE; i++) remote[i].node = NO_ENTRY;
+    memset(nodes, 0, sizeof(nodes));
+
+    nodeBus = bus;
+    rebuildCANNodeTable();
+    tableNext = 0;                      // Announce at startup
+    nextHeartbeat = millis();
+    nextValues = nextHeartbeat;
+    msg.debug.info(TAG_CAN, "CAN node %d on bus %d, IDs 0x%03X-0x%03X, %d channels",
+                   nodeId, bus, CAN_NODE_BASE_ID, CAN_NODE_BASE_ID + 0x3F, channelCount);
+}
+
+void updateCANNodes() {
+    if (nodeBus == 0xFF) return;
+    uint32_t now = millis();
+
+#ifndef USE_STATIC_CONFIG
+    if (importDue) {
+        uint16_t due = importDue;
+        importDue = 0;
+        for (uint8_t n = 0; n < CAN_NODE_COUNT; n++) {
+            if (due & (1U << n)) importNodeChannels(n);
+        }
+    }
+#endif
+
+    if ((int32_t)(now - nextHeartbeat) >= 0) {
+        nextHeartbeat = now + CAN_NODE_HEARTBEAT_MS;
+        sendHeartbeat(now);
+    }
+    if (tableNext != NO_ENTRY) announceTable();
+
+    if ((int32_t)(now - nextValues) >= 0) {
+        // Advance from the previous deadline so the cadence doesn't drift; resync after a stall
+        nextValues += CAN_NODE_VALUE_MS;
+        if ((int32_t)(now - nextValues) >= 0) nextValues = now + CAN_NODE_VALUE_MS;
+        sendValues();
+    }
+}
+
+// ===== NODE SENSOR =====
+
+void readNodeChannel(Input* ptr) {
+    if (!ptr->flags.useCustomCalibration) {
+        setInputFault(ptr, FAULT_NO_CALIBRATION);
+        return;
+    }
+    const RemoteChannel* c = findRemoteChannel(ptr->customCalibration.node.node,
+                                               ptr->customCalibration.node.remote_pin);
+    if (c == nullptr) {
+        setInputFault(ptr, FAULT_NO_DEVICE);   // Not announced (yet)
+        return;
+    }
+    if (c->rxMs == 0 || millis() - c->rxMs > CAN_NODE_TIMEOUT_MS || isnan(c->value)) {
+        setInputFault(ptr, FAULT_STALE);
+        return;
+    }
+    ptr->value = c->value;
+}
+
+// ===== STATUS =====
+
+void printCANNodeStatus() {
+    uint32_t now = millis();
+    msg.control.println();
+    msg.control.println(F("=== CAN Nodes ==="));
+    msg.control.print(F("This unit:  "));
+    if (systemConfig.buses.can_node_id >= CAN_NODE_COUNT) {
+        msg.control.println(F("not a node (BUS CAN NODE ID <0-15>)"));
+    } else if (nodeBus == 0xFF) {
+        msg.control.print(F("node "));
+        msg.control.print(systemConfig.buses.can_node_id);
+        msg.control.println(F(", not running (needs the CAN output bus)"));
+    } else {
+        char line[72];
+        snprintf(line, sizeof(line), "node %d, %d channels in %d frames, table CRC 0x%04X",
+                 nodeId, channelCount, frameCount, tableCrc);
+        msg.control.println(line);
+    }
+    if (conflicts > 0) {
+        msg.control.print(F("Conflicts:  "));
+        msg.control.print(conflicts);
+        msg.control.println(F(" heartbeats from another unit with this node number"));
+    }
+
+    bool any = false;
+    for (uint8_t node = 0; node < CAN_NODE_COUNT; node++) {
+        const RemoteNode& n = nodes[node];
+        bool subscribed = isSubscribed(node);
+        if (n.lastSeen == 0 && !subscribed) continue;
+        any = true;
+
+        uint8_t held = 0;
+        uint8_t imported = 0;
+        for (uint8_t i = 0; i < CAN_NODE_MAX_REMOTE; i++) {
+            if (remote[i].node != node) continue;
+            held++;
+#ifndef USE_STATIC_CONFIG
+            if (findNodeInput(node, remote[i].pin)) imported++;
+#endif
+        }
+
+        msg.control.print(F("Node "));
+        msg.control.print(node);
+        msg.control.print(F(": "));
+        if (n.lastSeen == 0) {
+            msg.control.print(F("not heard"));
+        } else {
+            msg.control.print(n.channels);
+            msg.control.print(F(" channels, up "));
+            msg.control.print(n.uptime);
+            msg.control.print(F(" s, heard "));
+            msg.control.print(now - n.lastSeen);
+            msg.control.print(isNodeAlive(n, now) ? F(" ms ago") : F(" ms ago (lost)"));
+        }
+        if (subscribed) {
+            msg.control.print(F(" - subscribed, "));
+            if (n.complete) {
+                msg.control.print(held);
+                msg.control.print(F(" held, "));
+                msg.control.print(imported);
+                msg.control.print(F(" imported"));
+            } else {
+                msg.control.print(F("table incomplete"));
+            }
+        }
+        msg.control.println();
+    }
+    if (!any) msg.control.println(F("No other nodes heard"));
+    if (remoteDropped > 0) {
+        msg.control.print(F("Dropped:    "));
+        msg.control.print(remoteDropped);
+        msg.control.println(F(" announced channels without room (CAN_NODE_MAX_REMOTE)"));
+    }
+}
+
+#else
+
+// ===== STUB IMPLEMENTATIONS (CAN NODES DISABLED) =====
+
+void readNodeChannel(Input* ptr) { setInputFault(ptr, FAULT_NO_DEVICE); }
+
+#endif // ENABLE_CAN_NODES && ENABLE_CAN
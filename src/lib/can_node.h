@@ -0,0 +1,141 @@
+/*
+ * can_node.h - preOBD node network: several units sharing inputs over CAN
+ *
+ * A large install splits across units - one in the engine bay next to the
+ * senders, one in the cockpit driving the display and the log. Each unit
+ * with a node number (BUS CAN NODE ID <0-15>) joins a small protocol on the
+ * CAN output bus, on 64 IDs of its own from CAN_NODE_BASE_ID:
+ *
+ *   ID = CAN_NODE_BASE_ID + (message << 4) + node        (11-bit)
+ *
+ *   +0x00 HEARTBEAT  every CAN_NODE_HEARTBEAT_MS - discovery
+ *                    [version, channels, table CRC lo, hi, uptime s (4, LE)]
+ *   +0x10 REQUEST    [node] - asks that node to announce its channel table
+ *   +0x20 TABLE      one frame per channel, after a REQUEST or a change
+ *                    [index, count, pin, app hash lo, hi, measurement, frame, byte]
+ *   +0x30 VALUES     every CAN_NODE_VALUE_MS, one frame per 7 bytes of signals
+ *                    [frame, signals...]
+ *
+ * A node's channels are its enabled inputs (NODE:n inputs excepted, so
+ * nothing is passed on twice), in slot order. Values use the packed
+ * layout's scaled 8/16-bit signals (outputs/packed_signal.h), so the width
+ * and scaling follow from the measurement type the table gives; a signal
+ * doesn't straddle frames. The table CRC is the low 16 bits of a CRC-32
+ * over each entry's pin, application hash, measurement and position - a
+ * heartbeat carrying a CRC other than the one a subscriber holds makes it
+ * ask again.
+ *
+ * Subscribing (BUS CAN NODE SUBSCRIBE <n>) imports a node's channels: once
+ * its table is complete, every channel without an input here gets one on
+ * the next free virtual pin NODE:0-NODE:31 (0x80-0x9F), with the remote
+ * input's application (matched by name hash) and the NODE sensor - so the
+ * display unit subscribes once instead of configuring each value. NODE:n
+ * inputs are ordinary inputs from then on (units, alarms, outputs, logging,
+ * SAVE) and name their source by node and remote pin, so a saved one finds
+ * its channel again after a reboot or a table change. A channel whose
+ * application this firmware doesn't know is not imported.
+ *
+ * A NODE:n input reads NAN: FAULT_NO_DEVICE until its channel has been
+ * announced, FAULT_STALE when no value arrived for CAN_NODE_TIMEOUT_MS or
+ * the sender had none. A heartbeat from another unit with our node number
+ * is counted as a conflict (BUS CAN NODE).
+ *
+ * Usage:
+ *   initCANNodes();              // setup(), after initCAN()
+ *   updateCANNodes();            // every loop in RUN mode
+ *   rebuildCANNodeTable();       // on every schedule rebuild
+ *
+ * Build Flags:
+ *   -D ENABLE_CAN_NODES          - Compile the node protocol (needs ENABLE_CAN)
+ *   -D CAN_NODE_BASE_ID=0x...    - First of the 64 node IDs, a multiple of 0x40 (default 0x6C0)
+ *   -D CAN_NODE_HEARTBEAT_MS=n   - Heartbeat interval (default 1000)
+ *   -D CAN_NODE_VALUE_MS=n       - Value broadcast interval, and NODE sensor read interval (default 100)
+ *   -D CAN_NODE_TIMEOUT_MS=n     - Silence after which a node is lost and its values stale (default 3000)
+ *   -D CAN_NODE_MAX_REMOTE=n     - Channels held from subscribed nodes (default 8 on AVR, 32 elsewhere)
+ */
+
+#ifndef CAN_NODE_H
+#define CAN_NODE_H
+
+#include <Arduino.h>
+
+// Virtual pin of imported channel n (NODE:n)
+#define NODE_PIN(n)         (0x80 + (n))
+#define NODE_PINS           32
+
+#define NODE_IS_PIN(pin)    ((pin) >= 0x80 && (pin) < 0x80 + NODE_PINS)
+
+// Also the read interval of the NODE sensor
+#ifndef CAN_NODE_VALUE_MS
+#define CAN_NODE_VALUE_MS 100
+#endif
+
+#define CAN_NODE_COUNT 16
+#define CAN_NODE_OFF   0xFF         // systemConfig.buses.can_node_id: not a node
+
+#include "../hal/hal_can_filter.h"
+
+#if defined(ENABLE_CAN_NODES) && defined(ENABLE_CAN)
+
+#ifndef CAN_NODE_BASE_ID
+#define CAN_NODE_BASE_ID 0x6C0
+#endif
+
+#ifndef CAN_NODE_HEARTBEAT_MS
+#define CAN_NODE_HEARTBEAT_MS 1000
+#endif
+
+#ifndef CAN_NODE_TIMEOUT_MS
+#define CAN_NODE_TIMEOUT_MS 3000
+#endif
+
+#ifndef CAN_NODE_MAX_REMOTE
+  #if defined(__AVR__)
+    #define CAN_NODE_MAX_REMOTE 8
+  #else
+    #define CAN_NODE_MAX_REMOTE 32
+  #endif
+#endif
+
+#define CAN_NODE_PROTOCOL_VERSION 1
+
+enum CanNodeMessage : uint8_t {
+    CAN_NODE_MSG_HEARTBEAT = 0,
+    CAN_NODE_MSG_REQUEST = 1,
+    CAN_NODE_MSG_TABLE = 2,
+    CAN_NODE_MSG_VALUES = 3
+};
+
+#define CAN_NODE_ID(message, node) (CAN_NODE_BASE_ID + ((message) << 4) + (node))
+
+// Join the protocol on the CAN output bus (node number set and output running)
+void initCANNodes();
+
+// Heartbeat, table announcements, value broadcasts and NODE:n imports
+void updateCANNodes();
+
+// Rebuild the channel table from the inputs, and give NODE:n inputs the
+// measurement type of their applications
+void rebuildCANNodeTable();
+
+// Acceptance filter rule for the node IDs - false if this unit is not a node
+bool getCANNodeFilterRule(hal::can::CanFilterRule* rule);
+
+// Own node, channels, discovered nodes and imports (BUS CAN NODE)
+void printCANNodeStatus();
+
+#else
+
+inline void initCANNodes() {}
+inline void updateCANNodes() {}
+inline void rebuildCANNodeTable() {}
+inline bool getCANNodeFilterRule(hal::can::CanFilterRule*) { return false; }
+inline void printCANNodeStatus() {}
+
+#endif // ENABLE_CAN_NODES && ENABLE_CAN
+
+// Sensor read function of NODE:n inputs
+struct Input;
+void readNodeChannel(Input* ptr);
+
+#endif // CAN_NODE_H
@@ -0,0 +1,542 @@
+/*
+ * can_replay.cpp - CAN log replay implementation
+ */
+
+#include "can_replay.h"
+
+#if defined(ENABLE_CAN_REPLAY) && defined(ENABLE_CAN)
+
+#include "../config.h"
+#include "../hal/hal_can.h"
+#include "message_api.h"
+#include "bus_config.h"
+#include "bus_manager.h"    // For getCANBusName()
+#include "system_config.h"
+#include "can_rx.h"
+#include "sd_manager.h"
+#include "../inputs/input_can.h"
+#include "../inputs/sensors/can/can_frame_cache.h"
+#include <string.h>
+#include <ctype.h>
+#include <stdlib.h>
+
+#if defined(ENABLE_SD_LOGGING) || defined(ENABLE_JSON_CONFIG)
+  #include <SD.h>
+  #define CAN_REPLAY_HAS_SD 1
+#endif
+
+enum ReplayLine : uint8_t {
+    LINE_FRAME,     // A frame to replay
+    LINE_SKIP,      // Header, comment, error or remote frame
+    LINE_BAD        // Looked like a frame but didn't parse
+};
+
+struct ReplayState {
+    bool active;
+    bool streaming;
+    bool loop;
+    bool havePending;       // pending is read and waits for its time
+    bool haveTime0;         // time0Us holds the first timestamp of this pass
+    uint8_t rxBus;
+    uint8_t txBus;
+    uint16_t speedPct;
+    uint64_t time0Us;       // Log time of the first frame of this pass
+    uint64_t lastTimeUs;    // Log time of the last frame (for frames without one)
+    uint64_t clockUs;       // Replay clock since the start of this pass
+    uint32_t lastMicros;
+    uint32_t startMs;
+    uint32_t stopMs;
+    uint64_t pendingUs;     // Due time of pending on the replay clock
+    hal::can::CanRxFrame pending;
+
+    uint32_t frames;        // Handed to the receive path or the driver
+    uint32_t skipped;       // Lines that aren't frames
+    uint32_t bad;           // Frame lines that didn't parse (or too long)
+    uint32_t late;
+    uint32_t maxLateUs;
+    uint32_t txRefused;     // Driver full: retried (file) or dropped (stream)
+    uint16_t passes;        // Times through the file (LOOP)
+
+    // Counters at the start, for the "since the start" report
+    CANCacheStats cacheBase;
+    uint32_t routeFrames[CAN_RX_MAX_HANDLERS];
+    uint32_t routeDrops[CAN_RX_MAX_HANDLERS];
+
+    char line[CAN_REPLAY_LINE_MAX];
+    uint8_t lineLen;
+    bool lineTooLong;
+    char name[24];
+};
+
+static ReplayState replay;
+
+#ifdef CAN_REPLAY_HAS_SD
+static File replayFile;
+#endif
+
+// ===== LINE PARSING =====
+
+// Next space-separated token of *p, NUL-terminated in place (nullptr at the end)
+static char* nextToken(char** p) {
+    char* s = *p;
+    while (*s == ' ' || *s == '\t') s++;
+    if (*s == '\0') return nullptr;
+    char* tok = s;
+    while (*s != '\0' && *s != ' ' && *s != '\t') s++;
+    if (*s != '\0') *s++ = '\0';
+    *p = s;
+    return tok;
+}
+
+static int8_t hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    c = toupper(c);
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Hex number of up to 8 digits; returns digits read (0 = not hex)
+static uint8_t parseHexId(const char* s, uint32_t* value) {
+    uint8_t digits = 0;
+    *value = 0;
+    for (; digits < 8 && hexDigit(s[digits]) >= 0; digits++) {
+        *value = (*value << 4) | hexDigit(s[digits]);
+    }
+    return digits;
+}
+
+// Hex byte pairs, '.' separators allowed (candump -l); returns bytes or -1
+static int16_t parseHexBytes(const char* s, uint8_t* data) {
+    uint8_t len = 0;
+    while (*s) {
+        if (*s == '.') { s++; continue; }
+        int8_t hi = hexDigit(s[0]);
+        int8_t lo = hi >= 0 ? hexDigit(s[1]) : -1;
+        if (lo < 0 || len >= HAL_CAN_MAX_DLEN) return -1;
+        data[len++] = (hi << 4) | lo;
+        s += 2;
+    }
+    return len;
+}
+
+// Decimal seconds ("1436509052.249713", "0.012345") to us
+static bool parseSeconds(const char* s, uint64_t* us) {
+    if (!isdigit(*s)) return false;
+    char* end;
+    uint64_t sec = strtoul(s, &end, 10);
+    uint32_t frac = 0;
+    uint8_t digits = 0;
+    if (*end == '.') {
+        for (end++; isdigit(*end); end++) {
+            if (digits < 6) { frac = frac * 10 + (*end - '0'); digits++; }
+        }
+    }
+    for (; digits < 6; digits++) frac *= 10;
+    *us = sec * 1000000ULL + frac;
+    return *end == '\0' || *end == ')';
+}
+
+static void setId(hal::can::CanRxFrame* frame, uint32_t id, uint8_t digits) {
+    frame->id = id;
+    frame->extended = digits > 3 || id > 0x7FF;
+}
+
+// candump -l: ID#DATA, ID#R (remote), ID##<flags>DATA (CAN FD)
+static ReplayLine parseCompact(char* tok, hal::can::CanRxFrame* frame) {
+    char* hash = strchr(tok, '#');
+    *hash = '\0';
+    uint32_t id;
+    uint8_t digits = parseHexId(tok, &id);
+    if (digits == 0 || tok[digits] != '\0') return LINE_BAD;
+    setId(frame, id, digits);
+
+    const char* data = hash + 1;
+    if (toupper(*data) == 'R') return LINE_SKIP;  // Remote frame - no payload to cache
+    frame->fd = *data == '#';
+    if (frame->fd) {
+        if (hexDigit(data[1]) < 0) return LINE_BAD;
+        data += 2;  // Flags nibble (BRS/ESI)
+    }
+    int16_t len = parseHexBytes(data, frame->data);
+    if (len < 0 || (!frame->fd && len > 8)) return LINE_BAD;
+    frame->len = len;
+    return LINE_FRAME;
+}
+
+// candump: ID [len] bytes...
+static ReplayLine parseSpaced(char* idTok, char** p, hal::can::CanRxFrame* frame) {
+    uint32_t id;
+    uint8_t digits = parseHexId(idTok, &id);
+    if (digits == 0 || idTok[digits] != '\0') return LINE_BAD;
+    setId(frame, id, digits);
+
+    char* lenTok = nextToken(p);
+    if (lenTok == nullptr || lenTok[0] != '[') return LINE_BAD;
+    int len = atoi(lenTok + 1);
+    if (len < 0 || len > HAL_CAN_MAX_DLEN) return LINE_BAD;
+    if (strstr(*p, "remote")) return LINE_SKIP;
+
+    frame->fd = len > 8;
+    for (int i = 0; i < len; i++) {
+        char* b = nextToken(p);
+        if (b == nullptr || hexDigit(b[0]) < 0 || hexDigit(b[1]) < 0) return LINE_BAD;
+        frame->data[i] = (hexDigit(b[0]) << 4) | hexDigit(b[1]);
+    }
+    frame->len = len;
+    return LINE_FRAME;
+}
+
+// Vector ASC after the timestamp: channel ID[x] Rx|Tx d dlc bytes...
+static ReplayLine parseAsc(char** p, hal::can::CanRxFrame* frame) {
+    char* channel = nextToken(p);
+    if (channel == nullptr || !isdigit(channel[0])) return LINE_SKIP;  // Start of measurement, events
+    char* idTok = nextToken(p);
+    if (idTok == nullptr) return LINE_SKIP;
+    uint32_t id;
+    uint8_t digits = parseHexId(idTok, &id);
+    bool extended = digits > 0 && toupper(idTok[digits]) == 'X';
+    if (digits == 0 || idTok[digits + extended] != '\0') return LINE_SKIP;  // ErrorFrame, statistics
+
+    char* dir = nextToken(p);
+    char* type = nextToken(p);
+    if (dir == nullptr || type == nullptr) return LINE_BAD;
+    if (strcasecmp(dir, "Rx") != 0 && strcasecmp(dir, "Tx") != 0) return LINE_SKIP;
+    if (strcasecmp(type, "r") == 0) return LINE_SKIP;  // Remote frame
+    if (strcasecmp(type, "d") != 0) return LINE_BAD;
+
+    char* dlcTok = nextToken(p);
+    if (dlcTok == nullptr) return LINE_BAD;
+    int len = atoi(dlcTok);
+    if (len < 0 || len > 8) return LINE_BAD;
+    for (int i = 0; i < len; i++) {
+        char* b = nextToken(p);
+        if (b == nullptr || hexDigit(b[0]) < 0 || hexDigit(b[1]) < 0) return LINE_BAD;
+        frame->data[i] = (hexDigit(b[0]) << 4) | hexDigit(b[1]);
+    }
+    frame->id = id;
+    frame->extended = extended;
+    frame->fd = false;
+    frame->len = len;
+    return LINE_FRAME;
+}
+
+/**
+ * One log line (modified in place)
+ * @param timeUs   Log time of the frame, if the line has one
+ * @param hasTime  Set when it does
+ */
+static ReplayLine parseLine(char* line, hal::can::CanRxFrame* frame, uint64_t* timeUs, bool* hasTime) {
+    char* p = line;
+    char* tok = nextToken(&p);
+    *hasTime = false;
+    if (tok == nullptr || tok[0] == '/' || tok[0] == ';') return LINE_SKIP;
+
+    if (tok[0] == '(') {                    // candump, with timestamp
+        if (!parseSeconds(tok + 1, timeUs)) return LINE_BAD;
+        *hasTime = true;
+        tok = nextToken(&p);                // Interface
+        if (tok == nullptr) return LINE_BAD;
+    } else if (isdigit(tok[0]) && strchr(tok, '.')) {
+        if (!parseSeconds(tok, timeUs)) return LINE_SKIP;
+        *hasTime = true;
+        return parseAsc(&p, frame);
+    } else if (!isalpha(tok[0])) {
+        return LINE_SKIP;
+    }
+
+    // tok is the interface (can0, vcan1, any) - or an ASC header word
+    char* frameTok = nextToken(&p);
+    if (frameTok == nullptr) return *hasTime ? LINE_BAD : LINE_SKIP;
+    if (strchr(frameTok, '#')) return parseCompact(frameTok, frame);
+    if (hexDigit(frameTok[0]) < 0 || strchr(p, '[') == nullptr) {
+        return *hasTime ? LINE_BAD : LINE_SKIP;  // date, base hex, Begin Triggerblock...
+    }
+    return parseSpaced(frameTok, &p, frame);
+}
+
+// ===== REPLAY =====
+
+static void snapshotCounters() {
+    replay.cacheBase = canCacheStats;
+    for (uint8_t i = 0; i < CAN_RX_MAX_HANDLERS; i++) {
+        CANRxHandlerStats s;
+        bool ok = getCANRxHandlerStats(i, &s);
+        replay.routeFrames[i] = ok ? s.frames : 0;
+        replay.routeDrops[i] = ok ? s.drops : 0;
+    }
+}
+
+#ifdef CAN_REPLAY_HAS_SD
+// Next line of the file into replay.line; false at the end
+static bool readFileLine() {
+    replay.lineLen = 0;
+    replay.lineTooLong = false;
+    bool any = false;
+    while (replayFile.available()) {
+        int c = replayFile.read();
+        any = true;
+        if (c == '\n') break;
+        if (c == '\r') continue;
+        if (replay.lineLen < sizeof(replay.line) - 1) {
+            replay.line[replay.lineLen++] = (char)c;
+        } else {
+            replay.lineTooLong = true;
+        }
+    }
+    replay.line[replay.lineLen] = '\0';
+    return any;
+}
+#endif
+
+// Hand a frame over; false if the driver refused it
+static bool deliver(hal::can::CanRxFrame& frame) {
+    frame.rxMs = millis();
+    frame.rxUs = hal::micros64();
+    if (replay.txBus != CAN_REPLAY_INJECT) {
+        if (!hal::can::write(frame.id, frame.data, frame.len, frame.extended, replay.txBus)) {
+            replay.txRefused++;
+            return false;
+        }
+    } else {
+        injectCANRxFrame(replay.rxBus, frame);
+    }
+    replay.frames++;
+    return true;
+}
+
+// Parse replay.line into pending; false if it holds no frame
+static bool takeLine() {
+    uint64_t timeUs = 0;
+    bool hasTime;
+    ReplayLine kind = replay.lineTooLong ? LINE_BAD : parseLine(replay.line, &replay.pending, &timeUs, &hasTime);
+    if (kind == LINE_SKIP) {
+        replay.skipped++;
+        return false;
+    }
+    if (kind == LINE_BAD) {
+        replay.bad++;
+        return false;
+    }
+
+    if (!hasTime) timeUs = replay.lastTimeUs;
+    if (!replay.haveTime0) {
+        replay.time0Us = timeUs;
+        replay.haveTime0 = true;
+    }
+    replay.lastTimeUs = timeUs;
+    uint64_t offset = timeUs >= replay.time0Us ? timeUs - replay.time0Us : 0;
+    replay.pendingUs = replay.speedPct ? offset * 100 / replay.speedPct : 0;
+    return true;
+}
+
+static void printSummaryLine() {
+    uint32_t ms = (replay.active ? millis() : replay.stopMs) - replay.startMs;
+    msg.control.print(F("Frames: "));
+    msg.control.print(replay.frames);
+    msg.control.print(F(" in "));
+    msg.control.print(ms);
+    msg.control.print(F(" ms ("));
+    msg.control.print(ms ? (uint32_t)((uint64_t)replay.frames * 1000 / ms) : 0);
+    msg.control.print(F(" frames/s), "));
+    msg.control.print(replay.late);
+    msg.control.print(F(" late (max "));
+    msg.control.print(replay.maxLateUs / 1000);
+    msg.control.print(F(" ms), "));
+    msg.control.print(replay.bad);
+    msg.control.print(F(" bad lines, "));
+    msg.control.print(replay.skipped);
+    msg.control.println(F(" skipped"));
+    if (replay.txBus != CAN_REPLAY_INJECT) {
+        msg.control.print(F("TX "));
+        msg.control.print(getCANBusName(replay.txBus));
+        msg.control.print(F(": "));
+        msg.control.print(replay.txRefused);
+        msg.control.println(replay.streaming ? F(" dropped (driver full)") : F(" driver full (retried)"));
+    }
+}
+
+void printCANReplayStatus() {
+    msg.control.println();
+    msg.control.print(F("=== CAN Replay: "));
+    if (!replay.active && replay.startMs == 0) {
+        msg.control.println(F("none ==="));
+        msg.control.println(F("  SCAN REPLAY <file>|STREAM [SPEED <x>|MAX] [TX <CAN1|CAN2|CAN3>] [LOOP]"));
+        return;
+    }
+    msg.control.print(replay.name);
+    msg.control.print(replay.active ? F(", running") : F(", finished"));
+    if (!replay.streaming) {
+        msg.control.print(F(", speed "));
+        if (replay.speedPct) {
+            msg.control.print(replay.speedPct / 100.0f, 2);
+            msg.control.print('x');
+        } else {
+            msg.control.print(F("MAX"));
+        }
+    }
+    if (replay.passes > 1) {
+        msg.control.print(F(", pass "));
+        msg.control.print(replay.passes);
+    }
+    msg.control.print(replay.txBus != CAN_REPLAY_INJECT ? F(", out on ") : F(", into "));
+    msg.control.print(getCANBusName(replay.txBus != CAN_REPLAY_INJECT ? replay.txBus : replay.rxBus));
+    msg.control.println(F(" ==="));
+    printSummaryLine();
+
+    // Receive handlers of the input bus, since the start
+    for (uint8_t i = 0; i < getCANRxHandlerCount() && i < CAN_RX_MAX_HANDLERS; i++) {
+        CANRxHandlerStats s;
+        if (!getCANRxHandlerStats(i, &s) || s.bus != replay.rxBus) continue;
+        msg.control.print(F("RX "));
+        msg.control.print(s.name);
+        msg.control.print(F(": "));
+        msg.control.print(s.frames - replay.routeFrames[i]);
+        msg.control.print(F(" frames, "));
+        msg.control.print(s.drops - replay.routeDrops[i]);
+        msg.control.println(F(" dropped (not subscribed or not used)"));
+    }
+    printCANCacheStats(&replay.cacheBase);
+    msg.control.println();
+}
+
+static void finish() {
+    replay.active = false;
+    replay.stopMs = millis();
+#ifdef CAN_REPLAY_HAS_SD
+    if (replayFile) replayFile.close();
+#endif
+    printCANReplayStatus();
+}
+
+bool startCANReplay(const char* filename, uint16_t speedPct, uint8_t txBus, bool loop) {
+    if (replay.active) {
+        replay.active = false;
+#ifdef CAN_REPLAY_HAS_SD
+        if (replayFile) replayFile.close();
+#endif
+    }
+
+    uint8_t rxBus = systemConfig.buses.input_can_bus;
+    if (txBus == CAN_REPLAY_INJECT &&
+        (systemConfig.buses.can_input_mode == CAN_INPUT_OFF || rxBus == 0xFF)) {
+        msg.control.println(F("ERROR: CAN input not enabled - nothing to replay into"));
+        msg.control.println(F("  Use 'BUS CAN INPUT CAN1 ENABLE', or TX <bus> to send the log out"));
+        return false;
+    }
+    if (txBus != CAN_REPLAY_INJECT && txBus != systemConfig.buses.output_can_bus &&
+        txBus != systemConfig.buses.can_mirror_bus && txBus != rxBus) {
+        msg.control.print(F("ERROR: "));
+        msg.control.print(getCANBusName(txBus));
+        msg.control.println(F(" is not started (configure it as CAN input, output or mirror)"));
+        return false;
+    }
+
+    memset(&replay, 0, sizeof(replay));
+    if (filename) {
+#ifdef CAN_REPLAY_HAS_SD
+        if (!isSDInitialized()) {
+            msg.control.println(F("ERROR: SD card not available"));
+            return false;
+        }
+        replayFile = SD.open(filename, FILE_READ);
+        if (!replayFile) {
+            msg.control.print(F("ERROR: Cannot open "));
+            msg.control.println(filename);
+            return false;
+        }
+        strncpy(replay.name, filename, sizeof(replay.name) - 1);
+#else
+        msg.control.println(F("ERROR: No SD support in this build - use SCAN REPLAY STREAM"));
+        return false;
+#endif
+    } else {
+        replay.streaming = true;
+        strncpy(replay.name, "STREAM", sizeof(replay.name) - 1);
+    }
+
+    replay.rxBus = rxBus;
+    replay.txBus = txBus;
+    replay.speedPct = speedPct;
+    replay.loop = loop && !replay.streaming;
+    replay.passes = 1;
+    replay.startMs = millis();
+    if (replay.startMs == 0) replay.startMs = 1;  // 0 = never started
+    replay.lastMicros = micros();
+    snapshotCounters();
+    replay.active = true;
+    return true;
+}
+
+void stopCANReplay() {
+    if (replay.active) finish();
+}
+
+bool isCANReplayActive() { return replay.active; }
+bool isCANReplayStreaming() { return replay.active && replay.streaming; }
+
+void updateCANReplay() {
+    if (!replay.active || replay.streaming) return;
+#ifdef CAN_REPLAY_HAS_SD
+    uint32_t nowUs = micros();
+    replay.clockUs += (uint32_t)(nowUs - replay.lastMicros);
+    replay.lastMicros = nowUs;
+
+    for (uint16_t n = 0; n < CAN_RX_FRAME_BUDGET; n++) {
+        if ((uint32_t)(micros() - nowUs) >= CAN_RX_TIME_BUDGET_US) return;
+
+        while (!replay.havePending) {
+            if (!readFileLine()) {
+                if (!replay.loop) {
+                    finish();
+                    return;
+                }
+                replayFile.seek(0);  // Next pass: the log's timeline starts over
+                replay.passes++;
+                replay.haveTime0 = false;
+                replay.clockUs = 0;
+                return;
+            }
+            replay.havePending = takeLine();
+        }
+
+        if (replay.speedPct && replay.pendingUs > replay.clockUs) return;  // Not due yet
+        if (replay.speedPct) {
+            uint64_t lateUs = replay.clockUs - replay.pendingUs;
+            if (lateUs > CAN_REPLAY_LATE_US) {
+                replay.late++;
+                if (lateUs > replay.maxLateUs) replay.maxLateUs = lateUs > 0xFFFFFFFFULL ? 0xFFFFFFFFUL : (uint32_t)lateUs;
+            }
+        }
+        if (!deliver(replay.pending)) return;  // Driver full - same frame next pass
+        replay.havePending = false;
+    }
+#endif
+}
+
+bool feedCANReplayStream(const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len && replay.active; i++) {
+        char c = (char)data[i];
+        if (c != '\n' && c != '\r') {
+            if (replay.lineLen < sizeof(replay.line) - 1) {
+                replay.line[replay.lineLen++] = c;
+            } else {
+                replay.lineTooLong = true;
+            }
+            continue;
+        }
+        if (replay.lineLen == 0 && !replay.lineTooLong) continue;
+
+        replay.line[replay.lineLen] = '\0';
+        if (strcasecmp(replay.line, "END") == 0) {
+            replay.lineLen = 0;
+            finish();
+            break;
+        }
+        if (takeLine()) deliver(replay.pending);  // Host-paced: straight through
+        replay.lineLen = 0;
+        replay.lineTooLong = false;
+    }
+    return replay.active && replay.lineLen > 0;
+}
+
+#endif // ENABLE_CAN_REPLAY && ENABLE_CAN
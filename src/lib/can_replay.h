@@ -0,0 +1,103 @@
+/*
+ * can_replay.h - CAN log replay into the receive path (SCAN REPLAY)
+ *
+ * Opt-in (-D ENABLE_CAN_REPLAY) load test of the CAN input path. Test mode
+ * overrides input values; this feeds the frames themselves - a recorded log
+ * of the vehicle - through the CAN receive pump, so the input handler, the
+ * OBD-II responder, the frame cache and the subscriptions see the traffic
+ * they will see on that vehicle:
+ *
+ *   SCAN REPLAY drive.log                   // From SD, at the recorded timing
+ *   SCAN REPLAY drive.asc SPEED 4           // Four times as fast
+ *   SCAN REPLAY drive.log SPEED MAX TX CAN2 // Out on a bus as fast as it takes them
+ *   SCAN REPLAY STREAM                      // Lines from the serial console (tools/can_replay.py)
+ *
+ * Formats (detected per line):
+ *   candump -l     (1436509052.249713) can0 123#DEADBEEF   (## for CAN FD)
+ *   candump        (1436509052.249713)  can0  123   [4]  DE AD BE EF
+ *                  (the timestamp is optional; frames without one go out
+ *                  as soon as they are read)
+ *   Vector ASC     0.012345 1  123             Rx   d 4 DE AD BE EF
+ *                  ("base hex"; extended IDs end in x)
+ * Header, comment, error and remote frame lines are skipped.
+ *
+ * Frames are injected on the CAN input bus (injectCANRxFrame(), counted
+ * as received), at most CAN_RX_FRAME_BUDGET per loop pass like the real
+ * pump. With TX <bus> they go out on that bus instead, through the driver
+ * rather than the transmit queue; wire it to the input bus to test the
+ * controller and filters too. A frame the driver refuses is retried next
+ * pass, so SPEED MAX runs at the bus's line rate. Frames handed over more
+ * than CAN_REPLAY_LATE_US after their time count as late - the loop could
+ * not keep up at that speed.
+ *
+ * STREAM takes candump or ASC lines from the console the command came
+ * from instead of a file, one frame per line as it arrives - the host sets
+ * the pace - until a line END. Nothing else is read as a command meanwhile.
+ *
+ * SCAN REPLAY STATUS (and the end of a replay) reports frames replayed,
+ * late and refused, and since the start: frames each receive handler
+ * dropped (IDs no input subscribes to - what acceptance filters would
+ * keep off the CPU) and the frame cache counters (updates, new slots,
+ * evictions, refused frames, lookups) - the figures for sizing
+ * CAN_CACHE_SIZE and the filters before going to a new vehicle.
+ *
+ * Replay runs in RUN mode; CONFIG mode stops it.
+ *
+ * Build Flags:
+ *   -D ENABLE_CAN_REPLAY         - Compile the replay engine and SCAN REPLAY (needs ENABLE_CAN)
+ *   -D CAN_REPLAY_LINE_MAX=n     - Longest log line (default 160; 80 on AVR)
+ *   -D CAN_REPLAY_LATE_US=n      - Behind schedule by more counts as late (default 2000)
+ */
+
+#ifndef CAN_REPLAY_H
+#define CAN_REPLAY_H
+
+#include <Arduino.h>
+
+#ifndef CAN_REPLAY_LINE_MAX
+  #if defined(__AVR__)
+    #define CAN_REPLAY_LINE_MAX 80
+  #else
+    #define CAN_REPLAY_LINE_MAX 160
+  #endif
+#endif
+
+#ifndef CAN_REPLAY_LATE_US
+#define CAN_REPLAY_LATE_US 2000
+#endif
+
+#define CAN_REPLAY_INJECT 0xFF      // txBus: into the receive path, not out on a bus
+
+#if defined(ENABLE_CAN_REPLAY) && defined(ENABLE_CAN)
+
+/**
+ * Start a replay (stops one running)
+ * @param filename  Log on SD, nullptr = STREAM from the control console
+ * @param speedPct  Playback speed in percent of the recorded timing, 0 = as fast as possible
+ * @param txBus     Bus to transmit on, CAN_REPLAY_INJECT = the input bus's receive path
+ * @param loop      Start the file over at its end
+ * @return          false (with the reason printed) if it can't start
+ */
+bool startCANReplay(const char* filename, uint16_t speedPct, uint8_t txBus, bool loop);
+
+// Stop and print the summary
+void stopCANReplay();
+
+bool isCANReplayActive();
+bool isCANReplayStreaming();
+
+// Hand the due frames over (main loop, RUN mode, before pumpCANRx())
+void updateCANReplay();
+
+/**
+ * Console bytes while streaming (serial_config.cpp, before the CLI sees them)
+ * @return  true if a partial line is held
+ */
+bool feedCANReplayStream(const uint8_t* data, size_t len);
+
+// Progress and the receive / frame cache counters since the start
+void printCANReplayStatus();
+
+#endif // ENABLE_CAN_REPLAY && ENABLE_CAN
+
+#endif // CAN_REPLAY_H
@@ -0,0 +1,228 @@
+/*
+ * can_rx.cpp - Per-bus CAN receive pump
+ */
+
+#include "can_rx.h"
+#include "../hal/hal_can.h"
+#include "message_router.h"  // For msg.control
+#include "message_api.h"
+#include "watchdog.h"
+#include "raw_trace.h"
+
+struct CANRxRoute {
+    const char* name;
+    CANRxHandler handler;
+    uint32_t id;
+    uint32_t mask;
+    uint32_t frames;
+    uint32_t drops;
+    uint16_t maxBurst;
+    uint16_t burst;       // Frames delivered in the current pass
+    uint8_t bus;
+};
+
+static CANRxRoute routes[CAN_RX_MAX_HANDLERS];
+static uint8_t numRoutes = 0;
+static CANRxBusStats busStats[CAN_RX_MAX_BUSES];
+
+// Load window - counts since windowStart, folded into the rates
+static uint32_t windowFrames[CAN_RX_MAX_BUSES];
+static uint32_t windowBytes[CAN_RX_MAX_BUSES];
+static uint32_t windowStart = 0;
+
+// Frames read by the pump are its heartbeat (TASK_WATCHDOG_CAN_MS > 0)
+static uint8_t watchId = TASK_WATCH_NONE;
+
+bool registerCANRxHandler(const char* name, uint8_t bus, uint32_t id, uint32_t mask, CANRxHandler handler) {
+    if (handler == nullptr || bus >= CAN_RX_MAX_BUSES) return false;
+
+    for (uint8_t i = 0; i < numRoutes; i++) {
+        CANRxRoute* r = &routes[i];
+        if (r->handler == handler && r->bus == bus && r->id == (id & mask) && r->mask == mask) {
+            r->name = name;  // Already routed (subsystem re-initialized)
+            return true;
+        }
+    }
+    if (numRoutes >= CAN_RX_MAX_HANDLERS) return false;
+
+#if defined(ENABLE_TASK_WATCHDOG) && TASK_WATCHDOG_CAN_MS > 0
+    if (numRoutes == 0) watchId = watchdogRegisterTask("CAN_RX", TASK_WATCHDOG_CAN_MS);
+#endif
+
+    CANRxRoute* r = &routes[numRoutes++];
+    r->name = name;
+    r->handler = handler;
+    r->id = id & mask;
+    r->mask = mask;
+    r->frames = 0;
+    r->drops = 0;
+    r->maxBurst = 0;
+    r->burst = 0;
+    r->bus = bus;
+    return true;
+}
+
+void unregisterCANRxHandler(CANRxHandler handler) {
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < numRoutes; i++) {
+        if (routes[i].handler != handler) {
+            routes[kept++] = routes[i];
+        }
+    }
+    numRoutes = kept;
+}
+
+// Count one frame on a bus and hand it to every matching route
+static void deliverFrame(uint8_t bus, const hal::can::CanRxFrame& frame) {
+    busStats[bus].frames++;
+    windowFrames[bus]++;
+    windowBytes[bus] += frame.len;
+
+    bool claimed = false;
+    for (uint8_t i = 0; i < numRoutes; i++) {
+        CANRxRoute* r = &routes[i];
+        if (r->bus != bus || (frame.id & r->mask) != r->id) continue;
+
+        claimed = true;
+        r->frames++;
+        r->burst++;
+        if (!r->handler(frame)) {
+            r->drops++;
+        }
+    }
+    if (!claimed) busStats[bus].unclaimed++;
+}
+
+// Read one bus until it is empty or a budget runs out, delivering each frame
+// to every matching route. Returns false if the budget cut the pass short.
+static bool pumpBus(uint8_t bus, uint32_t startUs) {
+    hal::can::CanRxFrame frame;
+
+    for (uint16_t n = 0; ; n++) {
+        if (n >= CAN_RX_FRAME_BUDGET || (uint32_t)(micros() - startUs) >= CAN_RX_TIME_BUDGET_US) {
+            busStats[bus].deferred++;  // Rest stays in the driver for the next pass
+            return false;
+        }
+        if (!hal::can::readFrame(frame, bus)) {
+            return true;
+        }
+        if (n == 0) watchdogHeartbeat(watchId);
+        RAW_TRACE_CAN(bus, frame);
+        deliverFrame(bus, frame);
+    }
+}
+
+void injectCANRxFrame(uint8_t bus, const hal::can::CanRxFrame& frame) {
+    if (bus >= CAN_RX_MAX_BUSES) return;
+    busStats[bus].injected++;
+    deliverFrame(bus, frame);
+}
+
+// Fold the window counts into per-second rates
+static void updateLoad(uint32_t now) {
+    uint32_t elapsed = now - windowStart;
+    if (elapsed < CAN_RX_LOAD_WINDOW_MS) return;
+
+    for (uint8_t bus = 0; bus < CAN_RX_MAX_BUSES; bus++) {
+        uint32_t fps = windowFrames[bus] * 1000UL / elapsed;
+        busStats[bus].framesPerSec = fps > 0xFFFF ? 0xFFFF : (uint16_t)fps;
+        busStats[bus].bytesPerSec = windowBytes[bus] * 1000UL / elapsed;
+        windowFrames[bus] = 0;
+        windowBytes[bus] = 0;
+    }
+    windowStart = now;
+}
+
+void pumpCANRx() {
+    uint32_t startUs = micros();
+
+    // Each bus once, however many handlers listen on it. The time budget is
+    // shared, so the bus served first rotates to keep a flooded bus from
+    // always starving the ones after it.
+    static uint8_t firstRoute = 0;
+    if (firstRoute >= numRoutes) firstRoute = 0;
+
+    uint8_t pumped = 0;  // Bitmask of buses already read this pass
+    for (uint8_t k = 0; k < numRoutes; k++) {
+        uint8_t bus = routes[(firstRoute + k) % numRoutes].bus;
+        if (pumped & (1 << bus)) continue;
+        pumped |= (1 << bus);
+        if (!pumpBus(bus, startUs)) {
+            firstRoute = (firstRoute + k + 1) % numRoutes;  // Start after the heavy bus next time
+        }
+    }
+
+    updateLoad(millis());
+
+    for (uint8_t i = 0; i < numRoutes; i++) {
+        if (routes[i].burst > routes[i].maxBurst) routes[i].maxBurst = routes[i].burst;
+        routes[i].burst = 0;
+    }
+}
+
+uint8_t getCANRxHandlerCount() {
+    return numRoutes;
+}
+
+bool getCANRxHandlerStats(uint8_t index, CANRxHandlerStats* stats) {
+    if (index >= numRoutes || stats == nullptr) return false;
+    const CANRxRoute* r = &routes[index];
+    stats->name = r->name;
+    stats->bus = r->bus;
+    stats->frames = r->frames;
+    stats->drops = r->drops;
+    stats->maxBurst = r->maxBurst;
+    return true;
+}
+
+bool getCANRxBusStats(uint8_t bus, CANRxBusStats* stats) {
+    if (bus >= CAN_RX_MAX_BUSES || stats == nullptr) return false;
+    *stats = busStats[bus];
+    return true;
+}
+
+void printCANRxStats() {
+    if (numRoutes == 0) return;
+
+    for (uint8_t bus = 0; bus < CAN_RX_MAX_BUSES; bus++) {
+        bool used = false;
+        for (uint8_t i = 0; i < numRoutes; i++) {
+            if (routes[i].bus == bus) used = true;
+        }
+        if (!used) continue;
+
+        msg.control.print(F("RX bus "));
+        msg.control.print(bus);
+        msg.control.print(F(": "));
+        msg.control.print(busStats[bus].frames);
+        msg.control.print(F(" frames, "));
+        msg.control.print(busStats[bus].unclaimed);
+        msg.control.print(F(" unclaimed, "));
+        msg.control.print(busStats[bus].deferred);
+        msg.control.print(F(" deferred"));
+        if (busStats[bus].injected) {
+            msg.control.print(F(", "));
+            msg.control.print(busStats[bus].injected);
+            msg.control.print(F(" injected"));
+        }
+        msg.control.println();
+        msg.control.print(F("  Load: "));
+        msg.control.print(busStats[bus].framesPerSec);
+        msg.control.print(F(" frames/s, "));
+        msg.control.print(busStats[bus].bytesPerSec);
+        msg.control.println(F(" bytes/s"));
+
+        for (uint8_t i = 0; i < numRoutes; i++) {
+            const CANRxRoute* r = &routes[i];
+            if (r->bus != bus) continue;
+            msg.control.print(F("  "));
+            msg.control.print(r->name);
+            msg.control.print(F(": "));
+            msg.control.print(r->frames);
+            msg.control.print(F(" frames, "));
+            msg.control.print(r->drops);
+            msg.control.print(F(" dropped, max burst "));
+            msg.control.println(r->maxBurst);
+        }
+    }
+}
@@ -0,0 +1,113 @@
+/*
+ * can_rx.h - Per-bus CAN receive pump
+ *
+ * CAN input (frame cache), CAN output (OBD-II request responder) and SCAN
+ * may all listen on the same bus. Instead of each draining hal::can::read()
+ * itself - whichever ran first ate the other's frames - they register a
+ * handler for an ID range and one pump reads every frame once and hands it
+ * to each matching handler:
+ *
+ *   registerCANRxHandler("OBD_REQ", bus, 0x7DF, 0x7FF, handleRequest);
+ *   registerCANRxHandler("INPUT",   bus, 0,     0,     handleFrame);    // mask 0 = all IDs
+ *
+ * A frame matches when (id & mask) == (handler id & mask). Handlers run
+ * synchronously from pumpCANRx() in the main loop - the driver's RX buffer
+ * is the only queue - and return false for frames they drop (e.g. an
+ * unsubscribed PID). Each frame carries its receive time (rxMs), taken in
+ * the driver's ISR on interrupt-driven backends, so consumers can age data
+ * from when it arrived rather than from when the pump got to it. Per handler the pump counts frames delivered, frames
+ * dropped and the largest burst delivered in one pass (how deep a queue it
+ * would have needed); per bus, frames read and frames no handler claimed.
+ * injectCANRxFrame() feeds a frame through the same routes without the
+ * driver (SCAN REPLAY, lib/can_replay.h).
+ *
+ * Bounded time: each pass reads at most CAN_RX_FRAME_BUDGET frames per bus
+ * and stops once CAN_RX_TIME_BUDGET_US has elapsed, so a flooded bus (a
+ * babbling node, 1 Mbps at full load) can't hold the main loop - and the
+ * safety tasks behind it - in the drain. The remaining frames wait in the
+ * driver for the next pass; passes cut short are counted as deferrals.
+ * Frame and byte rates per bus are recomputed every CAN_RX_LOAD_WINDOW_MS.
+ * With TASK_WATCHDOG_CAN_MS set, a pass that reads frames is the pump's
+ * heartbeat to the task watchdog (lib/watchdog.h).
+ *
+ * Build Flags:
+ *   -D CAN_RX_MAX_HANDLERS=n    - Registered handlers (default 4 on AVR, 6 elsewhere)
+ *   -D CAN_RX_FRAME_BUDGET=n    - Frames per bus per pass (default 16 on AVR, 64 elsewhere)
+ *   -D CAN_RX_TIME_BUDGET_US=n  - Time per pass across all buses (default 2000)
+ */
+
+#ifndef CAN_RX_H
+#define CAN_RX_H
+
+#include <Arduino.h>
+#include "../hal/hal_can_frame.h"
+
+#ifndef CAN_RX_MAX_HANDLERS
+  #if defined(__AVR__)
+    #define CAN_RX_MAX_HANDLERS 4
+  #else
+    #define CAN_RX_MAX_HANDLERS 6
+  #endif
+#endif
+
+#ifndef CAN_RX_FRAME_BUDGET
+  #if defined(__AVR__)
+    #define CAN_RX_FRAME_BUDGET 16
+  #else
+    #define CAN_RX_FRAME_BUDGET 64
+  #endif
+#endif
+
+#ifndef CAN_RX_TIME_BUDGET_US
+#define CAN_RX_TIME_BUDGET_US 2000
+#endif
+
+#define CAN_RX_LOAD_WINDOW_MS 1000
+
+#define CAN_RX_MAX_BUSES 4
+
+// Return true if the frame was used, false if dropped
+typedef bool (*CANRxHandler)(const hal::can::CanRxFrame& frame);
+
+struct CANRxHandlerStats {
+    const char* name;
+    uint8_t bus;
+    uint32_t frames;      // Frames delivered
+    uint32_t drops;       // Delivered frames the handler dropped
+    uint16_t maxBurst;    // Most frames delivered in one pump pass
+};
+
+struct CANRxBusStats {
+    uint32_t frames;      // Frames read from the driver
+    uint32_t unclaimed;   // Frames no handler matched
+    uint32_t deferred;    // Passes cut short by the frame or time budget
+    uint32_t injected;    // ... of frames, injected by SCAN REPLAY rather than read
+    uint16_t framesPerSec;  // Load over the last CAN_RX_LOAD_WINDOW_MS
+    uint32_t bytesPerSec;   // Payload bytes over the same window
+};
+
+// Route frames on bus matching (id, mask) to handler; re-registering the same
+// handler for the same bus and range only resets its name
+// Returns false if the handler table is full
+bool registerCANRxHandler(const char* name, uint8_t bus, uint32_t id, uint32_t mask, CANRxHandler handler);
+
+// Remove every route to handler
+void unregisterCANRxHandler(CANRxHandler handler);
+
+// Read pending frames on each bus with a handler and dispatch them
+// (bounded by CAN_RX_FRAME_BUDGET / CAN_RX_TIME_BUDGET_US)
+void pumpCANRx();
+
+// Dispatch a frame that was not read from the driver (a replayed log) as
+// if it had arrived on bus - same routes and counters as a received one
+void injectCANRxFrame(uint8_t bus, const hal::can::CanRxFrame& frame);
+
+// Statistics (index < getCANRxHandlerCount(); bus < CAN_RX_MAX_BUSES)
+uint8_t getCANRxHandlerCount();
+bool getCANRxHandlerStats(uint8_t index, CANRxHandlerStats* stats);
+bool getCANRxBusStats(uint8_t bus, CANRxBusStats* stats);
+
+// Print per-bus and per-handler counters to the control port
+void printCANRxStats();
+
+#endif // CAN_RX_H
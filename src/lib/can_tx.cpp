@@ -0,0 +1,177 @@
+/*
+ * can_tx.cpp - Per-bus CAN transmit queue
+ */
+
+#include "can_tx.h"
+#include "../hal/hal_can.h"
+#include "message_router.h"  // For msg.control
+#include "message_api.h"
+#include "latency_trace.h"
+
+struct CANTxEntry {
+    uint32_t id;
+    uint16_t key;
+    uint8_t len;
+    bool extended;
+    bool live;            // false once cancelled - skipped when it reaches the head
+    uint8_t data[8];
+};
+
+// Ring of queued frames - head is the next to go out
+template <uint8_t DEPTH>
+struct CANTxRing {
+    CANTxEntry slots[DEPTH];
+    uint8_t head;
+    uint8_t count;
+
+    CANTxEntry& at(uint8_t i) { return slots[(head + i) % DEPTH]; }
+    CANTxEntry& front() { return slots[head]; }
+    void pop() { head = (head + 1) % DEPTH; count--; }
+    CANTxEntry& push() { return slots[(head + count++) % DEPTH]; }
+    bool full() const { return count >= DEPTH; }
+};
+
+struct CANTxBus {
+    CANTxRing<CAN_TX_URGENT_DEPTH> urgent;
+    CANTxRing<CAN_TX_BROADCAST_DEPTH> broadcast;
+};
+
+static CANTxBus buses[CAN_TX_MAX_BUSES];
+static CANTxBusStats busStats[CAN_TX_MAX_BUSES];
+
+// Write the frame at the head of a ring; false if the driver had no room
+template <uint8_t DEPTH>
+static bool sendFront(uint8_t bus, CANTxRing<DEPTH>& ring) {
+    CANTxEntry& e = ring.front();
+    if (e.live && !hal::can::write(e.id, e.data, e.len, e.extended, bus)) {
+        busStats[bus].retries++;  // Stays queued for the next pass
+        return false;
+    }
+    if (e.live) busStats[bus].sent++;
+    ring.pop();
+    return true;
+}
+
+// Urgent frames until the driver is full, then a bounded broadcast burst
+static void pumpBus(uint8_t bus) {
+    CANTxBus& q = buses[bus];
+
+    while (q.urgent.count > 0) {
+        if (!sendFront(bus, q.urgent)) return;  // Broadcast waits behind it
+    }
+
+    uint8_t sent = 0;
+    while (sent < CAN_TX_BROADCAST_BURST && q.broadcast.count > 0) {
+        bool live = q.broadcast.front().live;
+        if (!sendFront(bus, q.broadcast)) return;
+        if (live) sent++;
+    }
+    if (sent > 0 && q.broadcast.count == 0) TRACE_CAN_WIRE(bus);  // Every queued value is out
+}
+
+bool queueCANTx(uint8_t bus, uint32_t id, const uint8_t* data, uint8_t len, bool extended,
+                CANTxPriority priority, uint16_t key) {
+    if (bus >= CAN_TX_MAX_BUSES || len > 8) return false;
+
+    CANTxBus& q = buses[bus];
+    CANTxBusStats& stats = busStats[bus];
+    CANTxEntry* e;
+
+    if (priority == CAN_TX_URGENT) {
+        if (q.urgent.full()) {
+            pumpBus(bus);  // Make room if the driver has caught up
+            if (q.urgent.full()) {
+                stats.drops++;
+                return false;
+            }
+        }
+        e = &q.urgent.push();
+        e->key = CAN_TX_NO_KEY;
+        if (q.urgent.count > stats.maxUrgent) stats.maxUrgent = q.urgent.count;
+    } else {
+        // Newest value wins - overwrite the queued frame in place
+        if (key != CAN_TX_NO_KEY) {
+            for (uint8_t i = 0; i < q.broadcast.count; i++) {
+                CANTxEntry& old = q.broadcast.at(i);
+                if (old.live && old.key == key && old.id == id && old.extended == extended) {
+                    old.len = len;
+                    memcpy(old.data, data, len);
+                    stats.coalesced++;
+                    return true;
+                }
+            }
+        }
+        if (q.broadcast.full()) {
+            q.broadcast.pop();  // Oldest value is the least worth sending
+            stats.drops++;
+        }
+        e = &q.broadcast.push();
+        e->key = key;
+        if (q.broadcast.count > stats.maxBroadcast) stats.maxBroadcast = q.broadcast.count;
+    }
+
+    e->id = id;
+    e->len = len;
+    e->extended = extended;
+    e->live = true;
+    memcpy(e->data, data, len);
+
+    if (priority == CAN_TX_URGENT) {
+        pumpBus(bus);  // Straight to the driver - no loop pass of latency
+    }
+    return true;
+}
+
+void cancelCANTx(uint8_t bus, uint32_t id) {
+    if (bus >= CAN_TX_MAX_BUSES) return;
+    CANTxRing<CAN_TX_BROADCAST_DEPTH>& ring = buses[bus].broadcast;
+    for (uint8_t i = 0; i < ring.count; i++) {
+        if (ring.at(i).id == id) ring.at(i).live = false;
+    }
+}
+
+void pumpCANTx() {
+    for (uint8_t bus = 0; bus < CAN_TX_MAX_BUSES; bus++) {
+        if (buses[bus].urgent.count > 0 || buses[bus].broadcast.count > 0) {
+            pumpBus(bus);
+        }
+    }
+}
+
+bool getCANTxBusStats(uint8_t bus, CANTxBusStats* stats) {
+    if (bus >= CAN_TX_MAX_BUSES || stats == nullptr) return false;
+    *stats = busStats[bus];
+    return true;
+}
+
+void printCANTxStats() {
+    for (uint8_t bus = 0; bus < CAN_TX_MAX_BUSES; bus++) {
+        const CANTxBusStats& s = busStats[bus];
+        if (s.sent == 0 && s.drops == 0 && s.retries == 0) continue;
+
+        msg.control.print(F("TX bus "));
+        msg.control.print(bus);
+        msg.control.print(F(": "));
+        msg.control.print(s.sent);
+        msg.control.print(F(" frames, "));
+        msg.control.print(s.coalesced);
+        msg.control.print(F(" coalesced, "));
+        msg.control.print(s.drops);
+        msg.control.print(F(" dropped, "));
+        msg.control.print(s.retries);
+        msg.control.println(F(" retries"));
+        msg.control.print(F("  Queue depth: urgent "));
+        msg.control.print(buses[bus].urgent.count);
+        msg.control.print(F("/"));
+        msg.control.print(CAN_TX_URGENT_DEPTH);
+        msg.control.print(F(" (max "));
+        msg.control.print(s.maxUrgent);
+        msg.control.print(F("), broadcast "));
+        msg.control.print(buses[bus].broadcast.count);
+        msg.control.print(F("/"));
+        msg.control.print(CAN_TX_BROADCAST_DEPTH);
+        msg.control.print(F(" (max "));
+        msg.control.print(s.maxBroadcast);
+        msg.control.println(F(")"));
+    }
+}
@@ -0,0 +1,102 @@
+/*
+ * can_tx.h - Per-bus CAN transmit queue
+ *
+ * CAN output (broadcast and OBD-II responses) and the OBD-II poller share
+ * the transmit side of a bus. Writing straight to hal::can::write() gave
+ * every frame the same treatment: a full controller buffer (three on the
+ * MCP2515, a 16-frame ring on FlexCAN) dropped whatever came next, and an
+ * answer to a tester queued behind a burst of broadcast frames. Frames go
+ * through a bounded queue per bus and priority instead:
+ *
+ *   queueCANTx(bus, 0x7E8, frame, 8, false, CAN_TX_URGENT);              // Response, in order
+ *   queueCANTx(bus, 0x7E8, frame, 8, false, CAN_TX_BROADCAST, pid);      // Newest value per key
+ *
+ * - URGENT (OBD-II responses, flow control, poll requests) goes to the
+ *   driver as soon as it is queued and always before any broadcast frame;
+ *   frames keep their order, as ISO-TP needs. A full urgent queue refuses
+ *   the frame (false) so the caller retries, like a full driver did.
+ * - BROADCAST frames with the same ID and key replace each other in place,
+ *   so a stale value never goes out ahead of its successor. A full queue
+ *   drops its oldest frame. At most CAN_TX_BROADCAST_BURST broadcast frames
+ *   are handed to the driver per pass, so its FIFO never holds a long
+ *   broadcast backlog ahead of the next urgent frame.
+ *
+ * A frame the driver refuses stays at the head of its queue and is retried
+ * from pumpCANTx() in the main loop (counted as a retry). FlexCAN and TWAI
+ * drain their own transmit buffers from the TX-complete interrupt, so the
+ * queue only has to keep them fed; the MCP2515 driver has no TX interrupt
+ * and is refilled from the loop.
+ *
+ * Build Flags:
+ *   -D CAN_TX_URGENT_DEPTH=n     - Urgent frames queued per bus (default 4 on AVR, 16 elsewhere)
+ *   -D CAN_TX_BROADCAST_DEPTH=n  - Broadcast frames queued per bus (default 8 on AVR, 32 elsewhere)
+ *   -D CAN_TX_BROADCAST_BURST=n  - Broadcast frames handed to the driver per pass (default 4)
+ */
+
+#ifndef CAN_TX_H
+#define CAN_TX_H
+
+#include <Arduino.h>
+
+#ifndef CAN_TX_URGENT_DEPTH
+  #if defined(__AVR__)
+    #define CAN_TX_URGENT_DEPTH 4
+  #else
+    #define CAN_TX_URGENT_DEPTH 16
+  #endif
+#endif
+
+#ifndef CAN_TX_BROADCAST_DEPTH
+  #if defined(__AVR__)
+    #define CAN_TX_BROADCAST_DEPTH 8
+  #else
+    #define CAN_TX_BROADCAST_DEPTH 32
+  #endif
+#endif
+
+#ifndef CAN_TX_BROADCAST_BURST
+#define CAN_TX_BROADCAST_BURST 4
+#endif
+
+#if defined(__AVR__)
+  #define CAN_TX_MAX_BUSES 2     // Two MCP2515 controllers at most
+#else
+  #define CAN_TX_MAX_BUSES 3
+#endif
+
+#define CAN_TX_NO_KEY 0xFFFF     // Never coalesced
+
+enum CANTxPriority : uint8_t {
+    CAN_TX_URGENT = 0,           // Responses and requests - in order, first out
+    CAN_TX_BROADCAST = 1         // Periodic values - newest wins
+};
+
+struct CANTxBusStats {
+    uint32_t sent;        // Frames accepted by the driver
+    uint32_t coalesced;   // Broadcast frames replaced by a newer value before going out
+    uint32_t drops;       // Frames lost to a full queue (oldest broadcast, or urgent refused)
+    uint32_t retries;     // Writes the driver refused (frame kept, retried next pass)
+    uint8_t maxUrgent;    // Deepest urgent queue seen
+    uint8_t maxBroadcast; // Deepest broadcast queue seen
+};
+
+// Queue a classic CAN frame; urgent frames are written at once if the driver has room
+// key: BROADCAST frames with the same bus, ID and key replace each other (CAN_TX_NO_KEY = never)
+// Returns false if the frame was not queued (bad bus or length, urgent queue full)
+bool queueCANTx(uint8_t bus, uint32_t id, const uint8_t* data, uint8_t len, bool extended,
+                CANTxPriority priority, uint16_t key = CAN_TX_NO_KEY);
+
+// Remove queued broadcast frames with this ID (e.g. before a multi-frame
+// response on the same ID, which a single frame in between would break)
+void cancelCANTx(uint8_t bus, uint32_t id);
+
+// Hand queued frames to the drivers - urgent first, then a broadcast burst
+void pumpCANTx();
+
+// Statistics (bus < CAN_TX_MAX_BUSES)
+bool getCANTxBusStats(uint8_t bus, CANTxBusStats* stats);
+
+// Print per-bus counters for buses that have sent anything to the control port
+void printCANTxStats();
+
+#endif // CAN_TX_H
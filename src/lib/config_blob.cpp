@@ -0,0 +1,588 @@
+/*
+ * config_blob.cpp - Compact binary config export/import (MessagePack records)
+ *
+ * Records are built and applied with the JSON section functions; only the
+ * encoding differs. Stream import parses each value straight from the
+ * stream through RecordStream, which bounds it to the record's length and
+ * takes the CRC on the way. Patch records (config_blob.h) are merged onto
+ * the section as exported, then imported like a whole one.
+ */
+
+#include "../config.h"
+
+#ifndef USE_STATIC_CONFIG
+
+#include "config_blob.h"
+#include "json_config.h"
+#include "json_arena.h"
+#include "crc32.h"
+#include "../inputs/input.h"
+#include "../inputs/input_manager.h"
+#include "message_api.h"
+#include "log_tags.h"
+
+extern Input inputs[MAX_INPUTS];
+extern uint8_t numActiveInputs;
+
+#define RECORD_HEADER 'H'
+#define RECORD_SYSTEM 'S'
+#define RECORD_INPUT 'I'
+#define RECORD_END 'E'
+#define RECORD_SYSTEM_PATCH 's'
+#define RECORD_INPUT_PATCH 'i'
+#define RECORD_INPUT_CLEAR 'X'
+
+// ===== EXPORT =====
+
+// Forwards to out, CRC-32 of everything written
+class CrcPrint : public Print {
+public:
+    CrcPrint(Print& out, uint32_t crc) : out(out), crc(crc) {}
+
+    size_t write(uint8_t c) override {
+        crc = crc32Update(crc, &c, 1);
+        return out.write(c);
+    }
+
+    size_t write(const uint8_t* data, size_t len) override {
+        crc = crc32Update(crc, data, len);
+        return out.write(data, len);
+    }
+
+    Print& out;
+    uint32_t crc;
+};
+
+// Keeps only the CRC-32 and the length of what is written (CONFIG HASH)
+class HashPrint : public Print {
+public:
+    size_t write(uint8_t c) override {
+        crc = crc32Update(crc, &c, 1);
+        length++;
+        return 1;
+    }
+
+    size_t write(const uint8_t* data, size_t len) override {
+        crc = crc32Update(crc, data, len);
+        length += len;
+        return len;
+    }
+
+    uint32_t crc = 0;
+    uint32_t length = 0;
+};
+
+// One input as its record holds it: idx, without the runtime state (not imported)
+static void exportInputRecord(JsonObject& inputObj, uint8_t idx) {
+    inputObj["idx"] = idx;
+    exportInputToJSON(inputObj, &inputs[idx]);
+    inputObj.remove("health");
+    inputObj.remove("summary");
+}
+
+static void writeRecord(Print& output, uint8_t type, JsonDocument& doc) {
+    size_t len = measureMsgPack(doc);
+#if CONFIG_BLOB_RECORD_MAX > 0
+    if (len > CONFIG_BLOB_RECORD_MAX) {
+        msg.debug.warn(TAG_JSON, "Blob record '%c' is %u bytes - IMPORT takes %u", type,
+                       (unsigned)len, (unsigned)CONFIG_BLOB_RECORD_MAX);
+    }
+#endif
+    uint8_t head[3] = {type, (uint8_t)len, (uint8_t)(len >> 8)};
+    output.write(head, sizeof(head));
+
+    CrcPrint body(output, crc32Update(0, head, sizeof(head)));
+    serializeMsgPack(doc, body);
+    uint8_t crc[4] = {(uint8_t)body.crc, (uint8_t)(body.crc >> 8), (uint8_t)(body.crc >> 16), (uint8_t)(body.crc >> 24)};
+    output.write(crc, sizeof(crc));
+}
+
+void dumpConfigToBlob(Print& output) {
+    output.write((const uint8_t*)CONFIG_BLOB_MAGIC, 4);
+
+    {
+        JsonDocument doc(jsonArena());
+        doc["schemaVersion"] = JSON_SCHEMA_VERSION;
+        doc["mode"] = "runtime";
+        JsonObject firmware = doc["firmware"].to<JsonObject>();
+        exportFirmwareToJSON(firmware);
+        writeRecord(output, RECORD_HEADER, doc);
+    }
+
+    {
+        JsonDocument doc(jsonArena());
+        JsonObject system = doc.to<JsonObject>();
+        exportSystemConfigToJSON(system);
+        writeRecord(output, RECORD_SYSTEM, doc);
+    }
+
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        const Input* input = &inputs[i];
+        if (!input->flags.isEnabled) {
+            continue;
+        }
+        JsonDocument doc(jsonArena());
+        JsonObject inputObj = doc.to<JsonObject>();
+        exportInputRecord(inputObj, i);
+        writeRecord(output, RECORD_INPUT, doc);
+        count++;
+    }
+
+    JsonDocument doc(jsonArena());
+    doc.set(count);
+    writeRecord(output, RECORD_END, doc);
+}
+
+// Base64 of what is written, as IMPORT lines on the control plane
+class ImportLinePrint : public Print {
+public:
+    size_t write(uint8_t c) override {
+        group[grouped++] = c;
+        if (grouped == 3) encodeGroup();
+        return 1;
+    }
+
+    void finish() {
+        if (grouped > 0) encodeGroup();
+        if (length > 0) flushLine();
+    }
+
+private:
+    void encodeGroup() {
+        static const char ALPHABET[] PROGMEM = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        uint32_t bits = ((uint32_t)group[0] << 16) | ((uint32_t)group[1] << 8) | group[2];
+        for (uint8_t k = 0; k < 4; k++) {
+            line[length++] = (k <= grouped) ? (char)pgm_read_byte(&ALPHABET[(bits >> (18 - 6 * k)) & 0x3F]) : '=';
+        }
+        grouped = 0;
+        group[1] = group[2] = 0;
+        if (length >= CONFIG_BLOB_LINE_CHARS) flushLine();
+    }
+
+    void flushLine() {
+        line[length] = '\0';
+        msg.control.print(F("IMPORT "));
+        msg.control.println(line);
+        length = 0;
+    }
+
+    uint8_t group[3] = {0, 0, 0};
+    uint8_t grouped = 0;
+    char line[CONFIG_BLOB_LINE_CHARS + 1];
+    uint8_t length = 0;
+};
+
+static_assert(CONFIG_BLOB_LINE_CHARS % 4 == 0 && CONFIG_BLOB_LINE_CHARS < 256, "IMPORT lines hold whole base64 groups");
+
+void dumpConfigBlobLines() {
+    msg.control.println(F("IMPORT BEGIN"));
+    ImportLinePrint lines;
+    dumpConfigToBlob(lines);
+    lines.finish();
+    msg.control.println(F("IMPORT END"));
+}
+
+uint32_t configBlobHash(uint32_t* length) {
+    HashPrint hash;
+    dumpConfigToBlob(hash);
+    if (length) *length = hash.length;
+    return hash.crc;
+}
+
+void printConfigHash() {
+    uint32_t length;
+    uint32_t crc = configBlobHash(&length);
+    char hex[9];
+    snprintf(hex, sizeof(hex), "%08lx", (unsigned long)crc);
+    msg.control.print(F("CONFIG HASH "));
+    msg.control.print(hex);
+    msg.control.print(' ');
+    msg.control.println(length);
+}
+
+// ===== IMPORT =====
+
+struct BlobImport {
+    bool headerChecked;
+    bool patch;                             // Header named the config it patches
+    bool ended;
+    bool failed;
+    uint8_t schemaVer;
+    uint8_t inputRecords;
+    uint8_t imported;
+};
+
+static void failImport(BlobImport& state, const __FlashStringHelper* reason) {
+    msg.control.print(F("ERROR: Config blob "));
+    msg.control.println(reason);
+    state.failed = true;
+}
+
+// RFC 7386 merge patch: objects merge member by member, null removes, the rest replaces
+static void mergePatch(JsonVariant target, JsonVariantConst patch) {
+    if (!patch.is<JsonObjectConst>()) {
+        target.set(patch);
+        return;
+    }
+    if (!target.is<JsonObject>()) target.to<JsonObject>();
+    for (JsonPairConst member : patch.as<JsonObjectConst>()) {
+        if (member.value().isNull()) {
+            target.remove(member.key());
+        } else {
+            mergePatch(target[member.key()], member.value());
+        }
+    }
+}
+
+static void failPatchedInput(BlobImport& state, uint8_t idx, const __FlashStringHelper* reason) {
+    msg.control.print(F("ERROR: Config patch for input "));
+    msg.control.print(idx);
+    msg.control.print(F(": "));
+    msg.control.println(reason);
+    state.failed = true;
+}
+
+// The input at idx as exported, the patch merged in, imported again
+static void applyInputPatch(BlobImport& state, JsonDocument& patch) {
+    uint8_t idx = patch["idx"] | (uint8_t)MAX_INPUTS;
+    if (idx >= MAX_INPUTS || inputs[idx].pin == 0xFF || !inputs[idx].flags.isEnabled) {
+        failPatchedInput(state, idx, F("not configured"));
+        return;
+    }
+
+    JsonDocument merged(jsonArena());
+    JsonObject inputObj = merged.to<JsonObject>();
+    exportInputRecord(inputObj, idx);
+    mergePatch(inputObj, patch.as<JsonVariantConst>());
+    if (merged.overflowed()) {
+        failPatchedInput(state, idx, F("out of scratch memory"));
+        return;
+    }
+
+    InputPin pin = inputObj["pin"] | inputs[idx].pin;
+    if (pin != inputs[idx].pin) clearInput(inputs[idx].pin);  // Moved - the old pin's captures let go
+    if (!importInputFromJSON(inputObj, idx)) {
+        failPatchedInput(state, idx, F("not imported"));
+        return;
+    }
+    state.imported++;
+}
+
+static void applySystemPatch(BlobImport& state, JsonDocument& patch) {
+    JsonDocument merged(jsonArena());
+    JsonObject system = merged.to<JsonObject>();
+    exportSystemConfigToJSON(system);
+    mergePatch(system, patch.as<JsonVariantConst>());
+    if (merged.overflowed()) {
+        failImport(state, F("system patch out of scratch memory"));
+    } else if (!importSystemConfigFromJSON(system)) {
+        failImport(state, F("system patch not imported"));
+    }
+}
+
+// Apply one checked record
+static void applyRecord(BlobImport& state, uint8_t type, JsonDocument& doc) {
+    if (type != RECORD_HEADER && !state.headerChecked) {
+        failImport(state, F("has no header record first"));
+        return;
+    }
+    bool patchRecord = type == RECORD_SYSTEM_PATCH || type == RECORD_INPUT_PATCH || type == RECORD_INPUT_CLEAR;
+    if (patchRecord && !state.patch) {
+        failImport(state, F("has patch records but no patch header"));
+        return;
+    }
+
+    switch (type) {
+        case RECORD_HEADER:
+            state.schemaVer = doc["schemaVersion"] | 1;
+            if (!checkConfigHeader(state.schemaVer, doc["mode"] | "runtime")) {
+                state.failed = true;
+                return;
+            }
+            state.patch = !doc["patch"].isNull();
+            if (state.patch && doc["patch"].as<uint32_t>() != configBlobHash(nullptr)) {
+                failImport(state, F("patch was made for another config (CONFIG HASH) - nothing applied"));
+                return;
+            }
+            if (!state.patch && isInputTransactionActive()) {
+                failImport(state, F("is a whole config - COMMIT or ROLLBACK first"));
+                return;
+            }
+            state.headerChecked = true;
+            break;
+
+        case RECORD_SYSTEM: {
+            JsonObject system = doc.as<JsonObject>();
+            if (!importSystemConfigFromJSON(system)) {
+                failImport(state, F("system record not imported"));
+            }
+            break;
+        }
+
+        case RECORD_INPUT: {
+            JsonObject inputObj = doc.as<JsonObject>();
+            uint8_t idx = inputObj["idx"];
+            state.inputRecords++;
+            if (importInputFromJSON(inputObj, idx)) {
+                state.imported++;
+                msg.debug.debug(TAG_JSON, "Successfully imported input %d", idx);
+            } else if (state.patch) {
+                failPatchedInput(state, idx, F("new input not imported"));
+            } else {
+                msg.debug.warn(TAG_JSON, "Failed to import input %d", idx);
+            }
+            break;
+        }
+
+        case RECORD_SYSTEM_PATCH:
+            applySystemPatch(state, doc);
+            break;
+
+        case RECORD_INPUT_PATCH:
+            state.inputRecords++;
+            applyInputPatch(state, doc);
+            break;
+
+        case RECORD_INPUT_CLEAR: {
+            uint8_t idx = doc.as<uint8_t>();
+            state.inputRecords++;
+            if (idx < MAX_INPUTS && inputs[idx].pin != 0xFF) clearInput(inputs[idx].pin);
+            state.imported++;               // Already clear is as good
+            break;
+        }
+
+        case RECORD_END:
+            if (doc.as<uint8_t>() != state.inputRecords) {
+                failImport(state, F("is missing input records"));
+                return;
+            }
+            state.ended = true;
+            if (state.patch) {
+                numActiveInputs = 0;        // Patched on top of what was there
+                for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+                    if (inputs[i].pin != 0xFF && inputs[i].flags.isEnabled) numActiveInputs++;
+                }
+            } else if (state.inputRecords > 0) {
+                msg.debug.info(TAG_JSON, "Import complete: %d of %d inputs imported", state.imported, state.inputRecords);
+                numActiveInputs = state.imported;
+            }
+            break;
+
+        default:
+            break;                          // Newer record type - skipped
+    }
+}
+
+static bool finishImport(const BlobImport& state) {
+    if (state.failed) return false;
+    if (!state.ended) {
+        msg.control.println(F("ERROR: Config blob truncated (no end record)"));
+        return false;
+    }
+    if (state.patch) {
+        msg.control.print(F("Applied config patch ("));
+        msg.control.print(state.imported);
+        msg.control.println(F(" input records)"));
+        return true;
+    }
+    if (state.inputRecords > 0 && state.imported == 0) {
+        msg.control.println(F("ERROR: Failed to import inputs"));
+        return false;
+    }
+    msg.control.print(F("Successfully loaded config (schema v"));
+    msg.control.print(state.schemaVer);
+    msg.control.println(F(", binary)"));
+    return true;
+}
+
+static uint16_t readLength(const uint8_t* head) {
+    return head[1] | ((uint16_t)head[2] << 8);
+}
+
+static uint32_t readCrc(const uint8_t* bytes) {
+    return bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+// The value of one record: at most left bytes of in, CRC-32 taken as read
+class RecordStream : public Stream {
+public:
+    RecordStream(Stream& in, uint16_t left, uint32_t crc) : in(in), left(left), crc(crc) {}
+
+    int available() override { return left ? in.available() : 0; }
+    int peek() override { return left ? in.peek() : -1; }
+    size_t write(uint8_t) override { return 0; }
+
+    int read() override {
+        if (left == 0) return -1;
+        int c = in.read();
+        if (c < 0) return -1;
+        uint8_t b = c;
+        crc = crc32Update(crc, &b, 1);
+        left--;
+        return c;
+    }
+
+    // Read what the parser left (an unknown or bad value); false if the stream ended
+    bool drain() {
+        while (left > 0) {
+            if (read() < 0) return false;
+        }
+        return true;
+    }
+
+    Stream& in;
+    uint16_t left;
+    uint32_t crc;
+};
+
+bool loadConfigFromBlob(Stream& input) {
+    char magic[4];
+    if (input.readBytes(magic, sizeof(magic)) != sizeof(magic) || memcmp(magic, CONFIG_BLOB_MAGIC, 4) != 0) {
+        msg.control.println(F("ERROR: Not a config blob"));
+        return false;
+    }
+
+    BlobImport state = {};
+    while (!state.ended && !state.failed) {
+        uint8_t head[3];
+        if (input.readBytes(head, sizeof(head)) != sizeof(head)) break;
+
+        RecordStream body(input, readLength(head), crc32Update(0, head, sizeof(head)));
+        JsonDocument doc(jsonArena());
+        DeserializationError error = deserializeMsgPack(doc, body);
+        uint8_t crc[4];
+        if (!body.drain() || input.readBytes(crc, sizeof(crc)) != sizeof(crc)) break;
+        if (readCrc(crc) != body.crc) {
+            failImport(state, F("record CRC mismatch"));
+            break;
+        }
+        if (error) {
+            msg.control.print(F("ERROR: Config blob record not MessagePack: "));
+            msg.control.println(error.c_str());
+            return false;
+        }
+        applyRecord(state, head[0], doc);
+    }
+    return finishImport(state);
+}
+
+#if CONFIG_BLOB_RECORD_MAX > 0
+
+// IMPORT lines: bytes are collected into the current record, applied when its CRC arrives
+static struct {
+    bool active;
+    uint8_t magicSeen;
+    uint8_t head[3];
+    uint8_t headSeen;
+    uint16_t length;
+    uint16_t received;
+    uint8_t crc[4];
+    uint8_t crcSeen;
+    BlobImport state;
+} lineImport;
+
+static uint8_t record[CONFIG_BLOB_RECORD_MAX];
+
+static void importByte(uint8_t b) {
+    BlobImport& state = lineImport.state;
+    if (lineImport.magicSeen < 4) {
+        if (b != (uint8_t)CONFIG_BLOB_MAGIC[lineImport.magicSeen++]) failImport(state, F("magic missing"));
+        return;
+    }
+    if (lineImport.headSeen < 3) {
+        lineImport.head[lineImport.headSeen++] = b;
+        if (lineImport.headSeen == 3) {
+            lineImport.length = readLength(lineImport.head);
+            lineImport.received = 0;
+            if (lineImport.length > CONFIG_BLOB_RECORD_MAX) failImport(state, F("record larger than CONFIG_BLOB_RECORD_MAX"));
+        }
+        return;
+    }
+    if (lineImport.received < lineImport.length) {
+        record[lineImport.received++] = b;
+        return;
+    }
+
+    lineImport.crc[lineImport.crcSeen++] = b;
+    if (lineImport.crcSeen < 4) return;
+    lineImport.headSeen = 0;
+    lineImport.crcSeen = 0;
+
+    uint32_t crc = crc32Update(crc32Update(0, lineImport.head, 3), record, lineImport.length);
+    if (readCrc(lineImport.crc) != crc) {
+        failImport(state, F("record CRC mismatch"));
+        return;
+    }
+    if (state.ended) return;                // Trailing bytes after the end record
+    JsonDocument doc(jsonArena());
+    DeserializationError error = deserializeMsgPack(doc, record, lineImport.length);
+    if (error) {
+        msg.control.print(F("ERROR: Config blob record not MessagePack: "));
+        msg.control.println(error.c_str());
+        state.failed = true;
+        return;
+    }
+    applyRecord(state, lineImport.head[0], doc);
+}
+
+static int8_t base64Value(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+') return 62;
+    if (c == '/') return 63;
+    return -1;
+}
+
+bool importConfigBlobLine(const char* arg) {
+    if (strcasecmp(arg, "BEGIN") == 0) {
+        memset(&lineImport, 0, sizeof(lineImport));
+        lineImport.active = true;
+        return true;
+    }
+    if (!lineImport.active) {
+        msg.control.println(F("ERROR: IMPORT BEGIN first"));
+        return false;
+    }
+    if (strcasecmp(arg, "END") == 0) {
+        lineImport.active = false;
+        return finishImport(lineImport.state);
+    }
+    if (lineImport.state.failed) return false;  // Reported once; the rest waits for END
+
+    // Base64 groups of 4 characters → up to 3 bytes
+    uint32_t bits = 0;
+    uint8_t count = 0;
+    for (const char* p = arg; *p && !lineImport.state.failed; p++) {
+        if (*p == '=') break;
+        int8_t v = base64Value(*p);
+        if (v < 0) {
+            failImport(lineImport.state, F("line is not base64"));
+            return false;
+        }
+        bits = (bits << 6) | v;
+        if (++count == 4) {
+            importByte(bits >> 16);
+            importByte(bits >> 8);
+            importByte(bits);
+            bits = 0;
+            count = 0;
+        }
+    }
+    if (count >= 2) importByte(bits >> (6 * count - 8));
+    if (count == 3) importByte(bits >> 2);
+    return !lineImport.state.failed;
+}
+
+#else
+
+bool importConfigBlobLine(const char* arg) {
+    (void)arg;
+    msg.control.println(F("ERROR: IMPORT not in this build (CONFIG_BLOB_RECORD_MAX=0) - LOAD a .bin file from SD"));
+    return false;
+}
+
+#endif // CONFIG_BLOB_RECORD_MAX > 0
+
+#endif // USE_STATIC_CONFIG
@@ -0,0 +1,104 @@
+/*
+ * config_blob.h - Compact binary config export/import (MessagePack records)
+ *
+ * The JSON config (json_config.h) as framed MessagePack records - the same
+ * schema, the same export/import functions per section, a fraction of the
+ * bytes and no text parsing:
+ *
+ *   "OEMC"  record...
+ *   record: type (uint8)  length (uint16)  MessagePack value  CRC-32
+ *
+ * little-endian; the CRC-32 (crc32.h) covers type, length and value.
+ *
+ *   'H'  {"schemaVersion", "mode", "firmware"} - first
+ *   'S'  the "system" object
+ *   'I'  one element of "inputs" (with "idx"; no health block)
+ *   'E'  the number of 'I' records - last
+ *
+ * Unknown record types are skipped. Each record is imported on its own, as
+ * the JSON stream import does each section, so peak RAM is one section's
+ * JsonDocument. tools/configure.py --blob converts a runtime JSON config.
+ *
+ * Over a control transport the blob goes as text lines, base64, which the
+ * export writes ready to paste back:
+ *
+ *   IMPORT BEGIN
+ *   IMPORT T0VNQ0gj...          (CONFIG_BLOB_LINE_CHARS characters each)
+ *   IMPORT END
+ *
+ * Line import collects one record at a time in a CONFIG_BLOB_RECORD_MAX
+ * buffer (0 = no line import - the default on AVR, where LOAD from SD
+ * still takes .bin files). The system record is the largest, ~1.5 KB.
+ *
+ * Delta sync (tools/configure.py --sync): CONFIG HASH answers the CRC-32 of
+ * the whole blob as it would be exported now, so a host tells whether the
+ * device still holds the config it last fetched. A patch blob then carries
+ * only what differs, as merge patches (RFC 7386: members replace, objects
+ * merge, null removes) onto the exported sections:
+ *
+ *   'H'  as above, plus "patch": the CONFIG HASH it was made against
+ *   's'  patch to the "system" object
+ *   'i'  patch to one input ("idx" and the members that changed)
+ *   'I'  a new input, whole
+ *   'X'  idx of an input to clear
+ *   'E'  the number of 'i', 'I' and 'X' records
+ *
+ * Each patched section is exported, merged and imported again, so fields
+ * the patch doesn't name stay as they are. A patch made against another
+ * hash is refused before anything is applied. Patch blobs may be imported
+ * inside a config transaction (BEGIN, IMPORT lines, COMMIT); whole blobs
+ * may not.
+ *
+ * Usage:
+ *   dumpConfigToBlob(file);                 // CONFIG SAVE SD:car.bin
+ *   loadConfigFromBlob(file);               // CONFIG LOAD SD:car.bin
+ *   dumpConfigBlobLines();                  // SYSTEM DUMP BIN
+ *   importConfigBlobLine(argv[1]);          // IMPORT BEGIN | <base64> | END
+ *   printConfigHash();                      // CONFIG HASH
+ *
+ * Build Flags:
+ *   -D CONFIG_BLOB_RECORD_MAX=n   - Largest record IMPORT takes (default 2048; 0 on AVR)
+ *   -D CONFIG_BLOB_LINE_CHARS=n   - Base64 characters per IMPORT line (default 96)
+ */
+
+#ifndef CONFIG_BLOB_H
+#define CONFIG_BLOB_H
+
+#ifndef USE_STATIC_CONFIG
+
+#include <Arduino.h>
+
+#ifndef CONFIG_BLOB_RECORD_MAX
+#if defined(__AVR__)
+#define CONFIG_BLOB_RECORD_MAX 0
+#else
+#define CONFIG_BLOB_RECORD_MAX 2048
+#endif
+#endif
+
+#ifndef CONFIG_BLOB_LINE_CHARS
+#define CONFIG_BLOB_LINE_CHARS 96   // "IMPORT " + 96 fits the 128-byte command line
+#endif
+
+#define CONFIG_BLOB_MAGIC "OEMC"
+
+// Write the whole config as a blob
+void dumpConfigToBlob(Print& output);
+
+// Import a blob from a stream (an SD file), record by record
+bool loadConfigFromBlob(Stream& input);
+
+// The blob as IMPORT lines on the control plane
+void dumpConfigBlobLines();
+
+// One IMPORT argument: BEGIN, base64 data or END (true unless it failed)
+bool importConfigBlobLine(const char* arg);
+
+// CRC-32 of the blob dumpConfigToBlob() would write now (its size in length)
+uint32_t configBlobHash(uint32_t* length);
+
+// "CONFIG HASH <crc32 hex> <bytes>" on the control plane
+void printConfigHash();
+
+#endif // USE_STATIC_CONFIG
+#endif // CONFIG_BLOB_H
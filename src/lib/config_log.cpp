@@ -0,0 +1,150 @@
+/*
+ * config_log.cpp - Append-only, keyed config records in EEPROM
+ *
+ * Header at address 0, then records. committedEnd is where the next save
+ * appends: just past the last commit record, over any torn save after it.
+ */
+
+#include "config_log.h"
+
+#ifdef ENABLE_CONFIG_LOG
+
+#include "eeprom_store.h"
+
+#define CONFIG_LOG_MAGIC 0x4C4D454F             // "OEML" in ASCII
+#define CONFIG_LOG_VERSION 1
+#define RECORD_OVERHEAD 4                       // Key, field, length, CRC
+#define COMMIT_BYTES (RECORD_OVERHEAD + 1 + 1)  // Commit with a count, then the end marker
+
+struct ConfigLogHeader {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t generation;
+    uint8_t generationCheck;                    // ~generation
+    uint8_t reserved;
+};
+
+static uint8_t generation;
+static uint16_t committedEnd;
+
+// CRC-8 (poly 0x07), seeded with the generation
+static uint8_t crc8(uint8_t crc, const uint8_t* data, uint8_t len) {
+    while (len--) {
+        crc ^= *data++;
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static uint8_t trimmedLength(const void* data, uint8_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    while (size > 0 && bytes[size - 1] == 0) size--;
+    return size;
+}
+
+// Record at pos: its length (header + data + CRC) if valid, 0 at the end or on a bad CRC
+static uint8_t readRecord(uint16_t pos, uint8_t* head, uint8_t* data) {
+    if (pos + RECORD_OVERHEAD > CONFIG_LOG_BYTES) return 0;
+    eepromStoreRead(pos, head, 3);
+    if (head[0] == CONFIG_LOG_END) return 0;
+    if (pos + RECORD_OVERHEAD + head[2] > CONFIG_LOG_BYTES) return 0;
+    eepromStoreRead(pos + 3, data, head[2]);
+    uint8_t crc = crc8(crc8(generation, head, 3), data, head[2]);
+    if (eepromStoreReadByte(pos + 3 + head[2]) != crc) return 0;
+    return RECORD_OVERHEAD + head[2];
+}
+
+bool configLogOpen() {
+    ConfigLogHeader header;
+    eepromGet(0, header);
+    generation = header.generation;             // Kept by configLogErase() - the next format moves on
+    if (header.magic != CONFIG_LOG_MAGIC || header.version != CONFIG_LOG_VERSION ||
+        header.generationCheck != (uint8_t)~header.generation) {
+        return false;
+    }
+
+    uint8_t head[3];
+    uint8_t data[255];
+    uint16_t pos = sizeof(ConfigLogHeader);
+    committedEnd = pos;
+    while (uint8_t n = readRecord(pos, head, data)) {
+        pos += n;
+        if (head[0] == CONFIG_LOG_COMMIT) committedEnd = pos;
+    }
+    return true;
+}
+
+void configLogReplay(ConfigLogVisitor visit) {
+    uint8_t head[3];
+    uint8_t data[255];
+    uint16_t pos = sizeof(ConfigLogHeader);
+    while (pos < committedEnd) {
+        uint8_t n = readRecord(pos, head, data);
+        if (n == 0) break;
+        visit(head[0], head[1], data, head[2]);
+        pos += n;
+    }
+}
+
+uint8_t configLogRecordBytes(const void* data, uint8_t size) {
+    return RECORD_OVERHEAD + trimmedLength(data, size);
+}
+
+uint16_t configLogRoom() {
+    uint16_t used = committedEnd + COMMIT_BYTES;
+    return (used < CONFIG_LOG_BYTES) ? CONFIG_LOG_BYTES - used : 0;
+}
+
+uint16_t configLogCapacity() {
+    return CONFIG_LOG_BYTES - sizeof(ConfigLogHeader) - COMMIT_BYTES;
+}
+
+void configLogFormat() {
+    generation++;
+    ConfigLogHeader header = {CONFIG_LOG_MAGIC, CONFIG_LOG_VERSION, generation, (uint8_t)~generation, 0};
+    eepromPut(0, header);
+    committedEnd = sizeof(ConfigLogHeader);
+}
+
+// Appends at committedEnd + pending: records of the save in progress
+static uint16_t pendingBytes;
+
+void configLogAppend(uint8_t key, uint8_t field, const void* data, uint8_t size) {
+    uint8_t len = trimmedLength(data, size);
+    uint8_t head[3] = {key, field, len};
+    uint16_t pos = committedEnd + pendingBytes;
+    eepromStoreWrite(pos, head, 3);
+    eepromStoreWrite(pos + 3, data, len);
+    uint8_t crc = crc8(crc8(generation, head, 3), (const uint8_t*)data, len);
+    eepromStoreWrite(pos + 3 + len, &crc, 1);
+    pendingBytes += RECORD_OVERHEAD + len;
+}
+
+void configLogCommit(uint8_t count) {
+    configLogAppend(CONFIG_LOG_COMMIT, 0, &count, 1);
+    committedEnd += pendingBytes;
+    pendingBytes = 0;
+    uint8_t end = CONFIG_LOG_END;
+    if (committedEnd < CONFIG_LOG_BYTES) eepromStoreWrite(committedEnd, &end, 1);
+}
+
+void configLogErase() {
+    ConfigLogHeader header;
+    memset(&header, 0, sizeof(header));
+    header.generation = generation;
+    eepromPut(0, header);
+    committedEnd = sizeof(ConfigLogHeader);
+    pendingBytes = 0;
+}
+
+uint16_t configLogUsed() {
+    return committedEnd;
+}
+
+uint8_t configLogGeneration() {
+    return generation;
+}
+
+#endif // ENABLE_CONFIG_LOG
@@ -0,0 +1,84 @@
+/*
+ * config_log.h - Append-only, keyed config records in EEPROM
+ *
+ * With ENABLE_CONFIG_LOG the input config (EEPROM 0 up to SystemConfig) is
+ * a log of records instead of fixed-size slots. Each record holds one field
+ * of one input - or one alarm rule - and its own CRC:
+ *
+ *   key (uint8)  field (uint8)  length (uint8)  data  CRC-8
+ *
+ * Trailing zero bytes of a field are left off; a field with no record is all
+ * zeros. A save appends the fields that changed since the previous save,
+ * then a commit record (key CONFIG_LOG_COMMIT) with the input count; a load
+ * applies the records up to the last commit, so a save cut off by a power
+ * loss is ignored as a whole. CONFIG_LOG_END follows the last record.
+ *
+ * When a save's records don't fit, the owner compacts: configLogFormat()
+ * starts the next generation at the front of the area and the whole config
+ * is written again, non-zero fields only. Every record's CRC covers the
+ * generation, so records left past the end by an older generation never
+ * read back as current.
+ *
+ * The log is written through eeprom_store.h like the fixed layout, so a
+ * save is a few changed bytes queued, not a full rewrite.
+ *
+ * Usage:
+ *   if (configLogOpen()) configLogReplay(applyRecord);
+ *   if (configLogRecordBytes(size) ... <= configLogRoom())
+ *       configLogAppend(key, field, data, size);
+ *   configLogCommit(count);
+ *
+ * Build Flags:
+ *   -D ENABLE_CONFIG_LOG  - Input config as a log (meant for Teensy 4.x / ESP32 flash EEPROM)
+ */
+
+#ifndef CONFIG_LOG_H
+#define CONFIG_LOG_H
+
+#include <Arduino.h>
+#include "system_config.h"
+
+#ifdef ENABLE_CONFIG_LOG
+
+#define CONFIG_LOG_BYTES SYSTEM_CONFIG_ADDRESS  // Area: 0 to SystemConfig
+#define CONFIG_LOG_RULES 0xFD                   // Key of alarm rule records (field = rule)
+#define CONFIG_LOG_COMMIT 0xFE                  // Key of commit records (data = input count)
+#define CONFIG_LOG_END 0xFF                     // Key byte after the last record
+
+// Called for each committed record, commits included, in log order
+typedef void (*ConfigLogVisitor)(uint8_t key, uint8_t field, const uint8_t* data, uint8_t length);
+
+// Find the log's generation and end; false if the area holds no log
+bool configLogOpen();
+
+// Visit every committed record
+void configLogReplay(ConfigLogVisitor visit);
+
+// Bytes a record of this field would take (zeros trimmed)
+uint8_t configLogRecordBytes(const void* data, uint8_t size);
+
+// Bytes left for records, keeping room for the commit
+uint16_t configLogRoom();
+
+// Room in an empty log
+uint16_t configLogCapacity();
+
+// Start the next generation, empty (compaction)
+void configLogFormat();
+
+// Append one field; the caller has checked configLogRoom()
+void configLogAppend(uint8_t key, uint8_t field, const void* data, uint8_t size);
+
+// Close a save: commit record and end marker
+void configLogCommit(uint8_t count);
+
+// Forget the log (next load finds no config)
+void configLogErase();
+
+// Bytes in use / generation (diagnostics)
+uint16_t configLogUsed();
+uint8_t configLogGeneration();
+
+#endif // ENABLE_CONFIG_LOG
+
+#endif // CONFIG_LOG_H
@@ -0,0 +1,32 @@
+/*
+ * config_migrate.cpp - Upgrade config images saved by older firmware
+ */
+
+#include "config_migrate.h"
+
+const ConfigMigration* findConfigMigration(const ConfigMigration* table, uint8_t count, uint16_t version) {
+    for (uint8_t i = 0; i < count; i++) {
+        if (table[i].version == version) return &table[i];
+    }
+    return nullptr;
+}
+
+void migrateConfigImage(const ConfigMigration* migration, const void* image, void* current) {
+    const uint8_t* from = (const uint8_t*)image;
+    uint8_t* to = (uint8_t*)current;
+    for (uint8_t i = 0; i < migration->count; i++) {
+        ConfigFieldMap field;
+        memcpy_P(&field, &migration->fields[i], sizeof(field));
+        memcpy(to + field.to, from + field.from, field.size);
+    }
+}
+
+void revertConfigImage(const ConfigMigration* migration, void* image, const void* current) {
+    uint8_t* to = (uint8_t*)image;
+    const uint8_t* from = (const uint8_t*)current;
+    for (uint8_t i = 0; i < migration->count; i++) {
+        ConfigFieldMap field;
+        memcpy_P(&field, &migration->fields[i], sizeof(field));
+        memcpy(to + field.from, from + field.to, field.size);
+    }
+}
@@ -0,0 +1,60 @@
+/*
+ * config_migrate.h - Upgrade config images saved by older firmware
+ *
+ * A layout change used to make a saved image unusable: the version byte
+ * didn't match and the config went back to defaults. Now each older layout
+ * the firmware still reads has a migration - its version, its image size
+ * and a field map: spans of bytes copied from the old image to where the
+ * same fields are in the current struct. The caller fills the current
+ * struct with defaults first, so fields the old layout didn't have keep
+ * them; fields it dropped are simply not mapped. One pass over the old
+ * image, then the caller saves it in the current layout.
+ *
+ * Maps go old offset -> current offset directly (not version by version),
+ * so every supported version upgrades in one step. When a layout change
+ * moves fields an older map already points at, the older maps can instead
+ * target the previous layout: revertConfigImage() puts the defaults into
+ * an image of that layout, the old map fills it, and the previous layout's
+ * own map finishes the upgrade. Checking the old image (its checksum) is
+ * the caller's, before migrating.
+ *
+ * Usage:
+ *   static const ConfigFieldMap V18_FIELDS[] PROGMEM = {
+ *       {4, offsetof(SystemConfig, outputEnabled), sizeof(SystemConfig) - 8},
+ *   };
+ *   static const ConfigMigration MIGRATIONS[] = {
+ *       {18, sizeof(SystemConfig) - 4, V18_FIELDS, 1},
+ *   };
+ *   const ConfigMigration* m = findConfigMigration(MIGRATIONS, 1, version);
+ *   if (m) migrateConfigImage(m, oldImage, &current);
+ */
+
+#ifndef CONFIG_MIGRATE_H
+#define CONFIG_MIGRATE_H
+
+#include <Arduino.h>
+
+// One span: size bytes at from (old image) go to to (current struct)
+struct ConfigFieldMap {
+    uint16_t from;
+    uint16_t to;
+    uint16_t size;
+};
+
+struct ConfigMigration {
+    uint16_t version;               // Version this migration reads
+    uint16_t size;                  // Bytes of an image of that version
+    const ConfigFieldMap* fields;   // PROGMEM
+    uint8_t count;
+};
+
+// Migration for an image of this version; nullptr if it can't be upgraded
+const ConfigMigration* findConfigMigration(const ConfigMigration* table, uint8_t count, uint16_t version);
+
+// Copy the mapped fields of an old image into current (already holding defaults)
+void migrateConfigImage(const ConfigMigration* migration, const void* image, void* current);
+
+// The reverse: copy current's mapped fields back into an image of the old layout
+void revertConfigImage(const ConfigMigration* migration, void* image, const void* current);
+
+#endif // CONFIG_MIGRATE_H
@@ -0,0 +1,24 @@
+/*
+ * crc32.h - CRC-32 for config images in EEPROM
+ *
+ * CRC-32/ISO-HDLC (the zlib / Ethernet CRC: reflected poly 0xEDB88320,
+ * init and final XOR 0xFFFFFFFF). Chains like zlib's crc32(): start from 0
+ * and pass each result back in, so an image is checked in the same pass
+ * that writes or reads it:
+ *
+ *   uint32_t crc = 0;
+ *   crc = crc32Update(crc, &header, sizeof(header));
+ *   crc = crc32Update(crc, &record, sizeof(record));
+ *
+ * Table-driven, a nibble at a time (64-byte table in flash); ESP32 uses the
+ * ROM's crc32_le() instead.
+ */
+
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <Arduino.h>
+
+uint32_t crc32Update(uint32_t crc, const void* data, size_t len);
+
+#endif // CRC32_H
@@ -0,0 +1,209 @@
+/*
+ * device_inventory.cpp - Detected bus devices, kept with the system config
+ */
+
+#include "device_inventory.h"
+
+#ifndef USE_STATIC_CONFIG
+
+#include "system_config.h"
+#include "eeprom_store.h"
+#include "bus_manager.h"
+#include "i2c_engine.h"
+#include "message_api.h"
+#include "log_tags.h"
+
+#define SCAN_FIRST 0x08             // 0x00-0x07 and 0x78-0x7F are reserved addresses
+#define SCAN_LAST  0x77
+
+// Where each kind can answer - BUS I2C SCAN finds a device that moved
+struct DeviceKindInfo {
+    DeviceKind kind;
+    const char* name;
+    uint8_t first;
+    uint8_t last;
+};
+
+static const DeviceKindInfo KINDS[] = {
+    { DEVICE_BME280,  "BME280",  0x76, 0x77 },
+    { DEVICE_ADS1115, "ADS1115", 0x48, 0x4B },
+};
+#define NUM_KINDS (sizeof(KINDS) / sizeof(KINDS[0]))
+
+static bool booting = true;         // Absent records skip probes until commitDeviceInventory()
+static bool changed = false;
+static bool fullWarned = false;
+
+static const DeviceKindInfo* kindInfo(uint8_t kind) {
+    for (uint8_t i = 0; i < NUM_KINDS; i++) {
+        if (KINDS[i].kind == kind) return &KINDS[i];
+    }
+    return nullptr;
+}
+
+static uint8_t activeSpeed() {
+    return (uint8_t)(systemConfig.buses.i2c_clock / 100);
+}
+
+static InventoryEntry* findEntry(DeviceKind kind, uint8_t index) {
+    for (uint8_t i = 0; i < DEVICE_INVENTORY_SLOTS; i++) {
+        InventoryEntry* e = &systemConfig.inventory[i];
+        if (e->kind == kind && (e->unit >> 4) == index) return e;
+    }
+    return nullptr;
+}
+
+// Set a record's address at the current clock; true if that changed it
+static bool setEntry(InventoryEntry* e, uint8_t address) {
+    uint8_t speed = activeSpeed();
+    bool differs = e->address != address || e->speed != speed;
+    e->address = address;
+    e->speed = speed;
+    changed |= differs;
+    return differs;
+}
+
+// ===== PUBLIC API =====
+
+uint8_t inventoryRecall(DeviceKind kind, uint8_t index) {
+    const InventoryEntry* e = findEntry(kind, index);
+    if (!e || (e->unit & 0x0F) != getActiveI2CId() || e->speed != activeSpeed()) {
+        return INVENTORY_UNKNOWN;
+    }
+    if (e->address == INVENTORY_ABSENT && !booting) return INVENTORY_UNKNOWN;
+    return e->address;
+}
+
+void inventoryRecord(DeviceKind kind, uint8_t index, uint8_t address) {
+    uint8_t unit = (uint8_t)((index << 4) | (getActiveI2CId() & 0x0F));
+    InventoryEntry* e = findEntry(kind, index);
+    if (!e) e = findEntry(DEVICE_NONE, 0);
+    if (!e) {
+        if (!fullWarned) msg.debug.warn(TAG_I2C, "Device inventory full (DEVICE_INVENTORY_SLOTS)");
+        fullWarned = true;
+        return;
+    }
+    if (e->kind != kind || e->unit != unit) changed = true;
+    e->kind = kind;
+    e->unit = unit;
+    setEntry(e, address);
+}
+
+void commitDeviceInventory() {
+    booting = false;
+    if (!changed) return;
+    changed = false;
+
+    // Only over a valid saved config - defaults wait for SAVE like any other change
+    uint16_t magic;
+    uint8_t version;
+    eepromStoreRead(SYSTEM_CONFIG_ADDRESS, &magic, sizeof(magic));
+    eepromStoreRead(SYSTEM_CONFIG_ADDRESS + 2, &version, sizeof(version));
+    if (magic != SYSTEM_CONFIG_MAGIC || version != SYSTEM_CONFIG_VERSION) return;
+
+    systemConfig.crc = calculateSystemConfigCrc(&systemConfig);
+    eepromPut(SYSTEM_CONFIG_ADDRESS, systemConfig);
+    msg.debug.info(TAG_I2C, "Device inventory updated");
+}
+
+void scanI2CBus() {
+    uint8_t found[16] = {0};        // One bit per address
+    uint8_t count = 0;
+    uint32_t start = millis();
+
+    msg.control.println();
+    msg.control.print(F("=== I2C SCAN ("));
+    msg.control.print(getI2CBusName(getActiveI2CId()));
+    msg.control.print(F(" @ "));
+    msg.control.print(systemConfig.buses.i2c_clock);
+    msg.control.println(F("kHz) ==="));
+
+    for (uint8_t addr = SCAN_FIRST; addr <= SCAN_LAST; addr++) {
+        uint8_t status = i2cProbe(addr);
+        if (status == I2C_BUS_STUCK) {
+            msg.control.println(F("ERROR: I2C bus stuck - BUS I2C RECOVER, then scan again"));
+            return;
+        }
+        if (status != I2C_OK) continue;
+        found[addr >> 3] |= (uint8_t)(1 << (addr & 7));
+        count++;
+
+        msg.control.print(F("  0x"));
+        if (addr < 0x10) msg.control.print(F("0"));
+        msg.control.print(addr, HEX);
+        for (uint8_t k = 0; k < NUM_KINDS; k++) {
+            if (addr >= KINDS[k].first && addr <= KINDS[k].last) {
+                msg.control.print(F("  "));
+                msg.control.print(KINDS[k].name);
+            }
+        }
+        if (addr == systemConfig.lcdI2CAddress) msg.control.print(F("  LCD"));
+        msg.control.println();
+    }
+    msg.control.print(count);
+    msg.control.print(F(" devices in "));
+    msg.control.print(millis() - start);
+    msg.control.println(F(" ms"));
+
+    // Records on this bus: kept if still answering, moved to a free address
+    // of their kind that answers, else absent
+    uint8_t bus = getActiveI2CId();
+    uint8_t updated = 0;
+    for (uint8_t i = 0; i < DEVICE_INVENTORY_SLOTS; i++) {
+        InventoryEntry* e = &systemConfig.inventory[i];
+        const DeviceKindInfo* info = kindInfo(e->kind);
+        if (!info || (e->unit & 0x0F) != bus) continue;
+
+        uint8_t address = INVENTORY_ABSENT;
+        if (e->address != INVENTORY_ABSENT && (found[e->address >> 3] & (1 << (e->address & 7)))) {
+            address = e->address;
+        } else {
+            for (uint8_t a = info->first; a <= info->last && address == INVENTORY_ABSENT; a++) {
+                if (!(found[a >> 3] & (1 << (a & 7)))) continue;
+                bool claimed = false;
+                for (uint8_t j = 0; j < DEVICE_INVENTORY_SLOTS; j++) {
+                    const InventoryEntry* other = &systemConfig.inventory[j];
+                    if (j != i && other->kind == e->kind && (other->unit & 0x0F) == bus && other->address == a) claimed = true;
+                }
+                if (!claimed) address = a;
+            }
+        }
+        if (setEntry(e, address)) updated++;
+    }
+
+    if (updated > 0) {
+        msg.control.print(updated);
+        msg.control.println(F(" inventory records updated - used from the next boot"));
+        msg.control.println(F("Use SAVE to persist"));
+    }
+}
+
+void printDeviceInventory() {
+    msg.control.println(F("Device inventory:"));
+    uint8_t shown = 0;
+    for (uint8_t i = 0; i < DEVICE_INVENTORY_SLOTS; i++) {
+        const InventoryEntry* e = &systemConfig.inventory[i];
+        const DeviceKindInfo* info = kindInfo(e->kind);
+        if (!info) continue;
+        shown++;
+        msg.control.print(F("  "));
+        msg.control.print(info->name);
+        msg.control.print(F(" #"));
+        msg.control.print(e->unit >> 4);
+        msg.control.print(F("  I2C:"));
+        msg.control.print(e->unit & 0x0F);
+        if (e->address == INVENTORY_ABSENT) {
+            msg.control.print(F("  absent"));
+        } else {
+            msg.control.print(F("  0x"));
+            if (e->address < 0x10) msg.control.print(F("0"));
+            msg.control.print(e->address, HEX);
+        }
+        msg.control.print(F(" @ "));
+        msg.control.print(e->speed * 100);
+        msg.control.println(F("kHz"));
+    }
+    if (shown == 0) msg.control.println(F("  (none - drivers record their probes at boot)"));
+}
+
+#endif // USE_STATIC_CONFIG
@@ -0,0 +1,96 @@
+/*
+ * device_inventory.h - Detected bus devices, kept with the system config
+ *
+ * Optional hardware is found by probing at boot: the BME280 tries 0x76,
+ * then 0x77; each ADS1115 is written at its build-flag address. A device
+ * that is not fitted costs its probes at every boot, and on a bus that
+ * misbehaves each probe can run into the I2C timeout.
+ *
+ * The inventory records what the probes found - device kind, bus, address
+ * and bus clock - in SystemConfig (DEVICE_INVENTORY_SLOTS entries of 4
+ * bytes). At boot a driver asks for its record first:
+ *
+ *   Recorded present  Verify with one transaction at the recorded address;
+ *                     the full probe only runs if that fails
+ *   Recorded absent   Skip the probe - the device was not there last time
+ *   No record         Full probe (first boot, another bus or clock)
+ *
+ * and records the result. At the end of setup() the inventory is written
+ * if it changed (only the changed bytes, eeprom_store.h) - unless the
+ * system config in EEPROM isn't valid, in which case it waits for SAVE.
+ *
+ * Absent records only apply at boot: a sensor SET at the prompt always
+ * runs its full probe. BUS I2C SCAN probes every address on the active
+ * bus, lists what answers and brings the records up to date - a device
+ * fitted since it was recorded absent is used from the next boot.
+ *
+ * Usage:
+ *   uint8_t addr = inventoryRecall(DEVICE_BME280, 0);
+ *   if (addr == INVENTORY_ABSENT) return;             // Not fitted last boot
+ *   if (addr == INVENTORY_UNKNOWN || !verify(addr)) addr = fullProbe();
+ *   inventoryRecord(DEVICE_BME280, 0, addr);          // Or INVENTORY_ABSENT
+ *   commitDeviceInventory();                          // setup(), after the probes
+ *
+ * Build Flags:
+ *   -D DEVICE_INVENTORY_SLOTS=n  - Devices recorded (default 6; part of the config layout)
+ */
+
+#ifndef DEVICE_INVENTORY_H
+#define DEVICE_INVENTORY_H
+
+#include <Arduino.h>
+
+#ifndef DEVICE_INVENTORY_SLOTS
+#define DEVICE_INVENTORY_SLOTS 6
+#endif
+
+// Device kinds with a record (0 = empty slot)
+enum DeviceKind : uint8_t {
+    DEVICE_NONE = 0,
+    DEVICE_BME280,
+    DEVICE_ADS1115
+};
+
+// inventoryRecall() answers besides an address
+#define INVENTORY_ABSENT  0x00      // Probed at the last boot, not found
+#define INVENTORY_UNKNOWN 0xFF      // No record for this bus and clock - run the full probe
+
+// One device (4 bytes, SystemConfig::inventory)
+struct InventoryEntry {
+    uint8_t kind;       // DeviceKind
+    uint8_t unit;       // Which one of its kind (high nibble), I2C bus id (low nibble)
+    uint8_t address;    // 7-bit address (INVENTORY_ABSENT: not found)
+    uint8_t speed;      // Bus clock when recorded, 100 kHz units
+};
+
+#ifndef USE_STATIC_CONFIG
+
+/**
+ * What the inventory knows about a device on the active I2C bus
+ * @param index  Which one of its kind (ADS1115: chip 0 or 1)
+ * @return Its address, INVENTORY_ABSENT (at boot only) or INVENTORY_UNKNOWN
+ */
+uint8_t inventoryRecall(DeviceKind kind, uint8_t index);
+
+// Record a probe's result (INVENTORY_ABSENT if nothing answered)
+void inventoryRecord(DeviceKind kind, uint8_t index, uint8_t address);
+
+// End of boot: write the records if they changed, absent records stop applying
+void commitDeviceInventory();
+
+// Probe every address on the active bus, list them, update the records (BUS I2C SCAN)
+void scanI2CBus();
+
+// Recorded devices (BUS I2C)
+void printDeviceInventory();
+
+#else
+
+// Compile-time config: nothing persists, every boot probes
+inline uint8_t inventoryRecall(DeviceKind, uint8_t) { return INVENTORY_UNKNOWN; }
+inline void inventoryRecord(DeviceKind, uint8_t, uint8_t) {}
+inline void commitDeviceInventory() {}
+
+#endif // USE_STATIC_CONFIG
+
+#endif // DEVICE_INVENTORY_H
@@ -9,6 +9,7 @@
 #include "system_config.h"
 #include "message_api.h"
 #include "log_tags.h"
+#include "button_handler.h"
 
 // Display control functions from display modules
 extern void enableLCD();
@@ -18,7 +19,14 @@ extern void disableLCD();
 // This is NEVER saved to EEPROM - resets to systemConfig default at boot
 static bool displayRuntimeState = true;
 
+// Long press toggles the display (button_handler.h)
+static void onDisplayButton(ButtonPress event) {
+    if (event == BUTTON_LONG_PRESS) toggleDisplayRuntime();
+}
+
 void initDisplayManager() {
+    subscribeButton(onDisplayButton);
+
     // Initialize runtime state from persistent config
     displayRuntimeState = systemConfig.displayEnabled;
 
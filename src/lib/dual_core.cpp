@@ -0,0 +1,102 @@
+/*
+ * dual_core.cpp - Acquisition and communications on separate ESP32 cores
+ */
+
+#include "dual_core.h"
+
+#ifdef ENABLE_DUAL_CORE
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include "scheduler.h"
+#include "../outputs/output_base.h"
+#ifndef USE_STATIC_CONFIG
+#include "system_mode.h"
+#endif
+
+static portMUX_TYPE sharedLock = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t outputMutex = nullptr;
+static TaskHandle_t acquisitionTask = nullptr;
+
+static volatile bool passActive = false;   // Set before the mode check, cleared after the pass
+static volatile uint32_t lastPassMs = 0;
+
+static bool inRunMode() {
+#ifndef USE_STATIC_CONFIG
+    return !isInConfigMode();
+#else
+    return true;
+#endif
+}
+
+static void acquisitionTaskMain(void* arg) {
+    (void)arg;
+    while (true) {
+        passActive = true;
+        if (inRunMode()) {
+            uint32_t now = millis();
+            runPriority(now, PRIORITY_SAFETY);
+            updateOutputClass(PRIORITY_SAFETY);
+        }
+        passActive = false;
+        lastPassMs = millis();
+
+        // Sleep to the next safety deadline - at least one tick, so the
+        // lower-priority tasks on this core (idle, its watchdog) always run
+        uint32_t now = millis();
+        int32_t wait = (int32_t)(getPriorityDeadline(now, PRIORITY_SAFETY) - now);
+        TickType_t ticks = wait > 0 ? pdMS_TO_TICKS(wait) : 0;
+        vTaskDelay(ticks > 0 ? ticks : 1);
+    }
+}
+
+bool startAcquisitionCore() {
+    if (acquisitionTask != nullptr) return true;
+    if (outputMutex == nullptr) {
+        outputMutex = xSemaphoreCreateRecursiveMutex();
+        if (outputMutex == nullptr) return false;
+    }
+
+    detachPriority(PRIORITY_SAFETY, true);
+    lastPassMs = millis();
+    if (xTaskCreatePinnedToCore(acquisitionTaskMain, "acquire", DUAL_CORE_ACQ_STACK, nullptr,
+                                DUAL_CORE_ACQ_PRIORITY, &acquisitionTask, DUAL_CORE_ACQ_CORE) != pdPASS) {
+        acquisitionTask = nullptr;
+        detachPriority(PRIORITY_SAFETY, false);  // loop() keeps it
+        return false;
+    }
+    return true;
+}
+
+void syncAcquisitionCore() {
+    if (acquisitionTask == nullptr) return;
+    while (passActive) vTaskDelay(1);
+}
+
+bool acquisitionCoreAlive() {
+    if (acquisitionTask == nullptr) return true;
+    return millis() - lastPassMs < DUAL_CORE_STALL_MS;
+}
+
+bool onAcquisitionCore() {
+    return acquisitionTask != nullptr && xTaskGetCurrentTaskHandle() == acquisitionTask;
+}
+
+void dualCoreLock() {
+    portENTER_CRITICAL(&sharedLock);
+}
+
+void dualCoreUnlock() {
+    portEXIT_CRITICAL(&sharedLock);
+}
+
+void dualCoreOutputLock() {
+    if (outputMutex != nullptr) xSemaphoreTakeRecursive(outputMutex, portMAX_DELAY);
+}
+
+void dualCoreOutputUnlock() {
+    if (outputMutex != nullptr) xSemaphoreGiveRecursive(outputMutex);
+}
+
+#endif // ENABLE_DUAL_CORE
@@ -0,0 +1,96 @@
+/*
+ * dual_core.h - Acquisition and communications on separate ESP32 cores
+ *
+ * By default everything runs in loop() on one core. With ENABLE_DUAL_CORE the
+ * safety class - the ADC scan, input reads, alarm evaluation and the alarm
+ * and relay output modules - leaves loop() for a FreeRTOS task pinned to the
+ * other core at a higher priority. loop() keeps the rest on the Arduino core:
+ * transports and the CLI, CAN, and the telemetry and cosmetic classes
+ * (RealDash, serial, SD, LCD). A slow SD write or a stalled BLE notification
+ * then no longer delays an alarm check.
+ *
+ * What the two sides share, and how:
+ *   - the input snapshot (input_snapshot.h)   published and taken under the spinlock
+ *   - the scheduler heaps (scheduler.h)       a sensor pass wakes change-driven outputs
+ *   - the message planes (message_api.h)      each write holds the output mutex
+ * Input::value and the CAN frame cache are read as single 32-bit words, and
+ * the ESP32 core serialises SPI and I2C transactions with its bus locks.
+ *
+ * The acquisition task only runs passes in RUN mode: entering CONFIG mode
+ * waits for the pass in progress (syncAcquisitionCore()). loop() feeds the
+ * watchdog only while the task keeps completing passes, so a hung
+ * acquisition core resets the board like a hung loop.
+ *
+ * Usage:
+ *   startAcquisitionCore();                  // setup(), after the tasks are registered
+ *   if (acquisitionCoreAlive()) watchdogReset();
+ *   dualCoreLock(); ... dualCoreUnlock();    // A few instructions of shared state
+ *
+ * Build Flags:
+ *   -D ENABLE_DUAL_CORE             - Split acquisition and communications (dual-core ESP32 only)
+ *   -D DUAL_CORE_ACQ_CORE=n         - Acquisition core (default: the one loop() isn't on)
+ *   -D DUAL_CORE_ACQ_PRIORITY=n     - Acquisition task priority (default 5; loop() is 1)
+ *   -D DUAL_CORE_ACQ_STACK=n        - Acquisition task stack bytes (default 4096)
+ *   -D DUAL_CORE_STALL_MS=n         - No pass for this long stops feeding the watchdog (default 1000)
+ */
+
+#ifndef DUAL_CORE_H
+#define DUAL_CORE_H
+
+#include <Arduino.h>
+
+#ifdef ENABLE_DUAL_CORE
+
+#if !defined(ESP32) || defined(CONFIG_FREERTOS_UNICORE)
+#error "ENABLE_DUAL_CORE needs a dual-core ESP32 (ESP32, ESP32-S3)"
+#endif
+
+#ifndef DUAL_CORE_ACQ_CORE
+#define DUAL_CORE_ACQ_CORE (ARDUINO_RUNNING_CORE ^ 1)
+#endif
+
+#ifndef DUAL_CORE_ACQ_PRIORITY
+#define DUAL_CORE_ACQ_PRIORITY 5
+#endif
+
+#ifndef DUAL_CORE_ACQ_STACK
+#define DUAL_CORE_ACQ_STACK 4096
+#endif
+
+#ifndef DUAL_CORE_STALL_MS
+#define DUAL_CORE_STALL_MS 1000
+#endif
+
+// Hand the safety class to the acquisition task and start it
+bool startAcquisitionCore();
+
+// Wait for the acquisition pass in progress (entering CONFIG mode)
+void syncAcquisitionCore();
+
+// Acquisition task completed a pass within DUAL_CORE_STALL_MS
+bool acquisitionCoreAlive();
+
+// Caller is the acquisition task
+bool onAcquisitionCore();
+
+// Spinlock for short shared-state sections (no blocking calls inside)
+void dualCoreLock();
+void dualCoreUnlock();
+
+// Output mutex held across a transport write (recursive)
+void dualCoreOutputLock();
+void dualCoreOutputUnlock();
+
+struct DualCoreOutputGuard {
+    DualCoreOutputGuard() { dualCoreOutputLock(); }
+    ~DualCoreOutputGuard() { dualCoreOutputUnlock(); }
+};
+
+#else
+
+inline void dualCoreLock() {}
+inline void dualCoreUnlock() {}
+
+#endif // ENABLE_DUAL_CORE
+
+#endif // DUAL_CORE_H
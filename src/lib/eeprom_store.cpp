@@ -0,0 +1,221 @@
+/*
+ * eeprom_store.cpp - Delta-only, background EEPROM writes for the config
+ *
+ * image[] holds the config area as it will be once the queue is written;
+ * dirty[] marks (one bit per byte) what differs from EEPROM. The writer
+ * walks the marks downward from cursor, so a batch ends at address 0 - the
+ * input header, whose CRC covers the rest.
+ */
+
+#include "eeprom_store.h"
+#include "message_api.h"
+#include "config_log.h"
+#include "memory_report.h"
+#include <EEPROM.h>
+
+#define NUM_REGIONS ((EEPROM_STORE_BYTES + EEPROM_STORE_REGION_BYTES - 1) / EEPROM_STORE_REGION_BYTES)
+
+static uint16_t covered;                    // Bytes of the config area this EEPROM has
+
+#if EEPROM_STORE_IMAGE
+static uint8_t image[EEPROM_STORE_BYTES];
+static uint8_t dirty[(EEPROM_STORE_BYTES + 7) / 8];
+static uint16_t pending;                    // Marked bytes
+static uint16_t cursor;                     // One above the next address to check
+static uint32_t lastChangeMs;
+static uint16_t batches;
+static bool writing;                        // A batch has started reaching EEPROM
+#endif
+
+static uint16_t regionWrites[NUM_REGIONS];  // Bytes written per region (saturating)
+static uint32_t bytesWritten;
+static uint32_t bytesUnchanged;             // Saved with the value already there
+
+// Write one byte if EEPROM doesn't already hold it; true if it was written
+static bool writeByte(uint16_t addr, uint8_t value) {
+    if (EEPROM.read(addr) == value) return false;
+    EEPROM.write(addr, value);
+    bytesWritten++;
+    uint16_t& count = regionWrites[addr / EEPROM_STORE_REGION_BYTES];
+    if (count < 0xFFFF) count++;
+    return true;
+}
+
+void initEEPROMStore() {
+#if defined(ESP32)
+    EEPROM.begin(EEPROM_STORE_ESP32_BYTES);
+#endif
+    uint32_t length = EEPROM.length();
+    covered = (length < EEPROM_STORE_BYTES) ? length : EEPROM_STORE_BYTES;
+
+#if EEPROM_STORE_IMAGE
+    for (uint16_t addr = 0; addr < covered; addr++) {
+        image[addr] = EEPROM.read(addr);
+    }
+    memset(dirty, 0, sizeof(dirty));
+    pending = 0;
+    cursor = 0;
+    noteStaticMemory(F("EEPROM image"), sizeof(image) + sizeof(dirty));
+#endif
+}
+
+void eepromStoreRead(uint16_t addr, void* data, uint16_t len) {
+    uint8_t* bytes = (uint8_t*)data;
+    for (uint16_t k = 0; k < len; k++) {
+        bytes[k] = eepromStoreReadByte(addr + k);
+    }
+}
+
+uint8_t eepromStoreReadByte(uint16_t addr) {
+#if EEPROM_STORE_IMAGE
+    if (addr < covered) return image[addr];
+#endif
+    return EEPROM.read(addr);
+}
+
+uint16_t eepromStoreWrite(uint16_t addr, const void* data, uint16_t len) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint16_t changed = 0;
+
+    for (uint16_t k = 0; k < len; k++) {
+        uint16_t a = addr + k;
+#if EEPROM_STORE_IMAGE
+        if (a < covered) {
+            if (image[a] == bytes[k]) {
+                bytesUnchanged++;
+                continue;
+            }
+            image[a] = bytes[k];
+            uint8_t bit = 1 << (a & 7);
+            if (!(dirty[a >> 3] & bit)) {
+                dirty[a >> 3] |= bit;
+                pending++;
+            }
+            changed++;
+            continue;
+        }
+#endif
+        if (writeByte(a, bytes[k])) changed++;
+        else bytesUnchanged++;
+    }
+
+#if EEPROM_STORE_IMAGE
+    if (changed) lastChangeMs = millis();
+#endif
+    return changed;
+}
+
+#if EEPROM_STORE_IMAGE
+// Unmark and write the next marked byte below cursor; true if EEPROM changed
+static bool writeNextQueued() {
+    while (pending > 0) {
+        if (cursor == 0) cursor = covered;
+        cursor--;
+        if ((cursor & 7) == 7 && dirty[cursor >> 3] == 0) {
+            cursor -= 7;                    // Nothing marked in this byte of dirty[]
+            continue;
+        }
+        uint8_t bit = 1 << (cursor & 7);
+        if (!(dirty[cursor >> 3] & bit)) continue;
+        dirty[cursor >> 3] &= ~bit;
+        pending--;
+        return writeByte(cursor, image[cursor]);
+    }
+    return false;
+}
+
+static void endBatch() {
+#if defined(ESP32)
+    EEPROM.commit();                        // One sector rewrite for the whole batch
+#endif
+    writing = false;
+    batches++;
+}
+#endif
+
+void updateEEPROMStore(uint32_t now) {
+#if EEPROM_STORE_IMAGE
+    if (pending == 0 || now - lastChangeMs < EEPROM_STORE_COMMIT_MS) return;
+
+    writing = true;
+    uint8_t budget = EEPROM_STORE_BYTES_PER_UPDATE;
+    while (budget > 0 && pending > 0) {
+        if (writeNextQueued()) budget--;    // Bytes EEPROM already holds cost nothing
+    }
+    if (pending == 0) endBatch();
+#else
+    (void)now;
+#endif
+}
+
+void flushEEPROMStore() {
+#if EEPROM_STORE_IMAGE
+    if (pending == 0) return;
+    while (pending > 0) writeNextQueued();
+    endBatch();
+#endif
+}
+
+bool isEEPROMStoreWriting() {
+#if EEPROM_STORE_IMAGE
+    return writing;
+#else
+    return false;
+#endif
+}
+
+uint16_t getEEPROMStorePending() {
+#if EEPROM_STORE_IMAGE
+    return pending;
+#else
+    return 0;
+#endif
+}
+
+void printEEPROMStoreStatus() {
+    msg.control.println();
+    msg.control.println(F("===== EEPROM Store ====="));
+    msg.control.print(F("  Config area: "));
+    msg.control.print(covered);
+#if EEPROM_STORE_IMAGE
+    msg.control.println(F(" bytes (RAM image, background writes)"));
+    msg.control.print(F("  Queued: "));
+    msg.control.print(pending);
+    msg.control.println(F(" bytes"));
+#else
+    msg.control.println(F(" bytes (written through)"));
+#endif
+    msg.control.print(F("  Since boot: "));
+    msg.control.print(bytesWritten);
+    msg.control.print(F(" bytes written, "));
+    msg.control.print(bytesUnchanged);
+    msg.control.print(F(" unchanged"));
+#if EEPROM_STORE_IMAGE
+    msg.control.print(F(", "));
+    msg.control.print(batches);
+    msg.control.print(F(" batches"));
+#endif
+    msg.control.println();
+#ifdef ENABLE_CONFIG_LOG
+    msg.control.print(F("  Config log: "));
+    msg.control.print(configLogUsed());
+    msg.control.print(F("/"));
+    msg.control.print(CONFIG_LOG_BYTES);
+    msg.control.print(F(" bytes, generation "));
+    msg.control.println(configLogGeneration());
+#endif
+
+    msg.control.println(F("  Writes by region:"));
+    bool any = false;
+    char line[32];
+    for (uint16_t r = 0; r < NUM_REGIONS; r++) {
+        if (regionWrites[r] == 0) continue;
+        uint16_t start = r * EEPROM_STORE_REGION_BYTES;
+        snprintf(line, sizeof(line), "    0x%04X-0x%04X  %u", start,
+                 start + EEPROM_STORE_REGION_BYTES - 1, regionWrites[r]);
+        msg.control.println(line);
+        any = true;
+    }
+    if (!any) msg.control.println(F("    (none)"));
+    msg.control.println();
+}
@@ -0,0 +1,111 @@
+/*
+ * eeprom_store.h - Delta-only, background EEPROM writes for the config
+ *
+ * The input and system config (EEPROM addresses 0 to the end of SystemConfig)
+ * are read and written through a RAM image of that area. A write compares
+ * against the image and only marks the bytes that differ; SAVE returns as
+ * soon as the image is updated. updateEEPROMStore() writes the marked bytes
+ * a few per loop, starting EEPROM_STORE_COMMIT_MS after the last change so
+ * the writes of one SAVE (inputs, index cache, rules, system config) go out
+ * as one batch. On ESP32 a batch ends with one EEPROM.commit() - one sector
+ * rewrite per batch instead of per put().
+ *
+ * Reads see queued bytes, so a load or CRC check right after a save reads
+ * what was saved. A power loss before the batch is written loses that save;
+ * a partly written one reads back as a CRC mismatch, as a power loss
+ * mid-SAVE always did. flushEEPROMStore() writes everything now - reboots
+ * call it.
+ *
+ * Wear accounting: bytes written to each EEPROM_STORE_REGION_BYTES region
+ * since boot, and the bytes saves left unchanged (SYSTEM EEPROM).
+ *
+ * Without the image (EEPROM_STORE_IMAGE 0, the AVR default - 1 KB+ of RAM)
+ * writes still skip unchanged bytes, but block as before.
+ *
+ * Addresses past the config area (the alarm journal) pass straight through.
+ *
+ * Usage:
+ *   initEEPROMStore();                  // setup(), before any config load
+ *   eepromPut(addr, header);            // Instead of EEPROM.put
+ *   eepromGet(addr, header);            // Instead of EEPROM.get
+ *   updateEEPROMStore(now);             // every loop
+ *
+ * Build Flags:
+ *   -D EEPROM_STORE_IMAGE=0|1           - RAM image and background writes (default 1; 0 on AVR)
+ *   -D EEPROM_STORE_COMMIT_MS=n         - Quiet time before a batch is written (default 250)
+ *   -D EEPROM_STORE_BYTES_PER_UPDATE=n  - Bytes written per loop (default 16)
+ *   -D EEPROM_STORE_REGION_BYTES=n      - Wear accounting granularity (default 64)
+ *   -D EEPROM_STORE_ESP32_BYTES=n       - EEPROM.begin() size on ESP32 (default 4096)
+ */
+
+#ifndef EEPROM_STORE_H
+#define EEPROM_STORE_H
+
+#include <Arduino.h>
+#include "system_config.h"
+
+#ifndef EEPROM_STORE_IMAGE
+#if defined(__AVR__)
+#define EEPROM_STORE_IMAGE 0
+#else
+#define EEPROM_STORE_IMAGE 1
+#endif
+#endif
+
+#ifndef EEPROM_STORE_COMMIT_MS
+#define EEPROM_STORE_COMMIT_MS 250
+#endif
+
+#ifndef EEPROM_STORE_BYTES_PER_UPDATE
+#define EEPROM_STORE_BYTES_PER_UPDATE 16
+#endif
+
+#ifndef EEPROM_STORE_REGION_BYTES
+#define EEPROM_STORE_REGION_BYTES 64
+#endif
+
+#ifndef EEPROM_STORE_ESP32_BYTES
+#define EEPROM_STORE_ESP32_BYTES 4096
+#endif
+
+// Config area covered by the store
+#define EEPROM_STORE_BYTES (SYSTEM_CONFIG_ADDRESS + SYSTEM_CONFIG_SIZE)
+
+// Load the image (ESP32: begin the EEPROM emulation first)
+void initEEPROMStore();
+
+// Copy len bytes at addr, queued writes included
+void eepromStoreRead(uint16_t addr, void* data, uint16_t len);
+
+// Queue the bytes that differ; returns how many did
+uint16_t eepromStoreWrite(uint16_t addr, const void* data, uint16_t len);
+
+uint8_t eepromStoreReadByte(uint16_t addr);
+
+template <typename T>
+T& eepromGet(uint16_t addr, T& value) {
+    eepromStoreRead(addr, &value, sizeof(T));
+    return value;
+}
+
+template <typename T>
+uint16_t eepromPut(uint16_t addr, const T& value) {
+    return eepromStoreWrite(addr, &value, sizeof(T));
+}
+
+// Write queued bytes, a few per call, once the writes have gone quiet
+void updateEEPROMStore(uint32_t now);
+
+// Write every queued byte now (blocking - before a reboot)
+void flushEEPROMStore();
+
+// A batch is partly written - stopping now leaves it torn (lib/power_fail.h)
+bool isEEPROMStoreWriting();
+
+// Bytes queued and not yet in EEPROM
+uint16_t getEEPROMStorePending();
+
+// Queue and wear counters (SYSTEM EEPROM)
+void printEEPROMStoreStatus();
+
+#endif // EEPROM_STORE_H
@@ -0,0 +1,499 @@
+/*
+ * ext_adc.cpp - External multi-channel ADC drivers (MCP3208, ADS1115)
+ */
+
+#include "ext_adc.h"
+
+#ifdef ENABLE_EXT_ADC
+
+#include <SPI.h>
+#include <math.h>
+#include "bus_manager.h"
+#include "i2c_engine.h"
+#include "device_inventory.h"
+#include "pin_registry.h"
+#include "message_api.h"
+#include "log_tags.h"
+#include "isr_profile.h"
+
+struct ExtAdcChannel {
+    float counts;           // Native counts, fraction kept
+    uint32_t updatedMs;     // millis() of the sample
+    bool valid;
+};
+
+static ExtAdcChannel channels[EXT_ADC_CHANNELS];
+static uint16_t registeredMask = 0;     // Channels read since the last reset
+
+static void storeSample(uint8_t ch, float counts, uint32_t now) {
+    channels[ch].counts = counts;
+    channels[ch].updatedMs = now;
+    channels[ch].valid = true;
+}
+
+// ===== MCP3208 (SPI) =====
+
+#ifdef EXT_ADC_MCP3208_CS
+
+static const SPISettings MCP3208_SPI_SETTINGS(EXT_ADC_MCP3208_SPI_HZ, MSBFIRST, SPI_MODE0);
+
+// Native counts per summed MCP3208 count
+static const float MCP3208_SCALE =
+    (float)EXT_ADC_MCP3208_VREF / AREF_VOLTAGE * ADC_MAX_VALUE / 4095.0f / EXT_ADC_OVERSAMPLE;
+
+#define MCP3208_MASK 0x00FF              // ADC:0-7
+#define MCP3208_MAX_AGE_MS (4UL * EXT_ADC_SCAN_INTERVAL_MS)
+
+static uint32_t mcpNextDue = 0;
+static uint32_t mcpBatches = 0;
+
+// One conversion: start bit, single-ended, channel in D2-D0; 12 bits back
+// (caller holds the transaction)
+static uint16_t mcp3208Convert(SPIClass* spi, uint8_t ch) {
+    uint8_t buf[3] = { (uint8_t)(0x06 | (ch >> 2)), (uint8_t)((ch & 0x03) << 6), 0 };
+    digitalWrite(EXT_ADC_MCP3208_CS, LOW);
+    spi->transfer(buf, 3);
+    digitalWrite(EXT_ADC_MCP3208_CS, HIGH);
+    return ((uint16_t)(buf[1] & 0x0F) << 8) | buf[2];
+}
+
+static float mcp3208Sample(SPIClass* spi, uint8_t ch) {
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < EXT_ADC_OVERSAMPLE; i++) {
+        sum += mcp3208Convert(spi, ch);
+    }
+    return sum * MCP3208_SCALE;
+}
+
+// Every channel in use, back to back in one transaction
+static uint32_t updateMCP3208(uint32_t now) {
+    uint8_t mask = registeredMask & MCP3208_MASK;
+    if (mask == 0) return now + EXT_ADC_IDLE_MS;
+    if ((int32_t)(now - mcpNextDue) < 0) return mcpNextDue;
+
+    SPIClass* spi = spiBegin(SPI_CLIENT_EXT_ADC, MCP3208_SPI_SETTINGS);
+    for (uint8_t ch = 0; ch < 8; ch++) {
+        if (mask & (1 << ch)) {
+            storeSample(EXT_ADC_MCP3208_FIRST + ch, mcp3208Sample(spi, ch), now);
+        }
+    }
+    spiEnd(SPI_CLIENT_EXT_ADC);
+    mcpBatches++;
+
+    mcpNextDue += EXT_ADC_SCAN_INTERVAL_MS;
+    if ((int32_t)(now - mcpNextDue) >= 0) {
+        mcpNextDue = now + EXT_ADC_SCAN_INTERVAL_MS;
+    }
+    spiSetNextDue(SPI_CLIENT_EXT_ADC, mcpNextDue);  // SD writes keep clear of it
+    return mcpNextDue;
+}
+
+static float readMCP3208Now(uint8_t ch) {
+    SPIClass* spi = spiBegin(SPI_CLIENT_EXT_ADC, MCP3208_SPI_SETTINGS);
+    float counts = mcp3208Sample(spi, ch - EXT_ADC_MCP3208_FIRST);
+    spiEnd(SPI_CLIENT_EXT_ADC);
+    storeSample(ch, counts, millis());
+    return counts;
+}
+
+#endif // EXT_ADC_MCP3208_CS
+
+// ===== ADS1115 (I2C) =====
+
+#if defined(EXT_ADC_ADS1115_ADDR) || defined(EXT_ADC_ADS1115_ADDR2)
+#define EXT_ADC_HAS_ADS1115
+
+#define ADS1115_REG_CONVERSION  0x00
+#define ADS1115_REG_CONFIG      0x01
+#define ADS1115_REG_LO_THRESH   0x02
+#define ADS1115_REG_HI_THRESH   0x03
+
+#define ADS1115_NO_ALERT        0xFF
+
+// Config register fields for the build's range and rate
+static constexpr uint8_t adsPgaCode(uint16_t mv) {
+    return mv >= 6144 ? 0 : mv >= 4096 ? 1 : mv >= 2048 ? 2 : mv >= 1024 ? 3 : mv >= 512 ? 4 : 5;
+}
+static constexpr uint8_t adsRateCode(uint16_t sps) {
+    return sps <= 8 ? 0 : sps <= 16 ? 1 : sps <= 32 ? 2 : sps <= 64 ? 3 :
+           sps <= 128 ? 4 : sps <= 250 ? 5 : sps <= 475 ? 6 : 7;
+}
+
+static const uint16_t ADS1115_FSR_MV[] = {6144, 4096, 2048, 1024, 512, 256};
+static const uint16_t ADS1115_RATES[] = {8, 16, 32, 64, 128, 250, 475, 860};
+
+#define ADS1115_PGA  adsPgaCode(EXT_ADC_ADS1115_FSR_MV)
+#define ADS1115_RATE adsRateCode(EXT_ADC_ADS1115_SPS)
+
+// Continuous mode; the comparator set up as conversion-ready signal
+// (thresholds below) pulses ALERT/RDY low after every conversion
+static constexpr uint16_t adsConfig(uint8_t ain) {
+    return ((uint16_t)(0x4 + ain) << 12)          // MUX: AINn vs GND
+         | ((uint16_t)ADS1115_PGA << 9)
+         | ((uint16_t)ADS1115_RATE << 5);           // MODE 0, COMP_QUE 00
+}
+
+// Conversion period with the oscillator's 10% tolerance
+#define ADS1115_PERIOD_US (1100000UL / ADS1115_RATES[ADS1115_RATE])
+#define ADS1115_PERIOD_MS ((ADS1115_PERIOD_US + 999) / 1000)
+#define ADS1115_NOMINAL_MS (1000U / ADS1115_RATES[ADS1115_RATE])  // 1 at 860 SPS
+
+// A full four-channel rotation twice, plus a task pass
+#define ADS1115_MAX_AGE_MS (16UL * ADS1115_PERIOD_MS + EXT_ADC_SCAN_INTERVAL_MS)
+
+struct ADS1115Chip {
+    uint8_t address;
+    uint8_t first;              // Channel index of AIN0
+    uint8_t alertPin;           // ADS1115_NO_ALERT = timed fetches
+    bool present;
+    uint8_t ain;                // Input being converted
+    uint8_t discard;            // Conversions still to skip after a mux move
+    uint32_t lastMs;            // millis() of the last conversion handled or mux move
+    volatile uint8_t pulses;    // ALERT/RDY edges (ISR)
+    uint8_t seen;               // Edges handled
+    uint32_t samples;
+    uint32_t errors;            // I2C transactions that failed
+};
+
+static ADS1115Chip adsChips[] = {
+#ifdef EXT_ADC_ADS1115_ADDR
+    { EXT_ADC_ADS1115_ADDR, EXT_ADC_ADS1115_FIRST,
+  #ifdef EXT_ADC_ADS1115_ALERT_PIN
+      EXT_ADC_ADS1115_ALERT_PIN,
+  #else
+      ADS1115_NO_ALERT,
+  #endif
+      false, 0, 0, 0, 0, 0, 0, 0 },
+#endif
+#ifdef EXT_ADC_ADS1115_ADDR2
+    { EXT_ADC_ADS1115_ADDR2, EXT_ADC_ADS1115_FIRST + 4,
+  #ifdef EXT_ADC_ADS1115_ALERT_PIN2
+      EXT_ADC_ADS1115_ALERT_PIN2,
+  #else
+      ADS1115_NO_ALERT,
+  #endif
+      false, 0, 0, 0, 0, 0, 0, 0 },
+#endif
+};
+
+#define NUM_ADS1115 (sizeof(adsChips) / sizeof(adsChips[0]))
+
+// One trampoline per chip - attachInterrupt() takes no argument
+// (not a template: GCC drops the section of a template instance)
+#define ADS_ALERT_ISR(N) \
+    HAL_ISR static void adsAlertISR##N() { \
+        ISR_PROFILE_BEGIN(); \
+        adsChips[N % NUM_ADS1115].pulses++; \
+        ISR_PROFILE_END(ISR_PROF_EXT_ADC); \
+    }
+
+ADS_ALERT_ISR(0) ADS_ALERT_ISR(1)
+
+typedef void (*AlertISR)();
+static const AlertISR adsAlertISRs[2] = { adsAlertISR0, adsAlertISR1 };
+
+// Native counts per ADS1115 count (negative single-ended readings are noise at 0 V)
+static const float ADS1115_SCALE =
+    ADS1115_FSR_MV[ADS1115_PGA] / 1000.0f / 32768.0f / AREF_VOLTAGE * ADC_MAX_VALUE;
+
+// Transactions go through the I2C engine (bounded, counted per address)
+static bool adsWrite(ADS1115Chip* chip, uint8_t reg, uint16_t value) {
+    uint8_t buf[3] = { reg, (uint8_t)(value >> 8), (uint8_t)(value & 0xFF) };
+    if (i2cWrite(chip->address, buf, 3) == I2C_OK) return true;
+    chip->errors++;
+    return false;
+}
+
+// Point at the conversion register - every fetch after that is a bare 2-byte read
+static bool adsPointAtConversion(ADS1115Chip* chip) {
+    uint8_t reg = ADS1115_REG_CONVERSION;
+    if (i2cWrite(chip->address, &reg, 1) == I2C_OK) return true;
+    chip->errors++;
+    return false;
+}
+
+static bool adsFetch(ADS1115Chip* chip, float* counts) {
+    uint8_t buf[2];
+    if (i2cRead(chip->address, buf, 2) != I2C_OK) {
+        chip->errors++;
+        return false;
+    }
+    int16_t raw = (int16_t)(((uint16_t)buf[0] << 8) | buf[1]);
+    *counts = (raw > 0 ? raw : 0) * ADS1115_SCALE;
+    chip->samples++;
+    return true;
+}
+
+// Move the mux; the conversion under way finishes on the old input
+static void adsSelect(ADS1115Chip* chip, uint8_t ain, uint32_t now) {
+    if (adsWrite(chip, ADS1115_REG_CONFIG, adsConfig(ain))) {
+        adsPointAtConversion(chip);
+    }
+    chip->ain = ain;
+    chip->lastMs = now;
+    chip->seen = chip->pulses;
+    chip->discard = 1;
+}
+
+// Next input in use after the current one (the current one if it is alone)
+static uint8_t adsNextInput(const ADS1115Chip* chip) {
+    uint8_t mask = (registeredMask >> chip->first) & 0x0F;
+    for (uint8_t step = 1; step <= 4; step++) {
+        uint8_t ain = (chip->ain + step) & 0x03;
+        if (mask & (1 << ain)) return ain;
+    }
+    return chip->ain;
+}
+
+// Conversions finished since the last one handled
+static uint8_t adsFinished(ADS1115Chip* chip, uint32_t now) {
+    uint32_t elapsed = now - chip->lastMs;
+    if (chip->alertPin != ADS1115_NO_ALERT) {
+        uint8_t pulses = chip->pulses - chip->seen;
+        if (pulses > 0) {
+            chip->seen += pulses;
+            return pulses;
+        }
+        // No edge for four periods - treat the pin as lost, fetch on time
+        if (elapsed < 4 * ADS1115_PERIOD_MS) return 0;
+    }
+    return elapsed / ADS1115_PERIOD_MS;
+}
+
+static uint32_t updateADS1115(ADS1115Chip* chip, uint32_t now) {
+    uint8_t mask = (registeredMask >> chip->first) & 0x0F;
+    if (!chip->present || mask == 0) return now + EXT_ADC_IDLE_MS;
+
+    uint8_t finished = adsFinished(chip, now);
+    if (finished > chip->discard) {
+        float counts;
+        if ((mask & (1 << chip->ain)) && adsFetch(chip, &counts)) {
+            storeSample(chip->first + chip->ain, counts, now);
+        }
+        uint8_t next = adsNextInput(chip);
+        if (next != chip->ain) {
+            adsSelect(chip, next, now);
+        } else {
+            chip->discard = 0;
+            chip->lastMs = now;
+        }
+    } else if (finished > 0) {
+        chip->discard -= finished;
+        chip->lastMs = now;
+    }
+
+    // With ALERT/RDY wired the task wakes when the conversion is expected
+    // and then only tests the edge counter (no bus traffic) until it comes;
+    // timed fetches wait out the period with its tolerance
+    if (chip->alertPin != ADS1115_NO_ALERT) {
+        uint32_t expected = chip->lastMs + ADS1115_NOMINAL_MS;
+        return (int32_t)(expected - now) > 0 ? expected : now + 1;
+    }
+    return chip->lastMs + ADS1115_PERIOD_MS;
+}
+
+static ADS1115Chip* findADS1115(uint8_t ch) {
+    for (uint8_t i = 0; i < NUM_ADS1115; i++) {
+        if (ch >= adsChips[i].first && ch < adsChips[i].first + 4) return &adsChips[i];
+    }
+    return nullptr;
+}
+
+// Move the mux and wait out the conversion under way and a fresh one
+static float readADS1115Now(ADS1115Chip* chip, uint8_t ch) {
+    if (!chip->present) return NAN;
+    adsSelect(chip, ch - chip->first, millis());
+    delay(2 * ADS1115_PERIOD_MS);
+
+    float counts;
+    uint32_t now = millis();
+    chip->seen = chip->pulses;
+    chip->discard = 0;
+    chip->lastMs = now;
+    if (!adsFetch(chip, &counts)) return NAN;
+    storeSample(ch, counts, now);
+    return counts;
+}
+
+static void initADS1115(ADS1115Chip* chip, uint8_t index) {
+    // Not fitted at the last boot (device_inventory.h) - no probe until BUS I2C SCAN
+    if (inventoryRecall(DEVICE_ADS1115, index) == INVENTORY_ABSENT) {
+        chip->present = false;
+        msg.debug.warn(TAG_ADC, "ADS1115 (0x%02X) not found at the last boot - ADC:%d-%d read NAN",
+                       chip->address, chip->first, chip->first + 3);
+        return;
+    }
+
+    // Conversion-ready mode: Hi_thresh MSB set, Lo_thresh MSB clear
+    chip->present = adsWrite(chip, ADS1115_REG_LO_THRESH, 0x0000) &&
+                    adsWrite(chip, ADS1115_REG_HI_THRESH, 0x8000);
+    inventoryRecord(DEVICE_ADS1115, index, chip->present ? chip->address : INVENTORY_ABSENT);
+    if (!chip->present) {
+        msg.debug.warn(TAG_ADC, "ADS1115 (0x%02X) not found - ADC:%d-%d read NAN",
+                       chip->address, chip->first, chip->first + 3);
+        return;
+    }
+    adsSelect(chip, 0, millis());
+
+    if (chip->alertPin != ADS1115_NO_ALERT) {
+        int irq = digitalPinToInterrupt(chip->alertPin);
+        if (irq == NOT_AN_INTERRUPT) {
+            msg.debug.warn(TAG_ADC, "Pin %d has no interrupt - ADS1115 uses timed reads", chip->alertPin);
+            chip->alertPin = ADS1115_NO_ALERT;
+        } else {
+            pinMode(chip->alertPin, INPUT_PULLUP);  // Open drain
+            registerPin(chip->alertPin, PIN_RESERVED, "ADS1115 ALERT");
+            attachInterrupt(irq, adsAlertISRs[index], FALLING);
+        }
+    }
+    msg.debug.info(TAG_ADC, "ADS1115 (0x%02X) on ADC:%d-%d, %u SPS, +/-%u mV%s",
+                   chip->address, chip->first, chip->first + 3,
+                   ADS1115_RATES[ADS1115_RATE], ADS1115_FSR_MV[ADS1115_PGA],
+                   chip->alertPin != ADS1115_NO_ALERT ? ", ALERT/RDY" : "");
+}
+
+#endif // EXT_ADC_ADS1115_ADDR || EXT_ADC_ADS1115_ADDR2
+
+// ===== COMMON =====
+
+static uint32_t maxAgeMs(uint8_t ch) {
+#if defined(EXT_ADC_MCP3208_CS) && defined(EXT_ADC_HAS_ADS1115)
+    return ch < EXT_ADC_ADS1115_FIRST ? MCP3208_MAX_AGE_MS : ADS1115_MAX_AGE_MS;
+#elif defined(EXT_ADC_HAS_ADS1115)
+    (void)ch;
+    return ADS1115_MAX_AGE_MS;
+#else
+    (void)ch;
+    return 4UL * EXT_ADC_SCAN_INTERVAL_MS;
+#endif
+}
+
+void initExtAdc() {
+#ifdef EXT_ADC_MCP3208_CS
+    pinMode(EXT_ADC_MCP3208_CS, OUTPUT);
+    digitalWrite(EXT_ADC_MCP3208_CS, HIGH);  // CS idle state is HIGH
+    registerPin(EXT_ADC_MCP3208_CS, PIN_CS, "MCP3208 CS");
+    msg.debug.info(TAG_ADC, "MCP3208 CS pin %d on ADC:0-7", EXT_ADC_MCP3208_CS);
+#endif
+#ifdef EXT_ADC_HAS_ADS1115
+    for (uint8_t i = 0; i < NUM_ADS1115; i++) {
+        initADS1115(&adsChips[i], i);
+    }
+#endif
+}
+
+uint32_t updateExtAdc(uint32_t now) {
+    uint32_t next = now + EXT_ADC_IDLE_MS;
+#ifdef EXT_ADC_MCP3208_CS
+    uint32_t due = updateMCP3208(now);
+    if ((int32_t)(due - next) < 0) next = due;
+#endif
+#ifdef EXT_ADC_HAS_ADS1115
+    for (uint8_t i = 0; i < NUM_ADS1115; i++) {
+        uint32_t due = updateADS1115(&adsChips[i], now);
+        if ((int32_t)(due - next) < 0) next = due;
+    }
+#endif
+    return next;
+}
+
+bool getExtAdcCounts(uint8_t pin, float* counts) {
+    uint8_t ch = pin - EXT_ADC_PIN(0);
+    if (ch >= EXT_ADC_CHANNELS) return false;
+    if (!(registeredMask & (1U << ch))) {
+        registeredMask |= 1U << ch;
+        return false;  // Caller reads synchronously now
+    }
+
+    const ExtAdcChannel* c = &channels[ch];
+    if (!c->valid || (millis() - c->updatedMs) > maxAgeMs(ch)) return false;
+    *counts = c->counts;
+    return true;
+}
+
+float readExtAdcNow(uint8_t pin) {
+    uint8_t ch = pin - EXT_ADC_PIN(0);
+#ifdef EXT_ADC_MCP3208_CS
+    if (ch < EXT_ADC_ADS1115_FIRST) return readMCP3208Now(ch);
+#endif
+#ifdef EXT_ADC_HAS_ADS1115
+    ADS1115Chip* chip = findADS1115(ch);
+    if (chip != nullptr) return readADS1115Now(chip, ch);
+#endif
+    return NAN;  // No chip behind this channel in this build
+}
+
+void resetExtAdc() {
+    registeredMask = 0;
+    for (uint8_t ch = 0; ch < EXT_ADC_CHANNELS; ch++) {
+        channels[ch].valid = false;
+    }
+}
+
+static void printChannels(uint8_t first, uint8_t count) {
+    for (uint8_t ch = first; ch < first + count; ch++) {
+        if (!(registeredMask & (1U << ch))) continue;
+        msg.control.print(F("    ADC:"));
+        msg.control.print(ch);
+        msg.control.print(F("  "));
+        if (channels[ch].valid) {
+            msg.control.print(channels[ch].counts, 2);
+            msg.control.print(F(" counts, "));
+            msg.control.print(millis() - channels[ch].updatedMs);
+            msg.control.println(F(" ms ago"));
+        } else {
+            msg.control.println(F("no sample"));
+        }
+    }
+}
+
+void printExtAdcStatus() {
+    msg.control.println();
+    msg.control.println(F("=== External ADCs ==="));
+    bool any = false;
+#ifdef EXT_ADC_MCP3208_CS
+    any = true;
+    msg.control.print(F("  MCP3208  CS "));
+    msg.control.print(EXT_ADC_MCP3208_CS);
+    msg.control.print(F(", ADC:0-7, "));
+    msg.control.print(EXT_ADC_OVERSAMPLE);
+    msg.control.print(F("x oversampled every "));
+    msg.control.print(EXT_ADC_SCAN_INTERVAL_MS);
+    msg.control.print(F(" ms, "));
+    msg.control.print(mcpBatches);
+    msg.control.println(F(" batches"));
+    printChannels(EXT_ADC_MCP3208_FIRST, 8);
+#endif
+#ifdef EXT_ADC_HAS_ADS1115
+    for (uint8_t i = 0; i < NUM_ADS1115; i++) {
+        const ADS1115Chip* chip = &adsChips[i];
+        any = true;
+        char line[64];
+        snprintf(line, sizeof(line), "  ADS1115  0x%02X, ADC:%u-%u, %u SPS, +/-%u mV, ",
+                 chip->address, chip->first, chip->first + 3,
+                 ADS1115_RATES[ADS1115_RATE], ADS1115_FSR_MV[ADS1115_PGA]);
+        msg.control.print(line);
+        if (!chip->present) {
+            msg.control.println(F("not found"));
+            continue;
+        }
+        msg.control.print(chip->alertPin != ADS1115_NO_ALERT ? F("ALERT/RDY, ") : F("timed, "));
+        msg.control.print(chip->samples);
+        msg.control.print(F(" samples, "));
+        msg.control.print(chip->errors);
+        msg.control.println(F(" I2C errors"));
+        printChannels(chip->first, 4);
+    }
+#endif
+    if (!any) {
+        msg.control.println(F("  None in this build (-D EXT_ADC_MCP3208_CS / EXT_ADC_ADS1115_ADDR)"));
+    }
+    msg.control.print(F("  Native scale: 0-"));
+    msg.control.print(ADC_MAX_VALUE);
+    msg.control.print(F(" counts = 0-"));
+    msg.control.print(AREF_VOLTAGE);
+    msg.control.println(F(" V"));
+    msg.control.println();
+}
+
+#endif // ENABLE_EXT_ADC
@@ -0,0 +1,143 @@
+/*
+ * ext_adc.h - External multi-channel ADCs (MCP3208, ADS1115) as ADC:n pins
+ *
+ * More analog inputs than the board has, and more resolution than a 10-bit
+ * AVR converter, from external ADC chips. Each channel is a virtual pin
+ * ADC:0-ADC:15 (0xE0-0xEF); readAnalogRaw() serves it from the driver
+ * instead of the MCU's ADC, so the existing thermistor, pressure, linear and
+ * voltage read functions work on it unchanged:
+ *
+ *   SET ADC:2 OIL_TEMP VDO_150C_STEINHART
+ *
+ * Channel layout (fixed by the chips wired in, see Build Flags):
+ *
+ *   ADC:0-7    MCP3208, 12-bit SPI, single-ended CH0-CH7
+ *   ADC:8-11   ADS1115, 16-bit I2C, single-ended AIN0-AIN3
+ *   ADC:12-15  Second ADS1115
+ *
+ * Readings are handed over in native counts (0-ADC_MAX_VALUE against
+ * AREF_VOLTAGE, what the read functions expect) with the fraction kept, so
+ * the extra bits reach the conversion. A channel reads the same voltage as
+ * a native pin would; ratiometric sensors need their divider supply at
+ * AREF_VOLTAGE, as on the native pins (EXT_ADC_MCP3208_VREF when the
+ * MCP3208's reference is not AREF).
+ *
+ * MCP3208: one scheduled batch reads every channel in use back to back in a
+ * single SPI transaction, EXT_ADC_OVERSAMPLE conversions each (averaged),
+ * every EXT_ADC_SCAN_INTERVAL_MS. Conversions take no time to wait for.
+ *
+ * ADS1115: the chip converts continuously; with the ALERT/RDY pin wired to
+ * an interrupt pin the pin pulses at each finished conversion and only then
+ * is the conversion register fetched (one 2-byte I2C read - the pointer is
+ * left on it). Without it, the register is fetched once per conversion
+ * period. Several channels in use share the converter in turn: the mux moves
+ * on after each sample, and the first conversion after a move is discarded
+ * (it may have started on the old channel), so a full rotation takes
+ * 2 x channels / EXT_ADC_ADS1115_SPS.
+ *
+ * Channels register on their first read and are forgotten whenever the
+ * input schedule is rebuilt (lifecycle of lib/adc_scan.h). A channel
+ * without a fresh sample is read synchronously (on an ADS1115, waiting out a
+ * conversion). A chip that did not answer at startup reads NAN, and is not
+ * probed at later boots until BUS I2C SCAN finds it (lib/device_inventory.h).
+ *
+ * BUS ADC shows the chips, the channels in use and their latest counts.
+ *
+ * Usage:
+ *   // Scheduled task - reschedule at the returned deadline
+ *   setTaskDeadline(extAdcTaskId, updateExtAdc(now));
+ *
+ *   float counts;
+ *   if (!getExtAdcCounts(pin, &counts)) counts = readExtAdcNow(pin);
+ *
+ * Build Flags:
+ *   -D ENABLE_EXT_ADC                  - Compile the drivers and the ADC:n pins
+ *   -D EXT_ADC_MCP3208_CS=pin          - MCP3208 chip select (ADC:0-7), on the active SPI bus
+ *                                        or EXT_ADC_SPI_BUS (lib/bus_manager.h)
+ *   -D EXT_ADC_MCP3208_VREF=v          - MCP3208 reference voltage (default AREF_VOLTAGE)
+ *   -D EXT_ADC_MCP3208_SPI_HZ=n        - MCP3208 SPI clock (default 1000000, its 2.7 V limit)
+ *   -D EXT_ADC_OVERSAMPLE=n            - MCP3208 conversions averaged per channel (default 4)
+ *   -D EXT_ADC_SCAN_INTERVAL_MS=n      - MCP3208 batch period (default ADC_SCAN_INTERVAL_MS)
+ *   -D EXT_ADC_ADS1115_ADDR=a          - ADS1115 address on the active I2C bus (ADC:8-11)
+ *   -D EXT_ADC_ADS1115_ADDR2=a         - Second ADS1115 (ADC:12-15)
+ *   -D EXT_ADC_ADS1115_ALERT_PIN=pin   - ALERT/RDY of the first ADS1115 (interrupt pin)
+ *   -D EXT_ADC_ADS1115_ALERT_PIN2=pin  - ALERT/RDY of the second
+ *   -D EXT_ADC_ADS1115_SPS=n           - Data rate 8/16/32/64/128/250/475/860 (default 250)
+ *   -D EXT_ADC_ADS1115_FSR_MV=n        - Full scale 256/512/1024/2048/4096/6144 mV
+ *                                        (default: the smallest covering the supply)
+ *   A chip whose CS pin or address is not given is not compiled in.
+ */
+
+#ifndef EXT_ADC_H
+#define EXT_ADC_H
+
+#include <Arduino.h>
+#include "../config.h"
+#include "platform.h"
+#include "adc_scan.h"  // ADC_SCAN_INTERVAL_MS
+
+// Virtual pin of channel n (ADC:n)
+#define EXT_ADC_PIN(n)      (0xE0 + (n))
+#define EXT_ADC_CHANNELS    16
+#define EXT_ADC_MCP3208_FIRST 0
+#define EXT_ADC_ADS1115_FIRST 8         // Second chip at 12
+
+#define EXT_ADC_IS_PIN(pin) ((pin) >= 0xE0 && (pin) < 0xF0)
+
+#ifdef ENABLE_EXT_ADC
+
+#ifndef EXT_ADC_OVERSAMPLE
+#define EXT_ADC_OVERSAMPLE 4
+#endif
+
+#ifndef EXT_ADC_SCAN_INTERVAL_MS
+#define EXT_ADC_SCAN_INTERVAL_MS ADC_SCAN_INTERVAL_MS
+#endif
+
+#ifndef EXT_ADC_MCP3208_VREF
+#define EXT_ADC_MCP3208_VREF AREF_VOLTAGE
+#endif
+
+#ifndef EXT_ADC_MCP3208_SPI_HZ
+#define EXT_ADC_MCP3208_SPI_HZ 1000000
+#endif
+
+#ifndef EXT_ADC_ADS1115_SPS
+#define EXT_ADC_ADS1115_SPS 250
+#endif
+
+#ifndef EXT_ADC_ADS1115_FSR_MV
+  #if SYSTEM_VOLTAGE_MV > 4096
+    #define EXT_ADC_ADS1115_FSR_MV 6144
+  #else
+    #define EXT_ADC_ADS1115_FSR_MV 4096
+  #endif
+#endif
+
+// Deadline when no channel is in use
+#define EXT_ADC_IDLE_MS 250
+
+// Probe the chips, configure them and attach the ALERT/RDY interrupts
+// (after initConfiguredBuses())
+void initExtAdc();
+
+// Run the MCP3208 batch and collect finished ADS1115 conversions
+// Returns the next deadline
+uint32_t updateExtAdc(uint32_t now);
+
+// Latest counts for ADC:n (registers the channel on first call)
+// Returns false if there is no fresh sample - use readExtAdcNow()
+bool getExtAdcCounts(uint8_t pin, float* counts);
+
+// Synchronous read in native counts (NAN if the chip is missing)
+float readExtAdcNow(uint8_t pin);
+
+// Forget all registered channels (inputs were reconfigured)
+void resetExtAdc();
+
+// Chips, channels in use and their latest counts (BUS ADC)
+void printExtAdcStatus();
+
+#endif // ENABLE_EXT_ADC
+
+#endif // EXT_ADC_H
@@ -0,0 +1,43 @@
+/*
+ * fixed_point.h - Q16.16 fixed-point helpers
+ *
+ * For FPU-less targets (AVR), where every float add/multiply is a library
+ * call. Values are Q16.16, limited to +/-16384 so the difference of any two
+ * never overflows 32 bits - plenty for the standard units the sensors
+ * produce (Celsius, bar, volts) at 1/65536 resolution.
+ *
+ * Used by the sensor hot path when built with -D PREOBD_FIXED_POINT
+ * (see inputs/sensors/adc_lut.h). Input::value stays float: it is the
+ * interface to every output, display and config path, so values are
+ * converted once per read at the end of the pipeline.
+ */
+
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+#include <Arduino.h>
+#include <math.h>
+
+typedef int32_t fixed_t;
+
+#define FIXED_SHIFT 16
+#define FIXED_ONE   ((fixed_t)1 << FIXED_SHIFT)
+#define FIXED_LIMIT 16384.0f
+#define FIXED_NAN   INT32_MIN   // Stands in for NAN (no valid value)
+
+inline fixed_t fixedFromFloat(float value) {
+    if (isnan(value) || value >= FIXED_LIMIT || value <= -FIXED_LIMIT) return FIXED_NAN;
+    return (fixed_t)lroundf(value * FIXED_ONE);
+}
+
+inline float fixedToFloat(fixed_t value) {
+    if (value == FIXED_NAN) return NAN;
+    return value * (1.0f / FIXED_ONE);
+}
+
+// a + (b - a) * frac / 256 - 32-bit only, so |b - a| must stay below 128.0
+inline fixed_t fixedLerp(fixed_t a, fixed_t b, uint8_t frac) {
+    return a + (((b - a) * (int32_t)frac) >> 8);
+}
+
+#endif // FIXED_POINT_H
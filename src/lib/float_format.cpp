@@ -0,0 +1,55 @@
+/*
+ * float_format.cpp - Fixed-precision number formatting for text outputs
+ */
+
+#include "float_format.h"
+#include <math.h>
+
+static const uint32_t powersOfTen[FLOAT_FORMAT_MAX_DECIMALS + 1] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000
+};
+
+uint8_t formatUnsigned(char* out, uint32_t value) {
+    char digits[10];
+    uint8_t n = 0;
+    do {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    for (uint8_t i = 0; i < n; i++) out[i] = digits[n - 1 - i];
+    out[n] = '\0';
+    return n;
+}
+
+uint8_t formatFixed(char* out, float value, uint8_t decimals) {
+    if (decimals > FLOAT_FORMAT_MAX_DECIMALS) decimals = FLOAT_FORMAT_MAX_DECIMALS;
+    if (isnan(value)) {
+        strcpy(out, "nan");
+        return 3;
+    }
+
+    uint8_t n = 0;
+    bool negative = value < 0;
+    if (negative) value = -value;
+    float scaled = value * powersOfTen[decimals] + 0.5f;
+    if (isinf(value) || scaled >= 4294967040.0f) {
+        if (negative) out[n++] = '-';
+        strcpy(out + n, isinf(value) ? "inf" : "ovf");
+        return n + 3;
+    }
+
+    uint32_t fixed = (uint32_t)scaled;
+    if (negative && fixed) out[n++] = '-';  // No "-0.00"
+    n += formatUnsigned(out + n, fixed / powersOfTen[decimals]);
+    if (decimals) {
+        out[n++] = '.';
+        uint32_t fraction = fixed % powersOfTen[decimals];
+        for (uint8_t d = decimals; d > 0; d--) {
+            out[n + d - 1] = '0' + fraction % 10;
+            fraction /= 10;
+        }
+        n += decimals;
+        out[n] = '\0';
+    }
+    return n;
+}
@@ -0,0 +1,43 @@
+/*
+ * float_format.h - Fixed-precision number formatting for text outputs
+ *
+ * Print::print(float, n) and dtostrf() divide in floating point for every
+ * digit - a library call per step on AVR - and printf only formats floats
+ * when the float printf support is linked in. Every text output (serial
+ * CSV, the SD CSV log, the LCD, command responses, debug messages) formats
+ * through here instead: one multiply by a power of ten, then 32-bit integer
+ * digits, into the caller's buffer - no heap, same time for every value.
+ *
+ *   char text[FLOAT_FORMAT_SIZE];
+ *   formatFixed(text, 13.8f, 1);        // "13.8"
+ *
+ * Values round half away from zero; NaN and infinity print as "nan" and
+ * "inf". A value that needs more than 32 bits at the requested precision
+ * (above about 42 million with 2 decimals) prints as "ovf", as
+ * Print::print(float) does beyond 32 bits.
+ */
+
+#ifndef FLOAT_FORMAT_H
+#define FLOAT_FORMAT_H
+
+#include <Arduino.h>
+
+#define FLOAT_FORMAT_MAX_DECIMALS  6
+#define FLOAT_FORMAT_SIZE          20   // Sign, 10 digits, point, 6 decimals, NUL
+
+/**
+ * Format value with a fixed number of decimals
+ * @param out       At least FLOAT_FORMAT_SIZE bytes; NUL terminated
+ * @param decimals  Digits after the point (more than FLOAT_FORMAT_MAX_DECIMALS are clamped)
+ * @return Characters written, NUL not counted
+ */
+uint8_t formatFixed(char* out, float value, uint8_t decimals);
+
+/**
+ * Format an unsigned integer in decimal
+ * @param out  At least 11 bytes; NUL terminated
+ * @return Characters written, NUL not counted
+ */
+uint8_t formatUnsigned(char* out, uint32_t value);
+
+#endif // FLOAT_FORMAT_H
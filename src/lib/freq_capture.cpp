@@ -0,0 +1,298 @@
+/*
+ * freq_capture.cpp - Multi-channel pulse frequency capture implementation
+ */
+
+#include "freq_capture.h"
+#include "../hal/hal_freq_counter.h"
+#include "../hal/hal_placement.h"
+#include "isr_profile.h"
+#include "message_api.h"
+#include "log_tags.h"
+#include "raw_trace.h"
+
+#if FREQ_CAPTURE_CHANNELS > 8
+#error "FREQ_CAPTURE_CHANNELS supports at most 8 channels"
+#endif
+
+#define FREQ_CAPTURE_FREE 0xFF
+
+// Reader retries before it gives up on the seqlock and masks interrupts
+#define FREQ_CAPTURE_READ_RETRIES 4
+
+// Orders the seqlock counter against the record (also across ESP32 cores)
+#define FREQ_CAPTURE_BARRIER() __sync_synchronize()
+
+struct FreqCaptureChannel {
+    uint8_t pin;                                // FREQ_CAPTURE_FREE = unclaimed
+    bool hardware;                              // Counted by hal::freqCounter*, no ISR
+    uint16_t debounceUs;
+
+    // Written by the edge ISR - readers copy lastEdgeUs/pulses/periodSum/
+    // filled under the seq counter (odd while the ISR is mid-update)
+    volatile uint8_t seq;
+    volatile uint32_t lastEdgeUs;
+    volatile uint32_t pulses;
+    volatile uint32_t periodSum;                // Sum of the periods in the ring
+    volatile uint8_t filled;                    // Valid periods in the ring
+    uint32_t periods[FREQ_CAPTURE_RING];        // ISR-private
+    uint8_t head;                               // Next ring slot to overwrite (ISR-private)
+
+    // Reader state (previous read window)
+    uint32_t readPulses;                        // pulses at the previous read
+    uint32_t readEdgeUs;                        // lastEdgeUs at the previous read
+    uint16_t hwCount;                           // Hardware count at the previous read
+    uint32_t gateStartUs;                       // Hardware gate window opened
+    uint32_t gateCounts;                        // Edges counted in the open gate
+    float frequencyHz;                          // Last hardware gate result
+};
+
+static FreqCaptureChannel channels[FREQ_CAPTURE_CHANNELS];
+static bool channelsInitialized = false;
+
+// ===== INTERRUPT SERVICE ROUTINES =====
+// HAL_ISR: IRAM on ESP32, so an edge during a flash write can't crash it
+
+HAL_ISR static void onCaptureEdge(uint8_t n) {
+    FreqCaptureChannel* ch = &channels[n];
+    uint32_t now = micros();
+    uint32_t interval = now - ch->lastEdgeUs;
+
+    if (interval <= ch->debounceUs) return;
+
+    ch->seq++;
+    FREQ_CAPTURE_BARRIER();
+
+    // The first edge only starts the clock
+    if (ch->pulses > 0) {
+        // Running sum - the reader's average costs no loop over the ring
+        if (ch->filled < FREQ_CAPTURE_RING) {
+            ch->filled++;
+        } else {
+            ch->periodSum -= ch->periods[ch->head];
+        }
+        ch->periods[ch->head] = interval;
+        ch->periodSum += interval;
+        ch->head = (ch->head + 1) % FREQ_CAPTURE_RING;
+    }
+    ch->lastEdgeUs = now;
+    ch->pulses++;
+
+    FREQ_CAPTURE_BARRIER();
+    ch->seq++;
+}
+
+// One trampoline per channel - attachInterrupt() takes no argument
+// (not a template: GCC drops the section of a template instance)
+#define CAPTURE_ISR(N) \
+    HAL_ISR static void captureISR##N() { \
+        ISR_PROFILE_BEGIN(); \
+        onCaptureEdge(N); \
+        ISR_PROFILE_END(ISR_PROF_FREQ_CAPTURE); \
+    }
+
+CAPTURE_ISR(0) CAPTURE_ISR(1) CAPTURE_ISR(2) CAPTURE_ISR(3)
+CAPTURE_ISR(4) CAPTURE_ISR(5) CAPTURE_ISR(6) CAPTURE_ISR(7)
+
+typedef void (*CaptureISR)();
+
+static const CaptureISR captureISRs[8] = {
+    captureISR0, captureISR1, captureISR2, captureISR3,
+    captureISR4, captureISR5, captureISR6, captureISR7
+};
+
+// ===== CHANNEL MANAGEMENT =====
+
+static void initChannels() {
+    for (uint8_t i = 0; i < FREQ_CAPTURE_CHANNELS; i++) {
+        channels[i].pin = FREQ_CAPTURE_FREE;
+    }
+    channelsInitialized = true;
+}
+
+static FreqCaptureChannel* findChannel(uint8_t pin) {
+    if (!channelsInitialized) return nullptr;
+    for (uint8_t i = 0; i < FREQ_CAPTURE_CHANNELS; i++) {
+        if (channels[i].pin == pin) return &channels[i];
+    }
+    return nullptr;
+}
+
+// Stop whatever is feeding channel n (hardware counter or edge ISR)
+static void stopChannel(uint8_t n) {
+    FreqCaptureChannel* ch = &channels[n];
+    if (ch->hardware) {
+        hal::freqCounterEnd(n);
+        ch->hardware = false;
+    } else {
+        detachInterrupt(digitalPinToInterrupt(ch->pin));
+    }
+}
+
+bool attachFreqCapture(uint8_t pin, uint16_t debounce_us) {
+    if (!channelsInitialized) initChannels();
+
+    // Re-init of the same pin reuses its channel
+    uint8_t n;
+    for (n = 0; n < FREQ_CAPTURE_CHANNELS; n++) {
+        if (channels[n].pin == pin) break;
+    }
+    if (n < FREQ_CAPTURE_CHANNELS) {
+        stopChannel(n);
+    } else {
+        for (n = 0; n < FREQ_CAPTURE_CHANNELS; n++) {
+            if (channels[n].pin == FREQ_CAPTURE_FREE) break;
+        }
+    }
+    if (n >= FREQ_CAPTURE_CHANNELS) {
+        msg.debug.warn(TAG_SENSOR, "No free capture channel for pin %d (max %d)",
+                       pin, FREQ_CAPTURE_CHANNELS);
+        return false;
+    }
+
+    FreqCaptureChannel* ch = &channels[n];
+    ch->debounceUs = debounce_us;
+    ch->seq = 0;
+    ch->lastEdgeUs = micros();
+    ch->head = 0;
+    ch->filled = 0;
+    ch->periodSum = 0;
+    ch->pulses = 0;
+    ch->readPulses = 0;
+    ch->readEdgeUs = 0;
+    ch->frequencyHz = 0;
+    ch->gateCounts = 0;
+    ch->gateStartUs = ch->lastEdgeUs;
+
+    pinMode(pin, INPUT);
+
+    // Hardware counter first - no per-edge interrupt load
+    if (n < HAL_FREQ_COUNTER_UNITS && hal::freqCounterBegin(n, pin, debounce_us)) {
+        ch->pin = pin;
+        ch->hardware = true;
+        ch->hwCount = hal::freqCounterRead(n);
+        return true;
+    }
+
+    int irq = digitalPinToInterrupt(pin);
+    if (irq == NOT_AN_INTERRUPT) {
+        msg.debug.warn(TAG_SENSOR, "Pin %d has no interrupt - pulse input disabled", pin);
+        ch->pin = FREQ_CAPTURE_FREE;
+        return false;
+    }
+
+    ch->pin = pin;
+    ch->hardware = false;
+    attachInterrupt(irq, captureISRs[n], RISING);
+    return true;
+}
+
+void releaseFreqCapture(uint8_t pin) {
+    FreqCaptureChannel* ch = findChannel(pin);
+    if (ch == nullptr) return;
+
+    stopChannel(ch - channels);
+    ch->pin = FREQ_CAPTURE_FREE;
+}
+
+// ===== MEASUREMENT =====
+
+// Gate-window counting on a hardware counter
+static void sampleHardware(uint8_t n, FreqCaptureSample* sample) {
+    FreqCaptureChannel* ch = &channels[n];
+    uint32_t now = micros();
+
+    uint16_t count = hal::freqCounterRead(n);
+    uint16_t delta = (count + HAL_FREQ_COUNTER_WRAP - ch->hwCount) % HAL_FREQ_COUNTER_WRAP;
+    ch->hwCount = count;
+
+    if (delta > 0) {
+        ch->pulses += delta;
+        ch->lastEdgeUs = now;
+        ch->gateCounts += delta;
+    }
+
+    // Close the gate once it holds enough edges for the resolution we want
+    uint32_t gateUs = now - ch->gateStartUs;
+    if (ch->gateCounts >= FREQ_COUNTER_MIN_COUNTS ||
+        (gateUs >= FREQ_COUNTER_MAX_GATE_MS * 1000UL && ch->gateCounts > 0)) {
+        ch->frequencyHz = ch->gateCounts * 1000000.0 / gateUs;
+        ch->gateCounts = 0;
+        ch->gateStartUs = now;
+    } else if (ch->gateCounts == 0) {
+        ch->gateStartUs = now;  // Nothing counted - don't stretch the gate over idle time
+    }
+
+    sample->frequencyHz = ch->frequencyHz;
+    sample->idleUs = now - ch->lastEdgeUs;
+    sample->pulses = ch->pulses;
+}
+
+// Consistent copy of the ISR record (multi-byte fields tear on 8-bit AVR)
+struct EdgeRecord {
+    uint32_t lastEdgeUs;
+    uint32_t pulses;
+    uint32_t periodSum;
+    uint8_t filled;
+};
+
+static void copyEdgeRecord(const FreqCaptureChannel* ch, EdgeRecord* rec) {
+    // Seqlock: retry if an edge landed mid-copy, interrupts stay enabled
+    for (uint8_t attempt = 0; attempt < FREQ_CAPTURE_READ_RETRIES; attempt++) {
+        uint8_t seq = ch->seq;
+        FREQ_CAPTURE_BARRIER();
+        rec->lastEdgeUs = ch->lastEdgeUs;
+        rec->pulses = ch->pulses;
+        rec->periodSum = ch->periodSum;
+        rec->filled = ch->filled;
+        FREQ_CAPTURE_BARRIER();
+        if (!(seq & 1) && seq == ch->seq) return;
+    }
+
+    // Edges faster than the copy - take it with interrupts masked
+    noInterrupts();
+    rec->lastEdgeUs = ch->lastEdgeUs;
+    rec->pulses = ch->pulses;
+    rec->periodSum = ch->periodSum;
+    rec->filled = ch->filled;
+    interrupts();
+}
+
+// Reciprocal counting over the read window, period ring at low rates
+static void sampleEdges(FreqCaptureChannel* ch, FreqCaptureSample* sample) {
+    EdgeRecord rec;
+    copyEdgeRecord(ch, &rec);
+    uint32_t lastEdgeUs = rec.lastEdgeUs;
+    uint32_t pulses = rec.pulses;
+
+    uint32_t newPulses = pulses - ch->readPulses;
+    if (ch->readPulses > 0 && newPulses >= FREQ_CAPTURE_RING) {
+        // newPulses whole periods between the window's first and last edge
+        sample->frequencyHz = newPulses * 1000000.0 / (lastEdgeUs - ch->readEdgeUs);
+    } else if (rec.filled > 0) {
+        sample->frequencyHz = rec.filled * 1000000.0 / rec.periodSum;
+    } else {
+        sample->frequencyHz = 0;
+    }
+
+    // Each window starts at the last edge of the previous one
+    if (pulses > 0 && newPulses > 0) {
+        ch->readPulses = pulses;
+        ch->readEdgeUs = lastEdgeUs;
+    }
+
+    sample->idleUs = micros() - lastEdgeUs;
+    sample->pulses = pulses;
+}
+
+bool getFreqCapture(uint8_t pin, FreqCaptureSample* sample) {
+    FreqCaptureChannel* ch = findChannel(pin);
+    if (ch == nullptr) return false;
+
+    if (ch->hardware) {
+        sampleHardware(ch - channels, sample);
+    } else {
+        sampleEdges(ch, sample);
+    }
+    RAW_TRACE(RAW_KIND_PULSE, pin, *sample);
+    return true;
+}
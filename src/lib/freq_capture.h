@@ -0,0 +1,90 @@
+/*
+ * freq_capture.h - Multi-channel pulse frequency capture
+ *
+ * Pulse inputs (W-phase RPM, hall effect speed) each claim their own capture
+ * channel instead of sharing one set of ISR globals, so two engines or four
+ * wheels can be measured at once. Every channel has:
+ *
+ *   - Its own ISR trampoline (captureISR<n> -> onCaptureEdge(n)), so no
+ *     lookup by pin happens inside the interrupt
+ *   - A software debounce (edges closer than debounce_us are ignored)
+ *   - A ring of the last FREQ_CAPTURE_RING pulse periods with a running sum
+ *   - A seqlock around the ISR record, so readers get a consistent copy of
+ *     the multi-byte fields (torn on 8-bit AVR) without masking interrupts
+ *
+ * Readers get a blended frequency. When at least FREQ_CAPTURE_RING edges
+ * arrived since the previous read, it is edges / time between the first and
+ * last of them (reciprocal counting over the read window - resolution grows
+ * with the pulse rate); at low rates it is the mean of the period ring.
+ *
+ * With -D ENABLE_FREQ_COUNTER_HW a channel on a platform with hardware
+ * counters (hal/hal_freq_counter.h: ESP32 PCNT) counts edges in hardware
+ * instead of interrupting per edge. The frequency is then counted over a
+ * gate window that stays open until FREQ_COUNTER_MIN_COUNTS edges (or
+ * FREQ_COUNTER_MAX_GATE_MS) have been seen, so low rates trade latency for
+ * resolution. The hardware glitch filter is shorter than the ISR debounce.
+ *
+ * Channels are claimed by the sensor init function and released when the
+ * input on that pin is cleared or changes sensor. Claiming the same pin
+ * again returns the same channel.
+ *
+ * Usage:
+ *   // init
+ *   attachFreqCapture(ptr->pin, 100);
+ *
+ *   // read
+ *   FreqCaptureSample s;
+ *   if (getFreqCapture(ptr->pin, &s) && s.frequencyHz > 0) { ... }
+ *
+ * Build Flags:
+ *   -D FREQ_CAPTURE_CHANNELS=n  - Capture channels (default 2 on Uno, 4 elsewhere, max 8)
+ *   -D FREQ_CAPTURE_RING=n      - Periods averaged per channel (default 4)
+ *   -D ENABLE_FREQ_COUNTER_HW   - Hardware edge counters where supported (ESP32)
+ *   -D FREQ_COUNTER_MIN_COUNTS=n  - Edges per hardware gate window (default 32, ~3%)
+ *   -D FREQ_COUNTER_MAX_GATE_MS=n - Longest hardware gate window (default 1000)
+ */
+
+#ifndef FREQ_CAPTURE_H
+#define FREQ_CAPTURE_H
+
+#include <Arduino.h>
+
+#ifndef FREQ_CAPTURE_CHANNELS
+  #if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
+    #define FREQ_CAPTURE_CHANNELS 2        // INT0/INT1 only
+  #else
+    #define FREQ_CAPTURE_CHANNELS 4
+  #endif
+#endif
+
+#ifndef FREQ_CAPTURE_RING
+#define FREQ_CAPTURE_RING 4
+#endif
+
+#ifndef FREQ_COUNTER_MIN_COUNTS
+#define FREQ_COUNTER_MIN_COUNTS 32
+#endif
+
+#ifndef FREQ_COUNTER_MAX_GATE_MS
+#define FREQ_COUNTER_MAX_GATE_MS 1000
+#endif
+
+// Measurement of one channel
+struct FreqCaptureSample {
+    float frequencyHz;     // Blended pulse frequency (0 = fewer than two edges)
+    uint32_t idleUs;       // Time since the latest edge (hardware: since the count last moved)
+    uint32_t pulses;       // Accepted edges since the channel was claimed
+};
+
+// Claim a channel for pin and attach its ISR on the rising edge
+// Returns false if the pin has no interrupt or all channels are taken
+bool attachFreqCapture(uint8_t pin, uint16_t debounce_us);
+
+// Detach and free the channel on pin (no-op if pin has none)
+void releaseFreqCapture(uint8_t pin);
+
+// Latest measurement for pin; false if pin has no channel
+// Each call closes the read window - call once per input read
+bool getFreqCapture(uint8_t pin, FreqCaptureSample* sample);
+
+#endif // FREQ_CAPTURE_H
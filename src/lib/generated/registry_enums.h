@@ -1,6 +1,6 @@
 // AUTO-GENERATED FILE - DO NOT EDIT MANUALLY
 // Generated by tools/generate_registry_enums.py
-// Last generated: 2026-02-07 12:27:27
+// Last generated: 2026-10-14 11:36:12
 
 #ifndef PREOBD_REGISTRY_ENUMS_H
 #define PREOBD_REGISTRY_ENUMS_H
@@ -37,7 +37,11 @@ enum SensorIndex : uint8_t {
     SENSOR_BME280_HUMIDITY = 25,
     SENSOR_BME280_ELEVATION = 26,
     SENSOR_FLOAT_SWITCH = 27,
-    SENSOR_CAN_IMPORT = 28
+    SENSOR_CAN_IMPORT = 28,
+    SENSOR_MATH = 29,
+    SENSOR_GPS_SPEED = 30,
+    SENSOR_GPS_ALTITUDE = 31,
+    SENSOR_NODE = 32
 };
 
 // Application indices for APPLICATION_PRESETS array
@@ -0,0 +1,50 @@
+// AUTO-GENERATED FILE - DO NOT EDIT MANUALLY
+// Generated by tools/generate_registry_enums.py
+// Last generated: 2026-10-14 11:36:12
+//
+// Perfect hashes of the registries' name hashes: the entry a
+// hash can belong to is X_HASH_SLOTS[REGISTRY_HASH_SLOT(hash, X_HASH_SEED,
+// X_HASH_BITS)] (0xFF = none). Lookups still compare the entry's own hash.
+
+#ifndef PREOBD_REGISTRY_HASHES_H
+#define PREOBD_REGISTRY_HASHES_H
+
+#include <Arduino.h>
+
+#define REGISTRY_HASH_EMPTY 0xFF
+#define REGISTRY_HASH_SLOT(hash, seed, bits) ((uint16_t)((uint32_t)(hash) * (seed)) >> (16 - (bits)))
+
+// SENSOR_LIBRARY: 33 hashes in 128 slots
+#define SENSOR_HASH_COUNT 33
+#define SENSOR_HASH_SEED 0x0021
+#define SENSOR_HASH_BITS 7
+static const uint8_t SENSOR_HASH_SLOTS[128] PROGMEM = {
+    0xFF, 0xFF, 0xFF, 0x15, 0xFF, 0x09, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x04, 0xFF, 0xFF, 0x1B, 0xFF, 0x19, 0xFF, 0x12,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x07, 0xFF, 0xFF, 0xFF, 0x14, 0xFF, 0xFF, 0x0F, 0xFF, 0x13,
+    0xFF, 0xFF, 0x08, 0x10, 0x0D, 0xFF, 0x1C, 0x01, 0xFF, 0x1D, 0x0C, 0xFF, 0xFF, 0xFF, 0x03, 0xFF,
+    0xFF, 0xFF, 0xFF, 0x11, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x0B, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0x06, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x16,
+    0x0A, 0xFF, 0xFF, 0x17, 0xFF, 0xFF, 0xFF, 0x0E, 0xFF, 0xFF, 0xFF, 0xFF, 0x1E, 0xFF, 0x02, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0x1A, 0xFF, 0xFF, 0x18, 0xFF, 0x20, 0xFF, 0xFF, 0xFF, 0x05, 0xFF, 0x1F,
+};
+
+// APPLICATION_PRESETS: 18 hashes in 32 slots
+#define APPLICATION_HASH_COUNT 18
+#define APPLICATION_HASH_SEED 0x027B
+#define APPLICATION_HASH_BITS 5
+static const uint8_t APPLICATION_HASH_SLOTS[32] PROGMEM = {
+    0x11, 0x09, 0x10, 0xFF, 0x0D, 0xFF, 0xFF, 0x05, 0x0F, 0xFF, 0x02, 0xFF, 0xFF, 0xFF, 0xFF, 0x0A,
+    0x08, 0x01, 0x06, 0x03, 0xFF, 0xFF, 0x00, 0x0E, 0x07, 0x04, 0xFF, 0x0C, 0x0B, 0xFF, 0xFF, 0xFF,
+};
+
+// UNITS_REGISTRY (names and aliases): 19 hashes in 32 slots
+#define UNITS_HASH_COUNT 13
+#define UNITS_HASH_SEED 0x0843
+#define UNITS_HASH_BITS 5
+static const uint8_t UNITS_HASH_SLOTS[32] PROGMEM = {
+    0xFF, 0xFF, 0xFF, 0x04, 0x00, 0x09, 0xFF, 0x0A, 0xFF, 0x03, 0x0B, 0x0A, 0x02, 0xFF, 0x06, 0x06,
+    0x07, 0x01, 0xFF, 0x08, 0x0C, 0xFF, 0xFF, 0xFF, 0x05, 0xFF, 0xFF, 0x00, 0x08, 0xFF, 0x01, 0x09,
+};
+
+#endif // PREOBD_REGISTRY_HASHES_H
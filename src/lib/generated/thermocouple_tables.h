@@ -0,0 +1,44 @@
+// AUTO-GENERATED FILE - DO NOT EDIT MANUALLY
+// Generated by tools/generate_thermocouple_tables.py
+// Last generated: 2026-10-14 13:40:53
+//
+// NIST ITS-90 thermocouple tables, linearly interpolated by
+// linearizeThermocouple() (inputs/sensors/thermocouples/thermocouple_linear.h).
+// TC_x_INVERSE: temperature in 1/16 C every 2^TC_x_INVERSE_SHIFT uV from
+// TC_x_INVERSE_START_UV. TC_x_COLD_JUNCTION: voltage in uV every
+// 2^TC_x_CJ_SHIFT C from TC_x_CJ_START_C.
+
+#ifndef PREOBD_THERMOCOUPLE_TABLES_H
+#define PREOBD_THERMOCOUPLE_TABLES_H
+
+#include <Arduino.h>
+
+// K-type (chromel/alumel)
+#define TC_K_SEEBECK_NV 41276
+#define TC_K_INVERSE_START_UV -6144
+#define TC_K_INVERSE_SHIFT 9
+#define TC_K_INVERSE_COUNT 121
+static const int16_t TC_K_INVERSE[TC_K_INVERSE_COUNT] PROGMEM = {
+    -3500, -2951, -2545, -2201, -1896, -1616, -1355, -1107, -871, -644,
+    -424, -210, 0, 206, 409, 610, 810, 1008, 1205, 1402,
+    1600, 1798, 1998, 2200, 2402, 2606, 2811, 3016, 3221, 3426,
+    3630, 3832, 4034, 4235, 4434, 4633, 4831, 5028, 5225, 5421,
+    5616, 5812, 6006, 6201, 6395, 6589, 6782, 6975, 7168, 7361,
+    7554, 7746, 7938, 8130, 8323, 8515, 8707, 8899, 9091, 9284,
+    9476, 9669, 9862, 10055, 10248, 10442, 10636, 10831, 11026, 11221,
+    11417, 11613, 11810, 12007, 12205, 12403, 12602, 12802, 13002, 13203,
+    13404, 13606, 13808, 14012, 14216, 14420, 14625, 14831, 15038, 15245,
+    15453, 15661, 15871, 16081, 16291, 16503, 16715, 16929, 17143, 17358,
+    17573, 17790, 18008, 18227, 18447, 18668, 18890, 19113, 19338, 19564,
+    19791, 20020, 20250, 20482, 20715, 20950, 21186, 21424, 21663, 21904,
+    22146,
+};
+#define TC_K_CJ_START_C -64
+#define TC_K_CJ_SHIFT 4
+#define TC_K_CJ_COUNT 13
+static const int16_t TC_K_COLD_JUNCTION[TC_K_CJ_COUNT] PROGMEM = {
+    -2382, -1818, -1231, -624, 0, 637, 1285, 1941, 2602, 3267,
+    3931, 4591, 5247,
+};
+
+#endif // PREOBD_THERMOCOUPLE_TABLES_H
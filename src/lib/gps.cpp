@@ -0,0 +1,548 @@
+/*
+ * gps.cpp - GPS receiver on a hardware serial port (NMEA 0183 and UBX)
+ */
+
+#include "gps.h"
+
+#ifdef ENABLE_GPS
+
+#include "serial_manager.h"
+#include "message_api.h"
+#include "log_tags.h"
+#include "timebase.h"
+#include "../hal/hal_clock.h"
+#include <math.h>
+
+#define NMEA_MAX_LENGTH     90          // 82 by the standard, some receivers run over
+#define NMEA_MAX_DECIMALS   5           // Fraction digits kept per field
+#define UBX_MAX_PAYLOAD     512         // Longer frames are noise or not ours
+
+#define UBX_SYNC1           0xB5
+#define UBX_SYNC2           0x62
+#define UBX_CLASS_NAV       0x01
+#define UBX_NAV_PVT         0x07
+#define UBX_NAV_PVT_MIN_LEN 68          // Through headMot (92 on M8 and later)
+
+enum ParseState : uint8_t {
+    PS_IDLE,
+    PS_NMEA,                            // Between '$' and '*'
+    PS_NMEA_CK1,                        // Checksum hex digits
+    PS_NMEA_CK2,
+    PS_UBX_SYNC2,
+    PS_UBX_CLASS,
+    PS_UBX_ID,
+    PS_UBX_LEN1,
+    PS_UBX_LEN2,
+    PS_UBX_PAYLOAD,
+    PS_UBX_CKA,
+    PS_UBX_CKB
+};
+
+enum NmeaSentence : uint8_t {
+    NMEA_OTHER,
+    NMEA_RMC,
+    NMEA_GGA
+};
+
+// Sentence being received - its fields land here as they arrive
+struct NmeaPending {
+    uint32_t time;                      // hhmmss
+    uint32_t date;                      // ddmmyy
+    uint32_t lat;                       // ddmm.mmmmm x 1e5
+    uint32_t lon;                       // dddmm.mmmmm x 1e5
+    float speed;                        // Knots
+    float course;
+    float altitude;
+    uint8_t status;                     // RMC 'A' / 'V'
+    uint8_t quality;                    // GGA fix quality
+    uint8_t satellites;
+    char ns, ew;
+    bool hasTime, hasDate, hasLat, hasLon, hasCourse, hasAltitude;
+    bool wholeSecond;                   // Time has no fraction (the epoch a PPS edge starts)
+};
+
+// NAV-PVT fields, assembled byte by byte at their payload offsets
+struct UbxPending {
+    uint32_t iTOW, lon, lat, hMSL, gSpeed, headMot;
+    uint16_t year;
+    uint8_t month, day, hour, minute, second, valid;
+    uint8_t fixType, flags, numSV;
+};
+
+static Stream* port = nullptr;
+static GpsFix fix = {0, 0, NAN, 0, 0, 0, 0, GPS_FIX_NONE, 0};
+static GpsStats stats = {0, 0, 0, 0};
+static uint32_t lastClockSyncMs = 0;
+static bool clockSynced = false;
+
+static ParseState state = PS_IDLE;
+
+// NMEA field accumulator
+static NmeaSentence sentence;
+static NmeaPending nmea;
+static uint8_t nmeaLength, nmeaField, nmeaChecksum, nmeaReceived;
+static uint32_t fieldValue;             // Digits so far
+static uint8_t fieldDecimals;           // Digits after the '.'
+static bool fieldDot, fieldDigits;
+static char fieldChar;                  // First character (N/S/E/W/A/V)
+static uint32_t typeCode;               // Last three characters of the address field
+
+// UBX frame
+static UbxPending ubx;
+static uint8_t ubxClass, ubxId, ubxCkA, ubxCkB;
+static uint16_t ubxLength, ubxOffset;
+
+static const uint32_t POW10[] = {1, 10, 100, 1000, 10000, 100000};
+
+// ===== FIX =====
+
+static void syncClock(uint32_t now) {
+    if (fix.unixTime == 0) return;
+    if (clockSynced && now - lastClockSyncMs < GPS_CLOCK_SYNC_MS) return;
+    hal::setWallClock(fix.unixTime);
+    clockSynced = true;
+    lastClockSyncMs = now;
+}
+
+// ddmm.mmmmm x 1e5 -> degrees x 1e7
+static int32_t nmeaDegrees(uint32_t value, char hemisphere) {
+    uint32_t degrees = value / 10000000UL;
+    uint32_t minutes = value % 10000000UL;    // Minutes x 1e5
+    int32_t e7 = (int32_t)(degrees * 10000000UL + minutes * 5 / 3);
+    return (hemisphere == 'S' || hemisphere == 'W') ? -e7 : e7;
+}
+
+static void applyNmea() {
+    uint32_t now = millis();
+    stats.sentences++;
+
+    if (sentence == NMEA_RMC) {
+        if (nmea.status != 'A') {
+            fix.fixType = GPS_FIX_NONE;
+            return;
+        }
+        if (fix.fixType == GPS_FIX_NONE) fix.fixType = GPS_FIX_2D;
+        fix.speed = nmea.speed * 1.852f;
+        if (nmea.hasCourse) fix.course = nmea.course;
+        if (nmea.hasTime && nmea.hasDate) {
+            uint8_t yy = nmea.date % 100;
+            fix.unixTime = hal::makeWallClock((yy >= 80 ? 1900 : 2000) + yy, nmea.date / 100 % 100, nmea.date / 10000,
+                                              nmea.time / 10000, nmea.time / 100 % 100, nmea.time % 100);
+            if (nmea.wholeSecond) timebaseGpsSecond(fix.unixTime, hal::micros64());
+        }
+    } else {
+        fix.satellites = nmea.satellites;
+        if (nmea.quality == 0) {
+            fix.fixType = GPS_FIX_NONE;
+            return;
+        }
+        fix.fixType = nmea.hasAltitude ? GPS_FIX_3D : GPS_FIX_2D;
+        fix.altitude = nmea.hasAltitude ? nmea.altitude : NAN;
+    }
+
+    if (nmea.hasLat && nmea.hasLon) {
+        fix.latitude = nmeaDegrees(nmea.lat, nmea.ns);
+        fix.longitude = nmeaDegrees(nmea.lon, nmea.ew);
+    }
+    fix.fixMs = now ? now : 1;
+    syncClock(now);
+}
+
+static void applyUbx() {
+    uint32_t now = millis();
+    stats.frames++;
+
+    // 2D, 3D or GNSS + dead reckoning, with the receiver's fix-OK flag
+    bool ok = (ubx.flags & 0x01) && ubx.fixType >= 2 && ubx.fixType <= 4;
+    fix.satellites = ubx.numSV;
+    if (!ok) {
+        fix.fixType = GPS_FIX_NONE;
+        return;
+    }
+    fix.fixType = ubx.fixType == 2 ? GPS_FIX_2D : GPS_FIX_3D;
+    fix.latitude = (int32_t)ubx.lat;
+    fix.longitude = (int32_t)ubx.lon;
+    fix.altitude = fix.fixType == GPS_FIX_3D ? (int32_t)ubx.hMSL * 0.001f : NAN;
+    fix.speed = (int32_t)ubx.gSpeed * 0.0036f;          // mm/s -> km/h
+    fix.course = (int32_t)ubx.headMot * 1.0e-5f;
+    if ((ubx.valid & 0x03) == 0x03) {                   // validDate and validTime
+        fix.unixTime = hal::makeWallClock(ubx.year, ubx.month, ubx.day, ubx.hour, ubx.minute, ubx.second);
+        if (ubx.iTOW % 1000 == 0) timebaseGpsSecond(fix.unixTime, hal::micros64());
+    }
+    fix.fixMs = now ? now : 1;
+    syncClock(now);
+}
+
+// ===== NMEA =====
+
+static void startField() {
+    fieldValue = 0;
+    fieldDecimals = 0;
+    fieldDot = false;
+    fieldDigits = false;
+    fieldChar = 0;
+}
+
+static float fieldFloat() {
+    return (float)fieldValue / (float)POW10[fieldDecimals];
+}
+
+static uint32_t fieldInteger() {
+    return fieldValue / POW10[fieldDecimals];
+}
+
+// Field value scaled to NMEA_MAX_DECIMALS fraction digits (fits ddd mm.mmmmm)
+static uint32_t fieldFixed5() {
+    return fieldValue * POW10[NMEA_MAX_DECIMALS - fieldDecimals];
+}
+
+static void nmeaFieldChar(char c) {
+    if (fieldChar == 0) fieldChar = c;
+    if (c >= '0' && c <= '9') {
+        if (fieldDot && fieldDecimals >= NMEA_MAX_DECIMALS) return;
+        if (fieldValue > (0xFFFFFFFFUL - 9) / 10) return;   // Extra fraction digits dropped
+        fieldValue = fieldValue * 10 + (c - '0');
+        if (fieldDot) fieldDecimals++;
+        fieldDigits = true;
+    } else if (c == '.') {
+        fieldDot = true;
+    }
+}
+
+static void nmeaFieldEnd() {
+    if (nmeaField == 0) {
+        // Address field: talker (any) + sentence type
+        if (typeCode == 0x524D43UL) sentence = NMEA_RMC;        // "RMC"
+        else if (typeCode == 0x474741UL) sentence = NMEA_GGA;   // "GGA"
+        else sentence = NMEA_OTHER;
+        memset(&nmea, 0, sizeof(nmea));
+    } else if (sentence == NMEA_RMC) {
+        switch (nmeaField) {
+            case 1:
+                nmea.time = fieldInteger();
+                nmea.hasTime = fieldDigits;
+                nmea.wholeSecond = fieldValue % POW10[fieldDecimals] == 0;
+                break;
+            case 2: nmea.status = fieldChar; break;
+            case 3: nmea.lat = fieldFixed5(); nmea.hasLat = fieldDigits; break;
+            case 4: nmea.ns = fieldChar; break;
+            case 5: nmea.lon = fieldFixed5(); nmea.hasLon = fieldDigits; break;
+            case 6: nmea.ew = fieldChar; break;
+            case 7: nmea.speed = fieldFloat(); break;
+            case 8: nmea.course = fieldFloat(); nmea.hasCourse = fieldDigits; break;
+            case 9: nmea.date = fieldInteger(); nmea.hasDate = fieldDigits; break;
+        }
+    } else if (sentence == NMEA_GGA) {
+        switch (nmeaField) {
+            case 2: nmea.lat = fieldFixed5(); nmea.hasLat = fieldDigits; break;
+            case 3: nmea.ns = fieldChar; break;
+            case 4: nmea.lon = fieldFixed5(); nmea.hasLon = fieldDigits; break;
+            case 5: nmea.ew = fieldChar; break;
+            case 6: nmea.quality = fieldInteger(); break;
+            case 7: nmea.satellites = fieldInteger(); break;
+            case 9:
+                nmea.altitude = fieldChar == '-' ? -fieldFloat() : fieldFloat();
+                nmea.hasAltitude = fieldDigits;
+                break;
+        }
+    }
+    nmeaField++;
+    startField();
+}
+
+static int8_t hexValue(uint8_t c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// ===== UBX =====
+
+static void ubxChecksum(uint8_t c) {
+    ubxCkA += c;
+    ubxCkB += ubxCkA;
+}
+
+// Little-endian field bytes straight into place
+static inline void ubxField(uint32_t* field, uint16_t offset, uint16_t start, uint8_t c) {
+    *field |= (uint32_t)c << (8 * (offset - start));
+}
+
+static void ubxPayloadByte(uint16_t offset, uint8_t c) {
+    if (ubxClass != UBX_CLASS_NAV || ubxId != UBX_NAV_PVT) return;
+    switch (offset) {
+        case 4:  ubx.year = c; break;
+        case 5:  ubx.year |= (uint16_t)c << 8; break;
+        case 6:  ubx.month = c; break;
+        case 7:  ubx.day = c; break;
+        case 8:  ubx.hour = c; break;
+        case 9:  ubx.minute = c; break;
+        case 10: ubx.second = c; break;
+        case 11: ubx.valid = c; break;
+        case 20: ubx.fixType = c; break;
+        case 21: ubx.flags = c; break;
+        case 23: ubx.numSV = c; break;
+        default:
+            if (offset < 4) ubxField(&ubx.iTOW, offset, 0, c);
+            else if (offset >= 24 && offset < 28) ubxField(&ubx.lon, offset, 24, c);
+            else if (offset >= 28 && offset < 32) ubxField(&ubx.lat, offset, 28, c);
+            else if (offset >= 36 && offset < 40) ubxField(&ubx.hMSL, offset, 36, c);
+            else if (offset >= 60 && offset < 64) ubxField(&ubx.gSpeed, offset, 60, c);
+            else if (offset >= 64 && offset < 68) ubxField(&ubx.headMot, offset, 64, c);
+            break;
+    }
+}
+
+#ifdef GPS_UBX_CONFIG
+static void sendUbx(uint8_t cls, uint8_t id, const uint8_t* payload, uint16_t length) {
+    uint8_t header[6] = {UBX_SYNC1, UBX_SYNC2, cls, id, (uint8_t)length, (uint8_t)(length >> 8)};
+    uint8_t ckA = 0, ckB = 0;
+    for (uint8_t i = 2; i < 6; i++) { ckA += header[i]; ckB += ckA; }
+    for (uint16_t i = 0; i < length; i++) { ckA += payload[i]; ckB += ckA; }
+    port->write(header, sizeof(header));
+    port->write(payload, length);
+    port->write(ckA);
+    port->write(ckB);
+}
+
+// NAV-PVT on this port at GPS_RATE_MS, the default NMEA sentences off
+static void configureUbx() {
+    for (uint8_t nmeaId = 0x00; nmeaId <= 0x05; nmeaId++) {   // GGA GLL GSA GSV RMC VTG
+        const uint8_t msgOff[3] = {0xF0, nmeaId, 0};
+        sendUbx(0x06, 0x01, msgOff, sizeof(msgOff));           // CFG-MSG
+    }
+    const uint8_t msgPvt[3] = {UBX_CLASS_NAV, UBX_NAV_PVT, 1};
+    sendUbx(0x06, 0x01, msgPvt, sizeof(msgPvt));
+    const uint8_t rate[6] = {(uint8_t)GPS_RATE_MS, (uint8_t)(GPS_RATE_MS >> 8), 1, 0, 1, 0};
+    sendUbx(0x06, 0x08, rate, sizeof(rate));                   // CFG-RATE, GPS time
+}
+#endif
+
+// ===== PARSER =====
+
+void parseGpsByte(uint8_t c) {
+    stats.bytes++;
+
+    // A '$' starts a sentence - except inside a UBX frame, which may carry one
+    if (c == '$' && state <= PS_NMEA_CK2) {
+        state = PS_NMEA;
+        nmeaLength = 0;
+        nmeaField = 0;
+        nmeaChecksum = 0;
+        typeCode = 0;
+        startField();
+        return;
+    }
+
+    // NMEA is printable text - anything else ends the sentence, and may
+    // start a UBX frame
+    if (state <= PS_NMEA_CK2 && (c < 0x20 || c > 0x7E) && c != '\r' && c != '\n') {
+        state = PS_IDLE;
+    }
+
+    switch (state) {
+        case PS_IDLE:
+            if (c == UBX_SYNC1) state = PS_UBX_SYNC2;
+            break;
+
+        case PS_NMEA:
+            if (c == '*') {
+                nmeaFieldEnd();
+                state = PS_NMEA_CK1;
+                break;
+            }
+            if (c == '\r' || c == '\n' || ++nmeaLength > NMEA_MAX_LENGTH) {
+                state = PS_IDLE;                    // No checksum - not trusted
+                break;
+            }
+            nmeaChecksum ^= c;
+            if (c == ',') {
+                nmeaFieldEnd();
+                if (sentence == NMEA_OTHER) state = PS_IDLE;
+            } else if (nmeaField == 0) {
+                typeCode = ((typeCode << 8) | c) & 0xFFFFFFUL;
+            } else {
+                nmeaFieldChar(c);
+            }
+            break;
+
+        case PS_NMEA_CK1:
+            if (hexValue(c) < 0) { state = PS_IDLE; break; }
+            nmeaReceived = hexValue(c) << 4;
+            state = PS_NMEA_CK2;
+            break;
+
+        case PS_NMEA_CK2:
+            state = PS_IDLE;
+            if (hexValue(c) < 0) break;
+            nmeaReceived |= hexValue(c);
+            if (nmeaReceived != nmeaChecksum) {
+                stats.checksumErrors++;
+            } else if (sentence != NMEA_OTHER) {
+                applyNmea();
+            }
+            break;
+
+        case PS_UBX_SYNC2:
+            state = (c == UBX_SYNC2) ? PS_UBX_CLASS : (c == UBX_SYNC1 ? PS_UBX_SYNC2 : PS_IDLE);
+            ubxCkA = 0;
+            ubxCkB = 0;
+            break;
+
+        case PS_UBX_CLASS:
+            ubxClass = c;
+            ubxChecksum(c);
+            state = PS_UBX_ID;
+            break;
+
+        case PS_UBX_ID:
+            ubxId = c;
+            ubxChecksum(c);
+            state = PS_UBX_LEN1;
+            break;
+
+        case PS_UBX_LEN1:
+            ubxLength = c;
+            ubxChecksum(c);
+            state = PS_UBX_LEN2;
+            break;
+
+        case PS_UBX_LEN2:
+            ubxLength |= (uint16_t)c << 8;
+            ubxChecksum(c);
+            ubxOffset = 0;
+            memset(&ubx, 0, sizeof(ubx));
+            if (ubxLength > UBX_MAX_PAYLOAD) state = PS_IDLE;
+            else state = ubxLength ? PS_UBX_PAYLOAD : PS_UBX_CKA;
+            break;
+
+        case PS_UBX_PAYLOAD:
+            ubxChecksum(c);
+            ubxPayloadByte(ubxOffset, c);
+            if (++ubxOffset >= ubxLength) state = PS_UBX_CKA;
+            break;
+
+        case PS_UBX_CKA:
+            state = (c == ubxCkA) ? PS_UBX_CKB : PS_IDLE;
+            if (state == PS_IDLE) stats.checksumErrors++;
+            break;
+
+        case PS_UBX_CKB:
+            state = PS_IDLE;
+            if (c != ubxCkB) {
+                stats.checksumErrors++;
+            } else if (ubxClass == UBX_CLASS_NAV && ubxId == UBX_NAV_PVT && ubxLength >= UBX_NAV_PVT_MIN_LEN) {
+                applyUbx();
+            }
+            break;
+    }
+}
+
+// ===== API =====
+
+void initGps() {
+    if (!claimSerialPort(GPS_SERIAL_PORT, GPS_BAUD, "GPS")) {
+        msg.debug.error(TAG_SERIAL, "GPS: Serial%d not available", GPS_SERIAL_PORT);
+        return;
+    }
+    port = getSerialPort(GPS_SERIAL_PORT);
+#ifdef GPS_UBX_CONFIG
+    if (port) configureUbx();
+#endif
+}
+
+void updateGps(uint32_t now) {
+    (void)now;
+    if (!port) return;
+    for (uint16_t n = 0; n < GPS_POLL_BYTES; n++) {
+        int c = port->read();
+        if (c < 0) break;
+        parseGpsByte((uint8_t)c);
+    }
+}
+
+const GpsFix& getGpsFix() {
+    return fix;
+}
+
+const GpsStats& getGpsStats() {
+    return stats;
+}
+
+bool hasGpsFix(uint32_t now) {
+    return fix.fixType != GPS_FIX_NONE && fix.fixMs != 0 && now - fix.fixMs < GPS_TIMEOUT_MS;
+}
+
+// Degrees x 1e7 as d.ddddddd
+static void printDegrees(int32_t e7) {
+    uint32_t magnitude = e7 < 0 ? -(uint32_t)e7 : (uint32_t)e7;
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%s%lu.%07lu", e7 < 0 ? "-" : "",
+             (unsigned long)(magnitude / 10000000UL), (unsigned long)(magnitude % 10000000UL));
+    msg.control.print(buf);
+}
+
+void printGpsStatus() {
+    uint32_t now = millis();
+    msg.control.println();
+    msg.control.println(F("=== GPS ==="));
+    msg.control.print(F("Port:       Serial"));
+    msg.control.print(GPS_SERIAL_PORT);
+    msg.control.print(F(" @ "));
+    msg.control.print((uint32_t)GPS_BAUD);
+#ifdef GPS_UBX_CONFIG
+    msg.control.println(F(" baud, UBX NAV-PVT"));
+#else
+    msg.control.println(F(" baud, NMEA"));
+#endif
+    if (!port) {
+        msg.control.println(F("  Not started (port not available)"));
+        return;
+    }
+    msg.control.print(F("Received:   "));
+    msg.control.print(stats.bytes);
+    msg.control.print(F(" bytes, "));
+    msg.control.print(stats.sentences);
+    msg.control.print(F(" sentences, "));
+    msg.control.print(stats.frames);
+    msg.control.print(F(" frames, "));
+    msg.control.print(stats.checksumErrors);
+    msg.control.println(F(" checksum errors"));
+
+    msg.control.print(F("Fix:        "));
+    if (fix.fixMs == 0) {
+        msg.control.println(F("none yet"));
+        return;
+    }
+    if (fix.fixType == GPS_FIX_NONE) msg.control.print(F("lost"));
+    else msg.control.print(fix.fixType == GPS_FIX_3D ? F("3D") : F("2D"));
+    msg.control.print(F(", "));
+    msg.control.print(fix.satellites);
+    msg.control.print(F(" satellites, "));
+    msg.control.print(now - fix.fixMs);
+    msg.control.println(hasGpsFix(now) ? F(" ms ago") : F(" ms ago (stale)"));
+    msg.control.print(F("Position:   "));
+    printDegrees(fix.latitude);
+    msg.control.print(F(", "));
+    printDegrees(fix.longitude);
+    msg.control.println();
+    msg.control.print(F("Altitude:   "));
+    if (isnan(fix.altitude)) msg.control.println(F("--"));
+    else { msg.control.print(fix.altitude, 1); msg.control.println(F(" m")); }
+    msg.control.print(F("Speed:      "));
+    msg.control.print(fix.speed, 1);
+    msg.control.print(F(" km/h, course "));
+    msg.control.print(fix.course, 1);
+    msg.control.println(F(" deg"));
+    msg.control.print(F("UTC:        "));
+    if (fix.unixTime == 0) {
+        msg.control.println(F("--"));
+    } else {
+        char stamp[16];
+        hal::formatWallClock(fix.unixTime, stamp);
+        msg.control.println(stamp);
+    }
+}
+
+#endif // ENABLE_GPS
@@ -0,0 +1,152 @@
+/*
+ * gps.h - GPS receiver on a hardware serial port (NMEA 0183 and UBX)
+ *
+ * Vehicle speed without a hall sender, altitude, position, and UTC time for
+ * log timestamps, from a GPS module on a spare UART (GPS_SERIAL_PORT). The
+ * port is claimed from the serial manager: it is not a transport and BUS
+ * SERIAL leaves it alone.
+ *
+ * Parsing is incremental: updateGps() takes the bytes waiting in the UART's
+ * receive ring and runs them through a state machine one at a time. Nothing
+ * is copied into a line or frame buffer - number fields are accumulated
+ * digit by digit into the sentence being received, UBX payload bytes are
+ * assembled straight into the fields at their offsets. A sentence or frame
+ * reaches the fix only when its checksum matches, so a corrupted line never
+ * shows up half-applied.
+ *
+ *   NMEA  $--RMC  time, date, status, position, speed, course
+ *         $--GGA  fix quality, satellites, position, altitude (MSL)
+ *         Any talker (GP, GN, GL, ...); other sentences are skipped.
+ *   UBX   NAV-PVT (0x01 0x07) - everything above in one frame. With
+ *         GPS_UBX_CONFIG the driver configures a u-blox receiver at
+ *         startup for NAV-PVT at GPS_RATE_MS and turns its NMEA
+ *         output off (the module must already be at GPS_BAUD).
+ *
+ * Inputs: GPS:0-GPS:7 (0xA0-0xA7) are virtual pins for the GPS sensors,
+ * any sensor on any pin:
+ *
+ *   SET GPS:0 VEHICLE_SPEED GPS_SPEED       km/h over ground
+ *   SET GPS:1 ELEVATION GPS_ALTITUDE        metres above mean sea level
+ *
+ * A GPS input reads NAN: FAULT_NO_DEVICE while nothing has been received
+ * from the receiver, FAULT_STALE without a fix or when none arrived for
+ * GPS_TIMEOUT_MS. Runtime configuration only - static builds have no GPS:n
+ * inputs (the clock is still set). Position, satellites and time are shown
+ * by BUS GPS and available to outputs through getGpsFix().
+ *
+ * Time: a fix with a valid date and time sets the wall clock
+ * (hal::setWallClock(), and the RTC where there is one) at the first fix and
+ * every GPS_CLOCK_SYNC_MS after, so logs are stamped in UTC even without an
+ * RTC. A fix for a whole second also names the PPS edge before it, when the
+ * receiver's PPS is wired to TIME_PPS_PIN (lib/timebase.h).
+ *
+ * Usage:
+ *   initGps();                  // setup(), before initConfiguredSerialPorts()
+ *   updateGps(millis());        // every loop, CONFIG mode too
+ *   const GpsFix& fix = getGpsFix();
+ *
+ * Build Flags:
+ *   -D ENABLE_GPS               - Compile the GPS driver and the GPS:n pins
+ *   -D GPS_SERIAL_PORT=n        - Hardware serial port of the receiver (default 1: Serial1)
+ *   -D GPS_BAUD=n               - Port baud rate (default 9600; 115200 with GPS_UBX_CONFIG)
+ *   -D GPS_UBX_CONFIG           - Configure a u-blox receiver for NAV-PVT at startup
+ *   -D GPS_RATE_MS=n            - Navigation rate set by GPS_UBX_CONFIG, and how often the
+ *                                 GPS inputs are read (default 100, 10 Hz)
+ *   -D GPS_TIMEOUT_MS=n         - Fix age after which inputs read stale (default 2000)
+ *   -D GPS_CLOCK_SYNC_MS=n      - How often a fix resets the wall clock (default 3600000)
+ *   -D GPS_POLL_BYTES=n         - Most bytes parsed per loop (default 128)
+ */
+
+#ifndef GPS_H
+#define GPS_H
+
+#include <Arduino.h>
+
+// Virtual pin of GPS input n (GPS:n)
+#define GPS_PIN(n)          (0xA0 + (n))
+#define GPS_PINS            8
+
+#define GPS_IS_PIN(pin)     ((pin) >= 0xA0 && (pin) < 0xA0 + GPS_PINS)
+
+// Also the read interval of the GPS sensors
+#ifndef GPS_RATE_MS
+#define GPS_RATE_MS 100
+#endif
+
+#ifdef ENABLE_GPS
+
+#ifndef GPS_SERIAL_PORT
+#define GPS_SERIAL_PORT 1
+#endif
+
+#ifndef GPS_BAUD
+#ifdef GPS_UBX_CONFIG
+#define GPS_BAUD 115200
+#else
+#define GPS_BAUD 9600
+#endif
+#endif
+
+#ifndef GPS_TIMEOUT_MS
+#define GPS_TIMEOUT_MS 2000
+#endif
+
+#ifndef GPS_CLOCK_SYNC_MS
+#define GPS_CLOCK_SYNC_MS 3600000UL
+#endif
+
+#ifndef GPS_POLL_BYTES
+#define GPS_POLL_BYTES 128
+#endif
+
+enum GpsFixType : uint8_t {
+    GPS_FIX_NONE = 0,
+    GPS_FIX_2D = 2,
+    GPS_FIX_3D = 3
+};
+
+// Latest navigation solution (fields of the last valid sentence or frame)
+struct GpsFix {
+    int32_t latitude;           // Degrees x 1e7, north positive
+    int32_t longitude;          // Degrees x 1e7, east positive
+    float altitude;             // Metres above mean sea level (NAN: not known)
+    float speed;                // km/h over ground
+    float course;               // Degrees from true north
+    uint32_t unixTime;          // UTC of the fix (0 = no valid date/time)
+    uint32_t fixMs;             // millis() the fix arrived (0 = never)
+    uint8_t fixType;            // GpsFixType
+    uint8_t satellites;
+};
+
+// Receiver counters (BUS GPS)
+struct GpsStats {
+    uint32_t bytes;             // Bytes parsed
+    uint16_t sentences;         // NMEA sentences applied
+    uint16_t frames;            // UBX frames applied
+    uint16_t checksumErrors;    // Sentences/frames dropped on checksum
+};
+
+// Claim the serial port, configure a u-blox receiver (GPS_UBX_CONFIG)
+void initGps();
+
+// Parse the bytes waiting on the port (up to GPS_POLL_BYTES)
+void updateGps(uint32_t now);
+
+// Parse one byte (updateGps() calls this for each byte read)
+void parseGpsByte(uint8_t c);
+
+// Latest fix - check hasGpsFix() before using the position
+const GpsFix& getGpsFix();
+
+// True if a 2D/3D fix arrived within GPS_TIMEOUT_MS
+bool hasGpsFix(uint32_t now);
+
+// Receiver counters
+const GpsStats& getGpsStats();
+
+// Port, counters and the latest fix (BUS GPS)
+void printGpsStatus();
+
+#endif // ENABLE_GPS
+
+#endif // GPS_H
@@ -12,6 +12,9 @@
  *   - 16-bit output (uint16_t) to save memory
  *   - Case-insensitive (converts to uppercase during hashing)
  *   - Optimized for AVR with minimal RAM usage
+ *
+ * djb2_const() is the same hash as a constexpr, for tables and switch labels
+ * built at compile time; DJB2("NAME") forces it to a constant in any context.
  */
 
 #ifndef HASH_H
@@ -73,4 +76,36 @@ inline uint16_t djb2_hash_P(const char* str) {
     return (uint16_t)(hash & 0xFFFF);
 }
 
+/**
+ * DJB2 hash at compile time
+ *
+ * Same value as djb2_hash() for ASCII strings. Usable in constant
+ * expressions: table initializers, case labels, static_assert.
+ *
+ * Usage:
+ *   switch (djb2_hash(token)) {
+ *       case djb2_const("SET"): ...    // Duplicate hashes fail to compile
+ *   }
+ */
+constexpr uint32_t djb2_const_step(const char* str, uint32_t hash) {
+    return *str ? djb2_const_step(str + 1,
+                                  hash * 33 + ((*str >= 'a' && *str <= 'z') ? *str - 32 : *str))
+                : hash;
+}
+
+constexpr uint16_t djb2_const(const char* str) {
+    return (uint16_t)(djb2_const_step(str, 5381) & 0xFFFF);
+}
+
+template <uint16_t Hash>
+struct Djb2Constant {
+    static constexpr uint16_t value = Hash;
+};
+
+// Hash of a string literal, folded by the compiler (never computed at run time)
+#define DJB2(str) (Djb2Constant<djb2_const(str)>::value)
+
+static_assert(djb2_const("CELSIUS") == 0x82DD && djb2_const("c") == 0xB5E8,
+              "djb2_const must match djb2_hash");
+
 #endif // HASH_H
@@ -0,0 +1,292 @@
+/*
+ * i2c_engine.cpp - Guarded I2C transactions, bus recovery and sliced I2C jobs
+ */
+
+#include "i2c_engine.h"
+#include "bus_manager.h"
+#include "bus_defaults.h"
+#include "system_config.h"
+#include "message_api.h"
+#include "log_tags.h"
+
+struct I2CDeviceStats {
+    uint8_t address;
+    uint32_t transactions;
+    uint32_t nacks;
+    uint32_t timeouts;
+    uint32_t errors;        // Bus errors, short reads, skipped while stuck
+};
+
+struct I2CJobSlot {
+    I2CJobFn fn;
+    I2CJobPriority priority;
+};
+
+static I2CDeviceStats devices[I2C_MAX_DEVICES];
+static uint8_t numDevices = 0;
+static uint32_t otherDevices = 0;       // Transactions to addresses past the table
+
+static bool busStuck = false;
+static uint8_t errorStreak = 0;
+static uint32_t lastRecoveryMs = 0;
+static bool recoveredOnce = false;
+static uint32_t recoveries = 0;
+static uint32_t failedRecoveries = 0;
+
+static I2CJobSlot jobs[I2C_MAX_JOBS];
+static uint8_t numJobs = 0;
+static uint32_t passStartUs = 0;
+
+static I2CDeviceStats* deviceStats(uint8_t address) {
+    for (uint8_t i = 0; i < numDevices; i++) {
+        if (devices[i].address == address) return &devices[i];
+    }
+    if (numDevices >= I2C_MAX_DEVICES) return nullptr;
+    I2CDeviceStats* dev = &devices[numDevices++];
+    memset(dev, 0, sizeof(*dev));
+    dev->address = address;
+    return dev;
+}
+
+void configureI2CTimeout(TwoWire* wire) {
+#if defined(WIRE_HAS_TIMEOUT)
+    wire->setWireTimeout(I2C_TIMEOUT_US, true);     // AVR: reset the TWI on timeout
+#elif defined(ESP32)
+    wire->setTimeOut((I2C_TIMEOUT_US + 999) / 1000);
+#else
+    (void)wire;     // No core timeout - i2cBusReady() guards the busy bus
+#endif
+}
+
+void i2cNoteResult(uint8_t address, uint8_t status) {
+    I2CDeviceStats* dev = deviceStats(address);
+    if (dev != nullptr) {
+        dev->transactions++;
+        if (status == I2C_NACK_ADDR || status == I2C_NACK_DATA) dev->nacks++;
+        else if (status == I2C_TIMEOUT) dev->timeouts++;
+        else if (status != I2C_OK) dev->errors++;
+    } else {
+        otherDevices++;
+    }
+
+    if (status == I2C_OK || status == I2C_NACK_ADDR || status == I2C_NACK_DATA) {
+        errorStreak = 0;
+        return;
+    }
+    if (status == I2C_BUS_STUCK) return;
+    if (status == I2C_TIMEOUT || ++errorStreak >= I2C_RECOVER_ERRORS) {
+        if (!busStuck) msg.debug.warn(TAG_I2C, "I2C bus error (status %d) - recovering", status);
+        busStuck = true;
+        errorStreak = 0;
+    }
+}
+
+// ===== BUS STATE =====
+
+#if defined(__IMXRT1062__)
+// LPI2C master status of the active bus (Wire = LPI2C1, Wire1 = LPI2C3, Wire2 = LPI2C4)
+static volatile uint32_t* lpi2cStatus() {
+    switch (getActiveI2CId()) {
+        case 0: return &LPI2C1_MSR;
+        case 1: return &LPI2C3_MSR;
+        case 2: return &LPI2C4_MSR;
+    }
+    return nullptr;
+}
+#endif
+
+// Busy with no master of ours on it, for longer than a transaction could take
+static bool busHeldBusy() {
+#if defined(__IMXRT1062__)
+    volatile uint32_t* msr = lpi2cStatus();
+    if (msr == nullptr) return false;
+    uint32_t start = micros();
+    while ((*msr & LPI2C_MSR_BBF) && !(*msr & LPI2C_MSR_MBF)) {
+        if (micros() - start > I2C_TIMEOUT_US) return true;
+    }
+#endif
+    return false;
+}
+
+bool i2cBusReady() {
+    if (!busStuck && busHeldBusy()) {
+        msg.debug.warn(TAG_I2C, "I2C bus held busy - recovering");
+        busStuck = true;
+    }
+    if (busStuck) {
+        uint32_t now = millis();
+        if (!recoveredOnce || now - lastRecoveryMs >= I2C_RECOVER_INTERVAL_MS) {
+            i2cRecoverBus();
+        }
+    }
+    return !busStuck;
+}
+
+// Open-drain pulse: drive low, then release to the pull-up
+static void pulseLow(uint8_t pin) {
+    pinMode(pin, OUTPUT);
+    digitalWrite(pin, LOW);
+    delayMicroseconds(5);
+    pinMode(pin, INPUT_PULLUP);
+    delayMicroseconds(5);
+}
+
+bool i2cRecoverBus() {
+    uint8_t bus_id = getActiveI2CId();
+    uint8_t sda = getDefaultI2CSDA(bus_id);
+    uint8_t scl = getDefaultI2CSCL(bus_id);
+    TwoWire* wire = getActiveI2C();
+
+    lastRecoveryMs = millis();
+    recoveredOnce = true;
+
+    // Take the pins from the controller and clock the slave through the
+    // rest of its byte until it releases SDA
+    wire->end();
+    pinMode(sda, INPUT_PULLUP);
+    pinMode(scl, INPUT_PULLUP);
+    delayMicroseconds(5);
+    for (uint8_t i = 0; i < 9 && digitalRead(sda) == LOW; i++) {
+        pulseLow(scl);
+    }
+
+    // STOP: SDA rises while SCL is high
+    pulseLow(sda);
+    bool released = digitalRead(sda) == HIGH && digitalRead(scl) == HIGH;
+
+    wire->begin();
+    wire->setClock(systemConfig.buses.i2c_clock * 1000UL);
+    configureI2CTimeout(wire);
+
+    if (released) {
+        recoveries++;
+        busStuck = false;
+        errorStreak = 0;
+        msg.debug.info(TAG_I2C, "I2C bus recovered");
+    } else {
+        failedRecoveries++;
+        busStuck = true;
+        msg.debug.warn(TAG_I2C, "I2C bus still held low (SDA %d, SCL %d)",
+                       digitalRead(sda), digitalRead(scl));
+    }
+    return released;
+}
+
+// ===== TRANSACTIONS =====
+
+uint8_t i2cWrite(uint8_t address, const uint8_t* data, uint8_t len) {
+    if (!i2cBusReady()) {
+        i2cNoteResult(address, I2C_BUS_STUCK);
+        return I2C_BUS_STUCK;
+    }
+    TwoWire* wire = getActiveI2C();
+    wire->beginTransmission(address);
+    wire->write(data, len);
+    uint8_t status = wire->endTransmission();
+    i2cNoteResult(address, status);
+    return status;
+}
+
+uint8_t i2cProbe(uint8_t address) {
+    if (!i2cBusReady()) return I2C_BUS_STUCK;
+    TwoWire* wire = getActiveI2C();
+    wire->beginTransmission(address);
+    uint8_t status = wire->endTransmission();
+    // An empty address doesn't take a per-device slot - only real errors are noted
+    if (status != I2C_OK && status != I2C_NACK_ADDR) i2cNoteResult(address, status);
+    return status;
+}
+
+uint8_t i2cRead(uint8_t address, uint8_t* data, uint8_t len) {
+    if (!i2cBusReady()) {
+        i2cNoteResult(address, I2C_BUS_STUCK);
+        return I2C_BUS_STUCK;
+    }
+    TwoWire* wire = getActiveI2C();
+    uint8_t got = wire->requestFrom(address, len);
+    for (uint8_t i = 0; i < got && i < len; i++) {
+        data[i] = wire->read();
+    }
+
+    uint8_t status = I2C_OK;
+    if (got != len) {
+        status = got == 0 ? I2C_NACK_ADDR : I2C_ERROR;
+#if defined(WIRE_HAS_TIMEOUT)
+        if (wire->getWireTimeoutFlag()) {
+            wire->clearWireTimeoutFlag();
+            status = I2C_TIMEOUT;
+        }
+#endif
+    }
+    i2cNoteResult(address, status);
+    return status;
+}
+
+// ===== JOBS =====
+
+bool i2cQueueJob(I2CJobFn job, I2CJobPriority priority) {
+    for (uint8_t i = 0; i < numJobs; i++) {
+        if (jobs[i].fn == job) return true;
+    }
+    if (numJobs >= I2C_MAX_JOBS) return false;
+
+    // Keep the queue in priority order, FIFO within a priority
+    uint8_t pos = numJobs;
+    while (pos > 0 && jobs[pos - 1].priority > priority) {
+        jobs[pos] = jobs[pos - 1];
+        pos--;
+    }
+    jobs[pos].fn = job;
+    jobs[pos].priority = priority;
+    numJobs++;
+    return true;
+}
+
+bool i2cSliceDone() {
+    return micros() - passStartUs >= I2C_PASS_BUDGET_US;
+}
+
+void updateI2CEngine() {
+    if (numJobs == 0) return;
+    passStartUs = micros();
+
+    uint8_t i = 0;
+    while (i < numJobs && !i2cSliceDone()) {
+        if (jobs[i].fn()) {
+            for (uint8_t j = i + 1; j < numJobs; j++) jobs[j - 1] = jobs[j];
+            numJobs--;
+        } else {
+            i++;  // Not finished - next pass; lower priorities get what is left
+        }
+    }
+}
+
+// ===== STATUS =====
+
+void printI2CEngineStatus() {
+    msg.control.print(F("Bus state: "));
+    msg.control.print(busStuck ? F("STUCK") : F("OK"));
+    msg.control.print(F(", "));
+    msg.control.print(recoveries);
+    msg.control.print(F(" recoveries, "));
+    msg.control.print(failedRecoveries);
+    msg.control.print(F(" failed, timeout "));
+    msg.control.print(I2C_TIMEOUT_US);
+    msg.control.print(F(" us, "));
+    msg.control.print(numJobs);
+    msg.control.println(F(" jobs queued"));
+
+    for (uint8_t i = 0; i < numDevices; i++) {
+        const I2CDeviceStats* dev = &devices[i];
+        char line[96];
+        snprintf(line, sizeof(line), "  0x%02X: %lu transactions, %lu NACK, %lu timeouts, %lu errors",
+                 dev->address, (unsigned long)dev->transactions, (unsigned long)dev->nacks,
+                 (unsigned long)dev->timeouts, (unsigned long)dev->errors);
+        msg.control.println(line);
+    }
+    if (otherDevices > 0) {
+        msg.control.print(F("  Other addresses: "));
+        msg.control.print(otherDevices);
+        msg.control.println(F(" transactions"));
+    }
+}
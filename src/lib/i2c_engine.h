@@ -0,0 +1,161 @@
+/*
+ * i2c_engine.h - Guarded I2C transactions, bus recovery and sliced I2C jobs
+ *
+ * A slave that holds SDA low (ignition noise, a reset in the middle of a
+ * byte) can stall Wire: Teensy 4.x Wire waits for a busy bus without a
+ * timeout, and AVR and ESP32 only give up after a core timeout if one is
+ * set - long enough either way for the watchdog to reset the unit.
+ *
+ * Bounded transactions: initI2CBus() sets the core's transaction timeout
+ * where it has one (AVR setWireTimeout(), ESP32 setTimeOut()), and
+ * i2cBusReady() checks the bus before each transaction - on Teensy 4.x the
+ * LPI2C bus-busy flag, polled for at most I2C_TIMEOUT_US - so a stuck bus
+ * fails at once instead of hanging Wire. Drivers that talk to Wire through a
+ * library (BME280, LCD) check i2cBusReady() before their traffic; the
+ * engine's own i2cWrite()/i2cRead() do it themselves.
+ *
+ * Recovery: a busy bus that does not free, a transaction timeout, or
+ * I2C_RECOVER_ERRORS bus errors in a row mark the bus stuck. The next
+ * i2cBusReady() then takes the pins from Wire, clocks SCL (up to 9 pulses)
+ * until the slave lets go of SDA, sends a STOP and restarts Wire at the
+ * configured clock. Recoveries are at least I2C_RECOVER_INTERVAL_MS apart;
+ * in between, transactions on the stuck bus fail immediately
+ * (I2C_BUS_STUCK). Address NACKs (a device that is not fitted) never count.
+ *
+ * Per-device counters: transactions, NACKs, timeouts and other errors by
+ * address (I2C_MAX_DEVICES), from i2cWrite()/i2cRead() and from
+ * i2cNoteResult() for drivers that see a Wire status themselves.
+ *
+ * Jobs: long traffic is queued as a job (i2cQueueJob()) that does its work
+ * in slices - a full LCD redraw is ~80 characters at close to a millisecond
+ * each on a 100 kHz bus. updateI2CEngine() runs the queued jobs once per
+ * loop pass, sensor jobs before display jobs, until I2C_PASS_BUDGET_US is
+ * used up; a job checks i2cSliceDone() between units of work and returns
+ * false to be called again next pass. Sensor reads and the rest of the loop
+ * run between the slices.
+ *
+ * BUS I2C shows the bus state, the recoveries and the per-device counters;
+ * BUS I2C RECOVER runs a recovery by hand. BUS I2C SCAN lists the addresses
+ * that answer i2cProbe() (device_inventory.h).
+ *
+ * Usage:
+ *   uint8_t reg[3] = { 0x01, hi, lo };
+ *   if (i2cWrite(addr, reg, 3) != I2C_OK) ...
+ *
+ *   static bool flushJob() {            // Slice of a long transfer
+ *       if (!i2cBusReady()) return false;
+ *       while (work left) { send one unit; if (i2cSliceDone()) return false; }
+ *       return true;                    // Done - leave the queue
+ *   }
+ *   i2cQueueJob(flushJob, I2C_JOB_DISPLAY);
+ *
+ * Build Flags:
+ *   -D I2C_TIMEOUT_US=n           - Longest wait for a busy bus / a transaction (default 10000)
+ *   -D I2C_RECOVER_ERRORS=n       - Bus errors in a row that mark the bus stuck (default 3)
+ *   -D I2C_RECOVER_INTERVAL_MS=n  - Shortest time between recoveries (default 1000)
+ *   -D I2C_MAX_DEVICES=n          - Addresses with their own counters (default 8; 4 on AVR)
+ *   -D I2C_PASS_BUDGET_US=n       - Job time per loop pass (default 1000)
+ */
+
+#ifndef I2C_ENGINE_H
+#define I2C_ENGINE_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#ifndef I2C_TIMEOUT_US
+#define I2C_TIMEOUT_US 10000
+#endif
+
+#ifndef I2C_RECOVER_ERRORS
+#define I2C_RECOVER_ERRORS 3
+#endif
+
+#ifndef I2C_RECOVER_INTERVAL_MS
+#define I2C_RECOVER_INTERVAL_MS 1000
+#endif
+
+#ifndef I2C_MAX_DEVICES
+  #if defined(__AVR__)
+    #define I2C_MAX_DEVICES 4
+  #else
+    #define I2C_MAX_DEVICES 8
+  #endif
+#endif
+
+#ifndef I2C_PASS_BUDGET_US
+#define I2C_PASS_BUDGET_US 1000
+#endif
+
+#define I2C_MAX_JOBS 4
+
+// Transaction status (Wire's endTransmission() codes, plus the engine's)
+#define I2C_OK          0
+#define I2C_NACK_ADDR   2   // No device answered
+#define I2C_NACK_DATA   3
+#define I2C_ERROR       4   // Bus error, arbitration lost, short read
+#define I2C_TIMEOUT     5   // Core timeout expired
+#define I2C_BUS_STUCK   6   // Not attempted - bus held busy
+
+enum I2CJobPriority : uint8_t {
+    I2C_JOB_SENSOR = 0,
+    I2C_JOB_DISPLAY
+};
+
+// One slice of a job; true when the job is finished
+typedef bool (*I2CJobFn)();
+
+// Set the core's transaction timeout on a bus (initI2CBus())
+void configureI2CTimeout(TwoWire* wire);
+
+/**
+ * Is the active bus free for a transaction?
+ * Runs a recovery when the bus is stuck and one is due.
+ * @return false if the bus is stuck - skip the traffic this time
+ */
+bool i2cBusReady();
+
+/**
+ * Write bytes to a device (one transaction, with STOP)
+ * @return I2C_OK or an error status
+ */
+uint8_t i2cWrite(uint8_t address, const uint8_t* data, uint8_t len);
+
+/**
+ * Read bytes from a device (no register pointer write - see i2cWrite())
+ * @return I2C_OK or an error status
+ */
+uint8_t i2cRead(uint8_t address, uint8_t* data, uint8_t len);
+
+/**
+ * Address a device without data - is anything there? (BUS I2C SCAN)
+ * NACKs are not counted per device; bus errors count toward recovery
+ * @return I2C_OK if it acknowledged, else an error status
+ */
+uint8_t i2cProbe(uint8_t address);
+
+// Count a Wire status for a device (drivers calling Wire themselves)
+void i2cNoteResult(uint8_t address, uint8_t status);
+
+/**
+ * Free the bus: clock out a slave holding SDA, STOP, restart Wire
+ * @return true if both lines are released afterwards
+ */
+bool i2cRecoverBus();
+
+/**
+ * Queue a job (no-op if it is already queued)
+ * @return false if the queue is full
+ */
+bool i2cQueueJob(I2CJobFn job, I2CJobPriority priority);
+
+// Inside a job: true once this pass's I2C_PASS_BUDGET_US is used up
+bool i2cSliceDone();
+
+// Run the queued jobs within the pass budget (main loop, every pass)
+void updateI2CEngine();
+
+// Bus state, recoveries and per-device counters (BUS I2C)
+void printI2CEngineStatus();
+
+#endif // I2C_ENGINE_H
@@ -0,0 +1,221 @@
+/*
+ * isotp.cpp - ISO 15765-2 (ISO-TP) transport over classic CAN
+ */
+
+#include "isotp.h"
+
+void isotpReset(IsoTpReceiver* rx) {
+    rx->length = 0;
+    rx->received = 0;
+    rx->nextSeq = 1;
+    rx->active = false;
+}
+
+IsoTpRxStatus isotpReceive(IsoTpReceiver* rx, const uint8_t* frame, uint8_t len, uint32_t rxMs) {
+    if (len == 0) return ISOTP_RX_IGNORED;
+
+    uint8_t type = frame[0] >> 4;
+
+    switch (type) {
+        case ISOTP_SINGLE_FRAME: {
+            uint8_t sfLength = frame[0] & 0x0F;
+            if (sfLength == 0 || sfLength > 7 || sfLength > len - 1) {
+                isotpReset(rx);
+                return ISOTP_RX_ERROR;
+            }
+            // A new message replaces one in progress (the sender gave up on it)
+            memcpy(rx->data, &frame[1], sfLength);
+            rx->length = sfLength;
+            rx->received = sfLength;
+            rx->active = false;
+            rx->lastFrameMs = rxMs;
+            return ISOTP_RX_COMPLETE;
+        }
+
+        case ISOTP_FIRST_FRAME: {
+            if (len < ISOTP_FRAME_LEN) {
+                isotpReset(rx);
+                return ISOTP_RX_ERROR;  // FF is always a full frame
+            }
+            uint16_t ffLength = ((uint16_t)(frame[0] & 0x0F) << 8) | frame[1];
+            if (ffLength <= 7) {
+                isotpReset(rx);
+                return ISOTP_RX_ERROR;  // Would have fit a Single Frame
+            }
+            if (ffLength > ISOTP_MAX_PAYLOAD) {
+                isotpReset(rx);
+                return ISOTP_RX_OVERFLOW;
+            }
+            memcpy(rx->data, &frame[2], 6);
+            rx->length = ffLength;
+            rx->received = 6;
+            rx->nextSeq = 1;
+            rx->active = true;
+            rx->lastFrameMs = rxMs;
+            return ISOTP_RX_FIRST_FRAME;
+        }
+
+        case ISOTP_CONSECUTIVE_FRAME: {
+            if (!rx->active) return ISOTP_RX_IGNORED;
+
+            if ((uint32_t)(rxMs - rx->lastFrameMs) > ISOTP_TIMEOUT_MS ||
+                (frame[0] & 0x0F) != rx->nextSeq) {
+                isotpReset(rx);
+                return ISOTP_RX_ERROR;
+            }
+
+            uint16_t remaining = rx->length - rx->received;
+            uint8_t chunk = remaining < 7 ? remaining : 7;
+            if (len - 1 < chunk) {
+                isotpReset(rx);
+                return ISOTP_RX_ERROR;  // Truncated frame
+            }
+            memcpy(&rx->data[rx->received], &frame[1], chunk);
+            rx->received += chunk;
+            rx->nextSeq = (rx->nextSeq + 1) & 0x0F;
+            rx->lastFrameMs = rxMs;
+
+            if (rx->received >= rx->length) {
+                rx->active = false;
+                return ISOTP_RX_COMPLETE;
+            }
+            return ISOTP_RX_IN_PROGRESS;
+        }
+
+        default:
+            return ISOTP_RX_IGNORED;  // Flow Control - only a sender cares
+    }
+}
+
+void isotpBuildFlowControl(uint8_t* frame, uint8_t status, uint8_t blockSize, uint8_t stMin) {
+    memset(frame, ISOTP_PAD_BYTE, ISOTP_FRAME_LEN);
+    frame[0] = (ISOTP_FLOW_CONTROL << 4) | (status & 0x0F);
+    frame[1] = blockSize;
+    frame[2] = stMin;
+}
+
+bool isotpBuildSingleFrame(uint8_t* frame, const uint8_t* data, uint8_t len) {
+    if (len == 0 || len > 7) return false;
+    memset(frame, ISOTP_PAD_BYTE, ISOTP_FRAME_LEN);
+    frame[0] = (ISOTP_SINGLE_FRAME << 4) | len;
+    memcpy(&frame[1], data, len);
+    return true;
+}
+
+// ===== SENDER =====
+
+// STmin byte to microseconds: 0x00-0x7F ms, 0xF1-0xF9 100-900 us, reserved values as 127 ms
+static uint32_t decodeSTmin(uint8_t stMin) {
+    if (stMin <= 0x7F) return (uint32_t)stMin * 1000;
+    if (stMin >= 0xF1 && stMin <= 0xF9) return (uint32_t)(stMin - 0xF0) * 100;
+    return 127000;
+}
+
+bool isotpStartSend(IsoTpSender* tx, const uint8_t* data, uint16_t len) {
+    if (len == 0 || len > ISOTP_MAX_PAYLOAD) {
+        tx->state = ISOTP_TX_IDLE;
+        return false;
+    }
+    memcpy(tx->data, data, len);
+    tx->length = len;
+    tx->sent = 0;
+    tx->seq = 1;
+    tx->blockSize = 0;
+    tx->blockSent = 0;
+    tx->waits = 0;
+    tx->stMinUs = 0;
+    tx->state = ISOTP_TX_SENDING;  // SF or FF due
+    return true;
+}
+
+bool isotpNextFrame(const IsoTpSender* tx, uint8_t* frame, uint32_t nowUs) {
+    if (tx->state != ISOTP_TX_SENDING) return false;
+
+    if (tx->sent == 0) {
+        if (tx->length <= 7) {
+            return isotpBuildSingleFrame(frame, tx->data, tx->length);
+        }
+        frame[0] = (ISOTP_FIRST_FRAME << 4) | ((tx->length >> 8) & 0x0F);
+        frame[1] = tx->length & 0xFF;
+        memcpy(&frame[2], tx->data, 6);
+        return true;
+    }
+
+    // First CF of a block goes straight after the Flow Control
+    if (tx->blockSent > 0 && (uint32_t)(nowUs - tx->lastFrameUs) < tx->stMinUs) return false;
+
+    uint16_t remaining = tx->length - tx->sent;
+    uint8_t chunk = remaining < 7 ? remaining : 7;
+    memset(frame, ISOTP_PAD_BYTE, ISOTP_FRAME_LEN);
+    frame[0] = (ISOTP_CONSECUTIVE_FRAME << 4) | tx->seq;
+    memcpy(&frame[1], &tx->data[tx->sent], chunk);
+    return true;
+}
+
+void isotpFrameSent(IsoTpSender* tx, uint32_t nowUs, uint32_t nowMs) {
+    if (tx->state != ISOTP_TX_SENDING) return;
+    tx->lastEventMs = nowMs;
+
+    if (tx->sent == 0) {
+        if (tx->length <= 7) {
+            tx->sent = tx->length;
+            tx->state = ISOTP_TX_IDLE;
+        } else {
+            tx->sent = 6;
+            tx->state = ISOTP_TX_WAIT_FLOW;
+        }
+        return;
+    }
+
+    uint16_t remaining = tx->length - tx->sent;
+    tx->sent += remaining < 7 ? remaining : 7;
+    tx->seq = (tx->seq + 1) & 0x0F;
+    tx->lastFrameUs = nowUs;
+    tx->blockSent++;
+
+    if (tx->sent >= tx->length) {
+        tx->state = ISOTP_TX_IDLE;
+    } else if (tx->blockSize != 0 && tx->blockSent >= tx->blockSize) {
+        tx->state = ISOTP_TX_WAIT_FLOW;
+    }
+}
+
+IsoTpTxStatus isotpHandleFlowControl(IsoTpSender* tx, const uint8_t* frame, uint8_t len, uint32_t nowMs) {
+    if (tx->state != ISOTP_TX_WAIT_FLOW || len == 0 || (frame[0] >> 4) != ISOTP_FLOW_CONTROL) {
+        return ISOTP_TX_IGNORED;
+    }
+    if (len < 3) {
+        tx->state = ISOTP_TX_IDLE;
+        return ISOTP_TX_ABORTED;
+    }
+
+    switch (frame[0] & 0x0F) {
+        case ISOTP_FC_CONTINUE:
+            tx->blockSize = frame[1];
+            tx->blockSent = 0;
+            tx->waits = 0;
+            tx->stMinUs = decodeSTmin(frame[2]);
+            tx->state = ISOTP_TX_SENDING;
+            tx->lastEventMs = nowMs;
+            return ISOTP_TX_CONTINUE;
+
+        case ISOTP_FC_WAIT:
+            if (++tx->waits > ISOTP_MAX_WAIT_FRAMES) {
+                tx->state = ISOTP_TX_IDLE;
+                return ISOTP_TX_ABORTED;
+            }
+            tx->lastEventMs = nowMs;  // Another FC is due within the timeout
+            return ISOTP_TX_WAITING;
+
+        default:
+            tx->state = ISOTP_TX_IDLE;  // Overflow or invalid status
+            return ISOTP_TX_ABORTED;
+    }
+}
+
+bool isotpCheckSendTimeout(IsoTpSender* tx, uint32_t nowMs) {
+    if (tx->state != ISOTP_TX_WAIT_FLOW) return false;
+    if ((uint32_t)(nowMs - tx->lastEventMs) <= ISOTP_TIMEOUT_MS) return false;
+    tx->state = ISOTP_TX_IDLE;
+    return true;
+}
@@ -0,0 +1,186 @@
+/*
+ * isotp.h - ISO 15765-2 (ISO-TP) transport over classic CAN
+ *
+ * OBD-II messages longer than a single frame's 7 bytes - multi-PID Mode 01
+ * responses, Mode 09 VIN - travel as a First Frame followed by Consecutive
+ * Frames, paced by the receiver's Flow Control:
+ *
+ *   Single Frame       [0x0L  d0..d6]            L = length 1-7
+ *   First Frame        [0x1H  LL  d0..d5]        HLL = total length (12 bit)
+ *   Consecutive Frame  [0x2N  d..]               N = sequence number 1-15, 0, 1...
+ *   Flow Control       [0x3S  BS  STmin]         S = 0 continue, 1 wait, 2 overflow
+ *
+ * The receiver reassembles one message at a time into a fixed buffer; the
+ * caller sends the Flow Control frame when isotpReceive() reports a First
+ * Frame (the transport doesn't own a bus). The sender segments one message
+ * at a time: it waits for Flow Control after the First Frame and after each
+ * block of BS Consecutive Frames, and spaces Consecutive Frames by the
+ * receiver's STmin. Frames are padded to 8 bytes, as ISO 15765-4 requires
+ * for OBD-II.
+ *
+ * Usage (sender):
+ *   isotpStartSend(&tx, msg, len);
+ *   while (isotpNextFrame(&tx, frame, micros()) && write(frame)) isotpFrameSent(&tx, micros(), millis());
+ *   isotpHandleFlowControl(&tx, rxFrame, rxLen, millis());   // FC from the receiver
+ *
+ * Build Flags:
+ *   -D ISOTP_MAX_PAYLOAD=n    - Reassembly buffer bytes (default 32 on AVR, 128 elsewhere)
+ *   -D ISOTP_TIMEOUT_MS=n     - Longest gap between frames of a message, or wait for
+ *                               Flow Control (default 150, N_Cr / N_Bs)
+ *   -D ISOTP_MAX_WAIT_FRAMES=n - Flow Control WAITs accepted per block (default 8, N_WFTmax)
+ */
+
+#ifndef ISOTP_H
+#define ISOTP_H
+
+#include <Arduino.h>
+
+#ifndef ISOTP_MAX_PAYLOAD
+  #if defined(__AVR__)
+    #define ISOTP_MAX_PAYLOAD 32   // 6-PID Mode 01 response (31 bytes)
+  #else
+    #define ISOTP_MAX_PAYLOAD 128
+  #endif
+#endif
+
+#ifndef ISOTP_TIMEOUT_MS
+#define ISOTP_TIMEOUT_MS 150
+#endif
+
+#ifndef ISOTP_MAX_WAIT_FRAMES
+#define ISOTP_MAX_WAIT_FRAMES 8
+#endif
+
+#define ISOTP_FRAME_LEN   8     // Classic CAN, padded
+#define ISOTP_PAD_BYTE    0x00
+
+// Protocol control information (high nibble of byte 0)
+enum IsoTpFrameType : uint8_t {
+    ISOTP_SINGLE_FRAME      = 0x0,
+    ISOTP_FIRST_FRAME       = 0x1,
+    ISOTP_CONSECUTIVE_FRAME = 0x2,
+    ISOTP_FLOW_CONTROL      = 0x3
+};
+
+enum IsoTpFlowStatus : uint8_t {
+    ISOTP_FC_CONTINUE = 0,      // Clear to send
+    ISOTP_FC_WAIT     = 1,
+    ISOTP_FC_OVERFLOW = 2       // Message too long for the receiver
+};
+
+enum IsoTpRxStatus : uint8_t {
+    ISOTP_RX_IGNORED,           // Not part of a message (stray CF, flow control)
+    ISOTP_RX_FIRST_FRAME,       // First Frame accepted - send Flow Control now
+    ISOTP_RX_IN_PROGRESS,       // Consecutive Frame accepted, more to come
+    ISOTP_RX_COMPLETE,          // data[0..length) holds the message
+    ISOTP_RX_OVERFLOW,          // First Frame longer than ISOTP_MAX_PAYLOAD - send FC overflow
+    ISOTP_RX_ERROR              // Bad length, sequence gap or timeout - message dropped
+};
+
+enum IsoTpTxState : uint8_t {
+    ISOTP_TX_IDLE,              // Nothing to send (or the message went out)
+    ISOTP_TX_WAIT_FLOW,         // FF or a block sent - waiting for Flow Control
+    ISOTP_TX_SENDING            // Consecutive Frames due, paced by STmin
+};
+
+enum IsoTpTxStatus : uint8_t {
+    ISOTP_TX_IGNORED,           // Not a Flow Control for a waiting sender
+    ISOTP_TX_CONTINUE,          // Clear to send the next block
+    ISOTP_TX_WAITING,           // Receiver asked to wait - next FC pending
+    ISOTP_TX_ABORTED            // Receiver overflow, too many WAITs, or bad FC
+};
+
+struct IsoTpReceiver {
+    uint8_t data[ISOTP_MAX_PAYLOAD];
+    uint16_t length;            // Message length announced by the SF / FF
+    uint16_t received;          // Bytes reassembled so far
+    uint8_t nextSeq;            // Expected Consecutive Frame sequence number
+    bool active;                // Multi-frame message in progress
+    uint32_t lastFrameMs;       // Receive time of the previous frame
+};
+
+struct IsoTpSender {
+    uint8_t data[ISOTP_MAX_PAYLOAD];
+    uint16_t length;            // Message length
+    uint16_t sent;              // Bytes framed and sent so far
+    uint8_t seq;                // Next Consecutive Frame sequence number
+    uint8_t blockSize;          // Receiver's BS (0 = one block)
+    uint8_t blockSent;          // Consecutive Frames sent in this block
+    uint8_t waits;              // FC WAITs received for this block
+    IsoTpTxState state;
+    uint32_t stMinUs;           // Receiver's STmin
+    uint32_t lastFrameUs;       // micros() of the previous Consecutive Frame
+    uint32_t lastEventMs;       // millis() of the last frame sent or FC received
+};
+
+/**
+ * Drop any message in progress
+ */
+void isotpReset(IsoTpReceiver* rx);
+
+/**
+ * Feed one received frame to the receiver
+ * @param rx     Receiver state
+ * @param frame  Frame data
+ * @param len    Frame length (a short final CF is accepted)
+ * @param rxMs   millis() when the frame was received
+ * @return       What the frame did (see IsoTpRxStatus)
+ */
+IsoTpRxStatus isotpReceive(IsoTpReceiver* rx, const uint8_t* frame, uint8_t len, uint32_t rxMs);
+
+/**
+ * Fill an 8-byte Flow Control frame
+ * @param frame      Output, ISOTP_FRAME_LEN bytes
+ * @param status     IsoTpFlowStatus
+ * @param blockSize  Consecutive Frames before the next FC (0 = no further FC)
+ * @param stMin      Minimum gap between Consecutive Frames (0-127 ms)
+ */
+void isotpBuildFlowControl(uint8_t* frame, uint8_t status, uint8_t blockSize, uint8_t stMin);
+
+/**
+ * Fill an 8-byte Single Frame
+ * @return  false if len is 0 or more than 7
+ */
+bool isotpBuildSingleFrame(uint8_t* frame, const uint8_t* data, uint8_t len);
+
+/**
+ * Queue a message to send (replaces one in progress)
+ * Messages of up to 7 bytes go as a Single Frame.
+ * @return  false if len is 0 or more than ISOTP_MAX_PAYLOAD
+ */
+bool isotpStartSend(IsoTpSender* tx, const uint8_t* data, uint16_t len);
+
+/**
+ * Frame to send next, if one is due
+ * Doesn't advance the sender - call isotpFrameSent() once the frame is
+ * written, so a full transmit queue just retries later.
+ * @param frame  Output, ISOTP_FRAME_LEN bytes
+ * @param nowUs  micros(), for STmin
+ * @return       true if frame holds the next SF / FF / CF
+ */
+bool isotpNextFrame(const IsoTpSender* tx, uint8_t* frame, uint32_t nowUs);
+
+/**
+ * The frame from isotpNextFrame() was written
+ */
+void isotpFrameSent(IsoTpSender* tx, uint32_t nowUs, uint32_t nowMs);
+
+/**
+ * Feed a received Flow Control frame to the sender
+ */
+IsoTpTxStatus isotpHandleFlowControl(IsoTpSender* tx, const uint8_t* frame, uint8_t len, uint32_t nowMs);
+
+/**
+ * Message in progress (a frame still to send, or Flow Control awaited)
+ */
+inline bool isotpSending(const IsoTpSender* tx) {
+    return tx->state != ISOTP_TX_IDLE;
+}
+
+/**
+ * Drop the message if the receiver's Flow Control is overdue
+ * @return  true if the message was dropped
+ */
+bool isotpCheckSendTimeout(IsoTpSender* tx, uint32_t nowMs);
+
+#endif // ISOTP_H
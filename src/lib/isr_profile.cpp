@@ -0,0 +1,98 @@
+/*
+ * isr_profile.cpp - Interrupt handler duration and rate counters
+ */
+
+#include "isr_profile.h"
+
+#ifdef ENABLE_ISR_PROFILER
+
+#include "message_api.h"
+#include "float_format.h"
+
+#define ISR_PROFILE_WINDOW_SHIFT 20     // micros() >> 20: 1.049 s windows
+
+static volatile IsrProfileStats isrStats[NUM_ISR_PROFILE_SLOTS];
+static uint32_t resetMs = 0;
+
+HAL_ISR void isrProfileRecord(uint8_t slot, uint32_t startUs) {
+    uint32_t elapsed = micros() - startUs;
+    volatile IsrProfileStats* s = &isrStats[slot];
+    s->count++;
+    s->totalUs += elapsed;
+    if (elapsed > s->maxUs) s->maxUs = elapsed;
+
+    uint16_t window = (uint16_t)(startUs >> ISR_PROFILE_WINDOW_SHIFT);
+    if (window != s->window) {
+        s->window = window;
+        s->windowCount = 0;
+    }
+    if (++s->windowCount > s->peakWindow) s->peakWindow = s->windowCount;
+}
+
+bool getIsrProfile(uint8_t slot, IsrProfileStats* stats) {
+    if (slot >= NUM_ISR_PROFILE_SLOTS) return false;
+    noInterrupts();
+    stats->count = isrStats[slot].count;
+    stats->totalUs = isrStats[slot].totalUs;
+    stats->maxUs = isrStats[slot].maxUs;
+    stats->window = isrStats[slot].window;
+    stats->windowCount = isrStats[slot].windowCount;
+    stats->peakWindow = isrStats[slot].peakWindow;
+    interrupts();
+    return stats->count > 0;
+}
+
+void isrProfileReset() {
+    noInterrupts();
+    for (uint8_t i = 0; i < NUM_ISR_PROFILE_SLOTS; i++) {
+        isrStats[i].count = 0;
+        isrStats[i].totalUs = 0;
+        isrStats[i].maxUs = 0;
+        isrStats[i].windowCount = 0;
+        isrStats[i].peakWindow = 0;
+    }
+    interrupts();
+    resetMs = millis();
+}
+
+static const __FlashStringHelper* isrSlotName(uint8_t slot) {
+    switch (slot) {
+        case ISR_PROF_FREQ_CAPTURE: return F("FREQ_CAPTURE");
+        case ISR_PROF_CAN_RX:       return F("CAN_RX");
+        case ISR_PROF_PPS:          return F("PPS");
+        case ISR_PROF_EXT_ADC:      return F("EXT_ADC");
+        case ISR_PROF_SAMPLE_TIMER: return F("SAMPLE_TIMER");
+        case ISR_PROF_BUTTON:       return F("BUTTON");
+        case ISR_PROF_STATE_CAPTURE: return F("STATE_CAPTURE");
+        default:                    return F("?");
+    }
+}
+
+void printIsrProfile() {
+    uint32_t elapsedMs = millis() - resetMs;
+    if (elapsedMs == 0) elapsedMs = 1;
+
+    msg.control.println(F("ISR: calls rate/s peak/s avg/max us cpu%"));
+    bool any = false;
+    for (uint8_t slot = 0; slot < NUM_ISR_PROFILE_SLOTS; slot++) {
+        IsrProfileStats s;
+        if (!getIsrProfile(slot, &s)) continue;
+        any = true;
+
+        char line[64];
+        snprintf(line, sizeof(line), ": %lu %lu %lu %lu/%lu ",
+                 (unsigned long)s.count,
+                 (unsigned long)((uint64_t)s.count * 1000 / elapsedMs),
+                 (unsigned long)((uint64_t)s.peakWindow * 1000000UL >> ISR_PROFILE_WINDOW_SHIFT),
+                 (unsigned long)(s.totalUs / s.count), (unsigned long)s.maxUs);
+        char cpu[FLOAT_FORMAT_SIZE];
+        formatFixed(cpu, s.totalUs / (elapsedMs * 10.0f), 2);   // us per ms / 10 = percent
+        msg.control.print(F("ISR "));
+        msg.control.print(isrSlotName(slot));
+        msg.control.print(line);
+        msg.control.println(cpu);
+    }
+    if (!any) msg.control.println(F("  (no interrupts since the last reset)"));
+}
+
+#endif // ENABLE_ISR_PROFILER
@@ -0,0 +1,85 @@
+/*
+ * isr_profile.h - Interrupt handler duration and rate counters
+ *
+ * Opt-in (-D ENABLE_ISR_PROFILER, with ENABLE_PROFILER): each interrupt
+ * source keeps its call count, total and longest time in the handler, and
+ * the most calls seen in one ~1 s window. PROFILE shows them after the loop
+ * slots - rate, peak rate, average and worst duration and the share of the
+ * CPU spent in each - so frequency capture at full pulse rate can be checked
+ * against CAN receive and the radio at their busiest.
+ *
+ * Sources are grouped by kind (every capture channel in one slot, both CAN
+ * buses in another). Recording costs two micros() calls and a few adds per
+ * interrupt, and the recorder is itself HAL_ISR (hal/hal_placement.h). The
+ * window is micros() >> 20, 1.049 s: the peak is scaled to per second.
+ * CAN on an ESP32 (TWAI) takes no interrupt of ours - the driver queues
+ * frames and pumpCANRx() reads them under the CAN_INPUT loop slot.
+ *
+ * Usage:
+ *   HAL_ISR static void ppsISR() {
+ *       ISR_PROFILE_BEGIN();
+ *       ...
+ *       ISR_PROFILE_END(ISR_PROF_PPS);
+ *   }
+ *
+ * Without ENABLE_ISR_PROFILER both macros compile to nothing.
+ *
+ * Build Flags:
+ *   -D ENABLE_ISR_PROFILER  - Count interrupt handler time and rate (needs ENABLE_PROFILER)
+ */
+
+#ifndef ISR_PROFILE_H
+#define ISR_PROFILE_H
+
+#include <Arduino.h>
+#include "../hal/hal_placement.h"
+
+#if defined(ENABLE_ISR_PROFILER) && !defined(ENABLE_PROFILER)
+#error "ENABLE_ISR_PROFILER is reported by PROFILE - it needs ENABLE_PROFILER"
+#endif
+
+enum IsrProfileSlot : uint8_t {
+    ISR_PROF_FREQ_CAPTURE = 0,  // Pulse edges (freq_capture.h)
+    ISR_PROF_CAN_RX,            // FlexCAN FIFO callback, MCP2515 INT
+    ISR_PROF_PPS,               // GPS PPS edge (timebase.h)
+    ISR_PROF_EXT_ADC,           // ADS1115 ALERT/RDY (ext_adc.h)
+    ISR_PROF_SAMPLE_TIMER,      // Bench stream sampling (bench_stream.h)
+    ISR_PROF_BUTTON,            // MODE_BUTTON edges (button_handler.h)
+    ISR_PROF_STATE_CAPTURE,     // On/off input edges (state_capture.h)
+    NUM_ISR_PROFILE_SLOTS
+};
+
+#ifdef ENABLE_ISR_PROFILER
+
+struct IsrProfileStats {
+    uint32_t count;
+    uint32_t totalUs;           // Wraps after ~71 minutes in the handler - PROFILE RESET
+    uint32_t maxUs;
+    uint16_t window;            // micros() >> 20 of the current rate window
+    uint32_t windowCount;       // Calls in it so far
+    uint32_t peakWindow;        // Most calls in one window
+};
+
+// Record one handler run that started at startUs (interrupt context, HAL_ISR)
+void isrProfileRecord(uint8_t slot, uint32_t startUs);
+
+// Consistent copy of a slot's counters; false if the slot never ran
+bool getIsrProfile(uint8_t slot, IsrProfileStats* stats);
+
+// Clear every slot and restart the rate clock
+void isrProfileReset();
+
+// The ISR table of PROFILE
+void printIsrProfile();
+
+#define ISR_PROFILE_BEGIN() uint32_t _isr_prof_start = micros()
+#define ISR_PROFILE_END(slot) isrProfileRecord((slot), _isr_prof_start)
+
+#else
+
+#define ISR_PROFILE_BEGIN() do { } while (0)
+#define ISR_PROFILE_END(slot) do { } while (0)
+
+#endif // ENABLE_ISR_PROFILER
+
+#endif // ISR_PROFILE_H
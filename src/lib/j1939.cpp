@@ -0,0 +1,153 @@
+/*
+ * j1939.cpp - SAE J1939 addressing, transport protocol (BAM) and SPN encoding
+ */
+
+#include "j1939.h"
+
+// ===== TRANSPORT PROTOCOL (BAM) =====
+
+void j1939TpReset(J1939TpReceiver* rx) {
+    for (uint8_t i = 0; i < J1939_TP_SESSIONS; i++) {
+        rx->sessions[i].active = false;
+    }
+}
+
+// Session following source, or nullptr
+static J1939TpSession* findSession(J1939TpReceiver* rx, uint8_t source) {
+    for (uint8_t i = 0; i < J1939_TP_SESSIONS; i++) {
+        if (rx->sessions[i].active && rx->sessions[i].source == source) return &rx->sessions[i];
+    }
+    return nullptr;
+}
+
+// Free session, or one whose sender went quiet
+static J1939TpSession* claimSession(J1939TpReceiver* rx, uint32_t rxMs) {
+    for (uint8_t i = 0; i < J1939_TP_SESSIONS; i++) {
+        J1939TpSession& s = rx->sessions[i];
+        if (!s.active || (uint32_t)(rxMs - s.lastMs) > J1939_TP_TIMEOUT_MS) return &s;
+    }
+    return nullptr;
+}
+
+static J1939TpStatus receiveAnnouncement(J1939TpReceiver* rx, const J1939Id& id, const uint8_t* data,
+                                         uint8_t len, uint32_t rxMs) {
+    if (len < 8 || data[0] != J1939_TP_CM_BAM || id.dest != J1939_GLOBAL_ADDRESS) {
+        return J1939_TP_IGNORED;  // RTS/CTS, abort, or a BAM to a single node
+    }
+
+    // A new announcement from the same sender replaces its message in progress
+    J1939TpSession* s = findSession(rx, id.source);
+    if (s) s->active = false;
+
+    uint16_t length = data[1] | ((uint16_t)data[2] << 8);
+    uint8_t packets = data[3];
+    if (length < 9 || packets != (length + 6) / 7) {
+        rx->dropped++;
+        return J1939_TP_ERROR;
+    }
+    if (length > J1939_TP_MAX_PAYLOAD) {
+        rx->dropped++;
+        return J1939_TP_ERROR;
+    }
+
+    if (!s) s = claimSession(rx, rxMs);
+    if (!s) {
+        rx->dropped++;
+        return J1939_TP_ERROR;
+    }
+
+    s->pgn = data[5] | ((uint32_t)data[6] << 8) | ((uint32_t)(data[7] & 0x03) << 16);
+    s->length = length;
+    s->packets = packets;
+    s->nextSeq = 1;
+    s->source = id.source;
+    s->lastMs = rxMs;
+    s->active = true;
+    return J1939_TP_IN_PROGRESS;
+}
+
+static J1939TpStatus receivePacket(J1939TpReceiver* rx, const J1939Id& id, const uint8_t* data,
+                                   uint8_t len, uint32_t rxMs, const J1939TpSession** complete) {
+    J1939TpSession* s = findSession(rx, id.source);
+    if (!s || len < 2) return J1939_TP_IGNORED;
+
+    if ((uint32_t)(rxMs - s->lastMs) > J1939_TP_TIMEOUT_MS || data[0] != s->nextSeq) {
+        s->active = false;
+        rx->dropped++;
+        return J1939_TP_ERROR;
+    }
+
+    uint16_t offset = (uint16_t)(s->nextSeq - 1) * 7;
+    uint16_t remaining = s->length - offset;
+    uint8_t chunk = remaining < 7 ? remaining : 7;
+    if (len - 1 < chunk) {
+        s->active = false;
+        rx->dropped++;
+        return J1939_TP_ERROR;  // Truncated packet
+    }
+    memcpy(&s->data[offset], &data[1], chunk);
+    s->lastMs = rxMs;
+
+    if (s->nextSeq++ < s->packets) return J1939_TP_IN_PROGRESS;
+
+    s->active = false;
+    rx->completed++;
+    *complete = s;
+    return J1939_TP_COMPLETE;
+}
+
+J1939TpStatus j1939TpReceive(J1939TpReceiver* rx, const J1939Id& id, const uint8_t* data, uint8_t len,
+                             uint32_t rxMs, const J1939TpSession** complete) {
+    switch (id.pgn) {
+        case J1939_PGN_TP_CM: return receiveAnnouncement(rx, id, data, len, rxMs);
+        case J1939_PGN_TP_DT: return receivePacket(rx, id, data, len, rxMs, complete);
+        default:              return J1939_TP_IGNORED;
+    }
+}
+
+// ===== SPN ENCODING =====
+
+// Standard units: C, bar, V, RPM, km/h
+static const J1939Spn spnTable[] PROGMEM = {
+    //  SPN   PGN     PID   byte width prio resolution  offset
+    {  110, 0xFEEE, 0x05, 0, 1, 6, 1.0f,        -40.0f  },  // ET1 Engine coolant temperature
+    {  175, 0xFEEE, 0x5C, 2, 2, 6, 0.03125f,    -273.0f },  // ET1 Engine oil temperature 1
+    {   94, 0xFEEF, 0x0A, 0, 1, 6, 0.04f,       0.0f    },  // EFL/P1 Fuel delivery pressure (4 kPa)
+    {  100, 0xFEEF, 0xCA, 3, 1, 6, 0.04f,       0.0f    },  // EFL/P1 Engine oil pressure (4 kPa)
+    {  102, 0xFEF6, 0x6F, 1, 1, 6, 0.02f,       0.0f    },  // IC1 Intake manifold 1 pressure (2 kPa)
+    {  173, 0xFEF6, 0x78, 5, 2, 6, 0.03125f,    -273.0f },  // IC1 Exhaust gas temperature
+    {  108, 0xFEF5, 0x33, 0, 1, 6, 0.005f,      0.0f    },  // AMB Barometric pressure (0.5 kPa)
+    {  171, 0xFEF5, 0x46, 3, 2, 6, 0.03125f,    -273.0f },  // AMB Ambient air temperature
+    {  168, 0xFEF7, 0xCB, 6, 2, 6, 0.05f,       0.0f    },  // VEP1 Battery potential
+    {  190, 0xF004, 0x0C, 3, 2, 3, 0.125f,      0.0f    },  // EEC1 Engine speed
+    {   84, 0xFEF1, 0x0D, 1, 2, 6, 0.00390625f, 0.0f    },  // CCVS Wheel-based vehicle speed
+};
+
+#define SPN_COUNT (sizeof(spnTable) / sizeof(spnTable[0]))
+
+uint8_t j1939FindSpn(uint8_t obd2pid) {
+    if (obd2pid == 0) return J1939_NO_SPN;
+    for (uint8_t i = 0; i < SPN_COUNT; i++) {
+        if (pgm_read_byte(&spnTable[i].obd2pid) == obd2pid) return i;
+    }
+    return J1939_NO_SPN;
+}
+
+J1939Spn j1939GetSpn(uint8_t index) {
+    J1939Spn spn;
+    memcpy_P(&spn, &spnTable[index], sizeof(spn));
+    return spn;
+}
+
+void j1939EncodeSpn(const J1939Spn& spn, float value, uint8_t* data) {
+    uint16_t maxValid = (spn.width == 1) ? 0xFA : 0xFAFF;  // Above: error / not available
+    uint16_t raw;
+    if (isnan(value)) {
+        raw = (spn.width == 1) ? 0xFF : 0xFFFF;
+    } else {
+        float scaled = (value - spn.offset) / spn.resolution + 0.5f;
+        raw = scaled < 0.0f ? 0 : (scaled >= maxValid ? maxValid : (uint16_t)scaled);
+    }
+    data[0] = raw & 0xFF;
+    if (spn.width == 2) data[1] = raw >> 8;
+}
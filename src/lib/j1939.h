@@ -0,0 +1,173 @@
+/*
+ * j1939.h - SAE J1939 addressing, transport protocol (BAM) and SPN encoding
+ *
+ * J1939 runs on 29-bit identifiers and addresses data by Parameter Group
+ * Number (PGN) rather than by CAN ID:
+ *
+ *   [28..26] priority  [25] EDP  [24] DP  [23..16] PF  [15..8] PS  [7..0] SA
+ *
+ *   PF <  240 (PDU1)  PS is the destination address - PGN = DP.PF.00
+ *   PF >= 240 (PDU2)  PS is the group extension     - PGN = DP.PF.PS
+ *
+ * Messages longer than 8 bytes are broadcast with the transport protocol:
+ * a TP.CM BAM announcement (PGN 60416, control byte 0x20, total size,
+ * packet count, the carried PGN) followed by TP.DT packets (PGN 60160,
+ * sequence number 1.. plus 7 data bytes). The receiver reassembles one
+ * message per source address at a time into a fixed buffer. Connection-mode
+ * transfers (RTS/CTS) need the receiver to answer and are not handled.
+ *
+ * Sensors go out as standard SPNs in their standard PGNs (engine
+ * temperature 65262, fluid level/pressure 65263, ...). An input is matched
+ * to an SPN by the OBD-II PID it is configured with, so the application
+ * presets (coolant temp 0x05, oil pressure 0xCA, ...) map without setup.
+ *
+ * Build Flags:
+ *   -D J1939_TP_SESSIONS=n     - BAM messages reassembled at once (default 2 on AVR, 4 elsewhere)
+ *   -D J1939_TP_MAX_PAYLOAD=n  - Largest reassembled message (default 32 on AVR, 64 elsewhere)
+ *   -D J1939_TP_TIMEOUT_MS=n   - Longest gap between BAM packets (default 750, T1)
+ */
+
+#ifndef J1939_H
+#define J1939_H
+
+#include <Arduino.h>
+
+#ifndef J1939_TP_SESSIONS
+  #if defined(__AVR__)
+    #define J1939_TP_SESSIONS 2
+  #else
+    #define J1939_TP_SESSIONS 4
+  #endif
+#endif
+
+#ifndef J1939_TP_MAX_PAYLOAD
+  #if defined(__AVR__)
+    #define J1939_TP_MAX_PAYLOAD 32
+  #else
+    #define J1939_TP_MAX_PAYLOAD 64
+  #endif
+#endif
+
+#ifndef J1939_TP_TIMEOUT_MS
+#define J1939_TP_TIMEOUT_MS 750
+#endif
+
+#define J1939_PGN_REQUEST          0xEA00   // 59904
+#define J1939_PGN_ADDRESS_CLAIMED  0xEE00   // 60928
+#define J1939_PGN_TP_CM            0xEC00   // 60416 - connection management
+#define J1939_PGN_TP_DT            0xEB00   // 60160 - data transfer
+
+#define J1939_GLOBAL_ADDRESS       0xFF
+#define J1939_NULL_ADDRESS         0xFE
+#define J1939_TP_CM_BAM            0x20
+#define J1939_DEFAULT_PRIORITY     6
+
+// PGN bits of a 29-bit ID as a filter mask (PDU1 leaves the destination out)
+#define J1939_PDU1_PGN_MASK        0x03FF0000UL
+#define J1939_PDU2_PGN_MASK        0x03FFFF00UL
+
+struct J1939Id {
+    uint32_t pgn;
+    uint8_t priority;
+    uint8_t source;         // SA
+    uint8_t dest;           // DA (PDU1), J1939_GLOBAL_ADDRESS for PDU2
+};
+
+inline J1939Id j1939ParseId(uint32_t id) {
+    J1939Id j;
+    uint8_t pf = (id >> 16) & 0xFF;
+    j.priority = (id >> 26) & 0x07;
+    j.source = id & 0xFF;
+    if (pf < 240) {
+        j.pgn = (id >> 8) & 0x3FF00;
+        j.dest = (id >> 8) & 0xFF;
+    } else {
+        j.pgn = (id >> 8) & 0x3FFFF;
+        j.dest = J1939_GLOBAL_ADDRESS;
+    }
+    return j;
+}
+
+inline uint32_t j1939BuildId(uint8_t priority, uint32_t pgn, uint8_t dest, uint8_t source) {
+    uint32_t id = ((uint32_t)(priority & 0x07) << 26) | ((pgn & 0x3FFFF) << 8) | source;
+    if (((pgn >> 8) & 0xFF) < 240) {
+        id = (id & ~0xFF00UL) | ((uint32_t)dest << 8);
+    }
+    return id;
+}
+
+// Filter mask matching every frame of a PGN, from any source
+inline uint32_t j1939PGNMask(uint32_t pgn) {
+    return (((pgn >> 8) & 0xFF) < 240) ? J1939_PDU1_PGN_MASK : J1939_PDU2_PGN_MASK;
+}
+
+// ===== TRANSPORT PROTOCOL (BAM) =====
+
+struct J1939TpSession {
+    uint32_t pgn;               // PGN carried
+    uint16_t length;            // Announced message size
+    uint8_t packets;            // Announced TP.DT count
+    uint8_t nextSeq;            // Expected TP.DT sequence number
+    uint8_t source;             // Sender SA
+    bool active;
+    uint32_t lastMs;            // Receive time of the previous packet
+    uint8_t data[J1939_TP_MAX_PAYLOAD];
+};
+
+struct J1939TpReceiver {
+    J1939TpSession sessions[J1939_TP_SESSIONS];
+    uint32_t completed;         // Messages reassembled
+    uint32_t dropped;           // Too long, no free session, sequence gap or timeout
+};
+
+enum J1939TpStatus : uint8_t {
+    J1939_TP_IGNORED,           // Not a BAM packet we follow
+    J1939_TP_IN_PROGRESS,       // Announcement or packet accepted, more to come
+    J1939_TP_COMPLETE,          // *complete holds the message
+    J1939_TP_ERROR              // Message dropped
+};
+
+void j1939TpReset(J1939TpReceiver* rx);
+
+/**
+ * Feed a TP.CM or TP.DT frame to the reassembler
+ * @param id        Parsed identifier (PGN J1939_PGN_TP_CM / J1939_PGN_TP_DT)
+ * @param complete  Set to the finished session on J1939_TP_COMPLETE (valid
+ *                  until the next call)
+ */
+J1939TpStatus j1939TpReceive(J1939TpReceiver* rx, const J1939Id& id, const uint8_t* data, uint8_t len,
+                             uint32_t rxMs, const J1939TpSession** complete);
+
+// ===== SPN ENCODING =====
+
+struct J1939Spn {
+    uint16_t spn;
+    uint16_t pgn;               // Broadcast PGN (PDU2)
+    uint8_t obd2pid;            // Input matched by its OBD-II PID
+    uint8_t start;              // First byte in the PGN's 8 bytes
+    uint8_t width;              // 1 or 2 bytes, little-endian
+    uint8_t priority;
+    float resolution;           // Standard units per bit
+    float offset;               // Standard units
+};
+
+#define J1939_NO_SPN 0xFF
+#define J1939_TX_PGN_COUNT 7    // Distinct PGNs in the SPN table
+
+/**
+ * SPN table entry for an OBD-II PID
+ * @return  Index for j1939GetSpn(), or J1939_NO_SPN
+ */
+uint8_t j1939FindSpn(uint8_t obd2pid);
+
+// Copy of a table entry (the table lives in PROGMEM)
+J1939Spn j1939GetSpn(uint8_t index);
+
+/**
+ * Encode a value in standard units as the SPN's raw bytes
+ * NAN and out-of-range values are sent as "not available" / clamped to the
+ * valid range (0xFA / 0xFAFF).
+ */
+void j1939EncodeSpn(const J1939Spn& spn, float value, uint8_t* data);
+
+#endif // J1939_H
@@ -0,0 +1,40 @@
+/*
+ * json_arena.h - ArduinoJson allocator over the scratch arena
+ *
+ * JsonDocument doc(jsonArena()) keeps the document's pools and strings in
+ * the arena of lib/static_pool.h instead of the heap. A document that does
+ * not fit reports ArduinoJson's NoMemory (deserialize) or overflowed()
+ * (build), as it would on a full heap.
+ *
+ * With STATIC_SCRATCH_BYTES=0 documents use the heap as before.
+ */
+
+#ifndef JSON_ARENA_H
+#define JSON_ARENA_H
+
+#include <ArduinoJson.h>
+#include "static_pool.h"
+
+#if STATIC_SCRATCH_BYTES > 0
+
+class JsonArenaAllocator : public ArduinoJson::Allocator {
+public:
+    void* allocate(size_t size) override { return scratchAlloc(size); }
+    void deallocate(void* pointer) override { scratchFree(pointer); }
+    void* reallocate(void* pointer, size_t newSize) override { return scratchRealloc(pointer, newSize); }
+};
+
+inline ArduinoJson::Allocator* jsonArena() {
+    static JsonArenaAllocator allocator;
+    return &allocator;
+}
+
+#else
+
+inline ArduinoJson::Allocator* jsonArena() {
+    return ArduinoJson::detail::DefaultAllocator::instance();
+}
+
+#endif
+
+#endif // JSON_ARENA_H
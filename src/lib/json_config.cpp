@@ -11,11 +11,15 @@
 #ifndef USE_STATIC_CONFIG
 
 #include "json_config.h"
+#include "json_arena.h"
+#include "config_blob.h"
 #include "system_config.h"
 #include "bus_defaults.h"
 #include "serial_manager.h"
 #include "../inputs/input.h"
 #include "../inputs/input_manager.h"
+#include "../inputs/input_health.h"
+#include "../inputs/input_summary.h"
 #include "units_registry.h"
 #include "sensor_library.h"
 #include "application_presets.h"
@@ -24,6 +28,7 @@
 #include "log_tags.h"
 #include "pin_registry.h"
 #include "watchdog.h"
+#include "response_stream.h"
 
 // Use Arduino SD library for consistency across platforms
 #include <SD.h>
@@ -81,6 +86,8 @@ static const char* getCalibrationType(const Input* input) {
         case CAL_LINEAR: return "LINEAR";
         case CAL_VOLTAGE_DIVIDER: return "VOLTAGE_DIVIDER";
         case CAL_RPM: return "RPM";
+        case CAL_MATH_CHANNEL: return "MATH_CHANNEL";
+        case CAL_NODE_CHANNEL: return "NODE_CHANNEL";
         default: return "UNKNOWN";
     }
 }
@@ -151,12 +158,40 @@ static void exportCalibration(JsonObject& calObj, const Input* input) {
             params["maxRPM"] = input->customCalibration.rpm.max_rpm;
             break;
 
+        case CAL_MATH_CHANNEL:
+            params["op"] = input->customCalibration.math.op;
+            params["sourceA"] = input->customCalibration.math.source_a;
+            params["sourceB"] = input->customCalibration.math.source_b;
+            params["integrate"] = input->customCalibration.math.integrate != 0;
+            params["constant"] = input->customCalibration.math.constant;
+            params["scale"] = input->customCalibration.math.scale;
+            params["offset"] = input->customCalibration.math.offset;
+            break;
+
+        case CAL_NODE_CHANNEL:
+            params["node"] = input->customCalibration.node.node;
+            params["remotePin"] = input->customCalibration.node.remote_pin;
+            params["appHash"] = input->customCalibration.node.app_hash;
+            break;
+
         default:
             break;
     }
 }
 
 // Export single input to JSON
+// One running statistics window (input_summary.h)
+static void exportSummaryWindow(JsonObject obj, const InputSummaryWindow* w) {
+    obj["count"] = w->count;
+    if (w->count == 0) return;
+    obj["min"] = w->min;
+    obj["minMs"] = w->minMs;
+    obj["max"] = w->max;
+    obj["maxMs"] = w->maxMs;
+    obj["mean"] = w->mean;
+    obj["stddev"] = getSummaryStdDev(w);
+}
+
 void exportInputToJSON(JsonObject& inputObj, const Input* input) {
     if (!input || !input->flags.isEnabled) {
         return;
@@ -165,7 +200,8 @@ void exportInputToJSON(JsonObject& inputObj, const Input* input) {
     // Basic info
     inputObj["pin"] = input->pin;
     inputObj["abbr"] = input->abbrName;
-    inputObj["name"] = input->displayName;
+    char name[INPUT_DISPLAY_NAME_LEN];
+    inputObj["name"] = getInputDisplayName(input, name);   // Copied into the document
 
     // Application, sensor, units (use registry names)
     inputObj["app"] = reinterpret_cast<const char*>(getApplicationNameByIndex(input->applicationIndex));
@@ -196,11 +232,32 @@ void exportInputToJSON(JsonObject& inputObj, const Input* input) {
         JsonObject cal = inputObj["calibration"].to<JsonObject>();
         exportCalibration(cal, input);
     }
+
+    // Read health (runtime state - ignored on import)
+    const InputHealth* h = getInputHealth(input);
+    if (h) {
+        JsonObject health = inputObj["health"].to<JsonObject>();
+        health["consecutiveFails"] = h->consecutiveFails;
+        health["totalFails"] = h->totalFails;
+        health["lastFault"] = getInputFaultName(h->lastReason);
+        health["lastGoodMs"] = h->lastGoodMs;
+        health["latencyUs"] = h->latencyUs;
+        health["maxLatencyUs"] = h->maxLatencyUs;
+    }
+
+    // Running statistics, standard units (runtime state - ignored on import)
+    const InputSummary* s = getInputSummary(input);
+    if (s) {
+        JsonObject summary = inputObj["summary"].to<JsonObject>();
+        exportSummaryWindow(summary["boot"].to<JsonObject>(), &s->boot);
+        exportSummaryWindow(summary["session"].to<JsonObject>(), &s->session);
+        summary["sessionStartMs"] = s->sessionStartMs;
+    }
 }
 
 // Export all inputs to JSON array
 void exportInputsToJSON(JsonArray& inputsArray) {
-    for (uint8_t i = 0; i < numActiveInputs; i++) {
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
         Input* input = &inputs[i];
         if (input->flags.isEnabled) {
             JsonObject inputObj = inputsArray.add<JsonObject>();
@@ -231,11 +288,23 @@ void exportSystemConfigToJSON(JsonObject& systemObj) {
     // Output modules
     JsonObject outputs = systemObj["outputs"].to<JsonObject>();
 
-    const char* outputNames[] = {"can", "realdash", "serial", "sd", "alarm", "relay"};
+    const char* outputNames[] = {"can", "realdash", "serial", "sd", "mqtt", "alarm", "relay"};
     for (uint8_t i = 0; i < NUM_OUTPUTS; i++) {
         JsonObject output = outputs[outputNames[i]].to<JsonObject>();
         output["enabled"] = (bool)systemConfig.outputEnabled[i];
         output["interval"] = systemConfig.outputInterval[i];
+        if (i < NUM_DATA_OUTPUTS) {
+            output["mode"] = systemConfig.outputMode[i];
+            output["deadband"] = systemConfig.outputDeadband[i] / 100.0f;
+            output["aggregate"] = systemConfig.outputAggregate[i];
+        }
+        if (i == OUTPUT_SERIAL) {
+            output["format"] = systemConfig.serialFormat;
+        }
+        if (i == OUTPUT_MQTT) {
+            output["format"] = systemConfig.mqttFormat;
+            output["qos"] = systemConfig.mqttQos;
+        }
     }
 
     // Display settings
@@ -255,6 +324,8 @@ void exportSystemConfigToJSON(JsonObject& systemObj) {
     display["address"] = addrBuf;
 
     display["updateInterval"] = systemConfig.lcdUpdateInterval;
+    display["pageSeconds"] = systemConfig.lcdPageSeconds;
+    display["pinAlarms"] = (bool)systemConfig.lcdPinAlarms;
 
     JsonObject defaultUnits = display["defaultUnits"].to<JsonObject>();
     defaultUnits["temperature"] = reinterpret_cast<const char*>(getUnitStringByIndex(systemConfig.defaultTempUnits));
@@ -288,6 +359,17 @@ void exportSystemConfigToJSON(JsonObject& systemObj) {
     buses["canOutputEnabled"] = systemConfig.buses.can_output_enabled;
     buses["canInputBaudrate"] = systemConfig.buses.can_input_baudrate;
     buses["canOutputBaudrate"] = systemConfig.buses.can_output_baudrate;
+    buses["canOutputLayout"] = systemConfig.buses.can_output_layout;
+    buses["canOutputBaseId"] = systemConfig.buses.can_output_base_id;
+    buses["canMirrorBus"] = systemConfig.buses.can_mirror_bus;
+    buses["canMirrorLayout"] = systemConfig.buses.can_mirror_layout;
+    buses["canMirrorBaseId"] = systemConfig.buses.can_mirror_base_id;
+    buses["canMirrorInterval"] = systemConfig.buses.can_mirror_interval;
+    buses["canMirrorBaudrate"] = systemConfig.buses.can_mirror_baudrate;
+    buses["canInputProtocol"] = systemConfig.buses.can_input_protocol;
+    buses["j1939Address"] = systemConfig.buses.j1939_address;
+    buses["canNodeId"] = systemConfig.buses.can_node_id;
+    buses["canNodeSubscribe"] = systemConfig.buses.can_node_subscribe;
 
     // Serial Port Configuration
     JsonObject serial = systemObj["serial"].to<JsonObject>();
@@ -299,6 +381,10 @@ void exportSystemConfigToJSON(JsonObject& systemObj) {
         port["port"] = port_id;
         port["enabled"] = (bool)(systemConfig.serial.enabled_mask & (1 << i));
         port["baudrate"] = getBaudRateFromIndex(systemConfig.serial.baudrate_index[i]);
+        if (systemConfig.serial.flow_port == port_id) {
+            port["rtsPin"] = systemConfig.serial.rts_pin;
+            port["ctsPin"] = systemConfig.serial.cts_pin;
+        }
     }
 
     // Log Filter Configuration
@@ -313,23 +399,27 @@ void exportSystemConfigToJSON(JsonObject& systemObj) {
     logFilter["enabledTags"] = tagsBuf;
 }
 
-// JSON Schema Version
-// Increment when making backward-incompatible changes to JSON structure
-// Version history:
-//   1 - Initial release (v0.4.1-alpha)
-#define JSON_SCHEMA_VERSION 1
+// Print adapter that indents every line after the first, so a section
+// serialized on its own nests inside the pretty-printed envelope
+class IndentPrint : public Print {
+public:
+    IndentPrint(Print& out, uint8_t indent) : out(out), indent(indent) {}
 
-// Main export function - dump entire config to JSON
-void dumpConfigToJSON(Print& output) {
-    // Allocate JSON document (ArduinoJson v7 handles sizing automatically)
-    JsonDocument doc;
+    size_t write(uint8_t c) override {
+        out.write(c);
+        if (c == '\n') {
+            for (uint8_t i = 0; i < indent; i++) out.write(' ');
+        }
+        return 1;
+    }
 
-    // Schema version (for future migration support)
-    doc["schemaVersion"] = JSON_SCHEMA_VERSION;
-    doc["mode"] = "runtime";
+private:
+    Print& out;
+    uint8_t indent;
+};
 
-    // Firmware info
-    JsonObject firmware = doc["firmware"].to<JsonObject>();
+// Export firmware identification (the "firmware" section)
+void exportFirmwareToJSON(JsonObject& firmware) {
     firmware["version"] = firmwareVersionString();
     firmware["major"] = FW_MAJOR;
     firmware["minor"] = FW_MINOR;
@@ -341,18 +431,99 @@ void dumpConfigToJSON(Print& output) {
     firmware["timestamp"] = getCurrentTimestamp();
     firmware["maxInputs"] = MAX_INPUTS;
     firmware["activeInputs"] = numActiveInputs;
+}
 
-    // System configuration
-    JsonObject system = doc["system"].to<JsonObject>();
-    exportSystemConfigToJSON(system);
+// Print adapter onto the control plane (msg.control is not a Print)
+class ControlPrint : public Print {
+public:
+    size_t write(uint8_t c) override {
+        return msg.control.write(c);
+    }
 
-    // Inputs
-    JsonArray inputsArray = doc["inputs"].to<JsonArray>();
-    exportInputsToJSON(inputsArray);
+    size_t write(const uint8_t* buffer, size_t size) override {
+        return msg.control.write(buffer, size);
+    }
+};
+
+// One piece of the export: the envelope and firmware, the system section,
+// one input, then the close. arg notes that an input was written.
+// Each section (and each input) comes from its own small document, so peak
+// RAM is one input rather than the whole configuration.
+static bool dumpConfigStep(Print& output, ResponseCursor& cursor) {
+    IndentPrint section(output, 2);
+    IndentPrint element(output, 4);
+
+    switch (cursor.section) {
+        case 0: {
+            // Schema version (for future migration support)
+            output.print(F("{\n  \"schemaVersion\": "));
+            output.print(JSON_SCHEMA_VERSION);
+            output.print(F(",\n  \"mode\": \"runtime\",\n  \"firmware\": "));
+
+            JsonDocument doc(jsonArena());
+            JsonObject firmware = doc.to<JsonObject>();
+            exportFirmwareToJSON(firmware);
+            serializeJsonPretty(doc, section);
+            cursor.section = 1;
+            return true;
+        }
+
+        case 1: {
+            output.print(F(",\n  \"system\": "));
+            JsonDocument doc(jsonArena());
+            JsonObject system = doc.to<JsonObject>();
+            exportSystemConfigToJSON(system);
+            serializeJsonPretty(doc, section);
+            output.print(F(",\n  \"inputs\": ["));
+            cursor.section = 2;
+            return true;
+        }
+
+        case 2:
+            // Inputs - one document per input, released before the next
+            while (cursor.index < MAX_INPUTS) {
+                uint8_t i = cursor.index++;
+                const Input* input = &inputs[i];
+                if (!input->flags.isEnabled) {
+                    continue;
+                }
+                JsonDocument doc(jsonArena());
+                JsonObject inputObj = doc.to<JsonObject>();
+                inputObj["idx"] = i;
+                exportInputToJSON(inputObj, input);
+                output.print(cursor.arg ? F(",\n    ") : F("\n    "));
+                serializeJsonPretty(doc, element);
+                cursor.arg = 1;
+                return true;
+            }
+            cursor.section = 3;
+            return true;
+
+        default:
+            output.println(cursor.arg ? F("\n  ]\n}") : F("]\n}"));
+            return false;
+    }
+}
+
+// Main export function - dump entire config to JSON
+void dumpConfigToJSON(Print& output) {
+    ResponseCursor cursor = { 0, 0, 0 };
+    while (dumpConfigStep(output, cursor)) {
+    }
+}
+
+// SYSTEM DUMP JSON: the export to the control plane, a piece per step,
+// between blank lines
+static bool dumpConfigResponseStep(ResponseCursor& cursor) {
+    ControlPrint output;
+    if (cursor.section == 0) msg.control.println();
+    if (dumpConfigStep(output, cursor)) return true;
+    msg.control.println();
+    return false;
+}
 
-    // Serialize to output
-    serializeJsonPretty(doc, output);
-    output.println();
+void startConfigDumpJSON() {
+    startResponse(dumpConfigResponseStep);
 }
 
 // Import calibration from JSON
@@ -385,7 +556,7 @@ bool importInputFromJSON(JsonObject& inputObj, uint8_t index) {
     }
 
     // Extract values
-    uint8_t pin = inputObj["pin"];
+    InputPin pin = inputObj["pin"];
 
     // Support both "app" (runtime) and "application" (static/legacy) field names
     const char* appName = inputObj["app"];
@@ -452,16 +623,16 @@ bool importInputFromJSON(JsonObject& inputObj, uint8_t index) {
 
     // Use input manager functions to properly configure the input
     // This ensures all function pointers and calibration are wired correctly
-    extern bool setInputApplication(uint8_t pin, uint8_t appIndex);
-    extern bool setInputSensor(uint8_t pin, uint8_t sensorIndex);
-    extern bool setInputUnits(uint8_t pin, uint8_t unitsIndex);
-    extern bool setInputName(uint8_t pin, const char* name);
-    extern bool setInputDisplayName(uint8_t pin, const char* displayName);
-    extern bool setInputAlarmRange(uint8_t pin, float minValue, float maxValue);
-    extern bool enableInput(uint8_t pin, bool enable);
-    extern bool enableInputAlarm(uint8_t pin, bool enable);
-    extern bool enableInputDisplay(uint8_t pin, bool enable);
-    extern bool setInputOBD(uint8_t pin, uint8_t pid, uint8_t length);
+    extern bool setInputApplication(InputPin pin, uint8_t appIndex);
+    extern bool setInputSensor(InputPin pin, uint8_t sensorIndex);
+    extern bool setInputUnits(InputPin pin, uint8_t unitsIndex);
+    extern bool setInputName(InputPin pin, const char* name);
+    extern bool setInputDisplayName(InputPin pin, const char* displayName);
+    extern bool setInputAlarmRange(InputPin pin, float minValue, float maxValue);
+    extern bool enableInput(InputPin pin, bool enable);
+    extern bool enableInputAlarm(InputPin pin, bool enable);
+    extern bool enableInputDisplay(InputPin pin, bool enable);
+    extern bool setInputOBD(InputPin pin, uint8_t pid, uint8_t length);
 
     // Get pointer to input struct and set pin
     Input* input = &inputs[index];
@@ -536,13 +707,32 @@ bool importSystemConfigFromJSON(JsonObject& systemObj) {
     // Output modules
     if (systemObj["outputs"].isNull() == false) {
         JsonObject outputs = systemObj["outputs"];
-        const char* outputNames[] = {"can", "realdash", "serial", "sd", "alarm", "relay"};
+        const char* outputNames[] = {"can", "realdash", "serial", "sd", "mqtt", "alarm", "relay"};
 
         for (uint8_t i = 0; i < NUM_OUTPUTS; i++) {
             if (outputs[outputNames[i]].isNull() == false) {
                 JsonObject output = outputs[outputNames[i]];
                 systemConfig.outputEnabled[i] = output["enabled"];
                 systemConfig.outputInterval[i] = output["interval"];
+                if (i < NUM_DATA_OUTPUTS) {
+                    uint8_t mode = output["mode"] | (uint8_t)OUTPUT_MODE_PERIODIC;
+                    systemConfig.outputMode[i] = (mode <= OUTPUT_MODE_HEARTBEAT) ? mode : OUTPUT_MODE_PERIODIC;
+                    float deadband = output["deadband"] | 0.0f;
+                    systemConfig.outputDeadband[i] = (deadband > 0.0f && deadband <= 655.35f) ?
+                                                     (uint16_t)(deadband * 100.0f + 0.5f) : 0;
+                    uint8_t aggregate = output["aggregate"] | (uint8_t)OUTPUT_AGG_LAST;
+                    systemConfig.outputAggregate[i] = (aggregate <= OUTPUT_AGG_MAX) ? aggregate : OUTPUT_AGG_LAST;
+                }
+                if (i == OUTPUT_SERIAL) {
+                    uint8_t format = output["format"] | (uint8_t)SERIAL_FORMAT_CSV;
+                    systemConfig.serialFormat = (format <= SERIAL_FORMAT_WIDE) ? format : SERIAL_FORMAT_CSV;
+                }
+                if (i == OUTPUT_MQTT) {
+                    uint8_t format = output["format"] | (uint8_t)MQTT_FORMAT_JSON;
+                    systemConfig.mqttFormat = (format <= MQTT_FORMAT_BINARY) ? format : MQTT_FORMAT_JSON;
+                    uint8_t qos = output["qos"] | (uint8_t)0;
+                    systemConfig.mqttQos = (qos <= 1) ? qos : 0;
+                }
             }
         }
     }
@@ -576,6 +766,14 @@ bool importSystemConfigFromJSON(JsonObject& systemObj) {
             systemConfig.lcdUpdateInterval = display["updateInterval"];
         }
 
+        // LCD pages
+        if (display["pageSeconds"].isNull() == false) {
+            systemConfig.lcdPageSeconds = display["pageSeconds"];
+        }
+        if (display["pinAlarms"].isNull() == false) {
+            systemConfig.lcdPinAlarms = display["pinAlarms"];
+        }
+
         // Default units
         if (display["defaultUnits"].isNull() == false) {
             JsonObject units = display["defaultUnits"];
@@ -672,6 +870,32 @@ bool importSystemConfigFromJSON(JsonObject& systemObj) {
             systemConfig.buses.can_input_baudrate = buses["canInputBaudrate"] | DEFAULT_CAN_BAUDRATE;
             systemConfig.buses.can_output_baudrate = buses["canOutputBaudrate"] | DEFAULT_CAN_BAUDRATE;
         }
+
+        uint8_t layout = buses["canOutputLayout"] | CAN_OUTPUT_OBD;
+        systemConfig.buses.can_output_layout = (layout <= CAN_OUTPUT_NMEA2000) ? layout : CAN_OUTPUT_OBD;
+        uint16_t baseId = buses["canOutputBaseId"] | DEFAULT_CAN_OUTPUT_BASE_ID;
+        systemConfig.buses.can_output_base_id = (baseId <= 0x7FF) ? baseId : DEFAULT_CAN_OUTPUT_BASE_ID;
+
+        // CAN mirror output (absent before v11 - stays off)
+        systemConfig.buses.can_mirror_bus = buses["canMirrorBus"] | 0xFF;
+        layout = buses["canMirrorLayout"] | CAN_OUTPUT_PACKED;
+        systemConfig.buses.can_mirror_layout = (layout <= CAN_OUTPUT_NMEA2000) ? layout : CAN_OUTPUT_PACKED;
+        baseId = buses["canMirrorBaseId"] | DEFAULT_CAN_MIRROR_BASE_ID;
+        systemConfig.buses.can_mirror_base_id = (baseId <= 0x7FF) ? baseId : DEFAULT_CAN_MIRROR_BASE_ID;
+        uint16_t interval = buses["canMirrorInterval"] | DEFAULT_CAN_MIRROR_INTERVAL;
+        systemConfig.buses.can_mirror_interval = (interval >= 10) ? interval : DEFAULT_CAN_MIRROR_INTERVAL;
+        systemConfig.buses.can_mirror_baudrate = buses["canMirrorBaudrate"] | DEFAULT_CAN_BAUDRATE;
+
+        // J1939 (absent before v12)
+        uint8_t protocol = buses["canInputProtocol"] | CAN_PROTOCOL_AUTO;
+        systemConfig.buses.can_input_protocol = (protocol <= CAN_PROTOCOL_J1939) ? protocol : CAN_PROTOCOL_AUTO;
+        uint8_t address = buses["j1939Address"] | DEFAULT_J1939_ADDRESS;
+        systemConfig.buses.j1939_address = (address <= 253) ? address : DEFAULT_J1939_ADDRESS;
+
+        // CAN node network (absent before v20 - not a node)
+        uint8_t node = buses["canNodeId"] | 0xFF;
+        systemConfig.buses.can_node_id = (node < 16) ? node : 0xFF;
+        systemConfig.buses.can_node_subscribe = buses["canNodeSubscribe"] | 0;
     } else {
         // No buses object - use defaults (backward compatibility with old configs)
         systemConfig.buses.active_i2c = DEFAULT_I2C_BUS;
@@ -684,15 +908,43 @@ bool importSystemConfigFromJSON(JsonObject& systemObj) {
         systemConfig.buses.can_output_enabled = 1;
         systemConfig.buses.can_input_baudrate = DEFAULT_CAN_BAUDRATE;
         systemConfig.buses.can_output_baudrate = DEFAULT_CAN_BAUDRATE;
+        systemConfig.buses.can_output_layout = CAN_OUTPUT_OBD;
+        systemConfig.buses.can_output_base_id = DEFAULT_CAN_OUTPUT_BASE_ID;
+        systemConfig.buses.can_mirror_bus = 0xFF;
+        systemConfig.buses.can_mirror_layout = CAN_OUTPUT_PACKED;
+        systemConfig.buses.can_mirror_base_id = DEFAULT_CAN_MIRROR_BASE_ID;
+        systemConfig.buses.can_mirror_interval = DEFAULT_CAN_MIRROR_INTERVAL;
+        systemConfig.buses.can_mirror_baudrate = DEFAULT_CAN_BAUDRATE;
+        systemConfig.buses.can_input_protocol = CAN_PROTOCOL_AUTO;
+        systemConfig.buses.j1939_address = DEFAULT_J1939_ADDRESS;
+        systemConfig.buses.can_node_id = 0xFF;
+        systemConfig.buses.can_node_subscribe = 0;
     }
 
     return true;
 }
 
+// Validate the schema version and mode of a config before importing it
+bool checkConfigHeader(uint8_t schemaVer, const char* mode) {
+    if (schemaVer != JSON_SCHEMA_VERSION) {
+        msg.control.print(F("ERROR: Only schemaVersion 1 is supported. Got: "));
+        msg.control.println(schemaVer);
+        return false;
+    }
+
+    // Validate mode field
+    if (strcmp(mode, "runtime") != 0) {
+        msg.control.print(F("ERROR: Only mode='runtime' configs can be imported. Got: "));
+        msg.control.println(mode);
+        return false;
+    }
+    return true;
+}
+
 // Load configuration from JSON string
 bool loadConfigFromJSON(const char* jsonString) {
     // Allocate JSON document (same size as export)
-    JsonDocument doc;
+    JsonDocument doc(jsonArena());
 
     // Parse JSON
     DeserializationError error = deserializeJson(doc, jsonString);
@@ -705,18 +957,7 @@ bool loadConfigFromJSON(const char* jsonString) {
 
     // Check schema version for migration support
     uint8_t schemaVer = doc["schemaVersion"] | 1;  // Default to v1 if missing (old configs)
-
-    if (schemaVer != JSON_SCHEMA_VERSION) {
-        msg.control.print(F("ERROR: Only schemaVersion 1 is supported. Got: "));
-        msg.control.println(schemaVer);
-        return false;
-    }
-
-    // Validate mode field
-    const char* mode = doc["mode"] | "runtime";
-    if (strcmp(mode, "runtime") != 0) {
-        msg.control.print(F("ERROR: Only mode='runtime' configs can be imported. Got: "));
-        msg.control.println(mode);
+    if (!checkConfigHeader(schemaVer, doc["mode"] | "runtime")) {
         return false;
     }
 
@@ -745,6 +986,209 @@ bool loadConfigFromJSON(const char* jsonString) {
     return true;
 }
 
+// Skip whitespace; the next character, not consumed (-1 at the end)
+static int peekToken(Stream& input) {
+    int c;
+    while ((c = input.peek()) == ' ' || c == '\n' || c == '\r' || c == '\t') {
+        input.read();
+    }
+    return c;
+}
+
+// Consume the next character if it is one of the given delimiters
+static int readDelimiter(Stream& input, const char* allowed) {
+    int c = peekToken(input);
+    if (c < 0 || strchr(allowed, c) == nullptr) {
+        return -1;
+    }
+    input.read();
+    return c;
+}
+
+// Read an object key and its ':' (keys longer than the buffer are truncated)
+static bool readKey(Stream& input, char* key, size_t size) {
+    if (readDelimiter(input, "\"") < 0) {
+        return false;
+    }
+    size_t n = 0;
+    int c;
+    while ((c = input.read()) != '"') {
+        if (c < 0) {
+            return false;
+        }
+        if (n + 1 < size) {
+            key[n++] = c;
+        }
+    }
+    key[n] = '\0';
+    return readDelimiter(input, ":") >= 0;
+}
+
+// Read a top-level scalar value as text, up to the ',' or '}' after it
+static bool readScalar(Stream& input, char* value, size_t size) {
+    size_t n = 0;
+    bool quoted = false;
+    int c;
+    while ((c = input.peek()) >= 0) {
+        if (!quoted && (c == ',' || c == '}')) {
+            break;
+        }
+        input.read();
+        if (c == '"') {
+            quoted = !quoted;
+        }
+        if (n + 1 < size) {
+            value[n++] = c;
+        }
+    }
+    value[n] = '\0';
+    return c >= 0;
+}
+
+static void printParseError(DeserializationError error) {
+    msg.control.print(F("ERROR: JSON parse failed: "));
+    msg.control.println(error.c_str());
+}
+
+// Import the inputs array one element at a time; only the fields
+// importInputFromJSON reads are kept (not the read-only health block)
+static bool importInputsFromStream(Stream& input) {
+    if (readDelimiter(input, "[") < 0) {
+        msg.control.println(F("ERROR: JSON parse failed: inputs is not an array"));
+        return false;
+    }
+
+    JsonDocument filter(jsonArena());
+    static const char* const keys[] = {
+        "idx", "pin", "abbr", "name", "app", "application", "sensor", "units",
+        "alarm", "enabled", "alarmEnabled", "displayEnabled", "obd2", "calibration"
+    };
+    for (const char* key : keys) {
+        filter[key] = true;
+    }
+
+    uint8_t importedCount = 0;
+    uint8_t totalInputs = 0;
+    if (readDelimiter(input, "]") < 0) {
+        do {
+            JsonDocument doc(jsonArena());
+            DeserializationError error = deserializeJson(doc, input, DeserializationOption::Filter(filter));
+            if (error) {
+                printParseError(error);
+                return false;
+            }
+            totalInputs++;
+
+            JsonObject inputObj = doc.as<JsonObject>();
+            uint8_t idx = inputObj["idx"];
+            if (importInputFromJSON(inputObj, idx)) {
+                importedCount++;
+                msg.debug.debug(TAG_JSON, "Successfully imported input %d", idx);
+            } else {
+                msg.debug.warn(TAG_JSON, "Failed to import input %d", idx);
+            }
+        } while (readDelimiter(input, ",") >= 0);
+
+        if (readDelimiter(input, "]") < 0) {
+            msg.control.println(F("ERROR: JSON parse failed: inputs array not closed"));
+            return false;
+        }
+    }
+
+    msg.debug.info(TAG_JSON, "Import complete: %d of %d inputs imported", importedCount, totalInputs);
+
+    numActiveInputs = importedCount;
+    return importedCount > 0;
+}
+
+// Load configuration from a stream (a config file) without holding it all:
+// the top-level object is walked key by key, each section parsed on its own,
+// so peak RAM is the system section or one input. schemaVersion and mode
+// must come before system and inputs, as dumpConfigToJSON() writes them.
+bool loadConfigFromStream(Stream& input) {
+    if (readDelimiter(input, "{") < 0) {
+        msg.control.println(F("ERROR: JSON parse failed: not a JSON object"));
+        return false;
+    }
+
+    uint8_t schemaVer = 1;  // Default to v1 if missing (old configs)
+    char mode[16] = "runtime";
+    bool headerChecked = false;
+
+    if (readDelimiter(input, "}") < 0) {
+        do {
+            char key[24];
+            if (!readKey(input, key, sizeof(key))) {
+                msg.control.println(F("ERROR: JSON parse failed: expected a key"));
+                return false;
+            }
+
+            bool isSystem = strcmp(key, "system") == 0;
+            bool isInputs = strcmp(key, "inputs") == 0;
+            if ((isSystem || isInputs) && !headerChecked) {
+                if (!checkConfigHeader(schemaVer, mode)) {
+                    return false;
+                }
+                headerChecked = true;
+            }
+
+            int c = peekToken(input);
+            if (isInputs) {
+                if (!importInputsFromStream(input)) {
+                    msg.control.println(F("ERROR: Failed to import inputs"));
+                    return false;
+                }
+            } else if (c == '{' || c == '[') {
+                // system is kept; other sections (firmware) are skipped unstored
+                JsonDocument none(jsonArena());
+                JsonDocument doc(jsonArena());
+                DeserializationError error = isSystem
+                    ? deserializeJson(doc, input)
+                    : deserializeJson(doc, input, DeserializationOption::Filter(none));
+                if (error) {
+                    printParseError(error);
+                    return false;
+                }
+                if (isSystem) {
+                    JsonObject system = doc.as<JsonObject>();
+                    if (!importSystemConfigFromJSON(system)) {
+                        msg.control.println(F("ERROR: Failed to import system config"));
+                        return false;
+                    }
+                }
+            } else {
+                char text[24];
+                JsonDocument doc(jsonArena());
+                if (!readScalar(input, text, sizeof(text)) || deserializeJson(doc, text)) {
+                    msg.control.print(F("ERROR: JSON parse failed: bad value for "));
+                    msg.control.println(key);
+                    return false;
+                }
+                if (strcmp(key, "schemaVersion") == 0) {
+                    schemaVer = doc.as<JsonVariantConst>() | 1;
+                } else if (strcmp(key, "mode") == 0) {
+                    strlcpy(mode, doc.as<JsonVariantConst>() | "", sizeof(mode));
+                }
+            }
+        } while (readDelimiter(input, ",") >= 0);
+
+        if (readDelimiter(input, "}") < 0) {
+            msg.control.println(F("ERROR: JSON parse failed: object not closed"));
+            return false;
+        }
+    }
+
+    if (!headerChecked && !checkConfigHeader(schemaVer, mode)) {
+        return false;
+    }
+
+    msg.control.print(F("Successfully loaded config (schema v"));
+    msg.control.print(schemaVer);
+    msg.control.println(F(")"));
+
+    return true;
+}
+
 // Save configuration to SD card
 bool saveConfigToSD(const char* filename) {
     msg.debug.info(TAG_SD, "Starting save operation");
@@ -808,12 +1252,18 @@ bool saveConfigToSD(const char* filename) {
     }
 
     msg.debug.debug(TAG_SD, "File opened successfully");
-    msg.debug.debug(TAG_SD, "Writing JSON...");
 
-    // Write JSON to file
-    dumpConfigToJSON(configFile);
+    // A .bin file gets the binary blob (config_blob.h), anything else JSON
+    size_t len = strlen(filepath);
+    if (len > 4 && strcasecmp(filepath + len - 4, ".bin") == 0) {
+        msg.debug.debug(TAG_SD, "Writing blob...");
+        dumpConfigToBlob(configFile);
+    } else {
+        msg.debug.debug(TAG_SD, "Writing JSON...");
+        dumpConfigToJSON(configFile);
+    }
 
-    msg.debug.debug(TAG_SD, "JSON write complete");
+    msg.debug.debug(TAG_SD, "Write complete");
     msg.debug.debug(TAG_SD, "Closing file...");
     configFile.close();
     msg.debug.debug(TAG_SD, "File closed");
@@ -872,29 +1322,18 @@ bool loadConfigFromSD(const char* filename) {
         return false;
     }
 
-    msg.debug.debug(TAG_SD, "File opened successfully");
-    msg.debug.debug(TAG_SD, "Reading file...");
+    msg.debug.debug(TAG_SD, "File opened successfully: %lu bytes", (unsigned long)configFile.size());
+    msg.debug.debug(TAG_SD, "Parsing JSON...");
 
-    // Read entire file into string
-    String jsonString;
-    size_t bytesRead = 0;
-    while (configFile.available()) {
-        jsonString += (char)configFile.read();
-        bytesRead++;
-    }
+    // Parse straight from the file, one section/input at a time (blob or JSON by its first byte)
+    bool success = (configFile.peek() == CONFIG_BLOB_MAGIC[0]) ? loadConfigFromBlob(configFile)
+                                                                : loadConfigFromStream(configFile);
 
-    msg.debug.debug(TAG_SD, "Read complete: %u bytes total", bytesRead);
+    msg.debug.debug(TAG_SD, "Parsing complete");
     msg.debug.debug(TAG_SD, "Closing file...");
     configFile.close();
     msg.debug.debug(TAG_SD, "File closed");
 
-    msg.debug.debug(TAG_SD, "Parsing JSON...");
-
-    // Load configuration
-    bool success = loadConfigFromJSON(jsonString.c_str());
-
-    msg.debug.debug(TAG_SD, "JSON parsing complete");
-
     // Re-enable watchdog after SD operations complete
     watchdogEnable(2000);
     msg.debug.debug(TAG_SD, "Watchdog re-enabled");
@@ -15,6 +15,18 @@
  * Current Schema Version: 1
  *   - Initial release (v0.4.1-alpha)
  *
+ * The same schema is also written as MessagePack records (config_blob.h) -
+ * CONFIG SAVE to a .bin file, SYSTEM DUMP BIN.
+ *
+ * MEMORY:
+ * dumpConfigToJSON() and loadConfigFromStream() (CONFIG SAVE/LOAD) never hold
+ * the whole configuration: each section, and each input, goes through its own
+ * small JsonDocument, so peak RAM is bounded by the system section or one
+ * input rather than by the number of inputs (the limit on the Mega). The
+ * documents live in the scratch arena (static_pool.h), not on the heap.
+ * SYSTEM DUMP JSON writes the same pieces one per loop pass, as the control
+ * transport's TX ring drains (startConfigDumpJSON()).
+ *
  * NOTE: JSON features are only available in EEPROM mode (runtime config).
  *       Static builds do not include JSON to save memory.
  */
@@ -28,21 +40,31 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 
+// JSON Schema Version
+// Increment when making backward-incompatible changes to JSON structure
+// Version history:
+//   1 - Initial release (v0.4.1-alpha)
+#define JSON_SCHEMA_VERSION 1
+
 // Forward declarations
 struct Input;
 struct SystemConfig;
 
 // JSON export functions
 void dumpConfigToJSON(Print& output);
+void startConfigDumpJSON();  // SYSTEM DUMP JSON - to the control plane as a response (response_stream.h)
 void exportSystemConfigToJSON(JsonObject& systemObj);
 void exportInputsToJSON(JsonArray& inputsArray);
 void exportInputToJSON(JsonObject& inputObj, const Input* input);
+void exportFirmwareToJSON(JsonObject& firmwareObj);
 
 // JSON import functions
 bool loadConfigFromJSON(const char* jsonString);
+bool loadConfigFromStream(Stream& input);  // Section by section - bounded RAM
 bool importSystemConfigFromJSON(JsonObject& systemObj);
 bool importInputsFromJSON(JsonArray& inputsArray);
 bool importInputFromJSON(JsonObject& inputObj, uint8_t index);
+bool checkConfigHeader(uint8_t schemaVer, const char* mode);  // schemaVersion and mode importable?
 
 // SD card backup/restore (always available, independent of ENABLE_SD_LOGGING)
 bool saveConfigToSD(const char* filename = nullptr);
@@ -0,0 +1,285 @@
+/*
+ * latency_trace.cpp - End-to-end latency tracer implementation
+ */
+
+#include "latency_trace.h"
+
+#ifdef ENABLE_TRACE
+
+#include "message_api.h"
+#include "dual_core.h"
+#include "static_pool.h"
+#include "system_config.h"  // For NUM_OUTPUTS, OUTPUT_CAN
+#include "../inputs/input_manager.h"
+#include "../outputs/output_base.h"
+#include "../outputs/output_can.h"
+
+enum TraceStage : uint8_t {
+    TRACE_STAGE_SAMPLE = 0,
+    TRACE_STAGE_ALARM,
+    TRACE_STAGE_QUEUED,
+    TRACE_STAGE_WIRE
+};
+
+#define TRACE_NO_OUTPUT 0x1F
+
+struct TraceEvent {
+    uint32_t us;          // micros() at the trace point
+    uint16_t tag;         // Reading of the input (nonzero)
+    uint8_t slot;         // Index into inputs[]
+    uint8_t point;        // Stage << 5 | output module (TRACE_NO_OUTPUT for sample/alarm)
+};
+
+static_assert(NUM_OUTPUTS < TRACE_NO_OUTPUT, "Output index must fit the event's 5 bits");
+
+bool traceActive = false;
+
+static TraceEvent ring[TRACE_BUFFER_SIZE];
+static uint16_t ringHead = 0;           // Next event written
+static uint16_t ringCount = 0;
+static uint32_t ringOverwritten = 0;
+static uint8_t traceFilter = 0xFF;      // Followed input, 0xFF = all
+static uint32_t traceStartMs = 0;
+static uint32_t traceStopMs = 0;
+
+// Per-reading state: the current reading of each input, and the last one
+// each stage has seen, so a reading counts once per stage
+static uint16_t sampleTag[MAX_INPUTS];
+static uint16_t alarmedTag[MAX_INPUTS];
+static uint16_t queuedTag[NUM_OUTPUTS][MAX_INPUTS];
+static uint16_t pendingTag[NUM_OUTPUTS][MAX_INPUTS];  // Queued, not yet on the wire
+static uint8_t pendingCount[NUM_OUTPUTS];
+
+static void record(uint8_t slot, uint8_t stage, uint8_t output, uint16_t tag) {
+    dualCoreLock();  // Acquisition and output passes may run on different cores
+    TraceEvent& e = ring[ringHead];
+    e.us = micros();
+    e.tag = tag;
+    e.slot = slot;
+    e.point = (stage << 5) | output;
+    ringHead = (ringHead + 1) % TRACE_BUFFER_SIZE;
+    if (ringCount < TRACE_BUFFER_SIZE) {
+        ringCount++;
+    } else {
+        ringOverwritten++;
+    }
+    dualCoreUnlock();
+}
+
+void traceSample(uint8_t slot) {
+    if (slot >= MAX_INPUTS || (traceFilter != 0xFF && slot != traceFilter)) return;
+    if (++sampleTag[slot] == 0) sampleTag[slot] = 1;  // 0 = no reading yet
+    record(slot, TRACE_STAGE_SAMPLE, TRACE_NO_OUTPUT, sampleTag[slot]);
+}
+
+void traceAlarm(uint8_t slot) {
+    if (slot >= MAX_INPUTS) return;
+    uint16_t tag = sampleTag[slot];
+    if (tag == 0 || alarmedTag[slot] == tag) return;
+    alarmedTag[slot] = tag;
+    record(slot, TRACE_STAGE_ALARM, TRACE_NO_OUTPUT, tag);
+}
+
+void traceEnqueue(uint8_t output, uint8_t slot) {
+    if (output >= NUM_OUTPUTS || slot >= MAX_INPUTS) return;
+    uint16_t tag = sampleTag[slot];
+    if (tag == 0 || queuedTag[output][slot] == tag) return;
+    queuedTag[output][slot] = tag;
+    if (pendingTag[output][slot] == 0) pendingCount[output]++;
+    pendingTag[output][slot] = tag;  // A newer reading replaces one not yet sent
+    record(slot, TRACE_STAGE_QUEUED, output, tag);
+}
+
+void traceWire(uint8_t output) {
+    if (output >= NUM_OUTPUTS || pendingCount[output] == 0) return;
+    for (uint8_t slot = 0; slot < MAX_INPUTS; slot++) {
+        if (pendingTag[output][slot] == 0) continue;
+        record(slot, TRACE_STAGE_WIRE, output, pendingTag[output][slot]);
+        pendingTag[output][slot] = 0;
+    }
+    pendingCount[output] = 0;
+}
+
+void traceCANWire(uint8_t bus) {
+    if (bus == getCANOutputBus()) traceWire(OUTPUT_CAN);
+}
+
+void traceStart(uint8_t slot) {
+    traceActive = false;
+    ringHead = 0;
+    ringCount = 0;
+    ringOverwritten = 0;
+    traceFilter = slot;
+    memset(sampleTag, 0, sizeof(sampleTag));
+    memset(alarmedTag, 0, sizeof(alarmedTag));
+    memset(queuedTag, 0, sizeof(queuedTag));
+    memset(pendingTag, 0, sizeof(pendingTag));
+    memset(pendingCount, 0, sizeof(pendingCount));
+    traceStartMs = millis();
+    traceActive = true;
+}
+
+void traceStop() {
+    if (!traceActive) return;
+    traceActive = false;
+    traceStopMs = millis();
+}
+
+// ===== REPORT =====
+
+// i-th oldest event in the ring
+static const TraceEvent& eventAt(uint16_t i) {
+    return ring[(ringHead + TRACE_BUFFER_SIZE - ringCount + i) % TRACE_BUFFER_SIZE];
+}
+
+static uint8_t stageOf(const TraceEvent& e) { return e.point >> 5; }
+static uint8_t outputOf(const TraceEvent& e) { return e.point & TRACE_NO_OUTPUT; }
+
+#define TRACE_UNMATCHED 0xFFFFFFFFUL
+
+// Latency of every event from its sample (TRACE_UNMATCHED for samples, and
+// for events whose sample was overwritten)
+static void pairWithSamples(uint32_t* latency) {
+    for (uint16_t i = 0; i < ringCount; i++) {
+        const TraceEvent& e = eventAt(i);
+        latency[i] = TRACE_UNMATCHED;
+        if (stageOf(e) == TRACE_STAGE_SAMPLE) continue;
+        for (uint16_t k = i; k-- > 0; ) {
+            const TraceEvent& s = eventAt(k);
+            if (s.slot == e.slot && s.tag == e.tag && stageOf(s) == TRACE_STAGE_SAMPLE) {
+                latency[i] = e.us - s.us;
+                break;
+            }
+        }
+    }
+}
+
+static void sortLatencies(uint32_t* v, uint16_t n) {
+    for (uint16_t i = 1; i < n; i++) {  // At most TRACE_BUFFER_SIZE values, at command time
+        uint32_t x = v[i];
+        uint16_t j = i;
+        for (; j > 0 && v[j - 1] > x; j--) v[j] = v[j - 1];
+        v[j] = x;
+    }
+}
+
+static void printPadded(const char* str, uint8_t width) {
+    msg.control.print(str);
+    for (uint8_t len = strlen(str); len < width; len++) msg.control.print(' ');
+}
+
+static void printColumn(uint32_t value) {
+    char buf[12];
+    snprintf(buf, sizeof(buf), "%9lu", (unsigned long)value);
+    msg.control.print(buf);
+}
+
+static void printStageName(uint8_t stage, uint8_t output) {
+    if (stage == TRACE_STAGE_ALARM) {
+        printPadded("alarm", 16);
+        return;
+    }
+    OutputModule* module = getOutputByIndex(output);
+    char name[17];
+    snprintf(name, sizeof(name), "%s %s", module ? module->name : "?",
+             stage == TRACE_STAGE_QUEUED ? "queued" : "wire");
+    printPadded(name, 16);
+}
+
+// One row: the latencies of one input at one stage (and output)
+static bool printRow(const uint32_t* latency, uint32_t* values, uint8_t slot, uint8_t stage, uint8_t output) {
+    uint16_t n = 0;
+    for (uint16_t i = 0; i < ringCount; i++) {
+        const TraceEvent& e = eventAt(i);
+        if (latency[i] == TRACE_UNMATCHED || e.slot != slot ||
+            stageOf(e) != stage || outputOf(e) != output) continue;
+        values[n++] = latency[i];
+    }
+    if (n == 0) return false;
+    sortLatencies(values, n);
+
+    printPadded(inputs[slot].abbrName[0] != '\0' ? inputs[slot].abbrName : "?", 9);
+    printStageName(stage, output);
+    printColumn(n);
+    printColumn(values[0]);
+    printColumn(values[(n - 1) / 2]);
+    printColumn(values[(n * 95UL + 99) / 100 - 1]);  // Nearest rank
+    printColumn(values[n - 1]);
+    msg.control.println();
+    return true;
+}
+
+void printTraceReport() {
+    msg.control.println();
+    msg.control.print(F("=== Trace: "));
+    msg.control.print(traceActive ? F("running") : F("stopped"));
+    msg.control.print(F(", "));
+    msg.control.print(ringCount);
+    msg.control.print(F(" events in "));
+    msg.control.print((traceActive ? millis() : traceStopMs) - traceStartMs);
+    msg.control.print(F(" ms (ring "));
+    msg.control.print(TRACE_BUFFER_SIZE);
+    msg.control.print(F(", "));
+    msg.control.print(ringOverwritten);
+    msg.control.println(F(" overwritten) ==="));
+    if (traceFilter != 0xFF) {
+        msg.control.print(F("Following "));
+        msg.control.println(inputs[traceFilter].abbrName);
+    }
+
+    uint32_t* latency = (uint32_t*)scratchAlloc(TRACE_BUFFER_SIZE * sizeof(uint32_t));
+    uint32_t* values = (uint32_t*)scratchAlloc(TRACE_BUFFER_SIZE * sizeof(uint32_t));
+    if (latency == nullptr || values == nullptr) {
+        msg.control.println(F("ERROR: No scratch space for the report"));
+        scratchFree(values);
+        scratchFree(latency);
+        return;
+    }
+
+    bool wasActive = traceActive;
+    traceActive = false;  // Hold the ring still while it is read
+    pairWithSamples(latency);
+
+    msg.control.println(F("Latency from sample (us):"));
+    msg.control.println(F("Input    Stage                   n      min      p50      p95      max"));
+    bool any = false;
+    for (uint8_t slot = 0; slot < MAX_INPUTS; slot++) {
+        any |= printRow(latency, values, slot, TRACE_STAGE_ALARM, TRACE_NO_OUTPUT);
+        for (uint8_t output = 0; output < NUM_OUTPUTS; output++) {
+            any |= printRow(latency, values, slot, TRACE_STAGE_QUEUED, output);
+            any |= printRow(latency, values, slot, TRACE_STAGE_WIRE, output);
+        }
+    }
+    if (!any) {
+        msg.control.println(wasActive || ringCount ? F("No complete traces yet (RUN mode, enabled inputs and outputs)")
+                                                   : F("Not tracing - TRACE START [<pin>]"));
+    }
+    traceActive = wasActive;
+
+    scratchFree(values);
+    scratchFree(latency);
+    msg.control.println();
+}
+
+void printTraceDump() {
+    bool wasActive = traceActive;
+    traceActive = false;
+    msg.control.println(F("us,input,stage,output,reading"));
+    for (uint16_t i = 0; i < ringCount; i++) {
+        const TraceEvent& e = eventAt(i);
+        static const char* const STAGE_NAMES[] = {"sample", "alarm", "queued", "wire"};
+        OutputModule* module = outputOf(e) == TRACE_NO_OUTPUT ? nullptr : getOutputByIndex(outputOf(e));
+        msg.control.print(e.us);
+        msg.control.print(',');
+        msg.control.print(inputs[e.slot].abbrName);
+        msg.control.print(',');
+        msg.control.print(STAGE_NAMES[stageOf(e)]);
+        msg.control.print(',');
+        msg.control.print(module ? module->name : "");
+        msg.control.print(',');
+        msg.control.println(e.tag);
+    }
+    traceActive = wasActive;
+}
+
+#endif // ENABLE_TRACE
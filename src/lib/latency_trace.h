@@ -0,0 +1,93 @@
+/*
+ * latency_trace.h - End-to-end latency tracer, sensor sample to wire
+ *
+ * Opt-in instrumentation (-D ENABLE_TRACE) of how long a reading takes to
+ * get anywhere - a pressure drop to the buzzer, a value to the CAN bus.
+ * The profiler measures how long each task runs; this measures the time
+ * between the tasks, which the scheduler, intervals and queues add up.
+ *
+ * Each reading is stamped at four points, in a ring of TRACE_BUFFER_SIZE
+ * events:
+ *
+ *   sample   the input's readFunction returned (tags the reading)
+ *   alarm    the first alarm evaluation of that reading
+ *   queued   the first output batch carrying it, per output module
+ *   wire     the module handed it on: CSV/RealDash/SD bytes written to the
+ *            transport, the CAN broadcast queue of the CAN output's bus
+ *            drained into the controller, the alarm/relay batch acted on
+ *
+ * A reading is traced once per stage - a periodic output resending the same
+ * value doesn't count again - so the figures are reaction times. The TRACE
+ * command pairs every event with its sample and prints min/p50/p95/max per
+ * input and stage; events whose sample has already left the ring are left
+ * out. Tracing is off until TRACE START, and TRACE START <pin> follows one
+ * input only, so the ring covers a longer stretch of it.
+ *
+ * Usage:
+ *   TRACE_SAMPLE(slot);              // After the read
+ *   TRACE_ALARM(slot);               // After its alarm evaluation
+ *   TRACE_ENQUEUE(output, slot);     // Into a module's batch
+ *   TRACE_WIRE(output);              // Module's batch handed on
+ *   TRACE_CAN_WIRE(bus);             // CAN broadcast queue of a bus drained
+ *
+ * Without ENABLE_TRACE all macros compile to nothing; with it and tracing
+ * stopped, each is one flag test.
+ *
+ * Build Flags:
+ *   -D ENABLE_TRACE              - Compile the tracer and the TRACE command
+ *   -D TRACE_BUFFER_SIZE=n       - Events in the ring (default 512; 64 on AVR)
+ */
+
+#ifndef LATENCY_TRACE_H
+#define LATENCY_TRACE_H
+
+#include <Arduino.h>
+
+#ifndef TRACE_BUFFER_SIZE
+  #if defined(__AVR__)
+    #define TRACE_BUFFER_SIZE 64
+  #else
+    #define TRACE_BUFFER_SIZE 512
+  #endif
+#endif
+
+#ifdef ENABLE_TRACE
+
+extern bool traceActive;
+
+void traceSample(uint8_t slot);
+void traceAlarm(uint8_t slot);
+void traceEnqueue(uint8_t output, uint8_t slot);
+void traceWire(uint8_t output);
+void traceCANWire(uint8_t bus);
+
+/**
+ * Clear the ring and start tracing
+ * @param slot  Only this input (index into inputs[]), 0xFF = all
+ */
+void traceStart(uint8_t slot);
+void traceStop();
+
+// Latency table per input and stage (TRACE)
+void printTraceReport();
+
+// Raw events, oldest first, as CSV (TRACE DUMP)
+void printTraceDump();
+
+#define TRACE_SAMPLE(slot)            do { if (traceActive) traceSample(slot); } while (0)
+#define TRACE_ALARM(slot)             do { if (traceActive) traceAlarm(slot); } while (0)
+#define TRACE_ENQUEUE(output, slot)   do { if (traceActive) traceEnqueue((output), (slot)); } while (0)
+#define TRACE_WIRE(output)            do { if (traceActive) traceWire(output); } while (0)
+#define TRACE_CAN_WIRE(bus)           do { if (traceActive) traceCANWire(bus); } while (0)
+
+#else
+
+#define TRACE_SAMPLE(slot)            ((void)0)
+#define TRACE_ALARM(slot)             ((void)0)
+#define TRACE_ENQUEUE(output, slot)   ((void)0)
+#define TRACE_WIRE(output)            ((void)0)
+#define TRACE_CAN_WIRE(bus)           ((void)0)
+
+#endif // ENABLE_TRACE
+
+#endif // LATENCY_TRACE_H
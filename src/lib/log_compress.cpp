@@ -0,0 +1,150 @@
+/*
+ * log_compress.cpp - Streaming compression for fixed-size log records
+ */
+
+#include "log_compress.h"
+
+void logCompressReset(LogCompressor* comp, const uint8_t* width, uint8_t channels) {
+    memset(comp->prev, 0, sizeof(comp->prev));
+    memset(comp->head, 0, sizeof(comp->head));
+    comp->historyLength = 0;
+    comp->recordSize = 4;
+    comp->channels = 0;
+    for (uint8_t c = 0; c < channels && c < LOG_COMPRESS_MAX_CHANNELS; c++) {
+        if (comp->recordSize + width[c] > LOG_COMPRESS_MAX_RECORD) break;
+        comp->width[c] = width[c];
+        comp->recordSize += width[c];
+        comp->channels++;
+    }
+    comp->rawBytes = 0;
+    comp->packedBytes = 0;
+}
+
+static inline uint16_t hash3(const uint8_t* p) {
+    uint32_t v = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+    uint32_t mixed = v * 2654435761UL;   // Knuth multiplicative hash
+    return (uint16_t)(mixed >> (32 - LOG_COMPRESS_HASH_BITS));
+}
+
+// Keep the newest window of history, freeing room behind it
+static void slideHistory(LogCompressor* comp) {
+    uint16_t drop = comp->historyLength - LOG_COMPRESS_WINDOW;
+    memmove(comp->history, comp->history + drop, LOG_COMPRESS_WINDOW);
+    comp->historyLength = LOG_COMPRESS_WINDOW;
+    for (uint16_t h = 0; h < (1 << LOG_COMPRESS_HASH_BITS); h++) {
+        comp->head[h] = comp->head[h] > drop ? comp->head[h] - drop : 0;
+    }
+}
+
+// Bytes at candidate matching those at pos, up to limit
+static uint16_t matchLength(const uint8_t* history, uint16_t candidate, uint16_t pos, uint16_t limit) {
+    uint16_t len = 0;
+    while (len < limit && history[candidate + len] == history[pos + len]) len++;
+    return len;
+}
+
+uint16_t logCompressRecord(LogCompressor* comp, const uint8_t* record, uint8_t* out) {
+    uint16_t n = comp->recordSize;
+    if (comp->historyLength + n > sizeof(comp->history)) {
+        slideHistory(comp);
+    }
+
+    // Delta stage, straight into the history
+    uint8_t* history = comp->history;
+    uint8_t* delta = &history[comp->historyLength];
+    uint32_t ms, prevMs;
+    memcpy(&ms, record, 4);
+    memcpy(&prevMs, comp->prev, 4);
+    uint32_t elapsed = ms - prevMs;
+    memcpy(delta, &elapsed, 4);
+
+    uint8_t* low = delta + 4;               // Low byte of every channel
+    uint8_t* high = low + comp->channels;   // Then the high bytes of the 16-bit ones
+    const uint8_t* value = record + 4;
+    const uint8_t* prev = comp->prev + 4;
+    for (uint8_t c = 0; c < comp->channels; c++) {
+        if (comp->width[c] == 1) {
+            uint8_t change = value[0] - prev[0];
+            *low++ = (uint8_t)(change << 1) ^ (uint8_t)((int8_t)change >> 7);
+            value++;
+            prev++;
+        } else {
+            uint16_t change = (value[0] | (value[1] << 8)) - (prev[0] | (prev[1] << 8));
+            uint16_t zigzag = (uint16_t)(change << 1) ^ (uint16_t)((int16_t)change >> 15);
+            *low++ = zigzag & 0xFF;
+            *high++ = zigzag >> 8;
+            value += 2;
+            prev += 2;
+        }
+    }
+    memcpy(comp->prev, record, n);
+
+    // LZ stage - payload goes after room for a 2-byte length
+    uint8_t* p = out + 2;
+    uint8_t* flags = nullptr;
+    uint8_t items = 8;
+    uint16_t pos = comp->historyLength;
+    uint16_t end = pos + n;
+
+    while (pos < end) {
+        if (items == 8) {
+            flags = p++;
+            *flags = 0;
+            items = 0;
+        }
+
+        uint16_t bestLength = 0;
+        uint16_t bestDistance = 0;
+        uint16_t limit = end - pos < LOG_COMPRESS_MAX_MATCH ? end - pos : LOG_COMPRESS_MAX_MATCH;
+        if (limit >= LOG_COMPRESS_MIN_MATCH) {
+            // Newest position with the same 3-byte hash, and the same byte of the previous record
+            uint16_t h = hash3(&history[pos]);
+            uint16_t candidates[2] = { comp->head[h], (uint16_t)(pos >= n ? pos - n + 1 : 0) };
+            comp->head[h] = pos + 1;
+
+            for (uint8_t c = 0; c < 2; c++) {
+                if (!candidates[c]) continue;
+                uint16_t candidate = candidates[c] - 1;
+                uint16_t distance = pos - candidate;
+                if (distance == 0 || distance > LOG_COMPRESS_WINDOW) continue;
+                uint16_t len = matchLength(history, candidate, pos, limit);
+                if (len > bestLength) {
+                    bestLength = len;
+                    bestDistance = distance;
+                }
+            }
+        }
+
+        if (bestLength >= LOG_COMPRESS_MIN_MATCH) {
+            uint16_t token = (bestDistance - 1) | ((bestLength - LOG_COMPRESS_MIN_MATCH) << 10);
+            *p++ = token & 0xFF;
+            *p++ = token >> 8;
+            *flags |= 1 << items;
+            // Index the positions the match covers so later matches can start there
+            for (uint16_t k = 1; k < bestLength && pos + k + LOG_COMPRESS_MIN_MATCH <= end; k++) {
+                comp->head[hash3(&history[pos + k])] = pos + k + 1;
+            }
+            pos += bestLength;
+        } else {
+            *p++ = history[pos++];
+        }
+        items++;
+    }
+    comp->historyLength = end;
+
+    uint16_t payload = p - (out + 2);
+    uint16_t total;
+    if (payload < 0x80) {
+        memmove(out + 1, out + 2, payload);
+        out[0] = payload;
+        total = payload + 1;
+    } else {
+        out[0] = (payload & 0x7F) | 0x80;
+        out[1] = payload >> 7;
+        total = payload + 2;
+    }
+
+    comp->rawBytes += n;
+    comp->packedBytes += total;
+    return total;
+}
@@ -0,0 +1,84 @@
+/*
+ * log_compress.h - Streaming compression for fixed-size log records
+ *
+ * Log records (timestamp + packed channel values) change little from one
+ * tick to the next. Each record is compressed as one block in two stages:
+ *
+ *   Delta  the timestamp becomes the time since the previous record and
+ *          each channel its change since then, zigzag coded (0, -1, 1, -2
+ *          .. as 0, 1, 2, 3 ..) in the channel's width; the low bytes of
+ *          all channels come first, then the high bytes of the 16-bit
+ *          ones - channels that did not move are zeros and small changes
+ *          leave a run of zero high bytes
+ *   LZ     LZSS over everything since the last reset, 1 KB window: groups of
+ *          a flag byte (bit n set = item n is a match, LSB first) and eight
+ *          items, a literal byte or a 16-bit little-endian match
+ *          (bits 0-9 distance - 1, bits 10-15 length - 3)
+ *
+ * A block is its compressed length (1 byte below 128, else 2: low 7 bits
+ * | 0x80, then the rest) followed by the groups; a block always ends its
+ * last group. A decoder keeps the previous record and the decoded delta
+ * bytes, so blocks must be decoded in order from the last reset - a log
+ * file, or a keyframe on a stream. A length of 0, or more than a record
+ * can compress to, marks the end (unwritten 0x00 / 0xFF space).
+ *
+ * Fixed state, no heap: about 3 KB per compressor - too much for AVR RAM.
+ *
+ * Usage:
+ *   LogCompressor comp;
+ *   logCompressReset(&comp, widths, channels);
+ *   uint8_t block[LOG_COMPRESS_BOUND(LOG_COMPRESS_MAX_RECORD)];
+ *   uint16_t len = logCompressRecord(&comp, record, block);
+ */
+
+#ifndef LOG_COMPRESS_H
+#define LOG_COMPRESS_H
+
+#include <Arduino.h>
+#include "platform.h"  // MAX_INPUTS
+
+#define LOG_COMPRESS_WINDOW      1024   // Match distance limit - part of the format
+#define LOG_COMPRESS_MIN_MATCH   3
+#define LOG_COMPRESS_MAX_MATCH   (LOG_COMPRESS_MIN_MATCH + 63)
+#define LOG_COMPRESS_HASH_BITS   8
+// Room for the timestamp and every input slot at 16 bits (-D MAX_INPUTS tables)
+#if 4 + 2 * MAX_INPUTS > 256
+#define LOG_COMPRESS_MAX_RECORD  (4 + 2 * MAX_INPUTS)
+#define LOG_COMPRESS_MAX_CHANNELS MAX_INPUTS
+#else
+#define LOG_COMPRESS_MAX_RECORD  256
+#define LOG_COMPRESS_MAX_CHANNELS 126
+#endif
+
+// Largest block for an n-byte record: length, every byte a literal, flag bytes
+#define LOG_COMPRESS_BOUND(n)    (2 + (n) + ((n) + 7) / 8)
+
+struct LogCompressor {
+    uint8_t prev[LOG_COMPRESS_MAX_RECORD];      // Previous record (delta reference)
+    uint8_t width[LOG_COMPRESS_MAX_CHANNELS];   // Channel bytes (1 or 2), in record order
+    uint8_t channels;
+    uint8_t history[2 * LOG_COMPRESS_WINDOW];   // Delta bytes already coded, newest last
+    uint16_t historyLength;
+    uint16_t head[1 << LOG_COMPRESS_HASH_BITS]; // Newest history position + 1 of each 3-byte hash
+    uint16_t recordSize;
+    uint32_t rawBytes;                          // Statistics since the reset
+    uint32_t packedBytes;
+};
+
+/**
+ * Start a new stream
+ * @param width     Bytes of each channel (1 or 2) in record order; the record is
+ *                  a uint32 timestamp followed by the channels (at most
+ *                  LOG_COMPRESS_MAX_RECORD bytes)
+ */
+void logCompressReset(LogCompressor* comp, const uint8_t* width, uint8_t channels);
+
+/**
+ * Compress one record
+ * @param record  recordSize bytes, the uint32 timestamp first
+ * @param out     At least LOG_COMPRESS_BOUND(recordSize) bytes
+ * @return Block length in bytes
+ */
+uint16_t logCompressRecord(LogCompressor* comp, const uint8_t* record, uint8_t* out);
+
+#endif // LOG_COMPRESS_H
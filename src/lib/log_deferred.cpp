@@ -0,0 +1,81 @@
+/*
+ * log_deferred.cpp - Deferred binary logging implementation
+ */
+
+#include "log_deferred.h"
+
+#ifdef ENABLE_DEFERRED_LOG
+
+#include "message_api.h"
+#include "../outputs/serial_frame.h"
+#include "dual_core.h"
+
+#define DEFERRED_LOG_FRAME  'L'
+
+static_assert(DEFERRED_LOG_FRAME_BYTES >= 2 + DEFERRED_LOG_RECORD_HEADER + DEFERRED_LOG_MAX_ARGS,
+              "Deferred log frame too small for a record");
+static_assert(DEFERRED_LOG_RECORD_HEADER - 1 + DEFERRED_LOG_MAX_ARGS <= 0xFF,
+              "Deferred log record length is 8-bit");
+
+static uint8_t ring[DEFERRED_LOG_RING_BYTES];
+static uint16_t ringTail = 0;       // Oldest record
+static uint16_t ringUsed = 0;
+static uint16_t dropped = 0;        // Records lost to a full ring since the last frame
+static uint16_t frameSequence = 0;  // 'L' frames count their own
+
+static uint8_t frame[SERIAL_FRAME_OVERHEAD + DEFERRED_LOG_FRAME_BYTES];
+
+void deferredLogPush(uint8_t level, uint8_t tagId, const char* fmt, const uint8_t* args, uint8_t len) {
+    uint8_t record[DEFERRED_LOG_RECORD_HEADER + DEFERRED_LOG_MAX_ARGS];
+    uint32_t us = micros();
+    uint32_t address = (uint32_t)(uintptr_t)fmt;
+    record[0] = DEFERRED_LOG_RECORD_HEADER - 1 + len;
+    memcpy(record + 1, &us, 4);
+    memcpy(record + 5, &address, 4);
+    record[9] = (level << 5) | (tagId & 0x1F);
+    memcpy(record + DEFERRED_LOG_RECORD_HEADER, args, len);
+
+    uint16_t n = DEFERRED_LOG_RECORD_HEADER + len;
+    dualCoreLock();  // Both cores log (dual_core.h)
+    if (n > DEFERRED_LOG_RING_BYTES - ringUsed) {
+        dropped++;
+        dualCoreUnlock();
+        return;
+    }
+    uint16_t head = (ringTail + ringUsed) % DEFERRED_LOG_RING_BYTES;
+    for (uint16_t i = 0; i < n; i++) {
+        ring[head] = record[i];
+        head = (head + 1 == DEFERRED_LOG_RING_BYTES) ? 0 : head + 1;
+    }
+    ringUsed += n;
+    dualCoreUnlock();
+}
+
+void drainDeferredLog() {
+    if (ringUsed == 0 && dropped == 0) return;
+
+    dualCoreLock();
+    uint8_t* p = frame + SERIAL_FRAME_HEADER;
+    *p++ = dropped & 0xFF;
+    *p++ = dropped >> 8;
+    dropped = 0;
+
+    // Whole records, as many as fit one frame
+    uint16_t room = DEFERRED_LOG_FRAME_BYTES - 2;
+    while (ringUsed > 0) {
+        uint16_t n = ring[ringTail] + 1;
+        if (n > room) break;
+        for (uint16_t i = 0; i < n; i++) {
+            *p++ = ring[ringTail];
+            ringTail = (ringTail + 1 == DEFERRED_LOG_RING_BYTES) ? 0 : ringTail + 1;
+        }
+        ringUsed -= n;
+        room -= n;
+    }
+    dualCoreUnlock();
+
+    uint16_t len = p - (frame + SERIAL_FRAME_HEADER);
+    msg.debug.write(frame, buildSerialFrame(frame, DEFERRED_LOG_FRAME, len, frameSequence++));
+}
+
+#endif // ENABLE_DEFERRED_LOG
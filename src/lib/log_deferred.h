@@ -0,0 +1,167 @@
+/*
+ * log_deferred.h - Deferred binary logging, decoded on the host
+ *
+ * With ENABLE_DEFERRED_LOG, msg.debug.error/warn/info/debug() don't format
+ * on the device. A call that passes the filters (log_filter.h) records its
+ * format string's address - the call site's ID, fixed at link time, with the
+ * firmware ELF as the string table - micros(), its level and tag, and the raw
+ * bytes of its arguments in a ring. router.update() drains the ring to the
+ * debug plane as 'L' frames (serial_frame.h), and tools/log_decode.py
+ * formats them on the host from the ELF. No vsnprintf, and a few bytes on
+ * the wire per message instead of the text.
+ *
+ * Record: length of the rest (uint8), micros (uint32), format address
+ * (uint32), level << 5 | tag ID, then each argument in order:
+ *
+ *   integers up to 32 bits   4 bytes, sign- or zero-extended
+ *   64-bit integers          8 bytes
+ *   float / double           4 bytes, float32
+ *   strings                  length (uint8) and up to DEFERRED_LOG_MAX_STRING bytes
+ *
+ * all little-endian. Arguments past DEFERRED_LOG_MAX_ARGS bytes are left
+ * off; the decoder marks them missing. An 'L' frame's payload is the count
+ * of records dropped with the ring full since the previous frame (uint16),
+ * then whole records. 'L' frames number their own sequence - the debug
+ * plane may be another transport than the data plane.
+ *
+ * Not from interrupt handlers: they would race the ring. (The dual-core
+ * acquisition task is fine - pushes hold the spinlock, dual_core.h.)
+ *
+ * Usage:
+ *   msg.debug.info(TAG_CAN, "Bus %d: %lu frames", bus, count);  // Unchanged
+ *   drainDeferredLog();        // router.update() does this every loop
+ *
+ * Build Flags:
+ *   -D ENABLE_DEFERRED_LOG          - Record debug messages instead of formatting them
+ *   -D DEFERRED_LOG_RING_BYTES=n    - Record ring (default 1024; 256 on AVR)
+ *   -D DEFERRED_LOG_FRAME_BYTES=n   - Largest 'L' frame payload (default 256)
+ *   -D DEFERRED_LOG_MAX_ARGS=n      - Argument bytes per record (default 48)
+ *   -D DEFERRED_LOG_MAX_STRING=n    - Bytes kept of a string argument (default 32)
+ */
+
+#ifndef LOG_DEFERRED_H
+#define LOG_DEFERRED_H
+
+#include <Arduino.h>
+
+#ifndef DEFERRED_LOG_RING_BYTES
+#if defined(__AVR__)
+#define DEFERRED_LOG_RING_BYTES 256
+#else
+#define DEFERRED_LOG_RING_BYTES 1024
+#endif
+#endif
+
+#ifndef DEFERRED_LOG_FRAME_BYTES
+#define DEFERRED_LOG_FRAME_BYTES 256
+#endif
+
+#ifndef DEFERRED_LOG_MAX_ARGS
+#define DEFERRED_LOG_MAX_ARGS 48
+#endif
+
+#ifndef DEFERRED_LOG_MAX_STRING
+#define DEFERRED_LOG_MAX_STRING 32
+#endif
+
+#define DEFERRED_LOG_RECORD_HEADER 10     // Length, micros, format address, level/tag
+
+#ifdef ENABLE_DEFERRED_LOG
+
+// Argument bytes being packed; end closes at the first one that doesn't fit
+struct DeferredLogArgs {
+    uint8_t* p;
+    uint8_t* end;
+};
+
+inline void deferredPut(DeferredLogArgs& a, const void* value, uint8_t n) {
+    if (a.p + n > a.end) {
+        a.end = a.p;  // Leave this and every later argument off
+        return;
+    }
+    memcpy(a.p, value, n);
+    a.p += n;
+}
+
+template <typename T>
+inline void deferredPutInt(DeferredLogArgs& a, T v, bool isSigned) {
+    if (sizeof(T) > 4) {
+        long long v64 = (long long)v;
+        deferredPut(a, &v64, 8);
+    } else if (isSigned) {
+        int32_t v32 = (int32_t)v;
+        deferredPut(a, &v32, 4);
+    } else {
+        uint32_t v32 = (uint32_t)v;
+        deferredPut(a, &v32, 4);
+    }
+}
+
+inline void deferredPack(DeferredLogArgs& a, char v)               { deferredPutInt(a, v, true); }
+inline void deferredPack(DeferredLogArgs& a, signed char v)        { deferredPutInt(a, v, true); }
+inline void deferredPack(DeferredLogArgs& a, unsigned char v)      { deferredPutInt(a, v, false); }
+inline void deferredPack(DeferredLogArgs& a, bool v)               { deferredPutInt(a, v, false); }
+inline void deferredPack(DeferredLogArgs& a, short v)              { deferredPutInt(a, v, true); }
+inline void deferredPack(DeferredLogArgs& a, unsigned short v)     { deferredPutInt(a, v, false); }
+inline void deferredPack(DeferredLogArgs& a, int v)                { deferredPutInt(a, v, true); }
+inline void deferredPack(DeferredLogArgs& a, unsigned int v)       { deferredPutInt(a, v, false); }
+inline void deferredPack(DeferredLogArgs& a, long v)               { deferredPutInt(a, v, true); }
+inline void deferredPack(DeferredLogArgs& a, unsigned long v)      { deferredPutInt(a, v, false); }
+inline void deferredPack(DeferredLogArgs& a, long long v)          { deferredPutInt(a, v, true); }
+inline void deferredPack(DeferredLogArgs& a, unsigned long long v) { deferredPutInt(a, v, false); }
+
+inline void deferredPack(DeferredLogArgs& a, double v) {
+    float f = (float)v;
+    deferredPut(a, &f, 4);
+}
+
+inline void deferredPack(DeferredLogArgs& a, const void* v) {
+    uint32_t address = (uint32_t)(uintptr_t)v;
+    deferredPut(a, &address, 4);
+}
+
+inline void deferredPack(DeferredLogArgs& a, const char* s) {
+    if (!s) s = "(null)";
+    uint8_t n = strnlen(s, DEFERRED_LOG_MAX_STRING);
+    if (a.p + 1 + n > a.end) {
+        a.end = a.p;
+        return;
+    }
+    *a.p++ = n;
+    memcpy(a.p, s, n);
+    a.p += n;
+}
+
+inline void deferredPack(DeferredLogArgs& a, char* s) {
+    deferredPack(a, (const char*)s);
+}
+
+inline void deferredPackAll(DeferredLogArgs& a) {
+    (void)a;
+}
+
+template <typename T, typename... Rest>
+inline void deferredPackAll(DeferredLogArgs& a, T first, Rest... rest) {
+    deferredPack(a, first);
+    deferredPackAll(a, rest...);
+}
+
+// Queue one record (dropped, and counted, if the ring is full)
+void deferredLogPush(uint8_t level, uint8_t tagId, const char* fmt, const uint8_t* args, uint8_t len);
+
+// Pack the arguments of one call and queue its record
+template <typename... Args>
+size_t deferredLog(uint8_t level, uint8_t tagId, const char* fmt, Args... args) {
+    uint8_t bytes[DEFERRED_LOG_MAX_ARGS];
+    DeferredLogArgs packed = {bytes, bytes + sizeof(bytes)};
+    deferredPackAll(packed, args...);
+    deferredLogPush(level, tagId, fmt, bytes, packed.p - bytes);
+    return 0;
+}
+
+// Send queued records as one 'L' frame on the debug plane
+void drainDeferredLog();
+
+#endif // ENABLE_DEFERRED_LOG
+
+#endif // LOG_DEFERRED_H
@@ -15,37 +15,25 @@ LogFilter::LogFilter() {
 
     // Enable all tags by default
     enabledTags = 0xFFFFFFFF;  // All bits set = all tags enabled
+    rebuildMasks();
 }
 
-// Check if a message should be logged
-bool LogFilter::shouldLog(int plane, LogLevel level, uint8_t tagId) {
-    // Check plane is valid
-    if (plane >= MAX_MESSAGE_PLANES || plane < 0) {
-        return false;
-    }
-
-    // Check log level threshold
-    // Messages at or below the threshold level are shown
-    // Example: threshold=INFO shows ERROR(1), WARN(2), INFO(3) but not DEBUG(4)
-    if (level > levelThreshold[plane]) {
-        return false;
-    }
-
-    // Check tag filter (if tag ID is valid)
-    if (tagId < 32) {
-        if (!(enabledTags & (1UL << tagId))) {
-            return false;  // Tag is disabled
+// Precompute the tags that pass for each plane and level
+// Messages at or below the threshold level are shown
+// Example: threshold=INFO shows ERROR(1), WARN(2), INFO(3) but not DEBUG(4)
+void LogFilter::rebuildMasks() {
+    for (int plane = 0; plane < MAX_MESSAGE_PLANES; plane++) {
+        for (uint8_t level = LOG_LEVEL_ERROR; level <= LOG_LEVEL_DEBUG; level++) {
+            passMask[plane][level - 1] = (level <= levelThreshold[plane]) ? enabledTags : 0;
         }
     }
-    // If tagId >= 32, skip tag filtering (unknown tag - allow through)
-
-    return true;  // Both filters passed
 }
 
 // Set log level threshold for a specific plane
 void LogFilter::setLevel(int plane, LogLevel level) {
     if (plane >= 0 && plane < MAX_MESSAGE_PLANES && level <= LOG_LEVEL_DEBUG) {
         levelThreshold[plane] = level;
+        rebuildMasks();
     }
 }
 
@@ -65,6 +53,7 @@ void LogFilter::enableTag(uint8_t tagId, bool enable) {
         } else {
             enabledTags &= ~(1UL << tagId);  // Clear bit
         }
+        rebuildMasks();
     }
 }
 
@@ -79,11 +68,13 @@ bool LogFilter::isTagEnabled(uint8_t tagId) {
 // Enable all tags
 void LogFilter::enableAllTags() {
     enabledTags = 0xFFFFFFFF;
+    rebuildMasks();
 }
 
 // Disable all tags
 void LogFilter::disableAllTags() {
     enabledTags = 0;
+    rebuildMasks();
 }
 
 // Get level name as string
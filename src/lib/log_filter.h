@@ -5,7 +5,12 @@
  * - Log level (ERROR, WARN, INFO, DEBUG)
  * - Tag (SD, BME280, CAN, etc.)
  *
- * Filtering decisions are made before message formatting to minimize overhead.
+ * Filtering decisions are made before message formatting to minimize overhead:
+ * the runtime check is one inline bit test of a mask per plane and level,
+ * rebuilt whenever a level or tag changes.
+ *
+ * Messages above a tag's compile-time floor are removed from the build
+ * entirely - the call and its format string - and can't be enabled at runtime.
  *
  * Usage:
  *   LogFilter filter;
@@ -14,6 +19,12 @@
  *   if (filter.shouldLog(PLANE_DEBUG, LOG_LEVEL_INFO, TAG_ID_SD)) {
  *       // Log the message
  *   }
+ *
+ * Build Flags:
+ *   -D LOG_MIN_LEVEL=<level>        - Most verbose level compiled in, all tags
+ *                                     (NONE, ERROR, WARN, INFO, DEBUG; default DEBUG)
+ *   -D LOG_MIN_LEVEL_<TAG>=<level>  - The same for one tag, e.g.
+ *                                     -D LOG_MIN_LEVEL_CAN=WARN
  */
 
 #ifndef LOG_FILTER_H
@@ -35,6 +46,129 @@ enum LogLevel {
     LOG_LEVEL_DEBUG = 4   // Everything (maximum verbosity)
 };
 
+// ========== Compile-Time Floor ==========
+
+// Level names as given to LOG_MIN_LEVEL / LOG_MIN_LEVEL_<TAG>
+// (no DEBUG name in builds that define DEBUG - it is the default anyway)
+namespace log_floor {
+    enum : uint8_t {
+        NONE = 0, ERROR = 1, WARN = 2, INFO = 3,
+#ifndef DEBUG
+        DEBUG = 4
+#endif
+    };
+}
+
+#ifdef LOG_MIN_LEVEL
+#define LOG_FLOOR_DEFAULT (log_floor::LOG_MIN_LEVEL)
+#else
+#define LOG_FLOOR_DEFAULT LOG_LEVEL_DEBUG
+#endif
+
+#define LOG_FLOOR_TAG_(x) (log_floor::x)
+
+#ifdef LOG_MIN_LEVEL_SD
+#define LOG_FLOOR_SD LOG_FLOOR_TAG_(LOG_MIN_LEVEL_SD)
+#else
+#define LOG_FLOOR_SD LOG_FLOOR_DEFAULT
+#endif
+#ifdef LOG_MIN_LEVEL_BT
+#define LOG_FLOOR_BT LOG_FLOOR_TAG_(LOG_MIN_LEVEL_BT)
+#else
+#define LOG_FLOOR_BT LOG_FLOOR_DEFAULT
+#endif
+#ifdef LOG_MIN_LEVEL_CAN
+#define LOG_FLOOR_CAN LOG_FLOOR_TAG_(LOG_MIN_LEVEL_CAN)
+#else
+#define LOG_FLOOR_CAN LOG_FLOOR_DEFAULT
+#endif
+#ifdef LOG_MIN_LEVEL_ADC
+#define LOG_FLOOR_ADC LOG_FLOOR_TAG_(LOG_MIN_LEVEL_ADC)
+#else
+#define LOG_FLOOR_ADC LOG_FLOOR_DEFAULT
+#endif
+#ifdef LOG_MIN_LEVEL_SENSOR
+#define LOG_FLOOR_SENSOR LOG_FLOOR_TAG_(LOG_MIN_LEVEL_SENSOR)
+#else
+#define LOG_FLOOR_SENSOR LOG_FLOOR_DEFAULT
+#endif
+#ifdef LOG_MIN_LEVEL_CONFIG
+#define LOG_FLOOR_CONFIG LOG_FLOOR_TAG_(LOG_MIN_LEVEL_CONFIG)
+#else
+#define LOG_FLOOR_CONFIG LOG_FLOOR_DEFAULT
+#endif
+#ifdef LOG_MIN_LEVEL_ALARM
+#define LOG_FLOOR_ALARM LOG_FLOOR_TAG_(LOG_MIN_LEVEL_ALARM)
+#else
+#define LOG_FLOOR_ALARM LOG_FLOOR_DEFAULT
+#endif
+#ifdef LOG_MIN_LEVEL_DISPLAY
+#define LOG_FLOOR_DISPLAY LOG_FLOOR_TAG_(LOG_MIN_LEVEL_DISPLAY)
+#else
+#define LOG_FLOOR_DISPLAY LOG_FLOOR_DEFAULT
+#endif
+#ifdef LOG_MIN_LEVEL_ROUTER
+#define LOG_FLOOR_ROUTER LOG_FLOOR_TAG_(LOG_MIN_LEVEL_ROUTER)
+#else
+#define LOG_FLOOR_ROUTER LOG_FLOOR_DEFAULT
+#endif
+#ifdef LOG_MIN_LEVEL_SERIAL
+#define LOG_FLOOR_SERIAL LOG_FLOOR_TAG_(LOG_MIN_LEVEL_SERIAL)
+#else
+#define LOG_FLOOR_SERIAL LOG_FLOOR_DEFAULT
+#endif
+#ifdef LOG_MIN_LEVEL_I2C
+#define LOG_FLOOR_I2C LOG_FLOOR_TAG_(LOG_MIN_LEVEL_I2C)
+#else
+#define LOG_FLOOR_I2C LOG_FLOOR_DEFAULT
+#endif
+#ifdef LOG_MIN_LEVEL_SPI
+#define LOG_FLOOR_SPI LOG_FLOOR_TAG_(LOG_MIN_LEVEL_SPI)
+#else
+#define LOG_FLOOR_SPI LOG_FLOOR_DEFAULT
+#endif
+#ifdef LOG_MIN_LEVEL_JSON
+#define LOG_FLOOR_JSON LOG_FLOOR_TAG_(LOG_MIN_LEVEL_JSON)
+#else
+#define LOG_FLOOR_JSON LOG_FLOOR_DEFAULT
+#endif
+#ifdef LOG_MIN_LEVEL_RELAY
+#define LOG_FLOOR_RELAY LOG_FLOOR_TAG_(LOG_MIN_LEVEL_RELAY)
+#else
+#define LOG_FLOOR_RELAY LOG_FLOOR_DEFAULT
+#endif
+#ifdef LOG_MIN_LEVEL_SYSTEM
+#define LOG_FLOOR_SYSTEM LOG_FLOOR_TAG_(LOG_MIN_LEVEL_SYSTEM)
+#else
+#define LOG_FLOOR_SYSTEM LOG_FLOOR_DEFAULT
+#endif
+
+// Most verbose level compiled in for a tag
+constexpr uint8_t logCompiledLevel(uint8_t tagId) {
+    return tagId == TAG_ID_SD      ? LOG_FLOOR_SD :
+           tagId == TAG_ID_BT      ? LOG_FLOOR_BT :
+           tagId == TAG_ID_CAN     ? LOG_FLOOR_CAN :
+           tagId == TAG_ID_ADC     ? LOG_FLOOR_ADC :
+           tagId == TAG_ID_SENSOR  ? LOG_FLOOR_SENSOR :
+           tagId == TAG_ID_CONFIG  ? LOG_FLOOR_CONFIG :
+           tagId == TAG_ID_ALARM   ? LOG_FLOOR_ALARM :
+           tagId == TAG_ID_DISPLAY ? LOG_FLOOR_DISPLAY :
+           tagId == TAG_ID_ROUTER  ? LOG_FLOOR_ROUTER :
+           tagId == TAG_ID_SERIAL  ? LOG_FLOOR_SERIAL :
+           tagId == TAG_ID_I2C     ? LOG_FLOOR_I2C :
+           tagId == TAG_ID_SPI     ? LOG_FLOOR_SPI :
+           tagId == TAG_ID_JSON    ? LOG_FLOOR_JSON :
+           tagId == TAG_ID_RELAY   ? LOG_FLOOR_RELAY :
+           tagId == TAG_ID_SYSTEM  ? LOG_FLOOR_SYSTEM :
+           LOG_FLOOR_DEFAULT;
+}
+
+// True if messages of this level and tag are compiled in
+template <uint8_t Id>
+constexpr bool logCompiled(uint8_t level, LogTagId<Id>) {
+    return level <= logCompiledLevel(Id);
+}
+
 // Log filter class
 class LogFilter {
 private:
@@ -45,6 +179,12 @@ private:
     // Supports up to 32 tags using a single uint32_t
     uint32_t enabledTags;
 
+    // Tags that pass, per plane and level (ERROR..DEBUG) - enabledTags where
+    // the level is within the plane's threshold, else 0
+    uint32_t passMask[MAX_MESSAGE_PLANES][LOG_LEVEL_DEBUG];
+
+    void rebuildMasks();
+
 public:
     // Constructor - initialize with permissive defaults
     LogFilter();
@@ -54,7 +194,17 @@ public:
     // Check if a message should be logged
     // Returns true if both level and tag filters pass
     // plane parameter is int to avoid circular dependency (use MessagePlane enum values)
-    bool shouldLog(int plane, LogLevel level, uint8_t tagId);
+    bool shouldLog(int plane, LogLevel level, uint8_t tagId) const {
+        if (plane < 0 || plane >= MAX_MESSAGE_PLANES) return false;
+        if (level == LOG_LEVEL_NONE || level > LOG_LEVEL_DEBUG) return false;
+        if (tagId >= 32) return level <= levelThreshold[plane];  // Unknown tag - level only
+        return passes(plane, level, tagId);
+    }
+
+    // The same for a known plane, level and tag - one bit test
+    bool passes(int plane, uint8_t level, uint8_t tagId) const {
+        return (passMask[plane][level - 1] & (1UL << tagId)) != 0;
+    }
 
     // ========== Level Configuration ==========
 
@@ -85,7 +235,7 @@ public:
     uint32_t getEnabledTags() { return enabledTags; }
 
     // Set enabled tags bitmap (for loading from EEPROM)
-    void setEnabledTags(uint32_t tags) { enabledTags = tags; }
+    void setEnabledTags(uint32_t tags) { enabledTags = tags; rebuildMasks(); }
 
     // ========== Utility Functions ==========
 
@@ -9,7 +9,9 @@
  *   LOG_DEBUG(TAG_ADC, "Channel %d value: %d", channel, value);
  *
  * These macros route to msg.debug plane and compile to no-ops when
- * DISABLE_DEBUG_MESSAGES is defined.
+ * DISABLE_DEBUG_MESSAGES is defined. Unlike a direct msg.debug call, a
+ * macro above the tag's compile-time floor (log_filter.h) doesn't evaluate
+ * its arguments either.
  */
 
 #ifndef LOG_MACROS_H
@@ -21,10 +23,12 @@
 
 // Macro API - routes to msg.debug plane with printf-style variadic arguments
 // Uses ##__VA_ARGS__ to handle both simple strings and formatted output
-#define LOG_ERROR(tag, fmt, ...) msg.debug.error(tag, fmt, ##__VA_ARGS__)
-#define LOG_WARN(tag, fmt, ...)  msg.debug.warn(tag, fmt, ##__VA_ARGS__)
-#define LOG_INFO(tag, fmt, ...)  msg.debug.info(tag, fmt, ##__VA_ARGS__)
-#define LOG_DEBUG(tag, fmt, ...) msg.debug.debug(tag, fmt, ##__VA_ARGS__)
+#define LOG_AT_(level, method, tag, fmt, ...) \
+    do { if (logCompiled(level, tag)) msg.debug.method(tag, fmt, ##__VA_ARGS__); } while (0)
+#define LOG_ERROR(tag, fmt, ...) LOG_AT_(LOG_LEVEL_ERROR, error, tag, fmt, ##__VA_ARGS__)
+#define LOG_WARN(tag, fmt, ...)  LOG_AT_(LOG_LEVEL_WARN, warn, tag, fmt, ##__VA_ARGS__)
+#define LOG_INFO(tag, fmt, ...)  LOG_AT_(LOG_LEVEL_INFO, info, tag, fmt, ##__VA_ARGS__)
+#define LOG_DEBUG(tag, fmt, ...) LOG_AT_(LOG_LEVEL_DEBUG, debug, tag, fmt, ##__VA_ARGS__)
 
 // All macros compile to no-ops when debug messages disabled
 #ifdef DISABLE_DEBUG_MESSAGES
@@ -1,8 +1,12 @@
 /*
  * log_tags.h - Tag definitions for structured logging
  *
- * Defines tag IDs and string constants for categorizing log messages.
- * Tags allow runtime filtering of log output by subsystem.
+ * Defines tag IDs and tag constants for categorizing log messages.
+ * Tags allow runtime filtering of log output by subsystem, and a
+ * compile-time level floor per tag (log_filter.h).
+ *
+ * TAG_* constants carry their ID in their type (LogTagId<id>), so the
+ * logging calls know the tag at compile time - no name lookup at runtime.
  *
  * Usage:
  *   LOG_INFO(TAG_SD, "Card initialized");
@@ -38,22 +42,28 @@ enum LogTag {
     NUM_LOG_TAGS  // Must be last - count of tags
 };
 
-// Tag string constants (for code usage)
-#define TAG_SD        "SD"
-#define TAG_BT        "BT"
-#define TAG_CAN       "CAN"
-#define TAG_ADC       "ADC"
-#define TAG_SENSOR    "SENSOR"
-#define TAG_CONFIG    "CONFIG"
-#define TAG_ALARM     "ALARM"
-#define TAG_DISPLAY   "DISPLAY"
-#define TAG_ROUTER    "ROUTER"
-#define TAG_SERIAL    "SERIAL"
-#define TAG_I2C       "I2C"
-#define TAG_SPI       "SPI"
-#define TAG_JSON      "JSON"
-#define TAG_RELAY     "RELAY"
-#define TAG_SYSTEM    "SYSTEM"
+// Compile-time tag (the first argument of msg.debug.info() etc.)
+template <uint8_t Id>
+struct LogTagId {
+    static constexpr uint8_t id = Id;
+};
+
+// Tag constants (for code usage)
+#define TAG_SD        LogTagId<TAG_ID_SD>()
+#define TAG_BT        LogTagId<TAG_ID_BT>()
+#define TAG_CAN       LogTagId<TAG_ID_CAN>()
+#define TAG_ADC       LogTagId<TAG_ID_ADC>()
+#define TAG_SENSOR    LogTagId<TAG_ID_SENSOR>()
+#define TAG_CONFIG    LogTagId<TAG_ID_CONFIG>()
+#define TAG_ALARM     LogTagId<TAG_ID_ALARM>()
+#define TAG_DISPLAY   LogTagId<TAG_ID_DISPLAY>()
+#define TAG_ROUTER    LogTagId<TAG_ID_ROUTER>()
+#define TAG_SERIAL    LogTagId<TAG_ID_SERIAL>()
+#define TAG_I2C       LogTagId<TAG_ID_I2C>()
+#define TAG_SPI       LogTagId<TAG_ID_SPI>()
+#define TAG_JSON      LogTagId<TAG_ID_JSON>()
+#define TAG_RELAY     LogTagId<TAG_ID_RELAY>()
+#define TAG_SYSTEM    LogTagId<TAG_ID_SYSTEM>()
 
 // Tag name array (stored in PROGMEM to save RAM)
 const char TAG_NAME_SD[]      PROGMEM = "SD";
@@ -95,7 +105,7 @@ const char* const LOG_TAG_NAMES[] PROGMEM = {
 // Returns NUM_LOG_TAGS if tag not found
 uint8_t getTagID(const char* tagName);
 
-// Helper function to get tag name from ID
+// Helper function to get tag name from ID (a PROGMEM string)
 // Returns nullptr if ID out of range
 const char* getTagName(uint8_t tagId);
 
@@ -0,0 +1,229 @@
+/*
+ * loop_monitor.cpp - Loop budget monitor and overrun history implementation
+ */
+
+#include "loop_monitor.h"
+#include "message_api.h"
+#include "log_tags.h"
+#include "../hal/hal_retained.h"
+
+#define LOOP_HISTORY_MAGIC 0x4C4F4F50UL  // "LOOP"
+
+// Retained across watchdog/software resets - validated with magic + checksum
+struct LoopHistory {
+    uint32_t magic;
+    uint16_t resets;                          // Warm resets survived since power-on
+    uint8_t inLoop;                           // 1 while an iteration is in progress
+    char activeSegment[LOOP_SEGMENT_NAME_LEN]; // Segment running right now
+    LoopOverrunStats current;                 // This boot
+    LoopOverrunStats previous;                // Boot before the last reset
+    uint8_t hasPrevious;
+    char resetSegment[LOOP_SEGMENT_NAME_LEN]; // Segment active when the last reset hit
+    uint8_t checksum;
+};
+
+static LoopHistory history HAL_RETAINED;
+
+// Non-retained per-iteration state
+static uint32_t budgetUs = (uint32_t)LOOP_BUDGET_MS * 1000UL;
+static uint32_t iterationStart = 0;
+static uint32_t segmentStart = 0;
+static const char* segmentName = nullptr;
+static const char* longestSegment = nullptr;
+static uint32_t longestSegmentUs = 0;
+
+// ===== RETAINED STORAGE HELPERS =====
+
+static uint8_t historyChecksum() {
+    const uint8_t* bytes = (const uint8_t*)&history;
+    uint8_t checksum = 0;
+    for (size_t i = 0; i < offsetof(LoopHistory, checksum); i++) {
+        checksum ^= bytes[i];
+    }
+    return checksum;
+}
+
+static void commitHistory() {
+    history.checksum = historyChecksum();
+    hal::retainedFlush(&history, sizeof(history));
+}
+
+static void copySegmentName(char* dest, const char* src) {
+    strncpy(dest, src ? src : "", LOOP_SEGMENT_NAME_LEN - 1);
+    dest[LOOP_SEGMENT_NAME_LEN - 1] = '\0';
+}
+
+// Credit time since the last mark to the current segment
+static void closeSegment(uint32_t nowUs) {
+    uint32_t elapsed = nowUs - segmentStart;
+    if (segmentName != nullptr && elapsed > longestSegmentUs) {
+        longestSegmentUs = elapsed;
+        longestSegment = segmentName;
+    }
+    segmentStart = nowUs;
+}
+
+// ===== INITIALIZATION =====
+
+void initLoopMonitor() {
+    bool recovered = HAL_HAS_RETAINED_RAM &&
+                     history.magic == LOOP_HISTORY_MAGIC &&
+                     history.checksum == historyChecksum();
+
+    if (recovered) {
+        history.resets++;
+
+        // Reset hit mid-iteration - remember which segment never finished
+        if (history.inLoop) {
+            copySegmentName(history.resetSegment, history.activeSegment);
+        } else {
+            history.resetSegment[0] = '\0';
+        }
+
+        history.previous = history.current;
+        history.hasPrevious = 1;
+
+        if (history.resetSegment[0] != '\0') {
+            msg.debug.warn(TAG_SYSTEM, "Reset during loop segment %s", history.resetSegment);
+        }
+        if (history.previous.overruns > 0) {
+            msg.debug.warn(TAG_SYSTEM, "Previous boot: %lu loop overruns, worst %lu us in %s",
+                           (unsigned long)history.previous.overruns,
+                           (unsigned long)history.previous.worstUs,
+                           history.previous.worstSegment);
+        }
+    } else {
+        memset(&history, 0, sizeof(history));
+        history.magic = LOOP_HISTORY_MAGIC;
+    }
+
+    memset(&history.current, 0, sizeof(history.current));
+    history.inLoop = 0;
+    history.activeSegment[0] = '\0';
+    commitHistory();
+}
+
+// ===== PER-ITERATION HOOKS =====
+
+void loopMonitorStart() {
+    iterationStart = micros();
+    segmentStart = iterationStart;
+    segmentName = nullptr;
+    longestSegment = nullptr;
+    longestSegmentUs = 0;
+
+    history.inLoop = 1;
+    history.activeSegment[0] = '\0';
+    commitHistory();
+}
+
+void loopMonitorMark(const char* segment) {
+    closeSegment(micros());
+    segmentName = segment;
+
+    copySegmentName(history.activeSegment, segment);
+    commitHistory();
+}
+
+void loopMonitorEnd() {
+    uint32_t nowUs = micros();
+    closeSegment(nowUs);
+
+    uint32_t elapsed = nowUs - iterationStart;
+    LoopOverrunStats* stats = &history.current;
+
+    if (elapsed > budgetUs) {
+        stats->overruns++;
+        if (elapsed > stats->worstUs) {
+            stats->worstUs = elapsed;
+            stats->worstAtMs = millis();
+            copySegmentName(stats->worstSegment, longestSegment ? longestSegment : "LOOP");
+        }
+    }
+
+    history.inLoop = 0;
+    commitHistory();
+}
+
+bool loopBudgetExceeded() {
+    return (micros() - iterationStart) > budgetUs;
+}
+
+uint32_t getLoopElapsedUs() {
+    return micros() - iterationStart;
+}
+
+void loopMonitorNoteDeferral() {
+    history.current.deferrals++;
+    commitHistory();
+}
+
+void loopMonitorPrepareReset() {
+    history.inLoop = 0;
+    commitHistory();
+}
+
+// ===== CONFIGURATION / REPORTING =====
+
+void setLoopBudget(uint16_t budget_ms) {
+    budgetUs = (uint32_t)budget_ms * 1000UL;
+}
+
+uint16_t getLoopBudget() {
+    return (uint16_t)(budgetUs / 1000UL);
+}
+
+const LoopOverrunStats* getLoopStats() {
+    return &history.current;
+}
+
+const LoopOverrunStats* getPreviousLoopStats() {
+    return history.hasPrevious ? &history.previous : nullptr;
+}
+
+static void printOverrunStats(const LoopOverrunStats* stats) {
+    msg.control.print(F("  Overruns: "));
+    msg.control.print(stats->overruns);
+    msg.control.print(F(", Deferred: "));
+    msg.control.println(stats->deferrals);
+    if (stats->overruns > 0) {
+        msg.control.print(F("  Worst: "));
+        msg.control.print(stats->worstUs);
+        msg.control.print(F(" us in "));
+        msg.control.print(stats->worstSegment);
+        msg.control.print(F(" at "));
+        msg.control.print(stats->worstAtMs);
+        msg.control.println(F(" ms"));
+    }
+}
+
+void printLoopStatus() {
+    msg.control.println(F("=== Loop Budget ==="));
+    msg.control.print(F("Budget: "));
+    msg.control.print(getLoopBudget());
+    msg.control.println(F(" ms"));
+
+    msg.control.println(F("This boot:"));
+    printOverrunStats(&history.current);
+
+#if HAL_HAS_RETAINED_RAM
+    msg.control.print(F("Warm resets: "));
+    msg.control.println(history.resets);
+    if (history.hasPrevious) {
+        msg.control.println(F("Previous boot:"));
+        printOverrunStats(&history.previous);
+        if (history.resetSegment[0] != '\0') {
+            msg.control.print(F("  Reset during: "));
+            msg.control.println(history.resetSegment);
+        }
+    }
+#else
+    msg.control.println(F("(History not retained across resets on this platform)"));
+#endif
+}
+
+void resetLoopHistory() {
+    memset(&history, 0, sizeof(history));
+    history.magic = LOOP_HISTORY_MAGIC;
+    commitHistory();
+}
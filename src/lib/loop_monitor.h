@@ -0,0 +1,87 @@
+/*
+ * loop_monitor.h - Loop budget monitor and overrun history
+ *
+ * The watchdog only tells us the loop stalled once the board has already
+ * reset. The loop monitor enforces a much tighter soft deadline (the loop
+ * budget, default 20ms) and keeps a record of every iteration that blew it:
+ *
+ *   - Overrun count and the worst iteration time
+ *   - Which segment (router, CAN input, scheduled task, ...) took the largest
+ *     share of the worst iteration
+ *   - Which segment was running when the board last reset
+ *
+ * That record lives in reset-retained RAM (hal/hal_retained.h), so after a
+ * watchdog reset the previous boot's history is still available and
+ * SYSTEM LOOP shows what starved the loop.
+ *
+ * Low-priority work defers itself to the next iteration when the current one
+ * has already used its budget: the scheduler sheds cosmetic tasks (LCD, serial
+ * CSV) and the LED and SD flush check loopBudgetExceeded() directly.
+ *
+ * Usage:
+ *   void loop() {
+ *       loopMonitorStart();
+ *       loopMonitorMark("ROUTER");
+ *       router.update();
+ *       ...
+ *       loopMonitorEnd();
+ *   }
+ *
+ * Build Flags:
+ *   -D LOOP_BUDGET_MS=n  - Default soft deadline per loop iteration (default 20)
+ */
+
+#ifndef LOOP_MONITOR_H
+#define LOOP_MONITOR_H
+
+#include <Arduino.h>
+
+#ifndef LOOP_BUDGET_MS
+#define LOOP_BUDGET_MS 20
+#endif
+
+#define LOOP_SEGMENT_NAME_LEN 12
+
+// Overrun statistics for one boot
+struct LoopOverrunStats {
+    uint32_t overruns;                        // Iterations over budget
+    uint32_t deferrals;                       // Low-priority work items pushed to a later iteration
+    uint32_t worstUs;                         // Longest iteration seen
+    uint32_t worstAtMs;                       // millis() when it happened
+    char worstSegment[LOOP_SEGMENT_NAME_LEN]; // Largest contributor to the worst iteration
+};
+
+// Initialise monitor and recover history from the previous boot
+// Call early in setup(), before the watchdog is enabled
+void initLoopMonitor();
+
+// ===== PER-ITERATION HOOKS =====
+
+void loopMonitorStart();                  // Top of loop()
+void loopMonitorMark(const char* segment); // Time from here on belongs to 'segment'
+void loopMonitorEnd();                    // Bottom of loop() (not called on early return)
+
+// True if the current iteration has already used its budget
+bool loopBudgetExceeded();
+
+// Microseconds since loopMonitorStart()
+uint32_t getLoopElapsedUs();
+
+// Record that a low-priority item was deferred because of the budget
+void loopMonitorNoteDeferral();
+
+// Intentional reboot is about to happen - don't blame the active segment
+void loopMonitorPrepareReset();
+
+// ===== CONFIGURATION / REPORTING =====
+
+void setLoopBudget(uint16_t budget_ms);   // Runtime override (not persisted)
+uint16_t getLoopBudget();
+
+const LoopOverrunStats* getLoopStats();          // This boot
+const LoopOverrunStats* getPreviousLoopStats();  // Previous boot (nullptr if none recovered)
+
+void printLoopStatus();    // SYSTEM LOOP
+void resetLoopHistory();   // SYSTEM LOOP RESET - clears this and previous boot
+
+#endif // LOOP_MONITOR_H
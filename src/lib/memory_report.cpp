@@ -0,0 +1,138 @@
+/*
+ * memory_report.cpp - RAM usage report (SYSTEM MEMORY)
+ */
+
+#include "memory_report.h"
+#include "message_api.h"
+#include "static_pool.h"
+#include "../hal/hal_memory.h"
+#include "../hal/hal_placement.h"
+
+#define PAINT_BYTE 0xA5
+#define PAINT_MARGIN 64     // Below the stack pointer at paint time: the frames of setup()
+
+struct MemoryEntry {
+    const __FlashStringHelper* name;
+    size_t bytes;
+};
+
+static MemoryEntry entries[MEMORY_REPORT_MAX_ENTRIES];
+static uint8_t numEntries = 0;
+
+#if HAL_HAS_PLACEMENT
+struct PlacementEntry {
+    const __FlashStringHelper* name;
+    const void* addr;
+};
+
+static PlacementEntry placements[MEMORY_REPORT_MAX_PLACEMENTS];
+static uint8_t numPlacements = 0;
+#endif
+
+#if HAL_HAS_STACK_RANGE
+static uintptr_t paintedFrom = 0;   // Heap top at paint time
+static uintptr_t paintedTo = 0;     // Stack pointer at paint time, less the margin
+#endif
+
+void initMemoryReport() {
+#if HAL_HAS_STACK_RANGE
+    uint8_t here;
+    paintedFrom = hal::memStackLimit();
+    paintedTo = (uintptr_t)&here - PAINT_MARGIN;
+    for (uintptr_t addr = paintedFrom; addr < paintedTo; addr++) {
+        *(volatile uint8_t*)addr = PAINT_BYTE;
+    }
+#endif
+}
+
+void noteStaticMemory(const __FlashStringHelper* name, size_t bytes) {
+    for (uint8_t i = 0; i < numEntries; i++) {
+        if (entries[i].name == name) {
+            entries[i].bytes = bytes;
+            return;
+        }
+    }
+    if (numEntries < MEMORY_REPORT_MAX_ENTRIES) {
+        entries[numEntries++] = {name, bytes};
+    }
+}
+
+void notePlacement(const __FlashStringHelper* name, const void* addr) {
+#if HAL_HAS_PLACEMENT
+    for (uint8_t i = 0; i < numPlacements; i++) {
+        if (placements[i].name == name) {
+            placements[i].addr = addr;
+            return;
+        }
+    }
+    if (numPlacements < MEMORY_REPORT_MAX_PLACEMENTS) {
+        placements[numPlacements++] = {name, addr};
+    }
+#else
+    (void)name;
+    (void)addr;
+#endif
+}
+
+#if HAL_HAS_MEMORY_INFO || HAL_HAS_PLACEMENT
+static void printBytes(const __FlashStringHelper* label, size_t bytes) {
+    msg.control.print(label);
+    msg.control.print((unsigned long)bytes);
+    msg.control.println(F(" bytes"));
+}
+#endif
+
+HAL_COLD_CODE void printMemoryReport() {
+    msg.control.println();
+    msg.control.println(F("===== Memory ====="));
+
+#if HAL_HAS_MEMORY_INFO
+    printBytes(F("  Static (.data + .bss): "), hal::memStaticBytes());
+    if (hal::memSecondaryStaticBytes() > 0) {
+        printBytes(F("  Static (DMAMEM): "), hal::memSecondaryStaticBytes());
+    }
+#if HAL_HAS_STACK_RANGE
+    // sbrk never gives memory back below a live block, so its top is close to the peak
+    printBytes(F("  Heap (sbrk top): "), hal::memHeapBytes());
+
+    // Paint still intact above the heap: never reached by the stack. Heap blocks
+    // freed since painting count as stack - the figure errs on the high side.
+    uintptr_t from = hal::memStackLimit();
+    if (from < paintedFrom) from = paintedFrom;
+    uintptr_t untouched = from;
+    while (untouched < paintedTo && *(volatile uint8_t*)untouched == PAINT_BYTE) untouched++;
+    if (paintedTo > paintedFrom) {
+        printBytes(F("  Stack peak (painted): "), hal::memStackTop() - untouched);
+        printBytes(F("  Never used: "), untouched - from);
+    }
+#else
+    printBytes(F("  Heap in use: "), hal::memHeapBytes());
+    if (hal::memHeapPeakBytes() > 0) printBytes(F("  Heap peak: "), hal::memHeapPeakBytes());
+    if (hal::memTaskStackUnused() > 0) printBytes(F("  Loop task stack never used: "), hal::memTaskStackUnused());
+#endif
+#else
+    msg.control.println(F("  (heap/stack figures not available on this platform)"));
+#endif
+
+    printStaticPoolStatus();
+
+    msg.control.println(F("  Static tables:"));
+    if (numEntries == 0) msg.control.println(F("    (none noted)"));
+    char line[16];
+    for (uint8_t i = 0; i < numEntries; i++) {
+        snprintf(line, sizeof(line), "    %6lu  ", (unsigned long)entries[i].bytes);
+        msg.control.print(line);
+        msg.control.println(entries[i].name);
+    }
+#if HAL_HAS_PLACEMENT
+    msg.control.println(F("  Placement:"));
+    if (hal::extRamBytes() > 0) printBytes(F("    PSRAM fitted: "), hal::extRamBytes());
+    for (uint8_t i = 0; i < numPlacements; i++) {
+        snprintf(line, sizeof(line), "    %-6s  ", hal::placementRegion(placements[i].addr));
+        msg.control.print(line);
+        msg.control.println(placements[i].name);
+    }
+#endif
+    msg.control.println(F("  Every symbol: tools/memory_report.py (linker map)"));
+    msg.control.println();
+}
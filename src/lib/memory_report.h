@@ -0,0 +1,64 @@
+/*
+ * memory_report.h - RAM usage report (SYSTEM MEMORY)
+ *
+ * Where the RAM goes, at runtime:
+ *
+ *   - Static data (.data + .bss) in total, and the tables of the subsystems
+ *     that note themselves here - the ones sized by build flags (inputs[],
+ *     the CAN frame cache, scan results, the PID index, log buffers, ...)
+ *   - Heap in use / high-water mark
+ *   - Stack high-water mark
+ *   - Where the hot paths and big buffers landed (Teensy 4.x: ITCM, DTCM,
+ *     OCRAM, FLASH or EXTMEM - hal/hal_placement.h), for the ones noted
+ *
+ * The stack high-water mark comes from stack painting: initMemoryReport()
+ * fills the free RAM between the heap and the stack with a pattern, first
+ * thing in setup(); the report counts how much of it above the heap is still
+ * intact. On AVR and Teensy the heap figure is the sbrk top, which stays at
+ * its highest live block. ESP32 has no shared region: there the heap
+ * allocator and FreeRTOS keep both marks.
+ *
+ * For every symbol, grouped by subsystem, see tools/memory_report.py, which
+ * reads the linker map of a build and checks it against the env's
+ * custom_ram_budget (scripts/memory_budget.py).
+ *
+ * Usage:
+ *   initMemoryReport();                                      // Top of setup()
+ *   noteStaticMemory(F("CAN frame cache"), sizeof(canFrameCache));  // Module init
+ *   notePlacement(F("updateCANCache()"), (const void*)updateCANCache);
+ *   printMemoryReport();                                     // Record a function or buffer whose memory region the report shows (no-op without HAL_HAS_PLACEMENT)
+void notePlacement(const __FlashStringHelper* name, const void* addr);
+
+// SYSTEM MEMORY
+ *
+ * Build Flags:
+ *   -D MEMORY_REPORT_MAX_ENTRIES=n     - Subsystems noteStaticMemory() keeps (default 12)
+ *   -D MEMORY_REPORT_MAX_PLACEMENTS=n  - Addresses notePlacement() keeps (default 10)
+ */
+
+#ifndef MEMORY_REPORT_H
+#define MEMORY_REPORT_H
+
+#include <Arduino.h>
+
+#ifndef MEMORY_REPORT_MAX_ENTRIES
+#define MEMORY_REPORT_MAX_ENTRIES 12
+#endif
+
+#ifndef MEMORY_REPORT_MAX_PLACEMENTS
+#define MEMORY_REPORT_MAX_PLACEMENTS 10
+#endif
+
+// Paint the free RAM between heap and stack (first thing in setup())
+void initMemoryReport();
+
+// Record a subsystem's static tables (again with the same name: replaced)
+void noteStaticMemory(const __FlashStringHelper* name, size_t bytes);
+
+// Record a function or buffer whose memory region the report shows (no-op without HAL_HAS_PLACEMENT)
+void notePlacement(const __FlashStringHelper* name, const void* addr);
+
+// SYSTEM MEMORY
+void printMemoryReport();
+
+#endif // MEMORY_REPORT_H
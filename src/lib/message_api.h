@@ -23,8 +23,17 @@
  *   LOG_ERROR(TAG_SD, "Mount failed");
  *   LOG_INFO(TAG_ADC, "ADC configured: %d-bit resolution", bits);
  *
+ * The level methods check the tag's compile-time floor first (log_filter.h):
+ * a call above it compiles to nothing, format string included. What remains
+ * is one inline bit test of the runtime filter before any formatting.
+ *
  * Build Flags:
  *   -D DISABLE_DEBUG_MESSAGES - Compile out all debug messages (saves flash/RAM)
+ *   -D LOG_MIN_LEVEL=<level>, -D LOG_MIN_LEVEL_<TAG>=<level>
+ *                             - Compile out messages above a level (log_filter.h)
+ *   -D ENABLE_DEFERRED_LOG    - Debug plane messages as binary records, formatted
+ *                               on the host (log_deferred.h)
+ *   -D ENABLE_DUAL_CORE       - Writes hold the output mutex (dual_core.h)
  */
 
 #ifndef MESSAGE_API_H
@@ -33,14 +42,41 @@
 #include "message_router.h"
 #include "log_filter.h"
 #include "log_tags.h"
+#include "log_deferred.h"
+#include "dual_core.h"
 #include <Arduino.h>
 #include <stdarg.h>  // For variadic functions
 
 // Print stream wrapper that routes to a specific message plane
+// Every overload formats to bytes and hands them to emit(), which writes them
+// to the plane's transports with the plane's TX overflow policy.
 class MessageStream {
 private:
     MessagePlane plane;
 
+    // Write the same bytes to each of the plane's resolved targets (primary,
+    // then subscribers); returns what the first took
+    size_t emit(const uint8_t* data, size_t len) {
+#ifdef ENABLE_DUAL_CORE
+        DualCoreOutputGuard guard;  // Both cores write to the transports
+#endif
+        if (plane == PLANE_CONTROL && router.captureControl(data, len)) return len;  // Script running
+        const PlaneTargets& targets = router.getTargets(plane);
+        if (targets.count == 0) return 0;
+        TxOverflowPolicy policy = router.getTxPolicy(plane);
+        size_t written = 0;
+        for (uint8_t i = 0; i < targets.count; i++) {
+            if (plane == PLANE_DATA && !router.admitData(targets.ids[i], len)) continue;  // Profile
+            size_t n = targets.list[i]->send(data, len, policy, (TxLane)plane);
+            if (i == 0) written = n;
+        }
+        return written;
+    }
+
+    size_t emitLineEnd() {
+        return emit((const uint8_t*)"\r\n", 2);
+    }
+
 public:
     MessageStream(MessagePlane p) : plane(p) {}
 
@@ -48,66 +84,26 @@ public:
 
     size_t print(const char* str) {
         if (!str) return 0;
-        TransportInterface* t = router.getTransport(plane, true);
-        if (!t || !t->isConnected()) return 0;
-        size_t n = t->print(str);
-
-        // Multi-cast to secondary if configured
-        TransportInterface* t2 = router.getTransport(plane, false);
-        if (t2 && t2->isConnected()) {
-            t2->print(str);
-        }
-
-        return n;
+        return emit((const uint8_t*)str, strlen(str));
     }
 
     size_t println(const char* str) {
         if (!str) return 0;
-        TransportInterface* t = router.getTransport(plane, true);
-        if (!t || !t->isConnected()) return 0;
-        size_t n = t->println(str);
-
-        // Multi-cast to secondary if configured
-        TransportInterface* t2 = router.getTransport(plane, false);
-        if (t2 && t2->isConnected()) {
-            t2->println(str);
-        }
-
-        return n;
+        return print(str) + emitLineEnd();
     }
 
     size_t println() {
-        return println("");
+        return emitLineEnd();
     }
 
     // ========== Character Output ==========
 
     size_t print(char c) {
-        TransportInterface* t = router.getTransport(plane, true);
-        if (!t || !t->isConnected()) return 0;
-        size_t written = t->print(c);
-
-        // Multi-cast to secondary if configured
-        TransportInterface* t2 = router.getTransport(plane, false);
-        if (t2 && t2->isConnected()) {
-            t2->print(c);
-        }
-
-        return written;
+        return emit((const uint8_t*)&c, 1);
     }
 
     size_t println(char c) {
-        TransportInterface* t = router.getTransport(plane, true);
-        if (!t || !t->isConnected()) return 0;
-        size_t written = t->println(c);
-
-        // Multi-cast to secondary if configured
-        TransportInterface* t2 = router.getTransport(plane, false);
-        if (t2 && t2->isConnected()) {
-            t2->println(c);
-        }
-
-        return written;
+        return print(c) + emitLineEnd();
     }
 
     // ========== Numeric Output ==========
@@ -123,31 +119,13 @@ public:
     }
 
     size_t print(int n) {
-        TransportInterface* t = router.getTransport(plane, true);
-        if (!t || !t->isConnected()) return 0;
-        size_t written = t->print(n);
-
-        // Multi-cast to secondary if configured
-        TransportInterface* t2 = router.getTransport(plane, false);
-        if (t2 && t2->isConnected()) {
-            t2->print(n);
-        }
-
-        return written;
+        char buf[12];
+        itoa(n, buf, 10);
+        return print(buf);
     }
 
     size_t println(int n) {
-        TransportInterface* t = router.getTransport(plane, true);
-        if (!t || !t->isConnected()) return 0;
-        size_t written = t->println(n);
-
-        // Multi-cast to secondary if configured
-        TransportInterface* t2 = router.getTransport(plane, false);
-        if (t2 && t2->isConnected()) {
-            t2->println(n);
-        }
-
-        return written;
+        return print(n) + emitLineEnd();
     }
 
     size_t print(unsigned int n) {
@@ -226,17 +204,9 @@ public:
     // ========== Float Output ==========
 
     size_t print(float f, int digits = 2) {
-        TransportInterface* t = router.getTransport(plane, true);
-        if (!t || !t->isConnected()) return 0;
-        size_t written = t->print(f, digits);
-
-        // Multi-cast to secondary if configured
-        TransportInterface* t2 = router.getTransport(plane, false);
-        if (t2 && t2->isConnected()) {
-            t2->print(f, digits);
-        }
-
-        return written;
+        char buf[FLOAT_FORMAT_SIZE];
+        formatFixed(buf, f, digits < 0 ? 0 : digits);
+        return print(buf);
     }
 
     size_t println(float f, int digits = 2) {
@@ -253,18 +223,23 @@ public:
 
     // ========== Flash String Support ==========
 
+    // Copied out of flash in chunks, one emit() per chunk
     size_t print(const __FlashStringHelper* str) {
         if (!str) return 0;
-        TransportInterface* t = router.getTransport(plane, true);
-        if (!t || !t->isConnected()) return 0;
-        size_t written = t->print(str);
-
-        // Multi-cast to secondary if configured
-        TransportInterface* t2 = router.getTransport(plane, false);
-        if (t2 && t2->isConnected()) {
-            t2->print(str);
-        }
-
+        const char* p = (const char*)str;
+        char chunk[32];
+        size_t written = 0;
+        size_t n;
+        do {
+            n = 0;
+            while (n < sizeof(chunk) && (chunk[n] = pgm_read_byte(p + n)) != 0) {
+                n++;
+            }
+            if (n > 0) {
+                written += emit((const uint8_t*)chunk, n);
+            }
+            p += n;
+        } while (n == sizeof(chunk));
         return written;
     }
 
@@ -278,18 +253,7 @@ public:
 
     size_t write(const uint8_t* data, size_t len) {
         if (!data || len == 0) return 0;
-
-        TransportInterface* t = router.getTransport(plane, true);
-        if (!t || !t->isConnected()) return 0;
-        size_t written = t->write(data, len);
-
-        // Multi-cast to secondary if configured
-        TransportInterface* t2 = router.getTransport(plane, false);
-        if (t2 && t2->isConnected()) {
-            t2->write(data, len);
-        }
-
-        return written;
+        return emit(data, len);
     }
 
     size_t write(uint8_t c) {
@@ -298,17 +262,43 @@ public:
 
     // ========== Level-Based Logging (Printf-style) ==========
 
-    // Printf-style logging methods with log levels and tags
+    // Printf-style logging methods with log levels and tags (TAG_* constants)
     // Note: Do NOT use F() macro - format strings must be in RAM for vsnprintf
     // These methods check the log filter before formatting/outputting
-    size_t error(const char* tag, const char* fmt, ...);
-    size_t warn(const char* tag, const char* fmt, ...);
-    size_t info(const char* tag, const char* fmt, ...);
-    size_t debug(const char* tag, const char* fmt, ...);
+    template <uint8_t Tag, typename... Args>
+    size_t error(LogTagId<Tag>, const char* fmt, Args... args) {
+        return logAt<LOG_LEVEL_ERROR, Tag>(fmt, args...);
+    }
+
+    template <uint8_t Tag, typename... Args>
+    size_t warn(LogTagId<Tag>, const char* fmt, Args... args) {
+        return logAt<LOG_LEVEL_WARN, Tag>(fmt, args...);
+    }
+
+    template <uint8_t Tag, typename... Args>
+    size_t info(LogTagId<Tag>, const char* fmt, Args... args) {
+        return logAt<LOG_LEVEL_INFO, Tag>(fmt, args...);
+    }
+
+    template <uint8_t Tag, typename... Args>
+    size_t debug(LogTagId<Tag>, const char* fmt, Args... args) {
+        return logAt<LOG_LEVEL_DEBUG, Tag>(fmt, args...);
+    }
 
 private:
-    // Helper method to format and output with level/tag prefix
-    size_t logWithLevel(LogLevel level, const char* tag, const char* msg);
+    // Compile-time floor, then the runtime filter, then (out of line) format
+    template <uint8_t Level, uint8_t Tag, typename... Args>
+    inline __attribute__((always_inline)) size_t logAt(const char* fmt, Args... args) {
+        if (Level > logCompiledLevel(Tag)) return 0;
+        if (!router.getLogFilter().passes(plane, Level, Tag)) return 0;
+#ifdef ENABLE_DEFERRED_LOG
+        if (plane == PLANE_DEBUG) return deferredLog(Level, Tag, fmt, args...);
+#endif
+        return logFormatted((LogLevel)Level, Tag, fmt, args...);
+    }
+
+    // Format and output with level/tag prefix
+    size_t logFormatted(LogLevel level, uint8_t tagId, const char* fmt, ...);
 };
 
 // Stub class for disabled debug messages (all methods compile to no-ops)
@@ -347,10 +337,14 @@ public:
     inline size_t write(uint8_t c) { (void)c; return 0; }
 
     // Level-based logging stub methods (compile to no-ops)
-    inline size_t error(const char* tag, const char* fmt, ...) { (void)tag; (void)fmt; return 0; }
-    inline size_t warn(const char* tag, const char* fmt, ...) { (void)tag; (void)fmt; return 0; }
-    inline size_t info(const char* tag, const char* fmt, ...) { (void)tag; (void)fmt; return 0; }
-    inline size_t debug(const char* tag, const char* fmt, ...) { (void)tag; (void)fmt; return 0; }
+    template <typename Tag, typename... Args>
+    inline size_t error(Tag, const char* fmt, Args...) { (void)fmt; return 0; }
+    template <typename Tag, typename... Args>
+    inline size_t warn(Tag, const char* fmt, Args...) { (void)fmt; return 0; }
+    template <typename Tag, typename... Args>
+    inline size_t info(Tag, const char* fmt, Args...) { (void)fmt; return 0; }
+    template <typename Tag, typename... Args>
+    inline size_t debug(Tag, const char* fmt, Args...) { (void)fmt; return 0; }
 };
 #endif
 
@@ -4,24 +4,39 @@
 
 #include "message_router.h"
 #include "message_api.h"
+#include "log_deferred.h"
 #include "system_config.h"
 #include "serial_manager.h"
+#include "response_stream.h"
 #include "../inputs/serial_config.h"
 #include <string.h>
 
+static_assert(sizeof(((SystemConfig*)0)->dataProfile.rate) == (NUM_TRANSPORTS - 1) * sizeof(uint16_t),
+              "SystemConfig.dataProfile holds one profile per TransportID");
+
 // Global router instance
 MessageRouter router;
 
-MessageRouter::MessageRouter() : activeControlTransport(nullptr) {
+MessageRouter::MessageRouter()
+    : activeControlTransport(nullptr), lineOwner(nullptr), lineOwnerMs(0), targetsDirty(true),
+      dataReserved(0), captureBuf(nullptr), captureSize(0), captureLen(0) {
     // Initialize transport registry to NULL
     for (int i = 0; i < NUM_TRANSPORTS; i++) {
         transports[i] = nullptr;
+        lastState[i] = TRANSPORT_DISCONNECTED;
+#if ROUTER_DATA_PROFILES
+        profiles[i] = {0, DATA_STREAMS_ALL, 0, 0, 0, 0};
+#endif
     }
+#if ROUTER_DATA_PROFILES
+    dataStream = DATA_STREAM_TEXT;
+#endif
 
     // Initialize plane mappings to USB Serial (default)
     for (int i = 0; i < NUM_PLANES; i++) {
         primaryTransport[i] = TRANSPORT_USB_SERIAL;
-        secondaryTransport[i] = TRANSPORT_NONE;
+        subscribers[i] = 0;
+        txPolicy[i] = defaultTxPolicy((MessagePlane)i);
     }
 }
 
@@ -33,13 +48,17 @@ void MessageRouter::begin() {
     for (int i = 0; i < NUM_TRANSPORTS; i++) {
         if (transports[i] != nullptr) {
             transports[i]->begin();
+            lastState[i] = transports[i]->getState();
         }
     }
+    targetsDirty = true;
 }
 
 void MessageRouter::registerTransport(TransportID id, TransportInterface* transport) {
     if (id > 0 && id < NUM_TRANSPORTS && transport != nullptr) {
         transports[id] = transport;
+        lastState[id] = transport->getState();
+        targetsDirty = true;
     }
 }
 
@@ -49,9 +68,23 @@ void MessageRouter::loadConfig() {
     primaryTransport[PLANE_DATA] = systemConfig.router.data_primary;
     primaryTransport[PLANE_DEBUG] = systemConfig.router.debug_primary;
 
-    secondaryTransport[PLANE_CONTROL] = systemConfig.router.control_secondary;
-    secondaryTransport[PLANE_DATA] = systemConfig.router.data_secondary;
-    secondaryTransport[PLANE_DEBUG] = systemConfig.router.debug_secondary;
+    // Subscriber bits past the last TransportID are ignored
+    for (int i = 0; i < NUM_PLANES; i++) {
+        subscribers[i] = systemConfig.router.subscribers[i] & ((1u << NUM_TRANSPORTS) - 2);
+    }
+    targetsDirty = true;
+
+    // Data plane profiles
+    for (int i = 1; i < NUM_TRANSPORTS; i++) {
+        setDataProfile((TransportID)i, systemConfig.dataProfile.rate[i - 1], systemConfig.dataProfile.streams[i - 1]);
+    }
+
+    // TX overflow policies (invalid or disallowed values fall back to the default)
+    for (int i = 0; i < NUM_PLANES; i++) {
+        if (!setTxPolicy((MessagePlane)i, (TxOverflowPolicy)systemConfig.router.tx_policy[i])) {
+            setTxPolicy((MessagePlane)i, TX_POLICY_DEFAULT);
+        }
+    }
 
     // Load log filter configuration from SystemConfig.logFilter
     logFilter.setLevel(PLANE_CONTROL, (LogLevel)systemConfig.logFilter.control_level);
@@ -63,11 +96,23 @@ void MessageRouter::loadConfig() {
 void MessageRouter::syncConfig() {
     // Copy router state to SystemConfig.router (does NOT save to EEPROM)
     systemConfig.router.control_primary = primaryTransport[PLANE_CONTROL];
-    systemConfig.router.control_secondary = secondaryTransport[PLANE_CONTROL];
     systemConfig.router.data_primary = primaryTransport[PLANE_DATA];
-    systemConfig.router.data_secondary = secondaryTransport[PLANE_DATA];
     systemConfig.router.debug_primary = primaryTransport[PLANE_DEBUG];
-    systemConfig.router.debug_secondary = secondaryTransport[PLANE_DEBUG];
+    for (int i = 0; i < NUM_PLANES; i++) {
+        systemConfig.router.subscribers[i] = subscribers[i];
+    }
+#if ROUTER_DATA_PROFILES
+    for (int i = 1; i < NUM_TRANSPORTS; i++) {
+        systemConfig.dataProfile.rate[i - 1] = profiles[i].rate;
+        systemConfig.dataProfile.streams[i - 1] = profiles[i].streams;
+    }
+#endif
+
+    // Plane defaults are stored as 0 so a changed default applies to saved configs
+    for (int i = 0; i < NUM_PLANES; i++) {
+        systemConfig.router.tx_policy[i] =
+            (txPolicy[i] == defaultTxPolicy((MessagePlane)i)) ? TX_POLICY_DEFAULT : txPolicy[i];
+    }
 
     // Copy log filter state to SystemConfig.logFilter
     systemConfig.logFilter.control_level = logFilter.getLevel(PLANE_CONTROL);
@@ -82,10 +127,10 @@ void MessageRouter::saveConfig() {
     saveSystemConfig();
 }
 
-TransportInterface* MessageRouter::getTransport(MessagePlane plane, bool primary) {
+TransportInterface* MessageRouter::getTransport(MessagePlane plane) {
     if (plane >= NUM_PLANES) return nullptr;
 
-    uint8_t transportId = primary ? primaryTransport[plane] : secondaryTransport[plane];
+    uint8_t transportId = primaryTransport[plane];
 
     if (transportId == TRANSPORT_NONE || transportId >= NUM_TRANSPORTS) {
         return nullptr;
@@ -94,112 +139,386 @@ TransportInterface* MessageRouter::getTransport(MessagePlane plane, bool primary
     return transports[transportId];
 }
 
-void MessageRouter::routeMessage(MessagePlane plane, const char* message) {
-    if (!message) return;
+void MessageRouter::resolveTargets() {
+    for (int i = 0; i < NUM_PLANES; i++) {
+        PlaneTargets& targets = planeTargets[i];
+        targets.count = 0;
+
+        // Primary first (it answers commands), then subscribers in ID order
+        TransportInterface* primary = getTransport((MessagePlane)i);
+        if (primary && primary->isConnected()) {
+            targets.ids[targets.count] = primaryTransport[i];
+            targets.list[targets.count++] = primary;
+        }
 
-    // Route to primary transport
-    TransportInterface* primary = getTransport(plane, true);
-    if (primary && primary->isConnected()) {
-        primary->print(message);
+        for (uint8_t tid = 1; tid < NUM_TRANSPORTS && targets.count < ROUTER_MAX_TARGETS; tid++) {
+            if (!(subscribers[i] & (1u << tid))) continue;
+            TransportInterface* t = transports[tid];
+            if (t && t != primary && t->isConnected()) {
+                targets.ids[targets.count] = tid;
+                targets.list[targets.count++] = t;
+            }
+        }
     }
+    targetsDirty = false;
+}
 
-    // Route to secondary transport (multi-cast)
-    TransportInterface* secondary = getTransport(plane, false);
-    if (secondary && secondary->isConnected()) {
-        secondary->print(message);
+void MessageRouter::routeMessage(MessagePlane plane, const char* message) {
+    if (!message) return;
+
+    const PlaneTargets& targets = getTargets(plane);
+    size_t len = strlen(message);
+    for (uint8_t i = 0; i < targets.count; i++) {
+        targets.list[i]->send((const uint8_t*)message, len);
     }
 }
 
 void MessageRouter::routeMessage(MessagePlane plane, const uint8_t* data, size_t len) {
     if (!data || len == 0) return;
 
-    // Route to primary transport
-    TransportInterface* primary = getTransport(plane, true);
-    if (primary && primary->isConnected() && primary->supportsBinary()) {
-        primary->write(data, len);
+    const PlaneTargets& targets = getTargets(plane);
+    for (uint8_t i = 0; i < targets.count; i++) {
+        if (!targets.list[i]->supportsBinary()) continue;
+        if (plane == PLANE_DATA && !admitData(targets.ids[i], len)) continue;
+        targets.list[i]->send(data, len);
+    }
+}
+
+#if ROUTER_DATA_PROFILES
+// Token bucket: refill at rate (bytes/s x ms elapsed = milli-bytes) up to
+// DATA_PROFILE_BURST_MS of it; a write goes while tokens are left
+bool MessageRouter::takeTokens(DataProfile& p, size_t len) {
+    uint32_t now = millis();
+    uint32_t elapsed = now - p.refillMs;
+    if (elapsed > 30000) elapsed = 30000;  // Keeps rate x elapsed inside int32
+    p.refillMs = now;
+
+    int32_t depth = (int32_t)p.rate * DATA_PROFILE_BURST_MS;
+    p.tokens += (int32_t)(p.rate * elapsed);
+    if (p.tokens > depth) p.tokens = depth;
+
+    if (p.tokens <= 0) {
+        p.shapedWrites++;
+        p.shapedBytes += len;
+        return false;
+    }
+    p.tokens -= (int32_t)len * 1000;
+    return true;
+}
+#endif
+
+bool MessageRouter::setDataProfile(TransportID transportId, uint16_t rate, uint8_t streams) {
+    if (transportId == TRANSPORT_NONE || transportId >= NUM_TRANSPORTS) return false;
+#if ROUTER_DATA_PROFILES
+    DataProfile& p = profiles[transportId];
+    p.rate = rate;
+    p.streams = streams & DATA_STREAMS_ALL;
+    p.tokens = (int32_t)rate * DATA_PROFILE_BURST_MS;  // Start with a full bucket
+    p.refillMs = millis();
+    return true;
+#else
+    return rate == 0 && (streams & DATA_STREAMS_ALL) == DATA_STREAMS_ALL;  // Only the default
+#endif
+}
+
+const DataProfile* MessageRouter::getDataProfile(TransportID transportId) const {
+#if ROUTER_DATA_PROFILES
+    if (transportId == TRANSPORT_NONE || transportId >= NUM_TRANSPORTS) return nullptr;
+    return &profiles[transportId];
+#else
+    (void)transportId;
+    return nullptr;
+#endif
+}
+
+void MessageRouter::printDataProfile(TransportID transportId) {
+    const DataProfile* p = getDataProfile(transportId);
+    if (!p) return;
+
+    msg.control.print(transports[transportId] ? transports[transportId]->getName() : "-");
+    msg.control.print(F(": "));
+    if (p->rate) {
+        msg.control.print(p->rate);
+        msg.control.print(F(" B/s"));
+    } else {
+        msg.control.print(F("unshaped"));
+    }
+    msg.control.print(F(", streams"));
+    if (p->streams == 0) msg.control.print(F(" NONE"));
+    for (uint8_t s = 0; s < NUM_DATA_STREAMS; s++) {
+        if (!(p->streams & (1u << s))) continue;
+        msg.control.print(' ');
+        msg.control.print(getDataStreamName((DataStream)s));
+    }
+}
+
+const char* MessageRouter::getDataStreamName(DataStream stream) {
+    switch (stream) {
+        case DATA_STREAM_REALDASH: return "REALDASH";
+        case DATA_STREAM_SERIAL:   return "SERIAL";
+        default:                   return "TEXT";
+    }
+}
+
+TxOverflowPolicy MessageRouter::defaultTxPolicy(MessagePlane plane) {
+    return (plane == PLANE_CONTROL) ? TX_BLOCK : TX_DROP_NEWEST;
+}
+
+const char* MessageRouter::getTxPolicyName(TxOverflowPolicy policy) {
+    switch (policy) {
+        case TX_DROP_OLDEST: return "DROP_OLDEST";
+        case TX_DROP_NEWEST: return "DROP_NEWEST";
+        case TX_BLOCK:       return "BLOCK";
+        default:             return "DEFAULT";
     }
+}
 
-    // Route to secondary transport (multi-cast)
-    TransportInterface* secondary = getTransport(plane, false);
-    if (secondary && secondary->isConnected() && secondary->supportsBinary()) {
-        secondary->write(data, len);
+bool MessageRouter::setTxPolicy(MessagePlane plane, TxOverflowPolicy policy) {
+    if (plane >= NUM_PLANES) return false;
+    if (policy == TX_POLICY_DEFAULT) {
+        policy = defaultTxPolicy(plane);
+    }
+    if (policy > TX_BLOCK) return false;
+    if (policy == TX_BLOCK && plane != PLANE_CONTROL) {
+        return false;  // Data and debug output must never stall the loop
     }
+    txPolicy[plane] = policy;
+    return true;
 }
 
 void MessageRouter::setActiveControlTransport(TransportInterface* transport) {
     activeControlTransport = transport;
 }
 
-bool MessageRouter::setTransport(MessagePlane plane, TransportID transportId, bool secondary) {
+bool MessageRouter::controlTxReady(size_t bytes) {
+    const PlaneTargets& ctrl = getTargets(PLANE_CONTROL);
+    for (uint8_t i = 0; i < ctrl.count; i++) {
+        const TxStats* stats = ctrl.list[i]->getControlTxStats();
+        size_t need = (stats && stats->capacity < bytes) ? stats->capacity : bytes;
+        if (ctrl.list[i]->controlTxSpace() < need) return false;
+    }
+    return true;
+}
+
+TransportID MessageRouter::findTransportId(const TransportInterface* transport) const {
+    if (transport == nullptr) return TRANSPORT_NONE;
+    for (uint8_t i = 1; i < NUM_TRANSPORTS; i++) {
+        if (transports[i] == transport) return (TransportID)i;
+    }
+    return TRANSPORT_NONE;
+}
+
+bool MessageRouter::isAvailable(TransportID transportId) const {
+    if (transportId == TRANSPORT_NONE || transportId >= NUM_TRANSPORTS) return false;
+    if (transports[transportId] == nullptr) {
+        return false;  // Transport not registered
+    }
+
+    // For hardware serial transports, verify the port is enabled
+    if (transportId >= TRANSPORT_SERIAL1 && transportId <= TRANSPORT_SERIAL8) {
+        uint8_t port_id = transportId - TRANSPORT_SERIAL1 + 1;
+        if (!isSerialPortActive(port_id)) {
+            return false;  // Serial port not enabled (use BUS SERIAL <n> ENABLE first)
+        }
+    }
+    return true;
+}
+
+bool MessageRouter::setTransport(MessagePlane plane, TransportID transportId) {
     if (plane >= NUM_PLANES) return false;
     if (transportId >= NUM_TRANSPORTS) return false;
 
     // Check if transport exists and is available
-    if (transportId != TRANSPORT_NONE) {
-        if (transports[transportId] == nullptr) {
-            return false;  // Transport not registered
-        }
+    if (transportId != TRANSPORT_NONE && !isAvailable(transportId)) return false;
 
-        // For hardware serial transports, verify the port is enabled
-        if (transportId >= TRANSPORT_SERIAL1 && transportId <= TRANSPORT_SERIAL8) {
-            uint8_t port_id = transportId - TRANSPORT_SERIAL1 + 1;
-            if (!isSerialPortActive(port_id)) {
-                return false;  // Serial port not enabled (use BUS SERIAL <n> ENABLE first)
-            }
-        }
-    }
+    primaryTransport[plane] = transportId;
+    targetsDirty = true;
+
+    return true;
+}
+
+bool MessageRouter::addSubscriber(MessagePlane plane, TransportID transportId) {
+    if (plane >= NUM_PLANES || !isAvailable(transportId)) return false;
+    subscribers[plane] |= (1u << transportId);
+    targetsDirty = true;
+    return true;
+}
+
+bool MessageRouter::removeSubscriber(MessagePlane plane, TransportID transportId) {
+    if (plane >= NUM_PLANES || transportId == TRANSPORT_NONE || transportId >= NUM_TRANSPORTS) return false;
+    if (!(subscribers[plane] & (1u << transportId))) return false;
+    subscribers[plane] &= ~(1u << transportId);
+    targetsDirty = true;
+    return true;
+}
 
-    // Update mapping
-    if (secondary) {
-        secondaryTransport[plane] = transportId;
+void MessageRouter::printPlaneRoute(MessagePlane plane) {
+    const char* planeNames[] = {"CONTROL", "DATA", "DEBUG"};
+    const char* transportNames[] = {"NONE", "USB_SERIAL", "SERIAL1", "SERIAL2", "SERIAL3",
+                                    "SERIAL4", "SERIAL5", "SERIAL6", "SERIAL7", "SERIAL8", "ESP32_BT",
+                                    "BLE_DATA", "WIFI", "WIFI_UDP"};
+
+    msg.control.print(planeNames[plane]);
+    msg.control.print(F(" → "));
+
+    uint8_t tid = primaryTransport[plane];
+    if (tid < NUM_TRANSPORTS) {
+        msg.control.print(transportNames[tid]);
     } else {
-        primaryTransport[plane] = transportId;
+        msg.control.print(F("UNKNOWN"));
     }
 
-    return true;
+    for (tid = 1; tid < NUM_TRANSPORTS; tid++) {
+        if (tid == primaryTransport[plane] || !(subscribers[plane] & (1u << tid))) continue;
+        msg.control.print(F(" + "));
+        msg.control.print(transportNames[tid]);
+    }
 }
 
 void MessageRouter::printTransportStatus() {
-    TransportInterface* ctrl = getTransport(PLANE_CONTROL, true);
+    TransportInterface* ctrl = getTransport(PLANE_CONTROL);
     if (!ctrl) return;
 
     msg.control.println(F("=== Transport Routing ==="));
 
-    const char* planeNames[] = {"CONTROL", "DATA", "DEBUG"};
-    const char* transportNames[] = {"NONE", "USB_SERIAL", "SERIAL1", "SERIAL2", "SERIAL3",
-                                    "SERIAL4", "SERIAL5", "SERIAL6", "SERIAL7", "SERIAL8", "ESP32_BT"};
-
     for (int i = 0; i < NUM_PLANES; i++) {
-        msg.control.print(planeNames[i]);
-        msg.control.print(F(" → "));
+        printPlaneRoute((MessagePlane)i);
+        msg.control.print(F("  (overflow: "));
+        msg.control.print(getTxPolicyName(txPolicy[i]));
+        msg.control.println(F(")"));
+    }
 
-        uint8_t tid = primaryTransport[i];
-        if (tid < NUM_TRANSPORTS) {
-            msg.control.print(transportNames[tid]);
-        } else {
-            msg.control.print(F("UNKNOWN"));
+    // Traffic since boot or TRANSPORT RESET, with the average rate out
+    bool header = false;
+    uint32_t now = millis();
+    for (int i = 1; i < NUM_TRANSPORTS; i++) {
+        if (!transports[i]) continue;
+        const TransportCounters& c = transports[i]->getCounters();
+        if (c.writes == 0 && c.bytesIn == 0) continue;
+
+        if (!header) {
+            msg.control.println();
+            msg.control.println(F("Traffic:"));
+            header = true;
         }
+        uint32_t seconds = (now - c.sinceMs) / 1000;
+        msg.control.print(F("  "));
+        msg.control.print(transports[i]->getName());
+        msg.control.print(F(": out "));
+        msg.control.print(c.bytesOut);
+        msg.control.print(F(" B ("));
+        msg.control.print(seconds > 0 ? c.bytesOut / seconds : c.bytesOut);
+        msg.control.print(F(" B/s, "));
+        msg.control.print(c.writes);
+        msg.control.print(F(" writes, "));
+        msg.control.print(c.shortWrites);
+        msg.control.print(F(" short), in "));
+        msg.control.print(c.bytesIn);
+        msg.control.print(F(" B over "));
+        msg.control.print(seconds);
+        msg.control.println(F(" s"));
+    }
 
-        if (secondaryTransport[i] != TRANSPORT_NONE) {
-            msg.control.print(F(" + "));
-            tid = secondaryTransport[i];
-            if (tid < NUM_TRANSPORTS) {
-                msg.control.print(transportNames[tid]);
-            }
+#if ROUTER_DATA_PROFILES
+    // Data plane profiles other than the default (all streams, unshaped)
+    header = false;
+    for (int i = 1; i < NUM_TRANSPORTS; i++) {
+        const DataProfile& p = profiles[i];
+        if (p.rate == 0 && p.streams == DATA_STREAMS_ALL) continue;
+
+        if (!header) {
+            msg.control.println();
+            msg.control.println(F("Data profiles:"));
+            header = true;
         }
+        msg.control.print(F("  "));
+        printDataProfile((TransportID)i);
+        msg.control.print(F(" (shaped "));
+        msg.control.print(p.shapedWrites);
+        msg.control.print(F(" writes, "));
+        msg.control.print(p.shapedBytes);
+        msg.control.println(F(" B)"));
+    }
+#endif
 
-        msg.control.println();
+    // TX ring counters of the buffered transports
+    header = false;
+    for (int i = 1; i < NUM_TRANSPORTS; i++) {
+        const TxStats* stats = transports[i] ? transports[i]->getTxStats() : nullptr;
+        if (!stats || stats->bytesSent + stats->bytesDropped == 0) continue;
+
+        if (!header) {
+            msg.control.println();
+            msg.control.println(F("TX buffers:"));
+            header = true;
+        }
+        msg.control.print(F("  "));
+        msg.control.print(transports[i]->getName());
+        msg.control.print(F(": "));
+        msg.control.print(stats->bytesSent);
+        msg.control.print(F(" sent, "));
+        msg.control.print(stats->bytesDropped);
+        msg.control.print(F(" dropped ("));
+        msg.control.print(stats->writesDropped);
+        msg.control.print(F(" writes), "));
+        msg.control.print(stats->blockedWrites);
+        msg.control.print(F(" blocked, peak "));
+        msg.control.print(stats->peakFill);
+        msg.control.print(F("/"));
+        msg.control.println(stats->capacity);
+    }
+
+    // Control lanes of the transports that keep one apart from the bulk ring
+    header = false;
+    for (int i = 1; i < NUM_TRANSPORTS; i++) {
+        if (!transports[i]) continue;
+        const TxStats* stats = transports[i]->getControlTxStats();
+        if (!stats || stats == transports[i]->getTxStats()) continue;
+        if (stats->bytesSent + stats->bytesDropped == 0 && !transports[i]->isFramed()) continue;
+
+        if (!header) {
+            msg.control.println();
+            msg.control.println(F("Control lanes:"));
+            header = true;
+        }
+        msg.control.print(F("  "));
+        msg.control.print(transports[i]->getName());
+        msg.control.print(F(": "));
+        msg.control.print(stats->bytesSent);
+        msg.control.print(F(" sent, "));
+        msg.control.print(stats->bytesDropped);
+        msg.control.print(F(" dropped, "));
+        msg.control.print(stats->blockedWrites);
+        msg.control.print(F(" blocked, peak "));
+        msg.control.print(stats->peakFill);
+        msg.control.print(F("/"));
+        msg.control.print(stats->capacity);
+        msg.control.print(F(", "));
+        msg.control.print(transports[i]->getControlAhead());
+        msg.control.print(F(" times ahead of bulk"));
+        msg.control.println(transports[i]->isFramed() ? F(", framed") : F(""));
+    }
+}
+
+void MessageRouter::resetTransportCounters() {
+    for (int i = 0; i < NUM_TRANSPORTS; i++) {
+        if (transports[i]) transports[i]->resetCounters();
+#if ROUTER_DATA_PROFILES
+        profiles[i].shapedWrites = 0;
+        profiles[i].shapedBytes = 0;
+#endif
     }
 }
 
 void MessageRouter::listAvailableTransports() {
-    TransportInterface* ctrl = getTransport(PLANE_CONTROL, true);
+    TransportInterface* ctrl = getTransport(PLANE_CONTROL);
     if (!ctrl) return;
 
     msg.control.println(F("=== Available Transports ==="));
 
     const char* transportNames[] = {"NONE", "USB_SERIAL", "SERIAL1", "SERIAL2", "SERIAL3",
-                                    "SERIAL4", "SERIAL5", "SERIAL6", "SERIAL7", "SERIAL8", "ESP32_BT"};
+                                    "SERIAL4", "SERIAL5", "SERIAL6", "SERIAL7", "SERIAL8", "ESP32_BT",
+                                    "BLE_DATA", "WIFI", "WIFI_UDP"};
 
     for (int i = 1; i < NUM_TRANSPORTS; i++) {
         if (transports[i] != nullptr) {
@@ -235,35 +554,14 @@ void MessageRouter::listTransports() {
 
     // This will be implemented after msg.control is available
     // For now, just a placeholder
-    TransportInterface* ctrl = getTransport(PLANE_CONTROL, true);
+    TransportInterface* ctrl = getTransport(PLANE_CONTROL);
     if (!ctrl) return;
 
     msg.control.println(F("=== Transport Configuration ==="));
 
     // Show plane assignments
-    const char* planeNames[] = {"CONTROL", "DATA", "DEBUG"};
-    const char* transportNames[] = {"NONE", "USB_SERIAL", "SERIAL1", "SERIAL2", "SERIAL3",
-                                    "SERIAL4", "SERIAL5", "SERIAL6", "SERIAL7", "SERIAL8", "ESP32_BT"};
-
     for (int i = 0; i < NUM_PLANES; i++) {
-        msg.control.print(planeNames[i]);
-        msg.control.print(F(" → "));
-
-        uint8_t tid = primaryTransport[i];
-        if (tid < NUM_TRANSPORTS) {
-            msg.control.print(transportNames[tid]);
-        } else {
-            msg.control.print(F("UNKNOWN"));
-        }
-
-        if (secondaryTransport[i] != TRANSPORT_NONE) {
-            msg.control.print(F(" + "));
-            tid = secondaryTransport[i];
-            if (tid < NUM_TRANSPORTS) {
-                msg.control.print(transportNames[tid]);
-            }
-        }
-
+        printPlaneRoute((MessagePlane)i);
         msg.control.println();
     }
 
@@ -314,30 +612,50 @@ void MessageRouter::listTransports() {
 }
 
 void MessageRouter::update() {
-    // Poll all transports for housekeeping
+    // Poll all transports for housekeeping; a state change re-resolves the targets
     for (int i = 0; i < NUM_TRANSPORTS; i++) {
         if (transports[i] != nullptr) {
             transports[i]->update();
+            uint8_t state = transports[i]->getState();
+            if (state != lastState[i]) {
+                lastState[i] = state;
+                targetsDirty = true;
+            }
         }
     }
 
+#ifdef ENABLE_DEFERRED_LOG
+    // One frame of deferred log records per loop
+    drainDeferredLog();
+#endif
+
     // Process incoming commands from control plane transports
     processIncomingCommands();
 }
 
 void MessageRouter::processIncomingCommands() {
-    // Poll primary control transport
-    TransportInterface* ctrl = getTransport(PLANE_CONTROL, true);
-    if (ctrl && ctrl->isConnected() && ctrl->available()) {
-        setActiveControlTransport(ctrl);
-        processCommandFromTransport(ctrl);
+    // A long answer still going out - the next command waits in its transport
+    if (responseActive()) return;
+
+    const PlaneTargets& ctrl = getTargets(PLANE_CONTROL);
+
+    // A partial line holds the command line for its transport - unless that
+    // transport is gone or has gone quiet
+    if (lineOwner) {
+        bool present = false;
+        for (uint8_t i = 0; i < ctrl.count; i++) {
+            if (ctrl.list[i] == lineOwner) present = true;
+        }
+        if (!present || millis() - lineOwnerMs >= COMMAND_LINE_HOLD_MS) lineOwner = nullptr;
     }
 
-    // Poll secondary control transport (if configured)
-    TransportInterface* ctrl2 = getTransport(PLANE_CONTROL, false);
-    if (ctrl2 && ctrl2->isConnected() && ctrl2->available()) {
-        setActiveControlTransport(ctrl2);
-        processCommandFromTransport(ctrl2);
+    // Poll every connected control transport, primary first
+    for (uint8_t i = 0; i < ctrl.count; i++) {
+        TransportInterface* t = ctrl.list[i];
+        if (t->available() && (!lineOwner || lineOwner == t)) {
+            setActiveControlTransport(t);
+            processCommandFromTransport(t);
+        }
     }
 
     // Process received characters (embedded-cli needs this after receiving chars)
@@ -345,9 +663,18 @@ void MessageRouter::processIncomingCommands() {
 }
 
 void MessageRouter::processCommandFromTransport(TransportInterface* transport) {
-    // Read and process all available characters
-    while (transport->available()) {
-        char c = transport->read();
-        handleCommandInput(c);
+    // Bulk reads up to the budget; the rest waits in the transport for the next loop
+    uint8_t chunk[COMMAND_INPUT_CHUNK];
+    uint16_t budget = COMMAND_INPUT_BUDGET;
+    while (budget > 0) {
+        size_t n = transport->receive(chunk, budget < sizeof(chunk) ? budget : sizeof(chunk));
+        if (n == 0) break;
+        budget -= n;
+        if (handleCommandInput(chunk, n)) {
+            lineOwner = transport;
+            lineOwnerMs = millis();
+        } else {
+            lineOwner = nullptr;
+        }
     }
 }
@@ -4,9 +4,58 @@
  * Routes messages to appropriate transports based on:
  * - Message type (CONTROL/DATA/DEBUG)
  * - Runtime configuration (persisted in EEPROM)
- * - Multi-cast support (send to multiple transports)
+ * - Fan-out: each plane has a primary transport and any number of
+ *   subscribers, and every connected one gets the same bytes
  *
  * Configuration is stored in SystemConfig.router and persisted to EEPROM.
+ *
+ * Each plane also has a TX overflow policy, used when a buffered transport's
+ * TX ring is full (transport_tx_ring.h). Defaults: CONTROL blocks (command
+ * responses are never lost), DATA and DEBUG drop the newest write, so they
+ * can never stall the loop. Only CONTROL may block. Writes carry their
+ * plane as a TxLane, so a serial transport shared by every plane sends
+ * command answers ahead of queued data and debug output, between writes
+ * (transport_tx_ring.h), and can frame each plane (TRANSPORT FRAMING, RAM only).
+ *
+ * Command input is read in blocks (TransportInterface::readAvailable()), up
+ * to COMMAND_INPUT_BUDGET bytes per control transport per loop - a pasted
+ * script is applied over several loops instead of holding one. A transport
+ * that has sent part of a line keeps the command line until it ends it (or
+ * goes quiet for COMMAND_LINE_HOLD_MS), so two control transports never mix
+ * their lines.
+ *
+ * A plane's primary is the transport TRANSPORT <plane> <transport> sets; the
+ * subscribers are a bitmask of TransportIDs (TRANSPORT <plane> ADD/REMOVE).
+ * The resolved target list is the primary first, then the subscribers in ID
+ * order, each only while connected - a data logger on SERIAL1 keeps
+ * receiving while the USB host is unplugged. msg.* formats a message once
+ * and hands the same buffer to each target. On the CONTROL plane every
+ * target can also send commands.
+ *
+ * Data plane profiles (ROUTER_DATA_PROFILES) shape the DATA plane per
+ * transport: which streams it takes (RealDash frames, the Serial output,
+ * other text - so a radio can carry binary records while USB carries
+ * RealDash) and a byte rate, enforced with a token bucket. A write the
+ * bucket has no tokens for is skipped on that transport only; the others
+ * still get it. A write is let through whenever the bucket is above zero
+ * and charged in full, so frames are never cut and a frame bigger than the
+ * bucket still goes, followed by a longer pause. The sender keeps its own
+ * interval, and each link carries whatever share of it fits its rate.
+ *
+ * A transport can also be held out of the data plane altogether
+ * (setDataReserved()) - a host subscription (outputs/host_subscription.h)
+ * writes that transport's data itself.
+ *
+ * Build Flags:
+ *   -D ROUTER_DATA_PROFILES=0   - No per-transport data profiles (default
+ *                                 off on AVR, on elsewhere)
+ *   -D DATA_PROFILE_BURST_MS=n  - Token bucket depth, in ms of the rate (default 200)
+ *   -D ROUTER_MAX_TARGETS=n     - Transports one plane can reach at once
+ *                                 (default 4 on AVR, NUM_TRANSPORTS elsewhere)
+ *   -D COMMAND_INPUT_BUDGET=n   - Bytes read per control transport per loop
+ *                                 (default 64 on AVR, 256 elsewhere)
+ *   -D COMMAND_LINE_HOLD_MS=n   - Idle time before a partial line's transport
+ *                                 gives up the command line (default 2000)
  */
 
 #ifndef MESSAGE_ROUTER_H
@@ -16,6 +65,32 @@
 #include "log_filter.h"
 #include <Arduino.h>
 
+#ifndef COMMAND_INPUT_BUDGET
+#if defined(__AVR__)
+#define COMMAND_INPUT_BUDGET 64
+#else
+#define COMMAND_INPUT_BUDGET 256
+#endif
+#endif
+
+#ifndef COMMAND_LINE_HOLD_MS
+#define COMMAND_LINE_HOLD_MS 2000
+#endif
+
+#ifndef ROUTER_DATA_PROFILES
+#if defined(__AVR__)
+#define ROUTER_DATA_PROFILES 0
+#else
+#define ROUTER_DATA_PROFILES 1
+#endif
+#endif
+
+#ifndef DATA_PROFILE_BURST_MS
+#define DATA_PROFILE_BURST_MS 200
+#endif
+
+#define COMMAND_INPUT_CHUNK 32      // Bytes per readAvailable() call
+
 // Message plane enumeration
 enum MessagePlane {
     PLANE_CONTROL = 0,  // Interactive commands, configuration responses
@@ -36,8 +111,50 @@ enum TransportID {
     TRANSPORT_SERIAL6 = 7,      // Hardware Serial6
     TRANSPORT_SERIAL7 = 8,      // Hardware Serial7
     TRANSPORT_SERIAL8 = 9,      // Hardware Serial8 (Teensy 4.1 only)
-    TRANSPORT_ESP32_BT = 10,    // ESP32 built-in Bluetooth Classic
-    NUM_TRANSPORTS = 11
+    TRANSPORT_ESP32_BT = 10,    // ESP32 built-in Bluetooth Classic (BLE UART on S3/C3)
+    TRANSPORT_ESP32_BLE_DATA = 11,  // ESP32-S3/C3 BLE data characteristic (write-only)
+    TRANSPORT_ESP32_WIFI = 12,      // ESP32 Wi-Fi TCP control connection (ENABLE_WIFI_TRANSPORT)
+    TRANSPORT_ESP32_WIFI_UDP = 13,  // ESP32 Wi-Fi UDP data stream (write-only)
+    NUM_TRANSPORTS = 14
+};
+
+// Source of a data plane write (data plane profiles pick streams per transport)
+enum DataStream : uint8_t {
+    DATA_STREAM_TEXT     = 0,   // Plain msg.data output, bench stream - not from a module below
+    DATA_STREAM_REALDASH = 1,   // RealDash output frames
+    DATA_STREAM_SERIAL   = 2,   // Serial output (CSV, WIDE, BINARY, COMPRESSED)
+    NUM_DATA_STREAMS     = 3
+};
+
+#define DATA_STREAMS_ALL ((1u << NUM_DATA_STREAMS) - 1)
+
+// A transport's data plane profile and its token bucket
+struct DataProfile {
+    uint16_t rate;              // Bytes/s (0 = unshaped)
+    uint8_t streams;            // DataStream bits it takes
+    int32_t tokens;             // Milli-bytes it may send; negative while paying off a big write
+    uint32_t refillMs;          // Last refill
+    uint32_t shapedWrites;      // Writes skipped for rate
+    uint32_t shapedBytes;
+};
+
+// Subscriber masks are 16 bits wide (SystemConfig.router.subscribers)
+static_assert(NUM_TRANSPORTS <= 16, "Subscriber masks hold 16 transports");
+
+#ifndef ROUTER_MAX_TARGETS
+#if defined(__AVR__)
+#define ROUTER_MAX_TARGETS 4        // USB and Serial1-3 at most
+#else
+#define ROUTER_MAX_TARGETS NUM_TRANSPORTS
+#endif
+#endif
+
+// Transports a plane's messages currently go to: the primary, then the
+// subscribers in TransportID order - whichever are registered and connected
+struct PlaneTargets {
+    TransportInterface* list[ROUTER_MAX_TARGETS];
+    uint8_t ids[ROUTER_MAX_TARGETS];    // TransportID of each
+    uint8_t count;
 };
 
 // Message router class
@@ -45,10 +162,45 @@ class MessageRouter {
 private:
     TransportInterface* transports[NUM_TRANSPORTS];
     TransportInterface* activeControlTransport;  // Last transport that sent a command
+    TransportInterface* lineOwner;               // Transport with a partial command line
+    uint32_t lineOwnerMs;                        // When lineOwner last sent input
 
     // Plane to transport mapping (runtime configurable)
     uint8_t primaryTransport[NUM_PLANES];
-    uint8_t secondaryTransport[NUM_PLANES];  // For multi-cast
+    uint16_t subscribers[NUM_PLANES];        // Bit n: TransportID n also gets the plane
+
+    // TX overflow policy per plane (never TX_POLICY_DEFAULT - resolved on load)
+    TxOverflowPolicy txPolicy[NUM_PLANES];
+
+    // Resolved targets per plane, rebuilt after a mapping, registration or
+    // connection state change (states are polled once per update())
+    PlaneTargets planeTargets[NUM_PLANES];
+    uint8_t lastState[NUM_TRANSPORTS];
+    bool targetsDirty;
+
+    void resolveTargets();
+
+#if ROUTER_DATA_PROFILES
+    // Data plane profile per TransportID, and the stream being written
+    DataProfile profiles[NUM_TRANSPORTS];
+    DataStream dataStream;
+
+    bool takeTokens(DataProfile& p, size_t len);
+#endif
+
+    // Bit n: TransportID n takes no data plane writes (setDataReserved())
+    uint16_t dataReserved;
+
+    // Control plane writes held in RAM instead of sent (setControlCapture())
+    char* captureBuf;
+    uint16_t captureSize;
+    uint16_t captureLen;
+
+    // Registered, and enabled if a hardware serial port
+    bool isAvailable(TransportID transportId) const;
+
+    // "CONTROL → USB_SERIAL + SERIAL1" (STATUS, LIST)
+    void printPlaneRoute(MessagePlane plane);
 
     // Log filtering (runtime configurable)
     LogFilter logFilter;
@@ -74,8 +226,19 @@ public:
 
     // ========== Message Routing ==========
 
-    // Get transport for a specific plane
-    TransportInterface* getTransport(MessagePlane plane, bool primary = true);
+    // Get the primary transport of a plane
+    TransportInterface* getTransport(MessagePlane plane);
+
+    // Subscriber bitmask of a plane (bit n = TransportID n)
+    uint16_t getSubscribers(MessagePlane plane) const {
+        return (plane < NUM_PLANES) ? subscribers[plane] : 0;
+    }
+
+    // Resolved targets of a plane (what MessageStream writes to)
+    const PlaneTargets& getTargets(MessagePlane plane) {
+        if (targetsDirty) resolveTargets();
+        return planeTargets[plane];
+    }
 
     // Route text message to appropriate transport(s)
     void routeMessage(MessagePlane plane, const char* message);
@@ -93,6 +256,84 @@ public:
         return activeControlTransport;
     }
 
+    // Whether every control target can queue bytes without waiting (a TX
+    // ring smaller than that only has to be empty)
+    bool controlTxReady(size_t bytes);
+
+    // Registered transport of an ID (nullptr if none), and the ID of one
+    TransportInterface* getTransportById(TransportID transportId) const {
+        return (transportId < NUM_TRANSPORTS) ? transports[transportId] : nullptr;
+    }
+    TransportID findTransportId(const TransportInterface* transport) const;
+
+    // ========== TX Overflow Policy ==========
+
+    TxOverflowPolicy getTxPolicy(MessagePlane plane) const {
+        return txPolicy[plane];
+    }
+
+    // TX_POLICY_DEFAULT restores the plane default; TX_BLOCK is CONTROL only
+    bool setTxPolicy(MessagePlane plane, TxOverflowPolicy policy);
+
+    static TxOverflowPolicy defaultTxPolicy(MessagePlane plane);
+    static const char* getTxPolicyName(TxOverflowPolicy policy);
+
+    // ========== Data Plane Profiles ==========
+
+    // Stream the following data plane writes come from (OutputFrame::commit())
+    void setDataStream(DataStream stream) {
+#if ROUTER_DATA_PROFILES
+        dataStream = stream;
+#else
+        (void)stream;
+#endif
+    }
+
+    // Whether transport id takes a data plane write of len bytes (charged if so)
+    bool admitData(uint8_t id, size_t len) {
+        if (dataReserved & (1u << id)) return false;
+#if ROUTER_DATA_PROFILES
+        DataProfile& p = profiles[id];
+        if (!(p.streams & (1u << dataStream))) return false;
+        return p.rate == 0 || takeTokens(p, len);
+#else
+        (void)id;
+        (void)len;
+        return true;
+#endif
+    }
+
+    // Transports whose data someone else writes (bit n = TransportID n)
+    void setDataReserved(uint16_t mask) { dataReserved = mask; }
+    uint16_t getDataReserved() const { return dataReserved; }
+
+    // ========== Control Capture ==========
+
+    // Control plane writes go into buf (up to size - 1 bytes, NUL-terminated,
+    // the rest dropped) instead of to the transports - each command of a
+    // script answers there, the script with one summary (inputs/command_script.h).
+    // Calling it again empties buf; nullptr ends the capture.
+    void setControlCapture(char* buf, uint16_t size) {
+        captureBuf = (size > 0) ? buf : nullptr;
+        captureSize = size;
+        captureLen = 0;
+        if (captureBuf) captureBuf[0] = '\0';
+    }
+
+    // True if the write was captured (MessageStream sends it nowhere else)
+    bool captureControl(const uint8_t* data, size_t len) {
+        if (!captureBuf) return false;
+        while (len-- > 0 && captureLen + 1 < captureSize) captureBuf[captureLen++] = (char)*data++;
+        captureBuf[captureLen] = '\0';
+        return true;
+    }
+
+    // rate 0 = unshaped, streams DATA_STREAMS_ALL = everything (the default)
+    bool setDataProfile(TransportID transportId, uint16_t rate, uint8_t streams);
+    const DataProfile* getDataProfile(TransportID transportId) const;
+    void printDataProfile(TransportID transportId);   // "SERIAL1: 960 B/s, streams SERIAL"
+    static const char* getDataStreamName(DataStream stream);
+
     // ========== Log Filtering ==========
 
     // Get the log filter instance
@@ -102,12 +343,19 @@ public:
 
     // ========== Configuration ==========
 
-    // Set transport for a specific plane
-    bool setTransport(MessagePlane plane, TransportID transportId, bool secondary = false);
+    // Set the primary transport of a plane
+    bool setTransport(MessagePlane plane, TransportID transportId);
+
+    // Add a transport to / remove it from a plane's subscribers
+    bool addSubscriber(MessagePlane plane, TransportID transportId);
+    bool removeSubscriber(MessagePlane plane, TransportID transportId);
 
-    // Query current transport routing (STATUS)
+    // Query current transport routing and traffic counters (STATUS)
     void printTransportStatus();
 
+    // Restart every transport's traffic counters (TRANSPORT RESET)
+    void resetTransportCounters();
+
     // List available transports (LIST)
     void listAvailableTransports();
 
@@ -123,7 +371,7 @@ private:
     // Process incoming commands from control plane transports
     void processIncomingCommands();
 
-    // Read and process characters from a specific transport
+    // Read and process up to COMMAND_INPUT_BUDGET bytes from a transport
     void processCommandFromTransport(TransportInterface* transport);
 };
 
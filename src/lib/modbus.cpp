@@ -0,0 +1,382 @@
+/*
+ * modbus.cpp - Modbus RTU slave on a hardware serial port (and Modbus TCP on ESP32 Wi-Fi)
+ */
+
+#include "modbus.h"
+
+#ifdef ENABLE_MODBUS
+
+#include "serial_manager.h"
+#include "message_api.h"
+#include "log_tags.h"
+#include "pin_registry.h"
+#include "../inputs/input.h"
+#include "../inputs/input_manager.h"
+#include <math.h>
+#ifdef MODBUS_TCP
+#include <WiFi.h>
+#endif
+
+#define MODBUS_FRAME_MAX    256                     // Address + PDU (253) + CRC
+#define FC_READ_HOLDING     0x03
+#define FC_READ_INPUT       0x04
+#define EX_ILLEGAL_FUNCTION 0x01
+#define EX_ILLEGAL_ADDRESS  0x02
+#define EX_ILLEGAL_VALUE    0x03
+
+// Register image in wire order (big-endian), written at read time
+static uint8_t image[MODBUS_REGISTERS * 2];
+
+static ModbusStats stats = {0, 0, 0, 0, 0, 0, 0};
+
+// ===== REGISTER IMAGE =====
+
+// Register units per standard unit, by measurement type
+static const float SCALE[] PROGMEM = {
+    10.0f,      // MEASURE_TEMPERATURE  0.1 C
+    100.0f,     // MEASURE_PRESSURE     0.01 bar
+    100.0f,     // MEASURE_VOLTAGE      0.01 V
+    1.0f,       // MEASURE_RPM
+    10.0f,      // MEASURE_HUMIDITY     0.1 %
+    1.0f,       // MEASURE_ELEVATION    1 m
+    1.0f,       // MEASURE_DIGITAL
+    10.0f,      // MEASURE_SPEED        0.1 km/h
+};
+
+#define SCALE_COUNT (sizeof(SCALE) / sizeof(SCALE[0]))
+
+static float scaleOf(uint8_t type) {
+    return type < SCALE_COUNT ? pgm_read_float(&SCALE[type]) : 100.0f;
+}
+
+static void putRegister(uint16_t reg, uint16_t value) {
+    image[2 * reg] = value >> 8;
+    image[2 * reg + 1] = value & 0xFF;
+}
+
+static uint16_t getRegister(uint16_t reg) {
+    return ((uint16_t)image[2 * reg] << 8) | image[2 * reg + 1];
+}
+
+static uint16_t encodeValue(float value, uint8_t type) {
+    if (isnan(value)) return MODBUS_NO_VALUE;
+    float raw = value * scaleOf(type);
+    raw += raw < 0.0f ? -0.5f : 0.5f;
+    if (raw > 32767.0f) return 0x7FFF;
+    if (raw < -32767.0f) return (uint16_t)-32767;
+    return (uint16_t)(int16_t)raw;
+}
+
+void updateModbusRegister(const Input* input) {
+    uint8_t slot = input - inputs;
+    uint16_t status = (uint16_t)input->measurementType << 8;
+    if (!isnan(input->value)) status |= MODBUS_STATUS_VALID;
+    if (input->flags.isInAlarm) status |= MODBUS_STATUS_ALARM;
+    putRegister(2 * slot, encodeValue(input->value, input->measurementType));
+    putRegister(2 * slot + 1, status);
+}
+
+void resetModbusRegisters() {
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        const Input* input = &inputs[i];
+        bool used = input->pin != 0xFF && input->flags.isEnabled;
+        putRegister(2 * i, MODBUS_NO_VALUE);
+        putRegister(2 * i + 1, used ? (uint16_t)input->measurementType << 8 : MODBUS_STATUS_UNUSED);
+    }
+}
+
+// ===== FRAMING =====
+
+uint16_t modbusCrc(const uint8_t* data, uint16_t len) {
+    uint16_t crc = 0xFFFF;
+    while (len--) {
+        crc ^= *data++;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+        }
+    }
+    return crc;
+}
+
+static uint8_t exception(uint8_t function, uint8_t code, uint8_t* reply) {
+    stats.exceptions++;
+    reply[0] = function | 0x80;
+    reply[1] = code;
+    return 2;
+}
+
+uint8_t handleModbusPdu(const uint8_t* pdu, uint8_t len, uint8_t* reply) {
+    stats.requests++;
+    stats.lastRequestMs = millis();
+
+    uint8_t function = pdu[0];
+    if (function != FC_READ_HOLDING && function != FC_READ_INPUT) {
+        return exception(function, EX_ILLEGAL_FUNCTION, reply);
+    }
+    if (len < 5) return exception(function, EX_ILLEGAL_VALUE, reply);
+
+    uint16_t start = ((uint16_t)pdu[1] << 8) | pdu[2];
+    uint16_t count = ((uint16_t)pdu[3] << 8) | pdu[4];
+    if (count == 0 || count > MODBUS_MAX_READ) return exception(function, EX_ILLEGAL_VALUE, reply);
+    if ((uint32_t)start + count > MODBUS_REGISTERS) return exception(function, EX_ILLEGAL_ADDRESS, reply);
+
+    // Holding and input registers are the same image
+    reply[0] = function;
+    reply[1] = count * 2;
+    memcpy(&reply[2], &image[2 * start], count * 2);
+    return 2 + count * 2;
+}
+
+// ===== RTU =====
+
+static Stream* port = nullptr;
+static uint8_t rxBuf[MODBUS_FRAME_MAX];
+static uint16_t rxLen = 0;
+static uint32_t lastByteUs = 0;
+static uint32_t silenceUs = 0;              // t3.5
+
+static uint8_t txBuf[MODBUS_FRAME_MAX];
+static uint16_t txLen = 0;
+static uint16_t txPos = 0;
+
+// Frame length once the function code (and a write's byte count) is in;
+// 0 = only the silence after it ends the frame
+static uint16_t expectedLength() {
+    if (rxLen < 2) return 0;
+    uint8_t function = rxBuf[1];
+    if (function >= 0x01 && function <= 0x06) return 8;
+    if (function == 0x0F || function == 0x10) return rxLen >= 7 ? 9 + rxBuf[6] : 0;
+    return 0;
+}
+
+static void sendReply() {
+#ifdef MODBUS_DE_PIN
+    // Half duplex: hold the driver for the whole reply, release after the stop bit
+    digitalWrite(MODBUS_DE_PIN, HIGH);
+    port->write(txBuf, txLen);
+    port->flush();
+    digitalWrite(MODBUS_DE_PIN, LOW);
+    txLen = 0;
+#else
+    txPos = 0;
+#endif
+}
+
+static void handleRtuFrame() {
+    uint16_t len = rxLen;
+    rxLen = 0;
+    if (len < 4) {
+        stats.partials++;
+        return;
+    }
+    uint16_t crc = modbusCrc(rxBuf, len - 2);
+    if (rxBuf[len - 2] != (crc & 0xFF) || rxBuf[len - 1] != (crc >> 8)) {
+        stats.crcErrors++;
+        return;
+    }
+    if (rxBuf[0] != MODBUS_SLAVE_ID) {
+        if (rxBuf[0] != 0) stats.otherSlaves++;
+        return;  // Broadcasts have no reply (and nothing here is writable)
+    }
+    if (txPos < txLen) return;  // Master didn't wait for the last reply
+
+    txBuf[0] = MODBUS_SLAVE_ID;
+    uint8_t pduLen = handleModbusPdu(&rxBuf[1], len - 3, &txBuf[1]);
+    crc = modbusCrc(txBuf, 1 + pduLen);
+    txBuf[1 + pduLen] = crc & 0xFF;
+    txBuf[2 + pduLen] = crc >> 8;
+    txLen = 3 + pduLen;
+    sendReply();
+}
+
+static void updateRtu(uint32_t nowUs) {
+    // Reply: what the transmit buffer has room for
+    if (txPos < txLen) {
+        int room = port->availableForWrite();
+        if (room > 0) {
+            uint16_t n = txLen - txPos;
+            if ((uint16_t)room < n) n = room;
+            port->write(&txBuf[txPos], n);
+            txPos += n;
+        }
+    }
+
+    bool received = false;
+    while (port->available() > 0) {
+        uint8_t c = port->read();
+        received = true;
+        if (rxLen >= sizeof(rxBuf)) {
+            stats.partials++;  // Overrun: drop it and resync at the next silence
+            rxLen = 0;
+        }
+        rxBuf[rxLen++] = c;
+        uint16_t expected = expectedLength();
+        if (expected != 0 && rxLen >= expected) handleRtuFrame();
+    }
+    if (received) {
+        lastByteUs = nowUs;
+    } else if (rxLen > 0 && nowUs - lastByteUs > silenceUs) {
+        // A frame of an unknown length ends here; anything else was cut short
+        if (expectedLength() == 0 && rxLen >= 4) handleRtuFrame();
+        else { stats.partials++; rxLen = 0; }
+    }
+}
+
+// ===== TCP =====
+
+#ifdef MODBUS_TCP
+static WiFiServer tcpServer(MODBUS_TCP_PORT);
+static WiFiClient tcpClient;
+static bool tcpStarted = false;
+static uint8_t tcpBuf[7 + MODBUS_FRAME_MAX - 3];    // MBAP header + PDU
+static uint16_t tcpLen = 0;
+
+static void handleTcpFrame(uint16_t length) {
+    uint8_t unit = tcpBuf[6];
+    if (unit != MODBUS_SLAVE_ID && unit != 0 && unit != 0xFF) return;
+
+    uint8_t reply[7 + 2 + 2 * MODBUS_MAX_READ];
+    uint8_t pduLen = handleModbusPdu(&tcpBuf[7], length - 1, &reply[7]);
+    memcpy(reply, tcpBuf, 4);       // Transaction and protocol ID
+    reply[4] = 0;
+    reply[5] = 1 + pduLen;
+    reply[6] = unit;
+    tcpClient.write(reply, 7 + pduLen);
+}
+
+static void updateTcp() {
+    if (!tcpStarted) {
+        if (WiFi.getMode() == WIFI_OFF) return;  // Wait for the Wi-Fi transport
+        tcpServer.begin();
+        tcpServer.setNoDelay(true);
+        tcpStarted = true;
+    }
+
+    // One master; a new connection replaces a stale one
+    if (tcpServer.hasClient()) {
+        WiFiClient incoming = tcpServer.available();
+        if (tcpClient.connected()) tcpClient.stop();
+        tcpClient = incoming;
+        tcpClient.setNoDelay(true);
+        tcpLen = 0;
+        stats.tcpConnections++;
+    }
+    if (!tcpClient.connected()) return;
+
+    while (tcpClient.available() > 0) {
+        tcpBuf[tcpLen++] = tcpClient.read();
+        if (tcpLen < 7) continue;
+        uint16_t length = ((uint16_t)tcpBuf[4] << 8) | tcpBuf[5];  // Unit ID + PDU
+        if (tcpBuf[2] != 0 || tcpBuf[3] != 0 || length < 2 || length > sizeof(tcpBuf) - 6) {
+            tcpClient.stop();   // Not Modbus - no way to find the next frame
+            tcpLen = 0;
+            return;
+        }
+        if (tcpLen < 6 + length) continue;
+        handleTcpFrame(length);
+        tcpLen = 0;
+    }
+}
+#endif // MODBUS_TCP
+
+// ===== PUBLIC =====
+
+void initModbus() {
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        putRegister(2 * i, MODBUS_NO_VALUE);
+        putRegister(2 * i + 1, MODBUS_STATUS_UNUSED);
+    }
+
+    // t3.5: 3.5 characters of 11 bits, fixed at 1750 us above 19200 baud
+    silenceUs = MODBUS_BAUD > 19200 ? 1750 : 38500000UL / MODBUS_BAUD;
+
+#if MODBUS_SERIAL_PORT > 0
+    if (!claimSerialPort(MODBUS_SERIAL_PORT, MODBUS_BAUD, "MODBUS")) {
+        msg.debug.warn(TAG_SERIAL, "Modbus: Serial%d not available - RTU disabled", MODBUS_SERIAL_PORT);
+        return;
+    }
+    port = getSerialPort(MODBUS_SERIAL_PORT);
+#ifdef MODBUS_DE_PIN
+    registerPin(MODBUS_DE_PIN, PIN_RESERVED, "RS-485 DE");
+    pinMode(MODBUS_DE_PIN, OUTPUT);
+    digitalWrite(MODBUS_DE_PIN, LOW);
+#endif
+    msg.debug.info(TAG_SERIAL, "Modbus RTU slave %d on Serial%d", MODBUS_SLAVE_ID, MODBUS_SERIAL_PORT);
+#endif
+}
+
+void updateModbus(uint32_t nowUs) {
+    if (port) updateRtu(nowUs);
+#ifdef MODBUS_TCP
+    updateTcp();
+#endif
+}
+
+const ModbusStats& getModbusStats() {
+    return stats;
+}
+
+void printModbusStatus() {
+    msg.control.println();
+    msg.control.println(F("=== MODBUS ==="));
+    msg.control.print(F("Slave:      "));
+    msg.control.print(MODBUS_SLAVE_ID);
+#if MODBUS_SERIAL_PORT > 0
+    msg.control.print(F(", RTU on Serial"));
+    msg.control.print(MODBUS_SERIAL_PORT);
+    msg.control.print(F(" @ "));
+    msg.control.print((uint32_t)MODBUS_BAUD);
+    msg.control.print(F(" baud"));
+    if (!port) msg.control.print(F(" (port not available)"));
+#endif
+#ifdef MODBUS_TCP
+    msg.control.print(F(", TCP port "));
+    msg.control.print(MODBUS_TCP_PORT);
+    msg.control.print(tcpClient.connected() ? F(" (master connected)") : F(""));
+#endif
+    msg.control.println();
+    msg.control.print(F("Requests:   "));
+    msg.control.print(stats.requests);
+    msg.control.print(F(", "));
+    msg.control.print(stats.exceptions);
+    msg.control.print(F(" exceptions"));
+    if (stats.lastRequestMs != 0) {
+        msg.control.print(F(", last "));
+        msg.control.print(millis() - stats.lastRequestMs);
+        msg.control.print(F(" ms ago"));
+    }
+    msg.control.println();
+    msg.control.print(F("Dropped:    "));
+    msg.control.print(stats.crcErrors);
+    msg.control.print(F(" CRC errors, "));
+    msg.control.print(stats.partials);
+    msg.control.print(F(" partial frames, "));
+    msg.control.print(stats.otherSlaves);
+    msg.control.println(F(" for other slaves"));
+
+    msg.control.println(F("Registers (03/04):"));
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        uint16_t status = getRegister(2 * i + 1);
+        if ((status & 0xFF00) == MODBUS_STATUS_UNUSED) continue;
+        uint8_t type = status >> 8;
+        float scale = scaleOf(type);
+        msg.control.print(F("  "));
+        msg.control.print(2 * i);
+        msg.control.print(F("/"));
+        msg.control.print(2 * i + 1);
+        msg.control.print(F("  "));
+        msg.control.print(inputs[i].abbrName);
+        msg.control.print(F(" ("));
+        printPin(inputs[i].pin);
+        msg.control.print(F(")  x"));
+        msg.control.print(scale, 0);
+        msg.control.print(F("  = "));
+        uint16_t raw = getRegister(2 * i);
+        if (raw == MODBUS_NO_VALUE) msg.control.print(F("--"));
+        else msg.control.print((int16_t)raw);
+        if (status & MODBUS_STATUS_ALARM) msg.control.print(F("  ALARM"));
+        msg.control.println();
+    }
+}
+
+#endif // ENABLE_MODBUS
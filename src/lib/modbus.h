@@ -0,0 +1,142 @@
+/*
+ * modbus.h - Modbus RTU slave on a hardware serial port (and Modbus TCP on ESP32 Wi-Fi)
+ *
+ * Lets a PLC, HMI or industrial gateway poll the inputs as registers. The
+ * port (MODBUS_SERIAL_PORT) is claimed from the serial manager like the GPS
+ * port: it is not a transport and BUS SERIAL leaves it alone.
+ *
+ * Register map - two registers per input slot, the same for function 03
+ * (holding) and 04 (input registers), 0-based:
+ *
+ *   2n      value of slot n, signed 16-bit, scaled by measurement type:
+ *             temperature 0.1 C, pressure 0.01 bar, voltage 0.01 V, RPM 1,
+ *             humidity 0.1 %, elevation 1 m, digital 0/1, speed 0.1 km/h
+ *           0x8000 (-32768) = no value; out of range clamps to +/-32767
+ *   2n+1    status: bit 0 value valid, bit 1 in alarm, bits 8-15 measurement
+ *           type (0 = temperature ... 7 = speed; 0xFF = slot not in use)
+ *
+ * BUS MODBUS lists which input is at which register. The registers are
+ * written when their input is read (updateModbusRegister(), next to the
+ * other per-reading stages), already in wire byte order - a request is
+ * answered by copying a block of the image, with no per-request scaling. A
+ * frame is answered as soon as its last byte arrives rather than after the
+ * 3.5-character silence, so a 125-register reply starts within a loop.
+ *
+ * Functions 03 and 04 read up to 125 registers. Other functions (writes
+ * included - the map is read-only) get exception 01, a block past the map
+ * exception 02, a count of 0 or over 125 exception 03. Frames with a bad CRC
+ * or for another slave are dropped; a broadcast (address 0) is not answered.
+ * A partial frame is discarded after 3.5 character times of silence (1.75 ms
+ * above 19200 baud).
+ *
+ * Replies go out through the UART's transmit buffer, a slice per loop, so a
+ * long reply never stalls the loop. With an RS-485 transceiver, name its
+ * driver enable pin (MODBUS_DE_PIN): it is raised for the reply and dropped
+ * once the last bit is out, and the reply is then written in one go.
+ *
+ * Modbus TCP (MODBUS_TCP, ESP32 with ENABLE_WIFI_TRANSPORT): the same map on
+ * MODBUS_TCP_PORT, one client at a time, unit IDs MODBUS_SLAVE_ID, 0 and 255.
+ *
+ * Usage:
+ *   initModbus();                   // setup(), before initConfiguredSerialPorts()
+ *   updateModbus(micros());         // every loop, CONFIG mode too
+ *   updateModbusRegister(input);    // with every reading
+ *   resetModbusRegisters();         // on every schedule rebuild
+ *
+ * Build Flags:
+ *   -D ENABLE_MODBUS            - Compile the Modbus slave
+ *   -D MODBUS_SERIAL_PORT=n     - Hardware serial port of the RTU link (default 2: Serial2, 0 = TCP only)
+ *   -D MODBUS_BAUD=n            - RTU baud rate (default 19200, 8N1)
+ *   -D MODBUS_SLAVE_ID=n        - Slave address 1-247 (default 1)
+ *   -D MODBUS_DE_PIN=n          - RS-485 driver enable pin (default none: full-duplex or auto-direction)
+ *   -D MODBUS_TCP               - Also serve Modbus TCP (ESP32 with ENABLE_WIFI_TRANSPORT)
+ *   -D MODBUS_TCP_PORT=n        - TCP port (default 502)
+ */
+
+#ifndef MODBUS_H
+#define MODBUS_H
+
+#include <Arduino.h>
+#include "platform.h"  // MAX_INPUTS
+
+struct Input;
+
+#ifdef ENABLE_MODBUS
+
+#ifndef MODBUS_SERIAL_PORT
+#define MODBUS_SERIAL_PORT 2
+#endif
+
+#ifndef MODBUS_BAUD
+#define MODBUS_BAUD 19200
+#endif
+
+#ifndef MODBUS_SLAVE_ID
+#define MODBUS_SLAVE_ID 1
+#endif
+
+#ifndef MODBUS_TCP_PORT
+#define MODBUS_TCP_PORT 502
+#endif
+
+#if defined(MODBUS_TCP) && (!defined(ESP32) || !defined(ENABLE_WIFI_TRANSPORT))
+#error "MODBUS_TCP needs an ESP32 build with ENABLE_WIFI_TRANSPORT"
+#endif
+
+#define MODBUS_REGISTERS        (2 * MAX_INPUTS)
+#define MODBUS_MAX_READ         125     // Registers per 03/04 request (by the standard)
+#define MODBUS_NO_VALUE         0x8000
+
+#define MODBUS_STATUS_VALID     0x0001
+#define MODBUS_STATUS_ALARM     0x0002
+#define MODBUS_STATUS_UNUSED    0xFF00  // Measurement type byte of a slot not in use
+
+// Slave counters (BUS MODBUS)
+struct ModbusStats {
+    uint32_t requests;          // Frames for us with a good CRC (RTU and TCP)
+    uint32_t exceptions;        // Of those, answered with an exception
+    uint16_t crcErrors;         // RTU frames dropped on CRC
+    uint16_t partials;          // RTU frames cut short by silence or overrun
+    uint16_t otherSlaves;       // RTU frames for other addresses
+    uint16_t tcpConnections;
+    uint32_t lastRequestMs;     // millis() of the last request (0 = none)
+};
+
+// Claim the serial port, fill the register image with "no value"
+void initModbus();
+
+// Receive, answer and transmit (RTU and TCP)
+void updateModbus(uint32_t nowUs);
+
+// Write an input's value and status into the register image
+void updateModbusRegister(const Input* input);
+
+// Mark unused slots and the measurement type of every slot (inputs changed)
+void resetModbusRegisters();
+
+/**
+ * Answer a request PDU (function code onward) from the register image
+ * @param pdu    Request, len bytes
+ * @param reply  At least 2 + 2 * MODBUS_MAX_READ bytes
+ * @return       Reply PDU length (an exception is 2 bytes)
+ */
+uint8_t handleModbusPdu(const uint8_t* pdu, uint8_t len, uint8_t* reply);
+
+// CRC-16/MODBUS (reflected 0x8005, initial 0xFFFF) - sent low byte first
+uint16_t modbusCrc(const uint8_t* data, uint16_t len);
+
+const ModbusStats& getModbusStats();
+
+// Port, counters and the register map (BUS MODBUS)
+void printModbusStatus();
+
+#else
+
+inline void initModbus() {}
+inline void updateModbus(uint32_t) {}
+inline void updateModbusRegister(const Input*) {}
+inline void resetModbusRegisters() {}
+
+#endif // ENABLE_MODBUS
+
+#endif // MODBUS_H
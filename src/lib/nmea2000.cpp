@@ -0,0 +1,143 @@
+/*
+ * nmea2000.cpp - NMEA 2000 engine and temperature PGNs, fast-packet framing
+ */
+
+#include "nmea2000.h"
+
+static const N2kPgn pgnTable[N2K_TX_MESSAGE_COUNT] PROGMEM = {
+    //  PGN                   prio len  interval
+    { N2K_PGN_ENGINE_RAPID,   2,  8,   100   },
+    { N2K_PGN_ENGINE_DYNAMIC, 2,  26,  500   },
+    { N2K_PGN_TEMPERATURE,    5,  8,   2000  },
+    { N2K_PGN_HEARTBEAT,      7,  8,   60000 },
+};
+
+N2kPgn n2kGetPgn(uint8_t message) {
+    N2kPgn pgn;
+    memcpy_P(&pgn, &pgnTable[message], sizeof(pgn));
+    return pgn;
+}
+
+// Standard units: C, bar, V, RPM. Discrete status 1 bits: 1 over temperature,
+// 2 low oil pressure, 4 low fuel pressure, 5 low system voltage, 6 low coolant
+// level, 11 high boost pressure.
+static const N2kField fieldTable[] PROGMEM = {
+    //  message                 PID   byte width signed tag  resolution offset
+    { N2K_TX_ENGINE_RAPID,   0x0C, 1,  2, false, 0,   0.25f,  0.0f     },  // Engine speed
+    { N2K_TX_ENGINE_RAPID,   0x6F, 3,  2, false, 12,  0.001f, 0.0f     },  // Boost pressure (100 Pa)
+    { N2K_TX_ENGINE_DYNAMIC, 0xCA, 1,  2, false, 3,   0.001f, 0.0f     },  // Oil pressure (100 Pa)
+    { N2K_TX_ENGINE_DYNAMIC, 0x5C, 3,  2, false, 0,   0.1f,   -273.15f },  // Oil temperature (0.1 K)
+    { N2K_TX_ENGINE_DYNAMIC, 0x05, 5,  2, false, 2,   0.01f,  -273.15f },  // Engine temperature (0.01 K)
+    { N2K_TX_ENGINE_DYNAMIC, 0xCB, 7,  2, true,  6,   0.01f,  0.0f     },  // Alternator potential
+    { N2K_TX_ENGINE_DYNAMIC, 0x0A, 17, 2, false, 5,   0.01f,  0.0f     },  // Fuel pressure (1 kPa)
+    { N2K_TX_ENGINE_DYNAMIC, 0xA2, 0,  0, false, 7,   1.0f,   0.0f     },  // Coolant level - status only
+    { N2K_TX_TEMPERATURE,    0x78, 3,  2, false, 14,  0.01f,  -273.15f },  // Exhaust gas
+    { N2K_TX_TEMPERATURE,    0x46, 3,  2, false, 1,   0.01f,  -273.15f },  // Outside
+    { N2K_TX_TEMPERATURE,    0xC8, 3,  2, false, 129, 0.01f,  -273.15f },  // Cylinder head (user defined)
+    { N2K_TX_TEMPERATURE,    0xC9, 3,  2, false, 130, 0.01f,  -273.15f },  // Transfer case (user defined)
+};
+
+#define FIELD_COUNT (sizeof(fieldTable) / sizeof(fieldTable[0]))
+
+uint8_t n2kFindField(uint8_t obd2pid) {
+    if (obd2pid == 0) return N2K_NO_FIELD;
+    for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+        if (pgm_read_byte(&fieldTable[i].obd2pid) == obd2pid) return i;
+    }
+    return N2K_NO_FIELD;
+}
+
+N2kField n2kGetField(uint8_t index) {
+    N2kField field;
+    memcpy_P(&field, &fieldTable[index], sizeof(field));
+    return field;
+}
+
+void n2kEncodeField(const N2kField& field, float value, uint8_t* data) {
+    if (field.width == 0) return;
+    uint16_t raw;
+    if (field.isSigned) {
+        // 0x7FFF not available, 0x7FFE out of range
+        if (isnan(value)) {
+            raw = 0x7FFF;
+        } else {
+            float scaled = (value - field.offset) / field.resolution;
+            scaled += scaled < 0.0f ? -0.5f : 0.5f;
+            raw = (scaled > 32765.0f || scaled < -32768.0f) ? 0x7FFE : (uint16_t)(int16_t)scaled;
+        }
+    } else {
+        // 0xFFFF not available, 0xFFFE out of range, 0xFFFD reserved
+        uint16_t maxValid = (field.width == 1) ? 0xFC : 0xFFFC;
+        if (isnan(value)) {
+            raw = (field.width == 1) ? 0xFF : 0xFFFF;
+        } else {
+            float scaled = (value - field.offset) / field.resolution + 0.5f;
+            raw = scaled < 0.0f ? 0 : (scaled >= maxValid + 1.0f ? (uint16_t)(maxValid + 2) : (uint16_t)scaled);
+        }
+    }
+    data[0] = raw & 0xFF;
+    if (field.width == 2) data[1] = raw >> 8;
+}
+
+void n2kInitMessage(uint8_t message, uint8_t instance, uint8_t tag, uint8_t* data) {
+    N2kPgn pgn = n2kGetPgn(message);
+    memset(data, 0xFF, pgn.length);
+
+    switch (message) {
+        case N2K_TX_ENGINE_RAPID:
+            data[0] = instance;
+            data[5] = 0x7F;     // Tilt/trim
+            break;
+
+        case N2K_TX_ENGINE_DYNAMIC:
+            data[0] = instance;
+            data[7] = 0xFF;     // Alternator potential (signed)
+            data[8] = 0x7F;
+            data[9] = 0xFF;     // Fuel rate (signed)
+            data[10] = 0x7F;
+            memset(&data[20], 0, 4);  // Discrete status 1 and 2: no warnings
+            data[24] = 0x7F;    // Load, torque
+            data[25] = 0x7F;
+            break;
+
+        case N2K_TX_TEMPERATURE:
+            data[1] = instance; // data[0] SID: not tied to other messages
+            data[2] = tag;
+            break;
+
+        case N2K_TX_HEARTBEAT: {
+            uint16_t interval = pgn.intervalMs / 10;  // 0.01 s
+            data[0] = interval & 0xFF;
+            data[1] = interval >> 8;
+            data[2] = tag;      // Sequence counter
+            data[3] = 0xCC;     // Controller 1 error active, controller 2 n/a, equipment operational
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+uint8_t n2kFastPacketFrames(uint8_t len) {
+    return len <= 8 ? 1 : 1 + len / 7;  // 6 bytes in the first frame, 7 in each after
+}
+
+void n2kFastPacketFrame(const uint8_t* message, uint8_t len, uint8_t seq, uint8_t index, uint8_t* frame) {
+    memset(frame, 0xFF, 8);
+    frame[0] = ((seq & 0x07) << 5) | (index & 0x1F);
+
+    uint8_t from;
+    uint8_t pos;
+    if (index == 0) {
+        frame[1] = len;
+        from = 0;
+        pos = 2;
+    } else {
+        from = 6 + 7 * (index - 1);
+        pos = 1;
+    }
+    while (pos < 8 && from < len) {
+        frame[pos++] = message[from++];
+    }
+}
@@ -0,0 +1,138 @@
+/*
+ * nmea2000.h - NMEA 2000 engine and temperature PGNs, fast-packet framing
+ *
+ * NMEA 2000 is J1939 underneath - the same 29-bit identifiers (lib/j1939.h),
+ * source addresses and Address Claimed / ISO Request messages - with its
+ * own PGNs, SI units and a fast-packet transport for messages up to 223
+ * bytes. Marine displays (chartplotters, engine gauges) read:
+ *
+ *   127488  Engine Parameters, Rapid Update    8 bytes   100 ms  priority 2
+ *           [instance, speed (0.25 rpm), boost (100 Pa), tilt/trim]
+ *   127489  Engine Parameters, Dynamic        26 bytes   500 ms  priority 2
+ *           [instance, oil pressure (100 Pa), oil temp (0.1 K), temperature
+ *           (0.01 K), alternator potential (0.01 V), fuel rate, engine hours
+ *           (1 s), coolant pressure, fuel pressure (1 kPa), reserved,
+ *           discrete status 1 and 2, load, torque]
+ *   130312  Temperature                        8 bytes  2000 ms  priority 5
+ *           [SID, instance, source, actual (0.01 K), set temperature]
+ *   126993  Heartbeat                          8 bytes 60000 ms  priority 7
+ *
+ * Inputs are matched by their OBD-II PID like the J1939 SPNs, so the
+ * application presets map without setup. Fields without an input are sent
+ * as "not available" (all ones, 0x7F.. when signed). Discrete status 1 sets
+ * the bit of each engine warning whose input is in alarm (over temperature,
+ * low oil pressure, low system voltage, ...); engine hours come from the RPM
+ * input's accumulator (inputs/input_stats.h). Every temperature input with
+ * a source type (exhaust, outside air, cylinder head, transfer case) is a
+ * 130312 message of its own; several inputs of one source are numbered by
+ * the message's instance.
+ *
+ * Fast packet - a message longer than 8 bytes goes out as a sequence of
+ * frames on the same ID:
+ *
+ *   frame 0    [seq << 5 | 0, length, 6 data bytes]
+ *   frame n    [seq << 5 | n, 7 data bytes]        (last one padded with 0xFF)
+ *
+ * The 3-bit sequence counter advances per message of a PGN, so a receiver
+ * tells a new message from a lost frame.
+ *
+ * Build Flags:
+ *   -D N2K_NAME=0x...          - 64-bit NAME sent in Address Claimed (default 0xC064A000FFE00001 -
+ *                                arbitrary address capable, marine industry group, engine gateway,
+ *                                identity 1, no manufacturer code)
+ *   -D N2K_ENGINE_INSTANCE=n   - Engine instance of 127488 / 127489 (default 0, port or single engine)
+ */
+
+#ifndef NMEA2000_H
+#define NMEA2000_H
+
+#include <Arduino.h>
+
+#ifndef N2K_NAME
+#define N2K_NAME 0xC064A000FFE00001ULL
+#endif
+
+#ifndef N2K_ENGINE_INSTANCE
+#define N2K_ENGINE_INSTANCE 0
+#endif
+
+#define N2K_PGN_ISO_ACK             0xE800  // 59392 - NACK for PGNs requested of us
+#define N2K_PGN_HEARTBEAT           0x1F011 // 126993
+#define N2K_PGN_ENGINE_RAPID        0x1F200 // 127488
+#define N2K_PGN_ENGINE_DYNAMIC      0x1F201 // 127489
+#define N2K_PGN_TEMPERATURE         0x1FD08 // 130312
+
+#define N2K_MAX_ADDRESS             251     // Highest address a node claims (252-253 reserved)
+#define N2K_CLAIM_HOLDOFF_MS        250     // No data after a claim while others contend
+#define N2K_MAX_MESSAGE             26      // Longest message sent (127489)
+
+// Messages sent, in schedule order
+enum N2kMessage : uint8_t {
+    N2K_TX_ENGINE_RAPID = 0,
+    N2K_TX_ENGINE_DYNAMIC,
+    N2K_TX_TEMPERATURE,
+    N2K_TX_HEARTBEAT,
+    N2K_TX_MESSAGE_COUNT
+};
+
+struct N2kPgn {
+    uint32_t pgn;
+    uint8_t priority;
+    uint8_t length;             // Bytes - over 8 is sent as fast packet
+    uint16_t intervalMs;
+};
+
+struct N2kField {
+    uint8_t message;            // N2kMessage
+    uint8_t obd2pid;            // Input matched by its OBD-II PID
+    uint8_t start;              // First byte in the message
+    uint8_t width;              // 1 or 2 bytes, little-endian (0 = discrete status only)
+    bool isSigned;
+    uint8_t tag;                // 127489: discrete status 1 bit + 1 (0 = none); 130312: temperature source
+    float resolution;           // Standard units per bit
+    float offset;               // Standard units at raw 0
+};
+
+#define N2K_NO_FIELD 0xFF
+#define N2K_TEMPERATURE_FIELDS 4    // 130312 sources in the field table
+
+// A layout holds one message each of 127488 / 127489 and one per temperature input
+#define N2K_MAX_LAYOUT_MESSAGES (2 + 2 * N2K_TEMPERATURE_FIELDS)
+
+// Schedule and size of a message
+N2kPgn n2kGetPgn(uint8_t message);
+
+/**
+ * Field table entry for an OBD-II PID
+ * @return  Index for n2kGetField(), or N2K_NO_FIELD
+ */
+uint8_t n2kFindField(uint8_t obd2pid);
+
+// Copy of a table entry (the table lives in PROGMEM)
+N2kField n2kGetField(uint8_t index);
+
+/**
+ * Encode a value in standard units as the field's raw bytes
+ * NAN is "not available", a value above the field's range "out of range"
+ * (0xFFFE / 0x7FFE); unsigned fields clamp below at 0.
+ */
+void n2kEncodeField(const N2kField& field, float value, uint8_t* data);
+
+/**
+ * Fill a message with "not available" and its fixed bytes
+ * @param instance  Engine or temperature instance
+ * @param tag       130312: temperature source; heartbeat: sequence counter
+ */
+void n2kInitMessage(uint8_t message, uint8_t instance, uint8_t tag, uint8_t* data);
+
+// Frames a message of len bytes takes (1 when it fits a single frame)
+uint8_t n2kFastPacketFrames(uint8_t len);
+
+/**
+ * Build frame index of a fast-packet message
+ * @param seq    Sequence counter of the message (0-7)
+ * @param frame  8 bytes
+ */
+void n2kFastPacketFrame(const uint8_t* message, uint8_t len, uint8_t seq, uint8_t index, uint8_t* frame);
+
+#endif // NMEA2000_H
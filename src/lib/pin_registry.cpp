@@ -3,11 +3,16 @@
  *
  * Maintains a global registry of pin assignments to prevent conflicts.
  * See pin_registry.h for detailed API documentation.
+ *
+ * Lookups go through a bitmap of all 256 pin numbers (physical, CAN 0xC0-0xDF,
+ * ADC 0xE0-0xEF and I2C 0xF0-0xFF virtual pins) and, with PIN_REGISTRY_INDEX, a pin -> entry
+ * index, so conflict checks don't scan the registry.
  */
 
 #include "pin_registry.h"
 #include "message_api.h"
 #include "log_tags.h"
+#include "memory_report.h"
 #include "system_config.h"
 #include "../inputs/input_manager.h"
 #include <Arduino.h>
@@ -20,16 +25,46 @@
 static PinUsage pinRegistry[MAX_PIN_REGISTRY];
 static uint8_t registrySize = 0;
 
+// One bit per pin number: registered
+static uint8_t pinOccupied[32];
+
+#if PIN_REGISTRY_INDEX
+static uint8_t pinEntry[256];   // Registry index of each registered pin
+#endif
+
+static inline bool isOccupied(uint8_t pin) {
+    return pinOccupied[pin >> 3] & (1 << (pin & 7));
+}
+
+// Registry entry of a pin, or nullptr if it isn't registered
+static PinUsage* findEntry(uint8_t pin) {
+    if (!isOccupied(pin)) return nullptr;
+#if PIN_REGISTRY_INDEX
+    return &pinRegistry[pinEntry[pin]];
+#else
+    for (uint8_t i = 0; i < registrySize; i++) {
+        if (pinRegistry[i].pin == pin) return &pinRegistry[i];
+    }
+    return nullptr;
+#endif
+}
+
 // ============================================================================
 // INITIALIZATION
 // ============================================================================
 
 void initPinRegistry() {
     clearPinRegistry();
+#if PIN_REGISTRY_INDEX
+    noteStaticMemory(F("Pin registry"), sizeof(pinRegistry) + sizeof(pinOccupied) + sizeof(pinEntry));
+#else
+    noteStaticMemory(F("Pin registry"), sizeof(pinRegistry) + sizeof(pinOccupied));
+#endif
 }
 
 void clearPinRegistry() {
     registrySize = 0;
+    memset(pinOccupied, 0, sizeof(pinOccupied));
     for (uint8_t i = 0; i < MAX_PIN_REGISTRY; i++) {
         pinRegistry[i].pin = 0xFF;
         pinRegistry[i].type = PIN_UNUSED;
@@ -43,11 +78,8 @@ void clearPinRegistry() {
 
 bool registerPin(uint8_t pin, PinUsageType type, const char* description) {
     // Check if pin already registered
-    for (uint8_t i = 0; i < registrySize; i++) {
-        if (pinRegistry[i].pin == pin) {
-            // Pin already in use
-            return false;
-        }
+    if (isOccupied(pin)) {
+        return false;
     }
 
     // Check if registry is full
@@ -60,29 +92,33 @@ bool registerPin(uint8_t pin, PinUsageType type, const char* description) {
     pinRegistry[registrySize].pin = pin;
     pinRegistry[registrySize].type = type;
     pinRegistry[registrySize].description = description;
+#if PIN_REGISTRY_INDEX
+    pinEntry[pin] = registrySize;
+#endif
+    pinOccupied[pin >> 3] |= 1 << (pin & 7);
     registrySize++;
 
     return true;
 }
 
 void unregisterPin(uint8_t pin) {
-    // Find the pin in the registry
-    for (uint8_t i = 0; i < registrySize; i++) {
-        if (pinRegistry[i].pin == pin) {
-            // Remove by shifting remaining entries down
-            for (uint8_t j = i; j < registrySize - 1; j++) {
-                pinRegistry[j] = pinRegistry[j + 1];
-            }
-            registrySize--;
-
-            // Clear the last entry
-            pinRegistry[registrySize].pin = 0xFF;
-            pinRegistry[registrySize].type = PIN_UNUSED;
-            pinRegistry[registrySize].description = nullptr;
-
-            return;
-        }
+    PinUsage* entry = findEntry(pin);
+    if (!entry) return;
+
+    // Remove by shifting remaining entries down (keeps registration order)
+    for (uint8_t j = entry - pinRegistry; j < registrySize - 1; j++) {
+        pinRegistry[j] = pinRegistry[j + 1];
+#if PIN_REGISTRY_INDEX
+        pinEntry[pinRegistry[j].pin] = j;
+#endif
     }
+    registrySize--;
+    pinOccupied[pin >> 3] &= ~(1 << (pin & 7));
+
+    // Clear the last entry
+    pinRegistry[registrySize].pin = 0xFF;
+    pinRegistry[registrySize].type = PIN_UNUSED;
+    pinRegistry[registrySize].description = nullptr;
 }
 
 // ============================================================================
@@ -90,30 +126,17 @@ void unregisterPin(uint8_t pin) {
 // ============================================================================
 
 bool isPinAvailable(uint8_t pin) {
-    for (uint8_t i = 0; i < registrySize; i++) {
-        if (pinRegistry[i].pin == pin) {
-            return false;  // Pin is in use
-        }
-    }
-    return true;  // Pin is available
+    return !isOccupied(pin);
 }
 
 PinUsageType getPinUsage(uint8_t pin) {
-    for (uint8_t i = 0; i < registrySize; i++) {
-        if (pinRegistry[i].pin == pin) {
-            return pinRegistry[i].type;
-        }
-    }
-    return PIN_UNUSED;
+    const PinUsage* entry = findEntry(pin);
+    return entry ? entry->type : PIN_UNUSED;
 }
 
 const char* getPinDescription(uint8_t pin) {
-    for (uint8_t i = 0; i < registrySize; i++) {
-        if (pinRegistry[i].pin == pin) {
-            return pinRegistry[i].description;
-        }
-    }
-    return nullptr;
+    const PinUsage* entry = findEntry(pin);
+    return entry ? entry->description : nullptr;
 }
 
 // ============================================================================
@@ -127,8 +150,9 @@ bool validateNoPinConflict(uint8_t pin, PinUsageType newType, const char* newDes
     }
 
     // Pin is already in use - print detailed error message
-    PinUsageType existingType = getPinUsage(pin);
-    const char* existingDesc = getPinDescription(pin);
+    const PinUsage* existing = findEntry(pin);
+    PinUsageType existingType = existing->type;
+    const char* existingDesc = existing->description;
 
     msg.debug.error(TAG_SYSTEM, "Pin %d already in use", pin);
     msg.debug.error(TAG_SYSTEM, "  Current: %s%s%s%s",
@@ -213,7 +237,7 @@ const PinUsage* getPinUsageByIndex(uint8_t index) {
 // PIN STATUS DISPLAY
 // ============================================================================
 
-// Helper to print pin name (A0, CAN:0, I2C:0, or numeric)
+// Helper to print pin name (A0, CAN:0, ADC:0, I2C:0, or numeric)
 static void printPinName(uint8_t pin) {
     // Check for special Teensy pins first before virtual pin ranges
     if (pin == 254) {
@@ -225,6 +249,9 @@ static void printPinName(uint8_t pin) {
     } else if (pin >= 0xC0 && pin < 0xE0) {
         msg.control.print(F("CAN:"));
         msg.control.print(pin - 0xC0);
+    } else if (pin >= 0xE0) {
+        msg.control.print(F("ADC:"));
+        msg.control.print(pin - 0xE0);
     } else if (pin >= A0) {
         msg.control.print(F("A"));
         msg.control.print(pin - A0);
@@ -241,8 +268,8 @@ static void printPinPadded(uint8_t pin) {
     if (pin == 254) {
         // Teensy built-in SDIO pin - special case
         printPinName(pin);
-    } else if (pin >= 0xF0 || (pin >= 0xC0 && pin < 0xE0)) {
-        // Virtual pins like "CAN:0" or "I2C:15" - already at least 5 chars
+    } else if (pin >= 0xC0) {
+        // Virtual pins like "CAN:0", "ADC:3" or "I2C:15" - already at least 5 chars
         printPinName(pin);
     } else if (pin >= A0) {
         // Analog pins like "A0" - pad to 2 chars
@@ -280,8 +307,9 @@ void printPinStatus(uint8_t specificPin) {
         for (uint8_t i = 0; i < MAX_INPUTS; i++) {
             if (inputs[i].pin == specificPin && inputs[i].applicationIndex != 0xFF) {
                 printPinPadded(specificPin);
+                char name[INPUT_DISPLAY_NAME_LEN];
                 msg.control.print(F("Input     - "));
-                msg.control.print(inputs[i].displayName);
+                msg.control.print(getInputDisplayName(&inputs[i], name));
                 if (inputs[i].abbrName[0] != '\0') {
                     msg.control.print(F(" ("));
                     msg.control.print(inputs[i].abbrName);
@@ -386,8 +414,9 @@ void printPinStatus(uint8_t specificPin) {
                 hasInputs = true;
             }
             printPinPadded(inputs[i].pin);
+            char name[INPUT_DISPLAY_NAME_LEN];
             msg.control.print(F("Input     - "));
-            msg.control.print(inputs[i].displayName);
+            msg.control.print(getInputDisplayName(&inputs[i], name));
             if (inputs[i].abbrName[0] != '\0') {
                 msg.control.print(F(" ("));
                 msg.control.print(inputs[i].abbrName);
@@ -26,6 +26,9 @@
  *   if (validateNoPinConflict(A0, PIN_INPUT, "Oil Pressure")) {
  *       registerPin(A0, PIN_INPUT, "Oil Pressure");
  *   }
+ *
+ * Build Flags:
+ *   -D PIN_REGISTRY_INDEX=0|1  - Pin -> entry index (default 1; 0 on AVR)
  */
 
 #ifndef PIN_REGISTRY_H
@@ -79,6 +82,17 @@ struct PinUsage {
 // Set to 64 to accommodate Teensy 4.1 (54 digital + 14 analog = 58 total)
 #define MAX_PIN_REGISTRY 64
 
+// Pin -> entry index (256 bytes) for constant-time getPinUsage() and
+// getPinDescription(). Without it those scan the registry for registered
+// pins; availability checks use the occupancy bitmap either way.
+#ifndef PIN_REGISTRY_INDEX
+#if defined(__AVR__)
+#define PIN_REGISTRY_INDEX 0
+#else
+#define PIN_REGISTRY_INDEX 1
+#endif
+#endif
+
 // ============================================================================
 // PUBLIC API
 // ============================================================================
@@ -16,7 +16,7 @@
     #define AREF_VOLTAGE 5.0    // Using VCC as reference
     #define ADC_RESOLUTION 10   // 10-bit ADC (0-1023)
     #define ADC_MAX_VALUE 1023
-    #define MAX_INPUTS 6        // Arduino Uno analog inputs
+    #define PLATFORM_MAX_INPUTS 6  // Arduino Uno analog inputs
 #elif defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
     // Arduino Mega - 5V system with 1.1V internal reference
     #define PLATFORM_NAME "Arduino Mega 2560"
@@ -26,7 +26,7 @@
     #define AREF_VOLTAGE 5.0
     #define ADC_RESOLUTION 10
     #define ADC_MAX_VALUE 1023
-    #define MAX_INPUTS 16       // Arduino Mega analog inputs
+    #define PLATFORM_MAX_INPUTS 16 // Arduino Mega analog inputs
 #elif defined(__MK20DX256__) || defined(__MK20DX128__)
     // Teensy 3.x - 3.3V system with 1.2V internal reference
     #define PLATFORM_NAME "Teensy 3.x"
@@ -36,7 +36,7 @@
     #define AREF_VOLTAGE 3.3    // Using VCC as reference
     #define ADC_RESOLUTION 12   // 12-bit ADC (0-4095)
     #define ADC_MAX_VALUE 4095
-    #define MAX_INPUTS 24       // Teensy 3.x analog inputs
+    #define PLATFORM_MAX_INPUTS 24 // Teensy 3.x analog inputs
 #elif defined(__MK64FX512__) || defined(__MK66FX1M0__)
     // Teensy 3.5/3.6 - can be 3.3V or 5V tolerant
     #define PLATFORM_NAME "Teensy 3.5/3.6"
@@ -46,7 +46,7 @@
     #define AREF_VOLTAGE 3.3    // Using VCC as reference
     #define ADC_RESOLUTION 12   // 12-bit ADC (0-4095)
     #define ADC_MAX_VALUE 4095
-    #define MAX_INPUTS 32       // Teensy 3.5/3.6 analog inputs
+    #define PLATFORM_MAX_INPUTS 32 // Teensy 3.5/3.6 analog inputs
 #elif defined(__IMXRT1062__)
     // Teensy 4.x - can be 3.3V or 5V tolerant
     #if defined(ARDUINO_TEENSY41)
@@ -62,7 +62,7 @@
     #define AREF_VOLTAGE 3.3    // Using VCC as reference
     #define ADC_RESOLUTION 12   // 12-bit ADC (0-4095)
     #define ADC_MAX_VALUE 4095
-    #define MAX_INPUTS 40       // Teensy 4.x analog inputs
+    #define PLATFORM_MAX_INPUTS 40 // Teensy 4.x analog inputs
 #elif defined(ARDUINO_SAM_DUE)
     // Arduino Due
     #define PLATFORM_NAME "Arduino Due"
@@ -72,7 +72,7 @@
     #define AREF_VOLTAGE 3.3
     #define ADC_RESOLUTION 12
     #define ADC_MAX_VALUE 4095
-    #define MAX_INPUTS 12       // Arduino Due analog inputs
+    #define PLATFORM_MAX_INPUTS 12 // Arduino Due analog inputs
 #elif defined(ESP32)
     // ESP32
     #define PLATFORM_NAME "ESP32"
@@ -82,7 +82,17 @@
     #define AREF_VOLTAGE 3.3
     #define ADC_RESOLUTION 12
     #define ADC_MAX_VALUE 4095
-    #define MAX_INPUTS 32       // ESP32 analog inputs
+    #define PLATFORM_MAX_INPUTS 32 // ESP32 analog inputs
+#elif defined(PREOBD_NATIVE)
+    // Host simulator (env:native) - ADC readings come from a recorded trace
+    #define PLATFORM_NAME "Native Simulator"
+    #define I2C_CLOCK_SPEED "400kHz"
+    #define SYSTEM_VOLTAGE 3.3
+    #define SYSTEM_VOLTAGE_MV 3300
+    #define AREF_VOLTAGE 3.3    // SIM_AREF_VOLTAGE in sim/src/sim_core.cpp
+    #define ADC_RESOLUTION 12
+    #define ADC_MAX_VALUE 4095
+    #define PLATFORM_MAX_INPUTS 16 // A0-A15
 #else
     // Default safe values for unknown platforms
     #define PLATFORM_NAME "Unknown"
@@ -92,7 +102,18 @@
     #define AREF_VOLTAGE 3.3
     #define ADC_RESOLUTION 10
     #define ADC_MAX_VALUE 1023
-    #define MAX_INPUTS 8        // Default/Unknown platform
+    #define PLATFORM_MAX_INPUTS 8  // Default/Unknown platform
+#endif
+
+// ===== INPUT CAPACITY =====
+// Input slots (inputs[]), the board's count unless -D MAX_INPUTS=n asks for
+// more - CAN imports, I2C and math channels take slots without a pin of
+// their own. Slot numbers are 8-bit and the config log keys 0xFD up special.
+#ifndef MAX_INPUTS
+    #define MAX_INPUTS PLATFORM_MAX_INPUTS
+#endif
+#if MAX_INPUTS > 252
+    #error "MAX_INPUTS is at most 252"
 #endif
 
 // ===== VOLTAGE DIVIDER CONFIGURATION =====
@@ -0,0 +1,237 @@
+/*
+ * power_fail.cpp - Supply loss detection and emergency flush
+ */
+
+#include "power_fail.h"
+
+#ifdef ENABLE_POWER_FAIL
+
+#include "message_api.h"
+#include "log_tags.h"
+#include "scheduler.h"
+#include "watchdog.h"
+#include "pin_registry.h"
+#include "eeprom_store.h"
+#include "../hal/hal_placement.h"
+#include "../inputs/input_manager.h"
+#include "../inputs/input_stats.h"
+#ifdef ENABLE_ALARMS
+#include "../inputs/alarm_journal.h"
+#endif
+#ifdef POWER_FAIL_ADC_PIN
+#include "adc_scan.h"
+#endif
+#ifdef ENABLE_RAW_TRACE
+#include "raw_trace.h"
+#endif
+
+extern void closeSDLog();
+extern void reopenSDLog();
+
+#ifdef POWER_FAIL_ADC_PIN
+// Counts below which the supply is failing, and above which it is back
+// (0.5 V of hysteresis so ripple at the threshold doesn't chatter)
+#define POWER_FAIL_COUNTS(volts) \
+    ((int)((volts) / POWER_FAIL_DIVIDER / AREF_VOLTAGE * ADC_MAX_VALUE))
+#define POWER_FAIL_LOW_COUNTS     POWER_FAIL_COUNTS(POWER_FAIL_THRESHOLD_V)
+#define POWER_FAIL_GOOD_COUNTS    POWER_FAIL_COUNTS(POWER_FAIL_THRESHOLD_V + 0.5f)
+#endif
+
+static volatile bool failSignalled = false;  // Comparator edge, set by the ISR
+static bool testRequested = false;
+static bool parked = false;             // Emergency path has run - waiting for the supply
+static uint32_t goodSinceMs = 0;        // Supply back since (0 = still low)
+
+#ifdef POWER_FAIL_ADC_PIN
+static uint32_t lastPollMs = 0;
+static int lastCounts = -1;
+#endif
+
+static uint16_t failCount = 0;
+static uint16_t resumeCount = 0;
+static uint32_t lastFailMs = 0;
+static uint32_t lastPathUs = 0;         // Emergency path of the last failure
+static uint32_t worstPathUs = 0;
+static bool lastWasTest = false;
+static bool configFinished = false;     // Last failure had to finish a config batch
+
+// ===== DETECTION =====
+
+#ifdef POWER_FAIL_PIN
+HAL_ISR static void powerFailISR() {
+    failSignalled = true;
+}
+#endif
+
+// Supply below the threshold now (no detection configured: never)
+static bool supplyLow(uint32_t now) {
+#if defined(POWER_FAIL_PIN)
+    (void)now;
+    return digitalRead(POWER_FAIL_PIN) == POWER_FAIL_ACTIVE;
+#elif defined(POWER_FAIL_ADC_PIN)
+    if (lastCounts < 0 || now - lastPollMs >= POWER_FAIL_POLL_MS) {
+        lastPollMs = now;
+        lastCounts = readAdcNow(POWER_FAIL_ADC_PIN);
+    }
+    // Parked: low until it clears the hysteresis band
+    return lastCounts < (parked ? POWER_FAIL_GOOD_COUNTS : POWER_FAIL_LOW_COUNTS);
+#else
+    (void)now;
+    return false;
+#endif
+}
+
+// ===== EMERGENCY PATH =====
+
+static void emergencyFlush(bool test) {
+    uint32_t start = micros();
+    parked = true;
+    goodSinceMs = 0;
+
+    closeSDLog();           // Staged sectors to the card, file closed
+#ifdef ENABLE_RAW_TRACE
+    stopRawTrace();
+#endif
+#ifdef ENABLE_ALARMS
+    flushAlarmJournal();
+#endif
+    flushInputStats();
+    configFinished = isEEPROMStoreWriting();
+    if (configFinished) flushEEPROMStore();  // Finish a batch part-way into EEPROM; one not started waits
+
+    lastPathUs = micros() - start;
+    if (lastPathUs > worstPathUs) worstPathUs = lastPathUs;
+    lastFailMs = millis();
+    lastWasTest = test;
+    failCount++;
+
+    // Messages after the flush - the supply may not last through them
+    msg.debug.warn(TAG_SYSTEM, "Supply failing - log closed, journals written in %lu us",
+                   (unsigned long)lastPathUs);
+    if (lastPathUs > (uint32_t)POWER_FAIL_HOLDUP_MS * 1000UL) {
+        msg.debug.warn(TAG_SYSTEM, "Emergency path took longer than the %d ms hold-up", POWER_FAIL_HOLDUP_MS);
+    }
+}
+
+// Supply back - inputs due at once, the log on its next segment
+static void resume(uint32_t now) {
+    parked = false;
+    failSignalled = false;
+    resumeCount++;
+    for (uint8_t i = 0; i < numScheduledInputs; i++) {
+        inputSchedule[i].nextDue = now;
+        inputSchedule[i].readyAt = 0;   // A conversion started before the dip is stale
+    }
+    for (uint8_t id = 0; id < getNumScheduledTasks(); id++) {
+        setTaskDeadline(id, now);
+    }
+    watchdogRestartHeartbeats();        // Nothing checked in while parked
+    reopenSDLog();
+    msg.debug.info(TAG_SYSTEM, "Supply restored after %lu ms - resuming", (unsigned long)(now - lastFailMs));
+}
+
+// ===== PUBLIC API =====
+
+void initPowerFail() {
+#if defined(POWER_FAIL_PIN)
+    registerPin(POWER_FAIL_PIN, PIN_RESERVED, "Power fail sense");
+    pinMode(POWER_FAIL_PIN, INPUT);
+    int irq = digitalPinToInterrupt(POWER_FAIL_PIN);
+    if (irq == NOT_AN_INTERRUPT) {
+        msg.debug.warn(TAG_SYSTEM, "Power fail pin %d has no interrupt - polled each loop", POWER_FAIL_PIN);
+    } else {
+        attachInterrupt(irq, powerFailISR, POWER_FAIL_ACTIVE == LOW ? FALLING : RISING);
+    }
+#elif defined(POWER_FAIL_ADC_PIN)
+    registerPin(POWER_FAIL_ADC_PIN, PIN_RESERVED, "Power fail supply sense");
+#else
+    msg.debug.warn(TAG_SYSTEM, "Power fail built without POWER_FAIL_PIN or POWER_FAIL_ADC_PIN - SYSTEM POWER FAIL only");
+#endif
+}
+
+bool updatePowerFail(uint32_t now) {
+    if (!parked) {
+        bool test = testRequested;
+        testRequested = false;
+        if (!test && !failSignalled && !supplyLow(now)) return false;
+        emergencyFlush(test);
+        return true;
+    }
+
+    // Parked - keep the hardware watchdog fed until the supply is back or gone
+    watchdogReset();
+    bool low = supplyLow(now);
+    if (failSignalled && !low) failSignalled = false;  // An edge from the dip itself
+    if (low || failSignalled) {
+        goodSinceMs = 0;
+        return true;
+    }
+    if (goodSinceMs == 0) goodSinceMs = now ? now : 1;
+    if (now - goodSinceMs < POWER_FAIL_RECOVER_MS) return true;
+    resume(now);
+    return true;   // The pass starts over with everything due
+}
+
+bool isPowerFailing() {
+    return parked || failSignalled;
+}
+
+void requestPowerFailTest() {
+    testRequested = true;
+}
+
+void printPowerFailStatus() {
+    uint32_t now = millis();
+
+    msg.control.println();
+    msg.control.println(F("=== POWER FAIL ==="));
+    msg.control.print(F("Detection:  "));
+#if defined(POWER_FAIL_PIN)
+    msg.control.print(F("comparator on pin "));
+    msg.control.print(POWER_FAIL_PIN);
+    msg.control.print(F(", failing when "));
+    msg.control.println(POWER_FAIL_ACTIVE == LOW ? F("LOW") : F("HIGH"));
+#elif defined(POWER_FAIL_ADC_PIN)
+    msg.control.print(F("ADC pin "));
+    msg.control.print(POWER_FAIL_ADC_PIN);
+    msg.control.print(F(", failing below "));
+    msg.control.print(POWER_FAIL_THRESHOLD_V, 1);
+    msg.control.println(F(" V"));
+    msg.control.print(F("Supply:     "));
+    supplyLow(now);
+    msg.control.print(lastCounts * (float)POWER_FAIL_DIVIDER * AREF_VOLTAGE / ADC_MAX_VALUE, 2);
+    msg.control.println(F(" V"));
+#else
+    msg.control.println(F("none (SYSTEM POWER FAIL only)"));
+#endif
+
+    msg.control.print(F("State:      "));
+    msg.control.println(parked ? F("parked, waiting for the supply") : (supplyLow(now) ? F("low") : F("good")));
+
+    msg.control.print(F("Failures:   "));
+    msg.control.print(failCount);
+    msg.control.print(F(", resumed "));
+    msg.control.println(resumeCount);
+    if (failCount > 0) {
+        msg.control.print(F("Last:       "));
+        msg.control.print((now - lastFailMs) / 1000);
+        msg.control.print(lastWasTest ? F(" s ago (test), flush ") : F(" s ago, flush "));
+        msg.control.print(lastPathUs);
+        msg.control.print(F(" us (worst "));
+        msg.control.print(worstPathUs);
+        msg.control.println(F(" us)"));
+        if (configFinished) msg.control.println(F("            A config batch was being written and was finished"));
+    }
+    msg.control.print(F("Hold-up:    "));
+    msg.control.print(POWER_FAIL_HOLDUP_MS);
+    msg.control.print(F(" ms"));
+    if (worstPathUs > (uint32_t)POWER_FAIL_HOLDUP_MS * 1000UL) msg.control.print(F(" - EXCEEDED"));
+    msg.control.println();
+    if (getEEPROMStorePending() > 0) {
+        msg.control.print(F("Config:     "));
+        msg.control.print(getEEPROMStorePending());
+        msg.control.println(F(" bytes queued"));
+    }
+}
+
+#endif // ENABLE_POWER_FAIL
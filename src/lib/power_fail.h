@@ -0,0 +1,126 @@
+/*
+ * power_fail.h - Supply loss detection and emergency flush
+ *
+ * Key-off and a deep cranking dip cut the supply without warning. Without
+ * this, whatever the SD log had staged since its last sync is lost, as are
+ * alarm journal events and accumulator totals still waiting in RAM. The
+ * power-fail service watches the supply and, when it drops, spends the
+ * regulator's hold-up time on the emergency path:
+ *
+ *   1. Acquisition and outputs stop (the loop is parked in updatePowerFail())
+ *   2. The SD log's staging buffers are written and the file closed
+ *      (a raw trace recording too)
+ *   3. Queued alarm journal events are written (alarm_journal.h)
+ *   4. A snapshot of the accumulators is written (input_stats.h)
+ *   5. A config batch already being written is finished (eeprom_store.h)
+ *
+ * in that order - the log holds the most data, the config batch is the
+ * least likely to be pending. The time the path took is kept (SYSTEM POWER)
+ * and compared with POWER_FAIL_HOLDUP_MS, the hold-up the supply is
+ * designed for, so a bench test shows whether it fits.
+ *
+ * Detection, one of:
+ *   Comparator  POWER_FAIL_PIN goes to POWER_FAIL_ACTIVE (default LOW) - a
+ *               supervisor or comparator output on the unregulated supply.
+ *               An interrupt flags it; the path runs at the top of the next
+ *               loop pass, at most one pass (the loop budget) later.
+ *   ADC         POWER_FAIL_ADC_PIN, through a divider of POWER_FAIL_DIVIDER,
+ *               reads below POWER_FAIL_THRESHOLD_V - polled at the top of
+ *               every loop pass, a conversion every POWER_FAIL_POLL_MS.
+ *
+ * A config batch that hasn't started when the supply fails is left queued
+ * (a SAVE that didn't reach EEPROM, not a torn one), and SAVE is refused
+ * while the supply is low.
+ *
+ * Recovery: a dip the MCU rode through - the supply back for
+ * POWER_FAIL_RECOVER_MS - resumes: the SD log opens its next segment and
+ * every input is made due at once. SYSTEM POWER FAIL runs the whole path on
+ * the bench with the supply good, so it resumes the same way.
+ *
+ * With power fail built the SD log can sync less often: SD_LOG_SYNC_MS
+ * defaults to 30 s instead of 5 s, fewer partly filled sectors for the card.
+ *
+ * Usage:
+ *   initPowerFail();                   // setup(), after the outputs
+ *   if (updatePowerFail(now)) return;  // top of loop() - supply failing, parked
+ *   if (isPowerFailing()) ...          // SAVE refuses
+ *
+ * Build Flags:
+ *   -D ENABLE_POWER_FAIL            - Compile the power-fail service
+ *   -D POWER_FAIL_PIN=n             - Comparator / supervisor output (interrupt)
+ *   -D POWER_FAIL_ACTIVE=LOW|HIGH   - Level that means the supply is failing (default LOW)
+ *   -D POWER_FAIL_ADC_PIN=n         - Analog supply sense instead (not with POWER_FAIL_PIN)
+ *   -D POWER_FAIL_DIVIDER=r         - Divider in front of that pin (default VOLTAGE_DIVIDER_RATIO)
+ *   -D POWER_FAIL_THRESHOLD_V=v     - Supply below which it is failing (default 9.0)
+ *   -D POWER_FAIL_POLL_MS=n         - Time between ADC checks (default 1)
+ *   -D POWER_FAIL_RECOVER_MS=n      - Supply good this long before resuming (default 500)
+ *   -D POWER_FAIL_HOLDUP_MS=n       - Hold-up time the emergency path must fit in (default 50)
+ */
+
+#ifndef POWER_FAIL_H
+#define POWER_FAIL_H
+
+#include <Arduino.h>
+
+#ifdef ENABLE_POWER_FAIL
+
+#include "platform.h"
+
+#if defined(POWER_FAIL_PIN) && defined(POWER_FAIL_ADC_PIN)
+#error "Power fail: define POWER_FAIL_PIN or POWER_FAIL_ADC_PIN, not both"
+#endif
+
+#ifdef ENABLE_DUAL_CORE
+#error "ENABLE_POWER_FAIL can't stop the acquisition core - build without ENABLE_DUAL_CORE"
+#endif
+
+#ifndef POWER_FAIL_ACTIVE
+#define POWER_FAIL_ACTIVE LOW
+#endif
+
+#ifndef POWER_FAIL_DIVIDER
+#define POWER_FAIL_DIVIDER VOLTAGE_DIVIDER_RATIO
+#endif
+
+#ifndef POWER_FAIL_THRESHOLD_V
+#define POWER_FAIL_THRESHOLD_V 9.0f
+#endif
+
+#ifndef POWER_FAIL_POLL_MS
+#define POWER_FAIL_POLL_MS 1
+#endif
+
+#ifndef POWER_FAIL_RECOVER_MS
+#define POWER_FAIL_RECOVER_MS 500
+#endif
+
+#ifndef POWER_FAIL_HOLDUP_MS
+#define POWER_FAIL_HOLDUP_MS 50
+#endif
+
+// Arm the comparator interrupt / ADC threshold
+void initPowerFail();
+
+/**
+ * Check the supply; when it fails run the emergency path, then stay parked
+ * until it has been back for POWER_FAIL_RECOVER_MS
+ * @return true while parked - the caller skips the rest of the loop
+ */
+bool updatePowerFail(uint32_t now);
+
+// The supply is failing or the emergency path has run and not yet resumed
+bool isPowerFailing();
+
+// Run the emergency path on the next updatePowerFail() (SYSTEM POWER FAIL)
+void requestPowerFailTest();
+
+// Detection, supply, events and emergency path timing (SYSTEM POWER)
+void printPowerFailStatus();
+
+#else
+
+inline bool isPowerFailing() { return false; }
+
+#endif // ENABLE_POWER_FAIL
+
+#endif // POWER_FAIL_H
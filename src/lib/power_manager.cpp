@@ -0,0 +1,302 @@
+/*
+ * power_manager.cpp - Engine-off low-power mode
+ */
+
+#include "power_manager.h"
+
+#ifdef ENABLE_POWER_MANAGER
+
+#include "message_api.h"
+#include "log_tags.h"
+#include "scheduler.h"
+#include "watchdog.h"
+#include "pin_registry.h"
+#include "../hal/hal_sleep.h"
+#include "../hal/hal_can.h"
+#include "../inputs/input.h"
+#include "../inputs/input_manager.h"
+#include "../outputs/output_base.h"
+#include <math.h>
+#ifdef ENABLE_CAN
+#include "can_rx.h"
+#endif
+
+// Wake pins: the ignition sense and one per CAN bus
+#ifdef ENABLE_CAN
+#define POWER_MAX_WAKE_PINS (1 + CAN_RX_MAX_BUSES)
+#else
+#define POWER_MAX_WAKE_PINS 1
+#endif
+
+// Sources are looked at this often - nothing here needs the loop rate
+#define POWER_CHECK_INTERVAL_MS 100
+
+static uint32_t lastOnMs = 0;           // Last time a source said the engine runs
+static uint32_t lastCheckMs = 0;
+static bool sleepRequested = false;
+
+#ifdef ENABLE_CAN
+static uint32_t lastCanFrames = 0;
+static uint32_t lastCanFrameMs = 0;
+static bool canSeen = false;            // A frame arrived this boot - CAN is a source
+#endif
+
+static uint16_t sleepCount = 0;
+static uint32_t asleepMs = 0;           // Total time asleep
+static uint32_t wokeAtMs = 0;
+static uint32_t lastSleepMs = 0;        // Length of the last sleep
+static PowerWakeReason wakeReason = POWER_WAKE_NONE;
+static bool awaitingFirstData = false;
+static uint32_t firstDataMs = 0;        // Wake to first telemetry send, last wake
+static uint32_t worstFirstDataMs = 0;
+
+// ===== ENGINE STATE =====
+
+static bool ignitionOn() {
+#ifdef POWER_IGNITION_PIN
+    return digitalRead(POWER_IGNITION_PIN) == HIGH;
+#else
+    return false;
+#endif
+}
+
+// Enabled RPM inputs: -1 none configured, 0 all at or below the threshold, 1 one above
+static int8_t rpmState() {
+    int8_t state = -1;
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        const Input* input = &inputs[i];
+        if (!input->flags.isEnabled || input->measurementType != MEASURE_RPM) continue;
+        if (!isnan(input->value) && input->value > POWER_RPM_THRESHOLD) return 1;
+        state = 0;
+    }
+    return state;
+}
+
+#ifdef ENABLE_CAN
+static uint32_t canFrameTotal() {
+    uint32_t total = 0;
+    for (uint8_t bus = 0; bus < CAN_RX_MAX_BUSES; bus++) {
+        CANRxBusStats stats;
+        if (getCANRxBusStats(bus, &stats)) total += stats.frames;
+    }
+    return total;
+}
+
+static bool canActive(uint32_t now) {
+    uint32_t frames = canFrameTotal();
+    if (frames != lastCanFrames) {
+        lastCanFrames = frames;
+        lastCanFrameMs = now;
+        canSeen = true;
+    }
+    return canSeen && (now - lastCanFrameMs) < POWER_CAN_SILENCE_MS;
+}
+#endif
+
+static bool hasWakeSource() {
+#ifdef POWER_IGNITION_PIN
+    return true;
+#elif defined(ENABLE_CAN)
+    return canSeen;
+#else
+    return false;
+#endif
+}
+
+static bool engineOn(uint32_t now) {
+    bool on = ignitionOn() || rpmState() > 0;
+#ifdef ENABLE_CAN
+    if (canActive(now)) on = true;   // Always sampled - keeps the frame count current
+#else
+    (void)now;
+#endif
+    return on;
+}
+
+// ===== SLEEP =====
+
+static bool activityWhileAsleep() {
+#ifdef ENABLE_CAN
+    for (uint8_t bus = 0; bus < CAN_RX_MAX_BUSES; bus++) {
+        if (hal::can::activity(bus)) {
+            wakeReason = POWER_WAKE_CAN;
+            return true;
+        }
+    }
+#endif
+    if (Serial.available() > 0) {
+        wakeReason = POWER_WAKE_SERIAL;
+        return true;
+    }
+    return false;
+}
+
+// Everything due now - the first pass after a wake reads every input and sends
+static void resumeSchedules(uint32_t now) {
+    for (uint8_t i = 0; i < numScheduledInputs; i++) {
+        inputSchedule[i].nextDue = now;
+        inputSchedule[i].readyAt = 0;   // A conversion started before sleeping is stale
+    }
+    for (uint8_t id = 0; id < getNumScheduledTasks(); id++) {
+        setTaskDeadline(id, now);
+    }
+}
+
+static void sleepUntilWake() {
+    msg.debug.info(TAG_SYSTEM, "Engine off - sleeping");
+    updateOutputs();   // Drain staged output (SD log, transport rings) while still awake
+    Serial.flush();
+
+    hal::WakePin pins[POWER_MAX_WAKE_PINS];
+    uint8_t count = 0;
+#ifdef POWER_IGNITION_PIN
+    pins[count++] = { POWER_IGNITION_PIN, HIGH };
+#endif
+#ifdef ENABLE_CAN
+    for (uint8_t bus = 0; bus < CAN_RX_MAX_BUSES; bus++) {
+        uint8_t pin = hal::can::sleep(bus);
+        if (pin != HAL_CAN_NO_WAKE_PIN) {
+            pinMode(pin, INPUT_PULLUP);
+            pins[count++] = { pin, LOW };
+        }
+    }
+#endif
+
+    uint32_t start = millis();
+    wakeReason = POWER_WAKE_NONE;
+    while (!hal::sleepUntilWake(pins, count, POWER_SLEEP_SLICE_MS, activityWhileAsleep)) {
+        watchdogReset();
+    }
+    watchdogReset();
+    if (wakeReason == POWER_WAKE_NONE) {
+        wakeReason = ignitionOn() ? POWER_WAKE_IGNITION : POWER_WAKE_CAN;  // A pin woke it
+    }
+
+#ifdef ENABLE_CAN
+    for (uint8_t bus = 0; bus < CAN_RX_MAX_BUSES; bus++) {
+        hal::can::wake(bus);
+    }
+#endif
+
+    uint32_t now = millis();
+    lastSleepMs = now - start;
+    asleepMs += lastSleepMs;
+    sleepCount++;
+    wokeAtMs = now;
+    awaitingFirstData = true;
+    lastOnMs = now;   // Awake at least POWER_OFF_DELAY_MS
+#ifdef ENABLE_CAN
+    lastCanFrames = canFrameTotal();
+    lastCanFrameMs = now;
+#endif
+    resumeSchedules(now);
+    watchdogRestartHeartbeats();  // Nothing checked in while asleep
+}
+
+// ===== PUBLIC API =====
+
+void initPowerManager() {
+#ifdef POWER_IGNITION_PIN
+    registerPin(POWER_IGNITION_PIN, PIN_RESERVED, "Ignition sense");
+    pinMode(POWER_IGNITION_PIN, INPUT);
+#endif
+    lastOnMs = millis();
+}
+
+bool updatePowerManager(uint32_t now) {
+    if (now - lastCheckMs < POWER_CHECK_INTERVAL_MS && !sleepRequested) return false;
+    lastCheckMs = now;
+    if (engineOn(now)) {
+        lastOnMs = now;
+        return false;
+    }
+    if (!sleepRequested && (now - lastOnMs < POWER_OFF_DELAY_MS || !hasWakeSource())) {
+        return false;
+    }
+    sleepRequested = false;
+    sleepUntilWake();
+    return true;
+}
+
+void notePowerOutput(uint32_t now) {
+    if (!awaitingFirstData) return;
+    awaitingFirstData = false;
+    firstDataMs = now - wokeAtMs;
+    if (firstDataMs > worstFirstDataMs) worstFirstDataMs = firstDataMs;
+}
+
+bool requestPowerSleep() {
+    if (!hasWakeSource()) return false;
+    sleepRequested = true;
+    return true;
+}
+
+void printPowerStatus() {
+    uint32_t now = millis();
+    int8_t rpm = rpmState();
+
+    msg.control.println();
+    msg.control.println(F("=== POWER ==="));
+    msg.control.print(F("Engine:     "));
+    msg.control.print(engineOn(now) ? F("on") : F("off"));
+    msg.control.print(F(" (last on "));
+    msg.control.print((now - lastOnMs) / 1000);
+    msg.control.print(F(" s ago, sleep after "));
+    msg.control.print((uint32_t)(POWER_OFF_DELAY_MS / 1000));
+    msg.control.println(F(" s)"));
+
+    msg.control.print(F("Ignition:   "));
+#ifdef POWER_IGNITION_PIN
+    msg.control.print(ignitionOn() ? F("on") : F("off"));
+    msg.control.print(F(" (pin "));
+    msg.control.print(POWER_IGNITION_PIN);
+    msg.control.println(F(")"));
+#else
+    msg.control.println(F("not configured"));
+#endif
+
+    msg.control.print(F("RPM:        "));
+    if (rpm < 0) msg.control.println(F("no RPM input"));
+    else msg.control.println(rpm > 0 ? F("above threshold") : F("at or below threshold"));
+
+    msg.control.print(F("CAN:        "));
+#ifdef ENABLE_CAN
+    if (!canSeen) {
+        msg.control.println(F("no frames seen"));
+    } else {
+        msg.control.print(F("last frame "));
+        msg.control.print(now - lastCanFrameMs);
+        msg.control.println(F(" ms ago"));
+    }
+#else
+    msg.control.println(F("not compiled"));
+#endif
+    if (!hasWakeSource()) {
+        msg.control.println(F("No wake source - will not sleep"));
+    }
+
+    msg.control.print(F("Sleeps:     "));
+    msg.control.print(sleepCount);
+    msg.control.print(F(", "));
+    msg.control.print(asleepMs / 1000);
+    msg.control.println(F(" s asleep"));
+    if (sleepCount > 0) {
+        static const char* const REASONS[] = { "-", "ignition", "CAN", "serial" };
+        msg.control.print(F("Last wake:  "));
+        msg.control.print(REASONS[wakeReason]);
+        msg.control.print(F(" after "));
+        msg.control.print(lastSleepMs / 1000);
+        msg.control.print(F(" s, first data "));
+        if (awaitingFirstData) {
+            msg.control.print(F("pending"));
+        } else {
+            msg.control.print(firstDataMs);
+            msg.control.print(F(" ms (worst "));
+            msg.control.print(worstFirstDataMs);
+            msg.control.print(F(" ms)"));
+        }
+        msg.control.println();
+    }
+}
+
+#endif // ENABLE_POWER_MANAGER
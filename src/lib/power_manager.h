@@ -0,0 +1,107 @@
+/*
+ * power_manager.h - Engine-off low-power mode
+ *
+ * A unit wired to permanent battery power would otherwise run its loop flat
+ * out in a parked vehicle. The power manager watches for the engine to stop
+ * and, after POWER_OFF_DELAY_MS with every source agreeing, sleeps until the
+ * vehicle wakes up again:
+ *
+ *   Engine on while any of:
+ *     Ignition  POWER_IGNITION_PIN is HIGH (when defined)
+ *     RPM       an enabled RPM input reads above POWER_RPM_THRESHOLD
+ *     CAN       frames arrived in the last POWER_CAN_SILENCE_MS (once any
+ *               frame has been seen this boot)
+ *
+ * Asleep, sensor acquisition and outputs stop (the loop is parked in
+ * updatePowerManager()), buffered output is drained first, and every CAN
+ * controller goes into its wake-on-activity mode (hal::can::sleep()):
+ *   MCP2515   Sleep mode, WAKIF on the first bus edge pulls INT low
+ *   TWAI      Controller stopped, the RX pin wakes the chip from light sleep
+ *   FlexCAN   Keeps receiving; its RX interrupt ends the CPU's WFI
+ * The MCU sleeps in hal::sleepUntilWake() (hal/hal_sleep.h) slices of
+ * POWER_SLEEP_SLICE_MS, feeding the watchdog between them. It wakes on the
+ * ignition pin, CAN activity or a character on the USB serial port.
+ *
+ * Nothing reboots: RAM, configuration and the transports survive, and on
+ * wake every input and scheduled task is made due at once, so the first
+ * data goes out on the next loop pass. The time from waking to the first
+ * telemetry send is kept (SYSTEM POWER) - the target is under 200 ms,
+ * which holds while no input needs a long warm-up. The engine-off timer
+ * restarts on wake, so the unit stays up at least POWER_OFF_DELAY_MS.
+ *
+ * With no wake source (no ignition pin and no CAN frame seen) the unit never
+ * sleeps - an RPM input says when the engine stops, but nothing could say
+ * when it starts again.
+ *
+ * Usage:
+ *   initPowerManager();
+ *   if (updatePowerManager(now)) return;  // loop(), RUN mode - slept and woke
+ *   notePowerOutput(millis());             // After a telemetry send
+ *
+ * Build Flags:
+ *   -D ENABLE_POWER_MANAGER         - Compile the power manager (not with ENABLE_DUAL_CORE)
+ *   -D POWER_IGNITION_PIN=n         - Digital ignition sense, HIGH = on (default none)
+ *   -D POWER_RPM_THRESHOLD=n        - RPM above which the engine runs (default 100)
+ *   -D POWER_CAN_SILENCE_MS=n       - CAN quiet this long counts as off (default 5000)
+ *   -D POWER_OFF_DELAY_MS=n         - Engine off this long before sleeping (default 60000)
+ *   -D POWER_SLEEP_SLICE_MS=n       - Sleep between watchdog feeds (default 500, under 2000)
+ */
+
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <Arduino.h>
+
+#ifdef ENABLE_POWER_MANAGER
+
+#ifdef ENABLE_DUAL_CORE
+#error "ENABLE_POWER_MANAGER can't park the acquisition core - build without ENABLE_DUAL_CORE"
+#endif
+
+#ifndef POWER_RPM_THRESHOLD
+#define POWER_RPM_THRESHOLD 100
+#endif
+
+#ifndef POWER_CAN_SILENCE_MS
+#define POWER_CAN_SILENCE_MS 5000
+#endif
+
+#ifndef POWER_OFF_DELAY_MS
+#define POWER_OFF_DELAY_MS 60000UL
+#endif
+
+#ifndef POWER_SLEEP_SLICE_MS
+#define POWER_SLEEP_SLICE_MS 500
+#endif
+
+static_assert(POWER_SLEEP_SLICE_MS < 2000, "POWER_SLEEP_SLICE_MS must be under the 2 s watchdog");
+
+enum PowerWakeReason : uint8_t {
+    POWER_WAKE_NONE = 0,        // Not slept yet
+    POWER_WAKE_IGNITION,
+    POWER_WAKE_CAN,
+    POWER_WAKE_SERIAL
+};
+
+void initPowerManager();
+
+/**
+ * Check the engine-off sources; once off for POWER_OFF_DELAY_MS (or after
+ * SYSTEM POWER SLEEP) sleep here until a wake source fires
+ * @return true if it slept - the caller's now is stale
+ */
+bool updatePowerManager(uint32_t now);
+
+// A telemetry send went out - the first after a wake is time-to-first-data
+void notePowerOutput(uint32_t now);
+
+// Sleep on the next updatePowerManager(), whatever the sources say (SYSTEM POWER SLEEP)
+// Returns false if there is no wake source to come back on
+bool requestPowerSleep();
+
+// Sources, engine state, sleeps and wake timing (SYSTEM POWER)
+void printPowerStatus();
+
+#endif // ENABLE_POWER_MANAGER
+
+#endif // POWER_MANAGER_H
@@ -0,0 +1,131 @@
+/*
+ * profiler.cpp - Loop and per-task execution-time profiler implementation
+ */
+
+#include "profiler.h"
+
+#ifdef ENABLE_PROFILER
+
+#include "message_api.h"
+#include "isr_profile.h"
+#include "../inputs/input.h"
+#include "../inputs/input_manager.h"
+#include "../outputs/output_base.h"
+
+static ProfileStats profileStats[NUM_PROFILE_SLOTS];
+
+// Bucket index for a duration: 0 for <1us, otherwise bit length (clamped)
+static inline uint8_t bucketFor(uint32_t us) {
+    uint8_t bucket = 0;
+    while (us != 0 && bucket < PROFILE_NUM_BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void profilerRecord(uint8_t slot, uint32_t elapsed_us) {
+    if (slot >= NUM_PROFILE_SLOTS) return;
+
+    ProfileStats* s = &profileStats[slot];
+    if (s->count == 0 || elapsed_us < s->min_us) s->min_us = elapsed_us;
+    if (elapsed_us > s->max_us) s->max_us = elapsed_us;
+    s->count++;
+    s->total_us += elapsed_us;
+
+    uint8_t bucket = bucketFor(elapsed_us);
+    if (s->histogram[bucket] < 0xFFFF) s->histogram[bucket]++;
+}
+
+void profilerReset() {
+    memset(profileStats, 0, sizeof(profileStats));
+#ifdef ENABLE_ISR_PROFILER
+    isrProfileReset();
+#endif
+}
+
+const ProfileStats* getProfileStats(uint8_t slot) {
+    return (slot < NUM_PROFILE_SLOTS) ? &profileStats[slot] : nullptr;
+}
+
+// Upper bound (us) of the bucket containing the 99th percentile sample
+static uint32_t estimateP99(const ProfileStats* s) {
+    uint32_t samples = 0;
+    for (uint8_t b = 0; b < PROFILE_NUM_BUCKETS; b++) samples += s->histogram[b];
+    if (samples == 0) return 0;
+
+    uint32_t threshold = samples - samples / 100;  // ceil(0.99 * n) for n >= 100
+    uint32_t seen = 0;
+    for (uint8_t b = 0; b < PROFILE_NUM_BUCKETS; b++) {
+        seen += s->histogram[b];
+        if (seen >= threshold) {
+            if (b == PROFILE_NUM_BUCKETS - 1) return s->max_us;  // Open-ended bucket
+            uint32_t upper = (1UL << b) - 1;
+            return (upper < s->max_us) ? upper : s->max_us;
+        }
+    }
+    return s->max_us;
+}
+
+static void printSlotName(uint8_t slot) {
+    if (slot == PROF_LOOP)      { msg.control.print(F("LOOP")); return; }
+    if (slot == PROF_ROUTER)    { msg.control.print(F("ROUTER")); return; }
+    if (slot == PROF_CAN_INPUT) { msg.control.print(F("CAN_INPUT")); return; }
+    if (slot == PROF_ALARMS)    { msg.control.print(F("ALARMS")); return; }
+    if (slot == PROF_LCD)       { msg.control.print(F("LCD")); return; }
+
+    if (slot < PROF_OUTPUT_UPDATE_BASE) {
+        OutputModule* output = getOutputByIndex(slot - PROF_OUTPUT_SEND_BASE);
+        msg.control.print(F("SEND "));
+        msg.control.print(output ? output->name : "?");
+        return;
+    }
+    if (slot < PROF_INPUT_BASE) {
+        OutputModule* output = getOutputByIndex(slot - PROF_OUTPUT_UPDATE_BASE);
+        msg.control.print(F("UPDATE "));
+        msg.control.print(output ? output->name : "?");
+        return;
+    }
+
+    uint8_t idx = slot - PROF_INPUT_BASE;
+    msg.control.print(F("READ "));
+    msg.control.print(inputs[idx].abbrName[0] != '\0' ? inputs[idx].abbrName : "?");
+    msg.control.print(F(" (pin "));
+    msg.control.print(inputs[idx].pin);
+    msg.control.print(F(")"));
+}
+
+void printProfile() {
+    msg.control.println();
+    msg.control.println(F("=== Profile (us) ==="));
+    msg.control.println(F("Slot: calls min/avg/max p99"));
+
+    bool any = false;
+    for (uint8_t slot = 0; slot < NUM_PROFILE_SLOTS; slot++) {
+        const ProfileStats* s = &profileStats[slot];
+        if (s->count == 0) continue;
+        any = true;
+
+        printSlotName(slot);
+        msg.control.print(F(": "));
+        msg.control.print(s->count);
+        msg.control.print(F(" "));
+        msg.control.print(s->min_us);
+        msg.control.print(F("/"));
+        msg.control.print(s->total_us / s->count);
+        msg.control.print(F("/"));
+        msg.control.print(s->max_us);
+        msg.control.print(F(" "));
+        msg.control.println(estimateP99(s));
+    }
+
+    if (!any) {
+        msg.control.println(F("No samples (profiling covers RUN mode loop work)"));
+    }
+#ifdef ENABLE_ISR_PROFILER
+    printIsrProfile();
+#endif
+    msg.control.println();
+}
+
+#endif // ENABLE_PROFILER
@@ -0,0 +1,96 @@
+/*
+ * profiler.h - Loop and per-task execution-time profiler
+ *
+ * Opt-in instrumentation (-D ENABLE_PROFILER) that records how long each
+ * piece of loop() work takes: the transport router, CAN input polling,
+ * every input's read function, the alarm evaluator, each output module's
+ * send batch and housekeeping update, and the LCD refresh.
+ *
+ * Each slot keeps call count, min/avg/max and a fixed-size log2 histogram
+ * of microseconds, from which p99 is estimated (upper bound of the bucket
+ * containing the 99th percentile). No allocation, no floating point on the
+ * record path.
+ *
+ * Results are shown with the PROFILE command (PROFILE RESET clears them).
+ * With -D ENABLE_ISR_PROFILER the interrupt handlers are counted too
+ * (lib/isr_profile.h) and listed after the loop slots.
+ *
+ * Usage:
+ *   PROFILE_CALL(PROF_ROUTER, router.update());
+ *
+ *   uint32_t t0 = PROFILE_TIMESTAMP();
+ *   ...
+ *   PROFILE_RECORD(profInputSlot(i), t0);
+ *
+ * Without ENABLE_PROFILER all macros compile to the bare statement / nothing.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+#include "../config.h"
+#include "platform.h"
+#include "system_config.h"  // For NUM_OUTPUTS
+
+// Histogram buckets: bucket n counts durations in [2^(n-1), 2^n) us,
+// bucket 0 is < 1us, last bucket is everything >= 2^(N-2) us
+#define PROFILE_NUM_BUCKETS 18
+
+// Profile slot layout
+enum ProfileSlot {
+    PROF_LOOP = 0,          // Whole loop() iteration
+    PROF_ROUTER,            // router.update() (transport polling + commands)
+    PROF_CAN_INPUT,         // pumpCANRx() (all CAN receive)
+    PROF_ALARMS,            // updateAllInputAlarms()
+    PROF_LCD,               // updateLCDLayout()
+    PROF_OUTPUT_SEND_BASE,  // + output module index: send batch
+    PROF_OUTPUT_UPDATE_BASE = PROF_OUTPUT_SEND_BASE + NUM_OUTPUTS,  // + module index: update()
+    PROF_INPUT_BASE = PROF_OUTPUT_UPDATE_BASE + NUM_OUTPUTS,        // + input index: readFunction
+    NUM_PROFILE_SLOTS = PROF_INPUT_BASE + MAX_INPUTS
+};
+
+inline uint8_t profOutputSendSlot(uint8_t module)   { return PROF_OUTPUT_SEND_BASE + module; }
+inline uint8_t profOutputUpdateSlot(uint8_t module) { return PROF_OUTPUT_UPDATE_BASE + module; }
+inline uint8_t profInputSlot(uint8_t inputIndex)    { return PROF_INPUT_BASE + inputIndex; }
+
+#ifdef ENABLE_PROFILER
+
+struct ProfileStats {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint32_t total_us;   // Wraps after ~71 minutes of cumulative time - use PROFILE RESET
+    uint16_t histogram[PROFILE_NUM_BUCKETS];  // Saturating counters
+};
+
+// Record one sample for a slot
+void profilerRecord(uint8_t slot, uint32_t elapsed_us);
+
+// Clear all statistics
+void profilerReset();
+
+// Access raw stats (nullptr if slot out of range)
+const ProfileStats* getProfileStats(uint8_t slot);
+
+// Print table of all slots with samples (PROFILE command)
+void printProfile();
+
+#define PROFILE_TIMESTAMP() micros()
+#define PROFILE_RECORD(slot, start) profilerRecord((slot), micros() - (start))
+#define PROFILE_CALL(slot, expr) \
+    do { \
+        uint32_t _prof_start = micros(); \
+        expr; \
+        profilerRecord((slot), micros() - _prof_start); \
+    } while (0)
+
+#else
+
+#define PROFILE_TIMESTAMP() 0
+#define PROFILE_RECORD(slot, start) ((void)(start))
+#define PROFILE_CALL(slot, expr) do { expr; } while (0)
+
+#endif // ENABLE_PROFILER
+
+#endif // PROFILER_H
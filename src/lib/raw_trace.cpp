@@ -0,0 +1,471 @@
+/*
+ * raw_trace.cpp - Raw acquisition recording and replay implementation
+ */
+
+#include "raw_trace.h"
+
+#ifdef ENABLE_RAW_TRACE
+
+#include "../config.h"
+#include "../hal/hal_clock.h"
+#include "../hal/hal_placement.h"
+#include "message_api.h"
+#include "log_tags.h"
+#include "loop_monitor.h"
+#include "bus_manager.h"
+#include "sd_manager.h"
+#ifdef ENABLE_CAN
+#include "can_rx.h"
+#endif
+#include <SD.h>
+#include <string.h>
+
+#define RAW_TRACE_MAGIC     "PRAW"
+#define RAW_TRACE_VERSION   1
+#define RAW_TRACE_HEADER    16
+#define RAW_TRACE_RECORD    7           // dtUs kind key len
+#define RAW_TRACE_DIR       "/logs"
+
+#define RAW_SLOT_BYTES      12          // Largest substituted payload (PULSE)
+#define RAW_PAYLOAD_MAX     (5 + HAL_CAN_MAX_DLEN)
+
+#define RAW_CAN_EXTENDED    0x01
+#define RAW_CAN_FD          0x02
+
+RawTraceMode rawTraceMode = RAW_TRACE_OFF;
+
+static File traceFile;
+static char traceName[32];
+static uint32_t startMs = 0;
+static uint32_t records = 0;        // Recorded
+static uint32_t drops = 0;          // Recording: both buffers full
+static uint32_t fileBytes = 0;
+
+// ===== RECORDING =====
+
+HAL_DMA_BUFFER static uint8_t stageBuffer[2][RAW_TRACE_BUFFER_SIZE];
+static uint8_t stageActive = 0;
+static uint16_t stageUsed = 0;
+static uint16_t stageLimit = RAW_TRACE_BUFFER_SIZE;
+static bool stageFull = false;
+static uint16_t stageFullLength = 0;
+static uint32_t lastSync = 0;
+static uint32_t lastRecordUs = 0;
+static bool writeFailed = false;
+
+// Same staging as the SD log: records kept whole, a full buffer waits for the card
+static void stageBytes(const uint8_t* data, uint16_t len) {
+    while (len > 0) {
+        uint16_t chunk = stageLimit - stageUsed;
+        if (chunk > len) chunk = len;
+        memcpy(&stageBuffer[stageActive][stageUsed], data, chunk);
+        stageUsed += chunk;
+        data += chunk;
+        len -= chunk;
+
+        if (stageUsed == stageLimit) {
+            stageFull = true;
+            stageFullLength = stageUsed;
+            stageActive ^= 1;
+            stageUsed = 0;
+            stageLimit = RAW_TRACE_BUFFER_SIZE;
+        }
+    }
+}
+
+static void stageRecord(uint8_t kind, uint8_t key, const void* payload, uint8_t len,
+                        const void* tail = nullptr, uint8_t tailLen = 0) {
+    uint16_t total = RAW_TRACE_RECORD + len + tailLen;
+    if (stageUsed + total > stageLimit && stageFull) {
+        if (drops++ == 0) {
+            msg.debug.warn(TAG_SD, "Raw trace overrun - card slower than the acquisitions");
+        }
+        return;
+    }
+
+    uint32_t now = micros();
+    uint32_t dt = now - lastRecordUs;
+    lastRecordUs = now;
+
+    uint8_t head[RAW_TRACE_RECORD];
+    memcpy(head, &dt, 4);
+    head[4] = kind;
+    head[5] = key;
+    head[6] = len + tailLen;
+    stageBytes(head, sizeof(head));
+    stageBytes((const uint8_t*)payload, len);
+    if (tailLen) stageBytes((const uint8_t*)tail, tailLen);
+    records++;
+}
+
+static void writeStaged(const uint8_t* data, uint16_t len) {
+    spiClaim(SPI_CLIENT_SD);
+    if (traceFile.write(data, len) != len) writeFailed = true;
+    spiRelease(SPI_CLIENT_SD);
+    fileBytes += len;
+}
+
+// True if a write now would overrun the loop budget or hold up SPI work that is due
+static bool cardWriteBlocked() {
+    if (loopBudgetExceeded()) {
+        loopMonitorNoteDeferral();
+        return true;
+    }
+    return spiShouldYield(SPI_CLIENT_SD);
+}
+
+// A full buffer per pass, and every RAW_TRACE_SYNC_MS the partly filled one
+static void drainStaging() {
+    if (stageFull) {
+        if (cardWriteBlocked()) return;
+        writeStaged(stageBuffer[stageActive ^ 1], stageFullLength);
+        stageFull = false;
+        return;
+    }
+
+    if (millis() - lastSync < RAW_TRACE_SYNC_MS || cardWriteBlocked()) return;
+    if (stageUsed > 0) {
+        writeStaged(stageBuffer[stageActive], stageUsed);
+        stageUsed = 0;
+        stageLimit = RAW_TRACE_BUFFER_SIZE - (fileBytes % RAW_TRACE_BUFFER_SIZE);
+    }
+    spiClaim(SPI_CLIENT_SD);
+    traceFile.flush();
+    spiRelease(SPI_CLIENT_SD);
+    lastSync = millis();
+}
+
+// ===== REPLAY =====
+
+struct RawSlot {
+    uint8_t kind;                   // 0 = free
+    uint8_t key;
+    uint8_t len;
+    uint8_t data[RAW_SLOT_BYTES];
+};
+
+struct RawPending {
+    bool valid;
+    uint64_t dueUs;                 // On the replay clock
+    uint8_t kind;
+    uint8_t key;
+    uint8_t len;
+    uint8_t payload[RAW_PAYLOAD_MAX];
+};
+
+static RawSlot slots[RAW_TRACE_REPLAY_SLOTS];
+static RawPending pending;
+static bool replayLoop = false;
+static uint64_t traceUs = 0;        // Trace time of the newest record read
+static uint64_t clockUs = 0;        // Replay clock since the start of this pass
+static uint32_t lastMicros = 0;
+static uint32_t applied = 0;
+static uint32_t substituted = 0;    // Live reads that took a recorded value
+static uint32_t unmatched = 0;      // Records with no slot left for their pin
+static uint32_t late = 0;
+static uint32_t maxLateUs = 0;
+static uint32_t bad = 0;
+static uint16_t passes = 0;
+
+static RawSlot* findSlot(uint8_t kind, uint8_t key, bool claim) {
+    for (uint8_t i = 0; i < RAW_TRACE_REPLAY_SLOTS; i++) {
+        if (slots[i].kind == kind && slots[i].key == key) return &slots[i];
+    }
+    if (!claim) return nullptr;
+    for (uint8_t i = 0; i < RAW_TRACE_REPLAY_SLOTS; i++) {
+        if (slots[i].kind == 0) {
+            slots[i].kind = kind;
+            slots[i].key = key;
+            return &slots[i];
+        }
+    }
+    return nullptr;
+}
+
+static bool readHeader() {
+    uint8_t header[RAW_TRACE_HEADER];
+    if (traceFile.read(header, sizeof(header)) != (int)sizeof(header)) return false;
+    return memcmp(header, RAW_TRACE_MAGIC, 4) == 0 && header[4] == RAW_TRACE_VERSION;
+}
+
+// Next record into pending; false at the end of the file
+static bool readRecord() {
+    uint8_t head[RAW_TRACE_RECORD];
+    pending.valid = false;
+    if (traceFile.read(head, sizeof(head)) != (int)sizeof(head)) return false;
+
+    uint32_t dt;
+    memcpy(&dt, head, 4);
+    pending.kind = head[4];
+    pending.key = head[5];
+    pending.len = head[6];
+    if (pending.len > sizeof(pending.payload) ||
+        traceFile.read(pending.payload, pending.len) != pending.len) {
+        bad++;
+        return false;                               // Cut short - the rest is unreadable
+    }
+    traceUs += dt;
+    pending.dueUs = traceUs;
+    pending.valid = true;
+    return true;
+}
+
+static bool rewindTrace() {
+    traceFile.seek(0);
+    if (!readHeader()) return false;
+    traceUs = 0;
+    clockUs = 0;
+    passes++;
+    return readRecord();
+}
+
+static void applyRecord() {
+    applied++;
+#ifdef ENABLE_CAN
+    if (pending.kind == RAW_KIND_CAN) {
+        if (pending.len < 5) {
+            bad++;
+            return;
+        }
+        hal::can::CanRxFrame frame;
+        memcpy(&frame.id, pending.payload, 4);
+        frame.extended = pending.payload[4] & RAW_CAN_EXTENDED;
+        frame.fd = pending.payload[4] & RAW_CAN_FD;
+        frame.len = pending.len - 5;
+        memcpy(frame.data, &pending.payload[5], frame.len);
+        frame.rxMs = millis();
+        frame.rxUs = hal::micros64();
+        injectCANRxFrame(pending.key, frame);
+        return;
+    }
+#endif
+    if (pending.len > RAW_SLOT_BYTES) {
+        bad++;
+        return;
+    }
+    RawSlot* slot = findSlot(pending.kind, pending.key, true);
+    if (slot == nullptr) {
+        unmatched++;
+        return;
+    }
+    slot->len = pending.len;
+    memcpy(slot->data, pending.payload, pending.len);
+}
+
+static void updateReplay() {
+    uint32_t now = micros();
+    clockUs += now - lastMicros;
+    lastMicros = now;
+
+    for (uint8_t n = 0; n < RAW_TRACE_RECORDS_PER_PASS; n++) {
+        if (!pending.valid) {
+            if (!replayLoop || !rewindTrace()) {
+                stopRawTrace();
+                return;
+            }
+        }
+        if (pending.dueUs > clockUs) return;        // Not due yet
+
+        uint64_t lateUs = clockUs - pending.dueUs;
+        if (lateUs > RAW_TRACE_LATE_US) {
+            late++;
+            if (lateUs > maxLateUs) maxLateUs = lateUs > 0xFFFFFFFFULL ? 0xFFFFFFFFUL : (uint32_t)lateUs;
+        }
+        applyRecord();
+        readRecord();
+    }
+}
+
+// ===== HOOKS =====
+
+void rawTraceAcquired(uint8_t kind, uint8_t key, void* data, uint8_t len) {
+    if (rawTraceMode == RAW_TRACE_RECORDING) {
+        stageRecord(kind, key, data, len);
+        return;
+    }
+    RawSlot* slot = findSlot(kind, key, false);
+    if (slot == nullptr || slot->len != len) return;    // Not in the trace - stays live
+    memcpy(data, slot->data, len);
+    substituted++;
+}
+
+void rawTraceCANFrame(uint8_t bus, const hal::can::CanRxFrame& frame) {
+    uint8_t head[5];
+    memcpy(head, &frame.id, 4);
+    head[4] = (frame.extended ? RAW_CAN_EXTENDED : 0) | (frame.fd ? RAW_CAN_FD : 0);
+    stageRecord(RAW_KIND_CAN, bus, head, sizeof(head), frame.data, frame.len);
+}
+
+// ===== CONTROL =====
+
+static void resetCounters(const char* filename) {
+    strncpy(traceName, filename, sizeof(traceName) - 1);
+    traceName[sizeof(traceName) - 1] = '\0';
+    startMs = millis();
+    records = 0;
+    drops = 0;
+    fileBytes = 0;
+}
+
+bool startRawRecord(const char* filename) {
+    if (!isSDInitialized()) {
+        msg.control.println(F("ERROR: SD card not available"));
+        return false;
+    }
+    if (rawTraceMode != RAW_TRACE_OFF) stopRawTrace();
+
+    char generated[32];
+    if (!SD.exists(RAW_TRACE_DIR)) SD.mkdir(RAW_TRACE_DIR);
+    if (filename == nullptr) {
+        snprintf(generated, sizeof(generated), RAW_TRACE_DIR "/raw_%lu.prw", (unsigned long)millis());
+        filename = generated;
+    }
+    if (SD.exists(filename)) {
+        SD.remove(filename);                         // FILE_WRITE appends - replace instead
+    }
+    traceFile = SD.open(filename, FILE_WRITE);
+    if (!traceFile) {
+        msg.control.print(F("ERROR: Cannot create "));
+        msg.control.println(filename);
+        return false;
+    }
+    resetCounters(filename);
+
+    stageActive = 0;
+    stageUsed = 0;
+    stageLimit = RAW_TRACE_BUFFER_SIZE;
+    stageFull = false;
+    writeFailed = false;
+    lastSync = startMs;
+    lastRecordUs = micros();
+
+    uint8_t header[RAW_TRACE_HEADER] = {0};
+    uint32_t startUnix = hal::wallClock();
+    memcpy(header, RAW_TRACE_MAGIC, 4);
+    header[4] = RAW_TRACE_VERSION;
+    memcpy(&header[8], &startMs, 4);
+    memcpy(&header[12], &startUnix, 4);
+    stageBytes(header, sizeof(header));
+
+    rawTraceMode = RAW_TRACE_RECORDING;
+    msg.control.print(F("Recording raw acquisitions to "));
+    msg.control.println(traceName);
+    return true;
+}
+
+bool startRawReplay(const char* filename, bool loop) {
+    if (!isSDInitialized()) {
+        msg.control.println(F("ERROR: SD card not available"));
+        return false;
+    }
+    if (rawTraceMode != RAW_TRACE_OFF) stopRawTrace();
+
+    traceFile = SD.open(filename, FILE_READ);
+    if (!traceFile) {
+        msg.control.print(F("ERROR: Cannot open "));
+        msg.control.println(filename);
+        return false;
+    }
+    resetCounters(filename);
+    memset(slots, 0, sizeof(slots));
+    applied = substituted = unmatched = late = maxLateUs = bad = 0;
+    passes = 1;
+    replayLoop = loop;
+    traceUs = 0;
+    clockUs = 0;
+    lastMicros = micros();
+
+    if (!readHeader()) {
+        msg.control.println(F("ERROR: Not a raw trace (PRAW header)"));
+        traceFile.close();
+        return false;
+    }
+    if (!readRecord()) {
+        msg.control.println(F("ERROR: Trace has no records"));
+        traceFile.close();
+        return false;
+    }
+
+    rawTraceMode = RAW_TRACE_REPLAYING;
+    msg.control.print(F("Replaying raw trace "));
+    msg.control.println(traceName);
+    return true;
+}
+
+void stopRawTrace() {
+    if (rawTraceMode == RAW_TRACE_OFF) return;
+
+    if (rawTraceMode == RAW_TRACE_RECORDING) {
+        // Whatever is staged goes out now, budget or not
+        if (stageFull) {
+            writeStaged(stageBuffer[stageActive ^ 1], stageFullLength);
+            stageFull = false;
+        }
+        if (stageUsed > 0) {
+            writeStaged(stageBuffer[stageActive], stageUsed);
+            stageUsed = 0;
+        }
+    }
+    spiClaim(SPI_CLIENT_SD);
+    traceFile.close();
+    spiRelease(SPI_CLIENT_SD);
+
+    printRawTraceStatus();
+    rawTraceMode = RAW_TRACE_OFF;
+    memset(slots, 0, sizeof(slots));
+}
+
+void updateRawTrace() {
+    if (rawTraceMode == RAW_TRACE_RECORDING) {
+        drainStaging();
+    } else if (rawTraceMode == RAW_TRACE_REPLAYING) {
+        updateReplay();
+    }
+}
+
+void printRawTraceStatus() {
+    if (rawTraceMode == RAW_TRACE_OFF) {
+        msg.control.println(F("Raw trace: off"));
+        return;
+    }
+    uint32_t elapsed = millis() - startMs;
+    msg.control.print(rawTraceMode == RAW_TRACE_RECORDING ? F("Raw trace: recording ") : F("Raw trace: replaying "));
+    msg.control.print(traceName);
+    msg.control.print(F(", "));
+    msg.control.print(elapsed / 1000.0f, 1);
+    msg.control.println(F(" s"));
+
+    if (rawTraceMode == RAW_TRACE_RECORDING) {
+        msg.control.print(F("  Records: "));
+        msg.control.print(records);
+        msg.control.print(F(", "));
+        msg.control.print(fileBytes + stageUsed + (stageFull ? stageFullLength : 0));
+        msg.control.print(F(" bytes, "));
+        msg.control.print(drops);
+        msg.control.print(F(" dropped"));
+        if (writeFailed) msg.control.print(F(", WRITE FAILED"));
+        msg.control.println();
+        return;
+    }
+
+    msg.control.print(F("  Records: "));
+    msg.control.print(applied);
+    msg.control.print(F(" applied"));
+    if (replayLoop) {
+        msg.control.print(F(", pass "));
+        msg.control.print(passes);
+    }
+    msg.control.print(F(", "));
+    msg.control.print(late);
+    msg.control.print(F(" late (max "));
+    msg.control.print(maxLateUs);
+    msg.control.print(F(" us), "));
+    msg.control.print(unmatched);
+    msg.control.print(F(" unmatched, "));
+    msg.control.print(bad);
+    msg.control.println(F(" bad"));
+    msg.control.print(F("  Reads substituted: "));
+    msg.control.println(substituted);
+}
+
+#endif // ENABLE_RAW_TRACE
@@ -0,0 +1,153 @@
+/*
+ * raw_trace.h - Raw acquisition recording and replay (RAW)
+ *
+ * Opt-in (-D ENABLE_RAW_TRACE) capture of what the sensors delivered
+ * before any conversion, for tuning calibrations and filters off the car.
+ * The SD log holds converted values; a raw trace holds the inputs to the
+ * conversion, each stamped in microseconds where it was acquired:
+ *
+ *   ADC     readAnalogRaw() counts (on-chip and external ADC), per pin
+ *   SPI     Thermocouple frames (MAX6675 / MAX31855), per CS pin
+ *   PULSE   getFreqCapture() measurements (frequency, idle time, pulses), per pin
+ *   CAN     Every frame the receive pump reads, per bus
+ *
+ * RAW REPLAY plays a trace back through the same hooks: each live read
+ * still runs, then takes the recorded value for its kind and pin in place
+ * of what the hardware returned, and recorded CAN frames are injected into
+ * the receive path (injectCANRxFrame()). The conversion, filtering, alarms
+ * and outputs downstream run on the recorded data - load a new calibration
+ * and replay the drive it has to fit. Records come due on the replay clock
+ * (micros() since the start), at most RAW_TRACE_RECORDS_PER_PASS per loop
+ * pass; in the native simulator (docs/advanced/SIMULATOR_GUIDE.md) the
+ * virtual clock runs as fast as the host allows, so a trace replays faster
+ * than real time. The inputs have to be configured on the pins they were
+ * recorded on; a pin the trace doesn't cover reads live.
+ *
+ * File (/logs/raw_<ms>.prw unless named), little-endian:
+ *
+ *   Header   "PRAW" version 0 0 0 startMs startUnix        (16 bytes)
+ *   Record   dtUs (uint32, since the previous record) kind key len payload[len]
+ *
+ *   kind 1 ADC    key pin   payload float counts
+ *   kind 2 SPI    key pin   payload uint32 frame
+ *   kind 3 PULSE  key pin   payload float Hz, uint32 idleUs, uint32 pulses
+ *   kind 4 CAN    key bus   payload uint32 id, flags (1 = extended, 2 = FD), data
+ *
+ * tools/raw_trace_decode.py prints a trace as CSV.
+ *
+ * Write path: records are staged in two sector-sized buffers and a full
+ * one goes to the card with one write() per pass from updateRawTrace(), put
+ * off while the loop is over budget or higher-priority SPI work is due -
+ * the scheme of the SD log (outputs/output_sdlog.cpp), in a file of its own
+ * because the records aren't the log's fixed size. With both buffers full
+ * a record is dropped and counted.
+ *
+ * Usage:
+ *   RAW_TRACE(RAW_KIND_ADC, pin, counts);    // After the acquisition
+ *   RAW_TRACE_CAN(bus, frame);               // Frame read from the driver
+ *
+ * Without ENABLE_RAW_TRACE the macros compile to nothing; with it and no
+ * trace running, each is one flag test.
+ *
+ * Build Flags:
+ *   -D ENABLE_RAW_TRACE              - Compile the recorder and the RAW command (needs ENABLE_SD_LOGGING)
+ *   -D RAW_TRACE_BUFFER_SIZE=n       - Bytes per staging buffer, two are used (default 512)
+ *   -D RAW_TRACE_SYNC_MS=n           - Longest time staged records wait for the card (default 2000)
+ *   -D RAW_TRACE_REPLAY_SLOTS=n      - Pins a replay can substitute (default 16; 8 on AVR)
+ *   -D RAW_TRACE_RECORDS_PER_PASS=n  - Records a replay reads per loop pass (default 32)
+ *   -D RAW_TRACE_LATE_US=n           - Applied later than this counts as late (default 2000)
+ */
+
+#ifndef RAW_TRACE_H
+#define RAW_TRACE_H
+
+#include <Arduino.h>
+
+#ifndef RAW_TRACE_BUFFER_SIZE
+#define RAW_TRACE_BUFFER_SIZE 512
+#endif
+
+#ifndef RAW_TRACE_SYNC_MS
+#define RAW_TRACE_SYNC_MS 2000
+#endif
+
+#ifndef RAW_TRACE_REPLAY_SLOTS
+  #if defined(__AVR__)
+    #define RAW_TRACE_REPLAY_SLOTS 8
+  #else
+    #define RAW_TRACE_REPLAY_SLOTS 16
+  #endif
+#endif
+
+#ifndef RAW_TRACE_RECORDS_PER_PASS
+#define RAW_TRACE_RECORDS_PER_PASS 32
+#endif
+
+#ifndef RAW_TRACE_LATE_US
+#define RAW_TRACE_LATE_US 2000
+#endif
+
+// Record kinds
+#define RAW_KIND_ADC   1
+#define RAW_KIND_SPI   2
+#define RAW_KIND_PULSE 3
+#define RAW_KIND_CAN   4
+
+enum RawTraceMode : uint8_t {
+    RAW_TRACE_OFF = 0,
+    RAW_TRACE_RECORDING,
+    RAW_TRACE_REPLAYING
+};
+
+#ifdef ENABLE_RAW_TRACE
+
+#ifndef ENABLE_SD_LOGGING
+#error "ENABLE_RAW_TRACE needs ENABLE_SD_LOGGING"
+#endif
+
+#include "../hal/hal_can_frame.h"
+
+extern RawTraceMode rawTraceMode;
+
+// Record data (recording), or overwrite it with the replayed value (replay)
+void rawTraceAcquired(uint8_t kind, uint8_t key, void* data, uint8_t len);
+
+// Record a frame read from a bus (recording only - replay injects its own)
+void rawTraceCANFrame(uint8_t bus, const hal::can::CanRxFrame& frame);
+
+/**
+ * Start recording (stops a trace running)
+ * @param filename  File on SD, nullptr = /logs/raw_<ms>.prw
+ * @return          false (with the reason printed) if it can't start
+ */
+bool startRawRecord(const char* filename);
+
+/**
+ * Start a replay (stops a trace running)
+ * @param filename  Trace on SD
+ * @param loop      Start the file over at its end
+ */
+bool startRawReplay(const char* filename, bool loop);
+
+// Stop either, flushing a recording to the card, and print the summary
+void stopRawTrace();
+
+// Recorded sectors to the card, due replay records applied (main loop)
+void updateRawTrace();
+
+// Mode, file, records and drops (RAW STATUS)
+void printRawTraceStatus();
+
+#define RAW_TRACE(kind, key, var) \
+    do { if (rawTraceMode != RAW_TRACE_OFF) rawTraceAcquired((kind), (key), &(var), sizeof(var)); } while (0)
+#define RAW_TRACE_CAN(bus, frame) \
+    do { if (rawTraceMode == RAW_TRACE_RECORDING) rawTraceCANFrame((bus), (frame)); } while (0)
+
+#else
+
+#define RAW_TRACE(kind, key, var)  ((void)0)
+#define RAW_TRACE_CAN(bus, frame)  ((void)0)
+
+#endif // ENABLE_RAW_TRACE
+
+#endif // RAW_TRACE_H
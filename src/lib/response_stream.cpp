@@ -0,0 +1,42 @@
+/*
+ * response_stream.cpp - Long command answers, a piece per loop
+ */
+
+#include "response_stream.h"
+#include "message_router.h"
+
+static ResponseStep current = nullptr;
+static ResponseCursor cursor;
+
+// Bytes the control plane's primary transport has taken so far
+static uint32_t controlBytesOut() {
+    const PlaneTargets& ctrl = router.getTargets(PLANE_CONTROL);
+    return ctrl.count > 0 ? ctrl.list[0]->getCounters().bytesOut : 0;
+}
+
+void startResponse(ResponseStep step, uint8_t arg) {
+    finishResponse();
+    cursor = { 0, 0, arg };
+    current = step;
+}
+
+void updateResponse() {
+    uint32_t emitted = 0;
+    while (current != nullptr && emitted < RESPONSE_LOOP_BYTES) {
+        if (!router.controlTxReady(RESPONSE_STEP_BYTES)) return;
+        uint32_t before = controlBytesOut();
+        if (!current(cursor)) current = nullptr;
+        uint32_t n = controlBytesOut() - before;
+        emitted += n > 0 ? n : 1;   // Steps printing nothing still end a pass eventually
+    }
+}
+
+void finishResponse() {
+    while (current != nullptr) {
+        if (!current(cursor)) current = nullptr;
+    }
+}
+
+bool responseActive() {
+    return current != nullptr;
+}
@@ -0,0 +1,77 @@
+/*
+ * response_stream.h - Long command answers, a piece per loop
+ *
+ * LIST SENSORS, LIST APPLICATIONS, LIST INPUTS and SYSTEM DUMP JSON answer
+ * with hundreds of lines. Printed in one go, the control plane's TX_BLOCK
+ * policy holds loop() until the port has taken them all - seconds at 115200
+ * baud, with no sensor reads in between. Instead, such a command starts a
+ * response: a step function printing one piece (a line, one input's JSON)
+ * per call and keeping its place in a ResponseCursor. updateResponse() runs
+ * steps from loop() (CONFIG mode too) while every control transport has
+ * room for RESPONSE_STEP_BYTES in its TX ring, and stops once a pass has
+ * emitted RESPONSE_LOOP_BYTES - so the answer drains at the port's pace and
+ * no write has to wait.
+ *
+ * While a response runs, the router leaves command input in the transports
+ * (one answer at a time, in order). A response started while another runs
+ * finishes the older one first, so a blocking caller (SYSTEM DUMP printing
+ * LIST INPUTS in the middle of its report) calls finishResponse() after
+ * starting one.
+ *
+ * Step functions print with msg.control and return false after the last
+ * piece. A step that prints nothing (the end of a section) is fine - the
+ * next one follows in the same pass.
+ *
+ * Usage:
+ *   static bool listStep(ResponseCursor& cursor) { ...; return cursor.index < n; }
+ *   startResponse(listStep);      // Command handler - returns at once
+ *   updateResponse();             // loop(), after router.update()
+ *
+ * Build Flags:
+ *   -D RESPONSE_LOOP_BYTES=n     - Emitted per loop pass (default 256; 64 on AVR)
+ *   -D RESPONSE_STEP_BYTES=n     - TX room a step waits for (default 128; 48 on AVR)
+ */
+
+#ifndef RESPONSE_STREAM_H
+#define RESPONSE_STREAM_H
+
+#include <Arduino.h>
+
+#ifndef RESPONSE_LOOP_BYTES
+#if defined(__AVR__)
+#define RESPONSE_LOOP_BYTES 64
+#else
+#define RESPONSE_LOOP_BYTES 256
+#endif
+#endif
+
+#ifndef RESPONSE_STEP_BYTES
+#if defined(__AVR__)
+#define RESPONSE_STEP_BYTES 48
+#else
+#define RESPONSE_STEP_BYTES 128
+#endif
+#endif
+
+// Where a response is - zeroed at the start, apart from arg
+struct ResponseCursor {
+    uint16_t index;     // Item within the section
+    uint8_t section;    // Part of the response
+    uint8_t arg;        // Set by the command (a filter); free for the step after that
+};
+
+// Print the next piece; false once the response is complete
+typedef bool (*ResponseStep)(ResponseCursor& cursor);
+
+// Answer with step from the next loop pass on (finishes a running response first)
+void startResponse(ResponseStep step, uint8_t arg = 0);
+
+// Steps while the control transports have room, up to RESPONSE_LOOP_BYTES
+void updateResponse();
+
+// Run what is left of the current response now, blocking on the port
+void finishResponse();
+
+bool responseActive();
+
+#endif // RESPONSE_STREAM_H
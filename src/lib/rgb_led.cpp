@@ -2,6 +2,12 @@
  * rgb_led.cpp - RGB LED Status Indicator Implementation
  *
  * Non-blocking PWM-based RGB LED controller with priority system
+ *
+ * Blink and pulse run on a hardware timer where the platform has one
+ * (hal/hal_led_wave.h - Teensy PIT, ESP32 LEDC fades): the PWM is written
+ * when the active effect changes and the timer does the rest, so a busy
+ * loop can't make a blink irregular. Elsewhere (AVR) updateRGBLed() steps
+ * the effect from millis() as before. Solid colors are written once.
  */
 
 #include "rgb_led.h"
@@ -11,6 +17,7 @@
 #include "pin_registry.h"
 #include "message_api.h"
 #include "log_tags.h"
+#include "../hal/hal_led_wave.h"
 
 // ============================================================================
 // INTERNAL STATE
@@ -32,6 +39,8 @@ static struct {
 
     // Current PWM output values
     uint8_t currentR, currentG, currentB;
+    bool currentValid;            // False after a hardware wave - the PWM is wherever it stopped
+    bool hardwareWave;            // The active blink/pulse runs on a timer (hal_led_wave.h)
 
     // Priority stack - stores request for each priority level
     // When high priority releases, we restore lower priority state
@@ -49,7 +58,7 @@ static struct {
 #ifdef ESP32
 // ESP32 uses LEDC peripheral for PWM
 // Channel assignment: R=0, G=1, B=2
-static const uint8_t LEDC_FREQ = 5000;  // 5kHz PWM frequency
+static const uint32_t LEDC_FREQ = 5000;  // 5kHz PWM frequency
 static const uint8_t LEDC_RESOLUTION = 8;  // 8-bit resolution (0-255)
 
 static void initPWM() {
@@ -109,6 +118,107 @@ static inline uint8_t priorityToSlot(RGBPriority priority) {
     return priority / 10;  // 0->0, 10->1, 20->2, 30->3, 40->4
 }
 
+// Color of the active effect at elapsed ms into it
+static RGBColor effectOutput(uint32_t elapsed) {
+    RGBColor output = RGB_OFF;
+
+    switch (rgbState.active.effect) {
+        case EFFECT_OFF:
+            output = RGB_OFF;
+            break;
+
+        case EFFECT_SOLID:
+            output = rgbState.active.color;
+            break;
+
+        case EFFECT_BLINK: {
+            // Square wave: on for half period, off for half
+            uint16_t period = rgbState.active.period_ms;
+            if (period == 0) {
+                // Fallback to solid if period is 0
+                output = rgbState.active.color;
+            } else {
+                uint32_t phase = elapsed % period;
+                output = (phase < period / 2) ? rgbState.active.color : RGB_OFF;
+            }
+            break;
+        }
+
+        case EFFECT_PULSE: {
+            // Triangular wave for smooth breathing
+            uint16_t period = rgbState.active.period_ms;
+            if (period == 0) {
+                // Fallback to solid if period is 0
+                output = rgbState.active.color;
+            } else {
+                uint32_t phase = elapsed % period;
+                uint16_t halfPeriod = period / 2;
+
+                uint8_t brightness;
+                if (phase < halfPeriod) {
+                    // Ramp up: 0 -> 255
+                    brightness = (phase * 255) / halfPeriod;
+                } else {
+                    // Ramp down: 255 -> 0
+                    brightness = ((period - phase) * 255) / halfPeriod;
+                }
+
+                // Apply brightness to color
+                output.r = (rgbState.active.color.r * brightness) / 255;
+                output.g = (rgbState.active.color.g * brightness) / 255;
+                output.b = (rgbState.active.color.b * brightness) / 255;
+            }
+            break;
+        }
+    }
+    return output;
+}
+
+// Only update PWM if values changed (reduce overhead)
+static void writeColor(RGBColor output) {
+    if (rgbState.currentValid &&
+        output.r == rgbState.currentR &&
+        output.g == rgbState.currentG &&
+        output.b == rgbState.currentB) return;
+
+    writePWM(RGB_PIN_R, applyPolarity(output.r));
+    writePWM(RGB_PIN_G, applyPolarity(output.g));
+    writePWM(RGB_PIN_B, applyPolarity(output.b));
+
+    rgbState.currentR = output.r;
+    rgbState.currentG = output.g;
+    rgbState.currentB = output.b;
+    rgbState.currentValid = true;
+}
+
+// The active request changed - hand a blink/pulse to the timer, write the rest now
+static void applyActive() {
+    if (rgbState.hardwareWave) {
+        hal::ledWaveStop();
+        rgbState.hardwareWave = false;
+        rgbState.currentValid = false;
+    }
+
+    const RGBRequest& req = rgbState.active;
+    if ((req.effect == EFFECT_BLINK || req.effect == EFFECT_PULSE) && req.period_ms > 0) {
+        static const uint8_t pins[3] = {RGB_PIN_R, RGB_PIN_G, RGB_PIN_B};
+        uint8_t peak[3] = {req.color.r, req.color.g, req.color.b};
+#ifdef RGB_COMMON_ANODE
+        bool invert = true;
+#else
+        bool invert = false;
+#endif
+        if (hal::ledWaveStart(req.effect == EFFECT_BLINK ? hal::LED_WAVE_BLINK : hal::LED_WAVE_RAMP,
+                              pins, peak, req.period_ms, invert)) {
+            rgbState.hardwareWave = true;
+            rgbState.currentValid = false;
+            return;
+        }
+    }
+
+    writeColor(effectOutput(0));  // Solid/off for good, or the first step of a loop-driven effect
+}
+
 // Find highest active priority and activate its request
 static void activateHighestPriority() {
     // Scan from highest to lowest priority
@@ -116,6 +226,7 @@ static void activateHighestPriority() {
         if (rgbState.priorityActive[i]) {
             rgbState.active = rgbState.priorityStack[i];
             rgbState.effectStartTime = millis();
+            applyActive();
             return;
         }
     }
@@ -123,6 +234,7 @@ static void activateHighestPriority() {
     // No active requests - turn off
     rgbState.active.effect = EFFECT_OFF;
     rgbState.active.priority = PRIORITY_IDLE;
+    applyActive();
 }
 
 // Set request at priority level
@@ -138,6 +250,7 @@ static void setRequest(RGBColor color, RGBEffect effect, uint16_t period_ms, RGB
     if (priority >= rgbState.active.priority) {
         rgbState.active = rgbState.priorityStack[slot];
         rgbState.effectStartTime = millis();
+        applyActive();
     }
 }
 
@@ -175,6 +288,8 @@ void initRGBLed() {
     rgbState.currentR = 0;
     rgbState.currentG = 0;
     rgbState.currentB = 0;
+    rgbState.currentValid = true;   // initPWM() wrote 0s
+    rgbState.hardwareWave = false;
 
     for (uint8_t i = 0; i < 5; i++) {
         rgbState.priorityActive[i] = false;
@@ -235,76 +350,13 @@ bool rgbLedIsActive() {
 }
 
 void updateRGBLed() {
-    if (!rgbState.initialized) return;
-
-    uint32_t now = millis();
-    uint32_t elapsed = now - rgbState.effectStartTime;
-
-    RGBColor output = RGB_OFF;
+    if (!rgbState.initialized || rgbState.hardwareWave) return;
 
-    switch (rgbState.active.effect) {
-        case EFFECT_OFF:
-            output = RGB_OFF;
-            break;
+    // Off and solid were written when they became active
+    RGBEffect effect = rgbState.active.effect;
+    if (effect == EFFECT_OFF || effect == EFFECT_SOLID) return;
 
-        case EFFECT_SOLID:
-            output = rgbState.active.color;
-            break;
-
-        case EFFECT_BLINK: {
-            // Square wave: on for half period, off for half
-            uint16_t period = rgbState.active.period_ms;
-            if (period == 0) {
-                // Fallback to solid if period is 0
-                output = rgbState.active.color;
-            } else {
-                uint32_t phase = elapsed % period;
-                output = (phase < period / 2) ? rgbState.active.color : RGB_OFF;
-            }
-            break;
-        }
-
-        case EFFECT_PULSE: {
-            // Triangular wave for smooth breathing
-            uint16_t period = rgbState.active.period_ms;
-            if (period == 0) {
-                // Fallback to solid if period is 0
-                output = rgbState.active.color;
-            } else {
-                uint32_t phase = elapsed % period;
-                uint16_t halfPeriod = period / 2;
-
-                uint8_t brightness;
-                if (phase < halfPeriod) {
-                    // Ramp up: 0 -> 255
-                    brightness = (phase * 255) / halfPeriod;
-                } else {
-                    // Ramp down: 255 -> 0
-                    brightness = ((period - phase) * 255) / halfPeriod;
-                }
-
-                // Apply brightness to color
-                output.r = (rgbState.active.color.r * brightness) / 255;
-                output.g = (rgbState.active.color.g * brightness) / 255;
-                output.b = (rgbState.active.color.b * brightness) / 255;
-            }
-            break;
-        }
-    }
-
-    // Only update PWM if values changed (reduce overhead)
-    if (output.r != rgbState.currentR ||
-        output.g != rgbState.currentG ||
-        output.b != rgbState.currentB) {
-
-        writePWM(RGB_PIN_R, applyPolarity(output.r));
-        writePWM(RGB_PIN_G, applyPolarity(output.g));
-        writePWM(RGB_PIN_B, applyPolarity(output.b));
-
-        rgbState.currentR = output.r;
-        rgbState.currentG = output.g;
-        rgbState.currentB = output.b;
-    }
+    writeColor(effectOutput(millis() - rgbState.effectStartTime));
 }
 
 #endif // ENABLE_LED
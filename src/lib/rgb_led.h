@@ -7,6 +7,7 @@
  * - Priority system (alarms override mode indication)
  * - Common cathode/anode support
  * - Platform-specific PWM (Teensy, ESP32, Arduino)
+ * - Blink/pulse on a hardware timer where there is one (Teensy, ESP32)
  */
 
 #ifndef RGB_LED_H
@@ -166,8 +167,8 @@ void rgbLedRelease(RGBPriority priority);
 void rgbLedOff();
 
 /**
- * Update LED output - handles effects timing
- * MUST be called every loop iteration for effects to work
+ * Update LED output - steps a blink/pulse the platform can't run on a timer
+ * (hal/hal_led_wave.h); returns at once otherwise. Call every loop iteration
  */
 void updateRGBLed();
 
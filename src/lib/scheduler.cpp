@@ -0,0 +1,362 @@
+/*
+ * scheduler.cpp - Deadline-ordered cooperative task scheduler implementation
+ */
+
+#include "scheduler.h"
+#include "loop_monitor.h"
+#include "dual_core.h"
+#ifdef ENABLE_LOOP_IDLE
+#include "../hal/hal_idle.h"
+#endif
+
+// Task table (indexed by task ID) and one binary min-heap of task IDs per
+// priority class, ordered by deadline
+static ScheduledTask tasks[MAX_SCHEDULER_TASKS];
+static uint8_t numTasks = 0;
+
+static uint8_t heap[NUM_TASK_PRIORITIES][MAX_SCHEDULER_TASKS];
+static uint8_t heapSize[NUM_TASK_PRIORITIES] = {0};
+
+static uint8_t pausedClasses = 0;    // Bit per priority class (pausePriority)
+static uint8_t detachedClasses = 0;  // Bit per priority class (detachPriority)
+
+// Deadline override for the task currently executing (see setTaskDeadline),
+// one per caller: loop(), and the acquisition task in dual-core builds
+struct RunContext {
+    uint8_t task = INVALID_TASK_ID;
+    bool override = false;
+    uint32_t deadline = 0;
+};
+
+#ifdef ENABLE_DUAL_CORE
+static RunContext contexts[2];
+static inline RunContext& runContext() { return contexts[onAcquisitionCore() ? 1 : 0]; }
+#else
+static RunContext context;
+static inline RunContext& runContext() { return context; }
+#endif
+
+// millis()-rollover-safe "a is earlier than b"
+static inline bool deadlineBefore(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+}
+
+static inline bool isDetached(uint8_t cls) {
+    return detachedClasses & (1 << cls);
+}
+
+// Heap ordering: earlier deadline first, ties broken by registration order so
+// tasks due at the same time run in a predictable sequence
+static inline bool taskBefore(uint8_t a, uint8_t b) {
+    if (tasks[a].deadline != tasks[b].deadline) {
+        return deadlineBefore(tasks[a].deadline, tasks[b].deadline);
+    }
+    return a < b;
+}
+
+// ===== HEAP OPERATIONS =====
+
+static void heapSwap(uint8_t* h, uint8_t i, uint8_t j) {
+    uint8_t tmp = h[i];
+    h[i] = h[j];
+    h[j] = tmp;
+}
+
+static void siftUp(uint8_t cls, uint8_t pos) {
+    uint8_t* h = heap[cls];
+    while (pos > 0) {
+        uint8_t parent = (pos - 1) / 2;
+        if (!taskBefore(h[pos], h[parent])) break;
+        heapSwap(h, pos, parent);
+        pos = parent;
+    }
+}
+
+static void siftDown(uint8_t cls, uint8_t pos) {
+    uint8_t* h = heap[cls];
+    uint8_t size = heapSize[cls];
+    while (true) {
+        uint8_t left = 2 * pos + 1;
+        uint8_t right = left + 1;
+        uint8_t smallest = pos;
+
+        if (left < size && taskBefore(h[left], h[smallest])) {
+            smallest = left;
+        }
+        if (right < size && taskBefore(h[right], h[smallest])) {
+            smallest = right;
+        }
+        if (smallest == pos) break;
+
+        heapSwap(h, pos, smallest);
+        pos = smallest;
+    }
+}
+
+static void heapPush(uint8_t id) {
+    uint8_t cls = tasks[id].priority;
+    heap[cls][heapSize[cls]] = id;
+    siftUp(cls, heapSize[cls]);
+    heapSize[cls]++;
+}
+
+static uint8_t heapPop(uint8_t cls) {
+    uint8_t top = heap[cls][0];
+    heapSize[cls]--;
+    if (heapSize[cls] > 0) {
+        heap[cls][0] = heap[cls][heapSize[cls]];
+        siftDown(cls, 0);
+    }
+    return top;
+}
+
+// Position of task in its class heap, or INVALID_TASK_ID if not queued
+static uint8_t heapFind(uint8_t id) {
+    uint8_t cls = tasks[id].priority;
+    for (uint8_t i = 0; i < heapSize[cls]; i++) {
+        if (heap[cls][i] == id) return i;
+    }
+    return INVALID_TASK_ID;
+}
+
+static void heapRemove(uint8_t id) {
+    uint8_t pos = heapFind(id);
+    if (pos == INVALID_TASK_ID) return;
+
+    uint8_t cls = tasks[id].priority;
+    heapSize[cls]--;
+    if (pos < heapSize[cls]) {
+        heap[cls][pos] = heap[cls][heapSize[cls]];
+        siftDown(cls, pos);
+        siftUp(cls, pos);
+    }
+}
+
+// Re-position a queued task after its deadline changed
+static void heapUpdate(uint8_t id) {
+    uint8_t pos = heapFind(id);
+    if (pos == INVALID_TASK_ID) return;
+    siftDown(tasks[id].priority, pos);
+    siftUp(tasks[id].priority, pos);
+}
+
+// ===== REGISTRATION =====
+
+uint8_t addScheduledTask(const char* name, TaskFunction function, uint16_t period_ms,
+                         TaskPriority priority) {
+    if (numTasks >= MAX_SCHEDULER_TASKS || function == nullptr ||
+        priority >= NUM_TASK_PRIORITIES) {
+        return INVALID_TASK_ID;
+    }
+
+    uint8_t id = numTasks++;
+    tasks[id].name = name;
+    tasks[id].function = function;
+    tasks[id].period_ms = period_ms;
+    tasks[id].deadline = millis();
+    tasks[id].shedCount = 0;
+    tasks[id].priority = priority;
+    tasks[id].enabled = true;
+    heapPush(id);
+
+    return id;
+}
+
+void setTaskPeriod(uint8_t id, uint16_t period_ms) {
+    if (id >= numTasks) return;
+    tasks[id].period_ms = period_ms;
+}
+
+void setTaskDeadline(uint8_t id, uint32_t deadline) {
+    if (id >= numTasks) return;
+
+    // Task is running - apply after it returns instead of the periodic reschedule
+    // (a task running on the other core reschedules itself as it returns)
+    RunContext& ctx = runContext();
+    if (id == ctx.task) {
+        ctx.override = true;
+        ctx.deadline = deadline;
+        return;
+    }
+
+    dualCoreLock();
+    tasks[id].deadline = deadline;
+    heapUpdate(id);
+    dualCoreUnlock();
+}
+
+void enableTask(uint8_t id, bool enable) {
+    if (id >= numTasks || tasks[id].enabled == enable) return;
+
+    tasks[id].enabled = enable;
+    if (id == runContext().task) return;  // Re-queued (or not) when it returns
+
+    dualCoreLock();
+    if (enable) {
+        tasks[id].deadline = millis();
+        heapPush(id);
+    } else {
+        heapRemove(id);
+    }
+    dualCoreUnlock();
+}
+
+const ScheduledTask* getScheduledTask(uint8_t id) {
+    return (id < numTasks) ? &tasks[id] : nullptr;
+}
+
+uint8_t getNumScheduledTasks() {
+    return numTasks;
+}
+
+// ===== EXECUTION =====
+
+bool shouldShedPriority(TaskPriority priority) {
+    if (pausedClasses & (1 << priority)) return true;
+    switch (priority) {
+        case PRIORITY_SAFETY:
+            return false;
+        case PRIORITY_TELEMETRY:
+            return getLoopElapsedUs() > 2UL * getLoopBudget() * 1000UL;
+        default:
+            return loopBudgetExceeded();
+    }
+}
+
+// Count every due task in a shed class (they stay queued and due)
+static void shedDueTasks(uint8_t cls, uint32_t now) {
+    dualCoreLock();
+    for (uint8_t i = 0; i < heapSize[cls]; i++) {
+        ScheduledTask* task = &tasks[heap[cls][i]];
+        if (!deadlineBefore(now, task->deadline)) {
+            task->shedCount++;
+            loopMonitorNoteDeferral();
+        }
+    }
+    dualCoreUnlock();
+}
+
+// Run the due tasks of one priority class; returns false if the budget ran out
+static bool runPriorityClass(uint8_t cls, uint32_t now, uint8_t* budget) {
+    RunContext& ctx = runContext();
+    while (true) {
+        dualCoreLock();
+        if (heapSize[cls] == 0 || deadlineBefore(now, tasks[heap[cls][0]].deadline)) {
+            dualCoreUnlock();
+            break;  // Earliest task not yet due
+        }
+        if (*budget == 0) {
+            dualCoreUnlock();
+            return false;
+        }
+        (*budget)--;
+        uint8_t id = heapPop(cls);
+        ctx.task = id;
+        ctx.override = false;
+        dualCoreUnlock();
+
+        ScheduledTask* task = &tasks[id];
+        if (!isDetached(cls)) loopMonitorMark(task->name);  // loop() sections only
+        task->function(now);
+        ctx.task = INVALID_TASK_ID;
+
+        if (!task->enabled) continue;  // Disabled itself - leave out of the heap
+
+        dualCoreLock();
+        if (ctx.override) {
+            task->deadline = ctx.deadline;
+        } else {
+            // Jitter-free: advance from the previous deadline, not from now
+            task->deadline += task->period_ms;
+
+            // More than a full period behind - resync rather than burst
+            if (!deadlineBefore(now, task->deadline)) {
+                task->deadline = now + task->period_ms;
+            }
+        }
+        heapPush(id);
+        dualCoreUnlock();
+    }
+    return true;
+}
+
+void runScheduler(uint32_t now) {
+    // Bound the number of runs per call so a zero-period task can't starve the loop
+    uint8_t budget = numTasks;
+
+    for (uint8_t cls = 0; cls < NUM_TASK_PRIORITIES; cls++) {
+        if (isDetached(cls)) continue;             // Another caller's
+        if (pausedClasses & (1 << cls)) continue;  // Held - not shed
+        if (shouldShedPriority((TaskPriority)cls)) {
+            shedDueTasks(cls, now);
+            continue;
+        }
+        if (!runPriorityClass(cls, now, &budget)) break;
+    }
+}
+
+void runPriority(uint32_t now, TaskPriority priority) {
+    if (priority >= NUM_TASK_PRIORITIES || (pausedClasses & (1 << priority))) return;
+    uint8_t budget = numTasks;
+    runPriorityClass(priority, now, &budget);
+}
+
+void pausePriority(TaskPriority priority, bool pause) {
+    if (priority >= NUM_TASK_PRIORITIES) return;
+    dualCoreLock();
+    if (pause) {
+        pausedClasses |= 1 << priority;
+    } else {
+        pausedClasses &= ~(1 << priority);
+    }
+    dualCoreUnlock();
+}
+
+void detachPriority(TaskPriority priority, bool detach) {
+    if (priority >= NUM_TASK_PRIORITIES) return;
+    dualCoreLock();
+    if (detach) {
+        detachedClasses |= 1 << priority;
+    } else {
+        detachedClasses &= ~(1 << priority);
+    }
+    dualCoreUnlock();
+}
+
+// Earliest deadline of the queued, unpaused classes in mask
+static uint32_t nextDeadlineOf(uint8_t mask, uint32_t now) {
+    bool any = false;
+    uint32_t next = now + 1;
+    dualCoreLock();
+    for (uint8_t cls = 0; cls < NUM_TASK_PRIORITIES; cls++) {
+        if (!(mask & (1 << cls)) || heapSize[cls] == 0 || (pausedClasses & (1 << cls))) continue;
+        uint32_t deadline = tasks[heap[cls][0]].deadline;
+        if (!any || deadlineBefore(deadline, next)) {
+            next = deadline;
+            any = true;
+        }
+    }
+    dualCoreUnlock();
+    return next;
+}
+
+uint32_t getNextDeadline(uint32_t now) {
+    return nextDeadlineOf(~detachedClasses, now);
+}
+
+uint32_t getPriorityDeadline(uint32_t now, TaskPriority priority) {
+    if (priority >= NUM_TASK_PRIORITIES) return now + 1;
+    return nextDeadlineOf(1 << priority, now);
+}
+
+void schedulerIdle() {
+#ifdef ENABLE_LOOP_IDLE
+    uint32_t now = millis();
+    if (!deadlineBefore(now, getNextDeadline(now))) return;  // Something is already due
+
+    // Sleep until the next interrupt (tick, UART, USB, CAN). The caller's loop
+    // then re-polls transports and re-checks deadlines, so command and CAN
+    // latency stays bounded by one tick.
+    hal::idleUntilInterrupt();
+#endif
+}
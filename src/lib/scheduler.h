@@ -0,0 +1,125 @@
+/*
+ * scheduler.h - Deadline-ordered cooperative task scheduler
+ *
+ * Replaces ad-hoc "now - lastX >= interval" polling in loop() with a small
+ * min-heap of periodic tasks keyed by their next deadline. The loop only
+ * touches tasks that are actually due, and always knows how long it has until
+ * the next one (used to idle the CPU between deadlines).
+ *
+ * Rescheduling is jitter-free: a task's next deadline is its previous deadline
+ * plus its period, not "now" plus its period, so a slow iteration (e.g. a long
+ * SPI read) doesn't permanently shift the cadence. If a task falls more than a
+ * full period behind it is resynchronised to now + period instead of bursting
+ * to catch up.
+ *
+ * Tasks that keep their own sub-schedule (per-input reads, per-module output
+ * intervals) can override their next deadline from inside the task function
+ * with setTaskDeadline().
+ *
+ * Every task has a priority class. Due tasks run class by class - safety
+ * first, then telemetry, then cosmetic - so a slow LCD refresh can never delay
+ * an alarm check or relay update queued in the same iteration. When the loop
+ * is over budget (lib/loop_monitor.h) cosmetic tasks are shed first, then
+ * telemetry at twice the budget; safety tasks are never shed. Shed tasks stay
+ * due and run on the next iteration that has time for them.
+ *
+ * A whole class can also be paused (pausePriority()) - its tasks stay queued
+ * but don't run, aren't counted as shed and don't hold the loop awake. The
+ * bench streamer pauses the cosmetic class.
+ *
+ * A class can instead be detached (detachPriority()): runScheduler() leaves
+ * it to another caller, which runs it with runPriority() - the dual-core
+ * acquisition task (dual_core.h) takes the safety class this way. Heap
+ * updates are then made under the dual-core spinlock, so a task on one
+ * core can still move the deadline of a task on the other.
+ *
+ * Usage:
+ *   static void checkAlarms(uint32_t now) { ... }
+ *   uint8_t id = addScheduledTask("ALARM", checkAlarms, 50, PRIORITY_SAFETY);
+ *   void loop() { runScheduler(millis()); }
+ *
+ * Build Flags:
+ *   -D MAX_SCHEDULER_TASKS=n  - Task table size (default 10)
+ *   -D ENABLE_LOOP_IDLE       - Idle the CPU between deadlines (see schedulerIdle())
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+#ifndef MAX_SCHEDULER_TASKS
+#define MAX_SCHEDULER_TASKS 10
+#endif
+
+#define INVALID_TASK_ID 0xFF
+
+// Priority classes (lower value runs first, sheds last)
+enum TaskPriority : uint8_t {
+    PRIORITY_SAFETY = 0,     // Alarm inputs, alarm evaluation, relays - never shed
+    PRIORITY_TELEMETRY,      // CAN/RealDash/SD data - shed at 2x loop budget
+    PRIORITY_COSMETIC,       // LCD, LED, serial CSV - shed as soon as budget is spent
+    NUM_TASK_PRIORITIES
+};
+
+// Task function signature - receives the loop's timestamp
+typedef void (*TaskFunction)(uint32_t now);
+
+struct ScheduledTask {
+    const char* name;        // Short name for diagnostics
+    TaskFunction function;   // Work to perform when due
+    uint16_t period_ms;      // Nominal period
+    uint32_t deadline;       // millis() timestamp of next run
+    uint32_t shedCount;      // Iterations this task was due but shed for load
+    TaskPriority priority;
+    bool enabled;
+};
+
+// ===== REGISTRATION =====
+
+// Register a periodic task (first run is due immediately)
+// Returns task ID, or INVALID_TASK_ID if the table is full
+uint8_t addScheduledTask(const char* name, TaskFunction function, uint16_t period_ms,
+                         TaskPriority priority = PRIORITY_TELEMETRY);
+
+// Change a task's period (takes effect from the next reschedule)
+void setTaskPeriod(uint8_t id, uint16_t period_ms);
+
+// Override a task's next deadline (may be called from inside the task)
+void setTaskDeadline(uint8_t id, uint32_t deadline);
+
+// Enable/disable a task (re-enabled tasks are due immediately)
+void enableTask(uint8_t id, bool enable);
+
+const ScheduledTask* getScheduledTask(uint8_t id);
+uint8_t getNumScheduledTasks();
+
+// ===== EXECUTION =====
+
+// Run every task whose deadline has passed, by priority class then deadline
+void runScheduler(uint32_t now);
+
+// True if tasks of this class should be skipped this iteration (loop overloaded or paused)
+bool shouldShedPriority(TaskPriority priority);
+
+// Hold every task of a class (pause = true) until released; resumed tasks
+// that fell due while paused run on the next iteration
+void pausePriority(TaskPriority priority, bool pause);
+
+// Leave a class to runPriority() (detach = true), or give it back to runScheduler()
+void detachPriority(TaskPriority priority, bool detach);
+
+// Run the due tasks of one class (a detached class's owner)
+void runPriority(uint32_t now, TaskPriority priority);
+
+// Earliest pending deadline of runScheduler()'s classes (now + 1 if no tasks are queued)
+uint32_t getNextDeadline(uint32_t now);
+
+// Earliest pending deadline of one class (now + 1 if none are queued)
+uint32_t getPriorityDeadline(uint32_t now, TaskPriority priority);
+
+// If nothing is due, sleep the CPU until the next interrupt (at most one
+// system tick). No-op unless ENABLE_LOOP_IDLE is defined.
+void schedulerIdle();
+
+#endif // SCHEDULER_H
@@ -22,10 +22,26 @@
 // ===== CALIBRATION DATA BY MANUFACTURER =====
 // Include modular calibration files organized by manufacturer
 
+// Static builds with thin libraries leave out the files no configured sensor
+// uses (generated/static_manifest.h)
+#if defined(USE_STATIC_CONFIG) && __has_include("generated/static_manifest.h")
+#include "generated/static_manifest.h"
+#endif
+
+#ifndef STATIC_SKIP_CAL_VDO
 #include "sensor_calibration_data/vdo/vdo_calibrations.h"
+#endif
+#ifndef STATIC_SKIP_CAL_AEM
 #include "sensor_calibration_data/aem/aem_calibrations.h"
+#endif
+#ifndef STATIC_SKIP_CAL_NXP
 #include "sensor_calibration_data/nxp/nxp_calibrations.h"
+#endif
+#ifndef STATIC_SKIP_CAL_GENERIC
 #include "sensor_calibration_data/generic/generic_calibrations.h"
+#endif
+#ifndef STATIC_SKIP_CAL_SYSTEM
 #include "sensor_calibration_data/system/system_calibrations.h"
+#endif
 
 #endif // SENSOR_CALIBRATION_DATA_H
@@ -15,7 +15,8 @@
  * 1. Add calibration data to sensor_calibration_data/ (if needed)
  * 2. Find the appropriate category file in sensor_library/sensors/
  * 3. Add PROGMEM strings for name and label
- * 4. Add X_SENSOR entry to the category's macro
+ * 4. Add X_SENSOR entry to the category's macro (X_SENSOR_TWO_PHASE for a
+ *    sensor with a conversion time, see SensorInfo::startFunction)
  * 5. Compute hash: python3 -c "h=5381; s='YOUR_NAME'; [h:=(h<<5)+h+ord(c.upper()) for c in s]; print(f'0x{h&0xFFFF:04X}')"
  *
  * MEMORY: All data here is stored in PROGMEM (flash), not RAM.
@@ -44,11 +45,16 @@
 #include "sensor_library/sensors/environmental.h"
 #include "sensor_library/sensors/digital.h"
 #include "sensor_library/sensors/can.h"
+#include "sensor_library/sensors/math.h"
+#include "sensor_library/sensors/gps.h"
+#include "sensor_library/sensors/node.h"
 
 // ===== SENSOR LIBRARY ASSEMBLY (PROGMEM) =====
 // Assemble SENSOR_LIBRARY[] from X-macros defined in each category file
 #define X_SENSOR(name, label, desc, readFn, initFn, measType, calType, defCal, minInt, minVal, maxVal, hash, pinType) \
     { name, label, desc, readFn, initFn, measType, calType, defCal, minInt, minVal, maxVal, hash, pinType },
+#define X_SENSOR_TWO_PHASE(name, label, desc, readFn, initFn, measType, calType, defCal, minInt, minVal, maxVal, hash, pinType, startFn, completeFn) \
+    { name, label, desc, readFn, initFn, measType, calType, defCal, minInt, minVal, maxVal, hash, pinType, startFn, completeFn },
 
 static const PROGMEM SensorInfo SENSOR_LIBRARY[] = {
     NONE_SENSORS
@@ -60,9 +66,13 @@ static const PROGMEM SensorInfo SENSOR_LIBRARY[] = {
     ENVIRONMENTAL_SENSORS
     DIGITAL_SENSORS
     CAN_SENSORS
+    MATH_SENSORS
+    GPS_SENSORS
+    NODE_SENSORS
 };
 
 #undef X_SENSOR
+#undef X_SENSOR_TWO_PHASE
 
 // Automatically calculate the number of sensors
 constexpr uint8_t NUM_SENSORS = sizeof(SENSOR_LIBRARY) / sizeof(SENSOR_LIBRARY[0]);
@@ -12,6 +12,7 @@
 #include "sensor_types.h"
 #include "sensor_categories.h"
 #include "../hash.h"
+#include "../generated/registry_hashes.h"
 
 // Helper macros for reading individual fields from PROGMEM
 #define READ_SENSOR_NAME(info) ((const char*)pgm_read_ptr(&(info)->name))
@@ -43,10 +44,22 @@ inline const SensorInfo* getSensorByIndex(uint8_t index) {
     return &SENSOR_LIBRARY[index];
 }
 
+#ifndef USE_STATIC_CONFIG
+// Thin static libraries renumber the sensors; they keep the scan
+static_assert(SENSOR_HASH_COUNT == NUM_SENSORS, "registry_hashes.h is stale - run tools/generate_registry_enums.py");
+#endif
+
 /**
- * Get Sensor index by name hash (O(n) search)
+ * Get Sensor index by name hash (O(1) perfect hash, registry_hashes.h)
+ * Scans the library if the slot doesn't hold the hash (unknown name)
  */
 inline uint8_t getSensorIndexByHash(uint16_t hash) {
+#ifndef USE_STATIC_CONFIG
+    uint8_t slot = pgm_read_byte(&SENSOR_HASH_SLOTS[REGISTRY_HASH_SLOT(hash, SENSOR_HASH_SEED, SENSOR_HASH_BITS)]);
+    if (slot < NUM_SENSORS && pgm_read_word(&SENSOR_LIBRARY[slot].nameHash) == hash) {
+        return slot;
+    }
+#endif
     for (uint8_t i = 0; i < NUM_SENSORS; i++) {
         uint16_t sensorHash = pgm_read_word(&SENSOR_LIBRARY[i].nameHash);
         if (sensorHash == hash) {
@@ -57,7 +70,7 @@ inline uint8_t getSensorIndexByHash(uint16_t hash) {
 }
 
 /**
- * Get Sensor index by name (O(n) search)
+ * Get Sensor index by name (O(1) hash lookup)
  */
 inline uint8_t getSensorIndexByName(const char* name) {
     if (!name) return 0;
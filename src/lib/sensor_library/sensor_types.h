@@ -46,6 +46,13 @@ struct SensorInfo {
 #ifndef USE_STATIC_CONFIG
     PinTypeRequirement pinTypeRequirement;  // What type of pin this sensor requires
 #endif
+    // Optional two-phase read (X_SENSOR_TWO_PHASE; nullptr for X_SENSOR entries)
+    // for sensors with a conversion time. The scheduler starts the conversions
+    // of every due input in one pass and collects each one once it is ready, so
+    // slow conversions overlap instead of one read waiting out each in turn.
+    // readFunction stays the synchronous read (static read pipeline, test mode).
+    uint16_t (*startFunction)(Input*);     // Trigger a conversion; returns ms until ready (0 = ready now)
+    void (*completeFunction)(Input*);      // Fetch the result into the input, like readFunction
 };
 
 // ===== FORWARD DECLARATIONS: READ FUNCTIONS =====
@@ -64,30 +71,45 @@ extern void readBME280Humidity(Input*);
 extern void readBME280Elevation(Input*);
 extern void readDigitalFloatSwitch(Input*);
 extern void readHallSpeed(Input*);
+extern void readGpsSpeed(Input*);
+extern void readGpsAltitude(Input*);
 
 // ===== FORWARD DECLARATIONS: INIT FUNCTIONS =====
-extern void initThermocoupleCS(Input*);
+extern void initMAX6675(Input*);
+extern void initMAX31855(Input*);
 extern void initWPhaseRPM(Input*);
 extern void initFloatSwitch(Input*);
 extern void initBME280(Input*);
 extern void initHallSpeed(Input*);
 
+// ===== FORWARD DECLARATIONS: TWO-PHASE START FUNCTIONS =====
+extern uint16_t startBME280(Input*);
+
 // ===== FORWARD DECLARATIONS: UNIT CONVERSION =====
 extern float convertFromBaseUnits(float baseValue, uint8_t unitsIndex);
 extern float convertToBaseUnits(float displayValue, uint8_t unitsIndex);
 
-// ===== FORWARD DECLARATIONS: OBD CONVERSION =====
-extern float obdConvertTemperature(float value);
-extern float obdConvertPressure(float value);
-extern float obdConvertVoltage(float value);
-extern float obdConvertRPM(float value);
-extern float obdConvertHumidity(float value);
-extern float obdConvertElevation(float value);
-extern float obdConvertFloatSwitch(float value);
-extern float obdConvertSpeed(float value);
+// ===== OBD CONVERSION =====
+// OBD-II PID encoding per measurement type, from standard units:
+//   raw = value * scale + offset, rounded and clamped to the PID's bytes
+// (refreshOBD2Data()). The inverse is the PID's formula in standard_pids.h.
+struct ObdScale {
+    float scale;
+    float offset;
+};
 
-// Helper function to get OBD conversion function pointer from measurement type
-typedef float (*ObdConvertFunc)(float);
-ObdConvertFunc getObdConvertFunc(MeasurementType type);
+inline ObdScale getObdScale(MeasurementType type) {
+    switch (type) {
+        case MEASURE_TEMPERATURE: return {1.0f, 40.0f};     // A - 40 C (PID 0x05)
+        case MEASURE_PRESSURE:    return {10.0f, 0.0f};     // A / 10 bar
+        case MEASURE_VOLTAGE:     return {10.0f, 0.0f};     // A / 10 V
+        case MEASURE_RPM:         return {4.0f, 0.0f};      // (256A + B) / 4 RPM (PID 0x0C)
+        case MEASURE_HUMIDITY:    return {2.55f, 0.0f};     // A * 100 / 255 %
+        case MEASURE_ELEVATION:   return {1.0f, 0.0f};      // m
+        case MEASURE_DIGITAL:     return {255.0f, 0.0f};    // 0 or 255
+        case MEASURE_SPEED:       return {1.0f, 0.0f};      // A km/h (PID 0x0D)
+        default:                  return {10.0f, 0.0f};
+    }
+}
 
 #endif // SENSOR_LIBRARY_TYPES_H
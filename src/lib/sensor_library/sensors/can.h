@@ -27,8 +27,12 @@ static const PROGMEM CANSensorCalibration default_can_cal = {
     .data_offset = 0,            // Start of data payload
     .data_length = 1,            // Single byte default
     .is_big_endian = true,       // OBD-II uses big-endian
+    .bit_offset = 0,
+    .bit_length = 0,             // Whole bytes
     .scale_factor = 1.0,         // No scaling by default
-    .offset = 0.0                // No offset by default
+    .offset = 0.0,               // No offset by default
+    .timeout_ms = 0,             // Default stale timeout
+    .whole_frame = false         // PID-keyed (OBD-II response)
 };
 
 // ===== SENSOR ENTRIES (X-MACRO) =====
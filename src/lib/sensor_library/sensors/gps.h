@@ -0,0 +1,32 @@
+/*
+ * gps.h - GPS Sensors
+ *
+ * Speed over ground and altitude from a GPS receiver on a hardware serial
+ * port (lib/gps.h), on the virtual pins GPS:0-7.
+ */
+
+#ifndef SENSOR_LIBRARY_SENSORS_GPS_H
+#define SENSOR_LIBRARY_SENSORS_GPS_H
+
+#include <Arduino.h>
+#include "../../gps.h"  // GPS_RATE_MS
+
+// ===== PROGMEM STRINGS =====
+static const char PSTR_GPS_SPEED[] PROGMEM = "GPS_SPEED";
+static const char PSTR_GPS_SPEED_LABEL[] PROGMEM = "GPS speed over ground";
+static const char PSTR_GPS_ALTITUDE[] PROGMEM = "GPS_ALTITUDE";
+static const char PSTR_GPS_ALTITUDE_LABEL[] PROGMEM = "GPS altitude (MSL)";
+
+// ===== SENSOR ENTRIES (X-MACRO) =====
+// X_SENSOR(name, label, description, readFunc, initFunc, measType, calType, defaultCal, minInterval, minVal, maxVal, hash, pinType)
+#define GPS_SENSORS \
+    X_SENSOR(PSTR_GPS_SPEED, PSTR_GPS_SPEED_LABEL, nullptr, readGpsSpeed, nullptr, \
+             MEASURE_SPEED, CAL_NONE, nullptr, GPS_RATE_MS, 0.0, 300.0, 0x2D5F, PIN_ANALOG) \
+    X_SENSOR(PSTR_GPS_ALTITUDE, PSTR_GPS_ALTITUDE_LABEL, nullptr, readGpsAltitude, nullptr, \
+             MEASURE_ELEVATION, CAL_NONE, nullptr, GPS_RATE_MS, -500.0, 9000.0, 0x364A, PIN_ANALOG)
+
+// Note:
+// - minInterval: a new fix arrives every GPS_RATE_MS at most
+// - PIN_ANALOG is placeholder (GPS inputs use virtual pins 0xA0-0xA7)
+
+#endif // SENSOR_LIBRARY_SENSORS_GPS_H
@@ -0,0 +1,44 @@
+/*
+ * math.h - Math Channels
+ *
+ * Virtual inputs MATH:0-15 computed from other inputs' readings
+ * (inputs/input_math.h) rather than read from a pin or a bus.
+ */
+
+#ifndef SENSOR_LIBRARY_SENSORS_MATH_H
+#define SENSOR_LIBRARY_SENSORS_MATH_H
+
+#include <Arduino.h>
+#include "../../../inputs/input_math.h"  // MATH_CHANNEL_INTERVAL_MS
+
+// ===== PROGMEM STRINGS =====
+static const char PSTR_MATH[] PROGMEM = "MATH";
+static const char PSTR_MATH_LABEL[] PROGMEM = "Math Channel";
+static const char PSTR_MATH_DESC[] PROGMEM = "Derived from other inputs - SET MATH:n MATH <expression>";
+
+// ===== DEFAULT CALIBRATION =====
+// No expression until SET MATH:n MATH (reads NAN, NO_CALIBRATION)
+static const PROGMEM MathChannelCalibration default_math_cal = {
+    .op = MATH_OP_NONE,
+    .source_a = 0xFF,
+    .source_b = MATH_SOURCE_CONSTANT,
+    .integrate = 0,
+    .constant = 0.0,
+    .scale = 1.0,
+    .offset = 0.0
+};
+
+// ===== SENSOR ENTRIES (X-MACRO) =====
+// X_SENSOR(name, label, description, readFunc, initFunc, measType, calType, defaultCal, minInterval, minVal, maxVal, hash, pinType)
+#define MATH_SENSORS \
+    X_SENSOR(PSTR_MATH, PSTR_MATH_LABEL, PSTR_MATH_DESC, readMathChannel, nullptr, \
+             MEASURE_VOLTAGE, CAL_MATH_CHANNEL, &default_math_cal, \
+             MATH_CHANNEL_INTERVAL_MS, -1.0e9, 1.0e9, 0x684F, PIN_ANALOG)
+
+// Note:
+// - measurementType is a placeholder: compileMathChannels() takes it from the application
+// - minInterval is how often a channel checks its sources for new readings
+// - hash 0x684F = djb2_hash("MATH")
+// - PIN_ANALOG is placeholder (math channels use virtual pins 0xB0-0xBF)
+
+#endif // SENSOR_LIBRARY_SENSORS_MATH_H
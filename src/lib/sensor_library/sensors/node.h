@@ -0,0 +1,34 @@
+/*
+ * node.h - Node Channels
+ *
+ * Virtual inputs NODE:0-31 carrying the inputs of another preOBD unit on
+ * the CAN node network (lib/can_node.h), made when its channel table
+ * arrives.
+ */
+
+#ifndef SENSOR_LIBRARY_SENSORS_NODE_H
+#define SENSOR_LIBRARY_SENSORS_NODE_H
+
+#include <Arduino.h>
+#include "../../can_node.h"  // CAN_NODE_VALUE_MS
+
+// ===== PROGMEM STRINGS =====
+static const char PSTR_NODE[] PROGMEM = "NODE";
+static const char PSTR_NODE_LABEL[] PROGMEM = "Node Channel";
+static const char PSTR_NODE_DESC[] PROGMEM = "Input of another unit - BUS CAN NODE SUBSCRIBE <n>";
+
+// ===== SENSOR ENTRIES (X-MACRO) =====
+// X_SENSOR(name, label, description, readFunc, initFunc, measType, calType, defaultCal, minInterval, minVal, maxVal, hash, pinType)
+#define NODE_SENSORS \
+    X_SENSOR(PSTR_NODE, PSTR_NODE_LABEL, PSTR_NODE_DESC, readNodeChannel, nullptr, \
+             MEASURE_VOLTAGE, CAL_NODE_CHANNEL, nullptr, \
+             CAN_NODE_VALUE_MS, -1.0e9, 1.0e9, 0x2E2B, PIN_ANALOG)
+
+// Note:
+// - measurementType is a placeholder: rebuildCANNodeTable() takes it from the application
+// - The source (node, remote pin) is set in the custom calibration by the import
+// - minInterval: a new value arrives every CAN_NODE_VALUE_MS at most
+// - hash 0x2E2B = djb2_hash("NODE")
+// - PIN_ANALOG is placeholder (node channels use virtual pins 0x80-0x9F)
+
+#endif // SENSOR_LIBRARY_SENSORS_NODE_H
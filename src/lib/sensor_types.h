@@ -33,7 +33,9 @@ enum CalibrationType {
     CAL_VOLTAGE_DIVIDER,
     CAL_RPM,
     CAL_SPEED,               // Speed sensor calibration
-    CAL_CAN_IMPORT           // CAN bus imported sensor
+    CAL_CAN_IMPORT,          // CAN bus imported sensor
+    CAL_MATH_CHANNEL,        // Math channel derived from other inputs (inputs/input_math.h)
+    CAL_NODE_CHANNEL         // Channel imported from another node (lib/can_node.h)
 };
 
 // ===== CALIBRATION STRUCTURES =====
@@ -125,11 +127,31 @@ typedef struct {
 typedef struct {
     uint16_t source_can_id;      // CAN ID to listen for (0x7E8 for OBD-II, 0x400+ for J1939)
     uint8_t source_pid;          // PID or identifier byte within CAN frame
-    uint8_t data_offset;         // Byte offset within CAN frame data (0-7)
-    uint8_t data_length;         // Number of bytes to extract (1-4)
+    uint8_t data_offset;         // Byte offset within CAN frame data (0-7, 0-63 on CAN FD)
+    uint8_t data_length;         // Number of bytes to extract (1-4), when bit_length is 0
     bool is_big_endian;          // Byte order: true for big-endian (OBD-II), false for little-endian
+    uint8_t bit_offset;          // Bit-packed signals: start bit within data_offset byte (0-7, LSB = 0)
+    uint8_t bit_length;          // Bit-packed signal length (1-32), 0 = whole bytes (data_length)
     float scale_factor;          // Conversion multiplier (e.g., 0.25 for RPM)
     float offset;                // Conversion offset (e.g., -40 for temperature)
+    uint16_t timeout_ms;         // Stale after this long without a frame (0 = CAN_DEFAULT_TIMEOUT_MS)
+    bool whole_frame;            // Broadcast frame with no PID byte: matched on CAN ID alone,
+                                 // data_offset counts from data byte 0 (source_pid unused)
 } CANSensorCalibration;
 
+// ===== MATH CHANNEL CALIBRATION STRUCTURE =====
+// Compiled expression of a MATH:n input: (A <op> B) * scale + offset,
+// B another input or a constant; optionally totalled over time
+#define MATH_SOURCE_CONSTANT 0xFF   // source_b: B is the constant
+
+typedef struct {
+    uint8_t op;                  // MathOp (inputs/input_math.h)
+    uint8_t source_a;            // Pin of input A
+    uint8_t source_b;            // Pin of input B, or MATH_SOURCE_CONSTANT
+    uint8_t integrate;           // 1 = the value is the running total of the result x seconds
+    float constant;              // B when source_b is MATH_SOURCE_CONSTANT
+    float scale;                 // Result multiplier
+    float offset;                // Result offset
+} MathChannelCalibration;
+
 #endif
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include "system_config.h"
 #include "message_api.h"
 #include "log_tags.h"
+#include "../hal/hal_placement.h"
 
 // ============================================================================
 // SERIAL CONFIG HELPERS
@@ -45,7 +46,11 @@ static const uint32_t BAUD_RATES[] = {
     115200,  // BAUD_115200 = 4
     230400,  // BAUD_230400 = 5
     460800,  // BAUD_460800 = 6
-    921600   // BAUD_921600 = 7
+    921600,  // BAUD_921600 = 7
+    1000000, // BAUD_1000000 = 8
+    2000000, // BAUD_2000000 = 9
+    3000000, // BAUD_3000000 = 10
+    4000000  // BAUD_4000000 = 11
 };
 
 static const char* BAUD_STRINGS[] = {
@@ -56,7 +61,11 @@ static const char* BAUD_STRINGS[] = {
     "115200",
     "230400",
     "460800",
-    "921600"
+    "921600",
+    "1000000",
+    "2000000",
+    "3000000",
+    "4000000"
 };
 
 uint32_t getBaudRateFromIndex(uint8_t index) {
@@ -76,6 +85,12 @@ const char* getBaudRateString(uint8_t index) {
     return BAUD_STRINGS[index];
 }
 
+uint8_t getMaxBaudIndex() {
+    uint8_t index = 0;
+    while (index + 1 < NUM_BAUD_RATES && BAUD_RATES[index + 1] <= SERIAL_MAX_BAUD) index++;
+    return index;
+}
+
 // ============================================================================
 // SERIAL PORT STATE
 // ============================================================================
@@ -83,6 +98,69 @@ const char* getBaudRateString(uint8_t index) {
 // Track which ports have been initialized at runtime
 static uint8_t active_ports_mask = 0;
 
+// Ports taken by a driver instead of a transport (claimSerialPort())
+static const char* port_claims[8] = {nullptr};
+
+#if SERIAL_FLOW_CONTROL
+// Large buffers for fast or flow-controlled ports, given to a port for good
+// (the core has no way to take added memory back)
+HAL_DMA_BUFFER static uint8_t fast_rx[SERIAL_FAST_PORTS][SERIAL_FAST_RX_BYTES];
+HAL_DMA_BUFFER static uint8_t fast_tx[SERIAL_FAST_PORTS][SERIAL_FAST_TX_BYTES];
+static uint8_t fast_owner[SERIAL_FAST_PORTS] = {0};   // Port id, 0 = free
+
+static inline bool hasFlowControl(uint8_t port_id) {
+    return systemConfig.serial.flow_port == port_id;
+}
+
+// Buffers, RTS/CTS, then begin() - in that order, as the core wants them
+template <typename Port>
+static bool startPort(Port& port, uint8_t port_id, uint32_t baudrate) {
+    bool flow = hasFlowControl(port_id);
+    if (baudrate >= SERIAL_FAST_BAUD || flow) {
+        int8_t slot = -1;
+        for (uint8_t i = 0; i < SERIAL_FAST_PORTS && slot < 0; i++) {
+            if (fast_owner[i] == port_id) slot = i;
+        }
+        for (uint8_t i = 0; i < SERIAL_FAST_PORTS && slot < 0; i++) {
+            if (fast_owner[i] == 0) {
+                slot = i;
+                fast_owner[i] = port_id;
+                port.addMemoryForRead(fast_rx[i], SERIAL_FAST_RX_BYTES);
+                port.addMemoryForWrite(fast_tx[i], SERIAL_FAST_TX_BYTES);
+            }
+        }
+        if (slot < 0) {
+            msg.debug.warn(TAG_SERIAL, "Serial%d: no large buffer left (SERIAL_FAST_PORTS=%d) - core buffers only",
+                           port_id, SERIAL_FAST_PORTS);
+        }
+    }
+
+    port.begin(baudrate);
+    if (flow) {
+        if (!port.attachRts(systemConfig.serial.rts_pin)) {
+            msg.debug.error(TAG_SERIAL, "Serial%d: pin %d can't be RTS", port_id, systemConfig.serial.rts_pin);
+        }
+        if (!port.attachCts(systemConfig.serial.cts_pin)) {
+            msg.debug.error(TAG_SERIAL, "Serial%d: pin %d can't be CTS on this port", port_id, systemConfig.serial.cts_pin);
+        }
+    }
+    return true;
+}
+
+// The port has one of the large buffers
+static bool hasFastBuffer(uint8_t port_id) {
+    for (uint8_t i = 0; i < SERIAL_FAST_PORTS; i++) {
+        if (fast_owner[i] == port_id) return true;
+    }
+    return false;
+}
+#else
+static inline bool hasFlowControl(uint8_t port_id) {
+    (void)port_id;
+    return false;
+}
+#endif
+
 // ============================================================================
 // MAIN INITIALIZATION
 // ============================================================================
@@ -90,6 +168,7 @@ static uint8_t active_ports_mask = 0;
 void initConfiguredSerialPorts() {
     // Initialize each enabled serial port
     for (uint8_t port_id = 1; port_id <= NUM_SERIAL_PORTS; port_id++) {
+        if (getSerialPortClaim(port_id)) continue;  // Driver-owned (GPS)
         if (isSerialPortEnabled(&systemConfig.serial, port_id)) {
             uint32_t baudrate = getBaudRateFromIndex(systemConfig.serial.baudrate_index[port_id - 1]);
             initSerialPort(port_id, baudrate);
@@ -119,6 +198,15 @@ bool initSerialPort(uint8_t port_id, uint32_t baudrate) {
     if (!validateNoPinConflict(tx, PIN_RESERVED, getSerialPortName(port_id))) {
         return false;
     }
+    bool flow = hasFlowControl(port_id);
+    if (flow && (!validateNoPinConflict(systemConfig.serial.rts_pin, PIN_RESERVED, getSerialPortName(port_id)) ||
+                 !validateNoPinConflict(systemConfig.serial.cts_pin, PIN_RESERVED, getSerialPortName(port_id)))) {
+        return false;
+    }
+    if (baudrate > SERIAL_MAX_BAUD) {
+        msg.debug.error(TAG_SERIAL, "Serial%d: %lu baud is above SERIAL_MAX_BAUD", port_id, baudrate);
+        return false;
+    }
 
     // Platform-specific initialization
     bool success = false;
@@ -126,15 +214,15 @@ bool initSerialPort(uint8_t port_id, uint32_t baudrate) {
 #if defined(__IMXRT1062__)
     // Teensy 4.x: Serial1-Serial7 (or Serial8 on 4.1)
     switch (port_id) {
-        case 1: Serial1.begin(baudrate); success = true; break;
-        case 2: Serial2.begin(baudrate); success = true; break;
-        case 3: Serial3.begin(baudrate); success = true; break;
-        case 4: Serial4.begin(baudrate); success = true; break;
-        case 5: Serial5.begin(baudrate); success = true; break;
-        case 6: Serial6.begin(baudrate); success = true; break;
-        case 7: Serial7.begin(baudrate); success = true; break;
+        case 1: success = startPort(Serial1, port_id, baudrate); break;
+        case 2: success = startPort(Serial2, port_id, baudrate); break;
+        case 3: success = startPort(Serial3, port_id, baudrate); break;
+        case 4: success = startPort(Serial4, port_id, baudrate); break;
+        case 5: success = startPort(Serial5, port_id, baudrate); break;
+        case 6: success = startPort(Serial6, port_id, baudrate); break;
+        case 7: success = startPort(Serial7, port_id, baudrate); break;
 #if defined(ARDUINO_TEENSY41)
-        case 8: Serial8.begin(baudrate); success = true; break;
+        case 8: success = startPort(Serial8, port_id, baudrate); break;
 #endif
     }
 
@@ -181,16 +269,42 @@ bool initSerialPort(uint8_t port_id, uint32_t baudrate) {
         // Register pins
         registerPin(rx, PIN_RESERVED, getSerialPortName(port_id));
         registerPin(tx, PIN_RESERVED, getSerialPortName(port_id));
+        if (flow) {
+            registerPin(systemConfig.serial.rts_pin, PIN_RESERVED, getSerialPortName(port_id));
+            registerPin(systemConfig.serial.cts_pin, PIN_RESERVED, getSerialPortName(port_id));
+        }
 
-        msg.debug.info(TAG_SERIAL, "Serial%d initialized @ %lu baud", port_id, baudrate);
+        msg.debug.info(TAG_SERIAL, "Serial%d initialized @ %lu baud%s", port_id, baudrate, flow ? ", RTS/CTS" : "");
     }
 
     return success;
 }
 
+bool claimSerialPort(uint8_t port_id, uint32_t baudrate, const char* owner) {
+    if (port_id < 1 || port_id > NUM_SERIAL_PORTS) {
+        msg.debug.error(TAG_SERIAL, "Serial%d not available on this platform", port_id);
+        return false;
+    }
+    if (getSerialPortClaim(port_id)) return false;
+    if (!initSerialPort(port_id, baudrate)) return false;
+
+    // Not a transport: the router only routes to active ports
+    active_ports_mask &= ~(1 << (port_id - 1));
+    port_claims[port_id - 1] = owner;
+    msg.debug.info(TAG_SERIAL, "Serial%d claimed by %s", port_id, owner);
+    return true;
+}
+
+const char* getSerialPortClaim(uint8_t port_id) {
+    if (port_id < 1 || port_id > 8) return nullptr;
+    return port_claims[port_id - 1];
+}
+
 bool enableSerialPort(uint8_t port_id, uint8_t baud_index) {
     if (port_id < 1 || port_id > NUM_SERIAL_PORTS) return false;
+    if (getSerialPortClaim(port_id)) return false;
     if (baud_index >= NUM_BAUD_RATES) baud_index = BAUD_115200;
+    if (baud_index > getMaxBaudIndex()) return false;
 
     // Update config
     setSerialPortEnabled(&systemConfig.serial, port_id, true);
@@ -202,6 +316,7 @@ bool enableSerialPort(uint8_t port_id, uint8_t baud_index) {
 
 bool disableSerialPort(uint8_t port_id) {
     if (port_id < 1 || port_id > NUM_SERIAL_PORTS) return false;
+    if (getSerialPortClaim(port_id)) return false;
 
     // Update config
     setSerialPortEnabled(&systemConfig.serial, port_id, false);
@@ -214,6 +329,10 @@ bool disableSerialPort(uint8_t port_id) {
     uint8_t tx = getDefaultSerialTX(port_id);
     unregisterPin(rx);
     unregisterPin(tx);
+    if (hasFlowControl(port_id)) {
+        unregisterPin(systemConfig.serial.rts_pin);
+        unregisterPin(systemConfig.serial.cts_pin);
+    }
 
     // Note: We don't call Serial.end() as it might be in use by transport layer
 
@@ -222,6 +341,40 @@ bool disableSerialPort(uint8_t port_id) {
     return true;
 }
 
+bool setSerialFlowControl(uint8_t port_id, uint8_t rts, uint8_t cts) {
+#if SERIAL_FLOW_CONTROL
+    if (port_id > NUM_SERIAL_PORTS) return false;
+    SerialPortConfig* config = &systemConfig.serial;
+    uint8_t old = config->flow_port;
+    bool oldActive = old != 0 && isSerialPortActive(old);
+
+    if (port_id != 0) {
+        if (rts == cts || rts == getDefaultSerialRX(port_id) || rts == getDefaultSerialTX(port_id) ||
+            cts == getDefaultSerialRX(port_id) || cts == getDefaultSerialTX(port_id)) {
+            return false;
+        }
+        // Pins the running flow-controlled port holds are its own to hand over
+        bool rtsHeld = oldActive && (rts == config->rts_pin || rts == config->cts_pin);
+        bool ctsHeld = oldActive && (cts == config->rts_pin || cts == config->cts_pin);
+        if ((!rtsHeld && !validateNoPinConflict(rts, PIN_RESERVED, getSerialPortName(port_id))) ||
+            (!ctsHeld && !validateNoPinConflict(cts, PIN_RESERVED, getSerialPortName(port_id)))) {
+            return false;
+        }
+    }
+
+    // Takes effect when the port next starts; the running one keeps its pins until then
+    config->flow_port = port_id;
+    config->rts_pin = port_id ? rts : 0xFF;
+    config->cts_pin = port_id ? cts : 0xFF;
+    return true;
+#else
+    (void)port_id;
+    (void)rts;
+    (void)cts;
+    return false;
+#endif
+}
+
 // ============================================================================
 // SERIAL PORT ACCESS
 // ============================================================================
@@ -301,13 +454,19 @@ void displaySerialStatus() {
         msg.control.print(port_id);
         msg.control.print(F(": "));
 
-        if (enabled) {
+        if (getSerialPortClaim(port_id)) {
+            msg.control.print(getSerialPortClaim(port_id));
+            msg.control.print(F(" (not a transport)"));
+        } else if (enabled) {
             msg.control.print(F("ENABLED @ "));
             msg.control.print(getBaudRateString(baud_idx));
             msg.control.print(F(" baud"));
         } else {
             msg.control.print(F("disabled"));
         }
+        if (hasFlowControl(port_id)) {
+            msg.control.print(F(" RTS/CTS"));
+        }
 
         msg.control.print(F(" (RX="));
         msg.control.print(getDefaultSerialRX(port_id));
@@ -334,7 +493,12 @@ void displaySerialPortStatus(uint8_t port_id) {
     msg.control.print(port_id);
     msg.control.println(F(":"));
     msg.control.print(F("  Status: "));
-    msg.control.println(enabled ? F("ENABLED") : F("disabled"));
+    if (getSerialPortClaim(port_id)) {
+        msg.control.print(F("claimed by "));
+        msg.control.println(getSerialPortClaim(port_id));
+    } else {
+        msg.control.println(enabled ? F("ENABLED") : F("disabled"));
+    }
     msg.control.print(F("  Baud:   "));
     msg.control.print(getBaudRateString(baud_idx));
     msg.control.println(F(" bps"));
@@ -342,4 +506,24 @@ void displaySerialPortStatus(uint8_t port_id) {
     msg.control.println(getDefaultSerialRX(port_id));
     msg.control.print(F("  TX pin: "));
     msg.control.println(getDefaultSerialTX(port_id));
+#if SERIAL_FLOW_CONTROL
+    msg.control.print(F("  Flow:   "));
+    if (hasFlowControl(port_id)) {
+        msg.control.print(F("RTS="));
+        msg.control.print(systemConfig.serial.rts_pin);
+        msg.control.print(F(", CTS="));
+        msg.control.println(systemConfig.serial.cts_pin);
+    } else {
+        msg.control.println(F("none"));
+    }
+    msg.control.print(F("  Buffer: "));
+    if (hasFastBuffer(port_id)) {
+        msg.control.print(SERIAL_FAST_RX_BYTES);
+        msg.control.print(F(" RX / "));
+        msg.control.print(SERIAL_FAST_TX_BYTES);
+        msg.control.println(F(" TX bytes added"));
+    } else {
+        msg.control.println(F("core default"));
+    }
+#endif
 }
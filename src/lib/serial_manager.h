@@ -10,10 +10,31 @@
  * - Pin conflict validation before port initialization
  * - Integration with TransportInterface for message routing
  *
+ * High-rate links (wired telemetry to a logger): up to SERIAL_MAX_BAUD, 4
+ * Mbaud on Teensy 4.x and ESP32. At 100 Hz x 64 channels the binary data
+ * plane alone needs more than 115200 carries. On Teensy 4.x a port at
+ * SERIAL_FAST_BAUD or above, or with flow control, also gets
+ * SERIAL_FAST_RX_BYTES / SERIAL_FAST_TX_BYTES of buffer (addMemoryForRead /
+ * addMemoryForWrite, in DMAMEM), so a loop pass of incoming bytes fits
+ * instead of the core's 64. Buffers for SERIAL_FAST_PORTS ports; a port
+ * keeps its buffer once given.
+ *
+ * RTS/CTS: one port at a time, on the pins BUS SERIAL <n> FLOW names
+ * (Teensy 4.x: RTS any digital pin, CTS only the pins the core's
+ * attachCts() takes). Stored in SerialPortConfig.flow_port.
+ *
  * Usage:
  *   1. Call initConfiguredSerialPorts() during setup()
  *   2. Use getSerialPort(port_id) to get the Stream* for a port
  *   3. TRANSPORT command assigns ports to message planes
+ *
+ * Build Flags:
+ *   -D SERIAL_MAX_BAUD=n        - Fastest rate BUS SERIAL takes (default 4000000 on Teensy 4.x
+ *                                 and ESP32, else 921600)
+ *   -D SERIAL_FAST_BAUD=n       - Rate from which a port gets the large buffers (default 1000000)
+ *   -D SERIAL_FAST_PORTS=n      - Ports that can have them (default 2; Teensy 4.x)
+ *   -D SERIAL_FAST_RX_BYTES=n   - Receive buffer added per port (default 4096)
+ *   -D SERIAL_FAST_TX_BYTES=n   - Transmit buffer added per port (default 4096)
  */
 
 #ifndef SERIAL_MANAGER_H
@@ -23,13 +44,43 @@
 #include "bus_config.h"
 #include "bus_defaults.h"
 
+#ifndef SERIAL_MAX_BAUD
+#if defined(__IMXRT1062__) || defined(ESP32)
+#define SERIAL_MAX_BAUD 4000000UL
+#else
+#define SERIAL_MAX_BAUD 921600UL
+#endif
+#endif
+
+#if defined(__IMXRT1062__)
+#define SERIAL_FLOW_CONTROL 1       // attachRts() / attachCts() / addMemoryFor*()
+#else
+#define SERIAL_FLOW_CONTROL 0
+#endif
+
+#ifndef SERIAL_FAST_BAUD
+#define SERIAL_FAST_BAUD 1000000UL
+#endif
+
+#ifndef SERIAL_FAST_PORTS
+#define SERIAL_FAST_PORTS 2
+#endif
+
+#ifndef SERIAL_FAST_RX_BYTES
+#define SERIAL_FAST_RX_BYTES 4096
+#endif
+
+#ifndef SERIAL_FAST_TX_BYTES
+#define SERIAL_FAST_TX_BYTES 4096
+#endif
+
 // ============================================================================
 // BAUD RATE LOOKUP
 // ============================================================================
 
 /**
  * Convert baud rate index to actual baud rate
- * @param index SerialBaudIndex value (0-7)
+ * @param index SerialBaudIndex value (0-11)
  * @return Actual baud rate in bps
  */
 uint32_t getBaudRateFromIndex(uint8_t index);
@@ -43,11 +94,16 @@ uint8_t getBaudRateIndex(uint32_t baudrate);
 
 /**
  * Get human-readable baud rate string
- * @param index SerialBaudIndex value (0-7)
+ * @param index SerialBaudIndex value (0-11)
  * @return String like "115200"
  */
 const char* getBaudRateString(uint8_t index);
 
+/**
+ * Highest SerialBaudIndex this platform runs (SERIAL_MAX_BAUD)
+ */
+uint8_t getMaxBaudIndex();
+
 // ============================================================================
 // SERIAL PORT INITIALIZATION
 // ============================================================================
@@ -69,11 +125,33 @@ void initConfiguredSerialPorts();
  */
 bool initSerialPort(uint8_t port_id, uint32_t baudrate);
 
+/**
+ * Take a serial port for a driver (GPS) instead of a transport
+ *
+ * The port is started and its pins reserved, but it is never routed to and
+ * BUS SERIAL cannot enable or disable it. Call before
+ * initConfiguredSerialPorts().
+ *
+ * @param port_id Port number (1-8)
+ * @param baudrate Baud rate in bps
+ * @param owner Name shown by BUS SERIAL ("GPS")
+ * @return true if the port was started
+ */
+bool claimSerialPort(uint8_t port_id, uint32_t baudrate, const char* owner);
+
+/**
+ * Driver that claimed a serial port
+ *
+ * @param port_id Port number (1-8)
+ * @return Owner name, or nullptr if the port is not claimed
+ */
+const char* getSerialPortClaim(uint8_t port_id);
+
 /**
  * Enable a serial port in config and initialize it
  *
  * @param port_id Port number (1-8)
- * @param baud_index SerialBaudIndex value (0-7)
+ * @param baud_index SerialBaudIndex value (0-11; above getMaxBaudIndex() is refused)
  * @return true if successfully enabled
  */
 bool enableSerialPort(uint8_t port_id, uint8_t baud_index);
@@ -86,6 +164,18 @@ bool enableSerialPort(uint8_t port_id, uint8_t baud_index);
  */
 bool disableSerialPort(uint8_t port_id);
 
+/**
+ * Put RTS/CTS flow control on a port (in config; applied when the port starts)
+ *
+ * Only one port has flow control: naming another moves it there.
+ *
+ * @param port_id Port number (1-8), or 0 to turn flow control off
+ * @param rts Pin driven as our RTS
+ * @param cts Pin read as our CTS
+ * @return false if the platform has none or a pin is taken
+ */
+bool setSerialFlowControl(uint8_t port_id, uint8_t rts, uint8_t cts);
+
 // ============================================================================
 // SERIAL PORT ACCESS
 // ============================================================================
@@ -0,0 +1,250 @@
+/*
+ * state_capture.cpp - Edge-timestamped on/off inputs implementation
+ */
+
+#include "state_capture.h"
+#include "../hal/hal_placement.h"
+#include "isr_profile.h"
+#include "message_api.h"
+#include "log_tags.h"
+
+#if STATE_CAPTURE_CHANNELS > 8
+#error "STATE_CAPTURE_CHANNELS supports at most 8 channels"
+#endif
+
+#define STATE_CAPTURE_FREE 0xFF
+
+// Reader retries before it gives up on the seqlock and masks interrupts
+#define STATE_CAPTURE_READ_RETRIES 4
+
+// Orders the seqlock counter against the record (also across ESP32 cores)
+#define STATE_CAPTURE_BARRIER() __sync_synchronize()
+
+// Snapshots kept - one more than the steps, so the oldest is a full window back
+#define STATE_CAPTURE_RING (STATE_CAPTURE_SLOTS + 1)
+
+#define STATE_CAPTURE_STEP_US (STATE_CAPTURE_WINDOW_MS * 1000UL / STATE_CAPTURE_SLOTS)
+
+struct StateSnapshot {
+    uint32_t atUs;
+    uint32_t highUs;                            // HIGH counter at atUs
+};
+
+struct StateCaptureChannel {
+    uint8_t pin;                                // STATE_CAPTURE_FREE = unclaimed
+    uint32_t debounceUs;
+
+    // Written by the edge ISR - readers copy them under the seq counter
+    // (odd while the ISR is mid-update)
+    volatile uint8_t seq;
+    volatile bool level;                        // Raw level after the latest edge
+    volatile uint32_t lastEdgeUs;
+    volatile uint32_t highUs;                   // Time HIGH up to lastEdgeUs (wraps)
+    volatile uint32_t edges;
+
+    // Reader state
+    bool filtered;                              // Debounced level
+    uint32_t stateSinceMs;                      // millis() the debounced level settled
+    StateSnapshot ring[STATE_CAPTURE_RING];
+    uint8_t oldest;                             // Ring index of the window start
+    uint8_t count;                              // Snapshots in the ring
+};
+
+static StateCaptureChannel channels[STATE_CAPTURE_CHANNELS];
+static bool channelsInitialized = false;
+
+// ===== INTERRUPT SERVICE ROUTINES =====
+// HAL_ISR: IRAM on ESP32, so an edge during a flash write can't crash it
+
+HAL_ISR static void onStateEdge(uint8_t n) {
+    StateCaptureChannel* ch = &channels[n];
+    uint32_t now = micros();
+    bool level = digitalRead(ch->pin) == HIGH;
+
+    if (level == ch->level) return;  // Bounced back before we got here
+
+    ch->seq++;
+    STATE_CAPTURE_BARRIER();
+
+    if (ch->level) ch->highUs += now - ch->lastEdgeUs;
+    ch->level = level;
+    ch->lastEdgeUs = now;
+    ch->edges++;
+
+    STATE_CAPTURE_BARRIER();
+    ch->seq++;
+}
+
+// One trampoline per channel - attachInterrupt() takes no argument
+// (not a template: GCC drops the section of a template instance)
+#define STATE_ISR(N) \
+    HAL_ISR static void stateISR##N() { \
+        ISR_PROFILE_BEGIN(); \
+        onStateEdge(N); \
+        ISR_PROFILE_END(ISR_PROF_STATE_CAPTURE); \
+    }
+
+STATE_ISR(0) STATE_ISR(1) STATE_ISR(2) STATE_ISR(3)
+STATE_ISR(4) STATE_ISR(5) STATE_ISR(6) STATE_ISR(7)
+
+typedef void (*StateISR)();
+
+static const StateISR stateISRs[8] = {
+    stateISR0, stateISR1, stateISR2, stateISR3,
+    stateISR4, stateISR5, stateISR6, stateISR7
+};
+
+// ===== CHANNEL MANAGEMENT =====
+
+static void initChannels() {
+    for (uint8_t i = 0; i < STATE_CAPTURE_CHANNELS; i++) {
+        channels[i].pin = STATE_CAPTURE_FREE;
+    }
+    channelsInitialized = true;
+}
+
+static StateCaptureChannel* findChannel(uint8_t pin) {
+    if (!channelsInitialized) return nullptr;
+    for (uint8_t i = 0; i < STATE_CAPTURE_CHANNELS; i++) {
+        if (channels[i].pin == pin) return &channels[i];
+    }
+    return nullptr;
+}
+
+bool attachStateCapture(uint8_t pin, uint16_t debounce_ms) {
+    if (!channelsInitialized) initChannels();
+
+    int irq = digitalPinToInterrupt(pin);
+    if (irq == NOT_AN_INTERRUPT) {
+        msg.debug.warn(TAG_SENSOR, "Pin %d has no interrupt - sampled at the read rate", pin);
+        releaseStateCapture(pin);
+        return false;
+    }
+
+    // Re-init of the same pin reuses its channel
+    StateCaptureChannel* ch = findChannel(pin);
+    if (ch) {
+        detachInterrupt(irq);
+    } else {
+        ch = findChannel(STATE_CAPTURE_FREE);
+    }
+    if (ch == nullptr) {
+        msg.debug.warn(TAG_SENSOR, "No free state capture channel for pin %d (max %d)",
+                       pin, STATE_CAPTURE_CHANNELS);
+        return false;
+    }
+
+    ch->pin = pin;
+    ch->debounceUs = debounce_ms * 1000UL;
+    ch->seq = 0;
+    ch->level = digitalRead(pin) == HIGH;
+    ch->lastEdgeUs = micros();
+    ch->highUs = 0;
+    ch->edges = 0;
+    ch->filtered = ch->level;
+    ch->stateSinceMs = millis();
+    ch->ring[0].atUs = ch->lastEdgeUs;   // Window opens at the claim
+    ch->ring[0].highUs = 0;
+    ch->oldest = 0;
+    ch->count = 1;
+
+    attachInterrupt(irq, stateISRs[ch - channels], CHANGE);
+    return true;
+}
+
+void releaseStateCapture(uint8_t pin) {
+    StateCaptureChannel* ch = findChannel(pin);
+    if (ch == nullptr) return;
+
+    detachInterrupt(digitalPinToInterrupt(pin));
+    ch->pin = STATE_CAPTURE_FREE;
+}
+
+// ===== MEASUREMENT =====
+
+// Consistent copy of the ISR record (multi-byte fields tear on 8-bit AVR)
+struct StateRecord {
+    bool level;
+    uint32_t lastEdgeUs;
+    uint32_t highUs;
+    uint32_t edges;
+};
+
+static void copyStateRecord(const StateCaptureChannel* ch, StateRecord* rec) {
+    // Seqlock: retry if an edge landed mid-copy, interrupts stay enabled
+    for (uint8_t attempt = 0; attempt < STATE_CAPTURE_READ_RETRIES; attempt++) {
+        uint8_t seq = ch->seq;
+        STATE_CAPTURE_BARRIER();
+        rec->level = ch->level;
+        rec->lastEdgeUs = ch->lastEdgeUs;
+        rec->highUs = ch->highUs;
+        rec->edges = ch->edges;
+        STATE_CAPTURE_BARRIER();
+        if (!(seq & 1) && seq == ch->seq) return;
+    }
+
+    // Edges faster than the copy - take it with interrupts masked
+    noInterrupts();
+    rec->level = ch->level;
+    rec->lastEdgeUs = ch->lastEdgeUs;
+    rec->highUs = ch->highUs;
+    rec->edges = ch->edges;
+    interrupts();
+}
+
+// Add a snapshot every STATE_CAPTURE_STEP_US; the window is oldest..now
+static const StateSnapshot* windowStart(StateCaptureChannel* ch, uint32_t nowUs, uint32_t highNow) {
+    uint8_t newest = (ch->oldest + ch->count - 1) % STATE_CAPTURE_RING;
+
+    if (nowUs - ch->ring[newest].atUs >= STATE_CAPTURE_WINDOW_MS * 1000UL) {
+        // No read for a whole window - start over from here
+        ch->oldest = 0;
+        ch->count = 1;
+        ch->ring[0].atUs = nowUs;
+        ch->ring[0].highUs = highNow;
+    } else if (nowUs - ch->ring[newest].atUs >= STATE_CAPTURE_STEP_US) {
+        uint8_t slot = (newest + 1) % STATE_CAPTURE_RING;
+        if (ch->count < STATE_CAPTURE_RING) {
+            ch->count++;
+        } else {
+            ch->oldest = (ch->oldest + 1) % STATE_CAPTURE_RING;
+        }
+        ch->ring[slot].atUs = nowUs;
+        ch->ring[slot].highUs = highNow;
+    }
+    return &ch->ring[ch->oldest];
+}
+
+bool getStateCapture(uint8_t pin, StateCaptureSample* sample) {
+    StateCaptureChannel* ch = findChannel(pin);
+    if (ch == nullptr) return false;
+
+    StateRecord rec;
+    copyStateRecord(ch, &rec);
+    uint32_t nowUs = micros();
+    uint32_t nowMs = millis();
+    uint32_t sinceEdgeUs = nowUs - rec.lastEdgeUs;
+
+    // Settled - the new state started at the edge it settled on
+    if (rec.level != ch->filtered && sinceEdgeUs >= ch->debounceUs) {
+        ch->filtered = rec.level;
+        ch->stateSinceMs = nowMs - sinceEdgeUs / 1000;
+    }
+
+    // HIGH time up to now, including a HIGH stretch still running
+    uint32_t highNow = rec.highUs + (rec.level ? sinceEdgeUs : 0);
+    const StateSnapshot* start = windowStart(ch, nowUs, highNow);
+    uint32_t windowUs = nowUs - start->atUs;
+
+    if (windowUs > 0) {
+        float duty = (float)(highNow - start->highUs) / windowUs;
+        sample->dutyHigh = duty > 1.0f ? 1.0f : duty;
+    } else {
+        sample->dutyHigh = rec.level ? 1.0f : 0.0f;
+    }
+    sample->windowMs = windowUs / 1000;
+    sample->level = ch->filtered;
+    sample->inStateMs = nowMs - ch->stateSinceMs;
+    sample->edges = rec.edges;
+    return true;
+}
@@ -0,0 +1,85 @@
+/*
+ * state_capture.h - Edge-timestamped on/off inputs
+ *
+ * A digital input sampled with digitalRead() at its read interval only sees
+ * the level at that instant - a float switch sloshing in the tank reads
+ * whatever it happened to be bouncing on, and an event shorter than the
+ * interval is missed. A state capture channel instead takes a pin-change
+ * interrupt (CHANGE) on every edge and keeps:
+ *
+ *   - The raw level and the micros() timestamp of the latest edge
+ *   - The time spent HIGH so far (a wrapping microsecond counter)
+ *   - The number of edges, bounces included
+ *
+ * under a seqlock, like freq_capture.h. Readers get:
+ *
+ *   level      Debounced state - the raw level once it has held debounce_ms
+ *              since its last edge; until then the previous state stands
+ *   inStateMs  How long the debounced state has held, timed from the edge
+ *              it settled on rather than from the read that noticed it
+ *   dutyHigh   Fraction of time HIGH over the last STATE_CAPTURE_WINDOW_MS
+ *
+ * All three come from the edge record, so they are as good at a one-second
+ * read interval as at a fast one. The window is kept as
+ * STATE_CAPTURE_SLOTS snapshots of the HIGH counter, so it slides in steps
+ * of WINDOW / SLOTS; reads further apart than the window restart it.
+ *
+ * Channels are claimed by the sensor init function and released when the
+ * input on that pin is cleared or changes sensor. A pin without an
+ * interrupt isn't claimed - the sensor falls back to digitalRead().
+ *
+ * Usage:
+ *   // init
+ *   attachStateCapture(ptr->pin, 250);
+ *
+ *   // read
+ *   StateCaptureSample s;
+ *   if (getStateCapture(ptr->pin, &s)) ptr->value = s.level;
+ *
+ * Build Flags:
+ *   -D STATE_CAPTURE_CHANNELS=n    - Capture channels (default 2 on Uno, 4 elsewhere, max 8)
+ *   -D STATE_CAPTURE_WINDOW_MS=n   - Duty window (default 10000)
+ *   -D STATE_CAPTURE_SLOTS=n       - Snapshots the window slides by (default 4)
+ */
+
+#ifndef STATE_CAPTURE_H
+#define STATE_CAPTURE_H
+
+#include <Arduino.h>
+
+#ifndef STATE_CAPTURE_CHANNELS
+  #if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
+    #define STATE_CAPTURE_CHANNELS 2       // INT0/INT1 only
+  #else
+    #define STATE_CAPTURE_CHANNELS 4
+  #endif
+#endif
+
+#ifndef STATE_CAPTURE_WINDOW_MS
+#define STATE_CAPTURE_WINDOW_MS 10000
+#endif
+
+#ifndef STATE_CAPTURE_SLOTS
+#define STATE_CAPTURE_SLOTS 4
+#endif
+
+// Measurement of one channel
+struct StateCaptureSample {
+    bool level;            // Debounced level (true = HIGH)
+    uint32_t inStateMs;    // Time the debounced level has held
+    float dutyHigh;        // Fraction of the window spent HIGH (0..1)
+    uint32_t windowMs;     // Time the duty covers (shorter until the window fills)
+    uint32_t edges;        // Raw edges since the channel was claimed
+};
+
+// Claim a channel for pin and attach its ISR on both edges
+// Returns false if the pin has no interrupt or all channels are taken
+bool attachStateCapture(uint8_t pin, uint16_t debounce_ms);
+
+// Detach and free the channel on pin (no-op if pin has none)
+void releaseStateCapture(uint8_t pin);
+
+// Latest measurement for pin; false if pin has no channel
+bool getStateCapture(uint8_t pin, StateCaptureSample* sample);
+
+#endif // STATE_CAPTURE_H
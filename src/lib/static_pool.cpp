@@ -0,0 +1,175 @@
+/*
+ * static_pool.cpp - Fixed RAM for objects created at runtime
+ */
+
+#include "static_pool.h"
+#include "message_api.h"
+#include "log_tags.h"
+
+#if defined(__AVR__)
+typedef uint16_t pool_size_t;
+#define POOL_ALIGN 1
+#else
+typedef uint32_t pool_size_t;
+#define POOL_ALIGN 8                // Doubles and 64-bit members
+#endif
+
+static inline size_t alignUp(size_t bytes) {
+    return (bytes + (POOL_ALIGN - 1)) & ~(size_t)(POOL_ALIGN - 1);
+}
+
+// ===== OBJECT POOL =====
+
+alignas(POOL_ALIGN) static uint8_t pool[STATIC_POOL_BYTES > 0 ? STATIC_POOL_BYTES : 1];
+static size_t poolUsed = 0;
+static uint8_t poolFailures = 0;
+
+void* poolAlloc(size_t bytes, const char* owner) {
+    size_t need = alignUp(bytes);
+    if (need > (size_t)STATIC_POOL_BYTES - poolUsed) {
+        if (poolFailures < 255) poolFailures++;
+        msg.debug.error(TAG_SYSTEM, "Static pool: %s needs %u bytes, %u free (raise STATIC_POOL_BYTES)",
+                        owner, (unsigned)bytes, (unsigned)((size_t)STATIC_POOL_BYTES - poolUsed));
+        return nullptr;
+    }
+    void* block = &pool[poolUsed];
+    poolUsed += need;
+    return block;
+}
+
+// ===== SCRATCH ARENA =====
+
+#if STATIC_SCRATCH_BYTES > 0
+
+#define NO_BLOCK ((pool_size_t)~0)
+
+struct BlockHeader {
+    pool_size_t size;   // Payload bytes (aligned)
+    pool_size_t prev;   // Offset of the block below, NO_BLOCK for the first
+    bool freed;         // Freed, but a newer block is still in use
+};
+
+#define HEADER_BYTES alignUp(sizeof(BlockHeader))
+
+alignas(POOL_ALIGN) static uint8_t scratch[STATIC_SCRATCH_BYTES];
+static size_t scratchUsed = 0;
+static pool_size_t scratchTop = NO_BLOCK;   // Newest block
+static size_t scratchPeak = 0;
+static uint8_t scratchFailures = 0;
+
+static inline BlockHeader* headerAt(pool_size_t offset) {
+    return (BlockHeader*)&scratch[offset];
+}
+
+static inline BlockHeader* headerOf(void* block) {
+    return (BlockHeader*)((uint8_t*)block - HEADER_BYTES);
+}
+
+static void scratchFull(size_t bytes) {
+    if (scratchFailures < 255) scratchFailures++;
+    msg.debug.warn(TAG_SYSTEM, "Scratch arena full: %u bytes wanted, %u free (raise STATIC_SCRATCH_BYTES)",
+                   (unsigned)bytes, (unsigned)(sizeof(scratch) - scratchUsed));
+}
+
+void* scratchAlloc(size_t bytes) {
+    size_t size = alignUp(bytes ? bytes : 1);
+    if (HEADER_BYTES + size > sizeof(scratch) - scratchUsed) {
+        scratchFull(bytes);
+        return nullptr;
+    }
+    BlockHeader* header = headerAt(scratchUsed);
+    header->size = size;
+    header->prev = scratchTop;
+    header->freed = false;
+    scratchTop = scratchUsed;
+    scratchUsed += HEADER_BYTES + size;
+    if (scratchUsed > scratchPeak) scratchPeak = scratchUsed;
+    return (uint8_t*)header + HEADER_BYTES;
+}
+
+void scratchFree(void* block) {
+    if (block == nullptr) return;
+    headerOf(block)->freed = true;
+
+    // Give back the freed blocks at the top
+    while (scratchTop != NO_BLOCK && headerAt(scratchTop)->freed) {
+        scratchUsed = scratchTop;
+        scratchTop = headerAt(scratchTop)->prev;
+    }
+}
+
+void* scratchRealloc(void* block, size_t bytes) {
+    if (block == nullptr) return scratchAlloc(bytes);
+
+    BlockHeader* header = headerOf(block);
+    size_t size = alignUp(bytes ? bytes : 1);
+    bool newest = (scratchTop != NO_BLOCK && header == headerAt(scratchTop));
+    if (!newest && size <= header->size) {
+        return block;                                   // Shrinking below the top: keep it
+    }
+    if (newest) {
+        if (scratchTop + HEADER_BYTES + size > sizeof(scratch)) {
+            scratchFull(bytes);
+            return nullptr;
+        }
+        header->size = size;                            // Newest block: resize in place
+        scratchUsed = scratchTop + HEADER_BYTES + size;
+        if (scratchUsed > scratchPeak) scratchPeak = scratchUsed;
+        return block;
+    }
+
+    void* moved = scratchAlloc(bytes);
+    if (moved == nullptr) return nullptr;
+    memcpy(moved, block, header->size);
+    scratchFree(block);
+    return moved;
+}
+
+void scratchReset() {
+    if (scratchUsed > 0) {
+        msg.debug.warn(TAG_SYSTEM, "Scratch arena: %u bytes not freed, reclaimed", (unsigned)scratchUsed);
+    }
+    scratchUsed = 0;
+    scratchTop = NO_BLOCK;
+}
+
+#else
+
+void* scratchAlloc(size_t bytes) { return malloc(bytes); }
+void* scratchRealloc(void* block, size_t bytes) { return realloc(block, bytes); }
+void scratchFree(void* block) { free(block); }
+void scratchReset() {}
+
+#endif
+
+// ===== STATUS =====
+
+void printStaticPoolStatus() {
+    msg.control.print(F("  Object pool: "));
+    msg.control.print((unsigned long)poolUsed);
+    msg.control.print(F(" / "));
+    msg.control.print((unsigned long)(size_t)STATIC_POOL_BYTES);
+    msg.control.print(F(" bytes"));
+    if (poolFailures > 0) {
+        msg.control.print(F(", "));
+        msg.control.print(poolFailures);
+        msg.control.print(F(" refused"));
+    }
+    msg.control.println();
+
+#if STATIC_SCRATCH_BYTES > 0
+    msg.control.print(F("  Scratch arena: peak "));
+    msg.control.print((unsigned long)scratchPeak);
+    msg.control.print(F(" / "));
+    msg.control.print((unsigned long)sizeof(scratch));
+    msg.control.print(F(" bytes"));
+    if (scratchFailures > 0) {
+        msg.control.print(F(", "));
+        msg.control.print(scratchFailures);
+        msg.control.print(F(" refused"));
+    }
+    msg.control.println();
+#else
+    msg.control.println(F("  Scratch arena: off (documents on the heap)"));
+#endif
+}
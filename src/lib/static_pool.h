@@ -0,0 +1,82 @@
+/*
+ * static_pool.h - Fixed RAM for objects created at runtime
+ *
+ * Objects that exist only when the config uses them (the BME280 driver, the
+ * BLE callbacks) and the JsonDocuments of config import/export come out of
+ * two fixed regions instead of the heap, so a long uptime cannot fragment
+ * it and an allocation takes the same time every time:
+ *
+ *   Object pool  - STATIC_POOL_BYTES; poolAlloc() hands out blocks that are
+ *                  never freed (one per driver, made once)
+ *   Scratch arena - STATIC_SCRATCH_BYTES; scratchAlloc()/scratchFree() for
+ *                  short-lived documents. Blocks stack: freeing the newest
+ *                  gives its bytes back at once, and the arena empties when
+ *                  the last block is freed. A realloc of the newest block
+ *                  grows it in place (ArduinoJson's string building does).
+ *                  No block outlives the command that made it: the command
+ *                  dispatcher calls scratchReset() after each one, which also
+ *                  takes back anything a failed realloc left behind.
+ *
+ * When a region is full the call returns nullptr and logs what asked for how
+ * much; the failures are counted in SYSTEM MEMORY. Callers treat nullptr as
+ * "driver not available" / ArduinoJson's NoMemory - nothing falls back to
+ * the heap. Nothing in the per-loop path allocates.
+ *
+ * JsonDocuments use the arena through lib/json_arena.h:
+ *   JsonDocument doc(jsonArena());
+ *
+ * Usage:
+ *   void* mem = poolAlloc(sizeof(Adafruit_BME280), "BME280");
+ *   if (mem) bme = new (mem) Adafruit_BME280();
+ *
+ * Build Flags:
+ *   -D STATIC_POOL_BYTES=n     - Object pool (default 512; on AVR 128 with ENABLE_BME280, else 0)
+ *   -D STATIC_SCRATCH_BYTES=n  - Document scratch arena (default 8192; 1024 on AVR, 0 in static
+ *                                AVR builds; 0 = documents on the heap)
+ */
+
+#ifndef STATIC_POOL_H
+#define STATIC_POOL_H
+
+#include <Arduino.h>
+
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__) || \
+    defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+    #ifndef STATIC_POOL_BYTES
+    #ifdef ENABLE_BME280
+    #define STATIC_POOL_BYTES 128          // The BME280 driver
+    #else
+    #define STATIC_POOL_BYTES 0
+    #endif
+    #endif
+    #ifndef STATIC_SCRATCH_BYTES
+    #ifdef USE_STATIC_CONFIG
+    #define STATIC_SCRATCH_BYTES 0         // No JSON in static builds
+    #else
+    #define STATIC_SCRATCH_BYTES 1024
+    #endif
+    #endif
+#else
+    #ifndef STATIC_POOL_BYTES
+    #define STATIC_POOL_BYTES 512
+    #endif
+    #ifndef STATIC_SCRATCH_BYTES
+    #define STATIC_SCRATCH_BYTES 8192      // One config section or input document at a time
+    #endif
+#endif
+
+// Object pool: never freed; nullptr (and a logged error) when full
+void* poolAlloc(size_t bytes, const char* owner);
+
+// Scratch arena: nullptr when full; free/realloc accept nullptr
+void* scratchAlloc(size_t bytes);
+void* scratchRealloc(void* block, size_t bytes);
+void scratchFree(void* block);
+
+// Empty the arena (between commands - no document is alive there)
+void scratchReset();
+
+// SYSTEM MEMORY lines for both regions
+void printStaticPoolStatus();
+
+#endif // STATIC_POOL_H
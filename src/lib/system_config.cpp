@@ -10,7 +10,10 @@
 #include "message_api.h"
 #include "log_tags.h"
 #include "pin_registry.h"
-#include <EEPROM.h>
+#include "../displays/lcd_layout.h"  // LCD_PAGE_SECONDS, LCD_PIN_ALARMS
+#include "eeprom_store.h"
+#include "crc32.h"
+#include "config_migrate.h"
 
 // Global system config instance
 SystemConfig systemConfig;
@@ -39,20 +42,289 @@ void printSystemStatus() {
 }
 
 /**
- * Calculate XOR checksum for SystemConfig structure
+ * Calculate CRC-32 of the SystemConfig structure (all bytes but the crc field)
  */
-uint8_t calculateChecksum(SystemConfig* cfg) {
-    uint8_t checksum = 0;
-    uint8_t* bytes = (uint8_t*)cfg;
-
-    // XOR all bytes except the checksum field itself
-    for (size_t i = 0; i < sizeof(SystemConfig); i++) {
-        if (i != offsetof(SystemConfig, checksum)) {
-            checksum ^= bytes[i];
+uint32_t calculateSystemConfigCrc(const SystemConfig* cfg) {
+    const uint8_t* bytes = (const uint8_t*)cfg;
+    const size_t after = offsetof(SystemConfig, crc) + sizeof(cfg->crc);
+
+    uint32_t crc = crc32Update(0, bytes, offsetof(SystemConfig, crc));
+    return crc32Update(crc, bytes + after, sizeof(SystemConfig) - after);
+}
+
+// ===== MIGRATION (config_migrate.h) =====
+// v20 layout: four data outputs (no MQTT) and no MQTT settings. Every field
+// from outputInterval on moved, padding included, so the older maps below
+// target this layout and v20's own map finishes their upgrade.
+#define V20_OUTPUTS (NUM_OUTPUTS - 1)
+#define V20_DATA_OUTPUTS 4
+
+struct SystemConfigV20 {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t reserved1;
+    uint32_t crc;
+    uint8_t outputEnabled[V20_OUTPUTS];
+    uint16_t outputInterval[V20_OUTPUTS];
+    uint8_t outputMode[V20_DATA_OUTPUTS];
+    uint16_t outputDeadband[V20_DATA_OUTPUTS];
+    uint8_t serialFormat;
+    uint8_t outputAggregate[V20_DATA_OUTPUTS];
+    uint8_t displayEnabled;
+    uint8_t displayType;
+    uint8_t lcdI2CAddress;
+    uint8_t defaultTempUnits;
+    uint8_t defaultPressUnits;
+    uint8_t defaultElevUnits;
+    uint8_t defaultSpeedUnits;
+    uint16_t sensorReadInterval;
+    uint16_t alarmCheckInterval;
+    uint16_t lcdUpdateInterval;
+    uint8_t lcdPageSeconds;
+    uint8_t lcdPinAlarms;
+    uint8_t modeButtonPin;
+    uint8_t buzzerPin;
+    uint8_t canCSPin;
+    uint8_t canIntPin;
+    uint8_t sdCSPin;
+    uint8_t testModePin;
+    uint16_t reserved2;
+    float seaLevelPressure;
+    decltype(SystemConfig::router) router;
+    decltype(SystemConfig::dataProfile) dataProfile;
+#ifdef ENABLE_RELAY_OUTPUT
+    RelayConfig relays[MAX_RELAYS];
+#endif
+    BusConfig buses;
+    SerialPortConfig serial;
+    decltype(SystemConfig::logFilter) logFilter;
+};
+
+// Fields first..last, in the same order in both layouts
+#define V20_SPAN(first, last) {offsetof(SystemConfigV20, first), offsetof(SystemConfig, first), \
+    offsetof(SystemConfigV20, last) + sizeof(SystemConfigV20::last) - offsetof(SystemConfigV20, first)}
+
+// The data outputs keep their indices; Alarm and Relay move up past MQTT
+static const ConfigFieldMap SYSTEM_V20_FIELDS[] PROGMEM = {
+    {offsetof(SystemConfigV20, outputEnabled), offsetof(SystemConfig, outputEnabled), V20_DATA_OUTPUTS},
+    {offsetof(SystemConfigV20, outputEnabled) + V20_DATA_OUTPUTS, offsetof(SystemConfig, outputEnabled) + OUTPUT_ALARM,
+     V20_OUTPUTS - V20_DATA_OUTPUTS},
+    {offsetof(SystemConfigV20, outputInterval), offsetof(SystemConfig, outputInterval), 2 * V20_DATA_OUTPUTS},
+    {offsetof(SystemConfigV20, outputInterval) + 2 * V20_DATA_OUTPUTS, offsetof(SystemConfig, outputInterval) + 2 * OUTPUT_ALARM,
+     2 * (V20_OUTPUTS - V20_DATA_OUTPUTS)},
+    V20_SPAN(outputMode, outputMode),
+    V20_SPAN(outputDeadband, outputDeadband),
+    V20_SPAN(serialFormat, serialFormat),
+    V20_SPAN(outputAggregate, outputAggregate),
+    V20_SPAN(displayEnabled, defaultSpeedUnits),
+    V20_SPAN(sensorReadInterval, lcdPinAlarms),
+    V20_SPAN(modeButtonPin, reserved2),
+    V20_SPAN(seaLevelPressure, seaLevelPressure),
+    V20_SPAN(router, dataProfile),
+#ifdef ENABLE_RELAY_OUTPUT
+    V20_SPAN(relays, relays),
+#endif
+    V20_SPAN(buses, logFilter),
+};
+
+// v17 and v18 had a 4-byte header with an XOR checksum at offset 3: every
+// field sits 4 bytes lower than in v20. v17 had reserved1 where the LCD page
+// settings are - they keep their defaults.
+#define LEGACY_OFFSET(field) (offsetof(SystemConfigV20, field) - 4)
+#define LEGACY_SIZE (sizeof(SystemConfigV20) - 4)
+
+// v19 had the v20 header but no CAN node fields at the end of BusConfig:
+// everything after the buses sits 4 bytes lower.
+#define BUS_NODE_OFFSET (offsetof(SystemConfigV20, buses) + offsetof(BusConfig, can_node_id))
+
+static const ConfigFieldMap SYSTEM_V19_FIELDS[] PROGMEM = {
+    {offsetof(SystemConfigV20, outputEnabled), offsetof(SystemConfigV20, outputEnabled), BUS_NODE_OFFSET - offsetof(SystemConfigV20, outputEnabled)},
+    {LEGACY_OFFSET(serial), offsetof(SystemConfigV20, serial), sizeof(SystemConfigV20) - offsetof(SystemConfigV20, serial)},
+};
+
+static const ConfigFieldMap SYSTEM_V18_FIELDS[] PROGMEM = {
+    {LEGACY_OFFSET(outputEnabled), offsetof(SystemConfigV20, outputEnabled), sizeof(SystemConfigV20) - offsetof(SystemConfigV20, outputEnabled)},
+};
+
+static const ConfigFieldMap SYSTEM_V17_FIELDS[] PROGMEM = {
+    {LEGACY_OFFSET(outputEnabled), offsetof(SystemConfigV20, outputEnabled), offsetof(SystemConfigV20, lcdPageSeconds) - offsetof(SystemConfigV20, outputEnabled)},
+    {LEGACY_OFFSET(modeButtonPin), offsetof(SystemConfigV20, modeButtonPin), sizeof(SystemConfigV20) - offsetof(SystemConfigV20, modeButtonPin)},
+};
+
+// v8 (the baseline release): XOR header, no send modes, formats or
+// aggregation, a secondary transport per plane where the subscribers are
+// now, 16-byte relays (always two) and the bus block up to the CAN flags.
+#define V8_RELAYS 2
+
+struct SystemConfigV8 {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t checksum;
+    uint8_t outputEnabled[V20_OUTPUTS];
+    uint16_t outputInterval[V20_OUTPUTS];
+    uint8_t displayEnabled;
+    uint8_t displayType;
+    uint8_t lcdI2CAddress;
+    uint8_t defaultTempUnits;
+    uint8_t defaultPressUnits;
+    uint8_t defaultElevUnits;
+    uint8_t defaultSpeedUnits;
+    uint16_t sensorReadInterval;
+    uint16_t alarmCheckInterval;
+    uint16_t lcdUpdateInterval;
+    uint16_t reserved1;
+    uint8_t modeButtonPin;
+    uint8_t buzzerPin;
+    uint8_t canCSPin;
+    uint8_t canIntPin;
+    uint8_t sdCSPin;
+    uint8_t testModePin;
+    uint16_t reserved2;
+    float seaLevelPressure;
+    struct {
+        uint8_t control_primary;
+        uint8_t control_secondary;
+        uint8_t data_primary;
+        uint8_t data_secondary;
+        uint8_t debug_primary;
+        uint8_t debug_secondary;
+        uint8_t bt_type;
+        uint8_t bt_auth_required;
+        uint16_t bt_pin;
+        uint8_t reserved[6];
+    } router;
+#ifdef ENABLE_RELAY_OUTPUT
+    struct {
+        uint8_t outputPin;
+        uint8_t inputIndex;
+        uint8_t mode;
+        uint8_t reserved;
+        float thresholdOn;
+        float thresholdOff;
+        uint32_t reserved2;
+    } relays[V8_RELAYS];
+#endif
+    struct {
+        uint8_t active_i2c;
+        uint16_t i2c_clock;
+        uint8_t active_spi;
+        uint32_t spi_clock;
+        uint8_t input_can_bus;
+        uint8_t output_can_bus;
+        uint32_t can_input_baudrate;
+        uint32_t can_output_baudrate;
+        uint8_t can_input_mode;
+        uint8_t can_output_enabled;
+    } buses;
+    SerialPortConfig serial;
+    decltype(SystemConfig::logFilter) logFilter;
+};
+
+// Fields first..last of v8, to the same fields of v20
+#define V8_SPAN(first, last) {offsetof(SystemConfigV8, first), offsetof(SystemConfigV20, first), \
+    offsetof(SystemConfigV8, last) + sizeof(SystemConfigV8::last) - offsetof(SystemConfigV8, first)}
+#define V8_FIELD(field) {offsetof(SystemConfigV8, field), offsetof(SystemConfigV20, field), sizeof(SystemConfigV8::field)}
+#define V8_RELAY(n) V8_SPAN(relays[n].outputPin, relays[n].mode), V8_SPAN(relays[n].thresholdOn, relays[n].thresholdOff)
+
+static const ConfigFieldMap SYSTEM_V8_FIELDS[] PROGMEM = {
+    V8_SPAN(outputEnabled, outputInterval),
+    V8_SPAN(displayEnabled, defaultSpeedUnits),
+    V8_SPAN(sensorReadInterval, lcdUpdateInterval),
+    V8_SPAN(modeButtonPin, seaLevelPressure),
+    V8_FIELD(router.control_primary),
+    V8_FIELD(router.data_primary),
+    V8_FIELD(router.debug_primary),
+    V8_FIELD(router.bt_type),
+    V8_FIELD(router.bt_auth_required),
+    V8_FIELD(router.bt_pin),
+#ifdef ENABLE_RELAY_OUTPUT
+    V8_RELAY(0),
+#if MAX_RELAYS > 1
+    V8_RELAY(1),
+#endif
+#endif
+    V8_SPAN(buses, buses.can_output_enabled),
+    {offsetof(SystemConfigV8, serial), offsetof(SystemConfigV20, serial), offsetof(SerialPortConfig, flow_port)},
+    V8_FIELD(logFilter),
+};
+
+// v8's secondary transport per plane becomes that plane's one subscriber
+static void migrateV8Router(const uint8_t* image, SystemConfigV20* cfg) {
+    const uint8_t secondary[3] = {image[offsetof(SystemConfigV8, router.control_secondary)],
+                                  image[offsetof(SystemConfigV8, router.data_secondary)],
+                                  image[offsetof(SystemConfigV8, router.debug_secondary)]};
+    for (uint8_t i = 0; i < 3; i++) {
+        cfg->router.subscribers[i] = (secondary[i] != TRANSPORT_NONE && secondary[i] < 16) ? (uint16_t)(1 << secondary[i]) : 0;
+    }
+}
+
+// v21: today's layout without the device inventory at the end
+#define V21_SIZE offsetof(SystemConfig, inventory)
+
+static const ConfigFieldMap SYSTEM_V21_FIELDS[] PROGMEM = {
+    {offsetof(SystemConfig, outputEnabled), offsetof(SystemConfig, outputEnabled), V21_SIZE - offsetof(SystemConfig, outputEnabled)},
+};
+
+// Second entry (v20): the layout the older ones map onto
+static const ConfigMigration SYSTEM_MIGRATIONS[] = {
+    {21, V21_SIZE, SYSTEM_V21_FIELDS, sizeof(SYSTEM_V21_FIELDS) / sizeof(ConfigFieldMap)},
+    {20, sizeof(SystemConfigV20), SYSTEM_V20_FIELDS, sizeof(SYSTEM_V20_FIELDS) / sizeof(ConfigFieldMap)},
+    {19, LEGACY_SIZE, SYSTEM_V19_FIELDS, sizeof(SYSTEM_V19_FIELDS) / sizeof(ConfigFieldMap)},
+    {18, LEGACY_SIZE, SYSTEM_V18_FIELDS, sizeof(SYSTEM_V18_FIELDS) / sizeof(ConfigFieldMap)},
+    {17, LEGACY_SIZE, SYSTEM_V17_FIELDS, sizeof(SYSTEM_V17_FIELDS) / sizeof(ConfigFieldMap)},
+    {8, sizeof(SystemConfigV8), SYSTEM_V8_FIELDS, sizeof(SYSTEM_V8_FIELDS) / sizeof(ConfigFieldMap)},
+};
+
+/**
+ * Upgrade a SystemConfig saved by an older version in place
+ * @return true if the old image was valid and is now systemConfig
+ */
+static bool migrateSystemConfig(uint8_t version) {
+    const ConfigMigration* migration = findConfigMigration(SYSTEM_MIGRATIONS,
+        sizeof(SYSTEM_MIGRATIONS) / sizeof(ConfigMigration), version);
+    if (!migration) {
+        msg.debug.warn(TAG_SYSTEM, "System config version mismatch (expected %d, got %d) - ignoring", SYSTEM_CONFIG_VERSION, version);
+        return false;
+    }
+
+    static_assert(V21_SIZE >= sizeof(SystemConfigV20) && V21_SIZE >= sizeof(SystemConfigV8), "v21 is the largest older layout");
+    uint8_t image[V21_SIZE];
+    eepromStoreRead(SYSTEM_CONFIG_ADDRESS, image, migration->size);
+    bool valid;
+    if (version >= 19) {
+        // CRC-32 header: every byte but the crc field at offset 4
+        uint32_t stored;
+        memcpy(&stored, image + 4, sizeof(stored));
+        uint32_t crc = crc32Update(0, image, 4);
+        valid = crc32Update(crc, image + 8, migration->size - 8) == stored;
+    } else {
+        uint8_t checksum = 0;
+        for (uint16_t i = 0; i < migration->size; i++) {
+            if (i != 3) checksum ^= image[i];
         }
+        valid = checksum == image[3];
+    }
+    if (!valid) {
+        msg.debug.warn(TAG_SYSTEM, "System config v%d checksum failed - ignoring", version);
+        return false;
     }
 
-    return checksum;
+    resetSystemConfig();  // Fields the old version didn't have keep their defaults
+    if (version < 20) {
+        // Onto the v20 layout first, over the defaults in that layout
+        SystemConfigV20 v20;
+        revertConfigImage(&SYSTEM_MIGRATIONS[1], &v20, &systemConfig);
+        migrateConfigImage(migration, image, &v20);
+        if (version == 8) migrateV8Router(image, &v20);
+        memcpy(image, &v20, sizeof(v20));
+        migration = &SYSTEM_MIGRATIONS[1];
+    }
+    migrateConfigImage(migration, image, &systemConfig);
+    systemConfig.crc = calculateSystemConfigCrc(&systemConfig);
+    eepromPut(SYSTEM_CONFIG_ADDRESS, systemConfig);
+
+    msg.debug.info(TAG_SYSTEM, "System config migrated from v%d to v%d", version, SYSTEM_CONFIG_VERSION);
+    return true;
 }
 
 /**
@@ -77,6 +349,7 @@ void initSystemConfig() {
 void resetSystemConfig() {
     systemConfig.magic = SYSTEM_CONFIG_MAGIC;
     systemConfig.version = SYSTEM_CONFIG_VERSION;
+    systemConfig.reserved1 = 0;
 
     // Output defaults (check config.h for #define ENABLE_*)
     // Data outputs default OFF to keep USB clean - user must explicitly enable
@@ -114,6 +387,9 @@ void resetSystemConfig() {
     systemConfig.outputInterval[OUTPUT_SD] = 5000;
     #endif
 
+    systemConfig.outputEnabled[OUTPUT_MQTT] = 0;  // OFF - data plane output (NEW in v21)
+    systemConfig.outputInterval[OUTPUT_MQTT] = 1000;
+
     #ifdef ENABLE_ALARMS
     systemConfig.outputEnabled[OUTPUT_ALARM] = 1;  // ON - safety critical
     systemConfig.outputInterval[OUTPUT_ALARM] = 100;  // 10Hz check rate
@@ -127,6 +403,16 @@ void resetSystemConfig() {
     systemConfig.outputInterval[OUTPUT_RELAY] = 100;  // 10Hz check rate
     #endif
 
+    // Data outputs send every input every interval until configured otherwise
+    for (uint8_t i = 0; i < NUM_DATA_OUTPUTS; i++) {
+        systemConfig.outputMode[i] = OUTPUT_MODE_PERIODIC;
+        systemConfig.outputDeadband[i] = 0;
+        systemConfig.outputAggregate[i] = OUTPUT_AGG_LAST;  // NEW in v14
+    }
+    systemConfig.serialFormat = SERIAL_FORMAT_CSV;  // NEW in v13
+    systemConfig.mqttFormat = MQTT_FORMAT_JSON;     // NEW in v21
+    systemConfig.mqttQos = 0;
+
     // Display defaults (only one display type should be defined in platformio.ini)
     #if defined(ENABLE_LCD)
         systemConfig.displayEnabled = 1;
@@ -151,7 +437,8 @@ void resetSystemConfig() {
     systemConfig.sensorReadInterval = SENSOR_READ_INTERVAL_MS;
     systemConfig.alarmCheckInterval = ALARM_CHECK_INTERVAL_MS;
     systemConfig.lcdUpdateInterval = LCD_UPDATE_INTERVAL_MS;
-    systemConfig.reserved1 = 0;
+    systemConfig.lcdPageSeconds = LCD_PAGE_SECONDS;
+    systemConfig.lcdPinAlarms = LCD_PIN_ALARMS;
 
     // Hardware pins
     systemConfig.modeButtonPin = MODE_BUTTON;
@@ -181,21 +468,26 @@ void resetSystemConfig() {
     // Transport Router Configuration (NEW in v4)
     // Default: All planes → USB Serial
     systemConfig.router.control_primary = TRANSPORT_USB_SERIAL;
-    systemConfig.router.control_secondary = TRANSPORT_NONE;
     systemConfig.router.data_primary = TRANSPORT_USB_SERIAL;
-    systemConfig.router.data_secondary = TRANSPORT_NONE;
     systemConfig.router.debug_primary = TRANSPORT_USB_SERIAL;
-    systemConfig.router.debug_secondary = TRANSPORT_NONE;
 
     // Bluetooth defaults (disabled)
     systemConfig.router.bt_type = 0;  // BT_TYPE_NONE
     systemConfig.router.bt_auth_required = 0;  // Disabled by default
     systemConfig.router.bt_pin = 0;  // Not set
 
-    // Reserved router space
-    for (int i = 0; i < 6; i++) {
-        systemConfig.router.reserved_router[i] = 0;
+    // TX overflow policies (plane defaults), no extra subscribers
+    for (int i = 0; i < 3; i++) {
+        systemConfig.router.tx_policy[i] = TX_POLICY_DEFAULT;
+        systemConfig.router.subscribers[i] = 0;
+    }
+
+    // Data plane profiles: every stream, unshaped (NEW in v16)
+    for (int i = 0; i < 13; i++) {
+        systemConfig.dataProfile.rate[i] = 0;
+        systemConfig.dataProfile.streams[i] = DATA_STREAMS_ALL;
     }
+    systemConfig.dataProfile.reserved = 0;
 
 #ifdef ENABLE_RELAY_OUTPUT
     // Relay defaults (NEW in v5)
@@ -203,10 +495,13 @@ void resetSystemConfig() {
         systemConfig.relays[i].outputPin = 0xFF;       // Unconfigured
         systemConfig.relays[i].inputIndex = 0xFF;      // Unassigned
         systemConfig.relays[i].mode = RELAY_DISABLED;
-        systemConfig.relays[i].reserved = 0;
+        systemConfig.relays[i].curve = RELAY_CURVE_LINEAR;
         systemConfig.relays[i].thresholdOn = 0.0;
         systemConfig.relays[i].thresholdOff = 0.0;
-        systemConfig.relays[i].reserved2 = 0;
+        systemConfig.relays[i].minOnMs = 0;            // No minimum on/off time
+        systemConfig.relays[i].minOffMs = 0;
+        systemConfig.relays[i].pwmFrequency = 0;       // Platform default
+        systemConfig.relays[i].reserved = 0;
     }
 #endif
 
@@ -223,6 +518,18 @@ void resetSystemConfig() {
     systemConfig.buses.can_output_baudrate = DEFAULT_CAN_BAUDRATE;
     systemConfig.buses.can_input_mode = CAN_INPUT_OFF;  // Disabled by default
     systemConfig.buses.can_output_enabled = 1;  // Enabled by default
+    systemConfig.buses.can_output_layout = CAN_OUTPUT_OBD;  // One frame per input, as before v10
+    systemConfig.buses.can_output_base_id = DEFAULT_CAN_OUTPUT_BASE_ID;
+    systemConfig.buses.can_mirror_bus = 0xFF;  // Mirror off by default (NEW in v11)
+    systemConfig.buses.can_mirror_layout = CAN_OUTPUT_PACKED;
+    systemConfig.buses.can_mirror_base_id = DEFAULT_CAN_MIRROR_BASE_ID;
+    systemConfig.buses.can_mirror_interval = DEFAULT_CAN_MIRROR_INTERVAL;
+    systemConfig.buses.can_mirror_baudrate = DEFAULT_CAN_BAUDRATE;
+    systemConfig.buses.can_input_protocol = CAN_PROTOCOL_AUTO;  // NEW in v12
+    systemConfig.buses.j1939_address = DEFAULT_J1939_ADDRESS;
+    systemConfig.buses.can_node_id = 0xFF;  // Not a node (NEW in v20)
+    systemConfig.buses.can_node_reserved = 0;
+    systemConfig.buses.can_node_subscribe = 0;
 
     // Serial Port Configuration defaults
     // USB Serial is always available; Serial1 enabled by default, others disabled
@@ -230,7 +537,10 @@ void resetSystemConfig() {
     for (int i = 0; i < 8; i++) {
         systemConfig.serial.baudrate_index[i] = BAUD_115200;  // Default 115200 baud
     }
-    for (int i = 0; i < 7; i++) {
+    systemConfig.serial.flow_port = 0;       // No RTS/CTS
+    systemConfig.serial.rts_pin = 0xFF;
+    systemConfig.serial.cts_pin = 0xFF;
+    for (int i = 0; i < 4; i++) {
         systemConfig.serial.reserved[i] = 0;
     }
 
@@ -244,8 +554,10 @@ void resetSystemConfig() {
         systemConfig.logFilter.reserved[i] = 0;
     }
 
-    // Calculate checksum
-    systemConfig.checksum = calculateChecksum(&systemConfig);
+    // Device inventory: nothing recorded - the next boot runs every full probe
+    memset(systemConfig.inventory, 0, sizeof(systemConfig.inventory));
+
+    systemConfig.crc = calculateSystemConfigCrc(&systemConfig);
 }
 
 /**
@@ -253,11 +565,11 @@ void resetSystemConfig() {
  * @return true if successful
  */
 bool saveSystemConfig() {
-    // Update checksum before saving
-    systemConfig.checksum = calculateChecksum(&systemConfig);
+    // Update CRC before saving
+    systemConfig.crc = calculateSystemConfigCrc(&systemConfig);
 
-    // Write to EEPROM
-    EEPROM.put(SYSTEM_CONFIG_ADDRESS, systemConfig);
+    // Queue the changed bytes (eeprom_store.h writes them in the background)
+    eepromPut(SYSTEM_CONFIG_ADDRESS, systemConfig);
 
     msg.control.println(F("✓ System config saved to EEPROM"));
     return true;
@@ -305,23 +617,21 @@ void registerSystemPins() {
  */
 bool loadSystemConfig() {
     SystemConfig temp;
-    EEPROM.get(SYSTEM_CONFIG_ADDRESS, temp);
+    eepromGet(SYSTEM_CONFIG_ADDRESS, temp);
 
     // Validate magic number
     if (temp.magic != SYSTEM_CONFIG_MAGIC) {
         return false;
     }
 
-    // Check version
+    // Older version: upgrade it if there is a migration for it
     if (temp.version != SYSTEM_CONFIG_VERSION) {
-        msg.debug.warn(TAG_SYSTEM, "System config version mismatch (expected %d, got %d) - ignoring", SYSTEM_CONFIG_VERSION, temp.version);
-        return false;
+        return migrateSystemConfig(temp.version);
     }
 
-    // Verify checksum
-    uint8_t calculatedChecksum = calculateChecksum(&temp);
-    if (temp.checksum != calculatedChecksum) {
-        msg.debug.warn(TAG_SYSTEM, "System config checksum failed - ignoring");
+    // Verify CRC
+    if (temp.crc != calculateSystemConfigCrc(&temp)) {
+        msg.debug.warn(TAG_SYSTEM, "System config CRC failed - ignoring");
         return false;
     }
 
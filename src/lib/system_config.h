@@ -10,15 +10,51 @@
 
 #include <Arduino.h>
 #include "bus_config.h"
+#include "device_inventory.h"
 
 // EEPROM memory layout constants
 #define SYSTEM_CONFIG_MAGIC 0x5343      // "SC" in ASCII
-#define SYSTEM_CONFIG_VERSION 8         // Increment when struct changes (v8: per-bus CAN baud rates)
+#define SYSTEM_CONFIG_VERSION 22        // Increment when struct changes (v22: device inventory)
 #define SYSTEM_CONFIG_ADDRESS 0x03F0    // Address in EEPROM (after inputs)
 #define SYSTEM_CONFIG_SIZE sizeof(SystemConfig)
 
-// Per-input output mask: all 4 data outputs enabled by default
-#define OUTPUT_MASK_ALL_DATA 0x0F
+// Per-input output mask: all 5 data outputs enabled by default
+#define OUTPUT_MASK_ALL_DATA 0x1F
+
+// Data outputs (CAN, RealDash, Serial, SD, MQTT) - per-input masks and send modes apply
+#define NUM_DATA_OUTPUTS 5
+
+// outputMask bit routing an input to the CAN mirror output (not a module of its own)
+#define OUTPUT_CAN_MIRROR 7
+
+// How a data output decides which inputs to send
+enum OutputSendMode : uint8_t {
+    OUTPUT_MODE_PERIODIC = 0,   // Every input, every interval (default)
+    OUTPUT_MODE_ON_CHANGE = 1,  // Only inputs that moved by more than the deadband, as soon as they change
+    OUTPUT_MODE_HEARTBEAT = 2   // On-change fast path plus every input every interval
+};
+
+// What a data output sends for each input when its interval elapses
+enum OutputAggregate : uint8_t {
+    OUTPUT_AGG_LAST = 0,        // The latest reading (default)
+    OUTPUT_AGG_MEAN = 1,        // Mean of every reading since the last send
+    OUTPUT_AGG_MIN = 2,         // Lowest reading since the last send
+    OUTPUT_AGG_MAX = 3          // Highest reading since the last send
+};
+
+// Serial data plane encoding (OUTPUT Serial FORMAT)
+enum SerialFormat : uint8_t {
+    SERIAL_FORMAT_CSV = 0,          // "abbr,value,units" line per input (default)
+    SERIAL_FORMAT_BINARY = 1,       // Framed packed records with sequence number and CRC16
+    SERIAL_FORMAT_COMPRESSED = 2,   // Binary frames, records delta + LZ compressed (not on AVR)
+    SERIAL_FORMAT_WIDE = 3          // One "t_ms,abbr,abbr,..." CSV row per tick, header on change
+};
+
+// MQTT payload encoding (OUTPUT MQTT FORMAT)
+enum MqttFormat : uint8_t {
+    MQTT_FORMAT_JSON = 0,           // {"ms":..,"v":{"abbr":value,...}} (default)
+    MQTT_FORMAT_BINARY = 1          // Slot + packed signal per input
+};
 
 // Output module IDs
 enum OutputID {
@@ -26,12 +62,13 @@ enum OutputID {
     OUTPUT_REALDASH = 1,
     OUTPUT_SERIAL = 2,
     OUTPUT_SD = 3,
-    OUTPUT_ALARM = 4,
+    OUTPUT_MQTT = 4,
+    OUTPUT_ALARM = 5,
 #ifdef ENABLE_RELAY_OUTPUT
-    OUTPUT_RELAY = 5,
-    NUM_OUTPUTS = 6
+    OUTPUT_RELAY = 6,
+    NUM_OUTPUTS = 7
 #else
-    NUM_OUTPUTS = 5
+    NUM_OUTPUTS = 6
 #endif
 };
 
@@ -48,14 +85,27 @@ enum DisplayType {
 
 // System configuration structure
 struct SystemConfig {
-    // Header (4 bytes)
+    // Header (8 bytes)
     uint16_t magic;              // 0x5343 validation
     uint8_t version;             // Schema version
-    uint8_t checksum;            // XOR checksum
+    uint8_t reserved1;
+    uint32_t crc;                // CRC-32 of every other byte - NEW in v19
+
+    // Output Modules (18 bytes)
+    uint8_t outputEnabled[NUM_OUTPUTS];    // 6 bytes (bool per output)
+    uint16_t outputInterval[NUM_OUTPUTS];  // 12 bytes (interval ms)
+
+    // Output Send Modes (15 bytes) - NEW in v9, data outputs only
+    uint8_t outputMode[NUM_DATA_OUTPUTS];       // OutputSendMode
+    uint16_t outputDeadband[NUM_DATA_OUTPUTS];  // On-change deadband (hundredths of standard units)
+
+    // Output Formats (3 bytes) - NEW in v13
+    uint8_t serialFormat;        // SerialFormat
+    uint8_t mqttFormat;          // MqttFormat - NEW in v21
+    uint8_t mqttQos;             // MQTT QoS 0 or 1 - NEW in v21
 
-    // Output Modules (12 bytes)
-    uint8_t outputEnabled[NUM_OUTPUTS];    // 5 bytes (bool per output)
-    uint16_t outputInterval[NUM_OUTPUTS];  // 10 bytes (interval ms)
+    // Output Aggregation (5 bytes) - NEW in v14, data outputs only
+    uint8_t outputAggregate[NUM_DATA_OUTPUTS];  // OutputAggregate
 
     // Display Settings (7 bytes)
     uint8_t displayEnabled;      // Display on/off (bool)
@@ -70,7 +120,8 @@ struct SystemConfig {
     uint16_t sensorReadInterval;
     uint16_t alarmCheckInterval;
     uint16_t lcdUpdateInterval;
-    uint16_t reserved1;
+    uint8_t lcdPageSeconds;      // LCD page rotation (0 = manual) - NEW in v18
+    uint8_t lcdPinAlarms;        // Pin inputs in alarm to every page (bool) - NEW in v18
 
     // Hardware Pins (8 bytes)
     uint8_t modeButtonPin;
@@ -84,26 +135,31 @@ struct SystemConfig {
     // Physical Constants (4 bytes)
     float seaLevelPressure;      // hPa for altitude
 
-    // Transport Router Configuration (16 bytes) - NEW in v4
+    // Transport Router Configuration (16 bytes) - NEW in v4, subscribers v15
     struct {
         uint8_t control_primary;     // TransportID for CONTROL plane
-        uint8_t control_secondary;   // Multi-cast target or TRANSPORT_NONE
         uint8_t data_primary;        // TransportID for DATA plane
-        uint8_t data_secondary;      // Multi-cast target or TRANSPORT_NONE
         uint8_t debug_primary;       // TransportID for DEBUG plane
-        uint8_t debug_secondary;     // Multi-cast target or TRANSPORT_NONE
         uint8_t bt_type;             // BluetoothType enum (0=none)
-        uint8_t bt_auth_required;    // 0=disabled, 1=enabled
         uint16_t bt_pin;             // 4-digit PIN (0=not set)
-        uint8_t reserved_router[6];  // Future expansion
+        uint8_t bt_auth_required;    // 0=disabled, 1=enabled
+        uint8_t tx_policy[3];        // TxOverflowPolicy per plane (0=plane default)
+        uint16_t subscribers[3];     // Per plane: bit n = TransportID n also gets the plane
     } router;
 
+    // Data Plane Profiles (40 bytes) - NEW in v16, TransportID 1-13 at [id - 1]
+    struct {
+        uint16_t rate[13];           // Bytes/s cap (0 = unshaped)
+        uint8_t streams[13];         // DataStream bits the transport takes
+        uint8_t reserved;
+    } dataProfile;
+
 #ifdef ENABLE_RELAY_OUTPUT
-    // Relay Configuration (32 bytes) - NEW in v5
-    RelayConfig relays[MAX_RELAYS];  // 2 relays × 16 bytes = 32 bytes
+    // Relay Configuration (20 bytes per relay) - NEW in v5
+    RelayConfig relays[MAX_RELAYS];  // MAX_RELAYS × 20 bytes (40 with the default 2)
 #endif
 
-    // Bus Configuration (16 bytes) - Simplified "pick one" model
+    // Bus Configuration (46 bytes) - Simplified "pick one" model
     BusConfig buses;
 
     // Serial Port Configuration (16 bytes) - Which serial ports are enabled
@@ -117,6 +173,9 @@ struct SystemConfig {
         uint32_t enabledTags;     // 32-bit bitmap for tag filtering (all enabled by default)
         uint8_t reserved[5];      // Future expansion
     } logFilter;
+
+    // Device Inventory (24 bytes with the default 6 slots) - NEW in v22
+    InventoryEntry inventory[DEVICE_INVENTORY_SLOTS];  // Probed devices (device_inventory.h)
 };
 
 // Global system config instance
@@ -127,7 +186,7 @@ void initSystemConfig();         // Load from EEPROM or set defaults
 bool saveSystemConfig();         // Save to EEPROM
 bool loadSystemConfig();         // Load from EEPROM
 void resetSystemConfig();        // Reset to defaults
-uint8_t calculateChecksum(SystemConfig* cfg);
+uint32_t calculateSystemConfigCrc(const SystemConfig* cfg);
 void printSystemStatus();
 void registerSystemPins();       // Register system pins in pin registry
 
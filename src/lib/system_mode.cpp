@@ -7,8 +7,9 @@
 #include "watchdog.h"
 #include "message_api.h"
 #include "log_tags.h"
+#include "dual_core.h"
 
-#ifdef ENABLE_LCD
+#if defined(ENABLE_LCD) || defined(ENABLE_OLED)
 extern void showConfigModeMessage();
 extern void clearLCD();
 #endif
@@ -17,6 +18,10 @@ extern void clearLCD();
 #include "rgb_led.h"
 #endif
 
+#ifdef ENABLE_BENCH_STREAM
+#include "../outputs/bench_stream.h"
+#endif
+
 // Current system mode
 static SystemMode currentMode = MODE_RUN;
 
@@ -40,9 +45,17 @@ void setMode(SystemMode newMode) {
     if (oldMode != newMode) {
         msg.control.println();
         if (newMode == MODE_CONFIG) {
+            #ifdef ENABLE_DUAL_CORE
+            syncAcquisitionCore();  // Config edits only once the pass in flight is done
+            #endif
+
             // Disable watchdog when entering CONFIG mode
             watchdogDisable();
 
+            #ifdef ENABLE_BENCH_STREAM
+            stopBenchStream();  // Nothing drains the ring while sensors are paused
+            #endif
+
             msg.control.println(F("========================================"));
             msg.control.println(F("  ENTERED CONFIG MODE"));
             msg.control.println(F("  Sensors paused, configuration unlocked"));
@@ -50,7 +63,7 @@ void setMode(SystemMode newMode) {
             msg.control.println(F("  Type RUN to resume normal operation"));
             msg.control.println(F("========================================"));
 
-            #ifdef ENABLE_LCD
+            #if defined(ENABLE_LCD) || defined(ENABLE_OLED)
             // Clear LCD (message will be shown by loop if no sensors)
             extern void clearLCD();
             clearLCD();
@@ -75,7 +88,7 @@ void setMode(SystemMode newMode) {
             msg.control.println(F("  Type CONFIG to modify configuration"));
             msg.control.println(F("========================================"));
 
-            #ifdef ENABLE_LCD
+            #if defined(ENABLE_LCD) || defined(ENABLE_OLED)
             // Clear LCD when entering RUN mode (sensors will update it)
             clearLCD();
             #endif
@@ -0,0 +1,290 @@
+/*
+ * timebase.cpp - UTC microseconds for the 64-bit timebase, disciplined to PPS or the RTC
+ */
+
+#include "timebase.h"
+
+#if TIME_SYNC
+
+#include "../hal/hal_clock.h"
+#include "../hal/hal_placement.h"
+#include "isr_profile.h"
+#include "message_api.h"
+#include "log_tags.h"
+#include "pin_registry.h"
+
+// RTC edges carry the loop's polling jitter - take only this share of their phase
+#define TIME_RTC_PHASE_SHARE 8
+
+// Share of an edge's rate error applied (smooths interrupt and polling jitter)
+#define TIME_RATE_SHARE 8
+
+// GPS seconds disagreeing with a locked PPS in a row before it re-locks
+#define TIME_GPS_MISMATCHES 3
+
+// Mapping local -> UTC: utc = anchorUtc + elapsed - elapsed * ppm / 1e6
+static uint64_t anchorLocal = 0;
+static uint64_t anchorUtc = 0;          // 0 = not locked
+static float ppm = 0;                   // Local crystal fast by this much
+static TimeSource source = TIME_SOURCE_NONE;
+
+static uint32_t edges = 0;              // Edges that corrected the mapping
+static uint16_t steps = 0;              // ... of them, by stepping the anchor
+static uint16_t rejected = 0;           // PPS edges too early or too far off
+static int32_t lastErrorUs = 0;         // Error shown by the last edge
+static uint64_t lastEdgeLocal = 0;
+
+// RTC edge detection
+static uint32_t rtcSecond = 0;          // hal::wallClock() at the previous poll
+static uint64_t rtcLastUsed = 0;        // Local count of the last RTC edge used
+static bool rtcResync = true;           // Take the next tick's phase whole
+
+#ifdef TIME_PPS_PIN
+static volatile uint64_t ppsEdgeUs = 0;
+static volatile uint8_t ppsCount = 0;
+static uint8_t ppsHandled = 0;
+static uint64_t ppsLastUs = 0;          // Last PPS edge accepted
+static uint64_t ppsUnlabelled = 0;      // Edge waiting for its second (not locked)
+static uint8_t gpsMismatches = 0;
+
+HAL_ISR static void ppsISR() {
+    ISR_PROFILE_BEGIN();
+    ppsEdgeUs = hal::micros64();
+    ppsCount++;
+    ISR_PROFILE_END(ISR_PROF_PPS);
+}
+#endif
+
+// ===== MAPPING =====
+
+uint64_t timebaseUtcMicros(uint64_t localUs) {
+    if (anchorUtc == 0) return 0;
+    int64_t elapsed = (int64_t)(localUs - anchorLocal);
+    return anchorUtc + elapsed - (int64_t)((float)elapsed * ppm * 1e-6f);
+}
+
+TimeSource getTimeSource() {
+    return source;
+}
+
+static void stepTo(uint64_t localUs, uint64_t utcUs) {
+    anchorLocal = localUs;
+    anchorUtc = utcUs;
+    steps++;
+}
+
+/**
+ * Correct the mapping with a reference edge
+ * @param localUs      Local count at the edge
+ * @param utcSecond    UTC second the edge starts
+ * @param phaseShare   Take 1/phaseShare of the phase error
+ */
+static void applyEdge(uint64_t localUs, uint32_t utcSecond, uint8_t phaseShare, TimeSource from) {
+    uint64_t utcUs = (uint64_t)utcSecond * 1000000ULL;
+    edges++;
+    lastEdgeLocal = localUs;
+    source = from;
+
+    if (anchorUtc == 0) {
+        stepTo(localUs, utcUs);
+        lastErrorUs = 0;
+        return;
+    }
+
+    int64_t error = (int64_t)(utcUs - timebaseUtcMicros(localUs));
+    lastErrorUs = (int32_t)(error > INT32_MAX ? INT32_MAX : (error < INT32_MIN ? INT32_MIN : error));
+    if (error >= TIME_STEP_US || error <= -TIME_STEP_US) {
+        stepTo(localUs, utcUs);
+        return;
+    }
+
+    // Error over the stretch since the anchor is the rate still uncorrected
+    int64_t elapsed = (int64_t)(localUs - anchorLocal);
+    if (elapsed > 0) {
+        ppm -= (float)error * 1e6f / (float)elapsed / TIME_RATE_SHARE;
+        if (ppm > TIME_MAX_PPM) ppm = TIME_MAX_PPM;
+        if (ppm < -TIME_MAX_PPM) ppm = -TIME_MAX_PPM;
+    }
+
+    uint64_t predicted = timebaseUtcMicros(localUs);
+    anchorLocal = localUs;
+    anchorUtc = predicted + error / phaseShare;
+}
+
+// ===== PPS =====
+
+#ifdef TIME_PPS_PIN
+static bool ppsLocked(uint64_t localUs) {
+    return source == TIME_SOURCE_PPS && localUs - ppsLastUs < (uint64_t)TIME_PPS_HOLDOVER_MS * 1000ULL;
+}
+
+static void takePpsEdge() {
+    if (ppsCount == ppsHandled) return;
+    noInterrupts();
+    uint64_t edgeUs = ppsEdgeUs;
+    ppsHandled = ppsCount;
+    interrupts();
+
+    // Glitch on the line - a real PPS is a second apart
+    if (ppsLastUs != 0 && edgeUs - ppsLastUs < 900000ULL) {
+        rejected++;
+        return;
+    }
+    bool locked = ppsLocked(edgeUs);
+    ppsLastUs = edgeUs;
+
+    if (locked) {
+        uint64_t predicted = timebaseUtcMicros(edgeUs);
+        uint32_t second = (uint32_t)((predicted + 500000ULL) / 1000000ULL);
+        applyEdge(edgeUs, second, 1, TIME_SOURCE_PPS);
+        return;
+    }
+
+#ifdef ENABLE_GPS
+    ppsUnlabelled = edgeUs;      // timebaseGpsSecond() names it
+#else
+    uint32_t second = hal::wallClock();
+    if (second != 0) applyEdge(edgeUs, second, 1, TIME_SOURCE_PPS);
+#endif
+}
+#endif // TIME_PPS_PIN
+
+void timebaseGpsSecond(uint32_t unixTime, uint64_t rxUs) {
+#ifdef TIME_PPS_PIN
+    takePpsEdge();
+    if (ppsLastUs == 0 || rxUs - ppsLastUs >= (uint64_t)TIME_PPS_LABEL_MS * 1000ULL) return;
+
+    if (!ppsLocked(rxUs)) {
+        if (ppsUnlabelled == ppsLastUs) {
+            applyEdge(ppsLastUs, unixTime, 1, TIME_SOURCE_PPS);
+            ppsUnlabelled = 0;
+        }
+        return;
+    }
+
+    // Locked: the GPS only checks the second the last edge was given
+    uint32_t second = (uint32_t)((timebaseUtcMicros(ppsLastUs) + 500000ULL) / 1000000ULL);
+    if (second == unixTime) {
+        gpsMismatches = 0;
+    } else if (++gpsMismatches >= TIME_GPS_MISMATCHES) {
+        gpsMismatches = 0;
+        stepTo(ppsLastUs, (uint64_t)unixTime * 1000000ULL);
+    }
+#else
+    (void)unixTime;
+    (void)rxUs;
+#endif
+}
+
+// ===== RTC =====
+
+static void takeRtcEdge(uint64_t localUs) {
+    uint32_t second = hal::wallClock();
+    if (second == rtcSecond) return;
+    bool tick = rtcSecond != 0 && second == rtcSecond + 1;
+    rtcSecond = second;
+    if (second == 0) return;
+
+    // First second seen, or the clock was set - not an edge; anchor on the next tick
+    if (!tick) {
+        rtcResync = true;
+        return;
+    }
+    if (rtcResync || anchorUtc == 0) {
+        rtcResync = false;
+        rtcLastUsed = localUs;
+        applyEdge(localUs, second, 1, TIME_SOURCE_RTC);
+        return;
+    }
+    if (localUs - rtcLastUsed < (uint64_t)TIME_RTC_EDGE_S * 1000000ULL) return;
+    rtcLastUsed = localUs;
+    applyEdge(localUs, second, TIME_RTC_PHASE_SHARE, TIME_SOURCE_RTC);
+}
+
+// ===== LOOP =====
+
+void initTimebase() {
+    hal::micros64();
+#ifdef TIME_PPS_PIN
+    int irq = digitalPinToInterrupt(TIME_PPS_PIN);
+    if (irq == NOT_AN_INTERRUPT) {
+        msg.debug.warn(TAG_SYSTEM, "PPS pin %d has no interrupt - PPS disabled", TIME_PPS_PIN);
+        return;
+    }
+    registerPin(TIME_PPS_PIN, PIN_RESERVED, "GPS PPS");
+    pinMode(TIME_PPS_PIN, INPUT);
+    attachInterrupt(irq, ppsISR, RISING);
+#endif
+}
+
+void updateTimebase() {
+    uint64_t now = hal::micros64();
+#ifdef TIME_PPS_PIN
+    takePpsEdge();
+#endif
+    // Once PPS has set the mapping the RTC's phase is worse even in holdover
+    if (source != TIME_SOURCE_PPS) takeRtcEdge(now);
+}
+
+// ===== STATUS =====
+
+static void printUtc(uint64_t utcUs) {
+    char stamp[16];
+    char fraction[8];
+    hal::formatWallClock((uint32_t)(utcUs / 1000000ULL), stamp);
+    snprintf(fraction, sizeof(fraction), ".%06lu", (unsigned long)(utcUs % 1000000ULL));
+    msg.control.print(stamp);
+    msg.control.print(fraction);
+}
+
+void printTimebaseStatus() {
+    uint64_t now = hal::micros64();
+    msg.control.println();
+    msg.control.println(F("=== Time ==="));
+    msg.control.print(F("Uptime:     "));
+    msg.control.print((uint32_t)(now / 1000000ULL));
+    char fraction[8];
+    snprintf(fraction, sizeof(fraction), ".%06lu", (unsigned long)(now % 1000000ULL));
+    msg.control.print(fraction);
+    msg.control.println(F(" s"));
+
+    msg.control.print(F("UTC:        "));
+    uint64_t utc = timebaseUtcMicros(now);
+    if (utc == 0) {
+        msg.control.println(F("not known (no PPS, RTC or clock set)"));
+    } else {
+        printUtc(utc);
+        msg.control.println();
+    }
+
+    msg.control.print(F("Source:     "));
+    if (source == TIME_SOURCE_NONE) {
+        msg.control.println(F("none"));
+    } else {
+        msg.control.print(source == TIME_SOURCE_PPS ? F("PPS") : F("RTC"));
+        msg.control.print(F(", last edge "));
+        msg.control.print((uint32_t)((now - lastEdgeLocal) / 1000ULL));
+        msg.control.println(F(" ms ago"));
+    }
+#ifdef TIME_PPS_PIN
+    msg.control.print(F("PPS:        pin "));
+    msg.control.print(TIME_PPS_PIN);
+    if (ppsLocked(now)) msg.control.println(F(", locked"));
+    else msg.control.println(source == TIME_SOURCE_PPS ? F(", holdover") : F(", not locked"));
+#endif
+
+    msg.control.print(F("Rate:       "));
+    msg.control.print(ppm, 2);
+    msg.control.print(F(" ppm, last edge off by "));
+    msg.control.print(lastErrorUs);
+    msg.control.println(F(" us"));
+    msg.control.print(F("Edges:      "));
+    msg.control.print(edges);
+    msg.control.print(F(" used, "));
+    msg.control.print(steps);
+    msg.control.print(F(" steps, "));
+    msg.control.print(rejected);
+    msg.control.println(F(" rejected"));
+}
+
+#endif // TIME_SYNC
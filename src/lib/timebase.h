@@ -0,0 +1,116 @@
+/*
+ * timebase.h - UTC microseconds for the 64-bit timebase, disciplined to PPS or the RTC
+ *
+ * hal::micros64() (hal/hal_timebase.h) counts microseconds since boot on
+ * the board's crystal. This maps those counts to UTC, so logs from several
+ * devices line up: an anchor (a local count and the UTC microsecond it
+ * was), plus the crystal's measured rate error in ppm, which grows to
+ * tens of milliseconds an hour if left alone.
+ *
+ * Reference edges, best first:
+ *   PPS    - GPS pulse-per-second on TIME_PPS_PIN, captured by an interrupt
+ *            to the microsecond. The second it starts is told by the GPS
+ *            driver (a fix received within TIME_PPS_LABEL_MS of the edge),
+ *            or hal::wallClock() without ENABLE_GPS. Once locked each edge
+ *            is labelled with the nearest predicted second, and a GPS
+ *            second that disagrees three times running re-locks.
+ *   RTC    - the second ticking over on hal::wallClock() (Teensy RTC, ESP32
+ *            time(), or a clock set by setWallClock()), polled from the
+ *            loop - good to the loop period, so only every TIME_RTC_EDGE_S
+ *            seconds is used for the rate
+ * Each edge corrects the rate by a fraction of the error it shows (an
+ * edge off by TIME_STEP_US or more steps the anchor instead), and PPS also
+ * takes the phase whole. The RTC's phase is only as good as whoever set it,
+ * so once PPS has locked the RTC is no longer used: without PPS edges for
+ * TIME_PPS_HOLDOVER_MS the mapping runs on at the rate PPS measured
+ * (holdover), and the next edge is labelled by the GPS again.
+ *
+ * The local count stays monotonic; UTC can step on a correction.
+ *
+ * Usage:
+ *   initTimebase();                     // setup()
+ *   updateTimebase();                   // every loop, CONFIG mode too
+ *   uint64_t utc = timebaseUtcMicros(hal::micros64());   // 0 = not known yet
+ *
+ * Build Flags:
+ *   -D TIME_SYNC=0|1            - UTC discipline and the TIME command (default 1; 0 on Uno)
+ *   -D TIME_PPS_PIN=n           - GPS PPS input, rising edge (default none)
+ *   -D TIME_PPS_HOLDOVER_MS=n   - PPS silence that ends the lock (default 5000)
+ *   -D TIME_PPS_LABEL_MS=n      - Latest a GPS fix may arrive after its PPS edge (default 500)
+ *   -D TIME_RTC_EDGE_S=n        - Seconds between RTC edges used for the rate (default 64)
+ *   -D TIME_STEP_US=n           - Edge error that steps instead of slewing (default 100000)
+ *   -D TIME_MAX_PPM=n           - Largest rate correction accepted (default 500)
+ */
+
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <Arduino.h>
+#include "../hal/hal_timebase.h"
+
+#ifndef TIME_SYNC
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
+#define TIME_SYNC 0
+#else
+#define TIME_SYNC 1
+#endif
+#endif
+
+#ifndef TIME_PPS_HOLDOVER_MS
+#define TIME_PPS_HOLDOVER_MS 5000
+#endif
+
+#ifndef TIME_PPS_LABEL_MS
+#define TIME_PPS_LABEL_MS 500
+#endif
+
+#ifndef TIME_RTC_EDGE_S
+#define TIME_RTC_EDGE_S 64
+#endif
+
+#ifndef TIME_STEP_US
+#define TIME_STEP_US 100000L
+#endif
+
+#ifndef TIME_MAX_PPM
+#define TIME_MAX_PPM 500
+#endif
+
+enum TimeSource : uint8_t {
+    TIME_SOURCE_NONE = 0,       // UTC not known
+    TIME_SOURCE_RTC,
+    TIME_SOURCE_PPS
+};
+
+#if TIME_SYNC
+
+// Attach the PPS interrupt (TIME_PPS_PIN)
+void initTimebase();
+
+// Take PPS and RTC edges (also keeps hal::micros64() ahead of its wraps)
+void updateTimebase();
+
+// UTC microseconds since 1970 at local count localUs, 0 if not known
+uint64_t timebaseUtcMicros(uint64_t localUs);
+
+// Source of the last edge used (TIME_SOURCE_NONE before the first)
+TimeSource getTimeSource();
+
+// GPS driver: a fix for UTC second unixTime arrived at local count rxUs
+void timebaseGpsSecond(uint32_t unixTime, uint64_t rxUs);
+
+// Local and UTC time, source, rate and edge counters (TIME)
+void printTimebaseStatus();
+
+#else
+
+inline void initTimebase() {}
+inline void updateTimebase() { hal::micros64(); }
+inline uint64_t timebaseUtcMicros(uint64_t) { return 0; }
+inline TimeSource getTimeSource() { return TIME_SOURCE_NONE; }
+inline void timebaseGpsSecond(uint32_t, uint64_t) {}
+inline void printTimebaseStatus() {}
+
+#endif // TIME_SYNC
+
+#endif // TIMEBASE_H
@@ -12,6 +12,7 @@
 #define TRANSPORT_INTERFACE_H
 
 #include <Arduino.h>
+#include "float_format.h"
 
 // Transport capabilities bitfield
 enum TransportCapabilities {
@@ -32,9 +33,50 @@ enum TransportState {
     TRANSPORT_ERROR        = 3,
 };
 
+// What a buffered transport does with a write that doesn't fit its TX ring
+// (transport_tx_ring.h). 0 in SystemConfig means the plane's default.
+enum TxOverflowPolicy : uint8_t {
+    TX_POLICY_DEFAULT = 0,
+    TX_DROP_OLDEST    = 1,  // Evict the oldest queued bytes
+    TX_DROP_NEWEST    = 2,  // Drop the whole write
+    TX_BLOCK          = 3,  // Wait for the port (control plane only)
+};
+
+// Which queue of a transport a write goes to - one per message plane, in
+// MessagePlane order. Serial transports send CONTROL ahead of DATA and DEBUG,
+// which share the bulk queue (transport_tx_ring.h); the others keep one queue.
+enum TxLane : uint8_t {
+    TX_LANE_CONTROL = 0,
+    TX_LANE_DATA    = 1,
+    TX_LANE_DEBUG   = 2,
+};
+
+// TX ring counters of a buffered transport
+struct TxStats {
+    uint32_t bytesSent;         // Drained to the port
+    uint32_t bytesDropped;      // Lost to TX_DROP_OLDEST / TX_DROP_NEWEST
+    uint32_t writesDropped;     // Whole writes dropped (TX_DROP_NEWEST)
+    uint32_t blockedWrites;     // TX_BLOCK writes that had to wait
+    uint16_t peakFill;          // Most bytes queued at once
+    uint16_t capacity;
+};
+
+// Traffic through a transport, kept by the base class for every transport
+// (send()/receive() - what the router and msg.* use)
+struct TransportCounters {
+    uint32_t bytesOut;          // Accepted by write()
+    uint32_t bytesIn;           // Returned by readAvailable()
+    uint32_t writes;            // write() calls
+    uint32_t shortWrites;       // Writes that took less than offered (partial or refused)
+    uint32_t sinceMs;           // millis() the counters started from
+};
+
 // Abstract transport interface
 // All concrete transports (Serial, Bluetooth, etc.) implement this interface
 class TransportInterface {
+private:
+    TransportCounters counters = {0, 0, 0, 0, 0};
+
 public:
     virtual ~TransportInterface() {}
 
@@ -46,12 +88,37 @@ public:
     // Write buffer (for binary data like RealDash frames)
     virtual size_t write(const uint8_t* buffer, size_t size) = 0;
 
+    // Write buffer with an overflow policy (MessageStream, per plane).
+    // Unbuffered transports just write.
+    virtual size_t write(const uint8_t* buffer, size_t size, TxOverflowPolicy policy) {
+        (void)policy;
+        return write(buffer, size);
+    }
+
+    // The same on a lane (the plane it is from); transports with one queue ignore it
+    virtual size_t write(const uint8_t* buffer, size_t size, TxOverflowPolicy policy, TxLane lane) {
+        (void)lane;
+        return write(buffer, size, policy);
+    }
+
     // Check bytes available for reading
     virtual int available() = 0;
 
     // Read single byte (-1 if none available)
     virtual int read() = 0;
 
+    // Read up to size bytes already received, without waiting; returns the
+    // bytes read. The default reads them one at a time.
+    virtual size_t readAvailable(uint8_t* buffer, size_t size) {
+        size_t n = 0;
+        while (n < size && available() > 0) {
+            int c = read();
+            if (c < 0) break;
+            buffer[n++] = (uint8_t)c;
+        }
+        return n;
+    }
+
     // Peek at next byte without consuming it
     virtual int peek() = 0;
 
@@ -69,6 +136,68 @@ public:
     // Get current connection state
     virtual TransportState getState() const = 0;
 
+    // TX ring counters (nullptr if the transport is unbuffered)
+    virtual const TxStats* getTxStats() const {
+        return nullptr;
+    }
+
+    // Bytes a write could queue right now without waiting or dropping
+    // ((size_t)-1 if unbuffered - writes go straight to the port)
+    virtual size_t txSpace() const {
+        return (size_t)-1;
+    }
+
+    // The same for the control lane - its own ring on a laned transport
+    virtual const TxStats* getControlTxStats() const {
+        return getTxStats();
+    }
+    virtual size_t controlTxSpace() const {
+        return txSpace();
+    }
+
+    // Control bytes sent ahead of queued bulk output (0 without lanes)
+    virtual uint32_t getControlAhead() const {
+        return 0;
+    }
+
+    // Plane framing: every write goes out as a serial frame (outputs/serial_frame.h)
+    // typed by its lane, so a host can split the planes. false if not supported.
+    virtual bool setFraming(bool on) {
+        return !on;
+    }
+    virtual bool isFramed() const {
+        return false;
+    }
+
+    // ========== Counted I/O ==========
+    // write() / readAvailable() plus the traffic counters
+
+    size_t send(const uint8_t* data, size_t len, TxOverflowPolicy policy) {
+        return countWrite(len, write(data, len, policy));
+    }
+
+    size_t send(const uint8_t* data, size_t len, TxOverflowPolicy policy, TxLane lane) {
+        return countWrite(len, write(data, len, policy, lane));
+    }
+
+    size_t send(const uint8_t* data, size_t len) {
+        return countWrite(len, write(data, len));
+    }
+
+    size_t receive(uint8_t* buffer, size_t size) {
+        size_t n = readAvailable(buffer, size);
+        counters.bytesIn += n;
+        return n;
+    }
+
+    const TransportCounters& getCounters() const {
+        return counters;
+    }
+
+    void resetCounters() {
+        counters = {0, 0, 0, 0, (uint32_t)millis()};
+    }
+
     // ========== Lifecycle Management ==========
 
     // Initialize transport (called once at startup)
@@ -102,6 +231,16 @@ public:
         return getState() == TRANSPORT_CONNECTED;
     }
 
+private:
+    size_t countWrite(size_t offered, size_t taken) {
+        counters.writes++;
+        counters.bytesOut += taken;
+        if (taken < offered) counters.shortWrites++;
+        return taken;
+    }
+
+public:
+
     // ========== Print Convenience Methods ==========
     // These provide compatibility with Serial.print() API
 
@@ -158,8 +297,8 @@ public:
     }
 
     size_t print(float f, int digits = 2) {
-        char buf[16];
-        dtostrf(f, 0, digits, buf);
+        char buf[FLOAT_FORMAT_SIZE];
+        formatFixed(buf, f, digits < 0 ? 0 : digits);
         return print(buf);
     }
 
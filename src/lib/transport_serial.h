@@ -4,15 +4,42 @@
  * Wraps Arduino Serial, Serial1, Serial2, etc. into the TransportInterface
  * abstraction. Provides unified access to hardware UARTs.
  *
+ * Writes are queued in a TX ring (transport_tx_ring.h) and drained as the
+ * port has room - after each write and in update() - so a port nobody reads
+ * can't block the loop. Writes without a policy (direct use rather than
+ * through msg.*) behave as TX_BLOCK, like an unbuffered Stream.
+ *
+ * With TRANSPORT_CONTROL_RING_BYTES the ring is split into priority lanes
+ * (TxLanes): control plane writes skip the queued data and debug output at
+ * its next write boundary. Writes without a lane are data.
+ *
+ * Plane framing (setFraming(), TRANSPORT FRAMING ON, lanes only): every
+ * write is wrapped in serial frames (outputs/serial_frame.h) of up to
+ * TRANSPORT_FRAME_PAYLOAD bytes, typed 'c' control, 'd' data, 'g' debug and
+ * numbered per transport, so a host reading one port can tell the planes
+ * apart - binary data frames arrive nested in 'd' frames. Not kept across
+ * a reboot; a host turns it on for the link it uses.
+ *
  * Usage:
  *   SerialTransport usb(&Serial, "USB", 115200);
  *   SerialTransport hw1(&Serial1, "SERIAL1", 115200);
+ *
+ * Build Flags:
+ *   -D TRANSPORT_FRAME_PAYLOAD=n  - Largest payload of a plane frame (default 128)
  */
 
 #ifndef TRANSPORT_SERIAL_H
 #define TRANSPORT_SERIAL_H
 
 #include "transport_interface.h"
+#include "transport_tx_ring.h"
+#include "../outputs/serial_frame.h"
+
+#ifndef TRANSPORT_FRAME_PAYLOAD
+#define TRANSPORT_FRAME_PAYLOAD 128
+#endif
+
+#define SERIAL_LANES (TRANSPORT_TX_RING_BYTES > 0 && TRANSPORT_CONTROL_RING_BYTES > 0)
 
 class SerialTransport : public TransportInterface {
 private:
@@ -20,6 +47,64 @@ private:
     const char* name;
     uint32_t baudRate;
 
+#if SERIAL_LANES
+    TxLanes lanes;
+    bool framed = false;
+    uint16_t frameSequence = 0;
+
+    // Non-blocking: only what the port has room for (control only while an
+    // answer is being printed)
+    void drain(bool bulkToo) {
+        if (lanes.used() == 0) return;
+        int room = serial->availableForWrite();
+        if (room > 0) {
+            lanes.drainTo(*serial, room, bulkToo);
+        }
+    }
+
+    size_t queue(const uint8_t* buffer, size_t size, TxOverflowPolicy policy, TxLane lane) {
+        if (policy == TX_BLOCK && size > lanes.space(lane)) {
+            // Wait for the port: queued bytes first, to keep the order
+            lanes.countBlocked(lane);
+            lanes.drainTo(*serial, lanes.used(), true);
+            if (size > lanes.capacity(lane)) {
+                size_t n = serial->write(buffer, size);
+                lanes.countSent(lane, n);
+                return n;
+            }
+        }
+        size_t n = lanes.push(buffer, size, policy, lane);
+        drain(lane != TX_LANE_CONTROL);
+        return n;
+    }
+
+    // Plane frames of up to TRANSPORT_FRAME_PAYLOAD bytes; stops at the first dropped
+    size_t queueFramed(const uint8_t* buffer, size_t size, TxOverflowPolicy policy, TxLane lane) {
+        static const uint8_t types[] = { 'c', 'd', 'g' };
+        uint8_t frame[TRANSPORT_FRAME_PAYLOAD + SERIAL_FRAME_OVERHEAD];
+        size_t done = 0;
+        while (done < size) {
+            uint16_t len = (size - done < TRANSPORT_FRAME_PAYLOAD) ? size - done : TRANSPORT_FRAME_PAYLOAD;
+            memcpy(frame + SERIAL_FRAME_HEADER, buffer + done, len);
+            uint16_t total = buildSerialFrame(frame, types[lane], len, frameSequence++);
+            if (queue(frame, total, policy, lane) < total) break;
+            done += len;
+        }
+        return done;
+    }
+#elif TRANSPORT_TX_RING_BYTES > 0
+    TxRing txRing;
+
+    // Non-blocking: only what the port has room for
+    void drain() {
+        if (txRing.used() == 0) return;
+        int room = serial->availableForWrite();
+        if (room > 0) {
+            txRing.drainTo(*serial, room);
+        }
+    }
+#endif
+
 public:
     SerialTransport(Stream* serialPort, const char* transportName, uint32_t baud = 115200)
         : serial(serialPort), name(transportName), baudRate(baud) {}
@@ -27,11 +112,40 @@ public:
     // ========== TransportInterface Implementation ==========
 
     size_t write(uint8_t c) override {
-        return serial->write(c);
+        return write(&c, 1, TX_BLOCK);
     }
 
     size_t write(const uint8_t* buffer, size_t size) override {
+        return write(buffer, size, TX_BLOCK);
+    }
+
+    size_t write(const uint8_t* buffer, size_t size, TxOverflowPolicy policy) override {
+        return write(buffer, size, policy, TX_LANE_DATA);
+    }
+
+    size_t write(const uint8_t* buffer, size_t size, TxOverflowPolicy policy, TxLane lane) override {
+#if SERIAL_LANES
+        return framed ? queueFramed(buffer, size, policy, lane) : queue(buffer, size, policy, lane);
+#elif TRANSPORT_TX_RING_BYTES > 0
+        (void)lane;
+        if (policy == TX_BLOCK && size > txRing.space()) {
+            // Wait for the port: queued bytes first, to keep the order
+            txRing.countBlocked();
+            txRing.drainTo(*serial, txRing.used());
+            if (size > txRing.capacity()) {
+                size_t n = serial->write(buffer, size);
+                txRing.countSent(n);
+                return n;
+            }
+        }
+        size_t n = txRing.push(buffer, size, policy);
+        drain();
+        return n;
+#else
+        (void)policy;
+        (void)lane;
         return serial->write(buffer, size);
+#endif
     }
 
     int available() override {
@@ -42,11 +156,23 @@ public:
         return serial->read();
     }
 
+    size_t readAvailable(uint8_t* buffer, size_t size) override {
+        int waiting = serial->available();
+        if (waiting <= 0) return 0;
+        if ((size_t)waiting < size) size = waiting;
+        return serial->readBytes((char*)buffer, size);  // All waiting - no timeout
+    }
+
     int peek() override {
         return serial->peek();
     }
 
     void flush() override {
+#if SERIAL_LANES
+        lanes.drainTo(*serial, lanes.used(), true);
+#elif TRANSPORT_TX_RING_BYTES > 0
+        txRing.drainTo(*serial, txRing.used());
+#endif
         serial->flush();
     }
 
@@ -58,6 +184,45 @@ public:
         return CAP_READ | CAP_WRITE | CAP_BINARY | CAP_HARDWARE_SERIAL;
     }
 
+#if SERIAL_LANES
+    const TxStats* getTxStats() const override {
+        return lanes.getBulkStats();
+    }
+
+    size_t txSpace() const override {
+        return lanes.bulkSpace();
+    }
+
+    const TxStats* getControlTxStats() const override {
+        return lanes.getControlStats();
+    }
+
+    size_t controlTxSpace() const override {
+        return lanes.controlSpace();
+    }
+
+    uint32_t getControlAhead() const override {
+        return lanes.getAheadOfBulk();
+    }
+
+    bool setFraming(bool on) override {
+        framed = on;
+        return true;
+    }
+
+    bool isFramed() const override {
+        return framed;
+    }
+#elif TRANSPORT_TX_RING_BYTES > 0
+    const TxStats* getTxStats() const override {
+        return txRing.getStats();
+    }
+
+    size_t txSpace() const override {
+        return txRing.space();
+    }
+#endif
+
     TransportState getState() const override {
         // Hardware serial is always "connected" once initialized
         return TRANSPORT_CONNECTED;
@@ -74,7 +239,11 @@ public:
     }
 
     void update() override {
-        // No housekeeping needed for hardware serial
+#if SERIAL_LANES
+        drain(true);
+#elif TRANSPORT_TX_RING_BYTES > 0
+        drain();
+#endif
     }
 };
 
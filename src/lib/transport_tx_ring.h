@@ -0,0 +1,260 @@
+/*
+ * transport_tx_ring.h - Bounded transmit ring for transports
+ *
+ * A transport queues outgoing bytes here and drains them to its port only as
+ * fast as the port reports room (availableForWrite()), so a full USB or UART
+ * TX buffer - no host reading, a 9600 baud radio - never stalls the loop.
+ * What happens when a write doesn't fit is the writer's TxOverflowPolicy
+ * (transport_interface.h):
+ *
+ *   TX_DROP_NEWEST  - the whole write is dropped (frames stay intact)
+ *   TX_DROP_OLDEST  - the oldest queued bytes make room for it
+ *   TX_BLOCK        - the transport waits for the port (control plane only)
+ *
+ * TxRing is the serial transports' ring; other transports pick their own
+ * size with TxRingBuffer<bytes>.
+ *
+ * Priority lanes (TxLanes): a serial transport that carries every plane -
+ * the default, all on USB - keeps command answers in a control ring of
+ * their own, apart from the bulk ring of data and debug output. The drain
+ * sends control bytes first, but only at a bulk write's boundary: a CSV line
+ * or binary frame already on its way is finished, never cut. A burst of
+ * telemetry then delays an answer by at most one write instead of everything
+ * queued ahead of it. The bulk ring keeps the lengths of its last
+ * TX_LANE_WRITES writes; more than that queued and the newest are merged
+ * into one (they go out back to back). Draining after a control write sends
+ * control bytes only, so bulk output never lands in the middle of an answer
+ * still being printed; the next update() or bulk write resumes it.
+ *
+ * Usage:
+ *   TxRing ring;
+ *   ring.push(data, len, TX_DROP_NEWEST);
+ *   ring.drainTo(*serial, serial->availableForWrite());
+ *
+ *   TxLanes lanes;
+ *   lanes.push(data, len, TX_DROP_NEWEST, TX_LANE_DATA);
+ *   lanes.drainTo(*serial, serial->availableForWrite(), true);
+ *
+ * Build Flags:
+ *   -D TRANSPORT_TX_RING_BYTES=n       - Ring per serial transport (default 64 on
+ *                                        AVR, 512 elsewhere; 0 = unbuffered); the
+ *                                        bulk ring when lanes are on
+ *   -D TRANSPORT_CONTROL_RING_BYTES=n  - Control ring per serial transport
+ *                                        (default 256; 0 on AVR = one ring, no lanes)
+ *   -D TX_LANE_WRITES=n                - Bulk write boundaries kept (default 16)
+ */
+
+#ifndef TRANSPORT_TX_RING_H
+#define TRANSPORT_TX_RING_H
+
+#include "transport_interface.h"
+
+#ifndef TRANSPORT_TX_RING_BYTES
+#if defined(__AVR__)
+#define TRANSPORT_TX_RING_BYTES 64
+#else
+#define TRANSPORT_TX_RING_BYTES 512
+#endif
+#endif
+
+#ifndef TRANSPORT_CONTROL_RING_BYTES
+#if defined(__AVR__)
+#define TRANSPORT_CONTROL_RING_BYTES 0
+#else
+#define TRANSPORT_CONTROL_RING_BYTES 256
+#endif
+#endif
+
+#ifndef TX_LANE_WRITES
+#define TX_LANE_WRITES 16
+#endif
+
+template <uint16_t Capacity>
+class TxRingBuffer {
+private:
+    uint8_t buffer[Capacity];
+    uint16_t tail = 0;      // Oldest queued byte
+    uint16_t count = 0;     // Bytes queued
+    TxStats stats = {0, 0, 0, 0, 0, Capacity};
+
+    void discard(uint16_t n) {
+        tail = (tail + n) % Capacity;
+        count -= n;
+    }
+
+public:
+    uint16_t used() const { return count; }
+    uint16_t space() const { return Capacity - count; }
+    uint16_t capacity() const { return Capacity; }
+
+    const TxStats* getStats() const { return &stats; }
+
+    void countBlocked() { stats.blockedWrites++; }
+    void countSent(size_t n) { stats.bytesSent += n; }
+
+    // Queue a write; returns the bytes accepted (0 if dropped). evicted, if
+    // given, gets the queued bytes TX_DROP_OLDEST discarded for it.
+    size_t push(const uint8_t* data, size_t len, TxOverflowPolicy policy, uint16_t* evicted = nullptr) {
+        if (evicted) *evicted = 0;
+        if (len > space()) {
+            if (policy != TX_DROP_OLDEST) {
+                stats.bytesDropped += len;
+                stats.writesDropped++;
+                return 0;
+            }
+            if (len > Capacity) {
+                // Only the newest bytes of an oversize write can be kept
+                stats.bytesDropped += len - Capacity;
+                data += len - Capacity;
+                len = Capacity;
+            }
+            uint16_t evict = len - space();
+            stats.bytesDropped += evict;
+            discard(evict);
+            if (evicted) *evicted = evict;
+        }
+
+        uint16_t head = (tail + count) % Capacity;
+        uint16_t first = Capacity - head;
+        if (first > len) first = len;
+        memcpy(buffer + head, data, first);
+        memcpy(buffer, data + first, len - first);
+        count += len;
+        if (count > stats.peakFill) stats.peakFill = count;
+        return len;
+    }
+
+    // Write up to limit queued bytes to out; returns the bytes written
+    size_t drainTo(Print& out, size_t limit) {
+        size_t total = 0;
+        while (limit > 0 && count > 0) {
+            uint16_t span = Capacity - tail;
+            if (span > count) span = count;
+            if (span > limit) span = limit;
+            size_t n = out.write(buffer + tail, span);
+            discard(n);
+            total += n;
+            limit -= n;
+            if (n < span) break;  // Port took less than it reported room for
+        }
+        stats.bytesSent += total;
+        return total;
+    }
+};
+
+// Control ring ahead of a bulk ring, switched only at bulk write boundaries
+template <uint16_t ControlBytes, uint16_t BulkBytes>
+class TxLaneRings {
+private:
+    TxRingBuffer<ControlBytes> control;
+    TxRingBuffer<BulkBytes> bulk;
+    uint16_t writeLen[TX_LANE_WRITES];  // Queued bulk writes not yet started, oldest first
+    uint8_t writeHead = 0;
+    uint8_t writeCount = 0;
+    uint16_t inFlight = 0;              // Bytes left of the bulk write being sent (0 = at a boundary)
+    uint32_t aheadOfBulk = 0;           // Control drains that went before queued bulk bytes
+
+    // The oldest queued bulk write is the one on its way
+    void startWrite() {
+        if (writeCount == 0) {
+            inFlight = bulk.used();     // Boundaries lost - the lot is one write
+            return;
+        }
+        inFlight = writeLen[writeHead];
+        writeHead = (writeHead + 1) % TX_LANE_WRITES;
+        writeCount--;
+    }
+
+    // n bulk bytes were evicted - advance the boundaries past them
+    void consumeBulk(uint16_t n) {
+        while (n > 0) {
+            if (inFlight == 0) {
+                if (writeCount == 0) return;
+                startWrite();
+            }
+            uint16_t step = (n < inFlight) ? n : inFlight;
+            inFlight -= step;
+            n -= step;
+        }
+    }
+
+public:
+    // Bytes queued in both rings
+    uint16_t used() const { return control.used() + bulk.used(); }
+
+    uint16_t controlSpace() const { return control.space(); }
+    uint16_t bulkSpace() const { return bulk.space(); }
+    uint16_t controlCapacity() const { return control.capacity(); }
+    uint16_t bulkCapacity() const { return bulk.capacity(); }
+
+    const TxStats* getControlStats() const { return control.getStats(); }
+    const TxStats* getBulkStats() const { return bulk.getStats(); }
+    uint32_t getAheadOfBulk() const { return aheadOfBulk; }
+
+    void countBlocked(TxLane lane) {
+        if (lane == TX_LANE_CONTROL) control.countBlocked();
+        else bulk.countBlocked();
+    }
+
+    void countSent(TxLane lane, size_t n) {
+        if (lane == TX_LANE_CONTROL) control.countSent(n);
+        else bulk.countSent(n);
+    }
+
+    uint16_t space(TxLane lane) const { return (lane == TX_LANE_CONTROL) ? control.space() : bulk.space(); }
+    uint16_t capacity(TxLane lane) const { return (lane == TX_LANE_CONTROL) ? control.capacity() : bulk.capacity(); }
+
+    // Queue a write on its lane; returns the bytes accepted (0 if dropped)
+    size_t push(const uint8_t* data, size_t len, TxOverflowPolicy policy, TxLane lane) {
+        if (lane == TX_LANE_CONTROL) return control.push(data, len, policy);
+
+        uint16_t evicted;
+        size_t n = bulk.push(data, len, policy, &evicted);
+        consumeBulk(evicted);
+        if (n == 0) return 0;
+        if (writeCount < TX_LANE_WRITES) {
+            writeLen[(writeHead + writeCount++) % TX_LANE_WRITES] = n;
+        } else {
+            writeLen[(writeHead + writeCount - 1) % TX_LANE_WRITES] += n;  // Merged with the newest
+        }
+        return n;
+    }
+
+    /**
+     * Write up to limit queued bytes to out - control first, whenever the bulk
+     * ring is at a write boundary
+     * @param bulkToo  false: control bytes only (a control write is still being printed)
+     * @return Bytes written
+     */
+    size_t drainTo(Print& out, size_t limit, bool bulkToo) {
+        size_t total = 0;
+        while (limit > 0) {
+            if (inFlight == 0 && control.used() > 0) {
+                if (bulk.used() > 0) aheadOfBulk++;
+                size_t n = control.drainTo(out, limit);
+                total += n;
+                limit -= n;
+                if (control.used() > 0) break;  // Port full
+                continue;
+            }
+            if (!bulkToo || bulk.used() == 0) break;
+            if (inFlight == 0) startWrite();
+            size_t want = (limit < inFlight) ? limit : inFlight;
+            size_t n = bulk.drainTo(out, want);
+            inFlight -= n;
+            total += n;
+            limit -= n;
+            if (n < want) break;
+        }
+        return total;
+    }
+};
+
+#if TRANSPORT_TX_RING_BYTES > 0
+typedef TxRingBuffer<TRANSPORT_TX_RING_BYTES> TxRing;
+#if TRANSPORT_CONTROL_RING_BYTES > 0
+typedef TxLaneRings<TRANSPORT_CONTROL_RING_BYTES, TRANSPORT_TX_RING_BYTES> TxLanes;
+#endif
+#endif // TRANSPORT_TX_RING_BYTES > 0
+
+#endif // TRANSPORT_TX_RING_H
@@ -0,0 +1,246 @@
+/*
+ * transport_ble_esp32.cpp - ESP32-S3 BLE Transport implementation
+ */
+
+#include "transport_ble_esp32.h"
+
+#if defined(CONFIG_IDF_TARGET_ESP32S3) || defined(CONFIG_IDF_TARGET_ESP32C3)
+
+#include <BLEDevice.h>
+#include <BLEServer.h>
+#include <BLE2902.h>
+#include <esp_gap_ble_api.h>
+#include <esp_idf_version.h>
+#include <new>
+#include "../static_pool.h"
+
+#define BLE_SERVICE_UUID     "6E400001-B5A3-F393-E0A9-E50E24DCCA9E"
+#define BLE_RX_UUID          "6E400002-B5A3-F393-E0A9-E50E24DCCA9E"
+#define BLE_TX_UUID          "6E400003-B5A3-F393-E0A9-E50E24DCCA9E"
+#define BLE_DATA_UUID        "6E400004-B5A3-F393-E0A9-E50E24DCCA9E"
+
+// Connection interval 7.5-15 ms (1.25 ms units), no latency, 4 s timeout (10 ms units)
+#define BLE_CONN_MIN_INTERVAL  6
+#define BLE_CONN_MAX_INTERVAL  12
+#define BLE_CONN_TIMEOUT       400
+
+#define BLE_MTU_CHECK_MS 500                // Peer MTU poll while connected
+
+// One notification being assembled (main loop only)
+static uint8_t packet[BLE_TRANSPORT_MTU - BLE_ATT_HEADER];
+
+class PacketPrint : public Print {
+public:
+    size_t len = 0;
+
+    size_t write(uint8_t c) override {
+        packet[len++] = c;
+        return 1;
+    }
+
+    size_t write(const uint8_t* buffer, size_t size) override {
+        memcpy(packet + len, buffer, size);
+        len += size;
+        return size;
+    }
+};
+
+// ========== BleNotifyChannel ==========
+
+void BleNotifyChannel::clear() {
+    PacketPrint discard;
+    while (ring.used() > 0) {
+        discard.len = 0;
+        ring.drainTo(discard, ring.used() < sizeof(packet) ? ring.used() : sizeof(packet));
+    }
+}
+
+size_t BleNotifyChannel::write(const uint8_t* data, size_t len, TxOverflowPolicy policy, uint16_t payload) {
+    if (characteristic == nullptr) return 0;
+    if (ring.used() == 0) oldestQueuedMs = millis();
+
+    if (policy == TX_BLOCK && len > ring.space()) {
+        // Hand what is queued to the stack until the write fits
+        ring.countBlocked();
+        while (len > ring.space() && ring.used() > 0) service(payload, true);
+        if (len > ring.space()) policy = TX_DROP_OLDEST;  // Bigger than the ring - keep the newest
+    }
+    size_t n = ring.push(data, len, policy);
+    service(payload, false);
+    return n;
+}
+
+void BleNotifyChannel::service(uint16_t payload, bool force) {
+    if (characteristic == nullptr) return;
+    if (payload > sizeof(packet)) payload = sizeof(packet);
+
+    uint8_t sent = 0;
+    while (ring.used() > 0 && sent < BLE_NOTIFY_PER_UPDATE) {
+        bool full = ring.used() >= payload;
+        if (!full && !force && millis() - oldestQueuedMs < BLE_TX_COALESCE_MS) break;
+
+        PacketPrint out;
+        ring.drainTo(out, full ? payload : ring.used());
+        characteristic->setValue(packet, out.len);
+        characteristic->notify();
+        sent++;
+        oldestQueuedMs = millis();  // What is left waits from now
+    }
+}
+
+// ========== Stack callbacks (BLE task) ==========
+
+class BleTransportCallbacks : public BLEServerCallbacks, public BLECharacteristicCallbacks {
+private:
+    BLETransportESP32& transport;
+
+public:
+    explicit BleTransportCallbacks(BLETransportESP32& t) : transport(t) {}
+
+    void onConnect(BLEServer* server, esp_ble_gatts_cb_param_t* param) override {
+        (void)server;
+        transport.onConnect(param->connect.remote_bda);
+    }
+
+    void onDisconnect(BLEServer* server) override {
+        (void)server;
+        transport.onDisconnect();
+        BLEDevice::startAdvertising();
+    }
+
+    void onWrite(BLECharacteristic* characteristic) override {
+        transport.onReceive(characteristic->getData(), characteristic->getLength());
+    }
+};
+
+void BLETransportESP32::onConnect(const uint8_t* address) {
+    memcpy(peerAddress, address, sizeof(peerAddress));
+    payload = BLE_ATT_DEFAULT_MTU - BLE_ATT_HEADER;  // Until the exchange completes
+    connectPending = true;
+    connected = true;
+}
+
+void BLETransportESP32::onDisconnect() {
+    connected = false;
+}
+
+void BLETransportESP32::onReceive(const uint8_t* bytes, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        uint16_t next = (rxHead + 1) % BLE_RX_BUFFER_BYTES;
+        if (next == rxTail) return;  // Full - the loop is behind
+        rxBuffer[rxHead] = bytes[i];
+        rxHead = next;
+    }
+}
+
+// Link setup once connected, then the negotiated MTU (loop side)
+void BLETransportESP32::refreshLink() {
+    if (connectPending) {
+        connectPending = false;
+        control.clear();
+        data.clear();
+        server->updateConnParams(peerAddress, BLE_CONN_MIN_INTERVAL, BLE_CONN_MAX_INTERVAL,
+                                 0, BLE_CONN_TIMEOUT);
+#if BLE_TRANSPORT_2M_PHY && defined(CONFIG_BT_BLE_50_FEATURES_SUPPORTED)
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+        esp_ble_gap_set_preferred_phy(peerAddress, 0, ESP_BLE_GAP_PHY_2M_PREF_MASK,
+                                      ESP_BLE_GAP_PHY_2M_PREF_MASK, ESP_BLE_GAP_PHY_OPTIONS_NO_PREF);
+#else
+        esp_ble_gap_set_prefered_phy(peerAddress, 0, ESP_BLE_GAP_PHY_2M_PREF_MASK,
+                                     ESP_BLE_GAP_PHY_2M_PREF_MASK, ESP_BLE_GAP_PHY_OPTIONS_NO_PREF);
+#endif
+#endif
+        mtuCheckedMs = millis() - BLE_MTU_CHECK_MS;
+    }
+
+    if (millis() - mtuCheckedMs >= BLE_MTU_CHECK_MS) {
+        mtuCheckedMs = millis();
+        uint16_t mtu = server->getPeerMTU(server->getConnId());
+        if (mtu > BLE_ATT_HEADER) payload = mtu - BLE_ATT_HEADER;
+    }
+}
+
+// ========== BLETransportESP32 ==========
+
+bool BLETransportESP32::begin() {
+    if (initialized) return true;
+
+    BLEDevice::init(deviceName);
+    BLEDevice::setMTU(BLE_TRANSPORT_MTU);
+
+    if (callbacks == nullptr) {
+        void* mem = poolAlloc(sizeof(BleTransportCallbacks), "BLE callbacks");
+        if (mem == nullptr) return false;
+        callbacks = new (mem) BleTransportCallbacks(*this);
+    }
+    server = BLEDevice::createServer();
+    server->setCallbacks(callbacks);
+
+    BLEService* service = server->createService(BLE_SERVICE_UUID);
+    BLECharacteristic* rx = service->createCharacteristic(
+        BLE_RX_UUID, BLECharacteristic::PROPERTY_WRITE | BLECharacteristic::PROPERTY_WRITE_NR);
+    rx->setCallbacks(callbacks);
+
+    BLECharacteristic* tx = service->createCharacteristic(BLE_TX_UUID, BLECharacteristic::PROPERTY_NOTIFY);
+    tx->addDescriptor(new BLE2902());
+    control.attach(tx);
+
+    BLECharacteristic* dataChar = service->createCharacteristic(BLE_DATA_UUID, BLECharacteristic::PROPERTY_NOTIFY);
+    dataChar->addDescriptor(new BLE2902());
+    data.attach(dataChar);
+
+    service->start();
+    BLEAdvertising* advertising = BLEDevice::getAdvertising();
+    advertising->addServiceUUID(BLE_SERVICE_UUID);
+    advertising->setScanResponse(true);
+    BLEDevice::startAdvertising();
+
+    initialized = true;
+    return true;
+}
+
+void BLETransportESP32::end() {
+    if (!initialized) return;
+    BLEDevice::deinit(false);
+    control.attach(nullptr);
+    data.attach(nullptr);
+    server = nullptr;
+    connected = false;
+    initialized = false;
+}
+
+void BLETransportESP32::update() {
+    if (!initialized || !connected) return;
+    refreshLink();
+    control.service(payload, false);
+}
+
+// ========== BLEDataTransportESP32 ==========
+
+size_t BLEDataTransportESP32::write(const uint8_t* buffer, size_t size, TxOverflowPolicy policy) {
+    if (!owner.initialized || !owner.connected) return 0;
+    return owner.data.write(buffer, size, policy, owner.payload);
+}
+
+void BLEDataTransportESP32::flush() {
+    if (owner.initialized && owner.connected) owner.data.service(owner.payload, true);
+}
+
+TransportState BLEDataTransportESP32::getState() const {
+    return owner.getState();
+}
+
+const TxStats* BLEDataTransportESP32::getTxStats() const {
+    return owner.data.getStats();
+}
+
+bool BLEDataTransportESP32::begin() {
+    return owner.begin();
+}
+
+void BLEDataTransportESP32::update() {
+    if (!owner.initialized || !owner.connected) return;
+    owner.data.service(owner.payload, false);
+}
+
+#endif // ESP32-S3 or ESP32-C3
@@ -1,12 +1,35 @@
 /*
  * transport_ble_esp32.h - ESP32-S3 BLE Transport
  *
- * Wraps ESP32_BleSerial into the TransportInterface abstraction.
- * Provides BLE UART service for ESP32-S3 and other BLE-only variants.
+ * BLE UART (Nordic UART Service UUIDs, as ESP32_BleSerial used - existing
+ * apps connect unchanged) for ESP32-S3 and other BLE-only variants, built on
+ * the core BLE library:
+ *
+ *   6E400002-...  RX    write         commands in
+ *   6E400003-...  TX    notify        control plane out
+ *   6E400004-...  DATA  notify        a second transport, BLE_DATA, for the
+ *                                     data plane (TRANSPORT DATA BLE_DATA)
+ *
+ * Throughput comes from few, full notifications: each characteristic's
+ * output is queued in a TX ring and sent as notifications of the negotiated
+ * MTU (less 3) once a full one is ready, or BLE_TX_COALESCE_MS after the
+ * first queued byte - not one notification per print(). On connect the
+ * transport offers a BLE_TRANSPORT_MTU MTU, asks for a short connection
+ * interval and, where the stack supports BLE 5, the 2M PHY. Ring overflow
+ * follows the plane's TxOverflowPolicy (transport_tx_ring.h).
  *
  * Usage:
  *   BLETransportESP32 ble("preOBD");
  *   router.registerTransport(TRANSPORT_ESP32_BT, &ble);
+ *   router.registerTransport(TRANSPORT_ESP32_BLE_DATA, ble.getDataTransport());
+ *
+ * Build Flags:
+ *   -D BLE_TRANSPORT_MTU=n       - MTU offered on connect (default 517)
+ *   -D BLE_TX_COALESCE_MS=n      - Longest wait for a notification to fill (default 10)
+ *   -D BLE_TX_BUFFER_BYTES=n     - TX ring per characteristic (default 1024)
+ *   -D BLE_RX_BUFFER_BYTES=n     - Received command bytes (default 256)
+ *   -D BLE_NOTIFY_PER_UPDATE=n   - Notifications per characteristic per loop (default 8)
+ *   -D BLE_TRANSPORT_2M_PHY=0    - Don't ask for the 2M PHY
  *
  * Note: Only available on ESP32-S3, ESP32-C3 (BLE-only chips)
  */
@@ -15,51 +38,186 @@
 #define TRANSPORT_BLE_ESP32_H
 
 #include "../transport_interface.h"
+#include "../transport_tx_ring.h"
 
 #if defined(CONFIG_IDF_TARGET_ESP32S3) || defined(CONFIG_IDF_TARGET_ESP32C3)
-#include <BleSerial.h>
+
+#ifndef BLE_TRANSPORT_MTU
+#define BLE_TRANSPORT_MTU 517
+#endif
+
+#ifndef BLE_TX_COALESCE_MS
+#define BLE_TX_COALESCE_MS 10
+#endif
+
+#ifndef BLE_TX_BUFFER_BYTES
+#define BLE_TX_BUFFER_BYTES 1024
+#endif
+
+#ifndef BLE_RX_BUFFER_BYTES
+#define BLE_RX_BUFFER_BYTES 256
+#endif
+
+#ifndef BLE_NOTIFY_PER_UPDATE
+#define BLE_NOTIFY_PER_UPDATE 8
+#endif
+
+#ifndef BLE_TRANSPORT_2M_PHY
+#define BLE_TRANSPORT_2M_PHY 1
+#endif
+
+#define BLE_ATT_DEFAULT_MTU 23
+#define BLE_ATT_HEADER 3                    // Notification opcode + handle
+
+class BLECharacteristic;
+class BLEServer;
+class BLETransportESP32;
+class BleTransportCallbacks;
+
+// Output of one notify characteristic: queued, then sent in full notifications
+class BleNotifyChannel {
+private:
+    TxRingBuffer<BLE_TX_BUFFER_BYTES> ring;
+    BLECharacteristic* characteristic = nullptr;
+    uint32_t oldestQueuedMs = 0;            // When the oldest unsent byte was queued
+
+public:
+    void attach(BLECharacteristic* c) { characteristic = c; }
+    void clear();
+
+    // Queue a write; returns the bytes accepted (0 if dropped)
+    size_t write(const uint8_t* data, size_t len, TxOverflowPolicy policy, uint16_t payload);
+
+    // Send full notifications, and a partial one once it has waited long enough
+    void service(uint16_t payload, bool force);
+
+    const TxStats* getStats() const { return ring.getStats(); }
+    uint16_t space() const { return ring.space(); }
+};
+
+// The DATA characteristic as a transport of its own (write-only)
+class BLEDataTransportESP32 : public TransportInterface {
+private:
+    BLETransportESP32& owner;
+
+public:
+    explicit BLEDataTransportESP32(BLETransportESP32& ble) : owner(ble) {}
+
+    size_t write(uint8_t c) override {
+        return write(&c, 1, TX_DROP_NEWEST);
+    }
+
+    size_t write(const uint8_t* buffer, size_t size) override {
+        return write(buffer, size, TX_DROP_NEWEST);
+    }
+
+    size_t write(const uint8_t* buffer, size_t size, TxOverflowPolicy policy) override;
+
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    void flush() override;
+
+    const char* getName() const override {
+        return "BLE_DATA";
+    }
+
+    uint8_t getCapabilities() const override {
+        return CAP_WRITE | CAP_BINARY;
+    }
+
+    TransportState getState() const override;
+    const TxStats* getTxStats() const override;
+
+    bool begin() override;
+    void end() override {}
+    void update() override;
+};
 
 class BLETransportESP32 : public TransportInterface {
 private:
-    BleSerial bleSerial;
+    friend class BLEDataTransportESP32;
+    friend class BleTransportCallbacks;
+
     const char* deviceName;
     bool initialized;
+    BLEServer* server;
+    BleTransportCallbacks* callbacks;
+    BLEDataTransportESP32 dataTransport;
+
+    BleNotifyChannel control;
+    BleNotifyChannel data;
+
+    // Written by the BLE task, read by the loop
+    volatile bool connected;
+    volatile bool connectPending;           // Connection parameters not requested yet
+    uint8_t peerAddress[6];
+    uint8_t rxBuffer[BLE_RX_BUFFER_BYTES];
+    volatile uint16_t rxHead;               // Next byte the BLE task writes
+    volatile uint16_t rxTail;               // Next byte the loop reads
+
+    uint16_t payload;                       // Notification size: negotiated MTU - 3
+    uint32_t mtuCheckedMs;
+
+    void onConnect(const uint8_t* address);
+    void onDisconnect();
+    void onReceive(const uint8_t* bytes, size_t len);
+    void refreshLink();
 
 public:
     BLETransportESP32(const char* name)
-        : deviceName(name), initialized(false) {}
+        : deviceName(name), initialized(false), server(nullptr), callbacks(nullptr), dataTransport(*this),
+          connected(false), connectPending(false), rxHead(0), rxTail(0),
+          payload(BLE_ATT_DEFAULT_MTU - BLE_ATT_HEADER), mtuCheckedMs(0) {}
+
+    // Transport for the DATA characteristic (TRANSPORT_ESP32_BLE_DATA)
+    TransportInterface* getDataTransport() { return &dataTransport; }
+
+    // Current notification payload (MTU - 3)
+    uint16_t getPayloadSize() const { return payload; }
 
     // ========== TransportInterface Implementation ==========
 
     size_t write(uint8_t c) override {
-        if (!initialized || !bleSerial.connected()) return 0;
-        return bleSerial.write(c);
+        return write(&c, 1, TX_BLOCK);
     }
 
     size_t write(const uint8_t* buffer, size_t size) override {
-        if (!initialized || !bleSerial.connected()) return 0;
-        return bleSerial.write(buffer, size);
+        return write(buffer, size, TX_BLOCK);
+    }
+
+    size_t write(const uint8_t* buffer, size_t size, TxOverflowPolicy policy) override {
+        if (!initialized || !connected) return 0;
+        return control.write(buffer, size, policy, payload);
     }
 
     int available() override {
-        if (!initialized) return 0;
-        return bleSerial.available();
+        uint16_t head = rxHead;
+        return (head >= rxTail) ? head - rxTail : BLE_RX_BUFFER_BYTES - rxTail + head;
     }
 
     int read() override {
-        if (!initialized) return -1;
-        return bleSerial.read();
+        if (rxTail == rxHead) return -1;
+        uint8_t c = rxBuffer[rxTail];
+        rxTail = (rxTail + 1) % BLE_RX_BUFFER_BYTES;
+        return c;
+    }
+
+    size_t readAvailable(uint8_t* buffer, size_t size) override {
+        size_t n = 0;
+        while (n < size && rxTail != rxHead) {
+            buffer[n++] = rxBuffer[rxTail];
+            rxTail = (rxTail + 1) % BLE_RX_BUFFER_BYTES;
+        }
+        return n;
     }
 
     int peek() override {
-        if (!initialized) return -1;
-        return bleSerial.peek();
+        return (rxTail == rxHead) ? -1 : rxBuffer[rxTail];
     }
 
     void flush() override {
-        if (initialized) {
-            bleSerial.flush();
-        }
+        if (initialized && connected) control.service(payload, true);
     }
 
     const char* getName() const override {
@@ -71,30 +229,20 @@ public:
     }
 
     TransportState getState() const override {
-        if (!initialized) return TRANSPORT_DISCONNECTED;
-        // Cast away const to call non-const connected() method
-        return const_cast<BleSerial&>(bleSerial).connected() ? TRANSPORT_CONNECTED : TRANSPORT_DISCONNECTED;
+        return (initialized && connected) ? TRANSPORT_CONNECTED : TRANSPORT_DISCONNECTED;
     }
 
-    bool begin() override {
-        if (!initialized) {
-            bleSerial.begin(deviceName);
-            initialized = true;
-        }
-        return initialized;
+    const TxStats* getTxStats() const override {
+        return control.getStats();
     }
 
-    void end() override {
-        if (initialized) {
-            bleSerial.end();
-            initialized = false;
-        }
+    size_t txSpace() const override {
+        return control.space();
     }
 
-    void update() override {
-        // ESP32_BleSerial handles connection management internally
-        // No housekeeping needed
-    }
+    bool begin() override;
+    void end() override;
+    void update() override;
 };
 
 #endif // ESP32-S3 or ESP32-C3
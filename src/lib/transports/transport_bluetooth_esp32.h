@@ -4,10 +4,26 @@
  * Wraps ESP32's built-in BluetoothSerial into the TransportInterface
  * abstraction. Provides Bluetooth Classic SPP (Serial Port Profile) support.
  *
+ * The loop never writes to BluetoothSerial itself: writes go into a FreeRTOS
+ * stream buffer, and a TX task pinned to the other core (BT_TX_TASK_CORE,
+ * where the Bluetooth stack runs) hands them to the stack. A slow phone or a
+ * stack hiccup stalls that task, not the sensor/alarm loop on core 1. When a
+ * write doesn't fit, TX_BLOCK waits up to BT_TX_BLOCK_MS for the task;
+ * TX_DROP_NEWEST and TX_DROP_OLDEST drop the write (only the TX task may take
+ * bytes out of the buffer, so the oldest can't be evicted from the loop).
+ * Writes without a policy behave as TX_BLOCK.
+ *
  * Usage:
  *   BluetoothTransportESP32 bt("preOBD");
  *   router.registerTransport(TRANSPORT_ESP32_BT, &bt);
  *
+ * Build Flags:
+ *   -D BT_TX_BUFFER_BYTES=n    - Stream buffer between loop and TX task (default 2048)
+ *   -D BT_TX_TASK_CORE=n       - Core the TX task is pinned to (default 0)
+ *   -D BT_TX_TASK_PRIORITY=n   - TX task priority (default 2)
+ *   -D BT_TX_TASK_STACK=n      - TX task stack bytes (default 3072)
+ *   -D BT_TX_BLOCK_MS=n        - Longest TX_BLOCK wait for room (default 50)
+ *
  * Note: Only available on original ESP32 (not S3, C3, or other BLE-only variants)
  */
 
@@ -19,6 +35,32 @@
 // Only compile for original ESP32 with Bluetooth Classic support
 #if defined(CONFIG_IDF_TARGET_ESP32) || (defined(ESP32) && !defined(CONFIG_IDF_TARGET_ESP32S3) && !defined(CONFIG_IDF_TARGET_ESP32C3))
 #include <BluetoothSerial.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/stream_buffer.h>
+
+#ifndef BT_TX_BUFFER_BYTES
+#define BT_TX_BUFFER_BYTES 2048
+#endif
+
+#ifndef BT_TX_TASK_CORE
+#define BT_TX_TASK_CORE 0
+#endif
+
+#ifndef BT_TX_TASK_PRIORITY
+#define BT_TX_TASK_PRIORITY 2
+#endif
+
+#ifndef BT_TX_TASK_STACK
+#define BT_TX_TASK_STACK 3072
+#endif
+
+#ifndef BT_TX_BLOCK_MS
+#define BT_TX_BLOCK_MS 50
+#endif
+
+#define BT_TX_CHUNK 256                     // Bytes per write to the stack
+#define BT_TX_WAKE_MS 50                    // TX task re-checks txRunning this often
 
 class BluetoothTransportESP32 : public TransportInterface {
 private:
@@ -26,20 +68,61 @@ private:
     const char* deviceName;
     bool initialized;
 
+    StreamBufferHandle_t txBuffer;
+    TaskHandle_t txTask;
+    volatile bool txRunning;                // Cleared by end() to stop the task
+    TxStats stats;                          // bytesSent is the TX task's, the rest the loop's
+
+    // TX task: buffer -> stack, on its own core
+    static void txTaskMain(void* arg) {
+        BluetoothTransportESP32* self = static_cast<BluetoothTransportESP32*>(arg);
+        uint8_t chunk[BT_TX_CHUNK];
+        while (self->txRunning) {
+            size_t n = xStreamBufferReceive(self->txBuffer, chunk, sizeof(chunk), pdMS_TO_TICKS(BT_TX_WAKE_MS));
+            if (n == 0) continue;
+            if (self->btSerial.hasClient()) {
+                self->stats.bytesSent += self->btSerial.write(chunk, n);
+            }
+        }
+        self->txTask = nullptr;
+        vTaskDelete(nullptr);
+    }
+
 public:
     BluetoothTransportESP32(const char* name)
-        : deviceName(name), initialized(false) {}
+        : deviceName(name), initialized(false), txBuffer(nullptr), txTask(nullptr), txRunning(false),
+          stats{0, 0, 0, 0, 0, BT_TX_BUFFER_BYTES} {}
 
     // ========== TransportInterface Implementation ==========
 
     size_t write(uint8_t c) override {
-        if (!initialized || !btSerial.hasClient()) return 0;
-        return btSerial.write(c);
+        return write(&c, 1, TX_BLOCK);
     }
 
     size_t write(const uint8_t* buffer, size_t size) override {
+        return write(buffer, size, TX_BLOCK);
+    }
+
+    size_t write(const uint8_t* buffer, size_t size, TxOverflowPolicy policy) override {
         if (!initialized || !btSerial.hasClient()) return 0;
-        return btSerial.write(buffer, size);
+
+        size_t n;
+        if (size <= xStreamBufferSpacesAvailable(txBuffer)) {
+            n = xStreamBufferSend(txBuffer, buffer, size, 0);
+        } else if (policy == TX_BLOCK) {
+            // Wait for the TX task to make room, but not for a stalled stack
+            stats.blockedWrites++;
+            n = xStreamBufferSend(txBuffer, buffer, size, pdMS_TO_TICKS(BT_TX_BLOCK_MS));
+            stats.bytesDropped += size - n;
+        } else {
+            stats.bytesDropped += size;
+            stats.writesDropped++;
+            return 0;
+        }
+
+        size_t queued = xStreamBufferBytesAvailable(txBuffer);
+        if (queued > stats.peakFill) stats.peakFill = queued;
+        return n;
     }
 
     int available() override {
@@ -52,14 +135,25 @@ public:
         return btSerial.read();
     }
 
+    size_t readAvailable(uint8_t* buffer, size_t size) override {
+        if (!initialized) return 0;
+        int waiting = btSerial.available();
+        if (waiting <= 0) return 0;
+        if ((size_t)waiting < size) size = waiting;
+        return btSerial.readBytes(buffer, size);
+    }
+
     int peek() override {
         if (!initialized) return -1;
         return btSerial.peek();
     }
 
     void flush() override {
-        if (initialized) {
-            btSerial.flush();
+        if (!initialized) return;
+        // Let the TX task empty the buffer (bounded - the stack may be stalled)
+        uint32_t start = millis();
+        while (!xStreamBufferIsEmpty(txBuffer) && millis() - start < BT_TX_BLOCK_MS) {
+            vTaskDelay(1);
         }
     }
 
@@ -71,6 +165,14 @@ public:
         return CAP_READ | CAP_WRITE | CAP_BINARY;
     }
 
+    const TxStats* getTxStats() const override {
+        return &stats;
+    }
+
+    size_t txSpace() const override {
+        return initialized ? xStreamBufferSpacesAvailable(txBuffer) : 0;
+    }
+
     TransportState getState() const override {
         if (!initialized) return TRANSPORT_DISCONNECTED;
         // Cast away const to call non-const hasClient() method
@@ -78,16 +180,35 @@ public:
     }
 
     bool begin() override {
-        if (!initialized) {
-            initialized = btSerial.begin(deviceName);
+        if (initialized) return true;
+        if (!btSerial.begin(deviceName)) return false;
+
+        if (txBuffer == nullptr) {
+            txBuffer = xStreamBufferCreate(BT_TX_BUFFER_BYTES, 1);
+            if (txBuffer == nullptr) {
+                btSerial.end();
+                return false;
+            }
         }
-        return initialized;
+        txRunning = true;
+        if (xTaskCreatePinnedToCore(txTaskMain, "bt_tx", BT_TX_TASK_STACK, this,
+                                    BT_TX_TASK_PRIORITY, &txTask, BT_TX_TASK_CORE) != pdPASS) {
+            txRunning = false;
+            txTask = nullptr;
+            btSerial.end();
+            return false;
+        }
+        initialized = true;
+        return true;
     }
 
     void end() override {
         if (initialized) {
-            btSerial.end();
             initialized = false;
+            txRunning = false;
+            while (txTask != nullptr) vTaskDelay(1);  // Task exits within BT_TX_WAKE_MS
+            xStreamBufferReset(txBuffer);
+            btSerial.end();
         }
     }
 
@@ -0,0 +1,118 @@
+/*
+ * transport_wifi_esp32.cpp - ESP32 Wi-Fi Transport implementation
+ */
+
+#include "transport_wifi_esp32.h"
+
+#if defined(ESP32) && defined(ENABLE_WIFI_TRANSPORT)
+
+// ========== WiFiTransportESP32 ==========
+
+bool WiFiTransportESP32::networkUp() const {
+#ifdef WIFI_SSID
+    return WiFi.status() == WL_CONNECTED;
+#else
+    return true;  // Our own access point
+#endif
+}
+
+bool WiFiTransportESP32::begin() {
+    if (initialized) return true;
+
+    WiFi.setHostname(deviceName);
+#ifdef WIFI_SSID
+    WiFi.mode(WIFI_STA);
+    WiFi.setAutoReconnect(true);
+#ifdef WIFI_PASSWORD
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+#else
+    WiFi.begin(WIFI_SSID);
+#endif
+#else
+    WiFi.mode(WIFI_AP);
+#ifdef WIFI_AP_PASSWORD
+    if (!WiFi.softAP(deviceName, WIFI_AP_PASSWORD)) return false;
+#else
+    if (!WiFi.softAP(deviceName)) return false;
+#endif
+#endif
+
+    server.begin();
+    server.setNoDelay(true);  // Responses are short lines - don't hold them for Nagle
+    initialized = true;
+    return true;
+}
+
+void WiFiTransportESP32::end() {
+    if (!initialized) return;
+    client.stop();
+    server.end();
+    WiFi.disconnect(true);
+    initialized = false;
+}
+
+void WiFiTransportESP32::update() {
+    if (!initialized) return;
+
+    // One control client; a new connection replaces a stale one
+    if (server.hasClient()) {
+        WiFiClient incoming = server.available();
+        if (client.connected()) client.stop();
+        client = incoming;
+        client.setNoDelay(true);
+    }
+}
+
+// ========== WiFiUdpTransportESP32 ==========
+
+bool WiFiUdpTransportESP32::begin() {
+    if (!owner.begin()) return false;
+    return target.fromString(WIFI_UDP_TARGET);
+}
+
+TransportState WiFiUdpTransportESP32::getState() const {
+    return (owner.initialized && owner.networkUp()) ? TRANSPORT_CONNECTED : TRANSPORT_DISCONNECTED;
+}
+
+void WiFiUdpTransportESP32::send(const uint8_t* data, size_t len) {
+    if (udp.beginPacket(target, WIFI_UDP_PORT) && udp.write(data, len) == len && udp.endPacket()) {
+        stats.bytesSent += len;
+    } else {
+        stats.bytesDropped += len;  // No route or no buffer - the stream's sequence shows the gap
+        stats.writesDropped++;
+    }
+}
+
+size_t WiFiUdpTransportESP32::write(const uint8_t* buffer, size_t size) {
+    if (getState() != TRANSPORT_CONNECTED) return 0;
+
+    // Start a new datagram rather than split a write across two
+    if (size > sizeof(datagram) - used) flush();
+    if (size > sizeof(datagram)) {
+        // Bigger than a datagram - send it in datagram-sized pieces
+        for (size_t off = 0; off < size; off += sizeof(datagram)) {
+            size_t n = size - off < sizeof(datagram) ? size - off : sizeof(datagram);
+            send(buffer + off, n);
+        }
+        return size;
+    }
+
+    if (used == 0) firstQueuedMs = millis();
+    memcpy(datagram + used, buffer, size);
+    used += size;
+    if (used > stats.peakFill) stats.peakFill = used;
+    if (used == sizeof(datagram)) flush();
+    return size;
+}
+
+void WiFiUdpTransportESP32::flush() {
+    if (used == 0) return;
+    send(datagram, used);
+    used = 0;
+}
+
+void WiFiUdpTransportESP32::update() {
+    if (used > 0 && millis() - firstQueuedMs >= WIFI_UDP_COALESCE_MS) flush();
+}
+
+#endif // ESP32 && ENABLE_WIFI_TRANSPORT
@@ -0,0 +1,199 @@
+/*
+ * transport_wifi_esp32.h - ESP32 Wi-Fi Transport
+ *
+ * Two router transports over Wi-Fi:
+ *
+ *   WIFI      TCP server (WIFI_CONTROL_PORT, one client) - commands in,
+ *             responses out; route the control plane here
+ *   WIFI_UDP  write-only UDP to WIFI_UDP_TARGET:WIFI_UDP_PORT - a multicast
+ *             group by default, so any number of laptops and dashboards on
+ *             the network receive one stream the device sends once
+ *             (TRANSPORT DATA WIFI_UDP)
+ *
+ * UDP writes are collected into datagrams of up to WIFI_UDP_DATAGRAM_BYTES
+ * and sent once full, or WIFI_UDP_COALESCE_MS after the first queued byte.
+ * A write that doesn't fit the current datagram starts the next one, so the
+ * binary frames (serial_frame.h) never straddle two datagrams and a lost
+ * datagram costs whole frames - the receiver's sequence check counts them.
+ *
+ * With WIFI_SSID set the device joins that network; without it, it starts
+ * an access point named after the device. Connection and reconnection run
+ * in the background: begin() doesn't wait for the network.
+ *
+ * Usage:
+ *   WiFiTransportESP32 wifi("preOBD");
+ *   router.registerTransport(TRANSPORT_ESP32_WIFI, &wifi);
+ *   router.registerTransport(TRANSPORT_ESP32_WIFI_UDP, wifi.getDataTransport());
+ *
+ *   python3 tools/serial_decode.py udp:239.255.0.1:5600     # Any receiver
+ *
+ * Build Flags:
+ *   -D ENABLE_WIFI_TRANSPORT        - Enable (ESP32 only)
+ *   -D WIFI_SSID=\"name\"           - Network to join (default: be an access point)
+ *   -D WIFI_PASSWORD=\"secret\"     - Its password
+ *   -D WIFI_AP_PASSWORD=\"secret\"  - Access point password (default: open; 8+ chars)
+ *   -D WIFI_CONTROL_PORT=n          - TCP control port (default 2323)
+ *   -D WIFI_UDP_TARGET=\"a.b.c.d\"  - Data destination: multicast group or host
+ *                                     (default 239.255.0.1)
+ *   -D WIFI_UDP_PORT=n              - Data destination port (default 5600)
+ *   -D WIFI_UDP_DATAGRAM_BYTES=n    - Largest datagram payload (default 1400)
+ *   -D WIFI_UDP_COALESCE_MS=n       - Longest wait for a datagram to fill (default 10)
+ */
+
+#ifndef TRANSPORT_WIFI_ESP32_H
+#define TRANSPORT_WIFI_ESP32_H
+
+#include "../transport_interface.h"
+
+#if defined(ESP32) && defined(ENABLE_WIFI_TRANSPORT)
+
+#include <WiFi.h>
+#include <WiFiUdp.h>
+
+#ifndef WIFI_CONTROL_PORT
+#define WIFI_CONTROL_PORT 2323
+#endif
+
+#ifndef WIFI_UDP_TARGET
+#define WIFI_UDP_TARGET "239.255.0.1"
+#endif
+
+#ifndef WIFI_UDP_PORT
+#define WIFI_UDP_PORT 5600
+#endif
+
+#ifndef WIFI_UDP_DATAGRAM_BYTES
+#define WIFI_UDP_DATAGRAM_BYTES 1400        // Under a 1500-byte Ethernet MTU with IP/UDP headers
+#endif
+
+#ifndef WIFI_UDP_COALESCE_MS
+#define WIFI_UDP_COALESCE_MS 10
+#endif
+
+class WiFiTransportESP32;
+
+// The UDP data stream as a transport of its own (write-only)
+class WiFiUdpTransportESP32 : public TransportInterface {
+private:
+    WiFiTransportESP32& owner;
+    WiFiUDP udp;
+    IPAddress target;
+    uint8_t datagram[WIFI_UDP_DATAGRAM_BYTES];
+    uint16_t used;
+    uint32_t firstQueuedMs;                 // When the datagram's first byte was queued
+    TxStats stats;
+
+    void send(const uint8_t* data, size_t len);
+
+public:
+    explicit WiFiUdpTransportESP32(WiFiTransportESP32& wifi)
+        : owner(wifi), used(0), firstQueuedMs(0),
+          stats{0, 0, 0, 0, 0, WIFI_UDP_DATAGRAM_BYTES} {}
+
+    size_t write(uint8_t c) override {
+        return write(&c, 1);
+    }
+
+    size_t write(const uint8_t* buffer, size_t size) override;
+
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    void flush() override;
+
+    const char* getName() const override {
+        return "WIFI_UDP";
+    }
+
+    uint8_t getCapabilities() const override {
+        return CAP_WRITE | CAP_BINARY;
+    }
+
+    TransportState getState() const override;
+
+    const TxStats* getTxStats() const override {
+        return &stats;
+    }
+
+    bool begin() override;
+    void end() override {}
+    void update() override;
+};
+
+class WiFiTransportESP32 : public TransportInterface {
+private:
+    friend class WiFiUdpTransportESP32;
+
+    const char* deviceName;
+    bool initialized;
+    WiFiServer server;
+    WiFiClient client;
+    WiFiUdpTransportESP32 dataTransport;
+
+    bool networkUp() const;
+
+public:
+    WiFiTransportESP32(const char* name)
+        : deviceName(name), initialized(false), server(WIFI_CONTROL_PORT), dataTransport(*this) {}
+
+    // Transport for the UDP data stream (TRANSPORT_ESP32_WIFI_UDP)
+    TransportInterface* getDataTransport() { return &dataTransport; }
+
+    // ========== TransportInterface Implementation ==========
+
+    size_t write(uint8_t c) override {
+        return write(&c, 1);
+    }
+
+    size_t write(const uint8_t* buffer, size_t size) override {
+        if (!initialized || !client.connected()) return 0;
+        return client.write(buffer, size);
+    }
+
+    int available() override {
+        if (!initialized || !client.connected()) return 0;
+        return client.available();
+    }
+
+    int read() override {
+        if (!initialized || !client.connected()) return -1;
+        return client.read();
+    }
+
+    size_t readAvailable(uint8_t* buffer, size_t size) override {
+        int waiting = available();
+        if (waiting <= 0) return 0;
+        if ((size_t)waiting < size) size = waiting;
+        int n = client.read(buffer, size);
+        return n > 0 ? n : 0;
+    }
+
+    int peek() override {
+        if (!initialized || !client.connected()) return -1;
+        return client.peek();
+    }
+
+    void flush() override {
+        if (initialized && client.connected()) client.flush();
+    }
+
+    const char* getName() const override {
+        return "WIFI";
+    }
+
+    uint8_t getCapabilities() const override {
+        return CAP_READ | CAP_WRITE | CAP_BINARY;
+    }
+
+    TransportState getState() const override {
+        if (!initialized) return TRANSPORT_DISCONNECTED;
+        return const_cast<WiFiClient&>(client).connected() ? TRANSPORT_CONNECTED : TRANSPORT_DISCONNECTED;
+    }
+
+    bool begin() override;
+    void end() override;
+    void update() override;
+};
+
+#endif // ESP32 && ENABLE_WIFI_TRANSPORT
+#endif // TRANSPORT_WIFI_ESP32_H
@@ -16,6 +16,7 @@
 #include <Arduino.h>
 #include "sensor_types.h"
 #include "hash.h"
+#include "generated/registry_hashes.h"
 
 // ===== UNITS INFO STRUCTURE =====
 
@@ -282,10 +283,39 @@ inline const UnitsInfo* getUnitsByIndex(uint8_t index) {
     return &UNITS_REGISTRY[index];
 }
 
+static_assert(UNITS_HASH_COUNT == NUM_UNITS, "registry_hashes.h is stale - run tools/generate_registry_enums.py");
+
+/**
+ * Index of the unit with this name or alias hash, REGISTRY_HASH_EMPTY if none
+ *
+ * One read of UNITS_HASH_SLOTS (registry_hashes.h), confirmed against the
+ * entry; a hash that isn't there (unknown name) falls back to a scan.
+ */
+inline uint8_t findUnitsIndexByHash(uint16_t hash) {
+    uint8_t slot = pgm_read_byte(&UNITS_HASH_SLOTS[REGISTRY_HASH_SLOT(hash, UNITS_HASH_SEED, UNITS_HASH_BITS)]);
+    if (slot < NUM_UNITS) {
+        const UnitsInfo* info = &UNITS_REGISTRY[slot];
+        if (hash == pgm_read_word(&info->nameHash) || hash == pgm_read_word(&info->aliasHash)) {
+            return slot;
+        }
+    }
+
+    for (uint8_t i = 0; i < NUM_UNITS; i++) {
+        const UnitsInfo* info = &UNITS_REGISTRY[i];
+        uint16_t nameHash = pgm_read_word(&info->nameHash);
+        uint16_t aliasHash = pgm_read_word(&info->aliasHash);
+
+        if (hash == nameHash || hash == aliasHash) {
+            return i;
+        }
+    }
+    return REGISTRY_HASH_EMPTY;
+}
+
 /**
- * Get UnitsInfo by hash value (O(n) linear search)
+ * Get UnitsInfo by hash value (O(1) perfect hash)
  *
- * Searches the registry for a unit with matching name hash or alias hash.
+ * Finds the unit with matching name hash or alias hash.
  * Used for parsing user input strings.
  *
  * @param hash  16-bit hash value to search for
@@ -296,42 +326,26 @@ inline const UnitsInfo* getUnitsByIndex(uint8_t index) {
  *   const UnitsInfo* info = getUnitsByHash(hash);  // Returns CELSIUS entry
  */
 inline const UnitsInfo* getUnitsByHash(uint16_t hash) {
-    for (uint8_t i = 0; i < NUM_UNITS; i++) {
-        const UnitsInfo* info = &UNITS_REGISTRY[i];
-        uint16_t nameHash = pgm_read_word(&info->nameHash);
-        uint16_t aliasHash = pgm_read_word(&info->aliasHash);
-
-        if (hash == nameHash || hash == aliasHash) {
-            return info;
-        }
-    }
-    return nullptr;
+    uint8_t i = findUnitsIndexByHash(hash);
+    return (i == REGISTRY_HASH_EMPTY) ? nullptr : &UNITS_REGISTRY[i];
 }
 
 /**
- * Get unit index by hash value (O(n) linear search)
+ * Get unit index by hash value (O(1) perfect hash)
  *
- * Searches the registry for a unit with matching name hash or alias hash.
+ * Finds the unit with matching name hash or alias hash.
  * Returns the array index (0-10).
  *
  * @param hash  16-bit hash value to search for
  * @return      Array index (0-10), or 0 (CELSIUS) if not found
  */
 inline uint8_t getUnitsIndexByHash(uint16_t hash) {
-    for (uint8_t i = 0; i < NUM_UNITS; i++) {
-        const UnitsInfo* info = &UNITS_REGISTRY[i];
-        uint16_t nameHash = pgm_read_word(&info->nameHash);
-        uint16_t aliasHash = pgm_read_word(&info->aliasHash);
-
-        if (hash == nameHash || hash == aliasHash) {
-            return i;
-        }
-    }
-    return 0;  // CELSIUS (default)
+    uint8_t i = findUnitsIndexByHash(hash);
+    return (i == REGISTRY_HASH_EMPTY) ? 0 : i;  // CELSIUS (default)
 }
 
 /**
- * Get unit index by name string (O(n) hash-based search)
+ * Get unit index by name string (O(1) hash lookup)
  *
  * Hashes the input string and searches for matching unit.
  * Case-insensitive. Returns index instead of pointer.
@@ -346,7 +360,7 @@ inline uint8_t getUnitsIndexByName(const char* name) {
 }
 
 /**
- * Get UnitsInfo by name string (O(n) hash-based search)
+ * Get UnitsInfo by name string (O(1) hash lookup)
  *
  * Hashes the input string and searches for matching unit.
  * Case-insensitive.
@@ -6,14 +6,179 @@
 #include "watchdog.h"
 #include "../hal/hal_watchdog.h"
 
+#ifdef ENABLE_TASK_WATCHDOG
+#include "message_api.h"
+#include "log_tags.h"
+#include "../hal/hal_retained.h"
+
+#define TASK_WATCH_MAGIC 0x54574447UL  // "TWDG"
+
+// Retained across the reset it causes - validated with magic + checksum
+struct TaskWatchRecord {
+    uint32_t magic;
+    char task[TASK_WATCH_NAME_LEN];   // Task that missed its deadline
+    uint32_t deadlineMs;
+    uint32_t lateMs;                  // Since its last heartbeat
+    uint32_t uptimeMs;                // When the miss was seen
+    uint8_t checksum;
+};
+
+struct TaskWatch {
+    const char* name;
+    uint32_t deadlineMs;
+    volatile uint32_t lastBeat;       // May be written from the acquisition core
+    volatile bool armed;
+};
+
+static TaskWatchRecord record HAL_RETAINED;
+static TaskWatchRecord lastReset;     // Copy of the record found at boot (magic 0 = none)
+
+static TaskWatch tasks[TASK_WATCHDOG_MAX_TASKS];
+static uint8_t numTasks = 0;
+static bool supervising = false;      // Between watchdogEnable() and watchdogDisable()
+static bool tripped = false;          // A task missed - no more feeding
+
+static uint8_t recordChecksum(const TaskWatchRecord* r) {
+    const uint8_t* bytes = (const uint8_t*)r;
+    uint8_t checksum = 0;
+    for (size_t i = 0; i < offsetof(TaskWatchRecord, checksum); i++) {
+        checksum ^= bytes[i];
+    }
+    return checksum;
+}
+
+// Write the miss to retained RAM and let the hardware watchdog run out
+static void tripWatchdog(const TaskWatch* task, uint32_t late, uint32_t now) {
+    tripped = true;
+    record.magic = TASK_WATCH_MAGIC;
+    strncpy(record.task, task->name, TASK_WATCH_NAME_LEN - 1);
+    record.task[TASK_WATCH_NAME_LEN - 1] = '\0';
+    record.deadlineMs = task->deadlineMs;
+    record.lateMs = late;
+    record.uptimeMs = now;
+    record.checksum = recordChecksum(&record);
+    hal::retainedFlush(&record, sizeof(record));
+    msg.debug.error(TAG_SYSTEM, "Task %s silent for %lu ms (deadline %lu) - watchdog reset",
+                    task->name, (unsigned long)late, (unsigned long)task->deadlineMs);
+}
+
+void initTaskWatchdog() {
+    if (HAL_HAS_RETAINED_RAM && record.magic == TASK_WATCH_MAGIC &&
+        record.checksum == recordChecksum(&record)) {
+        lastReset = record;
+        msg.debug.warn(TAG_SYSTEM, "Watchdog reset: task %s silent for %lu ms (deadline %lu)",
+                       lastReset.task, (unsigned long)lastReset.lateMs,
+                       (unsigned long)lastReset.deadlineMs);
+    } else {
+        lastReset.magic = 0;
+    }
+    memset(&record, 0, sizeof(record));  // A later reset isn't this task's
+    hal::retainedFlush(&record, sizeof(record));
+}
+
+uint8_t watchdogRegisterTask(const char* name, uint32_t deadlineMs) {
+    for (uint8_t i = 0; i < numTasks; i++) {
+        if (tasks[i].name == name) return i;  // Subsystem re-initialized
+    }
+    if (numTasks >= TASK_WATCHDOG_MAX_TASKS) {
+        msg.debug.warn(TAG_SYSTEM, "Task watchdog full - %s not watched", name);
+        return TASK_WATCH_NONE;
+    }
+    TaskWatch* task = &tasks[numTasks];
+    task->name = name;
+    task->deadlineMs = deadlineMs;
+    task->lastBeat = 0;
+    task->armed = false;
+    return numTasks++;
+}
+
+void watchdogHeartbeat(uint8_t id) {
+    if (id >= numTasks) return;
+    tasks[id].lastBeat = millis();
+    tasks[id].armed = true;
+}
+
+void watchdogTaskIdle(uint8_t id) {
+    if (id < numTasks) tasks[id].armed = false;
+}
+
+void watchdogRestartHeartbeats() {
+    for (uint8_t i = 0; i < numTasks; i++) {
+        tasks[i].armed = false;
+    }
+    tripped = false;
+}
+
+void watchdogService(uint32_t now) {
+    if (supervising && !tripped) {
+        for (uint8_t i = 0; i < numTasks; i++) {
+            const TaskWatch* task = &tasks[i];
+            if (!task->armed) continue;
+            uint32_t late = now - task->lastBeat;
+            if ((int32_t)late > (int32_t)task->deadlineMs) {  // A beat after now was read is not late
+                tripWatchdog(task, late, now);
+                break;
+            }
+        }
+    }
+    watchdogReset();
+}
+
+void printTaskWatchdogStatus() {
+    uint32_t now = millis();
+    msg.control.print(F("Task watchdog: "));
+    msg.control.println(!supervising ? F("off (CONFIG mode)") : tripped ? F("TRIPPED - resetting") : F("feeding"));
+    for (uint8_t i = 0; i < numTasks; i++) {
+        const TaskWatch* task = &tasks[i];
+        msg.control.print(F("  "));
+        msg.control.print(task->name);
+        msg.control.print(F(": deadline "));
+        msg.control.print(task->deadlineMs);
+        if (task->armed) {
+            msg.control.print(F(" ms, last beat "));
+            msg.control.print(now - task->lastBeat);
+            msg.control.println(F(" ms ago"));
+        } else {
+            msg.control.println(F(" ms, not armed"));
+        }
+    }
+    if (numTasks == 0) {
+        msg.control.println(F("  (no tasks)"));
+    }
+    msg.control.print(F("Last reset: "));
+    if (lastReset.magic == TASK_WATCH_MAGIC) {
+        msg.control.print(lastReset.task);
+        msg.control.print(F(" silent "));
+        msg.control.print(lastReset.lateMs);
+        msg.control.print(F(" ms (deadline "));
+        msg.control.print(lastReset.deadlineMs);
+        msg.control.print(F(") at "));
+        msg.control.print(lastReset.uptimeMs);
+        msg.control.println(F(" ms"));
+    } else {
+        msg.control.println(F("not a task miss"));
+    }
+}
+#endif // ENABLE_TASK_WATCHDOG
+
 void watchdogEnable(uint16_t timeout_ms) {
     hal::watchdogEnable(timeout_ms);
+#ifdef ENABLE_TASK_WATCHDOG
+    supervising = true;
+    watchdogRestartHeartbeats();
+#endif
 }
 
 void watchdogReset() {
+#ifdef ENABLE_TASK_WATCHDOG
+    if (tripped) return;  // Let the reset a task miss asked for happen
+#endif
     hal::watchdogReset();
 }
 
 void watchdogDisable() {
+#ifdef ENABLE_TASK_WATCHDOG
+    supervising = false;
+#endif
     hal::watchdogDisable();
 }
@@ -1,6 +1,38 @@
 /*
  * watchdog.h - Platform-abstracted watchdog timer
  * Provides unified interface across all supported platforms
+ *
+ * Task heartbeats (ENABLE_TASK_WATCHDOG): feeding the hardware watchdog at
+ * the top of loop() only proves the loop spins. A task can stop doing its
+ * work while the loop goes round - a CAN pump on a bus-off controller, SD
+ * writes failing fast. Critical tasks register a deadline and check in with
+ * watchdogHeartbeat() whenever they have done real work. watchdogService()
+ * then feeds the watchdog only while every armed task has checked in within
+ * its deadline. On the first miss the task's name and lateness go to
+ * reset-retained RAM (hal/hal_retained.h) and feeding stops, so the
+ * hardware watchdog resets the board; the next boot reports it (a warning,
+ * and SYSTEM WATCHDOG).
+ *
+ * A task is armed by its first heartbeat, so one that never started (no SD
+ * card, no CAN traffic yet) isn't held against the board. Entering RUN mode
+ * (watchdogEnable()) and waking from engine-off sleep disarm every task
+ * again; watchdogTaskIdle() disarms one that stops on purpose (log closed).
+ * watchdogReset() still feeds unconditionally for code that blocks on
+ * purpose (SD mount, config save) - unless a task has already missed.
+ *
+ * Usage:
+ *   uint8_t id = watchdogRegisterTask("SD_LOG", TASK_WATCHDOG_SD_MS);
+ *   watchdogHeartbeat(id);     // After a write that went through
+ *   watchdogService(now);      // Top of loop(), instead of watchdogReset()
+ *
+ * Build Flags:
+ *   -D ENABLE_TASK_WATCHDOG          - Task heartbeats (default off - loop() feeds unconditionally)
+ *   -D TASK_WATCHDOG_MAX_TASKS=n     - Registered tasks (default 6)
+ *   -D TASK_WATCHDOG_SENSORS_MS=n    - Safety input reads (default 5000)
+ *   -D TASK_WATCHDOG_SD_MS=n         - SD log writes and syncs (default 12000)
+ *   -D TASK_WATCHDOG_CAN_MS=n        - Frames received by the CAN pump (default 0 = not
+ *                                      watched - a bus that goes quiet at engine-off
+ *                                      looks the same as one that went bus-off)
  */
 
 #ifndef WATCHDOG_H
@@ -18,4 +50,60 @@ void watchdogReset();
 // Disable watchdog (use sparingly, mainly for debugging)
 void watchdogDisable();
 
+// ===== TASK HEARTBEATS =====
+
+#define TASK_WATCH_NONE 0xFF
+
+#ifdef ENABLE_TASK_WATCHDOG
+
+#ifndef TASK_WATCHDOG_MAX_TASKS
+#define TASK_WATCHDOG_MAX_TASKS 6
+#endif
+
+#ifndef TASK_WATCHDOG_SENSORS_MS
+#define TASK_WATCHDOG_SENSORS_MS 5000
+#endif
+
+#ifndef TASK_WATCHDOG_SD_MS
+#define TASK_WATCHDOG_SD_MS 12000   // Syncs come every SD_LOG_SYNC_MS (5 s)
+#endif
+
+#ifndef TASK_WATCHDOG_CAN_MS
+#define TASK_WATCHDOG_CAN_MS 0
+#endif
+
+#define TASK_WATCH_NAME_LEN 12
+
+// Report a task that missed its deadline before the last reset (setup())
+void initTaskWatchdog();
+
+// Supervise a task (name must outlive the program); TASK_WATCH_NONE if the table is full
+uint8_t watchdogRegisterTask(const char* name, uint32_t deadlineMs);
+
+// The task did its work - arms it on the first call
+void watchdogHeartbeat(uint8_t id);
+
+// The task stopped on purpose - not watched until its next heartbeat
+void watchdogTaskIdle(uint8_t id);
+
+// Disarm every task (RUN mode entered, woken from sleep)
+void watchdogRestartHeartbeats();
+
+// Feed the hardware watchdog if every armed task is within its deadline
+void watchdogService(uint32_t now);
+
+// Tasks, last heartbeats and the reset record (SYSTEM WATCHDOG)
+void printTaskWatchdogStatus();
+
+#else
+
+inline void initTaskWatchdog() {}
+inline uint8_t watchdogRegisterTask(const char*, uint32_t) { return TASK_WATCH_NONE; }
+inline void watchdogHeartbeat(uint8_t) {}
+inline void watchdogTaskIdle(uint8_t) {}
+inline void watchdogRestartHeartbeats() {}
+inline void watchdogService(uint32_t) { watchdogReset(); }
+
+#endif // ENABLE_TASK_WATCHDOG
+
 #endif
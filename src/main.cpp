@@ -10,32 +10,75 @@
 #include "version.h"
 #include "lib/platform.h"
 #include "lib/watchdog.h"
+#include "lib/scheduler.h"
+#include "lib/dual_core.h"
+#include "lib/profiler.h"
+#include "lib/latency_trace.h"
+#include "lib/raw_trace.h"
+#include "lib/loop_monitor.h"
+#include "lib/memory_report.h"
+#include "hal/hal_placement.h"
+#include "lib/timebase.h"
+#include "lib/eeprom_store.h"
+#include "lib/adc_scan.h"
+#include "inputs/sensors/thermocouples/thermocouple_batch.h"
+#ifdef ENABLE_EXT_ADC
+#include "lib/ext_adc.h"
+#endif
+#ifdef ENABLE_GPS
+#include "lib/gps.h"
+#endif
+#include "lib/modbus.h"
+#include "lib/power_manager.h"
+#include "lib/power_fail.h"
 
 #include "lib/sensor_types.h"
 #ifdef USE_STATIC_CONFIG
 #include "lib/generated/sensor_library_static.h"
+#if __has_include("lib/generated/static_read_pipeline.h") && !defined(ENABLE_TEST_MODE)
+#include "lib/generated/static_read_pipeline.h"  // Direct-call updateSensors()
+#endif
 #else
 #include "lib/sensor_library.h"
 #endif
 #include "lib/system_config.h"
 #include "lib/bus_manager.h"
+#include "lib/i2c_engine.h"
+#include "lib/device_inventory.h"
 #include "lib/serial_manager.h"
 #include "lib/pin_registry.h"
 #include "lib/sd_manager.h"
 #include "inputs/input.h"
 #include "inputs/input_manager.h"
+#include "inputs/input_filter.h"
+#include "inputs/input_health.h"
+#include "inputs/input_rate.h"
+#include "inputs/input_snapshot.h"
+#include "inputs/input_summary.h"
+#include "inputs/input_stats.h"
 #ifndef USE_STATIC_CONFIG
     #include "inputs/serial_config.h"   // Only needed for EEPROM/serial config mode
     #include "lib/system_mode.h"        // System mode (CONFIG/RUN)
-    #include "lib/button_handler.h"     // Multi-function button handler
 #endif
+#include "lib/button_handler.h"         // Multi-function button (alarm silence, display toggle)
 #include "lib/display_manager.h"        // Display runtime state management
 #ifdef ENABLE_LED
     #include "lib/rgb_led.h"
 #endif
 #include "outputs/output_base.h"
+#include "outputs/host_subscription.h"
+#ifdef ENABLE_BENCH_STREAM
+    #include "outputs/bench_stream.h"
+#endif
 #ifdef ENABLE_CAN
     #include "inputs/input_can.h"
+    #include "outputs/output_can.h"
+    #include "lib/can_rx.h"
+    #include "lib/can_tx.h"
+    #include "lib/can_node.h"
+    #ifdef ENABLE_CAN_REPLAY
+        #include "lib/can_replay.h"
+    #endif
     #ifndef USE_STATIC_CONFIG
         #include "inputs/sensors/can/can_scan.h"
     #endif
@@ -44,7 +87,9 @@
 // Transport abstraction layer
 #include "lib/message_router.h"
 #include "lib/message_api.h"
+#include "lib/response_stream.h"
 #include "lib/log_tags.h"
+#include "lib/float_format.h"
 #include "lib/transport_serial.h"
 #ifdef ESP32
 // Include appropriate Bluetooth transport for ESP32 variant
@@ -53,6 +98,9 @@
 #else
     #include "lib/transports/transport_bluetooth_esp32.h"
 #endif
+#ifdef ENABLE_WIFI_TRANSPORT
+    #include "lib/transports/transport_wifi_esp32.h"
+#endif
 #endif
 
 // Global transport instances
@@ -92,19 +140,29 @@ SerialTransport hwSerial8(&Serial8, "SERIAL8", 115200);
 #else
     BluetoothTransportESP32 btESP32("preOBD");
 #endif
+#ifdef ENABLE_WIFI_TRANSPORT
+    WiFiTransportESP32 wifiESP32("preOBD");
+#endif
 #endif
 
 // Declare output module functions
 extern void initOutputModules();
-extern void sendToOutputs(Input*);
+extern void sendToOutputs(uint32_t now, TaskPriority priority);
+extern uint32_t getNextOutputDeadline(uint32_t now, TaskPriority priority);
+extern bool outputsWantChanges(TaskPriority priority);
 extern void updateOutputs();
 
 // Declare display functions
 extern void initLCD();
-extern void updateLCD(Input**, int);
+#include "displays/lcd_layout.h"
 
 // Alarm logic module
 #include "inputs/alarm_logic.h"
+#include "inputs/alarm_journal.h"
+
+#ifdef ENABLE_RELAY_OUTPUT
+#include "outputs/output_relay.h"  // isRelayInput() for sensor priority
+#endif
 
 // Test mode (if enabled)
 #ifdef ENABLE_TEST_MODE
@@ -112,13 +170,18 @@ extern void updateLCD(Input**, int);
 #endif
 
 // ===== TIME-SLICING STATE =====
-// Tracks last execution time for each time-sliced operation
-static uint32_t lastInputRead[MAX_INPUTS];  // Per-sensor read timing
-#ifdef ENABLE_ALARMS
-static uint32_t lastAlarmCheck = 0;
+// RUN-mode work is driven by the deadline scheduler (lib/scheduler.h)
+static uint8_t sensorTaskId = INVALID_TASK_ID;     // Safety inputs (alarm/relay)
+static uint8_t auxSensorTaskId = INVALID_TASK_ID;  // All other inputs
+static uint8_t adcTaskId = INVALID_TASK_ID;        // Background ADC scan
+static uint8_t tcTaskId = INVALID_TASK_ID;         // Batched thermocouple SPI reads
+#ifdef ENABLE_EXT_ADC
+static uint8_t extAdcTaskId = INVALID_TASK_ID;     // External ADC chips
 #endif
-#ifdef ENABLE_LCD
-static uint32_t lastLCDUpdate = 0;
+static uint8_t sensorWatchId = TASK_WATCH_NONE;    // Heartbeat of the safety reads (lib/watchdog.h)
+static uint8_t outputTaskIds[NUM_TASK_PRIORITIES] = {INVALID_TASK_ID, INVALID_TASK_ID, INVALID_TASK_ID};
+#if (defined(ENABLE_LCD) || defined(ENABLE_OLED)) && !defined(USE_STATIC_CONFIG)
+static uint32_t lastLCDUpdate = 0;  // CONFIG mode display (not scheduled)
 #endif
 
 // ===== TIME-SLICED OPERATION FUNCTIONS =====
@@ -127,65 +190,306 @@ static uint32_t lastLCDUpdate = 0;
 #ifndef USE_STATIC_CONFIG
 // Update LCD display in CONFIG mode
 static void updateConfigModeDisplay(uint32_t now) {
-    #ifdef ENABLE_LCD
+    #if defined(ENABLE_LCD) || defined(ENABLE_OLED)
     if (isDisplayActive() && now - lastLCDUpdate >= LCD_UPDATE_INTERVAL_MS) {
-        static Input* inputPtrs[MAX_INPUTS];
-        uint8_t activeCount = 0;
-        for (uint8_t i = 0; i < MAX_INPUTS; i++) {
-            // In CONFIG mode, show any sensor with a valid pin (configured)
-            if (inputs[i].pin != 0xFF) {
-                inputPtrs[activeCount++] = &inputs[i];
-            }
-        }
-        updateLCD(inputPtrs, activeCount);
+        updateLCDLayout(now);  // In CONFIG mode, pages of every configured input
         lastLCDUpdate = now;
     }
     #endif
 }
 #endif
 
-// Read sensors at their individual configured intervals
-static void updateSensors(uint32_t now) {
-    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
-        if (!inputs[i].flags.isEnabled) continue;
-
-        // Get sensor-specific minimum read interval
-        const SensorInfo* sensorInfo = getSensorByIndex(inputs[i].sensorIndex);
-        uint16_t interval = sensorInfo ? pgm_read_word(&sensorInfo->minReadInterval) : SENSOR_READ_INTERVAL_MS;
-
-        // Check if enough time has elapsed for this sensor
-        if (now - lastInputRead[i] >= interval) {
-            inputs[i].readFunction(&inputs[i]);
-            lastInputRead[i] = now;
-        }
+// Input feeds a safety path (alarm evaluation or relay control)
+static bool isSafetyInput(const Input* input) {
+    if (input->flags.alarm) return true;
+    #ifdef ENABLE_RELAY_OUTPUT
+    if (isRelayInput(input - inputs)) return true;
+    #endif
+    return false;
+}
+
+// New reading differs from the old one (NaN -> NaN is not a change)
+static inline bool valueChanged(float before, float after) {
+    if (isnan(before) || isnan(after)) return isnan(before) != isnan(after);
+    return before != after;
+}
+
+// A reading is in the input: filter, stage and publish it, then advance the
+// input's deadline (shared by both pipelines, single and two-phase reads)
+HAL_HOT_CODE static inline void finishSensorRead(Input* input, uint16_t interval, uint32_t* nextDue,
+                                                 uint32_t now, float before, uint32_t readUs, bool* changed) {
+    TRACE_SAMPLE(input - inputs);
+    recordInputRead(input, now, readUs);
+    applyInputFilter(input, now);
+    recordInputSummary(input, now);
+    stageInputSample(input - inputs, input->value, now);
+    aggregateInputSample(input - inputs, input->value);
+    accumulateInputStats(input, now);
+    updateModbusRegister(input);
+    if (valueChanged(before, input->value)) {
+        input->sequence++;
+        refreshOBD2Data(input);
+        *changed = true;
+    }
+
+    // Advance from the previous deadline (no drift); resync if a full interval behind
+    // Adaptive inputs follow their signal, dead inputs are backed off
+    // (see input_rate.h, input_health.h)
+    uint16_t next = getInputHealthInterval(input, getInputRateInterval(input, interval, now));
+    *nextDue += next;
+    if ((int32_t)(now - *nextDue) >= 0) {
+        *nextDue = now + next;
     }
 }
 
-// Check alarms for all enabled inputs
-static void updateAlarms(uint32_t now) {
-    #ifdef ENABLE_ALARMS
-    if (now - lastAlarmCheck >= ALARM_CHECK_INTERVAL_MS) {
-        updateAllInputAlarms(now);  // Update alarm state for all inputs
-        lastAlarmCheck = now;
+#ifdef STATIC_READ_PIPELINE
+// Static builds with a generated pipeline: the input list, read functions and
+// intervals are known at compile time, so updateSensors() expands to one direct
+// call per input (inlinable with LTO) instead of walking inputSchedule[]
+static Input* staticInput[STATIC_INPUT_COUNT];
+static uint32_t staticNextDue[STATIC_INPUT_COUNT];
+static uint16_t (*staticStart[STATIC_INPUT_COUNT])(Input*);  // Two-phase, as in rebuildInputSchedule()
+static void (*staticComplete[STATIC_INPUT_COUNT])(Input*);
+static uint32_t staticReadyAt[STATIC_INPUT_COUNT];           // Conversion ready (0 = none running)
+
+// Two-phase functions of the input's sensor, if its read is the sensor's own
+static void resolveStaticTwoPhase(uint8_t n, void (*readFn)(Input*)) {
+    staticStart[n] = nullptr;
+    staticComplete[n] = nullptr;
+    staticReadyAt[n] = 0;
+    const SensorInfo* sensorInfo = staticInput[n] ? getSensorByIndex(staticInput[n]->sensorIndex) : nullptr;
+    if (!sensorInfo) return;
+    SensorInfo info;
+    loadSensorInfo(sensorInfo, &info);
+    if (info.startFunction && info.completeFunction && info.readFunction == readFn) {
+        staticStart[n] = info.startFunction;
+        staticComplete[n] = info.completeFunction;
     }
-    #endif
 }
 
+#define STATIC_RESOLVE_INPUT(N, readFn, interval) \
+    staticInput[N] = getInputByPin(INPUT_##N##_PIN); \
+    if (staticInput[N] != nullptr && !staticInput[N]->flags.isEnabled) staticInput[N] = nullptr; \
+    staticNextDue[N] = staticInput[N] ? getInputFirstReadTime(staticInput[N], now) : now; \
+    resolveStaticTwoPhase(N, readFn);
 
-// Update LCD display in RUN mode
-static void updateDisplay(uint32_t now) {
-    #ifdef ENABLE_LCD
-    if (isDisplayActive() && now - lastLCDUpdate >= LCD_UPDATE_INTERVAL_MS) {
-        static Input* inputPtrs[MAX_INPUTS];
-        uint8_t activeCount = 0;
-        for (uint8_t i = 0; i < MAX_INPUTS; i++) {
-            if (inputs[i].flags.isEnabled) {
-                inputPtrs[activeCount++] = &inputs[i];
+static void initStaticReadPipeline() {
+    uint32_t now = millis();
+    STATIC_INPUT_LIST(STATIC_RESOLVE_INPUT)
+}
+
+#define STATIC_START_INPUT(N, readFn, interval) \
+    if (staticStart[N] != nullptr && staticReadyAt[N] == 0 && isSafetyInput(staticInput[N]) == safety && \
+        (int32_t)(now - staticNextDue[N]) >= 0) { \
+        uint16_t convertMs; \
+        PROFILE_CALL(profInputSlot(staticInput[N] - inputs), convertMs = staticStart[N](staticInput[N])); \
+        staticReadyAt[N] = millis() + convertMs; \
+        if (staticReadyAt[N] == 0) staticReadyAt[N] = 1; \
+    }
+
+#define STATIC_READ_INPUT(N, readFn, interval) \
+    if (staticInput[N] != nullptr && isSafetyInput(staticInput[N]) == safety) { \
+        Input* input = staticInput[N]; \
+        if (staticReadyAt[N] != 0) { \
+            if ((int32_t)(clock - staticReadyAt[N]) >= 0) { \
+                float before = input->value; \
+                uint32_t readStart = micros(); \
+                PROFILE_CALL(profInputSlot(input - inputs), staticComplete[N](input)); \
+                staticReadyAt[N] = 0; \
+                finishSensorRead(input, (interval), &staticNextDue[N], now, before, micros() - readStart, changed); \
+            } else if ((int32_t)(staticReadyAt[N] - next) < 0) { \
+                next = staticReadyAt[N]; \
+            } \
+        } else if ((int32_t)(now - staticNextDue[N]) >= 0) { \
+            float before = input->value; \
+            uint32_t readStart = micros(); \
+            PROFILE_CALL(profInputSlot(input - inputs), readFn(input)); \
+            finishSensorRead(input, (interval), &staticNextDue[N], now, before, micros() - readStart, changed); \
+        } \
+        if (staticReadyAt[N] == 0 && (int32_t)(staticNextDue[N] - next) < 0) { \
+            next = staticNextDue[N]; \
+        } \
+    }
+
+// Same contract as the runtime version below, unrolled over STATIC_INPUT_LIST
+HAL_HOT_CODE static uint32_t updateSensors(uint32_t now, bool safety, bool* changed) {
+    uint32_t next = now + SENSOR_READ_INTERVAL_MS;
+    STATIC_INPUT_LIST(STATIC_START_INPUT)
+    uint32_t clock = millis();  // Conversion times run on the real clock
+    STATIC_INPUT_LIST(STATIC_READ_INPUT)
+    return next;
+}
+#else
+// Read sensors at their individual configured intervals
+// Walks the precomputed schedule (enabled inputs only, see rebuildInputSchedule())
+// and reads only the inputs in the requested class (safety or not)
+// Two-phase sensors are all started first, then the others are read while
+// they convert; each is collected on the first pass after it is ready
+// Bumps Input::sequence on every changed value; sets *changed if any did
+// Stages every reading for the output snapshot (published by the caller)
+// Returns the earliest upcoming read deadline or conversion
+HAL_HOT_CODE static uint32_t updateSensors(uint32_t now, bool safety, bool* changed) {
+    uint32_t next = now + SENSOR_READ_INTERVAL_MS;  // Re-check for new inputs if none scheduled
+
+    // Signed differences keep the comparisons correct across millis() rollover
+    for (uint8_t i = 0; i < numScheduledInputs; i++) {
+        InputSchedule* entry = &inputSchedule[i];
+        if (entry->startFunction == nullptr || entry->readyAt != 0 ||
+            isSafetyInput(entry->input) != safety || (int32_t)(now - entry->nextDue) < 0) continue;
+
+        uint16_t convertMs;
+        PROFILE_CALL(profInputSlot(entry->input - inputs), convertMs = entry->startFunction(entry->input));
+        entry->readyAt = millis() + convertMs;  // From when it really started
+        if (entry->readyAt == 0) entry->readyAt = 1;  // 0 = no conversion
+    }
+
+    uint32_t clock = millis();  // Conversion times run on the real clock
+    for (uint8_t i = 0; i < numScheduledInputs; i++) {
+        InputSchedule* entry = &inputSchedule[i];
+        if (isSafetyInput(entry->input) != safety) continue;
+
+        if (entry->readyAt != 0) {
+            if ((int32_t)(clock - entry->readyAt) >= 0) {
+                float before = entry->input->value;
+                uint32_t readStart = micros();
+                PROFILE_CALL(profInputSlot(entry->input - inputs), entry->completeFunction(entry->input));
+                entry->readyAt = 0;
+                finishSensorRead(entry->input, entry->interval, &entry->nextDue, now, before, micros() - readStart, changed);
+            } else {
+                if ((int32_t)(entry->readyAt - next) < 0) next = entry->readyAt;
+                continue;
             }
+        } else if ((int32_t)(now - entry->nextDue) >= 0) {
+            float before = entry->input->value;
+            uint32_t readStart = micros();
+            PROFILE_CALL(profInputSlot(entry->input - inputs), entry->readFunction(entry->input));
+            finishSensorRead(entry->input, entry->interval, &entry->nextDue, now, before, micros() - readStart, changed);
+        }
+        if ((int32_t)(entry->nextDue - next) < 0) {
+            next = entry->nextDue;
+        }
+    }
+    return next;
+}
+#endif // STATIC_READ_PIPELINE
+
+// ===== SCHEDULED TASKS =====
+
+// Pull change-driven output tasks forward so new values go out this iteration
+// (output tasks are registered after the sensor tasks of their class)
+static void wakeChangeDrivenOutputs(uint32_t now) {
+    for (uint8_t cls = 0; cls < NUM_TASK_PRIORITIES; cls++) {
+        if (outputTaskIds[cls] != INVALID_TASK_ID && outputsWantChanges((TaskPriority)cls)) {
+            setTaskDeadline(outputTaskIds[cls], now);
         }
-        updateLCD(inputPtrs, activeCount);
-        lastLCDUpdate = now;
     }
+}
+
+static void adcTask(uint32_t now) {
+    // Stays due while a scan pass is converting, then waits for the next pass
+    setTaskDeadline(adcTaskId, updateAdcScan(now));
+}
+
+static void thermocoupleTask(uint32_t now) {
+    // All due thermocouples in one SPI transaction, then wait for the next conversion
+    setTaskDeadline(tcTaskId, updateThermocoupleBatch(now));
+}
+
+#ifdef ENABLE_EXT_ADC
+static void extAdcTask(uint32_t now) {
+    // MCP3208 batch on its interval, ADS1115 samples as they finish
+    setTaskDeadline(extAdcTaskId, updateExtAdc(now));
+}
+#endif
+
+static void sensorTask(uint32_t now) {
+    bool changed = false;
+    // Per-input intervals - wake again when the next input is due
+    setTaskDeadline(sensorTaskId, updateSensors(now, true, &changed));
+    watchdogHeartbeat(sensorWatchId);
+    publishInputSnapshot();  // The pass's readings reach the outputs together
+    if (changed) wakeChangeDrivenOutputs(now);
+}
+
+static void auxSensorTask(uint32_t now) {
+    bool changed = false;
+    setTaskDeadline(auxSensorTaskId, updateSensors(now, false, &changed));
+    publishInputSnapshot();
+    if (changed) wakeChangeDrivenOutputs(now);
+}
+
+#ifdef ENABLE_ALARMS
+static void alarmTask(uint32_t now) {
+    PROFILE_CALL(PROF_ALARMS, updateAllInputAlarms(now));  // Update alarm state for all inputs
+}
+#endif
+
+// One output task per priority class so telemetry and cosmetic outputs can be
+// shed without holding back the alarm/relay modules
+static void runOutputClass(uint32_t now, TaskPriority priority) {
+    sendToOutputs(now, priority);  // Data-driven time-sliced output sending
+    // Per-module intervals - wake again when the next module is due
+    setTaskDeadline(outputTaskIds[priority], getNextOutputDeadline(now, priority));
+}
+
+static void safetyOutputTask(uint32_t now)    { runOutputClass(now, PRIORITY_SAFETY); }
+#if HOST_SUBSCRIPTIONS
+// Host subscriptions ride the telemetry class - wake for whichever is due first
+static void telemetryOutputTask(uint32_t now) {
+    sendToOutputs(now, PRIORITY_TELEMETRY);
+    uint32_t next = getNextOutputDeadline(now, PRIORITY_TELEMETRY);
+    uint32_t host = updateHostSubscriptions(now);
+    if ((int32_t)(host - next) < 0) next = host;
+    setTaskDeadline(outputTaskIds[PRIORITY_TELEMETRY], next);
+    #ifdef ENABLE_POWER_MANAGER
+    notePowerOutput(millis());  // Time-to-first-data after a wake
+    #endif
+}
+#else
+static void telemetryOutputTask(uint32_t now) {
+    runOutputClass(now, PRIORITY_TELEMETRY);
+    #ifdef ENABLE_POWER_MANAGER
+    notePowerOutput(millis());  // Time-to-first-data after a wake
+    #endif
+}
+#endif
+static void cosmeticOutputTask(uint32_t now)  { runOutputClass(now, PRIORITY_COSMETIC); }
+
+#if defined(ENABLE_LCD) || defined(ENABLE_OLED)
+// Update LCD display in RUN mode
+static void displayTask(uint32_t now) {
+    if (!isDisplayActive()) return;
+    PROFILE_CALL(PROF_LCD, updateLCDLayout(now));  // Current page, alarms pinned
+}
+#endif
+
+// Register RUN-mode work with the scheduler. Classes run safety-first; within
+// a class registration order breaks ties, so inputs are read before alarms are
+// evaluated and outputs are sent.
+static void initScheduledTasks() {
+    adcTaskId = addScheduledTask("ADC", adcTask, ADC_SCAN_INTERVAL_MS, PRIORITY_SAFETY);
+    tcTaskId = addScheduledTask("TC_SPI", thermocoupleTask, TC_BATCH_IDLE_MS, PRIORITY_SAFETY);
+    #ifdef ENABLE_EXT_ADC
+    extAdcTaskId = addScheduledTask("EXT_ADC", extAdcTask, EXT_ADC_IDLE_MS, PRIORITY_SAFETY);
+    #endif
+    sensorTaskId = addScheduledTask("SENSORS", sensorTask, SENSOR_READ_INTERVAL_MS, PRIORITY_SAFETY);
+    #ifdef ENABLE_TASK_WATCHDOG
+    sensorWatchId = watchdogRegisterTask("SENSORS", TASK_WATCHDOG_SENSORS_MS);
+    #endif
+    #ifdef ENABLE_ALARMS
+    addScheduledTask("ALARMS", alarmTask, ALARM_CHECK_INTERVAL_MS, PRIORITY_SAFETY);
+    #endif
+    outputTaskIds[PRIORITY_SAFETY] =
+        addScheduledTask("OUT_SAFE", safetyOutputTask, 100, PRIORITY_SAFETY);
+
+    auxSensorTaskId = addScheduledTask("SENS_AUX", auxSensorTask, SENSOR_READ_INTERVAL_MS, PRIORITY_TELEMETRY);
+    outputTaskIds[PRIORITY_TELEMETRY] =
+        addScheduledTask("OUT_TELEM", telemetryOutputTask, CAN_OUTPUT_INTERVAL_MS, PRIORITY_TELEMETRY);
+
+    outputTaskIds[PRIORITY_COSMETIC] =
+        addScheduledTask("OUT_COSM", cosmeticOutputTask, SERIAL_CSV_INTERVAL_MS, PRIORITY_COSMETIC);
+    #if defined(ENABLE_LCD) || defined(ENABLE_OLED)
+    addScheduledTask("DISPLAY", displayTask, DISPLAY_REFRESH_MS, PRIORITY_COSMETIC);
     #endif
 }
 
@@ -195,14 +499,24 @@ static void updateTestMode_Wrapper() {
     if (isTestModeActive()) {
         updateTestMode();
     }
+    updateTestCertify();  // Last, so the pass it measures is nearly all of loop()
     #endif
 }
 
 void setup() {
+    // Paint free RAM for the stack high-water mark - before the stack gets deep
+    initMemoryReport();
+    notePlacement(F("loop()"), (const void*)loop);
+    notePlacement(F("updateSensors()"), (const void*)updateSensors);
+    notePlacement(F("updateInputAlarmState()"), (const void*)updateInputAlarmState);
+    notePlacement(F("inputs[]"), inputs);
+    notePlacement(F("printMemoryReport()"), (const void*)printMemoryReport);
 
     // Initialize serial for debugging
-    Serial.begin(115200);
-    while (!Serial && millis() < 3000) {};  // Wait up to 3 seconds for serial
+    Serial.begin(115200);  // USB host wait happens later, overlapping bus/sensor init
+
+    // RAM image of the EEPROM config area - before anything reads it
+    initEEPROMStore();
 
     // Initialize system config (loads from EEPROM or uses defaults from config.h)
     // MUST happen before router.begin() so router can load correct transport mappings
@@ -218,6 +532,16 @@ void setup() {
     // Register system pins in the pin registry
     registerSystemPins();
 
+    initTimebase();  // PPS interrupt (TIME_PPS_PIN)
+
+    #ifdef ENABLE_GPS
+    initGps();  // Claims its serial port before the transports get theirs
+    #endif
+    initModbus();  // So does the Modbus RTU slave
+    #ifdef ENABLE_POWER_MANAGER
+    initPowerManager();  // Ignition sense pin
+    #endif
+
     // Initialize configured serial ports based on SystemConfig.serial
     // This replaces the old hardcoded Serial1.begin() / Serial2.begin() calls
     initConfiguredSerialPorts();
@@ -255,12 +579,28 @@ void setup() {
 #ifdef ESP32
     if (btESP32.begin()) {
         router.registerTransport(TRANSPORT_ESP32_BT, &btESP32);
+#if defined(CONFIG_IDF_TARGET_ESP32S3) || defined(CONFIG_IDF_TARGET_ESP32C3)
+        router.registerTransport(TRANSPORT_ESP32_BLE_DATA, btESP32.getDataTransport());
+#endif
         msg.debug.info(TAG_BT, "ESP32 Bluetooth initialized");
     } else {
         msg.debug.warn(TAG_BT, "ESP32 Bluetooth failed to initialize");
     }
+#ifdef ENABLE_WIFI_TRANSPORT
+    if (wifiESP32.begin() && wifiESP32.getDataTransport()->begin()) {
+        router.registerTransport(TRANSPORT_ESP32_WIFI, &wifiESP32);
+        router.registerTransport(TRANSPORT_ESP32_WIFI_UDP, wifiESP32.getDataTransport());
+        msg.debug.info(TAG_SYSTEM, "ESP32 Wi-Fi initialized");
+    } else {
+        msg.debug.warn(TAG_SYSTEM, "ESP32 Wi-Fi failed to initialize");
+    }
+#endif
 #endif
     router.begin();  // Load config from EEPROM
+
+    // Recover loop overrun history from before a watchdog/software reset
+    initLoopMonitor();
+    initTaskWatchdog();  // And the task that missed its heartbeat, if that was the reset
     msg.control.println();
     msg.control.println(F("                 ____  ___  ___  "));
     msg.control.println(F("   ___  _______ / __ \\/ _ )/ _ \\ "));
@@ -275,12 +615,17 @@ void setup() {
 
     // Configure ADC for this platform
     setupADC();
+    initAdcScan();
     msg.debug.info(TAG_ADC, "ADC configured");
 
     // Initialize configured buses (I2C, SPI, CAN) based on SystemConfig
     // This replaces the old hardcoded Wire.begin() and SPI.begin() calls
     initConfiguredBuses();
 
+    #ifdef ENABLE_EXT_ADC
+    initExtAdc();  // External ADC chips on the buses just brought up
+    #endif
+
     // Initialize CAN input subsystem (if enabled)
     #ifdef ENABLE_CAN
     if (initCANInput()) {
@@ -297,16 +642,20 @@ void setup() {
 #else
     initInputManager();
 #endif
+    commitDeviceInventory();  // What the boot probes found, for the next boot
+
+    #ifdef ENABLE_ALARMS
+    initAlarmJournal();  // Find the head of the event ring after the system config
+    #endif
+    initInputStats();    // Accumulator totals from the ring after the journal
 
     // Initialize display
-    #ifdef ENABLE_LCD
+    #if defined(ENABLE_LCD) || defined(ENABLE_OLED)
     initLCD();
     #endif
 
-#ifndef USE_STATIC_CONFIG
-    // Initialize button handler (only in EEPROM mode)
+    // Button service - alarm silence and the display toggle subscribe to it
     initButtonHandler();
-#endif
 
     // Initialize display manager (works in both static and EEPROM modes)
     // In static mode, this is a no-op (always returns true for isDisplayActive)
@@ -319,22 +668,34 @@ void setup() {
 
     // Initialize output modules
     initOutputModules();
+    #ifdef ENABLE_POWER_FAIL
+    initPowerFail();  // Supply sense - the SD log and journals it flushes are up
+    #endif
+    #ifdef ENABLE_CAN
+    initCANNodes();  // Node protocol on the CAN output bus, once it's up
+    #endif
 
-    // Wait for sensors to stabilize
-    msg.debug.info(TAG_SENSOR, "Waiting for sensors to stabilize...");
-    delay(1000);  // Increased from 500ms - MAX6675 needs ~220ms for first conversion
+    // Give a USB host whatever is left of the wait window - init above already
+    // used part of it, and sensor warm-ups (setInputWarmup) run meanwhile
+    while (!Serial && millis() < USB_SERIAL_WAIT_MS) {}
 
-    // Initialize per-sensor read timers (all start at 0)
-    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
-        lastInputRead[i] = 0;
-    }
+    // Start the read schedule from now - each input goes live on the next pass,
+    // or once its sensor's warm-up has elapsed
+    rebuildInputSchedule();
+#ifdef STATIC_READ_PIPELINE
+    initStaticReadPipeline();
+#endif
+    initScheduledTasks();
 
     msg.debug.info(TAG_SYSTEM, "Initialization complete!");
 #ifdef USE_STATIC_CONFIG
     msg.debug.info(TAG_CONFIG, "Mode: Compile-Time Config");
     msg.debug.info(TAG_CONFIG, "Active inputs: %d", numActiveInputs);
-    msg.debug.info(TAG_CONFIG, "System voltage: %.1fV", SYSTEM_VOLTAGE);
-    msg.debug.info(TAG_CONFIG, "ADC reference: %.2fV", AREF_VOLTAGE);
+    char volts[FLOAT_FORMAT_SIZE];  // No printf float support needed
+    formatFixed(volts, SYSTEM_VOLTAGE, 1);
+    msg.debug.info(TAG_CONFIG, "System voltage: %sV", volts);
+    formatFixed(volts, AREF_VOLTAGE, 2);
+    msg.debug.info(TAG_CONFIG, "ADC reference: %sV", volts);
     msg.debug.info(TAG_CONFIG, "ADC resolution: %d bits", ADC_RESOLUTION);
     msg.debug.info(TAG_CONFIG, "ADC max value: %d", ADC_MAX_VALUE);
 #endif
@@ -387,38 +748,73 @@ void setup() {
     watchdogEnable(2000);
     msg.debug.info(TAG_SYSTEM, "Watchdog enabled (2s timeout)");
 #endif
+
+#ifdef ENABLE_DUAL_CORE
+    // Safety class (reads, alarms, relays) to the other core; loop() keeps the rest
+    if (startAcquisitionCore()) {
+        msg.debug.info(TAG_SYSTEM, "Acquisition on core %d, communications on core %d",
+                       DUAL_CORE_ACQ_CORE, ARDUINO_RUNNING_CORE);
+    } else {
+        msg.debug.warn(TAG_SYSTEM, "Acquisition task failed to start - single-core loop");
+    }
+#endif
 }
 
-void loop() {
+HAL_HOT_CODE void loop() {
     // Get current time once per loop
     uint32_t now = millis();
+    uint32_t loopStart = PROFILE_TIMESTAMP();
+    loopMonitorStart();
+
+    // Reset watchdog at start of every loop iteration, if every watched task
+    // has checked in (lib/watchdog.h)
+    // (dual-core: only while the acquisition core is also completing passes)
+#ifdef ENABLE_DUAL_CORE
+    if (acquisitionCoreAlive()) watchdogService(now);
+#else
+    watchdogService(now);
+#endif
 
-    // Reset watchdog at start of every loop iteration
-    watchdogReset();
+    // Supply failing: SD log closed, journals written, parked here until it's back
+    #ifdef ENABLE_POWER_FAIL
+    if (updatePowerFail(now)) return;
+    #endif
 
     // Update transport router (poll transports, handle housekeeping, process commands)
-    router.update();  // Now handles command input from ALL transports
+    loopMonitorMark("ROUTER");
+    PROFILE_CALL(PROF_ROUTER, router.update());  // Now handles command input from ALL transports
+    updateResponse();        // A long command answer (LIST SENSORS, DUMP JSON), a piece per loop
+    updateEEPROMStore(now);  // Bytes changed by SAVE, written a few per loop (CONFIG mode too)
+    updateI2CEngine();       // Slices of queued I2C jobs (LCD redraws), CONFIG mode too
+    updateInputStats(now);   // Accumulator snapshots into EEPROM, CONFIG mode too (STATS RESET)
+    #ifdef ENABLE_GPS
+    updateGps(now);          // Parse what the receiver sent, CONFIG mode too (BUS GPS, clock)
+    #endif
+    updateModbus(micros());  // Answer the Modbus master, CONFIG mode too
+    updateTimebase();        // PPS and RTC edges into the UTC mapping, keeps micros64() unwrapped
+
+    // Queued button edges to their subscribers (press = silence alarm, hold = toggle display)
+    loopMonitorMark("BUTTON");
+    updateButtonHandler();
 
 #ifndef USE_STATIC_CONFIG
     // NOTE: processSerialCommands() is now deprecated - router.update() handles it
     // Kept for reference but does nothing (see serial_config.cpp)
 
-    // Process button events (short press = silence alarm, long press = toggle display)
-    ButtonPress buttonEvent = updateButtonHandler();
-    if (buttonEvent == BUTTON_SHORT_PRESS) {
-        // Short press handled by alarm system (already reads the button)
-        // No action needed here
-    } else if (buttonEvent == BUTTON_LONG_PRESS) {
-        // Long press toggles display
-        toggleDisplayRuntime();
-    }
-
     // If in CONFIG mode, skip sensor reading and outputs
     if (isInConfigMode()) {
+        loopMonitorMark("CONFIG");
+        #ifdef ENABLE_TEST_MODE
+        if (isTestCertifyActive()) stopTestCertify();  // Certification is a RUN mode load test
+        #endif
         #ifdef ENABLE_CAN
+        #ifdef ENABLE_CAN_REPLAY
+        if (isCANReplayActive()) stopCANReplay();  // Replay is a RUN mode load test
+        #endif
         // Update CAN input during scan to populate cache
         if (getCANScanState() == SCAN_LISTENING) {
             updateCANInput();  // Populate frame cache during scan
+            pumpCANRx();
         }
         updateCANScan();  // Update CAN scan state machine if active
         #endif
@@ -427,24 +823,59 @@ void loop() {
     }
 #endif
 
+    // Engine off long enough: sleep here until ignition, CAN or serial activity
+    // (woken: the next pass starts on a fresh loop budget with everything due)
+    #ifdef ENABLE_POWER_MANAGER
+    if (updatePowerManager(now)) return;
+    #endif
+
     // Read sensors, check alarms, send outputs, update display
+    #ifdef ENABLE_RAW_TRACE
+    updateRawTrace();    // Due replay records ahead of the reads, recorded sectors to the card
+    #endif
     #ifdef ENABLE_CAN
-    updateCANInput();  // Poll CAN bus and populate frame cache
+    loopMonitorMark("CAN_INPUT");
+    updateCANInput();
+    #ifdef ENABLE_CAN_REPLAY
+    updateCANReplay();  // Due log frames, injected ahead of the pump
+    #endif
+    PROFILE_CALL(PROF_CAN_INPUT, pumpCANRx());  // Read each CAN bus once, dispatch to input cache and OBD responder
+    updateCANOutput();  // Rest of a multi-frame OBD-II response
+    updateCANNodes();   // Heartbeat, channel table, values, NODE:n imports
+    updateCANScan();  // SCAN CAN also runs alongside normal operation
+    #endif
+    runScheduler(now);   // Sensors, alarms, outputs, display - whichever are due
+    #ifdef ENABLE_BENCH_STREAM
+    loopMonitorMark("BENCH");
+    updateBenchStream(now);  // Timer-sampled ADC ring out as data plane blocks
     #endif
-    updateSensors(now);
-    updateAlarms(now);
-    sendToOutputs(now);  // Data-driven time-sliced output sending
-    updateDisplay(now);
+    #ifdef ENABLE_CAN
+    pumpCANTx();         // Broadcast frames queued by this pass, retries
+    #endif
+    loopMonitorMark("OUT_UPDATE");
     updateOutputs();     // Housekeeping: drain buffers, handle RX
+    #ifdef ENABLE_ALARMS
+    updateAlarmJournal(now);  // A few bytes of queued alarm events into EEPROM
+    #endif
 
     // Update RGB LED effects (non-blocking)
+    // Cosmetic - skipped while the loop is over budget
     #ifdef ENABLE_LED
-    updateRGBLed();
+    if (!shouldShedPriority(PRIORITY_COSMETIC)) {
+        loopMonitorMark("LED");
+        updateRGBLed();
+    }
     #endif
 
     // Update test mode if active
+    loopMonitorMark("TEST_MODE");
     updateTestMode_Wrapper();
 
-    // NO DELAY - loop runs as fast as possible
-    // Time-slicing controls when operations execute
+    loopMonitorEnd();
+
+    PROFILE_RECORD(PROF_LOOP, loopStart);  // RUN-mode work only, excludes idle
+
+    // NO DELAY - the scheduler controls when operations execute
+    // With ENABLE_LOOP_IDLE the CPU sleeps until the next interrupt when nothing is due
+    schedulerIdle();
 }
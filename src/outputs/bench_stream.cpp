@@ -0,0 +1,291 @@
+/*
+ * bench_stream.cpp - High-rate ADC streaming implementation
+ */
+
+#include "bench_stream.h"
+
+#ifdef ENABLE_BENCH_STREAM
+
+#include "serial_frame.h"
+#include "packed_signal.h"
+#include "../inputs/input_manager.h"
+#include "../inputs/input_snapshot.h"
+#include "../lib/adc_scan.h"
+#include "../lib/platform.h"
+#include "../lib/scheduler.h"
+#include "../lib/message_api.h"
+#include "../hal/hal_sample_timer.h"
+#include "../hal/hal_placement.h"
+#include "../lib/isr_profile.h"
+
+#define BENCH_FRAME_DESCRIPTION  'S'
+#define BENCH_FRAME_BLOCK        'B'
+#define BENCH_VERSION            1
+
+#define BENCH_BLOCK_HEADER       3      // Lost (uint16) + sample count
+#define BENCH_INPUT_ENTRY        16     // Slot, pin, name[8], units[6]
+
+static_assert(BENCH_STREAM_BLOCK_BYTES >= SERIAL_FRAME_OVERHEAD + 7 + ADC_SCAN_MAX_PINS +
+              MAX_INPUTS * BENCH_INPUT_ENTRY, "Bench block too small for the description");
+static_assert(BENCH_STREAM_RING_BYTES / 6 <= 0xFFFF, "Bench ring indices are 16-bit");
+
+// Sample ring, filled by the timer ISR: micros() then counts per channel
+HAL_DMA_BUFFER static uint8_t ring[BENCH_STREAM_RING_BYTES];
+static uint16_t entrySize = 0;
+static uint16_t ringEntries = 0;
+static volatile uint16_t ringHead = 0;      // Next entry the ISR writes
+static volatile uint16_t ringTail = 0;      // Next entry the loop sends
+static volatile uint16_t lostSamples = 0;   // Dropped with the ring full (wraps)
+
+static uint8_t pins[ADC_SCAN_MAX_PINS];
+static uint8_t numPins = 0;
+static uint8_t slots[MAX_INPUTS];           // Inputs whose values go in each block
+static uint8_t numSlots = 0;
+
+static bool active = false;
+static uint16_t rate = 0;
+static uint8_t samplesPerBlock = 0;
+static uint16_t lostReported = 0;
+static uint32_t lastBlockMs = 0;
+static uint32_t lastDescribeMs = 0;
+
+// Statistics since the start
+static uint32_t samplesSent = 0;
+static uint32_t samplesLost = 0;
+static uint32_t blocksSent = 0;
+static uint32_t bytesSent = 0;
+static uint16_t peakFill = 0;
+
+static uint8_t block[BENCH_STREAM_BLOCK_BYTES];
+
+HAL_ISR static void takeSample() {
+    uint16_t head = ringHead;
+    uint16_t next = (head + 1 == ringEntries) ? 0 : head + 1;
+    if (next == ringTail) {
+        lostSamples++;  // Ring full - the loop is behind
+        return;
+    }
+
+    uint8_t* entry = &ring[(uint32_t)head * entrySize];
+    uint32_t us = micros();
+    memcpy(entry, &us, 4);
+    for (uint8_t c = 0; c < numPins; c++) {
+        uint16_t counts = analogRead(pins[c]);
+        memcpy(entry + 4 + 2 * c, &counts, 2);
+    }
+    ringHead = next;
+}
+
+HAL_ISR static void benchSampleIsr() {
+    ISR_PROFILE_BEGIN();
+    takeSample();
+    ISR_PROFILE_END(ISR_PROF_SAMPLE_TIMER);
+}
+
+static uint16_t ringFill() {
+    uint16_t head = ringHead;
+    uint16_t tail = ringTail;
+    return (head >= tail) ? head - tail : ringEntries - tail + head;
+}
+
+static void sendFrame(uint8_t type, uint16_t len) {
+    uint16_t total = buildSerialFrame(block, type, len);
+    msg.data.write(block, total);
+    bytesSent += total;
+}
+
+static void sendDescription() {
+    uint8_t* p = block + SERIAL_FRAME_HEADER;
+    *p++ = BENCH_VERSION;
+    *p++ = rate & 0xFF;
+    *p++ = rate >> 8;
+    *p++ = ADC_RESOLUTION;
+    *p++ = numPins;
+    memcpy(p, pins, numPins);
+    p += numPins;
+    *p++ = numSlots;
+    for (uint8_t k = 0; k < numSlots; k++) {
+        const Input& input = inputs[slots[k]];
+        memset(p, 0, BENCH_INPUT_ENTRY);
+        p[0] = slots[k];
+        p[1] = input.pin;
+        strncpy((char*)p + 2, input.abbrName, 8);
+        strncpy_P((char*)p + 10, (const char*)getPackedUnits(input.measurementType), 6);
+        p += BENCH_INPUT_ENTRY;
+    }
+    sendFrame(BENCH_FRAME_DESCRIPTION, p - (block + SERIAL_FRAME_HEADER));
+}
+
+// One block frame of up to count samples from the tail of the ring
+static void sendBlock(uint16_t count) {
+    if (count > samplesPerBlock) count = samplesPerBlock;
+
+    uint16_t lost = lostSamples;
+    uint16_t lostNow = lost - lostReported;
+    lostReported = lost;
+    samplesLost += lostNow;
+
+    uint8_t* p = block + SERIAL_FRAME_HEADER;
+    *p++ = lostNow & 0xFF;
+    *p++ = lostNow >> 8;
+    *p++ = count;
+
+    uint16_t tail = ringTail;
+    const uint8_t* newest = nullptr;
+    for (uint16_t k = 0; k < count; k++) {
+        newest = &ring[(uint32_t)tail * entrySize];
+        memcpy(p, newest, entrySize);
+        p += entrySize;
+        tail = (tail + 1 == ringEntries) ? 0 : tail + 1;
+    }
+    ringTail = tail;  // Copied out - the ISR may reuse the entries
+
+    // The sensor pipeline reads the newest conversion of each pin
+    for (uint8_t c = 0; c < numPins; c++) {
+        uint16_t counts;
+        memcpy(&counts, newest + 4 + 2 * c, 2);
+        putAdcCounts(c, counts);
+    }
+
+    const InputSample* samples = getInputSnapshot().samples;
+    for (uint8_t k = 0; k < numSlots; k++) {
+        memcpy(p, &samples[slots[k]].value, 4);
+        p += 4;
+    }
+
+    sendFrame(BENCH_FRAME_BLOCK, p - (block + SERIAL_FRAME_HEADER));
+    samplesSent += count;
+    blocksSent++;
+}
+
+static void drainRing() {
+    uint16_t fill;
+    while ((fill = ringFill()) > 0) sendBlock(fill);
+}
+
+BenchStartResult startBenchStream(uint16_t rateHz) {
+    if (!HAL_HAS_SAMPLE_TIMER) return BENCH_NO_TIMER;
+    if (rateHz == 0 || rateHz > BENCH_STREAM_MAX_RATE_HZ) return BENCH_BAD_RATE;
+    if (active) stopBenchStream();
+
+    numPins = getAdcScanPins(pins);
+    if (numPins == 0) return BENCH_NO_CHANNELS;
+
+    numSlots = 0;
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        if (inputs[i].flags.isEnabled) slots[numSlots++] = i;
+    }
+
+    entrySize = 4 + 2 * numPins;
+    uint16_t room = BENCH_STREAM_BLOCK_BYTES - SERIAL_FRAME_OVERHEAD - BENCH_BLOCK_HEADER - 4 * numSlots;
+    uint16_t fit = room / entrySize;
+    if (fit == 0) return BENCH_TOO_WIDE;
+    samplesPerBlock = fit > 255 ? 255 : fit;
+    ringEntries = BENCH_STREAM_RING_BYTES / entrySize;
+
+    ringHead = 0;
+    ringTail = 0;
+    lostSamples = 0;
+    lostReported = 0;
+    samplesSent = 0;
+    samplesLost = 0;
+    blocksSent = 0;
+    bytesSent = 0;
+    peakFill = 0;
+    rate = rateHz;
+
+    suspendAdcScan(true);
+    if (!hal::sampleTimerBegin(benchSampleIsr, 1000000UL / rateHz)) {
+        suspendAdcScan(false);
+        return BENCH_NO_TIMER;
+    }
+    pausePriority(PRIORITY_COSMETIC, true);
+    active = true;
+
+    uint32_t now = millis();
+    sendDescription();
+    lastDescribeMs = now;
+    lastBlockMs = now;
+    return BENCH_STARTED;
+}
+
+void stopBenchStream() {
+    if (!active) return;
+    hal::sampleTimerEnd();
+    drainRing();
+    active = false;
+    suspendAdcScan(false);
+    pausePriority(PRIORITY_COSMETIC, false);
+}
+
+bool isBenchStreamActive() {
+    return active;
+}
+
+void updateBenchStream(uint32_t now) {
+    if (!active) return;
+
+    if (now - lastDescribeMs >= BENCH_STREAM_DESCRIBE_MS) {
+        sendDescription();
+        lastDescribeMs = now;
+    }
+
+    // Full blocks as they fill, a partial one when the flush time is up -
+    // only what was waiting on entry, so a slow link can't hold the loop here
+    uint16_t fill = ringFill();
+    if (fill > peakFill) peakFill = fill;
+    while (fill >= samplesPerBlock) {
+        sendBlock(samplesPerBlock);
+        lastBlockMs = now;
+        fill -= samplesPerBlock;
+    }
+    if (fill > 0 && now - lastBlockMs >= BENCH_STREAM_FLUSH_MS) {
+        sendBlock(fill);
+        lastBlockMs = now;
+    }
+}
+
+void printBenchStreamStatus() {
+    msg.control.println(F("=== Bench Stream ==="));
+    if (!HAL_HAS_SAMPLE_TIMER) {
+        msg.control.println(F("Not available on this platform (no sampling timer)"));
+        return;
+    }
+    msg.control.print(F("State: "));
+    msg.control.println(active ? F("Streaming") : F("Stopped"));
+    if (rate == 0) return;
+
+    msg.control.print(F("Rate: "));
+    msg.control.print(rate);
+    msg.control.print(F(" Hz, Channels: "));
+    msg.control.print(numPins);
+    msg.control.print(F(", Inputs: "));
+    msg.control.println(numSlots);
+    msg.control.print(F("Samples: "));
+    msg.control.print(samplesSent);
+    msg.control.print(F(" sent, "));
+    msg.control.print(samplesLost);
+    msg.control.println(F(" lost (ring full)"));
+    msg.control.print(F("Blocks: "));
+    msg.control.print(blocksSent);
+    msg.control.print(F(", "));
+    msg.control.print(bytesSent);
+    msg.control.print(F(" bytes, up to "));
+    msg.control.print(samplesPerBlock);
+    msg.control.println(F(" samples each"));
+    msg.control.print(F("Ring: "));
+    msg.control.print(peakFill);
+    msg.control.print(F(" / "));
+    msg.control.print(ringEntries);
+    msg.control.println(F(" samples peak"));
+}
+
+#else
+
+BenchStartResult startBenchStream(uint16_t rateHz) { return BENCH_NO_TIMER; }
+void stopBenchStream() {}
+bool isBenchStreamActive() { return false; }
+void updateBenchStream(uint32_t now) {}
+void printBenchStreamStatus() {}
+
+#endif // ENABLE_BENCH_STREAM
@@ -0,0 +1,103 @@
+/*
+ * bench_stream.h - High-rate ADC streaming for bench characterization
+ *
+ * The data outputs send at most once per loop tick, from values the sensor
+ * pipeline computes at SENSOR_READ_INTERVAL_MS. To characterize a sender or
+ * a filter setting on the bench, BENCH START samples every analog pin in use
+ * (the ADC scan's pin list, adc_scan.h) from a hardware timer
+ * (hal/hal_sample_timer.h) at a fixed rate into a ring, and the loop sends
+ * the ring on the data plane as binary blocks, each one large write
+ * (BENCH_STREAM_BLOCK_BYTES, a multiple of the 512-byte USB high-speed bulk
+ * packet). While it streams:
+ *
+ *   - the cosmetic scheduler class (serial output, display, LED) is paused
+ *   - the ADC scan is suspended: the timer owns the ADC, and each pin's
+ *     newest sample goes to the scan cache, so the sensor pipeline keeps
+ *     computing its values from the same conversions
+ *   - samples are single raw analogRead() conversions - no settling
+ *     discard, no oversampling - 'counts' exactly as the ADC returned them
+ *
+ * Frames use the data plane framing (serial_frame.h):
+ *
+ *   'S'  description: version (1), rate Hz (uint16), ADC bits, channel
+ *        count, then the pin of each channel, input count, then for each
+ *        input slot, pin, name[8] and standard units[6]
+ *   'B'  block: samples lost to a full ring since the previous block
+ *        (uint16), sample count, then per sample micros() (uint32) and the
+ *        counts of each channel (uint16), then each input's value (float32,
+ *        standard units, the published input snapshot) at send time
+ *
+ * The description goes out at start and every BENCH_STREAM_DESCRIBE_MS. A
+ * block is sent as soon as one is full, or BENCH_STREAM_FLUSH_MS after the
+ * last. Decode with tools/bench_decode.py.
+ *
+ * Only where the HAL has a sampling timer (Teensy 3.x/4.x); elsewhere
+ * startBenchStream() fails. RUN mode only - CONFIG stops the stream.
+ *
+ * Usage:
+ *   startBenchStream(1000);        // BENCH START 1000
+ *   updateBenchStream(now);        // Every loop iteration
+ *   stopBenchStream();
+ *
+ * Build Flags:
+ *   -D ENABLE_BENCH_STREAM          - Compile the BENCH command and streamer
+ *   -D BENCH_STREAM_RING_BYTES=n    - Sample ring size (default 16384)
+ *   -D BENCH_STREAM_BLOCK_BYTES=n   - Largest block frame (default 2048)
+ *   -D BENCH_STREAM_MAX_RATE_HZ=n   - Highest accepted rate (default 20000)
+ *   -D BENCH_STREAM_FLUSH_MS=n      - Longest wait for a full block (default 20)
+ *   -D BENCH_STREAM_DESCRIBE_MS=n   - Description resend interval (default 1000)
+ */
+
+#ifndef BENCH_STREAM_H
+#define BENCH_STREAM_H
+
+#include <Arduino.h>
+
+#ifndef BENCH_STREAM_RING_BYTES
+#define BENCH_STREAM_RING_BYTES 16384
+#endif
+
+#ifndef BENCH_STREAM_BLOCK_BYTES
+#define BENCH_STREAM_BLOCK_BYTES 2048
+#endif
+
+#ifndef BENCH_STREAM_MAX_RATE_HZ
+#define BENCH_STREAM_MAX_RATE_HZ 20000
+#endif
+
+#ifndef BENCH_STREAM_FLUSH_MS
+#define BENCH_STREAM_FLUSH_MS 20
+#endif
+
+#ifndef BENCH_STREAM_DESCRIBE_MS
+#define BENCH_STREAM_DESCRIBE_MS 1000
+#endif
+
+#define BENCH_STREAM_DEFAULT_RATE_HZ 1000
+
+enum BenchStartResult : uint8_t {
+    BENCH_STARTED = 0,
+    BENCH_NO_TIMER,         // No sampling timer on this platform
+    BENCH_NO_CHANNELS,      // No analog pins in use yet
+    BENCH_BAD_RATE,         // 0 or above BENCH_STREAM_MAX_RATE_HZ
+    BENCH_TOO_WIDE          // One sample and the values don't fit a block
+};
+
+/**
+ * Start sampling every analog pin in use at rateHz
+ * Restarts (with the current pin list) if already streaming.
+ */
+BenchStartResult startBenchStream(uint16_t rateHz);
+
+// Stop sampling, send what the ring holds, resume the ADC scan and cosmetic tasks
+void stopBenchStream();
+
+bool isBenchStreamActive();
+
+// Drain the ring into block frames - every loop iteration while active
+void updateBenchStream(uint32_t now);
+
+// Rate, channels and counters (BENCH STATUS)
+void printBenchStreamStatus();
+
+#endif // BENCH_STREAM_H
@@ -0,0 +1,329 @@
+/*
+ * host_subscription.cpp - Host-negotiated data plane subscriptions
+ */
+
+#include "host_subscription.h"
+
+#if HOST_SUBSCRIPTIONS
+
+#include "serial_frame.h"
+#include "packed_signal.h"
+#include "../inputs/input_manager.h"
+#include "../inputs/input_snapshot.h"
+#include "../lib/message_router.h"
+#include "../lib/message_api.h"
+#include "../lib/float_format.h"
+#include "../lib/units_registry.h"
+
+#define HOST_FRAME_DESCRIPTION  'H'
+#define HOST_FRAME_VALUES       'V'
+
+#define HOST_CSV_DECIMALS       2
+#define HOST_CHANNEL_ENTRY      25      // Slot, period, width, factor, offset, name[8], units[6]
+#define HOST_FRAME_BYTES        (SERIAL_FRAME_OVERHEAD + 2 + HOST_SUBSCRIBE_MAX_CHANNELS * HOST_CHANNEL_ENTRY)
+
+static_assert(HOST_FRAME_BYTES >= 13 + HOST_SUBSCRIBE_MAX_CHANNELS * (1 + FLOAT_FORMAT_SIZE),
+              "A CSV row must fit the frame buffer");
+
+struct HostChannel {
+    uint8_t slot;
+    InputPin pin;              // Finds the input again after the slots change
+    uint16_t periodMs;
+    uint32_t nextDue;
+};
+
+struct HostSubscription {
+    uint8_t transport;          // TransportID, TRANSPORT_NONE = unused
+    HostFormat format;
+    uint8_t count;
+    uint8_t layoutVersion;      // getInputLayoutVersion() the channels were resolved at
+    bool describeDue;
+    uint16_t sequence;
+    uint32_t lastDescribeMs;
+    uint32_t writes;
+    uint32_t bytes;
+    uint32_t dropped;           // Writes the transport refused (TX ring full)
+    HostChannel channels[HOST_SUBSCRIBE_MAX_CHANNELS];
+};
+
+static HostSubscription subs[HOST_SUBSCRIBE_MAX_HOSTS];
+static uint8_t frame[HOST_FRAME_BYTES];
+
+static HostSubscription* findSubscription(uint8_t transportId) {
+    for (uint8_t i = 0; i < HOST_SUBSCRIBE_MAX_HOSTS; i++) {
+        if (subs[i].transport == transportId) return &subs[i];
+    }
+    return nullptr;
+}
+
+// Hold subscribed transports out of the data plane, and read each channel's
+// input at least as often as the fastest subscription to it wants
+static void applySubscriptions() {
+    uint16_t reserved = 0;
+    uint16_t fastest[MAX_INPUTS] = {0};
+    for (uint8_t i = 0; i < HOST_SUBSCRIBE_MAX_HOSTS; i++) {
+        const HostSubscription& sub = subs[i];
+        if (sub.transport == TRANSPORT_NONE) continue;
+        reserved |= 1u << sub.transport;
+        for (uint8_t c = 0; c < sub.count; c++) {
+            uint16_t& f = fastest[sub.channels[c].slot];
+            if (f == 0 || sub.channels[c].periodMs < f) f = sub.channels[c].periodMs;
+        }
+    }
+    router.setDataReserved(reserved);
+    for (uint8_t slot = 0; slot < MAX_INPUTS; slot++) {
+        setInputScheduleInterval(&inputs[slot], fastest[slot]);
+    }
+}
+
+// The inputs changed: find each channel's input again, drop the ones gone
+static void resolveChannels(HostSubscription& sub) {
+    uint8_t kept = 0;
+    for (uint8_t c = 0; c < sub.count; c++) {
+        HostChannel ch = sub.channels[c];
+        uint8_t slot = getInputIndex(ch.pin);
+        if (slot == 0xFF || !inputs[slot].flags.isEnabled) continue;
+        ch.slot = slot;
+        sub.channels[kept++] = ch;
+    }
+    sub.count = kept;
+    sub.layoutVersion = getInputLayoutVersion();
+    sub.describeDue = true;
+}
+
+static void endSubscription(HostSubscription& sub) {
+    sub.transport = TRANSPORT_NONE;
+    sub.count = 0;
+    applySubscriptions();
+}
+
+// Write to the subscribed transport only; a full TX ring drops the write
+static void sendToHost(HostSubscription& sub, TransportInterface* transport, const uint8_t* data, uint16_t len) {
+    size_t n = transport->send(data, len, TX_DROP_NEWEST);
+    sub.writes++;
+    if (n < len) {
+        sub.dropped++;
+    } else {
+        sub.bytes += len;
+    }
+}
+
+static void sendFrame(HostSubscription& sub, TransportInterface* transport, uint8_t type, uint16_t len) {
+    uint16_t total = buildSerialFrame(frame, type, len, sub.sequence++);
+    sendToHost(sub, transport, frame, total);
+}
+
+// Append at most the space left in the frame buffer
+static uint16_t appendText(uint16_t pos, const char* text, bool progmem) {
+    while (pos < HOST_FRAME_BYTES - 2) {
+        char c = progmem ? pgm_read_byte(text) : *text;
+        if (c == '\0') break;
+        frame[pos++] = c;
+        text++;
+    }
+    return pos;
+}
+
+static void sendHeaderRow(HostSubscription& sub, TransportInterface* transport) {
+    uint16_t pos = appendText(0, "t_ms", false);
+    for (uint8_t c = 0; c < sub.count; c++) {
+        const Input& input = inputs[sub.channels[c].slot];
+        pos = appendText(pos, ",", false);
+        pos = appendText(pos, input.abbrName, false);
+        const char* units = getUnitStringByIndex(input.unitsIndex);
+        if (pgm_read_byte(units)) {
+            pos = appendText(pos, " (", false);
+            pos = appendText(pos, units, true);
+            pos = appendText(pos, ")", false);
+        }
+    }
+    frame[pos++] = '\r';
+    frame[pos++] = '\n';
+    sendToHost(sub, transport, frame, pos);
+}
+
+static void sendDescription(HostSubscription& sub, TransportInterface* transport, uint32_t now) {
+    uint8_t* p = frame + SERIAL_FRAME_HEADER;
+    *p++ = HOST_SUBSCRIBE_VERSION;
+    *p++ = sub.count;
+    for (uint8_t c = 0; c < sub.count; c++) {
+        const HostChannel& ch = sub.channels[c];
+        const Input& input = inputs[ch.slot];
+        PackedScale scale = getPackedScale(input.measurementType);
+        *p++ = ch.slot;
+        *p++ = ch.periodMs & 0xFF;
+        *p++ = ch.periodMs >> 8;
+        *p++ = scale.width;
+        memcpy(p, &scale.factor, 4);
+        memcpy(p + 4, &scale.offset, 4);
+        p += 8;
+        memset(p, 0, 14);
+        strncpy((char*)p, input.abbrName, 8);
+        strncpy_P((char*)p + 8, (const char*)getPackedUnits(input.measurementType), 6);
+        p += 14;
+    }
+    sendFrame(sub, transport, HOST_FRAME_DESCRIPTION, p - (frame + SERIAL_FRAME_HEADER));
+    sub.lastDescribeMs = now;
+}
+
+// One tick of a subscription: the channels due, in one write
+static void sendDue(HostSubscription& sub, TransportInterface* transport, uint32_t now) {
+    uint16_t due = 0;
+    for (uint8_t c = 0; c < sub.count; c++) {
+        HostChannel& ch = sub.channels[c];
+        if ((int32_t)(now - ch.nextDue) < 0) continue;
+        due |= 1u << c;
+        ch.nextDue += ch.periodMs;
+        if ((int32_t)(now - ch.nextDue) >= 0) ch.nextDue = now + ch.periodMs;  // Resync, no burst
+    }
+    if (due == 0) return;
+
+    InputSnapshot snap = getInputSnapshot();
+    if (sub.format == HOST_FORMAT_CSV) {
+        uint16_t pos = formatUnsigned((char*)frame, now);
+        for (uint8_t c = 0; c < sub.count; c++) {
+            frame[pos++] = ',';
+            if (!(due & (1u << c))) continue;
+            const Input& input = inputs[sub.channels[c].slot];
+            float value = snap.samples[sub.channels[c].slot].value;
+            if (!isnan(value)) {
+                pos += formatFixed((char*)frame + pos, toInputUnits(&input, value), HOST_CSV_DECIMALS);
+            }
+        }
+        frame[pos++] = '\r';
+        frame[pos++] = '\n';
+        sendToHost(sub, transport, frame, pos);
+        return;
+    }
+
+    uint8_t* p = frame + SERIAL_FRAME_HEADER;
+    memcpy(p, &now, 4);
+    p[4] = due & 0xFF;
+    p[5] = due >> 8;
+    p += 6;
+    for (uint8_t c = 0; c < sub.count; c++) {
+        if (!(due & (1u << c))) continue;
+        uint8_t slot = sub.channels[c].slot;
+        p += writePackedSignal(p, inputs[slot].measurementType, snap.samples[slot].value);
+    }
+    sendFrame(sub, transport, HOST_FRAME_VALUES, p - (frame + SERIAL_FRAME_HEADER));
+}
+
+HostSubscribeResult subscribeHost(uint8_t transportId, const HostChannelRequest* channels,
+                                  uint8_t count, HostFormat format) {
+    TransportInterface* transport = router.getTransportById((TransportID)transportId);
+    if (transportId == TRANSPORT_NONE || transport == nullptr) return HOST_SUB_NO_TRANSPORT;
+    if (format == HOST_FORMAT_BINARY && !transport->supportsBinary()) return HOST_SUB_NOT_BINARY;
+    if (count == 0 || count > HOST_SUBSCRIBE_MAX_CHANNELS) return HOST_SUB_BAD_CHANNELS;
+    for (uint8_t c = 0; c < count; c++) {
+        if (channels[c].slot >= MAX_INPUTS || channels[c].rateHz == 0 ||
+            channels[c].rateHz > HOST_SUBSCRIBE_MAX_HZ) {
+            return HOST_SUB_BAD_CHANNELS;
+        }
+    }
+
+    HostSubscription* sub = findSubscription(transportId);
+    if (sub == nullptr) sub = findSubscription(TRANSPORT_NONE);
+    if (sub == nullptr) return HOST_SUB_FULL;
+
+    uint32_t now = millis();
+    memset(sub, 0, sizeof(*sub));
+    sub->transport = transportId;
+    sub->format = format;
+    sub->count = count;
+    for (uint8_t c = 0; c < count; c++) {
+        HostChannel& ch = sub->channels[c];
+        ch.slot = channels[c].slot;
+        ch.pin = inputs[ch.slot].pin;
+        ch.periodMs = 1000 / channels[c].rateHz;
+        ch.nextDue = now;
+    }
+    sub->layoutVersion = getInputLayoutVersion();
+    sub->describeDue = true;
+    applySubscriptions();
+    return HOST_SUBSCRIBED;
+}
+
+bool unsubscribeHost(uint8_t transportId) {
+    if (transportId == TRANSPORT_NONE) return false;
+    HostSubscription* sub = findSubscription(transportId);
+    if (sub == nullptr) return false;
+    endSubscription(*sub);
+    return true;
+}
+
+uint32_t updateHostSubscriptions(uint32_t now) {
+    uint32_t next = now + 1000;
+    for (uint8_t i = 0; i < HOST_SUBSCRIBE_MAX_HOSTS; i++) {
+        HostSubscription& sub = subs[i];
+        if (sub.transport == TRANSPORT_NONE) continue;
+
+        // The host went away - its channels stop costing anything
+        TransportInterface* transport = router.getTransportById((TransportID)sub.transport);
+        if (transport == nullptr || transport->getState() != TRANSPORT_CONNECTED) {
+            endSubscription(sub);
+            continue;
+        }
+        if (sub.layoutVersion != getInputLayoutVersion()) {
+            resolveChannels(sub);
+            applySubscriptions();  // The rebuild reset the read intervals
+            if (sub.count == 0) {
+                msg.debug.warn(TAG_ROUTER, "Subscription on %s ended: its inputs are gone",
+                               transport->getName());
+                endSubscription(sub);
+                continue;
+            }
+        }
+
+        if (sub.describeDue ||
+            (sub.format == HOST_FORMAT_BINARY && now - sub.lastDescribeMs >= HOST_SUBSCRIBE_DESCRIBE_MS)) {
+            sub.describeDue = false;
+            if (sub.format == HOST_FORMAT_CSV) {
+                sendHeaderRow(sub, transport);
+            } else {
+                sendDescription(sub, transport, now);
+            }
+        }
+        sendDue(sub, transport, now);
+
+        for (uint8_t c = 0; c < sub.count; c++) {
+            if ((int32_t)(sub.channels[c].nextDue - next) < 0) next = sub.channels[c].nextDue;
+        }
+    }
+    return next;
+}
+
+void printHostSubscriptions() {
+    bool any = false;
+    for (uint8_t i = 0; i < HOST_SUBSCRIBE_MAX_HOSTS; i++) {
+        const HostSubscription& sub = subs[i];
+        if (sub.transport == TRANSPORT_NONE) continue;
+        TransportInterface* transport = router.getTransportById((TransportID)sub.transport);
+        any = true;
+
+        msg.control.print(transport ? transport->getName() : "?");
+        msg.control.print(F(": "));
+        msg.control.print(sub.format == HOST_FORMAT_CSV ? F("CSV") : F("BINARY"));
+        msg.control.print(F(", "));
+        msg.control.print(sub.writes);
+        msg.control.print(F(" writes, "));
+        msg.control.print(sub.bytes);
+        msg.control.print(F(" bytes, "));
+        msg.control.print(sub.dropped);
+        msg.control.println(F(" dropped"));
+
+        msg.control.print(F(" "));
+        for (uint8_t c = 0; c < sub.count; c++) {
+            const HostChannel& ch = sub.channels[c];
+            msg.control.print(F(" "));
+            msg.control.print(inputs[ch.slot].abbrName);
+            msg.control.print('@');
+            msg.control.print(1000 / ch.periodMs);
+            msg.control.print(F("Hz"));
+        }
+        msg.control.println();
+    }
+    if (!any) msg.control.println(F("No host subscriptions"));
+}
+
+#endif // HOST_SUBSCRIPTIONS
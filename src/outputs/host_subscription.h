@@ -0,0 +1,132 @@
+/*
+ * host_subscription.h - Host-negotiated data plane subscriptions
+ *
+ * The data outputs send what the configuration routes to them, at their
+ * intervals, to every data plane transport. A host that wants something else
+ * - a logger after three channels, a tuning session after one at 100 Hz -
+ * asks for it on its own link instead of reconfiguring the unit:
+ *
+ *   SUBSCRIBE CHT@10 OILP@25 RPM@100 FORMAT BINARY
+ *
+ * Each channel is a pin or an input's abbreviation, with a rate in Hz
+ * (default HOST_SUBSCRIBE_DEFAULT_HZ). The subscription belongs to the
+ * transport the command came in on and lives in RAM only: SUBSCRIBE STOP,
+ * the transport disconnecting or a reboot ends it, nothing is saved, and a
+ * new SUBSCRIBE from the same transport replaces it.
+ *
+ * While subscribed, the transport is held out of the regular data plane
+ * (MessageRouter::setDataReserved()) and gets exactly what it asked for:
+ * each channel at its own rate, one write per tick holding the channels due,
+ * straight to that transport. Channels nobody asked for are not encoded for
+ * it. A rate faster than the input's read interval shortens that interval
+ * while the subscription lasts (setInputScheduleInterval()) - not for a
+ * sensor with a minimum read interval of its own.
+ *
+ * Formats:
+ *   CSV     a header row "t_ms,CHT (C),OILP (bar),..." (display units) on
+ *           start, then a row per tick, empty fields for channels not due
+ *   BINARY  data plane frames (serial_frame.h) numbered by a sequence
+ *           counter of the subscription's own:
+ *     'H'  description: version (1), channel count, then per channel the
+ *          input slot, period ms (uint16), signal width, factor and offset
+ *          (float32), name[8] and standard units[6]
+ *     'V'  values: ms (uint32), a bitmap of the channels present (uint16,
+ *          bit n = channel n of the description), then each present
+ *          channel's signal (packed_signal.h): raw * factor + offset, all
+ *          ones = no data
+ *
+ * The description is resent every HOST_SUBSCRIBE_DESCRIBE_MS and when the
+ * inputs change (a channel whose input was cleared is dropped). Values come
+ * from the published input snapshot, so the stream runs in RUN mode.
+ * tools/serial_decode.py decodes both formats.
+ *
+ * Usage:
+ *   subscribeHost(TRANSPORT_USB_SERIAL, requests, count, HOST_FORMAT_CSV);
+ *   next = updateHostSubscriptions(now);  // Telemetry output task
+ *   unsubscribeHost(TRANSPORT_USB_SERIAL);
+ *
+ * Build Flags:
+ *   -D HOST_SUBSCRIPTIONS=0             - No SUBSCRIBE command (default off on AVR)
+ *   -D HOST_SUBSCRIBE_MAX_HOSTS=n       - Transports subscribed at once (default 2)
+ *   -D HOST_SUBSCRIBE_MAX_CHANNELS=n    - Channels per subscription (default 16, at most 16)
+ *   -D HOST_SUBSCRIBE_MAX_HZ=n          - Highest rate per channel (default 200)
+ *   -D HOST_SUBSCRIBE_DESCRIBE_MS=n     - BINARY description resend interval (default 5000)
+ */
+
+#ifndef HOST_SUBSCRIPTION_H
+#define HOST_SUBSCRIPTION_H
+
+#include <Arduino.h>
+
+#ifndef HOST_SUBSCRIPTIONS
+#if defined(__AVR__) || defined(USE_STATIC_CONFIG)
+#define HOST_SUBSCRIPTIONS 0
+#else
+#define HOST_SUBSCRIPTIONS 1
+#endif
+#endif
+
+#if HOST_SUBSCRIPTIONS
+
+#ifndef HOST_SUBSCRIBE_MAX_HOSTS
+#define HOST_SUBSCRIBE_MAX_HOSTS 2
+#endif
+
+#ifndef HOST_SUBSCRIBE_MAX_CHANNELS
+#define HOST_SUBSCRIBE_MAX_CHANNELS 16
+#endif
+
+#ifndef HOST_SUBSCRIBE_MAX_HZ
+#define HOST_SUBSCRIBE_MAX_HZ 200
+#endif
+
+#ifndef HOST_SUBSCRIBE_DESCRIBE_MS
+#define HOST_SUBSCRIBE_DESCRIBE_MS 5000
+#endif
+
+static_assert(HOST_SUBSCRIBE_MAX_CHANNELS <= 16, "The 'V' frame bitmap holds 16 channels");
+
+#define HOST_SUBSCRIBE_DEFAULT_HZ 10
+#define HOST_SUBSCRIBE_VERSION    1
+
+enum HostFormat : uint8_t {
+    HOST_FORMAT_CSV = 0,
+    HOST_FORMAT_BINARY,
+};
+
+// One channel asked for
+struct HostChannelRequest {
+    uint8_t slot;               // Input slot
+    uint16_t rateHz;            // 1 - HOST_SUBSCRIBE_MAX_HZ
+};
+
+enum HostSubscribeResult : uint8_t {
+    HOST_SUBSCRIBED = 0,
+    HOST_SUB_NO_TRANSPORT,      // Not a registered transport
+    HOST_SUB_NOT_BINARY,        // BINARY on a text-only transport
+    HOST_SUB_BAD_CHANNELS,      // None, too many, or a rate out of range
+    HOST_SUB_FULL               // HOST_SUBSCRIBE_MAX_HOSTS other transports subscribed
+};
+
+/**
+ * Subscribe a transport (replacing its subscription, if any)
+ * The CSV header or BINARY description goes out on the next tick.
+ */
+HostSubscribeResult subscribeHost(uint8_t transportId, const HostChannelRequest* channels,
+                                  uint8_t count, HostFormat format);
+
+// End a transport's subscription; false if it had none
+bool unsubscribeHost(uint8_t transportId);
+
+/**
+ * Send every subscription's due channels
+ * @return millis() of the next channel due (now + 1000 with none)
+ */
+uint32_t updateHostSubscriptions(uint32_t now);
+
+// Subscribed transports, channels and counters (SUBSCRIBE STATUS)
+void printHostSubscriptions();
+
+#endif // HOST_SUBSCRIPTIONS
+
+#endif // HOST_SUBSCRIPTION_H
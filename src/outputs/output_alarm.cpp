@@ -2,7 +2,8 @@
  * output_alarm.cpp - Alarm output module (buzzer, LEDs, etc.)
  *
  * Reacts to Input.flags.isInAlarm state set by alarm_logic.cpp
- * Manages silence button and alarm hardware outputs.
+ * Manages silence button and alarm hardware outputs. The button comes from
+ * the button service (lib/button_handler.h): a debounced press silences.
  *
  * This is a true output module integrated with output_manager.
  *
@@ -11,14 +12,19 @@
  * - Hardware control (buzzer, silence) lives HERE
  * - This separation allows alarm logic to be tested without hardware
  * - Output can be enabled/disabled via serial commands like other outputs
+ * - The worst severity comes from alarm_logic's per-severity counts, and the
+ *   buzzer and LED are only driven when it (or the silence state) changes -
+ *   no per-loop tone() reprogramming, and LED blinks keep their phase
  */
 
 #include "output_alarm.h"
 #include "../config.h"
 #include "../inputs/input_manager.h"
+#include "../inputs/alarm_logic.h"
 #include "../lib/pin_registry.h"
 #include "../lib/message_api.h"
 #include "../lib/log_tags.h"
+#include "../lib/button_handler.h"
 
 #ifdef ENABLE_LED
 #include "../lib/rgb_led.h"
@@ -27,6 +33,19 @@
 // ===== ALARM OUTPUT STATE =====
 static bool alarmSilenced = false;        // Is alarm currently silenced?
 static uint32_t silenceStartTime = 0;    // When was silence button pressed?
+static bool buzzerOn = false;             // Buzzer state last driven
+#ifdef ENABLE_LED
+static uint8_t ledSeverity = 0xFF;        // Severity the LED shows (0xFF = not set yet)
+#endif
+
+// ===== SILENCE BUTTON =====
+
+// A new press starts (or restarts) the silence - holding the button doesn't extend it
+static void onSilenceButton(ButtonPress event) {
+    if (event != BUTTON_DOWN) return;
+    alarmSilenced = true;
+    silenceStartTime = millis();
+}
 
 // ===== INITIALIZATION =====
 
@@ -35,10 +54,10 @@ void initAlarmOutput() {
     // Note: Pin is already registered in registerSystemPins() as PIN_BUZZER
     pinMode(BUZZER, OUTPUT);
     noTone(BUZZER);  // Ensure buzzer is off initially
+    buzzerOn = false;
 
-    // Configure silence button with internal pullup
-    // Button is active LOW (pulls pin to GND when pressed)
-    pinMode(MODE_BUTTON, INPUT_PULLUP);
+    // Silence button - the pin belongs to the button service
+    subscribeButton(onSilenceButton);
 
 #ifdef ENABLE_LED
     // RGB LED is initialized separately in main.cpp
@@ -53,33 +72,25 @@ void initAlarmOutput() {
 void sendAlarmOutput(Input* input) {
     // This function is called per-input by output_manager
     // We don't send per-input data, just need to satisfy the interface
-    // (Actual alarm decision happens in updateAlarmOutput which scans all inputs)
+    // (Actual alarm decision happens in updateAlarmOutput, from the system severity)
 }
 
 // ===== HELPER FUNCTIONS =====
 
-// Scan all inputs and return worst-case severity
+// Worst-case severity across enabled inputs (kept by alarm_logic on transitions)
 AlarmSeverity getSystemSeverity() {
-    AlarmSeverity worstSeverity = SEVERITY_NORMAL;
-
-    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
-        if (inputs[i].flags.isEnabled) {
-            if (inputs[i].currentSeverity > worstSeverity) {
-                worstSeverity = inputs[i].currentSeverity;
-            }
-        }
-    }
-
-    return worstSeverity;
+    return getWorstSeverity();
 }
 
 #ifdef ENABLE_LED
-// Update RGB LED based on system severity
+// Update RGB LED for a new system severity (on transitions only - a new
+// request restarts the effect); dropping below ALARM hands its slot back
 void updateLEDs(AlarmSeverity severity) {
     switch (severity) {
         case SEVERITY_NORMAL:
             // Normal operation - solid green
             rgbLedSolid(RGB_COLOR_NORMAL, PRIORITY_WARNING);
+            rgbLedRelease(PRIORITY_ALARM);
             break;
 
         case SEVERITY_WARNING:
@@ -89,6 +100,7 @@ void updateLEDs(AlarmSeverity severity) {
 #else
             rgbLedSolid(RGB_COLOR_WARNING, PRIORITY_WARNING);
 #endif
+            rgbLedRelease(PRIORITY_ALARM);
             break;
 
         case SEVERITY_ALARM:
@@ -104,36 +116,34 @@ void updateLEDs(AlarmSeverity severity) {
 #endif
 
 void updateAlarmOutput() {
-    // ===== SILENCE BUTTON HANDLING =====
-    // Check silence button (active LOW with pullup)
-    // Only record first press (don't re-trigger on held button)
-    if (digitalRead(MODE_BUTTON) == LOW) {
-        if (!alarmSilenced) {  // Only update on first press
-            alarmSilenced = true;
-            silenceStartTime = millis();
-        }
-    }
-
-    // Check if silence duration expired
+    // ===== SILENCE =====
+    // Started by onSilenceButton(); check if the silence duration expired
     if (alarmSilenced && (millis() - silenceStartTime >= SILENCE_DURATION)) {
         alarmSilenced = false;
     }
 
-    // ===== ALARM STATE SCANNING =====
-    // Scan all inputs to determine worst-case severity
+    // ===== ALARM STATE =====
+    // Worst-case severity, from the per-severity counts
     AlarmSeverity systemSeverity = getSystemSeverity();
 
 #ifdef ENABLE_LED
     // ===== LED CONTROL =====
-    updateLEDs(systemSeverity);
+    if (systemSeverity != ledSeverity) {
+        updateLEDs(systemSeverity);
+        ledSeverity = systemSeverity;
+    }
 #endif
 
     // ===== BUZZER CONTROL =====
     // Sound alarm only on RED (SEVERITY_ALARM), not on YELLOW (SEVERITY_WARNING)
-    if (systemSeverity == SEVERITY_ALARM && !alarmSilenced) {
-        tone(BUZZER, 700);  // 700 Hz alarm tone
-    } else {
-        noTone(BUZZER);     // Turn off buzzer
+    bool sound = (systemSeverity == SEVERITY_ALARM && !alarmSilenced);
+    if (sound != buzzerOn) {
+        if (sound) {
+            tone(BUZZER, 700);  // 700 Hz alarm tone
+        } else {
+            noTone(BUZZER);     // Turn off buzzer
+        }
+        buzzerOn = sound;
     }
 }
 
@@ -22,7 +22,7 @@ void initAlarmOutput();
 /**
  * Send alarm output for a specific input
  * Required by output_manager interface, but not used
- * (Alarm decision is made by scanning ALL inputs in updateAlarmOutput)
+ * (Alarm decision is made from the system severity in updateAlarmOutput)
  *
  * @param input Pointer to Input (unused but required by interface)
  */
@@ -30,7 +30,7 @@ void sendAlarmOutput(Input* input);
 
 /**
  * Update alarm output (called every loop)
- * Scans all inputs for alarm state, handles silence button, controls buzzer
+ * Handles silence button; drives buzzer and LED when the system severity changes
  */
 void updateAlarmOutput();
 
@@ -38,7 +38,7 @@ void updateAlarmOutput();
 // These functions allow other modules (LCD, etc.) to check alarm status
 
 /**
- * Get worst-case alarm severity across all enabled inputs
+ * Get worst-case alarm severity across all enabled inputs (O(1))
  * @return AlarmSeverity (NORMAL, WARNING, or ALARM)
  */
 AlarmSeverity getSystemSeverity();
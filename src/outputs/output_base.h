@@ -6,6 +6,7 @@
 #define OUTPUT_BASE_H
 
 #include "../inputs/input.h"
+#include "../inputs/input_snapshot.h"
 #include "../lib/sensor_types.h"
 #ifdef USE_STATIC_CONFIG
 #include "../lib/generated/sensor_library_static.h"
@@ -13,76 +14,96 @@
 #include "../lib/sensor_library.h"
 #endif
 #include "../lib/system_config.h"  // For OutputID enum
+#include "../lib/scheduler.h"      // For TaskPriority
+
+// A module's send batch: the slots (indices into inputs[]) due this tick, in
+// slot order, already filtered for enabled, valid and routed to the module.
+// Values come from samples[slot] - the input snapshot the pass took
+// (input_snapshot.h), the same for every module - not the live Input::value.
+typedef void (*OutputBatchFn)(const uint8_t* slots, uint8_t count, const InputSample* samples, uint32_t now);
 
 // Output module structure
+// A module implements sendBatch to see a tick at once (one record, row or set
+// of frames), or send to take one input at a time - sendToOutputs() calls
+// send for each slot of the batch when sendBatch is nullptr.
 typedef struct {
     const char* name;
     bool enabled;
     void (*init)(void);
     void (*send)(Input*);
+    OutputBatchFn sendBatch;
     void (*update)(void);  // Called each loop iteration
     uint16_t sendInterval;  // Milliseconds between sends
+    TaskPriority priority;  // Scheduler class for the send batch (shed order under load)
+    OutputSendMode sendMode;  // Periodic / on-change / heartbeat (data outputs only)
+    uint16_t deadband;      // On-change deadband, hundredths of standard units
+    OutputAggregate aggregate;  // Value sent each interval: last reading or window statistic
 } OutputModule;
 
 // Output module functions
 void initOutputModules();
-void sendToOutputs(uint32_t now);  // Send data to all outputs (time-sliced)
+void sendToOutputs(uint32_t now, TaskPriority priority);  // Send to outputs of one class (time-sliced)
+uint32_t getNextOutputDeadline(uint32_t now, TaskPriority priority);  // Earliest pending send in class
+bool outputsWantChanges(TaskPriority priority);  // Any change-driven output in class (wake on new values)
 void updateOutputs();              // Housekeeping (drain buffers, etc.)
+void updateOutputClass(TaskPriority priority);  // Housekeeping of one class (dual-core acquisition task)
+void aggregateInputSample(uint8_t slot, float value);  // Fold a reading into the aggregation windows
 
 // Runtime configuration API
 bool setOutputEnabled(const char* name, bool enabled);
 bool setOutputInterval(const char* name, uint16_t interval);
+bool setOutputMode(const char* name, OutputSendMode mode, uint16_t deadband);
+bool setOutputAggregate(const char* name, OutputAggregate aggregate);
+const char* getOutputAggregateName(OutputAggregate aggregate);
 OutputModule* getOutputByName(const char* name);
+OutputModule* getOutputByIndex(uint8_t index);
 void listOutputs();          // Show output status (enabled/disabled + intervals)
 void listOutputModules();    // Show available output module names
 
 // ===== OBDII FRAME BUILDING =====
 
+// Copy an input's value as its OBDII PID data bytes (big-endian / MSB first)
+// The bytes are encoded once per changed reading (refreshOBD2Data, input_manager.h)
+// Parameters:
+//   data - obd2length-byte buffer to fill
+//   ptr - Input with obd2length and obd2data
+// Returns: number of bytes written (obd2length), 0 if data size invalid
+inline uint8_t encodeOBD2Data(byte* data, const Input* ptr) {
+    byte dataBytes = ptr->obd2length;
+
+    // Validate data size (max 5 bytes - one PID in a single frame)
+    if (dataBytes == 0 || dataBytes > sizeof(ptr->obd2data)) {
+        return 0;
+    }
+
+    memcpy(data, ptr->obd2data, dataBytes);
+    return dataBytes;
+}
+
 // Build standard OBDII Mode 01 frame data (ISO 15765-4 compliant)
 // Fixes: 1) Correct length byte calculation, 2) Big-endian byte order
 // Parameters:
 //   frameData - 8-byte buffer to fill
-//   ptr - Input with obd2pid, obd2length, and obdConvert()
+//   ptr - Input with obd2pid, obd2length, and obd2data (refreshOBD2Data())
 // Returns: true if successful, false if data size invalid
 inline bool buildOBD2Frame(byte* frameData, Input* ptr) {
     byte mode = 0x41;  // Mode 01: Show current data
-    byte dataBytes = ptr->obd2length;
-
-    // Validate data size (max 5 bytes to fit in frameData[3..7])
-    if (dataBytes == 0 || dataBytes > 5) {
-        return false;
-    }
 
     // Clear frame
     for (int i = 0; i < 8; i++) {
         frameData[i] = 0;
     }
 
+    byte dataBytes = encodeOBD2Data(&frameData[3], ptr);
+    if (dataBytes == 0) {
+        return false;
+    }
+
     // Byte 0: Length = mode + PID + data (ISO 15765-4 single-frame format)
     frameData[0] = 2 + dataBytes;  // FIX: Was just dataBytes, now 2 + dataBytes
     frameData[1] = mode;
     frameData[2] = ptr->obd2pid;
 
-    // Convert value to OBDII format using sensor's conversion function
-    float obdValue = getObdConvertFunc(ptr->measurementType)(ptr->value);
-
-    // Encode data based on size (big-endian / MSB first)
-    if (dataBytes == 1) {
-        // 1-byte data (most temperatures, percentages)
-        frameData[3] = (byte)obdValue;
-    } else if (dataBytes == 2) {
-        // 2-byte data (RPM, high-precision temps, pressures)
-        uint16_t value = (uint16_t)obdValue;
-        frameData[3] = (value >> 8) & 0xFF;  // MSB first (FIX: Was LSB first)
-        frameData[4] = value & 0xFF;         // LSB second
-    } else {
-        // 3-5 byte data (rare, but supported)
-        uint32_t value = (uint32_t)obdValue;
-        for (byte i = 0; i < dataBytes; i++) {
-            frameData[3 + i] = (value >> ((dataBytes - 1 - i) * 8)) & 0xFF;
-        }
-    }
-
     return true;
 }
 
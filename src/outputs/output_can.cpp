@@ -3,10 +3,44 @@
  * Supports FlexCAN (Teensy), TWAI (ESP32), and MCP2515 (AVR) via HAL
  *
  * Features:
- * - Broadcast mode: Periodic transmission of all sensor PIDs (for RealDash)
- * - Request/Response mode: OBD-II Mode 01 queries (for ELM327/Torque)
+ * - Broadcast mode: Periodic transmission of all sensor PIDs (for RealDash),
+ *   one OBD-II style frame per input on 0x7E8
+ * - Packed broadcast layout: inputs packed as scaled 8/16-bit little-endian
+ *   signals into frames from a configurable base ID (BUS CAN OUTPUT LAYOUT),
+ *   a fraction of the frames; the layout prints as DBC or RealDash XML
+ * - Request/Response mode: OBD-II Mode 01 queries (for ELM327/Torque),
+ *   up to 6 PIDs per request answered in one response, and Mode 09 VIN
+ * - ISO-TP transport (lib/isotp.h): answers longer than one frame are
+ *   segmented and paced by the tester's flow control (block size, STmin)
  * - Hybrid mode: Both modes work simultaneously
  * - Configurable output bus (supports dual-bus on Teensy)
+ * - Mirror output: a second set of inputs (SET <pin> OUTPUT CAN_MIRROR) on
+ *   another bus with its own layout and rate (BUS CAN MIRROR), broadcast
+ *   only - e.g. a packed dashboard set at 50 Hz on a private bus next to a
+ *   reduced OBD-II set on the vehicle bus. Both outputs encode from one
+ *   per-input cache, so a value is converted once however many buses send it
+ * - Transmit queue (lib/can_tx.h): responses go out ahead of broadcast
+ *   frames, and a queued broadcast value is replaced by its successor
+ * - Request governor: a minimum interval per addressing mode (functional
+ *   0x7DF, physical 0x7E0), repeats of the request being answered dropped,
+ *   and the last Mode 01 answer reused while none of its inputs changed
+ * - J1939 layout (BUS CAN OUTPUT LAYOUT J1939): inputs whose PID has a
+ *   standard SPN (lib/j1939.h) go out in their PGNs on 29-bit IDs from
+ *   j1939_address, announced with an Address Claimed message
+ * - NMEA 2000 layout (BUS CAN OUTPUT LAYOUT N2K): engine rapid / dynamic and
+ *   temperature PGNs (lib/nmea2000.h) on their own schedule from the
+ *   encoded signal cache, fast-packet framed, from an address claimed with
+ *   contention (moves on to a lower NAME, answers ISO Requests)
+ *
+ * Build Flags:
+ *   -D OBD2_VIN=\"...\"  - 17-character VIN reported for Mode 09 PID 02
+ *                          (default "PREOBD00000000000")
+ *   -D J1939_NAME=0x...  - 64-bit J1939 NAME sent in Address Claimed
+ *                          (default 0x00000000FFE00001 - identity 1, no manufacturer code)
+ *   -D OBD2_MIN_REQUEST_INTERVAL_MS=n  - Shortest gap between answered requests per
+ *                          addressing mode (default 5, 0 = no limit)
+ *   -D OBD2_DUPLICATE_WINDOW_MS=n      - An identical request on the other address
+ *                          this soon after one is a copy (default 10)
  */
 
 #include "../config.h"
@@ -17,71 +51,247 @@
 #include "../lib/log_tags.h"
 #include "../lib/system_config.h"
 
+#include "output_can.h"
+
 #ifdef ENABLE_CAN
 
 #include "../hal/hal_can.h"
+#include "../inputs/input_can.h"
+#include "../lib/can_rx.h"
+#include "../lib/can_tx.h"
+#include "../lib/isotp.h"
+#include "../lib/j1939.h"
+#include "../lib/nmea2000.h"
+#include "../lib/can_node.h"
+#include "packed_signal.h"
+#include "../lib/memory_report.h"
+#include "../inputs/input_stats.h"
+
+// ===== OUTPUT INSTANCES =====
+
+// Instance 0 is the CAN output module: sent at the module's interval by the
+// output manager, answers OBD-II requests. Instance 1 is the mirror: its own
+// bus and interval, broadcast only, paced from updateCANOutput().
+#define CAN_OUTPUT_PRIMARY   0
+#define CAN_OUTPUT_MIRROR    1
+#define CAN_OUTPUT_INSTANCES 2
+
+// A signal of the packed, J1939 or NMEA 2000 layout (J1939: frame is the
+// signal's PGN, start and width its SPN's position; NMEA 2000: the message
+// and the field's position in it)
+struct PackedSignal {
+    uint8_t input;      // Slot in inputs[]
+    uint8_t frame;      // Frame index - ID is the instance's base ID + frame
+    uint8_t start;      // First byte in the frame
+    uint8_t width;      // 1 or 2 bytes
+};
+
+// A frame holds at least 7 bytes of signals before the next one starts
+#define PACKED_MAX_FRAMES ((MAX_INPUTS * 2 + 6) / 7)
+#define STANDARD_MAX_FRAMES (J1939_TX_PGN_COUNT > N2K_MAX_LAYOUT_MESSAGES ? J1939_TX_PGN_COUNT : N2K_MAX_LAYOUT_MESSAGES)
+#define CAN_OUTPUT_MAX_FRAMES (PACKED_MAX_FRAMES > STANDARD_MAX_FRAMES ? PACKED_MAX_FRAMES : STANDARD_MAX_FRAMES)
+
+// NMEA 2000 network state of an instance
+struct N2kState {
+    uint32_t dueMs[N2K_TX_MESSAGE_COUNT];   // Next send of each message
+    uint8_t seq[N2K_TX_MESSAGE_COUNT];      // Fast-packet / heartbeat sequence counters
+    uint32_t claimMs;                       // Last Address Claimed sent
+    uint8_t preferred;                      // j1939_address the claim started from
+    uint8_t moves;                          // Addresses given up to a lower NAME
+    uint16_t contentions;                   // Claims of our address by other NAMEs
+    bool cannotClaim;                       // Every address taken - not sending
+    bool listening;                         // Network handler registered
+};
+
+struct CANOutputInstance {
+    uint8_t bus;                                    // 0xFF = not sending (set during init)
+    PackedSignal signals[MAX_INPUTS];               // Frame layout, ordered by frame
+    uint8_t signalOf[MAX_INPUTS];                   // Input slot -> signal + 1 (0 = not broadcast)
+    uint8_t frameFirst[CAN_OUTPUT_MAX_FRAMES + 1];  // First signal of each frame
+    uint8_t frameLen[CAN_OUTPUT_MAX_FRAMES];        // DLC - bytes used
+    bool frameDirty[CAN_OUTPUT_MAX_FRAMES];         // Holds a value sent since the last flush
+    uint32_t frameId[CAN_OUTPUT_MAX_FRAMES];        // J1939: 29-bit ID of each PGN (NMEA 2000: without SA)
+    uint8_t frameMessage[CAN_OUTPUT_MAX_FRAMES];    // NMEA 2000: N2kMessage of each message
+    uint8_t frameInstance[CAN_OUTPUT_MAX_FRAMES];   // NMEA 2000: engine / temperature instance
+    uint8_t signalCount;
+    uint8_t frameCount;
+    bool claimed;                                   // J1939 / NMEA 2000 address claimed on the bus
+    uint8_t claimedAddress;
+    N2kState n2k;
+};
+
+static CANOutputInstance canOutputs[CAN_OUTPUT_INSTANCES] = {{0xFF}, {0xFF}};
+static uint32_t mirrorNextSend = 0;
+
+// Layout and base ID are read live - BUS CAN ... LAYOUT applies without a reboot
+static uint8_t layoutOf(uint8_t n) {
+    return n == CAN_OUTPUT_PRIMARY ? systemConfig.buses.can_output_layout
+                                   : systemConfig.buses.can_mirror_layout;
+}
+
+static uint16_t baseIdOf(uint8_t n) {
+    return n == CAN_OUTPUT_PRIMARY ? systemConfig.buses.can_output_base_id
+                                   : systemConfig.buses.can_mirror_base_id;
+}
+
+// Layouts of multi-signal frames, sent from flushPackedFrames()
+static bool isFrameLayout(uint8_t n) {
+    return layoutOf(n) == CAN_OUTPUT_PACKED || layoutOf(n) == CAN_OUTPUT_J1939;
+}
+
+// outputMask bit routing inputs to the instance
+static uint8_t maskOf(uint8_t n) {
+    return n == CAN_OUTPUT_PRIMARY ? (1 << OUTPUT_CAN) : (1 << OUTPUT_CAN_MIRROR);
+}
 
-// Which bus we're outputting on (set during init)
-static uint8_t canOutputBus = 0;
+// ===== ENCODED SIGNAL CACHE =====
+
+// Wire bytes of each input's snapshot value, shared by both instances -
+// re-encoded only when the value changes. The OBD-II bytes live with the
+// input (Input::obd2data, encoded at read time).
+struct EncodedSignal {
+    float value;        // Value the bytes hold
+    bool valid;         // false = encode on next use (config changed)
+    uint8_t packed[2];  // Packed layout signal (packed_signal.h)
+    uint8_t j1939[2];   // J1939 SPN bytes
+    uint8_t n2k[2];     // NMEA 2000 field bytes
+    uint8_t spn;        // SPN table index from the PID (J1939_NO_SPN = none), set on layout rebuild
+    uint8_t n2kField;   // NMEA 2000 field table index from the PID (N2K_NO_FIELD = none), ditto
+};
+
+static EncodedSignal encodedSignals[MAX_INPUTS];
+
+static const EncodedSignal& getEncodedSignal(uint8_t slot) {
+    EncodedSignal& e = encodedSignals[slot];
+    float value = getInputSnapshot().samples[slot].value;
+    if (!e.valid || e.value != value) {
+        writePackedSignal(e.packed, inputs[slot].measurementType, value);
+        if (e.spn != J1939_NO_SPN) j1939EncodeSpn(j1939GetSpn(e.spn), value, e.j1939);
+        if (e.n2kField != N2K_NO_FIELD) n2kEncodeField(n2kGetField(e.n2kField), value, e.n2k);
+        e.value = value;
+        e.valid = true;
+    }
+    return e;
+}
+
+#define OBD2_FUNCTIONAL_ID  0x7DF   // Request to all ECUs
+#define OBD2_PHYSICAL_ID    0x7E0   // Request to this ECU
+#define OBD2_RESPONSE_ID    0x7E8   // Our responses
+
+#define OBD2_MAX_REQUEST_PIDS 6     // SAE J1979 Mode 01 limit
+
+#ifndef OBD2_MIN_REQUEST_INTERVAL_MS
+#define OBD2_MIN_REQUEST_INTERVAL_MS 5
+#endif
+
+#ifndef OBD2_DUPLICATE_WINDOW_MS
+#define OBD2_DUPLICATE_WINDOW_MS 10
+#endif
+
+#ifndef OBD2_VIN
+#define OBD2_VIN "PREOBD00000000000"
+#endif
+#define OBD2_VIN_LENGTH 17
+static_assert(sizeof(OBD2_VIN) == OBD2_VIN_LENGTH + 1, "OBD2_VIN must be 17 characters");
 
 // ===== OBD-II REQUEST/RESPONSE SUPPORT =====
 
-// PID Lookup Table - Maps PIDs to Input pointers for fast lookup
-#define MAX_PID_ENTRIES 64
+// PID Index - Maps each PID directly to its input slot + 1 (0 = not served),
+// so a zero-initialized index answers nothing until it is built
+static uint8_t pidIndex[256];
+static uint8_t pidIndexCount = 0;
+static uint8_t highestPID = 0;     // Largest PID served (0 = none)
+
+// ===== REQUEST GOVERNOR =====
+
+#define OBD2_ADDR_FUNCTIONAL 0
+#define OBD2_ADDR_PHYSICAL   1
+
+struct OBD2RequestGovernor {
+    uint32_t lastAnsweredMs[2];     // Per addressing mode
+    bool answered[2];
+    uint8_t lastRequest[1 + OBD2_MAX_REQUEST_PIDS];  // [mode, PID...] last answered
+    uint8_t lastRequestLen;
+    uint8_t lastRequestAddr;
+    // Stats
+    uint32_t requests;
+    uint32_t limited;               // Inside the minimum interval - dropped
+    uint32_t duplicates;            // Copy of the request being answered - dropped
+    uint32_t cacheHits;             // Mode 01 answer reused
+};
+
+static OBD2RequestGovernor obdGovernor;
 
-struct PIDMapping {
-    uint8_t pid;
-    Input* inputPtr;
+// Last Mode 01 answer, valid while the sequence of every input in it is unchanged
+struct OBD2ResponseCache {
+    uint8_t pids[OBD2_MAX_REQUEST_PIDS];
+    uint8_t sequence[OBD2_MAX_REQUEST_PIDS];
+    uint8_t count;                  // 0 = empty
+    uint8_t response[ISOTP_MAX_PAYLOAD];
+    uint16_t length;
 };
 
-static PIDMapping pidLookupTable[MAX_PID_ENTRIES];
-static uint8_t pidLookupCount = 0;
+static OBD2ResponseCache obdResponseCache;
 
 // ===== PLATFORM ABSTRACTION =====
 
 /**
- * Platform-agnostic CAN frame sender
+ * Queue an OBD-II response frame (transmit queue, urgent class)
  * @param canId CAN identifier (0x7E8 for ECU responses)
  * @param data Frame data (8 bytes)
  * @param len Data length (usually 8)
+ * @return false if the urgent queue is full
  */
-static void sendCANFrame(uint32_t canId, const byte* data, uint8_t len) {
-    hal::can::write(canId, data, len, false, canOutputBus);  // Standard 11-bit ID
+static bool sendCANFrame(uint32_t canId, const byte* data, uint8_t len) {
+    return queueCANTx(canOutputs[CAN_OUTPUT_PRIMARY].bus, canId, data, len, false, CAN_TX_URGENT);  // Standard 11-bit ID
 }
 
-// ===== PID LOOKUP TABLE =====
+/**
+ * Queue a broadcast frame (transmit queue, broadcast class)
+ * A frame still queued with the same ID and key is replaced by this one.
+ */
+static void broadcastCANFrame(uint8_t bus, uint32_t canId, const byte* data, uint8_t len, uint16_t key,
+                              bool extended = false) {
+    queueCANTx(bus, canId, data, len, extended, CAN_TX_BROADCAST, key);
+}
+
+// ===== PID INDEX =====
 
 /**
- * Build PID lookup table from active inputs
- * Called during initCAN() after inputs are configured
+ * Rebuild the PID index from active inputs
+ * First enabled input wins a PID; the supported-PIDs bitmap PIDs (0x00,
+ * 0x20, 0x40 ...) are answered by the responder itself.
  */
-static void buildPIDLookupTable() {
-    pidLookupCount = 0;
-
-    for (uint8_t i = 0; i < MAX_INPUTS && pidLookupCount < MAX_PID_ENTRIES; i++) {
-        if (inputs[i].flags.isEnabled &&
-            inputs[i].obd2pid != 0x00) {  // Skip invalid PIDs
-
-            // Check for duplicate PIDs
-            bool isDuplicate = false;
-            for (uint8_t j = 0; j < pidLookupCount; j++) {
-                if (pidLookupTable[j].pid == inputs[i].obd2pid) {
-                    isDuplicate = true;
-                    msg.debug.warn(TAG_CAN, "Duplicate PID 0x%02X - using first occurrence (%s)",
-                                  inputs[i].obd2pid, pidLookupTable[j].inputPtr->abbrName);
-                    break;
-                }
-            }
+void rebuildOBD2PIDIndex() {
+    obdResponseCache.count = 0;  // PIDs may now map to other inputs, bitmaps change
+    memset(pidIndex, 0, sizeof(pidIndex));
+    pidIndexCount = 0;
+    highestPID = 0;
 
-            if (!isDuplicate) {
-                pidLookupTable[pidLookupCount].pid = inputs[i].obd2pid;
-                pidLookupTable[pidLookupCount].inputPtr = &inputs[i];
-                pidLookupCount++;
-            }
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        if (inputs[i].pin == 0xFF || !inputs[i].flags.isEnabled) continue;
+
+        uint8_t pid = inputs[i].obd2pid;
+        if (pid == 0x00) continue;  // Skip invalid PIDs
+
+        if ((pid & 0x1F) == 0) {
+            msg.debug.warn(TAG_CAN, "PID 0x%02X is a supported-PIDs bitmap - not served (%s)",
+                           pid, inputs[i].abbrName);
+            continue;
+        }
+
+        if (pidIndex[pid] != 0) {
+            msg.debug.warn(TAG_CAN, "Duplicate PID 0x%02X - using first occurrence (%s)",
+                           pid, inputs[pidIndex[pid] - 1].abbrName);
+            continue;
         }
+
+        pidIndex[pid] = i + 1;
+        pidIndexCount++;
+        if (pid > highestPID) highestPID = pid;
     }
 
-    msg.debug.info(TAG_CAN, "Built OBD-II PID lookup table: %d PIDs available", pidLookupCount);
+    msg.debug.info(TAG_CAN, "Built OBD-II PID index: %d PIDs available", pidIndexCount);
 }
 
 /**
@@ -90,222 +300,1334 @@ static void buildPIDLookupTable() {
  * @return Pointer to Input, or nullptr if not found
  */
 static Input* findInputByPID(uint8_t pid) {
-    for (uint8_t i = 0; i < pidLookupCount; i++) {
-        if (pidLookupTable[i].pid == pid) {
-            return pidLookupTable[i].inputPtr;
-        }
-    }
-    return nullptr;
+    uint8_t slot = pidIndex[pid];
+    return slot ? &inputs[slot - 1] : nullptr;
 }
 
-// ===== PID 00 (SUPPORTED PIDS BITMAP) =====
+// ===== SUPPORTED PIDS BITMAPS =====
 
 /**
- * Generate PID 00 bitmap (Supported PIDs 0x01-0x20)
- * Sets bit for each PID present in pidLookupTable
+ * Any PID served above pid
+ * Decides whether the bitmap ending at pid advertises the next bitmap PID.
+ */
+static bool hasPIDAbove(uint8_t pid) {
+    return highestPID > pid;
+}
+
+/**
+ * Generate a supported-PIDs bitmap (Mode 01 PID 00, 20, 40 ...)
+ * Sets a bit for each PID in the index in base+1..base+0x20,
+ * and the last bit (PID base+0x20, the next bitmap) if any PID lies beyond
  *
  * Bitmap encoding (ISO 15765-4):
- *   Byte A, Bit 7 = PID 0x01 supported
- *   Byte A, Bit 6 = PID 0x02 supported
+ *   Byte A, Bit 7 = PID base+0x01 supported
+ *   Byte A, Bit 6 = PID base+0x02 supported
  *   ...
- *   Byte D, Bit 0 = PID 0x20 supported
+ *   Byte D, Bit 0 = PID base+0x20 supported
  *
+ * @param base   Bitmap PID (multiple of 0x20)
  * @param bitmap 4-byte buffer to fill
  */
-static void generatePID00Bitmap(uint8_t* bitmap) {
+static void generateSupportedBitmap(uint8_t base, uint8_t* bitmap) {
     memset(bitmap, 0, 4);
 
-    for (uint8_t i = 0; i < pidLookupCount; i++) {
-        uint8_t pid = pidLookupTable[i].pid;
+    for (uint8_t offset = 0; offset < 0x20; offset++) {
+        uint16_t pid = base + 1 + offset;
+        if (pid > 0xFF) break;
+        if (pidIndex[pid]) {
+            bitmap[offset / 8] |= (1 << (7 - (offset % 8)));  // MSB first
+        }
+    }
+
+    if (base < 0xE0 && hasPIDAbove(base + 0x20)) {
+        bitmap[3] |= 0x01;  // Next bitmap PID
+    }
+}
+
+// ===== PACKED BROADCAST =====
+
+/**
+ * Rebuild one instance's packed layout from the inputs routed to it
+ * Inputs are packed in slot order; a signal that doesn't fit the rest of a
+ * frame starts the next one.
+ */
+static void rebuildPackedLayout(uint8_t n) {
+    CANOutputInstance& out = canOutputs[n];
+    memset(out.signalOf, 0, sizeof(out.signalOf));
+    memset(out.frameDirty, 0, sizeof(out.frameDirty));
+    out.signalCount = 0;
+    out.frameCount = 0;
+
+    uint16_t baseId = baseIdOf(n);
+    uint8_t used = 8;  // First signal opens a frame
 
-        // Only PIDs 0x01-0x20 go in PID 00 bitmap
-        if (pid >= 0x01 && pid <= 0x20) {
-            uint8_t byteIndex = (pid - 1) / 8;     // Which byte (0-3)
-            uint8_t bitIndex = 7 - ((pid - 1) % 8); // Which bit (7-0, MSB first)
-            bitmap[byteIndex] |= (1 << bitIndex);
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        if (inputs[i].pin == 0xFF || !inputs[i].flags.isEnabled) continue;
+        if (!(inputs[i].outputMask & maskOf(n))) continue;
+
+        uint8_t width = getPackedScale(inputs[i].measurementType).width;
+        if (used + width > 8) {
+            if (baseId + out.frameCount > 0x7FF) {
+                msg.debug.warn(TAG_CAN, "Packed layout runs past ID 0x7FF - %s and later not broadcast",
+                               inputs[i].abbrName);
+                break;
+            }
+            out.frameFirst[out.frameCount] = out.signalCount;
+            out.frameCount++;
+            used = 0;
         }
+
+        PackedSignal& sig = out.signals[out.signalCount];
+        sig.input = i;
+        sig.frame = out.frameCount - 1;
+        sig.start = used;
+        sig.width = width;
+        used += width;
+        out.frameLen[sig.frame] = used;
+        out.signalOf[i] = ++out.signalCount;
+    }
+    out.frameFirst[out.frameCount] = out.signalCount;
+
+    if (layoutOf(n) == CAN_OUTPUT_PACKED) {
+        msg.debug.info(TAG_CAN, "Packed CAN %s layout: %d signals in %d frames from 0x%03X",
+                       n == CAN_OUTPUT_PRIMARY ? "output" : "mirror",
+                       out.signalCount, out.frameCount, baseId);
     }
 }
 
+// ===== J1939 BROADCAST =====
+
+#ifndef J1939_NAME
+#define J1939_NAME 0x00000000FFE00001ULL
+#endif
+
 /**
- * Send Mode 01 PID 00 response (Supported PIDs)
- * Single frame format: [06 41 00 XX XX XX XX 00]
- * Length=6: mode (1) + PID (1) + bitmap (4)
+ * Announce the source address (Address Claimed, PGN 60928, to global)
+ * J1939: the address is fixed - a contending node with a lower NAME is not
+ * answered by moving to another address (the NMEA 2000 layout does move).
  */
-static void sendPID00Response() {
-    uint8_t bitmap[4];
-    generatePID00Bitmap(bitmap);
-
-    // Single frame response (fits in 8 bytes)
-    byte frameData[8] = {
-        0x06,         // Length: 6 bytes (mode + PID + 4 bitmap bytes)
-        0x41,         // Mode 01 response
-        0x00,         // PID 00
-        bitmap[0],    // PIDs 0x01-0x08
-        bitmap[1],    // PIDs 0x09-0x10
-        bitmap[2],    // PIDs 0x11-0x18
-        bitmap[3],    // PIDs 0x19-0x20
-        0x00          // Padding
+static void sendAddressClaim(uint8_t bus, uint8_t address, uint64_t name) {
+    uint8_t data[8];
+    for (uint8_t i = 0; i < 8; i++) {
+        data[i] = (name >> (8 * i)) & 0xFF;  // Little-endian
+    }
+    queueCANTx(bus, j1939BuildId(J1939_DEFAULT_PRIORITY, J1939_PGN_ADDRESS_CLAIMED, J1939_GLOBAL_ADDRESS, address),
+               data, 8, true, CAN_TX_URGENT);
+}
+
+// Routed input's SPN, or J1939_NO_SPN
+static uint8_t routedSpnOf(uint8_t n, uint8_t slot) {
+    if (inputs[slot].pin == 0xFF || !inputs[slot].flags.isEnabled) return J1939_NO_SPN;
+    if (!(inputs[slot].outputMask & maskOf(n))) return J1939_NO_SPN;
+    return encodedSignals[slot].spn;
+}
+
+/**
+ * Rebuild one instance's J1939 layout from the inputs routed to it
+ * One 8-byte frame per PGN, in the order its first input appears; a signal
+ * sits at its SPN's position, unused bytes are "not available" (0xFF).
+ */
+static void rebuildJ1939Layout(uint8_t n) {
+    CANOutputInstance& out = canOutputs[n];
+    memset(out.signalOf, 0, sizeof(out.signalOf));
+    memset(out.frameDirty, 0, sizeof(out.frameDirty));
+    out.signalCount = 0;
+    out.frameCount = 0;
+
+    uint8_t address = systemConfig.buses.j1939_address;
+
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        if (inputs[i].pin == 0xFF || !inputs[i].flags.isEnabled) continue;
+        if (!(inputs[i].outputMask & maskOf(n))) continue;
+
+        uint8_t index = encodedSignals[i].spn;
+        if (index == J1939_NO_SPN) {
+            msg.debug.warn(TAG_CAN, "No J1939 SPN for %s (PID 0x%02X) - not broadcast",
+                           inputs[i].abbrName, inputs[i].obd2pid);
+            continue;
+        }
+        J1939Spn spn = j1939GetSpn(index);
+
+        uint8_t f = 0;
+        while (f < out.frameCount && ((out.frameId[f] >> 8) & 0xFFFF) != spn.pgn) f++;
+        if (f == out.frameCount) {
+            out.frameId[f] = j1939BuildId(spn.priority, spn.pgn, J1939_GLOBAL_ADDRESS, address);
+            out.frameLen[f] = 8;
+            out.frameCount++;
+        }
+    }
+
+    // Signals grouped by frame, first input per SPN
+    for (uint8_t f = 0; f < out.frameCount; f++) {
+        out.frameFirst[f] = out.signalCount;
+        for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+            uint8_t index = routedSpnOf(n, i);
+            if (index == J1939_NO_SPN) continue;
+            J1939Spn spn = j1939GetSpn(index);
+            if (((out.frameId[f] >> 8) & 0xFFFF) != spn.pgn) continue;
+
+            bool taken = false;
+            for (uint8_t s = out.frameFirst[f]; s < out.signalCount; s++) {
+                if (out.signals[s].start == spn.start) taken = true;
+            }
+            if (taken) {
+                msg.debug.warn(TAG_CAN, "Duplicate J1939 SPN %u - %s not broadcast", spn.spn, inputs[i].abbrName);
+                continue;
+            }
+
+            PackedSignal& sig = out.signals[out.signalCount];
+            sig.input = i;
+            sig.frame = f;
+            sig.start = spn.start;
+            sig.width = spn.width;
+            out.signalOf[i] = ++out.signalCount;
+        }
+    }
+    out.frameFirst[out.frameCount] = out.signalCount;
+
+    msg.debug.info(TAG_CAN, "J1939 %s layout: %d SPNs in %d PGNs from SA 0x%02X",
+                   n == CAN_OUTPUT_PRIMARY ? "output" : "mirror",
+                   out.signalCount, out.frameCount, address);
+
+    // Claim the address once per bus, and again when it changes
+    if (out.bus != 0xFF && (!out.claimed || out.claimedAddress != address)) {
+        sendAddressClaim(out.bus, address, J1939_NAME);
+        out.claimed = true;
+        out.claimedAddress = address;
+    }
+}
+
+// ===== NMEA 2000 BROADCAST =====
+
+// Network management frames: ISO Request (59904) and Address Claimed (60928)
+#define N2K_NETWORK_ID   0x00EA0000UL
+#define N2K_NETWORK_MASK 0x03FB0000UL
+
+// Routed input's NMEA 2000 field, or N2K_NO_FIELD
+static uint8_t routedFieldOf(uint8_t n, uint8_t slot) {
+    if (inputs[slot].pin == 0xFF || !inputs[slot].flags.isEnabled) return N2K_NO_FIELD;
+    if (!(inputs[slot].outputMask & maskOf(n))) return N2K_NO_FIELD;
+    return encodedSignals[slot].n2kField;
+}
+
+static const char* instanceName(uint8_t n) {
+    return n == CAN_OUTPUT_PRIMARY ? "output" : "mirror";
+}
+
+// Claim an address; data waits N2K_CLAIM_HOLDOFF_MS for a contending claim
+static void claimN2kAddress(uint8_t n, uint8_t address) {
+    CANOutputInstance& out = canOutputs[n];
+    out.claimed = true;
+    out.claimedAddress = address;
+    out.n2k.claimMs = millis();
+    for (uint8_t m = 0; m < N2K_TX_MESSAGE_COUNT; m++) {
+        out.n2k.dueMs[m] = out.n2k.claimMs + N2K_CLAIM_HOLDOFF_MS;
+    }
+    sendAddressClaim(out.bus, address, N2K_NAME);
+}
+
+/**
+ * Give our address up to a lower NAME - claim the next one, wrapping at
+ * N2K_MAX_ADDRESS; once every address was tried, Cannot Claim (the null
+ * address) and stop sending
+ */
+static void moveN2kAddress(uint8_t n) {
+    CANOutputInstance& out = canOutputs[n];
+    if (++out.n2k.moves > N2K_MAX_ADDRESS) {
+        out.claimed = false;
+        out.n2k.cannotClaim = true;
+        sendAddressClaim(out.bus, J1939_NULL_ADDRESS, N2K_NAME);
+        msg.debug.warn(TAG_CAN, "NMEA 2000 %s: no free address - not sending", instanceName(n));
+        return;
+    }
+    uint8_t next = out.claimedAddress >= N2K_MAX_ADDRESS ? 0 : out.claimedAddress + 1;
+    msg.debug.info(TAG_CAN, "NMEA 2000 %s: address 0x%02X taken by a lower NAME - claiming 0x%02X",
+                   instanceName(n), out.claimedAddress, next);
+    claimN2kAddress(n, next);
+}
+
+// NACK (ISO Acknowledgment, PGN 59392, to global) for a PGN requested of us
+static void sendN2kNack(uint8_t bus, uint8_t address, uint8_t requester, uint32_t pgn) {
+    uint8_t data[8] = {
+        1, 0xFF, 0xFF, 0xFF, requester,     // Control 1 = NACK, group function n/a
+        (uint8_t)(pgn & 0xFF), (uint8_t)((pgn >> 8) & 0xFF), (uint8_t)((pgn >> 16) & 0xFF)
     };
+    queueCANTx(bus, j1939BuildId(J1939_DEFAULT_PRIORITY, N2K_PGN_ISO_ACK, J1939_GLOBAL_ADDRESS, address),
+               data, 8, true, CAN_TX_URGENT);
+}
 
-    sendCANFrame(0x7E8, frameData, 8);
+/**
+ * Network management for an NMEA 2000 instance (CAN RX pump)
+ * Address Claimed for our address from another NAME: the lower NAME keeps
+ * it - we claim again, or move on. ISO Request for 60928: our claim (or
+ * Cannot Claim); any other PGN requested of our address: NACK.
+ */
+static bool handleN2kNetwork(uint8_t n, const hal::can::CanRxFrame& frame) {
+    CANOutputInstance& out = canOutputs[n];
+    if (!frame.extended || out.bus == 0xFF || layoutOf(n) != CAN_OUTPUT_NMEA2000) return false;
+    if (n == CAN_OUTPUT_PRIMARY && !systemConfig.buses.can_output_enabled) return false;
 
-    #ifdef DEBUG
-    msg.debug.debug(TAG_CAN, "PID 00 bitmap: %02X %02X %02X %02X",
-                   bitmap[0], bitmap[1], bitmap[2], bitmap[3]);
-    #endif
+    J1939Id id = j1939ParseId(frame.id);
+    if (id.pgn == J1939_PGN_ADDRESS_CLAIMED) {
+        if (frame.len < 8 || !out.claimed || id.source != out.claimedAddress) return false;
+        uint64_t name = 0;
+        for (uint8_t i = 0; i < 8; i++) {
+            name |= (uint64_t)frame.data[i] << (8 * i);  // Little-endian
+        }
+        if (name == N2K_NAME) return false;  // Our own claim
+        out.n2k.contentions++;
+        if (N2K_NAME < name) {
+            sendAddressClaim(out.bus, out.claimedAddress, N2K_NAME);
+        } else {
+            moveN2kAddress(n);
+        }
+        return true;
+    }
+
+    if (id.pgn == J1939_PGN_REQUEST) {
+        if (frame.len < 3) return false;
+        bool toUs = out.claimed && id.dest == out.claimedAddress;
+        if (!toUs && id.dest != J1939_GLOBAL_ADDRESS) return false;
+
+        uint32_t pgn = frame.data[0] | ((uint32_t)frame.data[1] << 8) | ((uint32_t)frame.data[2] << 16);
+        if (pgn == J1939_PGN_ADDRESS_CLAIMED) {
+            sendAddressClaim(out.bus, out.claimed ? out.claimedAddress : J1939_NULL_ADDRESS, N2K_NAME);
+        } else if (toUs) {
+            sendN2kNack(out.bus, out.claimedAddress, id.source, pgn);
+        }
+        return true;
+    }
+    return false;
+}
+
+static bool handleN2kPrimary(const hal::can::CanRxFrame& frame) {
+    return handleN2kNetwork(CAN_OUTPUT_PRIMARY, frame);
+}
+
+static bool handleN2kMirror(const hal::can::CanRxFrame& frame) {
+    return handleN2kNetwork(CAN_OUTPUT_MIRROR, frame);
+}
+
+// Stop answering on the bus (layout changed away from NMEA 2000)
+static void stopN2kNetwork(uint8_t n) {
+    CANOutputInstance& out = canOutputs[n];
+    if (!out.n2k.listening) return;
+    unregisterCANRxHandler(n == CAN_OUTPUT_PRIMARY ? handleN2kPrimary : handleN2kMirror);
+    out.n2k.listening = false;
+    out.claimed = false;
+}
+
+// Append an NMEA 2000 message to the layout (false if the layout is full)
+static bool addN2kMessage(uint8_t n, uint8_t message, uint8_t instance) {
+    CANOutputInstance& out = canOutputs[n];
+    if (out.frameCount >= CAN_OUTPUT_MAX_FRAMES) return false;
+    N2kPgn pgn = n2kGetPgn(message);
+    uint8_t f = out.frameCount++;
+    out.frameId[f] = j1939BuildId(pgn.priority, pgn.pgn, J1939_GLOBAL_ADDRESS, 0);
+    out.frameLen[f] = pgn.length;
+    out.frameMessage[f] = message;
+    out.frameInstance[f] = instance;
+    out.frameFirst[f] = out.signalCount;
+    return true;
+}
+
+static void addN2kSignal(uint8_t n, uint8_t slot, const N2kField& field) {
+    CANOutputInstance& out = canOutputs[n];
+    PackedSignal& sig = out.signals[out.signalCount];
+    sig.input = slot;
+    sig.frame = out.frameCount - 1;
+    sig.start = field.start;
+    sig.width = field.width;
+    out.signalOf[slot] = ++out.signalCount;
+}
+
+/**
+ * Rebuild one instance's NMEA 2000 layout from the inputs routed to it
+ * 127488 and 127489 once each, with the first input per field (127489
+ * also for an RPM input alone - it carries the engine hours), then one
+ * 130312 per temperature input, numbered per source. Joins the network on
+ * the first build and claims again when j1939_address changes.
+ */
+static void rebuildN2kLayout(uint8_t n) {
+    CANOutputInstance& out = canOutputs[n];
+    memset(out.signalOf, 0, sizeof(out.signalOf));
+    memset(out.frameDirty, 0, sizeof(out.frameDirty));
+    out.signalCount = 0;
+    out.frameCount = 0;
+
+    // Engine messages, fields at their fixed positions
+    for (uint8_t m = N2K_TX_ENGINE_RAPID; m <= N2K_TX_ENGINE_DYNAMIC; m++) {
+        bool opened = false;
+        for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+            uint8_t index = routedFieldOf(n, i);
+            if (index == N2K_NO_FIELD) continue;
+            N2kField field = n2kGetField(index);
+            bool hours = m == N2K_TX_ENGINE_DYNAMIC && inputs[i].obd2pid == 0x0C;
+            if (field.message != m && !hours) continue;
+
+            if (!opened) {
+                addN2kMessage(n, m, N2K_ENGINE_INSTANCE);
+                opened = true;
+            }
+            if (field.message != m || field.width == 0) continue;
+
+            bool taken = false;
+            for (uint8_t s = out.frameFirst[out.frameCount - 1]; s < out.signalCount; s++) {
+                if (out.signals[s].start == field.start) taken = true;
+            }
+            if (taken) {
+                msg.debug.warn(TAG_CAN, "Duplicate NMEA 2000 field (PID 0x%02X) - %s not sent",
+                               inputs[i].obd2pid, inputs[i].abbrName);
+                continue;
+            }
+            addN2kSignal(n, i, field);
+        }
+    }
+
+    // A temperature message per input
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        if (inputs[i].pin == 0xFF || !inputs[i].flags.isEnabled) continue;
+        if (!(inputs[i].outputMask & maskOf(n))) continue;
+
+        uint8_t index = encodedSignals[i].n2kField;
+        if (index == N2K_NO_FIELD) {
+            msg.debug.warn(TAG_CAN, "No NMEA 2000 field for %s (PID 0x%02X) - not sent",
+                           inputs[i].abbrName, inputs[i].obd2pid);
+            continue;
+        }
+        N2kField field = n2kGetField(index);
+        if (field.message != N2K_TX_TEMPERATURE) continue;
+
+        uint8_t instance = 0;
+        for (uint8_t f = 0; f < out.frameCount; f++) {
+            if (out.frameMessage[f] == N2K_TX_TEMPERATURE &&
+                encodedSignals[out.signals[out.frameFirst[f]].input].n2kField == index) {
+                instance++;
+            }
+        }
+        if (!addN2kMessage(n, N2K_TX_TEMPERATURE, instance)) {
+            msg.debug.warn(TAG_CAN, "NMEA 2000 %s layout full - %s not sent", instanceName(n), inputs[i].abbrName);
+            break;
+        }
+        addN2kSignal(n, i, field);
+    }
+    out.frameFirst[out.frameCount] = out.signalCount;
+
+    msg.debug.info(TAG_CAN, "NMEA 2000 %s layout: %d fields in %d messages",
+                   instanceName(n), out.signalCount, out.frameCount);
+
+    if (out.bus == 0xFF) return;
+
+    // Join the network once per bus, and claim again when the address changes
+    uint8_t address = systemConfig.buses.j1939_address;
+    if (!out.n2k.listening) {
+        CANRxHandler handler = n == CAN_OUTPUT_PRIMARY ? handleN2kPrimary : handleN2kMirror;
+        if (!registerCANRxHandler("N2K", out.bus, N2K_NETWORK_ID, N2K_NETWORK_MASK, handler)) {
+            msg.debug.warn(TAG_CAN, "CAN RX handler table full - NMEA 2000 %s can't defend its address",
+                           instanceName(n));
+        }
+        out.n2k.listening = true;
+    } else if (out.n2k.preferred == address) {
+        return;
+    }
+    out.n2k.preferred = address;
+    out.n2k.moves = 0;
+    out.n2k.cannotClaim = false;
+    claimN2kAddress(n, address > N2K_MAX_ADDRESS ? 0 : address);
+}
+
+/**
+ * Assemble message f of an NMEA 2000 layout from the encoded signal cache
+ * 127489 also gets the engine hours and discrete status 1.
+ */
+static void buildN2kMessage(uint8_t n, uint8_t f, uint8_t* message) {
+    const CANOutputInstance& out = canOutputs[n];
+    uint8_t m = out.frameMessage[f];
+
+    uint8_t tag = 0;
+    if (m == N2K_TX_TEMPERATURE) {
+        tag = n2kGetField(encodedSignals[out.signals[out.frameFirst[f]].input].n2kField).tag;
+    }
+    n2kInitMessage(m, out.frameInstance[f], tag, message);
+
+    for (uint8_t s = out.frameFirst[f]; s < out.frameFirst[f + 1]; s++) {
+        const PackedSignal& sig = out.signals[s];
+        memcpy(&message[sig.start], getEncodedSignal(sig.input).n2k, sig.width);
+    }
+    if (m != N2K_TX_ENGINE_DYNAMIC) return;
+
+    // Engine warnings from the inputs in alarm, hours from the RPM input
+    uint16_t status = 0;
+    bool hours = false;
+    uint32_t seconds = 0;
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        uint8_t index = routedFieldOf(n, i);
+        if (index == N2K_NO_FIELD) continue;
+        N2kField field = n2kGetField(index);
+        if (field.message != N2K_TX_TEMPERATURE && field.tag != 0 &&
+            inputs[i].alarmContext.state == ALARM_ACTIVE) {
+            status |= (uint16_t)1 << (field.tag - 1);
+        }
+        if (!hours && inputs[i].obd2pid == 0x0C) hours = getEngineSeconds(i, &seconds);
+    }
+    if (hours) {
+        for (uint8_t b = 0; b < 4; b++) {
+            message[11 + b] = (seconds >> (8 * b)) & 0xFF;
+        }
+    }
+    message[20] = status & 0xFF;
+    message[21] = status >> 8;
+}
+
+// One message as a single frame, or fast packet with the PGN's sequence counter
+static void sendN2kMessage(uint8_t bus, uint32_t id, const uint8_t* message, uint8_t len, uint8_t seq,
+                           uint16_t key) {
+    if (len <= 8) {
+        broadcastCANFrame(bus, id, message, 8, key, true);
+        return;
+    }
+    uint8_t frames = n2kFastPacketFrames(len);
+    uint8_t frame[8];
+    for (uint8_t i = 0; i < frames; i++) {
+        n2kFastPacketFrame(message, len, seq, i, frame);
+        queueCANTx(bus, id, frame, 8, true, CAN_TX_BROADCAST, CAN_TX_NO_KEY);  // In order, never replaced
+    }
+}
+
+/**
+ * Send the NMEA 2000 messages that are due, each PGN at its own interval
+ * Nothing while the address isn't claimed, or in the hold-off after a claim.
+ */
+static void sendN2kMessages(uint8_t n, uint32_t now) {
+    CANOutputInstance& out = canOutputs[n];
+    if (!out.claimed || (uint32_t)(now - out.n2k.claimMs) < N2K_CLAIM_HOLDOFF_MS) return;
+
+    uint8_t message[N2K_MAX_MESSAGE];
+    for (uint8_t m = 0; m < N2K_TX_MESSAGE_COUNT; m++) {
+        if ((int32_t)(now - out.n2k.dueMs[m]) < 0) continue;
+        N2kPgn pgn = n2kGetPgn(m);
+        // Advance from the previous deadline so the cadence doesn't drift; resync after a stall
+        out.n2k.dueMs[m] += pgn.intervalMs;
+        if ((int32_t)(now - out.n2k.dueMs[m]) >= 0) out.n2k.dueMs[m] = now + pgn.intervalMs;
+
+        uint32_t id = j1939BuildId(pgn.priority, pgn.pgn, J1939_GLOBAL_ADDRESS, out.claimedAddress);
+        if (m == N2K_TX_HEARTBEAT) {
+            n2kInitMessage(m, 0, out.n2k.seq[m], message);
+            out.n2k.seq[m] = out.n2k.seq[m] >= 252 ? 0 : out.n2k.seq[m] + 1;  // 253-255 reserved
+            broadcastCANFrame(out.bus, id, message, 8, 0, true);
+            continue;
+        }
+        for (uint8_t f = 0; f < out.frameCount; f++) {
+            if (out.frameMessage[f] != m) continue;
+            buildN2kMessage(n, f, message);
+            sendN2kMessage(out.bus, id, message, pgn.length, out.n2k.seq[m]++, f);
+        }
+    }
+}
+
+/**
+ * Rebuild the packed (J1939, NMEA 2000) layouts of both outputs
+ * Also drops the encoded signal cache - a changed sensor type changes the bytes.
+ */
+void rebuildCANBroadcastLayout() {
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        encodedSignals[i].valid = false;
+        encodedSignals[i].spn = j1939FindSpn(inputs[i].obd2pid);
+        encodedSignals[i].n2kField = n2kFindField(inputs[i].obd2pid);
+    }
+    for (uint8_t n = 0; n < CAN_OUTPUT_INSTANCES; n++) {
+        if (layoutOf(n) != CAN_OUTPUT_NMEA2000) stopN2kNetwork(n);
+
+        if (layoutOf(n) == CAN_OUTPUT_J1939) {
+            rebuildJ1939Layout(n);
+        } else if (layoutOf(n) == CAN_OUTPUT_NMEA2000) {
+            rebuildN2kLayout(n);
+        } else {
+            rebuildPackedLayout(n);
+        }
+    }
+}
+
+/**
+ * Send the frames holding values sent since the last flush
+ * Each frame carries the current value of all its signals.
+ */
+static void flushPackedFrames(uint8_t n) {
+    CANOutputInstance& out = canOutputs[n];
+    uint16_t baseId = baseIdOf(n);
+    bool j1939 = layoutOf(n) == CAN_OUTPUT_J1939;
+
+    for (uint8_t f = 0; f < out.frameCount; f++) {
+        if (!out.frameDirty[f]) continue;
+
+        byte data[8];
+        memset(data, j1939 ? 0xFF : 0x00, sizeof(data));
+        for (uint8_t s = out.frameFirst[f]; s < out.frameFirst[f + 1]; s++) {
+            const PackedSignal& sig = out.signals[s];
+            const EncodedSignal& encoded = getEncodedSignal(sig.input);
+            memcpy(&data[sig.start], j1939 ? encoded.j1939 : encoded.packed, sig.width);
+        }
+
+        if (j1939) {
+            broadcastCANFrame(out.bus, out.frameId[f], data, 8, 0, true);
+        } else {
+            broadcastCANFrame(out.bus, baseId + f, data, out.frameLen[f], 0);
+        }
+        out.frameDirty[f] = false;
+    }
+}
+
+// ===== LAYOUT EXPORT =====
+
+// DBC / RealDash identifier from the input's short name
+static void printSignalName(const Input* input) {
+    for (const char* c = input->abbrName; *c; c++) {
+        msg.control.print(isalnum((unsigned char)*c) ? *c : '_');
+    }
+}
+
+static void printJ1939LayoutTable(uint8_t n) {
+    const CANOutputInstance& out = canOutputs[n];
+    char line[64];
+    snprintf(line, sizeof(line), "J1939 %s layout: %d SPNs in %d PGNs from SA 0x%02X",
+             n == CAN_OUTPUT_PRIMARY ? "output" : "mirror", out.signalCount, out.frameCount,
+             systemConfig.buses.j1939_address);
+    msg.control.println(line);
+
+    for (uint8_t s = 0; s < out.signalCount; s++) {
+        const PackedSignal& sig = out.signals[s];
+        const Input* input = &inputs[sig.input];
+        J1939Spn spn = j1939GetSpn(encodedSignals[sig.input].spn);
+
+        if (sig.width == 2) {
+            snprintf(line, sizeof(line), "  PGN %5u  byte %d-%d  SPN %-4u %-8s x", spn.pgn,
+                     sig.start, sig.start + 1, spn.spn, input->abbrName);
+        } else {
+            snprintf(line, sizeof(line), "  PGN %5u  byte %d    SPN %-4u %-8s x", spn.pgn,
+                     sig.start, spn.spn, input->abbrName);
+        }
+        msg.control.print(line);
+        msg.control.print(spn.resolution, 5);
+        msg.control.print(F(" + "));
+        msg.control.print(spn.offset, 0);
+        msg.control.print(F(" "));
+        msg.control.println(getPackedUnits(input->measurementType));
+    }
+}
+
+static void printN2kLayoutTable(uint8_t n) {
+    const CANOutputInstance& out = canOutputs[n];
+    char line[72];
+    snprintf(line, sizeof(line), "NMEA 2000 %s layout: %d fields in %d messages",
+             instanceName(n), out.signalCount, out.frameCount);
+    msg.control.println(line);
+
+    if (out.bus == 0xFF) {
+        msg.control.println(F("  Address: not claimed (bus not running)"));
+    } else if (out.n2k.cannotClaim) {
+        msg.control.println(F("  Address: none free - not sending"));
+    } else {
+        snprintf(line, sizeof(line), "  Address: 0x%02X (preferred 0x%02X, %u contending claims)",
+                 out.claimedAddress, out.n2k.preferred, out.n2k.contentions);
+        msg.control.println(line);
+    }
+
+    for (uint8_t s = 0; s < out.signalCount; s++) {
+        const PackedSignal& sig = out.signals[s];
+        const Input* input = &inputs[sig.input];
+        N2kField field = n2kGetField(encodedSignals[sig.input].n2kField);
+        N2kPgn pgn = n2kGetPgn(out.frameMessage[sig.frame]);
+
+        snprintf(line, sizeof(line), "  PGN %6lu #%d  byte %d-%d  %-8s x", (unsigned long)pgn.pgn,
+                 out.frameInstance[sig.frame], sig.start, sig.start + 1, input->abbrName);
+        msg.control.print(line);
+        msg.control.print(field.resolution, 3);
+        msg.control.print(F(" + "));
+        msg.control.print(field.offset, 2);
+        msg.control.print(F(" "));
+        msg.control.println(getPackedUnits(input->measurementType));
+    }
+
+    // 127489 extras
+    bool hours = false;
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        uint8_t index = routedFieldOf(n, i);
+        if (index == N2K_NO_FIELD) continue;
+        N2kField field = n2kGetField(index);
+        if (field.message != N2K_TX_TEMPERATURE && field.tag != 0) {
+            snprintf(line, sizeof(line), "  PGN 127489     status bit %d  %s in alarm", field.tag - 1,
+                     inputs[i].abbrName);
+            msg.control.println(line);
+        }
+        if (!hours && inputs[i].obd2pid == 0x0C) {
+            uint32_t seconds;
+            hours = true;
+            msg.control.print(F("  PGN 127489     byte 11-14  engine hours of "));
+            msg.control.print(inputs[i].abbrName);
+            if (!getEngineSeconds(i, &seconds)) msg.control.print(F(" (no accumulator - not available)"));
+            msg.control.println();
+        }
+    }
+}
+
+static void printLayoutTable(uint8_t n) {
+    const CANOutputInstance& out = canOutputs[n];
+    uint16_t baseId = baseIdOf(n);
+    char line[64];
+    snprintf(line, sizeof(line), "Packed %s layout: %d signals in %d frames from 0x%03X",
+             n == CAN_OUTPUT_PRIMARY ? "output" : "mirror", out.signalCount, out.frameCount, baseId);
+    msg.control.println(line);
+    if (layoutOf(n) != CAN_OUTPUT_PACKED) {
+        msg.control.println(n == CAN_OUTPUT_PRIMARY ? F("  (not active - BUS CAN OUTPUT LAYOUT PACKED)")
+                                                    : F("  (not active - BUS CAN MIRROR LAYOUT PACKED)"));
+    }
+
+    for (uint8_t s = 0; s < out.signalCount; s++) {
+        const PackedSignal& sig = out.signals[s];
+        const Input* input = &inputs[sig.input];
+        PackedScale scale = getPackedScale(input->measurementType);
+
+        if (sig.width == 2) {
+            snprintf(line, sizeof(line), "  0x%03X  byte %d-%d  %-8s x", baseId + sig.frame,
+                     sig.start, sig.start + 1, input->abbrName);
+        } else {
+            snprintf(line, sizeof(line), "  0x%03X  byte %d    %-8s x", baseId + sig.frame,
+                     sig.start, input->abbrName);
+        }
+        msg.control.print(line);
+        msg.control.print(scale.factor, 2);
+        msg.control.print(F(" + "));
+        msg.control.print(scale.offset, 0);
+        msg.control.print(F(" "));
+        msg.control.println(getPackedUnits(input->measurementType));
+    }
+}
+
+static void printLayoutDBC(uint8_t n) {
+    const CANOutputInstance& out = canOutputs[n];
+    uint16_t baseId = baseIdOf(n);
+
+    msg.control.println(F("VERSION \"\""));
+    msg.control.println();
+    msg.control.println(F("NS_ :"));
+    msg.control.println();
+    msg.control.println(F("BS_:"));
+    msg.control.println();
+    msg.control.println(F("BU_: PREOBD"));
+
+    for (uint8_t f = 0; f < out.frameCount; f++) {
+        msg.control.println();
+        msg.control.print(F("BO_ "));
+        msg.control.print(baseId + f);
+        msg.control.print(F(" PREOBD_"));
+        msg.control.print(baseId + f, HEX);
+        msg.control.print(F(": "));
+        msg.control.print(out.frameLen[f]);
+        msg.control.println(F(" PREOBD"));
+
+        for (uint8_t s = out.frameFirst[f]; s < out.frameFirst[f + 1]; s++) {
+            const PackedSignal& sig = out.signals[s];
+            const Input* input = &inputs[sig.input];
+            PackedScale scale = getPackedScale(input->measurementType);
+            uint16_t maxRaw = (sig.width == 1) ? 0xFE : 0xFFFE;
+
+            msg.control.print(F(" SG_ "));
+            printSignalName(input);
+            msg.control.print(F(" : "));
+            msg.control.print(sig.start * 8);
+            msg.control.print(F("|"));
+            msg.control.print(sig.width * 8);
+            msg.control.print(F("@1+ ("));
+            msg.control.print(scale.factor, 2);
+            msg.control.print(F(","));
+            msg.control.print(scale.offset, 0);
+            msg.control.print(F(") ["));
+            msg.control.print(scale.offset, 0);
+            msg.control.print(F("|"));
+            msg.control.print(scale.offset + scale.factor * maxRaw, 2);
+            msg.control.print(F("] \""));
+            msg.control.print(getPackedUnits(input->measurementType));
+            msg.control.println(F("\" Vector__XXX"));
+        }
+    }
+
+    msg.control.println();
+    for (uint8_t s = 0; s < out.signalCount; s++) {
+        const PackedSignal& sig = out.signals[s];
+        const Input* input = &inputs[sig.input];
+        msg.control.print(F("CM_ SG_ "));
+        msg.control.print(baseId + sig.frame);
+        msg.control.print(F(" "));
+        printSignalName(input);
+        char name[INPUT_DISPLAY_NAME_LEN];
+        msg.control.print(F(" \""));
+        msg.control.print(getInputDisplayName(input, name));
+        msg.control.println(F("\";"));
+    }
+    for (uint8_t s = 0; s < out.signalCount; s++) {
+        const PackedSignal& sig = out.signals[s];
+        msg.control.print(F("VAL_ "));
+        msg.control.print(baseId + sig.frame);
+        msg.control.print(F(" "));
+        printSignalName(&inputs[sig.input]);
+        msg.control.print(sig.width == 1 ? F(" 255") : F(" 65535"));
+        msg.control.println(F(" \"Not available\" ;"));
+    }
+}
+
+static void printLayoutRealDash(uint8_t n) {
+    const CANOutputInstance& out = canOutputs[n];
+    uint16_t baseId = baseIdOf(n);
+
+    msg.control.println(F("<?xml version=\"1.0\" encoding=\"utf-8\"?>"));
+    msg.control.println(n == CAN_OUTPUT_PRIMARY
+        ? F("<!-- preOBD packed CAN layout (BUS CAN OUTPUT LAYOUT REALDASH) -->")
+        : F("<!-- preOBD packed CAN mirror layout (BUS CAN MIRROR LAYOUT REALDASH) -->"));
+    msg.control.println(F("<RealDashCAN version=\"2\">"));
+    msg.control.println(F("  <frames>"));
+
+    for (uint8_t f = 0; f < out.frameCount; f++) {
+        msg.control.print(F("    <frame id=\"0x"));
+        msg.control.print(baseId + f, HEX);
+        msg.control.println(F("\">"));
+
+        for (uint8_t s = out.frameFirst[f]; s < out.frameFirst[f + 1]; s++) {
+            const PackedSignal& sig = out.signals[s];
+            printRealDashValue(&inputs[sig.input], sig.start);
+        }
+        msg.control.println(F("    </frame>"));
+    }
+
+    msg.control.println(F("  </frames>"));
+    msg.control.println(F("</RealDashCAN>"));
+}
+
+void printCANBroadcastLayout(CanLayoutExport format, uint8_t instance) {
+    uint8_t n = instance == CAN_OUTPUT_MIRROR ? CAN_OUTPUT_MIRROR : CAN_OUTPUT_PRIMARY;
+    if (layoutOf(n) == CAN_OUTPUT_J1939) {
+        if (format != CAN_LAYOUT_TABLE) {
+            msg.control.println(F("J1939 layout uses standard SPNs - DBC / RealDash export covers the PACKED layout"));
+        }
+        printJ1939LayoutTable(n);
+        return;
+    }
+    if (layoutOf(n) == CAN_OUTPUT_NMEA2000) {
+        if (format != CAN_LAYOUT_TABLE) {
+            msg.control.println(F("NMEA 2000 layout uses standard PGNs - DBC / RealDash export covers the PACKED layout"));
+        }
+        printN2kLayoutTable(n);
+        return;
+    }
+    switch (format) {
+        case CAN_LAYOUT_DBC:      printLayoutDBC(n); break;
+        case CAN_LAYOUT_REALDASH: printLayoutRealDash(n); break;
+        default:                  printLayoutTable(n); break;
+    }
+}
+
+// ===== ISO-TP TRANSPORT =====
+
+static IsoTpReceiver obdRequestRx;  // Multi-frame requests (physical addressing only)
+static IsoTpSender obdResponseTx;   // Answers longer than a single frame
+
+/**
+ * Send the response frames that are due
+ * Consecutive Frames go out back to back unless the tester's STmin asks
+ * for a gap; the rest follow from updateCANOutput().
+ */
+static void pumpOBD2Response() {
+    byte frame[ISOTP_FRAME_LEN];
+    while (isotpNextFrame(&obdResponseTx, frame, micros())) {
+        if (!sendCANFrame(OBD2_RESPONSE_ID, frame, ISOTP_FRAME_LEN)) {
+            return;  // TX queue full - retried next loop
+        }
+        isotpFrameSent(&obdResponseTx, micros(), millis());
+    }
+}
+
+/**
+ * Send an OBD-II response message on 0x7E8 (Single Frame, or segmented)
+ * A new response replaces one still in progress.
+ */
+static void sendOBD2Message(const uint8_t* data, uint16_t len) {
+    if (len > 7) {
+        cancelCANTx(canOutputs[CAN_OUTPUT_PRIMARY].bus, OBD2_RESPONSE_ID);  // A broadcast frame between FF and CFs breaks reassembly
+    }
+    if (!isotpStartSend(&obdResponseTx, data, len)) {
+        msg.debug.warn(TAG_CAN, "OBD2 response too long (%u bytes)", len);
+        return;
+    }
+    pumpOBD2Response();
 }
 
 // ===== REQUEST PROCESSING =====
 
 /**
  * Send OBD-II negative response (ISO 14229-1)
- * @param requestId CAN ID of request (for logging)
+ * Functional requests get none - ECUs stay silent on what they don't support
+ * (ISO 15765-4), so a tester asking every ECU isn't flooded with refusals.
+ * @param requestId CAN ID of request
  * @param mode Service ID that failed
  * @param nrc Negative Response Code
  */
 static void sendNegativeResponse(uint32_t requestId, uint8_t mode, uint8_t nrc) {
-    byte frameData[8] = {0x03, 0x7F, mode, nrc, 0x00, 0x00, 0x00, 0x00};
-    //                    Len  Neg  Mode NRC
+    if (requestId == OBD2_FUNCTIONAL_ID) return;
 
-    sendCANFrame(0x7E8, frameData, 8);
+    uint8_t response[3] = {0x7F, mode, nrc};
+    //                     Neg   Mode  NRC
+    sendOBD2Message(response, sizeof(response));
 
     #ifdef DEBUG
-    (void)requestId;  // Used only for debug logging
     msg.debug.debug(TAG_CAN, "Sent negative response: NRC 0x%02X", nrc);
     #endif
 }
 
 /**
- * Send OBD-II Mode 01 response on CAN ID 0x7E8
- * @param input Input to respond with
+ * Answer Mode 01 (Show current data) for up to 6 PIDs in one response
+ * [0x41 pidA dataA... pidB dataB...] - PIDs without valid data are left out
+ * and no answer at all is NRC 0x31
  */
-static void sendOBD2Response(Input* input) {
-    byte frameData[8];
+static uint8_t sequenceOfPID(uint8_t pid) {
+    Input* input = findInputByPID(pid);
+    return input ? input->sequence : 0;
+}
+
+// Cached answer to exactly these PIDs, built from the values still current
+static bool responseCacheValid(const uint8_t* pids, uint8_t count) {
+    if (obdResponseCache.count != count || memcmp(obdResponseCache.pids, pids, count) != 0) {
+        return false;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        if (sequenceOfPID(pids[i]) != obdResponseCache.sequence[i]) return false;
+    }
+    return true;
+}
 
-    if (!buildOBD2Frame(frameData, input)) {
-        msg.debug.warn(TAG_CAN, "Failed to build OBD2 response");
+static void answerMode01(uint32_t canId, const uint8_t* pids, uint8_t count) {
+    if (count == 0 || count > OBD2_MAX_REQUEST_PIDS) {
+        sendNegativeResponse(canId, 0x01, 0x13);  // Incorrect message length
         return;
     }
 
-    sendCANFrame(0x7E8, frameData, 8);
+    // A scan tool polling faster than the inputs read gets the same bytes
+    if (responseCacheValid(pids, count)) {
+        obdGovernor.cacheHits++;
+        sendOBD2Message(obdResponseCache.response, obdResponseCache.length);
+        return;
+    }
+
+    uint8_t response[ISOTP_MAX_PAYLOAD];
+    uint16_t len = 0;
+    response[len++] = 0x41;
+
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t pid = pids[i];
+
+        #ifdef DEBUG
+        msg.debug.debug(TAG_CAN, "OBD-II Request: Mode=0x01 PID=0x%02X", pid);
+        #endif
+
+        if ((pid & 0x1F) == 0) {
+            // Supported PIDs bitmap - 00 always, the later ones if the previous advertised them
+            if (pid != 0x00 && !hasPIDAbove(pid)) continue;
+            if (len + 5 > ISOTP_MAX_PAYLOAD) break;
+            response[len++] = pid;
+            generateSupportedBitmap(pid, &response[len]);
+
+            #ifdef DEBUG
+            msg.debug.debug(TAG_CAN, "PID %02X bitmap: %02X %02X %02X %02X", pid,
+                           response[len], response[len + 1], response[len + 2], response[len + 3]);
+            #endif
+            len += 4;
+            continue;
+        }
+
+        // Lookup PID in active inputs
+        Input* input = findInputByPID(pid);
+        if (input == nullptr || isnan(input->value)) {
+            continue;  // PID not supported or no valid data
+        }
+        if (len + 1 + input->obd2length > ISOTP_MAX_PAYLOAD) break;
+
+        uint8_t dataBytes = encodeOBD2Data(&response[len + 1], input);
+        if (dataBytes == 0) {
+            msg.debug.warn(TAG_CAN, "Failed to build OBD2 response");
+            continue;
+        }
+        response[len] = pid;
+        len += 1 + dataBytes;
+    }
+
+    if (len == 1) {
+        sendNegativeResponse(canId, 0x01, 0x31);  // Request out of range
+        return;
+    }
+
+    memcpy(obdResponseCache.pids, pids, count);
+    for (uint8_t i = 0; i < count; i++) {
+        obdResponseCache.sequence[i] = sequenceOfPID(pids[i]);
+    }
+    memcpy(obdResponseCache.response, response, len);
+    obdResponseCache.length = len;
+    obdResponseCache.count = count;
+
+    sendOBD2Message(response, len);
+}
+
+/**
+ * Answer Mode 09 (Vehicle information) - one PID per request on CAN
+ * PID 00: supported PIDs, PID 02: VIN (OBD2_VIN, 20 bytes - multi-frame)
+ */
+static void answerMode09(uint32_t canId, const uint8_t* pids, uint8_t count) {
+    if (count != 1) {
+        sendNegativeResponse(canId, 0x09, 0x13);  // Incorrect message length
+        return;
+    }
+
+    uint8_t response[3 + OBD2_VIN_LENGTH];
+    response[0] = 0x49;
+    response[1] = pids[0];
+
+    switch (pids[0]) {
+        case 0x00:
+            response[2] = 0x40;  // PID 02 (VIN)
+            response[3] = 0x00;
+            response[4] = 0x00;
+            response[5] = 0x00;
+            sendOBD2Message(response, 6);
+            break;
+
+        case 0x02:
+            response[2] = 0x01;  // Number of data items
+            memcpy(&response[3], OBD2_VIN, OBD2_VIN_LENGTH);
+            sendOBD2Message(response, sizeof(response));
+            break;
+
+        default:
+            sendNegativeResponse(canId, 0x09, 0x31);  // Request out of range
+            break;
+    }
+}
+
+/**
+ * Admit a complete request, or drop it (flood protection)
+ * - A copy of the last answered request while that answer is still being
+ *   segmented, or on the other address within OBD2_DUPLICATE_WINDOW_MS
+ *   (a tester asking both functionally and physically), is dropped.
+ * - Requests on one address closer than OBD2_MIN_REQUEST_INTERVAL_MS are
+ *   dropped - the tester times out and asks again.
+ */
+static bool admitOBD2Request(uint32_t canId, const uint8_t* message, uint16_t len, uint32_t rxMs) {
+    OBD2RequestGovernor& g = obdGovernor;
+    uint8_t addr = canId == OBD2_FUNCTIONAL_ID ? OBD2_ADDR_FUNCTIONAL : OBD2_ADDR_PHYSICAL;
+    g.requests++;
+
+    bool same = len == g.lastRequestLen && memcmp(message, g.lastRequest, len) == 0;
+    if (same) {
+        uint8_t other = g.lastRequestAddr;
+        bool copy = isotpSending(&obdResponseTx) ||
+                    (addr != other && (uint32_t)(rxMs - g.lastAnsweredMs[other]) < OBD2_DUPLICATE_WINDOW_MS);
+        if (copy) {
+            g.duplicates++;
+            return false;
+        }
+    }
+
+    if (OBD2_MIN_REQUEST_INTERVAL_MS > 0 && g.answered[addr] &&
+        (uint32_t)(rxMs - g.lastAnsweredMs[addr]) < OBD2_MIN_REQUEST_INTERVAL_MS) {
+        g.limited++;
+        return false;
+    }
+
+    g.answered[addr] = true;
+    g.lastAnsweredMs[addr] = rxMs;
+    if (len <= sizeof(g.lastRequest)) {
+        memcpy(g.lastRequest, message, len);
+        g.lastRequestLen = len;
+        g.lastRequestAddr = addr;
+    } else {
+        g.lastRequestLen = 0;  // Longer than any request worth deduplicating
+    }
+    return true;
 }
 
 /**
- * Parse and process OBD-II Mode 01 request
+ * Dispatch a complete request message [mode, PID...]
+ */
+static void handleOBD2Message(uint32_t canId, const uint8_t* message, uint16_t len, uint32_t rxMs) {
+    if (!admitOBD2Request(canId, message, len, rxMs)) return;
+
+    uint8_t mode = message[0];
+
+    switch (mode) {
+        case 0x01:
+            answerMode01(canId, &message[1], len - 1);
+            break;
+        case 0x09:
+            answerMode09(canId, &message[1], len - 1);
+            break;
+        default:
+            sendNegativeResponse(canId, mode, 0x11);  // Service not supported
+            break;
+    }
+}
+
+/**
+ * Parse and process an OBD-II request frame
  * Handles both functional (0x7DF) and physical (0x7E0) addressing
  *
  * Frame format (ISO 15765-4):
- *   [0] = Length (2 for Mode 01)
- *   [1] = Mode (0x01 = Show current data)
- *   [2] = PID
- *   [3-7] = Unused (padding)
+ *   Single Frame: [0] = Length, [1] = Mode, [2..] = PIDs (up to 6 for Mode 01)
+ *   Flow Control for a multi-frame answer (physical address only)
+ *   First/Consecutive Frames of a longer request (physical address only)
  *
  * @param canId CAN ID of received request
  * @param data Received frame data
  * @param len Frame data length
+ * @param rxMs millis() when the frame was received
  */
-static void processOBD2Request(uint32_t canId, const byte* data, uint8_t len) {
-    // Validate minimum frame structure
-    if (len < 3) return;
+static void processOBD2Request(uint32_t canId, const byte* data, uint8_t len, uint32_t rxMs) {
+    if (len == 0) return;
 
-    // data[0] is frame length, not validated per OBD-II spec
-    uint8_t mode = data[1];
-    uint8_t pid = data[2];
+    uint8_t type = data[0] >> 4;
+    if (type == ISOTP_FLOW_CONTROL) {
+        if (canId == OBD2_PHYSICAL_ID &&
+            isotpHandleFlowControl(&obdResponseTx, data, len, rxMs) == ISOTP_TX_CONTINUE) {
+            pumpOBD2Response();
+        }
+        return;
+    }
 
-    #ifdef DEBUG
-    msg.debug.debug(TAG_CAN, "OBD-II Request: Mode=0x%02X PID=0x%02X", mode, pid);
-    #endif
+    // Functional requests are single frames only
+    if (canId == OBD2_FUNCTIONAL_ID && type != ISOTP_SINGLE_FRAME) return;
 
-    // Only handle Mode 01 (Show current data)
-    if (mode != 0x01) {
-        sendNegativeResponse(canId, mode, 0x12);  // Sub-function not supported
-        return;
+    byte flow[ISOTP_FRAME_LEN];
+    switch (isotpReceive(&obdRequestRx, data, len, rxMs)) {
+        case ISOTP_RX_FIRST_FRAME:
+            isotpBuildFlowControl(flow, ISOTP_FC_CONTINUE, 0, 0);
+            sendCANFrame(OBD2_RESPONSE_ID, flow, ISOTP_FRAME_LEN);
+            break;
+
+        case ISOTP_RX_OVERFLOW:
+            isotpBuildFlowControl(flow, ISOTP_FC_OVERFLOW, 0, 0);
+            sendCANFrame(OBD2_RESPONSE_ID, flow, ISOTP_FRAME_LEN);
+            break;
+
+        case ISOTP_RX_COMPLETE:
+            handleOBD2Message(canId, obdRequestRx.data, obdRequestRx.length, rxMs);
+            break;
+
+        default:
+            break;  // More frames to come, or a malformed request
     }
+}
 
-    // Special case: PID 00 (Supported PIDs 0x01-0x20)
-    if (pid == 0x00) {
-        sendPID00Response();
-        return;
+/**
+ * CAN RX pump handler (lib/can_rx.h) - OBD-II requests on the output bus
+ */
+static bool handleOBD2Request(const hal::can::CanRxFrame& frame) {
+    if (frame.extended || !systemConfig.buses.can_output_enabled ||
+        canOutputs[CAN_OUTPUT_PRIMARY].bus == 0xFF) {
+        return false;  // Output not configured
     }
+    processOBD2Request(frame.id, frame.data, frame.len, frame.rxMs);
+    return true;
+}
 
-    // Lookup PID in active inputs
-    Input* input = findInputByPID(pid);
-    if (input == nullptr || isnan(input->value)) {
-        // PID not supported or no valid data
-        sendNegativeResponse(canId, mode, 0x31);  // Request out of range
+/**
+ * Broadcast one input's current value on an instance
+ * Packed / J1939: marks the input's frame - flushPackedFrames() sends it
+ * with its neighbours. OBD: one Mode 01 style frame on 0x7E8, keyed by PID.
+ * NMEA 2000: nothing - the PGN schedule takes the value (sendN2kMessages()).
+ */
+static void broadcastInput(uint8_t n, uint8_t slot) {
+    CANOutputInstance& out = canOutputs[n];
+
+    if (layoutOf(n) == CAN_OUTPUT_NMEA2000) return;
+
+    if (isFrameLayout(n)) {
+        uint8_t sig = out.signalOf[slot];
+        if (sig) out.frameDirty[out.signals[sig - 1].frame] = true;
         return;
     }
 
-    // Build and send response
-    sendOBD2Response(input);
-}
+    if (n == CAN_OUTPUT_PRIMARY && isotpSending(&obdResponseTx)) {
+        return;  // A single frame on 0x7E8 would abort the tester's reassembly
+    }
 
-void initCAN() {
-    // Check if output is enabled
-    if (!systemConfig.buses.can_output_enabled) {
-        return;
+    // ISO 15765-4 single frame: [length, 0x41, PID, data...]
+    byte frameData[8];
+    if (!buildOBD2Frame(frameData, &inputs[slot])) {
+        return;  // Invalid data size
     }
 
-    canOutputBus = systemConfig.buses.output_can_bus;
-    if (canOutputBus == 0xFF) {
-        return;  // No output bus configured
+    // Send on standard OBDII ECU response ID - one queued frame per PID
+    broadcastCANFrame(out.bus, OBD2_RESPONSE_ID, frameData, 8, inputs[slot].obd2pid);
+}
+
+/**
+ * Broadcast the mirror's inputs every can_mirror_interval
+ */
+static void updateCANMirror() {
+    if (canOutputs[CAN_OUTPUT_MIRROR].bus == 0xFF) return;
+
+    uint32_t now = millis();
+    if ((int32_t)(now - mirrorNextSend) < 0) return;
+
+    uint16_t interval = systemConfig.buses.can_mirror_interval;
+    // Advance from the previous deadline so the cadence doesn't drift; resync after a stall
+    mirrorNextSend += interval;
+    if ((int32_t)(now - mirrorNextSend) >= 0) mirrorNextSend = now + interval;
+
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        if (!inputs[i].flags.isEnabled || isnan(inputs[i].value)) continue;
+        if (!(inputs[i].outputMask & maskOf(CAN_OUTPUT_MIRROR))) continue;
+        broadcastInput(CAN_OUTPUT_MIRROR, i);
     }
+}
 
-    uint32_t baudrate = systemConfig.buses.can_output_baudrate;
+void updateCANOutput() {
+    uint32_t now = millis();
+    updateCANMirror();
+    if (canOutputs[CAN_OUTPUT_MIRROR].bus != 0xFF) {
+        if (isFrameLayout(CAN_OUTPUT_MIRROR)) flushPackedFrames(CAN_OUTPUT_MIRROR);
+        if (layoutOf(CAN_OUTPUT_MIRROR) == CAN_OUTPUT_NMEA2000) sendN2kMessages(CAN_OUTPUT_MIRROR, now);
+    }
 
-    // Initialize CAN bus via HAL
-    if (!hal::can::begin(baudrate, canOutputBus)) {
-        msg.debug.error(TAG_CAN, "CAN output init failed on bus %d!", canOutputBus);
+    if (!systemConfig.buses.can_output_enabled || canOutputs[CAN_OUTPUT_PRIMARY].bus == 0xFF) {
         return;
     }
+    if (layoutOf(CAN_OUTPUT_PRIMARY) == CAN_OUTPUT_NMEA2000) sendN2kMessages(CAN_OUTPUT_PRIMARY, now);
+    if (isotpCheckSendTimeout(&obdResponseTx, millis())) {
+        msg.debug.warn(TAG_CAN, "OBD-II response dropped - no flow control from tester");
+    }
+    pumpOBD2Response();
+}
+
+/**
+ * Bring up the mirror bus (broadcast only - no request handlers or filters)
+ * A bus shared with CAN input keeps the input's initialization.
+ */
+static void initCANMirror() {
+    uint8_t bus = systemConfig.buses.can_mirror_bus;
+    if (bus == 0xFF) return;
 
-    // Configure RX filters for OBD-II requests
-    hal::can::setFilters(0x7DF, 0x7E0, canOutputBus);  // Functional and physical addressing
+    if (bus == canOutputs[CAN_OUTPUT_PRIMARY].bus) {
+        msg.debug.warn(TAG_CAN, "CAN mirror on the output bus %d - mirror disabled", bus);
+        return;
+    }
 
-    msg.debug.info(TAG_CAN, "CAN output initialized on bus %d (%lu bps)", canOutputBus, baudrate);
-    msg.debug.info(TAG_CAN, "OBD-II request/response enabled");
+    bool sharedWithInput = systemConfig.buses.can_input_mode != CAN_INPUT_OFF &&
+                           systemConfig.buses.input_can_bus == bus;
+    if (sharedWithInput && systemConfig.buses.can_input_mode == CAN_INPUT_LISTEN) {
+        msg.debug.warn(TAG_CAN, "CAN mirror bus %d is listen-only input - mirror disabled", bus);
+        return;
+    }
+    if (!sharedWithInput && !hal::can::begin(systemConfig.buses.can_mirror_baudrate, bus)) {
+        msg.debug.error(TAG_CAN, "CAN mirror init failed on bus %d!", bus);
+        return;
+    }
 
-    // Build PID lookup table for request/response
-    buildPIDLookupTable();
+    canOutputs[CAN_OUTPUT_MIRROR].bus = bus;
+    mirrorNextSend = millis();
+    msg.debug.info(TAG_CAN, "CAN mirror on bus %d every %u ms", bus, systemConfig.buses.can_mirror_interval);
 }
 
-void sendCAN(Input *ptr) {
-    if (!systemConfig.buses.can_output_enabled || canOutputBus == 0xFF) {
-        return;  // Output not configured
+uint8_t getCANOutputFilterRules(uint8_t bus, hal::can::CanFilterRule* rules) {
+    uint8_t count = 0;
+    bool primary = systemConfig.buses.can_output_enabled && systemConfig.buses.output_can_bus == bus;
+    if (primary) {
+        // Functional and physical addressing, and the node IDs if this unit is one
+        rules[count++] = { OBD2_FUNCTIONAL_ID, HAL_CAN_STD_MASK, false };
+        rules[count++] = { OBD2_PHYSICAL_ID, HAL_CAN_STD_MASK, false };
+        if (getCANNodeFilterRule(&rules[count])) count++;
     }
+    bool n2k = (primary && layoutOf(CAN_OUTPUT_PRIMARY) == CAN_OUTPUT_NMEA2000) ||
+               (systemConfig.buses.can_mirror_bus == bus && layoutOf(CAN_OUTPUT_MIRROR) == CAN_OUTPUT_NMEA2000);
+    if (n2k) rules[count++] = { N2K_NETWORK_ID, N2K_NETWORK_MASK, true };
+    return count;
+}
 
-    if (isnan(ptr->value)) {
-        return;  // Don't send invalid data
+void applyCANOutputFilters() {
+    uint8_t inputBus = systemConfig.buses.can_input_mode != CAN_INPUT_OFF ? systemConfig.buses.input_can_bus : 0xFF;
+    uint8_t bus = canOutputs[CAN_OUTPUT_PRIMARY].bus;
+
+    // Shared bus - input subscriptions plus the output's rules
+    if (inputBus != 0xFF && (bus == inputBus || canOutputs[CAN_OUTPUT_MIRROR].bus == inputBus)) {
+        applyCANInputFilters();
     }
+    if (bus == 0xFF || bus == inputBus) return;
 
-    byte frameData[8];
+    hal::can::CanFilterRule rules[CAN_OUTPUT_FILTER_RULES];
+    hal::can::setFilterRules(rules, getCANOutputFilterRules(bus, rules), bus);
+}
 
-    // Build OBDII frame using shared helper (fixes length byte and endianness)
-    if (!buildOBD2Frame(frameData, ptr)) {
-        return;  // Invalid data size
+void initCAN() {
+    noteStaticMemory(F("CAN PID index + signals"), sizeof(pidIndex) + sizeof(encodedSignals));
+
+    // Check if output is enabled
+    if (systemConfig.buses.can_output_enabled && systemConfig.buses.output_can_bus != 0xFF) {
+        uint8_t bus = systemConfig.buses.output_can_bus;
+        uint32_t baudrate = systemConfig.buses.can_output_baudrate;
+
+        // Initialize CAN bus via HAL
+        if (hal::can::begin(baudrate, bus)) {
+            canOutputs[CAN_OUTPUT_PRIMARY].bus = bus;
+
+            // Requests arrive through the RX pump - shared with CAN input on the same bus
+            unregisterCANRxHandler(handleOBD2Request);
+            registerCANRxHandler("OBD_REQ", bus, OBD2_FUNCTIONAL_ID, HAL_CAN_STD_MASK, handleOBD2Request);
+            registerCANRxHandler("OBD_REQ", bus, OBD2_PHYSICAL_ID, HAL_CAN_STD_MASK, handleOBD2Request);  // Also flow control
+
+            // Configure RX filters for OBD-II requests
+            applyCANOutputFilters();
+
+            msg.debug.info(TAG_CAN, "CAN output initialized on bus %d (%lu bps)", bus, baudrate);
+            msg.debug.info(TAG_CAN, "OBD-II request/response enabled");
+        } else {
+            msg.debug.error(TAG_CAN, "CAN output init failed on bus %d!", bus);
+        }
     }
 
-    // Send on standard OBDII ECU response ID
-    hal::can::write(0x7E8, frameData, 8, false, canOutputBus);
+    initCANMirror();
+
+    // Build PID index for request/response and the packed broadcast layouts
+    // (both rebuilt on every input config change)
+    rebuildOBD2PIDIndex();
+    rebuildCANBroadcastLayout();
+}
+
+void printOBD2RequestStats() {
+    const OBD2RequestGovernor& g = obdGovernor;
+    if (canOutputs[CAN_OUTPUT_PRIMARY].bus == 0xFF || g.requests == 0) return;
+
+    msg.control.print(F("OBD-II: "));
+    msg.control.print(g.requests);
+    msg.control.print(F(" requests, "));
+    msg.control.print(g.limited);
+    msg.control.print(F(" rate-limited, "));
+    msg.control.print(g.duplicates);
+    msg.control.print(F(" duplicates, "));
+    msg.control.print(g.cacheHits);
+    msg.control.println(F(" cached answers"));
+}
+
+uint8_t getCANOutputBus() {
+    return systemConfig.buses.can_output_enabled ? canOutputs[CAN_OUTPUT_PRIMARY].bus : 0xFF;
 }
 
-void updateCAN() {
-    if (!systemConfig.buses.can_output_enabled || canOutputBus == 0xFF) {
+void sendCANBatch(const uint8_t* slots, uint8_t count, const InputSample* samples, uint32_t now) {
+    (void)samples;  // Packed frames encode from the snapshot (getEncodedSignal), PIDs at read time
+    (void)now;
+    if (!systemConfig.buses.can_output_enabled || canOutputs[CAN_OUTPUT_PRIMARY].bus == 0xFF) {
         return;  // Output not configured
     }
 
-    // Process incoming OBD-II requests (request/response mode)
-    uint32_t id;
-    uint8_t data[8];
-    uint8_t len;
-    bool extended;
-
-    while (hal::can::read(id, data, len, extended, canOutputBus)) {
-        // Check if this is an OBD-II request
-        if (id == 0x7DF || id == 0x7E0) {
-            processOBD2Request(id, data, len);
-        }
+    for (uint8_t k = 0; k < count; k++) {
+        broadcastInput(CAN_OUTPUT_PRIMARY, slots[k]);
+    }
+    if (isFrameLayout(CAN_OUTPUT_PRIMARY)) {
+        flushPackedFrames(CAN_OUTPUT_PRIMARY);  // Each frame once, holding the whole tick
     }
 }
 
@@ -313,7 +1635,16 @@ void updateCAN() {
 
 // Dummy functions if CAN is disabled
 void initCAN() {}
-void sendCAN(Input *ptr) { (void)ptr; }
-void updateCAN() {}
+void sendCANBatch(const uint8_t* slots, uint8_t count, const InputSample* samples, uint32_t now) {
+    (void)slots; (void)count; (void)samples; (void)now;
+}
+void updateCANOutput() {}
+uint8_t getCANOutputBus() { return 0xFF; }
+void rebuildOBD2PIDIndex() {}
+void printOBD2RequestStats() {}
+void rebuildCANBroadcastLayout() {}
+uint8_t getCANOutputFilterRules(uint8_t bus, hal::can::CanFilterRule* rules) { (void)bus; (void)rules; return 0; }
+void applyCANOutputFilters() {}
+void printCANBroadcastLayout(CanLayoutExport format, uint8_t instance) { (void)format; (void)instance; }
 
 #endif
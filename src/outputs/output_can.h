@@ -0,0 +1,92 @@
+/*
+ * output_can.h - CAN bus output module
+ *
+ * initCAN() / sendCANBatch() are the output module hooks (output_manager.cpp);
+ * a batch queues a frame per PID, or in the packed layouts fills the
+ * broadcast frames and sends each of them once.
+ * OBD-II requests are answered from the CAN RX pump; answers longer than
+ * one frame (multi-PID Mode 01, Mode 09 VIN) go out over ISO-TP, and
+ * updateCANOutput() sends the Consecutive Frames the tester's flow control
+ * holds back (STmin, block size).
+ *
+ * A second, broadcast-only instance (the mirror) sends the inputs routed
+ * to OUTPUT_CAN_MIRROR on can_mirror_bus with its own layout and interval,
+ * paced from updateCANOutput(). It runs while the CAN output module does.
+ */
+
+#ifndef OUTPUT_CAN_H
+#define OUTPUT_CAN_H
+
+#include <Arduino.h>
+#include "../inputs/input.h"
+#include "../inputs/input_snapshot.h"
+#include "../hal/hal_can_filter.h"
+
+void initCAN();
+void sendCANBatch(const uint8_t* slots, uint8_t count, const InputSample* samples, uint32_t now);
+
+/**
+ * Rebuild the PID -> input index the OBD-II responder answers from
+ * Called whenever the input schedule is rebuilt or an input's PID changes.
+ */
+void rebuildOBD2PIDIndex();
+
+/**
+ * Rebuild the packed broadcast layouts (CAN_OUTPUT_PACKED)
+ * Inputs routed to CAN (or the mirror) are packed in slot order into frames
+ * from the instance's base ID up, so enabling or routing an input moves the
+ * signals after it - export the layout again after a change. An instance
+ * in the J1939 layout (CAN_OUTPUT_J1939) groups its inputs by the PGN of
+ * their standard SPN instead, and claims its source address on first build;
+ * one in the NMEA 2000 layout (CAN_OUTPUT_NMEA2000) builds its engine and
+ * temperature messages the same way and joins the network's address claiming.
+ */
+void rebuildCANBroadcastLayout();
+
+enum CanLayoutExport : uint8_t {
+    CAN_LAYOUT_TABLE,       // Human-readable signal list
+    CAN_LAYOUT_DBC,         // Vector DBC
+    CAN_LAYOUT_REALDASH     // RealDash CAN XML channel description
+};
+
+/**
+ * Print a packed (J1939, NMEA 2000) broadcast layout to the control port
+ * @param instance  0 = CAN output, 1 = mirror
+ */
+void printCANBroadcastLayout(CanLayoutExport format, uint8_t instance = 0);
+
+/**
+ * Print OBD-II request counters (answered, rate-limited, duplicates, cache
+ * hits) to the control port - nothing until a tester has asked
+ */
+void printOBD2RequestStats();
+
+/**
+ * Continue a multi-frame OBD-II response and send the mirror's inputs when
+ * its interval is due
+ * Called from main loop after pumpCANRx(), in RUN mode.
+ */
+void updateCANOutput();
+
+/**
+ * Bus the CAN output broadcasts on (0xFF = output disabled or not configured)
+ */
+uint8_t getCANOutputBus();
+
+/**
+ * Program the output bus acceptance filters: OBD-II request IDs, the node
+ * protocol (lib/can_node.h) and NMEA 2000 network management, plus the
+ * input subscriptions on a shared bus
+ */
+void applyCANOutputFilters();
+
+#define CAN_OUTPUT_FILTER_RULES 4
+
+/**
+ * Acceptance rules for the frames the outputs answer on a bus
+ * @param rules  Room for CAN_OUTPUT_FILTER_RULES
+ * @return  Rules written (0 = no output listens on the bus)
+ */
+uint8_t getCANOutputFilterRules(uint8_t bus, hal::can::CanFilterRule* rules);
+
+#endif // OUTPUT_CAN_H
@@ -0,0 +1,73 @@
+/*
+ * output_frame.cpp - Data plane frame assembly for output modules
+ */
+
+#include "output_frame.h"
+#include "../lib/message_api.h"
+#include "../lib/float_format.h"
+
+OutputFrame outputFrame;
+
+uint8_t* OutputFrame::reserve(uint16_t n) {
+    if (n > OUTPUT_FRAME_ARENA_SIZE) return nullptr;
+    if (len + n > OUTPUT_FRAME_ARENA_SIZE) {
+        splits++;
+        commit();  // Send what we have - the tick continues in a new write
+    }
+    return &buf[len];
+}
+
+void OutputFrame::append(const uint8_t* data, uint16_t n) {
+    while (n > 0) {
+        uint16_t chunk = n < OUTPUT_FRAME_ARENA_SIZE ? n : OUTPUT_FRAME_ARENA_SIZE;
+        uint8_t* p = reserve(chunk);
+        memcpy(p, data, chunk);
+        advance(chunk);
+        data += chunk;
+        n -= chunk;
+    }
+}
+
+void OutputFrame::print(const char* str) {
+    if (str) append((const uint8_t*)str, strlen(str));
+}
+
+void OutputFrame::print(const __FlashStringHelper* str) {
+    if (!str) return;
+    const char* p = reinterpret_cast<const char*>(str);
+    uint16_t n = strlen_P(p);
+    if (n > OUTPUT_FRAME_ARENA_SIZE) n = OUTPUT_FRAME_ARENA_SIZE;  // Unit strings and labels only
+    uint8_t* dst = reserve(n);
+    memcpy_P(dst, p, n);
+    advance(n);
+}
+
+void OutputFrame::print(char c) {
+    uint8_t* p = reserve(1);
+    *p = (uint8_t)c;
+    advance(1);
+}
+
+void OutputFrame::print(float value, uint8_t digits) {
+    char* p = (char*)reserve(FLOAT_FORMAT_SIZE);
+    advance(formatFixed(p, value, digits));
+}
+
+void OutputFrame::println() {
+    uint8_t* p = reserve(2);
+    p[0] = '\r';
+    p[1] = '\n';
+    advance(2);
+}
+
+void OutputFrame::commit() {
+    if (len == 0) return;
+#ifdef ENABLE_DUAL_CORE
+    DualCoreOutputGuard guard;  // The stream stays ours until the write is done
+#endif
+    router.setDataStream((DataStream)stream);
+    msg.data.write(buf, len);
+    router.setDataStream(DATA_STREAM_TEXT);
+    len = 0;
+    commits++;
+}
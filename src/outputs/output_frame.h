@@ -0,0 +1,89 @@
+/*
+ * output_frame.h - Data plane frame assembly for output modules
+ *
+ * Every msg.data.print()/write() walks the data plane's targets and makes
+ * a virtual call on each -
+ * the CSV output paid that four times per input, and the bytes of one
+ * interval reached a BLE link as a string of tiny notifications. Output
+ * modules assemble into a fixed scratch arena instead:
+ *
+ *   outputFrame.print(ptr->abbrName);     // From the module's send()
+ *   outputFrame.print(',');
+ *   ...
+ *   outputFrame.commit();                 // One msg.data.write() per tick
+ *
+ * sendToOutputs() commits after each module's batch, so everything a module
+ * sends in one interval goes out as one contiguous write per transport and
+ * the arena is empty between modules. If a batch outgrows the arena the
+ * bytes held so far are committed first (reserve()), so nothing is lost -
+ * the tick just takes more than one write. Output runs in the main loop
+ * only; the arena is not for interrupt context.
+ *
+ * The frame carries the DataStream of the module filling it (setStream(),
+ * from the output manager), so the router's data plane profiles can send
+ * each module's output only to the transports that take it.
+ *
+ * Build Flags:
+ *   -D OUTPUT_FRAME_ARENA_SIZE=n  - Arena bytes (default 128 on Uno, 256 on
+ *                                   other AVR, 2048 elsewhere)
+ */
+
+#ifndef OUTPUT_FRAME_H
+#define OUTPUT_FRAME_H
+
+#include <Arduino.h>
+
+#ifndef OUTPUT_FRAME_ARENA_SIZE
+  #if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
+    #define OUTPUT_FRAME_ARENA_SIZE 128
+  #elif defined(__AVR__)
+    #define OUTPUT_FRAME_ARENA_SIZE 256
+  #else
+    #define OUTPUT_FRAME_ARENA_SIZE 2048
+  #endif
+#endif
+
+class OutputFrame {
+public:
+    /**
+     * Space for n contiguous bytes at the end of the frame
+     * Commits what is already held if n doesn't fit behind it.
+     * @return  Pointer to fill, then advance(n) - nullptr if n exceeds the arena
+     */
+    uint8_t* reserve(uint16_t n);
+    void advance(uint16_t n) { len += n; }
+
+    void append(const uint8_t* data, uint16_t n);
+    void print(const char* str);
+    void print(const __FlashStringHelper* str);
+    void print(char c);
+    void print(float value, uint8_t digits);
+    void println();
+
+    // Write everything held to the data plane in one call and start over
+    void commit();
+
+    // Drop everything held unwritten (benchmarks of the serializers)
+    void discard() { len = 0; }
+
+    // DataStream (message_router.h) the following commits belong to
+    void setStream(uint8_t s) { stream = s; }
+
+    uint16_t length() const { return len; }
+
+    // Statistics
+    uint32_t getCommits() const { return commits; }
+    uint32_t getSplits() const { return splits; }   // Ticks that outgrew the arena
+
+private:
+    uint8_t buf[OUTPUT_FRAME_ARENA_SIZE];
+    uint16_t len = 0;
+    uint8_t stream = 0;     // DATA_STREAM_TEXT
+    uint32_t commits = 0;
+    uint32_t splits = 0;
+};
+
+// Data plane frame shared by the output modules (one module assembles at a time)
+extern OutputFrame outputFrame;
+
+#endif // OUTPUT_FRAME_H
@@ -3,31 +3,35 @@
  */
 
 #include "output_base.h"
+#include "output_frame.h"
+#include "output_serial.h"
+#include "output_mqtt.h"
 #include "../config.h"
 #include "../inputs/input_manager.h"
 #include "../lib/message_router.h"
 #include "../lib/message_api.h"
+#include "../lib/profiler.h"
+#include "../lib/latency_trace.h"
+#include "../lib/dual_core.h"
+#if defined(USE_STATIC_CONFIG) && __has_include("../lib/generated/static_manifest.h")
+#include "../lib/generated/static_manifest.h"  // Outputs a static config leaves out
+#endif
 
 // Output mask filtering relies on OutputID enum values matching outputModules[] indices
 static_assert(OUTPUT_CAN == 0 && OUTPUT_REALDASH == 1 &&
-              OUTPUT_SERIAL == 2 && OUTPUT_SD == 3,
-              "OutputID data output enum values must be 0-3 for per-input mask filtering");
+              OUTPUT_SERIAL == 2 && OUTPUT_SD == 3 && OUTPUT_MQTT == 4,
+              "OutputID data output enum values must be 0-4 for per-input mask filtering");
 
 // Declare external functions from output modules
 extern void initCAN();
-extern void sendCAN(Input*);
-extern void updateCAN();
+extern void sendCANBatch(const uint8_t* slots, uint8_t count, const InputSample* samples, uint32_t now);
 
 extern void initRealdash();
-extern void sendRealdash(Input*);
+extern void sendRealdashBatch(const uint8_t* slots, uint8_t count, const InputSample* samples, uint32_t now);
 extern void updateRealdash();
 
-extern void initSerialOutput();
-extern void sendSerialOutput(Input*);
-extern void updateSerialOutput();
-
 extern void initSDLog();
-extern void sendSDLog(Input*);
+extern void sendSDLogBatch(const uint8_t* slots, uint8_t count, const InputSample* samples, uint32_t now);
 extern void updateSDLog();
 
 extern void initAlarmOutput();
@@ -40,65 +44,297 @@ extern void sendRelayOutput(Input*);
 extern void updateRelayOutput();
 #endif
 
+// A data output the static manifest leaves out keeps its slot (OutputID is the
+// index) but no functions, so none of its code is linked; it cannot be enabled
+#define STRIPPED_OUTPUT(name, interval, priority) {name, false, nullptr, nullptr, nullptr, nullptr, interval, priority}
+
 // Define output modules array - always compiled, controlled by runtime flags
 OutputModule outputModules[] = {
-    {"CAN", false, initCAN, sendCAN, updateCAN, 100},
-    {"RealDash", false, initRealdash, sendRealdash, updateRealdash, 100},
-    {"Serial", false, initSerialOutput, sendSerialOutput, updateSerialOutput, 1000},
-    {"SD_Log", false, initSDLog, sendSDLog, updateSDLog, 5000},
-    {"Alarm", true, initAlarmOutput, sendAlarmOutput, updateAlarmOutput, 100},
+#ifndef STATIC_SKIP_OUTPUT_CAN
+    {"CAN", false, initCAN, nullptr, sendCANBatch, nullptr, 100, PRIORITY_TELEMETRY},  // Requests via the CAN RX pump
+#else
+    STRIPPED_OUTPUT("CAN", 100, PRIORITY_TELEMETRY),
+#endif
+#ifndef STATIC_SKIP_OUTPUT_REALDASH
+    {"RealDash", false, initRealdash, nullptr, sendRealdashBatch, updateRealdash, 100, PRIORITY_TELEMETRY},
+#else
+    STRIPPED_OUTPUT("RealDash", 100, PRIORITY_TELEMETRY),
+#endif
+#ifndef STATIC_SKIP_OUTPUT_SERIAL
+    {"Serial", false, initSerialOutput, nullptr, sendSerialBatch, updateSerialOutput, 1000, PRIORITY_COSMETIC},
+#else
+    STRIPPED_OUTPUT("Serial", 1000, PRIORITY_COSMETIC),
+#endif
+#ifndef STATIC_SKIP_OUTPUT_SD
+    {"SD_Log", false, initSDLog, nullptr, sendSDLogBatch, updateSDLog, 5000, PRIORITY_TELEMETRY},
+#else
+    STRIPPED_OUTPUT("SD_Log", 5000, PRIORITY_TELEMETRY),
+#endif
+#if defined(ENABLE_MQTT) && !defined(STATIC_SKIP_OUTPUT_MQTT)
+    {"MQTT", false, initMqttOutput, nullptr, sendMqttBatch, nullptr, 1000, PRIORITY_TELEMETRY},  // Publish task does the I/O
+#else
+    STRIPPED_OUTPUT("MQTT", 1000, PRIORITY_TELEMETRY),
+#endif
+    {"Alarm", true, initAlarmOutput, sendAlarmOutput, nullptr, updateAlarmOutput, 100, PRIORITY_SAFETY},
 #ifdef ENABLE_RELAY_OUTPUT
-    {"Relay", true, initRelayOutput, sendRelayOutput, updateRelayOutput, 100},
+    {"Relay", true, initRelayOutput, sendRelayOutput, nullptr, updateRelayOutput, 100, PRIORITY_SAFETY},
 #endif
 };
 
 #ifdef ENABLE_RELAY_OUTPUT
+const int numOutputModules = 7;
+#else
 const int numOutputModules = 6;
+#endif
+
+// Output has code in this build (not stripped by the static manifest)
+static inline bool outputLinked(const OutputModule& output) {
+    return output.send != nullptr || output.sendBatch != nullptr;
+}
+
+// Next send deadline for each output module
+static uint32_t nextOutputSend[sizeof(outputModules) / sizeof(outputModules[0])];
+
+// Slots of the batch being sent (one module at a time) - one per class when
+// the safety class runs on the other core (dual_core.h)
+#ifdef ENABLE_DUAL_CORE
+static uint8_t batches[NUM_TASK_PRIORITIES][MAX_INPUTS];
 #else
-const int numOutputModules = 5;
+static uint8_t batches[1][MAX_INPUTS];
 #endif
 
-// Track last send time for each output module
-static uint32_t lastOutputSend[sizeof(outputModules) / sizeof(outputModules[0])];
+// Last value/sequence sent per data output and input (change-driven modes)
+static float lastSentValue[NUM_DATA_OUTPUTS][MAX_INPUTS];
+static uint8_t lastSentSeq[NUM_DATA_OUTPUTS][MAX_INPUTS];
+
+// Aggregation window per data output and input: one running statistic
+// (sum for MEAN, extreme for MIN/MAX) and the readings folded in
+struct AggregateWindow {
+    float acc;
+    uint16_t count;
+};
+static AggregateWindow aggWindow[NUM_DATA_OUTPUTS][MAX_INPUTS];
+
+// Samples handed to an aggregating module - the window results for the batch
+static InputSample aggSamples[MAX_INPUTS];
+
+// Start a new window for every input of a data output
+static void resetAggregation(uint8_t output) {
+    for (uint8_t j = 0; j < MAX_INPUTS; j++) {
+        aggWindow[output][j].count = 0;
+    }
+}
+
+// Forget what was sent so the next pass sends every input once
+static void resetChangeTracking(uint8_t output) {
+    for (uint8_t j = 0; j < MAX_INPUTS; j++) {
+        lastSentValue[output][j] = NAN;
+        lastSentSeq[output][j] = inputs[j].sequence - 1;
+    }
+}
+
+// Input has a new value that moved at least the output's deadband since the last send
+static bool inputChangedFor(uint8_t output, uint8_t j, float value) {
+    if (inputs[j].sequence == lastSentSeq[output][j]) return false;  // Nothing new
+    float last = lastSentValue[output][j];
+    if (isnan(last)) return true;
+    return fabsf(value - last) * 100.0f >= outputModules[output].deadband;
+}
+
+// Data plane stream of a data output's frames (router data plane profiles)
+static uint8_t dataStreamOf(uint8_t output) {
+    switch (output) {
+        case OUTPUT_REALDASH: return DATA_STREAM_REALDASH;
+        case OUTPUT_SERIAL:   return DATA_STREAM_SERIAL;
+        default:              return DATA_STREAM_TEXT;
+    }
+}
 
 void initOutputModules() {
     // Apply runtime configuration from system config
     for (int i = 0; i < numOutputModules; i++) {
-        outputModules[i].enabled = systemConfig.outputEnabled[i];
+        outputModules[i].enabled = systemConfig.outputEnabled[i] && outputLinked(outputModules[i]);
         outputModules[i].sendInterval = systemConfig.outputInterval[i];
+        if (i < NUM_DATA_OUTPUTS) {
+            outputModules[i].sendMode = (OutputSendMode)systemConfig.outputMode[i];
+            outputModules[i].deadband = systemConfig.outputDeadband[i];
+            outputModules[i].aggregate = (OutputAggregate)systemConfig.outputAggregate[i];
+            resetChangeTracking(i);
+            resetAggregation(i);
+        }
 
         if (outputModules[i].enabled && outputModules[i].init != nullptr) {
             outputModules[i].init();
         }
-        lastOutputSend[i] = 0;  // Initialize timing
+        nextOutputSend[i] = millis();  // First send due immediately
+    }
+}
+
+// Fold one reading into the window of every aggregating output it is routed to
+// (called after each read, so a window sees readings between sends - dips a
+// slow output's instantaneous sample would miss). O(1) per input per output.
+void aggregateInputSample(uint8_t slot, float value) {
+    if (isnan(value)) return;
+    uint8_t mask = inputs[slot].outputMask;
+    dualCoreLock();  // Windows are read and reset by the output pass
+    for (uint8_t i = 0; i < NUM_DATA_OUTPUTS; i++) {
+        OutputAggregate aggregate = outputModules[i].aggregate;
+        if (aggregate == OUTPUT_AGG_LAST || !outputModules[i].enabled || !(mask & (1 << i))) continue;
+
+        AggregateWindow& window = aggWindow[i][slot];
+        if (window.count == 0) {
+            window.acc = value;
+        } else if (window.count == UINT16_MAX) {
+            continue;  // Full window (65535 readings) - keep the statistic, drop the rest
+        } else if (aggregate == OUTPUT_AGG_MEAN) {
+            window.acc += value;
+        } else if (aggregate == OUTPUT_AGG_MIN) {
+            if (value < window.acc) window.acc = value;
+        } else if (value > window.acc) {
+            window.acc = value;
+        }
+        window.count++;
     }
+    dualCoreUnlock();
 }
 
-// Send data to all outputs at their configured intervals
-void sendToOutputs(uint32_t now) {
+// Send data to the outputs of one priority class
+// (each class is a separate scheduler task, so load shedding applies per class)
+//   PERIODIC  - every input when the interval elapses
+//   ON_CHANGE - only inputs whose value moved past the deadband, on every pass
+//   HEARTBEAT - on-change fast path, plus every input when the interval elapses
+// A module gets the inputs due as one batch stamped with the pass time; data
+// outputs send the values of the input snapshot taken once for the whole pass.
+// An aggregating output (MEAN/MIN/MAX) sends its window statistic instead on
+// interval sends and starts a new window; on-change sends stay instantaneous.
+void sendToOutputs(uint32_t now, TaskPriority priority) {
+    const InputSample* samples = getInputSnapshot().samples;
+    uint8_t* batch = batches[sizeof(batches) / sizeof(batches[0]) > 1 ? priority : 0];
+
     for (int i = 0; i < numOutputModules; i++) {
-        if (!outputModules[i].enabled) continue;
-
-        // Check if enough time has elapsed for this output
-        if (now - lastOutputSend[i] >= outputModules[i].sendInterval) {
-            // Send all enabled inputs to this output
-            for (uint8_t j = 0; j < MAX_INPUTS; j++) {
-                if (inputs[j].flags.isEnabled && !isnan(inputs[j].value)) {
-                    // For data outputs (CAN/RealDash/Serial/SD), check per-input mask
-                    if (i <= OUTPUT_SD && !(inputs[j].outputMask & (1 << i))) continue;
-                    outputModules[i].send(&inputs[j]);
+        if (!outputModules[i].enabled || outputModules[i].priority != priority) continue;
+
+        OutputSendMode mode = (i < NUM_DATA_OUTPUTS) ? outputModules[i].sendMode : OUTPUT_MODE_PERIODIC;
+
+        // Check if this output's deadline has passed (signed diff handles rollover)
+        bool intervalDue = mode != OUTPUT_MODE_ON_CHANGE && (int32_t)(now - nextOutputSend[i]) >= 0;
+        if (!intervalDue && mode == OUTPUT_MODE_PERIODIC) continue;
+
+        uint32_t sendStart = PROFILE_TIMESTAMP();
+
+        // Collect the enabled inputs due for this output
+        uint8_t count = 0;
+        for (uint8_t k = 0; k < numActiveSlots; k++) {
+            uint8_t j = activeSlots[k];
+            if (i >= NUM_DATA_OUTPUTS) {
+                if (!isnan(inputs[j].value)) {
+                    batch[count++] = j;  // Alarm/relay act on live state
+                    TRACE_ENQUEUE(i, j);
                 }
+                continue;
+            }
+
+            // For data outputs (CAN/RealDash/Serial/SD), check per-input mask
+            float value = samples[j].value;
+            if (isnan(value) || !(inputs[j].outputMask & (1 << i))) continue;
+            if (!intervalDue && !inputChangedFor(i, j, value)) continue;
+
+            batch[count++] = j;
+            TRACE_ENQUEUE(i, j);
+            lastSentValue[i][j] = value;
+            lastSentSeq[i][j] = inputs[j].sequence;
+        }
+
+        // Interval send of an aggregating output: window results, then new windows
+        const InputSample* sent = samples;
+        if (intervalDue && i < NUM_DATA_OUTPUTS && outputModules[i].aggregate != OUTPUT_AGG_LAST) {
+            dualCoreLock();
+            for (uint8_t k = 0; k < count; k++) {
+                uint8_t j = batch[k];
+                AggregateWindow& window = aggWindow[i][j];
+                aggSamples[j] = samples[j];
+                if (window.count > 0) {
+                    aggSamples[j].value = (outputModules[i].aggregate == OUTPUT_AGG_MEAN) ?
+                                          window.acc / window.count : window.acc;
+                }
+                window.count = 0;
+            }
+            dualCoreUnlock();
+            sent = aggSamples;
+        }
+
+        if (count > 0) {
+            if (i < NUM_DATA_OUTPUTS) outputFrame.setStream(dataStreamOf(i));
+            if (outputModules[i].sendBatch) {
+                outputModules[i].sendBatch(batch, count, sent, now);
+            } else {
+                for (uint8_t k = 0; k < count; k++) {
+                    outputModules[i].send(&inputs[batch[k]]);
+                }
+            }
+        }
+        if (i < NUM_DATA_OUTPUTS) outputFrame.commit();  // Everything this module assembled, in one write
+        if (i != OUTPUT_CAN) TRACE_WIRE(i);  // CAN: when its transmit queue drains (can_tx.cpp)
+        PROFILE_RECORD(profOutputSendSlot(i), sendStart);
+
+        if (intervalDue) {
+            // Advance from the previous deadline so the cadence doesn't drift;
+            // resync if we've fallen more than a full interval behind
+            nextOutputSend[i] += outputModules[i].sendInterval;
+            if ((int32_t)(now - nextOutputSend[i]) >= 0) {
+                nextOutputSend[i] = now + outputModules[i].sendInterval;
             }
-            lastOutputSend[i] = now;
         }
     }
 }
 
+// Change-driven outputs in this class need a pass as soon as inputs update
+bool outputsWantChanges(TaskPriority priority) {
+    for (int i = 0; i < NUM_DATA_OUTPUTS; i++) {
+        if (outputModules[i].enabled && outputModules[i].priority == priority &&
+            outputModules[i].sendMode != OUTPUT_MODE_PERIODIC) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Earliest send deadline across enabled outputs of one class (for the loop scheduler)
+uint32_t getNextOutputDeadline(uint32_t now, TaskPriority priority) {
+    uint32_t next = now + 1000;  // Nothing enabled - check back periodically
+    for (int i = 0; i < numOutputModules; i++) {
+        if (!outputModules[i].enabled || outputModules[i].priority != priority) continue;
+        if (i < NUM_DATA_OUTPUTS && outputModules[i].sendMode == OUTPUT_MODE_ON_CHANGE) continue;  // Woken by input changes
+        if ((int32_t)(nextOutputSend[i] - next) < 0) {
+            next = nextOutputSend[i];
+        }
+    }
+    return next;
+}
+
 // Housekeeping - called every loop (drain buffers, handle RX, etc.)
+// With ENABLE_DUAL_CORE the safety modules' is the acquisition task's
 void updateOutputs() {
     for (int i = 0; i < numOutputModules; i++) {
+#ifdef ENABLE_DUAL_CORE
+        if (outputModules[i].priority == PRIORITY_SAFETY) continue;
+#endif
+        if (outputModules[i].enabled && outputModules[i].update != nullptr) {
+            if (i < NUM_DATA_OUTPUTS) outputFrame.setStream(dataStreamOf(i));
+            PROFILE_CALL(profOutputUpdateSlot(i), outputModules[i].update());
+            if (i < NUM_DATA_OUTPUTS) outputFrame.commit();
+        }
+    }
+}
+
+// Housekeeping of one class's modules only
+void updateOutputClass(TaskPriority priority) {
+    for (int i = 0; i < numOutputModules; i++) {
+        if (outputModules[i].priority != priority) continue;
         if (outputModules[i].enabled && outputModules[i].update != nullptr) {
+            if (i < NUM_DATA_OUTPUTS) outputFrame.setStream(dataStreamOf(i));
             outputModules[i].update();
+            if (i < NUM_DATA_OUTPUTS) outputFrame.commit();
         }
     }
 }
@@ -119,6 +355,16 @@ OutputModule* getOutputByName(const char* name) {
     return nullptr;
 }
 
+/**
+ * Get output module by table index
+ * @param index Index into output module table (OutputID order)
+ * @return Pointer to OutputModule, or nullptr if out of range
+ */
+OutputModule* getOutputByIndex(uint8_t index) {
+    if (index >= numOutputModules) return nullptr;
+    return &outputModules[index];
+}
+
 /**
  * Enable or disable an output module
  * @param name Output name
@@ -130,6 +376,7 @@ bool setOutputEnabled(const char* name, bool enabled) {
     if (!output) return false;
 
     int index = output - outputModules;  // Calculate index
+    if (enabled && !outputLinked(*output)) return false;  // Stripped from this build
     output->enabled = enabled;
     systemConfig.outputEnabled[index] = enabled ? 1 : 0;
 
@@ -137,6 +384,13 @@ bool setOutputEnabled(const char* name, bool enabled) {
     if (enabled && output->init != nullptr) {
         output->init();
     }
+    if (enabled) {
+        nextOutputSend[index] = millis();
+        if (index < NUM_DATA_OUTPUTS) {
+            resetChangeTracking(index);
+            resetAggregation(index);
+        }
+    }
 
     return true;
 }
@@ -158,6 +412,58 @@ bool setOutputInterval(const char* name, uint16_t interval) {
     return true;
 }
 
+/**
+ * Set output send mode (data outputs only)
+ * @param name Output name
+ * @param mode Periodic, on-change or heartbeat
+ * @param deadband Minimum change to send, hundredths of standard units
+ * @return true if successful (false for unknown or non-data outputs)
+ */
+bool setOutputMode(const char* name, OutputSendMode mode, uint16_t deadband) {
+    OutputModule* output = getOutputByName(name);
+    if (!output) return false;
+
+    int index = output - outputModules;  // Calculate index
+    if (index >= NUM_DATA_OUTPUTS) return false;
+
+    output->sendMode = mode;
+    output->deadband = deadband;
+    systemConfig.outputMode[index] = mode;
+    systemConfig.outputDeadband[index] = deadband;
+    resetChangeTracking(index);
+
+    return true;
+}
+
+/**
+ * Set what a data output sends each interval
+ * @param name Output name
+ * @param aggregate Last reading, or the mean/min/max of the readings since the last send
+ * @return true if successful (false for unknown or non-data outputs)
+ */
+bool setOutputAggregate(const char* name, OutputAggregate aggregate) {
+    OutputModule* output = getOutputByName(name);
+    if (!output) return false;
+
+    int index = output - outputModules;  // Calculate index
+    if (index >= NUM_DATA_OUTPUTS) return false;
+
+    output->aggregate = aggregate;
+    systemConfig.outputAggregate[index] = aggregate;
+    resetAggregation(index);
+
+    return true;
+}
+
+const char* getOutputAggregateName(OutputAggregate aggregate) {
+    switch (aggregate) {
+        case OUTPUT_AGG_MEAN: return "MEAN";
+        case OUTPUT_AGG_MIN:  return "MIN";
+        case OUTPUT_AGG_MAX:  return "MAX";
+        default:              return "LAST";
+    }
+}
+
 /**
  * List all outputs with their status
  */
@@ -169,7 +475,27 @@ void listOutputs() {
         if (outputModules[i].enabled) {
             msg.control.print(F("Enabled, Interval: "));
             msg.control.print(outputModules[i].sendInterval);
-            msg.control.println(F("ms"));
+            msg.control.print(F("ms"));
+            if (i < NUM_DATA_OUTPUTS && outputModules[i].sendMode != OUTPUT_MODE_PERIODIC) {
+                msg.control.print(outputModules[i].sendMode == OUTPUT_MODE_ON_CHANGE ?
+                                  F(", Mode: CHANGE, Deadband: ") : F(", Mode: HEARTBEAT, Deadband: "));
+                msg.control.print(outputModules[i].deadband / 100.0f, 2);
+            }
+            if (i < NUM_DATA_OUTPUTS && outputModules[i].aggregate != OUTPUT_AGG_LAST) {
+                msg.control.print(F(", Aggregate: "));
+                msg.control.print(getOutputAggregateName(outputModules[i].aggregate));
+            }
+            if (i == OUTPUT_SERIAL) {
+                msg.control.print(F(", Format: "));
+                msg.control.print(getSerialFormatName(getSerialFormat()));
+            }
+            if (i == OUTPUT_MQTT) {
+                msg.control.print(F(", Format: "));
+                msg.control.print(getMqttFormatName(getMqttFormat()));
+                msg.control.print(F(", QoS "));
+                msg.control.print(getMqttQos());
+            }
+            msg.control.println();
         } else {
             msg.control.println(F("Disabled"));
         }
@@ -0,0 +1,529 @@
+/*
+ * output_mqtt.cpp - MQTT publisher for fleet telemetry (ESP32 Wi-Fi)
+ */
+
+#include "output_mqtt.h"
+#include "output_base.h"
+
+#ifdef ENABLE_MQTT
+
+#include "packed_signal.h"
+#include "packed_log.h"
+#include "../inputs/input_manager.h"
+#include "../lib/message_api.h"
+#include "../lib/log_tags.h"
+#include "../lib/float_format.h"
+#include "../hal/hal_clock.h"
+#include <WiFi.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+
+#define TOPIC_DATA          MQTT_TOPIC "/data"
+#define TOPIC_CHANNELS      MQTT_TOPIC "/channels"
+
+// PUBLISH fixed header, topic and packet ID go in front of the payload
+#define HEADROOM            (1 + 4 + 2 + sizeof(TOPIC_CHANNELS) - 1 + 2)
+
+#define NO_SLOT             0xFF
+#define RECONNECT_MS        5000        // Between broker connection attempts
+#define CONNACK_TIMEOUT_MS  3000
+#define TASK_WAKE_MS        50          // Task checks the broker and keep-alive this often
+
+#if MQTT_QUEUE_DEPTH >= NO_SLOT
+#error "MQTT_QUEUE_DEPTH must be below 255"
+#endif
+
+struct PayloadSlot {
+    uint16_t len;                       // Payload bytes at data[HEADROOM]
+    uint16_t packetId;                  // QoS 1 (0 = not sent yet)
+    bool channels;                      // <topic>/channels (retained), else <topic>/data
+    uint8_t data[HEADROOM + MQTT_PAYLOAD_MAX];
+};
+
+static PayloadSlot payloads[MQTT_QUEUE_DEPTH];
+static QueueHandle_t freeSlots = nullptr;   // Slot indices the loop may fill
+static QueueHandle_t sendSlots = nullptr;   // Filled slots, in order, for the task
+static TaskHandle_t task = nullptr;
+
+// Each field has one writer: dropped/peakQueued the loop, the rest the task
+static MqttStats stats = {0, 0, 0, 0, 0, 0, false};
+
+static MqttFormat format = MQTT_FORMAT_JSON;
+static volatile uint8_t qos = 0;
+static volatile bool channelsDue = true;    // Channel table before the next data (task sets it on connect)
+static uint32_t layoutSignature = 0;
+
+// ===== LOOP SIDE: ENCODING =====
+
+// Text payload being built - stops at MQTT_PAYLOAD_MAX and remembers it did
+static PayloadSlot* building;
+static bool overflow;
+
+static void append(const char* text, uint16_t len) {
+    if (building->len + len > MQTT_PAYLOAD_MAX) {
+        overflow = true;
+        return;
+    }
+    memcpy(&building->data[HEADROOM + building->len], text, len);
+    building->len += len;
+}
+
+static void append(const char* text) {
+    append(text, strlen(text));
+}
+
+static void append(const __FlashStringHelper* text) {
+    const char* p = (const char*)text;
+    char c;
+    while ((c = pgm_read_byte(p++)) != 0) append(&c, 1);
+}
+
+static void appendUnsigned(uint32_t value) {
+    char text[11];
+    append(text, formatUnsigned(text, value));
+}
+
+// Input name as a JSON string (quotes and backslashes left out)
+static void appendName(const Input* input) {
+    append("\"", 1);
+    for (uint8_t k = 0; k < sizeof(input->abbrName) && input->abbrName[k]; k++) {
+        char c = input->abbrName[k];
+        if (c != '"' && c != '\\') append(&c, 1);
+    }
+    append("\"", 1);
+}
+
+static uint8_t takeSlot() {
+    uint8_t index;
+    if (xQueueReceive(freeSlots, &index, 0) != pdTRUE) {
+        stats.dropped++;  // Every slot in flight - never wait for the broker
+        return NO_SLOT;
+    }
+    building = &payloads[index];
+    building->len = 0;
+    building->packetId = 0;
+    building->channels = false;
+    overflow = false;
+    return index;
+}
+
+static bool queueSlot(uint8_t index) {
+    if (overflow) {
+        stats.dropped++;
+        xQueueSend(freeSlots, &index, 0);
+        return false;
+    }
+    xQueueSend(sendSlots, &index, 0);  // Room for every slot - never blocks
+    uint8_t inFlight = MQTT_QUEUE_DEPTH - uxQueueMessagesWaiting(freeSlots);
+    if (inFlight > stats.peakQueued) stats.peakQueued = inFlight;
+    return true;
+}
+
+// [{"slot":0,"name":"CHT","type":0,"units":"C"},...] - the inputs routed to MQTT
+static bool queueChannels() {
+    uint8_t index = takeSlot();
+    if (index == NO_SLOT) return false;
+    building->channels = true;
+
+    append("[", 1);
+    bool first = true;
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        const Input* input = &inputs[i];
+        if (input->pin == 0xFF || !input->flags.isEnabled || !(input->outputMask & (1 << OUTPUT_MQTT))) continue;
+        append(first ? "{\"slot\":" : ",{\"slot\":");
+        first = false;
+        appendUnsigned(i);
+        append(",\"name\":");
+        appendName(input);
+        append(",\"type\":");
+        appendUnsigned(input->measurementType);
+        append(",\"units\":\"");
+        append(getPackedUnits((MeasurementType)input->measurementType));
+        append("\"}");
+    }
+    append("]", 1);
+    return queueSlot(index);
+}
+
+void sendMqttBatch(const uint8_t* slots, uint8_t count, const InputSample* samples, uint32_t now) {
+    if (!stats.connected) return;  // Nothing is stored up while the broker is away
+
+    // Receivers learn the slots before data that uses them
+    uint32_t signature = getPackedLayoutSignature(OUTPUT_MQTT);
+    if (signature != layoutSignature) {
+        layoutSignature = signature;
+        channelsDue = true;
+    }
+    if (channelsDue) {
+        if (!queueChannels()) return;
+        channelsDue = false;
+    }
+
+    uint8_t index = takeSlot();
+    if (index == NO_SLOT) return;
+
+    if (format == MQTT_FORMAT_BINARY) {
+        uint8_t* data = &building->data[HEADROOM];
+        data[0] = MQTT_BINARY_VERSION;
+        data[1] = count;
+        data[2] = now & 0xFF;
+        data[3] = (now >> 8) & 0xFF;
+        data[4] = (now >> 16) & 0xFF;
+        data[5] = now >> 24;
+        uint16_t len = 6;
+        for (uint8_t k = 0; k < count && len + 3 <= MQTT_PAYLOAD_MAX; k++) {
+            data[len++] = slots[k];
+            len += writePackedSignal(&data[len], inputs[slots[k]].measurementType, samples[slots[k]].value);
+        }
+        building->len = len;
+    } else {
+        append("{\"ms\":");
+        appendUnsigned(now);
+        uint32_t wall = hal::wallClock();
+        if (wall != 0) {
+            append(",\"t\":");
+            appendUnsigned(wall);
+        }
+        append(",\"v\":{");
+        for (uint8_t k = 0; k < count; k++) {
+            const Input* input = &inputs[slots[k]];
+            if (k > 0) append(",", 1);
+            appendName(input);
+            append(":", 1);
+            char text[FLOAT_FORMAT_SIZE];
+            uint8_t decimals = (input->measurementType == MEASURE_RPM || input->measurementType == MEASURE_DIGITAL) ? 0 : 2;
+            append(text, formatFixed(text, samples[slots[k]].value, decimals));
+        }
+        append("}}");
+    }
+    queueSlot(index);
+}
+
+// ===== TASK SIDE: BROKER SESSION =====
+
+static WiFiClient client;
+static uint16_t nextPacketId = 1;
+static uint8_t inFlight = NO_SLOT;      // QoS 1 message waiting for its PUBACK
+static uint32_t inFlightMs = 0;
+static uint32_t lastWriteMs = 0;
+
+static bool networkUp() {
+#ifdef WIFI_SSID
+    return WiFi.status() == WL_CONNECTED;
+#else
+    return WiFi.getMode() != WIFI_OFF;  // Our own access point - the broker is a client of it
+#endif
+}
+
+static uint8_t putRemainingLength(uint8_t* out, uint32_t len) {
+    uint8_t n = 0;
+    do {
+        uint8_t b = len & 0x7F;
+        len >>= 7;
+        out[n++] = len ? (b | 0x80) : b;
+    } while (len);
+    return n;
+}
+
+static uint16_t putString(uint8_t* out, const char* text) {
+    uint16_t len = strlen(text);
+    out[0] = len >> 8;
+    out[1] = len & 0xFF;
+    memcpy(&out[2], text, len);
+    return 2 + len;
+}
+
+#ifdef MQTT_USER
+#ifdef MQTT_PASSWORD
+#define CREDENTIAL_BYTES (sizeof(MQTT_USER) + 1 + sizeof(MQTT_PASSWORD) + 1)
+#else
+#define CREDENTIAL_BYTES (sizeof(MQTT_USER) + 1)
+#endif
+#else
+#define CREDENTIAL_BYTES 0
+#endif
+
+static bool brokerConnect() {
+    if (!client.connect(MQTT_BROKER, MQTT_PORT)) return false;
+    client.setNoDelay(true);
+
+    // CONNECT: protocol "MQTT" level 4, clean session
+    uint8_t packet[5 + 10 + sizeof(MQTT_CLIENT_ID) + 1 + CREDENTIAL_BYTES];
+    uint8_t body[sizeof(packet) - 5];
+    uint16_t n = putString(body, "MQTT");
+    body[n++] = 4;
+    uint8_t flags = 0x02;
+#ifdef MQTT_USER
+    flags |= 0x80;
+#ifdef MQTT_PASSWORD
+    flags |= 0x40;
+#endif
+#endif
+    body[n++] = flags;
+    body[n++] = MQTT_KEEPALIVE_S >> 8;
+    body[n++] = MQTT_KEEPALIVE_S & 0xFF;
+    n += putString(&body[n], MQTT_CLIENT_ID);
+#ifdef MQTT_USER
+    n += putString(&body[n], MQTT_USER);
+#ifdef MQTT_PASSWORD
+    n += putString(&body[n], MQTT_PASSWORD);
+#endif
+#endif
+    packet[0] = 0x10;
+    uint8_t h = 1 + putRemainingLength(&packet[1], n);
+    memcpy(&packet[h], body, n);
+    client.write(packet, h + n);
+
+    // CONNACK: 0x20 0x02 flags return-code
+    uint32_t start = millis();
+    while (client.available() < 4) {
+        if (!client.connected() || millis() - start > CONNACK_TIMEOUT_MS) {
+            client.stop();
+            return false;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    uint8_t ack[4];
+    client.read(ack, sizeof(ack));
+    if (ack[0] != 0x20 || ack[3] != 0) {
+        client.stop();
+        return false;
+    }
+    lastWriteMs = millis();
+    return true;
+}
+
+static bool publish(PayloadSlot& slot, uint8_t level, bool dup) {
+    const char* topic = slot.channels ? TOPIC_CHANNELS : TOPIC_DATA;
+    uint16_t topicLen = strlen(topic);
+    uint8_t header[HEADROOM];
+    uint8_t h = 0;
+    header[h++] = 0x30 | (dup ? 0x08 : 0) | (level << 1) | (slot.channels ? 0x01 : 0);
+    h += putRemainingLength(&header[h], 2 + topicLen + (level ? 2 : 0) + slot.len);
+    h += putString(&header[h], topic);
+    if (level) {
+        header[h++] = slot.packetId >> 8;
+        header[h++] = slot.packetId & 0xFF;
+    }
+
+    // Header right in front of the payload - one write, one segment
+    uint8_t* frame = &slot.data[HEADROOM - h];
+    memcpy(frame, header, h);
+    size_t len = h + slot.len;
+    lastWriteMs = millis();
+    return client.write(frame, len) == len;
+}
+
+static void releaseSlot(uint8_t index) {
+    xQueueSend(freeSlots, &index, 0);
+}
+
+// PUBACK and PINGRESP - two-byte remaining lengths at most
+static void readBroker() {
+    while (client.available() >= 2) {
+        uint8_t head[2];
+        client.read(head, 2);
+        uint8_t body[4];
+        uint8_t len = head[1] & 0x7F;
+        uint8_t got = 0;
+        while (got < len) {
+            int c = client.read();
+            if (c < 0) {
+                if (!client.connected()) return;
+                vTaskDelay(1);
+                continue;
+            }
+            if (got < sizeof(body)) body[got] = c;
+            got++;
+        }
+        if ((head[0] & 0xF0) == 0x40 && len == 2 && inFlight != NO_SLOT &&
+            (((uint16_t)body[0] << 8) | body[1]) == payloads[inFlight].packetId) {
+            releaseSlot(inFlight);
+            inFlight = NO_SLOT;
+            stats.published++;
+        }
+    }
+}
+
+static uint16_t takePacketId() {
+    uint16_t id = nextPacketId++;
+    if (nextPacketId == 0) nextPacketId = 1;
+    return id;
+}
+
+static void taskMain(void*) {
+    uint32_t lastAttemptMs = 0;
+    bool attempted = false;
+    OutputModule* module = getOutputByIndex(OUTPUT_MQTT);
+
+    for (;;) {
+        if (!module->enabled) {
+            if (client.connected()) {
+                const uint8_t disconnect[2] = {0xE0, 0x00};
+                client.write(disconnect, sizeof(disconnect));
+                client.stop();
+            }
+            stats.connected = false;
+            vTaskDelay(pdMS_TO_TICKS(TASK_WAKE_MS));
+            continue;
+        }
+
+        if (!client.connected()) {
+            stats.connected = false;
+            uint32_t now = millis();
+            if (!networkUp() || (attempted && now - lastAttemptMs < RECONNECT_MS)) {
+                vTaskDelay(pdMS_TO_TICKS(TASK_WAKE_MS));
+                continue;
+            }
+            attempted = true;
+            lastAttemptMs = now;
+            if (!brokerConnect()) {
+                stats.connectFailures++;
+                continue;
+            }
+            stats.connects++;
+            channelsDue = true;     // Retained table again for this session
+            stats.connected = true;
+            if (inFlight != NO_SLOT) {
+                publish(payloads[inFlight], 1, true);
+                inFlightMs = millis();
+                stats.resent++;
+            }
+        }
+
+        readBroker();
+
+        // QoS 1: the next message waits for this one's PUBACK
+        if (inFlight != NO_SLOT) {
+            if (millis() - inFlightMs >= MQTT_ACK_TIMEOUT_MS) {
+                publish(payloads[inFlight], 1, true);
+                inFlightMs = millis();
+                stats.resent++;
+            }
+            vTaskDelay(pdMS_TO_TICKS(5));
+            continue;
+        }
+
+        uint8_t index;
+        if (xQueueReceive(sendSlots, &index, pdMS_TO_TICKS(TASK_WAKE_MS)) == pdTRUE) {
+            PayloadSlot& slot = payloads[index];
+            uint8_t level = qos;
+            if (level) slot.packetId = takePacketId();
+            bool written = publish(slot, level, false);
+            if (level) {
+                inFlight = index;           // Resent after a reconnect if the write failed
+                inFlightMs = millis();
+            } else {
+                releaseSlot(index);
+                if (written) stats.published++;
+            }
+            if (!written) client.stop();
+        } else if (millis() - lastWriteMs >= MQTT_KEEPALIVE_S * 500UL) {
+            const uint8_t ping[2] = {0xC0, 0x00};
+            client.write(ping, sizeof(ping));
+            lastWriteMs = millis();
+        }
+    }
+}
+
+// ===== PUBLIC =====
+
+void initMqttOutput() {
+    setMqttFormat((MqttFormat)systemConfig.mqttFormat);
+    setMqttQos(systemConfig.mqttQos);
+    if (task != nullptr) return;  // Enabled again - the task is still there
+
+    freeSlots = xQueueCreate(MQTT_QUEUE_DEPTH, sizeof(uint8_t));
+    sendSlots = xQueueCreate(MQTT_QUEUE_DEPTH, sizeof(uint8_t));
+    if (freeSlots == nullptr || sendSlots == nullptr) {
+        msg.debug.error(TAG_SYSTEM, "MQTT: no memory for the queues");
+        return;
+    }
+    for (uint8_t i = 0; i < MQTT_QUEUE_DEPTH; i++) {
+        xQueueSend(freeSlots, &i, 0);
+    }
+    if (xTaskCreatePinnedToCore(taskMain, "mqtt", MQTT_TASK_STACK, nullptr,
+                                MQTT_TASK_PRIORITY, &task, MQTT_TASK_CORE) != pdPASS) {
+        task = nullptr;
+        msg.debug.error(TAG_SYSTEM, "MQTT: publish task not started");
+        return;
+    }
+    msg.debug.info(TAG_SYSTEM, "MQTT publishing to %s:%d as %s", MQTT_BROKER, MQTT_PORT, MQTT_CLIENT_ID);
+}
+
+bool setMqttFormat(MqttFormat newFormat) {
+    format = (newFormat == MQTT_FORMAT_BINARY) ? MQTT_FORMAT_BINARY : MQTT_FORMAT_JSON;
+    systemConfig.mqttFormat = format;
+    channelsDue = true;
+    return true;
+}
+
+MqttFormat getMqttFormat() {
+    return format;
+}
+
+bool setMqttQos(uint8_t level) {
+    if (level > 1) return false;
+    qos = level;
+    systemConfig.mqttQos = level;
+    return true;
+}
+
+uint8_t getMqttQos() {
+    return qos;
+}
+
+void printMqttStatus() {
+    msg.control.println();
+    msg.control.println(F("=== MQTT ==="));
+    msg.control.print(F("Broker:     "));
+    msg.control.print(F(MQTT_BROKER));
+    msg.control.print(':');
+    msg.control.print(MQTT_PORT);
+    msg.control.print(F(" as "));
+    msg.control.print(F(MQTT_CLIENT_ID));
+    msg.control.println(stats.connected ? F(", connected") : F(", not connected"));
+    msg.control.print(F("Topics:     "));
+    msg.control.print(F(TOPIC_DATA));
+    msg.control.print(F(", "));
+    msg.control.println(F(TOPIC_CHANNELS));
+    msg.control.print(F("Format:     "));
+    msg.control.print(getMqttFormatName(format));
+    msg.control.print(F(", QoS "));
+    msg.control.println(qos);
+    msg.control.print(F("Messages:   "));
+    msg.control.print(stats.published);
+    msg.control.print(F(" published, "));
+    msg.control.print(stats.dropped);
+    msg.control.print(F(" dropped, "));
+    msg.control.print(stats.resent);
+    msg.control.println(F(" resent"));
+    msg.control.print(F("Sessions:   "));
+    msg.control.print(stats.connects);
+    msg.control.print(F(", "));
+    msg.control.print(stats.connectFailures);
+    msg.control.println(F(" failed connects"));
+    msg.control.print(F("Queue:      "));
+    msg.control.print(freeSlots ? MQTT_QUEUE_DEPTH - uxQueueMessagesWaiting(freeSlots) : 0);
+    msg.control.print(F(" of "));
+    msg.control.print(MQTT_QUEUE_DEPTH);
+    msg.control.print(F(" slots in flight, peak "));
+    msg.control.println(stats.peakQueued);
+}
+
+#else
+
+void initMqttOutput() {}
+void sendMqttBatch(const uint8_t* slots, uint8_t count, const InputSample* samples, uint32_t now) {}
+bool setMqttFormat(MqttFormat format) { return false; }
+MqttFormat getMqttFormat() { return MQTT_FORMAT_JSON; }
+bool setMqttQos(uint8_t qos) { return false; }
+uint8_t getMqttQos() { return 0; }
+void printMqttStatus() {}
+
+#endif // ENABLE_MQTT
+
+const __FlashStringHelper* getMqttFormatName(MqttFormat format) {
+    return format == MQTT_FORMAT_BINARY ? F("BINARY") : F("JSON");
+}
@@ -0,0 +1,145 @@
+/*
+ * output_mqtt.h - MQTT publisher for fleet telemetry (ESP32 Wi-Fi)
+ *
+ * A data output: each send is ONE message holding the whole batch - every
+ * input due this tick - instead of a message per input. With OUTPUT MQTT
+ * MODE CHANGE / HEARTBEAT the batch is only the inputs that moved past the
+ * deadband, so a vehicle at rest publishes next to nothing. Per-input
+ * routing (SET <pin> OUTPUT MQTT) and aggregation apply as to the other
+ * data outputs. Values are in standard units.
+ *
+ *   <MQTT_TOPIC>/data       JSON    {"ms":81230,"t":1760443519,"v":{"CHT":187.40,"OILP":4.12}}
+ *                           BINARY  [version 1][count][ms (uint32 LE)], then per input
+ *                                   [slot][value as a packed signal (packed_signal.h)]
+ *   <MQTT_TOPIC>/channels   retained, on connect and whenever the routed inputs change:
+ *                           [{"slot":0,"name":"CHT","type":0,"units":"C"},...]
+ *
+ * "t" is the wall clock (UTC seconds), left out until it has been set. A
+ * binary receiver finds each signal's width and scaling from the slot's
+ * measurement type in the channel table.
+ *
+ * The loop never talks to the broker. A message is encoded into one of
+ * MQTT_QUEUE_DEPTH fixed payload slots and its index put in a FreeRTOS
+ * queue; a task pinned to MQTT_TASK_CORE (where the Wi-Fi stack runs)
+ * keeps the broker connection and publishes. With every slot in flight the
+ * new message is dropped and counted, so a slow or unreachable broker costs
+ * the loop nothing. QoS 1 (OUTPUT MQTT QOS 1) holds a slot until its PUBACK
+ * and sends it again (DUP) after MQTT_ACK_TIMEOUT_MS or a reconnect, one
+ * message in flight at a time; QoS 0 frees it once written.
+ *
+ * The client is MQTT 3.1.1 over plain TCP, clean session, keep-alive pings.
+ * The session is closed while the output is disabled.
+ *
+ * Build Flags:
+ *   -D ENABLE_MQTT              - Compile the MQTT output (ESP32 with ENABLE_WIFI_TRANSPORT)
+ *   -D MQTT_BROKER=\"host\"     - Broker host name or address (required)
+ *   -D MQTT_PORT=n              - Broker port (default 1883)
+ *   -D MQTT_TOPIC=\"prefix\"    - Topic prefix (default "preobd")
+ *   -D MQTT_CLIENT_ID=\"id\"    - Client ID (default "preOBD" - give each unit its own)
+ *   -D MQTT_USER=\"name\"       - User name (default none)
+ *   -D MQTT_PASSWORD=\"secret\" - Password (with MQTT_USER)
+ *   -D MQTT_KEEPALIVE_S=n       - Keep-alive interval (default 30)
+ *   -D MQTT_QUEUE_DEPTH=n       - Payload slots between loop and task (default 8)
+ *   -D MQTT_PAYLOAD_MAX=n       - Bytes per payload slot (default 1024)
+ *   -D MQTT_ACK_TIMEOUT_MS=n    - QoS 1: wait for PUBACK before resending (default 2000)
+ *   -D MQTT_TASK_CORE=n         - Core of the publish task (default 0)
+ *   -D MQTT_TASK_PRIORITY=n     - Publish task priority (default 1)
+ *   -D MQTT_TASK_STACK=n        - Publish task stack bytes (default 4096)
+ */
+
+#ifndef OUTPUT_MQTT_H
+#define OUTPUT_MQTT_H
+
+#include <Arduino.h>
+#include "../inputs/input.h"
+#include "../inputs/input_snapshot.h"
+#include "../lib/system_config.h"
+
+#ifdef ENABLE_MQTT
+
+#if !defined(ESP32) || !defined(ENABLE_WIFI_TRANSPORT)
+#error "ENABLE_MQTT needs an ESP32 build with ENABLE_WIFI_TRANSPORT"
+#endif
+
+#ifndef MQTT_BROKER
+#error "ENABLE_MQTT needs -D MQTT_BROKER=\\\"host\\\""
+#endif
+
+#ifndef MQTT_PORT
+#define MQTT_PORT 1883
+#endif
+
+#ifndef MQTT_TOPIC
+#define MQTT_TOPIC "preobd"
+#endif
+
+#ifndef MQTT_CLIENT_ID
+#define MQTT_CLIENT_ID "preOBD"
+#endif
+
+#ifndef MQTT_KEEPALIVE_S
+#define MQTT_KEEPALIVE_S 30
+#endif
+
+#ifndef MQTT_QUEUE_DEPTH
+#define MQTT_QUEUE_DEPTH 8
+#endif
+
+#ifndef MQTT_PAYLOAD_MAX
+#define MQTT_PAYLOAD_MAX 1024
+#endif
+
+#ifndef MQTT_ACK_TIMEOUT_MS
+#define MQTT_ACK_TIMEOUT_MS 2000
+#endif
+
+#ifndef MQTT_TASK_CORE
+#define MQTT_TASK_CORE 0
+#endif
+
+#ifndef MQTT_TASK_PRIORITY
+#define MQTT_TASK_PRIORITY 1
+#endif
+
+#ifndef MQTT_TASK_STACK
+#define MQTT_TASK_STACK 4096
+#endif
+
+#define MQTT_BINARY_VERSION 1
+
+// Publisher counters (OUTPUT MQTT STATUS)
+struct MqttStats {
+    uint32_t published;         // Messages written to the broker (QoS 1: acknowledged)
+    uint32_t dropped;           // Messages lost: every slot in flight, or over MQTT_PAYLOAD_MAX
+    uint32_t resent;            // QoS 1 messages sent again (DUP)
+    uint16_t connects;          // Broker sessions started
+    uint16_t connectFailures;
+    uint8_t peakQueued;         // Most slots in flight at once
+    bool connected;
+};
+
+#endif // ENABLE_MQTT
+
+void initMqttOutput();
+void sendMqttBatch(const uint8_t* slots, uint8_t count, const InputSample* samples, uint32_t now);
+
+/**
+ * Payload encoding (OUTPUT MQTT FORMAT) - the next message uses it, after
+ * the channel table again
+ * @return false if MQTT is not available on this build
+ */
+bool setMqttFormat(MqttFormat format);
+MqttFormat getMqttFormat();
+const __FlashStringHelper* getMqttFormatName(MqttFormat format);
+
+/**
+ * Delivery guarantee (OUTPUT MQTT QOS)
+ * @return false for a QoS other than 0 or 1, or no MQTT on this build
+ */
+bool setMqttQos(uint8_t qos);
+uint8_t getMqttQos();
+
+// Broker, session and queue counters (OUTPUT MQTT STATUS)
+void printMqttStatus();
+
+#endif // OUTPUT_MQTT_H
@@ -1,48 +1,186 @@
 /*
  * output_realdash.cpp - RealDash binary CAN output for data plane
+ *
+ * RealDash-CAN 0x66 frames: every input routed to RealDash is packed into
+ * one variable-length frame per send interval as a scaled 8/16-bit
+ * little-endian signal (packed_signal.h), in slot order:
+ *
+ *   [66 33 22 11] [frame ID, 4 bytes LE] [length] [data, 1-64] [CRC32, 4 bytes LE]
+ *
+ * The CRC32 (IEEE 802.3) covers every byte before it. Inputs past 64 bytes
+ * continue in frame 0x0C81, 0x0C82 ... The frames are assembled in the
+ * output frame (output_frame.h) and written with a single msg.data.write(),
+ * so a Bluetooth SPP link sees one contiguous burst per interval instead of
+ * three writes per input. OUTPUT RealDash XML prints the channel description for the
+ * current inputs; enabling, clearing or re-routing an input moves the
+ * signals after it.
+ *
+ * Build Flags:
+ *   -D REALDASH_FRAME_44  - Legacy framing: one 0x44 frame per input on 0x0C80
+ *                           in OBD-II Mode 01 format (docs/realdash/preOBD.xml)
  */
 
 #include "output_base.h"
+#include "output_frame.h"
+#include "output_realdash.h"
 #include "../config.h"
 #include "../lib/message_api.h"
 
 #ifdef ENABLE_REALDASH
 
+#include "../inputs/input_manager.h"
+#include "packed_signal.h"
+
+#define REALDASH_FRAME_ID       0x0C80
+#define REALDASH_MAX_DATA       64      // 0x66 frame payload limit
+#define REALDASH_FRAME_OVERHEAD 13      // Preamble, ID, length, CRC32
+
+#ifndef REALDASH_FRAME_44
+
+// Input routed to RealDash and carried in the frames
+static bool isRealdashSignal(const Input* input) {
+    return input->pin != 0xFF && input->flags.isEnabled &&
+           (input->outputMask & (1 << OUTPUT_REALDASH));
+}
+
+// CRC-32 (IEEE 802.3, reflected, as zlib) - bitwise, no table in RAM
+static uint32_t crc32(const uint8_t* data, uint16_t len) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (uint16_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+static void putLE32(uint8_t* p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+// Wrap the data at frame[9..] into a 0x66 frame
+// @return  Frame bytes
+static uint16_t finishFrame(uint8_t* frame, uint16_t frameId, uint8_t dataLen) {
+    static const uint8_t preamble[4] = {0x66, 0x33, 0x22, 0x11};
+    memcpy(frame, preamble, 4);
+    putLE32(&frame[4], frameId);
+    frame[8] = dataLen;
+    uint16_t len = 9 + dataLen;
+    putLE32(&frame[len], crc32(frame, len));
+    return len + 4;
+}
+
+/**
+ * Assemble every input's snapshot value, as many frames as the inputs need,
+ * into the output frame (committed in one write by sendToOutputs())
+ */
+static void flushRealdashFrames(const InputSample* samples) {
+    uint8_t* frame = outputFrame.reserve(REALDASH_FRAME_OVERHEAD + REALDASH_MAX_DATA);
+    uint8_t used = 0;
+    uint16_t frameId = REALDASH_FRAME_ID;
+
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        const Input* input = &inputs[i];
+        if (!isRealdashSignal(input)) continue;
+
+        if (used + getPackedScale(input->measurementType).width > REALDASH_MAX_DATA) {
+            outputFrame.advance(finishFrame(frame, frameId++, used));
+            frame = outputFrame.reserve(REALDASH_FRAME_OVERHEAD + REALDASH_MAX_DATA);
+            used = 0;
+        }
+        used += writePackedSignal(&frame[9 + used], input->measurementType, samples[i].value);
+    }
+    if (used > 0) {
+        outputFrame.advance(finishFrame(frame, frameId, used));
+    }
+}
+
+void printRealdashXML() {
+    msg.control.println(F("<?xml version=\"1.0\" encoding=\"utf-8\"?>"));
+    msg.control.println(F("<!-- preOBD RealDash-CAN 0x66 frames (OUTPUT RealDash XML) -->"));
+    msg.control.println(F("<RealDashCAN version=\"2\">"));
+    msg.control.println(F("  <frames>"));
+
+    uint8_t used = REALDASH_MAX_DATA;  // First signal opens a frame
+    uint16_t frameId = REALDASH_FRAME_ID - 1;
+
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        const Input* input = &inputs[i];
+        if (!isRealdashSignal(input)) continue;
+
+        uint8_t width = getPackedScale(input->measurementType).width;
+        if (used + width > REALDASH_MAX_DATA) {
+            if (frameId >= REALDASH_FRAME_ID) msg.control.println(F("    </frame>"));
+            frameId++;
+            msg.control.print(F("    <frame id=\"0x"));
+            msg.control.print(frameId, HEX);
+            msg.control.println(F("\">"));
+            used = 0;
+        }
+        printRealDashValue(input, used);
+        used += width;
+    }
+    if (frameId >= REALDASH_FRAME_ID) msg.control.println(F("    </frame>"));
+
+    msg.control.println(F("  </frames>"));
+    msg.control.println(F("</RealDashCAN>"));
+}
+
+#endif // !REALDASH_FRAME_44
+
 void initRealdash() {
     // Serial initialization happens in main.cpp
     msg.data.println("✓ RealDash output initialized");
 }
 
-void sendRealdash(Input *ptr) {
-    if (isnan(ptr->value)) {
-        return;
-    }
+void sendRealdashBatch(const uint8_t* slots, uint8_t count, const InputSample* samples, uint32_t now) {
+    (void)now;
+#ifndef REALDASH_FRAME_44
+    (void)slots;
+    (void)count;
+    flushRealdashFrames(samples);  // Every routed input, so the signal positions stay put
+#else
+    (void)samples;  // The PID bytes are encoded at read time (refreshOBD2Data)
 
     // RealDash requires specific framing
     byte preamble[4] = {0x44, 0x33, 0x22, 0x11};
-    unsigned long canFrameId = 0x0C80;  // Base frame ID
+    unsigned long canFrameId = REALDASH_FRAME_ID;  // Base frame ID
 
-    byte frameData[8];
+    for (uint8_t k = 0; k < count; k++) {
+        byte frameData[8];
 
-    // Build OBDII frame using shared helper (fixes length byte and endianness)
-    if (!buildOBD2Frame(frameData, ptr)) {
-        return;  // Invalid data size
-    }
+        // Build OBDII frame using shared helper (fixes length byte and endianness)
+        if (!buildOBD2Frame(frameData, &inputs[slots[k]])) {
+            continue;  // Invalid data size
+        }
 
-    // Send RealDash frame to data plane
-    msg.data.write(preamble, 4);
-    msg.data.write((const byte*)&canFrameId, 4);
-    msg.data.write(frameData, 8);
+        // Assemble RealDash frame - the batch goes out in one write
+        outputFrame.append(preamble, 4);
+        outputFrame.append((const byte*)&canFrameId, 4);
+        outputFrame.append(frameData, 8);
+    }
+#endif
 }
 
 void updateRealdash() {
     // Handle any incoming RealDash commands if needed
 }
 
+#ifdef REALDASH_FRAME_44
+void printRealdashXML() {
+    msg.control.println(F("Legacy 0x44 framing - use docs/realdash/preOBD.xml"));
+}
+#endif
+
 #else
 
 void initRealdash() {}
-void sendRealdash(Input *ptr) {}
+void sendRealdashBatch(const uint8_t* slots, uint8_t count, const InputSample* samples, uint32_t now) {}
 void updateRealdash() {}
+void printRealdashXML() {}
 
 #endif
@@ -0,0 +1,25 @@
+/*
+ * output_realdash.h - RealDash binary output for data plane
+ *
+ * initRealdash() / sendRealdashBatch() / updateRealdash() are the output
+ * module hooks (output_manager.cpp).
+ */
+
+#ifndef OUTPUT_REALDASH_H
+#define OUTPUT_REALDASH_H
+
+#include <Arduino.h>
+#include "../inputs/input.h"
+#include "../inputs/input_snapshot.h"
+
+void initRealdash();
+void sendRealdashBatch(const uint8_t* slots, uint8_t count, const InputSample* samples, uint32_t now);
+void updateRealdash();
+
+/**
+ * Print the RealDash XML channel description for the current inputs
+ * (OUTPUT RealDash XML) to the control port
+ */
+void printRealdashXML();
+
+#endif // OUTPUT_REALDASH_H
@@ -4,6 +4,16 @@
  * Controls 12V relays based on sensor thresholds with hysteresis.
  * Supports manual override and EEPROM-backed configuration.
  *
+ * Bindings: boundTo[] holds, per input slot, the automatic relays reading
+ * it. A relay is evaluated when that input's sequence moves, when its
+ * configuration changes, or while it is pending (minimum on/off time or
+ * warmup not over yet).
+ *
+ * RELAY_PWM relays are bound the same way; each new reading recomputes the
+ * duty from the relay's curve. The pin is switched between digital and PWM
+ * use lazily in applyRelay(), so mode, pin and frequency changes only mark
+ * the relay pending.
+ *
  * Design pattern follows output_alarm.cpp for consistency.
  */
 
@@ -17,10 +27,122 @@
 #include "../lib/message_api.h"
 #include "../lib/units_registry.h"
 #include "../lib/log_tags.h"
+#include "../inputs/sensors/sensor_utils.h"
 
 // ===== RUNTIME STATE =====
 static RelayRuntimeState relayStates[MAX_RELAYS];
 
+static uint16_t boundTo[MAX_INPUTS];   // Automatic relays reading each input
+static uint8_t lastSeq[MAX_INPUTS];    // Input.sequence last evaluated
+static uint16_t pending;               // Relays to evaluate on the next update
+
+// ===== DUTY CURVES =====
+// X: position between thresholdOff (0) and thresholdOn (1), ascending; Y: duty %
+
+static const float PROGMEM curveLinearX[] = {0.0, 1.0};
+static const float PROGMEM curveLinearY[] = {0.0, 100.0};
+static const float PROGMEM curveQuadraticX[] = {0.0, 0.25, 0.5, 0.75, 1.0};
+static const float PROGMEM curveQuadraticY[] = {0.0, 6.25, 25.0, 56.25, 100.0};
+static const float PROGMEM curveFanX[] = {0.0, 0.05, 0.0501, 1.0};
+static const float PROGMEM curveFanY[] = {0.0, 0.0, 30.0, 100.0};
+static const float PROGMEM curvePumpX[] = {0.0, 1.0};
+static const float PROGMEM curvePumpY[] = {20.0, 100.0};
+
+struct RelayCurveTable {
+    const char* name;
+    uint8_t size;
+    const float* x;
+    const float* y;
+};
+
+static const RelayCurveTable curves[NUM_RELAY_CURVES] = {
+    {"LINEAR", 2, curveLinearX, curveLinearY},
+    {"QUADRATIC", 5, curveQuadraticX, curveQuadraticY},
+    {"FAN", 4, curveFanX, curveFanY},
+    {"PUMP", 2, curvePumpX, curvePumpY},
+};
+
+// ===== PLATFORM PWM =====
+
+#ifdef ESP32
+// LEDC channels after the RGB LED's 0-2
+#define RELAY_LEDC_CHANNEL(i) (3 + (i))
+
+static bool canPwm(uint8_t relayIndex, uint8_t pin) {
+    (void)pin;
+#ifdef SOC_LEDC_CHANNEL_NUM
+    if (RELAY_LEDC_CHANNEL(relayIndex) >= SOC_LEDC_CHANNEL_NUM) return false;
+#endif
+    return true;
+}
+
+static bool attachPwm(uint8_t relayIndex, uint8_t pin, uint16_t hz) {
+    if (!canPwm(relayIndex, pin)) return false;
+    ledcSetup(RELAY_LEDC_CHANNEL(relayIndex), hz ? hz : RELAY_PWM_DEFAULT_HZ, 8);
+    ledcAttachPin(pin, RELAY_LEDC_CHANNEL(relayIndex));
+    return true;
+}
+
+static void writePwm(uint8_t relayIndex, uint8_t pin, uint8_t duty) {
+    (void)pin;
+    ledcWrite(RELAY_LEDC_CHANNEL(relayIndex), duty);
+}
+
+static void detachPwm(uint8_t pin) {
+    ledcDetachPin(pin);
+}
+
+#else
+// Teensy and Arduino use standard analogWrite
+static bool canPwm(uint8_t relayIndex, uint8_t pin) {
+    (void)relayIndex;
+#ifdef digitalPinHasPWM
+    return digitalPinHasPWM(pin);
+#else
+    (void)pin;
+    return true;
+#endif
+}
+
+static bool attachPwm(uint8_t relayIndex, uint8_t pin, uint16_t hz) {
+    if (!canPwm(relayIndex, pin)) return false;
+    pinMode(pin, OUTPUT);
+#if defined(TEENSYDUINO)
+    if (hz) analogWriteFrequency(pin, hz);
+#else
+    (void)hz;  // Fixed by the timer on AVR / Due
+#endif
+    return true;
+}
+
+static void writePwm(uint8_t relayIndex, uint8_t pin, uint8_t duty) {
+    (void)relayIndex;
+    analogWrite(pin, duty);
+}
+
+static void detachPwm(uint8_t pin) {
+    (void)pin;
+}
+#endif
+
+/**
+ * Return a relay's pin to plain digital output, driven LOW
+ * @param relayIndex Relay index
+ */
+static void releasePwm(uint8_t relayIndex) {
+    RelayRuntimeState* state = &relayStates[relayIndex];
+    uint8_t pin = systemConfig.relays[relayIndex].outputPin;
+    if (!state->pwmAttached) return;
+
+    state->pwmAttached = false;
+    state->duty = 0;
+    state->currentState = false;
+    if (pin == 0xFF) return;
+    detachPwm(pin);
+    pinMode(pin, OUTPUT);
+    digitalWrite(pin, LOW);
+}
+
 // ===== HELPER FUNCTIONS =====
 
 /**
@@ -28,7 +150,7 @@ static RelayRuntimeState relayStates[MAX_RELAYS];
  * @param inputPin Analog/digital pin number
  * @return Input array index, or 0xFF if not found
  */
-static uint8_t getInputIndexByPin(uint8_t inputPin) {
+static uint8_t getInputIndexByPin(InputPin inputPin) {
     for (uint8_t i = 0; i < MAX_INPUTS; i++) {
         if (inputs[i].flags.isEnabled && inputs[i].pin == inputPin) {
             return i;
@@ -38,15 +160,14 @@ static uint8_t getInputIndexByPin(uint8_t inputPin) {
 }
 
 /**
- * Evaluate relay rule and determine desired state
- * Implements hysteresis logic with separate on/off thresholds
+ * Read a relay's source input, if the relay may act on it
  *
  * @param relayIndex Index of relay to evaluate
- * @return Desired relay state (true = ON, false = OFF)
+ * @param value Receives the input value
+ * @return false if the relay must be OFF (no input, disabled, NaN, warmup)
  */
-static bool evaluateRelayRule(uint8_t relayIndex) {
+static bool readRelayInput(uint8_t relayIndex, float* value) {
     RelayConfig* cfg = &systemConfig.relays[relayIndex];
-    RelayRuntimeState* state = &relayStates[relayIndex];
 
     // Safety: Check if input is assigned and valid
     if (cfg->inputIndex >= MAX_INPUTS) {
@@ -60,13 +181,33 @@ static bool evaluateRelayRule(uint8_t relayIndex) {
         return false;
     }
 
-    // Safety: Don't activate during warmup or init
+    // Safety: Don't activate during warmup or init (which ends without a new reading)
     if (input->alarmContext.state == ALARM_WARMUP ||
         input->alarmContext.state == ALARM_INIT) {
+        pending |= 1u << relayIndex;
+        return false;
+    }
+
+    *value = input->value;
+    return true;
+}
+
+/**
+ * Evaluate relay rule and determine desired state
+ * Implements hysteresis logic with separate on/off thresholds
+ *
+ * @param relayIndex Index of relay to evaluate
+ * @return Desired relay state (true = ON, false = OFF)
+ */
+static bool evaluateRelayRule(uint8_t relayIndex) {
+    RelayConfig* cfg = &systemConfig.relays[relayIndex];
+    RelayRuntimeState* state = &relayStates[relayIndex];
+
+    float value;
+    if (!readRelayInput(relayIndex, &value)) {
         return false;
     }
 
-    float value = input->value;
     bool currentState = state->currentState;
 
     // Hysteresis logic based on mode
@@ -98,6 +239,140 @@ static bool evaluateRelayRule(uint8_t relayIndex) {
     return false;
 }
 
+/**
+ * Duty for a RELAY_PWM relay from its input and curve
+ *
+ * @param relayIndex Index of relay to evaluate
+ * @return PWM output 0-255 (0 when the relay must be OFF)
+ */
+static uint8_t evaluateRelayDuty(uint8_t relayIndex) {
+    RelayConfig* cfg = &systemConfig.relays[relayIndex];
+
+    float value;
+    if (!readRelayInput(relayIndex, &value)) {
+        return 0;
+    }
+
+    float span = cfg->thresholdOn - cfg->thresholdOff;
+    if (span == 0) {
+        return 0;  // No range configured
+    }
+
+    const RelayCurveTable* curve = &curves[cfg->curve < NUM_RELAY_CURVES ? cfg->curve : RELAY_CURVE_LINEAR];
+    float percent = interpolateAscending((value - cfg->thresholdOff) / span, curve->size, curve->x, curve->y);
+    if (!(percent > 0)) return 0;
+    if (percent >= 100) return 255;
+    return (uint8_t)(percent * 2.55f + 0.5f);
+}
+
+static bool isAutoMode(uint8_t mode) {
+    return mode == RELAY_AUTO_HIGH || mode == RELAY_AUTO_LOW;
+}
+
+static bool isInputDriven(uint8_t mode) {
+    return isAutoMode(mode) || mode == RELAY_PWM;
+}
+
+/**
+ * Drive a RELAY_PWM relay: set the pin up for PWM if needed, then write the duty
+ *
+ * @param relayIndex Index of relay to update
+ */
+static void applyPwm(uint8_t relayIndex) {
+    RelayConfig* cfg = &systemConfig.relays[relayIndex];
+    RelayRuntimeState* state = &relayStates[relayIndex];
+
+    if (!state->pwmAttached) {
+        if (!attachPwm(relayIndex, cfg->outputPin, cfg->pwmFrequency)) {
+            msg.debug.warn(TAG_RELAY, "Relay %d: pin %d has no hardware PWM", relayIndex, cfg->outputPin);
+            return;
+        }
+        state->pwmAttached = true;
+        state->duty = 0;
+        writePwm(relayIndex, cfg->outputPin, 0);
+    }
+
+    uint8_t duty = evaluateRelayDuty(relayIndex);
+    if (duty == state->duty) return;
+
+    writePwm(relayIndex, cfg->outputPin, duty);
+    state->duty = duty;
+    if ((duty > 0) != state->currentState) {
+        state->currentState = duty > 0;
+        state->lastStateChange = millis();
+        state->stateChangeCount++;
+    }
+}
+
+/**
+ * Rebuild the input bindings after a configuration change
+ * Every configured relay is evaluated on the next update
+ */
+void bindRelays() {
+    memset(boundTo, 0, sizeof(boundTo));
+    for (uint8_t i = 0; i < MAX_RELAYS; i++) {
+        const RelayConfig* cfg = &systemConfig.relays[i];
+        if (cfg->outputPin == 0xFF) continue;
+        pending |= 1u << i;
+        if (isInputDriven(cfg->mode) && cfg->inputIndex < MAX_INPUTS) {
+            boundTo[cfg->inputIndex] |= 1u << i;
+        }
+    }
+}
+
+/**
+ * Evaluate one relay and switch its output
+ * Automatic switching waits out the minimum on/off time; manual modes
+ * and DISABLED apply at once.
+ *
+ * @param relayIndex Index of relay to update
+ */
+static void applyRelay(uint8_t relayIndex) {
+    RelayConfig* cfg = &systemConfig.relays[relayIndex];
+    RelayRuntimeState* state = &relayStates[relayIndex];
+    if (cfg->outputPin == 0xFF) return;
+
+    if (cfg->mode == RELAY_PWM) {
+        applyPwm(relayIndex);
+        return;
+    }
+    releasePwm(relayIndex);  // Leaving PWM mode: the pin is digital and LOW again
+
+    bool desiredState = false;
+    switch (cfg->mode) {
+        case RELAY_MANUAL_ON:
+            desiredState = true;
+            break;
+
+        case RELAY_AUTO_HIGH:
+        case RELAY_AUTO_LOW:
+            desiredState = evaluateRelayRule(relayIndex);
+            break;
+
+        default:
+            desiredState = false;
+            break;
+    }
+
+    if (desiredState == state->currentState) return;
+
+    uint32_t now = millis();
+    if (isAutoMode(cfg->mode)) {
+        uint16_t minMs = state->currentState ? cfg->minOnMs : cfg->minOffMs;
+        if (now - state->lastStateChange < minMs) {
+            pending |= 1u << relayIndex;  // Check again until the time is up
+            return;
+        }
+    }
+
+    digitalWrite(cfg->outputPin, desiredState ? HIGH : LOW);
+    state->currentState = desiredState;
+    state->lastStateChange = now;
+    state->stateChangeCount++;
+
+    msg.debug.info(TAG_RELAY, "Relay %d -> %s", relayIndex, desiredState ? "ON" : "OFF");
+}
+
 // ===== OUTPUT MODULE INTERFACE =====
 
 /**
@@ -113,6 +388,8 @@ void initRelayOutput() {
         state->currentState = false;
         state->lastStateChange = millis();
         state->stateChangeCount = 0;
+        state->duty = 0;
+        state->pwmAttached = false;
 
         // Skip disabled or unconfigured relays
         if (cfg->mode == RELAY_DISABLED || cfg->outputPin == 0xFF) {
@@ -128,6 +405,9 @@ void initRelayOutput() {
         msg.debug.info(TAG_RELAY, "Relay %d initialized on pin %d", i, cfg->outputPin);
     }
 
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) lastSeq[i] = inputs[i].sequence;
+    pending = 0;
+    bindRelays();
     msg.debug.info(TAG_RELAY, "Relay output initialized");
 }
 
@@ -136,56 +416,26 @@ void initRelayOutput() {
  * Required by OutputModule interface but not used for relays
  */
 void sendRelayOutput(Input* input) {
-    // Relay decisions are made by scanning configuration in updateRelayOutput()
-    // This function is called by output manager but we don't need per-input logic
+    // Relays follow their input's sequence in updateRelayOutput(), as soon as it
+    // has a new reading, rather than the output interval
 }
 
 /**
  * Update relay outputs
  * Called every loop iteration by output manager
- * Evaluates rules and controls relay GPIO pins
+ * Evaluates only the relays whose input has a new reading, or that are pending
  */
 void updateRelayOutput() {
-    for (uint8_t i = 0; i < MAX_RELAYS; i++) {
-        RelayConfig* cfg = &systemConfig.relays[i];
-        RelayRuntimeState* state = &relayStates[i];
-
-        // Skip disabled relays
-        if (cfg->mode == RELAY_DISABLED || cfg->outputPin == 0xFF) {
-            continue;
-        }
-
-        bool desiredState = false;
-
-        // Determine desired state based on mode
-        switch (cfg->mode) {
-            case RELAY_MANUAL_ON:
-                desiredState = true;
-                break;
-
-            case RELAY_MANUAL_OFF:
-                desiredState = false;
-                break;
-
-            case RELAY_AUTO_HIGH:
-            case RELAY_AUTO_LOW:
-                desiredState = evaluateRelayRule(i);
-                break;
-
-            default:
-                desiredState = false;
-                break;
-        }
-
-        // Update output if state changed
-        if (desiredState != state->currentState) {
-            digitalWrite(cfg->outputPin, desiredState ? HIGH : LOW);
-            state->currentState = desiredState;
-            state->lastStateChange = millis();
-            state->stateChangeCount++;
+    uint16_t dirty = pending;
+    pending = 0;
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        if (boundTo[i] == 0 || inputs[i].sequence == lastSeq[i]) continue;
+        lastSeq[i] = inputs[i].sequence;
+        dirty |= boundTo[i];
+    }
 
-            msg.debug.info(TAG_RELAY, "Relay %d -> %s", i, desiredState ? "ON" : "OFF");
-        }
+    for (uint8_t r = 0; dirty != 0; r++, dirty >>= 1) {
+        if (dirty & 1) applyRelay(r);
     }
 }
 
@@ -193,7 +443,7 @@ void updateRelayOutput() {
 
 /**
  * Set relay output pin
- * @param relayIndex Relay index (0-1)
+ * @param relayIndex Relay index (0 to MAX_RELAYS-1)
  * @param pin GPIO pin number
  * @return true if successful
  */
@@ -204,22 +454,54 @@ bool setRelayPin(uint8_t relayIndex, uint8_t pin) {
     }
 
     RelayConfig* cfg = &systemConfig.relays[relayIndex];
+    RelayRuntimeState* state = &relayStates[relayIndex];
+
+    if (cfg->mode == RELAY_PWM && !canPwm(relayIndex, pin)) {
+        msg.control.println(F("ERROR: Pin has no hardware PWM (relay is in PWM mode)"));
+        return false;
+    }
+
+    // Release the old pin rather than leave it driven
+    releasePwm(relayIndex);
+    if (cfg->outputPin != 0xFF && cfg->outputPin != pin) {
+        digitalWrite(cfg->outputPin, LOW);
+    }
 
     // Configure new pin
     cfg->outputPin = pin;
     pinMode(pin, OUTPUT);
     digitalWrite(pin, LOW);  // Start in OFF state
+    if (state->currentState) {
+        state->currentState = false;
+        state->lastStateChange = millis();
+    }
 
+    bindRelays();
     return true;
 }
 
+/**
+ * Check whether an input drives any relay in an automatic mode
+ * @param inputIndex Index into inputs[] array
+ * @return true if a relay depends on this input's value
+ */
+bool isRelayInput(uint8_t inputIndex) {
+    for (uint8_t i = 0; i < MAX_RELAYS; i++) {
+        const RelayConfig* cfg = &systemConfig.relays[i];
+        if (cfg->inputIndex == inputIndex && isInputDriven(cfg->mode)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 /**
  * Link relay to sensor input
- * @param relayIndex Relay index (0-1)
+ * @param relayIndex Relay index (0 to MAX_RELAYS-1)
  * @param inputPin Sensor pin number (e.g., A0, A1, etc.)
  * @return true if successful
  */
-bool setRelayInput(uint8_t relayIndex, uint8_t inputPin) {
+bool setRelayInput(uint8_t relayIndex, InputPin inputPin) {
     if (relayIndex >= MAX_RELAYS) {
         msg.control.println(F("ERROR: Invalid relay index"));
         return false;
@@ -233,12 +515,13 @@ bool setRelayInput(uint8_t relayIndex, uint8_t inputPin) {
     }
 
     systemConfig.relays[relayIndex].inputIndex = inputIndex;
+    bindRelays();
     return true;
 }
 
 /**
  * Set relay thresholds
- * @param relayIndex Relay index (0-1)
+ * @param relayIndex Relay index (0 to MAX_RELAYS-1)
  * @param thresholdOn Activation threshold
  * @param thresholdOff Deactivation threshold
  * @return true if successful
@@ -263,12 +546,13 @@ bool setRelayThresholds(uint8_t relayIndex, float thresholdOn, float thresholdOf
 
     cfg->thresholdOn = thresholdOn;
     cfg->thresholdOff = thresholdOff;
+    pending |= 1u << relayIndex;
     return true;
 }
 
 /**
  * Set relay mode
- * @param relayIndex Relay index (0-1)
+ * @param relayIndex Relay index (0 to MAX_RELAYS-1)
  * @param mode RelayMode enum value
  * @return true if successful
  */
@@ -278,13 +562,44 @@ bool setRelayMode(uint8_t relayIndex, RelayMode mode) {
         return false;
     }
 
-    systemConfig.relays[relayIndex].mode = mode;
+    RelayConfig* cfg = &systemConfig.relays[relayIndex];
+    if (mode == RELAY_PWM && cfg->outputPin != 0xFF && !canPwm(relayIndex, cfg->outputPin)) {
+        msg.control.println(F("ERROR: Relay pin has no hardware PWM"));
+        return false;
+    }
+
+    cfg->mode = mode;
+    bindRelays();
+    return true;
+}
+
+/**
+ * Set minimum on/off times (contactor protection)
+ * @param relayIndex Relay index
+ * @param minOnMs Shortest time ON before an automatic switch OFF (0-60000)
+ * @param minOffMs Shortest time OFF before an automatic switch ON (0-60000)
+ * @return true if successful
+ */
+bool setRelayMinTimes(uint8_t relayIndex, uint16_t minOnMs, uint16_t minOffMs) {
+    if (relayIndex >= MAX_RELAYS) {
+        msg.control.println(F("ERROR: Invalid relay index"));
+        return false;
+    }
+    if (minOnMs > RELAY_MAX_MIN_TIME_MS || minOffMs > RELAY_MAX_MIN_TIME_MS) {
+        msg.control.println(F("ERROR: Minimum times are 0-60000 ms"));
+        return false;
+    }
+
+    RelayConfig* cfg = &systemConfig.relays[relayIndex];
+    cfg->minOnMs = minOnMs;
+    cfg->minOffMs = minOffMs;
+    pending |= 1u << relayIndex;
     return true;
 }
 
 /**
  * Get current relay state
- * @param relayIndex Relay index (0-1)
+ * @param relayIndex Relay index (0 to MAX_RELAYS-1)
  * @return Current state (true = ON, false = OFF)
  */
 bool getRelayState(uint8_t relayIndex) {
@@ -295,11 +610,74 @@ bool getRelayState(uint8_t relayIndex) {
     return relayStates[relayIndex].currentState;
 }
 
+/**
+ * Set the duty curve used in RELAY_PWM mode
+ * @param relayIndex Relay index
+ * @param curve RelayCurve enum value
+ * @return true if successful
+ */
+bool setRelayCurve(uint8_t relayIndex, RelayCurve curve) {
+    if (relayIndex >= MAX_RELAYS || curve >= NUM_RELAY_CURVES) {
+        msg.control.println(F("ERROR: Invalid relay index or curve"));
+        return false;
+    }
+
+    systemConfig.relays[relayIndex].curve = curve;
+    pending |= 1u << relayIndex;
+    return true;
+}
+
+/**
+ * Set the PWM frequency used in RELAY_PWM mode
+ * @param relayIndex Relay index
+ * @param hz Frequency (1-40000), 0 = platform default
+ * @return true if successful
+ */
+bool setRelayFrequency(uint8_t relayIndex, uint16_t hz) {
+    if (relayIndex >= MAX_RELAYS) {
+        msg.control.println(F("ERROR: Invalid relay index"));
+        return false;
+    }
+    if (hz > RELAY_MAX_PWM_HZ) {
+        msg.control.println(F("ERROR: Frequency is 0-40000 Hz"));
+        return false;
+    }
+
+    systemConfig.relays[relayIndex].pwmFrequency = hz;
+    releasePwm(relayIndex);  // Set up again at the new frequency
+    pending |= 1u << relayIndex;
+    return true;
+}
+
+/**
+ * Get current PWM duty
+ * @param relayIndex Relay index
+ * @return Duty in percent (0 unless in RELAY_PWM mode)
+ */
+uint8_t getRelayDutyPercent(uint8_t relayIndex) {
+    if (relayIndex >= MAX_RELAYS) {
+        return 0;
+    }
+
+    return (uint8_t)((relayStates[relayIndex].duty * 100u + 127) / 255);
+}
+
+uint8_t getRelayCurveByName(const char* name) {
+    for (uint8_t i = 0; i < NUM_RELAY_CURVES; i++) {
+        if (strcasecmp(name, curves[i].name) == 0) return i;
+    }
+    return 0xFF;
+}
+
+const char* getRelayCurveName(uint8_t curve) {
+    return (curve < NUM_RELAY_CURVES) ? curves[curve].name : "UNKNOWN";
+}
+
 // ===== QUERY FUNCTIONS =====
 
 /**
  * Print status of a specific relay
- * @param relayIndex Relay index (0-1)
+ * @param relayIndex Relay index (0 to MAX_RELAYS-1)
  */
 void printRelayStatus(uint8_t relayIndex) {
     if (relayIndex >= MAX_RELAYS) {
@@ -352,6 +730,7 @@ void printRelayStatus(uint8_t relayIndex) {
         case RELAY_AUTO_LOW:    msg.control.println(F("AUTO_LOW")); break;
         case RELAY_MANUAL_ON:   msg.control.println(F("MANUAL_ON")); break;
         case RELAY_MANUAL_OFF:  msg.control.println(F("MANUAL_OFF")); break;
+        case RELAY_PWM:         msg.control.println(F("PWM")); break;
         default:                msg.control.println(F("UNKNOWN")); break;
     }
 
@@ -359,10 +738,31 @@ void printRelayStatus(uint8_t relayIndex) {
     msg.control.println(cfg->thresholdOn);
     msg.control.print(F("Threshold OFF: "));
     msg.control.println(cfg->thresholdOff);
+    if (cfg->mode == RELAY_PWM) {
+        msg.control.print(F("Curve: "));
+        msg.control.println(getRelayCurveName(cfg->curve));
+        msg.control.print(F("PWM Frequency: "));
+        if (cfg->pwmFrequency == 0) {
+            msg.control.println(F("platform default"));
+        } else {
+            msg.control.print(cfg->pwmFrequency);
+            msg.control.println(F(" Hz"));
+        }
+        msg.control.print(F("Duty: "));
+        msg.control.print(getRelayDutyPercent(relayIndex));
+        msg.control.println(F("%"));
+    }
+    msg.control.print(F("Min ON/OFF: "));
+    msg.control.print(cfg->minOnMs);
+    msg.control.print(F(" / "));
+    msg.control.print(cfg->minOffMs);
+    msg.control.println(F(" ms"));
 
     // Runtime state
     msg.control.print(F("Current State: "));
-    msg.control.println(state->currentState ? F("ON") : F("OFF"));
+    msg.control.print(state->currentState ? F("ON") : F("OFF"));
+    if (pending & (1u << relayIndex)) msg.control.print(F(" (switch pending)"));
+    msg.control.println();
 
     msg.control.print(F("State Changes: "));
     msg.control.println(state->stateChangeCount);
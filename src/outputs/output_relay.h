@@ -4,10 +4,28 @@
  * Enables automatic control of relays based on sensor thresholds with hysteresis.
  * Supports manual override and EEPROM-backed configuration.
  *
+ * Relays are bound to their source input: per input slot a mask of the
+ * automatic relays reading it, and updateRelayOutput() evaluates only the
+ * relays whose input has a new reading (Input.sequence) - not every relay
+ * every loop. A relay waiting out its minimum on/off time (or its input's
+ * warmup) stays pending and is checked each loop until it can switch.
+ *
+ * RELAY_PWM drives the pin with hardware PWM instead: the input value's
+ * position between thresholdOff (0) and thresholdOn (1) is looked up in a
+ * PROGMEM duty curve (interpolateAscending() table format, duty in %), and
+ * the duty is rewritten on each new reading. thresholdOn below thresholdOff
+ * runs the curve the other way (duty rises as the value falls). The PWM
+ * frequency is set per relay; 0 keeps the platform default. On Teensy the
+ * frequency applies to every pin on the same timer.
+ *
  * Example use cases:
  *   - Turn on cooling fan when coolant temp >= 100°C, off at 95°C
  *   - Activate warning light when oil pressure drops below threshold
  *   - Control electric water pump based on temperature
+ *
+ * Build Flags:
+ *   -D MAX_RELAYS=n             - Relays (default 16 on Teensy 4.x, 2 elsewhere; max 16)
+ *   -D RELAY_PWM_DEFAULT_HZ=n   - ESP32 PWM frequency when none is set (default 1000)
  */
 
 #ifndef OUTPUT_RELAY_H
@@ -18,8 +36,21 @@
 
 // Maximum number of relays supported (can be overridden by build flag)
 #ifndef MAX_RELAYS
+#if defined(__IMXRT1062__)
+#define MAX_RELAYS 16
+#else
 #define MAX_RELAYS 2
 #endif
+#endif
+
+static_assert(MAX_RELAYS <= 16, "Relay masks are 16 bits");
+
+#define RELAY_MAX_MIN_TIME_MS 60000  // Longest minimum on/off time
+#define RELAY_MAX_PWM_HZ 40000       // Highest PWM frequency
+
+#ifndef RELAY_PWM_DEFAULT_HZ
+#define RELAY_PWM_DEFAULT_HZ 1000
+#endif
 
 // ===== RELAY CONFIGURATION =====
 
@@ -29,18 +60,31 @@ enum RelayMode : uint8_t {
     RELAY_AUTO_HIGH = 1,    // Turn ON when value >= thresholdOn, OFF when value <= thresholdOff
     RELAY_AUTO_LOW = 2,     // Turn ON when value <= thresholdOn, OFF when value >= thresholdOff
     RELAY_MANUAL_ON = 3,    // Manual override - forced ON
-    RELAY_MANUAL_OFF = 4    // Manual override - forced OFF
+    RELAY_MANUAL_OFF = 4,   // Manual override - forced OFF
+    RELAY_PWM = 5           // Duty from the input value through a duty curve
+};
+
+// Duty curves for RELAY_PWM (RelayConfig.curve)
+enum RelayCurve : uint8_t {
+    RELAY_CURVE_LINEAR = 0,     // 0-100% across the range
+    RELAY_CURVE_QUADRATIC = 1,  // Slow start, steep top (fan law)
+    RELAY_CURVE_FAN = 2,        // Off at the start, then 30-100% (fans stall below ~30%)
+    RELAY_CURVE_PUMP = 3,       // 20% minimum flow, up to 100%
+    NUM_RELAY_CURVES = 4
 };
 
-// Per-relay configuration (16 bytes) - stored in EEPROM
+// Per-relay configuration (20 bytes) - stored in EEPROM
 struct RelayConfig {
     uint8_t outputPin;           // GPIO pin number (0xFF = unconfigured)
     uint8_t inputIndex;          // Index into inputs[] array (0xFF = unassigned)
     uint8_t mode;                // RelayMode enum
-    uint8_t reserved;            // Padding for alignment
-    float thresholdOn;           // Activation threshold in standard units (°C, bar, etc.)
-    float thresholdOff;          // Deactivation threshold in standard units
-    uint32_t reserved2;          // Future expansion
+    uint8_t curve;               // RelayCurve enum (RELAY_PWM)
+    float thresholdOn;           // Activation threshold in standard units (°C, bar, etc.); PWM: 100% end
+    float thresholdOff;          // Deactivation threshold in standard units; PWM: 0% end
+    uint16_t minOnMs;            // Shortest time ON before switching OFF (0 = none)
+    uint16_t minOffMs;           // Shortest time OFF before switching ON (0 = none)
+    uint16_t pwmFrequency;       // RELAY_PWM frequency in Hz (0 = platform default)
+    uint16_t reserved;           // Future expansion
 };
 
 // Runtime state (not persisted to EEPROM)
@@ -48,6 +92,8 @@ struct RelayRuntimeState {
     bool currentState;           // Current relay output state (HIGH/LOW)
     uint32_t lastStateChange;    // millis() when state last changed
     uint32_t stateChangeCount;   // Debug counter for state changes
+    uint8_t duty;                // RELAY_PWM output (0-255)
+    bool pwmAttached;            // Pin currently set up for PWM
 };
 
 // ===== OUTPUT MODULE INTERFACE =====
@@ -55,16 +101,24 @@ struct RelayRuntimeState {
 
 void initRelayOutput();          // Initialize relay GPIO pins
 void sendRelayOutput(Input* input);  // Per-input send (unused for relays)
-void updateRelayOutput();        // Main update function (called every loop)
+void updateRelayOutput();        // Evaluate relays whose input updated (called every loop)
 
 // ===== CONFIGURATION API =====
 // Used by serial command handlers
 
 bool setRelayPin(uint8_t relayIndex, uint8_t pin);
-bool setRelayInput(uint8_t relayIndex, uint8_t inputPin);
+bool setRelayInput(uint8_t relayIndex, InputPin inputPin);
 bool setRelayThresholds(uint8_t relayIndex, float thresholdOn, float thresholdOff);
 bool setRelayMode(uint8_t relayIndex, RelayMode mode);
+bool setRelayMinTimes(uint8_t relayIndex, uint16_t minOnMs, uint16_t minOffMs);
+bool setRelayCurve(uint8_t relayIndex, RelayCurve curve);
+bool setRelayFrequency(uint8_t relayIndex, uint16_t hz);
+void bindRelays();                       // Rebind after systemConfig.relays is replaced (LOAD)
 bool getRelayState(uint8_t relayIndex);
+uint8_t getRelayDutyPercent(uint8_t relayIndex);  // RELAY_PWM duty, 0-100
+uint8_t getRelayCurveByName(const char* name);    // RelayCurve, or 0xFF if unknown
+const char* getRelayCurveName(uint8_t curve);
+bool isRelayInput(uint8_t inputIndex);   // True if any active relay is driven by this input
 
 // ===== QUERY FUNCTIONS =====
 // For status display and debugging
@@ -1,6 +1,100 @@
 /*
  * output_sdlog.cpp - SD card data logging module
- * Example of how to add a new output module
+ *
+ * Logs to binary columnar files in /logs: a header describing each
+ * channel once, then one fixed-size record per send tick holding the
+ * timestamp and every logged input as a scaled integer. No names, units or
+ * float formatting per value - tools/sdlog_convert.py turns a log into CSV
+ * or Parquet. The format is in packed_log.h:
+ *
+ *   Header   "POBL" version channels recordSize startMs startUnix  (16 bytes)
+ *   Channel  name[8] units[6] width - factor offset             (24 bytes each)
+ *   Record   ms (uint32) + each channel's value, little-endian
+ *
+ * Values are in standard units with the packed signal scaling
+ * (packed_signal.h): physical = raw * factor + offset, all ones = no data.
+ * The channels are the inputs routed to SD_Log when the file is opened.
+ *
+ * Write path: log bytes are staged in two sector-sized RAM buffers. When
+ * one fills it is handed to the card with a single write() from
+ * updateSDLog() while the other keeps collecting, so the card never sees
+ * small fragments and a slow card only delays the handoff - it is put off
+ * while the loop is over budget, while higher-priority SPI work shares the
+ * card's bus and is due (the SPI arbiter in lib/bus_manager.h) and, on
+ * Teensy, while the card reports busy. With both buffers full the newest record is dropped (an overrun)
+ * rather than waiting. Every sync interval a partly filled buffer is written
+ * too, bounding what a power cut loses; the buffer after it is cut short so
+ * writes end on a sector boundary again. With the power-fail service
+ * (lib/power_fail.h) a supply loss closes the log first - closeSDLog() -
+ * so the interval is longer by default, and reopenSDLog() starts the next
+ * segment if the supply comes back. A sync after writes that all went
+ * through is the log's heartbeat to the task watchdog (lib/watchdog.h), so a
+ * card that fails every write - or a log that never reopened after a
+ * rotation - ends in a reset rather than silence.
+ *
+ * On Teensy 4.x the file is opened through SdFat (the engine under its SD
+ * library, SDIO on BUILTIN_SDCARD) and preallocated as one contiguous run of
+ * clusters, so no FAT or directory updates happen while logging. A log that
+ * is never closed keeps its preallocated size; sdlog_convert.py stops at the
+ * first unwritten record.
+ *
+ * Segments: the log rotates to a new file after SD_LOG_SEGMENT_MB or
+ * SD_LOG_SEGMENT_MINUTES, whichever comes first, so no file grows without
+ * bound and each one gets its own contiguous preallocation. Names sort in
+ * time order: YYYYMMDD_HHMMSS.pbl (UTC) when the wall clock is known
+ * (hal_clock.h - Teensy RTC, or a time source calling setWallClock()),
+ * otherwise BBBBB_SSS.pbl by boot and segment number. Every segment is
+ * appended to /logs/logindex.csv (file, boot, segment, start ms, start unix
+ * time) so off-board tools can pick the segments of a time range without
+ * opening them. Rotation closes and opens files in one pass, only when the
+ * loop has budget left.
+ *
+ * Timestamps: when UTC is known to the timebase (lib/timebase.h - PPS or
+ * RTC disciplined), a segment starts on a whole UTC second (startUnix,
+ * with startMs the millis() of that second) and each record's ms is counted
+ * on the disciplined timebase from there, not taken from millis(). The
+ * crystal's drift is corrected out, so logs of several devices stamped
+ * this way merge to the millisecond. Otherwise records carry millis() and
+ * startUnix the wall clock at startMs, as before.
+ *
+ * Rate: one record per SD_Log send pass, so OUTPUT SD_Log INTERVAL (and the
+ * ON_CHANGE / HEARTBEAT modes) set the logging rate - down to every sensor
+ * update.
+ *
+ * Event capture: every enabled input (not only those routed to SD_Log) is
+ * also recorded at its update rate (SD_LOG_EVENT_INTERVAL_MS at most) into a
+ * RAM ring holding the newest history. When an input enters ALARM_ACTIVE the
+ * last SD_LOG_EVENT_PRE_MS are kept, recording goes on for
+ * SD_LOG_EVENT_POST_MS (or until the ring is full), and the frozen window is
+ * written to its own event file (evt_<trigger ms>.pbl, same format, startMs
+ * = trigger time) a chunk per pass. Full-rate data around a fault without
+ * logging everything at full rate. Alarms while an event is being written
+ * start no new event. Binary format only.
+ *
+ * Compression (SD_LOG_COMPRESS): each record is staged as a log_compress.h
+ * block instead - each channel's change since the previous record, then
+ * LZ - and the header says version 2. Slowly changing channels shrink to a
+ * few bytes per record, for a few microseconds of Teensy 4 CPU. A record is only
+ * compressed once the staging buffers have room for the worst case, so an
+ * overrun drops it before the compressor sees it and the stream stays
+ * decodable. Segments start a new stream; event files stay uncompressed.
+ * Binary format only, not on AVR (about 3 KB of compressor state).
+ *
+ * Build Flags:
+ *   -D SD_LOG_CSV                - Previous text format: one CSV line per value
+ *                                  (Time,Sensor,Value,Units in display units)
+ *   -D SD_LOG_COMPRESS           - Delta + LZ compressed records (not with SD_LOG_CSV, not on AVR)
+ *   -D SD_LOG_BUFFER_SIZE=n      - Bytes per staging buffer, two are used (default 512)
+ *   -D SD_LOG_SYNC_MS=n          - Longest time staged data waits for the card (default 5000,
+ *                                  30000 with ENABLE_POWER_FAIL)
+ *   -D SD_LOG_SEGMENT_MB=n       - Segment size, preallocated on Teensy (default 64, 0 = no limit)
+ *   -D SD_LOG_SEGMENT_MINUTES=n  - Segment length (default 60, 0 = no limit)
+ *   -D SD_LOG_EVENT_RING_BYTES=n - Event ring (default 8192, 1 MB with SD_LOG_EVENT_EXTMEM,
+ *                                  0 on AVR = no event capture)
+ *   -D SD_LOG_EVENT_EXTMEM       - Ring in Teensy 4.1 PSRAM (skipped at runtime if none is fitted)
+ *   -D SD_LOG_EVENT_INTERVAL_MS=n - Shortest gap between event records (default 10)
+ *   -D SD_LOG_EVENT_PRE_MS=n     - History kept before the trigger (default 5000)
+ *   -D SD_LOG_EVENT_POST_MS=n    - Recording after the trigger (default 5000)
  */
 
 #include "output_base.h"
@@ -9,100 +103,722 @@
 #include "../lib/units_registry.h"
 #include "../lib/message_api.h"
 #include "../lib/log_tags.h"
+#include "../lib/loop_monitor.h"
+#include "../lib/bus_manager.h"
+#include "../lib/watchdog.h"
+#include "../lib/memory_report.h"
+#include "../lib/float_format.h"
 
 #ifdef ENABLE_SD_LOGGING
 
 // Use Arduino SD library for consistency across platforms
 #include <SD.h>
 #include "../lib/sd_manager.h"
+#include "../hal/hal_clock.h"
+#include "../hal/hal_placement.h"
+#include "../lib/timebase.h"
+#include "../inputs/input_manager.h"
+#ifndef SD_LOG_CSV
+#include "packed_signal.h"
+#include "packed_log.h"
+#endif
+#ifdef SD_LOG_COMPRESS
+#include "../lib/log_compress.h"
+#endif
+
+#ifndef SD_LOG_BUFFER_SIZE
+#define SD_LOG_BUFFER_SIZE 512
+#endif
+
+#ifndef SD_LOG_SYNC_MS
+#ifdef ENABLE_POWER_FAIL
+#define SD_LOG_SYNC_MS 30000    // A supply loss flushes the buffers (lib/power_fail.h)
+#else
+#define SD_LOG_SYNC_MS 5000
+#endif
+#endif
+
+#ifndef SD_LOG_SEGMENT_MB
+#define SD_LOG_SEGMENT_MB 64
+#endif
 
-// SD object is provided globally by SD.h
+#ifndef SD_LOG_SEGMENT_MINUTES
+#define SD_LOG_SEGMENT_MINUTES 60
+#endif
 
-File logFile;
-unsigned long lastLogTime = 0;
-const unsigned long LOG_INTERVAL = 1000;  // Log every 1 second
+#define SD_LOG_DIR    "/logs"
+#define SD_LOG_INDEX  SD_LOG_DIR "/logindex.csv"
+
+#if defined(ESP32)
+  #define SD_LOG_APPEND FILE_APPEND   // ESP32 FILE_WRITE truncates
+#else
+  #define SD_LOG_APPEND FILE_WRITE
+#endif
+
+#ifndef SD_LOG_EVENT_RING_BYTES
+  #if defined(__AVR__)
+    #define SD_LOG_EVENT_RING_BYTES 0
+  #elif defined(SD_LOG_EVENT_EXTMEM)
+    #define SD_LOG_EVENT_RING_BYTES 1048576
+  #else
+    #define SD_LOG_EVENT_RING_BYTES 8192
+  #endif
+#endif
+
+#ifndef SD_LOG_EVENT_INTERVAL_MS
+#define SD_LOG_EVENT_INTERVAL_MS 10
+#endif
+
+#ifndef SD_LOG_EVENT_PRE_MS
+#define SD_LOG_EVENT_PRE_MS 5000
+#endif
+
+#ifndef SD_LOG_EVENT_POST_MS
+#define SD_LOG_EVENT_POST_MS 5000
+#endif
+
+#if defined(SD_LOG_COMPRESS) && (defined(SD_LOG_CSV) || defined(__AVR__))
+  #error "SD_LOG_COMPRESS needs the binary format and more RAM than AVR has"
+#endif
+
+#if defined(SD_LOG_CSV) && SD_LOG_EVENT_RING_BYTES > 0
+  #undef SD_LOG_EVENT_RING_BYTES
+  #define SD_LOG_EVENT_RING_BYTES 0   // Needs fixed-size records
+#endif
+
+#if defined(__IMXRT1062__)  // Teensy 4.x - SD.h is built on SdFat
+  #define SD_LOG_SDFAT
+  typedef FsFile LogFile;
+#else
+  typedef File LogFile;
+#endif
+
+static LogFile logFile;
+static uint16_t bootNumber = 0;         // One more than the last boot in the index
+static uint16_t segmentNumber = 0;
+static uint32_t segmentStartMs = 0;
+static uint32_t segmentStartUnix = 0;   // 0 = wall clock unknown
+static uint64_t segmentStartUtcUs = 0;  // startUnix in UTC microseconds, 0 = records on millis()
+
+// ===== STAGING BUFFERS =====
+
+HAL_DMA_BUFFER static uint8_t stageBuffer[2][SD_LOG_BUFFER_SIZE];  // Teensy 4: OCRAM, off DTCM
+static uint8_t stageActive = 0;         // Buffer being filled
+static uint16_t stageUsed = 0;          // Bytes in the active buffer
+static uint16_t stageLimit = SD_LOG_BUFFER_SIZE;  // Fill that ends the active buffer on a sector boundary
+static bool stageFull = false;          // The other buffer is waiting for the card
+static uint16_t stageFullLength = 0;
+static uint32_t fileBytes = 0;          // Bytes handed to the card
+static uint32_t lastSync = 0;
+static uint32_t overruns = 0;           // Records dropped with both buffers full
+static bool writeFailed = false;        // A write since the last sync came up short
+static uint8_t sdWatchId = TASK_WATCH_NONE;  // Heartbeat per good sync (lib/watchdog.h)
+static bool reopenable = false;         // closeSDLog() closed an open log
+
+// False if len bytes would need the buffer still waiting for the card
+static bool stageHasRoom(uint16_t len) {
+    return !(stageUsed + len > stageLimit && stageFull);
+}
+
+static void noteOverrun() {
+    if (overruns++ == 0) {
+        msg.debug.warn(TAG_SD, "SD log overrun - card slower than the logging rate");
+    }
+}
+
+/**
+ * Add one record to the staging buffers
+ * A record is kept whole - dropped if it does not fit, never partly staged.
+ */
+static void stageRecord(const uint8_t* data, uint16_t len) {
+    if (!stageHasRoom(len)) {
+        noteOverrun();
+        return;
+    }
+
+    while (len > 0) {
+        uint16_t chunk = stageLimit - stageUsed;
+        if (chunk > len) chunk = len;
+        memcpy(&stageBuffer[stageActive][stageUsed], data, chunk);
+        stageUsed += chunk;
+        data += chunk;
+        len -= chunk;
+
+        if (stageUsed == stageLimit) {
+            // Hand this buffer to the card, keep filling the other
+            stageFull = true;
+            stageFullLength = stageUsed;
+            stageActive ^= 1;
+            stageUsed = 0;
+            stageLimit = SD_LOG_BUFFER_SIZE;
+        }
+    }
+}
+
+// True if a write now would wait on the card or overrun the loop budget
+static bool cardWriteBlocked(LogFile& file) {
+    if (loopBudgetExceeded()) {
+        loopMonitorNoteDeferral();
+        return true;
+    }
+    if (spiShouldYield(SPI_CLIENT_SD)) return true;  // CAN / batch due on the same bus
+#ifdef SD_LOG_SDFAT
+    if (file && file.isBusy()) return true;   // Still programming the previous sector
+#endif
+    return false;
+}
+
+static void writeStaged(const uint8_t* data, uint16_t len) {
+    spiClaim(SPI_CLIENT_SD);
+    if (logFile.write(data, len) != len) writeFailed = true;
+    spiRelease(SPI_CLIENT_SD);
+    fileBytes += len;
+}
+
+/**
+ * Write a full buffer, and every SD_LOG_SYNC_MS the partly filled one
+ */
+static void drainStaging() {
+    if (stageFull) {
+        if (cardWriteBlocked(logFile)) return;
+        writeStaged(stageBuffer[stageActive ^ 1], stageFullLength);
+        stageFull = false;
+        return;  // One sector per pass
+    }
+
+    if (millis() - lastSync < SD_LOG_SYNC_MS) return;
+    if (cardWriteBlocked(logFile)) return;
+
+    if (stageUsed > 0) {
+        writeStaged(stageBuffer[stageActive], stageUsed);
+        stageUsed = 0;
+        // Next buffer ends where the file reaches a sector boundary again
+        stageLimit = SD_LOG_BUFFER_SIZE - (fileBytes % SD_LOG_BUFFER_SIZE);
+    }
+    spiClaim(SPI_CLIENT_SD);
+    logFile.flush();
+    spiRelease(SPI_CLIENT_SD);
+    lastSync = millis();
+
+    // Everything since the last sync reached the card - the log is alive
+    if (!writeFailed) watchdogHeartbeat(sdWatchId);
+    writeFailed = false;
+}
+
+#ifndef SD_LOG_CSV
+
+static uint16_t channelOffset[MAX_INPUTS];  // Input slot -> offset in the record + 1 (0 = not logged)
+static uint8_t record[4 + MAX_INPUTS * 2];  // Timestamp + values of the tick being assembled
+static uint16_t recordSize = 0;
+
+#ifdef SD_LOG_COMPRESS
+static_assert(sizeof(record) <= LOG_COMPRESS_MAX_RECORD, "SD log record too large to compress");
+static LogCompressor compressor;
+static uint8_t compressed[LOG_COMPRESS_BOUND(sizeof(record))];
+#endif
+
+#if SD_LOG_EVENT_RING_BYTES > 0
+
+// ===== EVENT CAPTURE =====
+
+enum EventPhase : uint8_t {
+    EVENT_RECORDING,        // Ring keeps the newest history
+    EVENT_TRIGGERED,        // Alarm fired - recording the post-trigger window
+    EVENT_OPEN,             // Window frozen - event file to be created
+    EVENT_WRITING           // Ring going to the event file
+};
+
+#ifdef SD_LOG_EVENT_EXTMEM
+HAL_EXT_RAM static uint8_t eventRing[SD_LOG_EVENT_RING_BYTES];
+#else
+HAL_DMA_BUFFER static uint8_t eventRing[SD_LOG_EVENT_RING_BYTES];
+#endif
+
+static uint16_t eventOffset[MAX_INPUTS];    // Every enabled input, like channelOffset
+static uint16_t eventRecordSize = 0;
+static uint8_t eventChannels = 0;
+static uint32_t eventCapacity = 0;          // Whole records that fit the ring (0 = capture off)
+static uint32_t eventHead = 0;              // Oldest record
+static uint32_t eventCount = 0;
+static uint32_t eventWritten = 0;           // Records already in the event file
+static uint8_t eventSeq[MAX_INPUTS];        // Input::sequence at the previous event record
+static bool eventInAlarm[MAX_INPUTS];       // ALARM_ACTIVE at the previous check
+static uint32_t lastEventRecordMs = 0;
+static uint32_t eventTriggerMs = 0;
+static EventPhase eventPhase = EVENT_RECORDING;
+static LogFile eventFile;
+
+static uint8_t* eventSlot(uint32_t index) {
+    return &eventRing[((eventHead + index) % eventCapacity) * eventRecordSize];
+}
+
+static void resetEventRing() {
+    eventHead = 0;
+    eventCount = 0;
+    eventPhase = EVENT_RECORDING;
+}
+
+static void initEventCapture() {
+    eventRecordSize = buildPackedLayout(eventOffset, PACKED_LOG_ALL_INPUTS, &eventChannels);
+    eventCapacity = SD_LOG_EVENT_RING_BYTES / eventRecordSize;
+#ifdef SD_LOG_EVENT_EXTMEM
+    if (hal::extRamBytes() == 0) {
+        eventCapacity = 0;
+        msg.debug.warn(TAG_SD, "No PSRAM fitted - event capture off");
+    }
+#endif
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        eventSeq[i] = inputs[i].sequence - 1;
+        eventInAlarm[i] = false;
+    }
+    resetEventRing();
+}
+
+/**
+ * Record every channel when an input has a new value
+ * Idle, the oldest history is overwritten; after a trigger a full ring ends
+ * the post-trigger window early.
+ */
+static void captureEventRecord(uint32_t now) {
+    if (eventPhase > EVENT_TRIGGERED || now - lastEventRecordMs < SD_LOG_EVENT_INTERVAL_MS) return;
+
+    bool changed = false;
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        if (eventOffset[i] && inputs[i].sequence != eventSeq[i]) {
+            eventSeq[i] = inputs[i].sequence;
+            changed = true;
+        }
+    }
+    if (!changed) return;
+    lastEventRecordMs = now;
+
+    if (eventCount == eventCapacity) {
+        if (eventPhase == EVENT_TRIGGERED) {
+            eventPhase = EVENT_OPEN;
+            return;
+        }
+        eventHead = (eventHead + 1) % eventCapacity;
+        eventCount--;
+    }
+
+    uint8_t* slot = eventSlot(eventCount++);
+    memcpy(slot, &now, 4);
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        if (eventOffset[i]) writePackedSignal(&slot[eventOffset[i] - 1], &inputs[i]);
+    }
+}
+
+// Trigger on an input entering ALARM_ACTIVE; freeze once the post window has passed
+static void checkEventTrigger(uint32_t now) {
+    int8_t trigger = -1;
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        bool active = inputs[i].flags.isEnabled && inputs[i].alarmContext.state == ALARM_ACTIVE;
+        if (active && !eventInAlarm[i] && trigger < 0) trigger = i;
+        eventInAlarm[i] = active;
+    }
+
+    if (eventPhase == EVENT_RECORDING && trigger >= 0) {
+        // Keep SD_LOG_EVENT_PRE_MS of history - the rest of the ring holds the post window
+        while (eventCount > 0) {
+            uint32_t ms;
+            memcpy(&ms, eventSlot(0), 4);
+            if (now - ms <= SD_LOG_EVENT_PRE_MS) break;
+            eventHead = (eventHead + 1) % eventCapacity;
+            eventCount--;
+        }
+        eventTriggerMs = now;
+        eventPhase = EVENT_TRIGGERED;
+        msg.debug.info(TAG_SD, "%s alarm - capturing event", inputs[trigger].abbrName);
+    } else if (eventPhase == EVENT_TRIGGERED && now - eventTriggerMs >= SD_LOG_EVENT_POST_MS) {
+        eventPhase = EVENT_OPEN;
+    }
+}
+
+static void eventHeaderSink(const uint8_t* data, uint16_t len) {
+    eventFile.write(data, len);
+}
+
+// Write the frozen window, one step per pass
+static void writeEventFile() {
+    if (eventPhase == EVENT_OPEN) {
+        if (cardWriteBlocked(logFile)) return;
+
+        char filename[40];
+        uint32_t eventUnix = hal::wallClock();
+        if (eventUnix) {
+            eventUnix -= (millis() - eventTriggerMs) / 1000;
+            char stamp[16];
+            hal::formatWallClock(eventUnix, stamp);
+            snprintf(filename, sizeof(filename), SD_LOG_DIR "/evt_%s.pbl", stamp);
+        } else {
+            snprintf(filename, sizeof(filename), SD_LOG_DIR "/evt_%05u_%lu.pbl", bootNumber,
+                     (unsigned long)eventTriggerMs);
+        }
+#ifdef SD_LOG_SDFAT
+        eventFile = SD.sdfs.open(filename, O_WRONLY | O_CREAT | O_TRUNC);
+        if (eventFile) {
+            eventFile.preAllocate(sizeof(PackedLogHeader) + (uint32_t)eventChannels * sizeof(PackedLogChannel) +
+                                  eventCount * eventRecordSize);
+        }
+#else
+        eventFile = SD.open(filename, FILE_WRITE);
+#endif
+        if (!eventFile) {
+            msg.debug.error(TAG_SD, "Failed to create event file");
+            resetEventRing();
+            return;
+        }
+        writePackedLogHeader(eventHeaderSink, eventOffset, eventChannels, eventRecordSize, eventTriggerMs,
+                             eventUnix, PACKED_LOG_VERSION);
+        eventWritten = 0;
+        eventPhase = EVENT_WRITING;
+        return;
+    }
+
+    if (eventPhase != EVENT_WRITING || cardWriteBlocked(eventFile)) return;
+
+    // Up to a sector of consecutive ring records per pass
+    uint32_t start = (eventHead + eventWritten) % eventCapacity;
+    uint32_t n = eventCount - eventWritten;
+    if (n > eventCapacity - start) n = eventCapacity - start;
+    uint32_t perPass = SD_LOG_BUFFER_SIZE / eventRecordSize;
+    if (perPass == 0) perPass = 1;
+    if (n > perPass) n = perPass;
+    spiClaim(SPI_CLIENT_SD);
+    eventFile.write(&eventRing[start * eventRecordSize], n * eventRecordSize);
+    spiRelease(SPI_CLIENT_SD);
+    eventWritten += n;
+
+    if (eventWritten == eventCount) {
+        eventFile.close();
+        msg.debug.info(TAG_SD, "Event written: %lu records", (unsigned long)eventCount);
+        resetEventRing();
+    }
+}
+
+#endif // SD_LOG_EVENT_RING_BYTES
+
+static void stageHeaderSink(const uint8_t* data, uint16_t len) {
+    stageRecord(data, len);
+}
+
+/**
+ * Stage the header and build the record layout from the inputs routed to SD
+ */
+static void writeLogHeader() {
+    uint8_t channels;
+    recordSize = buildPackedLayout(channelOffset, OUTPUT_SD, &channels);
+#ifdef SD_LOG_COMPRESS
+    writePackedLogHeader(stageHeaderSink, channelOffset, channels, recordSize, segmentStartMs, segmentStartUnix,
+                         PACKED_LOG_VERSION_COMPRESSED);
+    uint8_t widths[MAX_INPUTS];
+    logCompressReset(&compressor, widths, getPackedLayoutWidths(channelOffset, widths));  // Each segment decodes on its own
+#else
+    writePackedLogHeader(stageHeaderSink, channelOffset, channels, recordSize, segmentStartMs, segmentStartUnix,
+                         PACKED_LOG_VERSION);
+#endif
+
+    // No data until an input is sent this tick
+    memset(record, 0xFF, sizeof(record));
+}
+
+#endif // SD_LOG_CSV
+
+// ===== SEGMENTS =====
+
+/**
+ * Boot number of the last segment in the index (0 if none)
+ * Reads only the tail of the file.
+ */
+static uint16_t readLastBoot() {
+    File index = SD.open(SD_LOG_INDEX, FILE_READ);
+    if (!index) return 0;
+
+    char tail[65];
+    uint32_t size = index.size();
+    uint32_t start = size > sizeof(tail) - 1 ? size - (sizeof(tail) - 1) : 0;
+    index.seek(start);
+    int n = index.read(tail, size - start);
+    index.close();
+    if (n <= 0) return 0;
+    tail[n] = '\0';
+
+    // Last complete line: file,boot,segment,start_ms,start_unix
+    char* end = tail + n;
+    while (end > tail && (end[-1] == '\n' || end[-1] == '\r')) *--end = '\0';
+    char* line = end;
+    while (line > tail && line[-1] != '\n') line--;
+    char* comma = strchr(line, ',');
+    return comma ? (uint16_t)atoi(comma + 1) : 0;
+}
+
+static void appendIndex(const char* filename) {
+    bool created = !SD.exists(SD_LOG_INDEX);
+    File index = SD.open(SD_LOG_INDEX, SD_LOG_APPEND);
+    if (!index) {
+        msg.debug.warn(TAG_SD, "Could not update " SD_LOG_INDEX);
+        return;
+    }
+    if (created) {
+        index.println("file,boot,segment,start_ms,start_unix");
+    }
+    const char* name = strrchr(filename, '/');
+    index.print(name ? name + 1 : filename);
+    index.print(',');
+    index.print(bootNumber);
+    index.print(',');
+    index.print(segmentNumber);
+    index.print(',');
+    index.print(segmentStartMs);
+    index.print(',');
+    index.println(segmentStartUnix);
+    index.close();
+}
+
+// Create the next segment and stage its header
+static void openSegment() {
+    uint64_t utc = timebaseUtcMicros(hal::micros64());
+    if (utc != 0) {
+        // Start on the UTC second - records count from it on the timebase
+        uint32_t intoSecondMs = (uint32_t)(utc % 1000000ULL / 1000ULL);
+        segmentStartUtcUs = utc - utc % 1000000ULL;
+        segmentStartUnix = (uint32_t)(segmentStartUtcUs / 1000000ULL);
+        segmentStartMs = millis() - intoSecondMs;
+    } else {
+        segmentStartUtcUs = 0;
+        segmentStartMs = millis();
+        segmentStartUnix = hal::wallClock();
+    }
+
+    char filename[40];
+#ifdef SD_LOG_CSV
+    const char* ext = "csv";
+#else
+    const char* ext = "pbl";
+#endif
+    if (segmentStartUnix) {
+        char stamp[16];
+        hal::formatWallClock(segmentStartUnix, stamp);
+        snprintf(filename, sizeof(filename), SD_LOG_DIR "/%s.%s", stamp, ext);
+    } else {
+        snprintf(filename, sizeof(filename), SD_LOG_DIR "/%05u_%03u.%s", bootNumber, segmentNumber, ext);
+    }
+
+#ifdef SD_LOG_SDFAT
+    logFile = SD.sdfs.open(filename, O_WRONLY | O_CREAT | O_TRUNC);
+#else
+    if (SD.exists(filename)) {
+        SD.remove(filename);  // FILE_WRITE appends - replace instead
+    }
+    logFile = SD.open(filename, FILE_WRITE);
+#endif
+
+    if (!logFile) {
+        msg.debug.error(TAG_SD, "Failed to create log file");
+        return;
+    }
+
+#ifdef SD_LOG_SDFAT
+    // Contiguous clusters up front - logging never touches the FAT
+    if (SD_LOG_SEGMENT_MB > 0 && !logFile.preAllocate((uint64_t)SD_LOG_SEGMENT_MB << 20)) {
+        msg.debug.warn(TAG_SD, "Could not preallocate %d MB for the log", SD_LOG_SEGMENT_MB);
+    }
+#endif
+    stageActive = 0;
+    stageUsed = 0;
+    stageLimit = SD_LOG_BUFFER_SIZE;
+    stageFull = false;
+    fileBytes = 0;
+    lastSync = millis();
+
+#ifdef SD_LOG_CSV
+    // Write CSV header
+    static const char csvHeader[] = "Time,Sensor,Value,Units\r\n";
+    stageRecord((const uint8_t*)csvHeader, sizeof(csvHeader) - 1);
+#else
+    writeLogHeader();
+#endif
+    appendIndex(filename);
+    msg.debug.info(TAG_SD, "Logging to: %s", filename);
+}
+
+// Write out everything staged and close the segment
+static void closeSegment() {
+    // Whatever is staged goes out now, budget or not
+    if (stageFull) {
+        writeStaged(stageBuffer[stageActive ^ 1], stageFullLength);
+        stageFull = false;
+    }
+    if (stageUsed > 0) {
+        writeStaged(stageBuffer[stageActive], stageUsed);
+        stageUsed = 0;
+    }
+#ifdef SD_LOG_SDFAT
+    logFile.truncate(fileBytes);  // Release the unused preallocation
+#endif
+    logFile.close();
+}
+
+// Segment has reached its size or length limit
+static bool segmentDue() {
+    if (SD_LOG_SEGMENT_MB > 0 &&
+        fileBytes + 2 * SD_LOG_BUFFER_SIZE >= ((uint32_t)SD_LOG_SEGMENT_MB << 20)) {
+        return true;  // Staged data still fits the preallocation
+    }
+    return SD_LOG_SEGMENT_MINUTES > 0 &&
+           millis() - segmentStartMs >= (uint32_t)SD_LOG_SEGMENT_MINUTES * 60000UL;
+}
 
 void initSDLog() {
     // SD card is already initialized by initSD() in main setup()
     // Just check if it's available and create log file
 
+#ifdef SD_LOG_EVENT_EXTMEM
+    noteStaticMemory(F("SD log buffers"), sizeof(stageBuffer));             // Event ring in PSRAM
+#else
+    noteStaticMemory(F("SD log buffers"), sizeof(stageBuffer) + sizeof(eventRing));
+#endif
+    notePlacement(F("SD stage buffers"), stageBuffer);
+#if SD_LOG_EVENT_RING_BYTES > 0
+    notePlacement(F("SD event ring"), eventRing);
+#endif
+
     if (!isSDInitialized()) {
         msg.debug.warn(TAG_SD, "SD logging failed - SD card not initialized");
         return;
     }
 
     msg.debug.info(TAG_SD, "SD card ready for logging");
+#ifdef ENABLE_TASK_WATCHDOG
+    sdWatchId = watchdogRegisterTask("SD_LOG", TASK_WATCHDOG_SD_MS);
+#endif
 
-    // Create or open log file with timestamp
-    char filename[20];
-    snprintf(filename, sizeof(filename), "log_%lu.csv", millis());
+    if (!SD.exists(SD_LOG_DIR)) {
+        SD.mkdir(SD_LOG_DIR);
+    }
+    bootNumber = readLastBoot() + 1;
+    segmentNumber = 0;
 
-    logFile = SD.open(filename, FILE_WRITE);
+#if SD_LOG_EVENT_RING_BYTES > 0
+    initEventCapture();
+#endif
 
-    if (logFile) {
-        // Write CSV header
-        logFile.println("Time,Sensor,Value,Units");
-        logFile.flush();
-        msg.debug.info(TAG_SD, "Logging to: %s", filename);
-    } else {
-        msg.debug.error(TAG_SD, "Failed to create log file");
-    }
+    openSegment();
+}
+
+// Record time: startMs + disciplined ms since the segment's UTC start, else millis()
+static uint32_t recordStamp(uint32_t now) {
+    if (segmentStartUtcUs == 0) return now;
+    uint64_t utc = timebaseUtcMicros(hal::micros64());
+    if (utc < segmentStartUtcUs) return segmentStartMs;  // Stepped back past the start
+    return segmentStartMs + (uint32_t)((utc - segmentStartUtcUs) / 1000ULL);
 }
 
-void sendSDLog(Input *ptr) {
+void sendSDLogBatch(const uint8_t* slots, uint8_t count, const InputSample* samples, uint32_t now) {
     if (!logFile) {
         return;  // File not open
     }
-    
-    // Throttle logging to avoid SD wear
-    if (millis() - lastLogTime < LOG_INTERVAL) {
-        return;
+    now = recordStamp(now);
+
+#ifdef SD_LOG_CSV
+    for (uint8_t k = 0; k < count; k++) {
+        const Input* ptr = &inputs[slots[k]];
+
+        // CSV line: timestamp, sensor name, value, units (display units)
+        char value[FLOAT_FORMAT_SIZE];
+        char line[64];
+        formatFixed(value, toInputUnits(ptr, samples[slots[k]].value), 2);
+        int len = snprintf(line, sizeof(line), "%lu,%s,%s,%s\r\n", (unsigned long)now, ptr->abbrName, value,
+                           ptr->unitsSymbol);
+        if (len > 0) {
+            stageRecord((const uint8_t*)line, len < (int)sizeof(line) ? len : sizeof(line) - 1);
+        }
     }
-    
-    if (isnan(ptr->value)) {
-        return;  // Don't log invalid data
+#else
+    // One record per tick
+    memcpy(record, &now, 4);
+    for (uint8_t k = 0; k < count; k++) {
+        uint16_t offset = channelOffset[slots[k]];
+        if (offset) {  // 0 = routed after the file was opened - not in this log's channels
+            writePackedSignal(&record[offset - 1], inputs[slots[k]].measurementType, samples[slots[k]].value);
+        }
     }
 
-    // Convert to display units for logging
-    float displayValue = convertFromBaseUnits(ptr->value, ptr->unitsIndex);
-
-    // Write CSV line: timestamp, sensor name, value, units
-    logFile.print(millis());
-    logFile.print(",");
-    logFile.print(ptr->abbrName);
-    logFile.print(",");
-    logFile.print(displayValue, 2);
-    logFile.print(",");
-    logFile.print(getUnitStringByIndex(ptr->unitsIndex));
-    logFile.println();
+#ifdef SD_LOG_COMPRESS
+    if (stageHasRoom(LOG_COMPRESS_BOUND(recordSize))) {
+        stageRecord(compressed, logCompressRecord(&compressor, record, compressed));
+    } else {
+        noteOverrun();  // Dropped before the compressor sees it
+    }
+#else
+    stageRecord(record, recordSize);
+#endif
+    memset(&record[4], 0xFF, recordSize - 4);  // Inputs not sent next tick log as no data
+#endif
 }
 
 void updateSDLog() {
-    static unsigned long lastFlush = 0;
-    
-    // Flush to SD card every 5 seconds to ensure data is written
-    if (millis() - lastFlush > 5000) {
-        if (logFile) {
-            logFile.flush();
-        }
-        lastFlush = millis();
-        lastLogTime = millis();
+#if SD_LOG_EVENT_RING_BYTES > 0
+    if (eventCapacity > 0) {
+        uint32_t now = millis();
+        captureEventRecord(now);
+        checkEventTrigger(now);
+        writeEventFile();
+    }
+#endif
+
+    if (!logFile) {
+        return;
+    }
+
+    drainStaging();
+
+    // Rotate - closing and creating files is the one long step, so only with budget left
+    if (segmentDue() && !loopBudgetExceeded()) {
+        closeSegment();
+        segmentNumber++;
+        openSegment();
     }
 }
 
+uint32_t getSDLogOverruns() {
+    return overruns;
+}
+
 void closeSDLog() {
+    watchdogTaskIdle(sdWatchId);  // Stopped on purpose
     if (logFile) {
-        logFile.close();
+        closeSegment();
+        reopenable = true;
         msg.debug.info(TAG_SD, "Log file closed");
     }
+#if SD_LOG_EVENT_RING_BYTES > 0
+    if (eventPhase == EVENT_WRITING) {
+        // Keep the records written so far
+#ifdef SD_LOG_SDFAT
+        eventFile.truncate(eventFile.curPosition());
+#endif
+        eventFile.close();
+        resetEventRing();
+    }
+#endif
+}
+
+void reopenSDLog() {
+    if (!reopenable || logFile) return;
+    reopenable = false;
+    segmentNumber++;
+    openSegment();
 }
 
 #else
 
 // Dummy functions if SD logging is disabled
 void initSDLog() {}
-void sendSDLog(Input *ptr) {}
+void sendSDLogBatch(const uint8_t* slots, uint8_t count, const InputSample* samples, uint32_t now) {}
 void updateSDLog() {}
+uint32_t getSDLogOverruns() { return 0; }
 void closeSDLog() {}
+void reopenSDLog() {}
 
 #endif
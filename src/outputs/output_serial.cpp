@@ -1,24 +1,255 @@
 /*
- * output_serial.cpp - Serial CSV output for data plane
+ * output_serial.cpp - Serial data plane output (CSV rows or binary frames)
+ *
+ * OUTPUT Serial FORMAT picks the encoding:
+ *
+ *   CSV         one "abbr,value,units" line per input, in display units
+ *   WIDE        one "t_ms,value,value,..." row per send tick, in display units
+ *   BINARY      one frame per send tick: timestamp + packed values
+ *   COMPRESSED  as BINARY, each record delta + LZ compressed (not on AVR)
+ *
+ * The binary formats carry the binary log format of the SD logger
+ * (packed_log.h): a description frame holding the header and channel
+ * table, then one record frame per tick. Values are packed signals in
+ * standard units (packed_signal.h), so nothing is formatted as text. Every
+ * frame is
+ *
+ *   0xA5 0x5A  type  sequence (uint16)  length (uint16)  payload  CRC16
+ *
+ *   'D'  description - header (version 1 raw, 2 compressed) + channels
+ *   'R'  one record (compressed: a log_compress.h block)
+ *
+ * little-endian, the CRC-16/CCITT-FALSE over type to payload (serial_frame.h).
+ * The sequence number counts every frame, so a receiver sees drops. The
+ * description is sent before the first record, when the data transport
+ * connects, when the inputs routed to Serial change (added, removed,
+ * renamed, retyped) and every SERIAL_DESCRIBE_MS so a host that starts
+ * reading late syncs up; a compressed stream restarts its compressor
+ * there. Text on the data plane between frames is skipped by the decoder
+ * (tools/serial_decode.py).
+ *
+ * WIDE has a column per input routed to Serial, in slot order, and prints
+ * its header row ("t_ms,CHT (C),EGT (C),...") in the same places as the
+ * description except the periodic resend - it also follows a units change.
+ * An input not sent in a tick leaves its field empty. The row is formatted
+ * straight into the output frame (float_format.h), two decimals.
+ *
+ * Build Flags:
+ *   -D SERIAL_DESCRIBE_MS=n  - Description resend interval (default 5000, 0 = only on change)
  */
 
 #include "output_base.h"
+#include "output_frame.h"
+#include "output_serial.h"
 #include "../config.h"
 #include "../lib/sensor_library.h"
 #include "../lib/units_registry.h"
 #include "../lib/message_api.h"
+#include "../lib/float_format.h"
 
 #ifdef ENABLE_SERIAL_OUTPUT
 
+#include "packed_signal.h"
+#include "packed_log.h"
+#include "serial_frame.h"
+#include "../inputs/input_manager.h"
+#include "../lib/message_router.h"
+#include "../hal/hal_clock.h"
+
 #ifndef USE_STATIC_CONFIG
     #include "../lib/system_mode.h"
 #endif
 
+#if !defined(__AVR__)
+  #define SERIAL_HAS_COMPRESSION 1    // About 3 KB of compressor state
+  #include "../lib/log_compress.h"
+#endif
+
+#ifndef SERIAL_DESCRIBE_MS
+#define SERIAL_DESCRIBE_MS 5000
+#endif
+
+#define SERIAL_FRAME_DESCRIPTION  'D'
+#define SERIAL_FRAME_RECORD       'R'
+
+#define SERIAL_WIDE_DECIMALS      2
+#define SERIAL_WIDE_FIELD_MAX     (1 + FLOAT_FORMAT_SIZE)   // ',' + the value
+
+static SerialFormat format = SERIAL_FORMAT_CSV;
+
+static uint16_t channelOffset[MAX_INPUTS];  // Input slot -> offset in the record + 1 (0 = not sent)
+static uint8_t record[4 + MAX_INPUTS * 2];  // Timestamp + values of the tick being assembled
+static uint16_t recordSize = 0;
+static uint32_t layoutSignature = 0;
+static bool describeDue = true;
+static uint32_t lastDescribe = 0;
+static bool dataConnected = false;
+static uint16_t frameCrc = 0;
+static float rowValue[MAX_INPUTS];          // WIDE: display value of each slot this tick (NaN = not sent)
+
+#ifdef SERIAL_HAS_COMPRESSION
+static_assert(sizeof(record) <= LOG_COMPRESS_MAX_RECORD, "Serial record too large to compress");
+static LogCompressor compressor;
+static uint8_t compressed[LOG_COMPRESS_BOUND(sizeof(record))];
+#endif
+
+static void framePayload(const uint8_t* data, uint16_t len) {
+    outputFrame.append(data, len);
+    frameCrc = serialFrameCrc(frameCrc, data, len);
+}
+
+static void beginFrame(uint8_t type, uint16_t len) {
+    uint16_t sequence = nextSerialFrameSequence();
+    uint8_t head[SERIAL_FRAME_HEADER] = { SERIAL_FRAME_SYNC1, SERIAL_FRAME_SYNC2, type,
+                                          (uint8_t)(sequence & 0xFF), (uint8_t)(sequence >> 8),
+                                          (uint8_t)(len & 0xFF), (uint8_t)(len >> 8) };
+    outputFrame.append(head, 2);
+    frameCrc = 0xFFFF;
+    framePayload(head + 2, sizeof(head) - 2);  // CRC covers type, sequence and length
+}
+
+static void endFrame() {
+    uint8_t crc[2] = { (uint8_t)(frameCrc & 0xFF), (uint8_t)(frameCrc >> 8) };
+    outputFrame.append(crc, sizeof(crc));
+}
+
+// What the receiver was told about - WIDE values are in display units, so its units too
+static uint32_t getLayoutSignature() {
+    uint32_t hash = getPackedLayoutSignature(OUTPUT_SERIAL);
+    if (format == SERIAL_FORMAT_WIDE) {
+        for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+            if (channelOffset[i]) hash = (hash ^ inputs[i].unitsIndex) * 16777619UL;
+        }
+    }
+    return hash;
+}
+
+// WIDE header row: a column per input in the layout
+static void sendHeaderRow() {
+    outputFrame.print(F("t_ms"));
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        if (!channelOffset[i]) continue;
+        outputFrame.print(',');
+        outputFrame.print(inputs[i].abbrName);
+        const __FlashStringHelper* units = (const __FlashStringHelper*)getUnitStringByIndex(inputs[i].unitsIndex);
+        if (pgm_read_byte((const char*)units)) {
+            outputFrame.print(F(" ("));
+            outputFrame.print(units);
+            outputFrame.print(')');
+        }
+    }
+    outputFrame.println();
+}
+
+// Rebuild the layout from the inputs routed to Serial and describe it
+static void sendDescription() {
+    uint8_t channels;
+    recordSize = buildPackedLayout(channelOffset, OUTPUT_SERIAL, &channels);
+    layoutSignature = getLayoutSignature();
+    describeDue = false;
+    lastDescribe = millis();
+
+    if (format == SERIAL_FORMAT_WIDE) {
+        sendHeaderRow();
+        return;
+    }
+    memset(record, 0xFF, sizeof(record));
+
+    uint8_t version = PACKED_LOG_VERSION;
+#ifdef SERIAL_HAS_COMPRESSION
+    if (format == SERIAL_FORMAT_COMPRESSED) {
+        uint8_t widths[MAX_INPUTS];
+        logCompressReset(&compressor, widths, getPackedLayoutWidths(channelOffset, widths));
+        version = PACKED_LOG_VERSION_COMPRESSED;
+    }
+#endif
+
+    beginFrame(SERIAL_FRAME_DESCRIPTION, sizeof(PackedLogHeader) + channels * sizeof(PackedLogChannel));
+    writePackedLogHeader(framePayload, channelOffset, channels, recordSize, lastDescribe, hal::wallClock(), version);
+    endFrame();
+}
+
+// Start a tick's record - describe first if anything changed
+static void startRecord(uint32_t now) {
+    bool periodic = format != SERIAL_FORMAT_WIDE && SERIAL_DESCRIBE_MS > 0;
+    if (describeDue ||
+        (periodic && millis() - lastDescribe >= SERIAL_DESCRIBE_MS) ||
+        getLayoutSignature() != layoutSignature) {
+        sendDescription();  // Between records, so no record mixes two layouts
+    }
+    memcpy(record, &now, 4);
+    if (format == SERIAL_FORMAT_WIDE) {
+        for (uint8_t i = 0; i < MAX_INPUTS; i++) rowValue[i] = NAN;
+    }
+}
+
+static void sendRow() {
+    uint32_t ms;
+    memcpy(&ms, record, 4);
+    char* p = (char*)outputFrame.reserve(11);
+    outputFrame.advance(formatUnsigned(p, ms));
+
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        if (!channelOffset[i]) continue;
+        p = (char*)outputFrame.reserve(SERIAL_WIDE_FIELD_MAX);
+        p[0] = ',';
+        uint8_t n = 1;
+        if (!isnan(rowValue[i])) {
+            n += formatFixed(p + 1, rowValue[i], SERIAL_WIDE_DECIMALS);
+        }
+        outputFrame.advance(n);
+    }
+    outputFrame.println();
+}
+
+static void sendRecord() {
+#ifdef SERIAL_HAS_COMPRESSION
+    if (format == SERIAL_FORMAT_COMPRESSED) {
+        uint16_t len = logCompressRecord(&compressor, record, compressed);
+        beginFrame(SERIAL_FRAME_RECORD, len);
+        framePayload(compressed, len);
+        endFrame();
+        return;
+    }
+#endif
+    beginFrame(SERIAL_FRAME_RECORD, recordSize);
+    framePayload(record, recordSize);
+    endFrame();
+}
+
+bool setSerialFormat(SerialFormat newFormat) {
+    if (newFormat > SERIAL_FORMAT_WIDE) return false;
+#ifndef SERIAL_HAS_COMPRESSION
+    if (newFormat == SERIAL_FORMAT_COMPRESSED) return false;
+#endif
+    format = newFormat;
+    systemConfig.serialFormat = newFormat;
+    describeDue = true;
+    return true;
+}
+
+SerialFormat getSerialFormat() {
+    return format;
+}
+
 void initSerialOutput() {
     msg.data.println("✓ Serial output initialized");
+    if (!setSerialFormat((SerialFormat)systemConfig.serialFormat)) {
+        setSerialFormat(SERIAL_FORMAT_CSV);
+    }
+}
+
+// CSV: "abbr,value,units" in display units
+void appendSerialCSVLine(const Input* ptr, float value) {
+    outputFrame.print(ptr->abbrName);
+    outputFrame.print(',');
+    outputFrame.print(toInputUnits(ptr, value), 2);
+    outputFrame.print(',');
+    outputFrame.print((const __FlashStringHelper*)ptr->unitsSymbol);
+    outputFrame.println();
 }
 
-void sendSerialOutput(Input *ptr) {
+void sendSerialBatch(const uint8_t* slots, uint8_t count, const InputSample* samples, uint32_t now) {
     #ifndef USE_STATIC_CONFIG
         // In CONFIG mode, suppress serial output
         if (isInConfigMode()) {
@@ -26,30 +257,64 @@ void sendSerialOutput(Input *ptr) {
         }
     #endif
 
-    msg.data.print(ptr->abbrName);
-    msg.data.print(",");
+    // Assembled into the output frame - the whole batch goes out in one write
+    if (format == SERIAL_FORMAT_CSV) {
+        for (uint8_t k = 0; k < count; k++) {
+            appendSerialCSVLine(&inputs[slots[k]], samples[slots[k]].value);
+        }
+        return;
+    }
 
-    if (isnan(ptr->value)) {
-        msg.data.print("ERROR");
-    } else {
-        // Display in human-readable format
-        float displayValue = convertFromBaseUnits(ptr->value, ptr->unitsIndex);
-        msg.data.print(displayValue, 2);
+    startRecord(now);
+    for (uint8_t k = 0; k < count; k++) {
+        const Input* ptr = &inputs[slots[k]];
+        uint16_t offset = channelOffset[slots[k]];
+        if (!offset) continue;
+        float value = samples[slots[k]].value;
+        if (format == SERIAL_FORMAT_WIDE) {
+            rowValue[slots[k]] = toInputUnits(ptr, value);
+        } else {
+            writePackedSignal(&record[offset - 1], ptr->measurementType, value);
+        }
     }
 
-    msg.data.print(",");
-    msg.data.print((__FlashStringHelper*)getUnitStringByIndex(ptr->unitsIndex));
-    msg.data.println();
+    if (format == SERIAL_FORMAT_WIDE) {
+        sendRow();
+    } else {
+        sendRecord();
+        memset(&record[4], 0xFF, recordSize - 4);  // Inputs not sent next tick go out as no data
+    }
 }
 
 void updateSerialOutput() {
-    // Can add header row every N seconds if desired
+    if (format == SERIAL_FORMAT_CSV) {
+        return;
+    }
+
+    // A host that just connected gets the description (WIDE: header row) before the next record
+    TransportInterface* transport = router.getTransport(PLANE_DATA);
+    bool connected = transport && transport->isConnected();
+    if (connected && !dataConnected) {
+        describeDue = true;
+    }
+    dataConnected = connected;
 }
 
 #else
 
 void initSerialOutput() {}
-void sendSerialOutput(Input *ptr) {}
+void sendSerialBatch(const uint8_t* slots, uint8_t count, const InputSample* samples, uint32_t now) {}
 void updateSerialOutput() {}
+bool setSerialFormat(SerialFormat format) { return false; }
+SerialFormat getSerialFormat() { return SERIAL_FORMAT_CSV; }
 
 #endif
+
+const __FlashStringHelper* getSerialFormatName(SerialFormat format) {
+    switch (format) {
+        case SERIAL_FORMAT_WIDE:       return F("WIDE");
+        case SERIAL_FORMAT_BINARY:     return F("BINARY");
+        case SERIAL_FORMAT_COMPRESSED: return F("COMPRESSED");
+        default:                       return F("CSV");
+    }
+}
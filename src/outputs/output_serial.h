@@ -0,0 +1,33 @@
+/*
+ * output_serial.h - Serial data plane output (CSV rows or binary frames)
+ *
+ * initSerialOutput() / sendSerialBatch() / updateSerialOutput() are the
+ * output module hooks (output_manager.cpp).
+ */
+
+#ifndef OUTPUT_SERIAL_H
+#define OUTPUT_SERIAL_H
+
+#include <Arduino.h>
+#include "../inputs/input.h"
+#include "../inputs/input_snapshot.h"
+#include "../lib/system_config.h"
+
+void initSerialOutput();
+void sendSerialBatch(const uint8_t* slots, uint8_t count, const InputSample* samples, uint32_t now);
+void updateSerialOutput();
+
+// CSV format: one input's "abbr,value,units" line into the output frame
+void appendSerialCSVLine(const Input* ptr, float value);
+
+/**
+ * Switch the data plane encoding (OUTPUT Serial FORMAT)
+ * WIDE prints its header row and the binary formats describe their channels
+ * again before the next record.
+ * @return false if the format is not available on this build
+ */
+bool setSerialFormat(SerialFormat format);
+SerialFormat getSerialFormat();
+const __FlashStringHelper* getSerialFormatName(SerialFormat format);
+
+#endif // OUTPUT_SERIAL_H
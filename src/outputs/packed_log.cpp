@@ -0,0 +1,71 @@
+/*
+ * packed_log.cpp - Binary log format shared by the SD log and the serial stream
+ */
+
+#include "packed_log.h"
+#include "packed_signal.h"
+#include "../inputs/input_manager.h"
+
+uint16_t buildPackedLayout(uint16_t* offsets, uint8_t output, uint8_t* channels) {
+    memset(offsets, 0, MAX_INPUTS * sizeof(offsets[0]));
+    uint16_t size = 4;
+    *channels = 0;
+
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        if (inputs[i].pin == 0xFF || !inputs[i].flags.isEnabled) continue;
+        if (output != PACKED_LOG_ALL_INPUTS && !(inputs[i].outputMask & (1 << output))) continue;
+        offsets[i] = size + 1;
+        size += getPackedScale(inputs[i].measurementType).width;
+        (*channels)++;
+    }
+    return size;
+}
+
+uint8_t getPackedLayoutWidths(const uint16_t* offsets, uint8_t* widths) {
+    uint8_t channels = 0;
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        if (offsets[i]) widths[channels++] = getPackedScale(inputs[i].measurementType).width;
+    }
+    return channels;
+}
+
+uint32_t getPackedLayoutSignature(uint8_t output) {
+    uint32_t hash = 2166136261UL;  // FNV-1a
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        if (inputs[i].pin == 0xFF || !inputs[i].flags.isEnabled) continue;
+        if (output != PACKED_LOG_ALL_INPUTS && !(inputs[i].outputMask & (1 << output))) continue;
+        hash = (hash ^ i) * 16777619UL;
+        hash = (hash ^ inputs[i].measurementType) * 16777619UL;
+        for (uint8_t k = 0; k < sizeof(inputs[i].abbrName) && inputs[i].abbrName[k]; k++) {
+            hash = (hash ^ (uint8_t)inputs[i].abbrName[k]) * 16777619UL;
+        }
+    }
+    return hash;
+}
+
+void writePackedLogHeader(PackedLogSink sink, const uint16_t* offsets, uint8_t channels, uint16_t size,
+                          uint32_t startMs, uint32_t startUnix, uint8_t version) {
+    PackedLogHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PACKED_LOG_MAGIC, 4);
+    header.version = version;
+    header.channels = channels;
+    header.recordSize = size;
+    header.startMs = startMs;
+    header.startUnix = startUnix;
+    sink((const uint8_t*)&header, sizeof(header));
+
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        if (!offsets[i]) continue;
+        PackedScale scale = getPackedScale(inputs[i].measurementType);
+
+        PackedLogChannel channel;
+        memset(&channel, 0, sizeof(channel));
+        strncpy(channel.name, inputs[i].abbrName, sizeof(channel.name));
+        strncpy_P(channel.units, (const char*)getPackedUnits(inputs[i].measurementType), sizeof(channel.units));
+        channel.width = scale.width;
+        channel.factor = scale.factor;
+        channel.offset = scale.offset;
+        sink((const uint8_t*)&channel, sizeof(channel));
+    }
+}
@@ -0,0 +1,73 @@
+/*
+ * packed_log.h - Binary log format shared by the SD log and the serial stream
+ *
+ * A log describes its channels once, then holds one fixed-size record per
+ * tick: the timestamp and each channel as a packed signal (packed_signal.h).
+ *
+ *   Header   "POBL" version channels recordSize startMs startUnix  (16 bytes)
+ *   Channel  name[8] units[6] width - factor offset             (24 bytes each)
+ *   Record   ms (uint32) + each channel's value, little-endian
+ *
+ * Version 1 stores records as they are; version 2 stores each record as a
+ * log_compress.h block. tools/sdlog_convert.py reads both.
+ */
+
+#ifndef PACKED_LOG_H
+#define PACKED_LOG_H
+
+#include <Arduino.h>
+
+#define PACKED_LOG_MAGIC                "POBL"
+#define PACKED_LOG_VERSION              1
+#define PACKED_LOG_VERSION_COMPRESSED   2
+
+#define PACKED_LOG_ALL_INPUTS           0xFF   // buildPackedLayout(): every enabled input
+
+struct PackedLogHeader {
+    char magic[4];
+    uint8_t version;
+    uint8_t channels;
+    uint16_t recordSize;    // Bytes per record (uncompressed)
+    uint32_t startMs;       // millis() when the log started
+    uint32_t startUnix;     // Wall clock at startMs, 0 = unknown
+};
+
+struct PackedLogChannel {
+    char name[8];           // Input::abbrName
+    char units[6];          // Standard units (getPackedUnits)
+    uint8_t width;          // Value bytes (1 or 2)
+    uint8_t reserved;
+    float factor;
+    float offset;
+};
+
+static_assert(sizeof(PackedLogHeader) == 16, "Log header is 16 bytes on disk");
+static_assert(sizeof(PackedLogChannel) == 24, "Log channel is 24 bytes on disk");
+
+typedef void (*PackedLogSink)(const uint8_t* data, uint16_t len);
+
+/**
+ * Record layout over the enabled inputs
+ * @param offsets   Input slot -> offset in the record + 1 (0 = not in the record)
+ * @param output    Only inputs routed to this output (OUTPUT_SD, ...), or PACKED_LOG_ALL_INPUTS
+ * @return Record size in bytes, timestamp included
+ */
+uint16_t buildPackedLayout(uint16_t* offsets, uint8_t output, uint8_t* channels);
+
+/**
+ * Width of each channel of a layout, in record order (for logCompressReset)
+ * @return Channel count
+ */
+uint8_t getPackedLayoutWidths(const uint16_t* offsets, uint8_t* widths);
+
+/**
+ * Hash of what buildPackedLayout() would describe for an output - inputs,
+ * types and names - to notice a routing or configuration change cheaply
+ */
+uint32_t getPackedLayoutSignature(uint8_t output);
+
+// Header and channel table for a layout
+void writePackedLogHeader(PackedLogSink sink, const uint16_t* offsets, uint8_t channels, uint16_t size,
+                          uint32_t startMs, uint32_t startUnix, uint8_t version);
+
+#endif // PACKED_LOG_H
@@ -0,0 +1,58 @@
+/*
+ * packed_signal.cpp - Scaled integer signals for packed output frames
+ */
+
+#include "packed_signal.h"
+#include "../inputs/input_manager.h"
+#include "../lib/message_api.h"
+
+const __FlashStringHelper* getPackedUnits(MeasurementType type) {
+    switch (type) {
+        case MEASURE_TEMPERATURE: return F("C");
+        case MEASURE_PRESSURE:    return F("bar");
+        case MEASURE_VOLTAGE:     return F("V");
+        case MEASURE_RPM:         return F("rpm");
+        case MEASURE_HUMIDITY:    return F("%");
+        case MEASURE_ELEVATION:   return F("m");
+        case MEASURE_SPEED:       return F("km/h");
+        default:                  return F("");
+    }
+}
+
+void printXmlText(const char* text) {
+    for (const char* c = text; *c; c++) {
+        switch (*c) {
+            case '&': msg.control.print(F("&amp;")); break;
+            case '<': msg.control.print(F("&lt;")); break;
+            case '>': msg.control.print(F("&gt;")); break;
+            case '"': msg.control.print(F("&quot;")); break;
+            default:  msg.control.print(*c); break;
+        }
+    }
+}
+
+void printRealDashValue(const Input* input, uint8_t offset) {
+    PackedScale scale = getPackedScale(input->measurementType);
+
+    msg.control.print(F("      <value name=\""));
+    printXmlText(input->abbrName);
+    msg.control.print(F(": "));
+    char name[INPUT_DISPLAY_NAME_LEN];
+    printXmlText(getInputDisplayName(input, name));
+    msg.control.print(F("\" units=\""));
+    msg.control.print(getPackedUnits(input->measurementType));
+    msg.control.print(F("\" offset=\""));
+    msg.control.print(offset);
+    msg.control.print(F("\" length=\""));
+    msg.control.print(scale.width);
+    msg.control.print(F("\" endianness=\"little\"><conversion>V"));
+    if (scale.factor != 1.0f) {
+        msg.control.print(F("*"));
+        msg.control.print(scale.factor, 2);
+    }
+    if (scale.offset != 0.0f) {
+        if (scale.offset > 0.0f) msg.control.print(F("+"));
+        msg.control.print(scale.offset, 0);
+    }
+    msg.control.println(F("</conversion></value>"));
+}
@@ -0,0 +1,83 @@
+/*
+ * packed_signal.h - Scaled integer signals for packed output frames
+ *
+ * The packed CAN broadcast layout and RealDash 0x66 frames carry each input
+ * as an 8- or 16-bit little-endian integer instead of a frame of its own.
+ * Scaling is fixed per measurement type, in standard units:
+ *
+ *   physical = raw * factor + offset
+ *
+ * The all-ones raw value (0xFF / 0xFFFF) means "not available".
+ */
+
+#ifndef PACKED_SIGNAL_H
+#define PACKED_SIGNAL_H
+
+#include <Arduino.h>
+#include "../inputs/input.h"
+
+struct PackedScale {
+    uint8_t width;      // Signal bytes (1 or 2, little-endian)
+    float factor;
+    float offset;
+};
+
+inline PackedScale getPackedScale(MeasurementType type) {
+    switch (type) {
+        case MEASURE_TEMPERATURE: return {2, 0.1f, -40.0f};    // -40..6513 C
+        case MEASURE_PRESSURE:    return {2, 0.01f, 0.0f};     // 0..655 bar
+        case MEASURE_VOLTAGE:     return {2, 0.01f, 0.0f};     // 0..655 V
+        case MEASURE_RPM:         return {2, 1.0f, 0.0f};      // 0..65534 RPM
+        case MEASURE_HUMIDITY:    return {1, 0.5f, 0.0f};      // 0..127 %
+        case MEASURE_ELEVATION:   return {2, 1.0f, -1000.0f};  // -1000..64534 m
+        case MEASURE_DIGITAL:     return {1, 1.0f, 0.0f};      // 0 / 1
+        case MEASURE_SPEED:       return {2, 0.01f, 0.0f};     // 0..655 km/h
+        default:                  return {2, 0.01f, 0.0f};
+    }
+}
+
+/**
+ * Scale a value (standard units) to its raw signal value
+ * Out-of-range values clamp to the signal range; no data is all ones.
+ */
+inline uint16_t encodePackedValue(float value, const PackedScale& scale) {
+    uint16_t notAvailable = (scale.width == 1) ? 0xFF : 0xFFFF;
+    if (isnan(value)) return notAvailable;
+
+    float raw = (value - scale.offset) / scale.factor + 0.5f;
+    if (raw < 0.0f) return 0;
+    if (raw >= notAvailable) return notAvailable - 1;
+    return (uint16_t)raw;
+}
+
+/**
+ * Write a signal at data[0..width) - value in standard units, for an input
+ * of the given measurement type (e.g. a snapshot sample, input_snapshot.h)
+ * @return  Signal width in bytes
+ */
+inline uint8_t writePackedSignal(uint8_t* data, MeasurementType type, float value) {
+    PackedScale scale = getPackedScale(type);
+    uint16_t raw = encodePackedValue(value, scale);
+    data[0] = raw & 0xFF;
+    if (scale.width == 2) data[1] = raw >> 8;
+    return scale.width;
+}
+
+// An input's current value
+inline uint8_t writePackedSignal(uint8_t* data, const Input* input) {
+    return writePackedSignal(data, input->measurementType, input->value);
+}
+
+// Unit string for DBC / RealDash descriptions
+const __FlashStringHelper* getPackedUnits(MeasurementType type);
+
+// Print text with XML special characters escaped to the control port
+void printXmlText(const char* text);
+
+/**
+ * Print a RealDash XML <value> element for an input's signal
+ * @param offset  Byte offset of the signal in its frame
+ */
+void printRealDashValue(const Input* input, uint8_t offset);
+
+#endif // PACKED_SIGNAL_H
@@ -0,0 +1,40 @@
+/*
+ * serial_frame.cpp - Frame format of the binary serial data plane
+ */
+
+#include "serial_frame.h"
+
+static uint16_t frameSequence = 0;
+
+uint16_t serialFrameCrc(uint16_t crc, const uint8_t* data, uint16_t len) {
+    for (uint16_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+uint16_t nextSerialFrameSequence() {
+    return frameSequence++;
+}
+
+uint16_t buildSerialFrame(uint8_t* frame, uint8_t type, uint16_t len) {
+    return buildSerialFrame(frame, type, len, nextSerialFrameSequence());
+}
+
+uint16_t buildSerialFrame(uint8_t* frame, uint8_t type, uint16_t len, uint16_t sequence) {
+    frame[0] = SERIAL_FRAME_SYNC1;
+    frame[1] = SERIAL_FRAME_SYNC2;
+    frame[2] = type;
+    frame[3] = sequence & 0xFF;
+    frame[4] = sequence >> 8;
+    frame[5] = len & 0xFF;
+    frame[6] = len >> 8;
+
+    uint16_t crc = serialFrameCrc(0xFFFF, frame + 2, SERIAL_FRAME_HEADER - 2 + len);
+    frame[SERIAL_FRAME_HEADER + len] = crc & 0xFF;
+    frame[SERIAL_FRAME_HEADER + len + 1] = crc >> 8;
+    return len + SERIAL_FRAME_OVERHEAD;
+}
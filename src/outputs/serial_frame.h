@@ -0,0 +1,44 @@
+/*
+ * serial_frame.h - Frame format of the binary serial data plane
+ *
+ *   0xA5 0x5A  type  sequence (uint16)  length (uint16)  payload  CRC16
+ *
+ * little-endian, the CRC-16/CCITT-FALSE over type to payload. Every binary
+ * producer on the data plane - the Serial output's 'D'/'R' frames
+ * (output_serial.cpp) and the bench stream's 'S'/'B' frames
+ * (bench_stream.h) - numbers its frames from the one sequence counter,
+ * so a receiver counts drops across both. The deferred log's 'L' frames
+ * (lib/log_deferred.h) go to the debug plane and number their own. A
+ * framed serial transport (TRANSPORT FRAMING ON, lib/transport_serial.h)
+ * wraps each write in 'c'/'d'/'g' plane frames numbered per transport, with
+ * the frames above nested inside. Decoded on the host by
+ * tools/sdlog_convert.py (StreamDecoder).
+ */
+
+#ifndef SERIAL_FRAME_H
+#define SERIAL_FRAME_H
+
+#include <Arduino.h>
+
+#define SERIAL_FRAME_SYNC1        0xA5
+#define SERIAL_FRAME_SYNC2        0x5A
+#define SERIAL_FRAME_HEADER       7                         // Sync, type, sequence, length
+#define SERIAL_FRAME_OVERHEAD     (SERIAL_FRAME_HEADER + 2) // Header + CRC
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) - bitwise, no table in RAM
+uint16_t serialFrameCrc(uint16_t crc, const uint8_t* data, uint16_t len);
+
+// Sequence number for the next frame (shared by every producer)
+uint16_t nextSerialFrameSequence();
+
+/**
+ * Frame a payload already placed at frame + SERIAL_FRAME_HEADER: fills in
+ * the header in front of it and the CRC behind it
+ * @return Frame length (len + SERIAL_FRAME_OVERHEAD)
+ */
+uint16_t buildSerialFrame(uint8_t* frame, uint8_t type, uint16_t len);
+
+// The same with a sequence number of the caller's own
+uint16_t buildSerialFrame(uint8_t* frame, uint8_t type, uint16_t len, uint16_t sequence);
+
+#endif // SERIAL_FRAME_H
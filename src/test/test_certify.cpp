@@ -0,0 +1,621 @@
+/*
+ * test_certify.cpp - Worst-case load run and loop-time report (TEST CERTIFY)
+ *
+ * Fills every free input slot, turns every output on at
+ * TEST_CERTIFY_OUTPUT_MS and injects synthetic CAN traffic, then measures
+ * what the loop does under that load. The configuration is changed through
+ * a live input transaction (input_manager.h) - read and checked as usual -
+ * and rolled back at the end, with the output settings put back as they
+ * were; nothing is saved.
+ *
+ * Free slots take free analog pins first, round-robin over the thermistor,
+ * pressure and battery applications, then CAN:n imports of standard OBD-II
+ * PIDs (responder 0x7E8, 0x7E9 past the end of the PID table). The CAN
+ * traffic alternates answers to those PIDs with IDs no input subscribes to.
+ *
+ * Alarm latency: the first input filled is stepped past its alarm limit
+ * every TEST_CERTIFY_STEP_MS (its read runs, then its value is replaced) and
+ * the time from the step to the alarm is taken - read interval, alarm task
+ * and loop jitter together.
+ */
+
+#include "../config.h"
+
+#ifdef ENABLE_TEST_MODE
+
+#include "test_mode.h"
+#include "../lib/message_api.h"
+
+#if !defined(USE_STATIC_CONFIG) && CONFIG_TRANSACTIONS
+
+#include "../lib/application_presets.h"
+#include "../lib/loop_monitor.h"
+#include "../lib/message_router.h"
+#include "../lib/platform.h"
+#include "../lib/scheduler.h"
+#include "../lib/system_config.h"
+#include "../outputs/output_base.h"
+#include <string.h>
+
+#ifdef ENABLE_CAN
+#include "../hal/hal_can.h"
+#include "../hal/hal_timebase.h"
+#include "../lib/bus_config.h"
+#include "../lib/bus_manager.h"    // For getCANBusName()
+#include "../lib/can_rx.h"
+#include "../lib/can_tx.h"
+#include "../lib/can_sensor_library/standard_pids.h"
+#endif
+
+extern uint32_t getSDLogOverruns();
+
+#define CERTIFY_NO_SLOT 0xFF
+
+// Bits on the wire of an 8-byte standard frame, stuffing included
+#define CERTIFY_CAN_FRAME_BITS 125
+
+// Loop time histogram: 4 buckets per octave of microseconds (upper bound
+// within 25%), the last one open-ended
+#define CERTIFY_BUCKETS 84
+
+#define CERTIFY_MAX_OUTPUTS 8
+
+// Applications the analog slots take in turn (djb2 name hashes)
+static const uint16_t CERTIFY_APPS[] PROGMEM = {
+    0xB5AA,  // COOLANT_TEMP - thermistor
+    0x2361,  // OIL_PRESSURE - resistive sender curve
+    0xD063,  // PRIMARY_BATTERY - divider
+    0xB5BE,  // OIL_TEMP - thermistor
+    0xC084,  // BOOST_PRESSURE - linear
+    0xA889   // FUEL_PRESSURE - linear
+};
+#define NUM_CERTIFY_APPS (sizeof(CERTIFY_APPS) / sizeof(CERTIFY_APPS[0]))
+
+struct CertifyOutput {
+    bool enabled;
+    uint16_t interval;
+};
+
+struct CertifyState {
+    bool active;
+    bool firstPass;             // Start-up pass, not measured
+    uint32_t startMs;
+    uint32_t durationMs;
+    uint8_t userInputs;         // Slots in use before the run
+    uint8_t analogFilled;
+    uint8_t canFilled;
+    uint8_t outputsOn;
+    CertifyOutput outputs[CERTIFY_MAX_OUTPUTS];
+
+    // Loop busy time per pass
+    uint32_t hist[CERTIFY_BUCKETS];
+    uint32_t passes;
+    uint32_t maxUs;
+    uint64_t sumUs;
+
+    // Alarm step
+    uint8_t stepSlot;
+    char stepName[8];           // Its short name (the slot is freed at the end)
+    void (*stepRead)(Input*);
+    bool stepHigh;
+    bool stepPending;           // Raised, alarm not seen yet
+    uint32_t stepAtUs;
+    uint32_t nextStepMs;
+    uint32_t alarms;
+    uint32_t alarmsMissed;      // Step fell before the alarm came
+    uint32_t alarmMinUs;
+    uint32_t alarmMaxUs;
+    uint32_t alarmSumUs;
+
+    // Counters at the start
+    LoopOverrunStats loop0;
+    uint32_t shed0[MAX_SCHEDULER_TASKS];
+    uint32_t txBytesDropped0;
+    uint32_t txWritesDropped0;
+    uint32_t sdOverruns0;
+
+#ifdef ENABLE_CAN
+    uint8_t rxBus;              // 0xFF = no CAN input to feed
+    uint8_t loadPct;
+    uint32_t framesPerSec;
+    uint32_t framesSent;
+    uint32_t framesSkipped;     // Owed beyond TEST_CERTIFY_CAN_BACKLOG_MS
+    uint16_t frameCounter;
+    uint8_t canSlots[MAX_INPUTS];
+    uint8_t nextCanSlot;
+    CANTxBusStats tx0[CAN_TX_MAX_BUSES];
+#endif
+};
+
+static CertifyState cert;
+
+// ===== LOOP TIME HISTOGRAM =====
+
+static uint8_t certifyBucket(uint32_t us) {
+    if (us < 4) return us;
+    uint8_t bits = 0;
+    for (uint32_t v = us; v != 0; v >>= 1) bits++;
+    uint16_t bucket = 4 * (bits - 2) + ((us >> (bits - 3)) & 3);
+    return bucket < CERTIFY_BUCKETS ? bucket : CERTIFY_BUCKETS - 1;
+}
+
+// Largest time in a bucket
+static uint32_t certifyBucketTop(uint8_t bucket) {
+    if (bucket < 4) return bucket;
+    uint8_t bits = bucket / 4 + 2;
+    return ((uint32_t)(5 + bucket % 4) << (bits - 3)) - 1;
+}
+
+// Upper bound of the bucket holding the pct-th percentile pass
+static uint32_t certifyPercentile(uint8_t pct) {
+    if (cert.passes == 0) return 0;
+    uint32_t rank = (uint32_t)(((uint64_t)cert.passes * pct + 99) / 100);
+    uint32_t seen = 0;
+    for (uint8_t b = 0; b < CERTIFY_BUCKETS; b++) {
+        seen += cert.hist[b];
+        if (seen >= rank) {
+            uint32_t top = certifyBucketTop(b);
+            return (b == CERTIFY_BUCKETS - 1 || top > cert.maxUs) ? cert.maxUs : top;
+        }
+    }
+    return cert.maxUs;
+}
+
+// ===== TRANSPORT COUNTERS =====
+
+static void sumTxDrops(uint32_t* bytes, uint32_t* writes) {
+    *bytes = 0;
+    *writes = 0;
+    for (uint8_t id = 1; id < NUM_TRANSPORTS; id++) {
+        TransportInterface* t = router.getTransportById((TransportID)id);
+        const TxStats* s = t ? t->getTxStats() : nullptr;
+        if (!s) continue;
+        *bytes += s->bytesDropped;
+        *writes += s->writesDropped;
+    }
+}
+
+// ===== ALARM STEP =====
+
+// The step input's own read, then the value the step is at
+static void readCertifyStep(Input* ptr) {
+    if (cert.stepRead) cert.stepRead(ptr);
+    float span = ptr->maxValue - ptr->minValue;
+    if (!(span > 0)) span = 1.0f;
+    ptr->value = cert.stepHigh ? ptr->maxValue + span : ptr->minValue + span / 2;
+}
+
+static void setupAlarmStep(uint8_t slot) {
+    Input* input = &inputs[slot];
+    if (!(input->maxValue > input->minValue)) {
+        setInputAlarmRange(input->pin, 0.0f, 100.0f);
+    }
+    enableInputAlarm(input->pin, true);
+    setInputAlarmWarmup(input->pin, 0);
+    setInputAlarmPersist(input->pin, 0);
+    setInputAlarmClear(input->pin, 0);
+    setInputWarmup(input, 0);
+
+    cert.stepSlot = slot;
+    memcpy(cert.stepName, input->abbrName, sizeof(cert.stepName));
+    cert.stepRead = input->readFunction;
+    input->readFunction = readCertifyStep;
+    rebuildInputSchedule();                     // The schedule caches read functions
+}
+
+static void updateAlarmStep(uint32_t nowMs) {
+    if (cert.stepSlot == CERTIFY_NO_SLOT) return;
+    if (cert.stepPending && inputs[cert.stepSlot].flags.isInAlarm) {
+        uint32_t us = micros() - cert.stepAtUs;
+        if (cert.alarms == 0 || us < cert.alarmMinUs) cert.alarmMinUs = us;
+        if (us > cert.alarmMaxUs) cert.alarmMaxUs = us;
+        cert.alarmSumUs += us;
+        cert.alarms++;
+        cert.stepPending = false;
+    }
+    if ((int32_t)(nowMs - cert.nextStepMs) < 0) return;
+
+    cert.nextStepMs = nowMs + TEST_CERTIFY_STEP_MS;
+    if (cert.stepPending) cert.alarmsMissed++;
+    cert.stepHigh = !cert.stepHigh;
+    cert.stepPending = cert.stepHigh;
+    cert.stepAtUs = micros();
+}
+
+// ===== SLOT FILLING =====
+
+static bool slotsLeft() {
+    return numActiveInputs < MAX_INPUTS;
+}
+
+static void fillAnalogSlots() {
+    uint8_t app = 0;
+    for (uint8_t n = 0; n < TEST_CERTIFY_ANALOG_PINS && slotsLeft(); n++) {
+        uint8_t pin = A0 + n;
+        if (getInputByPin(pin)) continue;
+        uint8_t appIndex = getApplicationIndexByHash(pgm_read_word(&CERTIFY_APPS[app % NUM_CERTIFY_APPS]));
+        app++;
+        if (!setInputApplication(pin, appIndex)) continue;   // Pin taken by a bus
+        if (cert.stepSlot == CERTIFY_NO_SLOT) setupAlarmStep(getInputIndex(pin));
+        cert.analogFilled++;
+    }
+}
+
+#ifdef ENABLE_CAN
+static void fillCANSlots() {
+    uint8_t sensorIndex = getSensorIndexByName("CAN_IMPORT");
+    uint8_t appIndex = getApplicationIndexByHash(0xD063);  // PRIMARY_BATTERY - only creates the slot
+    if (sensorIndex == 0) return;
+
+    for (uint16_t n = 0; n < CAN_PINS && slotsLeft(); n++) {
+        InputPin pin = CAN_PIN(n);
+        if (getInputByPin(pin)) continue;
+
+        StandardPIDInfo info;
+        memcpy_P(&info, &STANDARD_PID_TABLE[cert.canFilled % NUM_STANDARD_PIDS], sizeof(info));
+        if (!setInputApplication(pin, appIndex)) continue;
+        if (!setInputSensor(pin, sensorIndex)) {
+            clearInput(pin);
+            continue;
+        }
+        Input* input = getInputByPin(pin);
+        if (!input) continue;
+        input->flags.alarm = false;             // Battery limits don't fit the PID
+
+        input->customCalibration.can.whole_frame = false;
+        input->customCalibration.can.source_can_id = 0x7E8 + cert.canFilled / NUM_STANDARD_PIDS;
+        input->customCalibration.can.source_pid = info.pid;
+        input->customCalibration.can.data_offset = 0;
+        input->customCalibration.can.data_length = info.data_length;
+        input->customCalibration.can.is_big_endian = true;
+        input->customCalibration.can.bit_offset = 0;
+        input->customCalibration.can.bit_length = 0;
+        input->customCalibration.can.scale_factor = info.scale_factor;
+        input->customCalibration.can.offset = info.offset;
+        input->customCalibration.can.timeout_ms = 0;
+        input->flags.useCustomCalibration = true;
+        input->measurementType = info.measurementType;
+        sprintf(input->abbrName, "C%02X", info.pid);
+
+        uint8_t slot = input - inputs;
+        cert.canSlots[cert.canFilled++] = slot;
+        if (cert.stepSlot == CERTIFY_NO_SLOT) setupAlarmStep(slot);
+    }
+    rebuildInputSchedule();                     // Subscriptions for the new (CAN ID, PID) pairs
+}
+
+// One synthetic frame: an answer to the next certify CAN input, or noise
+static void injectCertifyFrame() {
+    hal::can::CanRxFrame frame;
+    memset(&frame, 0, sizeof(frame));
+    uint16_t k = cert.frameCounter++;
+    frame.len = 8;
+
+    if ((k & 1) == 0 && cert.canFilled > 0) {
+        const Input* input = &inputs[cert.canSlots[cert.nextCanSlot]];
+        cert.nextCanSlot = (cert.nextCanSlot + 1) % cert.canFilled;
+        frame.id = input->customCalibration.can.source_can_id;
+        frame.data[0] = 0x04;                   // The length byte the input path parses
+        frame.data[1] = 0x41;
+        frame.data[2] = input->customCalibration.can.source_pid;
+        frame.data[3] = (uint8_t)(k >> 8);
+        frame.data[4] = (uint8_t)k;
+    } else {
+        frame.id = 0x100 + (k >> 1) % 0x80;     // Nobody's subscription
+        for (uint8_t i = 0; i < 8; i++) frame.data[i] = (uint8_t)(k + i);
+    }
+    frame.rxMs = millis();
+    frame.rxUs = hal::micros64();
+    injectCANRxFrame(cert.rxBus, frame);
+    cert.framesSent++;
+}
+
+// Frames owed by the offered rate, at most TEST_CERTIFY_CAN_BURST a pass
+static void updateCertifyCAN(uint32_t elapsedMs) {
+    if (cert.rxBus == 0xFF || cert.framesPerSec == 0) return;
+
+    uint32_t owed = (uint32_t)((uint64_t)elapsedMs * cert.framesPerSec / 1000) - cert.framesSkipped;
+    uint32_t backlog = owed - cert.framesSent;
+    uint32_t limit = (uint32_t)((uint64_t)cert.framesPerSec * TEST_CERTIFY_CAN_BACKLOG_MS / 1000);
+    if (backlog > limit) {
+        cert.framesSkipped += backlog - limit;  // The loop can't keep up - not owed any more
+        backlog = limit;
+    }
+    for (uint16_t n = 0; n < TEST_CERTIFY_CAN_BURST && backlog > 0; n++, backlog--) {
+        injectCertifyFrame();
+    }
+}
+#endif // ENABLE_CAN
+
+// ===== OUTPUTS =====
+
+static void enableAllOutputs() {
+    for (uint8_t i = 0; i < CERTIFY_MAX_OUTPUTS; i++) {
+        OutputModule* output = getOutputByIndex(i);
+        if (!output) break;
+        cert.outputs[i].enabled = output->enabled;
+        cert.outputs[i].interval = output->sendInterval;
+        if (setOutputEnabled(output->name, true)) {
+            setOutputInterval(output->name, TEST_CERTIFY_OUTPUT_MS);
+            cert.outputsOn++;
+        }
+    }
+}
+
+static void restoreOutputs() {
+    for (uint8_t i = 0; i < CERTIFY_MAX_OUTPUTS; i++) {
+        OutputModule* output = getOutputByIndex(i);
+        if (!output) break;
+        setOutputInterval(output->name, cert.outputs[i].interval);
+        setOutputEnabled(output->name, cert.outputs[i].enabled);
+    }
+}
+
+// ===== REPORT =====
+
+static void printMs(uint32_t us) {
+    msg.control.print(us / 1000.0f, 1);
+    msg.control.print(F(" ms"));
+}
+
+static void printCertifyReport(uint32_t elapsedMs) {
+    msg.control.print(F("Certification: "));
+    msg.control.print(F(PLATFORM_NAME));
+    msg.control.print(F(", "));
+    msg.control.print(elapsedMs / 1000.0f, 1);
+    msg.control.println(F(" s"));
+
+    msg.control.print(F("  Inputs: "));
+    msg.control.print(cert.userInputs + cert.analogFilled + cert.canFilled);
+    msg.control.print(F(" of "));
+    msg.control.print(MAX_INPUTS);
+    msg.control.print(F(" ("));
+    msg.control.print(cert.userInputs);
+    msg.control.print(F(" configured, "));
+    msg.control.print(cert.analogFilled);
+    msg.control.print(F(" analog and "));
+    msg.control.print(cert.canFilled);
+    msg.control.println(F(" CAN added)"));
+
+    msg.control.print(F("  Outputs: "));
+    msg.control.print(cert.outputsOn);
+    msg.control.print(F(" every "));
+    msg.control.print(TEST_CERTIFY_OUTPUT_MS);
+    msg.control.println(F(" ms"));
+
+#ifdef ENABLE_CAN
+    if (cert.rxBus != 0xFF) {
+        msg.control.print(F("  CAN: "));
+        msg.control.print(cert.loadPct);
+        msg.control.print(F("% load, "));
+        msg.control.print(cert.framesPerSec);
+        msg.control.print(F(" frames/s offered, "));
+        msg.control.print(elapsedMs ? (uint32_t)((uint64_t)cert.framesSent * 1000 / elapsedMs) : 0);
+        msg.control.print(F(" injected ("));
+        msg.control.print(cert.framesSkipped);
+        msg.control.println(F(" frames the loop fell behind on)"));
+    } else {
+        msg.control.println(F("  CAN: input off - no CAN inputs or traffic"));
+    }
+#endif
+
+    msg.control.print(F("  Loop: "));
+    msg.control.print(cert.passes);
+    msg.control.print(F(" passes, mean "));
+    msg.control.print(cert.passes ? (uint32_t)(cert.sumUs / cert.passes) : 0);
+    msg.control.print(F(" us, p50 "));
+    msg.control.print(certifyPercentile(50));
+    msg.control.print(F(", p95 "));
+    msg.control.print(certifyPercentile(95));
+    msg.control.print(F(", p99 "));
+    msg.control.print(certifyPercentile(99));
+    msg.control.print(F(", max "));
+    msg.control.print(cert.maxUs);
+    msg.control.println(F(" us"));
+
+    const LoopOverrunStats* loop = getLoopStats();
+    msg.control.print(F("  Over budget: "));
+    msg.control.print(loop->overruns - cert.loop0.overruns);
+    msg.control.print(F(" passes, "));
+    msg.control.print(loop->deferrals - cert.loop0.deferrals);
+    msg.control.print(F(" deferrals (budget "));
+    msg.control.print(getLoopBudget());
+    msg.control.println(F(" ms)"));
+
+    msg.control.print(F("  Shed:"));
+    bool anyShed = false;
+    for (uint8_t id = 0; id < getNumScheduledTasks() && id < MAX_SCHEDULER_TASKS; id++) {
+        const ScheduledTask* task = getScheduledTask(id);
+        if (!task || task->shedCount == cert.shed0[id]) continue;
+        msg.control.print(' ');
+        msg.control.print(task->name);
+        msg.control.print(' ');
+        msg.control.print(task->shedCount - cert.shed0[id]);
+        anyShed = true;
+    }
+    if (!anyShed) msg.control.print(F(" none"));
+    msg.control.println();
+
+    uint32_t bytesDropped, writesDropped;
+    sumTxDrops(&bytesDropped, &writesDropped);
+    msg.control.print(F("  Drops: transports "));
+    msg.control.print(bytesDropped - cert.txBytesDropped0);
+    msg.control.print(F(" bytes ("));
+    msg.control.print(writesDropped - cert.txWritesDropped0);
+    msg.control.print(F(" writes), SD log "));
+    msg.control.print(getSDLogOverruns() - cert.sdOverruns0);
+    msg.control.print(F(" records"));
+#ifdef ENABLE_CAN
+    for (uint8_t bus = 0; bus < CAN_TX_MAX_BUSES; bus++) {
+        CANTxBusStats s;
+        if (!getCANTxBusStats(bus, &s) || s.sent == cert.tx0[bus].sent) continue;
+        msg.control.print(F(", "));
+        msg.control.print(getCANBusName(bus));
+        msg.control.print(F(" TX "));
+        msg.control.print(s.drops - cert.tx0[bus].drops);
+        msg.control.print(F(" of "));
+        msg.control.print(s.sent - cert.tx0[bus].sent + s.drops - cert.tx0[bus].drops);
+    }
+#endif
+    msg.control.println();
+
+    msg.control.print(F("  Alarm latency: "));
+    if (cert.stepSlot == CERTIFY_NO_SLOT) {
+        msg.control.println(F("not measured (no free slot)"));
+    } else if (cert.alarms == 0) {
+        msg.control.print(F("no alarm in "));
+        msg.control.print(cert.alarmsMissed);
+        msg.control.println(F(" steps"));
+    } else {
+        msg.control.print(cert.alarms);
+        msg.control.print(F(" steps on "));
+        msg.control.print(cert.stepName);
+        msg.control.print(F(", min "));
+        printMs(cert.alarmMinUs);
+        msg.control.print(F(", mean "));
+        printMs(cert.alarmSumUs / cert.alarms);
+        msg.control.print(F(", max "));
+        printMs(cert.alarmMaxUs);
+        msg.control.print(F(", "));
+        msg.control.print(cert.alarmsMissed);
+        msg.control.println(F(" missed"));
+    }
+}
+
+// ===== PUBLIC API =====
+
+bool startTestCertify(uint32_t seconds, uint8_t canLoadPct) {
+    if (cert.active) stopTestCertify();
+    if (isTestModeActive()) stopTestMode();
+
+    if (!beginInputTransaction(true)) {
+        msg.control.println(F("ERROR: A configuration transaction is open - COMMIT or ROLLBACK first"));
+        return false;
+    }
+
+    memset(&cert, 0, sizeof(cert));
+    cert.stepSlot = CERTIFY_NO_SLOT;
+    cert.userInputs = numActiveInputs;
+    cert.durationMs = seconds * 1000UL;
+
+    msg.control.println(F("========================================"));
+    msg.control.print(F("Certification run: "));
+    msg.control.print(seconds);
+    msg.control.println(F(" s at full load"));
+
+    fillAnalogSlots();
+
+#ifdef ENABLE_CAN
+    cert.rxBus = 0xFF;
+    if (systemConfig.buses.can_input_mode != CAN_INPUT_OFF && systemConfig.buses.input_can_bus != 0xFF) {
+        cert.rxBus = systemConfig.buses.input_can_bus;
+        cert.loadPct = canLoadPct;
+        cert.framesPerSec = (uint32_t)((uint64_t)systemConfig.buses.can_input_baudrate * canLoadPct /
+                                       (100UL * CERTIFY_CAN_FRAME_BITS));
+        fillCANSlots();
+    } else {
+        msg.control.println(F("  CAN input off - no CAN inputs or traffic (BUS CAN INPUT ...)"));
+    }
+#else
+    (void)canLoadPct;
+#endif
+
+    enableAllOutputs();
+
+    msg.control.print(F("  Inputs added: "));
+    msg.control.print(cert.analogFilled);
+    msg.control.print(F(" analog, "));
+    msg.control.print(cert.canFilled);
+    msg.control.print(F(" CAN ("));
+    msg.control.print(numActiveInputs);
+    msg.control.print(F(" of "));
+    msg.control.print(MAX_INPUTS);
+    msg.control.println(F(" slots)"));
+    msg.control.println(F("  Configuration is restored at the end - TEST STOP ends early"));
+    msg.control.println(F("========================================"));
+
+    cert.loop0 = *getLoopStats();
+    for (uint8_t id = 0; id < getNumScheduledTasks() && id < MAX_SCHEDULER_TASKS; id++) {
+        const ScheduledTask* task = getScheduledTask(id);
+        cert.shed0[id] = task ? task->shedCount : 0;
+    }
+    sumTxDrops(&cert.txBytesDropped0, &cert.txWritesDropped0);
+    cert.sdOverruns0 = getSDLogOverruns();
+#ifdef ENABLE_CAN
+    for (uint8_t bus = 0; bus < CAN_TX_MAX_BUSES; bus++) {
+        if (!getCANTxBusStats(bus, &cert.tx0[bus])) memset(&cert.tx0[bus], 0, sizeof(cert.tx0[bus]));
+    }
+#endif
+
+    cert.startMs = millis();
+    cert.nextStepMs = cert.startMs + TEST_CERTIFY_STEP_MS;
+    cert.firstPass = true;
+    cert.active = true;
+    return true;
+}
+
+void stopTestCertify() {
+    if (!cert.active) return;
+    cert.active = false;
+    uint32_t elapsedMs = millis() - cert.startMs;
+
+    restoreOutputs();
+    rollbackInputTransaction();                 // Read functions, alarms and slots as they were
+
+    msg.control.println();
+    msg.control.println(F("========================================"));
+    printCertifyReport(elapsedMs);
+    msg.control.println(F("========================================"));
+}
+
+bool isTestCertifyActive() {
+    return cert.active;
+}
+
+void updateTestCertify() {
+    if (!cert.active) return;
+    uint32_t nowMs = millis();
+    uint32_t elapsedMs = nowMs - cert.startMs;
+    if (elapsedMs >= cert.durationMs) {
+        stopTestCertify();
+        return;
+    }
+
+    updateAlarmStep(nowMs);
+#ifdef ENABLE_CAN
+    updateCertifyCAN(elapsedMs);                // Delivered now, counted in this pass
+#endif
+
+    if (cert.firstPass) {                       // Paid for the set-up
+        cert.firstPass = false;
+        return;
+    }
+    uint32_t us = getLoopElapsedUs();
+    cert.hist[certifyBucket(us)]++;
+    cert.passes++;
+    cert.sumUs += us;
+    if (us > cert.maxUs) cert.maxUs = us;
+}
+
+void printTestCertifyStatus() {
+    msg.control.println(F("Test mode: CERTIFY"));
+    printCertifyReport(millis() - cert.startMs);
+}
+
+#else
+
+bool startTestCertify(uint32_t seconds, uint8_t canLoadPct) {
+    (void)seconds;
+    (void)canLoadPct;
+    msg.control.println(F("ERROR: TEST CERTIFY needs configuration transactions (not on this board)"));
+    return false;
+}
+
+void stopTestCertify() {}
+bool isTestCertifyActive() { return false; }
+void updateTestCertify() {}
+void printTestCertifyStatus() {}
+
+#endif // !USE_STATIC_CONFIG && CONFIG_TRANSACTIONS
+
+#endif // ENABLE_TEST_MODE
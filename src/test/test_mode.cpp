@@ -18,9 +18,6 @@
 #include "../lib/log_tags.h"
 #include <string.h>
 
-// Forward declaration of test value generator
-extern float generateTestValue(const InputTestConfig* config, unsigned long elapsedMs);
-
 // Forward declaration of test read function
 void readTestInput(Input* ptr);
 
@@ -29,80 +26,85 @@ TestModeState testModeState;
 
 // ===== HELPER FUNCTIONS =====
 
-// Find the test config for a specific input index in the current scenario
-const InputTestConfig* findTestConfigForInput(uint8_t inputIndex) {
-    if (!testModeState.isActive || testModeState.currentScenario == nullptr) {
-        return nullptr;
+// Resolve which config (if any) simulates each input - once per scenario
+static void prepareScenarioInputs(const TestScenario* scenario) {
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        testModeState.values[i].config = 0xFF;
     }
-
-    // Read scenario from PROGMEM
-    TestScenario scenario;
-    memcpy_P(&scenario, testModeState.currentScenario, sizeof(TestScenario));
-
-    // Search through input configs for this input
-    for (uint8_t i = 0; i < scenario.numInputOverrides; i++) {
+    for (uint8_t c = 0; c < scenario->numInputOverrides; c++) {
         InputTestConfig config;
-        memcpy_P(&config, &scenario.inputConfigs[i], sizeof(InputTestConfig));
-
-        if (config.inputIndex == inputIndex) {
-            // Found it - but we need to return a pointer
-            // For now, we'll use a static buffer (not thread-safe but OK for single-threaded Arduino)
-            static InputTestConfig configBuffer;
-            memcpy(&configBuffer, &config, sizeof(InputTestConfig));
-            return &configBuffer;
-        }
-    }
+        memcpy_P(&config, &scenario->inputConfigs[c], sizeof(InputTestConfig));
+        if (config.inputIndex >= MAX_INPUTS) continue;
 
-    return nullptr;  // This input is not overridden in the current scenario
+        TestValueState* state = &testModeState.values[config.inputIndex];
+        if (state->config != 0xFF) continue;  // First config for an input wins
+        state->config = c;
+        prepareTestValue(&config, state);
+    }
 }
 
 // ===== TEST READ FUNCTION =====
 // This function replaces the normal sensor read functions during test mode
 void readTestInput(Input* ptr) {
-    // Find which input index this is
-    uint8_t inputIndex = 0xFF;
-    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
-        if (&inputs[i] == ptr) {
-            inputIndex = i;
-            break;
-        }
-    }
-
-    if (inputIndex == 0xFF || !testModeState.isActive) {
+    if (ptr < inputs || ptr >= inputs + MAX_INPUTS || !testModeState.isActive) {
         // Invalid input or test mode not active
         ptr->value = NAN;
         return;
     }
+    uint8_t inputIndex = ptr - inputs;
+
+#ifdef TEST_TRACE_HAS_SD
+    if (testModeState.trace) {
+        ptr->value = getTestTraceValue(inputIndex);  // Buffered row - no SD access here
+        return;
+    }
+#endif
 
-    // Find test config for this input
-    const InputTestConfig* config = findTestConfigForInput(inputIndex);
-    if (config == nullptr) {
+    TestValueState* state = &testModeState.values[inputIndex];
+    if (state->config == 0xFF) {
         // No test override for this input - use NaN or could call original function
         ptr->value = NAN;
         return;
     }
 
+    TestScenario scenario;
+    memcpy_P(&scenario, testModeState.currentScenario, sizeof(TestScenario));
+    InputTestConfig config;
+    memcpy_P(&config, &scenario.inputConfigs[state->config], sizeof(InputTestConfig));
+
     // Check for forced NaN
-    if (config->forceNaN) {
+    if (config.forceNaN) {
         ptr->value = NAN;
         return;
     }
 
     // Generate test value based on elapsed time
     unsigned long elapsed = millis() - testModeState.scenarioStartTime;
-    ptr->value = generateTestValue(config, elapsed);
+    ptr->value = generateTestValue(&config, state, elapsed);
 
     // Force alarm if requested (override to exceed threshold)
-    if (config->forceAlarm && ptr->flags.alarm) {
+    if (config.forceAlarm && ptr->flags.alarm) {
         ptr->value = ptr->maxValue + 10.0f;
     }
 }
 
+// Redirect every enabled input to readTestInput()
+static void substituteReadFunctions() {
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        if (inputs[i].flags.isEnabled) {
+            testModeState.originalReadFunctions[i] = inputs[i].readFunction;
+            inputs[i].readFunction = readTestInput;
+        }
+    }
+    rebuildInputSchedule();
+}
+
 // ===== PUBLIC API IMPLEMENTATION =====
 
 void initTestMode() {
     // Initialize test mode state
     testModeState.isActive = false;
+    testModeState.trace = false;
     testModeState.currentScenario = nullptr;
     testModeState.currentScenarioIndex = 0;
     testModeState.scenarioStartTime = 0;
@@ -131,6 +133,9 @@ bool startTestScenario(uint8_t scenarioIndex) {
     if (testModeState.isActive) {
         stopTestMode();
     }
+    if (isTestCertifyActive()) {
+        stopTestCertify();
+    }
 
     // Get pointer to scenario in PROGMEM
     testModeState.currentScenario = getTestScenario(scenarioIndex);
@@ -140,6 +145,7 @@ bool startTestScenario(uint8_t scenarioIndex) {
     // Read scenario info for printing
     TestScenario scenario;
     memcpy_P(&scenario, testModeState.currentScenario, sizeof(TestScenario));
+    prepareScenarioInputs(&scenario);
 
     char nameBuffer[32];
     strncpy_P(nameBuffer, scenario.name, sizeof(nameBuffer) - 1);
@@ -158,19 +164,41 @@ bool startTestScenario(uint8_t scenarioIndex) {
     msg.control.println(F("========================================"));
 
     // Backup original read functions and replace with test function
-    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
-        if (inputs[i].flags.isEnabled) {
-            testModeState.originalReadFunctions[i] = inputs[i].readFunction;
-            inputs[i].readFunction = readTestInput;
-        }
-    }
+    substituteReadFunctions();
 
     // Mark test mode as active
+    testModeState.trace = false;
     testModeState.isActive = true;
 
     return true;
 }
 
+bool startTestTrace(const char* filename, bool loop) {
+#ifdef TEST_TRACE_HAS_SD
+    if (testModeState.isActive) {
+        stopTestMode();
+    }
+    if (isTestCertifyActive()) {
+        stopTestCertify();
+    }
+    if (!openTestTrace(filename, loop)) {
+        return false;
+    }
+
+    testModeState.currentScenario = nullptr;
+    testModeState.scenarioStartTime = millis();
+    substituteReadFunctions();
+    testModeState.trace = true;
+    testModeState.isActive = true;
+    return true;
+#else
+    (void)filename;
+    (void)loop;
+    msg.control.println(F("ERROR: No SD support in this build - traces need SD"));
+    return false;
+#endif
+}
+
 void stopTestMode() {
     if (!testModeState.isActive) {
         return;  // Already stopped
@@ -187,9 +215,17 @@ void stopTestMode() {
             testModeState.originalReadFunctions[i] = nullptr;
         }
     }
+    rebuildInputSchedule();
+
+#ifdef TEST_TRACE_HAS_SD
+    if (testModeState.trace) {
+        closeTestTrace();
+    }
+#endif
 
     // Clear test mode state
     testModeState.isActive = false;
+    testModeState.trace = false;
     testModeState.currentScenario = nullptr;
     testModeState.scenarioStartTime = 0;
 }
@@ -203,12 +239,26 @@ void updateTestMode() {
         return;
     }
 
+    unsigned long elapsed = millis() - testModeState.scenarioStartTime;
+
+#ifdef TEST_TRACE_HAS_SD
+    if (testModeState.trace) {
+        if (!updateTestTrace(elapsed)) {
+            msg.control.println(F(""));
+            msg.control.println(F("========================================"));
+            msg.control.println(F("Test trace complete"));
+            msg.control.println(F("========================================"));
+            printTestTraceStatus(elapsed);
+            stopTestMode();
+        }
+        return;
+    }
+#endif
+
     // Check if scenario duration has elapsed
     TestScenario scenario;
     memcpy_P(&scenario, testModeState.currentScenario, sizeof(TestScenario));
 
-    unsigned long elapsed = millis() - testModeState.scenarioStartTime;
-
     if (elapsed >= scenario.duration_ms) {
         // Scenario complete
         msg.control.println(F(""));
@@ -222,6 +272,42 @@ void updateTestMode() {
     }
 }
 
+void printTestStatus() {
+    if (isTestCertifyActive()) {
+        printTestCertifyStatus();
+        return;
+    }
+    if (!testModeState.isActive) {
+        msg.control.println(F("Test mode: INACTIVE"));
+        return;
+    }
+
+    unsigned long elapsed = millis() - testModeState.scenarioStartTime;
+    msg.control.println(F("Test mode: ACTIVE"));
+#ifdef TEST_TRACE_HAS_SD
+    if (testModeState.trace) {
+        printTestTraceStatus(elapsed);
+        return;
+    }
+#endif
+
+    TestScenario scenario;
+    memcpy_P(&scenario, testModeState.currentScenario, sizeof(TestScenario));
+    char nameBuffer[32];
+    strncpy_P(nameBuffer, scenario.name, sizeof(nameBuffer) - 1);
+    nameBuffer[sizeof(nameBuffer) - 1] = '\0';
+
+    msg.control.print(F("  Scenario "));
+    msg.control.print(testModeState.currentScenarioIndex);
+    msg.control.print(F(": "));
+    msg.control.println(nameBuffer);
+    msg.control.print(F("  Elapsed: "));
+    msg.control.print(elapsed / 1000);
+    msg.control.print(F(" / "));
+    msg.control.print(scenario.duration_ms / 1000);
+    msg.control.println(F(" s"));
+}
+
 void listTestScenarios() {
     uint8_t numScenarios = getNumTestScenarios();
 
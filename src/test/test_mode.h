@@ -8,7 +8,43 @@
  * Features:
  * - Pre-defined test scenarios (normal operation, alarms, faults, etc.)
  * - Dynamic time-based value generation (ramps, waves, random walks)
+ * - Recorded traces streamed from SD at their own timing (TEST FILE)
  * - Zero overhead when ENABLE_TEST_MODE is not defined
+ *
+ * Generated values cost no trig or division per read: each input's period
+ * is turned into a 32-bit phase step when the scenario starts, and waves
+ * come from a quarter-sine table. The input -> config lookup is resolved
+ * then too.
+ *
+ * Traces (TEST FILE <file>) are CSV with a time column in ms ("Time" or
+ * "time_ms") and one column per input, headed by its short name - the
+ * layout tools/sdlog_convert.py writes, so a converted SD log plays back a
+ * recorded drive. Units in the heading ("CHT (C)") are ignored; values are
+ * in standard units; an empty cell is NaN. The loop reads the file one row
+ * ahead of the trace clock into a second buffer, at most
+ * TEST_TRACE_LINES_PER_PASS lines per pass; sensor reads only copy from
+ * RAM. Rows the loop couldn't apply within TEST_TRACE_LATE_MS of their
+ * time are counted as late.
+ *
+ * TEST CERTIFY [<seconds>] [CAN <percent>] is the worst-case load run
+ * (test_certify.cpp): every free input slot filled with representative
+ * sensors, every output on at TEST_CERTIFY_OUTPUT_MS, synthetic CAN traffic
+ * at the given share of the input bus - then a report of the loop time
+ * distribution, sheds, output drops and alarm latency, to compare boards
+ * before a release. The configuration is put back at the end.
+ *
+ * Build Flags:
+ *   -D TEST_TRACE_LINE_MAX=n        - Longest trace line (default 256; 96 on AVR)
+ *   -D TEST_TRACE_MAX_COLUMNS=n     - Columns read per line (default 24; 8 on AVR)
+ *   -D TEST_TRACE_LINES_PER_PASS=n  - Lines read per loop pass while catching up (default 8)
+ *   -D TEST_TRACE_LATE_MS=n         - Applied later counts as late (default 50)
+ *   -D TEST_CERTIFY_SECONDS=n       - TEST CERTIFY run length (default 60)
+ *   -D TEST_CERTIFY_CAN_LOAD=n      - CAN bus load in percent (default 30)
+ *   -D TEST_CERTIFY_OUTPUT_MS=n     - Output interval during the run (default 10)
+ *   -D TEST_CERTIFY_STEP_MS=n       - Alarm step half period (default 1000)
+ *   -D TEST_CERTIFY_ANALOG_PINS=n   - A0.. pins the run may fill (default: the board's; 0 on ESP32)
+ *   -D TEST_CERTIFY_CAN_BURST=n     - Synthetic frames per loop pass at most (default 16 on AVR, 64 elsewhere)
+ *   -D TEST_CERTIFY_CAN_BACKLOG_MS=n - Frames owed longer are skipped, not sent late (default 100)
  */
 
 #ifndef TEST_MODE_H
@@ -18,6 +54,77 @@
 #include "../inputs/input.h"
 #include "../inputs/input_manager.h"  // For MAX_INPUTS
 
+#if defined(ENABLE_SD_LOGGING) || defined(ENABLE_JSON_CONFIG)
+  #define TEST_TRACE_HAS_SD 1
+#endif
+
+#ifndef TEST_TRACE_LINE_MAX
+  #if defined(__AVR__)
+    #define TEST_TRACE_LINE_MAX 96
+  #else
+    #define TEST_TRACE_LINE_MAX 256
+  #endif
+#endif
+
+#ifndef TEST_TRACE_MAX_COLUMNS
+  #if defined(__AVR__)
+    #define TEST_TRACE_MAX_COLUMNS 8
+  #else
+    #define TEST_TRACE_MAX_COLUMNS 24
+  #endif
+#endif
+
+#ifndef TEST_TRACE_LINES_PER_PASS
+#define TEST_TRACE_LINES_PER_PASS 8
+#endif
+
+#ifndef TEST_TRACE_LATE_MS
+#define TEST_TRACE_LATE_MS 50
+#endif
+
+#ifndef TEST_CERTIFY_SECONDS
+#define TEST_CERTIFY_SECONDS 60
+#endif
+
+#ifndef TEST_CERTIFY_CAN_LOAD
+#define TEST_CERTIFY_CAN_LOAD 30
+#endif
+
+#ifndef TEST_CERTIFY_OUTPUT_MS
+#define TEST_CERTIFY_OUTPUT_MS 10
+#endif
+
+#ifndef TEST_CERTIFY_STEP_MS
+#define TEST_CERTIFY_STEP_MS 1000
+#endif
+
+// A0 + n is an analog pin for n below this (ESP32 analog pins aren't a run)
+#ifndef TEST_CERTIFY_ANALOG_PINS
+  #if defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+    #define TEST_CERTIFY_ANALOG_PINS 16
+  #elif defined(ARDUINO_TEENSY41)
+    #define TEST_CERTIFY_ANALOG_PINS 18
+  #elif defined(ARDUINO_TEENSY40)
+    #define TEST_CERTIFY_ANALOG_PINS 14
+  #elif defined(ESP32)
+    #define TEST_CERTIFY_ANALOG_PINS 0
+  #else
+    #define TEST_CERTIFY_ANALOG_PINS PLATFORM_MAX_INPUTS
+  #endif
+#endif
+
+#ifndef TEST_CERTIFY_CAN_BURST
+  #if defined(__AVR__)
+    #define TEST_CERTIFY_CAN_BURST 16
+  #else
+    #define TEST_CERTIFY_CAN_BURST 64
+  #endif
+#endif
+
+#ifndef TEST_CERTIFY_CAN_BACKLOG_MS
+#define TEST_CERTIFY_CAN_BACKLOG_MS 100
+#endif
+
 // ===== TEST VALUE TYPES =====
 // Different ways to generate test values over time
 enum TestValueType {
@@ -42,6 +149,16 @@ struct InputTestConfig {
     bool forceNaN;              // Override valueType and force NaN
 };
 
+// ===== PER-INPUT GENERATOR STATE =====
+// Worked out from the config when the scenario starts (prepareTestValue())
+struct TestValueState {
+    uint8_t config;             // Index into the scenario's configs, 0xFF = not simulated
+    uint32_t phaseStep;         // 2^32 / period_ms - phase per ms, wraps once a period
+    float rampRate;             // 1 / period_ms
+    float walkValue;            // TEST_RANDOM position (NAN = not started)
+    uint32_t walkMs;            // TEST_RANDOM last step
+};
+
 // ===== TEST SCENARIO =====
 // A complete test scenario with multiple input configurations
 // Stored in PROGMEM to save RAM
@@ -58,8 +175,10 @@ struct TestModeState {
     bool isActive;                          // Is test mode currently running?
     const TestScenario* currentScenario;    // Pointer to current scenario (PROGMEM)
     uint8_t currentScenarioIndex;           // Index of current scenario
+    bool trace;                             // Values come from a trace file, not a scenario
     unsigned long scenarioStartTime;        // millis() when scenario started
     void (*originalReadFunctions[MAX_INPUTS])(Input*);  // Backup of original function pointers
+    TestValueState values[MAX_INPUTS];      // Generator state per input (scenarios)
 };
 
 // ===== PUBLIC API =====
@@ -71,6 +190,10 @@ void initTestMode();
 // Returns true if successful, false if invalid index
 bool startTestScenario(uint8_t scenarioIndex);
 
+// Play a CSV trace from SD at its recorded timing (see above)
+// Returns false (with the reason printed) if it can't start
+bool startTestTrace(const char* filename, bool loop);
+
 // Stop test mode and restore original sensor reading functions
 void stopTestMode();
 
@@ -81,6 +204,9 @@ bool isTestModeActive();
 // Checks for scenario completion, updates elapsed time, etc.
 void updateTestMode();
 
+// Scenario or trace progress (TEST STATUS)
+void printTestStatus();
+
 // List all available test scenarios to Serial
 void listTestScenarios();
 
@@ -90,4 +216,31 @@ uint8_t getNumTestScenarios();
 // Get name of a specific scenario
 const char* getTestScenarioName(uint8_t index);
 
+// ===== VALUE GENERATION (test_value_generator.cpp) =====
+
+// Precompute the generator state of one config
+void prepareTestValue(const InputTestConfig* config, TestValueState* state);
+
+// Value of config at elapsedMs into the scenario
+float generateTestValue(const InputTestConfig* config, TestValueState* state, unsigned long elapsedMs);
+
+// ===== TRACE PLAYBACK (test_trace.cpp) =====
+
+#ifdef TEST_TRACE_HAS_SD
+bool openTestTrace(const char* filename, bool loop);
+void closeTestTrace();
+float getTestTraceValue(uint8_t inputIndex);
+bool updateTestTrace(unsigned long elapsedMs);   // false at the end of the trace
+void printTestTraceStatus(unsigned long elapsedMs);
+#endif
+
+// ===== CERTIFICATION (test_certify.cpp) =====
+
+// Start the load run (stops a scenario or trace); false with the reason printed
+bool startTestCertify(uint32_t seconds, uint8_t canLoadPct);
+void stopTestCertify();              // Put the configuration back and print the report
+bool isTestCertifyActive();
+void updateTestCertify();            // Main loop, every pass
+void printTestCertifyStatus();       // Report so far (TEST STATUS)
+
 #endif // TEST_MODE_H
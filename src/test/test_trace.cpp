@@ -0,0 +1,292 @@
+/*
+ * test_trace.cpp - Recorded trace playback for test mode (TEST FILE)
+ *
+ * Plays a CSV trace from SD: a header naming a time column and one column
+ * per input short name, then one row per sample. Two rows are held in RAM -
+ * the one applied and the next one, read ahead from the file - so sensor
+ * reads never wait on the card. The loop reads at most
+ * TEST_TRACE_LINES_PER_PASS lines per pass, even while catching up.
+ */
+
+#include "../config.h"
+
+#ifdef ENABLE_TEST_MODE
+
+#include "test_mode.h"
+
+#ifdef TEST_TRACE_HAS_SD
+
+#include "../lib/message_api.h"
+#include "../lib/sd_manager.h"
+#include <SD.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define TRACE_COLUMN_IGNORED 0xFF
+#define TRACE_COLUMN_TIME    0xFE
+
+struct TraceState {
+    bool loop;
+    bool haveNext;              // next[] holds a row not yet due
+    bool haveTime0;             // time0Ms is the first row of this pass
+    uint8_t columns;            // Columns in the header (up to TEST_TRACE_MAX_COLUMNS)
+    uint8_t mapped;             // Columns that feed an input
+    uint8_t column[TEST_TRACE_MAX_COLUMNS];  // Input index, or TRACE_COLUMN_*
+    uint32_t time0Ms;           // Trace time of the first row of this pass
+    uint32_t lastMs;            // Trace time of the newest row read
+    uint32_t nextMs;            // Due time of next[], on the trace clock
+    uint32_t passStartMs;       // Elapsed test time this pass began
+    uint32_t rows;              // Rows applied
+    uint32_t late;              // Applied more than TEST_TRACE_LATE_MS after their time
+    uint32_t maxLateMs;
+    uint32_t bad;               // Rows without a time, or cut at TEST_TRACE_LINE_MAX
+    uint16_t passes;
+    float now[MAX_INPUTS];      // Applied row
+    float next[MAX_INPUTS];     // Read-ahead row
+    char line[TEST_TRACE_LINE_MAX];
+    bool lineTooLong;
+    char name[24];
+};
+
+static TraceState trace;
+static File traceFile;
+
+// Next line of the file into trace.line; false at the end
+static bool readTraceLine() {
+    uint16_t len = 0;
+    bool any = false;
+    trace.lineTooLong = false;
+    while (traceFile.available()) {
+        int c = traceFile.read();
+        any = true;
+        if (c == '\n') break;
+        if (c == '\r') continue;
+        if (len < sizeof(trace.line) - 1) {
+            trace.line[len++] = (char)c;
+        } else {
+            trace.lineTooLong = true;
+        }
+    }
+    trace.line[len] = '\0';
+    return any;
+}
+
+// Next comma-separated field of *p, NUL-terminated in place (nullptr at the end)
+static char* nextField(char** p) {
+    char* s = *p;
+    if (s == nullptr) return nullptr;
+    char* comma = strchr(s, ',');
+    if (comma) {
+        *comma = '\0';
+        *p = comma + 1;
+    } else {
+        *p = nullptr;
+    }
+    while (*s == ' ' || *s == '"') s++;
+    char* end = s + strlen(s);
+    while (end > s && (end[-1] == ' ' || end[-1] == '"')) *--end = '\0';
+    return s;
+}
+
+// Header: the time column and the input each other column feeds
+static bool parseHeader() {
+    char* p = trace.line;
+    char* field;
+    bool haveTime = false;
+    trace.columns = 0;
+    trace.mapped = 0;
+
+    while ((field = nextField(&p)) != nullptr && trace.columns < TEST_TRACE_MAX_COLUMNS) {
+        uint8_t* column = &trace.column[trace.columns++];
+        *column = TRACE_COLUMN_IGNORED;
+
+        char* units = strstr(field, " (");      // "CHT (C)" as sdlog_convert.py writes it
+        if (units) *units = '\0';
+
+        if (!haveTime && (strcasecmp(field, "Time") == 0 || strcasecmp(field, "time_ms") == 0)) {
+            *column = TRACE_COLUMN_TIME;
+            haveTime = true;
+            continue;
+        }
+        for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+            if (inputs[i].flags.isEnabled && strcasecmp(inputs[i].abbrName, field) == 0) {
+                *column = i;
+                trace.mapped++;
+                break;
+            }
+        }
+    }
+    return haveTime;
+}
+
+// Parse the next data row into next[]; false at the end of the file
+static bool readTraceRow() {
+    while (readTraceLine()) {
+        if (trace.line[0] == '\0' || trace.line[0] == '#') continue;
+        if (trace.lineTooLong) {
+            trace.bad++;
+            continue;
+        }
+
+        // Cells the row leaves out hold their value
+        memcpy(trace.next, trace.now, sizeof(trace.next));
+
+        char* p = trace.line;
+        char* field;
+        bool haveTime = false;
+        uint32_t timeMs = 0;
+        for (uint8_t c = 0; c < trace.columns && (field = nextField(&p)) != nullptr; c++) {
+            uint8_t column = trace.column[c];
+            if (column == TRACE_COLUMN_IGNORED) continue;
+
+            char* end;
+            double value = strtod(field, &end);
+            bool valid = end != field;
+            if (column == TRACE_COLUMN_TIME) {
+                haveTime = valid && value >= 0;
+                timeMs = haveTime ? (uint32_t)value : 0;
+            } else {
+                trace.next[column] = valid ? (float)value : NAN;  // Empty cell - no data
+            }
+        }
+        if (!haveTime) {
+            trace.bad++;
+            continue;
+        }
+
+        if (!trace.haveTime0) {
+            trace.time0Ms = timeMs;
+            trace.lastMs = timeMs;
+            trace.haveTime0 = true;
+        }
+        if (timeMs < trace.lastMs) timeMs = trace.lastMs;  // Going backwards - due at once
+        trace.lastMs = timeMs;
+        trace.nextMs = timeMs - trace.time0Ms;
+        trace.haveNext = true;
+        return true;
+    }
+    return false;
+}
+
+// Back to the first row for another pass
+static bool rewindTrace(unsigned long elapsedMs) {
+    traceFile.seek(0);
+    readTraceLine();                            // Header
+    trace.haveTime0 = false;
+    trace.passStartMs = elapsedMs;
+    trace.passes++;
+    return readTraceRow();
+}
+
+bool openTestTrace(const char* filename, bool loop) {
+    if (!isSDInitialized()) {
+        msg.control.println(F("ERROR: SD card not available"));
+        return false;
+    }
+    if (traceFile) traceFile.close();
+    memset(&trace, 0, sizeof(trace));
+
+    traceFile = SD.open(filename, FILE_READ);
+    if (!traceFile) {
+        msg.control.print(F("ERROR: Cannot open "));
+        msg.control.println(filename);
+        return false;
+    }
+    if (!readTraceLine() || trace.lineTooLong || !parseHeader()) {
+        msg.control.println(F("ERROR: First line must be a header with a Time (ms) column"));
+        traceFile.close();
+        return false;
+    }
+    if (trace.mapped == 0) {
+        msg.control.println(F("ERROR: No column matches the short name of an enabled input"));
+        traceFile.close();
+        return false;
+    }
+
+    for (uint8_t i = 0; i < MAX_INPUTS; i++) {
+        trace.now[i] = NAN;                     // Inputs the trace doesn't feed
+    }
+    if (!readTraceRow()) {
+        msg.control.println(F("ERROR: Trace has no rows"));
+        traceFile.close();
+        return false;
+    }
+
+    strncpy(trace.name, filename, sizeof(trace.name) - 1);
+    trace.loop = loop;
+    trace.passes = 1;
+
+    msg.control.println(F("========================================"));
+    msg.control.print(F("Playing trace "));
+    msg.control.println(trace.name);
+    msg.control.print(F("Inputs fed: "));
+    for (uint8_t c = 0, n = 0; c < trace.columns; c++) {
+        if (trace.column[c] >= MAX_INPUTS) continue;
+        if (n++) msg.control.print(F(", "));
+        msg.control.print(inputs[trace.column[c]].abbrName);
+    }
+    msg.control.println();
+    msg.control.print(F("Columns ignored: "));
+    msg.control.println(trace.columns - trace.mapped - 1);
+    msg.control.println(F("========================================"));
+    return true;
+}
+
+void closeTestTrace() {
+    if (traceFile) traceFile.close();
+    trace.haveNext = false;
+}
+
+float getTestTraceValue(uint8_t inputIndex) {
+    return inputIndex < MAX_INPUTS ? trace.now[inputIndex] : NAN;
+}
+
+bool updateTestTrace(unsigned long elapsedMs) {
+    for (uint8_t n = 0; n < TEST_TRACE_LINES_PER_PASS; n++) {
+        if (!trace.haveNext) {
+            if (!trace.loop || !rewindTrace(elapsedMs)) return false;
+        }
+
+        uint32_t clockMs = elapsedMs - trace.passStartMs;
+        if (trace.nextMs > clockMs) return true;  // Not due yet
+
+        uint32_t lateMs = clockMs - trace.nextMs;
+        if (lateMs > TEST_TRACE_LATE_MS) {
+            trace.late++;
+            if (lateMs > trace.maxLateMs) trace.maxLateMs = lateMs;
+        }
+        memcpy(trace.now, trace.next, sizeof(trace.now));
+        trace.rows++;
+        trace.haveNext = false;
+        readTraceRow();                         // Read ahead for the next pass
+    }
+    return true;
+}
+
+void printTestTraceStatus(unsigned long elapsedMs) {
+    msg.control.print(F("  Trace: "));
+    msg.control.print(trace.name);
+    msg.control.print(F(", "));
+    msg.control.print(trace.mapped);
+    msg.control.print(F(" inputs"));
+    if (trace.loop) {
+        msg.control.print(F(", pass "));
+        msg.control.print(trace.passes);
+    }
+    msg.control.println();
+    msg.control.print(F("  Rows: "));
+    msg.control.print(trace.rows);
+    msg.control.print(F(" in "));
+    msg.control.print(elapsedMs / 1000.0f, 1);
+    msg.control.print(F(" s, "));
+    msg.control.print(trace.late);
+    msg.control.print(F(" late (max "));
+    msg.control.print(trace.maxLateMs);
+    msg.control.print(F(" ms), "));
+    msg.control.print(trace.bad);
+    msg.control.println(F(" bad"));
+}
+
+#endif // TEST_TRACE_HAS_SD
+
+#endif // ENABLE_TEST_MODE
@@ -8,6 +8,11 @@
  * - Square waves
  * - Random walks
  * - NaN (sensor faults)
+ *
+ * Waves use a 32-bit phase (elapsed ms x a step worked out once per
+ * scenario) and a quarter-sine table, so a read is a multiply and a table
+ * lookup rather than sin() and a division - cheap enough on AVR not to
+ * skew the loop timing test mode is used to look at.
  */
 
 #include "../config.h"
@@ -17,9 +22,49 @@
 #include "test_mode.h"
 #include <Arduino.h>
 
+// ===== WAVETABLE =====
+
+// sin(i * 90 / 64 degrees) in Q15 - the other three quarters are mirrored
+static const int16_t SINE_QUARTER[65] PROGMEM = {
+    0, 804, 1608, 2410, 3212, 4011, 4808, 5602,
+    6393, 7179, 7962, 8739, 9512, 10278, 11039, 11793,
+    12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+    18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+    23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+    27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+    30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+    32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+    32767
+};
+
+// Sine of a full-circle 32-bit phase, Q15, interpolated between table steps
+static int16_t sineQ15(uint32_t phase) {
+    uint8_t quadrant = phase >> 30;
+    uint16_t q = (phase >> 16) & 0x3FFF;        // Position in the quarter, 14 bits
+    if (quadrant & 1) q = 0x4000 - q;           // Falling quarters run the table backwards
+    uint8_t i = q >> 8;
+    int16_t a = (int16_t)pgm_read_word(&SINE_QUARTER[i]);
+    int16_t b = i < 64 ? (int16_t)pgm_read_word(&SINE_QUARTER[i + 1]) : a;
+    int16_t s = a + (int16_t)(((int32_t)(b - a) * (q & 0xFF)) >> 8);
+    return (quadrant & 2) ? -s : s;
+}
+
 // ===== VALUE GENERATION FUNCTIONS =====
 
-float generateTestValue(const InputTestConfig* config, unsigned long elapsedMs) {
+void prepareTestValue(const InputTestConfig* config, TestValueState* state) {
+    if (config->period_ms >= 1.0f) {
+        float step = 4294967296.0f / config->period_ms;
+        state->phaseStep = step >= 4294967295.0f ? 0xFFFFFFFFUL : (uint32_t)step;
+        state->rampRate = 1.0f / config->period_ms;
+    } else {
+        state->phaseStep = 0;
+        state->rampRate = 0;
+    }
+    state->walkValue = NAN;
+    state->walkMs = 0;
+}
+
+float generateTestValue(const InputTestConfig* config, TestValueState* state, unsigned long elapsedMs) {
     switch (config->valueType) {
         case TEST_STATIC: {
             // Constant value
@@ -28,11 +73,11 @@ float generateTestValue(const InputTestConfig* config, unsigned long elapsedMs)
 
         case TEST_RAMP_UP: {
             // Linear increase from value1 to value2 over period_ms
-            if (config->period_ms == 0) {
+            if (state->rampRate == 0) {
                 return config->value2;  // Instant
             }
 
-            float progress = (float)elapsedMs / config->period_ms;
+            float progress = elapsedMs * state->rampRate;
             if (progress > 1.0f) {
                 progress = 1.0f;  // Clamp at end value
             }
@@ -42,11 +87,11 @@ float generateTestValue(const InputTestConfig* config, unsigned long elapsedMs)
 
         case TEST_RAMP_DOWN: {
             // Linear decrease from value2 to value1 over period_ms
-            if (config->period_ms == 0) {
+            if (state->rampRate == 0) {
                 return config->value1;  // Instant
             }
 
-            float progress = (float)elapsedMs / config->period_ms;
+            float progress = elapsedMs * state->rampRate;
             if (progress > 1.0f) {
                 progress = 1.0f;  // Clamp at end value
             }
@@ -56,43 +101,37 @@ float generateTestValue(const InputTestConfig* config, unsigned long elapsedMs)
 
         case TEST_SINE_WAVE: {
             // Sinusoidal oscillation between value1 and value2
-            if (config->period_ms == 0) {
-                return (config->value1 + config->value2) / 2.0f;  // Midpoint
+            float midpoint = (config->value1 + config->value2) * 0.5f;
+            if (state->phaseStep == 0) {
+                return midpoint;
             }
 
-            // Calculate phase (0.0 to 1.0) within current period
-            unsigned long periodTime = (unsigned long)config->period_ms;
-            float phase = (float)(elapsedMs % periodTime) / periodTime;
+            // The 32-bit phase wraps once per period - no modulo needed
+            uint32_t phase = (uint32_t)elapsedMs * state->phaseStep;
+            float amplitude = (config->value2 - config->value1) * 0.5f;
 
-            // Calculate sine wave
-            float amplitude = (config->value2 - config->value1) / 2.0f;
-            float midpoint = (config->value1 + config->value2) / 2.0f;
-
-            return midpoint + amplitude * sin(2.0f * PI * phase);
+            return midpoint + amplitude * (sineQ15(phase) * (1.0f / 32767.0f));
         }
 
         case TEST_SQUARE_WAVE: {
             // Square wave alternating between value1 and value2
-            if (config->period_ms == 0) {
+            if (state->phaseStep == 0) {
                 return config->value1;  // Default to low value
             }
 
-            // Calculate phase (0.0 to 1.0) within current period
-            unsigned long periodTime = (unsigned long)config->period_ms;
-            float phase = (float)(elapsedMs % periodTime) / periodTime;
-
             // First half of period = value1, second half = value2
-            return (phase < 0.5f) ? config->value1 : config->value2;
+            uint32_t phase = (uint32_t)elapsedMs * state->phaseStep;
+            return (phase < 0x80000000UL) ? config->value1 : config->value2;
         }
 
         case TEST_RANDOM: {
             // Random walk within bounds [value1, value2]
-            // Use a pseudo-random walk that changes gradually
-            static float lastValue = -999.0f;  // Sentinel value
-            static unsigned long lastUpdateTime = 0;
+            // Use a pseudo-random walk that changes gradually (one per input)
+            float& lastValue = state->walkValue;
+            uint32_t& lastUpdateTime = state->walkMs;
 
             // Initialize on first call or if too much time has passed
-            if (lastValue == -999.0f || (elapsedMs - lastUpdateTime) > 10000) {
+            if (isnan(lastValue) || (elapsedMs - lastUpdateTime) > 10000) {
                 lastValue = (config->value1 + config->value2) / 2.0f;
                 lastUpdateTime = elapsedMs;
             }
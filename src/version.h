@@ -44,8 +44,14 @@
 // Increment when Input struct layout changes (forces reconfiguration)
 // Version 2: Changed from storing enum indices to storing name hashes (Phase 5)
 // Version 3: Added per-input output routing mask (outputMask)
+// Version 4: Added per-input filter stage (filterType, filterParam)
+// Version 5: Added per-input adaptive read rate (rateMaxInterval, rateBand)
+// Version 6: Added bit-packed CAN signal fields (bit_offset, bit_length)
+// Version 7: Added per-input trend alarm (trendRate, trendWindow)
+// Version 8: Added warning thresholds, hysteresis and persist/clear times
+// Version 9: CRC-32 in the header (and alarm rules) in place of the XOR checksum
 // =============================================================================
-#define EEPROM_VERSION 3
+#define EEPROM_VERSION 9
 
 // =============================================================================
 // Helper functions (defined in version.cpp)
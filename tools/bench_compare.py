@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+"""
+preOBD Benchmark Compare
+
+Compares two SYSTEM BENCHMARK CSV captures (firmware built with
+-D ENABLE_BENCHMARK) - a baseline, typically the last release, and a new
+build - kernel by kernel:
+
+  kernel                case          base ns   new ns   change
+  interpolate           24pt desc       212.4    198.1    -6.7%
+  can_cache             miss 90%         96.0    131.5   +37.0%  SLOWER
+
+Rows are matched on (platform, kernel, case), so captures of several
+boards can be concatenated into one file. Lines that are not benchmark
+rows (the prompt, log messages) are skipped, so a raw serial log works
+as well. Cycles are compared where both captures have them (ns on the
+host simulator). --threshold sets how much slower counts as a
+regression; with any regression the exit status is 1, for CI.
+"""
+
+import argparse
+import csv
+import sys
+
+HEADER = ["version", "platform", "kernel", "case", "iterations", "inputs",
+          "cycles_per_call", "ns_per_call"]
+
+
+def read_capture(path):
+    """(platform, kernel, case) -> row dict, and the firmware versions seen."""
+    rows = {}
+    versions = set()
+    with open(path, newline="", encoding="utf-8", errors="replace") as f:
+        for fields in csv.reader(f):
+            if len(fields) != len(HEADER) or fields == HEADER:
+                continue
+            row = dict(zip(HEADER, fields))
+            try:
+                row["ns_per_call"] = float(row["ns_per_call"])
+            except ValueError:
+                continue
+            row["cycles_per_call"] = float(row["cycles_per_call"]) if row["cycles_per_call"] else None
+            rows[(row["platform"], row["kernel"], row["case"])] = row
+            versions.add(row["version"])
+    return rows, versions
+
+
+def main():
+    """Main execution function."""
+    parser = argparse.ArgumentParser(description="Compare two SYSTEM BENCHMARK CSV captures")
+    parser.add_argument("baseline", help="CSV capture of the reference build")
+    parser.add_argument("new", help="CSV capture of the build under test")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="Percent slower that counts as a regression (default 10)")
+    parser.add_argument("--ns", action="store_true",
+                        help="Compare ns per call even where both captures have cycles")
+    args = parser.parse_args()
+
+    base, base_versions = read_capture(args.baseline)
+    new, new_versions = read_capture(args.new)
+    if not base or not new:
+        print("error: no benchmark rows in %s" % (args.baseline if not base else args.new), file=sys.stderr)
+        return 2
+
+    print("baseline: %s" % ", ".join(sorted(base_versions)))
+    print("new:      %s" % ", ".join(sorted(new_versions)))
+
+    regressions = 0
+    platform = None
+    for key in sorted(new, key=lambda k: k[0]):   # Stable: capture order within a platform
+        if key not in base:
+            continue
+        b, n = base[key], new[key]
+        use_cycles = not args.ns and b["cycles_per_call"] is not None and n["cycles_per_call"] is not None
+        unit = "cycles" if use_cycles else "ns"
+        before = b["cycles_per_call"] if use_cycles else b["ns_per_call"]
+        after = n["cycles_per_call"] if use_cycles else n["ns_per_call"]
+
+        if key[0] != platform:
+            platform = key[0]
+            print()
+            print("[%s]" % platform)
+            print("%-22s %-14s %12s %12s %8s" % ("kernel", "case", "base " + unit, "new " + unit, "change"))
+
+        change = (after - before) / before * 100 if before > 0 else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  SLOWER"
+            regressions += 1
+        elif change < -args.threshold:
+            flag = "  faster"
+        print("%-22s %-14s %12.1f %12.1f %+7.1f%%%s" % (key[1], key[2], before, after, change, flag))
+
+    missing = sorted(set(base) - set(new))
+    added = sorted(set(new) - set(base))
+    if missing:
+        print("\nNot in the new capture: %s" % ", ".join("%s/%s" % (k[1], k[2]) for k in missing))
+    if added:
+        print("\nNew kernels (no baseline): %s" % ", ".join("%s/%s" % (k[1], k[2]) for k in added))
+
+    print("\n%d regression(s) over %.0f%%" % (regressions, args.threshold))
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
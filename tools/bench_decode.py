@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+"""
+preOBD Bench Stream Decoder
+
+Reads the bench stream (BENCH START, firmware built with
+-D ENABLE_BENCH_STREAM) live from a serial port, or from a capture file,
+and writes the raw ADC samples as CSV, one row per sample:
+
+  us,CLT (counts),OILP (counts),...
+  12345000,2011,873,...
+
+With --values the computed input values sent with each block go to a
+second CSV - the sensor pipeline's output next to the raw counts it came
+from:
+
+  us,CLT (C),OILP (bar),...
+  12365000,88.42,3.07,...
+
+Samples lost to a full ring on the device, and lost or damaged frames, are
+counted and reported on exit (and as they happen with --verbose). A new
+header row is printed whenever the stream is restarted with other
+channels. The frame format is shared with serial_decode.py and
+sdlog_convert.py.
+
+Ports need pyserial (pip install pyserial).
+"""
+
+import argparse
+import csv
+import math
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from sdlog_convert import StreamDecoder  # noqa: E402
+from serial_decode import open_source   # noqa: E402
+
+
+def sample_columns(bench):
+    """Column names of the sample CSV - each pin named by the input reading it."""
+    names = {i.pin: i.name for i in bench.inputs}
+    return ["us"] + [f"{names.get(pin, f'pin{pin}')} (counts)" for pin in bench.pins]
+
+
+def value_columns(bench):
+    return ["us"] + [f"{i.name} ({i.units})" if i.units else i.name for i in bench.inputs]
+
+
+def main():
+    """Main execution function."""
+    parser = argparse.ArgumentParser(
+        description="Decode the preOBD bench stream (raw ADC samples) to CSV")
+    parser.add_argument("source", help="Serial port (e.g. /dev/ttyACM0, COM3), capture file, or - for stdin")
+    parser.add_argument("-b", "--baud", type=int, default=115200,
+                        help="Port baud rate (default 115200; ignored for USB serial)")
+    parser.add_argument("-o", "--output", help="Sample CSV file (default: stdout)")
+    parser.add_argument("--values", help="Also write the computed input values to this CSV file")
+    parser.add_argument("--save", help="Also write the raw bytes to this capture file")
+    parser.add_argument("--decimals", type=int, default=3,
+                        help="Decimal places of computed values (default 3)")
+    parser.add_argument("-v", "--verbose", action="store_true",
+                        help="Report lost samples and frames as they happen")
+    args = parser.parse_args()
+
+    try:
+        source = open_source(args.source, args.baud)
+    except OSError as e:
+        print(f"Error: {args.source}: {e}", file=sys.stderr)
+        return 1
+    out = open(args.output, "w", newline="") if args.output else sys.stdout
+    values_out = open(args.values, "w", newline="") if args.values else None
+    save = open(args.save, "wb") if args.save else None
+    writer = csv.writer(out)
+    values_writer = csv.writer(values_out) if values_out else None
+
+    stream = StreamDecoder()
+    bench = None
+    samples = 0
+    lost = 0
+    reported = (0, 0, 0)
+    try:
+        while True:
+            chunk = source.read1(4096) if hasattr(source, "read1") else source.read(4096)
+            if not chunk:
+                if os.path.isfile(args.source) or args.source == "-":
+                    break       # End of the capture
+                continue        # Port timeout - keep waiting
+            if save:
+                save.write(chunk)
+
+            for item in stream.feed(chunk):
+                if item[0] == "bench":
+                    if bench is None or (item[1].pins, item[1].inputs) != (bench.pins, bench.inputs):
+                        writer.writerow(sample_columns(item[1]))
+                        if values_writer:
+                            values_writer.writerow(value_columns(item[1]))
+                    bench = item[1]
+                    continue
+                if item[0] != "block":
+                    continue    # Serial output frames - tools/serial_decode.py
+                _, block_lost, block, values = item
+                lost += block_lost
+                writer.writerows(block)
+                samples += len(block)
+                if values_writer and block:
+                    values_writer.writerow([block[-1][0]] + ["" if math.isnan(v) else f"{v:.{args.decimals}f}"
+                                                             for v in values])
+            out.flush()
+
+            if args.verbose and (lost, stream.lost, stream.damaged) != reported:
+                reported = (lost, stream.lost, stream.damaged)
+                print(f"{lost} samples lost, {stream.lost} frames lost, {stream.damaged} damaged",
+                      file=sys.stderr)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if save:
+            save.close()
+        if values_out:
+            values_out.close()
+        if args.output:
+            out.close()
+
+    rate = f" at {bench.rate} Hz" if bench else ""
+    print(f"{samples} samples{rate}, {lost} lost on the device, "
+          f"{stream.lost} frames lost, {stream.damaged} damaged", file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""
+preOBD CAN Log Replay
+
+Streams a recorded CAN log - candump (-l or default format) or Vector ASC -
+to the firmware's CAN input over the serial console (firmware built with
+-D ENABLE_CAN_REPLAY), at the recorded timing or faster:
+
+  python3 tools/can_replay.py /dev/ttyACM0 drive.log
+  python3 tools/can_replay.py /dev/ttyACM0 drive.asc --speed 4
+  python3 tools/can_replay.py /dev/ttyACM0 drive.log --speed max --tx CAN2
+
+It sends SCAN REPLAY STREAM, then the log one line at a time - the host
+sets the pace, so a log of any length replays without an SD card - then
+END, and prints the firmware's summary: frames, the receive handlers'
+drops and the frame cache counters. Lines are sent unchanged; the firmware
+parses and skips headers, comments, error and remote frames itself.
+
+At SPEED MAX the lines go out as fast as the port takes them, which over
+USB is well past any real bus. For replays at the firmware's own timing
+from SD, use SCAN REPLAY <file> on the console instead.
+
+Needs pyserial (pip install pyserial).
+"""
+
+import argparse
+import re
+import sys
+import time
+
+# (1436509052.249713) can0 ...   or   0.012345 1 ...
+TIMESTAMP = re.compile(r"^\s*(?:\((\d+\.\d+)\)|(\d+\.\d+)\s)")
+
+
+def line_time(line):
+    """Seconds from the line's timestamp, or None."""
+    m = TIMESTAMP.match(line)
+    if not m:
+        return None
+    return float(m.group(1) or m.group(2))
+
+
+def read_summary(port, timeout):
+    """Print the firmware's output until it goes quiet."""
+    deadline = time.monotonic() + timeout
+    quiet_since = None
+    while time.monotonic() < deadline:
+        data = port.read(4096)
+        if data:
+            sys.stdout.write(data.decode("utf-8", errors="replace"))
+            sys.stdout.flush()
+            quiet_since = None
+        elif quiet_since is None:
+            quiet_since = time.monotonic()
+        elif time.monotonic() - quiet_since > 0.5:
+            break
+
+
+def main():
+    """Main execution function."""
+    parser = argparse.ArgumentParser(description="Replay a candump/ASC CAN log into preOBD over serial")
+    parser.add_argument("port", help="Serial port (e.g. /dev/ttyACM0, COM3)")
+    parser.add_argument("log", help="candump or Vector ASC log file")
+    parser.add_argument("-b", "--baud", type=int, default=115200,
+                        help="Port baud rate (default 115200; ignored for USB serial)")
+    parser.add_argument("--speed", default="1",
+                        help="Times the recorded rate (e.g. 0.5, 4), or max (default 1)")
+    parser.add_argument("--tx", choices=["CAN1", "CAN2", "CAN3"],
+                        help="Transmit the frames on this bus instead of injecting them")
+    args = parser.parse_args()
+
+    if args.speed.lower() == "max":
+        speed = None
+    else:
+        try:
+            speed = float(args.speed)
+        except ValueError:
+            speed = -1
+        if speed <= 0:
+            print(f"Error: --speed must be a positive number or max, not '{args.speed}'", file=sys.stderr)
+            return 1
+
+    try:
+        import serial
+    except ImportError:
+        print("Error: needs pyserial (pip install pyserial)", file=sys.stderr)
+        return 1
+
+    try:
+        log = open(args.log, encoding="utf-8", errors="replace")
+    except OSError as e:
+        print(f"Error: {args.log}: {e}", file=sys.stderr)
+        return 1
+    try:
+        port = serial.Serial(args.port, args.baud, timeout=0.1)
+    except (OSError, serial.SerialException) as e:
+        print(f"Error: {args.port}: {e}", file=sys.stderr)
+        return 1
+
+    command = "SCAN REPLAY STREAM" + (f" TX {args.tx}" if args.tx else "")
+    port.reset_input_buffer()
+    port.write((command + "\n").encode())
+    reply = b""
+    deadline = time.monotonic() + 2.0
+    while b"Streaming" not in reply and b"ERROR" not in reply and time.monotonic() < deadline:
+        reply += port.read(256)
+    if b"Streaming" not in reply:
+        sys.stdout.write(reply.decode("utf-8", errors="replace"))
+        print("Error: the firmware did not start streaming (RUN mode, -D ENABLE_CAN_REPLAY?)",
+              file=sys.stderr)
+        return 1
+
+    sent = 0
+    start = time.monotonic()
+    first = None
+    try:
+        for line in log:
+            line = line.rstrip("\r\n")
+            if not line.strip():
+                continue
+            t = line_time(line)
+            if speed is not None and t is not None:
+                if first is None:
+                    first = t
+                due = start + (t - first) / speed
+                wait = due - time.monotonic()
+                if wait > 0:
+                    time.sleep(wait)
+            port.write((line + "\n").encode())
+            sent += 1
+            if port.in_waiting:
+                port.read(port.in_waiting)  # Keep the firmware's output from backing up
+    except KeyboardInterrupt:
+        print("\nInterrupted", file=sys.stderr)
+    finally:
+        port.write(b"\nEND\n")
+
+    elapsed = time.monotonic() - start
+    print(f"{sent} lines sent in {elapsed:.1f} s", file=sys.stderr)
+    read_summary(port, 5.0)
+    port.close()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -14,6 +14,7 @@ import json
 import os
 import sys
 import time
+import zlib
 from typing import List, Dict, Any, Optional
 
 # Ensure the script can find the preobd_config package
@@ -35,7 +36,17 @@ from preobd_config.config_generator import (
     generate_thin_library_files,
     generate_static_calibrations_file,
     write_static_calibrations_file,
+    generate_static_read_pipeline_file,
+    generate_static_manifest_file,
+    MANIFEST_OUTPUTS,
 )
+from preobd_config.config_blob import (
+    build_config_blob,
+    blob_import_lines,
+    build_config_patch,
+    parse_config_blob,
+)
+from preobd_config.device_link import DeviceLink, DeviceError
 
 TOOL_VERSION = "1.0.0"
 
@@ -74,7 +85,7 @@ def prompt_for_pin(platform: str, used_pins: List[str], default: str = "", senso
         if sensor_pin_requirement == 'PIN_I2C':
             prompt = f"Pin (use 'I2C' for I2C sensors) [{default}]: " if default else "Pin (use 'I2C' for I2C sensors): "
         else:
-            prompt = f"Pin (e.g., A0, 6) [{default}]: " if default else "Pin (e.g., A0, 6): "
+            prompt = f"Pin (e.g., A0, 6, ADC:0) [{default}]: " if default else "Pin (e.g., A0, 6, ADC:0): "
 
         pin_str = input(prompt).strip().upper() or default
         if not pin_str: continue
@@ -254,16 +265,139 @@ def edit_input(inp: Dict[str, Any], platform: str, used_pins: List[str], registr
 
     return inp
 
+def convert_to_blob(json_path: str, out_path: Optional[str]) -> int:
+    """Writes a runtime JSON config as a binary blob.
+
+    With out_path the blob goes to a file (LOAD SD:name.bin); otherwise the
+    IMPORT lines to paste into the serial console are printed.
+    """
+    try:
+        with open(json_path, 'r') as f:
+            config = json.load(f)
+        blob = build_config_blob(config)
+    except (OSError, ValueError) as e:
+        print(f"Error: {e}", file=sys.stderr)
+        return 1
+
+    if out_path:
+        with open(out_path, 'wb') as f:
+            f.write(blob)
+        print(f"Wrote {len(blob)} bytes to {out_path} (JSON: {os.path.getsize(json_path)} bytes)")
+    else:
+        print("\n".join(blob_import_lines(blob)))
+    return 0
+
+def sync_to_device(json_path: str, port: str, baud: int, save: bool, dry_run: bool) -> int:
+    """Brings a live device's config to a runtime JSON config, sending only what differs.
+
+    The device's blob is fetched (or taken from the cache when its CONFIG HASH
+    is one fetched before), diffed with the JSON, and the difference sent as a
+    patch blob inside BEGIN ... COMMIT. Untouched inputs and settings are not
+    re-imported, and SAVE then writes only the changed EEPROM bytes.
+    """
+    try:
+        with open(json_path, 'r') as f:
+            target = json.load(f)
+    except (OSError, ValueError) as e:
+        print(f"Error: {e}", file=sys.stderr)
+        return 1
+
+    cache_dir = os.path.join(os.path.expanduser("~"), ".cache", "preobd", "blobs")
+    link = None
+    try:
+        link = DeviceLink(port, baud)
+        was_running = link.enter_config()
+        base_hash, size = link.config_hash()
+        cached = os.path.join(cache_dir, f"{base_hash:08x}.bin")
+        if os.path.isfile(cached):
+            with open(cached, 'rb') as f:
+                blob = f.read()
+            print(f"Device config {base_hash:08x} ({size} bytes) - cached")
+        else:
+            start = time.monotonic()
+            blob = link.fetch_blob()
+            if zlib.crc32(blob) & 0xFFFFFFFF != base_hash:
+                raise DeviceError("fetched blob doesn't match CONFIG HASH - config changed meanwhile?")
+            os.makedirs(cache_dir, exist_ok=True)
+            with open(cached, 'wb') as f:
+                f.write(blob)
+            print(f"Device config {base_hash:08x} ({size} bytes) - fetched in {time.monotonic() - start:.1f} s")
+
+        patch, changes = build_config_patch(base_hash, parse_config_blob(blob), target)
+        if patch is None:
+            print("Device already matches - nothing sent")
+        else:
+            for change in changes:
+                print(f"  {change}")
+            lines = blob_import_lines(patch)
+            if dry_run:
+                print("\n".join(["BEGIN"] + lines + ["COMMIT"]))
+            else:
+                start = time.monotonic()
+                staged = True
+                try:
+                    link.checked("BEGIN")
+                except DeviceError:
+                    staged = False      # No transactions on this platform - applied as it goes
+                    print("  (no config transactions on this device - patch applied directly)")
+                try:
+                    for line in lines:
+                        link.checked(line)
+                except DeviceError:
+                    if staged:
+                        link.command("ROLLBACK")
+                    raise
+                if staged:
+                    link.checked("COMMIT")
+                print(f"{len(changes)} changes in {len(patch)} bytes, applied in {time.monotonic() - start:.1f} s")
+                if save:
+                    link.checked("SAVE")
+                    print("Saved")
+                new_hash, _ = link.config_hash()
+                print(f"Device config now {new_hash:08x}")
+        if was_running:
+            link.checked("RUN")
+        return 0
+    except (OSError, ValueError, DeviceError) as e:
+        print(f"Error: {e}", file=sys.stderr)
+        return 1
+    finally:
+        if link:
+            link.close()
+
 def main():
     parser = argparse.ArgumentParser(description="preOBD Static Configuration Tool")
     parser.add_argument("--load", metavar="FILE", help="Load configuration from a JSON file for editing.")
     parser.add_argument("--project-dir", default=".", help="Path to the preOBD project root directory.")
     parser.add_argument("--generate-thin-libs", action="store_true", help="Generate thinned sensor and application libraries.")
+    parser.add_argument("--outputs", metavar="LIST",
+                        help="With --generate-thin-libs: data outputs to build, e.g. CAN,SERIAL (saved in the JSON; default all).")
     parser.add_argument("--platform", help="Specify the target platform (e.g., uno, megaatmega2560). Overrides auto-detection.")
+    parser.add_argument("--blob", metavar="JSON", help="Convert a runtime JSON config to a binary blob (IMPORT lines) and exit.")
+    parser.add_argument("--blob-out", metavar="FILE", help="With --blob: write the blob to FILE (e.g. mycar.bin) instead.")
+    parser.add_argument("--sync", metavar="JSON", help="Bring the device on --port to a runtime JSON config, sending only the changes, and exit.")
+    parser.add_argument("--port", help="With --sync: the device's serial port (e.g. /dev/ttyACM0, COM3).")
+    parser.add_argument("--baud", type=int, default=115200, help="With --sync: port baud rate (default 115200; ignored for USB serial).")
+    parser.add_argument("--save", action="store_true", help="With --sync: SAVE to EEPROM after the changes are committed.")
+    parser.add_argument("--dry-run", action="store_true", help="With --sync: list the changes and the lines, send nothing.")
     args = parser.parse_args()
 
+    if args.blob:
+        sys.exit(convert_to_blob(args.blob, args.blob_out))
+    if args.sync:
+        if not args.port:
+            parser.error("--sync needs --port")
+        sys.exit(sync_to_device(args.sync, args.port, args.baud, args.save, args.dry_run))
+
     print_header()
 
+    if args.outputs is not None:
+        requested = [name.strip().upper() for name in args.outputs.split(",") if name.strip()]
+        unknown = [name for name in requested if name.upper() not in MANIFEST_OUTPUTS]
+        if unknown:
+            print(f"Error: Unknown output(s) {', '.join(unknown)} (use CAN, REALDASH, SERIAL, SD, MQTT)", file=sys.stderr)
+            sys.exit(1)
+
     registries = load_registries(args.project_dir)
     if not registries: sys.exit(1)
 
@@ -274,6 +408,8 @@ def main():
     inputs: List[Dict[str, Any]] = []
     should_add_new = True
     original_timestamp = None  # Track original timestamp to preserve it if no changes made
+    outputs: Optional[List[str]] = None  # Data outputs to build (None = all)
+    config_modified = False
 
     if args.load:
         should_add_new = False
@@ -283,6 +419,7 @@ def main():
 
             # Preserve the original timestamp
             original_timestamp = config_data.get("metadata", {}).get("timestamp")
+            outputs = config_data.get("outputs")
 
             # Validate unified v1 schema
             if config_data.get("schemaVersion") != 1:
@@ -311,8 +448,8 @@ def main():
             inputs = convert_from_unified_format(config_data.get("inputs", []))
             print(f"Loaded {len(inputs)} inputs from {args.load}")
 
-            # Track if user makes any changes
-            config_modified = False
+            # Track if user makes any changes (a new --outputs list is one)
+            config_modified = args.outputs is not None and outputs != requested
 
             while True:
                 print("\nCurrent configuration:")
@@ -381,6 +518,9 @@ def main():
     for i, inp in enumerate(inputs):
         inp['input_number'] = i
 
+    if args.outputs is not None:
+        outputs = requested
+
     save_path = None
 
     # Determine if we should save
@@ -413,6 +553,8 @@ def main():
                 },
                 "inputs": convert_to_unified_format(inputs)
             }
+            if outputs is not None:
+                unified_config["outputs"] = outputs
             json.dump(unified_config, f, indent=2)
         print(f"\u2713 Saved to {save_path}")
 
@@ -443,12 +585,43 @@ def main():
             os.remove(static_cal_path)
             print("\u2713 Removed static_calibrations.h (no custom calibrations)")
 
+    # Generate static_read_pipeline.h (direct-call sensor reads for updateSensors)
+    pipeline_content = generate_static_read_pipeline_file(inputs, registries['sensors'], TOOL_VERSION)
+    pipeline_path = os.path.join(args.project_dir, 'src', 'lib', 'generated', 'static_read_pipeline.h')
+
+    if pipeline_content:
+        print("\nGenerating static_read_pipeline.h...")
+        if write_static_calibrations_file(pipeline_path, pipeline_content):
+            print(f"\u2713 File: {pipeline_path}")
+        else:
+            print(f"\u2717 Failed to write {pipeline_path}", file=sys.stderr)
+    elif os.path.exists(pipeline_path):
+        os.remove(pipeline_path)
+        print("\u2713 Removed static_read_pipeline.h (no readable inputs)")
+
+    manifest_path = os.path.join(args.project_dir, 'src', 'lib', 'generated', 'static_manifest.h')
     if args.generate_thin_libs:
         print("\nGenerating thin libraries...")
         output_dir = os.path.join(args.project_dir, 'src', 'lib', 'generated')
         generate_thin_library_files(inputs, registries['sensors'], registries['applications'], output_dir, args.project_dir)
         print(f"\u2713 Generated thin libraries in {output_dir}")
 
+        # Feature manifest: what the build leaves out (needs the thin libraries)
+        manifest_content = generate_static_manifest_file(inputs, registries['sensors'], args.project_dir,
+                                                         outputs, TOOL_VERSION)
+        if write_static_calibrations_file(manifest_path, manifest_content):
+            sensor_files = manifest_content.count("// inputs/sensors/")
+            cal_files = manifest_content.count("// lib/sensor_calibration_data/")
+            skipped_outputs = manifest_content.count("#define STATIC_SKIP_OUTPUT_")
+            print(f"\u2713 Manifest leaves out {sensor_files} sensor files, {cal_files} calibration files, "
+                  f"{skipped_outputs} outputs")
+            print(f"\u2713 File: {manifest_path}")
+        else:
+            print(f"\u2717 Failed to write {manifest_path}", file=sys.stderr)
+    elif os.path.exists(manifest_path):
+        os.remove(manifest_path)
+        print("\u2713 Removed static_manifest.h (needs --generate-thin-libs)")
+
     print(f"\nReady to compile: pio run -e {platform}")
 
 if __name__ == "__main__":
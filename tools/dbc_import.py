@@ -0,0 +1,206 @@
+#!/usr/bin/env python3
+"""
+preOBD DBC Import Tool
+
+Converts the signals of a DBC file into the serial commands that configure
+them as CAN-imported inputs, so a vehicle's broadcast frames can be set up in
+one paste instead of per-input by hand.
+
+Each message becomes one whole-frame import (SET CAN FRAME) per signal, all
+sharing that frame's cache slot and subscription on the device; each signal
+is placed with SET <pin> CAN_SIGNAL using the DBC start bit, length, byte
+order, factor and offset.
+
+Not converted (reported on stderr):
+  - Extended (29-bit) message IDs - CAN inputs match standard IDs
+  - Multiplexed signals
+  - Signals longer than 32 bits or extending past their message's DLC
+Signed signals are imported as unsigned raw values (with a warning).
+"""
+
+import argparse
+import re
+import sys
+from typing import Dict, List, Optional
+
+# BO_ <id> <name>: <dlc> <transmitter>
+MESSAGE_RE = re.compile(r'^BO_\s+(\d+)\s+(\w+)\s*:\s*(\d+)\s+(\w+)')
+
+# SG_ <name> [M|m<n>] : <start>|<len>@<order><sign> (<factor>,<offset>) [<min>|<max>] "<unit>" <receivers>
+SIGNAL_RE = re.compile(
+    r'^SG_\s+(\w+)\s*(M|m\d+)?\s*:\s*(\d+)\|(\d+)@([01])([+-])\s*'
+    r'\(\s*([^,]+)\s*,\s*([^)]+)\s*\)\s*\[\s*([^|]*)\|([^\]]*)\]\s*"([^"]*)"'
+)
+
+EXTENDED_ID_FLAG = 0x80000000
+
+ABBR_LEN = 7           # Input::abbrName is 8 chars with terminator
+DISPLAY_NAME_LEN = 31  # Input::displayName is 32 chars with terminator
+
+
+def parse_dbc(path: str) -> List[Dict]:
+    """Parses messages and their signals from a DBC file."""
+    messages = []
+    current = None
+
+    with open(path, encoding='latin-1') as f:
+        for raw in f:
+            line = raw.strip()
+            m = MESSAGE_RE.match(line)
+            if m:
+                current = {
+                    'id': int(m.group(1)),
+                    'name': m.group(2),
+                    'dlc': int(m.group(3)),
+                    'signals': [],
+                }
+                messages.append(current)
+                continue
+
+            m = SIGNAL_RE.match(line)
+            if m and current is not None:
+                current['signals'].append({
+                    'name': m.group(1),
+                    'mux': m.group(2),
+                    'start': int(m.group(3)),
+                    'length': int(m.group(4)),
+                    'big_endian': m.group(5) == '0',
+                    'signed': m.group(6) == '-',
+                    'factor': float(m.group(7)),
+                    'offset': float(m.group(8)),
+                    'unit': m.group(11),
+                })
+
+    return messages
+
+
+def last_byte(signal: Dict) -> int:
+    """Index of the highest payload byte the signal touches."""
+    start, length = signal['start'], signal['length']
+    if not signal['big_endian']:
+        return (start + length - 1) // 8
+    # Motorola: MSB at start, remaining bits run into the next byte's bit 7
+    below = length - 1
+    bit = start % 8
+    extra = 0 if below <= bit else (below - bit + 7) // 8
+    return start // 8 + extra
+
+
+def fmt_number(value: float) -> str:
+    return ('%.6f' % value).rstrip('0').rstrip('.') or '0'
+
+
+def abbreviate(name: str, used: set) -> str:
+    """Short unique name for the LCD (Input::abbrName)."""
+    base = re.sub(r'[^A-Za-z0-9]', '', name).upper()[:ABBR_LEN] or 'SIG'
+    abbr, n = base, 1
+    while abbr in used:
+        suffix = str(n)
+        abbr = base[:ABBR_LEN - len(suffix)] + suffix
+        n += 1
+    used.add(abbr)
+    return abbr
+
+
+def matches(filters: Optional[List[str]], *keys) -> bool:
+    if not filters:
+        return True
+    return any(str(k).lower() in filters for k in keys)
+
+
+def generate_commands(messages: List[Dict], args) -> List[str]:
+    commands = []
+    used_abbr = set()
+    pin = args.first_pin
+    message_filter = [m.lower() for m in args.messages] if args.messages else None
+    signal_filter = [s.lower() for s in args.signals] if args.signals else None
+
+    def warn(text):
+        print(f"  ! {text}", file=sys.stderr)
+
+    for msg in messages:
+        can_id = msg['id']
+        if not matches(message_filter, msg['name'], can_id, hex(can_id & ~EXTENDED_ID_FLAG)):
+            continue
+        if can_id & EXTENDED_ID_FLAG:
+            warn(f"{msg['name']}: extended ID 0x{can_id & ~EXTENDED_ID_FLAG:X} skipped")
+            continue
+
+        for sig in msg['signals']:
+            if not matches(signal_filter, sig['name']):
+                continue
+            label = f"{msg['name']}.{sig['name']}"
+            if sig['mux']:
+                warn(f"{label}: multiplexed signal skipped")
+                continue
+            if sig['length'] < 1 or sig['length'] > 32:
+                warn(f"{label}: {sig['length']}-bit signal skipped (1-32 supported)")
+                continue
+            if last_byte(sig) >= msg['dlc']:
+                warn(f"{label}: extends past the {msg['dlc']}-byte frame, skipped")
+                continue
+            if pin - args.first_pin >= args.max_inputs:
+                warn(f"{label}: input limit ({args.max_inputs}) reached, rest skipped")
+                return commands
+            if sig['signed']:
+                warn(f"{label}: signed signal imported as unsigned")
+
+            ref = f"CAN:{pin}"
+            commands.append(f"SET CAN FRAME 0x{can_id:03X}")
+            commands.append(
+                f"SET {ref} CAN_SIGNAL {sig['start']} {sig['length']} "
+                f"{'BE' if sig['big_endian'] else 'LE'} "
+                f"{fmt_number(sig['factor'])} {fmt_number(sig['offset'])}"
+            )
+            commands.append(f"SET {ref} NAME {abbreviate(sig['name'], used_abbr)}")
+            commands.append(f"SET {ref} DISPLAY_NAME {sig['name'][:DISPLAY_NAME_LEN]}")
+            print(f"  {ref:7} 0x{can_id:03X} {label}"
+                  f"{' [' + sig['unit'] + ']' if sig['unit'] else ''}", file=sys.stderr)
+            pin += 1
+
+    return commands
+
+
+def main():
+    """Main execution function."""
+    parser = argparse.ArgumentParser(
+        description="Convert DBC signals into preOBD CAN input commands")
+    parser.add_argument("dbc", help="DBC file to import")
+    parser.add_argument("-o", "--output",
+                        help="Write commands to this file (default: stdout)")
+    parser.add_argument("-m", "--messages", nargs='+',
+                        help="Only these messages (names or IDs, e.g. EngineData 0x3E9)")
+    parser.add_argument("-s", "--signals", nargs='+',
+                        help="Only these signals (names)")
+    parser.add_argument("--first-pin", type=int, default=0,
+                        help="CAN:n index SET CAN FRAME will assign first - one past "
+                             "the highest CAN:n already configured (default 0)")
+    parser.add_argument("--max-inputs", type=int, default=32,
+                        help="Stop after this many signals (the board's free inputs; "
+                             "at most 32 CAN inputs)")
+    parser.add_argument("--no-save", action="store_true",
+                        help="Leave out the trailing SAVE")
+    args = parser.parse_args()
+
+    print(f"Importing {args.dbc}", file=sys.stderr)
+    messages = parse_dbc(args.dbc)
+    commands = generate_commands(messages, args)
+    if not commands:
+        print("No signals converted", file=sys.stderr)
+        return 1
+    commands = ["BEGIN"] + commands + ["COMMIT"]    # Validated and applied once
+    if not args.no_save:
+        commands.append("SAVE")
+
+    text = "\n".join(commands) + "\n"
+    if args.output:
+        with open(args.output, 'w') as f:
+            f.write(text)
+        print(f"Wrote {len(commands)} commands to {args.output}", file=sys.stderr)
+    else:
+        sys.stdout.write(text)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -5,6 +5,11 @@ preOBD Registry Enum Generator
 Automatically generates C++ enum header file from sensor and application registries.
 This provides type-safe, self-documenting constants instead of magic number indices.
 
+Also generates registry_hashes.h: a perfect hash of each registry's
+name hashes (sensors, applications, units and unit aliases), so a name
+lookup on the device is one table read instead of a scan. Fails if two
+names in one registry share a hash.
+
 Parses the modular sensor library structure:
   - src/lib/sensor_library.h (orchestrator)
   - src/lib/sensor_library/sensors/*.h (sensor definitions using X-macro pattern)
@@ -20,9 +25,12 @@ sys.path.insert(0, os.path.abspath(os.path.join(os.path.dirname(__file__), '.'))
 
 from preobd_config.registry_parser import (
     parse_sensor_library,
-    parse_application_presets
+    parse_application_presets,
+    parse_units_registry
 )
 
+EMPTY_SLOT = 0xFF
+
 
 def generate_enum_header(sensors: List[Dict], apps: List[Dict], output_path: str) -> None:
     """
@@ -89,6 +97,117 @@ def generate_enum_header(sensors: List[Dict], apps: List[Dict], output_path: str
     print(f"  - {len(apps)} application constants")
 
 
+def slot_of(hash_value: int, seed: int, bits: int) -> int:
+    """Slot of a name hash - must match REGISTRY_HASH_SLOT() in registry_hashes.h."""
+    return ((hash_value * seed) & 0xFFFF) >> (16 - bits)
+
+
+def find_perfect_hash(keys: Dict[int, int], label: str):
+    """
+    Find a multiplier that sends every key to its own slot.
+
+    Args:
+        keys: name hash -> registry index
+        label: registry name for error messages
+
+    Returns:
+        (seed, bits, slots) with slots a list of 2**bits indices, EMPTY_SLOT unused
+    """
+    if max(keys.values()) >= EMPTY_SLOT:
+        raise ValueError(f"{label}: more than {EMPTY_SLOT - 1} entries")
+
+    bits = max(1, (len(keys) - 1).bit_length())
+    while bits <= 10:
+        for seed in range(1, 0x10000, 2):
+            slots = [EMPTY_SLOT] * (1 << bits)
+            for hash_value, index in keys.items():
+                slot = slot_of(hash_value, seed, bits)
+                if slots[slot] != EMPTY_SLOT:
+                    break
+                slots[slot] = index
+            else:
+                return seed, bits, slots
+        bits += 1
+    raise ValueError(f"{label}: no perfect hash found")
+
+
+def collect_keys(entries: List[Dict], fields: List[str], label: str) -> Dict[int, int]:
+    """Name hash -> index over the given hash fields; exits on a collision."""
+    keys = {}
+    for entry in entries:
+        for field in fields:
+            hash_value = entry.get(field)
+            if hash_value is None:
+                continue
+            owner = keys.get(hash_value)
+            if owner is not None and owner != entry['index']:
+                print(f"\u2717 Error: {label} hash collision: 0x{hash_value:04X} is both "
+                      f"{entries[owner]['name']} and {entry['name']}", file=sys.stderr)
+                sys.exit(1)
+            keys[hash_value] = entry['index']
+    return keys
+
+
+def generate_hash_header(sensors: List[Dict], apps: List[Dict], units: List[Dict], output_path: str) -> None:
+    """
+    Generate the perfect-hash slot tables for the name lookups.
+
+    Args:
+        sensors: List of sensor dictionaries from parse_sensor_library()
+        apps: List of application dictionaries from parse_application_presets()
+        units: List of unit dictionaries from parse_units_registry()
+        output_path: Path where the header file should be written
+    """
+    timestamp = datetime.now().strftime("%Y-%m-%d %H:%M:%S")
+
+    registries = [
+        ("SENSOR", "SENSOR_LIBRARY", sensors, ["nameHash"]),
+        ("APPLICATION", "APPLICATION_PRESETS", apps, ["nameHash"]),
+        ("UNITS", "UNITS_REGISTRY (names and aliases)", units, ["nameHash", "aliasHash"]),
+    ]
+
+    lines = []
+    lines.append("// AUTO-GENERATED FILE - DO NOT EDIT MANUALLY")
+    lines.append(f"// Generated by tools/generate_registry_enums.py")
+    lines.append(f"// Last generated: {timestamp}")
+    lines.append("//")
+    lines.append("// Perfect hashes of the registries' name hashes: the entry a")
+    lines.append("// hash can belong to is X_HASH_SLOTS[REGISTRY_HASH_SLOT(hash, X_HASH_SEED,")
+    lines.append("// X_HASH_BITS)] (0xFF = none). Lookups still compare the entry's own hash.")
+    lines.append("")
+    lines.append("#ifndef PREOBD_REGISTRY_HASHES_H")
+    lines.append("#define PREOBD_REGISTRY_HASHES_H")
+    lines.append("")
+    lines.append("#include <Arduino.h>")
+    lines.append("")
+    lines.append("#define REGISTRY_HASH_EMPTY 0xFF")
+    lines.append("#define REGISTRY_HASH_SLOT(hash, seed, bits) ((uint16_t)((uint32_t)(hash) * (seed)) >> (16 - (bits)))")
+
+    for prefix, label, entries, fields in registries:
+        keys = collect_keys(entries, fields, label)
+        seed, bits, slots = find_perfect_hash(keys, label)
+        lines.append("")
+        lines.append(f"// {label}: {len(keys)} hashes in {len(slots)} slots")
+        lines.append(f"#define {prefix}_HASH_COUNT {len(entries)}")
+        lines.append(f"#define {prefix}_HASH_SEED 0x{seed:04X}")
+        lines.append(f"#define {prefix}_HASH_BITS {bits}")
+        lines.append(f"static const uint8_t {prefix}_HASH_SLOTS[{len(slots)}] PROGMEM = {{")
+        for row in range(0, len(slots), 16):
+            cells = ", ".join(f"0x{index:02X}" for index in slots[row:row + 16])
+            lines.append(f"    {cells},")
+        lines.append("};")
+        print(f"  - {label}: {len(keys)} hashes, {len(slots)} slots, seed 0x{seed:04X}")
+
+    lines.append("")
+    lines.append("#endif // PREOBD_REGISTRY_HASHES_H")
+    lines.append("")
+
+    with open(output_path, 'w') as f:
+        f.write('\n'.join(lines))
+
+    print(f"Generated {output_path}")
+
+
 def main():
     """Main execution function."""
     # Determine paths
@@ -97,7 +216,9 @@ def main():
 
     sensor_lib_path = os.path.join(project_dir, "src/lib/sensor_library.h")
     app_presets_path = os.path.join(project_dir, "src/lib/application_presets.h")
+    units_path = os.path.join(project_dir, "src/lib/units_registry.h")
     output_path = os.path.join(project_dir, "src/lib/generated/registry_enums.h")
+    hashes_path = os.path.join(project_dir, "src/lib/generated/registry_hashes.h")
 
     print("=== preOBD Registry Enum Generator ===")
     print(f"Project directory: {project_dir}")
@@ -107,6 +228,7 @@ def main():
     try:
         sensors = parse_sensor_library(sensor_lib_path)
         apps = parse_application_presets(app_presets_path)
+        units = parse_units_registry(units_path)
     except FileNotFoundError as e:
         print(f"\u2717 Error: Could not find registry file. {e}", file=sys.stderr)
         sys.exit(1)
@@ -116,6 +238,7 @@ def main():
 
     print(f"\u2713 Parsed {len(sensors)} sensors from sensor_library.h (+ sensor_library/sensors/)")
     print(f"\u2713 Parsed {len(apps)} applications from application_presets.h")
+    print(f"\u2713 Parsed {len(units)} units from units_registry.h")
     print()
 
     # Generate enum header
@@ -126,6 +249,9 @@ def main():
         generate_enum_header(sensors, apps, output_path)
         print()
         print(f"\u2713 Successfully generated registry_enums.h")
+        print()
+        generate_hash_header(sensors, apps, units, hashes_path)
+        print(f"\u2713 Successfully generated registry_hashes.h")
 
     except Exception as e:
         print(f"\u2717 Error generating enum header: {e}", file=sys.stderr)
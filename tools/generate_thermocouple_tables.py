@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+"""
+preOBD Thermocouple Table Generator
+
+Writes src/lib/generated/thermocouple_tables.h: piecewise-linear tables,
+built from the NIST ITS-90 reference functions, that turn a thermocouple
+amplifier's linear reading into the true temperature (see
+src/inputs/sensors/thermocouples/thermocouple_linear.h).
+
+Per thermocouple type:
+  inverse       temperature (1/16 C) at evenly spaced thermocouple voltages,
+                from the NIST forward polynomial inverted by bisection
+  cold junction voltage (uV) at evenly spaced cold-junction temperatures
+
+Run it again after changing a range or step below; the firmware only reads
+the generated header.
+"""
+
+import math
+import os
+import sys
+from datetime import datetime
+
+OUTPUT = os.path.join(os.path.dirname(__file__), '..', 'src', 'lib', 'generated', 'thermocouple_tables.h')
+
+# NIST ITS-90 reference functions, E in mV for t in C (NIST Monograph 175)
+TYPES = {
+    'K': {
+        'label': 'K-type (chromel/alumel)',
+        'ranges': [
+            # (t_min, t_max, coefficients c0.., (a0, a1, a2) exponential term or None)
+            (-270.0, 0.0, [
+                0.000000000000E+00, 0.394501280250E-01, 0.236223735980E-04,
+                -0.328589067840E-06, -0.499048287770E-08, -0.675090591730E-10,
+                -0.574103274280E-12, -0.310888728940E-14, -0.104516093650E-16,
+                -0.198892668780E-19, -0.163226974860E-22,
+            ], None),
+            (0.0, 1372.0, [
+                -0.176004136860E-01, 0.389212049750E-01, 0.185587700320E-04,
+                -0.994575928740E-07, 0.318409457190E-09, -0.560728448890E-12,
+                0.560750590590E-15, -0.320207200030E-18, 0.971511471520E-22,
+                -0.121047212750E-25,
+            ], (0.118597600000E+00, -0.118343200000E-03, 0.126968600000E+03)),
+        ],
+        'seebeck_nv': 41276,        # MAX6675 / MAX31855K linear approximation, nV/C
+        'inverse_start_uv': -6144,  # About -220 C
+        'inverse_shift': 9,         # 512 uV steps
+        'inverse_end_uv': 55296,    # About 1380 C
+        'cj_start_c': -64,
+        'cj_shift': 4,              # 16 C steps
+        'cj_end_c': 128,
+    },
+}
+
+
+def emf_mv(spec, t):
+    """Thermocouple voltage (mV) at t, cold junction at 0 C."""
+    ranges = spec['ranges']
+    _, _, coeffs, exp_term = next((r for r in ranges if t < r[1]), ranges[-1])
+    e = sum(c * t ** i for i, c in enumerate(coeffs))
+    if exp_term:
+        a0, a1, a2 = exp_term
+        e += a0 * math.exp(a1 * (t - a2) ** 2)
+    return e
+
+
+def temperature_c(spec, uv):
+    """Temperature at a thermocouple voltage (uV), by bisection of emf_mv."""
+    lo = spec['ranges'][0][0]
+    hi = spec['ranges'][-1][1] + 50.0   # A step past the NIST range for the last segment
+    for _ in range(80):
+        mid = (lo + hi) / 2
+        if emf_mv(spec, mid) * 1000.0 < uv:
+            lo = mid
+        else:
+            hi = mid
+    return (lo + hi) / 2
+
+
+def format_table(values, per_line=10):
+    lines = []
+    for i in range(0, len(values), per_line):
+        lines.append('    ' + ', '.join(str(v) for v in values[i:i + per_line]) + ',')
+    return '\n'.join(lines)
+
+
+def generate(path):
+    out = [
+        '// AUTO-GENERATED FILE - DO NOT EDIT MANUALLY',
+        '// Generated by tools/generate_thermocouple_tables.py',
+        f'// Last generated: {datetime.now().strftime("%Y-%m-%d %H:%M:%S")}',
+        '//',
+        '// NIST ITS-90 thermocouple tables, linearly interpolated by',
+        '// linearizeThermocouple() (inputs/sensors/thermocouples/thermocouple_linear.h).',
+        '// TC_x_INVERSE: temperature in 1/16 C every 2^TC_x_INVERSE_SHIFT uV from',
+        '// TC_x_INVERSE_START_UV. TC_x_COLD_JUNCTION: voltage in uV every',
+        '// 2^TC_x_CJ_SHIFT C from TC_x_CJ_START_C.',
+        '',
+        '#ifndef PREOBD_THERMOCOUPLE_TABLES_H',
+        '#define PREOBD_THERMOCOUPLE_TABLES_H',
+        '',
+        '#include <Arduino.h>',
+        '',
+    ]
+    for name, spec in TYPES.items():
+        step = 1 << spec['inverse_shift']
+        inverse = []
+        uv = spec['inverse_start_uv']
+        while uv <= spec['inverse_end_uv']:
+            inverse.append(round(temperature_c(spec, uv) * 16))
+            uv += step
+        cj_step = 1 << spec['cj_shift']
+        cold = [round(emf_mv(spec, t) * 1000.0)
+                for t in range(spec['cj_start_c'], spec['cj_end_c'] + 1, cj_step)]
+        if max(abs(v) for v in inverse + cold) > 32767:
+            sys.exit(f'{name}: table value out of int16 range')
+
+        p = f'TC_{name}'
+        out += [
+            f'// {spec["label"]}',
+            f'#define {p}_SEEBECK_NV {spec["seebeck_nv"]}',
+            f'#define {p}_INVERSE_START_UV {spec["inverse_start_uv"]}',
+            f'#define {p}_INVERSE_SHIFT {spec["inverse_shift"]}',
+            f'#define {p}_INVERSE_COUNT {len(inverse)}',
+            f'static const int16_t {p}_INVERSE[{p}_INVERSE_COUNT] PROGMEM = {{',
+            format_table(inverse),
+            '};',
+            f'#define {p}_CJ_START_C {spec["cj_start_c"]}',
+            f'#define {p}_CJ_SHIFT {spec["cj_shift"]}',
+            f'#define {p}_CJ_COUNT {len(cold)}',
+            f'static const int16_t {p}_COLD_JUNCTION[{p}_CJ_COUNT] PROGMEM = {{',
+            format_table(cold),
+            '};',
+            '',
+        ]
+    out += ['#endif // PREOBD_THERMOCOUPLE_TABLES_H', '']
+
+    with open(path, 'w') as f:
+        f.write('\n'.join(out))
+    print(f'Wrote {os.path.normpath(path)}')
+
+
+if __name__ == '__main__':
+    generate(sys.argv[1] if len(sys.argv) > 1 else OUTPUT)
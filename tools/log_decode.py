@@ -0,0 +1,220 @@
+#!/usr/bin/env python3
+"""
+preOBD Deferred Log Decoder
+
+Firmware built with -D ENABLE_DEFERRED_LOG sends its debug messages as 'L'
+frames (src/lib/log_deferred.h): each message is the address of its format
+string, micros(), level, tag and the raw argument bytes. This reads those
+frames live from a serial port, or from a capture file, looks each format
+string up in the firmware ELF the device runs, and prints the messages as
+the device would have:
+
+  12345678 [INFO][CAN] Bus 1: 20431 frames
+
+The ELF must be the exact build on the device (.pio/build/<env>/firmware.elf)
+- a rebuild moves the strings. Records dropped on the device (ring full) and
+lost or damaged frames are counted and reported on exit (and as they happen
+with --verbose). Text and other frames between log frames are skipped.
+
+Ports need pyserial (pip install pyserial).
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from sdlog_convert import StreamDecoder  # noqa: E402
+from serial_decode import open_source   # noqa: E402
+
+LEVELS = ["NONE", "ERROR", "WARN", "INFO", "DEBUG"]
+TAGS = ["SD", "BT", "CAN", "ADC", "SENSOR", "CONFIG", "ALARM", "DISPLAY",
+        "ROUTER", "SERIAL", "I2C", "SPI", "JSON", "RELAY", "SYSTEM"]
+
+EM_AVR = 83
+AVR_DATA_OFFSET = 0x800000    # AVR ELFs place RAM (where literals live) here
+
+CONVERSION = re.compile(r"%([-+ #0]*)(\d+|\*)?(?:\.(\d+|\*))?(hh|h|ll|l|z|j|t|L)?([diouxXeEfFgGcspn%])")
+
+
+class Firmware:
+    """Format strings of a firmware ELF (32-bit little-endian), by address."""
+
+    def __init__(self, path: str):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1 or self.data[5] != 1:
+            raise ValueError("not a 32-bit little-endian ELF")
+        machine = struct.unpack_from("<H", self.data, 18)[0]
+        shoff, = struct.unpack_from("<I", self.data, 32)
+        shentsize, shnum = struct.unpack_from("<HH", self.data, 46)
+        offset = AVR_DATA_OFFSET if machine == EM_AVR else 0
+
+        # Sections holding file contents the program addresses
+        self.sections = []
+        for k in range(shnum):
+            _, kind, flags, addr, file_offset, size = struct.unpack_from("<IIIIII", self.data,
+                                                                         shoff + k * shentsize)
+            if kind == 1 and flags & 0x2 and addr:     # SHT_PROGBITS, SHF_ALLOC
+                self.sections.append((addr, size, file_offset))
+        self.offset = offset
+        self.cache = {}
+
+    def string(self, address: int):
+        """The NUL-terminated string at address, or None if it's in no section."""
+        if address in self.cache:
+            return self.cache[address]
+        text = None
+        for addr, size, file_offset in self.sections:
+            start = address + self.offset - addr
+            if 0 <= start < size:
+                pos = file_offset + start
+                end = self.data.find(b"\0", pos, file_offset + size)
+                if end >= 0:
+                    text = self.data[pos:end].decode("latin-1")
+                break
+        self.cache[address] = text
+        return text
+
+
+def format_message(fmt: str, args: bytes) -> str:
+    """fmt with its arguments unpacked as log_deferred.h packs them."""
+    pos = 0
+    truncated = False
+
+    def take(n):
+        nonlocal pos, truncated
+        if pos + n > len(args):
+            truncated = True
+            return None
+        raw = args[pos:pos + n]
+        pos += n
+        return raw
+
+    def take_int(signed):
+        raw = take(4)
+        return None if raw is None else struct.unpack("<i" if signed else "<I", raw)[0]
+
+    def convert(m):
+        flags, width, precision, length, kind = m.groups()
+        if kind == "%":
+            return "%"
+        if width == "*":
+            width = take_int(True)
+            width = "" if width is None else str(width)
+        if precision == "*":
+            precision = take_int(True)
+            precision = "" if precision is None else str(precision)
+        spec = "%" + flags + (width or "") + ("." + precision if precision else "")
+
+        if kind == "s":
+            n = take(1)
+            raw = take(n[0]) if n is not None else None
+            return "<missing>" if raw is None else (spec + "s") % raw.decode("latin-1")
+        if kind in "eEfFgG":
+            raw = take(4)
+            return "<missing>" if raw is None else (spec + kind) % struct.unpack("<f", raw)[0]
+        if kind == "n":
+            return ""
+        wide = length == "ll"
+        raw = take(8 if wide else 4)
+        if raw is None:
+            return "<missing>"
+        signed = kind in "di"
+        value = struct.unpack(("<q" if signed else "<Q") if wide else ("<i" if signed else "<I"), raw)[0]
+        if kind == "c":
+            return (spec + "c") % chr(value & 0xFF)
+        if kind == "p":
+            return "%#x" % value
+        return (spec + ("d" if kind in "iu" else kind)) % value
+
+    text = CONVERSION.sub(convert, fmt)
+    return text + " <truncated>" if truncated else text
+
+
+def main():
+    """Main execution function."""
+    parser = argparse.ArgumentParser(
+        description="Decode preOBD deferred log frames (ENABLE_DEFERRED_LOG) with the firmware ELF")
+    parser.add_argument("source", help="Serial port (e.g. /dev/ttyACM0, COM3), capture file, or - for stdin")
+    parser.add_argument("--elf", required=True, help="Firmware ELF the device runs (.pio/build/<env>/firmware.elf)")
+    parser.add_argument("-b", "--baud", type=int, default=115200,
+                        help="Port baud rate (default 115200; ignored for USB serial)")
+    parser.add_argument("-o", "--output", help="Text file (default: stdout)")
+    parser.add_argument("--save", help="Also write the raw bytes to this capture file")
+    parser.add_argument("-v", "--verbose", action="store_true",
+                        help="Report dropped records and lost frames as they happen")
+    args = parser.parse_args()
+
+    try:
+        firmware = Firmware(args.elf)
+    except (OSError, ValueError, struct.error) as e:
+        print(f"Error: {args.elf}: {e}", file=sys.stderr)
+        return 1
+    try:
+        source = open_source(args.source, args.baud)
+    except OSError as e:
+        print(f"Error: {args.source}: {e}", file=sys.stderr)
+        return 1
+    out = open(args.output, "w") if args.output else sys.stdout
+    save = open(args.save, "wb") if args.save else None
+
+    stream = StreamDecoder()
+    messages = 0
+    dropped = 0
+    unknown = 0
+    reported = (0, 0, 0)
+    try:
+        while True:
+            chunk = source.read1(4096) if hasattr(source, "read1") else source.read(4096)
+            if not chunk:
+                if os.path.isfile(args.source) or args.source == "-":
+                    break       # End of the capture
+                continue        # Port timeout - keep waiting
+            if save:
+                save.write(chunk)
+
+            for item in stream.feed(chunk):
+                if item[0] != "log":
+                    continue    # Data plane frames - serial_decode.py, bench_decode.py
+                _, frame_dropped, records = item
+                if frame_dropped:
+                    dropped += frame_dropped
+                    print(f"... {frame_dropped} messages dropped on the device", file=out)
+                for r in records:
+                    fmt = firmware.string(r.fmt_addr)
+                    if fmt is None:
+                        unknown += 1
+                        text = f"<unknown format 0x{r.fmt_addr:08x}> {r.args.hex()}"
+                    else:
+                        text = format_message(fmt, r.args)
+                    level = LEVELS[r.level] if r.level < len(LEVELS) else str(r.level)
+                    tag = TAGS[r.tag] if r.tag < len(TAGS) else str(r.tag)
+                    print(f"{r.us} [{level}][{tag}] {text}", file=out)
+                    messages += 1
+            out.flush()
+
+            if args.verbose and (dropped, stream.log_lost, stream.damaged) != reported:
+                reported = (dropped, stream.log_lost, stream.damaged)
+                print(f"{dropped} messages dropped, {stream.log_lost} frames lost, "
+                      f"{stream.damaged} damaged", file=sys.stderr)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if save:
+            save.close()
+        if args.output:
+            out.close()
+
+    if unknown:
+        print(f"Warning: {unknown} messages with no format string in {args.elf} - "
+              f"is it the build on the device?", file=sys.stderr)
+    print(f"{messages} messages, {dropped} dropped on the device, "
+          f"{stream.log_lost} frames lost, {stream.damaged} damaged", file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
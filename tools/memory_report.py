@@ -0,0 +1,274 @@
+#!/usr/bin/env python3
+"""
+preOBD RAM Report
+
+Reads the GNU ld map of a build (.pio/build/<env>/firmware.map, written by
+scripts/memory_budget.py) and prints the static RAM - .data, .bss, .noinit and
+Teensy DMAMEM - by subsystem, with the largest variables:
+
+  inputs                  6210
+  can                     1840
+  outputs                 1536
+  ...
+
+Objects are grouped by the source path they were built from: src/inputs,
+src/outputs, src/displays, src/lib/transports, src/lib, each library in
+.pio/libdeps and the framework core. --budget checks the groups against
+limits and exits 1 when one is over, which is how the build enforces an
+env's custom_ram_budget.
+
+--placement adds where each output section landed on a Teensy 4.x (ITCM,
+DTCM, OCRAM, FLASH, EXTMEM - src/hal/hal_placement.h), the cold code moved
+to flash, and the region of each hot function the map names:
+
+  Placement:
+    ITCM    .text.itcm         81344
+    FLASH   .text.progmem      52112  (cold code 18220)
+    DTCM    .bss               24576
+    ...
+    updateCANCache             ITCM
+"""
+
+import argparse
+import re
+import sys
+from collections import defaultdict
+
+RAM_SECTIONS = (".data", ".bss", ".noinit", "COMMON", ".dmabuffers")
+# Output sections in RAM whose input sections are not named after them
+RAM_OUTPUT_SECTIONS = (".data", ".bss", ".noinit", ".dmabuffers", ".dtcm", ".dram0.data", ".dram0.bss")
+
+# (path fragment, group) - first match wins
+GROUPS = [
+    ("src/inputs/sensors/can", "can"),
+    ("src/inputs", "inputs"),
+    ("src/outputs", "outputs"),
+    ("src/displays", "display"),
+    ("src/lib/transports", "transports"),
+    ("src/lib", "lib"),
+    ("src/test", "test"),
+    ("/src/", "main"),
+]
+
+# Teensy 4.x (i.MX RT1062) memory map: (first address, end, region)
+REGIONS = [
+    (0x00000000, 0x00080000, "ITCM"),
+    (0x20000000, 0x20080000, "DTCM"),
+    (0x20200000, 0x20280000, "OCRAM"),
+    (0x60000000, 0x70000000, "FLASH"),
+    (0x70000000, 0x80000000, "EXTMEM"),
+]
+
+# Marked HAL_HOT_CODE - expected in ITCM (static ones are not named in the map)
+HOT_FUNCTIONS = ("updateCANCache", "updateInputAlarmState", "updateAllInputAlarms", "readCANSensor",
+                 "readThermistor", "readPressure", "readVoltage", "readLinearSensor")
+
+SECTION_HEAD = re.compile(r"^(\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+))?")
+ADDRESS_ONLY = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)")
+
+ENTRY = re.compile(r"^\s*(\S+)?\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+SYMBOL = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+([A-Za-z_][\w:<>~,\s\(\)\*&\.]*)$")
+
+
+def group_of(obj_path):
+    """Subsystem of the object file an input section came from."""
+    path = obj_path.replace("\\", "/")
+    # Libraries: built into .pio/build/<env>/lib<hash>/<name>/, or from .pio/libdeps
+    lib = re.search(r"/lib[0-9a-f]{3,}/([^/]+)/", path) or re.search(r"libdeps/[^/]+/([^/]+)/", path)
+    if lib:
+        return lib.group(1)
+    for fragment, group in GROUPS:
+        if fragment in path:
+            return group
+    return "core"
+
+
+def is_ram_section(name, output_section):
+    if any(name == s or name.startswith(s + ".") for s in RAM_SECTIONS):
+        return True
+    return output_section in RAM_OUTPUT_SECTIONS and name != "*fill*"
+
+
+def parse_map(lines):
+    """Returns ([(group, section, size, object, symbol)], total)."""
+    in_map = False
+    output_section = None
+    pending = None          # Input section name that wrapped onto the next line
+    items = []
+
+    for line in lines:
+        line = line.rstrip("\n")
+        if not in_map:
+            in_map = line.startswith("Linker script and memory map")
+            continue
+        if line.startswith("/DISCARD/") or line.startswith("OUTPUT("):
+            break
+        if line and not line[0].isspace():
+            output_section = line.split()[0]
+            pending = None
+            continue
+
+        stripped = line.strip()
+        if pending is None and stripped and " " not in stripped and stripped[0] in ".C":
+            pending = stripped         # Long name; address, size and object follow
+            continue
+
+        match = ENTRY.match(line)
+        if match:
+            name = match.group(1) or pending
+            pending = None
+            size = int(match.group(3), 16)
+            obj = match.group(4).strip()
+            if name and size and is_ram_section(name, output_section) and not obj.startswith("0x"):
+                symbol = name.split(".")[-1] if name.count(".") >= 2 else ""
+                items.append([group_of(obj), name, size, obj, symbol])
+            continue
+
+        pending = None
+        match = SYMBOL.match(line)
+        if match and items and is_ram_section(items[-1][1], output_section):
+            # Symbol lines name a COMMON entry, or the section's first symbol
+            if not items[-1][4]:
+                items[-1][4] = match.group(2).strip()
+
+    return items, sum(item[2] for item in items)
+
+
+def region_of(address):
+    for first, end, name in REGIONS:
+        if first <= address < end:
+            return name
+    return None
+
+
+def parse_placement(lines):
+    """Returns ([(region, output section, size, cold bytes)], {hot function: region})."""
+    in_map = False
+    sections = []
+    hot = {}
+    current = None          # [region, section, size, cold] of the output section being read
+    waiting = None          # Output section name whose address is on the next line
+
+    for line in lines:
+        line = line.rstrip("\n")
+        if not in_map:
+            in_map = line.startswith("Linker script and memory map")
+            continue
+        if line.startswith("/DISCARD/") or line.startswith("OUTPUT("):
+            break
+
+        head = SECTION_HEAD.match(line)
+        if head and not line[0].isspace():
+            current = None
+            waiting = None
+            if head.group(2) is None:
+                waiting = head.group(1)
+                continue
+            name, address, size = head.group(1), int(head.group(2), 16), int(head.group(3), 16)
+        elif waiting:
+            match = ADDRESS_ONLY.match(line)
+            name, waiting = waiting, None
+            if not match:
+                continue
+            address, size = int(match.group(1), 16), int(match.group(2), 16)
+        else:
+            if current:
+                stripped = line.strip()
+                match = ENTRY.match(line)
+                if match and (match.group(1) or "").startswith(".flashmem"):
+                    current[3] += int(match.group(3), 16)
+                for function in HOT_FUNCTIONS:
+                    if function in stripped and function not in hot:
+                        address = re.search(r"0x([0-9a-fA-F]+)", stripped)
+                        if address:
+                            hot[function] = region_of(int(address.group(1), 16)) or "?"
+            continue
+
+        region = region_of(address)
+        if region and size and not name.startswith(".debug") and not name.startswith(".ARM.attributes"):
+            current = [region, name, size, 0]
+            sections.append(current)
+
+    return sections, hot
+
+
+def print_placement(path):
+    with open(path, errors="replace") as f:
+        sections, hot = parse_placement(f)
+    if not any(section[1] == ".text.itcm" for section in sections):
+        print("Placement: no region map for this target (Teensy 4.x only)")
+        return
+    print("Placement:")
+    for region, name, size, cold in sections:
+        note = f"  (cold code {cold})" if cold else ""
+        print(f"  {region:<7} {name:<18} {size:8}{note}")
+    for function, region in sorted(hot.items()):
+        warning = "" if region == "ITCM" else "  <- expected ITCM"
+        print(f"  {function:<26} {region}{warning}")
+
+
+def parse_budget(text):
+    budget = {}
+    for part in re.split(r"[,\s]+", text.strip()):
+        if not part:
+            continue
+        name, _, limit = part.partition(":")
+        if not limit.isdigit():
+            raise ValueError(f"Bad budget entry '{part}' (want name:bytes)")
+        budget[name] = int(limit)
+    return budget
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Static RAM by subsystem from a linker map")
+    parser.add_argument("map", help="Linker map (.pio/build/<env>/firmware.map)")
+    parser.add_argument("--top", type=int, default=10, help="Largest variables to list (default 10)")
+    parser.add_argument("--budget", default="",
+                        help="Limits as 'total:N,inputs:N,...' - exit 1 when one is over")
+    parser.add_argument("--placement", action="store_true",
+                        help="Also list the memory region of each output section (Teensy 4.x)")
+    args = parser.parse_args()
+
+    try:
+        with open(args.map, errors="replace") as f:
+            items, total = parse_map(f)
+    except OSError as e:
+        print(f"Error: {e}", file=sys.stderr)
+        return 2
+
+    groups = defaultdict(int)
+    for group, _, size, _, _ in items:
+        groups[group] += size
+
+    print(f"Static RAM: {total} bytes")
+    for group, size in sorted(groups.items(), key=lambda g: -g[1]):
+        print(f"  {group:<20} {size:8}")
+
+    if args.top > 0:
+        print(f"Largest {min(args.top, len(items))}:")
+        for group, name, size, _, symbol in sorted(items, key=lambda i: -i[2])[:args.top]:
+            print(f"  {size:8}  {symbol or name:<40} {group}")
+
+    if args.placement:
+        print_placement(args.map)
+
+    try:
+        budget = parse_budget(args.budget)
+    except ValueError as e:
+        print(f"Error: {e}", file=sys.stderr)
+        return 2
+
+    over = False
+    for name, limit in budget.items():
+        used = total if name == "total" else groups.get(name, 0)
+        if used > limit:
+            print(f"RAM budget exceeded: {name} uses {used} of {limit} bytes", file=sys.stderr)
+            over = True
+    if budget and not over:
+        print("RAM budget: OK (" + ", ".join(f"{n} {total if n == 'total' else groups.get(n, 0)}/{l}"
+                                            for n, l in budget.items()) + ")")
+    return 1 if over else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,328 @@
+"""
+Binary config blob (src/lib/config_blob.h) from a runtime JSON config.
+
+The blob is "OEMC" followed by records, each a MessagePack value framed as
+type (uint8), length (uint16 LE), value, CRC-32 (LE) of type+length+value.
+
+A patch blob (delta sync) holds merge patches against a device's current
+blob instead: see build_config_patch().
+"""
+import base64
+import math
+import struct
+import zlib
+from typing import Any, Dict, List, Optional, Tuple
+
+BLOB_MAGIC = b"OEMC"
+LINE_CHARS = 96  # CONFIG_BLOB_LINE_CHARS default
+
+# Members of an exported input that are runtime state, not config
+RUNTIME_INPUT_KEYS = ("health", "summary")
+
+
+def _pack(value: Any, out: bytearray) -> None:
+    """Appends the MessagePack encoding of value (the subset ArduinoJson reads)."""
+    if value is None:
+        out.append(0xC0)
+    elif isinstance(value, bool):
+        out.append(0xC3 if value else 0xC2)
+    elif isinstance(value, int):
+        if 0 <= value < 0x80:
+            out.append(value)
+        elif -32 <= value < 0:
+            out += struct.pack("b", value)
+        elif 0 <= value <= 0xFF:
+            out += struct.pack(">BB", 0xCC, value)
+        elif 0 <= value <= 0xFFFF:
+            out += struct.pack(">BH", 0xCD, value)
+        elif 0 <= value <= 0xFFFFFFFF:
+            out += struct.pack(">BI", 0xCE, value)
+        elif -0x80 <= value < 0:
+            out += struct.pack(">Bb", 0xD0, value)
+        elif -0x8000 <= value < 0:
+            out += struct.pack(">Bh", 0xD1, value)
+        elif -0x80000000 <= value < 0:
+            out += struct.pack(">Bi", 0xD2, value)
+        else:
+            raise ValueError(f"Integer out of range for the config blob: {value}")
+    elif isinstance(value, float):
+        # float32 when it holds the value exactly (as ArduinoJson writes it)
+        if math.isnan(value) or struct.unpack(">f", struct.pack(">f", value))[0] == value:
+            out += struct.pack(">Bf", 0xCA, value)
+        else:
+            out += struct.pack(">Bd", 0xCB, value)
+    elif isinstance(value, str):
+        data = value.encode("utf-8")
+        if len(data) < 32:
+            out.append(0xA0 | len(data))
+        elif len(data) <= 0xFF:
+            out += struct.pack(">BB", 0xD9, len(data))
+        else:
+            out += struct.pack(">BH", 0xDA, len(data))
+        out += data
+    elif isinstance(value, (list, tuple)):
+        if len(value) < 16:
+            out.append(0x90 | len(value))
+        else:
+            out += struct.pack(">BH", 0xDC, len(value))
+        for item in value:
+            _pack(item, out)
+    elif isinstance(value, dict):
+        if len(value) < 16:
+            out.append(0x80 | len(value))
+        else:
+            out += struct.pack(">BH", 0xDE, len(value))
+        for key, item in value.items():
+            _pack(str(key), out)
+            _pack(item, out)
+    else:
+        raise ValueError(f"Cannot encode {type(value).__name__} in the config blob")
+
+
+def _unpack(data: bytes, pos: int) -> Tuple[Any, int]:
+    """Decodes one MessagePack value at pos; returns it and the position after it."""
+    b = data[pos]
+    pos += 1
+    if b < 0x80:
+        return b, pos
+    if b >= 0xE0:
+        return b - 0x100, pos
+    if 0xA0 <= b <= 0xBF:
+        return data[pos:pos + (b & 0x1F)].decode("utf-8"), pos + (b & 0x1F)
+    if 0x90 <= b <= 0x9F:
+        return _unpack_array(data, pos, b & 0x0F)
+    if 0x80 <= b <= 0x8F:
+        return _unpack_map(data, pos, b & 0x0F)
+    if b == 0xC0:
+        return None, pos
+    if b in (0xC2, 0xC3):
+        return b == 0xC3, pos
+    fixed = {0xCA: ">f", 0xCB: ">d", 0xCC: ">B", 0xCD: ">H", 0xCE: ">I", 0xCF: ">Q",
+             0xD0: ">b", 0xD1: ">h", 0xD2: ">i", 0xD3: ">q"}
+    if b in fixed:
+        size = struct.calcsize(fixed[b])
+        return struct.unpack_from(fixed[b], data, pos)[0], pos + size
+    if b in (0xD9, 0xDA, 0xDB):
+        fmt = {0xD9: ">B", 0xDA: ">H", 0xDB: ">I"}[b]
+        (length,) = struct.unpack_from(fmt, data, pos)
+        pos += struct.calcsize(fmt)
+        return data[pos:pos + length].decode("utf-8"), pos + length
+    if b in (0xDC, 0xDD):
+        fmt = ">H" if b == 0xDC else ">I"
+        (count,) = struct.unpack_from(fmt, data, pos)
+        return _unpack_array(data, pos + struct.calcsize(fmt), count)
+    if b in (0xDE, 0xDF):
+        fmt = ">H" if b == 0xDE else ">I"
+        (count,) = struct.unpack_from(fmt, data, pos)
+        return _unpack_map(data, pos + struct.calcsize(fmt), count)
+    raise ValueError(f"Unsupported MessagePack type 0x{b:02x} in the config blob")
+
+
+def _unpack_array(data: bytes, pos: int, count: int) -> Tuple[List[Any], int]:
+    items = []
+    for _ in range(count):
+        item, pos = _unpack(data, pos)
+        items.append(item)
+    return items, pos
+
+
+def _unpack_map(data: bytes, pos: int, count: int) -> Tuple[Dict[str, Any], int]:
+    items = {}
+    for _ in range(count):
+        key, pos = _unpack(data, pos)
+        items[str(key)], pos = _unpack(data, pos)
+    return items, pos
+
+
+def _record(record_type: str, value: Any) -> bytes:
+    body = bytearray()
+    _pack(value, body)
+    if len(body) > 0xFFFF:
+        raise ValueError(f"Record '{record_type}' too large ({len(body)} bytes)")
+    head = struct.pack("<BH", ord(record_type), len(body))
+    crc = zlib.crc32(head + body) & 0xFFFFFFFF
+    return head + bytes(body) + struct.pack("<I", crc)
+
+
+def build_config_blob(config: Dict[str, Any]) -> bytes:
+    """Returns the blob for a runtime JSON config (as SYSTEM DUMP JSON prints it)."""
+    if config.get("mode", "runtime") != "runtime":
+        raise ValueError("Only runtime (EEPROM) configs convert to a blob")
+
+    header = {
+        "schemaVersion": config.get("schemaVersion", 1),
+        "mode": "runtime",
+        "firmware": config.get("firmware", {}),
+    }
+    blob = bytearray(BLOB_MAGIC)
+    blob += _record("H", header)
+    if "system" in config:
+        blob += _record("S", config["system"])
+
+    inputs: List[Dict[str, Any]] = config.get("inputs", [])
+    for input_obj in inputs:
+        record = {k: v for k, v in input_obj.items() if k != "health"}
+        blob += _record("I", record)
+    blob += _record("E", len(inputs))
+    return bytes(blob)
+
+
+def parse_config_blob(blob: bytes) -> Dict[str, Any]:
+    """Returns the runtime JSON config a blob holds (as SYSTEM DUMP BIN exports it).
+
+    Raises ValueError on a bad magic, a record CRC mismatch or a missing end record.
+    """
+    if blob[:4] != BLOB_MAGIC:
+        raise ValueError("Not a config blob")
+    config: Dict[str, Any] = {"inputs": []}
+    pos = 4
+    while pos < len(blob):
+        if pos + 3 > len(blob):
+            break
+        record_type, length = struct.unpack_from("<BH", blob, pos)
+        end = pos + 3 + length
+        if end + 4 > len(blob):
+            break
+        (crc,) = struct.unpack_from("<I", blob, end)
+        if zlib.crc32(blob[pos:end]) & 0xFFFFFFFF != crc:
+            raise ValueError(f"Config blob record '{chr(record_type)}' CRC mismatch")
+        value, _ = _unpack(blob[pos + 3:end], 0)
+        pos = end + 4
+
+        if record_type == ord("H"):
+            config.update(value)
+        elif record_type == ord("S"):
+            config["system"] = value
+        elif record_type == ord("I"):
+            config["inputs"].append(value)
+        elif record_type == ord("E"):
+            if value != len(config["inputs"]):
+                raise ValueError("Config blob is missing input records")
+            return config
+    raise ValueError("Config blob truncated (no end record)")
+
+
+def _same_value(a: Any, b: Any) -> bool:
+    """Equal as the device stores them: numbers compared at float32 precision."""
+    if isinstance(a, bool) or isinstance(b, bool):
+        return a is b if isinstance(a, bool) and isinstance(b, bool) else False
+    if isinstance(a, (int, float)) and isinstance(b, (int, float)):
+        if isinstance(a, int) and isinstance(b, int):
+            return a == b
+        try:
+            fa, fb = (struct.unpack(">f", struct.pack(">f", v))[0] for v in (a, b))
+        except OverflowError:
+            return float(a) == float(b)
+        return fa == fb or (math.isnan(fa) and math.isnan(fb))
+    return a == b
+
+
+def merge_patch(current: Any, target: Any) -> Any:
+    """The RFC 7386 merge patch that turns current into target (None if they match).
+
+    Objects are diffed member by member (removed members become null); any
+    other value that differs - arrays included - is replaced whole.
+    """
+    if isinstance(current, dict) and isinstance(target, dict):
+        patch: Dict[str, Any] = {}
+        for key, value in target.items():
+            if key not in current:
+                patch[key] = value
+            else:
+                member = merge_patch(current[key], value)
+                if member is not None:
+                    patch[key] = member
+        for key in current:
+            if key not in target:
+                patch[key] = None
+        return patch or None
+    if isinstance(current, list) and isinstance(target, list):
+        same = len(current) == len(target) and all(
+            merge_patch(c, t) is None for c, t in zip(current, target))
+        return None if same else target
+    return None if _same_value(current, target) else target
+
+
+def _config_inputs(config: Dict[str, Any]) -> Dict[int, Dict[str, Any]]:
+    """Enabled inputs by idx, without runtime state (disabled ones aren't exported)."""
+    inputs = {}
+    for input_obj in config.get("inputs", []):
+        if input_obj.get("enabled", True) is False:
+            continue
+        inputs[int(input_obj["idx"])] = {
+            k: v for k, v in input_obj.items() if k not in RUNTIME_INPUT_KEYS}
+    return inputs
+
+
+def build_config_patch(base_hash: int, device: Dict[str, Any],
+                       target: Dict[str, Any]) -> Tuple[Optional[bytes], List[str]]:
+    """Returns the patch blob that turns the device's config into target, and
+    a line per change; (None, []) when they already match.
+
+    base_hash is the device's CONFIG HASH - the patch is refused if it changed.
+    """
+    if target.get("mode", "runtime") != "runtime":
+        raise ValueError("Only runtime (EEPROM) configs sync to a device")
+
+    records = bytearray()
+    changes: List[str] = []
+    system = merge_patch(device.get("system", {}), target.get("system", {}))
+    if system is not None:
+        records += _record("s", system)
+        changes += [f"system: {path}" for path in _patch_paths(system)]
+
+    input_records = 0
+    current = _config_inputs(device)
+    wanted = _config_inputs(target)
+    for idx in sorted(set(current) | set(wanted)):
+        if idx not in wanted:
+            records += _record("X", idx)
+            changes.append(f"input {idx}: cleared")
+        elif idx not in current:
+            records += _record("I", wanted[idx])
+            changes.append(f"input {idx}: new ({wanted[idx].get('app', '?')} on pin {wanted[idx].get('pin', '?')})")
+        else:
+            patch = merge_patch(current[idx], wanted[idx])
+            if patch is None:
+                continue
+            changes += [f"input {idx}: {path}" for path in _patch_paths(patch)]
+            patch["idx"] = idx
+            records += _record("i", patch)
+        input_records += 1
+
+    if not records:
+        return None, []
+    header = {
+        "schemaVersion": target.get("schemaVersion", 1),
+        "mode": "runtime",
+        "patch": base_hash,
+    }
+    blob = bytearray(BLOB_MAGIC)
+    blob += _record("H", header)
+    blob += records
+    blob += _record("E", input_records)
+    return bytes(blob), changes
+
+
+def _patch_paths(patch: Dict[str, Any], prefix: str = "") -> List[str]:
+    """Dotted paths of the leaves a merge patch sets ("x removed" for nulls)."""
+    paths = []
+    for key, value in patch.items():
+        path = prefix + key
+        if isinstance(value, dict) and value:
+            paths += _patch_paths(value, path + ".")
+        elif value is None:
+            paths.append(path + " removed")
+        else:
+            paths.append(f"{path} = {value}")
+    return paths
+
+
+def blob_import_lines(blob: bytes, line_chars: int = LINE_CHARS) -> List[str]:
+    """Returns the IMPORT lines that load the blob over the serial console."""
+    text = base64.b64encode(blob).decode("ascii")
+    lines = ["IMPORT BEGIN"]
+    for start in range(0, len(text), line_chars):
+        lines.append("IMPORT " + text[start:start + line_chars])
+    lines.append("IMPORT END")
+    return lines
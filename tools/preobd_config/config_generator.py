@@ -107,6 +107,13 @@ def generate_static_calibrations_file(inputs: List[Dict[str, Any]], tool_version
     footer = "#endif // STATIC_CALIBRATIONS_H\n"
     return header + "".join(calibration_blocks) + footer
 
+def pin_define_value(pin: Any) -> str:
+    """C value of a pin string: external ADC channels (ADC:n) are virtual pins 0xE0 + n."""
+    pin_str = str(pin).strip().upper()
+    if pin_str.startswith("ADC:"):
+        return f"0x{0xE0 + int(pin_str[4:]):02X}"
+    return str(pin)
+
 def generate_config_block(inputs: List[Dict[str, Any]], platform: str, tool_version="1.0.0") -> str:
     """
     Generates the C++ block for static sensor configuration.
@@ -131,7 +138,7 @@ def generate_config_block(inputs: List[Dict[str, Any]], platform: str, tool_vers
 
         define_block = f"""
 // ----- Input {i}: {app_name} -----
-#define INPUT_{i}_PIN           {input_config['pin']:<12}
+#define INPUT_{i}_PIN           {pin_define_value(input_config['pin']):<12}
 #define INPUT_{i}_APPLICATION   {input_config['application_index']:<12} // {app_name}
 #define INPUT_{i}_SENSOR        {input_config['sensor_index']:<12} // {sensor_name}
 """
@@ -139,6 +146,135 @@ def generate_config_block(inputs: List[Dict[str, Any]], platform: str, tool_vers
 
     return header + "".join(input_defines)
 
+def generate_static_read_pipeline_file(inputs: List[Dict[str, Any]], sensors: List[Dict[str, Any]], tool_version="1.0.0") -> Optional[str]:
+    """
+    Generates the static_read_pipeline.h file content.
+    Returns None if no configured input has a read function.
+
+    Emits STATIC_INPUT_LIST(X) with one X(n, readFunction, interval) entry per
+    configured input, so main.cpp can expand updateSensors() into direct calls
+    with constant intervals instead of walking the runtime schedule.
+    """
+    entries = []
+    for i, inp in enumerate(inputs):
+        sensor = next((s for s in sensors if s['index'] == inp['sensor_index']), None)
+        if sensor is None:
+            continue
+        read_fn = sensor.get('readFunction', 'nullptr')
+        if read_fn in ('nullptr', 'NULL', ''):
+            continue
+        interval = sensor.get('minReadInterval', '0')
+        if interval in ('0', ''):
+            interval = 'SENSOR_READ_INTERVAL_MS'
+        entries.append((i, read_fn, interval, inp.get('application', 'NONE')))
+
+    if not entries:
+        return None
+
+    timestamp = datetime.datetime.now().strftime("%Y-%m-%d %H:%M:%S")
+
+    lines = [f"""// Auto-generated by tools/configure.py v{tool_version} on {timestamp}
+// DO NOT EDIT MANUALLY - Use tools/configure.py to regenerate
+
+#ifndef STATIC_READ_PIPELINE_H
+#define STATIC_READ_PIPELINE_H
+
+#include "../sensor_library/sensor_types.h"
+#include "../../config.h"
+
+#define STATIC_READ_PIPELINE 1
+#define STATIC_INPUT_COUNT {len(inputs)}
+
+// X(input number, read function, read interval ms)
+#define STATIC_INPUT_LIST(X) \\"""]
+    for i, read_fn, interval, app_name in entries:
+        lines.append(f"    X({i}, {read_fn}, {interval}) /* {app_name} */ \\")
+    lines.append("")
+    lines.append("#endif // STATIC_READ_PIPELINE_H")
+    return "\n".join(lines) + "\n"
+
+# Data outputs a static config can leave out: JSON name -> manifest token
+MANIFEST_OUTPUTS = {"CAN": "CAN", "REALDASH": "REALDASH", "SERIAL": "SERIAL", "SD": "SD", "SD_LOG": "SD", "MQTT": "MQTT"}
+
+_SKIPPABLE_INCLUDE = re.compile(r'#ifndef (STATIC_SKIP_\w+)\s*\n#include "([^"]+)"')
+_FUNCTION_DEF = re.compile(r'^[A-Za-z_][\w \t\*&]*?\b(\w+)\s*\([^;{)]*\)\s*\{', re.MULTILINE)
+_PROGMEM_DEF = re.compile(r'PROGMEM\s+\w+\s+(\w+)\s*(?:\[[^\]]*\])?\s*=')
+
+
+def _skippable_files(orchestrator_path: str):
+    """(token, path) of each #ifndef STATIC_SKIP_x / #include pair in an orchestrator file."""
+    with open(orchestrator_path, 'r') as f:
+        content = f.read()
+    base = os.path.dirname(orchestrator_path)
+    return [(m.group(1), os.path.join(base, m.group(2))) for m in _SKIPPABLE_INCLUDE.finditer(content)]
+
+
+def generate_static_manifest_file(inputs: List[Dict[str, Any]], sensors: List[Dict[str, Any]],
+                                  project_dir: str, outputs: Optional[List[str]] = None,
+                                  tool_version="1.0.0") -> str:
+    """
+    Generates the static_manifest.h file content (thin-library builds only).
+
+    Lists what the configured inputs do not use, for the build to leave out:
+      - sensor implementations (sensor_read.cpp) defining none of the used
+        sensors' read/init functions
+      - calibration files (sensor_calibration_data.h) defining none of their
+        default calibrations
+      - data outputs missing from `outputs` (when a list is given)
+    """
+    used_indices = {inp['sensor_index'] for inp in inputs}
+    used_sensors = [s for s in sensors if s['index'] in used_indices]
+    used_functions = set()
+    used_calibrations = set()
+    for sensor in used_sensors:
+        for fn in (sensor.get('readFunction'), sensor.get('initFunction'),
+                   sensor.get('startFunction'), sensor.get('completeFunction')):
+            if fn and fn not in ('nullptr', 'NULL'):
+                used_functions.add(fn)
+        cal = sensor.get('defaultCalibration', 'nullptr').lstrip('&').strip()
+        if cal not in ('nullptr', 'NULL', ''):
+            used_calibrations.add(cal)
+
+    skip_sensors = []
+    for token, path in _skippable_files(os.path.join(project_dir, 'src', 'inputs', 'sensor_read.cpp')):
+        with open(path, 'r') as f:
+            defined = set(_FUNCTION_DEF.findall(f.read()))
+        if not defined & used_functions:
+            skip_sensors.append((token, os.path.relpath(path, os.path.join(project_dir, 'src'))))
+
+    skip_calibrations = []
+    for token, path in _skippable_files(os.path.join(project_dir, 'src', 'lib', 'sensor_calibration_data.h')):
+        with open(path, 'r') as f:
+            defined = set(_PROGMEM_DEF.findall(f.read()))
+        if not defined & used_calibrations:
+            skip_calibrations.append((token, os.path.relpath(path, os.path.join(project_dir, 'src'))))
+
+    skip_outputs = []
+    if outputs is not None:
+        kept = {MANIFEST_OUTPUTS[name.strip().upper()] for name in outputs}
+        skip_outputs = [token for token in ("CAN", "REALDASH", "SERIAL", "SD", "MQTT") if token not in kept]
+
+    timestamp = datetime.datetime.now().strftime("%Y-%m-%d %H:%M:%S")
+    lines = [f"""// Auto-generated by tools/configure.py v{tool_version} on {timestamp}
+// DO NOT EDIT MANUALLY - Use tools/configure.py to regenerate
+
+#ifndef STATIC_MANIFEST_H
+#define STATIC_MANIFEST_H
+
+#define STATIC_MANIFEST 1
+
+// Sensor implementations no input uses (sensor_read.cpp)"""]
+    lines += [f"#define {token}  // {path}" for token, path in skip_sensors]
+    lines.append("")
+    lines.append("// Calibration tables no input uses (sensor_calibration_data.h)")
+    lines += [f"#define {token}  // {path}" for token, path in skip_calibrations]
+    lines.append("")
+    lines.append("// Data outputs left out (output_manager.cpp)")
+    lines += [f"#define STATIC_SKIP_OUTPUT_{token}" for token in skip_outputs]
+    lines.append("")
+    lines.append("#endif // STATIC_MANIFEST_H")
+    return "\n".join(lines) + "\n"
+
 def write_static_calibrations_file(output_path: str, content: str) -> bool:
     """
     Writes the static_calibrations.h file to disk.
@@ -372,6 +508,12 @@ def generate_thin_library_files(
         thinned_sensor_content,
         flags=re.DOTALL
     )
+    thinned_sensor_content = re.sub(
+        r'(#define X_SENSOR_TWO_PHASE\(name, label, desc, readFn, initFn, measType, calType, defCal, minInt, minVal, maxVal, hash, pinType, startFn, completeFn\).*?\{ name, label, desc, readFn, initFn, measType, calType, defCal, minInt, minVal, maxVal, hash), pinType(.*?\})',
+        r'\1\2',
+        thinned_sensor_content,
+        flags=re.DOTALL
+    )
     # Add comment explaining the macro behavior in static builds
     thinned_sensor_content = thinned_sensor_content.replace(
         '// Assemble SENSOR_LIBRARY[] from X-macros defined in each category file',
@@ -0,0 +1,85 @@
+"""
+Command link to a live device over its serial console (pyserial).
+
+Each command is sent as typed at the prompt; its answer is everything up to
+the next "preOBD> " prompt, which the console prints only once a command's
+output is complete. Data output and debug messages on the same port are
+passed through in the answer, so callers look for their own lines.
+"""
+import base64
+import re
+import time
+from typing import List, Optional, Tuple
+
+PROMPT = "preOBD> "
+HASH_LINE = re.compile(r"CONFIG HASH ([0-9a-fA-F]{8}) (\d+)")
+ANSI_ESCAPE = re.compile(r"\x1b\[[0-9;]*[A-Za-z]")
+
+
+class DeviceError(Exception):
+    """A command the device answered with ERROR, or no answer at all."""
+
+
+class DeviceLink:
+    def __init__(self, port: str, baud: int = 115200, timeout: float = 5.0):
+        try:
+            import serial
+        except ImportError:
+            raise DeviceError("talking to a device needs pyserial (pip install pyserial)")
+        self.port = serial.Serial(port, baud, timeout=0.1)
+        self.timeout = timeout
+        time.sleep(0.2)
+        self.port.reset_input_buffer()
+
+    def close(self):
+        self.port.close()
+
+    def command(self, line: str, timeout: Optional[float] = None) -> List[str]:
+        """Sends one command; returns the lines of its answer (echo and prompt removed)."""
+        self.port.write((line + "\r\n").encode("ascii"))
+        deadline = time.monotonic() + (timeout or self.timeout)
+        buffer = ""
+        while PROMPT not in buffer:
+            if time.monotonic() > deadline:
+                raise DeviceError(f"no prompt after '{line}'")
+            chunk = self.port.read(4096)
+            if chunk:
+                buffer += ANSI_ESCAPE.sub("", chunk.decode("ascii", errors="replace"))
+        lines = [l.strip("\r") for l in buffer[:buffer.index(PROMPT)].split("\n")]
+        if lines and line and lines[0].strip().endswith(line.strip()):
+            lines = lines[1:]             # The console's echo of the command
+        return [l for l in lines if l.strip()]
+
+    def checked(self, line: str, timeout: Optional[float] = None) -> List[str]:
+        """command(), raising DeviceError if any answer line starts with ERROR."""
+        answer = self.command(line, timeout)
+        errors = [l.strip() for l in answer if l.strip().startswith("ERROR")]
+        if errors:
+            raise DeviceError(f"{line}: " + "; ".join(errors))
+        return answer
+
+    def enter_config(self) -> bool:
+        """CONFIG mode; True if the device was in RUN mode before."""
+        return any("ENTERED CONFIG MODE" in l for l in self.checked("CONFIG"))
+
+    def config_hash(self) -> Tuple[int, int]:
+        """The device's CONFIG HASH: (CRC-32 of its blob, blob size)."""
+        for l in self.command("CONFIG HASH"):
+            match = HASH_LINE.search(l)
+            if match:
+                return int(match.group(1), 16), int(match.group(2))
+        raise DeviceError("no CONFIG HASH answer - firmware too old for --sync")
+
+    def fetch_blob(self) -> bytes:
+        """The device's config blob (SYSTEM DUMP BIN, CONFIG mode)."""
+        text = []
+        inside = False
+        for l in self.checked("SYSTEM DUMP BIN", timeout=max(self.timeout, 15.0)):
+            l = l.strip()
+            if l == "IMPORT BEGIN":
+                inside = True
+            elif l == "IMPORT END":
+                return base64.b64decode("".join(text))
+            elif inside and l.startswith("IMPORT "):
+                text.append(l[len("IMPORT "):])
+        raise DeviceError("SYSTEM DUMP BIN answer incomplete")
@@ -49,11 +49,18 @@ def get_platform_limits(platform: str) -> Dict[str, Any]:
 
 def parse_pin(pin_str: str) -> Optional[Tuple[str, int]]:
     """
-    Parses a pin string (e.g., "A2", "6", "I2C") into a tuple of (type, number).
+    Parses a pin string (e.g., "A2", "6", "I2C", "ADC:3") into a tuple of (type, number).
     """
     pin_str = pin_str.strip().upper()
     if pin_str == "I2C":
         return ("i2c", 0)  # Return special type for I2C
+    if pin_str.startswith("ADC:"):
+        # External ADC channel (firmware -D ENABLE_EXT_ADC, lib/ext_adc.h)
+        try:
+            channel = int(pin_str[4:])
+        except ValueError:
+            return None
+        return ("ext_adc", channel) if 0 <= channel <= 15 else None
     if pin_str.startswith('A'):
         try:
             pin_num = int(pin_str[1:])
@@ -73,7 +80,7 @@ def validate_pin(pin_str: str, platform: str, used_pins: List[str], sensor_pin_r
     Returns an error message string if invalid, otherwise None.
 
     Args:
-        pin_str: Pin string (e.g., "A0", "6", "I2C")
+        pin_str: Pin string (e.g., "A0", "6", "I2C", "ADC:0")
         platform: Target platform (e.g., "uno")
         used_pins: List of already-used pins
         sensor_pin_requirement: Optional sensor pin requirement ("PIN_ANALOG", "PIN_DIGITAL", "PIN_I2C")
@@ -115,7 +122,7 @@ def validate_pin(pin_str: str, platform: str, used_pins: List[str], sensor_pin_r
             return f"Only I2C sensors can use 'I2C' as pin"
 
         # Validate digital/analog pin types
-        elif requirement == "digital" and pin_type == "analog":
+        elif requirement == "digital" and pin_type in ("analog", "ext_adc"):
             return f"Sensor requires a digital pin, but {pin_str} is an analog pin"
         elif requirement == "analog" and pin_type == "digital":
             return f"Sensor requires an analog pin, but {pin_str} is a digital pin"
@@ -145,6 +145,7 @@ def _parse_x_macro_sensors(content: str, pstr_macros: Dict[str, str], base_dir:
     """
     Parses sensors defined using X-macro pattern.
     X_SENSOR(name, label, desc, readFn, initFn, measType, calType, defCal, minInt, minVal, maxVal, hash, pinType)
+    X_SENSOR_TWO_PHASE(..., pinType, startFn, completeFn)
     """
     sensors = []
 
@@ -152,7 +153,7 @@ def _parse_x_macro_sensors(content: str, pstr_macros: Dict[str, str], base_dir:
     # The pattern matches: X_SENSOR(PSTR_xxx, ...) - must start with PSTR_ to be a real sensor
     # This filters out comment examples like "X_SENSOR(name, label, ...)"
     x_sensor_pattern = re.compile(
-        r'X_SENSOR\s*\(\s*'
+        r'X_SENSOR(?:_TWO_PHASE)?\s*\(\s*'
         r'(PSTR_\w+),\s*'   # name - must be PSTR_xxx
         r'([^,]+),\s*'   # label
         r'([^,]+),\s*'   # description
@@ -165,18 +166,21 @@ def _parse_x_macro_sensors(content: str, pstr_macros: Dict[str, str], base_dir:
         r'([^,]+),\s*'   # minValue
         r'([^,]+),\s*'   # maxValue
         r'(0x[0-9A-Fa-f]+),\s*'   # nameHash - must be hex
-        r'(PIN_\w+)\s*\)', # pinTypeRequirement - must be PIN_xxx
+        r'(PIN_\w+)\s*'   # pinTypeRequirement - must be PIN_xxx
+        r'(?:,\s*([^,]+),\s*([^,)]+?)\s*)?\)',  # startFunction, completeFunction (X_SENSOR_TWO_PHASE)
         re.MULTILINE
     )
 
     index = 0
     for match in x_sensor_pattern.finditer(content):
         # Strip each arg and remove backslash-newline continuations
-        args = [re.sub(r'\\\n\s*', '', arg.strip()) for arg in match.groups()]
+        args = [re.sub(r'\\\n\s*', '', arg.strip()) if arg else 'nullptr' for arg in match.groups()]
 
         name_macro = args[0]
         label_macro = args[1]
         desc_macro = args[2]
+        read_fn = args[3]
+        min_interval = args[8]
         meas_type = args[5]
         cal_type = args[6]
         hash_str = args[11]
@@ -202,6 +206,12 @@ def _parse_x_macro_sensors(content: str, pstr_macros: Dict[str, str], base_dir:
             'calibrationType': cal_type,
             'nameHash': name_hash,
             'pinTypeRequirement': pin_type,
+            'readFunction': read_fn,
+            'initFunction': args[4],
+            'startFunction': args[13],
+            'completeFunction': args[14],
+            'defaultCalibration': args[7],
+            'minReadInterval': min_interval,
             'is_implemented': label is not None,
             'raw_c_block': match.group(0),
             'used_pstr_macros': [name_macro] + ([label_macro] if label_macro != 'nullptr' else [])
@@ -242,7 +242,7 @@ def validate_pin_type_compatibility(
             continue
         pin_type, pin_num = parsed
 
-        if requirement == 'digital' and pin_type == 'analog':
+        if requirement == 'digital' and pin_type in ('analog', 'ext_adc'):
             errors.append(f"Input {inp.get('idx')}: Sensor '{sensor['name']}' requires a digital pin, but {pin_str} is an analog pin")
         elif requirement == 'analog' and pin_type == 'digital':
             errors.append(f"Input {inp.get('idx')}: Sensor '{sensor['name']}' requires an analog pin, but {pin_str} is a digital pin")
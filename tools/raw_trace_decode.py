@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+"""
+preOBD Raw Trace Decoder
+
+Reads a raw trace (RAW RECORD, firmware built with -D ENABLE_RAW_TRACE -
+see src/lib/raw_trace.h) and writes one CSV row per acquisition:
+
+  us,kind,key,value
+  48872,ADC,16,400
+  49103,SPI,10,0x00000C8C
+  50011,PULSE,3,41.250 Hz idle 1210 us 3114 pulses
+  50240,CAN,0,18FEEE00x#7D7D...
+
+us counts from the start of the recording. key is the pin (ADC, SPI,
+PULSE) or the bus index (CAN). With --kind only one kind is written, and
+with --pivot ADC rows become one column per pin (pinN), each row holding
+the latest counts of every pin - the layout to feed a calibration fit.
+
+A trace cut short (power lost while recording) decodes up to the last
+whole record.
+"""
+
+import argparse
+import csv
+import struct
+import sys
+
+MAGIC = b"PRAW"
+VERSION = 1
+HEADER = struct.Struct("<4sB3xII")
+RECORD = struct.Struct("<IBBB")
+
+KINDS = {1: "ADC", 2: "SPI", 3: "PULSE", 4: "CAN"}
+
+
+def read_trace(f):
+    """Header fields, then (us, kind, key, payload) per record."""
+    head = f.read(HEADER.size)
+    if len(head) < HEADER.size:
+        raise ValueError("file too short for a raw trace header")
+    magic, version, start_ms, start_unix = HEADER.unpack(head)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError("not a version %d raw trace (PRAW header)" % VERSION)
+
+    def records():
+        us = 0
+        while True:
+            rec = f.read(RECORD.size)
+            if len(rec) < RECORD.size:
+                return
+            dt, kind, key, length = RECORD.unpack(rec)
+            payload = f.read(length)
+            if len(payload) < length:
+                return
+            us += dt
+            yield us, kind, key, payload
+
+    return start_ms, start_unix, records()
+
+
+def format_value(kind, payload):
+    """One acquisition as text."""
+    if kind == 1 and len(payload) == 4:
+        counts = struct.unpack("<f", payload)[0]
+        return f"{counts:g}"
+    if kind == 2 and len(payload) == 4:
+        return "0x%08X" % struct.unpack("<I", payload)[0]
+    if kind == 3 and len(payload) == 12:
+        hz, idle, pulses = struct.unpack("<fII", payload)
+        return f"{hz:.3f} Hz idle {idle} us {pulses} pulses"
+    if kind == 4 and len(payload) >= 5:
+        can_id, flags = struct.unpack("<IB", payload[:5])
+        sep = "##" if flags & 2 else "#"
+        ext = "x" if flags & 1 else ""
+        return f"{can_id:X}{ext}{sep}{payload[5:].hex().upper()}"
+    return payload.hex()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode a preOBD raw trace (.prw) to CSV")
+    parser.add_argument("trace", help="Raw trace file from the SD card")
+    parser.add_argument("-o", "--output", help="CSV file (default stdout)")
+    parser.add_argument("--kind", choices=sorted(KINDS.values()), help="Only this kind")
+    parser.add_argument("--pivot", action="store_true",
+                        help="ADC counts as one column per pin")
+    args = parser.parse_args()
+
+    out = open(args.output, "w", newline="") if args.output else sys.stdout
+    writer = csv.writer(out)
+    count = 0
+    per_kind = {}
+    try:
+        with open(args.trace, "rb") as f:
+            start_ms, start_unix, records = read_trace(f)
+            if args.pivot:
+                rows = []
+                pins = set()
+                latest = {}
+                for us, kind, key, payload in records:
+                    if kind != 1 or len(payload) != 4:
+                        continue
+                    latest[key] = struct.unpack("<f", payload)[0]
+                    pins.add(key)
+                    rows.append((us, dict(latest)))
+                    count += 1
+                columns = sorted(pins)
+                writer.writerow(["us"] + [f"pin{p}" for p in columns])
+                for us, values in rows:
+                    writer.writerow([us] + [f"{values[p]:g}" if p in values else "" for p in columns])
+            else:
+                writer.writerow(["us", "kind", "key", "value"])
+                for us, kind, key, payload in records:
+                    name = KINDS.get(kind, str(kind))
+                    if args.kind and name != args.kind:
+                        continue
+                    writer.writerow([us, name, key, format_value(kind, payload)])
+                    per_kind[name] = per_kind.get(name, 0) + 1
+                    count += 1
+    except (OSError, ValueError) as e:
+        print(f"Error: {e}", file=sys.stderr)
+        return 1
+    finally:
+        if args.output:
+            out.close()
+
+    kinds = ", ".join(f"{n} {k}" for k, n in sorted(per_kind.items()))
+    stamp = f", started unix {start_unix}" if start_unix else ""
+    print(f"{count} records{' (' + kinds + ')' if kinds else ''}, start {start_ms} ms{stamp}",
+          file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,728 @@
+#!/usr/bin/env python3
+"""
+preOBD SD Log Converter
+
+Converts binary SD logs (/logs/*.pbl) into CSV, or Parquet when pyarrow is
+installed. A log describes its channels once in the header, then holds one
+fixed-size record per logging tick:
+
+  Header   "POBL" version(u8) channels(u8) record_size(u16) start_ms(u32) start_unix(u32)
+  Channel  name[8] units[6] width(u8) reserved(u8) factor(f32) offset(f32)   x channels
+  Record   ms(u32) + each channel's raw value (width bytes)                   x n
+
+All fields are little-endian. A value is raw * factor + offset in standard
+units; a raw value of all ones (0xFF / 0xFFFF) means the input had no data
+that tick and is written as an empty cell / null.
+
+Version 2 logs (SD_LOG_COMPRESS) hold each record as a compressed block:
+a length (1 byte, or 2 with the top bit of the first set), then LZSS groups
+- a flag byte and eight items, a literal or a 16-bit match (10-bit distance
+- 1, 6-bit length - 3) over a 1 KB window - decoding to the record's delta:
+ms since the previous record, then each channel's zigzag-coded change, low
+bytes of all channels first and the high bytes of the 2-byte channels after.
+See src/lib/log_compress.h.
+
+With --stream the inputs are captures of the binary serial data plane
+(OUTPUT Serial FORMAT BINARY / COMPRESSED): frames of 0xA5 0x5A, type
+('D' description / 'R' record), uint16 sequence, uint16 length, payload and
+a CRC-16/CCITT-FALSE. Bench stream frames ('S' / 'B') and deferred log
+frames ('L') are skipped here - tools/bench_decode.py and tools/log_decode.py
+read those - and so are host subscription frames ('H' / 'V', SUBSCRIBE ...
+FORMAT BINARY), which tools/serial_decode.py prints. Anything between frames (text lines) is skipped;
+after a bad or missing frame a compressed stream drops records until the
+next description. "-" reads stdin. tools/serial_decode.py reads a port live.
+
+A partial trailing record (power lost mid-write) is ignored with a warning.
+Logs from Teensy are preallocated and keep that size if the logger was
+never closed; reading stops at the first record that was not written (all
+bytes 0x00 or 0xFF, or a timestamp going backwards).
+
+Several segments of one log convert into one table. With --index (the
+device's logindex.csv) and --from / --to, the segments covering a time range
+are picked from the index without reading the others.
+"""
+
+import argparse
+import binascii
+import csv
+import os
+import struct
+import sys
+from datetime import datetime, timezone
+from typing import Dict, List, NamedTuple, Optional
+
+MAGIC = b"POBL"
+VERSION_RAW = 1
+VERSION_COMPRESSED = 2
+
+WINDOW = 1024
+STREAM_SYNC = b"\xa5\x5a"
+STREAM_MAX_PAYLOAD = 16384
+PLANE_FRAMES = {ord("c"): "CONTROL", ord("d"): "DATA", ord("g"): "DEBUG"}
+
+HEADER = struct.Struct("<4sBBHII")
+CHANNEL = struct.Struct("<8s6sBBff")
+BENCH_INPUT = struct.Struct("<BB8s6s")
+BENCH_VERSION = 1
+LOG_RECORD = struct.Struct("<IIB")
+HOST_CHANNEL = struct.Struct("<BHBff8s6s")
+HOST_VERSION = 1
+
+
+class Channel(NamedTuple):
+    name: str
+    units: str
+    width: int
+    factor: float
+    offset: float
+
+
+class Log(NamedTuple):
+    start_ms: int
+    start_unix: int         # 0 = wall clock unknown
+    channels: List[Channel]
+    times: List[int]
+    columns: List[List[Optional[float]]]
+    stamps: List[Optional[float]]   # Unix time of each record, None if the clock was unknown
+
+
+class BenchInput(NamedTuple):
+    slot: int
+    pin: int
+    name: str
+    units: str
+
+
+class LogRecord(NamedTuple):
+    us: int                 # micros() when logged
+    fmt_addr: int           # Address of the format string in the firmware
+    level: int
+    tag: int
+    args: bytes             # Packed arguments (src/lib/log_deferred.h)
+
+
+class HostChannel(NamedTuple):
+    slot: int
+    period_ms: int
+    name: str
+    units: str
+    width: int
+    factor: float
+    offset: float
+
+
+class BenchStream(NamedTuple):
+    rate: int               # Samples per second
+    adc_bits: int
+    pins: List[int]         # Pin of each sampled channel
+    inputs: List[BenchInput]
+
+
+def _text(raw: bytes) -> str:
+    return raw.split(b"\0", 1)[0].decode("ascii", errors="replace")
+
+
+class EndOfLog(Exception):
+    """Unwritten space or a cut-off block ends a compressed log."""
+
+
+class Decompressor:
+    """Undo log_compress.h: LZSS over the delta stream, then the record delta."""
+
+    def __init__(self, channels: List[Channel]):
+        self.widths = [c.width for c in channels]
+        record_size = 4 + sum(self.widths)
+        self.record_size = record_size
+        self.bound = record_size + (record_size + 7) // 8
+        self.prev = bytes(record_size)
+        self.history = bytearray()
+
+    def block(self, data: bytes, pos: int):
+        """Decode the block at pos; returns (record, position after the block)."""
+        if pos >= len(data):
+            raise EndOfLog()
+        length = data[pos]
+        pos += 1
+        if length & 0x80:
+            if pos >= len(data):
+                raise EndOfLog()
+            length = (length & 0x7F) | (data[pos] << 7)
+            pos += 1
+        if length == 0 or length > self.bound or pos + length > len(data):
+            raise EndOfLog()
+        delta = self._unpack(data[pos:pos + length])
+        pos += length
+
+        elapsed = struct.unpack_from("<I", delta, 0)[0]
+        ms = (struct.unpack_from("<I", self.prev, 0)[0] + elapsed) & 0xFFFFFFFF
+        record = bytearray(struct.pack("<I", ms))
+        low = 4
+        high = 4 + len(self.widths)
+        field = 4
+        for width in self.widths:
+            if width == 1:
+                zigzag = delta[low]
+                value = (self.prev[field] + ((zigzag >> 1) ^ -(zigzag & 1))) & 0xFF
+                record.append(value)
+            else:
+                zigzag = delta[low] | (delta[high] << 8)
+                high += 1
+                previous = struct.unpack_from("<H", self.prev, field)[0]
+                value = (previous + ((zigzag >> 1) ^ -(zigzag & 1))) & 0xFFFF
+                record += struct.pack("<H", value)
+            low += 1
+            field += width
+        self.prev = bytes(record)
+        return self.prev, pos
+
+    def _unpack(self, payload: bytes) -> bytes:
+        out = self.history
+        start = len(out)
+        i = 0
+        while i < len(payload):
+            flags = payload[i]
+            i += 1
+            for bit in range(8):
+                if i >= len(payload):
+                    break
+                if flags & (1 << bit):
+                    if i + 2 > len(payload):
+                        raise ValueError("corrupt compressed block")
+                    token = payload[i] | (payload[i + 1] << 8)
+                    i += 2
+                    distance = (token & 0x3FF) + 1
+                    if distance > len(out):
+                        raise ValueError("corrupt compressed block")
+                    for _ in range((token >> 10) + 3):
+                        out.append(out[-distance])
+                else:
+                    out.append(payload[i])
+                    i += 1
+        delta = bytes(out[start:])
+        if len(delta) != self.record_size:
+            raise ValueError("compressed block does not decode to one record")
+        if len(out) > 4 * WINDOW:
+            del out[:-WINDOW]
+        return delta
+
+
+def parse_header(data: bytes):
+    """Header and channel table; returns (version, start_ms, start_unix, channels, record_size, end)."""
+    if len(data) < HEADER.size:
+        raise ValueError("file too short for a log header")
+    magic, version, count, record_size, start_ms, start_unix = HEADER.unpack_from(data, 0)
+    if magic != MAGIC:
+        raise ValueError("not a preOBD SD log (bad magic)")
+    if version not in (VERSION_RAW, VERSION_COMPRESSED):
+        raise ValueError(f"unsupported log version {version}")
+
+    pos = HEADER.size
+    channels = []
+    for _ in range(count):
+        if pos + CHANNEL.size > len(data):
+            raise ValueError("file ends inside the channel table")
+        name, units, width, _, factor, offset = CHANNEL.unpack_from(data, pos)
+        if width not in (1, 2):
+            raise ValueError(f"channel {_text(name)}: unsupported width {width}")
+        channels.append(Channel(_text(name), _text(units), width, factor, offset))
+        pos += CHANNEL.size
+
+    if record_size != 4 + sum(c.width for c in channels):
+        raise ValueError(f"record size {record_size} does not match the channel table")
+    return version, start_ms, start_unix, channels, record_size, pos
+
+
+def decode_values(record: bytes, channels: List[Channel]) -> List[Optional[float]]:
+    """Physical values of a record, None where the input had no data."""
+    values: List[Optional[float]] = []
+    field = 4
+    for channel in channels:
+        if channel.width == 1:
+            raw = record[field]
+            missing = raw == 0xFF
+        else:
+            raw = struct.unpack_from("<H", record, field)[0]
+            missing = raw == 0xFFFF
+        values.append(None if missing else raw * channel.factor + channel.offset)
+        field += channel.width
+    return values
+
+
+def append_record(record: bytes, channels: List[Channel], times: List[int],
+                  columns: List[List[Optional[float]]]):
+    times.append(struct.unpack_from("<I", record, 0)[0])
+    for column, value in zip(columns, decode_values(record, channels)):
+        column.append(value)
+
+
+def make_log(start_ms: int, start_unix: int, channels: List[Channel], times: List[int],
+             columns: List[List[Optional[float]]]) -> Log:
+    stamps = [start_unix + (t - start_ms) / 1000.0 if start_unix else None for t in times]
+    return Log(start_ms, start_unix, channels, times, columns, stamps)
+
+
+def read_log(path: str) -> Log:
+    """Parse a .pbl file into per-channel value columns."""
+    with open(path, "rb") as f:
+        data = f.read()
+
+    version, start_ms, start_unix, channels, record_size, pos = parse_header(data)
+    times: List[int] = []
+    columns: List[List[Optional[float]]] = [[] for _ in channels]
+
+    if version == VERSION_COMPRESSED:
+        decoder = Decompressor(channels)
+        while True:
+            try:
+                record, pos = decoder.block(data, pos)
+            except EndOfLog:
+                break
+            append_record(record, channels, times, columns)
+        unwritten = len(data) - pos
+        if unwritten:
+            print(f"Log ends after {len(times)} records ({unwritten} bytes unwritten or cut off)",
+                  file=sys.stderr)
+        return make_log(start_ms, start_unix, channels, times, columns)
+
+    body = len(data) - pos
+    records, leftover = divmod(body, record_size)
+    if leftover:
+        print(f"Warning: ignoring {leftover} bytes of a partial last record", file=sys.stderr)
+
+    for n in range(records):
+        chunk = data[pos:pos + record_size]
+        ms = struct.unpack_from("<I", data, pos)[0]
+        if chunk.count(0) == record_size or chunk.count(0xFF) == record_size or (times and ms < times[-1]):
+            print(f"Log ends after {n} records ({records - n} unwritten records of preallocated space)",
+                  file=sys.stderr)
+            break
+        append_record(chunk, channels, times, columns)
+        pos += record_size
+
+    return make_log(start_ms, start_unix, channels, times, columns)
+
+
+def parse_bench_description(payload: bytes) -> BenchStream:
+    """Bench stream 'S' frame (src/outputs/bench_stream.h)."""
+    version, rate, bits, count = struct.unpack_from("<BHBB", payload, 0)
+    if version != BENCH_VERSION:
+        raise ValueError(f"unsupported bench stream version {version}")
+    pins = list(payload[5:5 + count])
+    pos = 5 + count
+    count = payload[pos]
+    pos += 1
+    inputs = []
+    for _ in range(count):
+        slot, pin, name, units = BENCH_INPUT.unpack_from(payload, pos)
+        inputs.append(BenchInput(slot, pin, _text(name), _text(units)))
+        pos += BENCH_INPUT.size
+    return BenchStream(rate, bits, pins, inputs)
+
+
+def parse_log_frame(payload: bytes):
+    """Deferred log 'L' frame (src/lib/log_deferred.h); returns (lost, records)."""
+    lost = struct.unpack_from("<H", payload, 0)[0]
+    records = []
+    pos = 2
+    while pos < len(payload):
+        length = payload[pos]
+        if length < LOG_RECORD.size or pos + 1 + length > len(payload):
+            raise ValueError("truncated log record")
+        us, fmt_addr, level_tag = LOG_RECORD.unpack_from(payload, pos + 1)
+        args = payload[pos + 1 + LOG_RECORD.size:pos + 1 + length]
+        records.append(LogRecord(us, fmt_addr, level_tag >> 5, level_tag & 0x1F, args))
+        pos += 1 + length
+    return lost, records
+
+
+def parse_host_description(payload: bytes) -> List[HostChannel]:
+    """Host subscription 'H' frame (src/outputs/host_subscription.h)."""
+    version, count = struct.unpack_from("<BB", payload, 0)
+    if version != HOST_VERSION:
+        raise ValueError(f"unsupported subscription version {version}")
+    channels = []
+    for k in range(count):
+        slot, period, width, factor, offset, name, units = \
+            HOST_CHANNEL.unpack_from(payload, 2 + k * HOST_CHANNEL.size)
+        channels.append(HostChannel(slot, period, _text(name), _text(units), width, factor, offset))
+    return channels
+
+
+def parse_host_values(payload: bytes, channels: List[HostChannel]):
+    """Host subscription 'V' frame; returns (ms, values), None where not sent or no data."""
+    ms, present = struct.unpack_from("<IH", payload, 0)
+    values: List[Optional[float]] = []
+    pos = 6
+    for k, channel in enumerate(channels):
+        if not present & (1 << k):
+            values.append(None)
+            continue
+        if channel.width == 1:
+            raw, missing = payload[pos], payload[pos] == 0xFF
+        else:
+            raw = struct.unpack_from("<H", payload, pos)[0]
+            missing = raw == 0xFFFF
+        values.append(None if missing else raw * channel.factor + channel.offset)
+        pos += channel.width
+    if pos != len(payload):
+        raise ValueError("values frame does not match the description")
+    return ms, values
+
+
+def parse_bench_block(payload: bytes, bench: BenchStream):
+    """Bench stream 'B' frame; returns (lost, samples, values).
+
+    samples is a list of (micros, counts of each channel...) tuples and
+    values the inputs' computed values when the block was sent.
+    """
+    lost, count = struct.unpack_from("<HB", payload, 0)
+    sample = struct.Struct(f"<I{len(bench.pins)}H")
+    values_at = 3 + count * sample.size
+    if len(payload) != values_at + 4 * len(bench.inputs):
+        raise ValueError("bench block does not match the description")
+    samples = [sample.unpack_from(payload, 3 + k * sample.size) for k in range(count)]
+    values = list(struct.unpack_from(f"<{len(bench.inputs)}f", payload, values_at))
+    return lost, samples, values
+
+
+class StreamDecoder:
+    """Incremental decoder for the binary serial data plane.
+
+    feed() takes bytes as they arrive and yields
+      ("description", start_ms, start_unix, channels)  - a new channel table
+      ("record", record_bytes)                          - one decoded record
+      ("bench", bench_stream)                           - a bench stream description
+      ("block", lost, samples, values)                  - one bench stream block
+      ("log", lost, log_records)                        - one deferred log frame
+      ("subscription", host_channels)                   - a host subscription description
+      ("values", ms, values)                            - one host subscription tick
+      ("plane", plane_name, text)                       - what a framed transport's
+                                                          plane wrote besides frames
+    Counts frames lost (sequence gaps, damaged ones included) and damaged
+    (bad CRC) on the way. Log frames number their own sequence (they come
+    from the debug plane), counted in log_lost, and so do a subscription's
+    (only its transport gets them), counted in host_lost. Plane frames
+    (TRANSPORT FRAMING ON) count theirs in plane_lost; their DATA and DEBUG
+    payloads go through a decoder of their own (planes), so the frames nested
+    in them come out as from an unframed port, counted there.
+    """
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.channels: Optional[List[Channel]] = None
+        self.compressed = False
+        self.decoder: Optional[Decompressor] = None
+        self.bench: Optional[BenchStream] = None
+        self.next_sequence: Optional[int] = None
+        self.next_log_sequence: Optional[int] = None
+        self.host: Optional[List[HostChannel]] = None
+        self.next_host_sequence: Optional[int] = None
+        self.frames = 0
+        self.lost = 0
+        self.log_lost = 0
+        self.host_lost = 0
+        self.next_plane_sequence: Optional[int] = None
+        self.plane_lost = 0
+        self.planes: Dict[int, "StreamDecoder"] = {}  # Decoders of DATA / DEBUG plane frames
+        self.damaged = 0
+
+    def feed(self, data: bytes):
+        self.buffer += data
+        buf = self.buffer
+        while True:
+            pos = buf.find(STREAM_SYNC)
+            if pos < 0:
+                del buf[:-1]        # Keep a trailing 0xA5 that may start a frame
+                return
+            del buf[:pos]
+            if len(buf) < 9:
+                return
+            kind = buf[2]
+            sequence, length = struct.unpack_from("<HH", buf, 3)
+            if length > STREAM_MAX_PAYLOAD or kind not in b"DRSBLHVcdg":
+                del buf[:1]         # Not a frame - resync
+                continue
+            if len(buf) < 9 + length:
+                return
+            crc = struct.unpack_from("<H", buf, 7 + length)[0]
+            if binascii.crc_hqx(bytes(buf[2:7 + length]), 0xFFFF) != crc:
+                self.damaged += 1
+                self.decoder = None  # A compressed stream can't skip a record
+                del buf[:1]
+                continue
+            payload = bytes(buf[7:7 + length])
+            del buf[:9 + length]
+            self.frames += 1
+
+            if kind in b"cdg":
+                if self.next_plane_sequence is not None and sequence != self.next_plane_sequence:
+                    self.plane_lost += (sequence - self.next_plane_sequence) & 0xFFFF
+                self.next_plane_sequence = (sequence + 1) & 0xFFFF
+                inner = self.planes.setdefault(kind, StreamDecoder()) if kind != ord("c") else None
+                if inner is None or (STREAM_SYNC not in payload and not inner.buffer):
+                    yield ("plane", PLANE_FRAMES[kind], payload)
+                else:
+                    yield from inner.feed(payload)  # Nested frames, maybe split across plane frames
+                continue
+
+            if kind == ord("L"):
+                if self.next_log_sequence is not None and sequence != self.next_log_sequence:
+                    self.log_lost += (sequence - self.next_log_sequence) & 0xFFFF
+                self.next_log_sequence = (sequence + 1) & 0xFFFF
+                try:
+                    yield ("log",) + parse_log_frame(payload)
+                except (struct.error, ValueError):
+                    pass
+                continue
+
+            if kind in b"HV":
+                if self.next_host_sequence is not None and sequence != self.next_host_sequence:
+                    self.host_lost += (sequence - self.next_host_sequence) & 0xFFFF
+                self.next_host_sequence = (sequence + 1) & 0xFFFF
+                try:
+                    if kind == ord("H"):
+                        self.host = parse_host_description(payload)
+                        yield ("subscription", self.host)
+                    elif self.host is not None:
+                        yield ("values",) + parse_host_values(payload, self.host)
+                except (struct.error, ValueError):
+                    pass
+                continue
+
+            if self.next_sequence is not None and sequence != self.next_sequence:
+                self.lost += (sequence - self.next_sequence) & 0xFFFF
+                self.decoder = None
+            self.next_sequence = (sequence + 1) & 0xFFFF
+
+            if kind == ord("D"):
+                version, start_ms, start_unix, channels, _, _ = parse_header(payload)
+                self.channels = channels
+                self.compressed = version == VERSION_COMPRESSED
+                self.decoder = Decompressor(channels) if self.compressed else None
+                yield ("description", start_ms, start_unix, channels)
+            elif kind == ord("S"):
+                try:
+                    self.bench = parse_bench_description(payload)
+                except (struct.error, ValueError):
+                    continue
+                yield ("bench", self.bench)
+            elif kind == ord("B"):
+                if self.bench is None:
+                    continue        # Until the next description
+                try:
+                    yield ("block",) + parse_bench_block(payload, self.bench)
+                except (struct.error, ValueError):
+                    continue
+            elif self.channels is not None:
+                if not self.compressed:
+                    if len(payload) == 4 + sum(c.width for c in self.channels):
+                        yield ("record", payload)
+                    continue
+                if self.decoder is None:
+                    continue        # Out of sync until the next description
+                try:
+                    record, _ = self.decoder.block(payload, 0)
+                except (EndOfLog, ValueError):
+                    self.decoder = None
+                    continue
+                yield ("record", record)
+
+
+def read_stream(path: str) -> List[Log]:
+    """Parse a serial capture into one log per description frame."""
+    if path == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(path, "rb") as f:
+            data = f.read()
+
+    sessions = []       # (start_ms, start_unix, channels, times, columns) per description
+    stream = StreamDecoder()
+    for item in stream.feed(data):
+        if item[0] == "description":
+            _, start_ms, start_unix, channels = item
+            sessions.append((start_ms, start_unix, channels, [], [[] for _ in channels]))
+        elif item[0] == "record":
+            _, _, channels, times, columns = sessions[-1]
+            append_record(item[1], channels, times, columns)
+
+    if stream.lost or stream.damaged:
+        print(f"Warning: {stream.lost} frames lost, {stream.damaged} damaged", file=sys.stderr)
+    return [make_log(*session) for session in sessions]
+
+
+def concat_logs(logs: List[Log]) -> Log:
+    """Join segments of one log (same channel table) in order."""
+    first = logs[0]
+    times: List[int] = []
+    stamps: List[Optional[float]] = []
+    columns: List[List[Optional[float]]] = [[] for _ in first.channels]
+    for log in logs:
+        if log.channels != first.channels:
+            raise ValueError("segments have different channel tables")
+        times += log.times
+        stamps += log.stamps
+        for column, values in zip(columns, log.columns):
+            column += values
+    return Log(first.start_ms, first.start_unix, first.channels, times, columns, stamps)
+
+
+def parse_time(text: str) -> int:
+    """Unix seconds from a number or an ISO 8601 date/time (UTC unless given)."""
+    if text.isdigit():
+        return int(text)
+    t = datetime.fromisoformat(text)
+    if t.tzinfo is None:
+        t = t.replace(tzinfo=timezone.utc)
+    return int(t.timestamp())
+
+
+def select_segments(index_path: str, start: Optional[int], end: Optional[int]) -> List[str]:
+    """Files from logindex.csv whose time span overlaps [start, end]."""
+    with open(index_path, newline="") as f:
+        rows = [r for r in csv.DictReader(f) if int(r["start_unix"] or 0) > 0]
+    rows.sort(key=lambda r: int(r["start_unix"]))
+
+    folder = os.path.dirname(index_path)
+    chosen = []
+    for n, row in enumerate(rows):
+        seg_start = int(row["start_unix"])
+        seg_end = int(rows[n + 1]["start_unix"]) if n + 1 < len(rows) else None
+        if end is not None and seg_start > end:
+            continue
+        if start is not None and seg_end is not None and seg_end <= start:
+            continue
+        chosen.append(os.path.join(folder, row["file"]))
+    return chosen
+
+
+def column_names(log: Log) -> List[str]:
+    return ["Time"] + [f"{c.name} ({c.units})" if c.units else c.name for c in log.channels]
+
+
+def utc_time(stamp: Optional[float]) -> str:
+    """Wall-clock time of a record, from its segment's start time."""
+    if stamp is None:
+        return ""
+    return datetime.fromtimestamp(stamp, timezone.utc).isoformat(timespec="milliseconds")
+
+
+def write_csv(log: Log, path: Optional[str], decimals: int, utc: bool):
+    out = open(path, "w", newline="") if path else sys.stdout
+    try:
+        writer = csv.writer(out)
+        writer.writerow((["UTC"] if utc else []) + column_names(log))
+        for row, t in enumerate(log.times):
+            values = ["" if col[row] is None else f"{col[row]:.{decimals}f}" for col in log.columns]
+            writer.writerow(([utc_time(log.stamps[row])] if utc else []) + [t] + values)
+    finally:
+        if path:
+            out.close()
+
+
+def write_parquet(log: Log, path: str, utc: bool):
+    try:
+        import pyarrow as pa
+        import pyarrow.parquet as pq
+    except ImportError:
+        print("Error: Parquet output needs pyarrow (pip install pyarrow)", file=sys.stderr)
+        sys.exit(1)
+
+    names = column_names(log)
+    arrays = [pa.array(log.times, type=pa.uint32())]
+    arrays += [pa.array(col, type=pa.float32()) for col in log.columns]
+    if utc:
+        names = ["UTC"] + names
+        stamps = [None if st is None else int(st * 1000) for st in log.stamps]
+        arrays = [pa.array(stamps, type=pa.timestamp("ms", tz="UTC"))] + arrays
+    pq.write_table(pa.Table.from_arrays(arrays, names=names), path)
+
+
+def main():
+    """Main execution function."""
+    parser = argparse.ArgumentParser(
+        description="Convert a preOBD binary SD log to CSV or Parquet")
+    parser.add_argument("logs", nargs="*", help="Binary log files (.pbl), segments in order")
+    parser.add_argument("--stream", action="store_true",
+                        help="Inputs are binary serial captures (- for stdin)")
+    parser.add_argument("-o", "--output",
+                        help="Output file (default: stdout for CSV)")
+    parser.add_argument("-f", "--format", choices=["csv", "parquet"],
+                        help="Output format (default: from the output extension, else csv)")
+    parser.add_argument("--decimals", type=int, default=2,
+                        help="Decimal places in CSV values (default 2)")
+    parser.add_argument("--info", action="store_true",
+                        help="Print the channel table and record count only")
+    parser.add_argument("--index",
+                        help="logindex.csv - pick the segments to convert by time")
+    parser.add_argument("--from", dest="start",
+                        help="With --index: start time (unix seconds or ISO 8601, UTC)")
+    parser.add_argument("--to", dest="end",
+                        help="With --index: end time")
+    parser.add_argument("--utc", action="store_true",
+                        help="Add a UTC column (logs written with the wall clock known)")
+    args = parser.parse_args()
+
+    files = list(args.logs)
+    if args.index:
+        try:
+            start = parse_time(args.start) if args.start else None
+            end = parse_time(args.end) if args.end else None
+            files += select_segments(args.index, start, end)
+        except (OSError, ValueError, KeyError) as e:
+            print(f"Error: {args.index}: {e}", file=sys.stderr)
+            return 1
+    if not files:
+        print("Error: no log files (give files or --index)", file=sys.stderr)
+        return 1
+
+    logs = []
+    for path in files:
+        try:
+            if args.stream:
+                logs += read_stream(path)
+            else:
+                logs.append(read_log(path))
+        except (OSError, ValueError) as e:
+            print(f"Error: {path}: {e}", file=sys.stderr)
+            return 1
+    if not logs:
+        print("Error: no description frame in the stream", file=sys.stderr)
+        return 1
+    try:
+        log = concat_logs(logs)
+    except ValueError as e:
+        print(f"Error: {e}", file=sys.stderr)
+        return 1
+    if args.utc and all(st is None for st in log.stamps):
+        print("Error: --utc needs a log written with the wall clock known", file=sys.stderr)
+        return 1
+
+    if args.info:
+        duration = (log.times[-1] - log.times[0]) / 1000.0 if len(log.times) > 1 else 0.0
+        print(f"{len(files)} file(s), {len(log.channels)} channels, {len(log.times)} records, {duration:.1f} s")
+        if log.start_unix:
+            print(f"Started {datetime.fromtimestamp(log.start_unix, timezone.utc).isoformat()}")
+        for c in log.channels:
+            print(f"  {c.name:<8} {c.units:<6} {c.width} byte  x{c.factor:g} {c.offset:+g}")
+        return 0
+
+    fmt = args.format
+    if fmt is None:
+        fmt = "parquet" if args.output and args.output.endswith(".parquet") else "csv"
+
+    if fmt == "parquet":
+        if not args.output:
+            print("Error: Parquet output needs -o <file>", file=sys.stderr)
+            return 1
+        write_parquet(log, args.output, args.utc)
+    else:
+        write_csv(log, args.output, args.decimals, args.utc)
+
+    if args.output:
+        print(f"Wrote {len(log.times)} records to {args.output}", file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
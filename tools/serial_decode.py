@@ -0,0 +1,176 @@
+#!/usr/bin/env python3
+"""
+preOBD Serial Stream Decoder
+
+Reads the binary serial data plane (OUTPUT Serial FORMAT BINARY or
+COMPRESSED) live from a serial port, or from a capture file, and prints one
+CSV row per record:
+
+  Time,CLT (C),OILP (bar),...
+  123400,90.10,3.05,...
+
+Each frame carries a sequence number and a CRC16; lost and damaged frames
+are counted and reported on exit (and as they happen with --verbose). A new
+header row is printed whenever the channel table changes. The frame format
+and the record decoding are shared with sdlog_convert.py.
+
+A host subscription (SUBSCRIBE <channels> FORMAT BINARY, sent on the same
+link first - see --subscribe) is decoded the same way: a header row per
+description, then a row per tick with empty cells for the channels not due
+that tick. Its values are in standard units.
+
+A source of udp:PORT or udp:GROUP:PORT receives the Wi-Fi data stream
+(TRANSPORT DATA WIFI_UDP) - any number of receivers can join the group.
+
+Ports need pyserial (pip install pyserial).
+"""
+
+import argparse
+import csv
+import os
+import socket
+import struct
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from sdlog_convert import StreamDecoder, decode_values  # noqa: E402
+
+
+class UdpSource:
+    """Datagrams from a UDP port, optionally joining a multicast group."""
+
+    def __init__(self, spec: str):
+        parts = spec.split(":")
+        group = parts[0] if len(parts) == 2 else None
+        port = int(parts[-1])
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+        self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.sock.bind(("", port))
+        if group and socket.inet_aton(group)[0] & 0xF0 == 0xE0:     # 224.0.0.0/4
+            membership = struct.pack("4s4s", socket.inet_aton(group), socket.inet_aton("0.0.0.0"))
+            self.sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, membership)
+        self.sock.settimeout(0.2)
+
+    def read(self, size: int) -> bytes:
+        try:
+            return self.sock.recv(max(size, 65535))
+        except socket.timeout:
+            return b""
+
+    def close(self):
+        self.sock.close()
+
+
+def open_source(source: str, baud: int):
+    """A readable byte source: stdin, a capture file, a UDP port or a serial port."""
+    if source == "-":
+        return sys.stdin.buffer
+    if os.path.isfile(source):
+        return open(source, "rb")
+    if source.startswith("udp:"):
+        try:
+            return UdpSource(source[4:])
+        except ValueError:
+            raise OSError("expected udp:PORT or udp:GROUP:PORT")
+    try:
+        import serial
+    except ImportError:
+        print("Error: reading a port needs pyserial (pip install pyserial)", file=sys.stderr)
+        sys.exit(1)
+    return serial.Serial(source, baud, timeout=0.2)
+
+
+def main():
+    """Main execution function."""
+    parser = argparse.ArgumentParser(
+        description="Decode the preOBD binary serial data stream to CSV")
+    parser.add_argument("source", help="Serial port (e.g. /dev/ttyACM0, COM3), capture file, "
+                                       "udp:[GROUP:]PORT, or - for stdin")
+    parser.add_argument("-b", "--baud", type=int, default=115200,
+                        help="Port baud rate (default 115200; ignored for USB serial)")
+    parser.add_argument("-o", "--output", help="CSV file (default: stdout)")
+    parser.add_argument("--save", help="Also write the raw bytes to this capture file")
+    parser.add_argument("--decimals", type=int, default=2,
+                        help="Decimal places in CSV values (default 2)")
+    parser.add_argument("--subscribe", metavar="CHANNELS",
+                        help="Send SUBSCRIBE CHANNELS FORMAT BINARY first, e.g. \"CHT@10 RPM@100\" "
+                             "(serial ports only; SUBSCRIBE STOP on exit)")
+    parser.add_argument("-v", "--verbose", action="store_true",
+                        help="Report lost and damaged frames as they happen")
+    args = parser.parse_args()
+
+    try:
+        source = open_source(args.source, args.baud)
+    except OSError as e:
+        print(f"Error: {args.source}: {e}", file=sys.stderr)
+        return 1
+    out = open(args.output, "w", newline="") if args.output else sys.stdout
+    save = open(args.save, "wb") if args.save else None
+    writer = csv.writer(out)
+    if args.subscribe:
+        if args.source == "-" or os.path.isfile(args.source) or args.source.startswith("udp:"):
+            print("Error: --subscribe needs a serial port", file=sys.stderr)
+            return 1
+        source.write(f"SUBSCRIBE {args.subscribe} FORMAT BINARY\r\n".encode("ascii"))
+
+    stream = StreamDecoder()
+    channels = None
+    records = 0
+    reported = (0, 0)
+    try:
+        while True:
+            chunk = source.read1(4096) if hasattr(source, "read1") else source.read(4096)
+            if not chunk:
+                if os.path.isfile(args.source) or args.source == "-":
+                    break       # End of the capture
+                continue        # Port timeout - keep waiting
+            if save:
+                save.write(chunk)
+
+            for item in stream.feed(chunk):
+                if item[0] == "description":
+                    if item[3] != channels:
+                        channels = item[3]
+                        writer.writerow(["Time"] + [f"{c.name} ({c.units})" if c.units else c.name
+                                                  for c in channels])
+                    continue
+                if item[0] == "subscription":
+                    channels = None     # The next description starts over
+                    writer.writerow(["Time"] + [f"{c.name} ({c.units})" if c.units else c.name
+                                              for c in item[1]])
+                    continue
+                if item[0] == "values":
+                    writer.writerow([item[1]] + ["" if v is None else f"{v:.{args.decimals}f}"
+                                                 for v in item[2]])
+                    records += 1
+                    continue
+                if item[0] != "record":
+                    continue        # Bench stream frames - tools/bench_decode.py
+                record = item[1]
+                ms = struct.unpack_from("<I", record, 0)[0]
+                values = decode_values(record, channels)
+                writer.writerow([ms] + ["" if v is None else f"{v:.{args.decimals}f}" for v in values])
+                records += 1
+            out.flush()
+
+            if args.verbose and (stream.lost + stream.host_lost, stream.damaged) != reported:
+                reported = (stream.lost + stream.host_lost, stream.damaged)
+                print(f"{reported[0]} frames lost, {stream.damaged} damaged", file=sys.stderr)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if args.subscribe:
+            source.write(b"SUBSCRIBE STOP\r\n")
+        if save:
+            save.close()
+        if args.output:
+            out.close()
+
+    print(f"{records} records, {stream.frames} frames, {stream.lost + stream.host_lost} lost, "
+          f"{stream.damaged} damaged",
+          file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())